@@ -341,6 +341,11 @@ int netifc_active(void) {
     return (snp != 0);
 }
 
+// Receive at most this many packets per call, so that a stream of incoming
+// data is handled without a trip back through the caller for every packet,
+// but still can't keep the caller from checking its timers.
+#define MAX_RX_PER_POLL 32
+
 void netifc_poll(void) {
     uint8_t data[1514];
     efi_status r;
@@ -348,42 +353,44 @@ void netifc_poll(void) {
     uint32_t irq;
     void* txdone;
 
-    if (eth_buffers_avail < num_eth_buffers) {
-        // Only check for completion if we have operations in progress.
-        // Otherwise, the result of GetStatus is unreliable. See ZX-759.
-        if ((r = snp->GetStatus(snp, &irq, &txdone))) {
-            return;
-        }
-        if (txdone) {
-            // Check to make sure this is one of our buffers (see ZX-1516)
-            efi_physical_addr buf_paddr = (efi_physical_addr)txdone;
-            if ((buf_paddr >= eth_buffers_base)
-                && (buf_paddr < (eth_buffers_base + (NUM_BUFFER_PAGES * PAGE_SIZE)))) {
-                eth_put_buffer(txdone);
+    for (int n = 0; n < MAX_RX_PER_POLL; n++) {
+        if (eth_buffers_avail < num_eth_buffers) {
+            // Only check for completion if we have operations in progress.
+            // Otherwise, the result of GetStatus is unreliable. See ZX-759.
+            if ((r = snp->GetStatus(snp, &irq, &txdone))) {
+                return;
+            }
+            if (txdone) {
+                // Check to make sure this is one of our buffers (see ZX-1516)
+                efi_physical_addr buf_paddr = (efi_physical_addr)txdone;
+                if ((buf_paddr >= eth_buffers_base)
+                    && (buf_paddr < (eth_buffers_base + (NUM_BUFFER_PAGES * PAGE_SIZE)))) {
+                    eth_put_buffer(txdone);
+                }
             }
         }
-    }
 
-    hsz = 0;
-    bsz = sizeof(data);
-    r = snp->Receive(snp, &hsz, &bsz, data, NULL, NULL, NULL);
-    if (r != EFI_SUCCESS) {
-        return;
-    }
+        hsz = 0;
+        bsz = sizeof(data);
+        r = snp->Receive(snp, &hsz, &bsz, data, NULL, NULL, NULL);
+        if (r != EFI_SUCCESS) {
+            return;
+        }
 
 #if DROP_PACKETS
-    rxc++;
-    if ((random() % DROP_PACKETS) == 0) {
-        printf("rx drop %d\n", rxc);
-        return;
-    }
+        rxc++;
+        if ((random() % DROP_PACKETS) == 0) {
+            printf("rx drop %d\n", rxc);
+            continue;
+        }
 #endif
 
 #if TRACE
-    printf("RX %02x:%02x:%02x:%02x:%02x:%02x < %02x:%02x:%02x:%02x:%02x:%02x %02x%02x %d\n",
-            data[0], data[1], data[2], data[3], data[4], data[5],
-            data[6], data[7], data[8], data[9], data[10], data[11],
-            data[12], data[13], (int)(bsz - hsz));
+        printf("RX %02x:%02x:%02x:%02x:%02x:%02x < %02x:%02x:%02x:%02x:%02x:%02x %02x%02x %d\n",
+                data[0], data[1], data[2], data[3], data[4], data[5],
+                data[6], data[7], data[8], data[9], data[10], data[11],
+                data[12], data[13], (int)(bsz - hsz));
 #endif
-    eth_recv(data, bsz);
+        eth_recv(data, bsz);
+    }
 }
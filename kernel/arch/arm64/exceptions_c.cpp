@@ -447,6 +447,20 @@ void arch_fill_in_exception_context(const arch_exception_context_t* arch_context
     }
 }
 
+uintptr_t arch_exception_context_user_sp(const arch_exception_context_t* context) {
+    return context->frame->usp;
+}
+
+zx_status_t arch_redirect_exception_context(arch_exception_context_t* context,
+                                            uintptr_t pc, uintptr_t frame) {
+    struct arm64_iframe_long* iframe = context->frame;
+    iframe->elr = pc;
+    iframe->usp = frame;
+    iframe->r[0] = frame;
+    iframe->lr = 0;
+    return ZX_OK;
+}
+
 zx_status_t arch_dispatch_user_policy_exception(void) {
     struct arm64_iframe_long frame = {};
     arch_exception_context_t context = {};
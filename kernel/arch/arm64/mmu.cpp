@@ -469,6 +469,56 @@ volatile pte_t* ArmArchVmAspace::GetPageTable(vaddr_t index, uint page_size_shif
     }
 }
 
+// Used when an unmap or protect only covers part of a block mapping. |vaddr| is
+// the base of the block being split.
+volatile pte_t* ArmArchVmAspace::SplitBlock(vaddr_t vaddr, vaddr_t index, uint index_shift,
+                                            uint page_size_shift, volatile pte_t* page_table) {
+    pte_t pte = page_table[index];
+    paddr_t paddr;
+
+    DEBUG_ASSERT(index_shift > page_size_shift);
+    DEBUG_ASSERT((pte & MMU_PTE_DESCRIPTOR_MASK) == MMU_PTE_L012_DESCRIPTOR_BLOCK);
+
+    zx_status_t ret = AllocPageTable(&paddr, page_size_shift);
+    if (ret) {
+        TRACEF("failed to allocate page table\n");
+        return NULL;
+    }
+    volatile pte_t* next_page_table = static_cast<volatile pte_t*>(paddr_to_physmap(paddr));
+
+    uint next_index_shift = index_shift - (page_size_shift - 3);
+    paddr_t block_paddr = pte & MMU_PTE_OUTPUT_ADDR_MASK;
+    pte_t attrs = pte & ~(MMU_PTE_OUTPUT_ADDR_MASK | MMU_PTE_DESCRIPTOR_MASK);
+    attrs |= (next_index_shift > page_size_shift) ? MMU_PTE_L012_DESCRIPTOR_BLOCK
+                                                  : MMU_PTE_L3_DESCRIPTOR_PAGE;
+
+    uint count = 1U << (page_size_shift - 3);
+    for (uint i = 0; i < count; i++) {
+        next_page_table[i] = (block_paddr + ((paddr_t)i << next_index_shift)) | attrs;
+    }
+
+    // ensure that the new entries are observable from hardware page table walkers
+    DMB_ISHST;
+
+    // The architecture requires break-before-make when changing the size of
+    // a translation, so invalidate the block and flush it before installing
+    // the table.
+    page_table[index] = MMU_PTE_DESCRIPTOR_INVALID;
+    DSB_ISHST;
+    FlushTLBEntry(vaddr, true);
+    DSB;
+
+    pte = paddr | MMU_PTE_L012_DESCRIPTOR_TABLE;
+    page_table[index] = pte;
+    LTRACEF("split block, pte %p[%#" PRIxPTR "] = %#" PRIx64 "\n",
+            page_table, index, pte);
+
+    // ensure that the update is observable from hardware page table walkers
+    DMB_ISHST;
+
+    return next_page_table;
+}
+
 static bool page_table_is_clear(volatile pte_t* page_table, uint page_size_shift) {
     int i;
     int count = 1U << (page_size_shift - 3);
@@ -539,13 +589,27 @@ ssize_t ArmArchVmAspace::UnmapPageTable(vaddr_t vaddr, vaddr_t vaddr_rel,
 
         pte = page_table[index];
 
+        // A partial unmap of a block mapping has to split it first so the
+        // rest of the block stays mapped.
+        if (index_shift > page_size_shift && chunk_size != block_size &&
+            (pte & MMU_PTE_DESCRIPTOR_MASK) == MMU_PTE_L012_DESCRIPTOR_BLOCK) {
+            if (!SplitBlock(vaddr - vaddr_rem, index, index_shift, page_size_shift,
+                            page_table)) {
+                return ZX_ERR_NO_MEMORY;
+            }
+            pte = page_table[index];
+        }
+
         if (index_shift > page_size_shift &&
             (pte & MMU_PTE_DESCRIPTOR_MASK) == MMU_PTE_L012_DESCRIPTOR_TABLE) {
             page_table_paddr = pte & MMU_PTE_OUTPUT_ADDR_MASK;
             next_page_table = static_cast<volatile pte_t*>(paddr_to_physmap(page_table_paddr));
-            UnmapPageTable(vaddr, vaddr_rem, chunk_size,
-                           index_shift - (page_size_shift - 3),
-                           page_size_shift, next_page_table);
+            ssize_t ret = UnmapPageTable(vaddr, vaddr_rem, chunk_size,
+                                         index_shift - (page_size_shift - 3),
+                                         page_size_shift, next_page_table);
+            if (ret < 0) {
+                return ret;
+            }
             if (chunk_size == block_size ||
                 page_table_is_clear(next_page_table, page_size_shift)) {
                 LTRACEF("pte %p[0x%lx] = 0 (was page table)\n", page_table, index);
@@ -703,6 +767,15 @@ int ArmArchVmAspace::ProtectPageTable(vaddr_t vaddr_in, vaddr_t vaddr_rel_in,
         index = vaddr_rel >> index_shift;
         pte = page_table[index];
 
+        if (index_shift > page_size_shift && chunk_size != block_size &&
+            (pte & MMU_PTE_DESCRIPTOR_MASK) == MMU_PTE_L012_DESCRIPTOR_BLOCK) {
+            if (!SplitBlock(vaddr - vaddr_rem, index, index_shift, page_size_shift,
+                            page_table)) {
+                return ZX_ERR_NO_MEMORY;
+            }
+            pte = page_table[index];
+        }
+
         if (index_shift > page_size_shift &&
             (pte & MMU_PTE_DESCRIPTOR_MASK) == MMU_PTE_L012_DESCRIPTOR_TABLE) {
             page_table_paddr = pte & MMU_PTE_OUTPUT_ADDR_MASK;
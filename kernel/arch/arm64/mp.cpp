@@ -12,6 +12,7 @@
 #include <dev/interrupt.h>
 #include <err.h>
 #include <kernel/event.h>
+#include <kernel/mp.h>
 #include <platform.h>
 #include <trace.h>
 #include <zircon/types.h>
@@ -75,8 +76,13 @@ void arch_prepare_current_cpu_idle_state(bool idle) {
     // no-op
 }
 
+void arch_set_current_cpu_perf_hint(uint32_t hint, zx_time_t now) {
+    // no-op
+}
+
 zx_status_t arch_mp_reschedule(cpu_mask_t mask) {
-    return arch_mp_send_ipi(MP_IPI_TARGET_MASK, mask, MP_IPI_RESCHEDULE);
+    mp_send_ipi(MP_IPI_TARGET_MASK, mask, MP_IPI_RESCHEDULE);
+    return ZX_OK;
 }
 
 zx_status_t arch_mp_send_ipi(mp_ipi_target_t target, cpu_mask_t mask, mp_ipi_t ipi) {
@@ -106,6 +112,10 @@ void arm64_init_percpu_early(void) {
 
 void arch_mp_init_percpu(void) {
     interrupt_init_percpu();
+
+    // cpus within a cluster share the last level cache and there is no smt
+    cpu_num_t cpu = arch_curr_cpu_num();
+    mp_set_cpu_topology(cpu, arm64_cpu_cluster_ids[cpu], cpu);
 }
 
 void arch_flush_state_and_halt(event_t* flush_done) {
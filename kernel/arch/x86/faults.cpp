@@ -419,6 +419,13 @@ static void handle_exception_types(x86_iframe_t* frame) {
         /* no return */
         break;
     }
+    case X86_INT_POSTED_INTERRUPT: {
+        /* A posted-interrupt notification that arrived after its VCPU had
+         * exited. The VCPU picks up the posted interrupts before it next
+         * enters the guest, so there is nothing to do here. */
+        apic_issue_eoi();
+        break;
+    }
     case X86_INT_APIC_PMI: {
         apic_pmi_interrupt_handler(frame);
         // Note: apic_pmi_interrupt_handler calls apic_issue_eoi().
@@ -524,6 +531,29 @@ void arch_fill_in_exception_context(const arch_exception_context_t* arch_context
     zx_context->arch.u.x86_64.cr2 = arch_context->cr2;
 }
 
+uintptr_t arch_exception_context_user_sp(const arch_exception_context_t* context) {
+    return context->frame->user_sp;
+}
+
+zx_status_t arch_redirect_exception_context(arch_exception_context_t* context,
+                                            uintptr_t pc, uintptr_t frame) {
+    // Enter as if called from address 0, so that the stack is aligned the way
+    // the ABI expects at function entry and unwinders stop there.
+    uint64_t return_address = 0;
+    uintptr_t sp = frame - sizeof(return_address);
+    zx_status_t status = arch_copy_to_user(reinterpret_cast<void*>(sp), &return_address,
+                                           sizeof(return_address));
+    if (status != ZX_OK)
+        return status;
+
+    x86_iframe_t* iframe = context->frame;
+    iframe->ip = pc;
+    iframe->user_sp = sp;
+    iframe->rdi = frame;
+    iframe->flags &= ~X86_FLAGS_DF;
+    return ZX_OK;
+}
+
 zx_status_t arch_dispatch_user_policy_exception(void) {
     x86_iframe_t frame = {};
     arch_exception_context_t context = {};
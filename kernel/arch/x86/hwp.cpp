@@ -5,20 +5,103 @@
 // license that can be found in the LICENSE file or at
 // https://opensource.org/licenses/MIT
 
+#include <arch/mp.h>
 #include <arch/x86/feature.h>
 #include <err.h>
 #include <inttypes.h>
+#include <kernel/atomic.h>
 #include <kernel/auto_lock.h>
 #include <kernel/mp.h>
 #include <kernel/spinlock.h>
+#include <kernel/thread.h>
 #include <lib/console.h>
+#include <lib/counters.h>
+#include <platform.h>
 #include <string.h>
 #include <zircon/compiler.h>
+#include <zircon/time.h>
 
-static bool hwp_enabled = false;
+// the scheduler rewrites a cpu's request at most this often. hint changes in
+// between are left for the first context switch after the interval, so a cpu
+// alternating between threads with different hints settles on one of them
+// rather than paying for an msr write on every switch.
+#define HWP_MIN_UPDATE_INTERVAL ZX_USEC(500)
+
+KCOUNTER(hwp_request_writes, "kernel.hwp.request_writes");
+KCOUNTER(hwp_request_deferred, "kernel.hwp.request_deferred");
+
+// set once HWP is on and hwp_cpu is initialized on every cpu
+static volatile int hwp_enabled = false;
+
+// energy performance preference for threads without a hint
+static volatile int hwp_default_epp = 0x80;
 
 static SpinLock lock;
 
+struct hwp_cpu_state {
+    // performance levels from IA32_HWP_CAPABILITIES
+    uint8_t highest;
+    uint8_t guaranteed;
+    uint8_t lowest;
+
+    // hint the request is currently programmed for, and when it was written
+    uint32_t hint;
+    zx_time_t written;
+
+    // time spent under each hint, and the APERF/MPERF counts accumulated
+    // under it: their ratio is the delivered performance relative to the
+    // guaranteed one.
+    zx_duration_t residency[THREAD_PERF_HINT_COUNT];
+    uint64_t aperf[THREAD_PERF_HINT_COUNT];
+    uint64_t mperf[THREAD_PERF_HINT_COUNT];
+    uint64_t last_aperf;
+    uint64_t last_mperf;
+};
+
+// only touched by the cpu it belongs to, with interrupts disabled
+static hwp_cpu_state hwp_cpu[SMP_MAX_CPUS];
+
+static uint64_t hwp_request(const hwp_cpu_state* s, uint32_t hint) {
+    uint64_t epp;
+    uint64_t min;
+    switch (hint) {
+    case THREAD_PERF_HINT_LATENCY:
+        epp = 0;
+        min = s->guaranteed;
+        break;
+    case THREAD_PERF_HINT_EFFICIENCY:
+        epp = 0xff;
+        min = s->lowest;
+        break;
+    default:
+        epp = atomic_load(&hwp_default_epp) & 0xff;
+        min = s->lowest;
+        break;
+    }
+    // 14.4.4 desired performance is left at 0 for autonomous selection
+    return (epp << 24) | (static_cast<uint64_t>(s->highest) << 8) | min;
+}
+
+// Program the current cpu for |hint|, and charge the time since the last write
+// to the previous hint.
+static void hwp_write_request(hwp_cpu_state* s, uint32_t hint, zx_time_t now) {
+    if (x86_feature_test(X86_FEATURE_HW_FEEDBACK)) {
+        uint64_t aperf = read_msr(X86_MSR_IA32_APERF);
+        uint64_t mperf = read_msr(X86_MSR_IA32_MPERF);
+        s->aperf[s->hint] += aperf - s->last_aperf;
+        s->mperf[s->hint] += mperf - s->last_mperf;
+        s->last_aperf = aperf;
+        s->last_mperf = mperf;
+    }
+    s->residency[s->hint] = zx_duration_add_duration(s->residency[s->hint],
+                                                     zx_time_sub_time(now, s->written));
+
+    write_msr(X86_MSR_IA32_HWP_REQUEST, hwp_request(s, hint));
+    s->hint = hint;
+    s->written = now;
+    kcounter_add(hwp_request_writes, 1);
+}
+
 static void hwp_enable_sync_task(void* ctx) {
     // Enable HWP
     write_msr(X86_MSR_IA32_PM_ENABLE, 1);
@@ -26,8 +109,18 @@ static void hwp_enable_sync_task(void* ctx) {
     // 14.4.7 set minimum/maximum to values from capabilities for
     // common case. hint=0x80 by default
     uint64_t hwp_caps = read_msr(X86_MSR_IA32_HWP_CAPABILITIES);
-    uint64_t hwp_req = (0x80ull << 24) | ((hwp_caps & 0xff) << 8) | ((hwp_caps >> 24) & 0xff);
-    write_msr(X86_MSR_IA32_HWP_REQUEST, hwp_req);
+    hwp_cpu_state* s = &hwp_cpu[arch_curr_cpu_num()];
+    memset(s, 0, sizeof(*s));
+    s->highest = hwp_caps & 0xff;
+    s->guaranteed = (hwp_caps >> 8) & 0xff;
+    s->lowest = (hwp_caps >> 24) & 0xff;
+    s->hint = THREAD_PERF_HINT_NONE;
+    s->written = current_time();
+    if (x86_feature_test(X86_FEATURE_HW_FEEDBACK)) {
+        s->last_aperf = read_msr(X86_MSR_IA32_APERF);
+        s->last_mperf = read_msr(X86_MSR_IA32_MPERF);
+    }
+    write_msr(X86_MSR_IA32_HWP_REQUEST, hwp_request(s, THREAD_PERF_HINT_NONE));
 }
 
 static void hwp_enable(void) {
@@ -44,15 +137,15 @@ static void hwp_enable(void) {
 
     mp_sync_exec(MP_IPI_TARGET_ALL, 0, hwp_enable_sync_task, nullptr);
 
-    hwp_enabled = true;
+    atomic_store(&hwp_enabled, true);
 }
 
 static void hwp_set_hint_sync_task(void* ctx) {
-    uint8_t hint = (unsigned long)ctx & 0xff;
-    uint64_t hwp_req = read_msr(X86_MSR_IA32_HWP_REQUEST) & ~(0xff << 24);
-    hwp_req |= (hint << 24);
-    hwp_req &= ~(0xffffffffull << 32);
-    write_msr(X86_MSR_IA32_HWP_REQUEST, hwp_req);
+    // only cpus running threads without a hint use the default preference
+    hwp_cpu_state* s = &hwp_cpu[arch_curr_cpu_num()];
+    if (s->hint == THREAD_PERF_HINT_NONE) {
+        hwp_write_request(s, THREAD_PERF_HINT_NONE, current_time());
+    }
 }
 
 static void hwp_set_hint(unsigned long hint) {
@@ -66,7 +159,55 @@ static void hwp_set_hint(unsigned long hint) {
         printf("HWP hint not supported\n");
         return;
     }
-    mp_sync_exec(MP_IPI_TARGET_ALL, 0, hwp_set_hint_sync_task, (void*)hint);
+    atomic_store(&hwp_default_epp, static_cast<int>(hint & 0xff));
+    mp_sync_exec(MP_IPI_TARGET_ALL, 0, hwp_set_hint_sync_task, nullptr);
+}
+
+static void hwp_print_stats(void) {
+    static const char* const kHintNames[THREAD_PERF_HINT_COUNT] = {
+        "none", "latency", "efficiency",
+    };
+
+    if (!atomic_load(&hwp_enabled)) {
+        printf("Enable HWP first\n");
+        return;
+    }
+
+    // the counters are updated without a lock, so this is only a snapshot
+    for (cpu_num_t cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+        if (!mp_is_cpu_online(cpu)) {
+            continue;
+        }
+        const hwp_cpu_state* s = &hwp_cpu[cpu];
+        printf("cpu %u: perf %u-%u guaranteed %u, programmed for %s\n", cpu,
+               s->lowest, s->highest, s->guaranteed, kHintNames[s->hint]);
+        for (uint32_t hint = 0; hint < THREAD_PERF_HINT_COUNT; hint++) {
+            printf("  %-10s %10" PRIi64 " ms", kHintNames[hint],
+                   s->residency[hint] / ZX_MSEC(1));
+            if (s->mperf[hint] != 0) {
+                printf(", delivered %" PRIu64 "%% of guaranteed",
+                       s->aperf[hint] * 100 / s->mperf[hint]);
+            }
+            printf("\n");
+        }
+    }
+}
+
+// Called by the scheduler on every context switch, under the thread lock.
+void arch_set_current_cpu_perf_hint(uint32_t hint, zx_time_t now) {
+    if (!atomic_load(&hwp_enabled)) {
+        return;
+    }
+
+    hwp_cpu_state* s = &hwp_cpu[arch_curr_cpu_num()];
+    if (likely(s->hint == hint)) {
+        return;
+    }
+    if (zx_time_sub_time(now, s->written) < HWP_MIN_UPDATE_INTERVAL) {
+        kcounter_add(hwp_request_deferred, 1);
+        return;
+    }
+    hwp_write_request(s, hint, now);
 }
 
 static int cmd_hwp(int argc, const cmd_args* argv, uint32_t flags) {
@@ -77,6 +218,7 @@ static int cmd_hwp(int argc, const cmd_args* argv, uint32_t flags) {
         printf("usage:\n");
         printf("%s enable\n", argv[0].str);
         printf("%s hint <0-255>\n", argv[0].str);
+        printf("%s stats\n", argv[0].str);
         return ZX_ERR_INTERNAL;
     }
 
@@ -91,6 +233,8 @@ static int cmd_hwp(int argc, const cmd_args* argv, uint32_t flags) {
             goto usage;
         }
         hwp_set_hint(argv[2].u);
+    } else if (!strcmp(argv[1].str, "stats")) {
+        hwp_print_stats();
     } else {
         printf("unknown command\n");
         goto usage;
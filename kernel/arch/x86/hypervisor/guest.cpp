@@ -4,30 +4,38 @@
 // license that can be found in the LICENSE file or at
 // https://opensource.org/licenses/MIT
 
+#include <arch/hypervisor.h>
 #include <arch/x86/apic.h>
 #include <arch/x86/feature.h>
 #include <zircon/syscalls/hypervisor.h>
 
+#include "vcpu_priv.h"
+#include "vmexit_priv.h"
 #include "vmx_cpu_state_priv.h"
 
-static void ignore_msr(VmxPage* msr_bitmaps_page, bool ignore_writes, uint32_t msr) {
+static void clear_msr_bitmap(VmxPage* msr_bitmaps_page, bool write, uint32_t msr) {
     // From Volume 3, Section 24.6.9.
     uint8_t* msr_bitmaps = msr_bitmaps_page->VirtualAddress<uint8_t>();
     if (msr >= 0xc0000000) {
         msr_bitmaps += 1 << 10;
     }
+    if (write) {
+        msr_bitmaps += 2 << 10;
+    }
 
     uint16_t msr_low = msr & 0x1fff;
     uint16_t msr_byte = msr_low / 8;
     uint8_t msr_bit = msr_low % 8;
+    msr_bitmaps[msr_byte] &= (uint8_t) ~(1 << msr_bit);
+}
 
+static void ignore_msr(VmxPage* msr_bitmaps_page, bool ignore_writes, uint32_t msr) {
     // Ignore reads to the MSR.
-    msr_bitmaps[msr_byte] &= (uint8_t) ~(1 << msr_bit);
+    clear_msr_bitmap(msr_bitmaps_page, false, msr);
 
     if (ignore_writes) {
         // Ignore writes to the MSR.
-        msr_bitmaps += 2 << 10;
-        msr_bitmaps[msr_byte] &= (uint8_t) ~(1 << msr_bit);
+        clear_msr_bitmap(msr_bitmaps_page, true, msr);
     }
 }
 
@@ -75,6 +83,17 @@ zx_status_t Guest::Create(fbl::unique_ptr<Guest>* out) {
     ignore_msr(&guest->msr_bitmaps_page_, true, X86_MSR_IA32_SYSENTER_ESP);
     ignore_msr(&guest->msr_bitmaps_page_, true, X86_MSR_IA32_SYSENTER_EIP);
 
+    if (apic_virtualization_supported()) {
+        // From Volume 3, Section 29.5: With virtual-interrupt delivery, the
+        // processor virtualizes accesses to the TPR, and writes to EOI and
+        // SELF_IPI, using the virtual-APIC page. Other x2APIC accesses are
+        // still emulated.
+        ignore_msr(&guest->msr_bitmaps_page_, true, static_cast<uint32_t>(X2ApicMsr::TPR));
+        clear_msr_bitmap(&guest->msr_bitmaps_page_, true, static_cast<uint32_t>(X2ApicMsr::EOI));
+        clear_msr_bitmap(&guest->msr_bitmaps_page_, true,
+                         static_cast<uint32_t>(X2ApicMsr::SELF_IPI));
+    }
+
     // Setup VPID allocator
     fbl::AutoLock lock(&guest->vcpu_mutex_);
     status = guest->vpid_allocator_.Init();
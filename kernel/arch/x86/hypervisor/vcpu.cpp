@@ -8,11 +8,13 @@
 
 #include <arch/x86/descriptor.h>
 #include <arch/x86/feature.h>
+#include <arch/x86/mp.h>
 #include <arch/x86/pvclock.h>
 #include <fbl/auto_call.h>
 #include <hypervisor/cpu.h>
 #include <hypervisor/ktrace.h>
 #include <kernel/mp.h>
+#include <lib/counters.h>
 #include <lib/ktrace.h>
 #include <vm/fault.h>
 #include <vm/pmm.h>
@@ -30,6 +32,9 @@ static constexpr uint32_t kInterruptTypeHardwareException = 3u << 8;
 static constexpr uint32_t kInterruptTypeSoftwareException = 6u << 8;
 static constexpr uint16_t kBaseProcessorVpid = 1;
 
+KCOUNTER(vcpu_interrupts_posted, "kernel.hypervisor.interrupt.posted");
+KCOUNTER(vcpu_interrupts_notified, "kernel.hypervisor.interrupt.notified");
+
 static zx_status_t invept(InvEpt invalidation, uint64_t eptp) {
     uint8_t err;
     uint64_t descriptor[] = {eptp, 0};
@@ -270,9 +275,20 @@ static void edit_msr_list(VmxPage* msr_list_page, size_t index, uint32_t msr, ui
     entry->value = value;
 }
 
+bool apic_virtualization_supported() {
+    // Bits 63:32 of the capability MSRs report the controls that may be 1.
+    uint32_t procbased_ctls2 =
+        static_cast<uint32_t>(BITS_SHIFT(read_msr(X86_MSR_IA32_VMX_PROCBASED_CTLS2), 63, 32));
+    uint32_t pinbased_ctls =
+        static_cast<uint32_t>(BITS_SHIFT(read_msr(X86_MSR_IA32_VMX_TRUE_PINBASED_CTLS), 63, 32));
+    return (procbased_ctls2 & kProcbasedCtls2VirtualIntDelivery) &&
+           (pinbased_ctls & kPinbasedCtlsPostedInterrupts);
+}
+
 static zx_status_t vmcs_init(paddr_t vmcs_address, uint16_t vpid, uintptr_t entry,
                              paddr_t msr_bitmaps_address, paddr_t pml4_address, VmxState* vmx_state,
-                             VmxPage* host_msr_page, VmxPage* guest_msr_page) {
+                             VmxPage* host_msr_page, VmxPage* guest_msr_page,
+                             LocalApicState* local_apic_state) {
     zx_status_t status = vmclear(vmcs_address);
     if (status != ZX_OK)
         return status;
@@ -304,6 +320,22 @@ static zx_status_t vmcs_init(paddr_t vmcs_address, uint16_t vpid, uintptr_t entr
                     kProcbasedCtls2Invpcid,
                     0);
 
+    uint32_t pinbased_ctls = 0;
+    if (local_apic_state->apic_virtualization) {
+        // Enable virtual-interrupt delivery, so that the processor delivers
+        // interrupts from the virtual-APIC page and virtualizes EOIs.
+        status = vmcs.SetControl(VmcsField32::PROCBASED_CTLS2,
+                                 read_msr(X86_MSR_IA32_VMX_PROCBASED_CTLS2),
+                                 vmcs.Read(VmcsField32::PROCBASED_CTLS2),
+                                 kProcbasedCtls2VirtualIntDelivery,
+                                 0);
+        if (status != ZX_OK)
+            return status;
+        // Process posted interrupts, so that they can be delivered while the
+        // guest is running.
+        pinbased_ctls |= kPinbasedCtlsPostedInterrupts;
+    }
+
     // Setup pin-based VMCS controls.
     status = vmcs.SetControl(VmcsField32::PINBASED_CTLS,
                              read_msr(X86_MSR_IA32_VMX_TRUE_PINBASED_CTLS),
@@ -311,7 +343,8 @@ static zx_status_t vmcs_init(paddr_t vmcs_address, uint16_t vpid, uintptr_t entr
                              // External interrupts cause a VM exit.
                              kPinbasedCtlsExtIntExiting |
                                  // Non-maskable interrupts cause a VM exit.
-                                 kPinbasedCtlsNmiExiting,
+                                 kPinbasedCtlsNmiExiting |
+                                 pinbased_ctls,
                              0);
     if (status != ZX_OK)
         return status;
@@ -442,6 +475,29 @@ static zx_status_t vmcs_init(paddr_t vmcs_address, uint16_t vpid, uintptr_t entr
     // Setup MSR handling.
     vmcs.Write(VmcsField64::MSR_BITMAPS_ADDRESS, msr_bitmaps_address);
 
+    // From Volume 3, Section 24.6.8: The virtual-APIC page holds the shadow
+    // TPR, and is required when using the TPR shadow.
+    vmcs.Write(VmcsField64::VIRTUAL_APIC_ADDRESS,
+               local_apic_state->virtual_apic_page.PhysicalAddress());
+
+    if (local_apic_state->apic_virtualization) {
+        // From Volume 3, Section 29.1.2: Our local APIC has no level-triggered
+        // interrupts to complete, so no EOI causes a VM exit.
+        vmcs.Write(VmcsField64::EOI_EXIT_BITMAP_0, 0);
+        vmcs.Write(VmcsField64::EOI_EXIT_BITMAP_1, 0);
+        vmcs.Write(VmcsField64::EOI_EXIT_BITMAP_2, 0);
+        vmcs.Write(VmcsField64::EOI_EXIT_BITMAP_3, 0);
+        vmcs.Write(VmcsField16::GUEST_INTERRUPT_STATUS, 0);
+
+        // From Volume 3, Section 29.6: When the processor receives the
+        // notification vector while running the guest, it moves the vectors
+        // requested in the posted-interrupt descriptor into the virtual IRR
+        // and delivers them without a VM exit.
+        vmcs.Write(VmcsField16::POSTED_INTERRUPT_NOTIFICATION_VECTOR, X86_INT_POSTED_INTERRUPT);
+        vmcs.Write(VmcsField64::POSTED_INTERRUPT_DESC_ADDRESS,
+                   local_apic_state->posted_interrupt_page.PhysicalAddress());
+    }
+
     edit_msr_list(host_msr_page, 0, X86_MSR_IA32_KERNEL_GS_BASE,
                   read_msr(X86_MSR_IA32_KERNEL_GS_BASE));
     edit_msr_list(host_msr_page, 1, X86_MSR_IA32_STAR, read_msr(X86_MSR_IA32_STAR));
@@ -666,6 +722,19 @@ zx_status_t Vcpu::Create(Guest* guest, zx_vaddr_t entry, fbl::unique_ptr<Vcpu>*
     if (status != ZX_OK)
         return status;
 
+    status = vcpu->local_apic_state_.virtual_apic_page.Alloc(vmx_info, 0);
+    if (status != ZX_OK)
+        return status;
+
+    // The guest MSR bitmaps only pass local APIC accesses through to the
+    // virtual-APIC page when this is supported, see Guest::Create.
+    if (apic_virtualization_supported()) {
+        status = vcpu->local_apic_state_.posted_interrupt_page.Alloc(vmx_info, 0);
+        if (status != ZX_OK)
+            return status;
+        vcpu->local_apic_state_.apic_virtualization = true;
+    }
+
     status = vcpu->vmcs_page_.Alloc(vmx_info, 0);
     if (status != ZX_OK)
         return status;
@@ -675,7 +744,8 @@ zx_status_t Vcpu::Create(Guest* guest, zx_vaddr_t entry, fbl::unique_ptr<Vcpu>*
     region->revision_id = vmx_info.revision_id;
     zx_paddr_t table = gpas->arch_aspace()->arch_table_phys();
     status = vmcs_init(vcpu->vmcs_page_.PhysicalAddress(), vpid, entry, guest->MsrBitmapsAddress(),
-                       table, &vcpu->vmx_state_, &vcpu->host_msr_page_, &vcpu->guest_msr_page_);
+                       table, &vcpu->vmx_state_, &vcpu->host_msr_page_, &vcpu->guest_msr_page_,
+                       &vcpu->local_apic_state_);
     if (status != ZX_OK)
         return status;
 
@@ -699,8 +769,78 @@ Vcpu::~Vcpu() {
     DEBUG_ASSERT(status == ZX_OK);
 }
 
+// Merges |bits| into the 32 vectors of the virtual IRR starting at |base|.
+static void virtual_irr_merge(LocalApicState* local_apic_state, uint32_t base, uint32_t bits) {
+    // From Volume 3, Section 10.8.4: Each 32-bit IRR register is 16 bytes
+    // from the previous one.
+    uint8_t* virtual_apic = local_apic_state->virtual_apic_page.VirtualAddress<uint8_t>();
+    auto irr = reinterpret_cast<volatile uint32_t*>(virtual_apic + kVirtualApicIrr + base / 2);
+    *irr |= bits;
+}
+
+// Raises RVI to |vector|, so that the processor evaluates it on VM entry.
+static void raise_rvi(AutoVmcs* vmcs, uint8_t vector) {
+    // From Volume 3, Section 24.4.2: RVI is the low byte of the guest
+    // interrupt status, and SVI is the high byte.
+    uint16_t status = vmcs->Read(VmcsField16::GUEST_INTERRUPT_STATUS);
+    if (vector > (status & UINT8_MAX)) {
+        vmcs->Write(VmcsField16::GUEST_INTERRUPT_STATUS,
+                    static_cast<uint16_t>((status & ~UINT8_MAX) | vector));
+    }
+}
+
+// Moves the interrupts posted while the guest was not running into the
+// virtual IRR.
+static void sync_posted_interrupts(AutoVmcs* vmcs, LocalApicState* local_apic_state) {
+    auto pi_desc =
+        local_apic_state->posted_interrupt_page.VirtualAddress<PostedInterruptDescriptor>();
+    if ((__atomic_load_n(&pi_desc->control, __ATOMIC_SEQ_CST) & kPostedInterruptOutstanding) == 0) {
+        return;
+    }
+    // Clear the outstanding-notification bit before collecting the requests,
+    // so that any vector posted after we have read its word sends a new
+    // notification.
+    __atomic_fetch_and(&pi_desc->control, ~kPostedInterruptOutstanding, __ATOMIC_SEQ_CST);
+    int highest = -1;
+    for (uint32_t i = 0; i < countof(pi_desc->pir); i++) {
+        uint64_t pir = __atomic_exchange_n(&pi_desc->pir[i], 0, __ATOMIC_SEQ_CST);
+        if (pir == 0) {
+            continue;
+        }
+        virtual_irr_merge(local_apic_state, i * 64, static_cast<uint32_t>(pir));
+        virtual_irr_merge(local_apic_state, i * 64 + 32, static_cast<uint32_t>(pir >> 32));
+        highest = i * 64 + 63 - __builtin_clzl(pir);
+    }
+    if (highest >= 0) {
+        raise_rvi(vmcs, static_cast<uint8_t>(highest));
+    }
+}
+
+// Moves pending interrupts into the virtual IRR, from where virtual-interrupt
+// delivery injects them once the guest is able to take them. Exceptions are
+// still injected as events.
+static zx_status_t local_apic_virtual_interrupt(AutoVmcs* vmcs,
+                                                LocalApicState* local_apic_state) {
+    uint32_t vector;
+    zx_status_t status;
+    // Pop returns the highest vector first, so exceptions come last.
+    while ((status = local_apic_state->interrupt_tracker.Pop(&vector)) == ZX_OK) {
+        if (vector < X86_INT_PLATFORM_BASE) {
+            vmcs->IssueInterrupt(vector);
+            return ZX_OK;
+        }
+        virtual_irr_merge(local_apic_state, vector & ~31u, 1u << (vector % 32));
+        raise_rvi(vmcs, static_cast<uint8_t>(vector));
+    }
+    return status == ZX_ERR_NOT_FOUND ? ZX_OK : status;
+}
+
 // Injects an interrupt into the guest, if there is one pending.
 static zx_status_t local_apic_maybe_interrupt(AutoVmcs* vmcs, LocalApicState* local_apic_state) {
+    if (local_apic_state->apic_virtualization) {
+        return local_apic_virtual_interrupt(vmcs, local_apic_state);
+    }
+
     uint32_t vector;
     zx_status_t status = local_apic_state->interrupt_tracker.Pop(&vector);
     if (status != ZX_OK) {
@@ -737,8 +877,18 @@ zx_status_t Vcpu::Resume(zx_port_packet_t* packet) {
         // Updates guest system time if the guest subscribed to updates.
         pvclock_update_system_time(&pvclock_state_, guest_->AddressSpace());
 
+        // Our aspace may have been given a new PCID since the last entry,
+        // and the VM exit must restore the current one.
+        vmcs.Write(VmcsFieldXX::HOST_CR3, x86_get_cr3());
+
         ktrace(TAG_VCPU_ENTER, 0, 0, 0, 0);
         running_.store(true);
+        if (local_apic_state_.apic_virtualization) {
+            // Collect the interrupts posted while we were not running. Any
+            // posted from now on send a notification, which the processor
+            // handles once it has entered the guest.
+            sync_posted_interrupts(&vmcs, &local_apic_state_);
+        }
         status = vmx_enter(&vmx_state_);
         running_.store(false);
         if (x86_feature_test(X86_FEATURE_XSAVE)) {
@@ -772,6 +922,9 @@ void vmx_exit(VmxState* vmx_state) {
 }
 
 zx_status_t Vcpu::Interrupt(uint32_t vector) {
+    if (local_apic_state_.apic_virtualization && vector >= X86_INT_PLATFORM_BASE) {
+        return PostInterrupt(vector);
+    }
     bool signaled = false;
     zx_status_t status = local_apic_state_.interrupt_tracker.Interrupt(vector, &signaled);
     if (status != ZX_OK) {
@@ -782,6 +935,35 @@ zx_status_t Vcpu::Interrupt(uint32_t vector) {
     return ZX_OK;
 }
 
+// Posts |vector|. If the VCPU is running, the notification vector makes the
+// processor deliver it to the guest without a VM exit. Otherwise, it is moved
+// into the virtual IRR before the next VM entry.
+zx_status_t Vcpu::PostInterrupt(uint32_t vector) {
+    if (vector >= X86_INT_COUNT) {
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+    auto pi_desc =
+        local_apic_state_.posted_interrupt_page.VirtualAddress<PostedInterruptDescriptor>();
+    __atomic_fetch_or(&pi_desc->pir[vector / 64], 1ul << (vector % 64), __ATOMIC_SEQ_CST);
+    kcounter_add(vcpu_interrupts_posted, 1);
+
+    uint64_t control = __atomic_fetch_or(&pi_desc->control, kPostedInterruptOutstanding,
+                                         __ATOMIC_SEQ_CST);
+    if (control & kPostedInterruptOutstanding) {
+        // Whoever set the outstanding-notification bit has already notified
+        // or woken the VCPU, which will pick up this vector too.
+        return ZX_OK;
+    }
+    if (running_.load()) {
+        kcounter_add(vcpu_interrupts_notified, 1);
+        x86_send_ipi_vector(hypervisor::cpu_of(vpid_), X86_INT_POSTED_INTERRUPT);
+    } else {
+        // The VCPU may be waiting in HLT.
+        local_apic_state_.interrupt_tracker.Signal();
+    }
+    return ZX_OK;
+}
+
 template <typename Out, typename In>
 static void register_copy(Out* out, const In& in) {
     out->rax = in.rax;
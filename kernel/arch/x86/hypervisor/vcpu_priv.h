@@ -26,6 +26,7 @@ static const uint32_t kProcbasedCtls2Rdtscp             = 1u << 3;
 static const uint32_t kProcbasedCtls2x2Apic             = 1u << 4;
 static const uint32_t kProcbasedCtls2Vpid               = 1u << 5;
 static const uint32_t kProcbasedCtls2UnrestrictedGuest  = 1u << 7;
+static const uint32_t kProcbasedCtls2VirtualIntDelivery = 1u << 9;
 static const uint32_t kProcbasedCtls2Invpcid            = 1u << 12;
 
 // PROCBASED_CTLS flags.
@@ -44,6 +45,7 @@ static const uint32_t kProcbasedCtlsProcbasedCtls2      = 1u << 31;
 // PINBASED_CTLS flags.
 static const uint32_t kPinbasedCtlsExtIntExiting        = 1u << 0;
 static const uint32_t kPinbasedCtlsNmiExiting           = 1u << 3;
+static const uint32_t kPinbasedCtlsPostedInterrupts     = 1u << 7;
 
 // EXIT_CTLS flags.
 static const uint32_t kExitCtls64bitMode                = 1u << 9;
@@ -82,6 +84,13 @@ static const uint32_t kGuestXxAccessRightsDefault       = kGuestXxAccessRightsTy
                                                           kGuestXxAccessRightsS |
                                                           kGuestXxAccessRightsP;
 
+// Posted-interrupt descriptor control flags.
+static const uint64_t kPostedInterruptOutstanding       = 1u << 0;
+
+// Virtual-APIC page register offsets.
+static const size_t kVirtualApicPpr                     = 0x0a0;
+static const size_t kVirtualApicIrr                     = 0x200;
+
 // GUEST_INTERRUPTIBILITY_STATE flags.
 static const uint32_t kInterruptibilityStiBlocking      = 1u << 0;
 static const uint32_t kInterruptibilityMovSsBlocking    = 1u << 1;
@@ -89,8 +98,10 @@ static const uint32_t kInterruptibilityMovSsBlocking    = 1u << 1;
 // VMCS fields.
 enum class VmcsField16 : uint64_t {
     VPID                                                = 0x0000,
+    POSTED_INTERRUPT_NOTIFICATION_VECTOR                = 0x0002,
     GUEST_CS_SELECTOR                                   = 0x0802,
     GUEST_TR_SELECTOR                                   = 0x080e,
+    GUEST_INTERRUPT_STATUS                              = 0x0810,
     HOST_ES_SELECTOR                                    = 0x0c00,
     HOST_CS_SELECTOR                                    = 0x0c02,
     HOST_SS_SELECTOR                                    = 0x0c04,
@@ -105,7 +116,13 @@ enum class VmcsField64 : uint64_t {
     EXIT_MSR_STORE_ADDRESS                              = 0x2006,
     EXIT_MSR_LOAD_ADDRESS                               = 0x2008,
     ENTRY_MSR_LOAD_ADDRESS                              = 0x200a,
+    VIRTUAL_APIC_ADDRESS                                = 0x2012,
+    POSTED_INTERRUPT_DESC_ADDRESS                       = 0x2016,
     EPT_POINTER                                         = 0x201a,
+    EOI_EXIT_BITMAP_0                                   = 0x201c,
+    EOI_EXIT_BITMAP_1                                   = 0x201e,
+    EOI_EXIT_BITMAP_2                                   = 0x2020,
+    EOI_EXIT_BITMAP_3                                   = 0x2022,
     GUEST_PHYSICAL_ADDRESS                              = 0x2400,
     LINK_POINTER                                        = 0x2800,
     GUEST_IA32_PAT                                      = 0x2804,
@@ -209,6 +226,16 @@ enum class InvEpt : uint64_t {
 
 // clang-format on
 
+// From Volume 3, Section 29.6: The posted-interrupt descriptor. Each bit of
+// |pir| requests one vector, and |control| holds the outstanding-notification
+// bit that tells whether a notification has been sent for them.
+struct PostedInterruptDescriptor {
+    uint64_t pir[4];
+    uint64_t control;
+    uint64_t reserved[3];
+};
+static_assert(sizeof(PostedInterruptDescriptor) == 64, "");
+
 // Loads a VMCS within a given scope.
 class AutoVmcs : public hypervisor::StateInvalidator {
 public:
@@ -247,3 +274,8 @@ private:
 };
 
 bool cr0_is_invalid(AutoVmcs* vmcs, uint64_t cr0_value);
+
+// Returns whether the processor supports virtual-interrupt delivery and
+// posted interrupts, which let us deliver interrupts to a running VCPU
+// without a VM exit.
+bool apic_virtualization_supported();
@@ -17,10 +17,12 @@
 #include <arch/x86/mmu.h>
 #include <arch/x86/pvclock.h>
 #include <explicit-memory/bytes.h>
+#include <fbl/algorithm.h>
 #include <fbl/canary.h>
 #include <hypervisor/interrupt_tracker.h>
 #include <hypervisor/ktrace.h>
 #include <kernel/auto_lock.h>
+#include <kernel/thread.h>
 #include <lib/ktrace.h>
 #include <platform.h>
 #include <platform/pc/timer.h>
@@ -56,6 +58,13 @@ static_assert(sizeof(kHypVendorId) - 1 == kHypVendorIdLength, "");
 
 static constexpr uint64_t kKvmFeatureNoIoDelay = 1u << 1;
 
+// HLT polls for an interrupt for up to kHaltPollMax before it blocks. The
+// window starts at kHaltPollMin once a halt ends within kHaltPollMax, doubles
+// while halts keep ending within it, and halves, down to no polling, when
+// they outlast it.
+static constexpr zx_duration_t kHaltPollMin = ZX_USEC(10);
+static constexpr zx_duration_t kHaltPollMax = ZX_USEC(200);
+
 extern "C" void x86_call_external_interrupt_handler(uint64_t vector);
 
 ExitInfo::ExitInfo(const AutoVmcs& vmcs) {
@@ -337,10 +346,84 @@ static zx_status_t handle_cpuid(const ExitInfo& exit_info, AutoVmcs* vmcs,
     }
 }
 
+// Returns whether the virtual IRR holds an interrupt that virtual-interrupt
+// delivery would inject. See Volume 3, Section 29.2.1.
+static bool virtual_interrupt_pending(const AutoVmcs& vmcs, LocalApicState* local_apic_state) {
+    uint8_t rvi = static_cast<uint8_t>(vmcs.Read(VmcsField16::GUEST_INTERRUPT_STATUS));
+    uint8_t* virtual_apic = local_apic_state->virtual_apic_page.VirtualAddress<uint8_t>();
+    uint32_t vppr = *reinterpret_cast<volatile uint32_t*>(virtual_apic + kVirtualApicPpr);
+    return (rvi & 0xf0) > (vppr & 0xf0);
+}
+
+// Spins until |pending| returns true, for up to the halt poll window, and
+// returns whether it did. Interrupts are enabled while spinning, so the VMCS
+// may be unloaded, and the spin ends early if the thread has been signaled.
+template <typename F>
+static bool halt_poll(AutoVmcs* vmcs, LocalApicState* local_apic_state, F pending) {
+    if (local_apic_state->halt_poll_window == 0) {
+        return false;
+    }
+    vmcs->Invalidate();
+    ktrace_vcpu(TAG_VCPU_BLOCK, VCPU_HALT_POLL);
+    thread_t* thread = get_current_thread();
+    zx_time_t deadline = zx_time_add_duration(current_time(), local_apic_state->halt_poll_window);
+    bool hit;
+    arch_enable_ints();
+    while (!(hit = pending()) && thread->signals == 0 && current_time() < deadline) {
+        arch_spinloop_pause();
+    }
+    arch_disable_ints();
+    ktrace_vcpu_halt_poll(hit);
+    return hit;
+}
+
+static void update_halt_poll_window(LocalApicState* local_apic_state, zx_duration_t halted) {
+    zx_duration_t window = local_apic_state->halt_poll_window;
+    if (halted <= window) {
+        return;
+    }
+    if (halted > kHaltPollMax) {
+        window /= 2;
+        if (window < kHaltPollMin) {
+            window = 0;
+        }
+    } else if (window < kHaltPollMax) {
+        window = window == 0 ? kHaltPollMin : fbl::min(window * 2, kHaltPollMax);
+    }
+    local_apic_state->halt_poll_window = window;
+}
+
 static zx_status_t handle_hlt(const ExitInfo& exit_info, AutoVmcs* vmcs,
                               LocalApicState* local_apic_state) {
     next_rip(exit_info, vmcs);
-    return local_apic_state->interrupt_tracker.Wait(vmcs);
+    // The guest may halt with an interrupt already in the virtual IRR, for
+    // example right after STI.
+    if (local_apic_state->apic_virtualization &&
+        virtual_interrupt_pending(*vmcs, local_apic_state)) {
+        return ZX_OK;
+    }
+    PostedInterruptDescriptor* pi_desc = nullptr;
+    if (local_apic_state->apic_virtualization) {
+        pi_desc =
+            local_apic_state->posted_interrupt_page.VirtualAddress<PostedInterruptDescriptor>();
+    }
+    auto pending = [local_apic_state, pi_desc]() {
+        if (local_apic_state->interrupt_tracker.Pending()) {
+            return true;
+        }
+        return pi_desc != nullptr &&
+               (__atomic_load_n(&pi_desc->control, __ATOMIC_SEQ_CST) & kPostedInterruptOutstanding);
+    };
+
+    // Polling saves the wakeup through the scheduler for guests which are
+    // only briefly idle, such as between the messages of an RPC workload.
+    zx_time_t start = current_time();
+    zx_status_t status = ZX_OK;
+    if (!halt_poll(vmcs, local_apic_state, pending)) {
+        status = local_apic_state->interrupt_tracker.Wait(vmcs, pending);
+    }
+    update_halt_poll_window(local_apic_state, zx_time_sub_time(current_time(), start));
+    return status;
 }
 
 static zx_status_t handle_cr0_write(AutoVmcs* vmcs, GuestState* guest_state, uint64_t val) {
@@ -42,6 +42,7 @@ private:
     PtFlags terminal_flags(PageTableLevel level, uint flags) final;
     PtFlags split_flags(PageTableLevel level, PtFlags flags) final;
     void TlbInvalidate(PendingTlbInvalidation* pending) final;
+    PtFlags accessed_flag() final { return X86_MMU_PG_A; }
     uint pt_flags_to_mmu_flags(PtFlags flags, PageTableLevel level) final;
     bool needs_cache_flushes() final { return false; }
 
@@ -64,6 +65,8 @@ private:
     PtFlags terminal_flags(PageTableLevel level, uint flags) final;
     PtFlags split_flags(PageTableLevel level, PtFlags flags) final;
     void TlbInvalidate(PendingTlbInvalidation* pending) final;
+    // EPT accessed/dirty flags are not enabled.
+    PtFlags accessed_flag() final { return 0; }
     uint pt_flags_to_mmu_flags(PtFlags flags, PageTableLevel level) final;
     bool needs_cache_flushes() final { return false; }
 };
@@ -85,6 +88,11 @@ public:
     zx_status_t Unmap(vaddr_t vaddr, size_t count, size_t* unmapped) override;
     zx_status_t Protect(vaddr_t vaddr, size_t count, uint mmu_flags) override;
     zx_status_t Query(vaddr_t vaddr, paddr_t* paddr, uint* mmu_flags) override;
+    zx_status_t HarvestAccessed(vaddr_t vaddr, size_t count,
+                                harvest_accessed_fn_t accessed_fn, void* context) override;
+
+    void StartTlbBatch() override;
+    void FinishTlbBatch() override;
 
     vaddr_t PickSpot(vaddr_t base, uint prev_region_mmu_flags,
                      vaddr_t end, uint next_region_mmu_flags,
@@ -100,6 +108,17 @@ public:
 
     static void ContextSwitch(X86ArchVmAspace* from, X86ArchVmAspace* to);
 
+    // With PCIDs a CPU keeps an aspace's TLB entries while running other
+    // aspaces, and TLB shootdowns only reach the CPUs in active_cpus().
+    // Before a shootdown, MarkPcidStale() flags every other CPU that may
+    // hold entries for this aspace so that it flushes them when it next
+    // switches in.  A CPU handling the shootdown calls MarkPcidStale(cpu)
+    // if it has left the aspace in the meantime, or ClearPcidStale(cpu)
+    // before invalidating if it is still running in it.
+    void MarkPcidStale() { pcid_stale_cpus_.fetch_or(pcid_loaded_cpus_.load()); }
+    void MarkPcidStale(uint cpu) { pcid_stale_cpus_.fetch_or(static_cast<int>(1u << cpu)); }
+    void ClearPcidStale(uint cpu) { pcid_stale_cpus_.fetch_and(static_cast<int>(~(1u << cpu))); }
+
 private:
     // Test the vaddr against the address space's range.
     bool IsValidVaddr(vaddr_t vaddr) {
@@ -129,6 +148,19 @@ private:
     // CPUs that are currently executing in this aspace.
     // Actually an mp_cpu_mask_t, but header dependencies.
     fbl::atomic_int active_cpus_{0};
+
+    // The PCID this aspace runs with and the PCID generation it belongs to,
+    // as (generation << 12) | pcid, or 0 if it has none yet.
+    fbl::atomic<uint64_t> pcid_{0};
+    // CPUs that have run with |pcid_| and so may have TLB entries tagged
+    // with it, and the subset of those whose entries may be out of date
+    // because they missed an invalidation while running something else.
+    fbl::atomic_int pcid_loaded_cpus_{0};
+    fbl::atomic_int pcid_stale_cpus_{0};
+
+    // Give this aspace a PCID from the current generation, if it doesn't
+    // already have one, and return its new |pcid_| value.
+    uint64_t AssignPcid();
 };
 
 using ArchVmAspace = X86ArchVmAspace;
@@ -70,6 +70,16 @@ struct LocalApicState {
     uint32_t lvt_timer = LVT_MASKED; // Initial state is masked (Vol 3 Section 10.12.5.1).
     uint32_t lvt_initial_count;
     uint32_t lvt_divide_config;
+    // Virtual-APIC page, which holds the shadow TPR and, with APIC
+    // virtualization, the virtual IRR and ISR.
+    VmxPage virtual_apic_page;
+    // Whether interrupts are delivered through virtual-interrupt delivery and
+    // the posted-interrupt descriptor below, rather than by event injection.
+    bool apic_virtualization = false;
+    VmxPage posted_interrupt_page;
+    // How long HLT polls for an interrupt before it blocks, adapted to how
+    // long the guest has been halting for.
+    zx_duration_t halt_poll_window = 0;
 };
 
 // System time is time since boot time and boot time is some fixed point in the past. This
@@ -95,6 +105,8 @@ public:
     zx_status_t WriteState(uint32_t kind, const void* buf, size_t len);
 
 private:
+    zx_status_t PostInterrupt(uint32_t vector);
+
     Guest* guest_;
     const uint16_t vpid_;
     const thread_t* thread_;
@@ -57,6 +57,13 @@ void apic_send_ipi(
     uint8_t vector,
     uint32_t dst_apic_id,
     enum apic_interrupt_delivery_mode dm);
+// Sends |vector| to each of the |count| apics in |dst_apic_ids|, with as few
+// writes of the interrupt command register as the apic mode allows.
+void apic_send_multicast_ipi(
+    uint8_t vector,
+    const uint32_t* dst_apic_ids,
+    size_t count,
+    enum apic_interrupt_delivery_mode dm);
 void apic_send_self_ipi(uint8_t vector, enum apic_interrupt_delivery_mode dm);
 void apic_send_broadcast_ipi(
     uint8_t vector,
@@ -138,6 +145,11 @@ void apic_io_configure_irq_vector(
     uint32_t global_irq,
     uint8_t vector);
 uint8_t apic_io_fetch_irq_vector(uint32_t global_irq);
+// Route |global_irq| to the local APIC with physical ID |dst|, leaving the
+// rest of its configuration alone.
+void apic_io_configure_irq_dst(
+    uint32_t global_irq,
+    uint8_t dst);
 
 void apic_io_mask_isa_irq(uint8_t isa_irq, bool mask);
 // For ISA configuration, we don't need to specify the trigger mode
@@ -70,6 +70,11 @@
 
 #define X86_PAGING_LEVELS       4
 
+/* CR3 bits used with CR4.PCIDE set */
+#define X86_CR3_PCID_MASK       0xfffUL
+#define X86_CR3_NOFLUSH         (1UL << 63) /* keep the PCID's TLB entries */
+#define X86_MAX_PCID            0xfffu
+
 #define MMU_GUEST_SIZE_SHIFT    48
 
 /* page fault error code flags */
@@ -97,6 +97,10 @@ void x86_set_local_apic_id(uint32_t apic_id);
 
 int x86_apic_id_to_cpu_num(uint32_t apic_id);
 
+/* send a fixed IPI with an arbitrary |vector| to |cpu_num|, for vectors that
+ * are not covered by arch_mp_send_ipi */
+void x86_send_ipi_vector(cpu_num_t cpu_num, uint8_t vector);
+
 // Allocate all of the necessary structures for all of the APs to run.
 zx_status_t x86_allocate_ap_structures(uint32_t *apic_ids, uint8_t cpu_count);
 
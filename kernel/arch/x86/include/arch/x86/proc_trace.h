@@ -40,4 +40,7 @@ zx_status_t x86_ipt_stage_trace_data(zx_itrace_buffer_descriptor_t descriptor,
 zx_status_t x86_ipt_get_trace_data(zx_itrace_buffer_descriptor_t descriptor,
                                    zx_x86_pt_regs_t* regs);
 
+zx_status_t x86_ipt_snapshot_trace_data(zx_itrace_buffer_descriptor_t descriptor,
+                                        zx_x86_pt_regs_t* regs);
+
 #endif // __cplusplus
@@ -66,6 +66,8 @@
 #define X86_MSR_IA32_PM_ENABLE          0x00000770 /* enable/disable HWP */
 #define X86_MSR_IA32_HWP_CAPABILITIES   0x00000771 /* HWP performance range enumeration */
 #define X86_MSR_IA32_HWP_REQUEST        0x00000774 /* power manage control hints */
+#define X86_MSR_IA32_MPERF              0x000000e7 /* maximum performance clock count */
+#define X86_MSR_IA32_APERF              0x000000e8 /* actual performance clock count */
 #define X86_CR4_PSE                     0xffffffef /* Disabling PSE bit in the CR4 */
 
 // Non-architectural MSRs
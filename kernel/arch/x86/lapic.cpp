@@ -81,6 +81,16 @@ static bool bsp_apic_id_valid;
 
 #define X2_ICR_DST(x) ((uint64_t)(x) << 32)
 #define X2_ICR_BROADCAST ((uint64_t)(0xffffffff) << 32)
+#define ICR_DST_MODE_LOGICAL ((uint32_t)DST_MODE_LOGICAL << 11)
+
+// In x2APIC mode the logical destination register is fixed by the apic id:
+// the top bits pick one of the clusters of 16 apics and the low ones its bit
+// within the cluster, so one logical mode ipi reaches any set of apics that
+// share a cluster.
+#define X2_LOGICAL_CLUSTER(id) ((id) >> 4)
+#define X2_LOGICAL_CLUSTER_BIT(id) (1u << ((id) & 0xf))
+#define X2_LOGICAL_DST(cluster, bits) (((uint32_t)(cluster) << 16) | (bits))
+#define X2_NUM_CLUSTERS (256 / 16)
 
 // Common LVT bitmasks
 #define LVT_VECTOR(x) (x)
@@ -199,7 +209,8 @@ static inline void apic_wait_for_ipi_send(void) {
         ;
 }
 
-// We only support physical destination modes for now
+// We only use physical destination modes, except for multicasts in x2APIC
+// mode
 
 void apic_send_ipi(
     uint8_t vector,
@@ -223,6 +234,39 @@ void apic_send_ipi(
     arch_interrupt_restore(state, 0);
 }
 
+void apic_send_multicast_ipi(
+    uint8_t vector,
+    const uint32_t* dst_apic_ids,
+    size_t count,
+    enum apic_interrupt_delivery_mode dm) {
+    if (!x2apic_enabled) {
+        for (size_t i = 0; i < count; i++) {
+            apic_send_ipi(vector, dst_apic_ids[i], dm);
+        }
+        return;
+    }
+
+    uint16_t clusters[X2_NUM_CLUSTERS] = {};
+    for (size_t i = 0; i < count; i++) {
+        // we only support 8 bit apic ids
+        DEBUG_ASSERT(dst_apic_ids[i] < UINT8_MAX);
+        clusters[X2_LOGICAL_CLUSTER(dst_apic_ids[i])] |=
+            (uint16_t)X2_LOGICAL_CLUSTER_BIT(dst_apic_ids[i]);
+    }
+
+    uint32_t request = ICR_VECTOR(vector) | ICR_LEVEL_ASSERT;
+    request |= ICR_DELIVERY_MODE(dm) | ICR_DST_MODE_LOGICAL;
+
+    spin_lock_saved_state_t state;
+    arch_interrupt_save(&state, 0);
+    for (uint32_t c = 0; c < X2_NUM_CLUSTERS; c++) {
+        if (clusters[c]) {
+            write_msr(LAPIC_X2APIC_MSR_ICR, X2_ICR_DST(X2_LOGICAL_DST(c, clusters[c])) | request);
+        }
+    }
+    arch_interrupt_restore(state, 0);
+}
+
 void apic_send_self_ipi(uint8_t vector, enum apic_interrupt_delivery_mode dm) {
     uint32_t request = ICR_VECTOR(vector) | ICR_LEVEL_ASSERT;
     request |= ICR_DELIVERY_MODE(dm) | ICR_DST_SELF;
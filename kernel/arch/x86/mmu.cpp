@@ -16,7 +16,10 @@
 #include <arch/x86/feature.h>
 #include <arch/x86/mmu.h>
 #include <arch/x86/mmu_mem_types.h>
+#include <kernel/auto_lock.h>
 #include <kernel/mp.h>
+#include <kernel/spinlock.h>
+#include <lib/counters.h>
 #include <vm/arch_vm_aspace.h>
 #include <vm/physmap.h>
 #include <vm/pmm.h>
@@ -34,6 +37,9 @@ uint8_t g_paddr_width = 32;
 /* True if the system supports 1GB pages */
 static bool supports_huge_pages = false;
 
+/* True if user aspaces are tagged with PCIDs (CR4.PCIDE is set) */
+static bool use_pcid = false;
+
 /* top level kernel page tables, initialized in start.S */
 volatile pt_entry_t pml4[NO_OF_PT_ENTRIES] __ALIGNED(PAGE_SIZE);
 volatile pt_entry_t pdp[NO_OF_PT_ENTRIES] __ALIGNED(PAGE_SIZE); /* temporary */
@@ -137,20 +143,47 @@ static void x86_tlb_nonglobal_invalidate() {
     x86_set_cr3(x86_get_cr3());
 }
 
+KCOUNTER(tlb_shootdowns, "kernel.mmu.tlb_shootdown");
+KCOUNTER(tlb_shootdown_ipis, "kernel.mmu.tlb_shootdown.ipis");
+KCOUNTER(pcid_stale_flushes, "kernel.mmu.pcid.stale_flush");
+KCOUNTER(pcid_generations, "kernel.mmu.pcid.generation");
+
+/* PCIDs are handed out in generations.  An aspace gets a PCID from the
+ * current generation the first time it runs in it, and when they run out a
+ * new generation starts.  Each CPU flushes its entire TLB before it first
+ * uses a PCID of a new generation, so PCIDs never need to be freed and a
+ * recycled one never finds entries left by its previous owner.  PCID 0 is
+ * the kernel aspace's. */
+static SpinLock pcid_lock;
+static fbl::atomic<uint64_t> pcid_generation{1};
+static uint pcid_next TA_GUARDED(pcid_lock) = 1;
+/* The generation of the PCIDs in each CPU's TLB; only touched by that CPU */
+static uint64_t pcid_cpu_generation[SMP_MAX_CPUS];
+
 /* Task used for invalidating a TLB entry on each CPU */
 struct TlbInvalidatePage_context {
     ulong target_cr3;
+    /* The aspace being invalidated, if it is tagged with a PCID */
+    X86ArchVmAspace* pcid_aspace;
     const PendingTlbInvalidation* pending;
 };
 static void TlbInvalidatePage_task(void* raw_context) {
     DEBUG_ASSERT(arch_ints_disabled());
     TlbInvalidatePage_context* context = (TlbInvalidatePage_context*)raw_context;
 
-    ulong cr3 = x86_get_cr3();
+    ulong cr3 = x86_get_cr3() & ~X86_CR3_PCID_MASK;
     if (context->target_cr3 != cr3 && !context->pending->contains_global) {
-        /* This invalidation doesn't apply to this CPU, ignore it */
+        /* This invalidation doesn't apply to this CPU, ignore it.  If we
+         * left the aspace after the IPI was sent, its PCID may still hold
+         * the entries, so flush them when we switch back. */
+        if (context->pcid_aspace) {
+            context->pcid_aspace->MarkPcidStale(arch_curr_cpu_num());
+        }
         return;
     }
+    if (context->pcid_aspace) {
+        context->pcid_aspace->ClearPcidStale(arch_curr_cpu_num());
+    }
 
     if (context->pending->full_shootdown) {
         if (context->pending->contains_global) {
@@ -186,9 +219,9 @@ static void x86_tlb_invalidate_page(const X86PageTableBase* pt, PendingTlbInvali
         return;
     }
 
-    ulong cr3 = pt ? pt->phys() : x86_get_cr3();
+    ulong cr3 = pt ? pt->phys() : (x86_get_cr3() & ~X86_CR3_PCID_MASK);
     struct TlbInvalidatePage_context task_context = {
-        .target_cr3 = cr3, .pending = pending,
+        .target_cr3 = cr3, .pcid_aspace = nullptr, .pending = pending,
     };
 
     /* Target only CPUs this aspace is active on.  It may be the case that some
@@ -201,10 +234,24 @@ static void x86_tlb_invalidate_page(const X86PageTableBase* pt, PendingTlbInvali
     if (pending->contains_global || pt == nullptr) {
         target = MP_IPI_TARGET_ALL;
     } else {
+        X86ArchVmAspace* aspace = static_cast<X86ArchVmAspace*>(pt->ctx());
+        if (use_pcid) {
+            /* This has to happen before reading the active CPUs, see
+             * X86ArchVmAspace::ContextSwitch. */
+            aspace->MarkPcidStale();
+            task_context.pcid_aspace = aspace;
+        }
         target = MP_IPI_TARGET_MASK;
-        target_mask = static_cast<X86ArchVmAspace*>(pt->ctx())->active_cpus();
+        target_mask = aspace->active_cpus();
     }
 
+    // Count the other CPUs this will interrupt.  The current CPU may change
+    // under us, so the count is approximate.
+    cpu_mask_t ipi_mask = (target == MP_IPI_TARGET_ALL) ? mp_get_online_mask() : target_mask;
+    ipi_mask &= mp_get_online_mask() & ~cpu_num_to_mask(arch_curr_cpu_num());
+    kcounter_add(tlb_shootdowns, 1);
+    kcounter_add(tlb_shootdown_ipis, __builtin_popcount(ipi_mask));
+
     mp_sync_exec(target, target_mask, TlbInvalidatePage_task, &task_context);
     pending->clear();
 }
@@ -467,6 +514,10 @@ uint X86PageTableEpt::pt_flags_to_mmu_flags(PtFlags flags, PageTableLevel level)
 }
 
 void x86_mmu_early_init() {
+    /* Flushing every PCID at the start of a generation relies on toggling
+     * CR4.PGE, which the boot code always sets. */
+    use_pcid = x86_feature_test(X86_FEATURE_PCID) && (x86_get_cr4() & X86_CR4_PGE);
+
     x86_mmu_percpu_init();
 
     x86_mmu_mem_type_init();
@@ -641,9 +692,69 @@ zx_status_t X86ArchVmAspace::Protect(vaddr_t vaddr, size_t count, uint mmu_flags
     return pt_->ProtectPages(vaddr, count, mmu_flags);
 }
 
+void X86ArchVmAspace::StartTlbBatch() {
+    pt_->StartTlbBatch();
+}
+
+void X86ArchVmAspace::FinishTlbBatch() {
+    pt_->FinishTlbBatch();
+}
+
+uint64_t X86ArchVmAspace::AssignPcid() {
+    AutoSpinLockNoIrqSave guard(&pcid_lock);
+
+    uint64_t generation = pcid_generation.load();
+    uint64_t pcid = pcid_.load();
+    if ((pcid >> 12) == generation) {
+        // Another CPU got here first.
+        return pcid;
+    }
+    if (pcid_next > X86_MAX_PCID) {
+        generation++;
+        pcid_generation.store(generation);
+        pcid_next = 1;
+        kcounter_add(pcid_generations, 1);
+    }
+    pcid = (generation << 12) | pcid_next++;
+    pcid_.store(pcid);
+    return pcid;
+}
+
 void X86ArchVmAspace::ContextSwitch(X86ArchVmAspace* old_aspace, X86ArchVmAspace* aspace) {
-    cpu_mask_t cpu_bit = cpu_num_to_mask(arch_curr_cpu_num());
-    if (aspace != nullptr) {
+    const uint cpu = arch_curr_cpu_num();
+    cpu_mask_t cpu_bit = cpu_num_to_mask(cpu);
+    if (aspace != nullptr && use_pcid) {
+        aspace->canary_.Assert();
+        paddr_t phys = aspace->pt_phys();
+        LTRACEF_LEVEL(3, "switching to aspace %p, pt %#" PRIXPTR "\n", aspace, phys);
+
+        // Become active before looking for stale entries.  A TLB shootdown
+        // marks CPUs stale before it reads the active CPUs, so it either
+        // sends us an IPI or we see its mark here.
+        aspace->active_cpus_.fetch_or(cpu_bit);
+        aspace->pcid_loaded_cpus_.fetch_or(cpu_bit);
+
+        uint64_t pcid = aspace->pcid_.load();
+        if ((pcid >> 12) != pcid_generation.load()) {
+            pcid = aspace->AssignPcid();
+        }
+        if (pcid_cpu_generation[cpu] != (pcid >> 12)) {
+            x86_tlb_global_invalidate();
+            pcid_cpu_generation[cpu] = pcid >> 12;
+        }
+
+        ulong cr3 = phys | (pcid & X86_CR3_PCID_MASK);
+        if (aspace->pcid_stale_cpus_.fetch_and(~cpu_bit) & cpu_bit) {
+            kcounter_add(pcid_stale_flushes, 1);
+        } else {
+            cr3 |= X86_CR3_NOFLUSH;
+        }
+        x86_set_cr3(cr3);
+
+        if (old_aspace != nullptr) {
+            old_aspace->active_cpus_.fetch_and(~cpu_bit);
+        }
+    } else if (aspace != nullptr) {
         aspace->canary_.Assert();
         paddr_t phys = aspace->pt_phys();
         LTRACEF_LEVEL(3, "switching to aspace %p, pt %#" PRIXPTR "\n", aspace, phys);
@@ -677,6 +788,14 @@ zx_status_t X86ArchVmAspace::Query(vaddr_t vaddr, paddr_t* paddr, uint* mmu_flag
     return pt_->QueryVaddr(vaddr, paddr, mmu_flags);
 }
 
+zx_status_t X86ArchVmAspace::HarvestAccessed(vaddr_t vaddr, size_t count,
+                                             harvest_accessed_fn_t accessed_fn, void* context) {
+    if (!IsValidVaddr(vaddr))
+        return ZX_ERR_INVALID_ARGS;
+
+    return pt_->HarvestAccessed(vaddr, count, accessed_fn, context);
+}
+
 void x86_mmu_percpu_init(void) {
     ulong cr0 = x86_get_cr0();
     /* Set write protect bit in CR0*/
@@ -691,6 +810,9 @@ void x86_mmu_percpu_init(void) {
         cr4 |= X86_CR4_SMEP;
     if (x86_feature_test(X86_FEATURE_SMAP))
         cr4 |= X86_CR4_SMAP;
+    /* CR3 has no PCID bits yet, as enabling PCIDE requires */
+    if (use_pcid)
+        cr4 |= X86_CR4_PCIDE;
     x86_set_cr4(cr4);
 
     // Set NXE bit in X86_MSR_IA32_EFER.
@@ -27,6 +27,7 @@
 #include <dev/hw_rng.h>
 #include <dev/interrupt.h>
 #include <kernel/event.h>
+#include <kernel/mp.h>
 #include <kernel/timer.h>
 #include <platform.h>
 #include <zircon/types.h>
@@ -130,6 +131,15 @@ zx_status_t x86_allocate_ap_structures(uint32_t* apic_ids, uint8_t cpu_count) {
     return ZX_OK;
 }
 
+// Publish the cache and smt layout of |cpu_num| to the scheduler.
+static void x86_register_cpu_topology(cpu_num_t cpu_num, uint32_t apic_id) {
+    x86_cpu_topology_t topo;
+    x86_cpu_topology_decode(apic_id, &topo);
+
+    // The last level cache is shared at the die level.
+    mp_set_cpu_topology(cpu_num, (topo.package_id << 16) | topo.node_id, topo.core_id);
+}
+
 void x86_init_percpu(cpu_num_t cpu_num) {
     struct x86_percpu* const percpu =
         cpu_num == 0 ? &bp_percpu : &ap_percpus[cpu_num - 1];
@@ -147,6 +157,10 @@ void x86_init_percpu(cpu_num_t cpu_num) {
     x86_feature_init();
 
     x86_cpu_topology_init();
+    if (cpu_num != 0) {
+        // The bootstrap processor registers once its local APIC id is known.
+        x86_register_cpu_topology(cpu_num, percpu->apic_id);
+    }
     x86_extended_register_init();
     x86_extended_register_enable_feature(X86_EXTENDED_REGISTER_SSE);
     x86_extended_register_enable_feature(X86_EXTENDED_REGISTER_AVX);
@@ -243,6 +257,7 @@ void x86_set_local_apic_id(uint32_t apic_id) {
     struct x86_percpu* percpu = x86_get_percpu();
     DEBUG_ASSERT(percpu->cpu_num == 0);
     percpu->apic_id = apic_id;
+    x86_register_cpu_topology(0, apic_id);
 }
 
 int x86_apic_id_to_cpu_num(uint32_t apic_id) {
@@ -285,7 +300,10 @@ zx_status_t arch_mp_reschedule(cpu_mask_t mask) {
         needs_ipi = mask;
     }
 
-    return needs_ipi ? arch_mp_send_ipi(MP_IPI_TARGET_MASK, needs_ipi, MP_IPI_RESCHEDULE) : ZX_OK;
+    if (needs_ipi) {
+        mp_send_ipi(MP_IPI_TARGET_MASK, needs_ipi, MP_IPI_RESCHEDULE);
+    }
+    return ZX_OK;
 }
 
 void arch_prepare_current_cpu_idle_state(bool idle) {
@@ -347,6 +365,8 @@ zx_status_t arch_mp_send_ipi(mp_ipi_target_t target, cpu_mask_t mask, mp_ipi_t i
 
     ASSERT(x86_num_cpus <= sizeof(mask) * CHAR_BIT);
 
+    uint32_t apic_ids[SMP_MAX_CPUS];
+    size_t num_apic_ids = 0;
     cpu_mask_t remaining = mask;
     uint cpu_id = 0;
     while (remaining && cpu_id < x86_num_cpus) {
@@ -364,16 +384,29 @@ zx_status_t arch_mp_send_ipi(mp_ipi_target_t target, cpu_mask_t mask, mp_ipi_t i
             }
             /* Make sure the CPU is actually up before sending the IPI */
             if (percpu->apic_id != INVALID_APIC_ID) {
-                apic_send_ipi(vector, (uint8_t)percpu->apic_id, DELIVERY_MODE_FIXED);
+                apic_ids[num_apic_ids++] = percpu->apic_id;
             }
         }
         remaining >>= 1;
         cpu_id++;
     }
 
+    if (num_apic_ids == 1) {
+        apic_send_ipi(vector, apic_ids[0], DELIVERY_MODE_FIXED);
+    } else if (num_apic_ids > 1) {
+        apic_send_multicast_ipi(vector, apic_ids, num_apic_ids, DELIVERY_MODE_FIXED);
+    }
+
     return ZX_OK;
 }
 
+void x86_send_ipi_vector(cpu_num_t cpu_num, uint8_t vector) {
+    DEBUG_ASSERT(cpu_num < x86_num_cpus);
+    struct x86_percpu* percpu = (cpu_num == 0) ? &bp_percpu : &ap_percpus[cpu_num - 1];
+    DEBUG_ASSERT(percpu->apic_id != INVALID_APIC_ID);
+    apic_send_ipi(vector, percpu->apic_id, DELIVERY_MODE_FIXED);
+}
+
 void x86_ipi_halt_handler(void*) {
     printf("halting cpu %u\n", arch_curr_cpu_num());
 
@@ -10,9 +10,12 @@
 #include <fbl/canary.h>
 #include <fbl/mutex.h>
 #include <hwreg/bitfields.h>
+#include <list.h>
 // Needed for ARCH_MMU_FLAG_*
 #include <vm/arch_vm_aspace.h>
 
+struct thread;
+
 typedef uint64_t pt_entry_t;
 #define PRIxPTE PRIx64
 
@@ -53,6 +56,9 @@ struct PendingTlbInvalidation {
     // bit set.
     void enqueue(vaddr_t v, PageTableLevel level, bool is_global_page, bool is_terminal);
 
+    // Add all of |other|'s invalidations to this one and clear |other|.
+    void merge(PendingTlbInvalidation* other);
+
     // Clear the list of pending invalidations
     void clear();
 
@@ -91,6 +97,14 @@ public:
 
     zx_status_t QueryVaddr(vaddr_t vaddr, paddr_t* paddr, uint* mmu_flags);
 
+    zx_status_t HarvestAccessed(vaddr_t vaddr, size_t count,
+                                harvest_accessed_fn_t accessed_fn, void* context);
+
+    // See ArchVmAspaceInterface::StartTlbBatch().  Batches may nest, but
+    // only one thread may have a batch open at a time.
+    void StartTlbBatch();
+    void FinishTlbBatch();
+
 protected:
     // Initialize an empty page table, assigning this given context to it.
     zx_status_t Init(void* ctx);
@@ -119,6 +133,10 @@ protected:
     // Execute the given pending invalidation
     virtual void TlbInvalidate(PendingTlbInvalidation* pending) = 0;
 
+    // Return the hardware flag set on terminal entries when they are accessed,
+    // or 0 if these page tables do not track accesses.
+    virtual PtFlags accessed_flag() = 0;
+
     // Convert PtFlags to ARCH_MMU_* flags.
     virtual uint pt_flags_to_mmu_flags(PtFlags flags, PageTableLevel level) = 0;
     // Returns true if a cache flush is necessary for pagetable changes to be
@@ -185,4 +203,12 @@ private:
 
     // low lock to protect the mmu code
     fbl::Mutex lock_;
+
+    // The thread with an open TLB batch, if any, and how deeply nested it is.
+    thread* tlb_batch_owner_ TA_GUARDED(lock_) = nullptr;
+    uint tlb_batch_depth_ TA_GUARDED(lock_) = 0;
+    // Invalidations deferred by the open batch, and the page tables that can
+    // only be freed once they have been performed.
+    PendingTlbInvalidation deferred_tlb_ TA_GUARDED(lock_);
+    list_node deferred_free_ TA_GUARDED(lock_) = LIST_INITIAL_VALUE(deferred_free_);
 };
@@ -12,12 +12,16 @@
 #include <fbl/algorithm.h>
 #include <fbl/auto_call.h>
 #include <fbl/auto_lock.h>
+#include <kernel/thread.h>
+#include <lib/counters.h>
 #include <trace.h>
 #include <vm/physmap.h>
 #include <vm/pmm.h>
 
 #define LOCAL_TRACE 0
 
+KCOUNTER(tlb_batched_invalidations, "kernel.mmu.tlb_invalidation.batched");
+
 namespace {
 
 // Return the page size for this level
@@ -105,6 +109,20 @@ void PendingTlbInvalidation::enqueue(vaddr_t v, PageTableLevel level, bool is_gl
     count++;
 }
 
+void PendingTlbInvalidation::merge(PendingTlbInvalidation* other) {
+    if (other->contains_global) {
+        contains_global = true;
+    }
+    if (other->full_shootdown || count + other->count > fbl::count_of(item)) {
+        full_shootdown = true;
+    } else {
+        for (uint i = 0; i < other->count; ++i) {
+            item[count++] = other->item[i];
+        }
+    }
+    other->clear();
+}
+
 void PendingTlbInvalidation::clear() {
     count = 0;
     full_shootdown = false;
@@ -185,8 +203,9 @@ public:
     CacheLineFlusher* cache_line_flusher() { return &clf_; }
     PendingTlbInvalidation* pending_tlb() { return &tlb_; }
 
-    // This function must be called while holding pt_->lock_.
-    void Finish();
+    // This function must be called while holding pt_->lock_.  Thread safety
+    // analysis is disabled for the same reason as in queue_free().
+    void Finish() TA_NO_THREAD_SAFETY_ANALYSIS;
 private:
     X86PageTableBase* pt_;
 
@@ -227,7 +246,21 @@ void X86PageTableBase::ConsistencyManager::Finish() {
         // invalidations.
         mb();
     }
-    pt_->TlbInvalidate(&tlb_);
+    if (pt_->tlb_batch_owner_ == get_current_thread()) {
+        // Leave the invalidation to FinishTlbBatch(), which must also be the
+        // one to free any page tables the hardware may still be caching.
+        if (tlb_.count > 0 || tlb_.full_shootdown) {
+            kcounter_add(tlb_batched_invalidations, 1);
+        }
+        pt_->deferred_tlb_.merge(&tlb_);
+        list_splice_after(&to_free_, &pt_->deferred_free_);
+    } else {
+        // Someone else's batch may have removed entries a caller of ours is
+        // about to rely on being gone, e.g. before freeing the pages they
+        // mapped, so perform its invalidations now as well.
+        tlb_.merge(&pt_->deferred_tlb_);
+        pt_->TlbInvalidate(&tlb_);
+    }
     pt_ = nullptr;
 }
 
@@ -1021,6 +1054,82 @@ zx_status_t X86PageTableBase::QueryVaddr(vaddr_t vaddr, paddr_t* paddr, uint* mm
     return ZX_OK;
 }
 
+zx_status_t X86PageTableBase::HarvestAccessed(vaddr_t vaddr, size_t count,
+                                              harvest_accessed_fn_t accessed_fn, void* context) {
+    canary_.Assert();
+
+    LTRACEF("aspace %p, vaddr %#" PRIxPTR " count %#zx\n", this, vaddr, count);
+
+    const PtFlags accessed = accessed_flag();
+    if (accessed == 0)
+        return ZX_ERR_NOT_SUPPORTED;
+    if (!check_vaddr(vaddr))
+        return ZX_ERR_INVALID_ARGS;
+
+    ConsistencyManager cm(this);
+    {
+        fbl::AutoLock a(&lock_);
+        for (size_t i = 0; i < count; i++) {
+            const vaddr_t va = vaddr + i * PAGE_SIZE;
+
+            PageTableLevel level;
+            volatile pt_entry_t* pte;
+            if (GetMapping(virt_, va, top_level(), &level, &pte) != ZX_OK)
+                continue;
+            if (!(*pte & accessed))
+                continue;
+
+            // Clearing the flag on a large page would hide accesses to the
+            // rest of it, so only terminal 4k entries are reset. The update
+            // has to be atomic since the hardware may set the dirty flag
+            // concurrently.
+            if (level == PT_L) {
+                __atomic_fetch_and(pte, ~accessed, __ATOMIC_RELAXED);
+                cm.cache_line_flusher()->FlushPtEntry(pte);
+                cm.pending_tlb()->enqueue(va, level, is_kernel_address(va), true);
+            }
+            accessed_fn(context, va);
+        }
+        cm.Finish();
+    }
+    return ZX_OK;
+}
+
+void X86PageTableBase::StartTlbBatch() {
+    canary_.Assert();
+
+    fbl::AutoLock a(&lock_);
+    DEBUG_ASSERT(tlb_batch_depth_ == 0 || tlb_batch_owner_ == get_current_thread());
+    tlb_batch_owner_ = get_current_thread();
+    tlb_batch_depth_++;
+}
+
+void X86PageTableBase::FinishTlbBatch() {
+    canary_.Assert();
+
+    list_node to_free = LIST_INITIAL_VALUE(to_free);
+    {
+        fbl::AutoLock a(&lock_);
+        DEBUG_ASSERT(tlb_batch_depth_ > 0);
+        DEBUG_ASSERT(tlb_batch_owner_ == get_current_thread());
+        if (--tlb_batch_depth_ > 0) {
+            return;
+        }
+        tlb_batch_owner_ = nullptr;
+
+        PendingTlbInvalidation tlb;
+        tlb.merge(&deferred_tlb_);
+        TlbInvalidate(&tlb);
+        tlb.clear();
+        list_move(&deferred_free_, &to_free);
+    }
+
+    // As with ConsistencyManager, free outside of the page table lock.
+    if (!list_is_empty(&to_free)) {
+        pmm_free(&to_free);
+    }
+}
+
 void X86PageTableBase::Destroy(vaddr_t base, size_t size) {
     canary_.Assert();
 
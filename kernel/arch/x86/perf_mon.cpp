@@ -176,7 +176,8 @@ static uint64_t kFixedCounterCtrlWritableBits;
 
 // While the last-branch record is far larger, it is not emitted for each
 // event.
-static constexpr size_t kMaxEventRecordSize = sizeof(cpuperf_pc_record_t);
+static constexpr size_t kMaxEventRecordSize =
+    fbl::max(sizeof(cpuperf_pc_record_t), sizeof(cpuperf_thread_pc_record_t));
 
 // Commented out values represent currently unsupported features.
 // They remain present for documentation purposes.
@@ -669,6 +670,21 @@ static cpuperf_record_header_t* x86_perfmon_write_pc_record(
     return reinterpret_cast<cpuperf_record_header_t*>(rec);
 }
 
+static cpuperf_record_header_t* x86_perfmon_write_thread_pc_record(
+        cpuperf_record_header_t* hdr,
+        cpuperf_event_id_t event, uint64_t pc) {
+    auto rec = reinterpret_cast<cpuperf_thread_pc_record_t*>(hdr);
+    x86_perfmon_write_header(&rec->header, CPUPERF_RECORD_THREAD_PC, event);
+    // The user ids are plain fields of the thread, so they can be read
+    // from the PMI handler.
+    thread_t* t = get_current_thread();
+    rec->pid = t->user_pid;
+    rec->tid = t->user_tid;
+    rec->pc = pc;
+    ++rec;
+    return reinterpret_cast<cpuperf_record_header_t*>(rec);
+}
+
 zx_status_t x86_ipm_get_properties(zx_x86_ipm_properties_t* props) {
     fbl::AutoLock al(&perfmon_lock);
 
@@ -802,6 +818,11 @@ static zx_status_t x86_ipm_verify_fixed_config(
                        " but not supported\n", i);
                 return ZX_ERR_NOT_SUPPORTED;
             }
+            if ((config->fixed_flags[i] & IPM_CONFIG_FLAG_THREAD) &&
+                    !(config->fixed_flags[i] & IPM_CONFIG_FLAG_PC)) {
+                TRACEF("Thread data requested for |fixed_flags[%u]| without pc data\n", i);
+                return ZX_ERR_INVALID_ARGS;
+            }
             if ((config->fixed_flags[i] & IPM_CONFIG_FLAG_TIMEBASE) &&
                     config->timebase_id == CPUPERF_EVENT_ID_NONE) {
                 TRACEF("Timebase requested for |fixed_flags[%u]|, but not provided\n", i);
@@ -866,6 +887,11 @@ static zx_status_t x86_ipm_verify_programmable_config(
                        " but not supported\n", i);
                 return ZX_ERR_NOT_SUPPORTED;
             }
+            if ((config->programmable_flags[i] & IPM_CONFIG_FLAG_THREAD) &&
+                    !(config->programmable_flags[i] & IPM_CONFIG_FLAG_PC)) {
+                TRACEF("Thread data requested for |programmable_flags[%u]| without pc data\n", i);
+                return ZX_ERR_INVALID_ARGS;
+            }
             if ((config->programmable_flags[i] & IPM_CONFIG_FLAG_TIMEBASE) &&
                     config->timebase_id == CPUPERF_EVENT_ID_NONE) {
                 TRACEF("Timebase requested for |programmable_flags[%u]|, but not provided\n", i);
@@ -1884,7 +1910,8 @@ static bool pmi_interrupt_handler(x86_iframe_t *frame, PerfmonState* state) {
 
     const uint64_t status = read_msr(IA32_PERF_GLOBAL_STATUS);
     uint64_t bits_to_clear = 0;
-    uint64_t cr3 = x86_get_cr3();
+    // Leave out the PCID so that this matches the aspace's table address.
+    uint64_t cr3 = x86_get_cr3() & ~X86_CR3_PCID_MASK;
 
     LTRACEF("cpu %u: status 0x%" PRIx64 "\n", cpu, status);
 
@@ -1924,7 +1951,9 @@ static bool pmi_interrupt_handler(x86_iframe_t *frame, PerfmonState* state) {
             } else if (state->programmable_flags[i] & IPM_CONFIG_FLAG_TIMEBASE) {
                 continue;
             }
-            if (state->programmable_flags[i] & IPM_CONFIG_FLAG_PC) {
+            if (state->programmable_flags[i] & IPM_CONFIG_FLAG_THREAD) {
+                next = x86_perfmon_write_thread_pc_record(next, id, frame->ip);
+            } else if (state->programmable_flags[i] & IPM_CONFIG_FLAG_PC) {
                 next = x86_perfmon_write_pc_record(next, id, cr3, frame->ip);
             } else {
                 next = x86_perfmon_write_tick_record(next, id);
@@ -1952,7 +1981,9 @@ static bool pmi_interrupt_handler(x86_iframe_t *frame, PerfmonState* state) {
             } else if (state->fixed_flags[i] & IPM_CONFIG_FLAG_TIMEBASE) {
                 continue;
             }
-            if (state->fixed_flags[i] & IPM_CONFIG_FLAG_PC) {
+            if (state->fixed_flags[i] & IPM_CONFIG_FLAG_THREAD) {
+                next = x86_perfmon_write_thread_pc_record(next, id, frame->ip);
+            } else if (state->fixed_flags[i] & IPM_CONFIG_FLAG_PC) {
                 next = x86_perfmon_write_pc_record(next, id, cr3, frame->ip);
             } else {
                 next = x86_perfmon_write_tick_record(next, id);
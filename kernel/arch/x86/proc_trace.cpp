@@ -367,6 +367,62 @@ zx_status_t x86_ipt_stop() {
     return ZX_OK;
 }
 
+// This is invoked via mp_sync_exec which thread safety analysis cannot follow.
+static void x86_ipt_snapshot_cpu_task(void* raw_context) TA_NO_THREAD_SAFETY_ANALYSIS {
+    DEBUG_ASSERT(arch_ints_disabled());
+    DEBUG_ASSERT(active && raw_context);
+
+    ipt_trace_state_t* state = reinterpret_cast<ipt_trace_state_t*>(raw_context);
+    DEBUG_ASSERT(state == &ipt_trace_state[arch_curr_cpu_num()]);
+
+    // The output MSRs are only guaranteed to be up to date, and all packets
+    // written out to memory, once TraceEn is clear. See Intel Vol 3 chapter
+    // 36.2.4. Clear it just long enough to read them, then carry on tracing
+    // with the same configuration.
+    uint64_t ctl = read_msr(IA32_RTIT_CTL);
+    write_msr(IA32_RTIT_CTL, ctl & ~IPT_CTL_TRACE_EN_MASK);
+
+    state->status = read_msr(IA32_RTIT_STATUS);
+    state->output_base = read_msr(IA32_RTIT_OUTPUT_BASE);
+    state->output_mask_ptrs = read_msr(IA32_RTIT_OUTPUT_MASK_PTRS);
+
+    write_msr(IA32_RTIT_CTL, ctl);
+}
+
+// Fetch the current trace data of one cpu without stopping the trace.
+// Used to read out the latest window of a circular buffer on demand.
+
+zx_status_t x86_ipt_snapshot_trace_data(zx_itrace_buffer_descriptor_t descriptor,
+                                        zx_x86_pt_regs_t* regs) {
+    AutoLock al(&ipt_lock);
+
+    if (!supports_pt)
+        return ZX_ERR_NOT_SUPPORTED;
+    if (trace_mode != IPT_TRACE_CPUS || !active)
+        return ZX_ERR_BAD_STATE;
+    if (!ipt_trace_state)
+        return ZX_ERR_BAD_STATE;
+    if (descriptor >= ipt_num_traces)
+        return ZX_ERR_INVALID_ARGS;
+
+    cpu_num_t cpu = descriptor;
+    if (!mp_is_cpu_online(cpu))
+        return ZX_ERR_BAD_STATE;
+
+    ipt_trace_state_t* state = &ipt_trace_state[descriptor];
+    mp_sync_exec(MP_IPI_TARGET_MASK, cpu_num_to_mask(cpu), x86_ipt_snapshot_cpu_task, state);
+
+    regs->ctl = state->ctl;
+    regs->status = state->status;
+    regs->output_base = state->output_base;
+    regs->output_mask_ptrs = state->output_mask_ptrs;
+    regs->cr3_match = state->cr3_match;
+    static_assert(sizeof(regs->addr_ranges) == sizeof(state->addr_ranges), "addr_ranges size mismatch");
+    memcpy(regs->addr_ranges, state->addr_ranges, sizeof(regs->addr_ranges));
+
+    return ZX_OK;
+}
+
 zx_status_t x86_ipt_stage_trace_data(zx_itrace_buffer_descriptor_t descriptor,
                                      const zx_x86_pt_regs_t* regs) {
     AutoLock al(&ipt_lock);
@@ -13,6 +13,7 @@
 #include <arch/x86/apic.h>
 #include <arch/x86/bootstrap16.h>
 #include <arch/x86/descriptor.h>
+#include <arch/x86/feature.h>
 #include <arch/x86/mmu_mem_types.h>
 #include <arch/x86/mp.h>
 #include <err.h>
@@ -41,6 +42,24 @@ static void free_stack_and_thread(thread_t* t) {
     }
 }
 
+// Whether the APs need the delays that the MP specification asks for in the
+// INIT-SIPI-SIPI sequence. Like other kernels, we assume that the cpus of
+// modern Intel and AMD processors, and virtual cpus, leave INIT right away.
+static bool x86_ap_startup_delays_needed() {
+    if (x86_feature_test(X86_FEATURE_HYPERVISOR)) {
+        return false;
+    }
+    const x86_model_info* model = x86_get_model();
+    switch (x86_vendor) {
+    case X86_VENDOR_INTEL:
+        return model->display_family < 6;
+    case X86_VENDOR_AMD:
+        return model->display_family < 0xf;
+    default:
+        return true;
+    }
+}
+
 zx_status_t x86_bringup_aps(uint32_t* apic_ids, uint32_t count) {
     volatile int aps_still_booting = 0;
     zx_status_t status = ZX_ERR_INTERNAL;
@@ -103,8 +122,11 @@ zx_status_t x86_bringup_aps(uint32_t* apic_ids, uint32_t count) {
     }
     dprintf(INFO, "\n");
 
-    // Wait 10 ms and then send the startup signals
-    thread_sleep_relative(ZX_MSEC(10));
+    // Older cpus need 10 ms after INIT before the startup signals
+    bool delays_needed = x86_ap_startup_delays_needed();
+    if (delays_needed) {
+        thread_sleep_relative(ZX_MSEC(10));
+    }
 
     // Actually send the startups
     DEBUG_ASSERT(bootstrap_instr_ptr < 1 * MB && IS_PAGE_ALIGNED(bootstrap_instr_ptr));
@@ -123,18 +145,19 @@ zx_status_t x86_bringup_aps(uint32_t* apic_ids, uint32_t count) {
         if (aps_still_booting == 0) {
             break;
         }
-        // Wait 1ms for cores to boot.  The docs recommend 200us between STARTUP
-        // IPIs.
-        thread_sleep_relative(ZX_MSEC(1));
+        // Wait for cores to boot.  The docs recommend 200us between STARTUP
+        // IPIs; older cpus get 1ms.
+        thread_sleep_relative(delays_needed ? ZX_MSEC(1) : ZX_USEC(200));
     }
 
     // The docs recommend waiting 200us for cores to boot.  We do a bit more
-    // work before the cores report in, so wait longer (up to 1 second).
-    for (int tries_left = 200;
+    // work before the cores report in, so wait longer (up to 1 second),
+    // checking often so that we move on as soon as they are all up.
+    for (int tries_left = 10000;
          aps_still_booting != 0 && tries_left > 0;
          --tries_left) {
 
-        thread_sleep_relative(ZX_MSEC(5));
+        thread_sleep_relative(ZX_USEC(100));
     }
 
     uint failed_aps;
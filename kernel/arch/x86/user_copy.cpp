@@ -46,6 +46,19 @@ void fill_out_clac_instruction(const CodePatchInfo* patch) {
         memset(patch->dest_addr, kNopInstruction, kSize);
     }
 }
+
+// The default at the patch site is a jmp rel8 that skips the "rep movsq"
+// block and copies everything with "rep movsb".  That is only fast with
+// ERMS, so on other CPUs we replace the jmp with a two-byte nop.
+void x86_user_copy_select(const CodePatchInfo* patch) {
+    const size_t kSize = 2;
+    DEBUG_ASSERT(patch->dest_size == kSize);
+    DEBUG_ASSERT(patch->dest_addr[0] == 0xeb); /* jmp rel8 */
+    if (!x86_feature_test(X86_FEATURE_ERMS)) {
+        patch->dest_addr[0] = 0x66; /* operand-size prefix */
+        patch->dest_addr[1] = kNopInstruction;
+    }
+}
 }
 
 static inline bool ac_flag(void) {
@@ -59,6 +59,11 @@ bool is_valid_interrupt(unsigned int vector, uint32_t flags);
 
 unsigned int remap_interrupt(unsigned int vector);
 
+// Deliver the interrupt |vector| to |cpu| from now on. Interrupts are
+// delivered to the boot cpu until this is called.  Returns
+// ZX_ERR_NOT_SUPPORTED if the platform cannot steer |vector|.
+zx_status_t set_interrupt_affinity(unsigned int vector, cpu_num_t cpu);
+
 // sends an inter-processor interrupt
 zx_status_t interrupt_send_ipi(cpu_mask_t target, mp_ipi_t ipi);
 
@@ -121,4 +126,14 @@ void msi_free_block(msi_block_t* block);
 // NULL handler will effectively unregister a handler for a given msi_id within the
 // block.
 void msi_register_handler(const msi_block_t* block, uint msi_id, int_handler handler, void *ctx);
+
+// Method used to steer all of the IRQs of an allocated block to a single CPU.
+// On success, the block's tgt_addr and tgt_data hold the values the device
+// has to be reprogrammed with.
+//
+// @param block A pointer to the block to retarget
+// @param cpu The CPU the block's IRQs should be delivered to.
+//
+// @return ZX_ERR_NOT_SUPPORTED if the platform cannot target |cpu|.
+zx_status_t msi_set_affinity(msi_block_t* block, cpu_num_t cpu);
 __END_CDECLS
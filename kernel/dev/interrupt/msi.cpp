@@ -5,8 +5,8 @@
 // https://opensource.org/licenses/MIT
 
 // Methods in this file exist to provide default stubs for MSI
-// support so that individual platforms do not need to provide
-// them if they only partially support MSI.
+// support and interrupt steering so that individual platforms do
+// not need to provide them if they only partially support MSI.
 
 #include <dev/interrupt.h>
 
@@ -44,3 +44,11 @@ __WEAK void msi_register_handler(const msi_block_t* block,
                                  void *ctx) {
     PANIC_UNIMPLEMENTED;
 }
+
+__WEAK zx_status_t msi_set_affinity(msi_block_t* block, cpu_num_t cpu) {
+    return ZX_ERR_NOT_SUPPORTED;
+}
+
+__WEAK zx_status_t set_interrupt_affinity(unsigned int vector, cpu_num_t cpu) {
+    return ZX_ERR_NOT_SUPPORTED;
+}
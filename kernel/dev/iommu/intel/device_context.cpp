@@ -224,7 +224,7 @@ zx_status_t DeviceContext::SecondLevelMapDiscontiguous(const fbl::RefPtr<VmObjec
     };
 
     fbl::unique_ptr<const RegionAllocator::Region> region;
-    zx_status_t status = region_alloc_.GetRegion(size, min_contig, region);
+    zx_status_t status = region_alloc_.GetRegion(size, MapAlignment(0, size), region);
     if (status != ZX_OK) {
         return status;
     }
@@ -240,13 +240,42 @@ zx_status_t DeviceContext::SecondLevelMapDiscontiguous(const fbl::RefPtr<VmObjec
     paddr_t base = region->base;
     size_t remaining = size;
 
+    // Any invalidations needed along the way are issued once at the end.
+    second_level_pt_.StartTlbBatch();
+    auto finish_batch = fbl::MakeAutoCall([&]() {
+        second_level_pt_.FinishTlbBatch();
+    });
+
+    // Physically contiguous runs of pages are mapped with a single walk of the
+    // page tables, which also lets them use large pages.  The run currently
+    // being accumulated starts at |run_vaddr| and may span lookups, so
+    // everything below |run_vaddr| has been mapped.
+    paddr_t run_vaddr = base;
+    paddr_t run_paddr = 0;
+    size_t run_pages = 0;
     auto cleanup_partial = fbl::MakeAutoCall([&]() {
-        size_t allocated = base - region->base;
+        size_t allocated = run_vaddr - region->base;
         size_t unmapped;
-        second_level_pt_.UnmapPages(base, allocated / PAGE_SIZE, &unmapped);
+        second_level_pt_.UnmapPages(region->base, allocated / PAGE_SIZE, &unmapped);
         DEBUG_ASSERT(unmapped == allocated / PAGE_SIZE);
     });
 
+    auto map_run = [&]() -> zx_status_t {
+        if (run_pages == 0) {
+            return ZX_OK;
+        }
+        size_t mapped;
+        zx_status_t status = second_level_pt_.MapPagesContiguous(run_vaddr, run_paddr, run_pages,
+                                                                 flags, &mapped);
+        if (status != ZX_OK) {
+            return status;
+        }
+        ASSERT(mapped == run_pages);
+        run_vaddr += run_pages * PAGE_SIZE;
+        run_pages = 0;
+        return ZX_OK;
+    };
+
     while (remaining > 0) {
         const size_t kNumEntriesPerLookup = 32;
         size_t chunk_size = fbl::min(remaining, kNumEntriesPerLookup * PAGE_SIZE);
@@ -256,18 +285,27 @@ zx_status_t DeviceContext::SecondLevelMapDiscontiguous(const fbl::RefPtr<VmObjec
             return status;
         }
 
-        size_t map_len = chunk_size / PAGE_SIZE;
-        size_t mapped;
-        status = second_level_pt_.MapPages(base, paddrs, map_len, flags, &mapped);
-        if (status != ZX_OK) {
-            return status;
+        for (size_t i = 0; i < chunk_size / PAGE_SIZE; ++i) {
+            if (run_pages > 0 && paddrs[i] == run_paddr + run_pages * PAGE_SIZE) {
+                run_pages++;
+                continue;
+            }
+            status = map_run();
+            if (status != ZX_OK) {
+                return status;
+            }
+            run_paddr = paddrs[i];
+            run_pages = 1;
         }
-        ASSERT(mapped == map_len);
 
         base += chunk_size;
         offset += chunk_size;
         remaining -= chunk_size;
     }
+    status = map_run();
+    if (status != ZX_OK) {
+        return status;
+    }
 
     cleanup_partial.cancel();
 
@@ -306,8 +344,7 @@ zx_status_t DeviceContext::SecondLevelMapContiguous(const fbl::RefPtr<VmObject>&
     DEBUG_ASSERT(paddr != UINT64_MAX);
 
     fbl::unique_ptr<const RegionAllocator::Region> region;
-    uint64_t min_contig = minimum_contiguity();
-    status = region_alloc_.GetRegion(size, min_contig, region);
+    status = region_alloc_.GetRegion(size, MapAlignment(paddr, size), region);
     if (status != ZX_OK) {
         return status;
     }
@@ -393,6 +430,8 @@ zx_status_t DeviceContext::SecondLevelUnmap(paddr_t virt_paddr, size_t size) {
         }
     }
 
+    // Unmapping several regions only needs one round of invalidations.
+    second_level_pt_.StartTlbBatch();
     for (size_t i = 0; i < allocated_regions_.size(); ++i) {
         const auto& region = allocated_regions_[i];
         if (region->base < virt_paddr || region->base + region->size > virt_paddr + size) {
@@ -409,10 +448,26 @@ zx_status_t DeviceContext::SecondLevelUnmap(paddr_t virt_paddr, size_t size) {
         allocated_regions_.erase(i);
         i--;
     }
+    second_level_pt_.FinishTlbBatch();
 
     return ZX_OK;
 }
 
+uint64_t DeviceContext::MapAlignment(paddr_t paddr, size_t size) {
+    const uint64_t k2MB = 1ull << 21;
+    const uint64_t k1GB = 1ull << 30;
+
+    if (size >= k1GB && IS_ALIGNED(paddr, k1GB) &&
+        parent_->caps()->supports_second_level_1gb_page()) {
+        return k1GB;
+    }
+    if (size >= k2MB && IS_ALIGNED(paddr, k2MB) &&
+        parent_->caps()->supports_second_level_2mb_page()) {
+        return fbl::max(k2MB, minimum_contiguity());
+    }
+    return minimum_contiguity();
+}
+
 uint64_t DeviceContext::minimum_contiguity() const {
     // TODO(teisenbe): Do not hardcode this.
     return 1ull << 20;
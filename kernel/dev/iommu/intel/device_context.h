@@ -88,6 +88,12 @@ private:
                                          uint64_t offset, size_t size, uint flags,
                                          paddr_t* virt_paddr, size_t* mapped_len);
 
+    // Returns the alignment to request from |region_alloc_| for a mapping of
+    // |size| bytes starting at the physical address |paddr|, so that the
+    // second-level tables can use large pages where the layout allows.  Pass a
+    // |paddr| of 0 if the pages are not known to be contiguous.
+    uint64_t MapAlignment(paddr_t paddr, size_t size);
+
     IommuImpl* const parent_;
     union {
         volatile ds::ExtendedContextEntry* const extended_context_entry_;
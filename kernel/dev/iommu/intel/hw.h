@@ -274,6 +274,44 @@ public:
     DEF_BIT(63, fault);
 };
 
+class InvalidationQueueHead : public hwreg::RegisterBase<InvalidationQueueHead, uint64_t> {
+public:
+    static constexpr uint32_t kAddr = 0x80;
+    static auto Get() { return hwreg::RegisterAddr<InvalidationQueueHead>(kAddr); }
+
+    DEF_RSVDZ_FIELD(3, 0);
+    DEF_FIELD(18, 4, queue_head);
+};
+
+class InvalidationQueueTail : public hwreg::RegisterBase<InvalidationQueueTail, uint64_t> {
+public:
+    static constexpr uint32_t kAddr = 0x88;
+    static auto Get() { return hwreg::RegisterAddr<InvalidationQueueTail>(kAddr); }
+
+    DEF_RSVDZ_FIELD(3, 0);
+    DEF_FIELD(18, 4, queue_tail);
+};
+
+class InvalidationQueueAddress : public hwreg::RegisterBase<InvalidationQueueAddress, uint64_t> {
+public:
+    static constexpr uint32_t kAddr = 0x90;
+    static auto Get() { return hwreg::RegisterAddr<InvalidationQueueAddress>(kAddr); }
+
+    // The queue is 2^queue_size pages long.
+    DEF_FIELD(2, 0, queue_size);
+    DEF_RSVDZ_FIELD(11, 3);
+    DEF_FIELD(63, 12, queue_base);
+};
+
+class InvalidationCompletionStatus :
+        public hwreg::RegisterBase<InvalidationCompletionStatus, uint32_t> {
+public:
+    static constexpr uint32_t kAddr = 0x9c;
+    static auto Get() { return hwreg::RegisterAddr<InvalidationCompletionStatus>(kAddr); }
+
+    DEF_BIT(0, wait_descriptor_complete);
+};
+
 } // namespace reg
 
 namespace ds {
@@ -494,6 +532,67 @@ struct PasidState {
 static_assert(fbl::is_pod<PasidState>::value, "not POD");
 static_assert(sizeof(PasidState) == 8, "wrong size");
 
+// Descriptors submitted through the invalidation queue.  All of them share
+// the placement of the type field.
+struct InvalidationDescriptor {
+    uint64_t raw[2];
+
+    DEF_SUBFIELD(raw[0], 3, 0, type);
+
+    enum Type {
+        kContextCacheInvld = 0x1,
+        kIotlbInvld = 0x2,
+        kInvldWait = 0x5,
+    };
+};
+static_assert(fbl::is_pod<InvalidationDescriptor>::value, "not POD");
+static_assert(sizeof(InvalidationDescriptor) == 16, "wrong size");
+
+struct ContextCacheInvldDescriptor : public InvalidationDescriptor {
+    DEF_SUBFIELD(raw[0], 5, 4, granularity);
+    DEF_SUBFIELD(raw[0], 31, 16, domain_id);
+    DEF_SUBFIELD(raw[0], 47, 32, source_id);
+    DEF_SUBFIELD(raw[0], 49, 48, function_mask);
+
+    // Same encoding as reg::ContextCommand::Granularity
+    enum Granularity {
+        kGlobalInvld = 0b01,
+        kDomainInvld = 0b10,
+        kDeviceInvld = 0b11,
+    };
+};
+static_assert(sizeof(ContextCacheInvldDescriptor) == 16, "wrong size");
+
+struct IotlbInvldDescriptor : public InvalidationDescriptor {
+    DEF_SUBFIELD(raw[0], 5, 4, granularity);
+    DEF_SUBBIT(raw[0], 6, drain_writes);
+    DEF_SUBBIT(raw[0], 7, drain_reads);
+    DEF_SUBFIELD(raw[0], 31, 16, domain_id);
+
+    DEF_SUBFIELD(raw[1], 5, 0, address_mask);
+    DEF_SUBBIT(raw[1], 6, invld_hint);
+    DEF_SUBFIELD(raw[1], 63, 12, address);
+
+    // Same encoding as reg::IotlbInvalidate::Granularity
+    enum Granularity {
+        kGlobalInvld = 0b01,
+        kDomainAllInvld = 0b10,
+        kDomainPageInvld = 0b11,
+    };
+};
+static_assert(sizeof(IotlbInvldDescriptor) == 16, "wrong size");
+
+struct InvldWaitDescriptor : public InvalidationDescriptor {
+    DEF_SUBBIT(raw[0], 4, interrupt_flag);
+    DEF_SUBBIT(raw[0], 5, status_write);
+    DEF_SUBBIT(raw[0], 6, fence);
+    DEF_SUBFIELD(raw[0], 63, 32, status_data);
+
+    // Physical address of the 32-bit word |status_data| is written to.
+    DEF_SUBFIELD(raw[1], 63, 2, status_address);
+};
+static_assert(sizeof(InvldWaitDescriptor) == 16, "wrong size");
+
 } // namespace ds
 
 } // namespace intel_iommu
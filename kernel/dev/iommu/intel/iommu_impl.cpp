@@ -87,6 +87,7 @@ IommuImpl::~IommuImpl() {
     ASSERT(status == ZX_OK);
 
     DisableFaultsLocked();
+    DisableQueuedInvalidationLocked();
     msi_free_block(&irq_block_);
 
     VmAspace::kernel_aspace()->FreeRegion(mmio_.base());
@@ -393,6 +394,17 @@ zx_status_t IommuImpl::Initialize() {
         return status;
     }
 
+    // Switch to queued invalidation where available, so that invalidations
+    // can be batched behind a single wait instead of each being a
+    // synchronous register round trip.
+    if (extended_caps_.supports_queued_invld()) {
+        status = EnableQueuedInvalidationLocked();
+        if (status != ZX_OK) {
+            LTRACEF("enable queued invalidation failed\n");
+            return status;
+        }
+    }
+
     // Enable interrupts before we enable translation
     status = ConfigureFaultEventInterruptLocked();
     if (status != ZX_OK) {
@@ -500,6 +512,15 @@ zx_status_t IommuImpl::SetTranslationEnableLocked(bool enabled, zx_time_t deadli
 void IommuImpl::InvalidateContextCacheGlobalLocked() {
     DEBUG_ASSERT(lock_.IsHeld());
 
+    if (queued_invld_enabled_) {
+        ds::ContextCacheInvldDescriptor desc = {};
+        desc.set_type(ds::InvalidationDescriptor::kContextCacheInvld);
+        desc.set_granularity(ds::ContextCacheInvldDescriptor::kGlobalInvld);
+        SubmitInvalidationLocked(desc);
+        WaitForInvalidationsLocked();
+        return;
+    }
+
     auto context_cmd = reg::ContextCommand::Get().FromValue(0);
     context_cmd.set_invld_context_cache(1);
     context_cmd.set_invld_request_granularity(reg::ContextCommand::kGlobalInvld);
@@ -512,6 +533,16 @@ void IommuImpl::InvalidateContextCacheGlobalLocked() {
 void IommuImpl::InvalidateContextCacheDomainLocked(uint32_t domain_id) {
     DEBUG_ASSERT(lock_.IsHeld());
 
+    if (queued_invld_enabled_) {
+        ds::ContextCacheInvldDescriptor desc = {};
+        desc.set_type(ds::InvalidationDescriptor::kContextCacheInvld);
+        desc.set_granularity(ds::ContextCacheInvldDescriptor::kDomainInvld);
+        desc.set_domain_id(domain_id);
+        SubmitInvalidationLocked(desc);
+        WaitForInvalidationsLocked();
+        return;
+    }
+
     auto context_cmd = reg::ContextCommand::Get().FromValue(0);
     context_cmd.set_invld_context_cache(1);
     context_cmd.set_invld_request_granularity(reg::ContextCommand::kDomainInvld);
@@ -536,6 +567,12 @@ void IommuImpl::InvalidateIotlbGlobalLocked() {
     DEBUG_ASSERT(lock_.IsHeld());
     ASSERT(!caps_.required_write_buf_flushing());
 
+    if (queued_invld_enabled_) {
+        SubmitIotlbInvalidationLocked(ds::IotlbInvldDescriptor::kGlobalInvld, 0, 0, 0);
+        WaitForInvalidationsLocked();
+        return;
+    }
+
     // TODO(teisenbe): Read/write draining?
     auto iotlb_invld = reg::IotlbInvalidate::Get(iotlb_reg_offset_).ReadFrom(&mmio_);
     iotlb_invld.set_invld_iotlb(1);
@@ -550,6 +587,12 @@ void IommuImpl::InvalidateIotlbDomainAllLocked(uint32_t domain_id) {
     DEBUG_ASSERT(lock_.IsHeld());
     ASSERT(!caps_.required_write_buf_flushing());
 
+    if (queued_invld_enabled_) {
+        SubmitIotlbInvalidationLocked(ds::IotlbInvldDescriptor::kDomainAllInvld, domain_id, 0, 0);
+        WaitForInvalidationsLocked();
+        return;
+    }
+
     // TODO(teisenbe): Read/write draining?
     auto iotlb_invld = reg::IotlbInvalidate::Get(iotlb_reg_offset_).ReadFrom(&mmio_);
     iotlb_invld.set_invld_iotlb(1);
@@ -562,12 +605,24 @@ void IommuImpl::InvalidateIotlbDomainAllLocked(uint32_t domain_id) {
 }
 
 void IommuImpl::InvalidateIotlbPageLocked(uint32_t domain_id, dev_vaddr_t vaddr, uint pages_pow2) {
+    QueueIotlbPageInvalidationLocked(domain_id, vaddr, pages_pow2);
+    WaitForInvalidationsLocked();
+}
+
+void IommuImpl::QueueIotlbPageInvalidationLocked(uint32_t domain_id, dev_vaddr_t vaddr,
+                                                 uint pages_pow2) {
     DEBUG_ASSERT(lock_.IsHeld());
     DEBUG_ASSERT(IS_PAGE_ALIGNED(vaddr));
     DEBUG_ASSERT(pages_pow2 < 64);
     DEBUG_ASSERT(pages_pow2 <= caps_.max_addr_mask_value());
     ASSERT(!caps_.required_write_buf_flushing());
 
+    if (queued_invld_enabled_) {
+        SubmitIotlbInvalidationLocked(ds::IotlbInvldDescriptor::kDomainPageInvld, domain_id,
+                                      vaddr, pages_pow2);
+        return;
+    }
+
     auto invld_addr = reg::InvalidateAddress::Get(iotlb_reg_offset_).FromValue(0);
     invld_addr.set_address(vaddr >> 12);
     invld_addr.set_invld_hint(0);
@@ -585,6 +640,152 @@ void IommuImpl::InvalidateIotlbPageLocked(uint32_t domain_id, dev_vaddr_t vaddr,
                        ZX_TIME_INFINITE);
 }
 
+void IommuImpl::SubmitIotlbInvalidationLocked(uint32_t granularity, uint32_t domain_id,
+                                              dev_vaddr_t vaddr, uint pages_pow2) {
+    ds::IotlbInvldDescriptor desc = {};
+    desc.set_type(ds::InvalidationDescriptor::kIotlbInvld);
+    desc.set_granularity(granularity);
+    desc.set_domain_id(domain_id);
+    // Drain DMA still using the old translations where the hardware can, so
+    // none is in flight once the wait for this descriptor completes.
+    desc.set_drain_writes(caps_.supports_write_draining());
+    desc.set_drain_reads(caps_.supports_read_draining());
+    desc.set_address(vaddr >> 12);
+    desc.set_invld_hint(0);
+    desc.set_address_mask(pages_pow2);
+    SubmitInvalidationLocked(desc);
+}
+
+// Sets up the invalidation queue and switches the unit over to it.  Once it
+// is enabled, the register-based invalidation interface must not be used.
+zx_status_t IommuImpl::EnableQueuedInvalidationLocked() {
+    DEBUG_ASSERT(!queued_invld_enabled_);
+
+    zx_status_t status = IommuPage::AllocatePage(&invld_queue_page_);
+    if (status != ZX_OK) {
+        return status;
+    }
+    status = IommuPage::AllocatePage(&invld_status_page_);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    // The queue must be empty (head == tail == 0) when it is enabled.
+    invld_queue_tail_ = 0;
+    invld_queue_pending_ = 0;
+    reg::InvalidationQueueTail::Get().FromValue(0).WriteTo(&mmio_);
+
+    auto queue_addr = reg::InvalidationQueueAddress::Get().FromValue(0);
+    queue_addr.set_queue_base(invld_queue_page_.paddr() >> PAGE_SIZE_SHIFT);
+    queue_addr.set_queue_size(0); // One page
+    queue_addr.WriteTo(&mmio_);
+
+    auto global_ctl = reg::GlobalControl::Get().ReadFrom(&mmio_);
+    // Don't re-trigger the one-shot commands that read back as set.
+    global_ctl.set_root_table_ptr(0);
+    global_ctl.set_write_buffer_flush(0);
+    global_ctl.set_interrupt_remap_table_ptr(0);
+    global_ctl.set_queued_invld_enable(1);
+    global_ctl.WriteTo(&mmio_);
+    status = WaitForValueLocked(&global_ctl, &decltype(global_ctl)::queued_invld_enable,
+                                1, zx_time_add_duration(current_time(), ZX_SEC(1)));
+    if (status != ZX_OK) {
+        LTRACEF("Timed out waiting for queued_invld_enable bit to take\n");
+        return status;
+    }
+
+    queued_invld_enabled_ = true;
+    return ZX_OK;
+}
+
+void IommuImpl::DisableQueuedInvalidationLocked() {
+    if (!queued_invld_enabled_) {
+        return;
+    }
+    // Hardware must have finished with the queue before it can be disabled.
+    WaitForInvalidationsLocked();
+
+    auto global_ctl = reg::GlobalControl::Get().ReadFrom(&mmio_);
+    global_ctl.set_root_table_ptr(0);
+    global_ctl.set_write_buffer_flush(0);
+    global_ctl.set_interrupt_remap_table_ptr(0);
+    global_ctl.set_queued_invld_enable(0);
+    global_ctl.WriteTo(&mmio_);
+    zx_status_t status = WaitForValueLocked(&global_ctl,
+                                            &decltype(global_ctl)::queued_invld_enable,
+                                            0, ZX_TIME_INFINITE);
+    ASSERT(status == ZX_OK);
+    queued_invld_enabled_ = false;
+}
+
+void IommuImpl::SubmitInvalidationLocked(const ds::InvalidationDescriptor& desc) {
+    DEBUG_ASSERT(lock_.IsHeld());
+    DEBUG_ASSERT(queued_invld_enabled_);
+
+    // Keep a slot free for the wait descriptor that drains the queue, so the
+    // tail can never catch up with the head.
+    if (invld_queue_pending_ >= kInvldQueueEntries - 2) {
+        WaitForInvalidationsLocked();
+    }
+    WriteInvalidationLocked(desc);
+}
+
+void IommuImpl::WriteInvalidationLocked(const ds::InvalidationDescriptor& desc) {
+    DEBUG_ASSERT(invld_queue_pending_ < kInvldQueueEntries - 1);
+
+    auto queue = reinterpret_cast<volatile ds::InvalidationDescriptor*>(
+            invld_queue_page_.vaddr());
+    volatile ds::InvalidationDescriptor* slot = &queue[invld_queue_tail_];
+    slot->raw[0] = desc.raw[0];
+    slot->raw[1] = desc.raw[1];
+    // Hardware access to the queue may not be coherent, so flush just in case.
+    arch_clean_cache_range(reinterpret_cast<addr_t>(slot), sizeof(*slot));
+
+    invld_queue_tail_ = (invld_queue_tail_ + 1) % kInvldQueueEntries;
+    invld_queue_pending_++;
+
+    // Make the descriptor visible before the hardware is told about it.
+    mb();
+    auto tail = reg::InvalidationQueueTail::Get().FromValue(0);
+    tail.set_queue_tail(invld_queue_tail_);
+    tail.WriteTo(&mmio_);
+}
+
+void IommuImpl::WaitForInvalidationsLocked() {
+    DEBUG_ASSERT(lock_.IsHeld());
+
+    if (!queued_invld_enabled_ || invld_queue_pending_ == 0) {
+        return;
+    }
+
+    const uint32_t seq = ++invld_wait_seq_;
+    ds::InvldWaitDescriptor desc = {};
+    desc.set_type(ds::InvalidationDescriptor::kInvldWait);
+    desc.set_status_write(1);
+    // Don't let later descriptors start until everything before this one has
+    // completed.
+    desc.set_fence(1);
+    desc.set_status_data(seq);
+    desc.set_status_address(invld_status_page_.paddr() >> 2);
+    // Goes into the slot SubmitInvalidationLocked() keeps free, rather than
+    // through it, since a full queue would wait on itself.
+    WriteInvalidationLocked(desc);
+
+    auto status_word = reinterpret_cast<volatile uint32_t*>(invld_status_page_.vaddr());
+    while (*status_word != seq) {
+        // An invalidation queue error stops the hardware from fetching any
+        // further descriptors, and only happens if we wrote a bad one.
+        auto fault_status = reg::FaultStatus::Get().ReadFrom(&mmio_);
+        if (fault_status.invld_queue_error()) {
+            auto head = reg::InvalidationQueueHead::Get().ReadFrom(&mmio_);
+            panic("iommu: invalidation queue error at descriptor %#lx\n",
+                  head.queue_head());
+        }
+        arch_spinloop_pause();
+    }
+    invld_queue_pending_ = 0;
+}
+
 void IommuImpl::InvalidateIotlbGlobal() {
     fbl::AutoLock guard(&lock_);
     InvalidateIotlbGlobalLocked();
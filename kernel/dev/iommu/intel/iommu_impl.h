@@ -70,6 +70,18 @@ public:
     void InvalidateIotlbPageLocked(uint32_t domain_id, dev_vaddr_t vaddr,
                                    uint pages_pow2) TA_REQ(lock_);
 
+    // Batched variant of InvalidateIotlbPageLocked().  With queued
+    // invalidation this only appends a descriptor to the queue, and
+    // WaitForInvalidationsLocked() waits for everything queued so far.
+    // Without it, each call completes synchronously and the wait is a no-op.
+    void QueueIotlbPageInvalidationLocked(uint32_t domain_id, dev_vaddr_t vaddr,
+                                          uint pages_pow2) TA_REQ(lock_);
+    void WaitForInvalidationsLocked() TA_REQ(lock_);
+
+    // Whether invalidations are issued through the invalidation queue.  Fixed
+    // before translation is enabled.
+    bool queued_invld_enabled() const { return queued_invld_enabled_; }
+
 private:
     DISALLOW_COPY_ASSIGN_AND_MOVE(IommuImpl);
     IommuImpl(volatile void* register_base, fbl::unique_ptr<const uint8_t[]> desc,
@@ -96,6 +108,15 @@ private:
     // IOTLB invalidation
     void InvalidateIotlbGlobalLocked() TA_REQ(lock_);
 
+    // Queued invalidation interface
+    zx_status_t EnableQueuedInvalidationLocked() TA_REQ(lock_);
+    void DisableQueuedInvalidationLocked() TA_REQ(lock_);
+    void SubmitInvalidationLocked(const ds::InvalidationDescriptor& desc) TA_REQ(lock_);
+    // Appends |desc| to the queue without checking for room.
+    void WriteInvalidationLocked(const ds::InvalidationDescriptor& desc) TA_REQ(lock_);
+    void SubmitIotlbInvalidationLocked(uint32_t granularity, uint32_t domain_id,
+                                       dev_vaddr_t vaddr, uint pages_pow2) TA_REQ(lock_);
+
     zx_status_t SetRootTablePointerLocked(paddr_t pa) TA_REQ(lock_);
     zx_status_t SetTranslationEnableLocked(bool enabled, zx_time_t deadline) TA_REQ(lock_);
     zx_status_t ConfigureFaultEventInterruptLocked() TA_REQ(lock_);
@@ -140,6 +161,18 @@ private:
 
     DomainAllocator domain_allocator_ TA_GUARDED(lock_);
 
+    // Invalidation queue, and the word its wait descriptors write
+    // |invld_wait_seq_| to when everything before them has completed.
+    static constexpr uint32_t kInvldQueueEntries =
+            PAGE_SIZE / sizeof(ds::InvalidationDescriptor);
+    IommuPage invld_queue_page_ TA_GUARDED(lock_);
+    IommuPage invld_status_page_ TA_GUARDED(lock_);
+    uint32_t invld_queue_tail_ TA_GUARDED(lock_) = 0;
+    // Descriptors submitted since the last completed wait
+    uint32_t invld_queue_pending_ TA_GUARDED(lock_) = 0;
+    uint32_t invld_wait_seq_ TA_GUARDED(lock_) = 0;
+    bool queued_invld_enabled_ = false;
+
     // A mask with bits set for each usable bit in an address with the largest allowed
     // address width.  E.g., if the largest allowed width is 48-bit,
     // max_guest_addr_mask will be 0xffff_ffff_ffff.
@@ -7,6 +7,7 @@
 #include "second_level_pt.h"
 
 #include <arch/x86/mmu.h>
+#include <fbl/algorithm.h>
 
 #include "device_context.h"
 #include "iommu_impl.h"
@@ -136,27 +137,73 @@ void SecondLevelPageTable::TlbInvalidate(PendingTlbInvalidation* pending)
 
     DEBUG_ASSERT(!pending->contains_global);
 
+    const uint32_t domain_id = parent_->domain_id();
+    // No invalidation needs to cover more than the 48-bit address space.
+    const uint max_mask = fbl::min(static_cast<uint>(iommu_->caps()->max_addr_mask_value()),
+                                   48u - PAGE_SIZE_SHIFT);
+
     if (pending->full_shootdown) {
-        iommu_->InvalidateIotlbDomainAllLocked(parent_->domain_id());
+        iommu_->InvalidateIotlbDomainAllLocked(domain_id);
         pending->clear();
         return;
     }
 
     constexpr uint kBitsPerLevel = 9;
-    for (uint i = 0; i < pending->count; ++i) {
-        const auto& item = pending->item[i];
-        uint address_mask = kBitsPerLevel * static_cast<uint>(item.page_level());
-
+    auto item_mask = [](const PendingTlbInvalidation::Item& item) -> uint {
         if (!item.is_terminal()) {
             // If this is non-terminal, force the paging-structure cache to be
             // cleared for this address still, even though a terminal mapping hasn't
             // been changed.
             // TODO(teisenbe): Not completely sure this is necessary.  Including for
             // now out of caution.
-            address_mask = 0;
+            return 0;
+        }
+        return kBitsPerLevel * static_cast<uint>(item.page_level());
+    };
+
+    if (!iommu_->queued_invld_enabled() && pending->count > 1) {
+        // Each register-based invalidation is a synchronous round trip to the
+        // hardware, so cover the whole batch with a single page-selective
+        // invalidation of the smallest aligned block containing it.
+        vaddr_t start = UINT64_MAX;
+        vaddr_t end = 0;
+        for (uint i = 0; i < pending->count; ++i) {
+            const auto& item = pending->item[i];
+            const vaddr_t size = PAGE_SIZE << item_mask(item);
+            start = fbl::min(start, item.addr());
+            end = fbl::max(end, item.addr() + size);
+        }
+        uint mask = 0;
+        while (mask <= max_mask) {
+            const vaddr_t block_size = PAGE_SIZE << mask;
+            if (ROUNDDOWN(start, block_size) + block_size >= end) {
+                break;
+            }
+            mask++;
+        }
+        if (mask <= max_mask) {
+            const vaddr_t block_base = ROUNDDOWN(start, PAGE_SIZE << mask);
+            iommu_->InvalidateIotlbPageLocked(domain_id, block_base, mask);
+        } else {
+            iommu_->InvalidateIotlbDomainAllLocked(domain_id);
+        }
+        pending->clear();
+        return;
+    }
+
+    for (uint i = 0; i < pending->count; ++i) {
+        const auto& item = pending->item[i];
+        const uint address_mask = item_mask(item);
+        if (address_mask > max_mask) {
+            // Large pages may be bigger than the hardware can invalidate
+            // selectively.
+            iommu_->InvalidateIotlbDomainAllLocked(domain_id);
+            pending->clear();
+            return;
         }
-        iommu_->InvalidateIotlbPageLocked(parent_->domain_id(), item.addr(), address_mask);
+        iommu_->QueueIotlbPageInvalidationLocked(domain_id, item.addr(), address_mask);
     }
+    iommu_->WaitForInvalidationsLocked();
     pending->clear();
 }
 
@@ -32,6 +32,8 @@ private:
     PtFlags terminal_flags(PageTableLevel level, uint flags) final;
     PtFlags split_flags(PageTableLevel level, PtFlags flags) final;
     void TlbInvalidate(PendingTlbInvalidation* pending) final;
+    // Second-level accessed/dirty flags are not enabled.
+    PtFlags accessed_flag() final { return 0; }
     uint pt_flags_to_mmu_flags(PtFlags flags, PageTableLevel level) final;
     bool needs_cache_flushes() final { return needs_flushes_; }
 
@@ -17,6 +17,7 @@
 #include <dev/pcie_irqs.h>
 #include <dev/pcie_ref_counted.h>
 #include <dev/pci_config.h>
+#include <kernel/cpu.h>
 #include <kernel/spinlock.h>
 #include <fbl/algorithm.h>
 #include <fbl/macros.h>
@@ -280,6 +281,37 @@ public:
      */
     zx_status_t MaskUnmaskIrq(uint irq_id, bool mask);
 
+    /**
+     * Steer the specified IRQ to a CPU.
+     *
+     * In MSI mode all of the device's IRQs share one target address, so
+     * steering one of them steers all of them.  Devices without per vector
+     * masking have MSI briefly disabled while they are retargeted, and may
+     * drop an IRQ raised meanwhile, so steer IRQs before starting the device.
+     *
+     * @param irq_id The ID of the IRQ to steer.
+     * @param cpu The CPU the IRQ should be delivered to.
+     *
+     * @return A zx_status_t indicating the success or failure of the operation.
+     * Status codes may include (but are not limited to)...
+     *
+     * ++ ZX_ERR_BAD_STATE
+     *    The device is unplugged, or in the DISABLED mode.
+     * ++ ZX_ERR_INVALID_ARGS
+     *    The irq_id parameter is out of range for the currently configured
+     *    mode, or |cpu| does not exist.
+     * ++ ZX_ERR_NOT_SUPPORTED
+     *    The device is in legacy mode, whose IRQ may be shared with other
+     *    devices, or the platform cannot steer MSIs to |cpu|.
+     */
+    zx_status_t SetIrqAffinity(uint irq_id, cpu_num_t cpu);
+
+    /**
+     * Returns the CPU the specified IRQ is delivered to, or INVALID_CPU if
+     * it has not been steered.
+     */
+    cpu_num_t GetIrqAffinity(uint irq_id) const;
+
     void SetQuirksDone() { quirks_done_ = true; }
 
     /**
@@ -289,6 +321,13 @@ public:
     zx_status_t UnmaskIrq(uint irq_id) { return MaskUnmaskIrq(irq_id, false); }
 
     const PciConfig*     config()      const { return cfg_; }
+
+    // Read |width| bytes of config space at |offset| from the copy of the
+    // read-only registers taken when the device was probed: the IDs, class
+    // codes, header type and the capability list headers.  Returns false if
+    // any of the bytes were not copied, in which case the caller needs to go
+    // to the hardware.
+    bool ReadShadowedConfig(uint16_t offset, size_t width, uint32_t* out_val) const;
     paddr_t              config_phys() const { return cfg_phys_; }
     PcieBusDriver&       driver()            { return bus_drv_; }
 
@@ -343,6 +382,7 @@ protected:
     zx_status_t ProbeCapabilitiesLocked();
     zx_status_t ParseStdCapabilitiesLocked();
     zx_status_t ParseExtCapabilitiesLocked();
+    void ShadowConfigLocked(uint16_t offset, uint32_t val, size_t width);
     zx_status_t MapPinToIrqLocked(fbl::RefPtr<PcieUpstreamNode>&& upstream);
     zx_status_t InitLegacyIrqStateLocked(PcieUpstreamNode& upstream);
 
@@ -373,6 +413,12 @@ protected:
     uint8_t        prog_if_;        // The device's programming interface (from cfg)
     uint8_t        rev_id_;         // The device's revision ID (from cfg)
 
+    /* Copy of the read-only bytes of standard config space, filled in during
+     * probing and only read afterwards, along with a bitmap of which bytes
+     * have been copied. */
+    uint8_t  cfg_shadow_[PCIE_BASE_CONFIG_SIZE] = { };
+    uint64_t cfg_shadow_valid_[PCIE_BASE_CONFIG_SIZE / 64] = { };
+
     fbl::RefPtr<PcieUpstreamNode> upstream_;  // The upstream node in the device graph.
 
     /* State related to lifetime management */
@@ -414,6 +460,7 @@ private:
     zx_status_t MaskUnmaskMsiIrq(uint irq_id, bool mask);
     void        MaskAllMsiVectors();
     void        SetMsiTarget(uint64_t tgt_addr, uint32_t tgt_data);
+    void        RetargetMsiLocked(uint64_t tgt_addr);
     void        FreeMsiBlock();
     void        SetMsiMultiMessageEnb(uint requested_irqs);
     void        LeaveMsiIrqMode();
@@ -456,6 +503,8 @@ private:
         } legacy;
 
         PciCapMsi* msi = nullptr;
+        /* The CPU the MSI block was steered to, if any */
+        cpu_num_t                 msi_affinity = INVALID_CPU;
         /* TODO(johngro) : Add MSI-X state */
         struct { } msi_x;
     } irq_;
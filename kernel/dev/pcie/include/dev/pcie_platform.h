@@ -123,6 +123,19 @@ public:
         DEBUG_ASSERT(false);
     }
 
+    /**
+     * Method used to steer a block of MSIs to a single CPU.  On success, the
+     * block's target address and data have been updated and the bus driver
+     * reprograms the device with them.
+     *
+     * @param block A pointer to a block of MSIs allocated using a platform supplied
+     *        platform_msi_alloc_block_t callback.
+     * @param cpu The CPU the block's MSIs should be delivered to.
+     */
+    virtual zx_status_t SetMsiAffinity(msi_block_t* block, cpu_num_t cpu) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
     DISALLOW_COPY_ASSIGN_AND_MOVE(PciePlatformInterface);
 protected:
     enum class MsiSupportLevel { NONE, MSI, MSI_WITH_MASKING };
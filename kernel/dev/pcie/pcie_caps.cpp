@@ -297,7 +297,12 @@ zx_status_t PcieDevice::ParseStdCapabilitiesLocked() {
             break;
         }
 
+        // The ID and next pointer of each capability are read-only, so keep
+        // copies for capability walks done later on.
         uint8_t id = cfg_->Read(PciReg8(cap_offset));
+        uint8_t next = cfg_->Read(PciReg8(static_cast<uint16_t>(cap_offset + 0x1)));
+        ShadowConfigLocked(cap_offset, id, sizeof(uint8_t));
+        ShadowConfigLocked(static_cast<uint16_t>(cap_offset + 0x1), next, sizeof(uint8_t));
 
         LTRACEF("Found capability (#%u, id = 0x%02x) for device %02x:%02x.%01x (%04hx:%04hx)\n",
                 caps_found, id,
@@ -331,7 +336,7 @@ zx_status_t PcieDevice::ParseStdCapabilitiesLocked() {
         }
 
         caps_.detected.push_front(fbl::unique_ptr<PciStdCapability>(cap));
-        cap_offset  = cfg_->Read(PciReg8(static_cast<uint16_t>(cap_offset + 0x1))) & 0xFC;
+        cap_offset  = next & 0xFC;
         caps_found++;
     }
 
@@ -117,6 +117,34 @@ zx_status_t PcieDevice::Init(PcieUpstreamNode& upstream) {
     return res;
 }
 
+void PcieDevice::ShadowConfigLocked(uint16_t offset, uint32_t val, size_t width) {
+    DEBUG_ASSERT(dev_lock_.IsHeld());
+    DEBUG_ASSERT(offset + width <= sizeof(cfg_shadow_));
+
+    for (size_t i = 0; i < width; i++, val >>= 8) {
+        cfg_shadow_[offset + i] = static_cast<uint8_t>(val & 0xFF);
+        cfg_shadow_valid_[(offset + i) / 64] |= 1ull << ((offset + i) % 64);
+    }
+}
+
+bool PcieDevice::ReadShadowedConfig(uint16_t offset, size_t width, uint32_t* out_val) const {
+    if ((width != sizeof(uint8_t) && width != sizeof(uint16_t) && width != sizeof(uint32_t)) ||
+        (offset + width > sizeof(cfg_shadow_))) {
+        return false;
+    }
+
+    uint32_t val = 0;
+    for (size_t i = 0; i < width; i++) {
+        if (!(cfg_shadow_valid_[(offset + i) / 64] & (1ull << ((offset + i) % 64)))) {
+            return false;
+        }
+        val |= static_cast<uint32_t>(cfg_shadow_[offset + i]) << (i * 8);
+    }
+
+    *out_val = val;
+    return true;
+}
+
 zx_status_t PcieDevice::InitLocked(PcieUpstreamNode& upstream) {
     zx_status_t res;
     DEBUG_ASSERT(dev_lock_.IsHeld());
@@ -136,6 +164,22 @@ zx_status_t PcieDevice::InitLocked(PcieUpstreamNode& upstream) {
     prog_if_   = cfg_->Read(PciConfig::kProgramInterface);
     rev_id_    = cfg_->Read(PciConfig::kRevisionId);
 
+    // Keep copies of the read-only parts of the header so that they can be
+    // read later without going to the hardware.
+    ShadowConfigLocked(PciConfig::kVendorId.offset(),
+                       cfg_->Read(PciReg32(PciConfig::kVendorId.offset())), sizeof(uint32_t));
+    ShadowConfigLocked(PciConfig::kRevisionId.offset(),
+                       cfg_->Read(PciReg32(PciConfig::kRevisionId.offset())), sizeof(uint32_t));
+    ShadowConfigLocked(PciConfig::kHeaderType.offset(),
+                       cfg_->Read(PciConfig::kHeaderType), sizeof(uint8_t));
+    ShadowConfigLocked(PciConfig::kCapabilitiesPtr.offset(),
+                       cfg_->Read(PciConfig::kCapabilitiesPtr), sizeof(uint8_t));
+    if (!is_bridge_) {
+        ShadowConfigLocked(PciConfig::kSubsystemVendorId.offset(),
+                           cfg_->Read(PciReg32(PciConfig::kSubsystemVendorId.offset())),
+                           sizeof(uint32_t));
+    }
+
     // Determine the details of each of the BARs, but do not actually allocate
     // space on the bus for them yet.
     res = ProbeBarsLocked();
@@ -359,6 +359,35 @@ void PcieDevice::SetMsiTarget(uint64_t tgt_addr, uint32_t tgt_data) {
     cfg_->Write(irq_.msi->data_reg(), static_cast<uint16_t>(tgt_data & 0xFFFF));
 }
 
+void PcieDevice::RetargetMsiLocked(uint64_t tgt_addr) {
+    DEBUG_ASSERT(dev_lock_.IsHeld());
+    DEBUG_ASSERT(irq_.msi);
+    DEBUG_ASSERT(irq_.msi->is_valid());
+    DEBUG_ASSERT(irq_.msi->is64Bit() || !(tgt_addr >> 32));
+
+    /* Keep the device from signalling while the halves of the address
+     * disagree.  Vectors masked with PVM latch their pending bit, so mask them
+     * if we can.  Otherwise, MSI has to be turned off for the duration. */
+    uint32_t mask_bits = 0;
+    if (irq_.msi->has_pvm()) {
+        mask_bits = cfg_->Read(irq_.msi->mask_bits_reg());
+        cfg_->Write(irq_.msi->mask_bits_reg(), 0xFFFFFFFF);
+    } else {
+        SetMsiEnb(false);
+    }
+
+    cfg_->Write(irq_.msi->addr_reg(), static_cast<uint32_t>(tgt_addr & 0xFFFFFFFF));
+    if (irq_.msi->is64Bit()) {
+        cfg_->Write(irq_.msi->addr_upper_reg(), static_cast<uint32_t>(tgt_addr >> 32));
+    }
+
+    if (irq_.msi->has_pvm()) {
+        cfg_->Write(irq_.msi->mask_bits_reg(), mask_bits);
+    } else {
+        SetMsiEnb(true);
+    }
+}
+
 void PcieDevice::FreeMsiBlock() {
     /* If no block has been allocated, there is nothing to do */
     if (!irq_.msi->irq_block_.allocated)
@@ -404,6 +433,7 @@ void PcieDevice::LeaveMsiIrqMode() {
      * the interrupt controller and synchronizing with the dispatchers in
      * the process. */
     FreeMsiBlock();
+    irq_.msi_affinity = INVALID_CPU;
 
     /* Reset our common state, free any allocated handlers */
     ResetCommonIrqBookkeeping();
@@ -775,6 +805,39 @@ zx_status_t PcieDevice::MaskUnmaskIrq(uint irq_id, bool mask) {
         : ZX_ERR_BAD_STATE;
 }
 
+zx_status_t PcieDevice::SetIrqAffinity(uint irq_id, cpu_num_t cpu) {
+    AutoLock dev_lock(&dev_lock_);
+
+    if (!plugged_in_ || disabled_)
+        return ZX_ERR_BAD_STATE;
+
+    switch (irq_.mode) {
+    case PCIE_IRQ_MODE_DISABLED: return ZX_ERR_BAD_STATE;
+    case PCIE_IRQ_MODE_MSI:      break;
+    default:                     return ZX_ERR_NOT_SUPPORTED;
+    }
+
+    if (irq_id >= irq_.handler_count)
+        return ZX_ERR_INVALID_ARGS;
+
+    DEBUG_ASSERT(irq_.msi->irq_block_.allocated);
+    zx_status_t res = bus_drv_.platform().SetMsiAffinity(&irq_.msi->irq_block_, cpu);
+    if (res != ZX_OK)
+        return res;
+
+    RetargetMsiLocked(irq_.msi->irq_block_.tgt_addr);
+    irq_.msi_affinity = cpu;
+    return ZX_OK;
+}
+
+cpu_num_t PcieDevice::GetIrqAffinity(uint irq_id) const {
+    AutoLock dev_lock(&dev_lock_);
+
+    if ((irq_.mode != PCIE_IRQ_MODE_MSI) || (irq_id >= irq_.handler_count))
+        return INVALID_CPU;
+
+    return irq_.msi_affinity;
+}
 
 // Map from a device's interrupt pin ID to the proper system IRQ ID.  Follow the
 // PCIe graph up to the root, swizzling as we traverse PCIe switches,
@@ -36,4 +36,14 @@ void arch_dump_exception_context(const arch_exception_context_t* context);
 void arch_fill_in_exception_context(
     const arch_exception_context_t* context, zx_exception_report_t* report);
 
+// Returns the user stack pointer at the time of the exception described by
+// |context|. Implemented by arch code.
+uintptr_t arch_exception_context_user_sp(const arch_exception_context_t* context);
+
+// Makes the current thread return from the exception described by |context|
+// into a call of |pc|, with the stack pointer at |frame| and |frame| as the
+// first argument. |frame| is 16 byte aligned. Implemented by arch code.
+zx_status_t arch_redirect_exception_context(arch_exception_context_t* context,
+                                            uintptr_t pc, uintptr_t frame);
+
 __END_CDECLS
@@ -25,6 +25,11 @@ zx_status_t arch_mp_reschedule(cpu_mask_t mask);
  * thread lock. */
 void arch_prepare_current_cpu_idle_state(bool idle);
 
+/* Passes the performance hint of the thread being switched in on the
+ * current cpu, one of THREAD_PERF_HINT_*. Will be called under the
+ * thread lock. */
+void arch_set_current_cpu_perf_hint(uint32_t hint, zx_time_t now);
+
 /* Bring a CPU up and enter it into the scheduler */
 zx_status_t platform_mp_cpu_hotplug(cpu_num_t cpu_id);
 
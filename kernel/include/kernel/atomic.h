@@ -95,6 +95,10 @@ static inline uint32_t atomic_load_u32(volatile uint32_t* ptr) {
     return __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
 }
 
+static inline void atomic_store_u32(volatile uint32_t* ptr, uint32_t newval) {
+    __atomic_store_n(ptr, newval, __ATOMIC_SEQ_CST);
+}
+
 static inline void atomic_store_relaxed_u32(volatile uint32_t* ptr, uint32_t newval) {
     __atomic_store_n(ptr, newval, __ATOMIC_RELAXED);
 }
@@ -5,6 +5,7 @@
 // https://opensource.org/licenses/MIT
 #pragma once
 
+#include <kernel/event.h>
 #include <kernel/thread.h>
 #include <list.h>
 #include <sys/types.h>
@@ -14,6 +15,17 @@
 __BEGIN_CDECLS
 
 #define DPC_THREAD_PRIORITY HIGH_PRIORITY
+#define DPC_HIGH_THREAD_PRIORITY DPC_PRIORITY
+
+// Each class of dpc is run by its own thread on every cpu.
+typedef enum dpc_class {
+    // Runs at DPC_THREAD_PRIORITY.
+    DPC_CLASS_NORMAL = 0,
+    // For latency critical completions.  Runs at DPC_HIGH_THREAD_PRIORITY,
+    // ahead of the normal class and of most other threads.  Keep these short.
+    DPC_CLASS_HIGH,
+    DPC_NUM_CLASSES,
+} dpc_class_t;
 
 struct dpc;
 typedef void (*dpc_func_t)(struct dpc*);
@@ -23,6 +35,9 @@ typedef struct dpc {
 
     dpc_func_t func;
     void* arg;
+
+    // when the dpc was last queued, for the queueing delay counters
+    zx_time_t queued_time;
 } dpc_t;
 
 #define DPC_INITIAL_VALUE                   \
@@ -30,8 +45,19 @@ typedef struct dpc {
         .node = LIST_INITIAL_CLEARED_VALUE, \
         .func = 0,                          \
         .arg = 0,                           \
+        .queued_time = 0,                   \
     }
 
+// per cpu state of one dpc class, guarded by dpc_lock
+struct dpc_worker {
+    list_node_t list;
+    event_t event;
+    // request the dpc thread to stop by setting to true
+    bool stop;
+    // the thread processing the dpcs of this class
+    thread_t* thread;
+};
+
 // initializes dpc for the current cpu
 void dpc_init_for_cpu(void);
 
@@ -39,6 +65,9 @@ void dpc_init_for_cpu(void);
 // the deferred procedure runs in a dedicated thread that runs at DPC_THREAD_PRIORITY
 zx_status_t dpc_queue(dpc_t* dpc, bool reschedule);
 
+// like dpc_queue, but the dpc is run by the thread of class |cls|
+zx_status_t dpc_queue_etc(dpc_t* dpc, dpc_class_t cls, bool reschedule);
+
 // queue a dpc, but must be holding the thread lock
 // does not force a reschedule
 zx_status_t dpc_queue_thread_locked(dpc_t* dpc) TA_REQ(thread_lock);
@@ -52,7 +81,7 @@ zx_status_t dpc_queue_thread_locked(dpc_t* dpc) TA_REQ(thread_lock);
 // - stops servicing the queue
 // - waits for any in-progress DPC to complete
 // - ensures no queued DPCs will begin executing
-// - joins the DPC thread
+// - joins the DPC threads
 //
 // Upon completion, |cpu| may have unexecuted DPCs and |dpc_queue| will continue to queue new DPCs.
 //
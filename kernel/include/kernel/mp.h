@@ -53,10 +53,21 @@ void mp_reschedule(cpu_mask_t mask, uint flags) TA_REQ(thread_lock);
 // Used by the hypervisor to trigger a vmexit.
 void mp_interrupt(mp_ipi_target_t, cpu_mask_t mask);
 
+// Send |ipi|, other than MP_IPI_HALT, to the cpus in |mask|. A cpu that has
+// yet to take the last ipi it was sent is not sent another one; the pending
+// one does the work of both when it arrives. Used by the arch layer for the
+// reschedule ipis it cannot avoid.
+void mp_send_ipi(mp_ipi_target_t, cpu_mask_t mask, mp_ipi_t ipi);
+
 // Make a cross cpu call to one or more cpus. Waits for all of the calls
 // to complete before returning.
 void mp_sync_exec(mp_ipi_target_t, cpu_mask_t mask, mp_sync_task_t task, void* context);
 
+// Record where |cpu| sits in the cache hierarchy. cpus that report the same
+// |cache_id| share a last level cache; cpus that additionally report the same
+// |core_id| are smt siblings. Called by the arch layer as each cpu comes up.
+void mp_set_cpu_topology(cpu_num_t cpu, uint32_t cache_id, uint32_t core_id);
+
 zx_status_t mp_hotplug_cpu_mask(cpu_mask_t mask);
 zx_status_t mp_unplug_cpu_mask(cpu_mask_t mask);
 static inline zx_status_t mp_hotplug_cpu(cpu_num_t cpu) {
@@ -97,12 +108,43 @@ struct mp_state {
     // accessed with the ipi_task_lock held
     struct list_node ipi_task_list[SMP_MAX_CPUS];
 
+    // the (1 << mp_ipi_t) work each cpu has been asked for since it last took
+    // an ipi. Whoever sets the first bit sends the ipi; the handler of
+    // whichever ipi arrives clears them all and does the work.
+    volatile int ipi_pending[SMP_MAX_CPUS];
+
     // lock for serializing CPU hotplug/unplug operations
     mutex_t hotplug_lock;
+
+    // cpu topology as reported by the arch layer; see mp_set_cpu_topology().
+    // cpus that have not reported yet are assumed to share a cache with every
+    // other cpu and to have no smt siblings.
+    spin_lock_t topology_lock;
+    volatile cpu_mask_t topology_valid;
+    uint32_t cache_id[SMP_MAX_CPUS];
+    uint32_t core_id[SMP_MAX_CPUS];
+    volatile cpu_mask_t smt_mask[SMP_MAX_CPUS];
+    volatile cpu_mask_t cache_mask[SMP_MAX_CPUS];
 };
 
 extern struct mp_state mp;
 
+// mask of cpus sharing a core with |cpu|, including |cpu| itself
+static inline cpu_mask_t mp_get_smt_mask(cpu_num_t cpu) {
+    if (!(mp.topology_valid & cpu_num_to_mask(cpu))) {
+        return cpu_num_to_mask(cpu);
+    }
+    return mp.smt_mask[cpu];
+}
+
+// mask of cpus sharing a last level cache with |cpu|, including |cpu| itself
+static inline cpu_mask_t mp_get_cache_mask(cpu_num_t cpu) {
+    if (!(mp.topology_valid & cpu_num_to_mask(cpu))) {
+        return CPU_MASK_ALL;
+    }
+    return mp.cache_mask[cpu];
+}
+
 // idle/busy is used to track if the cpu is running anything or has a non empty run queue
 // idle == (cpu run queue empty & cpu running idle thread)
 // busy == !idle
@@ -140,6 +182,8 @@ static inline cpu_mask_t mp_get_realtime_mask(void) TA_REQ(thread_lock) {
 // tracks if a cpu is online and initialized
 static inline void mp_set_curr_cpu_online(bool online) {
     if (online) {
+        // ipis sent while the cpu was down were lost
+        atomic_swap(&mp.ipi_pending[arch_curr_cpu_num()], 0);
         atomic_or((volatile int*)&mp.online_cpus, cpu_num_to_mask(arch_curr_cpu_num()));
     } else {
         atomic_and((volatile int*)&mp.online_cpus, ~cpu_num_to_mask(arch_curr_cpu_num()));
@@ -7,6 +7,7 @@
 
 #include <arch/ops.h>
 #include <kernel/align.h>
+#include <kernel/dpc.h>
 #include <kernel/event.h>
 #include <kernel/stats.h>
 #include <kernel/thread.h>
@@ -30,6 +31,22 @@ struct percpu {
     // per cpu run queue and bitmap to indicate which queues are non empty
     struct list_node run_queue[NUM_PRIORITIES];
     uint32_t run_queue_bitmap;
+    // number of threads across all of run_queue
+    uint32_t run_queue_len;
+
+    // rotor used to spread wakeups across the idle cpus; kept per cpu so that
+    // concurrent wakeups do not bounce a shared cache line.
+    uint32_t sched_rotor;
+
+    // virtual clock for the fair scheduling class on this cpu; only moves
+    // forward and is guarded by thread_lock
+    zx_duration_t fair_vtime;
+
+    // set when the running thread used up its time slice with nothing else
+    // queued on this cpu, so the preemption timer was left off; the next
+    // enqueue onto this cpu preempts the thread instead. guarded by
+    // thread_lock
+    bool preempt_deferred;
 
 #if WITH_LOCK_DEP
     // state for runtime lock validation when in irq context
@@ -45,13 +62,8 @@ struct percpu {
     // kernel counters arena
     int64_t* counters;
 
-    // dpc context
-    list_node_t dpc_list;
-    event_t dpc_event;
-    // request the dpc thread to stop by setting to true; guarded by dpc_lock
-    bool dpc_stop;
-    // each cpu has a dedicated thread for processing dpcs
-    thread_t* dpc_thread;
+    // dpc context; each cpu has a dedicated thread for processing each class of dpcs
+    struct dpc_worker dpc[DPC_NUM_CLASSES];
 } __CPU_ALIGN;
 
 // the kernel per-cpu structure
@@ -34,6 +34,10 @@ void sched_inherit_priority(thread_t* t, int pri, bool* local_resched) TA_REQ(th
 // pri should be 0 <= to <= MAX_PRIORITY.
 void sched_change_priority(thread_t* t, int pri) TA_REQ(thread_lock);
 
+// set the fair class parameters of a thread, requeueing it if it is ready.
+// weight == 0 moves the thread back to the priority class. This function might reschedule.
+void sched_set_fair_params(thread_t* t, uint32_t weight, zx_duration_t deadline) TA_REQ(thread_lock);
+
 // return true if the thread was placed on the current cpu's run queue
 // this usually means the caller should locally reschedule soon
 bool sched_unblock(thread_t* t) __WARN_UNUSED_RESULT TA_REQ(thread_lock);
@@ -20,10 +20,24 @@ static inline bool spin_lock_held(spin_lock_t* lock) {
     return arch_spin_lock_held(lock);
 }
 
+#if WITH_LOCK_PROF
+// Tells the lock profiler that the acquisition in progress on the current
+// thread (or cpu, in irq context) had to wait for another owner.
+void lockdep_note_contention(void);
+#else
+static inline void lockdep_note_contention(void) {}
+#endif
+
 // interrupts should already be disabled
 static inline void spin_lock(spin_lock_t* lock) TA_ACQ(lock) {
     DEBUG_ASSERT(arch_ints_disabled());
     DEBUG_ASSERT(!spin_lock_held(lock));
+#if WITH_LOCK_PROF
+    // Only pay for the extra attempt when profiling.
+    if (!arch_spin_trylock(lock))
+        return;
+    lockdep_note_contention();
+#endif
     arch_spin_lock(lock);
 }
 
@@ -53,6 +53,7 @@ typedef void (*thread_tls_callback_t)(void* tls_value);
 #define THREAD_SIGNAL_KILL                   (1 << 0)
 #define THREAD_SIGNAL_SUSPEND                (1 << 1)
 #define THREAD_SIGNAL_POLICY_EXCEPTION       (1 << 2)
+#define THREAD_SIGNAL_THROTTLE               (1 << 3)
 // clang-format on
 
 #define THREAD_MAGIC (0x74687264) // 'thrd'
@@ -76,6 +77,7 @@ typedef struct lockdep_state {
     uintptr_t acquired_locks;
     uint16_t reporting_disabled_count;
     uint8_t last_result;
+    bool contended;
 } lockdep_state_t;
 
 typedef struct thread {
@@ -95,6 +97,24 @@ typedef struct thread {
     // left the scheduler.
     zx_duration_t runtime_ns;
 
+    // Usage of a user thread not yet charged to the task counters of its
+    // process and jobs. The scheduler folds the runtime and switch counts in
+    // once they amount to a millisecond of runtime; page faults are only
+    // touched by the thread itself.
+    zx_duration_t uncharged_runtime;
+    uint32_t uncharged_switches;
+    uint32_t uncharged_page_faults;
+
+    // Set once a charge finds that a job above the thread limits its cpu
+    // bandwidth. The scheduler then also charges the thread every
+    // millisecond while it runs, and |running_charged| is the part of the
+    // current run already charged that way. When a quota runs out the
+    // thread gets THREAD_SIGNAL_THROTTLE and sleeps until |throttled_until|
+    // before it next returns to user mode.
+    bool cpu_limited;
+    zx_duration_t running_charged;
+    zx_time_t throttled_until;
+
     // priority: in the range of [MIN_PRIORITY, MAX_PRIORITY], from low to high.
     // base_priority is set at creation time, and can be tuned with thread_set_priority().
     // priority_boost is a signed value that is moved around within a range by the scheduler.
@@ -107,6 +127,21 @@ typedef struct thread {
     int priority_boost;
     int inherited_priority;
 
+    // scheduling class, one of THREAD_SCHED_CLASS_*.
+    // fair class threads are never boosted. Within their run queue they are
+    // ordered by fair_vfinish, the virtual time at which their current quantum
+    // ends, and virtual time advances inversely to fair_weight. A non zero
+    // fair_deadline caps both the quantum and the virtual span of the thread.
+    int sched_class;
+    uint32_t fair_weight;
+    zx_duration_t fair_deadline;
+    zx_duration_t fair_vstart;
+    zx_duration_t fair_vfinish;
+
+    // performance hint, one of THREAD_PERF_HINT_*. The scheduler passes it on
+    // to the arch layer as the thread is switched in.
+    uint32_t perf_hint;
+
     // current cpu the thread is either running on or in the ready queue, undefined otherwise
     cpu_num_t curr_cpu;
     cpu_num_t last_cpu;      // last cpu the thread ran on, INVALID_CPU if it's never run
@@ -216,6 +251,21 @@ typedef struct thread {
 #define DEFAULT_PRIORITY (NUM_PRIORITIES / 2)
 #define HIGH_PRIORITY ((NUM_PRIORITIES / 4) * 3)
 
+// scheduling classes
+#define THREAD_SCHED_CLASS_PRIORITY (0)
+#define THREAD_SCHED_CLASS_FAIR (1)
+
+// fair class weights, relative to the default weight
+#define THREAD_FAIR_WEIGHT_MIN (1u)
+#define THREAD_FAIR_WEIGHT_DEFAULT (1024u)
+#define THREAD_FAIR_WEIGHT_MAX (65536u)
+
+// performance hints
+#define THREAD_PERF_HINT_NONE (0u)
+#define THREAD_PERF_HINT_LATENCY (1u)
+#define THREAD_PERF_HINT_EFFICIENCY (2u)
+#define THREAD_PERF_HINT_COUNT (3u)
+
 // stack size
 #ifdef CUSTOM_DEFAULT_STACK_SIZE
 #define DEFAULT_STACK_SIZE CUSTOM_DEFAULT_STACK_SIZE
@@ -232,6 +282,10 @@ void thread_construct_first(thread_t* t, const char* name);
 thread_t* thread_create_idle_thread(uint cpu_num);
 void thread_set_name(const char* name);
 void thread_set_priority(thread_t* t, int priority);
+// move the thread into the weighted-fair scheduling class with the given weight and
+// optional deadline (0 for none). A weight of 0 returns it to the priority class.
+void thread_set_fair_params(thread_t* t, uint32_t weight, zx_duration_t deadline);
+void thread_set_perf_hint(thread_t* t, uint32_t hint);
 void thread_set_user_callback(thread_t* t, thread_user_callback_t cb);
 thread_t* thread_create(const char* name, thread_start_routine entry, void* arg, int priority);
 thread_t* thread_create_etc(thread_t* t, const char* name, thread_start_routine entry, void* arg,
@@ -330,6 +384,10 @@ static inline bool thread_is_real_time_or_idle(thread_t* t) {
     return !!(t->flags & (THREAD_FLAG_REAL_TIME | THREAD_FLAG_IDLE));
 }
 
+static inline bool thread_is_fair(thread_t* t) {
+    return t->sched_class == THREAD_SCHED_CLASS_FAIR;
+}
+
 // the current thread
 #include <arch/current_thread.h>
 thread_t* get_current_thread(void);
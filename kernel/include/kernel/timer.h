@@ -35,6 +35,9 @@ typedef struct timer {
     zx_time_t scheduled_time;
     zx_duration_t slack; // Stores the applied slack adjustment from
     //                      the ideal scheduled_time.
+    zx_time_t earliest_time; // Start of the slack window; the timer may
+    //                          fire from here on if the cpu is interrupted
+    //                          anyway.
     timer_callback callback;
     void* arg;
 
@@ -48,6 +51,7 @@ typedef struct timer {
         .node = LIST_INITIAL_CLEARED_VALUE, \
         .scheduled_time = 0,                \
         .slack = 0,                         \
+        .earliest_time = 0,                 \
         .callback = NULL,                   \
         .arg = NULL,                        \
         .active_cpu = -1,                   \
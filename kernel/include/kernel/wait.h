@@ -118,7 +118,7 @@ public:
     }
 
     int WakeAll(bool reschedule, zx_status_t wait_queue_error) TA_REQ(thread_lock) {
-        return wait_queue_wake_one(&wq_, reschedule, wait_queue_error);
+        return wait_queue_wake_all(&wq_, reschedule, wait_queue_error);
     }
 
     struct thread* DequeueOne(zx_status_t wait_queue_error) TA_REQ(thread_lock) {
@@ -20,8 +20,9 @@ __BEGIN_CDECLS
 //   - after N seconds how many outstanding <x> things are allocated?
 //   - up to this point has <Y> ever happened?
 //
-// Currently the only query interface to the counters is the console
-// k counters command. Issue 'k counters help' to learn what it can do.
+// The counters can be inspected with the console k counters command. Issue
+// 'k counters help' to learn what it can do. Userspace holding the root
+// resource can map them read-only through zx_kcounters_get_vmo().
 //
 // Kernel counters public API:
 // 1- define a new counter.
@@ -94,3 +95,15 @@ static inline void kcounter_add(const struct k_counter_desc* var,
 }
 
 __END_CDECLS
+
+#ifdef __cplusplus
+
+#include <fbl/ref_ptr.h>
+
+class VmObject;
+
+// Returns the VMO exporting the descriptor table and the per-cpu counter
+// pages, or null if it could not be created at boot.
+fbl::RefPtr<VmObject> kcounters_get_vmo();
+
+#endif // __cplusplus
@@ -9,6 +9,7 @@
 
 #include <zircon/compiler.h>
 #include <sys/types.h>
+#include <zircon/types.h>
 
 __BEGIN_CDECLS
 
@@ -64,6 +65,17 @@ struct lk_init_struct {
     const char *name;
 };
 
+// When, in ticks, an init hook ran on the primary cpu and for how long.
+struct lk_init_timing {
+    const struct lk_init_struct* init;
+    zx_ticks_t start;
+    zx_ticks_t duration;
+};
+
+// Returns the hooks that have run on the primary cpu so far, in call order,
+// and stores their number in |count|.
+const struct lk_init_timing* lk_init_timings(size_t* count);
+
 #define LK_INIT_HOOK_FLAGS(_name, _hook, _level, _flags)                \
     __ALIGNED(sizeof(void *)) __USED __SECTION(".data.rel.ro.lk_init")  \
     static const struct lk_init_struct _init_struct_##_name = {         \
@@ -38,6 +38,12 @@ zx_ticks_t ticks_per_second(void);
 /* high-precision timer current_ticks */
 zx_ticks_t current_ticks(void);
 
+/* If current_time() is the counter user mode reads as zx_ticks_get()
+ * converted by a fixed factor, store that factor in |ns_per_tick| and
+ * return true, so that user mode can compute the time itself. */
+struct fp_32_64;
+bool platform_get_user_timebase(struct fp_32_64* ns_per_tick);
+
 /* super early platform initialization, before almost everything */
 void platform_early_init(void);
 
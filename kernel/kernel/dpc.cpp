@@ -9,17 +9,50 @@
 #include <list.h>
 #include <trace.h>
 
+#include <fbl/algorithm.h>
 #include <kernel/dpc.h>
 #include <kernel/event.h>
 #include <kernel/percpu.h>
 #include <kernel/spinlock.h>
+#include <lib/counters.h>
+#include <lib/ktrace.h>
 #include <lk/init.h>
+#include <platform.h>
+#include <zircon/time.h>
+
+// Most dpcs taken off the list per acquisition of dpc_lock.
+#define DPC_BATCH_MAX 16
+
+// Dpcs which waited longer than this to run are counted as late.
+#define DPC_LATE_THRESHOLD ZX_MSEC(1)
 
 static spin_lock_t dpc_lock = SPIN_LOCK_INITIAL_VALUE;
 
+KCOUNTER(dpc_batch_count, "kernel.dpc.batches");
+KCOUNTER(dpc_run_count, "kernel.dpc.run");
+KCOUNTER(dpc_delay_count, "kernel.dpc.delay_ns");
+KCOUNTER(dpc_late_count, "kernel.dpc.late");
+KCOUNTER(dpc_high_run_count, "kernel.dpc.high.run");
+KCOUNTER(dpc_high_delay_count, "kernel.dpc.high.delay_ns");
+KCOUNTER(dpc_high_late_count, "kernel.dpc.high.late");
+
+static const struct {
+    const struct k_counter_desc* run;
+    const struct k_counter_desc* delay;
+    const struct k_counter_desc* late;
+} dpc_counters[DPC_NUM_CLASSES] = {
+    {dpc_run_count, dpc_delay_count, dpc_late_count},
+    {dpc_high_run_count, dpc_high_delay_count, dpc_high_late_count},
+};
+
 zx_status_t dpc_queue(dpc_t* dpc, bool reschedule) {
+    return dpc_queue_etc(dpc, DPC_CLASS_NORMAL, reschedule);
+}
+
+zx_status_t dpc_queue_etc(dpc_t* dpc, dpc_class_t cls, bool reschedule) {
     DEBUG_ASSERT(dpc);
     DEBUG_ASSERT(dpc->func);
+    DEBUG_ASSERT(cls < DPC_NUM_CLASSES);
 
     // disable interrupts before finding lock
     spin_lock_saved_state_t state;
@@ -30,14 +63,15 @@ zx_status_t dpc_queue(dpc_t* dpc, bool reschedule) {
         return ZX_ERR_ALREADY_EXISTS;
     }
 
-    struct percpu* cpu = get_local_percpu();
+    struct dpc_worker* worker = &get_local_percpu()->dpc[cls];
 
     // put the dpc at the tail of the list and signal the worker
-    list_add_tail(&cpu->dpc_list, &dpc->node);
+    dpc->queued_time = current_time();
+    list_add_tail(&worker->list, &dpc->node);
 
     spin_unlock_irqrestore(&dpc_lock, state);
 
-    event_signal(&cpu->dpc_event, reschedule);
+    event_signal(&worker->event, reschedule);
 
     return ZX_OK;
 }
@@ -54,11 +88,12 @@ zx_status_t dpc_queue_thread_locked(dpc_t* dpc) {
         return ZX_ERR_ALREADY_EXISTS;
     }
 
-    struct percpu* cpu = get_local_percpu();
+    struct dpc_worker* worker = &get_local_percpu()->dpc[DPC_CLASS_NORMAL];
 
     // put the dpc at the tail of the list and signal the worker
-    list_add_tail(&cpu->dpc_list, &dpc->node);
-    event_signal_thread_locked(&cpu->dpc_event);
+    dpc->queued_time = current_time();
+    list_add_tail(&worker->list, &dpc->node);
+    event_signal_thread_locked(&worker->event);
 
     spin_unlock(&dpc_lock);
 
@@ -68,68 +103,101 @@ zx_status_t dpc_queue_thread_locked(dpc_t* dpc) {
 void dpc_shutdown(uint cpu_id) {
     DEBUG_ASSERT(cpu_id < SMP_MAX_CPUS);
 
+    thread_t* threads[DPC_NUM_CLASSES];
+
     spin_lock_saved_state_t state;
     spin_lock_irqsave(&dpc_lock, state);
 
-    DEBUG_ASSERT(!percpu[cpu_id].dpc_stop);
+    for (uint cls = 0; cls < DPC_NUM_CLASSES; cls++) {
+        struct dpc_worker* worker = &percpu[cpu_id].dpc[cls];
+        DEBUG_ASSERT(!worker->stop);
 
-    // Ask the DPC thread to terminate.
-    percpu[cpu_id].dpc_stop = true;
+        // Ask the DPC thread to terminate.
+        worker->stop = true;
 
-    // Take the thread pointer so we can join outside the spinlock.
-    thread_t* t = percpu[cpu_id].dpc_thread;
-    percpu[cpu_id].dpc_thread = nullptr;
+        // Take the thread pointer so we can join outside the spinlock.
+        threads[cls] = worker->thread;
+        worker->thread = nullptr;
+    }
 
     spin_unlock_irqrestore(&dpc_lock, state);
 
-    // Wake it.
-    event_signal(&percpu[cpu_id].dpc_event, false);
+    for (uint cls = 0; cls < DPC_NUM_CLASSES; cls++) {
+        // Wake it.
+        event_signal(&percpu[cpu_id].dpc[cls].event, false);
 
-    // Wait for it to terminate.
-    int ret = 0;
-    zx_status_t status = thread_join(t, &ret, ZX_TIME_INFINITE);
-    DEBUG_ASSERT(status == ZX_OK);
-    DEBUG_ASSERT(ret == 0);
+        // Wait for it to terminate.
+        int ret = 0;
+        zx_status_t status = thread_join(threads[cls], &ret, ZX_TIME_INFINITE);
+        DEBUG_ASSERT(status == ZX_OK);
+        DEBUG_ASSERT(ret == 0);
+    }
 }
 
 void dpc_shutdown_transition_off_cpu(uint cpu_id) {
     DEBUG_ASSERT(cpu_id < SMP_MAX_CPUS);
 
+    bool moved[DPC_NUM_CLASSES] = {};
+
     spin_lock_saved_state_t state;
     spin_lock_irqsave(&dpc_lock, state);
 
     uint cur_cpu = arch_curr_cpu_num();
     DEBUG_ASSERT(cpu_id != cur_cpu);
 
-    // The DPC thread should already be stopped.
-    DEBUG_ASSERT(percpu[cpu_id].dpc_stop);
-    DEBUG_ASSERT(percpu[cpu_id].dpc_thread == nullptr);
+    for (uint cls = 0; cls < DPC_NUM_CLASSES; cls++) {
+        struct dpc_worker* src = &percpu[cpu_id].dpc[cls];
+        struct dpc_worker* dst = &percpu[cur_cpu].dpc[cls];
 
-    list_node_t* src_list = &percpu[cpu_id].dpc_list;
-    list_node_t* dst_list = &percpu[cur_cpu].dpc_list;
+        // The DPC thread should already be stopped.
+        DEBUG_ASSERT(src->stop);
+        DEBUG_ASSERT(src->thread == nullptr);
 
-    dpc_t* dpc;
-    while ((dpc = list_remove_head_type(src_list, dpc_t, node))) {
-        list_add_tail(dst_list, &dpc->node);
-    }
+        dpc_t* dpc;
+        while ((dpc = list_remove_head_type(&src->list, dpc_t, node))) {
+            list_add_tail(&dst->list, &dpc->node);
+            moved[cls] = true;
+        }
 
-    // Reset the state so we can restart DPC processing if the CPU comes back online.
-    DEBUG_ASSERT(list_is_empty(&percpu[cpu_id].dpc_list));
-    percpu[cpu_id].dpc_stop = false;
-    event_destroy(&percpu[cpu_id].dpc_event);
+        // Reset the state so we can restart DPC processing if the CPU comes back online.
+        DEBUG_ASSERT(list_is_empty(&src->list));
+        src->stop = false;
+        event_destroy(&src->event);
+    }
 
     spin_unlock_irqrestore(&dpc_lock, state);
+
+    // Make sure the moved dpcs are not left waiting for another one to be queued.
+    for (uint cls = 0; cls < DPC_NUM_CLASSES; cls++) {
+        if (moved[cls]) {
+            event_signal(&percpu[cur_cpu].dpc[cls].event, false);
+        }
+    }
+}
+
+// Accounts for |dpc| starting to run at |now| after waiting in the queue of class |cls|.
+static void dpc_account(const dpc_t* dpc, uint cls, zx_time_t now) {
+    const zx_duration_t delay = zx_time_sub_time(now, dpc->queued_time);
+    kcounter_add(dpc_counters[cls].run, 1);
+    kcounter_add(dpc_counters[cls].delay, delay);
+    if (delay > DPC_LATE_THRESHOLD) {
+        kcounter_add(dpc_counters[cls].late, 1);
+    }
+    ktrace_probe2("dpc_delay", cls,
+                  static_cast<uint32_t>(fbl::min<zx_duration_t>(delay, UINT32_MAX)));
 }
 
 static int dpc_thread(void* arg) {
-    dpc_t dpc_local;
+    const uint cls = static_cast<uint>(reinterpret_cast<uintptr_t>(arg));
+    dpc_t batch[DPC_BATCH_MAX];
 
     spin_lock_saved_state_t state;
     arch_interrupt_save(&state, SPIN_LOCK_FLAG_INTERRUPTS);
 
     struct percpu* cpu = get_local_percpu();
-    event_t* event = &cpu->dpc_event;
-    list_node_t* list = &cpu->dpc_list;
+    struct dpc_worker* worker = &cpu->dpc[cls];
+    event_t* event = &worker->event;
+    list_node_t* list = &worker->list;
 
     arch_interrupt_restore(state, SPIN_LOCK_FLAG_INTERRUPTS);
 
@@ -140,27 +208,35 @@ static int dpc_thread(void* arg) {
 
         spin_lock_irqsave(&dpc_lock, state);
 
-        if (cpu->dpc_stop) {
+        if (worker->stop) {
             spin_unlock_irqrestore(&dpc_lock, state);
             return 0;
         }
 
-        // pop a dpc off the list, make a local copy.
-        dpc_t* dpc = list_remove_head_type(list, dpc_t, node);
+        // pop a batch of dpcs off the list, making local copies, since a dpc
+        // may be queued again or freed as soon as it is off the list.
+        size_t count = 0;
+        dpc_t* dpc;
+        while (count < DPC_BATCH_MAX && (dpc = list_remove_head_type(list, dpc_t, node))) {
+            batch[count++] = *dpc;
+        }
 
         // if the list is now empty, unsignal the event so we block until it is
-        if (!dpc) {
+        // not, otherwise come straight back for the rest.
+        if (list_is_empty(list)) {
             event_unsignal(event);
-            dpc_local.func = NULL;
-        } else {
-            dpc_local = *dpc;
         }
 
         spin_unlock_irqrestore(&dpc_lock, state);
 
-        // call the dpc
-        if (dpc_local.func) {
-            dpc_local.func(&dpc_local);
+        if (count > 0) {
+            kcounter_add(dpc_batch_count, 1);
+        }
+
+        // call the dpcs
+        for (size_t i = 0; i < count; i++) {
+            dpc_account(&batch[i], cls, current_time());
+            batch[i].func(&batch[i]);
         }
     }
 
@@ -172,19 +248,31 @@ void dpc_init_for_cpu(void) {
     uint cpu_num = arch_curr_cpu_num();
 
     // the cpu's dpc state was initialized on a previous hotplug event
-    if (event_initialized(&cpu->dpc_event)) {
+    if (event_initialized(&cpu->dpc[DPC_CLASS_NORMAL].event)) {
         return;
     }
 
-    list_initialize(&cpu->dpc_list);
-    event_init(&cpu->dpc_event, false, 0);
-    cpu->dpc_stop = false;
-
-    char name[10];
-    snprintf(name, sizeof(name), "dpc-%u", cpu_num);
-    cpu->dpc_thread = thread_create(name, &dpc_thread, NULL, DPC_THREAD_PRIORITY);
-    thread_set_cpu_affinity(cpu->dpc_thread, cpu_num_to_mask(cpu_num));
-    thread_resume(cpu->dpc_thread);
+    static const struct {
+        const char* name;
+        int priority;
+    } classes[DPC_NUM_CLASSES] = {
+        {"dpc", DPC_THREAD_PRIORITY},
+        {"dpc-high", DPC_HIGH_THREAD_PRIORITY},
+    };
+
+    for (uint cls = 0; cls < DPC_NUM_CLASSES; cls++) {
+        struct dpc_worker* worker = &cpu->dpc[cls];
+        list_initialize(&worker->list);
+        event_init(&worker->event, false, 0);
+        worker->stop = false;
+
+        char name[THREAD_NAME_LENGTH];
+        snprintf(name, sizeof(name), "%s-%u", classes[cls].name, cpu_num);
+        void* arg = reinterpret_cast<void*>(static_cast<uintptr_t>(cls));
+        worker->thread = thread_create(name, &dpc_thread, arg, classes[cls].priority);
+        thread_set_cpu_affinity(worker->thread, cpu_num_to_mask(cpu_num));
+        thread_resume(worker->thread);
+    }
 }
 
 static void dpc_init(unsigned int level) {
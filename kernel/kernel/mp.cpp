@@ -24,6 +24,7 @@
 #include <kernel/spinlock.h>
 #include <kernel/stats.h>
 #include <kernel/timer.h>
+#include <lib/counters.h>
 #include <lk/init.h>
 #include <platform.h>
 #include <platform/timer.h>
@@ -33,12 +34,16 @@
 
 #define LOCAL_TRACE 0
 
+KCOUNTER(mp_ipi_sent_count, "kernel.mp.ipi.sent");
+KCOUNTER(mp_ipi_coalesced_count, "kernel.mp.ipi.coalesced");
+
 // a global state structure, aligned on cpu cache line to minimize aliasing
 struct mp_state mp __CPU_ALIGN_EXCLUSIVE;
 
 // Helpers used for implementing mp_sync
 struct mp_sync_context;
 static void mp_sync_task(void* context);
+static void mp_run_ipi_tasks(cpu_num_t cpu);
 
 void mp_init(void) {
     mutex_init(&mp.hotplug_lock);
@@ -48,6 +53,43 @@ void mp_init(void) {
     }
 }
 
+void mp_set_cpu_topology(cpu_num_t cpu, uint32_t cache_id, uint32_t core_id) {
+    DEBUG_ASSERT(is_valid_cpu_num(cpu));
+
+    spin_lock_saved_state_t state;
+    spin_lock_irqsave(&mp.topology_lock, state);
+
+    mp.cache_id[cpu] = cache_id;
+    mp.core_id[cpu] = core_id;
+    mp.topology_valid |= cpu_num_to_mask(cpu);
+
+    // recompute the sibling masks of every cpu that has reported so far
+    const cpu_mask_t valid = mp.topology_valid;
+    for (cpu_num_t i = 0; i < SMP_MAX_CPUS; i++) {
+        if (!(valid & cpu_num_to_mask(i))) {
+            continue;
+        }
+        cpu_mask_t smt = 0;
+        cpu_mask_t cache = 0;
+        for (cpu_num_t j = 0; j < SMP_MAX_CPUS; j++) {
+            if (!(valid & cpu_num_to_mask(j)) || mp.cache_id[j] != mp.cache_id[i]) {
+                continue;
+            }
+            cache |= cpu_num_to_mask(j);
+            if (mp.core_id[j] == mp.core_id[i]) {
+                smt |= cpu_num_to_mask(j);
+            }
+        }
+        mp.smt_mask[i] = smt;
+        mp.cache_mask[i] = cache;
+    }
+
+    spin_unlock_irqrestore(&mp.topology_lock, state);
+
+    LTRACEF("cpu %u cache %#x core %#x smt mask %#x cache mask %#x\n",
+            cpu, cache_id, core_id, mp.smt_mask[cpu], mp.cache_mask[cpu]);
+}
+
 void mp_prepare_current_cpu_idle_state(bool idle) {
     arch_prepare_current_cpu_idle_state(idle);
 }
@@ -81,7 +123,45 @@ void mp_reschedule(cpu_mask_t mask, uint flags) {
 }
 
 void mp_interrupt(mp_ipi_target_t target, cpu_mask_t mask) {
-    arch_mp_send_ipi(target, mask, MP_IPI_INTERRUPT);
+    mp_send_ipi(target, mask, MP_IPI_INTERRUPT);
+}
+
+void mp_send_ipi(mp_ipi_target_t target, cpu_mask_t mask, mp_ipi_t ipi) {
+    DEBUG_ASSERT(ipi != MP_IPI_HALT);
+
+    spin_lock_saved_state_t irqstate;
+    arch_interrupt_save(&irqstate, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    if (target == MP_IPI_TARGET_ALL) {
+        mask = mp_get_online_mask();
+    } else if (target == MP_IPI_TARGET_ALL_BUT_LOCAL) {
+        mask = mp_get_online_mask() & ~cpu_num_to_mask(arch_curr_cpu_num());
+    }
+
+    // Any pending ipi will do, as the handlers of all of them look at every
+    // pending bit.
+    cpu_mask_t needs_ipi = 0;
+    uint coalesced = 0;
+    for (cpu_mask_t remaining = mask; remaining;) {
+        const cpu_num_t cpu = lowest_cpu_set(remaining);
+        remaining &= ~cpu_num_to_mask(cpu);
+        if (atomic_or(&mp.ipi_pending[cpu], 1 << ipi) == 0) {
+            needs_ipi |= cpu_num_to_mask(cpu);
+        } else {
+            coalesced++;
+        }
+    }
+
+    if (needs_ipi) {
+        kcounter_add(mp_ipi_sent_count, __builtin_popcount(needs_ipi));
+        __UNUSED zx_status_t status = arch_mp_send_ipi(MP_IPI_TARGET_MASK, needs_ipi, ipi);
+        DEBUG_ASSERT(status == ZX_OK);
+    }
+    if (coalesced) {
+        kcounter_add(mp_ipi_coalesced_count, coalesced);
+    }
+
+    arch_interrupt_restore(irqstate, SPIN_LOCK_FLAG_INTERRUPTS);
 }
 
 struct mp_sync_context {
@@ -164,8 +244,7 @@ void mp_sync_exec(mp_ipi_target_t target, cpu_mask_t mask, mp_sync_task_t task,
     spin_unlock(&mp.ipi_task_lock);
 
     // let CPUs know to begin executing
-    __UNUSED zx_status_t status = arch_mp_send_ipi(MP_IPI_TARGET_MASK, mask, MP_IPI_GENERIC);
-    DEBUG_ASSERT(status == ZX_OK);
+    mp_send_ipi(MP_IPI_TARGET_MASK, mask, MP_IPI_GENERIC);
 
     if (targetting_self) {
         bool previous_blocking_disallowed = arch_blocking_disallowed();
@@ -194,11 +273,12 @@ void mp_sync_exec(mp_ipi_target_t target, cpu_mask_t mask, mp_sync_task_t task,
         // tasks queued for us in order to prevent deadlock.
         if (ints_disabled) {
             // Optimistically check if our task list has work without the lock.
-            // mp_mbx_generic_irq will take the lock and check again.
+            // mp_run_ipi_tasks will take the lock and check again. The
+            // pending bits are left to the ipi that is on its way.
             if (!list_is_empty(&mp.ipi_task_list[local_cpu])) {
                 bool previous_blocking_disallowed = arch_blocking_disallowed();
                 arch_set_blocking_disallowed(true);
-                mp_mbx_generic_irq(nullptr);
+                mp_run_ipi_tasks(local_cpu);
                 arch_set_blocking_disallowed(previous_blocking_disallowed);
                 continue;
             }
@@ -391,16 +471,13 @@ cleanup_mutex:
     return status;
 }
 
-void mp_mbx_generic_irq(void*) {
+static void mp_run_ipi_tasks(cpu_num_t cpu) {
     DEBUG_ASSERT(arch_ints_disabled());
-    const cpu_num_t local_cpu = arch_curr_cpu_num();
-
-    CPU_STATS_INC(generic_ipis);
 
     while (1) {
         struct mp_ipi_task* task;
         spin_lock(&mp.ipi_task_lock);
-        task = list_remove_head_type(&mp.ipi_task_list[local_cpu], struct mp_ipi_task, node);
+        task = list_remove_head_type(&mp.ipi_task_list[cpu], struct mp_ipi_task, node);
         spin_unlock(&mp.ipi_task_lock);
         if (task == NULL) {
             break;
@@ -410,16 +487,40 @@ void mp_mbx_generic_irq(void*) {
     }
 }
 
+// Does the work of every ipi coalesced into the one being handled. The bits
+// are cleared first, so that work asked for after this looks sends a new ipi.
+static void mp_handle_pending_ipis(cpu_num_t cpu, mp_ipi_t ipi) {
+    const int pending = atomic_swap(&mp.ipi_pending[cpu], 0) | (1 << ipi);
+
+    if (pending & (1 << MP_IPI_GENERIC)) {
+        CPU_STATS_INC(generic_ipis);
+    }
+    mp_run_ipi_tasks(cpu);
+
+    if (pending & (1 << MP_IPI_RESCHEDULE)) {
+        CPU_STATS_INC(reschedule_ipis);
+        if (mp.active_cpus & cpu_num_to_mask(cpu)) {
+            thread_preempt_set_pending();
+        }
+    }
+
+    // MP_IPI_INTERRUPT needs nothing more; the entire point of it is to
+    // simply have an interrupt delivered to the cpu.
+}
+
+void mp_mbx_generic_irq(void*) {
+    DEBUG_ASSERT(arch_ints_disabled());
+    const cpu_num_t local_cpu = arch_curr_cpu_num();
+
+    mp_handle_pending_ipis(local_cpu, MP_IPI_GENERIC);
+}
+
 void mp_mbx_reschedule_irq(void*) {
     const cpu_num_t cpu = arch_curr_cpu_num();
 
     LTRACEF("cpu %u\n", cpu);
 
-    CPU_STATS_INC(reschedule_ipis);
-
-    if (mp.active_cpus & cpu_num_to_mask(cpu)) {
-        thread_preempt_set_pending();
-    }
+    mp_handle_pending_ipis(cpu, MP_IPI_RESCHEDULE);
 }
 
 void mp_mbx_interrupt_irq(void*) {
@@ -427,8 +528,7 @@ void mp_mbx_interrupt_irq(void*) {
 
     LTRACEF("cpu %u\n", cpu);
 
-    // do nothing, the entire point of this interrupt is to simply have one
-    // delivered to the cpu.
+    mp_handle_pending_ipis(cpu, MP_IPI_INTERRUPT);
 }
 
 __WEAK zx_status_t arch_mp_cpu_hotplug(uint cpu_id) {
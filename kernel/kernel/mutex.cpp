@@ -16,6 +16,7 @@
 
 #include <kernel/mutex.h>
 
+#include <arch/ops.h>
 #include <assert.h>
 #include <debug.h>
 #include <err.h>
@@ -23,12 +24,22 @@
 #include <kernel/sched.h>
 #include <kernel/thread.h>
 #include <kernel/thread_lock.h>
+#include <lib/counters.h>
 #include <lib/ktrace.h>
+#include <platform.h>
 #include <trace.h>
 #include <zircon/types.h>
 
 #define LOCAL_TRACE 0
 
+// how long a contending thread spins on a held mutex before giving up and
+// blocking, and how many spins it makes between looks at the clock
+#define MUTEX_SPIN_MAX_TIME ZX_USEC(10)
+#define MUTEX_SPIN_TIME_CHECK_INTERVAL 64
+
+KCOUNTER(mutex_spin_success_count, "kernel.mutex.spin_success");
+KCOUNTER(mutex_spin_fail_count, "kernel.mutex.spin_fail");
+
 /**
  * @brief  Initialize a mutex_t
  */
@@ -60,6 +71,43 @@ void mutex_destroy(mutex_t* m) {
     wait_queue_destroy(&m->wait);
 }
 
+// Spin waiting for the mutex to be released, for no more than
+// MUTEX_SPIN_MAX_TIME. A holder is likely to release the mutex soon, and
+// picking it up here is much cheaper than blocking and being woken up again.
+// Only the mutex word is read, so nothing about the holder is looked at
+// without the thread lock.
+//
+// Returns true if the mutex was acquired, false if the caller should block.
+static bool mutex_spin(mutex_t* m, thread_t* ct) {
+    zx_time_t deadline = current_time() + MUTEX_SPIN_MAX_TIME;
+
+    for (uint32_t spins = 1;; spins++) {
+        uintptr_t val = mutex_val(m);
+        if (val == 0) {
+            if (atomic_cmpxchg_u64(&m->val, &val, (uintptr_t)ct)) {
+                kcounter_add(mutex_spin_success_count, 1);
+                return true;
+            }
+            continue;
+        }
+
+        // once there are waiters the mutex is handed directly to one of them
+        // on release, so it will never be seen unheld here
+        if (val & MUTEX_FLAG_QUEUED) {
+            break;
+        }
+
+        if (spins % MUTEX_SPIN_TIME_CHECK_INTERVAL == 0 && current_time() >= deadline) {
+            break;
+        }
+
+        arch_spinloop_pause();
+    }
+
+    kcounter_add(mutex_spin_fail_count, 1);
+    return false;
+}
+
 /**
  * @brief  Acquire the mutex
  */
@@ -85,6 +133,12 @@ retry:
               ct, ct->name, m);
 #endif
 
+    if (mutex_spin(m, ct)) {
+        lockdep_note_contention();
+        ct->mutexes_held++;
+        return;
+    }
+
     {
         // we contended with someone else, will probably need to block
         Guard<spin_lock_t, IrqSave> guard{ThreadLock::Get()};
@@ -118,6 +172,10 @@ retry:
         // someone must have woken us up, we should own the mutex now
         DEBUG_ASSERT(ct == mutex_holder(m));
 
+        // charge the wait to the lock being acquired, after the thread lock
+        // guard above has finished its own accounting
+        lockdep_note_contention();
+
         // record that we hold it
         ct->mutexes_held++;
     }
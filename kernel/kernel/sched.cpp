@@ -9,12 +9,16 @@
 #include <assert.h>
 #include <debug.h>
 #include <err.h>
+#include <arch/mp.h>
 #include <inttypes.h>
 #include <kernel/mp.h>
 #include <kernel/percpu.h>
 #include <kernel/thread.h>
+#include <kernel/thread_lock.h>
+#include <lib/counters.h>
 #include <lib/ktrace.h>
 #include <list.h>
+#include <object/c_user_thread.h>
 #include <platform.h>
 #include <printf.h>
 #include <string.h>
@@ -53,6 +57,20 @@
 // threads get 10ms to run before they use up their time slice and the scheduler is invoked
 #define THREAD_INITIAL_TIME_SLICE ZX_MSEC(10)
 
+// bounds on the weight scaled quantum of fair class threads
+#define FAIR_MIN_TIME_SLICE ZX_USEC(500)
+#define FAIR_MAX_TIME_SLICE ZX_MSEC(100)
+
+// runtime a user thread accumulates before it is charged to its task counters.
+// threads in jobs with a cpu bandwidth limit are also charged this often while
+// they run, which bounds how far they can overrun a quota.
+#define USAGE_CHARGE_INTERVAL ZX_MSEC(1)
+
+KCOUNTER(sched_steal_count, "kernel.sched.steal");
+KCOUNTER(sched_llc_wakeup_count, "kernel.sched.wakeup_llc");
+KCOUNTER(sched_preempt_deferred_count, "kernel.sched.preempt_deferred");
+KCOUNTER(sched_cpu_throttled_count, "kernel.sched.cpu_throttled");
+
 static bool local_migrate_if_needed(thread_t* curr_thread);
 
 // compute the effective priority of a thread
@@ -73,7 +91,7 @@ static void boost_thread(thread_t* t) {
         return;
     }
 
-    if (unlikely(thread_is_real_time_or_idle(t))) {
+    if (unlikely(thread_is_real_time_or_idle(t) || thread_is_fair(t))) {
         return;
     }
 
@@ -92,7 +110,7 @@ static void deboost_thread(thread_t* t, bool quantum_expiration) {
         return;
     }
 
-    if (unlikely(thread_is_real_time_or_idle(t))) {
+    if (unlikely(thread_is_real_time_or_idle(t) || thread_is_fair(t))) {
         return;
     }
 
@@ -121,6 +139,79 @@ static void deboost_thread(thread_t* t, bool quantum_expiration) {
     compute_effec_priority(t);
 }
 
+// the quantum a thread receives when its time slice is refilled
+static zx_duration_t thread_quantum(const thread_t* t) {
+    if (likely(t->sched_class != THREAD_SCHED_CLASS_FAIR)) {
+        return THREAD_INITIAL_TIME_SLICE;
+    }
+
+    // fair threads get a quantum proportional to their weight, capped by their deadline
+    zx_duration_t slice = THREAD_INITIAL_TIME_SLICE * t->fair_weight / THREAD_FAIR_WEIGHT_DEFAULT;
+    if (t->fair_deadline > 0 && t->fair_deadline < slice) {
+        slice = t->fair_deadline;
+    }
+    return MAX(FAIR_MIN_TIME_SLICE, MIN(slice, FAIR_MAX_TIME_SLICE));
+}
+
+// convert real run time into virtual time for a fair thread
+static zx_duration_t fair_scale(const thread_t* t, zx_duration_t runtime) {
+    return runtime * THREAD_FAIR_WEIGHT_DEFAULT / t->fair_weight;
+}
+
+// add |runtime| to the usage of a user thread that has not been charged to
+// its process and jobs yet, and charge it once it amounts to
+// USAGE_CHARGE_INTERVAL, so the shared task counters are touched about once a
+// millisecond. returns the time until which a job above the thread is out of
+// cpu quota, or 0 if none is.
+static zx_time_t charge_user_thread(thread_t* t, zx_duration_t runtime, uint32_t switches,
+                                    zx_time_t now) {
+    t->uncharged_runtime = zx_duration_add_duration(t->uncharged_runtime, runtime);
+    t->uncharged_switches += switches;
+    if (t->uncharged_runtime < USAGE_CHARGE_INTERVAL) {
+        return 0;
+    }
+
+    zx_time_t resume = user_thread_charge_usage(t->user_thread, t->uncharged_runtime,
+                                                t->uncharged_switches, 0);
+    t->uncharged_runtime = 0;
+    t->uncharged_switches = 0;
+    t->cpu_limited = (resume != 0);
+    return resume > now ? resume : 0;
+}
+
+// make a thread whose job is out of cpu quota sleep until |until| before it
+// next returns to user mode
+static void throttle_thread(thread_t* t, zx_time_t until) TA_REQ(thread_lock) {
+    t->throttled_until = until;
+    t->signals |= THREAD_SIGNAL_THROTTLE;
+    kcounter_add(sched_cpu_throttled_count, 1);
+}
+
+// charge the current thread for its run so far, from the preemption timer
+static void charge_running_thread(thread_t* t, zx_time_t now) {
+    if (!t->user_thread) {
+        return;
+    }
+
+    zx_duration_t ran = zx_duration_sub_duration(
+        zx_time_sub_time(now, t->last_started_running), t->running_charged);
+    t->running_charged = zx_duration_add_duration(t->running_charged, ran);
+    zx_time_t until = charge_user_thread(t, ran, 0, now);
+    if (until) {
+        Guard<spin_lock_t, NoIrqSave> guard{ThreadLock::Get()};
+        throttle_thread(t, until);
+    }
+}
+
+// the preemption timer deadline for a thread, which fires at least every
+// USAGE_CHARGE_INTERVAL for cpu limited threads so that they get charged
+static zx_time_t preempt_deadline(const thread_t* t, zx_time_t now, zx_time_t deadline) {
+    if (t->cpu_limited) {
+        return MIN(deadline, zx_time_add_duration(now, USAGE_CHARGE_INTERVAL));
+    }
+    return deadline;
+}
+
 // pick a 'random' cpu out of the passed in mask of cpus
 static cpu_mask_t rand_cpu(cpu_mask_t mask) {
     if (unlikely(mask == 0)) {
@@ -137,19 +228,51 @@ static cpu_mask_t rand_cpu(cpu_mask_t mask) {
     // compute the highest cpu in the mask
     cpu_num_t highest_cpu = highest_cpu_set(mask);
 
-    // not very random, round robins a bit through the mask until it gets a hit
+    // not very random, round robins a bit through the mask until it gets a hit.
+    // the rotor is per cpu and only touched with interrupts disabled, so it is
+    // safe to use non atomically.
+    uint32_t* rot = &get_local_percpu()->sched_rotor;
     for (;;) {
-        // protected by THREAD_LOCK, safe to use non atomically
-        static uint rot = 0;
+        if (++*rot > highest_cpu) {
+            *rot = 0;
+        }
 
-        if (++rot > highest_cpu) {
-            rot = 0;
+        if ((1u << *rot) & mask) {
+            return (1u << *rot);
         }
+    }
+}
+
+// out of a mask of idle cpus, pick one close to |near| in the cache hierarchy.
+// prefer cpus sharing its last level cache, and within any set prefer cpus
+// whose smt siblings are idle too, so the thread gets a whole core.
+static cpu_mask_t pick_idle_cpu(cpu_mask_t idle_cpu_mask, cpu_num_t near) TA_REQ(thread_lock) {
+    cpu_mask_t cache_mask = is_valid_cpu_num(near) ? mp_get_cache_mask(near) : CPU_MASK_ALL;
 
-        if ((1u << rot) & mask) {
-            return (1u << rot);
+    cpu_mask_t candidates[2] = {idle_cpu_mask & cache_mask, idle_cpu_mask};
+    for (cpu_mask_t candidate : candidates) {
+        if (candidate == 0) {
+            continue;
+        }
+
+        // look for a cpu whose whole core is idle
+        cpu_mask_t whole_core = 0;
+        for (cpu_mask_t m = candidate; m != 0; m &= m - 1) {
+            cpu_num_t cpu = lowest_cpu_set(m);
+            if ((mp_get_smt_mask(cpu) & idle_cpu_mask) == mp_get_smt_mask(cpu)) {
+                whole_core |= cpu_num_to_mask(cpu);
+            }
+        }
+
+        cpu_mask_t pick = rand_cpu(whole_core ? whole_core : candidate);
+        if (pick != 0) {
+            if (pick & cache_mask) {
+                kcounter_add(sched_llc_wakeup_count, 1);
+            }
+            return pick;
         }
     }
+    return 0;
 }
 
 // find a cpu to wake up
@@ -182,8 +305,14 @@ static cpu_mask_t find_cpu_mask(thread_t* t) TA_REQ(thread_lock) {
             return last_ran_cpu_mask;
         }
 
-        // pick an idle_cpu
+        // pick an idle cpu, as close as possible to where the thread last ran so
+        // it finds its working set in a warm cache
         DEBUG_ASSERT((idle_cpu_mask & mp_get_active_mask()) == idle_cpu_mask);
+        cpu_num_t near = is_valid_cpu_num(t->last_cpu) ? t->last_cpu : arch_curr_cpu_num();
+        cpu_mask_t mask = pick_idle_cpu(idle_cpu_mask, near);
+        if (mask != 0) {
+            return mask;
+        }
         return rand_cpu(idle_cpu_mask);
     }
 
@@ -212,25 +341,69 @@ static cpu_mask_t find_cpu_mask(thread_t* t) TA_REQ(thread_lock) {
     return mask;
 }
 
-// run queue manipulation
-static void insert_in_run_queue_head(cpu_num_t cpu, thread_t* t) TA_REQ(thread_lock) {
-    DEBUG_ASSERT(!list_in_list(&t->queue_node));
+// insert a fair class thread into its queue ordered by virtual finish time.
+// a fair thread is only ordered against the fair threads queued after the last
+// priority class thread in the queue and never overtakes a priority class thread,
+// so within a queue the two classes are served in arrival order and neither can
+// starve the other.
+static void fair_insert(struct percpu* c, thread_t* t) TA_REQ(thread_lock) {
+    // a thread that was blocked or queued elsewhere does not get to bank virtual time
+    if (t->fair_vstart < c->fair_vtime) {
+        t->fair_vstart = c->fair_vtime;
+    }
 
-    list_add_head(&percpu[cpu].run_queue[t->effec_priority], &t->queue_node);
-    percpu[cpu].run_queue_bitmap |= (1u << t->effec_priority);
+    zx_duration_t span = t->fair_deadline > 0 ? t->fair_deadline : thread_quantum(t);
+    t->fair_vfinish = t->fair_vstart + fair_scale(t, span);
 
-    // mark the cpu as busy since the run queue now has at least one item in it
-    mp_set_cpu_busy(cpu);
+    struct list_node* queue = &c->run_queue[t->effec_priority];
+    struct list_node* pos = queue->prev;
+    while (pos != queue) {
+        thread_t* entry = containerof(pos, thread_t, queue_node);
+        if (!thread_is_fair(entry) || entry->fair_vfinish <= t->fair_vfinish) {
+            break;
+        }
+        pos = pos->prev;
+    }
+    list_add_after(pos, &t->queue_node);
 }
 
-static void insert_in_run_queue_tail(cpu_num_t cpu, thread_t* t) TA_REQ(thread_lock) {
+// run queue manipulation
+static void insert_in_run_queue(cpu_num_t cpu, thread_t* t, bool head) TA_REQ(thread_lock) {
     DEBUG_ASSERT(!list_in_list(&t->queue_node));
 
-    list_add_tail(&percpu[cpu].run_queue[t->effec_priority], &t->queue_node);
-    percpu[cpu].run_queue_bitmap |= (1u << t->effec_priority);
+    struct percpu* c = &percpu[cpu];
+    if (thread_is_fair(t)) {
+        fair_insert(c, t);
+    } else if (head) {
+        list_add_head(&c->run_queue[t->effec_priority], &t->queue_node);
+    } else {
+        list_add_tail(&c->run_queue[t->effec_priority], &t->queue_node);
+    }
+    c->run_queue_bitmap |= (1u << t->effec_priority);
+    c->run_queue_len++;
+    bool preempt_deferred = c->preempt_deferred;
+    c->preempt_deferred = false;
 
     // mark the cpu as busy since the run queue now has at least one item in it
     mp_set_cpu_busy(cpu);
+
+    // the thread running on |cpu| is past the end of its time slice and only kept
+    // the cpu because nothing else was queued, so take the deferred preemption now
+    if (unlikely(preempt_deferred) && t != get_current_thread()) {
+        if (cpu == arch_curr_cpu_num()) {
+            timer_preempt_reset(current_time());
+        } else {
+            mp_reschedule(cpu_num_to_mask(cpu), 0);
+        }
+    }
+}
+
+static void insert_in_run_queue_head(cpu_num_t cpu, thread_t* t) TA_REQ(thread_lock) {
+    insert_in_run_queue(cpu, t, true);
+}
+
+static void insert_in_run_queue_tail(cpu_num_t cpu, thread_t* t) TA_REQ(thread_lock) {
+    insert_in_run_queue(cpu, t, false);
 }
 
 // remove the thread from the run queue it's in
@@ -242,6 +415,7 @@ static void remove_from_run_queue(thread_t* t, int prio_queue) TA_REQ(thread_loc
 
     // clear the old cpu's queue bitmap if that was the last entry
     struct percpu* c = &percpu[t->curr_cpu];
+    c->run_queue_len--;
     if (list_is_empty(&c->run_queue[prio_queue])) {
         c->run_queue_bitmap &= ~(1u << prio_queue);
     }
@@ -262,6 +436,7 @@ static thread_t* sched_get_top_thread(cpu_num_t cpu) TA_REQ(thread_lock) {
         uint highest_queue = highest_run_queue(c);
 
         thread_t* newthread = list_remove_head_type(&c->run_queue[highest_queue], thread_t, queue_node);
+        c->run_queue_len--;
 
         DEBUG_ASSERT(newthread);
         DEBUG_ASSERT_MSG(newthread->cpu_affinity & cpu_num_to_mask(cpu),
@@ -273,6 +448,11 @@ static thread_t* sched_get_top_thread(cpu_num_t cpu) TA_REQ(thread_lock) {
             c->run_queue_bitmap &= ~(1u << highest_queue);
         }
 
+        // the cpu's fair clock follows the earliest virtual start it has run
+        if (thread_is_fair(newthread) && newthread->fair_vstart > c->fair_vtime) {
+            c->fair_vtime = newthread->fair_vstart;
+        }
+
         LOCAL_KTRACE2("sched_get_top", newthread->priority_boost, newthread->base_priority);
 
         return newthread;
@@ -282,10 +462,77 @@ static thread_t* sched_get_top_thread(cpu_num_t cpu) TA_REQ(thread_lock) {
     return &c->idle_thread;
 }
 
+// pull the highest priority thread that is allowed to run on |cpu| out of the
+// run queue of |victim|, or return NULL if there is none.
+static thread_t* steal_from_cpu(cpu_num_t cpu, cpu_num_t victim) TA_REQ(thread_lock) {
+    struct percpu* c = &percpu[victim];
+    const cpu_mask_t cpu_mask = cpu_num_to_mask(cpu);
+
+    for (uint32_t bitmap = c->run_queue_bitmap; bitmap != 0;) {
+        uint queue = (sizeof(bitmap) * CHAR_BIT - 1) - __builtin_clz(bitmap);
+        bitmap &= ~(1u << queue);
+
+        thread_t* t;
+        list_for_every_entry (&c->run_queue[queue], t, thread_t, queue_node) {
+            if (thread_is_idle(t) || !(t->cpu_affinity & cpu_mask)) {
+                continue;
+            }
+
+            list_delete(&t->queue_node);
+            c->run_queue_len--;
+            if (list_is_empty(&c->run_queue[queue])) {
+                c->run_queue_bitmap &= ~(1u << queue);
+            }
+
+            t->curr_cpu = cpu;
+            return t;
+        }
+    }
+    return NULL;
+}
+
+// called when |cpu| is about to go idle: take work from the busiest cpu that
+// shares a last level cache with it, so the stolen thread stays cache warm.
+static thread_t* sched_steal_thread(cpu_num_t cpu) TA_REQ(thread_lock) {
+    cpu_mask_t domain = mp_get_cache_mask(cpu) & mp_get_active_mask() &
+                        ~mp_get_idle_mask() & ~cpu_num_to_mask(cpu);
+
+    // realtime cpus only ever have work pinned to them in the common case, leave them be
+    domain &= ~mp_get_realtime_mask();
+
+    cpu_num_t victim = INVALID_CPU;
+    uint32_t victim_len = 0;
+    for (cpu_mask_t m = domain; m != 0; m &= m - 1) {
+        cpu_num_t i = lowest_cpu_set(m);
+        uint32_t len = percpu[i].run_queue_len;
+        if (len > victim_len) {
+            victim = i;
+            victim_len = len;
+        }
+    }
+
+    if (victim == INVALID_CPU) {
+        return NULL;
+    }
+
+    thread_t* t = steal_from_cpu(cpu, victim);
+    if (t) {
+        kcounter_add(sched_steal_count, 1);
+        LOCAL_KTRACE2("sched_steal", (uint32_t)t->user_tid, victim);
+    }
+    return t;
+}
+
 void sched_init_thread(thread_t* t, int priority) {
     t->base_priority = priority;
     t->priority_boost = 0;
     t->inherited_priority = -1;
+    t->sched_class = THREAD_SCHED_CLASS_PRIORITY;
+    t->fair_weight = THREAD_FAIR_WEIGHT_DEFAULT;
+    t->fair_deadline = 0;
+    t->fair_vstart = 0;
+    t->fair_vfinish = 0;
+    t->perf_hint = THREAD_PERF_HINT_NONE;
     compute_effec_priority(t);
 }
 
@@ -731,6 +978,59 @@ void sched_change_priority(thread_t* t, int pri) {
     }
 }
 
+void sched_set_fair_params(thread_t* t, uint32_t weight, zx_duration_t deadline) {
+    DEBUG_ASSERT(spin_lock_held(&thread_lock));
+
+    if (unlikely(t->state == THREAD_DEATH || thread_is_real_time_or_idle(t))) {
+        return;
+    }
+
+    // a ready thread has to be pulled out of its queue while its ordering key changes
+    bool requeue = (t->state == THREAD_READY);
+    if (requeue) {
+        DEBUG_ASSERT_MSG(list_in_list(&t->queue_node), "thread %p name %s curr_cpu %u\n", t, t->name, t->curr_cpu);
+        remove_from_run_queue(t, t->effec_priority);
+    }
+
+    if (weight == 0) {
+        t->sched_class = THREAD_SCHED_CLASS_PRIORITY;
+        t->fair_weight = THREAD_FAIR_WEIGHT_DEFAULT;
+        t->fair_deadline = 0;
+    } else {
+        t->sched_class = THREAD_SCHED_CLASS_FAIR;
+        t->fair_weight = MAX(THREAD_FAIR_WEIGHT_MIN, MIN(weight, THREAD_FAIR_WEIGHT_MAX));
+        t->fair_deadline = deadline;
+
+        // drop any boost collected in the priority class
+        t->priority_boost = 0;
+    }
+    int old_ep = t->effec_priority;
+    compute_effec_priority(t);
+
+    // start the new quantum from scratch so the new weight takes effect promptly
+    t->remaining_time_slice = MIN(t->remaining_time_slice, thread_quantum(t));
+
+    cpu_mask_t accum_cpu_mask = 0;
+    bool local_resched = false;
+    if (requeue) {
+        insert_in_run_queue_tail(t->curr_cpu, t);
+        if (t->curr_cpu == arch_curr_cpu_num()) {
+            local_resched = true;
+        } else {
+            accum_cpu_mask |= cpu_num_to_mask(t->curr_cpu);
+        }
+    } else if (old_ep != t->effec_priority) {
+        sched_priority_changed(t, old_ep, &local_resched, &accum_cpu_mask);
+    }
+
+    if (accum_cpu_mask) {
+        mp_reschedule(accum_cpu_mask, 0);
+    }
+    if (local_resched) {
+        sched_reschedule();
+    }
+}
+
 // preemption timer that is set whenever a thread is scheduled
 void sched_preempt_timer_tick(zx_time_t now) {
     // if the preemption timer went off on the idle or a real time thread, ignore it
@@ -745,12 +1045,30 @@ void sched_preempt_timer_tick(zx_time_t now) {
     // did this tick complete the time slice?
     DEBUG_ASSERT(now > current_thread->last_started_running);
     zx_duration_t delta = zx_time_sub_time(now, current_thread->last_started_running);
+    charge_running_thread(current_thread, now);
     if (delta >= current_thread->remaining_time_slice) {
         // we completed the time slice, do not restart it and let the scheduler run
         current_thread->remaining_time_slice = 0;
 
+        // if nothing else is queued on this cpu there is nobody to hand it to, so
+        // rather than ticking every time slice, leave the preemption timer off until
+        // a thread is queued here. see insert_in_run_queue(). cpu limited threads
+        // still need the ticks to be charged.
+        struct percpu* c = &percpu[arch_curr_cpu_num()];
+        bool deferred;
+        {
+            Guard<spin_lock_t, NoIrqSave> guard{ThreadLock::Get()};
+            c->preempt_deferred = (c->run_queue_len == 0) && !current_thread->cpu_limited;
+            deferred = c->preempt_deferred;
+        }
+        if (deferred) {
+            kcounter_add(sched_preempt_deferred_count, 1);
+            return;
+        }
+
         // set a timer to go off on the time slice interval from now
-        timer_preempt_reset(zx_time_add_duration(now, THREAD_INITIAL_TIME_SLICE));
+        timer_preempt_reset(preempt_deadline(
+            current_thread, now, zx_time_add_duration(now, THREAD_INITIAL_TIME_SLICE)));
 
         // Mark a reschedule as pending.  The irq handler will call back
         // into us with sched_preempt().
@@ -759,7 +1077,7 @@ void sched_preempt_timer_tick(zx_time_t now) {
         // the timer tick must have fired early, reschedule and continue
         zx_time_t deadline = zx_time_add_duration(current_thread->last_started_running,
                                                   current_thread->remaining_time_slice);
-        timer_preempt_reset(deadline);
+        timer_preempt_reset(preempt_deadline(current_thread, now, deadline));
     }
 }
 
@@ -790,6 +1108,14 @@ void sched_resched_internal() {
     // pick a new thread to run
     thread_t* newthread = sched_get_top_thread(cpu);
 
+    // rather than going idle, see if a neighbour has work queued up
+    if (thread_is_idle(newthread) && mp_is_cpu_active(cpu)) {
+        thread_t* stolen = sched_steal_thread(cpu);
+        if (stolen) {
+            newthread = stolen;
+        }
+    }
+
     DEBUG_ASSERT(newthread);
 
     newthread->state = THREAD_RUNNING;
@@ -815,12 +1141,34 @@ void sched_resched_internal() {
     DEBUG_ASSERT(now >= oldthread->last_started_running);
     zx_duration_t old_runtime = zx_time_sub_time(now, oldthread->last_started_running);
     oldthread->runtime_ns = zx_duration_add_duration(oldthread->runtime_ns, old_runtime);
+
+    // charge user threads to their process and jobs, minus what the preemption
+    // timer already charged during this run. the final slice of an exiting
+    // thread was charged by thread_exit.
+    if (oldthread->user_thread && oldthread->state != THREAD_DEATH) {
+        zx_time_t until = charge_user_thread(
+            oldthread, zx_duration_sub_duration(old_runtime, oldthread->running_charged), 1, now);
+        if (until) {
+            throttle_thread(oldthread, until);
+        }
+    }
+    oldthread->running_charged = 0;
     oldthread->remaining_time_slice = zx_duration_sub_duration(
         oldthread->remaining_time_slice, MIN(old_runtime, oldthread->remaining_time_slice));
 
+    // charge virtual time to a fair thread. if it was already put back in a run
+    // queue its position depends on the charge, so requeue it.
+    if (thread_is_fair(oldthread)) {
+        oldthread->fair_vstart += fair_scale(oldthread, old_runtime);
+        if (oldthread->state == THREAD_READY) {
+            remove_from_run_queue(oldthread, oldthread->effec_priority);
+            insert_in_run_queue_tail(oldthread->curr_cpu, oldthread);
+        }
+    }
+
     // set up quantum for the new thread if it was consumed
     if (newthread->remaining_time_slice == 0) {
-        newthread->remaining_time_slice = THREAD_INITIAL_TIME_SLICE;
+        newthread->remaining_time_slice = thread_quantum(newthread);
     }
 
     newthread->last_started_running = now;
@@ -832,6 +1180,9 @@ void sched_resched_internal() {
     newthread->last_cpu = cpu;
     newthread->curr_cpu = cpu;
 
+    // the preemption timer is set up for the new thread below, or not needed
+    percpu[cpu].preempt_deferred = false;
+
     // if we selected the idle thread the cpu's run queue must be empty, so mark the
     // cpu as idle
     if (thread_is_idle(newthread)) {
@@ -844,6 +1195,12 @@ void sched_resched_internal() {
         mp_set_cpu_non_realtime(cpu);
     }
 
+    // the idle thread keeps whatever hint the cpu was last given, rather than
+    // reprogramming it on every trip through idle
+    if (!thread_is_idle(newthread)) {
+        arch_set_current_cpu_perf_hint(newthread->perf_hint, now);
+    }
+
     CPU_STATS_INC(context_switches);
 
     if (thread_is_idle(oldthread)) {
@@ -875,7 +1232,8 @@ void sched_resched_internal() {
         // make sure the time slice is reasonable
         DEBUG_ASSERT(newthread->remaining_time_slice > 0 && newthread->remaining_time_slice < ZX_SEC(1));
 
-        timer_preempt_reset(zx_time_add_duration(now, newthread->remaining_time_slice));
+        timer_preempt_reset(preempt_deadline(
+            newthread, now, zx_time_add_duration(now, newthread->remaining_time_slice)));
     }
 
     // set some optional target debug leds
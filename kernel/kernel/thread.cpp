@@ -28,6 +28,7 @@
 #include <kernel/mp.h>
 #include <kernel/percpu.h>
 #include <kernel/sched.h>
+#include <kernel/spinlock.h>
 #include <kernel/stats.h>
 #include <kernel/thread.h>
 #include <kernel/thread_lock.h>
@@ -64,6 +65,29 @@ KCOUNTER(thread_join_count, "kernel.thread.join");
 KCOUNTER(thread_suspend_count, "kernel.thread.suspend");
 // counts the number of calls to resume() that succeeded.
 KCOUNTER(thread_resume_count, "kernel.thread.resume");
+// counts the number of thread_t allocations served from, or missing, the
+// per-cpu cache of thread_t structures.
+KCOUNTER(thread_cache_hit, "kernel.thread.cache.hit");
+KCOUNTER(thread_cache_miss, "kernel.thread.cache.miss");
+// the number of thread_t structures held by the caches. Goes down as well.
+KCOUNTER(thread_cache_held, "kernel.thread.cache.held");
+
+// thread_t structures that thread_create_etc() allocated are kept in a small
+// per-cpu cache when their thread is freed, to save the heap round trip for
+// threads that are created and exit in quick succession.
+namespace {
+
+constexpr size_t kThreadCacheMax = 4;
+
+struct ThreadCache {
+    DECLARE_SPINLOCK(ThreadCache) lock;
+    thread_t* threads[kThreadCacheMax] TA_GUARDED(lock) = {};
+    size_t count TA_GUARDED(lock) = 0;
+} __CPU_ALIGN;
+
+ThreadCache thread_cache[SMP_MAX_CPUS];
+
+} // namespace
 
 // global thread list
 static struct list_node thread_list = LIST_INITIAL_VALUE(thread_list);
@@ -90,6 +114,54 @@ static void init_thread_struct(thread_t* t, const char* name) {
     init_thread_lock_state(t);
 }
 
+// Pop a thread_t off the current cpu's cache, or allocate one from the heap.
+static thread_t* alloc_thread_struct() {
+    thread_t* t = nullptr;
+
+    spin_lock_saved_state_t irqstate;
+    arch_interrupt_save(&irqstate, SPIN_LOCK_FLAG_INTERRUPTS);
+    {
+        ThreadCache& cache = thread_cache[arch_curr_cpu_num()];
+        Guard<SpinLock, NoIrqSave> guard{&cache.lock};
+        if (cache.count > 0) {
+            t = cache.threads[--cache.count];
+        }
+    }
+    arch_interrupt_restore(irqstate, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    if (t) {
+        kcounter_add(thread_cache_hit, 1);
+        kcounter_add(thread_cache_held, -1);
+        return t;
+    }
+    kcounter_add(thread_cache_miss, 1);
+    return static_cast<thread_t*>(malloc(sizeof(thread_t)));
+}
+
+// Push a thread_t onto the current cpu's cache, or free it if the cache is full.
+// init_thread_struct() clears the structure when it is reused.
+static void free_thread_struct(thread_t* t) {
+    bool cached = false;
+
+    spin_lock_saved_state_t irqstate;
+    arch_interrupt_save(&irqstate, SPIN_LOCK_FLAG_INTERRUPTS);
+    {
+        ThreadCache& cache = thread_cache[arch_curr_cpu_num()];
+        Guard<SpinLock, NoIrqSave> guard{&cache.lock};
+        if (cache.count < kThreadCacheMax) {
+            cache.threads[cache.count++] = t;
+            cached = true;
+        }
+    }
+    arch_interrupt_restore(irqstate, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    if (cached) {
+        kcounter_add(thread_cache_held, 1);
+    } else {
+        free(t);
+    }
+}
+
 static void initial_thread_func(void) TA_REQ(thread_lock) __NO_RETURN;
 static void initial_thread_func(void) {
     int ret;
@@ -154,7 +226,7 @@ thread_t* thread_create_etc(
     unsigned int flags = 0;
 
     if (!t) {
-        t = static_cast<thread_t*>(malloc(sizeof(thread_t)));
+        t = alloc_thread_struct();
         if (!t) {
             return NULL;
         }
@@ -182,7 +254,7 @@ thread_t* thread_create_etc(
     zx_status_t status = vm_allocate_kstack(&t->stack);
     if (status != ZX_OK) {
         if (flags & THREAD_FLAG_FREE_STRUCT) {
-            free(t);
+            free_thread_struct(t);
         }
         return nullptr;
     }
@@ -230,7 +302,7 @@ static void free_thread_resources(thread_t* t) {
     // free the thread structure itself
     t->magic = 0;
     if (t->flags & THREAD_FLAG_FREE_STRUCT) {
-        free(t);
+        free_thread_struct(t);
     }
 }
 
@@ -477,6 +549,19 @@ __NO_RETURN static void thread_exit_locked(thread_t* current_thread,
     // reusing the stack before the function exits
     dpc_t free_dpc = DPC_INITIAL_VALUE;
 
+    // charge what's left, including the slice running now; the scheduler
+    // skips dead threads when it charges at the final context switch
+    if (current_thread->user_thread) {
+        zx_duration_t recent = zx_duration_sub_duration(
+            zx_time_sub_time(current_time(), current_thread->last_started_running),
+            current_thread->running_charged);
+        user_thread_charge_usage(current_thread->user_thread,
+                                 zx_duration_add_duration(current_thread->uncharged_runtime,
+                                                          recent),
+                                 current_thread->uncharged_switches + 1,
+                                 current_thread->uncharged_page_faults);
+    }
+
     // enter the dead state
     current_thread->state = THREAD_DEATH;
     current_thread->retcode = retcode;
@@ -722,6 +807,18 @@ void thread_process_pending_signals(void) {
         return;
     }
 
+    // Hold the thread back while a job above it is out of cpu quota. The
+    // sleep is interruptible, so a kill or suspend is handled right away.
+    if (current_thread->signals & THREAD_SIGNAL_THROTTLE) {
+        current_thread->signals &= ~THREAD_SIGNAL_THROTTLE;
+        zx_time_t until = current_thread->throttled_until;
+        guard.Release();
+
+        thread_sleep_etc(until, true);
+        thread_process_pending_signals();
+        return;
+    }
+
     if (current_thread->signals & THREAD_SIGNAL_SUSPEND) {
         // transition the thread to the suspended state
         DEBUG_ASSERT(current_thread->state == THREAD_RUNNING);
@@ -1023,6 +1120,41 @@ void thread_set_priority(thread_t* t, int priority) {
     sched_change_priority(t, priority);
 }
 
+/**
+ * @brief  Change the scheduling class of a thread
+ *
+ * Places the thread in the weighted-fair scheduling class, or returns it to
+ * the priority class when |weight| is 0. The thread keeps its base priority.
+ *
+ * @param t         Thread to adjust
+ * @param weight    Relative share of the cpu, THREAD_FAIR_WEIGHT_DEFAULT is nominal
+ * @param deadline  Maximum scheduling latency relative to other fair threads, or 0
+ */
+void thread_set_fair_params(thread_t* t, uint32_t weight, zx_duration_t deadline) {
+    DEBUG_ASSERT(t->magic == THREAD_MAGIC);
+
+    Guard<spin_lock_t, IrqSave> guard{ThreadLock::Get()};
+
+    sched_set_fair_params(t, weight, deadline);
+}
+
+/**
+ * @brief  Change the performance hint of a thread
+ *
+ * Takes effect the next time the thread is switched in.
+ *
+ * @param t     Thread to adjust
+ * @param hint  One of THREAD_PERF_HINT_*
+ */
+void thread_set_perf_hint(thread_t* t, uint32_t hint) {
+    DEBUG_ASSERT(t->magic == THREAD_MAGIC);
+    DEBUG_ASSERT(hint < THREAD_PERF_HINT_COUNT);
+
+    Guard<spin_lock_t, IrqSave> guard{ThreadLock::Get()};
+
+    t->perf_hint = hint;
+}
+
 /**
  * @brief  Become an idle thread
  *
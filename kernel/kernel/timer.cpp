@@ -31,6 +31,7 @@
 #include <kernel/stats.h>
 #include <kernel/thread.h>
 #include <kernel/timer.h>
+#include <lib/counters.h>
 #include <list.h>
 #include <malloc.h>
 #include <platform.h>
@@ -48,6 +49,17 @@ DECLARE_SINGLETON_LOCK_WRAPPER(TimerLock, timer_lock);
 
 } // anonymous namespace
 
+// Timers that were given a slack adjustment to share another timer's deadline.
+KCOUNTER(timer_coalesced_count, "kernel.timer.coalesced");
+// Timers fired by an interrupt that was already taken for another event,
+// i.e. hardware interrupts saved.
+KCOUNTER(timer_batched_count, "kernel.timer.batched");
+// Of those, the timers that fired inside their slack window, before their
+// scheduled time.
+KCOUNTER(timer_fired_early_count, "kernel.timer.fired_early");
+// Platform timer interrupts dropped because only a canceled preemption timer wanted them.
+KCOUNTER(timer_preempt_stopped_count, "kernel.timer.preempt_stopped");
+
 void timer_init(timer_t* timer) {
     *timer = (timer_t)TIMER_INITIAL_VALUE(*timer);
 }
@@ -88,6 +100,16 @@ static void insert_timer_in_queue(uint cpu, timer_t* timer,
     //
     timer_t* entry;
 
+    // Timeouts are mostly armed in increasing deadline order, and then the
+    // walk below would skip every entry to append the timer.  Do that
+    // without the walk when it starts after the last timer.
+    entry = list_peek_tail_type(&percpu[cpu].timer_queue, timer_t, node);
+    if (entry == NULL || entry->scheduled_time < earliest_deadline) {
+        timer->slack = 0;
+        list_add_tail(&percpu[cpu].timer_queue, &timer->node);
+        return;
+    }
+
     list_for_every_entry (&percpu[cpu].timer_queue, entry, timer_t, node) {
         if (entry->scheduled_time > latest_deadline) {
             // New timer latest is earlier than the current timer.
@@ -109,6 +131,7 @@ static void insert_timer_in_queue(uint cpu, timer_t* timer,
             timer->slack = zx_time_sub_time(entry->scheduled_time, timer->scheduled_time);
             timer->scheduled_time = entry->scheduled_time;
             list_add_after(&entry->node, &timer->node);
+            kcounter_add(timer_coalesced_count, 1);
             return;
         }
 
@@ -172,6 +195,7 @@ static void insert_timer_in_queue(uint cpu, timer_t* timer,
         timer->slack = zx_time_sub_time(entry->scheduled_time, timer->scheduled_time);
         timer->scheduled_time = entry->scheduled_time;
         list_add_after(&entry->node, &timer->node);
+        kcounter_add(timer_coalesced_count, 1);
         return;
     }
 
@@ -235,6 +259,7 @@ void timer_set(timer_t* timer, zx_time_t deadline,
 
     // Set up the structure.
     timer->scheduled_time = deadline;
+    timer->earliest_time = earliest_deadline;
     timer->callback = callback;
     timer->arg = arg;
     timer->cancel = false;
@@ -267,12 +292,33 @@ void timer_preempt_cancel() {
 
     uint cpu = arch_curr_cpu_num();
 
+    zx_time_t old_deadline = percpu[cpu].preempt_timer_deadline;
     percpu[cpu].preempt_timer_deadline = ZX_TIME_INFINITE;
 
-    // Note, we're not updating the platform timer. It's entirely possible the timer queue is empty
-    // and the preemption timer is the only reason the platform timer is set. To know that, we'd
-    // need to acquire a lock and look at the queue. Rather than pay that cost, leave the platform
-    // timer as is and expect the recipient to handle spurious wakeups.
+    // If the platform timer is set for something sooner than the preemption timer, it is not
+    // ours to change. Otherwise it is only set for the preemption timer, and would wake the cpu
+    // (most likely going idle) for nothing, so move it out to the head of the timer queue. That
+    // costs a trip through the timer lock, so it is skipped in the common case above.
+    if (old_deadline == ZX_TIME_INFINITE || percpu[cpu].next_timer_deadline < old_deadline) {
+        return;
+    }
+
+    Guard<spin_lock_t, NoIrqSave> guard{TimerLock::Get()};
+    timer_t* t = list_peek_head_type(&percpu[cpu].timer_queue, timer_t, node);
+    zx_time_t deadline = t ? t->scheduled_time : ZX_TIME_INFINITE;
+    guard.Release();
+
+    if (deadline == percpu[cpu].next_timer_deadline) {
+        return;
+    }
+
+    kcounter_add(timer_preempt_stopped_count, 1);
+    percpu[cpu].next_timer_deadline = ZX_TIME_INFINITE;
+    if (deadline == ZX_TIME_INFINITE) {
+        platform_stop_timer();
+    } else {
+        update_platform_timer(cpu, deadline);
+    }
 }
 
 bool timer_cancel(timer_t* timer) {
@@ -365,6 +411,7 @@ void timer_tick(zx_time_t now) {
 
     Guard<spin_lock_t, NoIrqSave> guard{TimerLock::Get()};
 
+    bool fired = false;
     for (;;) {
         // see if there's an event to process
         timer = list_peek_head_type(&percpu[cpu].timer_queue, timer_t, node);
@@ -373,9 +420,18 @@ void timer_tick(zx_time_t now) {
         }
         LTRACEF("next item on timer queue %p at %" PRIi64 " now %" PRIi64 " (%p, arg %p)\n",
                 timer, timer->scheduled_time, now, timer->callback, timer->arg);
-        if (likely(now < timer->scheduled_time)) {
+        // A timer whose slack window has opened is fired with this interrupt
+        // rather than programming another one for its scheduled time.
+        if (likely(now < timer->earliest_time)) {
             break;
         }
+        if (now < timer->scheduled_time) {
+            kcounter_add(timer_fired_early_count, 1);
+            kcounter_add(timer_batched_count, 1);
+        } else if (fired) {
+            kcounter_add(timer_batched_count, 1);
+        }
+        fired = true;
 
         // process it
         LTRACEF("timer %p\n", timer);
@@ -414,6 +470,7 @@ void timer_tick(zx_time_t now) {
         deadline = timer->scheduled_time;
 
         // has to be the case or it would have fired already
+        DEBUG_ASSERT(timer->earliest_time > now);
         DEBUG_ASSERT(deadline > now);
     }
 
@@ -453,10 +510,10 @@ void timer_transition_off_cpu(uint old_cpu) {
     // Move all timers from old_cpu to this cpu
     list_for_every_entry_safe (&percpu[old_cpu].timer_queue, entry, tmp_entry, timer_t, node) {
         list_delete(&entry->node);
-        // We lost the original asymmetric slack information so when we combine them
-        // with the other timer queue they are not coalesced again.
-        // TODO(cpu): figure how important this case is.
-        insert_timer_in_queue(cpu, entry, entry->scheduled_time, entry->scheduled_time);
+        // We lost the end of the original slack window, but the timer may
+        // still coalesce with anything between its earliest time and the
+        // time it was already adjusted to.
+        insert_timer_in_queue(cpu, entry, entry->earliest_time, entry->scheduled_time);
     }
 
     timer_t* new_head = list_peek_head_type(&percpu[cpu].timer_queue, timer_t, node);
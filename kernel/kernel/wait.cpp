@@ -101,6 +101,19 @@ static void wait_queue_insert(wait_queue_t* wait, thread_t* t) {
     } else {
         int pri = t->effec_priority;
 
+        // check the lowest priority queue first, so that threads at or below
+        // every priority already queued don't walk the whole list
+        thread_t* tail = list_peek_tail_type(&wait->heads, thread_t, wait_queue_heads_node);
+        if (pri < tail->effec_priority) {
+            list_initialize(&t->queue_node);
+            list_add_tail(&wait->heads, &t->wait_queue_heads_node);
+            return;
+        } else if (pri == tail->effec_priority) {
+            list_add_tail(&tail->queue_node, &t->queue_node);
+            list_clear_node(&t->wait_queue_heads_node);
+            return;
+        }
+
         // walk through the sorted list of wait queue heads
         thread_t* temp;
         list_for_every_entry (&wait->heads, temp, thread_t, wait_queue_heads_node) {
@@ -397,22 +410,25 @@ int wait_queue_wake_all(wait_queue_t* wait, bool reschedule, zx_status_t wait_qu
 
     struct list_node list = LIST_INITIAL_VALUE(list);
 
-    // pop all the threads off the wait queue into the run queue
-    // TODO: optimize with custom pop all routine
-    while ((t = wait_queue_pop_head(wait))) {
-        wait->count--;
+    // move the threads onto a local list a whole priority at a time, highest
+    // priority first, rather than popping and re-heading them one by one
+    while ((t = list_remove_head_type(&wait->heads, thread_t, wait_queue_heads_node))) {
+        struct list_node* pos = list.prev;
+        list_splice_after(&t->queue_node, pos);
+        list_add_after(pos, &t->queue_node);
+    }
 
+    list_for_every_entry (&list, t, thread_t, queue_node) {
         DEBUG_ASSERT(t->state == THREAD_BLOCKED);
         t->blocked_status = wait_queue_error;
         t->blocking_wait_queue = NULL;
 
-        list_add_tail(&list, &t->queue_node);
-
         ret++;
     }
 
     DEBUG_ASSERT(ret > 0);
-    DEBUG_ASSERT(wait->count == 0);
+    DEBUG_ASSERT(ret == wait->count);
+    wait->count = 0;
 
     ktrace_ptr(TAG_KWAIT_WAKE, wait, 0, 0);
 
@@ -505,10 +521,25 @@ void wait_queue_priority_changed(struct thread* t, int old_prio) {
 
     LTRACEF("%p %d -> %d\n", t, old_prio, t->effec_priority);
 
-    // simple algorithm: remove the thread from the queue and add it back
-    // TODO: implement optimal algorithm depending on all the different edge
-    // cases of how the thread was previously queued and what priority its
-    // switching to.
+    if (t->effec_priority == old_prio) {
+        return;
+    }
+
+    // a thread which is alone at its priority can stay where it is, as long
+    // as the new priority still sits between those of its neighbours
+    wait_queue_t* wait = t->blocking_wait_queue;
+    if (list_in_list(&t->wait_queue_heads_node) && list_is_empty(&t->queue_node)) {
+        thread_t* prev = list_prev_type(&wait->heads, &t->wait_queue_heads_node,
+                                        thread_t, wait_queue_heads_node);
+        thread_t* next = list_next_type(&wait->heads, &t->wait_queue_heads_node,
+                                        thread_t, wait_queue_heads_node);
+        if ((!prev || prev->effec_priority > t->effec_priority) &&
+            (!next || next->effec_priority < t->effec_priority)) {
+            return;
+        }
+    }
+
+    // otherwise remove the thread from the queue and add it back
     wait_queue_remove_thread(t);
     wait_queue_insert(t->blocking_wait_queue, t);
 
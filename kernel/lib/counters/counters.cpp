@@ -6,6 +6,7 @@
 
 #include <lib/counters.h>
 
+#include <stdlib.h>
 #include <string.h>
 
 #include <arch/ops.h>
@@ -24,8 +25,22 @@
 
 #include <lib/console.h>
 
-// The arena is allocated in kernel.ld linker script.
+#include <vm/vm.h>
+#include <vm/vm_object_paged.h>
+
+#include <zircon/syscalls/kcounters.h>
+
+// The arena and the descriptor table in front of it are allocated in the
+// kernel.ld linker script, which hardcodes the sizes of the table entries.
 extern int64_t kcounters_arena[];
+extern uint8_t kcounters_table[];
+extern uint8_t kcounters_end[];
+
+static_assert(sizeof(zx_kcounters_header_t) == 64, "kernel.ld knows this size");
+static_assert(sizeof(zx_kcounter_desc_t) == 64, "kernel.ld knows this size");
+
+// The read-only view of the table and arena handed to userspace.
+static fbl::RefPtr<VmObject> counters_vmo;
 
 struct watched_counter_t {
     list_node node;
@@ -41,6 +56,13 @@ static size_t get_num_counters() {
     return kcountdesc_end - kcountdesc_begin;
 }
 
+// The distance, in slots, between the counters of consecutive cpus. Each
+// cpu's slots start on a page of their own so that they can be mapped by
+// userspace without sharing cache lines with other cpus.
+static size_t get_cpu_stride() {
+    return ROUNDUP(get_num_counters() * sizeof(int64_t), PAGE_SIZE) / sizeof(int64_t);
+}
+
 static bool prefix_match(const char *pre, const char *str) {
     return strncmp(pre, str, strlen(pre)) == 0;
 }
@@ -73,8 +95,41 @@ static const k_counter_desc* upper_bound(
 static void counters_init(unsigned level) {
     // Wire the memory defined in the .bss section to the counters.
     for (size_t ix = 0; ix != SMP_MAX_CPUS; ++ix) {
-        percpu[ix].counters = &kcounters_arena[ix * get_num_counters()];
+        percpu[ix].counters = &kcounters_arena[ix * get_cpu_stride()];
+    }
+}
+
+// Fills in the descriptor table and wraps it and the arena in a VMO. The
+// pages stay owned by the kernel image; the VMO only lends them out.
+static void counters_vmo_init(unsigned level) {
+    DEBUG_ASSERT(IS_PAGE_ALIGNED(kcounters_table));
+    DEBUG_ASSERT(IS_PAGE_ALIGNED(kcounters_arena));
+
+    const size_t num_counters = get_num_counters();
+    auto header = reinterpret_cast<zx_kcounters_header_t*>(kcounters_table);
+    auto descs = reinterpret_cast<zx_kcounter_desc_t*>(header + 1);
+
+    header->magic = ZX_KCOUNTERS_MAGIC;
+    header->num_counters = static_cast<uint32_t>(num_counters);
+    header->max_cpus = SMP_MAX_CPUS;
+    header->descriptor_offset = sizeof(*header);
+    header->data_offset = reinterpret_cast<uint8_t*>(kcounters_arena) - kcounters_table;
+    header->cpu_stride = get_cpu_stride() * sizeof(int64_t);
+    for (size_t ix = 0; ix != num_counters; ++ix) {
+        strlcpy(descs[ix].name, kcountdesc_begin[ix].name, sizeof(descs[ix].name));
     }
+
+    zx_status_t status = VmObjectPaged::CreateFromROData(
+        kcounters_table, kcounters_end - kcounters_table, &counters_vmo);
+    if (status != ZX_OK) {
+        printf("counters: failed to create vmo: %d\n", status);
+        return;
+    }
+    counters_vmo->set_name("kcounters", sizeof("kcounters"));
+}
+
+fbl::RefPtr<VmObject> kcounters_get_vmo() {
+    return counters_vmo;
 }
 
 static void dump_counter(const k_counter_desc* desc) {
@@ -236,6 +291,7 @@ static int cmd_counters(int argc, const cmd_args* argv, uint32_t flags) {
 }
 
 LK_INIT_HOOK(kcounters, counters_init, LK_INIT_LEVEL_PLATFORM_EARLY);
+LK_INIT_HOOK(kcounters_vmo, counters_vmo_init, LK_INIT_LEVEL_KERNEL);
 
 STATIC_COMMAND_START
 STATIC_COMMAND("counters", "view system counters", &cmd_counters)
@@ -6,11 +6,14 @@
 
 #include <lib/crypto/global_prng.h>
 
+#include <arch/defines.h>
+#include <arch/ops.h>
 #include <assert.h>
 #include <ctype.h>
 #include <err.h>
 #include <explicit-memory/bytes.h>
 #include <fbl/algorithm.h>
+#include <fbl/atomic.h>
 #include <kernel/auto_lock.h>
 #include <kernel/cmdline.h>
 #include <kernel/mutex.h>
@@ -38,6 +41,65 @@ PRNG* GetInstance() {
     return kGlobalPrng;
 }
 
+namespace {
+
+// A per-cpu PRNG is reseeded from the global PRNG after this many bytes
+// have been drawn from it.
+constexpr size_t kCpuReseedBytes = 64 * 1024;
+
+struct alignas(MAX_CACHE_LINE) CpuPRNG {
+    PRNG* prng() { return reinterpret_cast<PRNG*>(&prng_space); }
+
+    alignas(alignof(PRNG)) uint8_t prng_space[sizeof(PRNG)];
+
+    // Bytes drawn since the last reseed.
+    fbl::atomic<size_t> drawn;
+
+    // The value of |entropy_generation| at the last reseed.
+    fbl::atomic<uint64_t> generation;
+};
+
+CpuPRNG cpu_prngs[SMP_MAX_CPUS];
+fbl::atomic<bool> cpu_prngs_ready(false);
+
+// Incremented whenever entropy is added to the global PRNG, to tell the
+// per-cpu PRNGs to reseed.
+fbl::atomic<uint64_t> entropy_generation(0);
+
+void ReseedCpuPRNG(CpuPRNG* cpu, uint64_t generation) {
+    uint8_t seed[PRNG::kMinEntropy];
+    GetInstance()->Draw(seed, sizeof(seed));
+    cpu->prng()->AddEntropy(seed, sizeof(seed));
+    mandatory_memset(seed, 0, sizeof(seed));
+
+    cpu->drawn.store(0);
+    cpu->generation.store(generation);
+}
+
+} // namespace
+
+void Draw(void* out, size_t size) {
+    if (!cpu_prngs_ready.load()) {
+        GetInstance()->Draw(out, size);
+        return;
+    }
+
+    // Being migrated after picking an instance is harmless, since each
+    // instance is thread-safe; it just means sharing it with another cpu.
+    CpuPRNG* cpu = &cpu_prngs[arch_curr_cpu_num()];
+    uint64_t generation = entropy_generation.load();
+    if (cpu->drawn.fetch_add(size) + size > kCpuReseedBytes ||
+        cpu->generation.load() != generation) {
+        ReseedCpuPRNG(cpu, generation);
+    }
+    cpu->prng()->Draw(out, size);
+}
+
+void AddEntropy(const void* data, size_t size) {
+    GetInstance()->AddEntropy(data, size);
+    entropy_generation.fetch_add(1);
+}
+
 // Returns true if the kernel cmdline provided at least PRNG::kMinEntropy bytes
 // of entropy, and false otherwise.
 //
@@ -167,6 +229,22 @@ static void BecomeThreadSafe(uint level) {
     GetInstance()->BecomeThreadSafe();
 }
 
+// Seed a PRNG for each cpu from the global PRNG.  Each gets its own key
+// drawn from the global PRNG, so knowing the state of one tells nothing
+// about the others.
+static void InitCpuPRNGs(uint level) {
+    for (auto& cpu : cpu_prngs) {
+        uint8_t seed[PRNG::kMinEntropy];
+        GetInstance()->Draw(seed, sizeof(seed));
+        new (&cpu.prng_space) PRNG(seed, sizeof(seed));
+        mandatory_memset(seed, 0, sizeof(seed));
+
+        cpu.drawn.store(0);
+        cpu.generation.store(entropy_generation.load());
+    }
+    cpu_prngs_ready.store(true);
+}
+
 } //namespace GlobalPRNG
 
 } // namespace crypto
@@ -177,3 +255,6 @@ LK_INIT_HOOK(global_prng_seed, crypto::GlobalPRNG::EarlyBootSeed,
 
 LK_INIT_HOOK(global_prng_thread_safe, crypto::GlobalPRNG::BecomeThreadSafe,
              LK_INIT_LEVEL_THREADING - 1)
+
+LK_INIT_HOOK(global_prng_per_cpu, crypto::GlobalPRNG::InitCpuPRNGs,
+             LK_INIT_LEVEL_THREADING)
@@ -8,6 +8,7 @@
 
 #include <lib/unittest/unittest.h>
 #include <stdint.h>
+#include <string.h>
 
 namespace crypto {
 
@@ -24,10 +25,34 @@ bool identical() {
     END_TEST;
 }
 
+bool per_cpu_draws_differ() {
+    BEGIN_TEST;
+
+    // Each draw comes from a fresh nonce or a different cpu's key, so
+    // repeated output would mean the per-cpu PRNGs share state.
+    // kDrawSize is large enough that the probability of a false positive
+    // is negligible.
+    static const int kDrawSize = 32;
+    uint8_t out1[kDrawSize] = {0};
+    uint8_t out2[kDrawSize] = {0};
+    GlobalPRNG::Draw(out1, sizeof(out1));
+    GlobalPRNG::Draw(out2, sizeof(out2));
+    EXPECT_NE(0, memcmp(out1, out2, sizeof(out1)), "");
+
+    // Adding entropy makes the per-cpu PRNGs reseed; they must still work.
+    uint8_t entropy[PRNG::kMinEntropy] = {0};
+    GlobalPRNG::AddEntropy(entropy, sizeof(entropy));
+    GlobalPRNG::Draw(out2, sizeof(out2));
+    EXPECT_NE(0, memcmp(out1, out2, sizeof(out1)), "");
+
+    END_TEST;
+}
+
 } // namespace
 
 UNITTEST_START_TESTCASE(global_prng_tests)
 UNITTEST("Identical", identical)
+UNITTEST("PerCpuDrawsDiffer", per_cpu_draws_differ)
 UNITTEST_END_TESTCASE(global_prng_tests, "global_prng",
                       "Validate global PRNG singleton");
 
@@ -16,6 +16,19 @@ namespace GlobalPRNG {
 // guaranteed to be non-null.
 PRNG* GetInstance();
 
+// Fills |out| with |size| bytes of pseudo-random output from a PRNG
+// belonging to the current cpu, so that callers on different cpus do not
+// contend.  The per-cpu PRNGs are seeded from the global PRNG, and reseeded
+// from it every 64KiB drawn and after any call to AddEntropy().  Before they
+// are set up at LK_INIT_LEVEL_THREADING, this draws from the global PRNG.
+// |size| MUST NOT be greater than PRNG::kMaxDrawLen.
+void Draw(void* out, size_t size);
+
+// Mixes |size| bytes of entropy into the global PRNG, and has the per-cpu
+// PRNGs reseed from it before their next draw.  |size| MUST NOT be greater
+// than PRNG::kMaxEntropy.
+void AddEntropy(const void* data, size_t size);
+
 } //namespace GlobalPRNG
 
 } // namespace crypto
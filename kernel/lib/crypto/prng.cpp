@@ -73,8 +73,10 @@ void PRNG::AddEntropy(const void* data, size_t size) {
         memcpy(key_, key, sizeof(key_));
     }
     // Increment how much entropy has been added, and signal if we have enough.
-    if (is_thread_safe() &&
-        accumulated_.fetch_add(size) + size >= kMinEntropy) {
+    // Entropy added before becoming thread-safe counts too, so that a PRNG
+    // which was seeded fully at construction never has to check |ready_|.
+    if (accumulated_.fetch_add(size) + size >= kMinEntropy &&
+        is_thread_safe()) {
         event_signal(&ready_, true /* reschedule */);
     }
 }
@@ -37,6 +37,7 @@ static dlog_t DLOG = {
     .tail = 0,
     .data = DLOG_DATA,
     .panic = false,
+    .notify_pending = false,
     .event = EVENT_INITIAL_VALUE(DLOG.event, 0, EVENT_FLAG_AUTOUNSIGNAL),
 
     .readers_lock = MUTEX_INITIAL_VALUE(DLOG.readers_lock),
@@ -169,6 +170,12 @@ zx_status_t dlog_write(uint32_t flags, const void* data_ptr, size_t len) {
     }
     log->head += wiresize;
 
+    // Only the first record written since the notifier last ran needs to
+    // wake it: Signaling takes the thread lock, which is too costly to do
+    // for every record of a busy log.
+    bool do_notify = !log->notify_pending;
+    log->notify_pending = true;
+
     // Need to check this before re-releasing the log lock, since we may
     // re-enable interrupts while doing that.  If interrupts are enabled when we
     // make this check, we could see the following sequence of events between
@@ -183,6 +190,10 @@ zx_status_t dlog_write(uint32_t flags, const void* data_ptr, size_t len) {
 
     spin_unlock_irqrestore(&log->lock, state);
 
+    if (!do_notify) {
+        return ZX_OK;
+    }
+
     [log, holding_thread_lock]() TA_NO_THREAD_SAFETY_ANALYSIS {
         // if we happen to be called from within the global thread lock, use a
         // special version of event signal
@@ -297,6 +308,14 @@ static int debuglog_notifier(void* arg) {
         }
         event_wait(&log->event);
 
+        // Records written from here on need another wakeup. Readers only
+        // read after being notified below, so they see everything written
+        // before this point.
+        spin_lock_saved_state_t state;
+        spin_lock_irqsave(&log->lock, state);
+        log->notify_pending = false;
+        spin_unlock_irqrestore(&log->lock, state);
+
         // notify readers that new log items were posted
         mutex_acquire(&log->readers_lock);
         dlog_reader_t* rdr;
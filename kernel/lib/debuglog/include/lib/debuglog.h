@@ -30,6 +30,10 @@ struct dlog {
 
     bool panic;
 
+    // True if |event| has been signaled and the notifier hasn't yet
+    // picked up the records written since. Guarded by |lock|.
+    bool notify_pending;
+
     event_t event;
 
     mutex_t readers_lock;
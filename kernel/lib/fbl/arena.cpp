@@ -128,6 +128,7 @@ zx_status_t Arena::Init(const char* name, size_t ob_size, size_t count) {
 
     control_.Init("control", control_mapping, sizeof(Node));
     data_.Init("data", data_mapping, ob_size);
+    data_top_.store(reinterpret_cast<uintptr_t>(data_.top()), fbl::memory_order_release);
 
     count_ = 0u;
 
@@ -247,6 +248,8 @@ void* Arena::Alloc() {
         allocation = slot;
     } else {
         allocation = data_.Pop();
+        // Publish the new slot only once its memory has been committed.
+        data_top_.store(reinterpret_cast<uintptr_t>(data_.top()), fbl::memory_order_release);
     }
     if (allocation != nullptr) {
         ++count_;
@@ -11,6 +11,7 @@
 #include <vm/vm_address_region.h>
 
 #include <zxcpp/new.h>
+#include <fbl/atomic.h>
 #include <fbl/intrusive_single_list.h>
 #include <fbl/ref_ptr.h>
 #include <fbl/type_support.h>
@@ -34,8 +35,13 @@ public:
     zx_status_t Init(const char* name, size_t ob_size, size_t max_count);
     void* Alloc();
     void Free(void* addr);
+    // Returns true if |addr| is within a slot that Alloc() has handed out at
+    // some point. Data slots are never given back to their pool, so that
+    // memory stays committed and this may be called without whatever lock
+    // serializes Alloc() and Free().
     bool in_range(uintptr_t addr) const {
-        return data_.InRange(addr);
+        return addr >= reinterpret_cast<uintptr_t>(data_.start()) &&
+               addr < data_top_.load(fbl::memory_order_acquire);
     }
     bool in_range(void* addr) const {
         return in_range(reinterpret_cast<uintptr_t>(addr));
@@ -84,6 +90,9 @@ private:
         // the method will ASSERT.
         void Push(void* p);
 
+        // The end of the allocated slots.
+        char* top() const { return top_; }
+
         // Returns true if |addr| could have been returned by Pop and has
         // not been reclaimed by Push.
         bool InRange(uintptr_t addr) const {
@@ -120,6 +129,9 @@ private:
     Pool control_; // Free list nodes
     Pool data_;    // Objects
 
+    // Mirrors data_.top() for in_range(), which runs unserialized.
+    fbl::atomic<uintptr_t> data_top_ = {};
+
     // Parent VMAR of our memory.
     fbl::RefPtr<VmAddressRegion> vmar_;
 
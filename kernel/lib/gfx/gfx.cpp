@@ -170,36 +170,28 @@ static void putpixel(gfx_surface* surface, uint x, uint y, uint color) {
 
 template <typename T>
 static void copyrect(gfx_surface* surface, uint x, uint y, uint width, uint height, uint x2, uint y2) {
-    // copy
+    // Copy a row at a time with memmove, which handles any overlap within a
+    // row and is much faster than copying a pixel at a time.  Walk the rows
+    // backwards when moving down so that overlapping rows are read before
+    // they are overwritten.
     const T* src = static_cast<const T*>(surface->ptr) + (x + y * surface->stride);
     T* dest = static_cast<T*>(surface->ptr) + (x2 + y2 * surface->stride);
-    uint stride_diff = surface->stride - width;
+    size_t row_bytes = width * sizeof(T);
 
     if (dest < src) {
-        uint i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest++;
-                src++;
-            }
-            dest += stride_diff;
-            src += stride_diff;
+        for (uint i = 0; i < height; i++) {
+            memmove(dest, src, row_bytes);
+            dest += surface->stride;
+            src += surface->stride;
         }
     } else {
-        // copy backwards
-        src += height * surface->stride + width;
-        dest += height * surface->stride + width;
+        src += (height - 1) * surface->stride;
+        dest += (height - 1) * surface->stride;
 
-        uint i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest--;
-                src--;
-            }
-            dest -= stride_diff;
-            src -= stride_diff;
+        for (uint i = 0; i < height; i++) {
+            memmove(dest, src, row_bytes);
+            dest -= surface->stride;
+            src -= surface->stride;
         }
     }
 }
@@ -207,7 +199,6 @@ static void copyrect(gfx_surface* surface, uint x, uint y, uint width, uint heig
 template <typename T>
 static void fillrect(gfx_surface* surface, uint x, uint y, uint width, uint height, uint _color) {
     T* dest = static_cast<T*>(surface->ptr) + (x + y * surface->stride);
-    uint stride_diff = surface->stride - width;
 
     T color;
     if (sizeof(_color) == sizeof(color)) {
@@ -216,13 +207,16 @@ static void fillrect(gfx_surface* surface, uint x, uint y, uint width, uint heig
         color = static_cast<T>(surface->translate_color(_color));
     }
 
-    uint i, j;
-    for (i = 0; i < height; i++) {
-        for (j = 0; j < width; j++) {
-            *dest = color;
-            dest++;
-        }
-        dest += stride_diff;
+    // Fill the first row, then replicate it into the remaining rows.
+    for (uint j = 0; j < width; j++) {
+        dest[j] = color;
+    }
+
+    const T* first = dest;
+    size_t row_bytes = width * sizeof(T);
+    for (uint i = 1; i < height; i++) {
+        dest += surface->stride;
+        memcpy(dest, first, row_bytes);
     }
 }
 
@@ -13,21 +13,25 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <arch/ops.h>
 #include <debug.h>
 #include <err.h>
+#include <kernel/align.h>
 #include <kernel/mutex.h>
 #include <kernel/spinlock.h>
 #include <kernel/thread.h>
 #include <vm/vm.h>
+#include <lib/counters.h>
 #include <lib/heap.h>
 #include <platform.h>
 #include <trace.h>
 
 // Malloc implementation tuned for space.
 //
-// Allocation strategy takes place with a global mutex.  Freelist entries are
-// kept in linked lists with 8 different sizes per binary order of magnitude
-// and the header size is two words with eager coalescing on free.
+// Allocation strategy takes place with a global mutex, fronted by small
+// per-cpu caches for the smallest sizes.  Freelist entries are kept in linked
+// lists with 8 different sizes per binary order of magnitude and the header
+// size is two words with eager coalescing on free.
 //
 // ## Concepts ##
 //
@@ -108,6 +112,16 @@
 //   Exception: to avoid OS free/alloc churn when right on the edge, the heap
 //   will try to hold onto one entirely-free, non-large OS allocation instead of
 //   returning it to the OS. See cached_os_alloc.
+//
+// Magazines:
+//   Each cpu keeps a short stack of recently freed memory areas for each of
+//   the smallest MAGAZINE_BUCKETS buckets. Areas in a magazine are still
+//   marked as allocated, so they are not coalesced and do not count towards
+//   heap.remaining; cmpct_alloc() hands them back out without taking the heap
+//   lock. The magazine for bucket |b| only holds areas whose usable size is at
+//   least the size of |b|, so any of them satisfies an allocation rounded up
+//   to |b|. An empty magazine is refilled, and a full one half emptied, with a
+//   single acquisition of the heap lock.
 
 #if defined(DEBUG) || LK_DEBUGLEVEL > 2
 #define CMPCT_DEBUG
@@ -197,9 +211,51 @@ struct heap {
 // Heap static vars.
 static struct heap theheap;
 
+// Buckets 0 through 31 cover usable sizes up to 512 bytes.
+#define MAGAZINE_BUCKETS 32
+#define MAGAZINE_SIZE 8
+#define MAGAZINE_BATCH (MAGAZINE_SIZE / 2)
+
+struct magazine {
+    // areas[count - 1] is the most recently freed one.
+    int count;
+    header_t* areas[MAGAZINE_SIZE];
+
+    // Per size class statistics, see cmpct_dump().
+    uint64_t alloc_hits;
+    uint64_t alloc_misses;
+};
+
+struct cpu_magazines {
+    // Taken with interrupts disabled by the owning cpu, and by drains from
+    // cmpct_trim(). Never held while acquiring the heap lock.
+    spin_lock_t lock;
+    struct magazine mags[MAGAZINE_BUCKETS];
+} __CPU_ALIGN;
+
+static struct cpu_magazines magazines[SMP_MAX_CPUS];
+
+// Cleared while the internal heap tests run, since they expect frees to reach
+// the free buckets right away.
+static bool magazines_enabled = true;
+
+KCOUNTER(heap_magazine_alloc_hit, "kernel.heap.magazine.alloc_hit");
+KCOUNTER(heap_magazine_alloc_miss, "kernel.heap.magazine.alloc_miss");
+KCOUNTER(heap_magazine_free_hit, "kernel.heap.magazine.free_hit");
+KCOUNTER(heap_magazine_drain, "kernel.heap.magazine.drain");
+KCOUNTER(heap_lock_acquired, "kernel.heap.lock.acquired");
+KCOUNTER(heap_lock_contended, "kernel.heap.lock.contended");
+
 static ssize_t heap_grow(size_t len);
+static void free_locked(header_t* header) TA_REQ(theheap.lock);
+static void drain_magazines(void);
 
 static void lock(void) TA_ACQ(theheap.lock) {
+    // Racy, but good enough to tell how often callers queue on the lock.
+    if (mutex_val(&theheap.lock) != 0) {
+        kcounter_add(heap_lock_contended, 1);
+    }
+    kcounter_add(heap_lock_acquired, 1);
     mutex_acquire(&theheap.lock);
 }
 
@@ -237,15 +293,51 @@ void cmpct_dump(bool panic_time) TA_NO_THREAD_SAFETY_ANALYSIS {
         }
     }
 
+    // The statistics are only ever read here, so sum them without the cpu
+    // locks.
+    dprintf(INFO, "\tmagazines (cached, alloc hits, alloc misses):\n");
+    for (int i = 0; i < MAGAZINE_BUCKETS; i++) {
+        uint64_t cached = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        for (const auto& cpu : magazines) {
+            cached += cpu.mags[i].count;
+            hits += cpu.mags[i].alloc_hits;
+            misses += cpu.mags[i].alloc_misses;
+        }
+        if (cached != 0 || hits != 0 || misses != 0) {
+            dprintf(INFO, "\tbucket %d: %" PRIu64 " %" PRIu64 " %" PRIu64 "\n",
+                    i, cached, hits, misses);
+        }
+    }
+
     if (!panic_time) {
         unlock();
     }
 }
 
+// Bytes held in the magazines of all cpus.
+static size_t magazine_bytes(void) {
+    size_t bytes = 0;
+    for (auto& cpu : magazines) {
+        spin_lock_saved_state_t state;
+        spin_lock_irqsave(&cpu.lock, state);
+        for (const auto& mag : cpu.mags) {
+            for (int i = 0; i < mag.count; i++) {
+                bytes += mag.areas[i]->size;
+            }
+        }
+        spin_unlock_irqrestore(&cpu.lock, state);
+    }
+    return bytes;
+}
+
 void cmpct_get_info(size_t* size_bytes, size_t* free_bytes) {
+    // Cached areas are free as far as the callers are concerned.
+    size_t cached = magazine_bytes();
     lock();
     *size_bytes = theheap.size;
-    *free_bytes = theheap.remaining;
+    *free_bytes = theheap.remaining + cached;
     unlock();
 }
 
@@ -740,6 +832,8 @@ static void cmpct_test_return_to_os(void) {
 }
 
 void cmpct_test(void) {
+    magazines_enabled = false;
+    drain_magazines();
     cmpct_test_buckets();
     cmpct_test_get_back_newly_freed();
     cmpct_test_return_to_os();
@@ -798,6 +892,7 @@ void cmpct_test(void) {
     }
 
     cmpct_dump(false);
+    magazines_enabled = true;
 }
 
 #else
@@ -805,6 +900,9 @@ void cmpct_test(void) {}
 #endif  // HEAP_ENABLE_TESTS
 
 void cmpct_trim(void) {
+    // Cached areas pin the pages they live on, so give them back first.
+    drain_magazines();
+
     // Look at free list entries that are at least as large as one page plus a
     // header. They might be at the start or the end of a block, so we can trim
     // them and free the page(s).
@@ -897,22 +995,11 @@ void cmpct_trim(void) {
     unlock();
 }
 
-void* cmpct_alloc(size_t size) {
-    if (size == 0u) {
-        return NULL;
-    }
-
-    // Large allocations are no longer allowed. See ZX-1318 for details.
-    if (size > (HEAP_LARGE_ALLOC_BYTES - sizeof(header_t))) {
-        return NULL;
-    }
-
-    size_t rounded_up;
-    int start_bucket = size_to_index_allocating(size, &rounded_up);
-
-    rounded_up += sizeof(header_t);
-
-    lock();
+// Carves an area with at least |rounded_up| bytes, including the header, out
+// of the free buckets, growing the heap if needed. Returns the usable memory,
+// or NULL if the heap could not grow.
+static void* alloc_locked(size_t size, int start_bucket, size_t rounded_up)
+    TA_REQ(theheap.lock) {
     int bucket = find_nonempty_bucket(start_bucket);
     if (bucket == -1) {
         // Grow heap by at least 12% if we can.
@@ -923,7 +1010,6 @@ void* cmpct_alloc(size_t size) {
         // we succeed or get too small.
         while (heap_grow(growby) < 0) {
             if (growby <= rounded_up) {
-                unlock();
                 return NULL;
             }
             growby = MAX(growby >> 1, rounded_up);
@@ -955,7 +1041,139 @@ void* cmpct_alloc(size_t size) {
     memset(((char*)result) + size, PADDING_FILL,
            rounded_up - size - sizeof(header_t));
 #endif
+    return result;
+}
+
+// Returns the magazine bucket for an allocated area, or -1 if the area is too
+// large to be cached.
+static int magazine_bucket(const header_t* header) {
+    size_t usable = header->size - sizeof(header_t);
+    if (usable > 512) {
+        return -1;
+    }
+    int bucket = size_to_index_freeing(usable);
+    return bucket < MAGAZINE_BUCKETS ? bucket : -1;
+}
+
+static void magazine_fill(header_t* header) {
+#ifdef CMPCT_DEBUG
+    memset(header + 1, FREE_FILL, header->size - sizeof(header_t));
+#endif
+}
+
+// Pops a cached area with at least |size| usable bytes from this cpu's
+// magazine for |bucket|.
+static void* magazine_pop(int bucket, size_t size) {
+    spin_lock_saved_state_t state;
+    arch_interrupt_save(&state, SPIN_LOCK_FLAG_INTERRUPTS);
+    struct cpu_magazines* cpu = &magazines[arch_curr_cpu_num()];
+    spin_lock(&cpu->lock);
+    struct magazine* mag = &cpu->mags[bucket];
+    header_t* header = NULL;
+    if (mag->count > 0) {
+        header = mag->areas[--mag->count];
+        mag->alloc_hits++;
+    } else {
+        mag->alloc_misses++;
+    }
+    spin_unlock(&cpu->lock);
+    arch_interrupt_restore(state, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    if (header == NULL) {
+        kcounter_add(heap_magazine_alloc_miss, 1);
+        return NULL;
+    }
+    kcounter_add(heap_magazine_alloc_hit, 1);
+    void* result = header + 1;
+#ifdef CMPCT_DEBUG
+    check_free_fill(result, size);
+    memset(result, ALLOC_FILL, size);
+    memset(((char*)result) + size, PADDING_FILL,
+           header->size - size - sizeof(header_t));
+#endif
+    return result;
+}
+
+// Pushes up to |count| areas onto this cpu's magazine for |bucket|. Returns
+// how many of them fit.
+static int magazine_push(int bucket, header_t** areas, int count) {
+    spin_lock_saved_state_t state;
+    arch_interrupt_save(&state, SPIN_LOCK_FLAG_INTERRUPTS);
+    struct cpu_magazines* cpu = &magazines[arch_curr_cpu_num()];
+    spin_lock(&cpu->lock);
+    struct magazine* mag = &cpu->mags[bucket];
+    int pushed = 0;
+    while (pushed < count && mag->count < MAGAZINE_SIZE) {
+        mag->areas[mag->count++] = areas[pushed++];
+    }
+    spin_unlock(&cpu->lock);
+    arch_interrupt_restore(state, SPIN_LOCK_FLAG_INTERRUPTS);
+    return pushed;
+}
+
+void* cmpct_alloc(size_t size) {
+    if (size == 0u) {
+        return NULL;
+    }
+
+    // Large allocations are no longer allowed. See ZX-1318 for details.
+    if (size > (HEAP_LARGE_ALLOC_BYTES - sizeof(header_t))) {
+        return NULL;
+    }
+
+    size_t rounded_up;
+    int start_bucket = size_to_index_allocating(size, &rounded_up);
+
+    // Cached areas are filed by the bucket they are freed into, which is not
+    // always |start_bucket| for the smallest sizes.
+    int mag_bucket = -1;
+    if (magazines_enabled && rounded_up <= 512) {
+        mag_bucket = size_to_index_freeing(rounded_up);
+        if (mag_bucket >= MAGAZINE_BUCKETS) {
+            mag_bucket = -1;
+        }
+    }
+    if (mag_bucket >= 0) {
+        void* result = magazine_pop(mag_bucket, size);
+        if (result != NULL) {
+            return result;
+        }
+    }
+
+    rounded_up += sizeof(header_t);
+
+    header_t* refill[MAGAZINE_BATCH];
+    int refilled = 0;
+
+    lock();
+    void* result = alloc_locked(size, start_bucket, rounded_up);
+    if (result != NULL && mag_bucket >= 0) {
+        // Take the lock once for the next few allocations of this size, too.
+        size_t usable = rounded_up - sizeof(header_t);
+        while (refilled < MAGAZINE_BATCH) {
+            void* area = alloc_locked(usable, start_bucket, rounded_up);
+            if (area == NULL) {
+                break;
+            }
+            refill[refilled++] = (header_t*)area - 1;
+        }
+    }
     unlock();
+
+    if (refilled > 0) {
+        for (int i = 0; i < refilled; i++) {
+            magazine_fill(refill[i]);
+        }
+        int pushed = magazine_push(mag_bucket, refill, refilled);
+        if (pushed < refilled) {
+            // Someone else filled the magazine while we were refilling it.
+            lock();
+            for (int i = pushed; i < refilled; i++) {
+                free_locked(refill[i]);
+            }
+            unlock();
+        }
+    }
     return result;
 }
 
@@ -995,14 +1213,10 @@ void* cmpct_memalign(size_t size, size_t alignment) {
     return payload;
 }
 
-void cmpct_free(void* payload) {
-    if (payload == NULL) {
-        return;
-    }
-    header_t* header = (header_t*)payload - 1;
-    DEBUG_ASSERT(!is_tagged_as_free(header)); // Double free!
+// Returns an allocated area to the free buckets, coalescing it with its
+// neighbors.
+static void free_locked(header_t* header) TA_REQ(theheap.lock) {
     size_t size = header->size;
-    lock();
     header_t* left = header->left;
     if (left != NULL && is_tagged_as_free(left)) {
         // Coalesce with left free object.
@@ -1031,9 +1245,80 @@ void cmpct_free(void* payload) {
             free_memory(header, left, size);
         }
     }
+}
+
+void cmpct_free(void* payload) {
+    if (payload == NULL) {
+        return;
+    }
+    header_t* header = (header_t*)payload - 1;
+    DEBUG_ASSERT(!is_tagged_as_free(header)); // Double free!
+
+    int bucket = magazines_enabled ? magazine_bucket(header) : -1;
+    if (bucket >= 0) {
+        magazine_fill(header);
+
+        header_t* drained[MAGAZINE_BATCH];
+        spin_lock_saved_state_t state;
+        arch_interrupt_save(&state, SPIN_LOCK_FLAG_INTERRUPTS);
+        struct cpu_magazines* cpu = &magazines[arch_curr_cpu_num()];
+        spin_lock(&cpu->lock);
+        struct magazine* mag = &cpu->mags[bucket];
+        bool drain = mag->count == MAGAZINE_SIZE;
+        if (drain) {
+            // Hand the coldest half back to the heap.
+            memcpy(drained, mag->areas, sizeof(drained));
+            memmove(mag->areas, mag->areas + MAGAZINE_BATCH,
+                    (MAGAZINE_SIZE - MAGAZINE_BATCH) * sizeof(header_t*));
+            mag->count -= MAGAZINE_BATCH;
+        }
+        mag->areas[mag->count++] = header;
+        spin_unlock(&cpu->lock);
+        arch_interrupt_restore(state, SPIN_LOCK_FLAG_INTERRUPTS);
+
+        if (!drain) {
+            kcounter_add(heap_magazine_free_hit, 1);
+            return;
+        }
+        kcounter_add(heap_magazine_drain, 1);
+        lock();
+        for (header_t* area : drained) {
+            free_locked(area);
+        }
+        unlock();
+        return;
+    }
+
+    lock();
+    free_locked(header);
     unlock();
 }
 
+// Returns every cached area of every cpu to the free buckets.
+static void drain_magazines(void) {
+    for (auto& cpu : magazines) {
+        for (int bucket = 0; bucket < MAGAZINE_BUCKETS; bucket++) {
+            header_t* drained[MAGAZINE_SIZE];
+            spin_lock_saved_state_t state;
+            spin_lock_irqsave(&cpu.lock, state);
+            struct magazine* mag = &cpu.mags[bucket];
+            int count = mag->count;
+            memcpy(drained, mag->areas, count * sizeof(header_t*));
+            mag->count = 0;
+            spin_unlock_irqrestore(&cpu.lock, state);
+
+            if (count == 0) {
+                continue;
+            }
+            lock();
+            for (int i = 0; i < count; i++) {
+                free_locked(drained[i]);
+            }
+            unlock();
+        }
+    }
+}
+
 void* cmpct_realloc(void* payload, size_t size) {
     if (payload == NULL) {
         return cmpct_alloc(size);
@@ -1121,6 +1406,10 @@ void cmpct_init(void) {
     // Create a mutex.
     mutex_init(&theheap.lock);
 
+    for (auto& cpu : magazines) {
+        spin_lock_init(&cpu.lock);
+    }
+
     // Initialize the free list.
     for (int i = 0; i < NUMBER_OF_BUCKETS; i++) {
         theheap.free_lists[i] = NULL;
@@ -12,4 +12,7 @@ MODULE := $(LOCAL_DIR)
 MODULE_SRCS += \
 	$(LOCAL_DIR)/cmpctmalloc.cpp
 
+MODULE_DEPS += \
+	kernel/lib/counters
+
 include make/module.mk
@@ -6,8 +6,11 @@
 
 #include <hypervisor/guest_physical_address_space.h>
 
+#include <fbl/algorithm.h>
 #include <fbl/alloc_checker.h>
+#include <fbl/vector.h>
 #include <kernel/range_check.h>
+#include <lib/counters.h>
 #include <vm/fault.h>
 #include <vm/vm_object_physical.h>
 
@@ -22,6 +25,74 @@ static constexpr uint kGuestMmuFlags =
     ARCH_MMU_FLAG_PERM_READ |
     ARCH_MMU_FLAG_PERM_WRITE;
 
+KCOUNTER(fault_large_page, "kernel.hypervisor.fault.large_page");
+
+namespace {
+
+// Collects the base addresses of the mappings within a guest physical address
+// space, so they can be mapped after the enumeration has dropped the lock.
+class MappingCollector final : public VmEnumerator {
+public:
+    bool OnVmMapping(const VmMapping* map, const VmAddressRegion* vmar, uint depth) final {
+        fbl::AllocChecker ac;
+        bases_.push_back(map->base(), &ac);
+        if (!ac.check()) {
+            status_ = ZX_ERR_NO_MEMORY;
+            return false;
+        }
+        return true;
+    }
+
+    zx_status_t status() const { return status_; }
+    const fbl::Vector<zx_gpaddr_t>& bases() const { return bases_; }
+
+private:
+    fbl::Vector<zx_gpaddr_t> bases_;
+    zx_status_t status_ = ZX_OK;
+};
+
+} // namespace
+
+// Commits and maps [offset, offset + len) of |mapping| in one go. Paged VMOs
+// commit an untouched, aligned large page of memory as a contiguous run, and
+// the mapping then uses a large page wherever its memory is contiguous.
+static zx_status_t map_block(const fbl::RefPtr<VmMapping>& mapping, uint64_t offset,
+                             uint64_t len) {
+    const fbl::RefPtr<VmObject>& vmo = mapping->vmo();
+    if (vmo->is_paged()) {
+        uint64_t committed;
+        zx_status_t status = vmo->CommitRange(mapping->object_offset() + offset, len, &committed);
+        if (status != ZX_OK) {
+            return status;
+        }
+    }
+    return mapping->MapRange(offset, len, false);
+}
+
+// Maps the large page of |mapping| that contains |guest_paddr|, provided the
+// large page is within the mapping and its memory is either untouched or fully
+// committed. A partially committed large page, for example one that has been
+// decommitted in part, is left to be faulted in page by page.
+static void map_large_page(const fbl::RefPtr<VmMapping>& mapping, zx_gpaddr_t guest_paddr) {
+    const zx_gpaddr_t begin = ROUNDDOWN(guest_paddr, LARGE_PAGE_SIZE);
+    if (begin < mapping->base() || mapping->size() < LARGE_PAGE_SIZE ||
+        begin - mapping->base() > mapping->size() - LARGE_PAGE_SIZE) {
+        return;
+    }
+    const uint64_t offset = begin - mapping->base();
+    const fbl::RefPtr<VmObject>& vmo = mapping->vmo();
+    if (vmo->is_paged()) {
+        size_t allocated = vmo->AllocatedPagesInRange(mapping->object_offset() + offset,
+                                                      LARGE_PAGE_SIZE);
+        if (allocated != 0 && allocated != LARGE_PAGE_SIZE / PAGE_SIZE) {
+            return;
+        }
+    }
+    if (map_block(mapping, offset, LARGE_PAGE_SIZE) == ZX_OK) {
+        kcounter_add(fault_large_page, 1);
+    }
+}
+
 namespace hypervisor {
 
 zx_status_t GuestPhysicalAddressSpace::Create(
@@ -131,10 +202,44 @@ zx_status_t GuestPhysicalAddressSpace::PageFault(zx_gpaddr_t guest_paddr) {
     if (mapping->arch_mmu_flags() & ARCH_MMU_FLAG_PERM_EXECUTE) {
         pf_flags |= VMM_PF_FLAG_INSTRUCTION;
     }
+
+    // Try to map the whole large page first, which takes the aspace lock
+    // itself. The page fault below then finds the page already mapped, or
+    // maps it if the large page could not be.
+    map_large_page(mapping, guest_paddr);
+
     Guard<fbl::Mutex> guard{guest_aspace_->lock()};
     return mapping->PageFault(guest_paddr, pf_flags);
 }
 
+zx_status_t GuestPhysicalAddressSpace::Prefault() {
+    MappingCollector collector;
+    guest_aspace_->EnumerateChildren(&collector);
+    if (collector.status() != ZX_OK) {
+        return collector.status();
+    }
+
+    for (zx_gpaddr_t base : collector.bases()) {
+        fbl::RefPtr<VmMapping> mapping = FindMapping(RootVmar(), base);
+        if (!mapping) {
+            continue;
+        }
+        // Map the mapping one large page at a time, so that a large page that
+        // is already mapped does not stop the rest from being mapped.
+        for (uint64_t offset = 0; offset < mapping->size();) {
+            const zx_gpaddr_t addr = mapping->base() + offset;
+            const uint64_t len = fbl::min(ROUNDDOWN(addr, LARGE_PAGE_SIZE) + LARGE_PAGE_SIZE - addr,
+                                          mapping->size() - offset);
+            zx_status_t status = map_block(mapping, offset, len);
+            if (status != ZX_OK && status != ZX_ERR_ALREADY_EXISTS) {
+                return status;
+            }
+            offset += len;
+        }
+    }
+    return ZX_OK;
+}
+
 zx_status_t GuestPhysicalAddressSpace::CreateGuestPtr(zx_gpaddr_t guest_paddr, size_t len,
                                                       const char* name, GuestPtr* guest_ptr) {
     const zx_gpaddr_t begin = ROUNDDOWN(guest_paddr, PAGE_SIZE);
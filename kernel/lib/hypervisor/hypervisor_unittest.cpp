@@ -415,6 +415,88 @@ static bool guest_physical_address_space_page_fault() {
     END_TEST;
 }
 
+static bool guest_physical_address_space_page_fault_large_page() {
+    BEGIN_TEST;
+
+    if (!hypervisor_supported()) {
+        return true;
+    }
+
+    // Setup.
+    fbl::unique_ptr<hypervisor::GuestPhysicalAddressSpace> gpas;
+    zx_status_t status = create_gpas(&gpas);
+    EXPECT_EQ(ZX_OK, status, "Failed to create GuestPhysicalAddressSpace\n");
+    fbl::RefPtr<VmObject> vmo;
+    status = create_vmo(LARGE_PAGE_SIZE * 2, &vmo);
+    EXPECT_EQ(ZX_OK, status, "Failed to create VMO\n");
+    status = create_mapping(gpas->RootVmar(), vmo, 0);
+    EXPECT_EQ(ZX_OK, status, "Failed to create mapping\n");
+
+    // Fault in a single page of an untouched large page.
+    status = gpas->PageFault(LARGE_PAGE_SIZE + PAGE_SIZE);
+    EXPECT_EQ(ZX_OK, status, "Failed to fault page\n");
+
+    // The whole large page should now be committed and mapped, but no other.
+    EXPECT_EQ(LARGE_PAGE_SIZE / PAGE_SIZE, vmo->AllocatedPages(),
+              "Large page was not committed\n");
+    for (zx_gpaddr_t addr = LARGE_PAGE_SIZE; addr < LARGE_PAGE_SIZE * 2; addr += PAGE_SIZE) {
+        paddr_t paddr;
+        status = gpas->arch_aspace()->Query(addr, &paddr, nullptr);
+        EXPECT_EQ(ZX_OK, status, "Page in large page was not mapped\n");
+    }
+    paddr_t paddr;
+    status = gpas->arch_aspace()->Query(0, &paddr, nullptr);
+    EXPECT_EQ(ZX_ERR_NOT_FOUND, status, "Page outside of large page was mapped\n");
+
+    END_TEST;
+}
+
+static bool guest_physical_address_space_prefault() {
+    BEGIN_TEST;
+
+    if (!hypervisor_supported()) {
+        return true;
+    }
+
+    // Setup.
+    fbl::unique_ptr<hypervisor::GuestPhysicalAddressSpace> gpas;
+    zx_status_t status = create_gpas(&gpas);
+    EXPECT_EQ(ZX_OK, status, "Failed to create GuestPhysicalAddressSpace\n");
+    fbl::RefPtr<VmObject> vmo1;
+    status = create_vmo(LARGE_PAGE_SIZE + PAGE_SIZE, &vmo1);
+    EXPECT_EQ(ZX_OK, status, "Failed to create VMO\n");
+    status = create_mapping(gpas->RootVmar(), vmo1, 0);
+    EXPECT_EQ(ZX_OK, status, "Failed to create mapping\n");
+    fbl::RefPtr<VmObject> vmo2;
+    status = create_vmo(PAGE_SIZE * 2, &vmo2);
+    EXPECT_EQ(ZX_OK, status, "Failed to create VMO\n");
+    status = create_mapping(gpas->RootVmar(), vmo2, LARGE_PAGE_SIZE * 2 + PAGE_SIZE);
+    EXPECT_EQ(ZX_OK, status, "Failed to create mapping\n");
+
+    // Fault in a page first, which must not stop the rest from being mapped.
+    status = gpas->PageFault(LARGE_PAGE_SIZE);
+    EXPECT_EQ(ZX_OK, status, "Failed to fault page\n");
+    status = gpas->Prefault();
+    EXPECT_EQ(ZX_OK, status, "Failed to prefault guest physical address space\n");
+
+    // Every page of both mappings should be mapped.
+    EXPECT_EQ(vmo1->size() / PAGE_SIZE, vmo1->AllocatedPages(), "VMO was not committed\n");
+    EXPECT_EQ(vmo2->size() / PAGE_SIZE, vmo2->AllocatedPages(), "VMO was not committed\n");
+    for (zx_gpaddr_t addr = 0; addr < vmo1->size(); addr += PAGE_SIZE) {
+        paddr_t paddr;
+        status = gpas->arch_aspace()->Query(addr, &paddr, nullptr);
+        EXPECT_EQ(ZX_OK, status, "Page was not mapped\n");
+    }
+    for (zx_gpaddr_t addr = 0; addr < vmo2->size(); addr += PAGE_SIZE) {
+        paddr_t paddr;
+        status = gpas->arch_aspace()->Query(LARGE_PAGE_SIZE * 2 + PAGE_SIZE + addr, &paddr,
+                                            nullptr);
+        EXPECT_EQ(ZX_OK, status, "Page was not mapped\n");
+    }
+
+    END_TEST;
+}
+
 static bool guest_physical_address_space_map_interrupt_controller() {
     BEGIN_TEST;
 
@@ -529,6 +611,8 @@ HYPERVISOR_UNITTEST(guest_physical_address_space_get_page)
 HYPERVISOR_UNITTEST(guest_physical_address_space_get_page_complex)
 HYPERVISOR_UNITTEST(guest_physical_address_space_get_page_not_present)
 HYPERVISOR_UNITTEST(guest_physical_address_space_page_fault)
+HYPERVISOR_UNITTEST(guest_physical_address_space_page_fault_large_page)
+HYPERVISOR_UNITTEST(guest_physical_address_space_prefault)
 HYPERVISOR_UNITTEST(guest_physical_address_space_map_interrupt_controller)
 HYPERVISOR_UNITTEST(guest_physical_address_space_uncached)
 HYPERVISOR_UNITTEST(guest_physical_address_space_uncached_device)
@@ -70,6 +70,9 @@ public:
     zx_status_t UnmapRange(zx_gpaddr_t guest_paddr, size_t len);
     zx_status_t GetPage(zx_gpaddr_t guest_paddr, zx_paddr_t* host_paddr);
     zx_status_t PageFault(zx_gpaddr_t guest_paddr);
+    // Commits and maps all of the memory mapped into the guest physical address
+    // space, using large pages where possible.
+    zx_status_t Prefault();
     zx_status_t CreateGuestPtr(zx_gpaddr_t guest_paddr, size_t len, const char* name,
                                GuestPtr* guest_ptr);
 
@@ -77,8 +77,22 @@ public:
         return ZX_OK;
     }
 
+    // Signals any waiters, without tracking an interrupt. Used when an
+    // interrupt is queued outside of the tracker.
+    void Signal() {
+        event_signal(&event_, true);
+    }
+
     // Waits for an interrupt.
     zx_status_t Wait(StateInvalidator* invalidator) {
+        return Wait(invalidator, [this]() { return Pending(); });
+    }
+
+    // Waits until |pending| returns true. It must return true whenever
+    // Pending() does, and anything else that makes it return true must be
+    // followed by a call to Signal().
+    template <typename F>
+    zx_status_t Wait(StateInvalidator* invalidator, F pending) {
         if (invalidator != nullptr) {
             invalidator->Invalidate();
         }
@@ -89,7 +103,7 @@ public:
                 ktrace_vcpu(TAG_VCPU_UNBLOCK, VCPU_INTERRUPT);
                 return ZX_ERR_CANCELED;
             }
-        } while (!Pending());
+        } while (!pending());
         ktrace_vcpu(TAG_VCPU_UNBLOCK, VCPU_INTERRUPT);
         return ZX_OK;
     }
@@ -12,6 +12,7 @@ enum VcpuMeta : uint32_t {
     // Waits.
     VCPU_INTERRUPT,
     VCPU_PORT,
+    VCPU_HALT_POLL,
 
     // Do not use.
     VCPU_META_COUNT,
@@ -51,4 +52,8 @@ enum VcpuExit : uint32_t {
 
 void ktrace_report_vcpu_meta();
 void ktrace_vcpu(uint32_t tag, VcpuMeta meta);
+// Traces a VM exit, and counts it in the kernel.hypervisor.exit.* counters.
 void ktrace_vcpu_exit(VcpuExit exit, uint64_t exit_address);
+// Traces the end of a halt poll, and counts it in the
+// kernel.hypervisor.halt_poll.* counters.
+void ktrace_vcpu_halt_poll(bool hit);
@@ -7,7 +7,11 @@
 #pragma once
 
 #include <fbl/arena.h>
+#include <fbl/array.h>
+#include <fbl/atomic.h>
+#include <fbl/intrusive_single_list.h>
 #include <fbl/intrusive_wavl_tree.h>
+#include <fbl/mutex.h>
 #include <fbl/ref_ptr.h>
 #include <hypervisor/state_invalidator.h>
 #include <object/port_dispatcher.h>
@@ -24,9 +28,18 @@ public:
     PortPacket* AllocBlocking();
     virtual void Free(PortPacket* port_packet) override;
 
+    // Tracks |port_packet| as pending until it is freed. Only the most
+    // recently tracked packet is remembered.
+    void SetPending(PortPacket* port_packet);
+    // Returns true if the pending packet is a bell for the same address as
+    // |packet|, and has therefore not yet been dequeued.
+    bool BellPending(const zx_port_packet_t& packet);
+
 private:
     Semaphore semaphore_;
     fbl::TypedArena<PortPacket, fbl::Mutex> arena_;
+    fbl::Mutex pending_mutex_;
+    PortPacket* pending_ TA_GUARDED(pending_mutex_) = nullptr;
 
     PortPacket* Alloc() override;
 };
@@ -69,13 +82,28 @@ public:
 private:
     using TrapTree = fbl::WAVLTree<zx_gpaddr_t, fbl::unique_ptr<Trap>>;
 
+    // An immutable snapshot of the traps of a kind, sorted by address. Lookups
+    // search the current snapshot without taking |mutex_|. Inserting a trap
+    // publishes a new snapshot. Traps are never removed, and old snapshots are
+    // kept until the TrapMap is destroyed, as a lookup may still be using one.
+    struct TrapTable : public fbl::SinglyLinkedListable<fbl::unique_ptr<TrapTable>> {
+        fbl::Array<Trap*> traps;
+    };
+
+    struct TrapSet {
+        TrapTree tree;
+        fbl::atomic<const TrapTable*> table{nullptr};
+    };
+
     fbl::Mutex mutex_;
-    TrapTree mem_traps_ TA_GUARDED(mutex_);
+    TrapSet mem_traps_ TA_GUARDED(mutex_);
 #ifdef ARCH_X86
-    TrapTree io_traps_ TA_GUARDED(mutex_);
+    TrapSet io_traps_ TA_GUARDED(mutex_);
 #endif // ARCH_X86
+    fbl::SinglyLinkedList<fbl::unique_ptr<TrapTable>> tables_ TA_GUARDED(mutex_);
 
-    TrapTree* TreeOf(uint32_t kind);
+    TrapSet* SetOf(uint32_t kind) TA_NO_THREAD_SAFETY_ANALYSIS;
+    zx_status_t PublishLocked(TrapSet* traps) TA_REQ(mutex_);
 };
 
 } // namespace hypervisor
@@ -6,11 +6,13 @@
 
 #include <hypervisor/ktrace.h>
 #include <kernel/thread.h>
+#include <lib/counters.h>
 #include <lib/ktrace.h>
 
 static const char* const vcpu_meta[] = {
         [VCPU_INTERRUPT] = "wait:interrupt",
         [VCPU_PORT] = "wait:port",
+        [VCPU_HALT_POLL] = "wait:halt_poll",
 };
 static_assert((sizeof(vcpu_meta) / sizeof(vcpu_meta[0])) == VCPU_META_COUNT,
               "vcpu_meta array must match enum VcpuMeta");
@@ -46,6 +48,72 @@ static const char* const vcpu_exit[] = {
 static_assert((sizeof(vcpu_exit) / sizeof(vcpu_exit[0])) == VCPU_EXIT_COUNT,
               "vcpu_exit array must match enum VcpuExit");
 
+// Counts of VM exits by reason, readable with "k counters" even when ktrace
+// is not running.
+#if ARCH_ARM64
+KCOUNTER(exit_underflow_maintenance_interrupt,
+         "kernel.hypervisor.exit.underflow_maintenance_interrupt");
+KCOUNTER(exit_physical_interrupt, "kernel.hypervisor.exit.physical_interrupt");
+KCOUNTER(exit_wfi_instruction, "kernel.hypervisor.exit.wfi_instruction");
+KCOUNTER(exit_wfe_instruction, "kernel.hypervisor.exit.wfe_instruction");
+KCOUNTER(exit_smc_instruction, "kernel.hypervisor.exit.smc_instruction");
+KCOUNTER(exit_system_instruction, "kernel.hypervisor.exit.system_instruction");
+KCOUNTER(exit_instruction_abort, "kernel.hypervisor.exit.instruction_abort");
+KCOUNTER(exit_data_abort, "kernel.hypervisor.exit.data_abort");
+#elif ARCH_X86
+KCOUNTER(exit_external_interrupt, "kernel.hypervisor.exit.external_interrupt");
+KCOUNTER(exit_interrupt_window, "kernel.hypervisor.exit.interrupt_window");
+KCOUNTER(exit_cpuid, "kernel.hypervisor.exit.cpuid");
+KCOUNTER(exit_hlt, "kernel.hypervisor.exit.hlt");
+KCOUNTER(exit_control_register_access, "kernel.hypervisor.exit.control_register_access");
+KCOUNTER(exit_io_instruction, "kernel.hypervisor.exit.io_instruction");
+KCOUNTER(exit_rdmsr, "kernel.hypervisor.exit.rdmsr");
+KCOUNTER(exit_wrmsr, "kernel.hypervisor.exit.wrmsr");
+KCOUNTER(exit_vm_entry_failure, "kernel.hypervisor.exit.vm_entry_failure");
+KCOUNTER(exit_ept_violation, "kernel.hypervisor.exit.ept_violation");
+KCOUNTER(exit_xsetbv, "kernel.hypervisor.exit.xsetbv");
+KCOUNTER(exit_pause, "kernel.hypervisor.exit.pause");
+KCOUNTER(exit_vmcall, "kernel.hypervisor.exit.vmcall");
+#endif
+KCOUNTER(exit_unknown, "kernel.hypervisor.exit.unknown");
+KCOUNTER(exit_failure, "kernel.hypervisor.exit.failure");
+
+// Halt polls which saw an interrupt arrive, and those which gave up and
+// blocked.
+KCOUNTER(halt_poll_hit, "kernel.hypervisor.halt_poll.hit");
+KCOUNTER(halt_poll_miss, "kernel.hypervisor.halt_poll.miss");
+
+static const k_counter_desc* const vcpu_exit_counters[] = {
+#if ARCH_ARM64
+        [VCPU_UNDERFLOW_MAINTENANCE_INTERRUPT] = exit_underflow_maintenance_interrupt,
+        [VCPU_PHYSICAL_INTERRUPT] = exit_physical_interrupt,
+        [VCPU_WFI_INSTRUCTION] = exit_wfi_instruction,
+        [VCPU_WFE_INSTRUCTION] = exit_wfe_instruction,
+        [VCPU_SMC_INSTRUCTION] = exit_smc_instruction,
+        [VCPU_SYSTEM_INSTRUCTION] = exit_system_instruction,
+        [VCPU_INSTRUCTION_ABORT] = exit_instruction_abort,
+        [VCPU_DATA_ABORT] = exit_data_abort,
+#elif ARCH_X86
+        [VCPU_EXTERNAL_INTERRUPT] = exit_external_interrupt,
+        [VCPU_INTERRUPT_WINDOW] = exit_interrupt_window,
+        [VCPU_CPUID] = exit_cpuid,
+        [VCPU_HLT] = exit_hlt,
+        [VCPU_CONTROL_REGISTER_ACCESS] = exit_control_register_access,
+        [VCPU_IO_INSTRUCTION] = exit_io_instruction,
+        [VCPU_RDMSR] = exit_rdmsr,
+        [VCPU_WRMSR] = exit_wrmsr,
+        [VCPU_VM_ENTRY_FAILURE] = exit_vm_entry_failure,
+        [VCPU_EPT_VIOLATION] = exit_ept_violation,
+        [VCPU_XSETBV] = exit_xsetbv,
+        [VCPU_PAUSE] = exit_pause,
+        [VCPU_VMCALL] = exit_vmcall,
+#endif
+        [VCPU_UNKNOWN] = exit_unknown,
+        [VCPU_FAILURE] = exit_failure,
+};
+static_assert((sizeof(vcpu_exit_counters) / sizeof(vcpu_exit_counters[0])) == VCPU_EXIT_COUNT,
+              "vcpu_exit_counters array must match enum VcpuExit");
+
 void ktrace_report_vcpu_meta() {
     for (uint32_t i = 0; i != VCPU_META_COUNT; i++) {
         ktrace_name_etc(TAG_VCPU_META, i, 0, vcpu_meta[i], true);
@@ -60,6 +128,12 @@ void ktrace_vcpu(uint32_t tag, VcpuMeta meta) {
 }
 
 void ktrace_vcpu_exit(VcpuExit exit, uint64_t exit_address) {
+    kcounter_add(vcpu_exit_counters[exit], 1);
     ktrace(TAG_VCPU_EXIT, exit, static_cast<uint32_t>(exit_address),
            static_cast<uint32_t>(exit_address >> 32), 0);
-}
\ No newline at end of file
+}
+
+void ktrace_vcpu_halt_poll(bool hit) {
+    kcounter_add(hit ? halt_poll_hit : halt_poll_miss, 1);
+    ktrace(TAG_VCPU_UNBLOCK, VCPU_HALT_POLL, hit, 0, 0);
+}
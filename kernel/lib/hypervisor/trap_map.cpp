@@ -9,12 +9,15 @@
 #include <fbl/alloc_checker.h>
 #include <fbl/auto_lock.h>
 #include <hypervisor/ktrace.h>
+#include <lib/counters.h>
 #include <lib/ktrace.h>
 #include <zircon/syscalls/hypervisor.h>
 #include <zircon/types.h>
 
 static constexpr size_t kMaxPacketsPerRange = 256;
 
+KCOUNTER(bell_coalesced, "kernel.hypervisor.bell.coalesced");
+
 namespace hypervisor {
 
 BlockingPortAllocator::BlockingPortAllocator() : semaphore_(kMaxPacketsPerRange) {}
@@ -38,10 +41,27 @@ PortPacket* BlockingPortAllocator::Alloc() {
 }
 
 void BlockingPortAllocator::Free(PortPacket* port_packet) {
+    {
+        fbl::AutoLock lock(&pending_mutex_);
+        if (pending_ == port_packet) {
+            pending_ = nullptr;
+        }
+    }
     arena_.Delete(port_packet);
     semaphore_.Post();
 }
 
+void BlockingPortAllocator::SetPending(PortPacket* port_packet) {
+    fbl::AutoLock lock(&pending_mutex_);
+    pending_ = port_packet;
+}
+
+bool BlockingPortAllocator::BellPending(const zx_port_packet_t& packet) {
+    fbl::AutoLock lock(&pending_mutex_);
+    return pending_ != nullptr && pending_->packet.type == ZX_PKT_TYPE_GUEST_BELL &&
+           pending_->packet.guest_bell.addr == packet.guest_bell.addr;
+}
+
 Trap::Trap(uint32_t kind, zx_gpaddr_t addr, size_t len, fbl::RefPtr<PortDispatcher> port,
                      uint64_t key)
     : kind_(kind), addr_(addr), len_(len), port_(fbl::move(port)), key_(key) {
@@ -66,11 +86,23 @@ zx_status_t Trap::Queue(const zx_port_packet_t& packet, StateInvalidator* invali
     if (port_ == nullptr) {
         return ZX_ERR_NOT_FOUND;
     }
+    // A bell that rings again before the packet for its previous ring has been
+    // dequeued is folded into that packet. The packet is freed under the port
+    // lock once it has been copied out, so whoever dequeues it handles the
+    // state that led to this ring as well.
+    const bool bell = packet.type == ZX_PKT_TYPE_GUEST_BELL;
+    if (bell && port_allocator_.BellPending(packet)) {
+        kcounter_add(bell_coalesced, 1);
+        return ZX_OK;
+    }
     PortPacket* port_packet = port_allocator_.AllocBlocking();
     if (port_packet == nullptr) {
         return ZX_ERR_NO_MEMORY;
     }
     port_packet->packet = packet;
+    if (bell) {
+        port_allocator_.SetPending(port_packet);
+    }
     zx_status_t status = port_->Queue(port_packet, ZX_SIGNAL_NONE, 0);
     if (status != ZX_OK) {
         port_allocator_.Free(port_packet);
@@ -80,52 +112,84 @@ zx_status_t Trap::Queue(const zx_port_packet_t& packet, StateInvalidator* invali
 
 zx_status_t TrapMap::InsertTrap(uint32_t kind, zx_gpaddr_t addr, size_t len,
                                 fbl::RefPtr<PortDispatcher> port, uint64_t key) {
-    TrapTree* traps = TreeOf(kind);
+    TrapSet* traps = SetOf(kind);
     if (traps == nullptr) {
         return ZX_ERR_INVALID_ARGS;
     }
-    auto iter = traps->find(addr);
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<Trap> range(new (&ac) Trap(kind, addr, len, fbl::move(port), key));
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    zx_status_t status = range->Init();
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    fbl::AutoLock lock(&mutex_);
+    auto iter = traps->tree.find(addr);
     if (iter.IsValid()) {
         dprintf(INFO, "Trap for kind %u (addr %#lx len %lu key %lu) already exists "
                 "(addr %#lx len %lu key %lu)\n", kind, addr, len, key, iter->addr(), iter->len(),
                 iter->key());
         return ZX_ERR_ALREADY_EXISTS;
     }
+    traps->tree.insert(fbl::move(range));
+    status = PublishLocked(traps);
+    if (status != ZX_OK) {
+        traps->tree.erase(addr);
+    }
+    return status;
+}
+
+zx_status_t TrapMap::PublishLocked(TrapSet* traps) {
     fbl::AllocChecker ac;
-    fbl::unique_ptr<Trap> range(new (&ac) Trap(kind, addr, len, fbl::move(port), key));
+    fbl::unique_ptr<TrapTable> table(new (&ac) TrapTable);
     if (!ac.check()) {
         return ZX_ERR_NO_MEMORY;
     }
-    zx_status_t status = range->Init();
-    if (status != ZX_OK) {
-        return status;
+    size_t count = traps->tree.size();
+    table->traps.reset(new (&ac) Trap*[count], count);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
     }
-    {
-        fbl::AutoLock lock(&mutex_);
-        traps->insert(fbl::move(range));
+    size_t i = 0;
+    for (auto& trap : traps->tree) {
+        table->traps[i++] = &trap;
     }
+    traps->table.store(table.get(), fbl::memory_order_release);
+    tables_.push_front(fbl::move(table));
     return ZX_OK;
 }
 
 zx_status_t TrapMap::FindTrap(uint32_t kind, zx_gpaddr_t addr, Trap** trap) {
-    TrapTree* traps = TreeOf(kind);
+    TrapSet* traps = SetOf(kind);
     if (traps == nullptr) {
         return ZX_ERR_INVALID_ARGS;
     }
-    TrapTree::iterator iter;
-    {
-        fbl::AutoLock lock(&mutex_);
-        iter = traps->upper_bound(addr);
+    const TrapTable* table = traps->table.load(fbl::memory_order_acquire);
+    if (table == nullptr) {
+        return ZX_ERR_NOT_FOUND;
+    }
+    // Find the last trap that starts at or before |addr|.
+    size_t begin = 0;
+    size_t end = table->traps.size();
+    while (begin < end) {
+        size_t mid = begin + (end - begin) / 2;
+        if (table->traps[mid]->addr() <= addr) {
+            begin = mid + 1;
+        } else {
+            end = mid;
+        }
     }
-    --iter;
-    if (!iter.IsValid() || !iter->Contains(addr)) {
+    if (begin == 0 || !table->traps[begin - 1]->Contains(addr)) {
         return ZX_ERR_NOT_FOUND;
     }
-    *trap = const_cast<Trap*>(&*iter);
+    *trap = table->traps[begin - 1];
     return ZX_OK;
 }
 
-TrapMap::TrapTree* TrapMap::TreeOf(uint32_t kind) {
+TrapMap::TrapSet* TrapMap::SetOf(uint32_t kind) {
     switch (kind) {
     case ZX_GUEST_TRAP_BELL:
     case ZX_GUEST_TRAP_MEM:
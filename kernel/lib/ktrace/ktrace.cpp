@@ -6,13 +6,19 @@
 
 #include <debug.h>
 #include <err.h>
+#include <inttypes.h>
 #include <platform.h>
 #include <string.h>
 
 #include <arch/ops.h>
 #include <arch/user_copy.h>
+#include <fbl/algorithm.h>
+#include <fbl/atomic.h>
 #include <hypervisor/ktrace.h>
+#include <kernel/align.h>
+#include <kernel/auto_lock.h>
 #include <kernel/cmdline.h>
+#include <kernel/spinlock.h>
 #include <lib/ktrace.h>
 #include <lk/init.h>
 #include <object/thread_dispatcher.h>
@@ -75,88 +81,343 @@ static void ktrace_report_probes(void) {
     }
 }
 
-typedef struct ktrace_state {
-    // where the next record will be written
-    int offset;
+// Size of the buffer that holds the version, syscall, probe and vcpu
+// metadata. It is carved out of the front of the trace buffer so that the
+// metadata survives circular tracing.
+#define KTRACE_META_BUFSIZE (64 * 1024)
+
+enum ktrace_mode {
+    // Stop tracing as soon as any buffer fills up.
+    KTRACE_MODE_ONESHOT,
+    // Overwrite the oldest records of a cpu when its buffer fills up.
+    KTRACE_MODE_CIRCULAR,
+    // Drop new records of a cpu while its buffer is full, and let
+    // zx_ktrace_read() consume records as they are written.
+    KTRACE_MODE_STREAMING,
+};
+
+// A ring of records. |head| and |tail| are free running byte counts and
+// the ring holds the bytes [tail, head), modulo |size|. Records may wrap
+// around the end of the ring; since every record is a multiple of 8 bytes
+// its tag word never does.
+//
+// Each cpu has its own ring which only that cpu writes, with interrupts
+// disabled, so tracing on different cpus never touches the same cache
+// line. |head| is only advanced by the writer. |tail| is advanced by the
+// writer in circular mode and by the reader in streaming mode.
+typedef struct ktrace_ring {
+    uint8_t* base;
+    uint32_t size;
+    fbl::atomic<uint64_t> head;
+    fbl::atomic<uint64_t> tail;
+    // records lost because the ring was full
+    fbl::atomic<uint64_t> dropped;
+} __CPU_ALIGN ktrace_ring_t;
 
+typedef struct ktrace_state {
     // mask of groups we allow, 0 == tracing disabled
     int grpmask;
 
-    // total size of the trace buffer
-    uint32_t bufsize;
+    // enum ktrace_mode, only changed while tracing is disabled
+    int mode;
 
-    // offset where tracing was stopped, 0 if tracing active
-    uint32_t marker;
+    // number of per-cpu rings in use
+    uint32_t num_cpus;
 
-    // raw trace buffer
+    // raw trace buffer, the metadata ring followed by the per-cpu rings
     uint8_t* buffer;
+
+    // the next cpu ring to drain in streaming mode, so that one busy cpu
+    // cannot starve the others
+    uint32_t drain_cpu TA_GUARDED(read_lock);
+
+    // serializes readers
+    fbl::Mutex read_lock;
+
+    // serializes writers of the metadata ring, which is shared by all cpus
+    SpinLock meta_lock;
+
+    ktrace_ring_t meta;
+    ktrace_ring_t cpus[SMP_MAX_CPUS];
 } ktrace_state_t;
 
 static ktrace_state_t KTRACE_STATE;
 
-ssize_t ktrace_read_user(void* ptr, uint32_t off, size_t len) {
-    ktrace_state_t* ks = &KTRACE_STATE;
+// Returns the length of the record that starts at |pos|.
+static uint32_t ktrace_ring_record_len(const ktrace_ring_t* ring, uint64_t pos) {
+    uint32_t tag;
+    memcpy(&tag, ring->base + pos % ring->size, sizeof(tag));
+    // A zero length can only come from a corrupted ring; step over it
+    // rather than spinning on it.
+    return fbl::max(KTRACE_LEN(tag), 8u);
+}
+
+static void ktrace_ring_copy_in(ktrace_ring_t* ring, uint64_t pos, const void* data, uint32_t len) {
+    uint32_t off = static_cast<uint32_t>(pos % ring->size);
+    uint32_t first = fbl::min(len, ring->size - off);
+    memcpy(ring->base + off, data, first);
+    memcpy(ring->base, static_cast<const uint8_t*>(data) + first, len - first);
+}
 
-    // Buffer size is limited by the marker if set,
-    // otherwise limited by offset (last written point).
-    // Offset can end up pointing past the end, so clip
-    // it to the actual buffer size to be safe.
-    uint32_t max;
-    if (ks->marker) {
-        max = ks->marker;
-    } else {
-        max = ks->offset;
-        if (max > ks->bufsize) {
-            max = ks->bufsize;
+static zx_status_t ktrace_ring_copy_out(const ktrace_ring_t* ring, uint64_t pos,
+                                        uint8_t* ptr, size_t len) {
+    uint32_t off = static_cast<uint32_t>(pos % ring->size);
+    size_t first = fbl::min(len, static_cast<size_t>(ring->size - off));
+    if (arch_copy_to_user(ptr, ring->base + off, first) != ZX_OK) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+    if (len > first && arch_copy_to_user(ptr + first, ring->base, len - first) != ZX_OK) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+    return ZX_OK;
+}
+
+// Appends the |len| byte record at |rec| to |ring|. The caller keeps the
+// ring from being written concurrently. If |stamp| is set, |rec| starts
+// with a ktrace_header_t whose timestamp is taken here, so that each ring
+// is in timestamp order. Returns false if the record was dropped.
+static bool ktrace_ring_append(ktrace_state_t* ks, ktrace_ring_t* ring, int mode,
+                               void* rec, uint32_t len, bool stamp) {
+    if (stamp) {
+        static_cast<ktrace_header_t*>(rec)->ts = ktrace_timestamp();
+    }
+
+    uint64_t head = ring->head.load(fbl::memory_order_relaxed);
+    uint64_t tail = ring->tail.load(fbl::memory_order_acquire);
+    if (head + len - tail > ring->size) {
+        if (mode != KTRACE_MODE_CIRCULAR || len > ring->size) {
+            if (mode == KTRACE_MODE_ONESHOT) {
+                // if we arrive at the end, stop
+                atomic_store(&ks->grpmask, 0);
+            }
+            ring->dropped.fetch_add(1, fbl::memory_order_relaxed);
+            return false;
         }
+        do {
+            tail += ktrace_ring_record_len(ring, tail);
+        } while (head + len - tail > ring->size);
+        ring->tail.store(tail, fbl::memory_order_release);
     }
 
-    // null read is a query for trace buffer size
-    if (ptr == nullptr) {
-        return max;
+    ktrace_ring_copy_in(ring, head, rec, len);
+    ring->head.store(head + len, fbl::memory_order_release);
+    return true;
+}
+
+// Appends a record to the current cpu's ring.
+static bool ktrace_commit(ktrace_state_t* ks, void* rec, uint32_t len, bool stamp) {
+    bool written = false;
+    spin_lock_saved_state_t state;
+    arch_interrupt_save(&state, SPIN_LOCK_FLAG_INTERRUPTS);
+    ktrace_ring_t* ring = &ks->cpus[arch_curr_cpu_num()];
+    if (ring->size) {
+        written = ktrace_ring_append(ks, ring, atomic_load(&ks->mode), rec, len, stamp);
     }
+    arch_interrupt_restore(state, SPIN_LOCK_FLAG_INTERRUPTS);
+    return written;
+}
+
+// Appends a record to the metadata ring, which never overwrites.
+static void ktrace_commit_meta(ktrace_state_t* ks, void* rec, uint32_t len) {
+    AutoSpinLock guard(&ks->meta_lock);
+    if (ks->meta.size) {
+        ktrace_ring_append(ks, &ks->meta, KTRACE_MODE_STREAMING, rec, len, false);
+    }
+}
+
+// Set by the last init hook, after which the init hook timings are final.
+static fbl::atomic_bool init_hooks_done;
+
+// Reports when each init hook ran on the boot cpu and how long it took.
+static void ktrace_report_init_hooks(ktrace_state_t* ks) {
+    if (!init_hooks_done.load()) {
+        return;
+    }
+    size_t count;
+    const lk_init_timing* timings = lk_init_timings(&count);
+    for (size_t i = 0; i < count; i++) {
+        uint32_t num = static_cast<uint32_t>(i);
+        ktrace_name_etc(TAG_INIT_HOOK_NAME, num, timings[i].init->level,
+                        timings[i].init->name, true);
+        ktrace_rec_32b_t rec = {};
+        rec.tag = TAG_INIT_HOOK;
+        rec.ts = timings[i].start;
+        rec.a = num;
+        rec.b = timings[i].init->level;
+        rec.c = static_cast<uint32_t>(timings[i].duration);
+        rec.d = static_cast<uint32_t>(timings[i].duration >> 32);
+        ktrace_commit_meta(ks, &rec, sizeof(rec));
+    }
+}
+
+static void ktrace_ring_reset(ktrace_ring_t* ring, uint64_t pos) {
+    ring->tail.store(0, fbl::memory_order_relaxed);
+    ring->head.store(pos, fbl::memory_order_relaxed);
+    ring->dropped.store(0, fbl::memory_order_relaxed);
+}
+
+// Empties the metadata ring except for the version and tick rate records
+// in the first two event slots.
+static void ktrace_rewind_meta(ktrace_state_t* ks) {
+    AutoSpinLock guard(&ks->meta_lock);
+    if (ks->meta.size == 0) {
+        return;
+    }
+
+    uint64_t n = ktrace_ticks_per_ms();
+    ktrace_rec_32b_t* rec = (ktrace_rec_32b_t*) ks->meta.base;
+    memset(rec, 0, KTRACE_RECSIZE * 2);
+    rec[0].tag = TAG_VERSION;
+    rec[0].a = KTRACE_VERSION;
+    rec[1].tag = TAG_TICKS_PER_MS;
+    rec[1].a = (uint32_t)n;
+    rec[1].b = (uint32_t)(n >> 32);
+    ktrace_ring_reset(&ks->meta, KTRACE_RECSIZE * 2);
+}
+
+static uint64_t ktrace_ring_pending(const ktrace_ring_t* ring) {
+    return ring->head.load(fbl::memory_order_acquire) -
+           ring->tail.load(fbl::memory_order_acquire);
+}
 
-    // constrain read to available buffer
-    if (off >= max) {
+// Moves as many whole records as fit in |len| bytes out of |ring|.
+static ssize_t ktrace_ring_drain(ktrace_ring_t* ring, uint8_t* ptr, size_t len) {
+    uint64_t head = ring->head.load(fbl::memory_order_acquire);
+    uint64_t tail = ring->tail.load(fbl::memory_order_relaxed);
+    uint64_t end = tail;
+    while (end < head) {
+        uint32_t n = ktrace_ring_record_len(ring, end);
+        if (end + n - tail > len) {
+            break;
+        }
+        end += n;
+    }
+    size_t n = static_cast<size_t>(end - tail);
+    if (n == 0) {
         return 0;
     }
-    if (len > (max - off)) {
-        len = max - off;
+    zx_status_t status = ktrace_ring_copy_out(ring, tail, ptr, n);
+    if (status != ZX_OK) {
+        return status;
     }
+    ring->tail.store(end, fbl::memory_order_release);
+    return n;
+}
 
-    if (arch_copy_to_user(ptr, ks->buffer + off, len) != ZX_OK) {
-        return ZX_ERR_INVALID_ARGS;
+// In streaming mode each read consumes whole records, the metadata first
+// and then the cpus in turn, and |off| is ignored.
+static ssize_t ktrace_read_streaming(ktrace_state_t* ks, uint8_t* ptr, size_t len)
+    TA_REQ(ks->read_lock) {
+    size_t actual = 0;
+    ssize_t n = ktrace_ring_drain(&ks->meta, ptr, len);
+    if (n < 0) {
+        return n;
+    }
+    actual += n;
+    for (uint32_t i = 0; i < ks->num_cpus; i++) {
+        ktrace_ring_t* ring = &ks->cpus[ks->drain_cpu];
+        ks->drain_cpu = (ks->drain_cpu + 1) % ks->num_cpus;
+        n = ktrace_ring_drain(ring, ptr + actual, len - actual);
+        if (n < 0) {
+            return n;
+        }
+        actual += n;
+    }
+    return actual;
+}
+
+// Otherwise the trace reads as one file: the metadata followed by the
+// records of each cpu, oldest first.
+static ssize_t ktrace_read_file(ktrace_state_t* ks, uint8_t* ptr, uint64_t off, size_t len)
+    TA_REQ(ks->read_lock) {
+    size_t actual = 0;
+    for (uint32_t i = 0; i <= ks->num_cpus && len > actual; i++) {
+        const ktrace_ring_t* ring = (i == 0) ? &ks->meta : &ks->cpus[i - 1];
+        uint64_t tail = ring->tail.load(fbl::memory_order_acquire);
+        uint64_t size = ring->head.load(fbl::memory_order_acquire) - tail;
+        if (off >= size) {
+            off -= size;
+            continue;
+        }
+        size_t n = static_cast<size_t>(fbl::min(size - off, static_cast<uint64_t>(len - actual)));
+        zx_status_t status = ktrace_ring_copy_out(ring, tail + off, ptr + actual, n);
+        if (status != ZX_OK) {
+            return status;
+        }
+        actual += n;
+        off = 0;
+    }
+    return actual;
+}
+
+ssize_t ktrace_read_user(void* ptr, uint32_t off, size_t len) {
+    ktrace_state_t* ks = &KTRACE_STATE;
+    fbl::AutoLock lock(&ks->read_lock);
+
+    // null read is a query for the number of bytes available
+    if (ptr == nullptr) {
+        uint64_t size = ktrace_ring_pending(&ks->meta);
+        for (uint32_t i = 0; i < ks->num_cpus; i++) {
+            size += ktrace_ring_pending(&ks->cpus[i]);
+        }
+        return static_cast<ssize_t>(size);
+    }
+
+    if (atomic_load(&ks->mode) == KTRACE_MODE_STREAMING) {
+        return ktrace_read_streaming(ks, static_cast<uint8_t*>(ptr), len);
+    }
+    return ktrace_read_file(ks, static_cast<uint8_t*>(ptr), off, len);
+}
+
+static void ktrace_report_dropped(ktrace_state_t* ks) {
+    uint64_t dropped = ks->meta.dropped.load(fbl::memory_order_relaxed);
+    for (uint32_t i = 0; i < ks->num_cpus; i++) {
+        dropped += ks->cpus[i].dropped.load(fbl::memory_order_relaxed);
+    }
+    if (dropped) {
+        dprintf(INFO, "ktrace: %" PRIu64 " records dropped\n", dropped);
     }
-    return len;
 }
 
 zx_status_t ktrace_control(uint32_t action, uint32_t options, void* ptr) {
     ktrace_state_t* ks = &KTRACE_STATE;
     switch (action) {
-    case KTRACE_ACTION_START:
-        options = KTRACE_GRP_TO_MASK(options);
-        ks->marker = 0;
-        atomic_store(&ks->grpmask, options ? options : KTRACE_GRP_TO_MASK(KTRACE_GRP_ALL));
+    case KTRACE_ACTION_START: {
+        if (ks->buffer == nullptr) {
+            return ZX_ERR_BAD_STATE;
+        }
+        int mode = KTRACE_MODE_ONESHOT;
+        if (options & KTRACE_START_STREAMING) {
+            mode = KTRACE_MODE_STREAMING;
+        } else if (options & KTRACE_START_CIRCULAR) {
+            mode = KTRACE_MODE_CIRCULAR;
+        }
+        atomic_store(&ks->mode, mode);
+        int grpmask = KTRACE_GRP_TO_MASK(options & KTRACE_GRP_ALL);
+        atomic_store(&ks->grpmask, grpmask ? grpmask : KTRACE_GRP_TO_MASK(KTRACE_GRP_ALL));
         ktrace_report_live_processes();
         ktrace_report_live_threads();
         break;
-    case KTRACE_ACTION_STOP: {
+    }
+    case KTRACE_ACTION_STOP:
         atomic_store(&ks->grpmask, 0);
-        uint32_t n = ks->offset;
-        if (n > ks->bufsize) {
-            ks->marker = ks->bufsize;
-        } else {
-            ks->marker = n;
-        }
+        ktrace_report_dropped(ks);
         break;
-    }
-    case KTRACE_ACTION_REWIND:
-        // roll back to just after the metadata
-        atomic_store(&ks->offset, KTRACE_RECSIZE * 2);
+    case KTRACE_ACTION_REWIND: {
+        {
+            fbl::AutoLock lock(&ks->read_lock);
+            ktrace_rewind_meta(ks);
+            for (uint32_t i = 0; i < ks->num_cpus; i++) {
+                ktrace_ring_reset(&ks->cpus[i], 0);
+            }
+            ks->drain_cpu = 0;
+        }
         ktrace_report_syscalls(kt_syscall_info);
         ktrace_report_probes();
         ktrace_report_vcpu_meta();
+        ktrace_report_init_hooks(ks);
         break;
+    }
     case KTRACE_ACTION_NEW_PROBE: {
         fbl::AutoLock lock(&probe_list_lock);
         ktrace_probe_info_t* probe;
@@ -201,11 +462,25 @@ void ktrace_init(unsigned level) {
         return;
     }
 
-    // The last packet written can overhang the end of the buffer,
-    // so we reduce the reported size by the max size of a record
-    ks->bufsize = mb - 256;
+    // Split what is left after the metadata evenly between the cpus, giving
+    // each cpu whole pages.
+    uint32_t meta_size = KTRACE_META_BUFSIZE;
+    ks->num_cpus = arch_max_num_cpus();
+    uint32_t cpu_size = ROUNDDOWN((mb - meta_size) / ks->num_cpus, PAGE_SIZE);
+    ks->meta.base = ks->buffer;
+    ks->meta.size = meta_size;
+    for (uint32_t i = 0; i < ks->num_cpus; i++) {
+        ks->cpus[i].base = ks->buffer + meta_size + i * cpu_size;
+        ks->cpus[i].size = cpu_size;
+    }
+
+    dprintf(INFO, "ktrace: buffer at %p (%u bytes, %u per cpu)\n", ks->buffer, mb, cpu_size);
+
+    if (cmdline_get_bool("ktrace.circular", false)) {
+        ks->mode = KTRACE_MODE_CIRCULAR;
+    }
 
-    dprintf(INFO, "ktrace: buffer at %p (%u bytes)\n", ks->buffer, mb);
+    ktrace_rewind_meta(ks);
 
     // register all static probes
     {
@@ -217,17 +492,7 @@ void ktrace_init(unsigned level) {
         }
     }
 
-    // write metadata to the first two event slots
-    uint64_t n = ktrace_ticks_per_ms();
-    ktrace_rec_32b_t* rec = (ktrace_rec_32b_t*) ks->buffer;
-    rec[0].tag = TAG_VERSION;
-    rec[0].a = KTRACE_VERSION;
-    rec[1].tag = TAG_TICKS_PER_MS;
-    rec[1].a = (uint32_t)n;
-    rec[1].b = (uint32_t)(n >> 32);
-
     // enable tracing
-    atomic_store(&ks->offset, KTRACE_RECSIZE * 2);
     ktrace_report_syscalls(kt_syscall_info);
     ktrace_report_probes();
     atomic_store(&ks->grpmask, KTRACE_GRP_TO_MASK(grpmask));
@@ -248,38 +513,27 @@ void ktrace_init(unsigned level) {
 void ktrace_tiny(uint32_t tag, uint32_t arg) {
     ktrace_state_t* ks = &KTRACE_STATE;
     if (tag & atomic_load(&ks->grpmask)) {
-        tag = (tag & 0xFFFFFFF0) | 2;
-        int off;
-        if ((off = atomic_add(&ks->offset, KTRACE_HDRSIZE)) >= (int)ks->bufsize) {
-            // if we arrive at the end, stop
-            atomic_store(&ks->grpmask, 0);
-        } else {
-            ktrace_header_t* hdr = (ktrace_header_t*) (ks->buffer + off);
-            hdr->ts = ktrace_timestamp();
-            hdr->tag = tag;
-            hdr->tid = arg;
-        }
+        ktrace_header_t hdr;
+        hdr.tag = (tag & 0xFFFFFFF0) | 2;
+        hdr.tid = arg;
+        ktrace_commit(ks, &hdr, sizeof(hdr), true);
     }
 }
 
-void* ktrace_open(uint32_t tag) {
+bool ktrace_write(uint32_t tag, const void* payload) {
     ktrace_state_t* ks = &KTRACE_STATE;
     if (!(tag & atomic_load(&ks->grpmask))) {
-        return nullptr;
-    }
-
-    int off;
-    if ((off = atomic_add(&ks->offset, KTRACE_LEN(tag))) >= (int)ks->bufsize) {
-        // if we arrive at the end, stop
-        atomic_store(&ks->grpmask, 0);
-        return nullptr;
+        return false;
     }
 
-    ktrace_header_t* hdr = (ktrace_header_t*) (ks->buffer + off);
-    hdr->ts = ktrace_timestamp();
+    uint64_t rec[KTRACE_MAXSIZE / sizeof(uint64_t)];
+    uint32_t len = KTRACE_LEN(tag);
+    DEBUG_ASSERT(len >= KTRACE_HDRSIZE);
+    ktrace_header_t* hdr = reinterpret_cast<ktrace_header_t*>(rec);
     hdr->tag = tag;
     hdr->tid = (uint32_t)get_current_thread()->user_tid;
-    return hdr + 1;
+    memcpy(hdr + 1, payload, len - KTRACE_HDRSIZE);
+    return ktrace_commit(ks, rec, len, true);
 }
 
 void ktrace_name_etc(uint32_t tag, uint32_t id, uint32_t arg, const char* name, bool always) {
@@ -290,19 +544,28 @@ void ktrace_name_etc(uint32_t tag, uint32_t id, uint32_t arg, const char* name,
         // set size to: sizeof(hdr) + len + 1, round up to multiple of 8
         tag = (tag & 0xFFFFFFF0) | ((KTRACE_NAMESIZE + len + 1 + 7) >> 3);
 
-        int off;
-        if ((off = atomic_add(&ks->offset, KTRACE_LEN(tag))) >= (int)ks->bufsize) {
-            // if we arrive at the end, stop
-            atomic_store(&ks->grpmask, 0);
+        uint64_t buf[KTRACE_MAXSIZE / sizeof(uint64_t)] = {};
+        ktrace_rec_name_t* rec = reinterpret_cast<ktrace_rec_name_t*>(buf);
+        rec->tag = tag;
+        rec->id = id;
+        rec->arg = arg;
+        memcpy(rec->name, name, len);
+        rec->name[len] = 0;
+
+        // Names reported regardless of the group mask are metadata, which
+        // must not be overwritten by circular tracing.
+        if (always) {
+            ktrace_commit_meta(ks, rec, KTRACE_LEN(tag));
         } else {
-            ktrace_rec_name_t* rec = (ktrace_rec_name_t*) (ks->buffer + off);
-            rec->tag = tag;
-            rec->id = id;
-            rec->arg = arg;
-            memcpy(rec->name, name, len);
-            rec->name[len] = 0;
+            ktrace_commit(ks, rec, KTRACE_LEN(tag), false);
         }
     }
 }
 
+static void ktrace_init_hooks_done(unsigned level) {
+    init_hooks_done.store(true);
+    ktrace_report_init_hooks(&KTRACE_STATE);
+}
+
 LK_INIT_HOOK(ktrace, ktrace_init, LK_INIT_LEVEL_USER);
+LK_INIT_HOOK(ktrace_init_hooks, ktrace_init_hooks_done, LK_INIT_LEVEL_LAST);
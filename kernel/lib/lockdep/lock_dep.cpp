@@ -13,7 +13,9 @@
 #include <vm/vm.h>
 
 #include <lib/console.h>
+#include <lib/ktrace.h>
 #include <lib/version.h>
+#include <platform.h>
 
 #include <inttypes.h>
 #include <string.h>
@@ -81,6 +83,42 @@ void DumpLockClassState() {
     }
 }
 
+#if WITH_LOCK_PROF
+// Prints one line of histogram buckets.
+void DumpHistogram(const char* label, const lockdep::LockClassProfile& profile, bool wait) {
+    printf("    %s:", label);
+    for (size_t i = 0; i < lockdep::kLockProfileBuckets; i++)
+        printf(" %" PRIu64, wait ? profile.wait_histogram(i) : profile.hold_histogram(i));
+    printf("\n");
+}
+
+// Dumps the contention statistics of every lock class acquired so far.
+void DumpLockClassProfiles() {
+    printf("Lock class profiles (histogram bucket 0 < 256ns, then log2 up to 4ms):\n");
+    for (auto& state : lockdep::LockClassState::Iter()) {
+        const lockdep::LockClassProfile& profile = state.profile();
+        const uint64_t acquisitions = profile.acquisitions();
+        if (acquisitions == 0)
+            continue;
+
+        printf("  %s id %#" PRIxPTR "\n", state.name(), state.id());
+        printf("    acquisitions %" PRIu64 " contended %" PRIu64 "\n",
+               acquisitions, profile.contentions());
+        printf("    wait total %" PRIu64 "ns max %" PRIu64 "ns"
+               " hold total %" PRIu64 "ns max %" PRIu64 "ns\n",
+               profile.total_wait_ns(), profile.max_wait_ns(),
+               profile.total_hold_ns(), profile.max_hold_ns());
+        DumpHistogram("wait", profile, true);
+        DumpHistogram("hold", profile, false);
+    }
+}
+
+void ResetLockClassProfiles() {
+    for (auto& state : lockdep::LockClassState::Iter())
+        state.profile().Reset();
+}
+#endif
+
 // Top-level lockdep command.
 int CommandLockDep(int argc, const cmd_args* argv, uint32_t flags) {
     if (argc < 2) {
@@ -88,6 +126,9 @@ int CommandLockDep(int argc, const cmd_args* argv, uint32_t flags) {
     usage:
         printf("%s dump              : dump lock classes\n", argv[0].str);
         printf("%s loop              : trigger loop detection pass\n", argv[0].str);
+#if WITH_LOCK_PROF
+        printf("%s prof [reset]      : dump or clear lock contention profiles\n", argv[0].str);
+#endif
         return -1;
     }
 
@@ -96,6 +137,13 @@ int CommandLockDep(int argc, const cmd_args* argv, uint32_t flags) {
     } else if (strcmp(argv[1].str, "loop") == 0) {
         printf("Triggering loop detection pass:\n");
         lockdep::SystemTriggerLoopDetection();
+#if WITH_LOCK_PROF
+    } else if (strcmp(argv[1].str, "prof") == 0) {
+        if (argc > 2 && strcmp(argv[2].str, "reset") == 0)
+            ResetLockClassProfiles();
+        else
+            DumpLockClassProfiles();
+#endif
     } else {
         printf("Unrecognized subcommand: '%s'\n", argv[1].str);
         goto usage;
@@ -204,6 +252,28 @@ void SystemTriggerLoopDetection() {
     event_signal(&graph_edge_event, /*reschedule=*/false);
 }
 
+#if WITH_LOCK_PROF
+// Returns the timestamp used to measure lock wait and hold times.
+uint64_t SystemGetLockProfileTimestamp() {
+    return current_time();
+}
+
+// Emits a ktrace record for a contended acquisition.
+void SystemLockContended(uintptr_t lock_class_id, uint64_t wait_time_ns) {
+    ktrace(TAG_LOCK_CONTENDED,
+           static_cast<uint32_t>(lock_class_id >> 32), static_cast<uint32_t>(lock_class_id),
+           static_cast<uint32_t>(wait_time_ns >> 32), static_cast<uint32_t>(wait_time_ns));
+}
+#endif
+
 } // namespace lockdep
 
+#if WITH_LOCK_PROF
+// Called by the mutex and spinlock slow paths to mark the acquisition in
+// progress as contended.
+void lockdep_note_contention() {
+    lockdep::ThreadLockState::Get()->NoteContention();
+}
+#endif
+
 #endif
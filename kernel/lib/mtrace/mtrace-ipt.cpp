@@ -86,6 +86,19 @@ zx_status_t mtrace_insntrace_control(uint32_t action, uint32_t options,
         return ZX_OK;
     }
 
+    case MTRACE_INSNTRACE_SNAPSHOT_TRACE_DATA: {
+        zx_x86_pt_regs_t regs;
+        if (size != sizeof(regs))
+            return ZX_ERR_INVALID_ARGS;
+        zx_itrace_buffer_descriptor_t descriptor = options;
+        auto status = x86_ipt_snapshot_trace_data(descriptor, &regs);
+        if (status != ZX_OK)
+            return status;
+        LTRACEF("action %u, descriptor %u, output_base 0x%" PRIx64 ", output_mask_ptrs 0x%" PRIx64 "\n",
+                action, descriptor, regs.output_base, regs.output_mask_ptrs);
+        return arg.reinterpret<zx_x86_pt_regs_t>().copy_to_user(regs);
+    }
+
     case MTRACE_INSNTRACE_START:
         if (options != 0 || size != 0)
             return ZX_ERR_INVALID_ARGS;
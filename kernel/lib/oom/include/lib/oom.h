@@ -14,8 +14,8 @@ typedef void(oom_lowmem_callback_t)(size_t shortfall_bytes);
 
 // Initializes the out-of-memory system. If |enable| is true, starts the
 // memory-watcher thread, which calls |lowmem_callback| when the PMM has less
-// than |redline_bytes| free memory, sleeping for |sleep_duration_ns| between
-// checks.
+// than |redline_bytes| free memory and reclaiming idle pages could not make up
+// the difference, sleeping for |sleep_duration_ns| between checks.
 //
 // If |enable| is false, the thread can be started manually using 'k oom start'.
 // TODO(dbort): Add a programmatic way to start/stop the thread.
@@ -13,11 +13,13 @@
 #include <platform.h>
 #include <pretty/sizes.h>
 #include <vm/pmm.h>
+#include <vm/reclaim.h>
 #include <zircon/errors.h>
 #include <zircon/time.h>
 #include <zircon/types.h>
 
 #include <inttypes.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/types.h>
 
@@ -57,6 +59,7 @@ static int oom_loop(void* arg) {
         const size_t free_bytes = pmm_count_free_pages() * PAGE_SIZE;
 
         bool lowmem = false;
+        bool simulated = false;
         bool printing = false;
         size_t shortfall_bytes = 0;
         oom_lowmem_callback_t* lowmem_callback = nullptr;
@@ -69,6 +72,7 @@ static int oom_loop(void* arg) {
             if (oom_simulate_lowmem) {
                 printf("OOM: simulating low-memory situation\n");
             }
+            simulated = oom_simulate_lowmem;
             lowmem = free_bytes < oom_redline_bytes || oom_simulate_lowmem;
             if (lowmem) {
                 shortfall_bytes =
@@ -106,6 +110,23 @@ static int oom_loop(void* arg) {
         }
         last_free_bytes = free_bytes;
 
+        // Try to make up the shortfall by evicting idle pages before killing
+        // anything. A simulated low-memory event always goes to the callback.
+        if (lowmem && !simulated) {
+            const size_t shortfall_pages = ROUNDUP(shortfall_bytes, PAGE_SIZE) / PAGE_SIZE;
+            const size_t reclaimed_bytes = vm_reclaim_pages(shortfall_pages) * PAGE_SIZE;
+            if (reclaimed_bytes > 0) {
+                char reclaimed_buf[MAX_FORMAT_SIZE_LEN];
+                format_size(reclaimed_buf, sizeof(reclaimed_buf), reclaimed_bytes);
+                printf("OOM: reclaimed %s\n", reclaimed_buf);
+            }
+            if (reclaimed_bytes >= shortfall_bytes) {
+                lowmem = false;
+            } else {
+                shortfall_bytes -= reclaimed_bytes;
+            }
+        }
+
         if (lowmem) {
             lowmem_callback(shortfall_bytes);
         }
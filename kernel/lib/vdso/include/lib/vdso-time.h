@@ -0,0 +1,54 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#pragma once
+
+// This file is used both in the kernel and in the vDSO implementation.
+// So it must be compatible with both the kernel and userland header
+// environments.  It must use only the basic types so that struct
+// layouts match exactly in both contexts.
+
+#define VDSO_TIME_ALIGN 8
+#define VDSO_TIME_SIZE (6 * 4 + 8)
+
+// The time data gets a page of its own in the vDSO image, so that the
+// pages the variant vDSOs modify are never the one the kernel updates.
+#define VDSO_TIME_PAGE_SIZE 4096
+
+#ifndef __ASSEMBLER__
+
+#include <stdint.h>
+
+// This struct holds what user mode needs to read the clocks without
+// entering the kernel.  Unlike vdso_constants, the kernel updates it
+// while processes are reading it.  Each update is bracketed by two
+// increments of |seq|, so readers retry while |seq| is odd or changed
+// under them.
+struct vdso_time {
+    uint32_t seq;
+
+    // Nonzero if the kernel's monotonic clock is the counter read by
+    // zx_ticks_get() converted with |ns_per_tick|.  Otherwise the clocks
+    // have to be read by the kernel.
+    uint32_t user_ticks;
+
+    // The struct fp_32_64 the kernel converts ticks to nanoseconds with.
+    uint32_t ns_per_tick_l0;
+    uint32_t ns_per_tick_l32;
+    uint32_t ns_per_tick_l64;
+
+    uint32_t reserved;
+
+    // What zx_clock_adjust() last set as ZX_CLOCK_UTC - ZX_CLOCK_MONOTONIC.
+    int64_t utc_offset;
+};
+
+static_assert(VDSO_TIME_SIZE == sizeof(vdso_time),
+              "Need to adjust VDSO_TIME_SIZE");
+static_assert(VDSO_TIME_ALIGN == alignof(vdso_time),
+              "Need to adjust VDSO_TIME_ALIGN");
+
+#endif // __ASSEMBLER__
@@ -50,6 +50,10 @@ public:
     // Return a handle to the VMO for the given variant.
     HandleOwner vmo_handle(Variant) const;
 
+    // Publish a new ZX_CLOCK_UTC offset to user mode.  The caller
+    // serializes calls.
+    static void SetUtcOffset(int64_t offset);
+
 private:
     VDso();
     void CreateVariant(Variant);
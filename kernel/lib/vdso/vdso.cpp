@@ -6,10 +6,12 @@
 
 #include <lib/vdso.h>
 #include <lib/vdso-constants.h>
+#include <lib/vdso-time.h>
 
 #include <fbl/alloc_checker.h>
 #include <fbl/type_support.h>
 #include <kernel/cmdline.h>
+#include <lib/fixed_point.h>
 #include <object/handle.h>
 #include <platform.h>
 #include <vm/pmm.h>
@@ -200,6 +202,11 @@ void blacklist_##category##_syscalls(VDsoDynSymWindow& dynsym_window, \
 #undef SYSCALL_IN_CATEGORY_END
 #undef SYSCALL_CATEGORY_END
 
+// The kernel's mapping of the vDSO time data.  Unlike the constants
+// window, this one lives as long as the system, since the kernel keeps
+// updating the time data after boot.
+KernelVmoWindow<vdso_time>* time_window;
+
 } // anonymous namespace
 
 const VDso* VDso::instance_ = NULL;
@@ -239,7 +246,8 @@ const VDso* VDso::Create() {
 
     // If ticks_per_second has not been calibrated, it will return 0. In this
     // case, use soft_ticks instead.
-    if (per_second == 0 || cmdline_get_bool("vdso.soft_ticks", false)) {
+    bool soft_ticks = per_second == 0 || cmdline_get_bool("vdso.soft_ticks", false);
+    if (soft_ticks) {
         // Make zx_ticks_per_second return nanoseconds per second.
         constants_window.data()->ticks_per_second = ZX_SEC(1);
 
@@ -248,6 +256,27 @@ const VDso* VDso::Create() {
         REDIRECT_SYSCALL(dynsym_window, zx_ticks_get, soft_ticks_get);
     }
 
+    // Let the vDSO read the clocks without entering the kernel when the
+    // kernel's time is a plain conversion of the user-visible counter.
+    static_assert(sizeof(vdso_time) == VDSO_DATA_TIME_SIZE,
+                  "gen-rodso-code.sh is suspect");
+    static_assert(VDSO_DATA_TIME % VDSO_TIME_PAGE_SIZE == 0,
+                  "vDSO time data must have a page of its own");
+    time_window = new(&ac) KernelVmoWindow<vdso_time>(
+        "vDSO time", vdso->vmo()->vmo(), VDSO_DATA_TIME);
+    ASSERT(ac.check());
+    struct fp_32_64 ns_per_tick = {};
+    bool user_ticks = !soft_ticks && platform_get_user_timebase(&ns_per_tick);
+    *time_window->data() = (vdso_time) {
+        0,
+        user_ticks,
+        ns_per_tick.l0,
+        ns_per_tick.l32,
+        ns_per_tick.l64,
+        0,
+        0,
+    };
+
     for (size_t v = static_cast<size_t>(Variant::FULL) + 1;
          v < static_cast<size_t>(Variant::COUNT);
          ++v)
@@ -257,6 +286,15 @@ const VDso* VDso::Create() {
     return instance_;
 }
 
+void VDso::SetUtcOffset(int64_t offset) {
+    vdso_time* time = time_window->data();
+    uint32_t seq = time->seq;
+    __atomic_store_n(&time->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&time->utc_offset, offset, __ATOMIC_RELAXED);
+    __atomic_store_n(&time->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
 uintptr_t VDso::base_address(const fbl::RefPtr<VmMapping>& code_mapping) {
     return code_mapping ? code_mapping->base() - VDSO_CODE_START : 0;
 }
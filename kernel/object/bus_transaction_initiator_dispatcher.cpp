@@ -8,6 +8,7 @@
 
 #include <dev/iommu.h>
 #include <err.h>
+#include <fbl/alloc_checker.h>
 #include <vm/pinned_vm_object.h>
 #include <vm/vm_object.h>
 #include <zircon/rights.h>
@@ -38,6 +39,10 @@ BusTransactionInitiatorDispatcher::BusTransactionInitiatorDispatcher(fbl::RefPtr
 
 BusTransactionInitiatorDispatcher::~BusTransactionInitiatorDispatcher() {
     DEBUG_ASSERT(pinned_memory_.is_empty());
+
+    // Only non-empty if this BTI never had a handle, since on_zero_handles()
+    // releases the cache.
+    ReleaseCachedPins(&pin_cache_);
 }
 
 zx_status_t BusTransactionInitiatorDispatcher::Pin(fbl::RefPtr<VmObject> vmo, uint64_t offset,
@@ -52,6 +57,35 @@ zx_status_t BusTransactionInitiatorDispatcher::Pin(fbl::RefPtr<VmObject> vmo, ui
         return ZX_ERR_INVALID_ARGS;
     }
 
+    {
+        Guard<fbl::Mutex> guard{get_lock()};
+        if (zero_handles_) {
+            return ZX_ERR_BAD_STATE;
+        }
+
+        if (pin_cache_quota_ > 0) {
+            for (auto iter = pin_cache_.begin(); iter != pin_cache_.end(); ++iter) {
+                const PinnedVmObject& cached = iter->pinned_vmo;
+                if (cached.vmo().get() != vmo.get() || cached.offset() != offset ||
+                    cached.size() != size || iter->perms != perms) {
+                    continue;
+                }
+                zx_status_t status = PinnedMemoryTokenDispatcher::CreateFromCache(
+                        fbl::WrapRefPtr(this), &iter->pinned_vmo, perms, &iter->mapped_addrs,
+                        pmt, pmt_rights);
+                if (status != ZX_OK) {
+                    // The entry is left intact in the cache.
+                    return status;
+                }
+                pin_cache_bytes_ -= size;
+                pin_cache_hits_++;
+                pin_cache_.erase(iter);
+                return ZX_OK;
+            }
+            pin_cache_misses_++;
+        }
+    }
+
     PinnedVmObject pinned_vmo;
     zx_status_t status = PinnedVmObject::Create(vmo, offset, size, &pinned_vmo);
     if (status != ZX_OK) {
@@ -79,20 +113,28 @@ void BusTransactionInitiatorDispatcher::ReleaseQuarantine() {
 }
 
 void BusTransactionInitiatorDispatcher::on_zero_handles() {
-    Guard<fbl::Mutex> guard{get_lock()};
-    // Prevent new pinning from happening.  The Dispatcher will stick around
-    // until all of the PMTs are closed.
-    zero_handles_ = true;
-
-    // Do not clear out the quarantine list.  PMTs hold a reference to the BTI
-    // and the BTI holds a reference to each quarantined PMT.  We intentionally
-    // leak the BTI, all quarantined PMTs, and their underlying VMOs.  We could
-    // get away with freeing the BTI and the PMTs, but for safety we must leak
-    // at least the pinned parts of the VMOs, since we have no assurance that
-    // hardware is not still reading/writing to it.
-    if (!quarantine_.is_empty()) {
-        PrintQuarantineWarningLocked();
+    CachedPinList cached;
+    {
+        Guard<fbl::Mutex> guard{get_lock()};
+        // Prevent new pinning from happening.  The Dispatcher will stick around
+        // until all of the PMTs are closed.
+        zero_handles_ = true;
+
+        // Nothing can be pinned from the cache anymore, so let it go.
+        pin_cache_.swap(cached);
+        pin_cache_bytes_ = 0;
+
+        // Do not clear out the quarantine list.  PMTs hold a reference to the BTI
+        // and the BTI holds a reference to each quarantined PMT.  We intentionally
+        // leak the BTI, all quarantined PMTs, and their underlying VMOs.  We could
+        // get away with freeing the BTI and the PMTs, but for safety we must leak
+        // at least the pinned parts of the VMOs, since we have no assurance that
+        // hardware is not still reading/writing to it.
+        if (!quarantine_.is_empty()) {
+            PrintQuarantineWarningLocked();
+        }
     }
+    ReleaseCachedPins(&cached);
 }
 
 void BusTransactionInitiatorDispatcher::AddPmoLocked(PinnedMemoryTokenDispatcher* pmt) {
@@ -129,3 +171,75 @@ void BusTransactionInitiatorDispatcher::PrintQuarantineWarningLocked() {
     printf("Bus Transaction Initiator 0x%lx has leaked %" PRIu64 " pages in %zu VMOs\n",
            bti_id_, leaked_pages, num_entries);
 }
+
+void BusTransactionInitiatorDispatcher::SetPinCacheQuota(uint64_t quota) {
+    CachedPinList evicted;
+    {
+        Guard<fbl::Mutex> guard{get_lock()};
+        pin_cache_quota_ = quota;
+        EvictCachedPinsLocked(quota, &evicted);
+    }
+    ReleaseCachedPins(&evicted);
+}
+
+uint64_t BusTransactionInitiatorDispatcher::pin_cache_quota() const {
+    Guard<fbl::Mutex> guard{get_lock()};
+    return pin_cache_quota_;
+}
+
+void BusTransactionInitiatorDispatcher::GetInfo(zx_info_bti_t* info) const {
+    Guard<fbl::Mutex> guard{get_lock()};
+    info->minimum_contiguity = minimum_contiguity();
+    info->aspace_size = aspace_size();
+    info->pin_cache_quota = pin_cache_quota_;
+    info->pin_cache_bytes = pin_cache_bytes_;
+    info->pin_cache_hits = pin_cache_hits_;
+    info->pin_cache_misses = pin_cache_misses_;
+    info->pin_cache_evictions = pin_cache_evictions_;
+}
+
+bool BusTransactionInitiatorDispatcher::CachePin(PinnedVmObject* pinned_vmo, uint32_t perms,
+                                                 fbl::Array<dev_vaddr_t>* mapped_addrs) {
+    CachedPinList evicted;
+    {
+        Guard<fbl::Mutex> guard{get_lock()};
+        if (zero_handles_ || pinned_vmo->size() > pin_cache_quota_) {
+            return false;
+        }
+
+        fbl::AllocChecker ac;
+        fbl::unique_ptr<CachedPin> entry(new (&ac) CachedPin());
+        if (!ac.check()) {
+            return false;
+        }
+        entry->pinned_vmo = fbl::move(*pinned_vmo);
+        entry->perms = perms;
+        entry->mapped_addrs = fbl::move(*mapped_addrs);
+
+        pin_cache_bytes_ += entry->pinned_vmo.size();
+        pin_cache_.push_front(fbl::move(entry));
+        EvictCachedPinsLocked(pin_cache_quota_, &evicted);
+    }
+    ReleaseCachedPins(&evicted);
+    return true;
+}
+
+void BusTransactionInitiatorDispatcher::EvictCachedPinsLocked(uint64_t quota,
+                                                              CachedPinList* evicted) {
+    while (pin_cache_bytes_ > quota) {
+        fbl::unique_ptr<CachedPin> entry = pin_cache_.pop_back();
+        pin_cache_bytes_ -= entry->pinned_vmo.size();
+        pin_cache_evictions_++;
+        evicted->push_back(fbl::move(entry));
+    }
+}
+
+void BusTransactionInitiatorDispatcher::ReleaseCachedPins(CachedPinList* pins) {
+    while (!pins->is_empty()) {
+        fbl::unique_ptr<CachedPin> entry = pins->pop_front();
+        zx_status_t status = PinnedMemoryTokenDispatcher::UnmapFromIommu(*this, entry->pinned_vmo,
+                                                                         entry->mapped_addrs);
+        ASSERT(status == ZX_OK);
+        // Dropping |entry| unpins the range.
+    }
+}
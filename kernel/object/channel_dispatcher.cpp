@@ -202,6 +202,48 @@ zx_status_t ChannelDispatcher::Read(zx_koid_t owner,
     return rv;
 }
 
+zx_status_t ChannelDispatcher::ReadMany(zx_koid_t owner,
+                                        uint32_t* msg_sizes,
+                                        uint32_t* msg_handle_counts,
+                                        fbl::unique_ptr<MessagePacket>* msgs,
+                                        size_t count,
+                                        size_t* actual) {
+    canary_.Assert();
+
+    *actual = 0;
+
+    Guard<fbl::Mutex> guard{get_lock()};
+
+    if (owner != owner_)
+        return ZX_ERR_BAD_HANDLE;
+
+    if (messages_.is_empty())
+        return peer_ ? ZX_ERR_SHOULD_WAIT : ZX_ERR_PEER_CLOSED;
+
+    size_t n = 0;
+    while (n < count && !messages_.is_empty()) {
+        uint32_t size = messages_.front().data_size();
+        uint32_t handle_count = messages_.front().num_handles();
+        bool fits = size <= msg_sizes[n] && handle_count <= msg_handle_counts[n];
+        msg_sizes[n] = size;
+        msg_handle_counts[n] = handle_count;
+        if (!fits)
+            break;
+
+        msgs[n++] = messages_.pop_front();
+        message_count_--;
+    }
+
+    if (n == 0)
+        return ZX_ERR_BUFFER_TOO_SMALL;
+
+    if (messages_.is_empty())
+        UpdateStateLocked(ZX_CHANNEL_READABLE, 0u);
+
+    *actual = n;
+    return ZX_OK;
+}
+
 zx_status_t ChannelDispatcher::Write(zx_koid_t owner, fbl::unique_ptr<MessagePacket> msg) {
     canary_.Assert();
 
@@ -223,6 +265,35 @@ zx_status_t ChannelDispatcher::Write(zx_koid_t owner, fbl::unique_ptr<MessagePac
     return ZX_OK;
 }
 
+zx_status_t ChannelDispatcher::WriteMany(zx_koid_t owner,
+                                         fbl::unique_ptr<MessagePacket>* msgs,
+                                         size_t count) {
+    canary_.Assert();
+
+    AutoReschedDisable resched_disable; // Must come before the lock guard.
+    resched_disable.Disable();
+    Guard<fbl::Mutex> guard{get_lock()};
+
+    // See Write() for an explanation of this test.
+    if (owner != owner_)
+        return ZX_ERR_BAD_HANDLE;
+
+    if (!peer_)
+        return ZX_ERR_PEER_CLOSED;
+
+    bool queued = false;
+    for (size_t i = 0; i < count; ++i) {
+        if (msgs[i])
+            queued |= peer_->EnqueueSelf(fbl::move(msgs[i]));
+    }
+
+    // Observers of the peer only need to hear about the batch once.
+    if (queued)
+        peer_->UpdateStateLocked(0u, ZX_CHANNEL_READABLE);
+
+    return ZX_OK;
+}
+
 zx_status_t ChannelDispatcher::Call(zx_koid_t owner,
                                     fbl::unique_ptr<MessagePacket> msg,
                                     zx_time_t deadline, fbl::unique_ptr<MessagePacket>* reply) {
@@ -326,6 +397,11 @@ size_t ChannelDispatcher::TxMessageMax() const {
 }
 
 void ChannelDispatcher::WriteSelf(fbl::unique_ptr<MessagePacket> msg) {
+    if (EnqueueSelf(fbl::move(msg)))
+        UpdateStateLocked(0u, ZX_CHANNEL_READABLE);
+}
+
+bool ChannelDispatcher::EnqueueSelf(fbl::unique_ptr<MessagePacket> msg) {
     canary_.Assert();
 
     if (!waiters_.is_empty()) {
@@ -339,7 +415,7 @@ void ChannelDispatcher::WriteSelf(fbl::unique_ptr<MessagePacket> msg) {
             if (waiter.get_txid() == txid) {
                 waiters_.erase(waiter);
                 waiter.Deliver(fbl::move(msg));
-                return;
+                return false;
             }
         }
     }
@@ -348,8 +424,7 @@ void ChannelDispatcher::WriteSelf(fbl::unique_ptr<MessagePacket> msg) {
     if (message_count_ > max_message_count_) {
         max_message_count_ = message_count_;
     }
-
-    UpdateStateLocked(0u, ZX_CHANNEL_READABLE);
+    return true;
 }
 
 zx_status_t ChannelDispatcher::UserSignalSelf(uint32_t clear_mask, uint32_t set_mask) {
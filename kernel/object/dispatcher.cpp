@@ -9,6 +9,7 @@
 #include <inttypes.h>
 
 #include <arch/ops.h>
+#include <kernel/thread.h>
 #include <lib/ktrace.h>
 #include <lib/counters.h>
 #include <fbl/atomic.h>
@@ -150,8 +151,10 @@ void Dispatcher::AddObserverHelper(StateObserver* observer,
         Guard<LockType> guard{lock};
 
         flags = observer->OnInitialize(signals_, cinfo);
-        if (!(flags & StateObserver::kNeedRemoval))
+        if (!(flags & StateObserver::kNeedRemoval)) {
             observers_.push_front(observer);
+            observers_interest_ |= observer->interest();
+        }
     }
     if (flags & StateObserver::kNeedRemoval)
         observer->OnRemoved();
@@ -179,6 +182,13 @@ void Dispatcher::RemoveObserver(StateObserver* observer) {
     observers_.erase(*observer);
 }
 
+zx_signals_t Dispatcher::PollSignals() const {
+    ZX_DEBUG_ASSERT(is_waitable());
+
+    Guard<fbl::Mutex> guard{get_lock()};
+    return signals_;
+}
+
 void Dispatcher::Cancel(const Handle* handle) {
     ZX_DEBUG_ASSERT(is_waitable());
 
@@ -211,6 +221,11 @@ void Dispatcher::UpdateStateHelper(zx_signals_t clear_mask,
                                    zx_signals_t set_mask,
                                    Lock<LockType>* lock) TA_NO_THREAD_SAFETY_ANALYSIS {
     Dispatcher::ObserverList obs_to_remove;
+
+    // Hold off any reschedules until all the observers have been notified,
+    // so that the first waiter woken does not preempt us while we hold the
+    // lock and the rest of the waiters are still queued behind it.
+    AutoReschedDisable resched_disable; // Must come before the lock guard.
     {
         Guard<LockType> guard{lock};
 
@@ -218,10 +233,12 @@ void Dispatcher::UpdateStateHelper(zx_signals_t clear_mask,
         signals_ &= ~clear_mask;
         signals_ |= set_mask;
 
-        if (previous_signals == signals_)
+        zx_signals_t changed = previous_signals ^ signals_;
+        if ((changed & observers_interest_) == 0u)
             return;
 
-        UpdateInternalLocked(&obs_to_remove, signals_);
+        resched_disable.Disable();
+        UpdateInternalLocked(&obs_to_remove, signals_, changed);
     }
 
     while (!obs_to_remove.is_empty()) {
@@ -242,19 +259,28 @@ void Dispatcher::UpdateStateLocked(zx_signals_t clear_mask,
     UpdateStateHelper(clear_mask, set_mask, &lock);
 }
 
-void Dispatcher::UpdateInternalLocked(ObserverList* obs_to_remove, zx_signals_t signals) {
+void Dispatcher::UpdateInternalLocked(ObserverList* obs_to_remove, zx_signals_t signals,
+                                      zx_signals_t changed) {
     ZX_DEBUG_ASSERT(is_waitable());
 
+    zx_signals_t interest = 0u;
     for (auto it = observers_.begin(); it != observers_.end();) {
+        if ((it->interest() & changed) == 0u) {
+            interest |= it->interest();
+            ++it;
+            continue;
+        }
         StateObserver::Flags it_flags = it->OnStateChange(signals);
         if (it_flags & StateObserver::kNeedRemoval) {
             auto to_remove = it;
             ++it;
             obs_to_remove->push_back(observers_.erase(to_remove));
         } else {
+            interest |= it->interest();
             ++it;
         }
     }
+    observers_interest_ = interest;
 }
 
 zx_status_t Dispatcher::SetCookie(CookieJar* cookiejar, zx_koid_t scope, uint64_t cookie) {
@@ -225,6 +225,11 @@ zx_status_t dispatch_user_exception(uint exception_type,
         return ZX_ERR_BAD_STATE;
     }
 
+    // A handler registered with ZX_PROP_EXCEPTION_HANDLER runs on the thread
+    // itself, which saves the round trip through an exception port.
+    if (thread->RedirectToExceptionHandler(exception_type, context))
+        return ZX_OK;
+
     // From now until the exception is resolved the thread is in an exception.
     ThreadDispatcher::AutoBlocked by(ThreadDispatcher::Blocked::EXCEPTION);
 
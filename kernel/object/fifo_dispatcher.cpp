@@ -8,10 +8,62 @@
 
 #include <string.h>
 
+#include <kernel/atomic.h>
 #include <zircon/rights.h>
 #include <fbl/alloc_checker.h>
+#include <fbl/auto_call.h>
 #include <fbl/auto_lock.h>
 #include <object/handle.h>
+#include <object/vm_object_dispatcher.h>
+#include <vm/physmap.h>
+#include <vm/vm_object_paged.h>
+
+static_assert(ZX_FIFO_SHARED_DATA_OFFSET(0) == PAGE_SIZE, "");
+static_assert(2 * sizeof(zx_fifo_ring_t) <= PAGE_SIZE, "");
+
+// Commits and pins the vmo of a ZX_FIFO_SHARED fifo once per endpoint, and finds the kernel
+// addresses of its rings.
+static zx_status_t CreateSharedVmo(fbl::RefPtr<VmObject>* vmo_out, zx_fifo_ring_t* rings[2],
+                                   uint8_t* data[2]) {
+    constexpr uint64_t kSize = ZX_FIFO_SHARED_VMO_SIZE;
+
+    fbl::RefPtr<VmObject> vmo;
+    zx_status_t status = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u, kSize, &vmo);
+    if (status != ZX_OK)
+        return status;
+    status = vmo->CommitRange(0, kSize, nullptr);
+    if (status != ZX_OK)
+        return status;
+    status = vmo->Pin(0, kSize);
+    if (status != ZX_OK)
+        return status;
+    status = vmo->Pin(0, kSize);
+    if (status != ZX_OK) {
+        vmo->Unpin(0, kSize);
+        return status;
+    }
+
+    paddr_t pages[kSize / PAGE_SIZE];
+    auto lookup_fn = [](void* ctx, size_t offset, size_t index, paddr_t pa) {
+        static_cast<paddr_t*>(ctx)[index] = pa;
+        return ZX_OK;
+    };
+    status = vmo->Lookup(0, kSize, 0, lookup_fn, pages);
+    if (status != ZX_OK) {
+        vmo->Unpin(0, kSize);
+        vmo->Unpin(0, kSize);
+        return status;
+    }
+
+    auto header = static_cast<uint8_t*>(paddr_to_physmap(pages[0]));
+    for (uint32_t i = 0; i < 2; ++i) {
+        rings[i] = reinterpret_cast<zx_fifo_ring_t*>(header + ZX_FIFO_SHARED_RING_OFFSET(i));
+        data[i] = static_cast<uint8_t*>(
+            paddr_to_physmap(pages[ZX_FIFO_SHARED_DATA_OFFSET(i) / PAGE_SIZE]));
+    }
+    *vmo_out = fbl::move(vmo);
+    return ZX_OK;
+}
 
 // static
 zx_status_t FifoDispatcher::Create(size_t count, size_t elemsize, uint32_t options,
@@ -26,6 +78,8 @@ zx_status_t FifoDispatcher::Create(size_t count, size_t elemsize, uint32_t optio
         ((count * elemsize) > kMaxSizeBytes)) {
         return ZX_ERR_OUT_OF_RANGE;
     }
+    if (options & ~ZX_FIFO_SHARED)
+        return ZX_ERR_INVALID_ARGS;
 
     fbl::AllocChecker ac;
     auto holder0 = fbl::AdoptRef(new (&ac) PeerHolder<FifoDispatcher>());
@@ -33,23 +87,62 @@ zx_status_t FifoDispatcher::Create(size_t count, size_t elemsize, uint32_t optio
         return ZX_ERR_NO_MEMORY;
     auto holder1 = holder0;
 
-    auto data0 = fbl::unique_ptr<uint8_t[]>(new (&ac) uint8_t[count * elemsize]);
-    if (!ac.check())
-        return ZX_ERR_NO_MEMORY;
+    // Ring i carries the elements written to endpoint i, so endpoint i reads ring 1 - i.
+    fbl::RefPtr<VmObject> vmo;
+    zx_fifo_ring_t* rings[2] = {nullptr, nullptr};
+    uint8_t* data[2] = {nullptr, nullptr};
+    fbl::unique_ptr<uint8_t[]> buffer0;
+    fbl::unique_ptr<uint8_t[]> buffer1;
+    fbl::RefPtr<Dispatcher> vmo_dispatcher;
+    zx_rights_t vmo_rights = 0u;
+    if (options & ZX_FIFO_SHARED) {
+        zx_status_t status = CreateSharedVmo(&vmo, rings, data);
+        if (status != ZX_OK)
+            return status;
+    } else {
+        buffer0 = fbl::unique_ptr<uint8_t[]>(new (&ac) uint8_t[count * elemsize]);
+        if (!ac.check())
+            return ZX_ERR_NO_MEMORY;
+        buffer1 = fbl::unique_ptr<uint8_t[]>(new (&ac) uint8_t[count * elemsize]);
+        if (!ac.check())
+            return ZX_ERR_NO_MEMORY;
+        data[1] = buffer0.get();
+        data[0] = buffer1.get();
+    }
 
-    auto fifo0 = fbl::AdoptRef(new (&ac) FifoDispatcher(fbl::move(holder0), options, static_cast<uint32_t>(count),
-                                                        static_cast<uint32_t>(elemsize), fbl::move(data0)));
-    if (!ac.check())
-        return ZX_ERR_NO_MEMORY;
+    // Each endpoint holds one of the pins taken on the vmo; drop those not handed over yet.
+    uint32_t pins = vmo ? 2u : 0u;
+    auto unpin = fbl::MakeAutoCall([&]() {
+        for (; pins > 0; --pins)
+            vmo->Unpin(0, ZX_FIFO_SHARED_VMO_SIZE);
+    });
+
+    if (vmo) {
+        zx_status_t status = VmObjectDispatcher::Create(vmo, &vmo_dispatcher, &vmo_rights);
+        if (status != ZX_OK)
+            return status;
+        vmo_rights &= ~ZX_RIGHT_EXECUTE;
+    }
 
-    auto data1 = fbl::unique_ptr<uint8_t[]>(new (&ac) uint8_t[count * elemsize]);
+    auto fifo0 = fbl::AdoptRef(new (&ac) FifoDispatcher(fbl::move(holder0),
+                                                        static_cast<uint32_t>(count),
+                                                        static_cast<uint32_t>(elemsize),
+                                                        rings[1], data[1], fbl::move(buffer0),
+                                                        vmo, vmo_dispatcher, vmo_rights, 0u));
     if (!ac.check())
         return ZX_ERR_NO_MEMORY;
-
-    auto fifo1 = fbl::AdoptRef(new (&ac) FifoDispatcher(fbl::move(holder1), options, static_cast<uint32_t>(count),
-                                                        static_cast<uint32_t>(elemsize), fbl::move(data1)));
+    if (vmo)
+        --pins;
+
+    auto fifo1 = fbl::AdoptRef(new (&ac) FifoDispatcher(fbl::move(holder1),
+                                                        static_cast<uint32_t>(count),
+                                                        static_cast<uint32_t>(elemsize),
+                                                        rings[0], data[0], fbl::move(buffer1),
+                                                        vmo, vmo_dispatcher, vmo_rights, 1u));
     if (!ac.check())
         return ZX_ERR_NO_MEMORY;
+    if (vmo)
+        --pins;
 
     fifo0->Init(fifo1);
     fifo1->Init(fifo0);
@@ -61,14 +154,20 @@ zx_status_t FifoDispatcher::Create(size_t count, size_t elemsize, uint32_t optio
 }
 
 FifoDispatcher::FifoDispatcher(fbl::RefPtr<PeerHolder<FifoDispatcher>> holder,
-                               uint32_t /*options*/, uint32_t count, uint32_t elem_size,
-                               fbl::unique_ptr<uint8_t[]> data)
+                               uint32_t count, uint32_t elem_size, zx_fifo_ring_t* ring,
+                               uint8_t* data, fbl::unique_ptr<uint8_t[]> buffer,
+                               fbl::RefPtr<VmObject> vmo, fbl::RefPtr<Dispatcher> vmo_dispatcher,
+                               zx_rights_t vmo_rights, uint32_t tx_ring)
     : PeeredDispatcher(fbl::move(holder), ZX_FIFO_WRITABLE),
       elem_count_(count), elem_size_(elem_size), mask_(count - 1),
-      head_(0u), tail_(0u), data_(fbl::move(data)) {
+      ring_(ring ? ring : &local_ring_), data_(data), buffer_(fbl::move(buffer)),
+      vmo_(fbl::move(vmo)), vmo_dispatcher_(fbl::move(vmo_dispatcher)), vmo_rights_(vmo_rights),
+      tx_ring_(tx_ring) {
 }
 
 FifoDispatcher::~FifoDispatcher() {
+    if (vmo_)
+        vmo_->Unpin(0, ZX_FIFO_SHARED_VMO_SIZE);
 }
 
 // Thread safety analysis disabled as this happens during creation only,
@@ -115,21 +214,25 @@ zx_status_t FifoDispatcher::WriteSelfLocked(size_t elem_size, user_in_ptr<const
     if (count == 0)
         return ZX_ERR_OUT_OF_RANGE;
 
-    uint32_t old_head = head_;
+    const uint32_t old_head = atomic_load_u32(&ring_->head);
+    uint32_t head = old_head;
+
+    // number of filled slots, which a user mode consumer could have corrupted
+    const uint32_t used = head - atomic_load_u32(&ring_->tail);
+    if (used > elem_count_)
+        return ZX_ERR_BAD_STATE;
 
     // total number of available empty slots in the fifo
-    size_t avail = elem_count_ - (head_ - tail_);
+    size_t avail = elem_count_ - used;
 
     if (avail == 0)
         return ZX_ERR_SHOULD_WAIT;
 
-    bool was_empty = (avail == elem_count_);
-
     if (count > avail)
         count = avail;
 
     while (count > 0) {
-        uint32_t offset = (head_ & mask_);
+        uint32_t offset = (head & mask_);
 
         // number of slots from target to end, inclusive
         uint32_t n = elem_count_ - offset;
@@ -137,30 +240,25 @@ zx_status_t FifoDispatcher::WriteSelfLocked(size_t elem_size, user_in_ptr<const
         // number of slots we can actually copy
         size_t to_copy = (count > n) ? n : count;
 
+        // nothing is published until the head is stored, so there is nothing to roll back
         zx_status_t status = ptr.copy_array_from_user(&data_[offset * elem_size_],
                                                       to_copy * elem_size_);
-        if (status != ZX_OK) {
-            // roll back, in case this is the second copy
-            head_ = old_head;
+        if (status != ZX_OK)
             return ZX_ERR_INVALID_ARGS;
-        }
 
         // adjust head and count
         // due to size limitations on fifo, to_copy will always fit in a u32
-        head_ += static_cast<uint32_t>(to_copy);
+        head += static_cast<uint32_t>(to_copy);
         count -= to_copy;
         ptr = ptr.byte_offset(to_copy * elem_size_);
     }
 
-    // if was empty, we've become readable
-    if (was_empty)
-        UpdateStateLocked(0u, ZX_FIFO_READABLE);
+    atomic_store_u32(&ring_->head, head);
 
-    // if now full, we're no longer writable
-    if (elem_count_ == (head_ - tail_))
-        peer_->UpdateStateLocked(ZX_FIFO_WRITABLE, 0u);
+    // readable now, and maybe no longer writable
+    UpdateRingSignalsLocked();
 
-    *actual = (head_ - old_head);
+    *actual = (head - old_head);
     return ZX_OK;
 }
 
@@ -176,21 +274,24 @@ zx_status_t FifoDispatcher::ReadToUser(size_t elem_size, user_out_ptr<uint8_t> p
 
     Guard<fbl::Mutex> guard{get_lock()};
 
-    uint32_t old_tail = tail_;
+    const uint32_t old_tail = atomic_load_u32(&ring_->tail);
+    uint32_t tail = old_tail;
 
-    // total number of available entries to read from the fifo
-    size_t avail = (head_ - tail_);
+    // total number of available entries to read from the fifo, which a user mode producer
+    // could have corrupted
+    const uint32_t avail32 = atomic_load_u32(&ring_->head) - tail;
+    if (avail32 > elem_count_)
+        return ZX_ERR_BAD_STATE;
+    size_t avail = avail32;
 
     if (avail == 0)
         return peer_ ? ZX_ERR_SHOULD_WAIT : ZX_ERR_PEER_CLOSED;
 
-    bool was_full = (avail == elem_count_);
-
     if (count > avail)
         count = avail;
 
     while (count > 0) {
-        uint32_t offset = (tail_ & mask_);
+        uint32_t offset = (tail & mask_);
 
         // number of slots from target to end, inclusive
         uint32_t n = elem_count_ - offset;
@@ -198,29 +299,67 @@ zx_status_t FifoDispatcher::ReadToUser(size_t elem_size, user_out_ptr<uint8_t> p
         // number of slots we can actually copy
         size_t to_copy = (count > n) ? n : count;
 
+        // nothing is consumed until the tail is stored, so there is nothing to roll back
         zx_status_t status = ptr.copy_array_to_user(&data_[offset * elem_size_],
                                                     to_copy * elem_size_);
-        if (status != ZX_OK) {
-            // roll back, in case this is the second copy
-            tail_ = old_tail;
+        if (status != ZX_OK)
             return ZX_ERR_INVALID_ARGS;
-        }
 
         // adjust tail and count
         // due to size limitations on fifo, to_copy will always fit in a u32
-        tail_ += static_cast<uint32_t>(to_copy);
+        tail += static_cast<uint32_t>(to_copy);
         count -= to_copy;
         ptr = ptr.byte_offset(to_copy * elem_size_);
     }
 
-    // if we were full, we have become writable
-    if (was_full && peer_)
-        peer_->UpdateStateLocked(0u, ZX_FIFO_WRITABLE);
+    atomic_store_u32(&ring_->tail, tail);
 
-    // if we've become empty, we're no longer readable
-    if ((head_ - tail_) == 0)
+    // writable again, and maybe no longer readable
+    UpdateRingSignalsLocked();
+
+    *actual = (tail - old_tail);
+    return ZX_OK;
+}
+
+void FifoDispatcher::UpdateRingSignalsLocked() TA_NO_THREAD_SAFETY_ANALYSIS {
+    // The store that made a transition is ordered before these loads, so whichever of the
+    // kernel or a user mode producer or consumer goes last sees the final state.
+    const uint32_t used = atomic_load_u32(&ring_->head) - atomic_load_u32(&ring_->tail);
+
+    if (used == 0)
         UpdateStateLocked(ZX_FIFO_READABLE, 0u);
+    else
+        UpdateStateLocked(0u, ZX_FIFO_READABLE);
+
+    if (peer_) {
+        if (used >= elem_count_)
+            peer_->UpdateStateLocked(ZX_FIFO_WRITABLE, 0u);
+        else
+            peer_->UpdateStateLocked(0u, ZX_FIFO_WRITABLE);
+    }
+}
 
-    *actual = (tail_ - old_tail);
+zx_status_t FifoDispatcher::GetSharedVmo(fbl::RefPtr<Dispatcher>* vmo, zx_rights_t* rights,
+                                         uint32_t* tx_ring) const {
+    canary_.Assert();
+
+    if (!vmo_dispatcher_)
+        return ZX_ERR_NOT_SUPPORTED;
+    *vmo = vmo_dispatcher_;
+    *rights = vmo_rights_;
+    *tx_ring = tx_ring_;
+    return ZX_OK;
+}
+
+zx_status_t FifoDispatcher::UpdateSharedSignals() TA_NO_THREAD_SAFETY_ANALYSIS {
+    canary_.Assert();
+
+    if (!vmo_)
+        return ZX_ERR_NOT_SUPPORTED;
+
+    Guard<fbl::Mutex> guard{get_lock()};
+    UpdateRingSignalsLocked();
+    if (peer_)
+        peer_->UpdateRingSignalsLocked();
     return ZX_OK;
 }
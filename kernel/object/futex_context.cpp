@@ -7,6 +7,7 @@
 #include <object/futex_context.h>
 
 #include <assert.h>
+#include <fbl/ref_ptr.h>
 #include <lib/user_copy/user_ptr.h>
 #include <object/thread_dispatcher.h>
 #include <trace.h>
@@ -23,23 +24,47 @@ FutexContext::~FutexContext() {
 
     // All of the threads should have removed themselves from wait queues
     // by the time the process has exited.
-    DEBUG_ASSERT(futex_table_.is_empty());
+#if LK_DEBUGLEVEL > 0
+    for (Bucket& bucket : buckets_) {
+        Guard<fbl::Mutex> guard{&bucket.lock};
+        DEBUG_ASSERT(bucket.futex_table.is_empty());
+    }
+#endif
 }
 
 zx_status_t FutexContext::FutexWait(user_in_ptr<const int> value_ptr, int current_value, zx_time_t deadline) {
     LTRACE_ENTRY;
 
+    return WaitInternal(value_ptr, current_value, nullptr, deadline);
+}
+
+zx_status_t FutexContext::FutexWaitPi(user_in_ptr<const int> value_ptr, int current_value,
+                                      fbl::RefPtr<ThreadDispatcher> owner, zx_time_t deadline) {
+    LTRACE_ENTRY;
+
+    if (owner.get() == ThreadDispatcher::GetCurrent())
+        return ZX_ERR_INVALID_ARGS;
+
+    return WaitInternal(value_ptr, current_value, fbl::move(owner), deadline);
+}
+
+zx_status_t FutexContext::WaitInternal(user_in_ptr<const int> value_ptr, int current_value,
+                                       fbl::RefPtr<ThreadDispatcher> owner, zx_time_t deadline) {
     uintptr_t futex_key = reinterpret_cast<uintptr_t>(value_ptr.get());
     if (futex_key % sizeof(int))
         return ZX_ERR_INVALID_ARGS;
 
+    // A replaced owner must not be released with the bucket lock held.
+    fbl::RefPtr<ThreadDispatcher> old_owner;
+    Bucket* bucket = GetBucket(futex_key);
+
     // FutexWait() checks that the address value_ptr still contains
     // current_value, and if so it sleeps awaiting a FutexWake() on value_ptr.
     // Those two steps must together be atomic with respect to FutexWake().
     // If a FutexWake() operation could occur between them, a userland mutex
     // operation built on top of futexes would have a race condition that
     // could miss wakeups.
-    Guard<fbl::Mutex> guard{&lock_};
+    Guard<fbl::Mutex> guard{&bucket->lock};
 
     int value;
     zx_status_t result = value_ptr.copy_from_user(&value);
@@ -53,10 +78,18 @@ zx_status_t FutexContext::FutexWait(user_in_ptr<const int> value_ptr, int curren
     FutexNode node;
     node.set_hash_key(futex_key);
     node.SetAsSingletonList();
+    node.SetWaiter(ThreadDispatcher::GetCurrent(), get_current_thread()->effec_priority);
 
-    QueueNodesLocked(&node);
+    QueueNodesLocked(bucket, &node);
 
-    // Block current thread.  This releases lock_ and does not reacquire it.
+    if (owner) {
+        FutexNode* head = &*bucket->futex_table.find(futex_key);
+        old_owner = head->TakeOwner();
+        head->SetOwner(fbl::move(owner));
+    }
+
+    // Block current thread.  This releases the bucket lock and does not
+    // reacquire it.
     result = node.BlockThread(guard.take(), deadline);
     if (result == ZX_OK) {
         DEBUG_ASSERT(!node.IsInQueue());
@@ -70,8 +103,7 @@ zx_status_t FutexContext::FutexWait(user_in_ptr<const int> value_ptr, int curren
     //
     // We need to ensure that the thread's node is removed from the wait
     // queue, because FutexWake() probably didn't do that.
-    Guard<fbl::Mutex> guard2{&lock_};
-    if (UnqueueNodeLocked(&node)) {
+    if (UnqueueNode(&node)) {
         return result;
     }
     // The current thread was not found on the wait queue.  This means
@@ -106,24 +138,58 @@ zx_status_t FutexContext::FutexWake(user_in_ptr<const int> value_ptr,
     if (futex_key % sizeof(int))
         return ZX_ERR_INVALID_ARGS;
 
+    fbl::RefPtr<ThreadDispatcher> owner;
+    Bucket* bucket = GetBucket(futex_key);
+
     AutoReschedDisable resched_disable; // Must come before the Guard.
     resched_disable.Disable();
-    Guard<fbl::Mutex> guard{&lock_};
+    Guard<fbl::Mutex> guard{&bucket->lock};
 
-    FutexNode* node = futex_table_.erase(futex_key);
+    FutexNode* node = bucket->futex_table.erase(futex_key);
     if (!node) {
         // nothing blocked on this futex if we can't find it
         return ZX_OK;
     }
     DEBUG_ASSERT(node->GetKey() == futex_key);
+    owner = node->TakeOwner();
 
     FutexNode* remaining_waiters =
         FutexNode::WakeThreads(node, count, futex_key);
 
-    if (remaining_waiters) {
-        DEBUG_ASSERT(remaining_waiters->GetKey() == futex_key);
-        futex_table_.insert(remaining_waiters);
+    DEBUG_ASSERT(!remaining_waiters || remaining_waiters->GetKey() == futex_key);
+    InstallHeadLocked(bucket, remaining_waiters, &owner);
+
+    return ZX_OK;
+}
+
+zx_status_t FutexContext::FutexWakePi(user_in_ptr<const int> value_ptr) {
+    LTRACE_ENTRY;
+
+    uintptr_t futex_key = reinterpret_cast<uintptr_t>(value_ptr.get());
+    if (futex_key % sizeof(int))
+        return ZX_ERR_INVALID_ARGS;
+
+    fbl::RefPtr<ThreadDispatcher> owner;
+    fbl::RefPtr<ThreadDispatcher> new_owner;
+    Bucket* bucket = GetBucket(futex_key);
+
+    AutoReschedDisable resched_disable; // Must come before the Guard.
+    resched_disable.Disable();
+    Guard<fbl::Mutex> guard{&bucket->lock};
+
+    FutexNode* node = bucket->futex_table.erase(futex_key);
+    if (!node) {
+        // nothing blocked on this futex if we can't find it
+        return ZX_OK;
     }
+    DEBUG_ASSERT(node->GetKey() == futex_key);
+    owner = node->TakeOwner();
+    // The woken thread is still blocked, so its dispatcher is alive.
+    new_owner = fbl::WrapRefPtr(node->thread());
+
+    FutexNode* remaining_waiters = FutexNode::WakeThreads(node, 1, futex_key);
+
+    InstallHeadLocked(bucket, remaining_waiters, &new_owner);
 
     return ZX_OK;
 }
@@ -135,32 +201,56 @@ zx_status_t FutexContext::FutexRequeue(user_in_ptr<const int> wake_ptr, uint32_t
     if ((requeue_ptr.get() == nullptr) && requeue_count)
         return ZX_ERR_INVALID_ARGS;
 
+    uintptr_t wake_key = reinterpret_cast<uintptr_t>(wake_ptr.get());
+    uintptr_t requeue_key = reinterpret_cast<uintptr_t>(requeue_ptr.get());
+    if (wake_key == requeue_key) return ZX_ERR_INVALID_ARGS;
+    if (wake_key % sizeof(int) || requeue_key % sizeof(int))
+        return ZX_ERR_INVALID_ARGS;
+
+    fbl::RefPtr<ThreadDispatcher> owner;
+    Bucket* wake_bucket = GetBucket(wake_key);
+    Bucket* requeue_bucket = GetBucket(requeue_key);
+
     AutoReschedDisable resched_disable; // Must come before the Guard.
-    Guard<fbl::Mutex> guard{&lock_};
+    if (wake_bucket == requeue_bucket) {
+        Guard<fbl::Mutex> guard{&wake_bucket->lock};
+        return RequeueLocked(wake_bucket, requeue_bucket, &resched_disable,
+                             wake_ptr, wake_count, current_value, requeue_key, requeue_count,
+                             &owner);
+    }
+    GuardMultiple<2, fbl::Mutex> guard{&wake_bucket->lock, &requeue_bucket->lock};
+    return RequeueLocked(wake_bucket, requeue_bucket, &resched_disable,
+                         wake_ptr, wake_count, current_value, requeue_key, requeue_count,
+                         &owner);
+}
 
+zx_status_t FutexContext::RequeueLocked(Bucket* wake_bucket, Bucket* requeue_bucket,
+                                        AutoReschedDisable* resched_disable,
+                                        user_in_ptr<const int> wake_ptr, uint32_t wake_count,
+                                        int current_value, uintptr_t requeue_key,
+                                        uint32_t requeue_count,
+                                        fbl::RefPtr<ThreadDispatcher>* owner) {
     int value;
     zx_status_t result = wake_ptr.copy_from_user(&value);
     if (result != ZX_OK) return result;
     if (value != current_value) return ZX_ERR_BAD_STATE;
 
     uintptr_t wake_key = reinterpret_cast<uintptr_t>(wake_ptr.get());
-    uintptr_t requeue_key = reinterpret_cast<uintptr_t>(requeue_ptr.get());
-    if (wake_key == requeue_key) return ZX_ERR_INVALID_ARGS;
-    if (wake_key % sizeof(int) || requeue_key % sizeof(int))
-        return ZX_ERR_INVALID_ARGS;
 
     // This must happen before RemoveFromHead() calls set_hash_key() on
-    // nodes below, because operations on futex_table_ look at the GetKey
+    // nodes below, because operations on futex_table look at the GetKey
     // field of the list head nodes for wake_key and requeue_key.
-    FutexNode* node = futex_table_.erase(wake_key);
+    FutexNode* node = wake_bucket->futex_table.erase(wake_key);
     if (!node) {
         // nothing blocked on this futex if we can't find it
         return ZX_OK;
     }
+    // The owner stays with the wake_key futex.
+    *owner = node->TakeOwner();
 
     // This must come before WakeThreads() to be useful, but we want to
     // avoid doing it before copy_from_user() in case that faults.
-    resched_disable.Disable();
+    resched_disable->Disable();
 
     if (wake_count > 0) {
         node = FutexNode::WakeThreads(node, wake_count, wake_key);
@@ -176,51 +266,71 @@ zx_status_t FutexContext::FutexRequeue(user_in_ptr<const int> wake_ptr, uint32_t
 
             // now requeue our nodes to requeue_ptr mutex
             DEBUG_ASSERT(requeue_head->GetKey() == requeue_key);
-            QueueNodesLocked(requeue_head);
+            QueueNodesLocked(requeue_bucket, requeue_head);
         }
     }
 
     // add any remaining nodes back to wake_key futex
-    if (node != nullptr) {
-        DEBUG_ASSERT(node->GetKey() == wake_key);
-        futex_table_.insert(node);
-    }
+    DEBUG_ASSERT(node == nullptr || node->GetKey() == wake_key);
+    InstallHeadLocked(wake_bucket, node, owner);
 
     return ZX_OK;
 }
 
-void FutexContext::QueueNodesLocked(FutexNode* head) {
-    DEBUG_ASSERT(lock_.lock().IsHeld());
+void FutexContext::QueueNodesLocked(Bucket* bucket, FutexNode* head) {
+    DEBUG_ASSERT(bucket->lock.lock().IsHeld());
 
     FutexNode::HashTable::iterator iter;
 
     // Attempt to insert this FutexNode into the hash table.  If the insert
     // succeeds, then the current thread is first to block on this futex and we
     // are finished.  If the insert fails, then there is already a thread
-    // waiting on this futex.  Add ourselves to that thread's list.
-    if (!futex_table_.insert_or_find(head, &iter))
+    // waiting on this futex.  Add ourselves to that thread's list, and let
+    // the futex's owner, if any, inherit the new waiters' priority.
+    if (!bucket->futex_table.insert_or_find(head, &iter)) {
         iter->AppendList(head);
+        iter->UpdateOwner();
+    }
+}
+
+void FutexContext::InstallHeadLocked(Bucket* bucket, FutexNode* new_head,
+                                     fbl::RefPtr<ThreadDispatcher>* owner) {
+    DEBUG_ASSERT(bucket->lock.lock().IsHeld());
+
+    if (new_head) {
+        DEBUG_ASSERT(!new_head->owner());
+        if (*owner)
+            new_head->SetOwner(fbl::move(*owner));
+        bucket->futex_table.insert(new_head);
+    }
 }
 
 // This attempts to unqueue a thread (which may or may not be waiting on a
 // futex), given its FutexNode.  This returns whether the FutexNode was
 // found and removed from a futex wait queue.
-bool FutexContext::UnqueueNodeLocked(FutexNode* node) {
-    DEBUG_ASSERT(lock_.lock().IsHeld());
-
-    if (!node->IsInQueue())
-        return false;
-
-    // Note: When UnqueueNode() is called from FutexWait(), it might be
-    // tempting to reuse the futex key that was passed to FutexWait().
-    // However, that could be out of date if the thread was requeued by
-    // FutexRequeue(), so we need to re-get the hash table key here.
-    uintptr_t futex_key = node->GetKey();
-
-    FutexNode* old_head = futex_table_.erase(futex_key);
-    DEBUG_ASSERT(old_head);
-    FutexNode* new_head = FutexNode::RemoveNodeFromList(old_head, node);
-    if (new_head)
-        futex_table_.insert(new_head);
-    return true;
+bool FutexContext::UnqueueNode(FutexNode* node) {
+    fbl::RefPtr<ThreadDispatcher> owner;
+
+    for (;;) {
+        // Note: When UnqueueNode() is called from FutexWait(), it might be
+        // tempting to reuse the futex key that was passed to FutexWait().
+        // However, that could be out of date if the thread was requeued by
+        // FutexRequeue(), so we need to re-get the hash table key here, and
+        // check it again once we hold the lock of the bucket it names.
+        uintptr_t futex_key = node->GetKey();
+        Bucket* bucket = GetBucket(futex_key);
+        Guard<fbl::Mutex> guard{&bucket->lock};
+        if (node->GetKey() != futex_key)
+            continue;
+
+        if (!node->IsInQueue())
+            return false;
+
+        FutexNode* old_head = bucket->futex_table.erase(futex_key);
+        DEBUG_ASSERT(old_head);
+        owner = old_head->TakeOwner();
+        FutexNode* new_head = FutexNode::RemoveNodeFromList(old_head, node);
+        InstallHeadLocked(bucket, new_head, &owner);
+        return true;
+    }
 }
@@ -12,6 +12,7 @@
 #include <fbl/mutex.h>
 #include <platform.h>
 #include <trace.h>
+#include <kernel/sched.h>
 #include <kernel/thread_lock.h>
 #include <zircon/types.h>
 
@@ -25,6 +26,7 @@ FutexNode::~FutexNode() {
     LTRACE_ENTRY;
 
     DEBUG_ASSERT(!IsInQueue());
+    DEBUG_ASSERT(!owner_);
 }
 
 bool FutexNode::IsInQueue() const {
@@ -42,6 +44,51 @@ void FutexNode::AppendList(FutexNode* head) {
     SpliceNodes(this, head);
 }
 
+int FutexNode::MaxWaiterPriority() const {
+    int priority = priority_;
+    for (const FutexNode* node = queue_next_; node != this; node = node->queue_next_) {
+        if (node->priority_ > priority)
+            priority = node->priority_;
+    }
+    return priority;
+}
+
+void FutexNode::SetOwner(fbl::RefPtr<ThreadDispatcher> owner) {
+    DEBUG_ASSERT(!owner_);
+    owner_ = fbl::move(owner);
+
+    Guard<spin_lock_t, IrqSave> guard{ThreadLock::Get()};
+    owner_priority_ = MaxWaiterPriority();
+    bool local_resched = false;
+    owner_->AddPiFutex(this, &local_resched);
+    // Deferred by the scheduler if the caller disabled rescheduling.
+    if (local_resched)
+        sched_reschedule();
+}
+
+fbl::RefPtr<ThreadDispatcher> FutexNode::TakeOwner() {
+    if (owner_) {
+        Guard<spin_lock_t, IrqSave> guard{ThreadLock::Get()};
+        bool local_resched = false;
+        owner_->RemovePiFutex(this, &local_resched);
+        if (local_resched)
+            sched_reschedule();
+    }
+    return fbl::move(owner_);
+}
+
+void FutexNode::UpdateOwner() {
+    if (!owner_)
+        return;
+
+    Guard<spin_lock_t, IrqSave> guard{ThreadLock::Get()};
+    owner_priority_ = MaxWaiterPriority();
+    bool local_resched = false;
+    owner_->UpdatePiPriority(&local_resched);
+    if (local_resched)
+        sched_reschedule();
+}
+
 // This removes |node| from the list whose first node is |list_head|.  This
 // returns the new list head, or nullptr if the list has become empty.
 FutexNode* FutexNode::RemoveNodeFromList(FutexNode* list_head,
@@ -83,8 +130,9 @@ FutexNode* FutexNode::WakeThreads(FutexNode* node, uint32_t count,
     FutexNode* const list_end = node->queue_prev_;
     for (uint32_t i = 0; i < count; i++) {
         DEBUG_ASSERT(node->GetKey() == old_hash_key);
-        // Clear this field to avoid any possible confusion.
-        node->set_hash_key(0);
+        // The key is left as is: if the thread's wait timed out at the same
+        // time, FutexWait() uses it to find the bucket lock we are holding,
+        // and must wait for it before it can tell the node was dequeued.
 
         const bool is_last_node = (node == list_end);
         FutexNode* next = node->queue_next_;
@@ -175,10 +223,10 @@ void FutexNode::WakeThread() {
     // cases to consider:
     //  1) The thread's wait times out, or the thread is killed or
     //     suspended.  In those cases, FutexWait() will reacquire the
-    //     FutexContext lock.  We are currently holding that lock, so
-    //     FutexWait() will not race with us.
+    //     bucket lock for the node's key.  We are currently holding that
+    //     lock, so FutexWait() will not race with us.
     //  2) The thread is woken by our wait_queue_wake_one() call.  In
-    //     this case, FutexWait() will *not* reacquire the FutexContext
+    //     this case, FutexWait() will *not* reacquire the bucket
     //     lock.  To handle this correctly, we must not access |this|
     //     after wait_queue_wake_one().
 
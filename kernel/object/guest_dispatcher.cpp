@@ -8,11 +8,13 @@
 
 #include <arch/hypervisor.h>
 #include <fbl/alloc_checker.h>
+#include <hypervisor/guest_physical_address_space.h>
 #include <object/vm_address_region_dispatcher.h>
 #include <zircon/rights.h>
 
 // static
-zx_status_t GuestDispatcher::Create(fbl::RefPtr<Dispatcher>* guest_dispatcher,
+zx_status_t GuestDispatcher::Create(uint32_t options,
+                                    fbl::RefPtr<Dispatcher>* guest_dispatcher,
                                     zx_rights_t* guest_rights,
                                     fbl::RefPtr<Dispatcher>* vmar_dispatcher,
                                     zx_rights_t* vmar_rights) {
@@ -23,7 +25,7 @@ zx_status_t GuestDispatcher::Create(fbl::RefPtr<Dispatcher>* guest_dispatcher,
     }
 
     fbl::AllocChecker ac;
-    auto disp = fbl::AdoptRef(new (&ac) GuestDispatcher(fbl::move(guest)));
+    auto disp = fbl::AdoptRef(new (&ac) GuestDispatcher(options, fbl::move(guest)));
     if (!ac.check()) {
         return ZX_ERR_NO_MEMORY;
     }
@@ -39,8 +41,8 @@ zx_status_t GuestDispatcher::Create(fbl::RefPtr<Dispatcher>* guest_dispatcher,
     return ZX_OK;
 }
 
-GuestDispatcher::GuestDispatcher(fbl::unique_ptr<Guest> guest)
-    : guest_(fbl::move(guest)) {}
+GuestDispatcher::GuestDispatcher(uint32_t options, fbl::unique_ptr<Guest> guest)
+    : guest_(fbl::move(guest)), options_(options), prefaulted_(false) {}
 
 GuestDispatcher::~GuestDispatcher() {}
 
@@ -49,3 +51,16 @@ zx_status_t GuestDispatcher::SetTrap(uint32_t kind, zx_vaddr_t addr, size_t len,
     canary_.Assert();
     return guest_->SetTrap(kind, addr, len, fbl::move(port), key);
 }
+
+zx_status_t GuestDispatcher::Prefault() {
+    canary_.Assert();
+    if (!(options_ & ZX_GUEST_OPT_PREFAULT) || prefaulted_.exchange(true)) {
+        return ZX_OK;
+    }
+    zx_status_t status = guest_->AddressSpace()->Prefault();
+    if (status != ZX_OK) {
+        // Let the next VCPU to be created try again.
+        prefaulted_.store(false);
+    }
+    return status;
+}
@@ -7,10 +7,15 @@
 #include <object/handle.h>
 
 #include <object/dispatcher.h>
+#include <arch/ops.h>
 #include <fbl/arena.h>
+#include <fbl/atomic.h>
 #include <fbl/mutex.h>
+#include <kernel/align.h>
+#include <kernel/spinlock.h>
 #include <lib/counters.h>
 #include <pow2.h>
+#include <string.h>
 
 namespace {
 
@@ -24,6 +29,29 @@ constexpr size_t kHighHandleCount = (kMaxHandleCount * 7) / 8;
 KCOUNTER(handle_count_new, "kernel.handles.new");
 KCOUNTER(handle_count_duped, "kernel.handles.duped");
 KCOUNTER(handle_count_freed, "kernel.handles.freed");
+KCOUNTER(handle_cache_alloc_hit, "kernel.handles.cache.alloc_hit");
+KCOUNTER(handle_cache_alloc_miss, "kernel.handles.cache.alloc_miss");
+KCOUNTER(handle_cache_drain, "kernel.handles.cache.drain");
+
+// Each cpu keeps a small stack of free arena slots so that creating and
+// destroying handles usually doesn't touch ArenaLock. A cache is refilled
+// from and drained to the arena kHandleCacheBatch slots at a time. A freed
+// slot holds on to its stashed base_value while cached, so generation
+// numbers keep advancing exactly as if it had gone back to the arena.
+constexpr size_t kHandleCacheBatch = 16;
+constexpr size_t kHandleCacheMax = 2 * kHandleCacheBatch;
+
+struct HandleCache {
+    DECLARE_SPINLOCK(HandleCache) lock;
+    // slots[count - 1] is the most recently freed, and the hottest.
+    void* slots[kHandleCacheMax] TA_GUARDED(lock) = {};
+    size_t count TA_GUARDED(lock) = 0;
+} __CPU_ALIGN;
+
+HandleCache handle_cache[SMP_MAX_CPUS];
+
+// Live handles, not counting free slots parked in the caches.
+fbl::atomic<size_t> outstanding_handles;
 
 // Masks for building a Handle's base_value, which ProcessDispatcher
 // uses to create zx_handle_t values.
@@ -64,7 +92,7 @@ void Handle::set_process_id(zx_koid_t pid) {
 // Returns a new |base_value| based on the value stored in the free
 // arena slot pointed to by |addr|. The new value will be different
 // from the last |base_value| used by this slot.
-uint32_t Handle::GetNewBaseValue(void* addr) TA_REQ(ArenaLock::Get()) {
+uint32_t Handle::GetNewBaseValue(void* addr) {
     // Get the index of this slot within the arena.
     uint32_t handle_index = HandleToIndex(reinterpret_cast<Handle*>(addr));
     DEBUG_ASSERT((handle_index & ~kHandleIndexMask) == 0);
@@ -82,33 +110,146 @@ uint32_t Handle::GetNewBaseValue(void* addr) TA_REQ(ArenaLock::Get()) {
     return (handle_index | new_gen);
 }
 
+// Pop a free slot off the current cpu's cache, refilling it from the arena
+// if it is empty. Returns nullptr if the arena is exhausted.
+void* Handle::AllocSlot() {
+    void* addr = nullptr;
+
+    spin_lock_saved_state_t irqstate;
+    arch_interrupt_save(&irqstate, SPIN_LOCK_FLAG_INTERRUPTS);
+    {
+        HandleCache& cache = handle_cache[arch_curr_cpu_num()];
+        Guard<SpinLock, NoIrqSave> guard{&cache.lock};
+        if (cache.count > 0) {
+            addr = cache.slots[--cache.count];
+        }
+    }
+    arch_interrupt_restore(irqstate, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    if (likely(addr)) {
+        kcounter_add(handle_cache_alloc_hit, 1);
+        return addr;
+    }
+    kcounter_add(handle_cache_alloc_miss, 1);
+
+    void* batch[kHandleCacheBatch];
+    size_t batch_count = 0;
+    {
+        Guard<fbl::Mutex> guard{ArenaLock::Get()};
+        addr = arena_.Alloc();
+        if (unlikely(!addr)) {
+            return nullptr;
+        }
+        while (batch_count < kHandleCacheBatch) {
+            void* slot = arena_.Alloc();
+            if (!slot) {
+                break;
+            }
+            batch[batch_count++] = slot;
+        }
+    }
+
+    // we may have migrated while holding ArenaLock, and the cache we land on
+    // may have filled up in the meantime
+    size_t cached = 0;
+    arch_interrupt_save(&irqstate, SPIN_LOCK_FLAG_INTERRUPTS);
+    {
+        HandleCache& cache = handle_cache[arch_curr_cpu_num()];
+        Guard<SpinLock, NoIrqSave> guard{&cache.lock};
+        while (cached < batch_count && cache.count < kHandleCacheMax) {
+            cache.slots[cache.count++] = batch[cached++];
+        }
+    }
+    arch_interrupt_restore(irqstate, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    if (unlikely(cached < batch_count)) {
+        Guard<fbl::Mutex> guard{ArenaLock::Get()};
+        while (cached < batch_count) {
+            arena_.Free(batch[cached++]);
+        }
+    }
+
+    return addr;
+}
+
+// Push a free slot onto the current cpu's cache, giving the coldest batch of
+// slots back to the arena if the cache is full.
+void Handle::FreeSlot(void* addr) {
+    void* overflow[kHandleCacheBatch];
+    size_t overflow_count = 0;
+
+    spin_lock_saved_state_t irqstate;
+    arch_interrupt_save(&irqstate, SPIN_LOCK_FLAG_INTERRUPTS);
+    {
+        HandleCache& cache = handle_cache[arch_curr_cpu_num()];
+        Guard<SpinLock, NoIrqSave> guard{&cache.lock};
+        if (cache.count == kHandleCacheMax) {
+            overflow_count = kHandleCacheBatch;
+            memcpy(overflow, cache.slots, sizeof(overflow));
+            memmove(cache.slots, cache.slots + kHandleCacheBatch,
+                    (kHandleCacheMax - kHandleCacheBatch) * sizeof(cache.slots[0]));
+            cache.count -= kHandleCacheBatch;
+        }
+        cache.slots[cache.count++] = addr;
+    }
+    arch_interrupt_restore(irqstate, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    if (overflow_count > 0) {
+        kcounter_add(handle_cache_drain, 1);
+        Guard<fbl::Mutex> guard{ArenaLock::Get()};
+        for (size_t i = 0; i < overflow_count; i++) {
+            arena_.Free(overflow[i]);
+        }
+    }
+}
+
+// Return a batch of free slots at once: top up the current cpu's cache and
+// give the rest back to the arena under a single acquisition of ArenaLock.
+void Handle::FreeSlots(void** slots, size_t count) {
+    size_t cached = 0;
+
+    spin_lock_saved_state_t irqstate;
+    arch_interrupt_save(&irqstate, SPIN_LOCK_FLAG_INTERRUPTS);
+    {
+        HandleCache& cache = handle_cache[arch_curr_cpu_num()];
+        Guard<SpinLock, NoIrqSave> guard{&cache.lock};
+        while (cached < count && cache.count < kHandleCacheMax) {
+            cache.slots[cache.count++] = slots[cached++];
+        }
+    }
+    arch_interrupt_restore(irqstate, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    if (cached < count) {
+        kcounter_add(handle_cache_drain, 1);
+        Guard<fbl::Mutex> guard{ArenaLock::Get()};
+        while (cached < count) {
+            arena_.Free(slots[cached++]);
+        }
+    }
+}
+
 // Allocate space for a Handle from the arena, but don't instantiate the
 // object.  |base_value| gets the value for Handle::base_value_.  |what|
 // says whether this is allocation or duplication, for the error message.
 void* Handle::Alloc(const fbl::RefPtr<Dispatcher>& dispatcher,
                     const char* what, uint32_t* base_value) {
-    size_t outstanding_handles;
-    {
-        Guard<fbl::Mutex> guard{ArenaLock::Get()};
-        void* addr = arena_.Alloc();
-        outstanding_handles = arena_.DiagnosticCount();
-        if (likely(addr)) {
-            if (outstanding_handles > kHighHandleCount) {
-                // TODO: Avoid calling this for every handle after
-                // kHighHandleCount; printfs are slow and we're
-                // holding the mutex.
-                printf("WARNING: High handle count: %zu handles\n",
-                       outstanding_handles);
-            }
-            dispatcher->increment_handle_count();
-            *base_value = GetNewBaseValue(addr);
-            return addr;
-        }
+    void* addr = AllocSlot();
+    if (unlikely(!addr)) {
+        printf("WARNING: Could not allocate %s handle (%zu outstanding)\n",
+               what, outstanding_handles.load(fbl::memory_order_relaxed));
+        return nullptr;
     }
 
-    printf("WARNING: Could not allocate %s handle (%zu outstanding)\n",
-           what, outstanding_handles);
-    return nullptr;
+    size_t outstanding =
+        outstanding_handles.fetch_add(1u, fbl::memory_order_relaxed) + 1u;
+    if (outstanding > kHighHandleCount) {
+        // TODO: Avoid calling this for every handle after
+        // kHighHandleCount; printfs are slow.
+        printf("WARNING: High handle count: %zu handles\n", outstanding);
+    }
+    dispatcher->increment_handle_count();
+    *base_value = GetNewBaseValue(addr);
+    return addr;
 }
 
 HandleOwner Handle::Make(fbl::RefPtr<Dispatcher> dispatcher,
@@ -182,12 +323,9 @@ void Handle::Delete() {
 
     TearDown();
 
-    bool zero_handles = false;
-    {
-        Guard<fbl::Mutex> guard{ArenaLock::Get()};
-        zero_handles = disp->decrement_handle_count();
-        arena_.Free(this);
-    }
+    bool zero_handles = disp->decrement_handle_count();
+    outstanding_handles.fetch_sub(1u, fbl::memory_order_relaxed);
+    FreeSlot(this);
 
     if (zero_handles)
         disp->on_zero_handles();
@@ -197,29 +335,68 @@ void Handle::Delete() {
     kcounter_add(handle_count_freed, 1);
 }
 
+void Handle::DeleteList(fbl::DoublyLinkedList<Handle*>* handles) {
+    constexpr size_t kDeleteBatch = 64;
+    void* slots[kDeleteBatch];
+    size_t count = 0;
+    size_t total = 0;
+
+    while (!handles->is_empty()) {
+        Handle* handle = handles->pop_front();
+        fbl::RefPtr<Dispatcher> disp = handle->dispatcher();
+
+        if (disp->is_waitable())
+            disp->Cancel(handle);
+
+        handle->TearDown();
+
+        bool zero_handles = disp->decrement_handle_count();
+        slots[count++] = handle;
+        total++;
+        if (count == kDeleteBatch) {
+            outstanding_handles.fetch_sub(count, fbl::memory_order_relaxed);
+            FreeSlots(slots, count);
+            count = 0;
+        }
+
+        if (zero_handles)
+            disp->on_zero_handles();
+    }
+
+    if (count > 0) {
+        outstanding_handles.fetch_sub(count, fbl::memory_order_relaxed);
+        FreeSlots(slots, count);
+    }
+    kcounter_add(handle_count_freed, total);
+}
+
+// Every handle lookup comes through here, so it must not take ArenaLock:
+// that would serialize handle resolution across all processes. Handle slots
+// are never decommitted once handed out, so the range check is safe without it.
 Handle* Handle::FromU32(uint32_t value) TA_NO_THREAD_SAFETY_ANALYSIS {
     uintptr_t handle_addr = IndexToHandle(value & kHandleIndexMask);
-    {
-        Guard<fbl::Mutex> guard{ArenaLock::Get()};
-        if (unlikely(!arena_.in_range(handle_addr)))
-            return nullptr;
-    }
+    if (unlikely(!arena_.in_range(handle_addr)))
+        return nullptr;
     auto handle = reinterpret_cast<Handle*>(handle_addr);
     return likely(handle->base_value() == value) ? handle : nullptr;
 }
 
 uint32_t Handle::Count(const fbl::RefPtr<const Dispatcher>& dispatcher) {
-    // Handle::ArenaLock also guards Dispatcher::handle_count_.
-    Guard<fbl::Mutex> guard{ArenaLock::Get()};
     return dispatcher->current_handle_count();
 }
 
 size_t Handle::diagnostics::OutstandingHandles() {
-    Guard<fbl::Mutex> guard{ArenaLock::Get()};
-    return arena_.DiagnosticCount();
+    return outstanding_handles.load(fbl::memory_order_relaxed);
 }
 
 void Handle::diagnostics::DumpTableInfo() {
+    size_t cached = 0;
+    for (auto& cache : handle_cache) {
+        Guard<SpinLock, IrqSave> guard{&cache.lock};
+        cached += cache.count;
+    }
     Guard<fbl::Mutex> guard{ArenaLock::Get()};
     arena_.Dump();
+    printf("%zu handles outstanding, %zu free slots cached\n",
+           outstanding_handles.load(fbl::memory_order_relaxed), cached);
 }
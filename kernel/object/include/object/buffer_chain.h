@@ -90,11 +90,21 @@ public:
         size += sizeof(BufferChain);
         const size_t num_buffers = (size + kRawDataSize - 1) / kRawDataSize;
 
-        // Allocate a list of pages.
+        // Allocate a list of pages. Most messages fit in a single buffer, and a single page comes
+        // from the current cpu's page cache without taking the PMM lock.
         list_node pages = LIST_INITIAL_VALUE(pages);
-        zx_status_t status = pmm_alloc_pages(num_buffers, 0, &pages);
-        if (unlikely(status != ZX_OK)) {
-            return nullptr;
+        if (likely(num_buffers == 1)) {
+            vm_page_t* page;
+            zx_status_t status = pmm_alloc_page(0, &page);
+            if (unlikely(status != ZX_OK)) {
+                return nullptr;
+            }
+            list_add_tail(&pages, &page->queue_node);
+        } else {
+            zx_status_t status = pmm_alloc_pages(num_buffers, 0, &pages);
+            if (unlikely(status != ZX_OK)) {
+                return nullptr;
+            }
         }
 
         // Construct a Buffer in each page and add them to a temporary list.
@@ -128,7 +138,14 @@ public:
             BufferChain::Buffer* buf = buffers.pop_front();
             buf->Buffer::~Buffer();
         }
-        pmm_free(&pages);
+        // As in Alloc, a lone page goes back through the per-cpu page cache.
+        vm_page_t* page = list_peek_head_type(&pages, vm_page_t, queue_node);
+        if (likely(page && list_next(&pages, &page->queue_node) == nullptr)) {
+            list_delete(&page->queue_node);
+            pmm_free_page(page);
+        } else {
+            pmm_free(&pages);
+        }
     }
 
     // Copies |size| bytes from |src| to this chain starting at offset |dst_offset|.
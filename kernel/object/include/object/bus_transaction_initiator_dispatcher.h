@@ -7,11 +7,15 @@
 #pragma once
 
 #include <dev/iommu.h>
+#include <fbl/array.h>
 #include <fbl/canary.h>
+#include <fbl/intrusive_double_list.h>
 #include <fbl/mutex.h>
+#include <fbl/unique_ptr.h>
 #include <kernel/lockdep.h>
 #include <object/dispatcher.h>
 #include <object/pinned_memory_token_dispatcher.h>
+#include <zircon/syscalls/object.h>
 
 #include <sys/types.h>
 
@@ -62,6 +66,18 @@ public:
     // The number of bytes in the address space (UINT64_MAX if 2^64).
     uint64_t aspace_size() const { return iommu_->aspace_size(bti_id_); }
 
+    // The pin cache keeps the pins and IOMMU mappings of explicitly unpinned
+    // PMTs, up to |quota| bytes with the least recently unpinned evicted
+    // first.  Pinning the same range of the same VMO with the same
+    // permissions again then reuses them, skipping the commit, pin and map.
+    // A quota of 0, the default, disables the cache and releases everything
+    // in it.
+    void SetPinCacheQuota(uint64_t quota) TA_EXCL(get_lock());
+    uint64_t pin_cache_quota() const TA_EXCL(get_lock());
+    bool pin_cache_enabled() const TA_EXCL(get_lock()) { return pin_cache_quota() > 0; }
+
+    void GetInfo(zx_info_bti_t* info) const TA_EXCL(get_lock());
+
 protected:
     friend PinnedMemoryTokenDispatcher;
 
@@ -75,10 +91,31 @@ protected:
     // quarantine is cleared.
     void Quarantine(fbl::RefPtr<PinnedMemoryTokenDispatcher> pmt) TA_EXCL(get_lock());
 
+    // Offer the pin and IOMMU mappings of an explicitly unpinned PMT to the
+    // pin cache.  Returns true if the cache took them, in which case they have
+    // been moved out of |*pinned_vmo| and |*mapped_addrs|.
+    bool CachePin(PinnedVmObject* pinned_vmo, uint32_t perms,
+                  fbl::Array<dev_vaddr_t>* mapped_addrs) TA_EXCL(get_lock());
+
 private:
+    // A pinned and mapped range left behind by an unpinned PMT.
+    struct CachedPin : public fbl::DoublyLinkedListable<fbl::unique_ptr<CachedPin>> {
+        PinnedVmObject pinned_vmo;
+        uint32_t perms = 0;
+        fbl::Array<dev_vaddr_t> mapped_addrs;
+    };
+    using CachedPinList = fbl::DoublyLinkedList<fbl::unique_ptr<CachedPin>>;
+
     BusTransactionInitiatorDispatcher(fbl::RefPtr<Iommu> iommu, uint64_t bti_id);
     void PrintQuarantineWarningLocked() TA_REQ(get_lock());
 
+    // Move the least recently cached pins to |evicted| until the cache holds
+    // at most |quota| bytes.
+    void EvictCachedPinsLocked(uint64_t quota, CachedPinList* evicted) TA_REQ(get_lock());
+    // Unmap and unpin everything in |pins|.  Called without the lock held, so
+    // that the VMOs' locks are not taken under it.
+    void ReleaseCachedPins(CachedPinList* pins) TA_EXCL(get_lock());
+
     fbl::Canary<fbl::magic("BTID")> canary_;
 
     const fbl::RefPtr<Iommu> iommu_;
@@ -93,4 +130,12 @@ private:
     QuarantineList quarantine_ TA_GUARDED(get_lock());
 
     bool zero_handles_ TA_GUARDED(get_lock());
+
+    // Most recently cached first
+    CachedPinList pin_cache_ TA_GUARDED(get_lock());
+    uint64_t pin_cache_quota_ TA_GUARDED(get_lock()) = 0;
+    uint64_t pin_cache_bytes_ TA_GUARDED(get_lock()) = 0;
+    uint64_t pin_cache_hits_ TA_GUARDED(get_lock()) = 0;
+    uint64_t pin_cache_misses_ TA_GUARDED(get_lock()) = 0;
+    uint64_t pin_cache_evictions_ TA_GUARDED(get_lock()) = 0;
 };
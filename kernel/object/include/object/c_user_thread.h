@@ -15,4 +15,12 @@ __BEGIN_CDECLS
 void get_user_thread_process_name(const void* user_thread,
                                   char out_name[THREAD_NAME_LENGTH]);
 
+// Charges usage of the thread to the task counters of its process and of
+// every enclosing job. Lock free, so it may be called with the thread lock
+// held. Returns 0 if no enclosing job limits its cpu bandwidth, otherwise
+// the earliest time the thread may run again, which is in the past unless
+// the quota of one of those jobs has run out.
+zx_time_t user_thread_charge_usage(void* user_thread, zx_duration_t runtime,
+                                   uint64_t context_switches, uint64_t page_faults);
+
 __END_CDECLS
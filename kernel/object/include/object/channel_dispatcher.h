@@ -44,12 +44,32 @@ public:
                      fbl::unique_ptr<MessagePacket>* msg,
                      bool may_disard);
 
+    // Read up to |count| messages from this endpoint's message queue while holding the lock
+    // once. |msg_sizes| and |msg_handle_counts| are arrays of |count| in-out parameters with the
+    // same meaning as for Read(). Messages are dequeued in order until the queue is empty or the
+    // next message does not fit its buffers; |*actual| is the number returned in |msgs|. If the
+    // first message does not fit, returns ZX_ERR_BUFFER_TOO_SMALL with its sizes in the first
+    // entries and nothing dequeued.
+    zx_status_t ReadMany(zx_koid_t owner,
+                         uint32_t* msg_sizes,
+                         uint32_t* msg_handle_counts,
+                         fbl::unique_ptr<MessagePacket>* msgs,
+                         size_t count,
+                         size_t* actual);
+
     // Write to the opposing endpoint's message queue. |owner| is the process attempting to
     // write to the channel, or ZX_KOID_INVALID if kernel is doing it. If |owner| does not
     // match what was last set by Dispatcher::set_owner() the call will fail.
     zx_status_t Write(zx_koid_t owner,
                       fbl::unique_ptr<MessagePacket> msg) TA_NO_THREAD_SAFETY_ANALYSIS;
 
+    // Write the non-null entries of |msgs| to the opposing endpoint's message queue, in order,
+    // while holding the lock once and updating the peer's signals at most once. On failure none
+    // of the messages are written. |owner| has the same meaning as for Write().
+    zx_status_t WriteMany(zx_koid_t owner,
+                          fbl::unique_ptr<MessagePacket>* msgs,
+                          size_t count) TA_NO_THREAD_SAFETY_ANALYSIS;
+
     // Perform a transacted Write + Read. |owner| is the process attempting to write
     // to the channel, or ZX_KOID_INVALID if kernel is doing it. If |owner| does not
     // match what was last set by Dispatcher::set_owner() the call will fail.
@@ -120,6 +140,9 @@ private:
     explicit ChannelDispatcher(fbl::RefPtr<PeerHolder<ChannelDispatcher>> holder);
     void Init(fbl::RefPtr<ChannelDispatcher> other);
     void WriteSelf(fbl::unique_ptr<MessagePacket> msg) TA_REQ(get_lock());
+    // Delivers |msg| to a waiting Call or queues it. Returns true if it was queued, in which
+    // case the caller must raise ZX_CHANNEL_READABLE.
+    bool EnqueueSelf(fbl::unique_ptr<MessagePacket> msg) TA_REQ(get_lock());
     zx_status_t UserSignalSelf(uint32_t clear_mask, uint32_t set_mask) TA_REQ(get_lock());
 
     fbl::Canary<fbl::magic("CHAN")> canary_;
@@ -0,0 +1,75 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <fbl/atomic.h>
+#include <zircon/syscalls/object.h>
+#include <zircon/types.h>
+
+// A job's ZX_PROP_JOB_CPU_BANDWIDTH limit, and the cpu time charged against
+// it in the current period. Charged along with the TaskCounters by the threads
+// of the job and its descendants, lock free. Periods start lazily, with the
+// first charge after the previous one ended.
+class CpuBandwidth {
+public:
+    static constexpr zx_duration_t kMinPeriod = ZX_MSEC(10);
+    static constexpr zx_duration_t kMaxPeriod = ZX_SEC(10);
+    static constexpr zx_duration_t kMinQuota = ZX_MSEC(1);
+
+    zx_status_t Set(const zx_job_cpu_bandwidth_t& limit) {
+        if (limit.quota != 0 &&
+            (limit.period < kMinPeriod || limit.period > kMaxPeriod || limit.quota < kMinQuota))
+            return ZX_ERR_INVALID_ARGS;
+        // Racing charges may see a mix of the old and new values for a moment.
+        quota_.store(0, fbl::memory_order_relaxed);
+        period_.store(limit.period, fbl::memory_order_relaxed);
+        period_end_.store(0, fbl::memory_order_relaxed);
+        quota_.store(limit.quota, fbl::memory_order_relaxed);
+        return ZX_OK;
+    }
+
+    void GetInfo(zx_info_job_cpu_bandwidth_t* info) const {
+        info->limit.quota = quota_.load(fbl::memory_order_relaxed);
+        info->limit.period = info->limit.quota ? period_.load(fbl::memory_order_relaxed) : 0;
+        info->period_used = info->limit.quota ? used_.load(fbl::memory_order_relaxed) : 0;
+        info->throttled_periods = throttled_periods_.load(fbl::memory_order_relaxed);
+    }
+
+    bool limited() const { return quota_.load(fbl::memory_order_relaxed) != 0; }
+
+    // Charges |runtime|, used up to |now|, to the current period. Returns
+    // |now| while the period's quota lasts, and the end of the period once it
+    // has run out. Only called while limited().
+    zx_time_t Charge(zx_duration_t runtime, zx_time_t now) {
+        const zx_duration_t quota = quota_.load(fbl::memory_order_relaxed);
+        zx_time_t end = period_end_.load(fbl::memory_order_relaxed);
+        if (now >= end) {
+            // Only the cpu which wins the exchange resets the usage; the
+            // others get the new end back from the failed exchange.
+            const zx_time_t new_end = now + period_.load(fbl::memory_order_relaxed);
+            if (period_end_.compare_exchange_strong(&end, new_end, fbl::memory_order_relaxed,
+                                                    fbl::memory_order_relaxed)) {
+                used_.store(0, fbl::memory_order_relaxed);
+                end = new_end;
+            }
+        }
+
+        const zx_duration_t used = used_.fetch_add(runtime, fbl::memory_order_relaxed) + runtime;
+        if (used < quota)
+            return now;
+        if (used - runtime < quota)
+            throttled_periods_.fetch_add(1, fbl::memory_order_relaxed);
+        return end;
+    }
+
+private:
+    fbl::atomic<zx_duration_t> quota_{0};
+    fbl::atomic<zx_duration_t> period_{0};
+    fbl::atomic<zx_time_t> period_end_{0};
+    fbl::atomic<zx_duration_t> used_{0};
+    fbl::atomic<uint64_t> throttled_periods_{0};
+};
@@ -10,6 +10,7 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <fbl/atomic.h>
 #include <fbl/auto_lock.h>
 #include <fbl/canary.h>
 #include <fbl/intrusive_double_list.h>
@@ -100,21 +101,17 @@ public:
 
     zx_koid_t get_koid() const { return koid_; }
 
-    // Must be called under the handle table lock.
-    void increment_handle_count() TA_REQ(Handle::ArenaLock::Get()) {
-        ++handle_count_;
+    void increment_handle_count() {
+        handle_count_.fetch_add(1u, fbl::memory_order_relaxed);
     }
 
-    // Must be called under the handle table lock.
     // Returns true exactly when the handle count goes to zero.
-    bool decrement_handle_count() TA_REQ(Handle::ArenaLock::Get()) {
-        --handle_count_;
-        return handle_count_ == 0u;
+    bool decrement_handle_count() {
+        return handle_count_.fetch_sub(1u, fbl::memory_order_acq_rel) == 1u;
     }
 
-    // Must be called under the handle table lock.
-    uint32_t current_handle_count() const TA_REQ(Handle::ArenaLock::Get()) {
-        return handle_count_;
+    uint32_t current_handle_count() const {
+        return handle_count_.load(fbl::memory_order_relaxed);
     }
 
     // The following are only to be called when |is_waitable| reports true.
@@ -129,6 +126,10 @@ public:
     // Remove an observer (which must have been added).
     void RemoveObserver(StateObserver* observer);
 
+    // Returns a snapshot of the current signal state without registering an
+    // observer. The state may change as soon as the lock is dropped.
+    zx_signals_t PollSignals() const;
+
     // Called when observers of the handle's state (e.g., waits on the handle) should be
     // "cancelled", i.e., when a handle (for the object that owns this StateTracker) is being
     // destroyed or transferred. Returns true if at least one observer was found.
@@ -212,17 +213,22 @@ private:
                            const StateObserver::CountInfo* cinfo,
                            Lock<LockType>* lock);
 
-    void UpdateInternalLocked(ObserverList* obs_to_remove,
-                              zx_signals_t signals) TA_REQ(get_lock());
+    void UpdateInternalLocked(ObserverList* obs_to_remove, zx_signals_t signals,
+                              zx_signals_t changed) TA_REQ(get_lock());
 
     const zx_koid_t koid_;
-    uint32_t handle_count_ TA_GUARDED(Handle::ArenaLock::Get());
+    fbl::atomic<uint32_t> handle_count_;
 
     zx_signals_t signals_ TA_GUARDED(get_lock());
 
     // Active observers are elements in |observers_|.
     ObserverList observers_ TA_GUARDED(get_lock());
 
+    // A superset of the union of the interest() of |observers_|, so that
+    // state changes no observer cares about can skip walking the list.
+    // Grows as observers are added and is recomputed on every walk.
+    zx_signals_t observers_interest_ TA_GUARDED(get_lock()) = 0u;
+
     // Used to store this dispatcher on the dispatcher deleter list.
     fbl::SinglyLinkedListNodeState<Dispatcher*> deleter_ll_;
 };
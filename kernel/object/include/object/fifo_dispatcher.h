@@ -16,7 +16,10 @@
 #include <fbl/canary.h>
 #include <fbl/mutex.h>
 #include <fbl/ref_counted.h>
+#include <fbl/ref_ptr.h>
+#include <fbl/unique_ptr.h>
 #include <lib/user_copy/user_ptr.h>
+#include <vm/vm_object.h>
 
 class FifoDispatcher final : public PeeredDispatcher<FifoDispatcher, ZX_DEFAULT_FIFO_RIGHTS> {
 public:
@@ -34,27 +37,51 @@ public:
     zx_status_t ReadToUser(size_t elem_size, user_out_ptr<uint8_t> dst, size_t count,
                            size_t* actual);
 
+    // For ZX_FIFO_SHARED fifos, returns the dispatcher and rights for the vmo holding both rings,
+    // and the index of the ring that writes to this endpoint go to.
+    zx_status_t GetSharedVmo(fbl::RefPtr<Dispatcher>* vmo, zx_rights_t* rights,
+                             uint32_t* tx_ring) const;
+
+    // For ZX_FIFO_SHARED fifos, brings the readable and writable signals of both endpoints up
+    // to date with the rings, after user mode advanced their indices directly.
+    zx_status_t UpdateSharedSignals();
+
     // PeeredDispatcher implementation.
     void on_zero_handles_locked() TA_REQ(get_lock());
     void OnPeerZeroHandlesLocked() TA_REQ(get_lock());
 
 private:
     FifoDispatcher(fbl::RefPtr<PeerHolder<FifoDispatcher>> holder,
-                   uint32_t options, uint32_t elem_count, uint32_t elem_size,
-                   fbl::unique_ptr<uint8_t[]> data);
+                   uint32_t elem_count, uint32_t elem_size, zx_fifo_ring_t* ring, uint8_t* data,
+                   fbl::unique_ptr<uint8_t[]> buffer, fbl::RefPtr<VmObject> vmo,
+                   fbl::RefPtr<Dispatcher> vmo_dispatcher, zx_rights_t vmo_rights,
+                   uint32_t tx_ring);
     void Init(fbl::RefPtr<FifoDispatcher> other);
     zx_status_t WriteSelfLocked(size_t elem_size, user_in_ptr<const uint8_t> ptr, size_t count,
                                 size_t* actual) TA_REQ(get_lock());
     zx_status_t UserSignalSelfLocked(uint32_t clear_mask, uint32_t set_mask) TA_REQ(get_lock());
 
+    // Sets our readable signal and our peer's writable signal from the fill level of ring_.
+    void UpdateRingSignalsLocked() TA_REQ(get_lock());
+
     fbl::Canary<fbl::magic("FIFO")> canary_;
     const uint32_t elem_count_;
     const uint32_t elem_size_;
     const uint32_t mask_;
 
-    uint32_t head_ TA_GUARDED(get_lock());
-    uint32_t tail_ TA_GUARDED(get_lock());
-    fbl::unique_ptr<uint8_t[]> data_ TA_GUARDED(get_lock());
+    // The ring this endpoint reads from and its peer writes to. Its indices are read and
+    // advanced atomically, and only trusted to be in range after checking, since for
+    // ZX_FIFO_SHARED fifos ring_ and data_ point into the pinned pages of vmo_, which user mode
+    // may access directly. Otherwise they point at local_ring_ and buffer_.
+    zx_fifo_ring_t local_ring_ = {};
+    zx_fifo_ring_t* const ring_;
+    uint8_t* const data_;
+    const fbl::unique_ptr<uint8_t[]> buffer_;
+    const fbl::RefPtr<VmObject> vmo_;
+    // Shared by both endpoints so that every handle to the vmo refers to the same object.
+    const fbl::RefPtr<Dispatcher> vmo_dispatcher_;
+    const zx_rights_t vmo_rights_;
+    const uint32_t tx_ring_;
 
     static constexpr uint32_t kMaxSizeBytes = PAGE_SIZE;
 };
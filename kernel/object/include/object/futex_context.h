@@ -9,9 +9,12 @@
 #include <lib/user_copy/user_ptr.h>
 #include <zircon/types.h>
 #include <fbl/mutex.h>
+#include <fbl/ref_ptr.h>
 #include <kernel/lockdep.h>
 #include <object/futex_node.h>
 
+class ThreadDispatcher;
+
 // FutexContext is a class that encapsulates support for futex operations.
 // FutexContext uses a hash table keyed on the futex address (a pointer to integer in userspace)
 // to contain all active futexes.
@@ -24,6 +27,15 @@
 // When the thread at the head of the futex's blocked thread list is resumed,
 // The FutexNode for the new head of the blocked thread list is set as the hash table value
 // for the futex.
+//
+// The futexes are spread over kNumBuckets buckets by address, each with its
+// own lock and hash table, so that threads of one process contending on
+// different futexes do not serialize on a single lock.
+//
+// A futex may also have a priority inheritance owner, set by FutexWaitPi().
+// While threads are blocked on the futex, the owner inherits the highest
+// priority among them, the same way the holder of a kernel mutex does; a
+// thread that owns several PI futexes inherits the highest over all of them.
 class FutexContext {
 public:
     FutexContext();
@@ -36,9 +48,21 @@ public:
     // on the same |value_ptr| futex.
     zx_status_t FutexWait(user_in_ptr<const int> value_ptr, int current_value, zx_time_t deadline);
 
+    // FutexWaitPi behaves like FutexWait, and additionally makes |owner|,
+    // when not null, the priority inheritance owner of the futex. |owner|
+    // inherits the priority of the threads blocked on the futex until it
+    // calls FutexWakePi or the last waiter leaves.
+    zx_status_t FutexWaitPi(user_in_ptr<const int> value_ptr, int current_value,
+                            fbl::RefPtr<ThreadDispatcher> owner, zx_time_t deadline);
+
     // FutexWake will wake up to |count| number of threads blocked on the |value_ptr| futex.
     zx_status_t FutexWake(user_in_ptr<const int> value_ptr, uint32_t count);
 
+    // FutexWakePi wakes up the first thread blocked on the |value_ptr| futex
+    // and hands the futex's ownership to it: the woken thread inherits the
+    // priority of the remaining waiters, and the previous owner drops it.
+    zx_status_t FutexWakePi(user_in_ptr<const int> value_ptr);
+
     // FutexWait first verifies that the integer pointed to by |wake_ptr|
     // still equals |current_value|. If the test fails, FutexWait returns FAILED_PRECONDITION.
     // Otherwise it will wake up to |wake_count| number of threads blocked on the |wake_ptr| futex.
@@ -52,14 +76,51 @@ private:
     FutexContext(const FutexContext&) = delete;
     FutexContext& operator=(const FutexContext&) = delete;
 
-    void QueueNodesLocked(FutexNode* head) TA_REQ(lock_);
+    static constexpr size_t kNumBucketsShift = 4;
+    static constexpr size_t kNumBuckets = 1u << kNumBucketsShift;
+
+    struct Bucket {
+        // protects futex_table
+        DECLARE_MUTEX(Bucket) lock;
+
+        // Hash table for the futexes of this bucket.
+        // Key is futex address, value is the FutexNode for the head of futex's blocked thread list.
+        FutexNode::HashTable futex_table TA_GUARDED(lock);
+    };
+
+    // Futexes are often laid out at a regular stride larger than an int (for
+    // example, one per cache line), which would put them all in the same
+    // bucket if the bucket were picked from the low address bits.  Use the
+    // top bits of a multiplicative (Fibonacci) hash of the address instead,
+    // which depends on all of its bits.
+    Bucket* GetBucket(uintptr_t futex_key) {
+        uint64_t hash = static_cast<uint64_t>(futex_key) * 0x9e3779b97f4a7c15ull;
+        return &buckets_[hash >> (64 - kNumBucketsShift)];
+    }
+
+    zx_status_t WaitInternal(user_in_ptr<const int> value_ptr, int current_value,
+                             fbl::RefPtr<ThreadDispatcher> owner, zx_time_t deadline);
+
+    // Called with both bucket locks held, which are the same lock if both
+    // futexes hash to the same bucket.
+    static zx_status_t RequeueLocked(Bucket* wake_bucket, Bucket* requeue_bucket,
+                                     AutoReschedDisable* resched_disable,
+                                     user_in_ptr<const int> wake_ptr, uint32_t wake_count,
+                                     int current_value, uintptr_t requeue_key,
+                                     uint32_t requeue_count,
+                                     fbl::RefPtr<ThreadDispatcher>* owner)
+        TA_NO_THREAD_SAFETY_ANALYSIS;
+
+    static void QueueNodesLocked(Bucket* bucket, FutexNode* head) TA_REQ(bucket->lock);
 
-    bool UnqueueNodeLocked(FutexNode* node) TA_REQ(lock_);
+    // Makes |new_head| (which may be null) the head of its futex's wait list
+    // after the previous head was erased, passing |*owner| on to it.
+    // The reference is only moved out of |owner| if |new_head| is not null,
+    // so that callers can drop their last reference after unlocking.
+    static void InstallHeadLocked(Bucket* bucket, FutexNode* new_head,
+                                  fbl::RefPtr<ThreadDispatcher>* owner) TA_REQ(bucket->lock);
 
-    // protects futex_table_
-    DECLARE_MUTEX(FutexContext) lock_;
+    bool UnqueueNode(FutexNode* node);
 
-    // Hash table for futexes in this context.
-    // Key is futex address, value is the FutexNode for the head of futex's blocked thread list.
-    FutexNode::HashTable futex_table_ TA_GUARDED(lock_);
+    Bucket buckets_[kNumBuckets];
 };
@@ -11,8 +11,13 @@
 #include <kernel/wait.h>
 #include <list.h>
 #include <zircon/types.h>
+#include <fbl/atomic.h>
+#include <fbl/intrusive_double_list.h>
 #include <fbl/intrusive_hash_table.h>
 #include <fbl/mutex.h>
+#include <fbl/ref_ptr.h>
+
+class ThreadDispatcher;
 
 // Node for linked list of threads blocked on a futex
 // Intended to be embedded within a ThreadDispatcher Instance
@@ -47,11 +52,43 @@ public:
     zx_status_t BlockThread(Guard<fbl::Mutex>&& adopt_guard, zx_time_t deadline);
 
     void set_hash_key(uintptr_t key) {
-        hash_key_ = key;
+        hash_key_.store(key, fbl::memory_order_relaxed);
+    }
+
+    // Records the blocking thread and its effective priority, for priority
+    // inheritance. Must be called by the thread that is about to block.
+    void SetWaiter(ThreadDispatcher* thread, int priority) {
+        thread_ = thread;
+        priority_ = priority;
     }
+    ThreadDispatcher* thread() const { return thread_; }
+
+    // Returns the highest waiter priority in the list headed by this node.
+    int MaxWaiterPriority() const;
+
+    // The priority inheritance owner of the futex. Only meaningful on the
+    // head node of a futex's wait list. The owner keeps the heads of all of
+    // the futexes it owns, and inherits the highest waiter priority among
+    // them; SetOwner() and TakeOwner() add and remove this head, and
+    // UpdateOwner() accounts for waiters that joined the list. These take
+    // the thread lock, so the caller must not hold it.
+    void SetOwner(fbl::RefPtr<ThreadDispatcher> owner);
+    fbl::RefPtr<ThreadDispatcher> TakeOwner();
+    void UpdateOwner();
+    ThreadDispatcher* owner() const { return owner_.get(); }
+
+    // What the owner inherits from this head, as of the last update.
+    int owner_priority() const TA_REQ(thread_lock) { return owner_priority_; }
+
+    // Trait implementation for the owner's fbl::DoublyLinkedList.
+    struct OwnerListTraits {
+        static fbl::DoublyLinkedListNodeState<FutexNode*>& node_state(FutexNode& node) {
+            return node.owner_node_;
+        }
+    };
 
     // Trait implementation for fbl::HashTable
-    uintptr_t GetKey() const { return hash_key_; }
+    uintptr_t GetKey() const { return hash_key_.load(fbl::memory_order_relaxed); }
     static size_t GetHash(uintptr_t key) { return (key >> 3); }
 
 private:
@@ -68,7 +105,18 @@ private:
     //  * Additionally, when this FutexNode is the head of a futex wait
     //    queue, this field is used by the HashTable (because it uses
     //    intrusive SinglyLinkedLists).
-    uintptr_t hash_key_;
+    // It is atomic because a timed out FutexWait() reads it before taking
+    // the bucket lock that guards it, to find out which bucket to lock.
+    fbl::atomic<uintptr_t> hash_key_;
+
+    // The blocked thread and its effective priority when it blocked.
+    ThreadDispatcher* thread_ = nullptr;
+    int priority_ = -1;
+
+    // Thread that inherits the waiters' priority, set by FutexWaitPi().
+    fbl::RefPtr<ThreadDispatcher> owner_;
+    int owner_priority_ TA_GUARDED(thread_lock) = -1;
+    fbl::DoublyLinkedListNodeState<FutexNode*> owner_node_;
 
     // Used for waking the thread corresponding to the FutexNode.
     WaitQueue wait_queue_;
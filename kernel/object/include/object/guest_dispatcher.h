@@ -8,6 +8,7 @@
 
 #include <zircon/syscalls/hypervisor.h>
 #include <zircon/types.h>
+#include <fbl/atomic.h>
 #include <object/port_dispatcher.h>
 
 class Guest;
@@ -15,7 +16,8 @@ class VmObject;
 
 class GuestDispatcher final : public SoloDispatcher<GuestDispatcher, ZX_DEFAULT_GUEST_RIGHTS> {
 public:
-    static zx_status_t Create(fbl::RefPtr<Dispatcher>* guest_dispatcher,
+    static zx_status_t Create(uint32_t options,
+                              fbl::RefPtr<Dispatcher>* guest_dispatcher,
                               zx_rights_t* guest_rights,
                               fbl::RefPtr<Dispatcher>* vmar_dispatcher,
                               zx_rights_t* vmar_rights);
@@ -27,9 +29,15 @@ public:
     zx_status_t SetTrap(uint32_t kind, zx_vaddr_t addr, size_t len,
                         fbl::RefPtr<PortDispatcher> port, uint64_t key);
 
+    // Commits and maps the memory of the guest when its first VCPU is created,
+    // if the guest was created with ZX_GUEST_OPT_PREFAULT.
+    zx_status_t Prefault();
+
 private:
     fbl::Canary<fbl::magic("GSTD")> canary_;
     fbl::unique_ptr<Guest> guest_;
+    const uint32_t options_;
+    fbl::atomic_bool prefaulted_;
 
-    explicit GuestDispatcher(fbl::unique_ptr<Guest> guest);
+    GuestDispatcher(uint32_t options, fbl::unique_ptr<Guest> guest);
 };
@@ -79,8 +79,8 @@ private:
 // A Handle is how a specific process refers to a specific Dispatcher.
 class Handle final : public fbl::DoublyLinkedListable<Handle*> {
 public:
-    // The handle arena's mutex. This is public since it protects
-    // other things like |Dispatcher::handle_count_|.
+    // The handle arena's mutex. Handles are allocated from and freed to
+    // per-cpu caches, so it is only taken to refill or drain one of those.
     DECLARE_SINGLETON_MUTEX(ArenaLock);
 
     // Returns the Dispatcher to which this instance points.
@@ -136,6 +136,11 @@ public:
         fbl::RefPtr<Dispatcher> dispatcher, zx_rights_t rights);
     static HandleOwner Dup(Handle* source, zx_rights_t rights);
 
+    // Deletes every handle on |handles|, as if each was owned by a
+    // HandleOwner that went away, but returns their arena slots in batches.
+    // Used to tear down a whole handle table at once.
+    static void DeleteList(fbl::DoublyLinkedList<Handle*>* handles);
+
 private:
     DISALLOW_COPY_ASSIGN_AND_MOVE(Handle);
 
@@ -150,6 +155,11 @@ private:
                        uint32_t* base_value);
     static uint32_t GetNewBaseValue(void* addr);
 
+    // Get and put arena slots through the current cpu's cache.
+    static void* AllocSlot() TA_EXCL(ArenaLock::Get());
+    static void FreeSlot(void* addr) TA_EXCL(ArenaLock::Get());
+    static void FreeSlots(void** slots, size_t count) TA_EXCL(ArenaLock::Get());
+
     // Handle should never be destroyed by anything other than Delete,
     // which uses TearDown to do the actual destruction.
     ~Handle() = default;
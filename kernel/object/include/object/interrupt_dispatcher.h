@@ -6,10 +6,13 @@
 
 #pragma once
 
+#include <kernel/cpu.h>
 #include <kernel/event.h>
 #include <kernel/spinlock.h>
+#include <kernel/timer.h>
 
 #include <zircon/rights.h>
+#include <zircon/syscalls/object.h>
 #include <zircon/types.h>
 
 #include <fbl/mutex.h>
@@ -41,6 +44,16 @@ public:
     zx_status_t Bind(fbl::RefPtr<PortDispatcher> port_dispatcher,
                      fbl::RefPtr<InterruptDispatcher> interrupt, uint64_t key);
 
+    // ZX_PROP_INTERRUPT_COALESCE. Only affects interrupts bound to a port.
+    zx_status_t SetCoalescing(const zx_interrupt_coalesce_t& coalesce);
+    zx_interrupt_coalesce_t GetCoalescing();
+
+    // ZX_PROP_INTERRUPT_AFFINITY.
+    virtual zx_status_t SetAffinity(cpu_num_t cpu) { return ZX_ERR_NOT_SUPPORTED; }
+    virtual cpu_num_t GetAffinity() const { return INVALID_CPU; }
+
+    void GetInfo(zx_info_interrupt_t* info);
+
 protected:
     virtual void MaskInterrupt() = 0;
     virtual void UnmaskInterrupt() = 0;
@@ -51,19 +64,42 @@ protected:
         event_signal_etc(&event_, true, ZX_OK);
     }
     void set_flags(uint32_t flags) { flags_ = flags; }
-    bool SendPacketLocked(zx_time_t timestamp) TA_REQ(spinlock_);
+    bool SendPacketLocked() TA_REQ(spinlock_);
     // Bits for Interrupt.flags
     static constexpr uint32_t INTERRUPT_VIRTUAL         = (1u << 0);
     static constexpr uint32_t INTERRUPT_UNMASK_PREWAIT  = (1u << 1);
     static constexpr uint32_t INTERRUPT_MASK_POSTWAIT   = (1u << 2);
 
 private:
+    // Notes an interrupt at |timestamp| that has not been reported yet.
+    void RecordLocked(zx_time_t timestamp) TA_REQ(spinlock_);
+    // Whether the coalescing window for the pending interrupts is still open.
+    bool CoalescingLocked() const TA_REQ(spinlock_);
+    // Called on a port-bound interrupt with pending interrupts before it
+    // queues a packet. Returns true, and arms the coalescing timer, if the
+    // packet should be held back for now.
+    bool HoldLocked() TA_REQ(spinlock_);
+    static void CoalesceTimerCallback(timer_t* timer, zx_time_t now, void* arg);
+    void OnCoalesceTimer();
+
     event_t event_;
 
     // Interrupt Flags
     uint32_t flags_;
 
     zx_time_t timestamp_ TA_GUARDED(spinlock_);
+    // The last interrupt and the number of interrupts since the last packet.
+    zx_time_t last_timestamp_ TA_GUARDED(spinlock_) = 0;
+    uint32_t pending_count_ TA_GUARDED(spinlock_) = 0;
+
+    // Interrupt coalescing, see zx_interrupt_coalesce_t. While the window is
+    // open the interrupt stays IDLE with |pending_count_| set, and
+    // |coalesce_timer_| delivers the packet at |coalesce_deadline_|.
+    uint32_t coalesce_max_count_ TA_GUARDED(spinlock_) = 0;
+    zx_duration_t coalesce_max_delay_ TA_GUARDED(spinlock_) = 0;
+    zx_time_t coalesce_deadline_ TA_GUARDED(spinlock_) = 0;
+    bool coalesce_timer_armed_ TA_GUARDED(spinlock_) = false;
+    timer_t coalesce_timer_;
     // Current state of the interrupt object
     InterruptState state_ TA_GUARDED(spinlock_);
     PortInterruptPacket port_packet_ TA_GUARDED(spinlock_) = {};
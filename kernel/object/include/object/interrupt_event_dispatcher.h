@@ -7,6 +7,7 @@
 #pragma once
 
 #include <zircon/types.h>
+#include <fbl/atomic.h>
 #include <fbl/canary.h>
 #include <object/interrupt_dispatcher.h>
 #include <sys/types.h>
@@ -21,6 +22,9 @@ public:
     InterruptEventDispatcher(const InterruptDispatcher &) = delete;
     InterruptEventDispatcher& operator=(const InterruptDispatcher &) = delete;
 
+    zx_status_t SetAffinity(cpu_num_t cpu) final;
+    cpu_num_t GetAffinity() const final { return affinity_.load(); }
+
 protected:
     void MaskInterrupt() final;
     void UnmaskInterrupt() final;
@@ -34,6 +38,7 @@ private:
     static void IrqHandler(void* ctx);
 
     const uint32_t vector_;
+    fbl::atomic<cpu_num_t> affinity_{INVALID_CPU};
 
     fbl::Canary<fbl::magic("INED")> canary_;
 };
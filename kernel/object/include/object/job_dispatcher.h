@@ -8,10 +8,12 @@
 
 #include <stdint.h>
 
+#include <object/cpu_bandwidth.h>
 #include <object/dispatcher.h>
 #include <object/excp_port.h>
 #include <object/policy_manager.h>
 #include <object/process_dispatcher.h>
+#include <object/task_counters.h>
 
 #include <zircon/types.h>
 #include <fbl/array.h>
@@ -137,6 +139,21 @@ public:
     void set_kill_on_oom(bool kill);
     bool get_kill_on_oom() const;
 
+    // Charges usage of a process in this job to this job and every job
+    // above it. Returns 0 if none of those jobs limits its cpu bandwidth,
+    // otherwise the time until which the quota of one of them has run out,
+    // which is in the past while they all have quota left.
+    zx_time_t ChargeUsage(zx_duration_t runtime, uint64_t context_switches,
+                          uint64_t page_faults);
+    void GetUsage(zx_info_task_usage_t* usage) const { counters_.GetUsage(usage); }
+
+    zx_status_t SetCpuBandwidth(const zx_job_cpu_bandwidth_t& limit) {
+        return cpu_bandwidth_.Set(limit);
+    }
+    void GetCpuBandwidth(zx_info_job_cpu_bandwidth_t* info) const {
+        cpu_bandwidth_.GetInfo(info);
+    }
+
 private:
     enum class State {
         READY,
@@ -173,6 +190,10 @@ private:
     // is, there is no mechanism to mint a handle to a job via this name.
     fbl::Name<ZX_MAX_NAME_LEN> name_;
 
+    // Usage of the processes in this job and its descendants.
+    TaskCounters counters_;
+    CpuBandwidth cpu_bandwidth_;
+
     // The common |get_lock()| protects all members below.
     State state_ TA_GUARDED(get_lock());
     uint32_t process_count_ TA_GUARDED(get_lock());
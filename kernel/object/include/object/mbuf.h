@@ -12,6 +12,8 @@
 #include <zircon/types.h>
 #include <fbl/intrusive_single_list.h>
 
+struct vm_page;
+
 // MBufChain is a container for storing a stream of bytes or a sequence of datagrams.
 //
 // It's designed to back sockets and channels.  Don't simultaneously store stream data and datagrams
@@ -23,8 +25,13 @@ public:
 
     // Writes |len| bytes of stream data from |src| and sets |written| to number of bytes written.
     //
+    // Whole pages of data are stored in page sized mbufs. When |move_pages| is true and |src| is
+    // page aligned, the pages backing |src| may be moved into the chain, which leaves that part of
+    // the source range decommitted.
+    //
     // Returns an error on failure.
-    zx_status_t WriteStream(user_in_ptr<const void> src, size_t len, size_t* written);
+    zx_status_t WriteStream(user_in_ptr<const void> src, size_t len, bool move_pages,
+                            size_t* written);
 
     // Writes a datagram of |len| bytes from |src| and sets |written| to number of bytes written.
     //
@@ -44,6 +51,9 @@ public:
     // call will read at most one datagram.  If |len| is too small to read a complete datagram, a
     // partial datagram is returned and its remaining bytes are discarded.
     //
+    // Data that was stored in whole pages is moved, rather than copied, into a stream reader's
+    // buffer where that buffer is page aligned.
+    //
     // Returns number of bytes read.
     size_t Read(user_out_ptr<void> dst, size_t len, bool datagram);
 
@@ -64,17 +74,27 @@ public:
     size_t max_size() const { return kSizeMax; }
 
 private:
-    // An MBuf is a small fixed-size chainable memory buffer.
+    // An MBuf is a chainable memory buffer. Its payload either follows the header inline, see
+    // SmallMBuf, or is a whole page of its own.
     struct MBuf : public fbl::SinglyLinkedListable<MBuf*> {
-        // 8 for the linked list and 4 for the explicit uint32_t fields.
-        static constexpr size_t kHeaderSize = 8 + (4 * 4);
+        // 8 for the linked list, 4 for the explicit uint32_t fields and 8 for the page pointer.
+        static constexpr size_t kHeaderSize = 8 + (4 * 4) + 8;
         // 16 is for the malloc header.
         static constexpr size_t kMallocSize = 2048 - 16;
         static constexpr size_t kPayloadSize = kMallocSize - kHeaderSize;
 
+        // Returns the start of the payload.
+        char* data();
+
+        // Returns the size of the payload.
+        size_t capacity() const;
+
         // Returns number of bytes of free space in this MBuf.
         size_t rem() const;
 
+        // Returns true if this MBuf holds exactly one page of data in a page of its own.
+        bool is_full_page() const;
+
         uint32_t off_ = 0u;
         uint32_t len_ = 0u;
         // pkt_len_ is set to the total number of bytes in a packet
@@ -84,15 +104,32 @@ private:
         // Always 0 in ZX_SOCKET_STREAM mode.
         uint32_t pkt_len_ = 0u;
         uint32_t unused_;
+        // The page holding the payload, in state VM_PAGE_STATE_IPC, or null for a SmallMBuf.
+        vm_page* page_ = nullptr;
+    };
+
+    struct SmallMBuf : public MBuf {
         char data_[kPayloadSize] = {0};
-        // TODO: maybe union data_ with char* blocks for large messages
     };
-    static_assert(sizeof(MBuf) == MBuf::kMallocSize, "");
+    static_assert(sizeof(SmallMBuf) == MBuf::kMallocSize, "");
 
     static constexpr size_t kSizeMax = 128 * MBuf::kPayloadSize;
 
     MBuf* AllocMBuf();
+    MBuf* AllocPageMBuf();
     void FreeMBuf(MBuf* buf);
+    static void DestroyMBuf(MBuf* buf);
+
+    // Appends |buf| to the chain and makes it the head.
+    void AppendMBuf(MBuf* buf);
+
+    // Moves up to |len| bytes, a multiple of PAGE_SIZE, of the pages backing the page aligned
+    // |src| into page mbufs at the end of the chain. Returns the number of bytes moved.
+    size_t MovePagesIn(user_in_ptr<const void> src, size_t len);
+
+    // Moves up to |len| bytes of the full page mbufs at the front of the chain into the page
+    // aligned |dst|. Returns the number of bytes moved.
+    size_t MovePagesOut(user_out_ptr<void> dst, size_t len);
 
     fbl::SinglyLinkedList<MBuf*> freelist_;
     fbl::SinglyLinkedList<MBuf*> tail_;
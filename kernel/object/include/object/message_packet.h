@@ -12,6 +12,7 @@
 #include <fbl/intrusive_single_list.h>
 #include <fbl/unique_ptr.h>
 #include <lib/user_copy/user_ptr.h>
+#include <list.h>
 #include <object/buffer_chain.h>
 #include <object/handle.h>
 #include <zircon/types.h>
@@ -38,14 +39,30 @@ public:
                               uint32_t num_handles,
                               fbl::unique_ptr<MessagePacket>* msg);
 
+    // Like Create(), but moves the pages backing |data| into the packet instead of copying them,
+    // leaving the caller's range decommitted. |data| and |data_size| must be page aligned and the
+    // range must lie within a single writable mapping of a vmo that no clone reads through.
+    // Returns ZX_ERR_NOT_SUPPORTED, having changed nothing visible, when that is not the case.
+    static zx_status_t CreateFromPages(user_in_ptr<const void> data, uint32_t data_size,
+                                       uint32_t num_handles,
+                                       fbl::unique_ptr<MessagePacket>* msg);
+
     uint32_t data_size() const { return data_size_; }
 
     // Copies the packet's |data_size()| bytes to |buf|.
     // Returns an error if |buf| points to a bad user address.
     zx_status_t CopyDataTo(user_out_ptr<void> buf) const {
+        if (unlikely(!list_is_empty(&pages_))) {
+            return CopyPagesTo(buf);
+        }
         return buffer_chain_->CopyOut(buf, payload_offset_, data_size_);
     }
 
+    // Like CopyDataTo(), but for a packet made by CreateFromPages() hands its pages to the vmo
+    // behind |buf| when |buf| is page aligned and mapped writable. The packet is left without
+    // data and must be destroyed.
+    zx_status_t MoveDataTo(user_out_ptr<void> buf);
+
     uint32_t num_handles() const { return num_handles_; }
     Handle* const* handles() const { return handles_; }
     Handle** mutable_handles() { return handles_; }
@@ -59,14 +76,12 @@ public:
             return 0;
         }
         // The first few bytes of the payload are a zx_txid_t.
-        void* payload_start = buffer_chain_->buffers()->front().data() + payload_offset_;
-        return *reinterpret_cast<zx_txid_t*>(payload_start);
+        return *reinterpret_cast<zx_txid_t*>(PayloadStart());
     }
 
     void set_txid(zx_txid_t txid) {
         if (data_size_ >= sizeof(zx_txid_t)) {
-            void* payload_start = buffer_chain_->buffers()->front().data() + payload_offset_;
-            *(reinterpret_cast<zx_txid_t*>(payload_start)) = txid;
+            *(reinterpret_cast<zx_txid_t*>(PayloadStart())) = txid;
         }
     }
 
@@ -74,7 +89,9 @@ private:
     MessagePacket(BufferChain* chain, uint32_t data_size, uint32_t payload_offset,
                   uint16_t num_handles, Handle** handles)
         : buffer_chain_(chain), handles_(handles), data_size_(data_size),
-          payload_offset_(payload_offset), num_handles_(num_handles), owns_handles_(false) {}
+          payload_offset_(payload_offset), num_handles_(num_handles), owns_handles_(false) {
+        list_initialize(&pages_);
+    }
 
     friend class fbl::unique_ptr<MessagePacket>;
     ~MessagePacket() {
@@ -90,10 +107,16 @@ private:
     friend class fbl::Recyclable<MessagePacket>;
     void fbl_recycle();
 
-    static zx_status_t CreateCommon(uint32_t data_size, uint32_t num_handles,
+    static zx_status_t CreateCommon(uint32_t data_size, uint32_t num_handles, bool buffered,
                                     fbl::unique_ptr<MessagePacket>* msg);
 
+    char* PayloadStart() const;
+    zx_status_t CopyPagesTo(user_out_ptr<void> buf) const;
+
     BufferChain* buffer_chain_;
+    // Pages holding the payload of a packet made by CreateFromPages(), in order. Empty when the
+    // payload lives in the buffer chain.
+    list_node pages_;
     Handle** const handles_;
     const uint32_t data_size_;
     const uint32_t payload_offset_;
@@ -24,6 +24,9 @@ public:
 
     ~PciInterruptDispatcher() final;
 
+    zx_status_t SetAffinity(cpu_num_t cpu) final;
+    cpu_num_t GetAffinity() const final;
+
 protected:
     void MaskInterrupt() final;
     void UnmaskInterrupt() final;
@@ -76,10 +76,27 @@ protected:
                               uint32_t perms,
                               fbl::RefPtr<Dispatcher>* dispatcher,
                               zx_rights_t* rights);
+
+    // Like Create(), but takes over |*mapped_addrs|, the IOMMU mappings of
+    // |*pinned_vmo| that an unpinned PMT left in |bti|'s pin cache.  Both are
+    // left untouched on failure.  Must be created under the BTI dispatcher's
+    // lock.
+    static zx_status_t CreateFromCache(fbl::RefPtr<BusTransactionInitiatorDispatcher> bti,
+                                       PinnedVmObject* pinned_vmo,
+                                       uint32_t perms,
+                                       fbl::Array<dev_vaddr_t>* mapped_addrs,
+                                       fbl::RefPtr<Dispatcher>* dispatcher,
+                                       zx_rights_t* rights);
+
+    // Removes the IOMMU mappings |mapped_addrs| of |pinned_vmo| that were
+    // made on behalf of |bti|.
+    static zx_status_t UnmapFromIommu(const BusTransactionInitiatorDispatcher& bti,
+                                      const PinnedVmObject& pinned_vmo,
+                                      const fbl::Array<dev_vaddr_t>& mapped_addrs);
 private:
     PinnedMemoryTokenDispatcher(fbl::RefPtr<BusTransactionInitiatorDispatcher> bti,
-                                PinnedVmObject pinned_vmo,
-                                fbl::Array<dev_vaddr_t> mapped_addrs);
+                                PinnedVmObject&& pinned_vmo, uint32_t perms,
+                                fbl::Array<dev_vaddr_t>&& mapped_addrs);
     DISALLOW_COPY_ASSIGN_AND_MOVE(PinnedMemoryTokenDispatcher);
 
     zx_status_t MapIntoIommu(uint32_t perms);
@@ -100,5 +117,9 @@ private:
     bool explicitly_unpinned_ TA_GUARDED(get_lock()) = false;
 
     const fbl::RefPtr<BusTransactionInitiatorDispatcher> bti_;
-    const fbl::Array<dev_vaddr_t> mapped_addrs_ TA_GUARDED(get_lock());
+    // The IOMMU permissions the range was mapped with
+    const uint32_t perms_;
+    // Not const, since the destructor may hand the mappings to the BTI's pin
+    // cache.
+    fbl::Array<dev_vaddr_t> mapped_addrs_ TA_GUARDED(get_lock());
 };
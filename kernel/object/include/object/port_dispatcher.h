@@ -14,6 +14,7 @@
 #include <zircon/syscalls/port.h>
 #include <zircon/types.h>
 
+#include <fbl/atomic.h>
 #include <fbl/canary.h>
 #include <fbl/intrusive_double_list.h>
 #include <fbl/mutex.h>
@@ -106,6 +107,8 @@ struct PortPacket final : public fbl::DoublyLinkedListable<PortPacket*> {
 
 struct PortInterruptPacket final : public fbl::DoublyLinkedListable<PortInterruptPacket*> {
     zx_time_t timestamp;
+    zx_time_t last_timestamp;
+    uint32_t count;
     uint64_t key;
 };
 
@@ -176,8 +179,13 @@ public:
 
     zx_status_t Queue(PortPacket* port_packet, zx_signals_t observed, uint64_t count);
     zx_status_t QueueUser(const zx_port_packet_t& packet);
-    bool QueueInterruptPacket(PortInterruptPacket* port_packet, zx_time_t timestamp);
+    bool QueueInterruptPacket(PortInterruptPacket* port_packet, zx_time_t timestamp,
+                              zx_time_t last_timestamp, uint32_t count);
     zx_status_t Dequeue(zx_time_t deadline, zx_port_packet_t* packet);
+    // Blocks like Dequeue() until a packet arrives, then returns up to |count|
+    // queued packets, taking the lock once. |*actual| is at least one on ZX_OK.
+    zx_status_t DequeueMany(zx_time_t deadline, zx_port_packet_t* packets, size_t count,
+                            size_t* actual);
     bool RemoveInterruptPacket(PortInterruptPacket* port_packet);
 
     // Decides who is going to destroy the observer. If it returns the
@@ -216,7 +224,9 @@ private:
     bool zero_handles_ TA_GUARDED(get_lock());
 
     // Next three members handle the object, manual and exception notifications.
-    size_t num_packets_ TA_GUARDED(get_lock());
+    // |num_packets_| is only written under the lock, but waiters read it
+    // without the lock to skip taking it when the queue is empty.
+    fbl::atomic<size_t> num_packets_;
     fbl::DoublyLinkedList<PortPacket*> packets_ TA_GUARDED(get_lock());
     fbl::DoublyLinkedList<fbl::RefPtr<ExceptionPort>> eports_ TA_GUARDED(get_lock());
     // Next two members handle the interrupt notifications.
@@ -13,11 +13,14 @@
 #include <object/futex_context.h>
 #include <object/handle.h>
 #include <object/policy_manager.h>
+#include <object/syscall_stats.h>
+#include <object/task_counters.h>
 #include <object/thread_dispatcher.h>
 
 #include <zircon/syscalls/object.h>
 #include <zircon/types.h>
 #include <fbl/array.h>
+#include <fbl/atomic.h>
 #include <fbl/canary.h>
 #include <fbl/intrusive_double_list.h>
 #include <fbl/mutex.h>
@@ -195,9 +198,17 @@ public:
     void Exit(int64_t retcode) __NO_RETURN;
     void Kill();
 
+    // Charges usage of one of the process's threads to the process and its
+    // jobs. Lock free. Returns the same as JobDispatcher::ChargeUsage().
+    zx_time_t ChargeUsage(zx_duration_t runtime, uint64_t context_switches,
+                          uint64_t page_faults);
+
     // Syscall helpers
     zx_status_t GetInfo(zx_info_process_t* info);
     zx_status_t GetStats(zx_info_task_stats_t* stats);
+    void GetUsage(zx_info_task_usage_t* usage) const { counters_.GetUsage(usage); }
+    // Null unless SyscallStats::enabled().
+    SyscallStats* syscall_stats() const { return syscall_stats_.get(); }
     // NOTE: Code outside of the syscall layer should not typically know about
     // user_ptrs; do not use this pattern as an example.
     zx_status_t GetAspaceMaps(user_out_ptr<zx_info_maps_t> maps, size_t max,
@@ -251,6 +262,17 @@ public:
     //     // Ok to create a channel.
     zx_status_t QueryPolicy(uint32_t condition) const;
 
+    // Charges one outstanding VmoAsyncOp to the process, unless |max| already
+    // are. Returns whether it was charged.
+    bool ChargeVmoAsyncOp(uint32_t max) {
+        if (vmo_async_ops_.fetch_add(1, fbl::memory_order_relaxed) >= max) {
+            vmo_async_ops_.fetch_sub(1, fbl::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+    void UnchargeVmoAsyncOp() { vmo_async_ops_.fetch_sub(1, fbl::memory_order_relaxed); }
+
     // return a cached copy of the vdso code address or compute a new one
     uintptr_t vdso_code_address() {
         if (unlikely(vdso_code_address_ == 0)) {
@@ -346,6 +368,15 @@ private:
     // The user-friendly process name. For debug purposes only. That
     // is, there is no mechanism to mint a handle to a process via this name.
     fbl::Name<ZX_MAX_NAME_LEN> name_;
+
+    // Usage of the threads of this process, including exited ones.
+    TaskCounters counters_;
+
+    // Set once in Create(), before any thread can make a syscall.
+    fbl::unique_ptr<SyscallStats> syscall_stats_;
+
+    // Number of ZX_VMO_OP_*_ASYNC requests of this process not finished yet.
+    fbl::atomic<uint32_t> vmo_async_ops_{0};
 };
 
 const char* StateToString(ProcessDispatcher::State state);
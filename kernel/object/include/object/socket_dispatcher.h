@@ -33,7 +33,18 @@ public:
     zx_obj_type_t get_type() const final { return ZX_OBJ_TYPE_SOCKET; }
 
     // Socket methods.
-    zx_status_t Write(user_in_ptr<const void> src, size_t len, size_t* written);
+    // |move_pages| lets a stream socket take the pages backing a page aligned |src| rather
+    // than copy them; it is ignored by datagram sockets.
+    zx_status_t Write(user_in_ptr<const void> src, size_t len, bool move_pages, size_t* written);
+
+    // Writes the user buffers described by |vectors| under a single acquisition of the socket
+    // lock, stopping at the first one that is written short. Stream sockets only.
+    zx_status_t WriteVector(const zx_iovec_t* vectors, size_t count, size_t* written);
+
+    // Writes each of |vectors| as its own datagram under a single acquisition of the socket lock,
+    // stopping at the first one that does not fit. |written| is the number of datagrams written.
+    // Datagram sockets only.
+    zx_status_t WriteDatagramVector(const zx_iovec_t* vectors, size_t count, size_t* written);
 
     zx_status_t WriteControl(user_in_ptr<const void> src, size_t len);
 
@@ -44,6 +55,15 @@ public:
 
     zx_status_t Read(user_out_ptr<void> dst, size_t len, size_t* nread);
 
+    // Fills the user buffers described by |vectors| in order under a single acquisition of the
+    // socket lock. Stream sockets only.
+    zx_status_t ReadVector(const zx_iovec_t* vectors, size_t count, size_t* nread);
+
+    // Reads at most one datagram into each of |vectors|, after a zx_socket_datagram_header_t, under
+    // a single acquisition of the socket lock. |nread| is the number of datagrams read. Datagram
+    // sockets only.
+    zx_status_t ReadDatagramVector(const zx_iovec_t* vectors, size_t count, size_t* nread);
+
     zx_status_t ReadControl(user_out_ptr<void> dst, size_t len, size_t* nread);
 
     // On success, the share queue takes ownership of |h|. On failure,
@@ -82,7 +102,16 @@ private:
                      zx_signals_t starting_signals, uint32_t flags,
                      fbl::unique_ptr<ControlMsg> control_msg);
     void Init(fbl::RefPtr<SocketDispatcher> other);
-    zx_status_t WriteSelfLocked(user_in_ptr<const void> src, size_t len, size_t* nwritten) TA_REQ(get_lock());
+    zx_status_t WriteSelfLocked(user_in_ptr<const void> src, size_t len, bool move_pages,
+                                size_t* nwritten) TA_REQ(get_lock());
+    zx_status_t WriteVectorSelfLocked(const zx_iovec_t* vectors, size_t count,
+                                      size_t* nwritten) TA_REQ(get_lock());
+    zx_status_t WriteDatagramVectorSelfLocked(const zx_iovec_t* vectors, size_t count,
+                                              size_t* nwritten) TA_REQ(get_lock());
+    // Update the signals of both endpoints after data was written to or read from this one.
+    void OnWriteLocked(bool was_empty, size_t written) TA_REQ(get_lock());
+    void OnReadLocked(bool was_full, size_t nread) TA_REQ(get_lock());
+    zx_status_t CheckReadableLocked() const TA_REQ(get_lock());
     zx_status_t WriteControlSelfLocked(user_in_ptr<const void> src, size_t len) TA_REQ(get_lock());
     zx_status_t UserSignalSelfLocked(uint32_t clear_mask, uint32_t set_mask) TA_REQ(get_lock());
     zx_status_t ShutdownOtherLocked(uint32_t how) TA_REQ(get_lock());
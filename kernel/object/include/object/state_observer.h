@@ -68,12 +68,23 @@ public:
     // is safe to delete the observer.
     virtual void OnRemoved() {}
 
+    // The signals this observer cares about. OnStateChange() is only called for state changes
+    // which set or clear at least one of them.
+    zx_signals_t interest() const { return interest_; }
+
 protected:
     ~StateObserver() {}
 
+    // Narrows interest(), which by default is every signal. Observers should only narrow it to
+    // signals outside of which a state change can never make OnStateChange() do anything.
+    // Must be called before the observer is added to a dispatcher.
+    void set_interest(zx_signals_t signals) { interest_ = signals; }
+
 private:
     fbl::Canary<fbl::magic("SOBS")> canary_;
 
+    zx_signals_t interest_ = ~0u;
+
     friend struct StateObserverListTraits;
     fbl::DoublyLinkedListNodeState<StateObserver*> state_observer_list_node_state_;
 };
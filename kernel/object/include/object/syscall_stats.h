@@ -0,0 +1,63 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <fbl/atomic.h>
+#include <fbl/unique_ptr.h>
+#include <kernel/cpu.h>
+#include <zircon/syscalls/object.h>
+#include <zircon/types.h>
+#include <zircon/zx-syscall-numbers.h>
+
+// Call counts, total and max durations and log2 latency histograms of every
+// syscall, kept per cpu and per process when the kernel.syscall-stats boot
+// option is set. Exported through the ZX_INFO_SYSCALL_STATS topic.
+class SyscallStats {
+public:
+    static constexpr size_t kBuckets = ZX_INFO_SYSCALL_STATS_BUCKETS;
+
+    // Whether syscalls are being measured. Fixed once the kernel is up.
+    static bool enabled() { return enabled_; }
+
+    // Allocates the stats of a new process. Returns null if out of memory.
+    static fbl::unique_ptr<SyscallStats> Create();
+
+    // The stats of syscalls made on |cpu|. Only valid while enabled().
+    static SyscallStats* ForCpu(cpu_num_t cpu) { return &cpu_stats_[cpu]; }
+
+    // Charges a call to |syscall_num| which took |duration| to the current
+    // cpu and to |process|, which may be null. Must be called with
+    // interrupts disabled.
+    static void Record(uint64_t syscall_num, zx_duration_t duration, SyscallStats* process);
+
+    // Adds the counts of |syscall_num| to |stats|.
+    void Accumulate(uint32_t syscall_num, zx_info_syscall_stats_t* stats) const;
+
+    // Initializes the per cpu stats; called once at boot.
+    static void Init();
+
+private:
+    struct Entry {
+        fbl::atomic<uint64_t> count{0};
+        fbl::atomic<zx_duration_t> total_time{0};
+        fbl::atomic<zx_duration_t> max_time{0};
+        fbl::atomic<uint64_t> histogram[kBuckets] = {};
+    };
+
+    static size_t Bucket(zx_duration_t duration);
+
+    // Per cpu stats are only ever written by their own cpu with interrupts
+    // disabled, so they skip the locked read-modify-write cycles that process
+    // stats, written from every cpu, need.
+    void AddLocal(uint32_t syscall_num, zx_duration_t duration, size_t bucket);
+    void AddShared(uint32_t syscall_num, zx_duration_t duration, size_t bucket);
+
+    static bool enabled_;
+    static SyscallStats* cpu_stats_;
+
+    Entry entries_[ZX_SYS_COUNT];
+};
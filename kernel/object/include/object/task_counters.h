@@ -0,0 +1,37 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <fbl/atomic.h>
+#include <zircon/syscalls/object.h>
+#include <zircon/types.h>
+
+// Usage a task has accumulated over its lifetime. A process charges its own
+// counters and those of every job above it, so reading the totals of a job
+// costs the same no matter how many tasks it holds.
+class TaskCounters {
+public:
+    void Charge(zx_duration_t runtime, uint64_t context_switches, uint64_t page_faults) {
+        if (runtime)
+            cpu_time_.fetch_add(runtime, fbl::memory_order_relaxed);
+        if (context_switches)
+            context_switches_.fetch_add(context_switches, fbl::memory_order_relaxed);
+        if (page_faults)
+            page_faults_.fetch_add(page_faults, fbl::memory_order_relaxed);
+    }
+
+    void GetUsage(zx_info_task_usage_t* usage) const {
+        usage->cpu_time = cpu_time_.load(fbl::memory_order_relaxed);
+        usage->context_switches = context_switches_.load(fbl::memory_order_relaxed);
+        usage->page_faults = page_faults_.load(fbl::memory_order_relaxed);
+    }
+
+private:
+    fbl::atomic<zx_duration_t> cpu_time_{0};
+    fbl::atomic<uint64_t> context_switches_{0};
+    fbl::atomic<uint64_t> page_faults_{0};
+};
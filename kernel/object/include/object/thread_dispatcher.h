@@ -142,6 +142,15 @@ public:
     // Returns ZX_ERR_BAD_STATE if not in an exception.
     zx_status_t GetExceptionReport(zx_exception_report_t* report);
 
+    // Sets the ZX_PROP_EXCEPTION_HANDLER handler. Only called by the thread
+    // itself.
+    zx_status_t SetExceptionHandler(const zx_thread_exception_handler_t& handler);
+
+    // Called by the thread itself in an exception. If it has an in-thread
+    // handler for |exception_type|, sets it up to return to the handler and
+    // returns true.
+    bool RedirectToExceptionHandler(uint exception_type, arch_exception_context_t* context);
+
     // Fetch the state of the thread for userspace tools.
     zx_status_t GetInfoForUserspace(zx_info_thread_t* info);
 
@@ -154,6 +163,18 @@ public:
                            size_t buffer_len);
     // Profile support
     zx_status_t SetPriority(int32_t priority);
+    // Moves the thread into the weighted-fair scheduling class at |priority|,
+    // with performance hint |perf_hint|.
+    zx_status_t SetFairParams(int32_t priority, uint32_t weight, zx_duration_t deadline,
+                              uint32_t perf_hint);
+
+    // Priority inheritance for FutexNode. |head| is the head of the wait
+    // list of a PI futex the thread owns. The thread inherits the highest
+    // owner_priority() among the heads it owns, recomputed by each of these;
+    // |local_resched| is set if the local cpu needs to reschedule.
+    void AddPiFutex(FutexNode* head, bool* local_resched) TA_REQ(thread_lock);
+    void RemovePiFutex(FutexNode* head, bool* local_resched) TA_REQ(thread_lock);
+    void UpdatePiPriority(bool* local_resched) TA_REQ(thread_lock);
 
     // For ChannelDispatcher use.
     ChannelDispatcher::MessageWaiter* GetMessageWaiter() { return &channel_waiter_; }
@@ -238,6 +259,10 @@ private:
     // The exception port of the handler the thread is waiting for a response from.
     fbl::RefPtr<ExceptionPort> exception_wait_port_ TA_GUARDED(get_lock());
     const zx_exception_report_t* exception_report_ TA_GUARDED(get_lock());
+
+    // The in-thread exception handler. Only used by the thread itself, so it
+    // needs no lock.
+    zx_thread_exception_handler_t exception_handler_ = {};
     event_t exception_event_ =
         EVENT_INITIAL_VALUE(exception_event_, false, EVENT_FLAG_AUTOUNSIGNAL);
 
@@ -256,6 +281,10 @@ private:
     // in order to suspend a thread.
     ChannelDispatcher::MessageWaiter channel_waiter_;
 
+    // Heads of the wait lists of the PI futexes this thread owns.
+    fbl::DoublyLinkedList<FutexNode*, FutexNode::OwnerListTraits> pi_futexes_
+        TA_GUARDED(thread_lock);
+
     // LK thread structure
     // put last to ease debugging since this is a pretty large structure
     // (~1.5K on x86_64).
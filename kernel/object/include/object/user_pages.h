@@ -0,0 +1,28 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <list.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include <zircon/types.h>
+
+// Helpers for moving whole pages between the user address space of the current process and
+// kernel owned page lists, used by the IPC objects to avoid copying large page aligned payloads.
+//
+// Both require a page aligned range that lies within a single read-write mapping of a vmo that no
+// clone reads through, and return ZX_ERR_NOT_SUPPORTED, having changed nothing visible, when that
+// is not the case.
+
+// Moves the pages backing [va, va + len) onto the tail of |pages|, in order, leaving the range
+// decommitted. The pages are in state VM_PAGE_STATE_IPC.
+zx_status_t TakeUserPages(vaddr_t va, size_t len, list_node* pages);
+
+// Replaces the contents of [va, va + len) with the VM_PAGE_STATE_IPC pages on |pages|, which must
+// hold exactly len / PAGE_SIZE of them. On success the pages belong to the vmo and |pages| is
+// empty.
+zx_status_t SupplyUserPages(vaddr_t va, size_t len, list_node* pages);
@@ -11,6 +11,7 @@
 
 #include <fbl/canary.h>
 #include <object/dispatcher.h>
+#include <object/port_dispatcher.h>
 
 #include <lib/user_copy/user_ptr.h>
 #include <sys/types.h>
@@ -30,6 +31,7 @@ public:
 
     // SoloDispatcher implementation.
     zx_obj_type_t get_type() const final { return ZX_OBJ_TYPE_VMO; }
+    void on_zero_handles() final;
     void get_name(char out_name[ZX_MAX_NAME_LEN]) const final;
     zx_status_t set_name(const char* name, size_t len) final;
     CookieJar* get_cookie_jar() final { return &cookie_jar_; }
@@ -43,6 +45,10 @@ public:
     zx_status_t GetSize(uint64_t* size);
     zx_status_t RangeOp(uint32_t op, uint64_t offset, uint64_t size, user_inout_ptr<void> buffer,
                         size_t buffer_size, zx_rights_t rights);
+    // Starts ZX_VMO_OP_COMMIT_ASYNC or ZX_VMO_OP_PREFETCH_ASYNC, which report
+    // their result with a packet on |port|.
+    zx_status_t RangeOpAsync(uint32_t op, uint64_t offset, uint64_t size,
+                             fbl::RefPtr<PortDispatcher> port, uint64_t key, zx_rights_t rights);
     zx_status_t Clone(
         uint32_t options, uint64_t offset, uint64_t size, bool copy_name,
         fbl::RefPtr<VmObject>* clone_vmo);
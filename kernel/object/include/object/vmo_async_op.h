@@ -0,0 +1,80 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#pragma once
+
+#include <fbl/atomic.h>
+#include <fbl/intrusive_double_list.h>
+#include <fbl/ref_ptr.h>
+#include <fbl/unique_ptr.h>
+#include <object/port_dispatcher.h>
+#include <vm/vm_object.h>
+#include <zircon/types.h>
+
+class ProcessDispatcher;
+
+// A ZX_VMO_OP_COMMIT_ASYNC or ZX_VMO_OP_PREFETCH_ASYNC request. Requests run
+// on a small pool of kernel worker threads, which queue a ZX_PKT_TYPE_VMO_OP
+// packet with the result on the request's port when they are done.
+class VmoAsyncOp final : public fbl::DoublyLinkedListable<fbl::unique_ptr<VmoAsyncOp>> {
+public:
+    // Requests beyond this many waiting for a worker are refused with
+    // ZX_ERR_NO_RESOURCES.
+    static constexpr size_t kMaxPending = 1024;
+
+    // Requests beyond this many outstanding for one process are refused with
+    // ZX_ERR_NO_RESOURCES, so that no process can take up all of the pool.
+    static constexpr uint32_t kMaxPendingPerProcess = 64;
+
+    // The range is worked on in chunks of this size, so that the vmo lock is
+    // not held for all of a large range at once.
+    static constexpr uint64_t kChunkSize = 4 * LARGE_PAGE_SIZE;
+
+    // Queues a request on behalf of the current process.
+    static zx_status_t Submit(fbl::RefPtr<VmObject> vmo, uint32_t op, uint64_t offset,
+                              uint64_t size, fbl::RefPtr<PortDispatcher> port, uint64_t key);
+
+    // Cancel the requests on |vmo|, once it has no handles left. Their
+    // packets are queued with ZX_ERR_CANCELED. Requests already running stop
+    // at the end of the current chunk.
+    static void CancelVmo(const VmObject* vmo);
+
+    // Cancel the requests which would complete on |port|, once it has no
+    // handles left to read their packets from.
+    static void CancelPort(const PortDispatcher* port);
+
+    static void StartWorkers();
+
+    ~VmoAsyncOp();
+
+private:
+    VmoAsyncOp(fbl::RefPtr<ProcessDispatcher> process, fbl::RefPtr<VmObject> vmo, uint32_t op,
+               uint64_t offset, uint64_t size, fbl::RefPtr<PortDispatcher> port,
+               PortPacket* packet);
+
+    static int WorkerThread(void* arg);
+
+    // Cancels the requests on |vmo| or |port|, whichever is not null.
+    static void Cancel(const VmObject* vmo, const PortDispatcher* port);
+
+    // Does the work and queues the completion packet.
+    void Run();
+
+    // Queues the completion packet with |status|.
+    void Complete(zx_status_t status);
+
+    // The process the request is charged to, until it is destroyed.
+    fbl::RefPtr<ProcessDispatcher> process_;
+    fbl::RefPtr<VmObject> vmo_;
+    const uint32_t op_;
+    const uint64_t offset_;
+    const uint64_t size_;
+    fbl::RefPtr<PortDispatcher> port_;
+    // Allocated up front so that completion cannot fail for lack of memory.
+    PortPacket* packet_;
+    // Set by Cancel() while the request is running.
+    fbl::atomic<bool> canceled_{false};
+};
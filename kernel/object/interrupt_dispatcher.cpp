@@ -10,10 +10,12 @@
 #include <object/process_dispatcher.h>
 #include <platform.h>
 #include <zircon/syscalls/port.h>
+#include <zircon/time.h>
 
 InterruptDispatcher::InterruptDispatcher()
     : timestamp_(0), state_(InterruptState::IDLE) {
     event_init(&event_, false, EVENT_FLAG_AUTOUNSIGNAL);
+    timer_init(&coalesce_timer_);
 }
 
 zx_status_t InterruptDispatcher::WaitForInterrupt(zx_time_t* out_timestamp) {
@@ -30,6 +32,7 @@ zx_status_t InterruptDispatcher::WaitForInterrupt(zx_time_t* out_timestamp) {
                 state_ = InterruptState::NEEDACK;
                 *out_timestamp = timestamp_;
                 timestamp_ = 0;
+                pending_count_ = 0;
                 return event_unsignal(&event_);
             case InterruptState::NEEDACK:
                 if (flags_ & INTERRUPT_UNMASK_PREWAIT) {
@@ -61,15 +64,86 @@ zx_status_t InterruptDispatcher::WaitForInterrupt(zx_time_t* out_timestamp) {
     }
 }
 
-bool InterruptDispatcher::SendPacketLocked(zx_time_t timestamp) {
-    bool status = port_dispatcher_->QueueInterruptPacket(&port_packet_, timestamp);
+void InterruptDispatcher::RecordLocked(zx_time_t timestamp) {
+    // only record timestamp if this is the first signal since we started waiting
+    if (!timestamp_) {
+        timestamp_ = timestamp;
+    }
+    last_timestamp_ = timestamp;
+    if (pending_count_ == 0u && coalesce_max_count_ > 1u) {
+        coalesce_deadline_ = zx_time_add_duration(current_time(), coalesce_max_delay_);
+    }
+    if (pending_count_ < UINT32_MAX) {
+        pending_count_++;
+    }
+}
+
+bool InterruptDispatcher::SendPacketLocked() {
+    if (coalesce_timer_armed_) {
+        timer_cancel(&coalesce_timer_);
+        coalesce_timer_armed_ = false;
+    }
+    bool status = port_dispatcher_->QueueInterruptPacket(&port_packet_, timestamp_,
+                                                         last_timestamp_, pending_count_);
     if (flags_ & INTERRUPT_MASK_POSTWAIT) {
         MaskInterrupt();
     }
     timestamp_ = 0;
+    pending_count_ = 0;
     return status;
 }
 
+bool InterruptDispatcher::CoalescingLocked() const {
+    return coalesce_max_count_ > 1u && pending_count_ < coalesce_max_count_ &&
+           current_time() < coalesce_deadline_;
+}
+
+bool InterruptDispatcher::HoldLocked() {
+    DEBUG_ASSERT(pending_count_ > 0u);
+    if (!CoalescingLocked()) {
+        return false;
+    }
+
+    // A level-triggered line stays asserted until the driver services the
+    // device, so it has to stay masked while the window is open and only
+    // the time threshold applies to it.
+    if (flags_ & INTERRUPT_MASK_POSTWAIT) {
+        MaskInterrupt();
+    }
+    if (!coalesce_timer_armed_) {
+        // The callback may still be returning on another cpu. It gives up on
+        // |spinlock_| once the timer is canceled, so this cannot deadlock.
+        timer_cancel(&coalesce_timer_);
+        timer_set_oneshot(&coalesce_timer_, coalesce_deadline_, CoalesceTimerCallback, this);
+        coalesce_timer_armed_ = true;
+    }
+    return true;
+}
+
+void InterruptDispatcher::CoalesceTimerCallback(timer_t* timer, zx_time_t now, void* arg) {
+    static_cast<InterruptDispatcher*>(arg)->OnCoalesceTimer();
+}
+
+void InterruptDispatcher::OnCoalesceTimer() TA_NO_THREAD_SAFETY_ANALYSIS {
+    spin_lock_t* lock = spinlock_.lock().GetInternal();
+    if (timer_trylock_or_cancel(&coalesce_timer_, lock) != ZX_OK) {
+        return;
+    }
+    coalesce_timer_armed_ = false;
+    if (state_ == InterruptState::IDLE && port_dispatcher_ && pending_count_ > 0u) {
+        if (CoalescingLocked()) {
+            // Left over from an earlier window; only the callback itself
+            // may re-arm the timer without canceling it first.
+            timer_set_oneshot(&coalesce_timer_, coalesce_deadline_, CoalesceTimerCallback, this);
+            coalesce_timer_armed_ = true;
+        } else {
+            SendPacketLocked();
+            state_ = InterruptState::NEEDACK;
+        }
+    }
+    spin_unlock(lock);
+}
+
 zx_status_t InterruptDispatcher::Trigger(zx_time_t timestamp) {
 
     if (!(flags_ & INTERRUPT_VIRTUAL))
@@ -81,22 +155,20 @@ zx_status_t InterruptDispatcher::Trigger(zx_time_t timestamp) {
     resched_disable.Disable();
     Guard<SpinLock, IrqSave> guard{&spinlock_};
 
-    // only record timestamp if this is the first signal since we started waiting
-    if (!timestamp_) {
-        timestamp_ = timestamp;
-    }
     if (state_ == InterruptState::DESTROYED) {
         return ZX_ERR_CANCELED;
     }
+    RecordLocked(timestamp);
     if (state_ == InterruptState::NEEDACK && port_dispatcher_) {
         // Cannot trigger a interrupt without ACK
-        // only record timestamp if this is the first signal since we started waiting
         return ZX_OK;
     }
 
     if (port_dispatcher_) {
-        SendPacketLocked(timestamp);
-        state_ = InterruptState::NEEDACK;
+        if (!HoldLocked()) {
+            SendPacketLocked();
+            state_ = InterruptState::NEEDACK;
+        }
     } else {
         Signal();
         state_ = InterruptState::TRIGGERED;
@@ -107,16 +179,15 @@ zx_status_t InterruptDispatcher::Trigger(zx_time_t timestamp) {
 void InterruptDispatcher::InterruptHandler() {
     Guard<SpinLock, IrqSave> guard{&spinlock_};
 
-    // only record timestamp if this is the first IRQ since we started waiting
-    if (!timestamp_) {
-        timestamp_ = current_time();
-    }
+    RecordLocked(current_time());
     if (state_ == InterruptState::NEEDACK && port_dispatcher_) {
         return;
     }
     if (port_dispatcher_) {
-        SendPacketLocked(timestamp_);
-        state_ = InterruptState::NEEDACK;
+        if (!HoldLocked()) {
+            SendPacketLocked();
+            state_ = InterruptState::NEEDACK;
+        }
     } else {
         if (flags_ & INTERRUPT_MASK_POSTWAIT) {
             MaskInterrupt();
@@ -135,6 +206,8 @@ zx_status_t InterruptDispatcher::Destroy() {
 
     MaskInterrupt();
     UnregisterInterruptHandler();
+    timer_cancel(&coalesce_timer_);
+    coalesce_timer_armed_ = false;
 
     if (port_dispatcher_) {
         bool packet_was_in_queue = port_dispatcher_->RemoveInterruptPacket(&port_packet_);
@@ -190,8 +263,10 @@ zx_status_t InterruptDispatcher::Ack() {
         if (flags_ & INTERRUPT_UNMASK_PREWAIT) {
             UnmaskInterrupt();
         }
-        if (timestamp_) {
-            if (!SendPacketLocked(timestamp_)) {
+        if (pending_count_ > 0u) {
+            if (HoldLocked()) {
+                state_ = InterruptState::IDLE;
+            } else if (!SendPacketLocked()) {
                 // We cannot queue another packet here.
                 // If we reach here it means that the
                 // interrupt packet has not been processed,
@@ -206,6 +281,58 @@ zx_status_t InterruptDispatcher::Ack() {
     return ZX_OK;
 }
 
+zx_status_t InterruptDispatcher::SetCoalescing(const zx_interrupt_coalesce_t& coalesce) {
+    // Without a time threshold a partly filled window would never close.
+    if (coalesce.reserved != 0u || coalesce.max_delay < 0 ||
+        (coalesce.max_count > 1u && coalesce.max_delay == 0)) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    AutoReschedDisable resched_disable;
+    resched_disable.Disable();
+    Guard<SpinLock, IrqSave> guard{&spinlock_};
+    if (state_ == InterruptState::DESTROYED) {
+        return ZX_ERR_CANCELED;
+    }
+    coalesce_max_count_ = coalesce.max_count;
+    coalesce_max_delay_ = coalesce.max_delay;
+
+    // Restart an open window under the new settings.
+    if (coalesce_timer_armed_) {
+        timer_cancel(&coalesce_timer_);
+        coalesce_timer_armed_ = false;
+    }
+    if (pending_count_ > 0u) {
+        coalesce_deadline_ = zx_time_add_duration(current_time(), coalesce_max_delay_);
+        if (state_ == InterruptState::IDLE && port_dispatcher_ && !HoldLocked()) {
+            SendPacketLocked();
+            state_ = InterruptState::NEEDACK;
+        }
+    }
+    return ZX_OK;
+}
+
+zx_interrupt_coalesce_t InterruptDispatcher::GetCoalescing() {
+    Guard<SpinLock, IrqSave> guard{&spinlock_};
+    zx_interrupt_coalesce_t coalesce = {};
+    coalesce.max_count = coalesce_max_count_;
+    coalesce.max_delay = coalesce_max_delay_;
+    return coalesce;
+}
+
+void InterruptDispatcher::GetInfo(zx_info_interrupt_t* info) {
+    *info = {};
+    cpu_num_t cpu = GetAffinity();
+    info->cpu_affinity = (cpu == INVALID_CPU) ? ZX_INFO_INVALID_CPU : cpu;
+    if (flags_ & INTERRUPT_VIRTUAL) {
+        info->flags |= ZX_INFO_INTERRUPT_FLAG_VIRTUAL;
+    }
+    if (flags_ & INTERRUPT_MASK_POSTWAIT) {
+        info->flags |= ZX_INFO_INTERRUPT_FLAG_LEVEL;
+    }
+    info->coalesce = GetCoalescing();
+}
+
 void InterruptDispatcher::on_zero_handles() {
     Destroy();
 }
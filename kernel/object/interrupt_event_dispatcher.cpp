@@ -107,6 +107,14 @@ void InterruptEventDispatcher::IrqHandler(void* ctx) {
     thiz->InterruptHandler();
 }
 
+zx_status_t InterruptEventDispatcher::SetAffinity(cpu_num_t cpu) {
+    zx_status_t status = set_interrupt_affinity(vector_, cpu);
+    if (status == ZX_OK) {
+        affinity_.store(cpu);
+    }
+    return status;
+}
+
 void InterruptEventDispatcher::MaskInterrupt() {
     mask_interrupt(vector_);
 }
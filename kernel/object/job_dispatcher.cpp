@@ -13,6 +13,7 @@
 #include <zircon/rights.h>
 #include <zircon/syscalls/policy.h>
 
+#include <fbl/algorithm.h>
 #include <fbl/alloc_checker.h>
 #include <fbl/array.h>
 #include <fbl/auto_lock.h>
@@ -567,3 +568,20 @@ bool JobDispatcher::get_kill_on_oom() const {
     Guard<fbl::Mutex> guard{get_lock()};
     return kill_on_oom_;
 }
+
+zx_time_t JobDispatcher::ChargeUsage(zx_duration_t runtime, uint64_t context_switches,
+                                     uint64_t page_faults) {
+    zx_time_t now = 0;
+    zx_time_t resume = 0;
+    // Every job holds a reference to its parent, so the chain stays alive
+    // for as long as the charging process does.
+    for (JobDispatcher* job = this; job != nullptr; job = job->parent_.get()) {
+        job->counters_.Charge(runtime, context_switches, page_faults);
+        if (runtime && job->cpu_bandwidth_.limited()) {
+            if (now == 0)
+                now = current_time();
+            resume = fbl::max(resume, job->cpu_bandwidth_.Charge(runtime, now));
+        }
+    }
+    return resume;
+}
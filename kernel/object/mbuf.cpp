@@ -10,6 +10,10 @@
 
 #include <fbl/algorithm.h>
 #include <fbl/alloc_checker.h>
+#include <object/user_pages.h>
+#include <vm/page.h>
+#include <vm/physmap.h>
+#include <vm/pmm.h>
 
 #define LOCAL_TRACE 0
 
@@ -18,15 +22,29 @@ constexpr size_t MBufChain::MBuf::kMallocSize;
 constexpr size_t MBufChain::MBuf::kPayloadSize;
 constexpr size_t MBufChain::kSizeMax;
 
+char* MBufChain::MBuf::data() {
+    if (page_ != nullptr)
+        return static_cast<char*>(paddr_to_physmap(page_->paddr()));
+    return static_cast<SmallMBuf*>(this)->data_;
+}
+
+size_t MBufChain::MBuf::capacity() const {
+    return (page_ != nullptr) ? PAGE_SIZE : kPayloadSize;
+}
+
 size_t MBufChain::MBuf::rem() const {
-    return kPayloadSize - (off_ + len_);
+    return capacity() - (off_ + len_);
+}
+
+bool MBufChain::MBuf::is_full_page() const {
+    return page_ != nullptr && off_ == 0u && len_ == PAGE_SIZE;
 }
 
 MBufChain::~MBufChain() {
     while (!tail_.is_empty())
-        delete tail_.pop_front();
+        DestroyMBuf(tail_.pop_front());
     while (!freelist_.is_empty())
-        delete freelist_.pop_front();
+        DestroyMBuf(freelist_.pop_front());
 }
 
 bool MBufChain::is_full() const {
@@ -46,9 +64,20 @@ size_t MBufChain::Read(user_out_ptr<void> dst, size_t len, bool datagram) {
         len = tail_.front().pkt_len_;
 
     size_t pos = 0;
+    bool move_pages = !datagram;
     while (pos < len && !tail_.is_empty()) {
+        if (move_pages && len - pos >= PAGE_SIZE && tail_.front().is_full_page() &&
+            IS_PAGE_ALIGNED(reinterpret_cast<vaddr_t>(dst.byte_offset(pos).get()))) {
+            size_t moved = MovePagesOut(dst.byte_offset(pos), len - pos);
+            if (moved > 0) {
+                pos += moved;
+                continue;
+            }
+            // Don't look the buffer up again for every page.
+            move_pages = false;
+        }
         MBuf& cur = tail_.front();
-        char* src = cur.data_ + cur.off_;
+        char* src = cur.data() + cur.off_;
         size_t copy_len = MIN(cur.len_, len - pos);
         if (dst.byte_offset(pos).copy_array_to_user(src, copy_len) != ZX_OK)
             return pos;
@@ -100,7 +129,7 @@ zx_status_t MBufChain::WriteDatagram(user_in_ptr<const void> src, size_t len,
     size_t pos = 0;
     for (auto& buf : bufs) {
         size_t copy_len = fbl::min(MBuf::kPayloadSize, len - pos);
-        if (src.byte_offset(pos).copy_array_from_user(buf.data_, copy_len) != ZX_OK) {
+        if (src.byte_offset(pos).copy_array_from_user(buf.data(), copy_len) != ZX_OK) {
             while (!bufs.is_empty())
                 FreeMBuf(bufs.pop_front());
             return ZX_ERR_INVALID_ARGS; // Bad user buffer.
@@ -127,30 +156,33 @@ zx_status_t MBufChain::WriteDatagram(user_in_ptr<const void> src, size_t len,
     return ZX_OK;
 }
 
-zx_status_t MBufChain::WriteStream(user_in_ptr<const void> src, size_t len, size_t* written) {
-    if (head_ == nullptr) {
-        head_ = AllocMBuf();
-        if (head_ == nullptr)
-            return ZX_ERR_SHOULD_WAIT;
-        tail_.push_front(head_);
-    }
-
+zx_status_t MBufChain::WriteStream(user_in_ptr<const void> src, size_t len, bool move_pages,
+                                   size_t* written) {
     size_t pos = 0;
-    while (pos < len) {
-        if (head_->rem() == 0) {
-            auto next = AllocMBuf();
-            if (next == nullptr)
-                break;
-            tail_.insert_after(tail_.make_iterator(*head_), next);
-            head_ = next;
+    while (pos < len && size_ < kSizeMax) {
+        const size_t avail = fbl::min(len - pos, kSizeMax - size_);
+        if (move_pages && avail >= PAGE_SIZE &&
+            IS_PAGE_ALIGNED(reinterpret_cast<vaddr_t>(src.byte_offset(pos).get()))) {
+            size_t moved = MovePagesIn(src.byte_offset(pos), ROUNDDOWN(avail, PAGE_SIZE));
+            if (moved > 0) {
+                pos += moved;
+                continue;
+            }
+            // The rest of the source is copied.
+            move_pages = false;
         }
-        void* dst = head_->data_ + head_->off_ + head_->len_;
-        size_t copy_len = fbl::min(head_->rem(), len - pos);
-        if (size_ + copy_len > kSizeMax) {
-            copy_len = kSizeMax - size_;
-            if (copy_len == 0)
+        if (head_ == nullptr || head_->rem() == 0) {
+            // Whole pages of data get a page of their own rather than being spread over
+            // several small mbufs.
+            MBuf* next = (avail >= PAGE_SIZE) ? AllocPageMBuf() : nullptr;
+            if (next == nullptr)
+                next = AllocMBuf();
+            if (next == nullptr)
                 break;
+            AppendMBuf(next);
         }
+        void* dst = head_->data() + head_->off_ + head_->len_;
+        size_t copy_len = fbl::min(head_->rem(), avail);
         if (src.byte_offset(pos).copy_array_from_user(dst, copy_len) != ZX_OK)
             break;
         pos += copy_len;
@@ -165,17 +197,118 @@ zx_status_t MBufChain::WriteStream(user_in_ptr<const void> src, size_t len, size
     return ZX_OK;
 }
 
+void MBufChain::AppendMBuf(MBuf* buf) {
+    if (head_ == nullptr) {
+        tail_.push_front(buf);
+    } else {
+        tail_.insert_after(tail_.make_iterator(*head_), buf);
+    }
+    head_ = buf;
+}
+
+size_t MBufChain::MovePagesIn(user_in_ptr<const void> src, size_t len) {
+    // Allocate all the headers first so that there is nothing left to fail once the pages have
+    // been taken from the writer.
+    fbl::SinglyLinkedList<MBuf*> bufs;
+    size_t count = 0;
+    for (; count < len / PAGE_SIZE; ++count) {
+        fbl::AllocChecker ac;
+        MBuf* buf = new (&ac) MBuf();
+        if (!ac.check())
+            break;
+        bufs.push_front(buf);
+    }
+
+    list_node pages = LIST_INITIAL_VALUE(pages);
+    if (count == 0 ||
+        TakeUserPages(reinterpret_cast<vaddr_t>(src.get()), count * PAGE_SIZE, &pages) != ZX_OK) {
+        while (!bufs.is_empty())
+            delete bufs.pop_front();
+        return 0;
+    }
+
+    while (!bufs.is_empty()) {
+        MBuf* buf = bufs.pop_front();
+        buf->page_ = list_remove_head_type(&pages, vm_page_t, queue_node);
+        buf->len_ = PAGE_SIZE;
+        AppendMBuf(buf);
+    }
+    DEBUG_ASSERT(list_is_empty(&pages));
+
+    size_ += count * PAGE_SIZE;
+    return count * PAGE_SIZE;
+}
+
+size_t MBufChain::MovePagesOut(user_out_ptr<void> dst, size_t len) {
+    list_node pages = LIST_INITIAL_VALUE(pages);
+    size_t count = 0;
+    for (auto& buf : tail_) {
+        if (count == len / PAGE_SIZE || !buf.is_full_page())
+            break;
+        list_add_tail(&pages, &buf.page_->queue_node);
+        ++count;
+    }
+
+    if (count == 0 ||
+        SupplyUserPages(reinterpret_cast<vaddr_t>(dst.get()), count * PAGE_SIZE, &pages) != ZX_OK) {
+        // The mbufs still point at their pages.
+        while (list_remove_head(&pages) != nullptr)
+            ;
+        return 0;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        MBuf* buf = tail_.pop_front();
+        if (head_ == buf)
+            head_ = nullptr;
+        // The page belongs to the reader's vmo now.
+        delete buf;
+    }
+
+    size_ -= count * PAGE_SIZE;
+    return count * PAGE_SIZE;
+}
+
 MBufChain::MBuf* MBufChain::AllocMBuf() {
     if (freelist_.is_empty()) {
         fbl::AllocChecker ac;
-        MBuf* buf = new (&ac) MBuf();
+        MBuf* buf = new (&ac) SmallMBuf();
         return (!ac.check()) ? nullptr : buf;
     }
     return freelist_.pop_front();
 }
 
+MBufChain::MBuf* MBufChain::AllocPageMBuf() {
+    fbl::AllocChecker ac;
+    MBuf* buf = new (&ac) MBuf();
+    if (!ac.check())
+        return nullptr;
+    vm_page_t* page;
+    if (pmm_alloc_page(0, &page) != ZX_OK) {
+        delete buf;
+        return nullptr;
+    }
+    page->state = VM_PAGE_STATE_IPC;
+    buf->page_ = page;
+    return buf;
+}
+
 void MBufChain::FreeMBuf(MBuf* buf) {
+    if (buf->page_ != nullptr) {
+        DestroyMBuf(buf);
+        return;
+    }
     buf->off_ = 0u;
     buf->len_ = 0u;
     freelist_.push_front(buf);
 }
+
+// static
+void MBufChain::DestroyMBuf(MBuf* buf) {
+    if (buf->page_ != nullptr) {
+        pmm_free_page(buf->page_);
+        delete buf;
+    } else {
+        delete static_cast<SmallMBuf*>(buf);
+    }
+}
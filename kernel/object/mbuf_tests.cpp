@@ -43,7 +43,7 @@ static bool stream_read_zero() {
 
     MBufChain chain;
     size_t written = 7;
-    ASSERT_EQ(ZX_OK, chain.WriteStream(mem_in, 1, &written), "");
+    ASSERT_EQ(ZX_OK, chain.WriteStream(mem_in, 1, false, &written), "");
     ASSERT_EQ(1U, written, "");
 
     EXPECT_EQ(0U, chain.Read(mem_out, 0, false), "");
@@ -67,7 +67,7 @@ static bool stream_write_basic() {
         char buf[kWriteLen] = {0};
         memset(buf, 'A' + i, kWriteLen);
         ASSERT_EQ(ZX_OK, mem_out.copy_array_to_user(buf, kWriteLen), "");
-        ASSERT_EQ(ZX_OK, chain.WriteStream(mem_in, kWriteLen, &written), "");
+        ASSERT_EQ(ZX_OK, chain.WriteStream(mem_in, kWriteLen, false, &written), "");
         ASSERT_EQ(kWriteLen, written, "");
         EXPECT_FALSE(chain.is_empty(), "");
         EXPECT_FALSE(chain.is_full(), "");
@@ -109,7 +109,7 @@ static bool stream_write_zero() {
     size_t written = 7;
     MBufChain chain;
     // TODO(maniscalco): Is ZX_ERR_SHOULD_WAIT really the right error here in this case?
-    EXPECT_EQ(ZX_ERR_SHOULD_WAIT, chain.WriteStream(mem_in, 0, &written), "");
+    EXPECT_EQ(ZX_ERR_SHOULD_WAIT, chain.WriteStream(mem_in, 0, false, &written), "");
     EXPECT_EQ(7U, written, "");
     EXPECT_TRUE(chain.is_empty(), "");
     EXPECT_FALSE(chain.is_full(), "");
@@ -129,7 +129,7 @@ static bool stream_write_too_much() {
     size_t total_written = 0;
 
     // Fill the chain until it refuses to take any more.
-    while (!chain.is_full() && chain.WriteStream(mem_in, kWriteLen, &written) == ZX_OK) {
+    while (!chain.is_full() && chain.WriteStream(mem_in, kWriteLen, false, &written) == ZX_OK) {
         total_written += written;
     }
     ASSERT_FALSE(chain.is_empty(), "");
@@ -148,6 +148,49 @@ static bool stream_write_too_much() {
     END_TEST;
 }
 
+// Tests that page sized stream writes, moved or copied into pages, read back intact.
+static bool stream_write_pages() {
+    BEGIN_TEST;
+    constexpr size_t kPrefixLen = 10;
+    constexpr size_t kPagesLen = 2 * PAGE_SIZE;
+    constexpr size_t kTotalLen = kPrefixLen + kPagesLen;
+
+    fbl::AllocChecker ac;
+    auto expected_buf = fbl::unique_ptr<char[]>(new (&ac) char[kTotalLen]);
+    ASSERT_TRUE(ac.check(), "");
+    for (size_t i = 0; i < kTotalLen; ++i) {
+        expected_buf[i] = static_cast<char>(i * 7);
+    }
+
+    fbl::unique_ptr<UserMemory> prefix = UserMemory::Create(kPrefixLen);
+    fbl::unique_ptr<UserMemory> pages = UserMemory::Create(kPagesLen);
+    ASSERT_EQ(ZX_OK, make_user_out_ptr(prefix->out()).copy_array_to_user(expected_buf.get(),
+                                                                         kPrefixLen), "");
+    ASSERT_EQ(ZX_OK, make_user_out_ptr(pages->out()).copy_array_to_user(
+                         expected_buf.get() + kPrefixLen, kPagesLen), "");
+
+    MBufChain chain;
+    size_t written = 0;
+    ASSERT_EQ(ZX_OK, chain.WriteStream(make_user_in_ptr(prefix->in()), kPrefixLen, true,
+                                       &written), "");
+    ASSERT_EQ(kPrefixLen, written, "");
+    ASSERT_EQ(ZX_OK, chain.WriteStream(make_user_in_ptr(pages->in()), kPagesLen, true,
+                                       &written), "");
+    ASSERT_EQ(kPagesLen, written, "");
+    EXPECT_EQ(kTotalLen, chain.size(), "");
+
+    fbl::unique_ptr<UserMemory> read_buf = UserMemory::Create(kTotalLen);
+    ASSERT_EQ(kTotalLen, chain.Read(make_user_out_ptr(read_buf->out()), kTotalLen, false), "");
+    EXPECT_TRUE(chain.is_empty(), "");
+
+    auto actual_buf = fbl::unique_ptr<char[]>(new (&ac) char[kTotalLen]);
+    ASSERT_TRUE(ac.check(), "");
+    ASSERT_EQ(ZX_OK, make_user_in_ptr(read_buf->in()).copy_array_from_user(actual_buf.get(),
+                                                                          kTotalLen), "");
+    EXPECT_EQ(0, memcmp(expected_buf.get(), actual_buf.get(), kTotalLen), "");
+    END_TEST;
+}
+
 // Tests reading a datagram when chain is empty.
 static bool datagram_read_empty() {
     BEGIN_TEST;
@@ -344,6 +387,7 @@ UNITTEST("stream_read_zero", stream_read_zero)
 UNITTEST("stream_write_basic", stream_write_basic)
 UNITTEST("stream_write_zero", stream_write_zero)
 UNITTEST("stream_write_too_much", stream_write_too_much)
+UNITTEST("stream_write_pages", stream_write_pages)
 UNITTEST("datagram_read_empty", datagram_read_empty)
 UNITTEST("datagram_read_zero", datagram_read_zero)
 UNITTEST("datagram_read_buffer_too_small", datagram_read_buffer_too_small)
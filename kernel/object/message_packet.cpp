@@ -8,8 +8,11 @@
 
 #include <err.h>
 #include <fbl/algorithm.h>
+#include <object/user_pages.h>
 #include <stdint.h>
 #include <string.h>
+#include <vm/physmap.h>
+#include <vm/pmm.h>
 #include <zxcpp/new.h>
 
 // MessagePackets have special allocation requirements because they can contain a variable number of
@@ -21,6 +24,9 @@
 //
 // The first buffer in a MessagePacket's BufferChain contains the MessagePacket object, followed by
 // its handles (if any), and finally its payload data (if any).
+//
+// A MessagePacket made by CreateFromPages() instead keeps its payload in whole pages moved out of
+// the writer's vmo, and only the MessagePacket and its handles live in the BufferChain.
 
 // The MessagePacket object, its handles and zx_txid_t must all fit in the first buffer.
 static constexpr size_t kContiguousBytes =
@@ -44,6 +50,7 @@ static inline uint32_t PayloadOffset(uint32_t num_handles) {
 //
 // static
 inline zx_status_t MessagePacket::CreateCommon(uint32_t data_size, uint32_t num_handles,
+                                               bool buffered,
                                                fbl::unique_ptr<MessagePacket>* msg) {
     if (unlikely(data_size > kMaxMessageSize || num_handles > kMaxMessageHandles)) {
         return ZX_ERR_OUT_OF_RANGE;
@@ -53,7 +60,7 @@ inline zx_status_t MessagePacket::CreateCommon(uint32_t data_size, uint32_t num_
 
     // MessagePackets lives *inside* a list of buffers.  The first buffer holds the MessagePacket
     // object, followed by its handles (if any), and finally the payload data.
-    BufferChain* chain = BufferChain::Alloc(payload_offset + data_size);
+    BufferChain* chain = BufferChain::Alloc(payload_offset + (buffered ? data_size : 0u));
     if (unlikely(!chain)) {
         return ZX_ERR_NO_MEMORY;
     }
@@ -76,7 +83,7 @@ inline zx_status_t MessagePacket::CreateCommon(uint32_t data_size, uint32_t num_
 zx_status_t MessagePacket::Create(user_in_ptr<const void> data, uint32_t data_size,
                                   uint32_t num_handles, fbl::unique_ptr<MessagePacket>* msg) {
     fbl::unique_ptr<MessagePacket> new_msg;
-    zx_status_t status = CreateCommon(data_size, num_handles, &new_msg);
+    zx_status_t status = CreateCommon(data_size, num_handles, true, &new_msg);
     if (unlikely(status != ZX_OK)) {
         return status;
     }
@@ -92,7 +99,7 @@ zx_status_t MessagePacket::Create(user_in_ptr<const void> data, uint32_t data_si
 zx_status_t MessagePacket::Create(const void* data, uint32_t data_size, uint32_t num_handles,
                                   fbl::unique_ptr<MessagePacket>* msg) {
     fbl::unique_ptr<MessagePacket> new_msg;
-    zx_status_t status = CreateCommon(data_size, num_handles, &new_msg);
+    zx_status_t status = CreateCommon(data_size, num_handles, true, &new_msg);
     if (unlikely(status != ZX_OK)) {
         return status;
     }
@@ -104,10 +111,68 @@ zx_status_t MessagePacket::Create(const void* data, uint32_t data_size, uint32_t
     return ZX_OK;
 }
 
+// static
+zx_status_t MessagePacket::CreateFromPages(user_in_ptr<const void> data, uint32_t data_size,
+                                           uint32_t num_handles,
+                                           fbl::unique_ptr<MessagePacket>* msg) {
+    const vaddr_t va = reinterpret_cast<vaddr_t>(data.get());
+    if (data_size == 0u || !IS_PAGE_ALIGNED(va) || !IS_PAGE_ALIGNED(data_size)) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
+    fbl::unique_ptr<MessagePacket> new_msg;
+    zx_status_t status = CreateCommon(data_size, num_handles, false, &new_msg);
+    if (unlikely(status != ZX_OK)) {
+        return status;
+    }
+    status = TakeUserPages(va, data_size, &new_msg->pages_);
+    if (status != ZX_OK) {
+        return status;
+    }
+    *msg = fbl::move(new_msg);
+    return ZX_OK;
+}
+
+zx_status_t MessagePacket::MoveDataTo(user_out_ptr<void> buf) {
+    const vaddr_t va = reinterpret_cast<vaddr_t>(buf.get());
+    if (list_is_empty(&pages_) || SupplyUserPages(va, data_size_, &pages_) != ZX_OK) {
+        return CopyDataTo(buf);
+    }
+    DEBUG_ASSERT(list_is_empty(&pages_));
+    return ZX_OK;
+}
+
+char* MessagePacket::PayloadStart() const {
+    if (unlikely(!list_is_empty(&pages_))) {
+        vm_page_t* page = list_peek_head_type(const_cast<list_node*>(&pages_), vm_page_t,
+                                              queue_node);
+        return static_cast<char*>(paddr_to_physmap(page->paddr()));
+    }
+    return buffer_chain_->buffers()->front().data() + payload_offset_;
+}
+
+zx_status_t MessagePacket::CopyPagesTo(user_out_ptr<void> buf) const {
+    vm_page_t* page;
+    list_for_every_entry (const_cast<list_node*>(&pages_), page, vm_page_t, queue_node) {
+        const void* src = paddr_to_physmap(page->paddr());
+        zx_status_t status = buf.copy_array_to_user(src, PAGE_SIZE);
+        if (unlikely(status != ZX_OK)) {
+            return status;
+        }
+        buf = buf.byte_offset(PAGE_SIZE);
+    }
+    return ZX_OK;
+}
+
 void MessagePacket::fbl_recycle() {
     // This function invokes the destructor so be careful about taking any references to |this|.
     BufferChain* chain = buffer_chain_;
+    list_node pages = LIST_INITIAL_VALUE(pages);
+    list_move(&pages_, &pages);
     this->~MessagePacket();
     // |this| has been destroyed.
     BufferChain::Free(chain);
+    if (!list_is_empty(&pages)) {
+        pmm_free(&pages);
+    }
 }
@@ -68,6 +68,14 @@ zx_status_t PciInterruptDispatcher::Create(
     return ZX_OK;
 }
 
+zx_status_t PciInterruptDispatcher::SetAffinity(cpu_num_t cpu) {
+    return device_->SetIrqAffinity(vector_, cpu);
+}
+
+cpu_num_t PciInterruptDispatcher::GetAffinity() const {
+    return device_->GetIrqAffinity(vector_);
+}
+
 void PciInterruptDispatcher::MaskInterrupt() {
     if (maskable_)
         device_->MaskIrq(vector_);
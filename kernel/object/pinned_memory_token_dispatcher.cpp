@@ -40,11 +40,18 @@ zx_status_t PinnedMemoryTokenDispatcher::Create(fbl::RefPtr<BusTransactionInitia
 
     auto pmo = fbl::AdoptRef(new (&ac) PinnedMemoryTokenDispatcher(fbl::move(bti),
                                                                    fbl::move(pinned_vmo),
+                                                                   perms,
                                                                    fbl::move(addr_array)));
     if (!ac.check()) {
         return ZX_ERR_NO_MEMORY;
     }
 
+    // Nothing is mapped yet.  This also lets cleanup after a partial failure
+    // below tell which entries were mapped.
+    [&]() TA_NO_THREAD_SAFETY_ANALYSIS {
+        pmo->InvalidateMappedAddrsLocked();
+    }();
+
     zx_status_t status = pmo->MapIntoIommu(perms);
     if (status != ZX_OK) {
         LTRACEF("MapIntoIommu failed: %d\n", status);
@@ -62,6 +69,37 @@ zx_status_t PinnedMemoryTokenDispatcher::Create(fbl::RefPtr<BusTransactionInitia
     return ZX_OK;
 }
 
+zx_status_t PinnedMemoryTokenDispatcher::CreateFromCache(
+        fbl::RefPtr<BusTransactionInitiatorDispatcher> bti, PinnedVmObject* pinned_vmo,
+        uint32_t perms, fbl::Array<dev_vaddr_t>* mapped_addrs,
+        fbl::RefPtr<Dispatcher>* dispatcher, zx_rights_t* rights) {
+    LTRACE_ENTRY;
+    DEBUG_ASSERT(mapped_addrs->size() ==
+                 ROUNDUP(pinned_vmo->size(), bti->minimum_contiguity()) /
+                 bti->minimum_contiguity());
+
+    // The constructor takes its arguments by reference, so nothing is moved
+    // out of them if the allocation fails.
+    fbl::AllocChecker ac;
+    auto pmo = fbl::AdoptRef(new (&ac) PinnedMemoryTokenDispatcher(fbl::move(bti),
+                                                                   fbl::move(*pinned_vmo),
+                                                                   perms,
+                                                                   fbl::move(*mapped_addrs)));
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    // Create must be called with the BTI's lock held, so this is safe to
+    // invoke.
+    [&]() TA_NO_THREAD_SAFETY_ANALYSIS {
+        pmo->bti_->AddPmoLocked(pmo.get());
+    }();
+
+    *dispatcher = fbl::move(pmo);
+    *rights = default_rights();
+    return ZX_OK;
+}
+
 // Used during initialization to set up the IOMMU state for this PMT.
 //
 // We disable thread-safety analysis here, because this is part of the
@@ -128,28 +166,39 @@ zx_status_t PinnedMemoryTokenDispatcher::MapIntoIommu(uint32_t perms) TA_NO_THRE
 }
 
 zx_status_t PinnedMemoryTokenDispatcher::UnmapFromIommuLocked() {
-    auto iommu = bti_->iommu();
-    const uint64_t bus_txn_id = bti_->bti_id();
+    zx_status_t status = UnmapFromIommu(*bti_, pinned_vmo_, mapped_addrs_);
 
-    if (mapped_addrs_[0] == UINT64_MAX) {
+    // Clear this so we won't try again if this gets called again in the
+    // destructor.
+    InvalidateMappedAddrsLocked();
+    return status;
+}
+
+zx_status_t PinnedMemoryTokenDispatcher::UnmapFromIommu(
+        const BusTransactionInitiatorDispatcher& bti, const PinnedVmObject& pinned_vmo,
+        const fbl::Array<dev_vaddr_t>& mapped_addrs) {
+    auto iommu = bti.iommu();
+    const uint64_t bus_txn_id = bti.bti_id();
+
+    if (mapped_addrs[0] == UINT64_MAX) {
         // No work to do, nothing is mapped.
         return ZX_OK;
     }
 
     zx_status_t status = ZX_OK;
-    if (pinned_vmo_.vmo()->is_contiguous()) {
-        status = iommu->Unmap(bus_txn_id, mapped_addrs_[0], pinned_vmo_.size());
+    if (pinned_vmo.vmo()->is_contiguous()) {
+        status = iommu->Unmap(bus_txn_id, mapped_addrs[0], pinned_vmo.size());
     } else {
-        const size_t min_contig = bti_->minimum_contiguity();
-        size_t remaining = pinned_vmo_.size();
-        for (size_t i = 0; i < mapped_addrs_.size(); ++i) {
-            dev_vaddr_t addr = mapped_addrs_[i];
+        const size_t min_contig = bti.minimum_contiguity();
+        size_t remaining = pinned_vmo.size();
+        for (size_t i = 0; i < mapped_addrs.size(); ++i) {
+            dev_vaddr_t addr = mapped_addrs[i];
             if (addr == UINT64_MAX) {
                 break;
             }
 
             size_t size = fbl::min(remaining, min_contig);
-            DEBUG_ASSERT(size == min_contig || i == mapped_addrs_.size() - 1);
+            DEBUG_ASSERT(size == min_contig || i == mapped_addrs.size() - 1);
             // Try to unmap all pages even if we get an error, and return the
             // first error encountered.
             zx_status_t err = iommu->Unmap(bus_txn_id, addr, size);
@@ -160,10 +209,6 @@ zx_status_t PinnedMemoryTokenDispatcher::UnmapFromIommuLocked() {
             remaining -= size;
         }
     }
-
-    // Clear this so we won't try again if this gets called again in the
-    // destructor.
-    InvalidateMappedAddrsLocked();
     return status;
 }
 
@@ -181,17 +226,31 @@ void PinnedMemoryTokenDispatcher::InvalidateMappedAddrsLocked() {
 }
 
 void PinnedMemoryTokenDispatcher::on_zero_handles() {
-    Guard<fbl::Mutex> guard{get_lock()};
-
-    // Once usermode has dropped the handle, either through zx_handle_close(),
-    // zx_pmt_unpin(), or process crash, prevent access to the pinned memory.
-    //
-    // We do not unpin the VMO until this object is destroyed, to allow usermode
-    // to protect against stray DMA via the quarantining mechanism.
-    zx_status_t status = UnmapFromIommuLocked();
-    ASSERT(status == ZX_OK);
+    // The BTI's lock is ordered before ours, so ask it about the pin cache
+    // before taking our lock.  If the quota changes in the meantime, the
+    // destructor asks again before handing the mappings to the cache.
+    const bool pin_cache_enabled = bti_->pin_cache_enabled();
+
+    bool explicitly_unpinned;
+    {
+        Guard<fbl::Mutex> guard{get_lock()};
+        explicitly_unpinned = explicitly_unpinned_;
+
+        // Once usermode has dropped the handle, either through zx_handle_close(),
+        // zx_pmt_unpin(), or process crash, prevent access to the pinned memory.
+        //
+        // We do not unpin the VMO until this object is destroyed, to allow usermode
+        // to protect against stray DMA via the quarantining mechanism.
+        //
+        // The exception is an explicit unpin on a BTI with a pin cache, where the
+        // destructor may hand the pin and its mappings to the cache instead.
+        if (!explicitly_unpinned || !pin_cache_enabled) {
+            zx_status_t status = UnmapFromIommuLocked();
+            ASSERT(status == ZX_OK);
+        }
+    }
 
-    if (explicitly_unpinned_) {
+    if (explicitly_unpinned) {
         // The cleanup will happen when the reference that on_zero_handles()
         // was called on goes away.
     } else {
@@ -206,8 +265,15 @@ PinnedMemoryTokenDispatcher::~PinnedMemoryTokenDispatcher() {
     // it is possible for that to never run if an error occurs between the
     // creation of the PinnedMemoryTokenDispatcher and the completion of the
     // zx_bti_pin() syscall.
-    zx_status_t status = UnmapFromIommuLocked();
-    ASSERT(status == ZX_OK);
+    //
+    // If the range was explicitly unpinned and is still mapped, the BTI's pin
+    // cache may keep it for a later pin of the same range instead.
+    bool cached = explicitly_unpinned_ && mapped_addrs_[0] != UINT64_MAX &&
+                  bti_->CachePin(&pinned_vmo_, perms_, &mapped_addrs_);
+    if (!cached) {
+        zx_status_t status = UnmapFromIommuLocked();
+        ASSERT(status == ZX_OK);
+    }
 
     // RemovePmo is the only method that will remove dll_pmt_ from a list, and
     // it's only called here.  dll_pmt_ is only added to a list at the end of
@@ -220,12 +286,12 @@ PinnedMemoryTokenDispatcher::~PinnedMemoryTokenDispatcher() {
 
 PinnedMemoryTokenDispatcher::PinnedMemoryTokenDispatcher(
     fbl::RefPtr<BusTransactionInitiatorDispatcher> bti,
-    PinnedVmObject pinned_vmo,
-    fbl::Array<dev_vaddr_t> mapped_addrs)
+    PinnedVmObject&& pinned_vmo,
+    uint32_t perms,
+    fbl::Array<dev_vaddr_t>&& mapped_addrs)
     : pinned_vmo_(fbl::move(pinned_vmo)),
-      bti_(fbl::move(bti)), mapped_addrs_(fbl::move(mapped_addrs)) {
+      bti_(fbl::move(bti)), perms_(perms), mapped_addrs_(fbl::move(mapped_addrs)) {
     DEBUG_ASSERT(pinned_vmo_.vmo() != nullptr);
-    InvalidateMappedAddrsLocked();
 }
 
 zx_status_t PinnedMemoryTokenDispatcher::EncodeAddrs(bool compress_results,
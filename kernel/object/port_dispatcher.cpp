@@ -18,6 +18,7 @@
 #include <object/excp_port.h>
 #include <object/handle.h>
 #include <object/thread_dispatcher.h>
+#include <object/vmo_async_op.h>
 #include <zircon/compiler.h>
 #include <zircon/rights.h>
 #include <zircon/syscalls/port.h>
@@ -100,6 +101,12 @@ PortObserver::PortObserver(uint32_t type, const Handle* handle, fbl::RefPtr<Port
     packet.key = key;
     packet.type = type_;
     packet.signal.trigger = trigger_;
+
+    // A one-shot observer is removed as soon as any trigger signal is seen,
+    // so while it is still observing, changes to other signals cannot fire
+    // it. Repeating observers queue on every change while triggered.
+    if (type_ == ZX_PKT_TYPE_SIGNAL_ONE)
+        set_interest(trigger_);
 }
 
 StateObserver::Flags PortObserver::OnInitialize(zx_signals_t initial_state,
@@ -189,12 +196,16 @@ PortDispatcher::PortDispatcher(uint32_t options)
 
 PortDispatcher::~PortDispatcher() {
     DEBUG_ASSERT(zero_handles_);
-    DEBUG_ASSERT(num_packets_ == 0u);
+    DEBUG_ASSERT(num_packets_.load() == 0u);
 }
 
 void PortDispatcher::on_zero_handles() {
     canary_.Assert();
 
+    // Async VMO ops which would complete here are of no use any more. Those
+    // still queued complete right away, and their packets are freed below.
+    VmoAsyncOp::CancelPort(this);
+
     Guard<fbl::Mutex> guard{get_lock()};
     zero_handles_ = true;
 
@@ -210,7 +221,7 @@ void PortDispatcher::on_zero_handles() {
     // Free any queued packets.
     while (!packets_.is_empty()) {
         FreePacket(packets_.pop_front());
-        --num_packets_;
+        num_packets_.fetch_sub(1, fbl::memory_order_relaxed);
     }
 }
 
@@ -239,12 +250,15 @@ bool PortDispatcher::RemoveInterruptPacket(PortInterruptPacket* port_packet) {
     return false;
 }
 
-bool PortDispatcher::QueueInterruptPacket(PortInterruptPacket* port_packet, zx_time_t timestamp) {
+bool PortDispatcher::QueueInterruptPacket(PortInterruptPacket* port_packet, zx_time_t timestamp,
+                                          zx_time_t last_timestamp, uint32_t count) {
     Guard<SpinLock, IrqSave> guard{&spinlock_};
     if (port_packet->InContainer()) {
         return false;
     } else {
         port_packet->timestamp = timestamp;
+        port_packet->last_timestamp = last_timestamp;
+        port_packet->count = count;
         interrupt_packets_.push_back(port_packet);
         sema_.Post();
         return true;
@@ -259,7 +273,7 @@ zx_status_t PortDispatcher::Queue(PortPacket* port_packet, zx_signals_t observed
     if (zero_handles_)
         return ZX_ERR_BAD_STATE;
 
-    if (num_packets_ > kMaxPendingPacketCountPerPort) {
+    if (num_packets_.load(fbl::memory_order_relaxed) > kMaxPendingPacketCountPerPort) {
         kcounter_add(port_full_count, 1);
         return ZX_ERR_SHOULD_WAIT;
     }
@@ -274,7 +288,7 @@ zx_status_t PortDispatcher::Queue(PortPacket* port_packet, zx_signals_t observed
         port_packet->packet.signal.count = count;
     }
     packets_.push_back(port_packet);
-    ++num_packets_;
+    num_packets_.fetch_add(1, fbl::memory_order_release);
     // This Disable() call must come before Post() to be useful, but doing
     // it earlier would also be OK.
     resched_disable.Disable();
@@ -284,31 +298,50 @@ zx_status_t PortDispatcher::Queue(PortPacket* port_packet, zx_signals_t observed
 }
 
 zx_status_t PortDispatcher::Dequeue(zx_time_t deadline, zx_port_packet_t* out_packet) {
+    size_t actual;
+    return DequeueMany(deadline, out_packet, 1u, &actual);
+}
+
+zx_status_t PortDispatcher::DequeueMany(zx_time_t deadline, zx_port_packet_t* out_packets,
+                                        size_t count, size_t* actual) {
     canary_.Assert();
+    DEBUG_ASSERT(count > 0u);
 
     while (true) {
+        size_t n = 0u;
         if (options_ == ZX_PORT_BIND_TO_INTERRUPT) {
             Guard<SpinLock, IrqSave> guard{&spinlock_};
-            PortInterruptPacket* port_interrupt_packet = interrupt_packets_.pop_front();
-            if (port_interrupt_packet != nullptr) {
+            while (n < count) {
+                PortInterruptPacket* port_interrupt_packet = interrupt_packets_.pop_front();
+                if (port_interrupt_packet == nullptr)
+                    break;
+                zx_port_packet_t* out_packet = &out_packets[n++];
                 *out_packet = {};
                 out_packet->key = port_interrupt_packet->key;
                 out_packet->type = ZX_PKT_TYPE_INTERRUPT;
                 out_packet->status = ZX_OK;
                 out_packet->interrupt.timestamp = port_interrupt_packet->timestamp;
-                return ZX_OK;
+                out_packet->interrupt.last_timestamp = port_interrupt_packet->last_timestamp;
+                out_packet->interrupt.count = port_interrupt_packet->count;
             }
         }
-        {
+        // Waiters woken by a Post() whose packet was already taken by a
+        // batch would otherwise all bounce the lock just to find nothing.
+        if (n < count && num_packets_.load(fbl::memory_order_acquire) != 0u) {
             Guard<fbl::Mutex> guard{get_lock()};
-            PortPacket* port_packet = packets_.pop_front();
-            if (port_packet != nullptr) {
-                --num_packets_;
-                *out_packet = port_packet->packet;
+            while (n < count) {
+                PortPacket* port_packet = packets_.pop_front();
+                if (port_packet == nullptr)
+                    break;
+                num_packets_.fetch_sub(1, fbl::memory_order_relaxed);
+                out_packets[n++] = port_packet->packet;
                 FreePacket(port_packet);
-                return ZX_OK;
             }
         }
+        if (n != 0u) {
+            *actual = n;
+            return ZX_OK;
+        }
 
         {
             ThreadDispatcher::AutoBlocked by(ThreadDispatcher::Blocked::PORT);
@@ -411,7 +444,7 @@ bool PortDispatcher::CancelQueued(const void* handle, uint64_t key) {
             // Destroyed as we go around the loop.
             fbl::unique_ptr<const PortObserver> observer =
                 fbl::move(packets_.erase(to_remove)->observer);
-            --num_packets_;
+            num_packets_.fetch_sub(1, fbl::memory_order_relaxed);
             packet_removed = true;
         } else {
             ++it;
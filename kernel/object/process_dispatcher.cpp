@@ -65,6 +65,12 @@ zx_status_t ProcessDispatcher::Create(
     if (!ac.check())
         return ZX_ERR_NO_MEMORY;
 
+    if (SyscallStats::enabled()) {
+        process->syscall_stats_ = SyscallStats::Create();
+        if (!process->syscall_stats_)
+            return ZX_ERR_NO_MEMORY;
+    }
+
     if (!job->AddChildProcess(process))
         return ZX_ERR_BAD_STATE;
 
@@ -101,8 +107,7 @@ ProcessDispatcher::ProcessDispatcher(fbl::RefPtr<JobDispatcher> job,
 
     // Generate handle XOR mask with top bit and bottom two bits cleared
     uint32_t secret;
-    auto prng = crypto::GlobalPRNG::GetInstance();
-    prng->Draw(&secret, sizeof(secret));
+    crypto::GlobalPRNG::Draw(&secret, sizeof(secret));
 
     // Handle values cannot be negative values, so we mask the high bit.
     handle_rand_ = (secret << 2) & INT_MAX;
@@ -231,6 +236,12 @@ void ProcessDispatcher::Kill() {
         FinishDeadTransition();
 }
 
+zx_time_t ProcessDispatcher::ChargeUsage(zx_duration_t runtime, uint64_t context_switches,
+                                         uint64_t page_faults) {
+    counters_.Charge(runtime, context_switches, page_faults);
+    return job_->ChargeUsage(runtime, context_switches, page_faults);
+}
+
 void ProcessDispatcher::KillAllThreadsLocked() {
     LTRACE_ENTRY_OBJ;
 
@@ -354,10 +365,7 @@ void ProcessDispatcher::FinishDeadTransition() {
     // our exception ports then ResetExceptionPort will get called (by
     // ExceptionPort::OnPortZeroHandles) and will need to grab |get_lock()|.
     // This needs to be done outside of |get_lock()|.
-    while (!to_clean.is_empty()) {
-        // Delete handle via HandleOwner dtor.
-        HandleOwner ho(to_clean.pop_front());
-    }
+    Handle::DeleteList(&to_clean);
 
     LTRACEF_LEVEL(2, "done cleaning up handle table on proc %p\n", this);
 
@@ -15,13 +15,35 @@
 
 #include <zircon/rights.h>
 
+static_assert(ZX_PROFILE_FAIR_WEIGHT_MIN == THREAD_FAIR_WEIGHT_MIN, "");
+static_assert(ZX_PROFILE_FAIR_WEIGHT_DEFAULT == THREAD_FAIR_WEIGHT_DEFAULT, "");
+static_assert(ZX_PROFILE_FAIR_WEIGHT_MAX == THREAD_FAIR_WEIGHT_MAX, "");
+static_assert(ZX_PROFILE_PERF_HINT_NONE == THREAD_PERF_HINT_NONE, "");
+static_assert(ZX_PROFILE_PERF_HINT_LATENCY == THREAD_PERF_HINT_LATENCY, "");
+static_assert(ZX_PROFILE_PERF_HINT_EFFICIENCY == THREAD_PERF_HINT_EFFICIENCY, "");
+
 zx_status_t validate_profile(const zx_profile_info_t& info) {
-    if (info.type != ZX_PROFILE_INFO_SCHEDULER)
+    switch (info.type) {
+    case ZX_PROFILE_INFO_SCHEDULER:
+        if ((info.scheduler.priority < LOWEST_PRIORITY) ||
+            (info.scheduler.priority  > HIGHEST_PRIORITY))
+            return ZX_ERR_INVALID_ARGS;
+        return ZX_OK;
+    case ZX_PROFILE_INFO_FAIR:
+        if ((info.fair.priority < LOWEST_PRIORITY) ||
+            (info.fair.priority > HIGHEST_PRIORITY))
+            return ZX_ERR_INVALID_ARGS;
+        if ((info.fair.weight < ZX_PROFILE_FAIR_WEIGHT_MIN) ||
+            (info.fair.weight > ZX_PROFILE_FAIR_WEIGHT_MAX))
+            return ZX_ERR_INVALID_ARGS;
+        if (info.fair.deadline_us > ZX_PROFILE_FAIR_DEADLINE_MAX_US)
+            return ZX_ERR_INVALID_ARGS;
+        if (info.fair.perf_hint > ZX_PROFILE_PERF_HINT_EFFICIENCY)
+            return ZX_ERR_INVALID_ARGS;
+        return ZX_OK;
+    default:
         return ZX_ERR_NOT_SUPPORTED;
-    if ((info.scheduler.priority < LOWEST_PRIORITY) ||
-        (info.scheduler.priority  > HIGHEST_PRIORITY))
-        return ZX_ERR_INVALID_ARGS;
-    return ZX_OK;
+    }
 }
 
 zx_status_t ProfileDispatcher::Create(const zx_profile_info_t& info,
@@ -48,6 +70,13 @@ ProfileDispatcher::~ProfileDispatcher() {
 }
 
 zx_status_t ProfileDispatcher::ApplyProfile(fbl::RefPtr<ThreadDispatcher> thread) {
-    // At the moment, the only thing we support is the priority.
-    return thread->SetPriority(info_.scheduler.priority);
+    switch (info_.type) {
+    case ZX_PROFILE_INFO_FAIR:
+        return thread->SetFairParams(info_.fair.priority, info_.fair.weight,
+                                     ZX_USEC(info_.fair.deadline_us),
+                                     info_.fair.perf_hint);
+    default:
+        // For the priority scheduler, the only thing we support is the priority.
+        return thread->SetPriority(info_.scheduler.priority);
+    }
 }
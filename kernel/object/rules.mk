@@ -44,12 +44,15 @@ MODULE_SRCS := \
     $(LOCAL_DIR)/semaphore.cpp \
     $(LOCAL_DIR)/socket_dispatcher.cpp \
     $(LOCAL_DIR)/suspend_token_dispatcher.cpp \
+    $(LOCAL_DIR)/syscall_stats.cpp \
     $(LOCAL_DIR)/thread_dispatcher.cpp \
     $(LOCAL_DIR)/timer_dispatcher.cpp \
+    $(LOCAL_DIR)/user_pages.cpp \
     $(LOCAL_DIR)/vcpu_dispatcher.cpp \
     $(LOCAL_DIR)/virtual_interrupt_dispatcher.cpp \
     $(LOCAL_DIR)/vm_address_region_dispatcher.cpp \
     $(LOCAL_DIR)/vm_object_dispatcher.cpp \
+    $(LOCAL_DIR)/vmo_async_op.cpp \
     $(LOCAL_DIR)/wait_state_observer.cpp \
 
 # Tests
@@ -182,7 +182,7 @@ zx_status_t SocketDispatcher::ShutdownOtherLocked(uint32_t how) {
     return ZX_OK;
 }
 
-zx_status_t SocketDispatcher::Write(user_in_ptr<const void> src, size_t len,
+zx_status_t SocketDispatcher::Write(user_in_ptr<const void> src, size_t len, bool move_pages,
                                     size_t* nwritten) TA_NO_THREAD_SAFETY_ANALYSIS {
     canary_.Assert();
 
@@ -203,7 +203,7 @@ zx_status_t SocketDispatcher::Write(user_in_ptr<const void> src, size_t len,
     if (len != static_cast<size_t>(static_cast<uint32_t>(len)))
         return ZX_ERR_INVALID_ARGS;
 
-    return peer_->WriteSelfLocked(src, len, nwritten);
+    return peer_->WriteSelfLocked(src, len, move_pages, nwritten);
 }
 
 zx_status_t SocketDispatcher::WriteControl(user_in_ptr<const void> src, size_t len)
@@ -246,6 +246,7 @@ zx_status_t SocketDispatcher::WriteControlSelfLocked(user_in_ptr<const void> src
 }
 
 zx_status_t SocketDispatcher::WriteSelfLocked(user_in_ptr<const void> src, size_t len,
+                                              bool move_pages,
                                               size_t* written) TA_NO_THREAD_SAFETY_ANALYSIS {
     canary_.Assert();
 
@@ -259,15 +260,148 @@ zx_status_t SocketDispatcher::WriteSelfLocked(user_in_ptr<const void> src, size_
     if (flags_ & ZX_SOCKET_DATAGRAM) {
         status = data_.WriteDatagram(src, len, &st);
     } else {
-        status = data_.WriteStream(src, len, &st);
+        status = data_.WriteStream(src, len, move_pages, &st);
     }
     if (status)
         return status;
 
+    OnWriteLocked(was_empty, st);
+    *written = st;
+    return status;
+}
+
+zx_status_t SocketDispatcher::WriteVector(const zx_iovec_t* vectors, size_t count,
+                                          size_t* nwritten) TA_NO_THREAD_SAFETY_ANALYSIS {
+    canary_.Assert();
+
+    LTRACE_ENTRY;
+
+    // A datagram has to be gathered up before it can be written atomically, which the caller can
+    // do as well as we can.
+    if (flags_ & ZX_SOCKET_DATAGRAM)
+        return ZX_ERR_NOT_SUPPORTED;
+
+    size_t len = 0u;
+    for (size_t i = 0; i < count; ++i) {
+        if (add_overflow(len, vectors[i].capacity, &len))
+            return ZX_ERR_INVALID_ARGS;
+    }
+
+    Guard<fbl::Mutex> guard{get_lock()};
+
+    if (!peer_)
+        return ZX_ERR_PEER_CLOSED;
+    zx_signals_t signals = GetSignalsStateLocked();
+    if (signals & ZX_SOCKET_WRITE_DISABLED)
+        return ZX_ERR_BAD_STATE;
+
+    if (len == 0) {
+        *nwritten = 0;
+        return ZX_OK;
+    }
+    if (len != static_cast<size_t>(static_cast<uint32_t>(len)))
+        return ZX_ERR_INVALID_ARGS;
+
+    return peer_->WriteVectorSelfLocked(vectors, count, nwritten);
+}
+
+zx_status_t SocketDispatcher::WriteVectorSelfLocked(const zx_iovec_t* vectors, size_t count,
+                                                    size_t* written) TA_NO_THREAD_SAFETY_ANALYSIS {
+    canary_.Assert();
+
+    if (is_full())
+        return ZX_ERR_SHOULD_WAIT;
+
+    bool was_empty = is_empty();
+
+    size_t total = 0u;
+    for (size_t i = 0; i < count; ++i) {
+        if (vectors[i].capacity == 0)
+            continue;
+        size_t st = 0u;
+        auto src = make_user_in_ptr(static_cast<const void*>(vectors[i].buffer));
+        if (data_.WriteStream(src, vectors[i].capacity, false, &st) != ZX_OK)
+            break;
+        total += st;
+        if (st != vectors[i].capacity)
+            break;
+    }
+    if (total == 0)
+        return ZX_ERR_SHOULD_WAIT;
+
+    OnWriteLocked(was_empty, total);
+    *written = total;
+    return ZX_OK;
+}
+
+zx_status_t SocketDispatcher::WriteDatagramVector(const zx_iovec_t* vectors, size_t count,
+                                                  size_t* nwritten) TA_NO_THREAD_SAFETY_ANALYSIS {
+    canary_.Assert();
+
+    LTRACE_ENTRY;
+
+    if (!(flags_ & ZX_SOCKET_DATAGRAM))
+        return ZX_ERR_NOT_SUPPORTED;
+
+    for (size_t i = 0; i < count; ++i) {
+        if (vectors[i].capacity == 0)
+            return ZX_ERR_INVALID_ARGS;
+        if (vectors[i].capacity != static_cast<size_t>(static_cast<uint32_t>(vectors[i].capacity)))
+            return ZX_ERR_INVALID_ARGS;
+    }
+
+    Guard<fbl::Mutex> guard{get_lock()};
+
+    if (!peer_)
+        return ZX_ERR_PEER_CLOSED;
+    zx_signals_t signals = GetSignalsStateLocked();
+    if (signals & ZX_SOCKET_WRITE_DISABLED)
+        return ZX_ERR_BAD_STATE;
+
+    if (count == 0) {
+        *nwritten = 0;
+        return ZX_OK;
+    }
+
+    return peer_->WriteDatagramVectorSelfLocked(vectors, count, nwritten);
+}
+
+zx_status_t SocketDispatcher::WriteDatagramVectorSelfLocked(const zx_iovec_t* vectors,
+                                                            size_t count, size_t* written)
+    TA_NO_THREAD_SAFETY_ANALYSIS {
+    canary_.Assert();
+
+    if (is_full())
+        return ZX_ERR_SHOULD_WAIT;
+
+    bool was_empty = is_empty();
+
+    size_t datagrams = 0u;
+    size_t total = 0u;
+    zx_status_t status = ZX_OK;
+    for (; datagrams < count; ++datagrams) {
+        size_t st = 0u;
+        auto src = make_user_in_ptr(static_cast<const void*>(vectors[datagrams].buffer));
+        status = data_.WriteDatagram(src, vectors[datagrams].capacity, &st);
+        if (status != ZX_OK)
+            break;
+        total += st;
+    }
+    // Report a bad buffer or an oversized datagram only if nothing made it out ahead of it; the
+    // caller learns about it when it retries from the first unwritten vector.
+    if (datagrams == 0)
+        return status;
+
+    OnWriteLocked(was_empty, total);
+    *written = datagrams;
+    return ZX_OK;
+}
+
+void SocketDispatcher::OnWriteLocked(bool was_empty, size_t written) TA_NO_THREAD_SAFETY_ANALYSIS {
     zx_signals_t clear = 0u;
     zx_signals_t set = 0u;
 
-    if (st > 0) {
+    if (written > 0) {
         if (was_empty)
             set |= ZX_SOCKET_READABLE;
         // Assert signal if we go above the read threshold
@@ -290,9 +424,6 @@ zx_status_t SocketDispatcher::WriteSelfLocked(user_in_ptr<const void> src, size_
 
     if (clear)
         peer_->UpdateStateLocked(clear, 0u);
-
-    *written = st;
-    return status;
 }
 
 zx_status_t SocketDispatcher::Read(user_out_ptr<void> dst, size_t len,
@@ -312,6 +443,108 @@ zx_status_t SocketDispatcher::Read(user_out_ptr<void> dst, size_t len,
     if (len != (size_t)((uint32_t)len))
         return ZX_ERR_INVALID_ARGS;
 
+    zx_status_t status = CheckReadableLocked();
+    if (status != ZX_OK)
+        return status;
+
+    bool was_full = is_full();
+
+    auto st = data_.Read(dst, len, flags_ & ZX_SOCKET_DATAGRAM);
+
+    OnReadLocked(was_full, st);
+    *nread = static_cast<size_t>(st);
+    return ZX_OK;
+}
+
+zx_status_t SocketDispatcher::ReadVector(const zx_iovec_t* vectors, size_t count,
+                                         size_t* nread) TA_NO_THREAD_SAFETY_ANALYSIS {
+    canary_.Assert();
+
+    LTRACE_ENTRY;
+
+    // See WriteVector().
+    if (flags_ & ZX_SOCKET_DATAGRAM)
+        return ZX_ERR_NOT_SUPPORTED;
+
+    size_t len = 0u;
+    for (size_t i = 0; i < count; ++i) {
+        if (add_overflow(len, vectors[i].capacity, &len))
+            return ZX_ERR_INVALID_ARGS;
+    }
+    if (len != (size_t)((uint32_t)len))
+        return ZX_ERR_INVALID_ARGS;
+
+    Guard<fbl::Mutex> guard{get_lock()};
+
+    zx_status_t status = CheckReadableLocked();
+    if (status != ZX_OK)
+        return status;
+
+    bool was_full = is_full();
+
+    size_t total = 0u;
+    for (size_t i = 0; i < count && !is_empty(); ++i) {
+        auto dst = make_user_out_ptr(vectors[i].buffer);
+        size_t st = data_.Read(dst, vectors[i].capacity, false);
+        total += st;
+        if (st != vectors[i].capacity)
+            break;
+    }
+
+    OnReadLocked(was_full, total);
+    *nread = total;
+    return ZX_OK;
+}
+
+zx_status_t SocketDispatcher::ReadDatagramVector(const zx_iovec_t* vectors, size_t count,
+                                                 size_t* nread) TA_NO_THREAD_SAFETY_ANALYSIS {
+    canary_.Assert();
+
+    LTRACE_ENTRY;
+
+    if (!(flags_ & ZX_SOCKET_DATAGRAM))
+        return ZX_ERR_NOT_SUPPORTED;
+
+    for (size_t i = 0; i < count; ++i) {
+        // Leave room for at least one byte of payload so that every datagram read is consumed.
+        if (vectors[i].capacity <= sizeof(zx_socket_datagram_header_t))
+            return ZX_ERR_INVALID_ARGS;
+        if (vectors[i].capacity != static_cast<size_t>(static_cast<uint32_t>(vectors[i].capacity)))
+            return ZX_ERR_INVALID_ARGS;
+    }
+
+    Guard<fbl::Mutex> guard{get_lock()};
+
+    zx_status_t status = CheckReadableLocked();
+    if (status != ZX_OK)
+        return status;
+
+    if (count == 0) {
+        *nread = 0;
+        return ZX_OK;
+    }
+
+    bool was_full = is_full();
+
+    size_t datagrams = 0u;
+    size_t total = 0u;
+    for (; datagrams < count && !is_empty(); ++datagrams) {
+        auto dst = make_user_out_ptr(vectors[datagrams].buffer);
+        zx_socket_datagram_header_t header = {static_cast<uint32_t>(data_.size(true)), 0u};
+        if (dst.copy_array_to_user(&header, sizeof(header)) != ZX_OK)
+            break;
+        total += data_.Read(dst.byte_offset(sizeof(header)),
+                            vectors[datagrams].capacity - sizeof(header), true);
+    }
+    if (datagrams == 0)
+        return ZX_ERR_INVALID_ARGS; // Bad user buffer.
+
+    OnReadLocked(was_full, total);
+    *nread = datagrams;
+    return ZX_OK;
+}
+
+zx_status_t SocketDispatcher::CheckReadableLocked() const TA_NO_THREAD_SAFETY_ANALYSIS {
     if (is_empty()) {
         if (!peer_)
             return ZX_ERR_PEER_CLOSED;
@@ -321,11 +554,10 @@ zx_status_t SocketDispatcher::Read(user_out_ptr<void> dst, size_t len,
             return ZX_ERR_BAD_STATE;
         return ZX_ERR_SHOULD_WAIT;
     }
+    return ZX_OK;
+}
 
-    bool was_full = is_full();
-
-    auto st = data_.Read(dst, len, flags_ & ZX_SOCKET_DATAGRAM);
-
+void SocketDispatcher::OnReadLocked(bool was_full, size_t nread) TA_NO_THREAD_SAFETY_ANALYSIS {
     zx_signals_t clear = 0u;
     zx_signals_t set = 0u;
 
@@ -347,14 +579,11 @@ zx_status_t SocketDispatcher::Read(user_out_ptr<void> dst, size_t len,
         if (peer_write_threshold > 0 &&
             ((data_.max_size() - data_.size()) >= peer_write_threshold))
             set |= ZX_SOCKET_WRITE_THRESHOLD;
-        if (was_full && (st > 0))
+        if (was_full && (nread > 0))
             set |= ZX_SOCKET_WRITABLE;
         if (set)
             peer_->UpdateStateLocked(0u, set);
     }
-
-    *nread = static_cast<size_t>(st);
-    return ZX_OK;
 }
 
 zx_status_t SocketDispatcher::ReadControl(user_out_ptr<void> dst, size_t len,
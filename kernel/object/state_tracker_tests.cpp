@@ -22,6 +22,11 @@ public:
         UpdateState(0, 1);
     }
 
+    // Helper: Changes the state to |signals|.
+    void SetState(zx_signals_t signals) {
+        UpdateState(~0u, signals);
+    }
+
     // Helper: Causes most On*() hooks (except for OnInitialized) to
     // be called on all of |st|'s observers.
     void CallAllOnHooks() {
@@ -180,6 +185,67 @@ bool on_cancel_by_key() {
 
 } // namespace removal
 
+// Tests for observer interest masks
+namespace interest {
+
+class CountingObserver : public StateObserver {
+public:
+    explicit CountingObserver(zx_signals_t interest) { set_interest(interest); }
+
+    // The number of times OnStateChange() has been called.
+    int state_changes() const { return state_changes_; }
+
+private:
+    Flags OnInitialize(zx_signals_t initial_state,
+                       const StateObserver::CountInfo* cinfo) override {
+        return 0;
+    }
+    Flags OnStateChange(zx_signals_t new_state) override {
+        state_changes_++;
+        return 0;
+    }
+    Flags OnCancel(const Handle* handle) override { return 0; }
+
+    int state_changes_ = 0;
+};
+
+bool skips_uninteresting_changes() {
+    BEGIN_TEST;
+
+    CountingObserver narrow(2u);
+    CountingObserver wide(~0u);
+
+    TestDispatcher st;
+    st.AddObserver(&narrow, nullptr);
+    st.AddObserver(&wide, nullptr);
+
+    // Neither setting nor clearing other signals reaches |narrow|.
+    st.SetState(1u);
+    st.SetState(0u);
+    EXPECT_EQ(0, narrow.state_changes(), "");
+    EXPECT_EQ(2, wide.state_changes(), "");
+
+    // Setting and clearing its own signal does.
+    st.SetState(3u);
+    st.SetState(1u);
+    EXPECT_EQ(2, narrow.state_changes(), "");
+    EXPECT_EQ(4, wide.state_changes(), "");
+
+    st.RemoveObserver(&wide);
+
+    // With only |narrow| left, other signals still do not reach it.
+    st.SetState(5u);
+    EXPECT_EQ(2, narrow.state_changes(), "");
+    st.SetState(2u);
+    EXPECT_EQ(3, narrow.state_changes(), "");
+
+    st.RemoveObserver(&narrow);
+
+    END_TEST;
+}
+
+} // namespace interest
+
 #define ST_UNITTEST(fname) UNITTEST(#fname, fname)
 
 UNITTEST_START_TESTCASE(state_tracker_tests)
@@ -188,6 +254,7 @@ ST_UNITTEST(removal::on_initialize)
 ST_UNITTEST(removal::on_state_change_via_update_state)
 ST_UNITTEST(removal::on_cancel)
 ST_UNITTEST(removal::on_cancel_by_key)
+ST_UNITTEST(interest::skips_uninteresting_changes)
 
 UNITTEST_END_TESTCASE(
     state_tracker_tests, "statetracker", "StateTracker test");
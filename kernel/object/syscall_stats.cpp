@@ -0,0 +1,97 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <object/syscall_stats.h>
+
+#include <arch/ops.h>
+#include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
+#include <kernel/cmdline.h>
+#include <lk/init.h>
+#include <stdio.h>
+
+bool SyscallStats::enabled_ = false;
+SyscallStats* SyscallStats::cpu_stats_ = nullptr;
+
+void SyscallStats::Init() {
+    if (!cmdline_get_bool("kernel.syscall-stats", false))
+        return;
+
+    fbl::AllocChecker ac;
+    cpu_stats_ = new (&ac) SyscallStats[arch_max_num_cpus()];
+    if (!ac.check()) {
+        printf("syscall stats: out of memory, not enabled\n");
+        return;
+    }
+    enabled_ = true;
+}
+
+fbl::unique_ptr<SyscallStats> SyscallStats::Create() {
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<SyscallStats> stats(new (&ac) SyscallStats());
+    if (!ac.check())
+        return nullptr;
+    return stats;
+}
+
+// Bucket 0 counts times below 128ns, bucket i counts times in
+// [2^(6+i), 2^(7+i))ns and the last bucket counts everything above.
+size_t SyscallStats::Bucket(zx_duration_t duration) {
+    if (duration < 128)
+        return 0;
+    size_t log2 = 63 - __builtin_clzll(static_cast<uint64_t>(duration));
+    return fbl::min(log2 - 6, kBuckets - 1);
+}
+
+void SyscallStats::Record(uint64_t syscall_num, zx_duration_t duration,
+                          SyscallStats* process) {
+    if (syscall_num >= ZX_SYS_COUNT)
+        return;
+    const uint32_t num = static_cast<uint32_t>(syscall_num);
+    const size_t bucket = Bucket(duration);
+    cpu_stats_[arch_curr_cpu_num()].AddLocal(num, duration, bucket);
+    if (process)
+        process->AddShared(num, duration, bucket);
+}
+
+void SyscallStats::AddLocal(uint32_t syscall_num, zx_duration_t duration, size_t bucket) {
+    Entry& e = entries_[syscall_num];
+    e.count.store(e.count.load(fbl::memory_order_relaxed) + 1, fbl::memory_order_relaxed);
+    e.total_time.store(e.total_time.load(fbl::memory_order_relaxed) + duration,
+                       fbl::memory_order_relaxed);
+    if (duration > e.max_time.load(fbl::memory_order_relaxed))
+        e.max_time.store(duration, fbl::memory_order_relaxed);
+    e.histogram[bucket].store(e.histogram[bucket].load(fbl::memory_order_relaxed) + 1,
+                              fbl::memory_order_relaxed);
+}
+
+void SyscallStats::AddShared(uint32_t syscall_num, zx_duration_t duration, size_t bucket) {
+    Entry& e = entries_[syscall_num];
+    e.count.fetch_add(1, fbl::memory_order_relaxed);
+    e.total_time.fetch_add(duration, fbl::memory_order_relaxed);
+    zx_duration_t max = e.max_time.load(fbl::memory_order_relaxed);
+    while (duration > max &&
+           !e.max_time.compare_exchange_weak(&max, duration, fbl::memory_order_relaxed,
+                                             fbl::memory_order_relaxed)) {
+    }
+    e.histogram[bucket].fetch_add(1, fbl::memory_order_relaxed);
+}
+
+void SyscallStats::Accumulate(uint32_t syscall_num, zx_info_syscall_stats_t* stats) const {
+    const Entry& e = entries_[syscall_num];
+    stats->count += e.count.load(fbl::memory_order_relaxed);
+    stats->total_time += e.total_time.load(fbl::memory_order_relaxed);
+    stats->max_time = fbl::max(stats->max_time, e.max_time.load(fbl::memory_order_relaxed));
+    for (size_t i = 0; i < kBuckets; i++)
+        stats->histogram[i] += e.histogram[i].load(fbl::memory_order_relaxed);
+}
+
+static void syscall_stats_init_hook(uint) {
+    SyscallStats::Init();
+}
+
+// Before userboot makes the first syscall.
+LK_INIT_HOOK(syscall_stats, syscall_stats_init_hook, LK_INIT_LEVEL_KERNEL);
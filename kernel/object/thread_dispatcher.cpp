@@ -15,7 +15,9 @@
 
 #include <arch/debugger.h>
 #include <arch/exception.h>
+#include <arch/user_copy.h>
 
+#include <kernel/sched.h>
 #include <kernel/thread.h>
 #include <vm/kstack.h>
 #include <vm/vm.h>
@@ -853,6 +855,54 @@ zx_status_t ThreadDispatcher::GetExceptionReport(zx_exception_report_t* report)
     return ZX_OK;
 }
 
+zx_status_t ThreadDispatcher::SetExceptionHandler(const zx_thread_exception_handler_t& handler) {
+    canary_.Assert();
+    DEBUG_ASSERT(this == GetCurrent());
+
+    if (handler.pc == 0) {
+        exception_handler_ = {};
+        return ZX_OK;
+    }
+    if (handler.types == 0 || (handler.types & ~ZX_EXCEPTION_HANDLER_TYPES_ALLOWED) ||
+        handler.reserved != 0)
+        return ZX_ERR_INVALID_ARGS;
+    if (!is_user_address(handler.pc) ||
+        handler.stack_size < sizeof(zx_exception_frame_t) + 16 ||
+        !is_user_address_range(handler.stack_base, handler.stack_size))
+        return ZX_ERR_INVALID_ARGS;
+
+    exception_handler_ = handler;
+    return ZX_OK;
+}
+
+bool ThreadDispatcher::RedirectToExceptionHandler(uint exception_type,
+                                                  arch_exception_context_t* context) {
+    canary_.Assert();
+    DEBUG_ASSERT(this == GetCurrent());
+
+    const zx_thread_exception_handler_t& handler = exception_handler_;
+    if (!(handler.types & ZX_EXCEPTION_HANDLER_TYPE(exception_type)) ||
+        !ZX_EXCP_IS_ARCH(exception_type))
+        return false;
+
+    // An exception on the handler's stack was raised by the handler itself,
+    // which would likely just raise it again. Leave it to the exception ports.
+    uintptr_t stack_top = handler.stack_base + handler.stack_size;
+    uintptr_t sp = arch_exception_context_user_sp(context);
+    if (sp > handler.stack_base && sp <= stack_top)
+        return false;
+
+    zx_exception_frame_t frame = {};
+    ExceptionPort::BuildArchReport(&frame.report, exception_type, context);
+    if (arch_get_general_regs(&thread_, &frame.regs) != ZX_OK)
+        return false;
+
+    uintptr_t frame_addr = ROUNDDOWN(stack_top - sizeof(frame), 16);
+    if (arch_copy_to_user(reinterpret_cast<void*>(frame_addr), &frame, sizeof(frame)) != ZX_OK)
+        return false;
+    return arch_redirect_exception_context(context, handler.pc, frame_addr) == ZX_OK;
+}
+
 // Note: buffer must be sufficiently aligned
 
 zx_status_t ThreadDispatcher::ReadState(zx_thread_state_topic_t state_kind,
@@ -971,10 +1021,53 @@ zx_status_t ThreadDispatcher::SetPriority(int32_t priority) {
         return ZX_ERR_BAD_STATE;
     }
     // The priority was already validated by the Profile dispatcher.
+    thread_set_fair_params(&thread_, 0, 0);
+    thread_set_perf_hint(&thread_, THREAD_PERF_HINT_NONE);
     thread_set_priority(&thread_, priority);
     return ZX_OK;
 }
 
+zx_status_t ThreadDispatcher::SetFairParams(int32_t priority, uint32_t weight,
+                                            zx_duration_t deadline, uint32_t perf_hint) {
+    Guard<fbl::Mutex> guard{get_lock()};
+    if ((state_.lifecycle() == ThreadState::Lifecycle::INITIAL) ||
+        (state_.lifecycle() == ThreadState::Lifecycle::DYING) ||
+        (state_.lifecycle() == ThreadState::Lifecycle::DEAD)) {
+        return ZX_ERR_BAD_STATE;
+    }
+    // The parameters were already validated by the Profile dispatcher.
+    thread_set_fair_params(&thread_, weight, deadline);
+    thread_set_perf_hint(&thread_, perf_hint);
+    thread_set_priority(&thread_, priority);
+    return ZX_OK;
+}
+
+void ThreadDispatcher::AddPiFutex(FutexNode* head, bool* local_resched) {
+    pi_futexes_.push_back(head);
+    UpdatePiPriority(local_resched);
+}
+
+void ThreadDispatcher::RemovePiFutex(FutexNode* head, bool* local_resched) {
+    pi_futexes_.erase(*head);
+    UpdatePiPriority(local_resched);
+}
+
+void ThreadDispatcher::UpdatePiPriority(bool* local_resched) {
+    int priority = -1;
+    for (const FutexNode& head : pi_futexes_) {
+        if (head.owner_priority() > priority)
+            priority = head.owner_priority();
+    }
+
+    // Drop what the thread inherited before, since waiters may have left,
+    // unless it holds kernel mutexes, which then own the inheritance until
+    // they are released.
+    if (thread_.mutexes_held == 0)
+        sched_inherit_priority(&thread_, -1, local_resched);
+    if (priority >= 0)
+        sched_inherit_priority(&thread_, priority, local_resched);
+}
+
 void get_user_thread_process_name(const void* user_thread,
                                   char out_name[ZX_MAX_NAME_LEN]) {
     const ThreadDispatcher* ut =
@@ -982,6 +1075,12 @@ void get_user_thread_process_name(const void* user_thread,
     ut->process()->get_name(out_name);
 }
 
+zx_time_t user_thread_charge_usage(void* user_thread, zx_duration_t runtime,
+                                   uint64_t context_switches, uint64_t page_faults) {
+    ThreadDispatcher* ut = reinterpret_cast<ThreadDispatcher*>(user_thread);
+    return ut->process()->ChargeUsage(runtime, context_switches, page_faults);
+}
+
 const char* ThreadLifecycleToString(ThreadState::Lifecycle lifecycle) {
     switch (lifecycle) {
     case ThreadState::Lifecycle::INITIAL:
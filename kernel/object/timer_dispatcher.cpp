@@ -20,8 +20,8 @@
 
 static void timer_irq_callback(timer* timer, zx_time_t now, void* arg) {
     // We are in IRQ context and cannot touch the timer state_tracker, so we
-    // schedule a DPC to do so. TODO(cpu): figure out ways to reduce the lag.
-    dpc_queue(reinterpret_cast<dpc_t*>(arg), true);
+    // schedule a DPC to do so, in the high class to keep the lag down.
+    dpc_queue_etc(reinterpret_cast<dpc_t*>(arg), DPC_CLASS_HIGH, true);
 }
 
 static void dpc_callback(dpc_t* d) {
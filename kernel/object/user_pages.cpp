@@ -0,0 +1,82 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <object/user_pages.h>
+
+#include <arch/mmu.h>
+#include <fbl/ref_ptr.h>
+#include <kernel/thread.h>
+#include <vm/vm.h>
+#include <vm/vm_address_region.h>
+#include <vm/vm_aspace.h>
+#include <vm/vm_object.h>
+
+static constexpr uint kMovableMmuFlags =
+    ARCH_MMU_FLAG_PERM_USER | ARCH_MMU_FLAG_PERM_READ | ARCH_MMU_FLAG_PERM_WRITE;
+
+// Finds the vmo range behind the user range [va, va + len) of the current thread's address space,
+// which must lie within a single mapping with all of |mmu_flags|.
+//
+// Like the other users of VmAspace::FindRegion() this is racy with the mapping going away, which
+// is harmless since the caller only operates on the vmo it holds a reference to.
+static zx_status_t LookupUserRange(vaddr_t va, size_t len, uint mmu_flags,
+                                   fbl::RefPtr<VmObject>* vmo, uint64_t* offset) {
+    VmAspace* aspace = vmm_aspace_to_obj(get_current_thread()->aspace);
+    if (!aspace || !aspace->is_user()) {
+        return ZX_ERR_BAD_STATE;
+    }
+    auto region = aspace->FindRegion(va);
+    if (!region) {
+        return ZX_ERR_NOT_FOUND;
+    }
+    auto mapping = region->as_vm_mapping();
+    if (!mapping) {
+        return ZX_ERR_NOT_FOUND;
+    }
+    vaddr_t end;
+    if (add_overflow(va, len, &end) || va < mapping->base() ||
+        end > mapping->base() + mapping->size()) {
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+    if ((mapping->arch_mmu_flags() & mmu_flags) != mmu_flags) {
+        return ZX_ERR_ACCESS_DENIED;
+    }
+    *offset = mapping->object_offset() + (va - mapping->base());
+    *vmo = mapping->vmo();
+    return ZX_OK;
+}
+
+zx_status_t TakeUserPages(vaddr_t va, size_t len, list_node* pages) {
+    if (len == 0u || !IS_PAGE_ALIGNED(va) || !IS_PAGE_ALIGNED(len)) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
+    fbl::RefPtr<VmObject> vmo;
+    uint64_t offset;
+    if (LookupUserRange(va, len, kMovableMmuFlags, &vmo, &offset) != ZX_OK) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+    // Failing part way through at most commits pages of the range, which the caller cannot tell
+    // from the copy that follows.
+    if (vmo->TakePages(offset, len, pages) != ZX_OK) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+    return ZX_OK;
+}
+
+zx_status_t SupplyUserPages(vaddr_t va, size_t len, list_node* pages) {
+    if (len == 0u || !IS_PAGE_ALIGNED(va) || !IS_PAGE_ALIGNED(len)) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
+    fbl::RefPtr<VmObject> vmo;
+    uint64_t offset;
+    if (LookupUserRange(va, len, kMovableMmuFlags, &vmo, &offset) != ZX_OK ||
+        vmo->SupplyPages(offset, len, pages) != ZX_OK) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+    return ZX_OK;
+}
@@ -18,8 +18,12 @@ zx_status_t VcpuDispatcher::Create(fbl::RefPtr<GuestDispatcher> guest_dispatcher
                                    fbl::RefPtr<Dispatcher>* dispatcher, zx_rights_t* rights) {
     Guest* guest = guest_dispatcher->guest();
 
+    zx_status_t status = guest_dispatcher->Prefault();
+    if (status != ZX_OK)
+        return status;
+
     fbl::unique_ptr<Vcpu> vcpu;
-    zx_status_t status = Vcpu::Create(guest, entry, &vcpu);
+    status = Vcpu::Create(guest, entry, &vcpu);
     if (status != ZX_OK)
         return status;
 
@@ -79,6 +79,10 @@ zx_status_t split_syscall_flags(uint32_t flags, uint32_t* vmar_flags, uint* arch
         vmar |= VMAR_FLAG_REQUIRE_NON_RESIZABLE;
         flags &= ~ZX_VM_REQUIRE_NON_RESIZABLE;
     }
+    if (flags & ZX_VM_NO_FAULT_AROUND) {
+        vmar |= VMAR_FLAG_NO_FAULT_AROUND;
+        flags &= ~ZX_VM_NO_FAULT_AROUND;
+    }
 
     if (flags != 0)
         return ZX_ERR_INVALID_ARGS;
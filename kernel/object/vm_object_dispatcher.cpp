@@ -6,6 +6,8 @@
 
 #include <object/vm_object_dispatcher.h>
 
+#include <object/vmo_async_op.h>
+
 #include <vm/vm_aspace.h>
 #include <vm/vm_object.h>
 
@@ -37,6 +39,7 @@ zx_status_t VmObjectDispatcher::Create(fbl::RefPtr<VmObject> vmo,
 VmObjectDispatcher::VmObjectDispatcher(fbl::RefPtr<VmObject> vmo)
     : SoloDispatcher(ZX_VMO_ZERO_CHILDREN), vmo_(vmo) {
         vmo_->SetChildObserver(this);
+        vmo_->AddDispatcher();
     }
 
 VmObjectDispatcher::~VmObjectDispatcher() {
@@ -44,6 +47,13 @@ VmObjectDispatcher::~VmObjectDispatcher() {
     // dying and the koid will no longer map to a Dispatcher. koids are never
     // recycled, and it could be a useful breadcrumb.
     vmo_->SetChildObserver(nullptr);
+    vmo_->RemoveDispatcher();
+}
+
+void VmObjectDispatcher::on_zero_handles() {
+    // The async ops were asked for through the VMO's handles, so stop them
+    // once those are gone. Their packets are still queued, as canceled.
+    VmoAsyncOp::CancelVmo(vmo_.get());
 }
 
 
@@ -184,6 +194,38 @@ zx_status_t VmObjectDispatcher::RangeOp(uint32_t op, uint64_t offset, uint64_t s
     }
 }
 
+zx_status_t VmObjectDispatcher::RangeOpAsync(uint32_t op, uint64_t offset, uint64_t size,
+                                             fbl::RefPtr<PortDispatcher> port, uint64_t key,
+                                             zx_rights_t rights) {
+    canary_.Assert();
+
+    LTRACEF("op %u offset %#" PRIx64 " size %#" PRIx64 " key %#" PRIx64 " rights %#x\n",
+            op, offset, size, key, rights);
+
+    switch (op) {
+        case ZX_VMO_OP_COMMIT_ASYNC:
+            if ((rights & ZX_RIGHT_WRITE) == 0) {
+                return ZX_ERR_ACCESS_DENIED;
+            }
+            break;
+        case ZX_VMO_OP_PREFETCH_ASYNC:
+            if ((rights & ZX_RIGHT_READ) == 0) {
+                return ZX_ERR_ACCESS_DENIED;
+            }
+            break;
+        default:
+            return ZX_ERR_INVALID_ARGS;
+    }
+
+    // Catch ranges that are out of bounds now rather than in the packet.
+    uint64_t end;
+    if (add_overflow(offset, size, &end) || end > vmo_->size()) {
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+
+    return VmoAsyncOp::Submit(vmo_, op, offset, size, fbl::move(port), key);
+}
+
 zx_status_t VmObjectDispatcher::SetMappingCachePolicy(uint32_t cache_policy) {
     return vmo_->SetMappingCachePolicy(cache_policy);
 }
@@ -0,0 +1,229 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <object/vmo_async_op.h>
+
+#include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
+#include <fbl/auto_lock.h>
+#include <fbl/mutex.h>
+#include <inttypes.h>
+#include <kernel/event.h>
+#include <kernel/thread.h>
+#include <lib/counters.h>
+#include <lk/init.h>
+#include <object/process_dispatcher.h>
+#include <stdio.h>
+#include <trace.h>
+#include <zircon/syscalls/port.h>
+
+#define LOCAL_TRACE 0
+
+KCOUNTER(vmo_async_ops, "kernel.vmo.async.ops");
+KCOUNTER(vmo_async_rejected, "kernel.vmo.async.rejected");
+KCOUNTER(vmo_async_canceled, "kernel.vmo.async.canceled");
+
+namespace {
+
+constexpr uint kNumWorkers = 2;
+
+fbl::Mutex pending_lock;
+fbl::DoublyLinkedList<fbl::unique_ptr<VmoAsyncOp>> pending TA_GUARDED(pending_lock);
+size_t pending_count TA_GUARDED(pending_lock) = 0;
+// The requests the workers have taken off |pending|, so Cancel() can find them.
+fbl::DoublyLinkedList<fbl::unique_ptr<VmoAsyncOp>> running TA_GUARDED(pending_lock);
+
+event_t pending_event = EVENT_INITIAL_VALUE(pending_event, false, EVENT_FLAG_AUTOUNSIGNAL);
+
+} // namespace
+
+VmoAsyncOp::VmoAsyncOp(fbl::RefPtr<ProcessDispatcher> process, fbl::RefPtr<VmObject> vmo,
+                       uint32_t op, uint64_t offset, uint64_t size,
+                       fbl::RefPtr<PortDispatcher> port, PortPacket* packet)
+    : process_(fbl::move(process)), vmo_(fbl::move(vmo)), op_(op), offset_(offset), size_(size),
+      port_(fbl::move(port)), packet_(packet) {}
+
+VmoAsyncOp::~VmoAsyncOp() {
+    if (packet_) {
+        packet_->Free();
+    }
+    process_->UnchargeVmoAsyncOp();
+}
+
+// static
+zx_status_t VmoAsyncOp::Submit(fbl::RefPtr<VmObject> vmo, uint32_t op, uint64_t offset,
+                               uint64_t size, fbl::RefPtr<PortDispatcher> port, uint64_t key) {
+    DEBUG_ASSERT(op == ZX_VMO_OP_COMMIT_ASYNC || op == ZX_VMO_OP_PREFETCH_ASYNC);
+
+    // The charge is dropped when the request is destroyed.
+    ProcessDispatcher* up = ProcessDispatcher::GetCurrent();
+    if (!up->ChargeVmoAsyncOp(kMaxPendingPerProcess)) {
+        kcounter_add(vmo_async_rejected, 1);
+        return ZX_ERR_NO_RESOURCES;
+    }
+
+    auto packet = PortDispatcher::DefaultPortAllocator()->Alloc();
+    if (!packet) {
+        up->UnchargeVmoAsyncOp();
+        return ZX_ERR_NO_MEMORY;
+    }
+    packet->packet.key = key;
+    packet->packet.type = ZX_PKT_TYPE_VMO_OP;
+
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<VmoAsyncOp> req(
+        new (&ac) VmoAsyncOp(fbl::WrapRefPtr(up), fbl::move(vmo), op, offset, size,
+                             fbl::move(port), packet));
+    if (!ac.check()) {
+        packet->Free();
+        up->UnchargeVmoAsyncOp();
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    {
+        fbl::AutoLock lock(&pending_lock);
+        if (pending_count >= kMaxPending) {
+            kcounter_add(vmo_async_rejected, 1);
+            return ZX_ERR_NO_RESOURCES;
+        }
+        pending.push_back(fbl::move(req));
+        pending_count++;
+    }
+    kcounter_add(vmo_async_ops, 1);
+    event_signal(&pending_event, true);
+    return ZX_OK;
+}
+
+// static
+void VmoAsyncOp::CancelVmo(const VmObject* vmo) {
+    Cancel(vmo, nullptr);
+}
+
+// static
+void VmoAsyncOp::CancelPort(const PortDispatcher* port) {
+    Cancel(nullptr, port);
+}
+
+// static
+void VmoAsyncOp::Cancel(const VmObject* vmo, const PortDispatcher* port) {
+    auto matches = [vmo, port](const VmoAsyncOp& req) {
+        return (vmo && req.vmo_.get() == vmo) || (port && req.port_.get() == port);
+    };
+
+    fbl::DoublyLinkedList<fbl::unique_ptr<VmoAsyncOp>> canceled;
+    {
+        fbl::AutoLock lock(&pending_lock);
+        for (auto it = pending.begin(); it != pending.end();) {
+            auto cur = it++;
+            if (matches(*cur)) {
+                canceled.push_back(pending.erase(cur));
+                pending_count--;
+            }
+        }
+        for (VmoAsyncOp& req : running) {
+            if (matches(req)) {
+                req.canceled_.store(true, fbl::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Completing takes the port lock, so it is done without |pending_lock|.
+    while (!canceled.is_empty()) {
+        kcounter_add(vmo_async_canceled, 1);
+        canceled.pop_front()->Complete(ZX_ERR_CANCELED);
+    }
+}
+
+void VmoAsyncOp::Run() {
+    LTRACEF("op %u offset %#" PRIx64 " size %#" PRIx64 "\n", op_, offset_, size_);
+
+    // Chunks end on large page boundaries so that the commits can still be
+    // backed by large pages.
+    zx_status_t status = ZX_OK;
+    uint64_t offset = offset_;
+    uint64_t remaining = size_;
+    while (remaining > 0) {
+        if (canceled_.load(fbl::memory_order_relaxed)) {
+            kcounter_add(vmo_async_canceled, 1);
+            status = ZX_ERR_CANCELED;
+            break;
+        }
+        const uint64_t chunk =
+            fbl::min(remaining, ROUNDDOWN(offset, LARGE_PAGE_SIZE) + kChunkSize - offset);
+        if (op_ == ZX_VMO_OP_COMMIT_ASYNC) {
+            status = vmo_->CommitRange(offset, chunk, nullptr);
+        } else {
+            status = vmo_->PrefetchRange(offset, chunk);
+        }
+        if (status != ZX_OK)
+            break;
+        offset += chunk;
+        remaining -= chunk;
+    }
+    Complete(status);
+}
+
+void VmoAsyncOp::Complete(zx_status_t status) {
+    packet_->packet.status = status;
+    packet_->packet.vmo_op.op = op_;
+    packet_->packet.vmo_op.reserved0 = 0;
+    packet_->packet.vmo_op.offset = offset_;
+    packet_->packet.vmo_op.size = size_;
+    packet_->packet.vmo_op.reserved1 = 0;
+
+    // The port owns the packet once it is queued. It is freed with the
+    // request if the port has no handles left.
+    if (port_->Queue(packet_, 0, 0) == ZX_OK) {
+        packet_ = nullptr;
+    }
+}
+
+// static
+int VmoAsyncOp::WorkerThread(void* arg) {
+    for (;;) {
+        VmoAsyncOp* req = nullptr;
+        {
+            fbl::AutoLock lock(&pending_lock);
+            auto next = pending.pop_front();
+            if (next) {
+                pending_count--;
+                req = next.get();
+                running.push_back(fbl::move(next));
+            }
+        }
+        if (!req) {
+            event_wait(&pending_event);
+            continue;
+        }
+        req->Run();
+
+        // Destroyed, and its references dropped, without |pending_lock|.
+        fbl::unique_ptr<VmoAsyncOp> done;
+        {
+            fbl::AutoLock lock(&pending_lock);
+            done = running.erase(*req);
+        }
+    }
+    return 0;
+}
+
+// static
+void VmoAsyncOp::StartWorkers() {
+    for (uint i = 0; i < kNumWorkers; i++) {
+        char name[THREAD_NAME_LENGTH];
+        snprintf(name, sizeof(name), "vmo-async-%u", i);
+        thread_t* t = thread_create(name, &VmoAsyncOp::WorkerThread, nullptr, DEFAULT_PRIORITY);
+        if (t) {
+            thread_detach_and_resume(t);
+        }
+    }
+}
+
+static void vmo_async_op_init(uint level) {
+    VmoAsyncOp::StartWorkers();
+}
+
+LK_INIT_HOOK(vmo_async_op, vmo_async_op_init, LK_INIT_LEVEL_THREADING);
@@ -14,6 +14,7 @@
 #include <kernel/thread.h>
 #include <kernel/timer.h>
 #include <lib/cbuf.h>
+#include <lib/counters.h>
 #include <lib/debuglog.h>
 #include <lk/init.h>
 #include <platform.h>
@@ -44,10 +45,19 @@ uint32_t uart_fifo_depth;
 
 // tx driven irq
 static bool uart_tx_irq_enabled = false;
-static event_t uart_dputc_event = EVENT_INITIAL_VALUE(uart_dputc_event, true,
-                                                      EVENT_FLAG_AUTOUNSIGNAL);
 static spin_lock_t uart_spinlock = SPIN_LOCK_INITIAL_VALUE;
 
+// Buffered Tx: while the tx irq is in use, output from thread context is
+// queued here and fed to the fifo by the irq handler, so writers never wait
+// for the uart.  If the buffer fills up the oldest bytes are dropped.
+// |uart_tx_head| and |uart_tx_tail| count bytes ever queued and sent.
+static constexpr size_t kUartTxBufSize = 16384;
+static char uart_tx_buf[kUartTxBufSize];
+static size_t uart_tx_head;
+static size_t uart_tx_tail;
+
+KCOUNTER(uart_tx_dropped_count, "platform.uart.tx_dropped");
+
 static uint8_t uart_read(uint8_t reg) {
     if (uart_mem_addr) {
         return (uint8_t)readl(uart_mem_addr + 4 * reg);
@@ -64,6 +74,23 @@ static void uart_write(uint8_t reg, uint8_t val) {
     }
 }
 
+// Moves up to a fifo's worth of queued bytes to the uart, whose tx fifo
+// must be empty.  Returns true if nothing is left queued.
+static bool uart_tx_fill_fifo() {
+    for (uint32_t i = 0; i < uart_fifo_depth && uart_tx_tail != uart_tx_head; i++) {
+        uart_write(0, uart_tx_buf[uart_tx_tail++ % kUartTxBufSize]);
+    }
+    return uart_tx_tail == uart_tx_head;
+}
+
+static void uart_tx_queue_char(char c) {
+    if (uart_tx_head - uart_tx_tail == kUartTxBufSize) {
+        uart_tx_tail++;
+        kcounter_add(uart_tx_dropped_count, 1);
+    }
+    uart_tx_buf[uart_tx_head++ % kUartTxBufSize] = c;
+}
+
 static void uart_irq_handler(void *arg) {
     spin_lock(&uart_spinlock);
 
@@ -84,10 +111,11 @@ static void uart_irq_handler(void *arg) {
             break;
         }
         case 0b0010:
-            // transmitter is empty, signal any waiting senders
-            event_signal(&uart_dputc_event, true);
-            // disable the tx irq
-            uart_write(1, (1<<0)); // just rx interrupt enable
+            // transmitter is empty, refill it from the tx buffer and
+            // disable the tx irq once there is nothing left to send
+            if (uart_tx_fill_fifo()) {
+                uart_write(1, (1<<0)); // just rx interrupt enable
+            }
             break;
         case 0b0110: // receiver line status
             uart_read(5); // read the LSR
@@ -362,23 +390,20 @@ static char *debug_platform_tx_FIFO_bytes(const char *str, size_t *len,
 
 /*
  * dputs() Tx is either polling driven (if the caller is non-preemptible
- * or earlyboot or panic) or blocking (and irq driven).
- * TODO - buffered Tx support may be a win, (lopri but worth investigating)
- * When we do that dputs() can be completely asynchronous, and return when
- * the write has been (atomically) deposited into the buffer, except when
- * we run out of room in the Tx buffer (rare) - we'd either need to spin
- * (if non-blocking) or block waiting for space in the Tx buffer (adding
- * support to optionally block in cbuf_write_char() would be easiest way
- * to achieve that).
+ * or earlyboot or panic) or buffered (and irq driven).
  *
- * block : Blocking vs Non-Blocking
+ * Buffered writes return as soon as the string has been copied into the tx
+ * buffer.  Polled writes first send anything still buffered so that output
+ * stays in order, which also means a panic flushes whatever was queued
+ * before it.
+ *
+ * block : Buffered vs Polled
  * map_NL : If true, map a '\n' to '\r'+'\n'
  */
 static void platform_dputs(const char* str, size_t len,
                            bool block, bool map_NL) {
     spin_lock_saved_state_t state;
     bool copied_CR = false;
-    size_t wrote;
 
     // drop strings if we haven't initialized the uart yet
     if (unlikely(!output_enabled))
@@ -386,30 +411,37 @@ static void platform_dputs(const char* str, size_t len,
     if (!uart_tx_irq_enabled)
         block = false;
     spin_lock_irqsave(&uart_spinlock, state);
-    while (len > 0) {
+    if (block) {
+        for (size_t i = 0; i < len; i++) {
+            if (str[i] == '\n' && map_NL) {
+                uart_tx_queue_char('\r');
+            }
+            uart_tx_queue_char(str[i]);
+        }
+        // Start sending now if the fifo is idle, and have the tx irq
+        // send the rest.
+        if ((uart_read(5) & (1<<5)) && uart_tx_fill_fifo()) {
+            spin_unlock_irqrestore(&uart_spinlock, state);
+            return;
+        }
+        uart_write(1, (1<<0)|(1<<1)); // rx and tx interrupt enable
+        spin_unlock_irqrestore(&uart_spinlock, state);
+        return;
+    }
+    while (len > 0 || uart_tx_tail != uart_tx_head) {
         // Is FIFO empty ?
         while (!(uart_read(5) & (1<<5))) {
-            if (block) {
-                /*
-                 * We want to Tx more and FIFO is empty, re-enable
-                 * Tx interrupts before blocking.
-                 */
-                uart_write(1, (1<<0)|(1<<1)); // rx and tx interrupt enable
-                spin_unlock_irqrestore(&uart_spinlock, state);
-                event_wait(&uart_dputc_event);
-            } else {
-                spin_unlock_irqrestore(&uart_spinlock, state);
-                arch_spinloop_pause();
-            }
+            spin_unlock_irqrestore(&uart_spinlock, state);
+            arch_spinloop_pause();
             spin_lock_irqsave(&uart_spinlock, state);
         }
         // Fifo is completely empty now, we can shove an entire
-        // fifo's worth of Tx...
-        str = debug_platform_tx_FIFO_bytes(str, &len, &copied_CR,
-                                           &wrote, map_NL);
-        if (block && wrote > 0) {
-            // If blocking/irq driven wakeps, enable rx/tx intrs
-            uart_write(1, (1<<0)|(1<<1)); // rx and tx interrupt enable
+        // fifo's worth of Tx, starting with anything still buffered...
+        if (uart_tx_tail != uart_tx_head) {
+            uart_tx_fill_fifo();
+        } else {
+            str = debug_platform_tx_FIFO_bytes(str, &len, &copied_CR,
+                                               NULL, map_NL);
         }
     }
     spin_unlock_irqrestore(&uart_spinlock, state);
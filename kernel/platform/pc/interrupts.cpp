@@ -10,6 +10,7 @@
 #include <arch/x86.h>
 #include <arch/x86/apic.h>
 #include <arch/x86/interrupts.h>
+#include <arch/x86/mp.h>
 #include <assert.h>
 #include <debug.h>
 #include <dev/interrupt.h>
@@ -152,6 +153,36 @@ zx_status_t configure_interrupt(unsigned int vector,
     return ZX_OK;
 }
 
+// Look up the physical APIC ID which interrupts for |cpu| have to target.
+static zx_status_t cpu_to_apic_dst(cpu_num_t cpu, uint8_t* out_dst) {
+    if (cpu >= arch_max_num_cpus()) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+    uint32_t apic_id = (cpu == 0) ? bp_percpu.apic_id : ap_percpus[cpu - 1].apic_id;
+    // Without interrupt remapping, IO APIC entries and MSI addresses only
+    // have room for an 8 bit destination.
+    if (apic_id > 0xff) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+    *out_dst = static_cast<uint8_t>(apic_id);
+    return ZX_OK;
+}
+
+zx_status_t set_interrupt_affinity(unsigned int vector, cpu_num_t cpu) {
+    if (!is_valid_interrupt(vector, 0)) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+    uint8_t dst;
+    zx_status_t status = cpu_to_apic_dst(cpu, &dst);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    AutoSpinLock guard(&lock);
+    apic_io_configure_irq_dst(vector, dst);
+    return ZX_OK;
+}
+
 zx_status_t get_interrupt_config(unsigned int vector,
                                  enum interrupt_trigger_mode* tm,
                                  enum interrupt_polarity* pol) {
@@ -279,6 +310,14 @@ bool msi_is_supported(void) {
     return true;
 }
 
+static uint32_t msi_target_addr(uint8_t dst) {
+    uint32_t tgt_addr = 0xFEE00000;              // base addr
+    tgt_addr |= ((uint32_t)dst) << 12;           // Dest ID
+    tgt_addr |= 0x08;                            // Redir hint == 1
+    tgt_addr &= ~0x04;                           // Dest Mode == Physical
+    return tgt_addr;
+}
+
 zx_status_t msi_alloc_block(uint requested_irqs,
                                 bool can_target_64bit,
                                 bool is_msix,
@@ -305,15 +344,9 @@ zx_status_t msi_alloc_block(uint requested_irqs,
         // See section 10.11.1 of the Intel 64 and IA-32 Architectures Software
         // Developer's Manual Volume 3A.
         //
-        // TODO(johngro) : don't just bind this block to the Local APIC of the
-        // processor which is active when calling msi_alloc_block.  Instead,
-        // there should either be a system policy (like, always send to any
-        // processor, or just processor 0, or something), or the decision of
-        // which CPUs to bind to should be left to the caller.
-        uint32_t tgt_addr = 0xFEE00000;              // base addr
-        tgt_addr |= ((uint32_t)apic_bsp_id()) << 12; // Dest ID == the BSP APIC ID
-        tgt_addr |= 0x08;                            // Redir hint == 1
-        tgt_addr &= ~0x04;                           // Dest Mode == Physical
+        // The block starts out bound to the BSP. Callers can move it with
+        // msi_set_affinity.
+        uint32_t tgt_addr = msi_target_addr(apic_bsp_id());
 
         // Compute the target data.
         // See section 10.11.2 of the Intel 64 and IA-32 Architectures Software
@@ -345,6 +378,21 @@ void msi_free_block(msi_block_t* block) {
     memset(block, 0, sizeof(*block));
 }
 
+zx_status_t msi_set_affinity(msi_block_t* block, cpu_num_t cpu) {
+    DEBUG_ASSERT(block && block->allocated);
+
+    uint8_t dst;
+    zx_status_t status = cpu_to_apic_dst(cpu, &dst);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    // The data (and so the vector) stays the same, only the destination in
+    // the address changes.
+    block->tgt_addr = msi_target_addr(dst);
+    return ZX_OK;
+}
+
 void msi_register_handler(const msi_block_t* block, uint msi_id, int_handler handler, void* ctx) {
     DEBUG_ASSERT(block && block->allocated);
     DEBUG_ASSERT(msi_id < block->num_irq);
@@ -44,6 +44,10 @@ public:
                             void* ctx) override {
         msi_register_handler(block, msi_id, handler, ctx);
     }
+
+    zx_status_t SetMsiAffinity(msi_block_t* block, cpu_num_t cpu) override {
+        return msi_set_affinity(block, cpu);
+    }
 };
 
 X86PciePlatformSupport platform_pcie_support;
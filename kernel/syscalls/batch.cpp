@@ -0,0 +1,67 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <err.h>
+#include <inttypes.h>
+#include <trace.h>
+
+#include <zircon/types.h>
+
+#include "priv.h"
+
+#define LOCAL_TRACE 0
+
+// Each operation goes through the same sys_* function its own system call
+// would, so it behaves exactly the same; only the kernel entry and exit are
+// shared.
+static zx_status_t batch_run_op(const zx_batch_op_t& op) {
+    switch (op.op) {
+    case ZX_BATCH_OP_HANDLE_CLOSE:
+        return sys_handle_close(op.handle);
+    case ZX_BATCH_OP_OBJECT_SIGNAL:
+        return sys_object_signal(op.handle, op.arg0, op.arg1);
+    case ZX_BATCH_OP_OBJECT_SIGNAL_PEER:
+        return sys_object_signal_peer(op.handle, op.arg0, op.arg1);
+    case ZX_BATCH_OP_CHANNEL_WRITE:
+        return sys_channel_write(
+            op.handle, 0u, make_user_in_ptr(op.ptr0), op.arg0,
+            make_user_in_ptr(static_cast<const zx_handle_t*>(op.ptr1)), op.arg1);
+    case ZX_BATCH_OP_PORT_QUEUE:
+        return sys_port_queue(
+            op.handle, make_user_in_ptr(static_cast<const zx_port_packet_t*>(op.ptr0)));
+    default:
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+}
+
+// zx_status_t zx_batch
+zx_status_t sys_batch(uint32_t options, user_inout_ptr<zx_batch_op_t> user_ops, size_t num_ops) {
+    LTRACEF("ops %p num_ops %zu options 0x%x\n", user_ops.get(), num_ops, options);
+
+    if (options != 0u)
+        return ZX_ERR_INVALID_ARGS;
+
+    if (num_ops == 0u || num_ops > ZX_BATCH_MAX_OPS)
+        return ZX_ERR_OUT_OF_RANGE;
+
+    zx_batch_op_t ops[ZX_BATCH_MAX_OPS];
+    if (user_ops.copy_array_from_user(ops, num_ops) != ZX_OK)
+        return ZX_ERR_INVALID_ARGS;
+
+    // Every operation runs, in order, whether or not the ones before it
+    // succeeded, just as if they were separate calls.
+    zx_status_t result = ZX_OK;
+    for (size_t i = 0; i < num_ops; ++i) {
+        ops[i].status = batch_run_op(ops[i]);
+        if (result == ZX_OK)
+            result = ops[i].status;
+    }
+
+    if (user_ops.copy_array_to_user(ops, num_ops) != ZX_OK)
+        return ZX_ERR_INVALID_ARGS;
+
+    return result;
+}
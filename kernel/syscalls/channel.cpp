@@ -154,7 +154,7 @@ static zx_status_t channel_read(zx_handle_t handle_value, uint32_t options,
         return result;
 
     if (num_bytes > 0u) {
-        if (msg->CopyDataTo(bytes) != ZX_OK)
+        if (msg->MoveDataTo(bytes) != ZX_OK)
             return ZX_ERR_INVALID_ARGS;
     }
 
@@ -191,6 +191,87 @@ zx_status_t sys_channel_read_etc(zx_handle_t handle_value, uint32_t options,
         bytes, handle_info, num_bytes, num_handles, actual_bytes, actual_handles);
 }
 
+// zx_status_t zx_channel_read_many
+zx_status_t sys_channel_read_many(zx_handle_t handle_value, uint32_t options,
+                                  user_inout_ptr<zx_channel_msg_t> user_msgs,
+                                  uint32_t num_msgs,
+                                  user_out_ptr<uint32_t> actual_msgs) {
+    LTRACEF("handle %x msgs %p num_msgs %u\n", handle_value, user_msgs.get(), num_msgs);
+
+    if (options != 0u)
+        return ZX_ERR_NOT_SUPPORTED;
+
+    if (num_msgs == 0u || num_msgs > ZX_CHANNEL_MAX_BATCH_MSGS)
+        return ZX_ERR_OUT_OF_RANGE;
+
+    zx_channel_msg_t msgs[ZX_CHANNEL_MAX_BATCH_MSGS];
+    if (user_msgs.copy_array_from_user(msgs, num_msgs) != ZX_OK)
+        return ZX_ERR_INVALID_ARGS;
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    fbl::RefPtr<ChannelDispatcher> channel;
+    zx_status_t result = up->GetDispatcherWithRights(handle_value, ZX_RIGHT_READ, &channel);
+    if (result != ZX_OK)
+        return result;
+
+    uint32_t sizes[ZX_CHANNEL_MAX_BATCH_MSGS];
+    uint32_t handle_counts[ZX_CHANNEL_MAX_BATCH_MSGS];
+    for (uint32_t i = 0; i < num_msgs; ++i) {
+        sizes[i] = msgs[i].num_bytes;
+        handle_counts[i] = msgs[i].num_handles;
+    }
+
+    fbl::unique_ptr<MessagePacket> packets[ZX_CHANNEL_MAX_BATCH_MSGS];
+    size_t actual = 0;
+    result = channel->ReadMany(up->get_koid(), sizes, handle_counts, packets, num_msgs, &actual);
+    if (result != ZX_OK && result != ZX_ERR_BUFFER_TOO_SMALL)
+        return result;
+
+    // Like zx_channel_read(), a message that cannot be copied out is lost.
+    for (size_t i = 0; i < actual; ++i) {
+        const uint32_t num_bytes = sizes[i];
+        const uint32_t num_handles = handle_counts[i];
+        if (num_bytes > 0u) {
+            if (packets[i]->MoveDataTo(make_user_out_ptr(msgs[i].bytes)) != ZX_OK)
+                return ZX_ERR_INVALID_ARGS;
+        }
+        if (num_handles > 0u) {
+            msg_get_handles(up, packets[i].get(), make_user_out_ptr(msgs[i].handles),
+                            num_handles);
+        }
+        msgs[i].num_bytes = num_bytes;
+        msgs[i].num_handles = num_handles;
+        msgs[i].status = ZX_OK;
+
+        record_recv_msg_sz(num_bytes);
+        ktrace(TAG_CHANNEL_READ, (uint32_t)channel->get_koid(), num_bytes, num_handles, 0);
+    }
+
+    // Report why the batch stopped short: a message that did not fit, or an
+    // empty queue.
+    for (size_t i = actual; i < num_msgs; ++i) {
+        msgs[i].status = ZX_ERR_SHOULD_WAIT;
+    }
+    if (actual < num_msgs &&
+        (sizes[actual] > msgs[actual].num_bytes ||
+         handle_counts[actual] > msgs[actual].num_handles)) {
+        msgs[actual].num_bytes = sizes[actual];
+        msgs[actual].num_handles = handle_counts[actual];
+        msgs[actual].status = ZX_ERR_BUFFER_TOO_SMALL;
+    }
+
+    if (user_msgs.copy_array_to_user(msgs, num_msgs) != ZX_OK)
+        return ZX_ERR_INVALID_ARGS;
+
+    if (actual_msgs) {
+        zx_status_t status = actual_msgs.copy_to_user(static_cast<uint32_t>(actual));
+        if (status != ZX_OK)
+            return status;
+    }
+    return result;
+}
+
 static zx_status_t channel_read_out(ProcessDispatcher* up,
                                     fbl::unique_ptr<MessagePacket> reply,
                                     zx_channel_call_args_t* args,
@@ -283,7 +364,7 @@ zx_status_t sys_channel_write(zx_handle_t handle_value, uint32_t options,
 
     auto up = ProcessDispatcher::GetCurrent();
 
-    if (options != 0u) {
+    if (options & ~ZX_CHANNEL_WRITE_MOVE_PAGES) {
         up->RemoveHandles(user_handles, num_handles);
         return ZX_ERR_INVALID_ARGS;
     }
@@ -296,7 +377,13 @@ zx_status_t sys_channel_write(zx_handle_t handle_value, uint32_t options,
     }
 
     fbl::unique_ptr<MessagePacket> msg;
-    status = MessagePacket::Create(user_bytes, num_bytes, num_handles, &msg);
+    status = ZX_ERR_NOT_SUPPORTED;
+    if (options & ZX_CHANNEL_WRITE_MOVE_PAGES) {
+        // Moving is best effort; anything that can't be moved is copied.
+        status = MessagePacket::CreateFromPages(user_bytes, num_bytes, num_handles, &msg);
+    }
+    if (status == ZX_ERR_NOT_SUPPORTED)
+        status = MessagePacket::Create(user_bytes, num_bytes, num_handles, &msg);
     if (status != ZX_OK) {
         up->RemoveHandles(user_handles, num_handles);
         return status;
@@ -317,6 +404,83 @@ zx_status_t sys_channel_write(zx_handle_t handle_value, uint32_t options,
     return ZX_OK;
 }
 
+static void msgs_remove_handles(ProcessDispatcher* up, const zx_channel_msg_t* msgs,
+                                uint32_t num_msgs) {
+    for (uint32_t i = 0; i < num_msgs; ++i) {
+        up->RemoveHandles(make_user_in_ptr<const zx_handle_t>(msgs[i].handles),
+                          msgs[i].num_handles);
+    }
+}
+
+// zx_status_t zx_channel_write_many
+zx_status_t sys_channel_write_many(zx_handle_t handle_value, uint32_t options,
+                                   user_inout_ptr<zx_channel_msg_t> user_msgs,
+                                   uint32_t num_msgs) {
+    LTRACEF("handle %x msgs %p num_msgs %u options 0x%x\n",
+            handle_value, user_msgs.get(), num_msgs, options);
+
+    // Until the array is read there are no handles to consume.
+    if (num_msgs == 0u || num_msgs > ZX_CHANNEL_MAX_BATCH_MSGS)
+        return ZX_ERR_OUT_OF_RANGE;
+
+    zx_channel_msg_t msgs[ZX_CHANNEL_MAX_BATCH_MSGS];
+    if (user_msgs.copy_array_from_user(msgs, num_msgs) != ZX_OK)
+        return ZX_ERR_INVALID_ARGS;
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    if (options != 0u) {
+        msgs_remove_handles(up, msgs, num_msgs);
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    fbl::RefPtr<ChannelDispatcher> channel;
+    zx_status_t status = up->GetDispatcherWithRights(handle_value, ZX_RIGHT_WRITE, &channel);
+    if (status != ZX_OK) {
+        msgs_remove_handles(up, msgs, num_msgs);
+        return status;
+    }
+
+    // Each message succeeds or fails on its own. The ones that could be built
+    // are written together.
+    fbl::unique_ptr<MessagePacket> packets[ZX_CHANNEL_MAX_BATCH_MSGS];
+    for (uint32_t i = 0; i < num_msgs; ++i) {
+        auto user_bytes = make_user_in_ptr<const void>(msgs[i].bytes);
+        auto user_handles = make_user_in_ptr<const zx_handle_t>(msgs[i].handles);
+        const uint32_t num_handles = msgs[i].num_handles;
+
+        status = MessagePacket::Create(user_bytes, msgs[i].num_bytes, num_handles, &packets[i]);
+        if (status != ZX_OK) {
+            up->RemoveHandles(user_handles, num_handles);
+        } else if (num_handles > 0u) {
+            status = msg_put_handles(up, packets[i].get(), user_handles, num_handles,
+                                     static_cast<Dispatcher*>(channel.get()));
+            if (status != ZX_OK)
+                packets[i].reset();
+        }
+        msgs[i].status = status;
+    }
+
+    status = channel->WriteMany(up->get_koid(), packets, num_msgs);
+
+    zx_status_t result = ZX_OK;
+    for (uint32_t i = 0; i < num_msgs; ++i) {
+        if (msgs[i].status == ZX_OK) {
+            msgs[i].status = status;
+            if (status == ZX_OK) {
+                ktrace(TAG_CHANNEL_WRITE, (uint32_t)channel->get_koid(),
+                       msgs[i].num_bytes, msgs[i].num_handles, 0);
+            }
+        }
+        if (result == ZX_OK)
+            result = msgs[i].status;
+    }
+
+    if (user_msgs.copy_array_to_user(msgs, num_msgs) != ZX_OK)
+        return ZX_ERR_INVALID_ARGS;
+    return result;
+}
+
 // zx_status_t zx_channel_call_noretry
 zx_status_t sys_channel_call_noretry(zx_handle_t handle_value, uint32_t options,
                                      zx_time_t deadline,
@@ -477,6 +477,12 @@ zx_status_t sys_pci_config_read(zx_handle_t handle, uint16_t offset, size_t widt
         return ZX_ERR_INVALID_ARGS;
     }
 
+    // Read-only registers copied at probe time don't need a trip to the hardware.
+    uint32_t val;
+    if (device->ReadShadowedConfig(offset, width, &val)) {
+        return out_val.copy_to_user(val);
+    }
+
     // Based on the width passed in we can use the type safety of the PciConfig layer
     // to ensure we're getting correctly sized data back and return errors in the PIO
     // cases.
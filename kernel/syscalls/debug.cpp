@@ -12,7 +12,10 @@
 #include <string.h>
 #include <trace.h>
 
+#include <fbl/mutex.h>
+#include <kernel/lockdep.h>
 #include <lib/console.h>
+#include <lib/counters.h>
 #include <lib/debuglog.h>
 #include <lib/user_copy/user_ptr.h>
 #include <lib/ktrace.h>
@@ -21,6 +24,7 @@
 #include <object/handle.h>
 #include <object/process_dispatcher.h>
 #include <object/resource.h>
+#include <object/vm_object_dispatcher.h>
 
 #include <platform/debug.h>
 
@@ -162,17 +166,54 @@ zx_status_t sys_ktrace_write(zx_handle_t handle, uint32_t event_id, uint32_t arg
         return ZX_ERR_INVALID_ARGS;
     }
 
-    uint32_t* args = static_cast<uint32_t*>(ktrace_open(TAG_PROBE_24(event_id)));
-    if (!args) {
+    uint32_t args[2] = {arg0, arg1};
+    if (!ktrace_write(TAG_PROBE_24(event_id), args)) {
         //  There is not a single reason for failure. Assume it reached the end.
         return ZX_ERR_UNAVAILABLE;
     }
-
-    args[0] = arg0;
-    args[1] = arg1;
     return ZX_OK;
 }
 
+// Every handle to the counters refers to the same dispatcher, created on
+// first use, like the vDSO's. The VMO is the kernel's own and must never
+// look unreachable just because one caller closed its handle.
+static fbl::Mutex kcounters_lock;
+static fbl::RefPtr<Dispatcher> kcounters_dispatcher TA_GUARDED(kcounters_lock);
+static zx_rights_t kcounters_rights TA_GUARDED(kcounters_lock);
+
+// zx_status_t zx_kcounters_get_vmo
+zx_status_t sys_kcounters_get_vmo(zx_handle_t handle, user_out_handle* out) {
+    zx_status_t status;
+    if ((status = validate_resource(handle, ZX_RSRC_KIND_ROOT)) < 0) {
+        return status;
+    }
+
+    fbl::RefPtr<Dispatcher> dispatcher;
+    zx_rights_t rights;
+    {
+        Guard<fbl::Mutex> guard{&kcounters_lock};
+        if (!kcounters_dispatcher) {
+            fbl::RefPtr<VmObject> vmo = kcounters_get_vmo();
+            if (!vmo) {
+                return ZX_ERR_NOT_SUPPORTED;
+            }
+
+            status = VmObjectDispatcher::Create(fbl::move(vmo), &kcounters_dispatcher,
+                                                &kcounters_rights);
+            if (status != ZX_OK) {
+                return status;
+            }
+
+            // The pages are the kernel's own counters; userspace may only look.
+            kcounters_rights &= ~(ZX_RIGHT_WRITE | ZX_RIGHT_EXECUTE | ZX_RIGHT_SET_PROPERTY);
+        }
+        dispatcher = kcounters_dispatcher;
+        rights = kcounters_rights;
+    }
+
+    return out->make(fbl::move(dispatcher), rights);
+}
+
 // zx_status_t zx_mtrace_control
 zx_status_t sys_mtrace_control(zx_handle_t handle,
                                uint32_t kind, uint32_t action, uint32_t options,
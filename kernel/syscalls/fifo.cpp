@@ -89,3 +89,39 @@ zx_status_t sys_fifo_read(zx_handle_t handle, size_t elem_size, user_out_ptr<voi
     }
     return ZX_OK;
 }
+
+// zx_status_t zx_fifo_get_vmo
+zx_status_t sys_fifo_get_vmo(zx_handle_t handle, user_out_handle* out_vmo,
+                             user_out_ptr<uint32_t> tx_ring_out) {
+    auto up = ProcessDispatcher::GetCurrent();
+
+    fbl::RefPtr<FifoDispatcher> fifo;
+    zx_status_t status = up->GetDispatcherWithRights(handle, ZX_RIGHT_READ | ZX_RIGHT_WRITE,
+                                                     &fifo);
+    if (status != ZX_OK)
+        return status;
+
+    fbl::RefPtr<Dispatcher> vmo;
+    zx_rights_t rights;
+    uint32_t tx_ring;
+    status = fifo->GetSharedVmo(&vmo, &rights, &tx_ring);
+    if (status != ZX_OK)
+        return status;
+
+    status = tx_ring_out.copy_to_user(tx_ring);
+    if (status != ZX_OK)
+        return status;
+    return out_vmo->make(fbl::move(vmo), rights);
+}
+
+// zx_status_t zx_fifo_update_signals
+zx_status_t sys_fifo_update_signals(zx_handle_t handle) {
+    auto up = ProcessDispatcher::GetCurrent();
+
+    fbl::RefPtr<FifoDispatcher> fifo;
+    zx_status_t status = up->GetDispatcherWithRights(handle, ZX_RIGHT_SIGNAL, &fifo);
+    if (status != ZX_OK)
+        return status;
+
+    return fifo->UpdateSharedSignals();
+}
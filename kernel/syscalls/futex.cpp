@@ -9,6 +9,7 @@
 #include <trace.h>
 
 #include <object/process_dispatcher.h>
+#include <object/thread_dispatcher.h>
 #include <zircon/types.h>
 
 #include "priv.h"
@@ -42,3 +43,31 @@ zx_status_t sys_futex_requeue(user_in_ptr<const zx_futex_t> wake_ptr, uint32_t w
         wake_ptr, wake_count, current_value,
         requeue_ptr, requeue_count);
 }
+
+// zx_status_t zx_futex_wait_pi
+zx_status_t sys_futex_wait_pi(user_in_ptr<const zx_futex_t> value_ptr, int32_t current_value,
+                              zx_handle_t owner, zx_time_t deadline) {
+    LTRACEF("futex %p current %d owner %x\n", value_ptr.get(), current_value, owner);
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    fbl::RefPtr<ThreadDispatcher> owner_thread;
+    if (owner != ZX_HANDLE_INVALID) {
+        zx_status_t status = up->GetDispatcher(owner, &owner_thread);
+        if (status != ZX_OK)
+            return status;
+        // Futexes are keyed by address in the waiter's process only.
+        if (owner_thread->process() != up)
+            return ZX_ERR_INVALID_ARGS;
+    }
+
+    return up->futex_context()->FutexWaitPi(
+        value_ptr, current_value, fbl::move(owner_thread), deadline);
+}
+
+// zx_status_t zx_futex_wake_pi
+zx_status_t sys_futex_wake_pi(user_in_ptr<const zx_futex_t> value_ptr) {
+    LTRACEF("futex %p\n", value_ptr.get());
+
+    return ProcessDispatcher::GetCurrent()->futex_context()->FutexWakePi(value_ptr);
+}
@@ -21,7 +21,7 @@
 // zx_status_t zx_guest_create
 zx_status_t sys_guest_create(zx_handle_t resource, uint32_t options, user_out_handle* guest_handle,
                              user_out_handle* vmar_handle) {
-    if (options != 0u)
+    if (options & ~ZX_GUEST_OPT_PREFAULT)
         return ZX_ERR_INVALID_ARGS;
 
     zx_status_t status = validate_resource(resource, ZX_RSRC_KIND_HYPERVISOR);
@@ -30,8 +30,8 @@ zx_status_t sys_guest_create(zx_handle_t resource, uint32_t options, user_out_ha
 
     fbl::RefPtr<Dispatcher> guest_dispatcher, vmar_dispatcher;
     zx_rights_t guest_rights, vmar_rights;
-    status =
-        GuestDispatcher::Create(&guest_dispatcher, &guest_rights, &vmar_dispatcher, &vmar_rights);
+    status = GuestDispatcher::Create(options, &guest_dispatcher, &guest_rights, &vmar_dispatcher,
+                                     &vmar_rights);
     if (status != ZX_OK)
         return status;
 
@@ -6,8 +6,10 @@
 
 #include <err.h>
 #include <inttypes.h>
+#include <string.h>
 #include <trace.h>
 
+#include <kernel/lockdep.h>
 #include <kernel/mp.h>
 #include <kernel/stats.h>
 #include <kernel/thread_lock.h>
@@ -21,11 +23,13 @@
 #include <object/bus_transaction_initiator_dispatcher.h>
 #include <object/diagnostics.h>
 #include <object/handle.h>
+#include <object/interrupt_dispatcher.h>
 #include <object/job_dispatcher.h>
 #include <object/process_dispatcher.h>
 #include <object/resource_dispatcher.h>
 #include <object/resource.h>
 #include <object/socket_dispatcher.h>
+#include <object/syscall_stats.h>
 #include <object/thread_dispatcher.h>
 #include <object/vm_address_region_dispatcher.h>
 #include <object/vm_object_dispatcher.h>
@@ -553,6 +557,62 @@ zx_status_t sys_object_get_info(zx_handle_t handle, uint32_t topic,
         return single_record_result(
             _buffer, buffer_size, _actual, _avail, &stats, sizeof(stats));
     }
+    case ZX_INFO_LOCK_STATS: {
+        auto status = validate_resource(handle, ZX_RSRC_KIND_ROOT);
+        if (status != ZX_OK)
+            return status;
+#if WITH_LOCK_PROF
+        size_t num_space_for = buffer_size / sizeof(zx_info_lock_stats_t);
+        size_t num_classes = 0;
+        size_t num_copied = 0;
+
+        user_out_ptr<zx_info_lock_stats_t> stats_buf =
+            _buffer.reinterpret<zx_info_lock_stats_t>();
+
+        // The lock class list is built by global initializers and never changes
+        // afterwards, so it can be walked without a lock.
+        for (auto& state : lockdep::LockClassState::Iter()) {
+            num_classes++;
+            if (num_copied == num_space_for)
+                continue;
+
+            const lockdep::LockClassProfile& profile = state.profile();
+            zx_info_lock_stats_t stats = {};
+            strlcpy(stats.name, state.name(), sizeof(stats.name));
+            stats.id = state.id();
+            stats.acquisitions = profile.acquisitions();
+            stats.contentions = profile.contentions();
+            stats.total_wait_time = profile.total_wait_ns();
+            stats.max_wait_time = profile.max_wait_ns();
+            stats.total_hold_time = profile.total_hold_ns();
+            stats.max_hold_time = profile.max_hold_ns();
+            static_assert(ZX_INFO_LOCK_STATS_BUCKETS == lockdep::kLockProfileBuckets, "");
+            for (size_t i = 0; i < ZX_INFO_LOCK_STATS_BUCKETS; i++) {
+                stats.wait_histogram[i] = profile.wait_histogram(i);
+                stats.hold_histogram[i] = profile.hold_histogram(i);
+            }
+
+            // copy out one at a time
+            if (stats_buf.copy_array_to_user(&stats, 1, num_copied) != ZX_OK)
+                return ZX_ERR_INVALID_ARGS;
+            num_copied++;
+        }
+
+        if (_actual) {
+            zx_status_t status = _actual.copy_to_user(num_copied);
+            if (status != ZX_OK)
+                return status;
+        }
+        if (_avail) {
+            zx_status_t status = _avail.copy_to_user(num_classes);
+            if (status != ZX_OK)
+                return status;
+        }
+        return ZX_OK;
+#else
+        return ZX_ERR_NOT_SUPPORTED;
+#endif
+    }
     case ZX_INFO_RESOURCE: {
         // grab a reference to the dispatcher
         fbl::RefPtr<ResourceDispatcher> resource;
@@ -590,10 +650,8 @@ zx_status_t sys_object_get_info(zx_handle_t handle, uint32_t topic,
         if (status != ZX_OK)
             return status;
 
-        zx_info_bti_t info = {
-            .minimum_contiguity = dispatcher->minimum_contiguity(),
-            .aspace_size = dispatcher->aspace_size(),
-        };
+        zx_info_bti_t info = {};
+        dispatcher->GetInfo(&info);
 
         return single_record_result(
             _buffer, buffer_size, _actual, _avail, &info, sizeof(info));
@@ -631,6 +689,105 @@ zx_status_t sys_object_get_info(zx_handle_t handle, uint32_t topic,
             _buffer, buffer_size, _actual, _avail, &info, sizeof(info));
     }
 
+    case ZX_INFO_INTERRUPT: {
+        fbl::RefPtr<InterruptDispatcher> interrupt;
+        auto status = up->GetDispatcherWithRights(handle, ZX_RIGHT_INSPECT, &interrupt);
+        if (status != ZX_OK)
+            return status;
+
+        zx_info_interrupt_t info;
+        interrupt->GetInfo(&info);
+
+        return single_record_result(
+            _buffer, buffer_size, _actual, _avail, &info, sizeof(info));
+    }
+    case ZX_INFO_TASK_USAGE: {
+        fbl::RefPtr<Dispatcher> dispatcher;
+        auto status = up->GetDispatcherWithRights(handle, ZX_RIGHT_INSPECT, &dispatcher);
+        if (status != ZX_OK)
+            return status;
+
+        // Both read counters kept up to date by the scheduler and the fault
+        // handler, so this is cheap regardless of the size of the task.
+        zx_info_task_usage_t info = {};
+        if (auto job = DownCastDispatcher<JobDispatcher>(&dispatcher)) {
+            job->GetUsage(&info);
+        } else if (auto process = DownCastDispatcher<ProcessDispatcher>(&dispatcher)) {
+            process->GetUsage(&info);
+        } else {
+            return ZX_ERR_WRONG_TYPE;
+        }
+
+        return single_record_result(
+            _buffer, buffer_size, _actual, _avail, &info, sizeof(info));
+    }
+    case ZX_INFO_SYSCALL_STATS: {
+        // A process handle reports the calls made by that process, the root
+        // resource those made by the whole system.
+        fbl::RefPtr<ProcessDispatcher> process;
+        auto status = up->GetDispatcherWithRights(handle, ZX_RIGHT_INSPECT, &process);
+        if (status == ZX_ERR_WRONG_TYPE)
+            status = validate_resource(handle, ZX_RSRC_KIND_ROOT);
+        if (status != ZX_OK)
+            return status;
+        if (!SyscallStats::enabled())
+            return ZX_ERR_NOT_SUPPORTED;
+
+        size_t num_space_for = buffer_size / sizeof(zx_info_syscall_stats_t);
+        size_t num_called = 0;
+        size_t num_copied = 0;
+
+        user_out_ptr<zx_info_syscall_stats_t> stats_buf =
+            _buffer.reinterpret<zx_info_syscall_stats_t>();
+
+        // Only syscalls which have been made at least once are reported.
+        for (uint32_t num = 0; num < ZX_SYS_COUNT; num++) {
+            zx_info_syscall_stats_t stats = {};
+            stats.syscall_num = num;
+            if (process) {
+                process->syscall_stats()->Accumulate(num, &stats);
+            } else {
+                for (cpu_num_t cpu = 0; cpu < arch_max_num_cpus(); cpu++)
+                    SyscallStats::ForCpu(cpu)->Accumulate(num, &stats);
+            }
+            if (stats.count == 0)
+                continue;
+
+            num_called++;
+            if (num_copied == num_space_for)
+                continue;
+
+            // copy out one at a time
+            if (stats_buf.copy_array_to_user(&stats, 1, num_copied) != ZX_OK)
+                return ZX_ERR_INVALID_ARGS;
+            num_copied++;
+        }
+
+        if (_actual) {
+            zx_status_t status = _actual.copy_to_user(num_copied);
+            if (status != ZX_OK)
+                return status;
+        }
+        if (_avail) {
+            zx_status_t status = _avail.copy_to_user(num_called);
+            if (status != ZX_OK)
+                return status;
+        }
+        return ZX_OK;
+    }
+    case ZX_INFO_JOB_CPU_BANDWIDTH: {
+        fbl::RefPtr<JobDispatcher> job;
+        auto status = up->GetDispatcherWithRights(handle, ZX_RIGHT_INSPECT, &job);
+        if (status != ZX_OK)
+            return status;
+
+        zx_info_job_cpu_bandwidth_t info = {};
+        job->GetCpuBandwidth(&info);
+
+        return single_record_result(
+            _buffer, buffer_size, _actual, _avail, &info, sizeof(info));
+    }
+
     default:
         return ZX_ERR_NOT_SUPPORTED;
     }
@@ -740,6 +897,34 @@ zx_status_t sys_object_get_property(zx_handle_t handle_value, uint32_t property,
         size_t depth = channel->TxMessageMax();
         return _value.reinterpret<size_t>().copy_to_user(depth);
     }
+    case ZX_PROP_INTERRUPT_COALESCE: {
+        if (size < sizeof(zx_interrupt_coalesce_t))
+            return ZX_ERR_BUFFER_TOO_SMALL;
+        auto interrupt = DownCastDispatcher<InterruptDispatcher>(&dispatcher);
+        if (!interrupt)
+            return ZX_ERR_WRONG_TYPE;
+        zx_interrupt_coalesce_t value = interrupt->GetCoalescing();
+        return _value.reinterpret<zx_interrupt_coalesce_t>().copy_to_user(value);
+    }
+    case ZX_PROP_BTI_PIN_CACHE_QUOTA: {
+        if (size < sizeof(uint64_t))
+            return ZX_ERR_BUFFER_TOO_SMALL;
+        auto bti = DownCastDispatcher<BusTransactionInitiatorDispatcher>(&dispatcher);
+        if (!bti)
+            return ZX_ERR_WRONG_TYPE;
+        uint64_t value = bti->pin_cache_quota();
+        return _value.reinterpret<uint64_t>().copy_to_user(value);
+    }
+    case ZX_PROP_JOB_CPU_BANDWIDTH: {
+        if (size < sizeof(zx_job_cpu_bandwidth_t))
+            return ZX_ERR_BUFFER_TOO_SMALL;
+        auto job = DownCastDispatcher<JobDispatcher>(&dispatcher);
+        if (!job)
+            return ZX_ERR_WRONG_TYPE;
+        zx_info_job_cpu_bandwidth_t info;
+        job->GetCpuBandwidth(&info);
+        return _value.reinterpret<zx_job_cpu_bandwidth_t>().copy_to_user(info.limit);
+    }
     default:
         return ZX_ERR_INVALID_ARGS;
     }
@@ -867,6 +1052,71 @@ zx_status_t sys_object_set_property(zx_handle_t handle_value, uint32_t property,
         }
         return ZX_OK;
     }
+    case ZX_PROP_INTERRUPT_COALESCE: {
+        if (size < sizeof(zx_interrupt_coalesce_t))
+            return ZX_ERR_BUFFER_TOO_SMALL;
+        auto interrupt = DownCastDispatcher<InterruptDispatcher>(&dispatcher);
+        if (!interrupt)
+            return ZX_ERR_WRONG_TYPE;
+        zx_interrupt_coalesce_t value;
+        zx_status_t status =
+            _value.reinterpret<const zx_interrupt_coalesce_t>().copy_from_user(&value);
+        if (status != ZX_OK)
+            return status;
+        return interrupt->SetCoalescing(value);
+    }
+    case ZX_PROP_INTERRUPT_AFFINITY: {
+        if (size < sizeof(uint32_t))
+            return ZX_ERR_BUFFER_TOO_SMALL;
+        auto interrupt = DownCastDispatcher<InterruptDispatcher>(&dispatcher);
+        if (!interrupt)
+            return ZX_ERR_WRONG_TYPE;
+        uint32_t value = 0;
+        zx_status_t status = _value.reinterpret<const uint32_t>().copy_from_user(&value);
+        if (status != ZX_OK)
+            return status;
+        if (value >= arch_max_num_cpus())
+            return ZX_ERR_INVALID_ARGS;
+        return interrupt->SetAffinity(value);
+    }
+    case ZX_PROP_BTI_PIN_CACHE_QUOTA: {
+        if (size < sizeof(uint64_t))
+            return ZX_ERR_BUFFER_TOO_SMALL;
+        auto bti = DownCastDispatcher<BusTransactionInitiatorDispatcher>(&dispatcher);
+        if (!bti)
+            return ZX_ERR_WRONG_TYPE;
+        uint64_t value = 0;
+        zx_status_t status = _value.reinterpret<const uint64_t>().copy_from_user(&value);
+        if (status != ZX_OK)
+            return status;
+        bti->SetPinCacheQuota(value);
+        return ZX_OK;
+    }
+    case ZX_PROP_JOB_CPU_BANDWIDTH: {
+        if (size < sizeof(zx_job_cpu_bandwidth_t))
+            return ZX_ERR_BUFFER_TOO_SMALL;
+        auto job = DownCastDispatcher<JobDispatcher>(&dispatcher);
+        if (!job)
+            return ZX_ERR_WRONG_TYPE;
+        zx_job_cpu_bandwidth_t value;
+        zx_status_t status =
+            _value.reinterpret<const zx_job_cpu_bandwidth_t>().copy_from_user(&value);
+        if (status != ZX_OK)
+            return status;
+        return job->SetCpuBandwidth(value);
+    }
+    case ZX_PROP_EXCEPTION_HANDLER: {
+        if (size < sizeof(zx_thread_exception_handler_t))
+            return ZX_ERR_BUFFER_TOO_SMALL;
+        zx_status_t status = is_current_thread(&dispatcher);
+        if (status != ZX_OK)
+            return status;
+        zx_thread_exception_handler_t value;
+        status = _value.reinterpret<const zx_thread_exception_handler_t>().copy_from_user(&value);
+        if (status != ZX_OK)
+            return status;
+        return ThreadDispatcher::GetCurrent()->SetExceptionHandler(value);
+    }
     }
 
     return ZX_ERR_INVALID_ARGS;
@@ -110,6 +110,39 @@ zx_status_t sys_object_wait_many(user_inout_ptr<zx_wait_item_t> user_items, size
     if (user_items.copy_array_from_user(items, count) != ZX_OK)
         return ZX_ERR_INVALID_ARGS;
 
+    auto up = ProcessDispatcher::GetCurrent();
+
+    // Fast path: if some item is already satisfied, or the deadline has already
+    // passed (the common zero-timeout poll), just report the current state
+    // without attaching and detaching an observer on every object.
+    {
+        bool expired = deadline <= current_time();
+        zx_signals_t satisfied = 0;
+
+        Guard<fbl::Mutex> guard{up->handle_table_lock()};
+
+        for (size_t ix = 0; ix != count; ++ix) {
+            Handle* handle = up->GetHandleLocked(items[ix].handle);
+            if (!handle)
+                return ZX_ERR_BAD_HANDLE;
+            if (!handle->HasRights(ZX_RIGHT_WAIT))
+                return ZX_ERR_ACCESS_DENIED;
+            const auto& dispatcher = handle->dispatcher();
+            if (!dispatcher->is_waitable())
+                return ZX_ERR_NOT_SUPPORTED;
+
+            items[ix].pending = dispatcher->PollSignals();
+            satisfied |= items[ix].pending & items[ix].waitfor;
+        }
+
+        if (satisfied || expired) {
+            guard.Release();
+            if (user_items.copy_array_to_user(items, count) != ZX_OK)
+                return ZX_ERR_INVALID_ARGS;
+            return satisfied ? ZX_OK : ZX_ERR_TIMED_OUT;
+        }
+    }
+
     WaitStateObserver wait_state_observers[kMaxWaitHandleCount];
     Event event;
 
@@ -117,7 +150,6 @@ zx_status_t sys_object_wait_many(user_inout_ptr<zx_wait_item_t> user_items, size
     zx_status_t result = ZX_OK;
     size_t num_added = 0;
     {
-        auto up = ProcessDispatcher::GetCurrent();
         Guard<fbl::Mutex> guard{up->handle_table_lock()};
 
         for (; num_added != count; ++num_added) {
@@ -20,6 +20,7 @@ MODULE_DEPS := \
 
 MODULE_SRCS := \
     $(LOCAL_DIR)/syscalls.cpp \
+    $(LOCAL_DIR)/batch.cpp \
     $(LOCAL_DIR)/channel.cpp \
     $(LOCAL_DIR)/ddk.cpp \
     $(LOCAL_DIR)/ddk_pci.cpp \
@@ -64,7 +64,8 @@ zx_status_t sys_socket_write(zx_handle_t handle, uint32_t options,
     size_t nwritten;
     switch (options) {
     case 0:
-        status = socket->Write(buffer, size, &nwritten);
+    case ZX_SOCKET_WRITE_MOVE_PAGES:
+        status = socket->Write(buffer, size, options == ZX_SOCKET_WRITE_MOVE_PAGES, &nwritten);
         break;
     case ZX_SOCKET_CONTROL:
         status = socket->WriteControl(buffer, size);
@@ -124,6 +125,86 @@ zx_status_t sys_socket_read(zx_handle_t handle, uint32_t options,
     return status;
 }
 
+// zx_status_t zx_socket_writev
+zx_status_t sys_socket_writev(zx_handle_t handle, uint32_t options,
+                              user_in_ptr<const zx_iovec_t> user_vectors, size_t num_vectors,
+                              user_out_ptr<size_t> actual) {
+    LTRACEF("handle %x num_vectors %zu\n", handle, num_vectors);
+
+    if (options & ~ZX_SOCKET_DATAGRAM_BATCH)
+        return ZX_ERR_INVALID_ARGS;
+    if (num_vectors > ZX_SOCKET_MAX_IOVECS)
+        return ZX_ERR_OUT_OF_RANGE;
+
+    zx_iovec_t vectors[ZX_SOCKET_MAX_IOVECS];
+    if (user_vectors.copy_array_from_user(vectors, num_vectors) != ZX_OK)
+        return ZX_ERR_INVALID_ARGS;
+    for (size_t i = 0; i < num_vectors; ++i) {
+        if (!vectors[i].buffer && vectors[i].capacity > 0)
+            return ZX_ERR_INVALID_ARGS;
+    }
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    fbl::RefPtr<SocketDispatcher> socket;
+    zx_status_t status = up->GetDispatcherWithRights(handle, ZX_RIGHT_WRITE, &socket);
+    if (status != ZX_OK)
+        return status;
+
+    size_t nwritten;
+    if (options & ZX_SOCKET_DATAGRAM_BATCH) {
+        status = socket->WriteDatagramVector(vectors, num_vectors, &nwritten);
+    } else {
+        status = socket->WriteVector(vectors, num_vectors, &nwritten);
+    }
+
+    // Caller may ignore results if desired.
+    if (status == ZX_OK && actual)
+        status = actual.copy_to_user(nwritten);
+
+    return status;
+}
+
+// zx_status_t zx_socket_readv
+zx_status_t sys_socket_readv(zx_handle_t handle, uint32_t options,
+                             user_in_ptr<const zx_iovec_t> user_vectors, size_t num_vectors,
+                             user_out_ptr<size_t> actual) {
+    LTRACEF("handle %x num_vectors %zu\n", handle, num_vectors);
+
+    if (options & ~ZX_SOCKET_DATAGRAM_BATCH)
+        return ZX_ERR_INVALID_ARGS;
+    if (num_vectors > ZX_SOCKET_MAX_IOVECS)
+        return ZX_ERR_OUT_OF_RANGE;
+
+    zx_iovec_t vectors[ZX_SOCKET_MAX_IOVECS];
+    if (user_vectors.copy_array_from_user(vectors, num_vectors) != ZX_OK)
+        return ZX_ERR_INVALID_ARGS;
+    for (size_t i = 0; i < num_vectors; ++i) {
+        if (!vectors[i].buffer && vectors[i].capacity > 0)
+            return ZX_ERR_INVALID_ARGS;
+    }
+
+    auto up = ProcessDispatcher::GetCurrent();
+
+    fbl::RefPtr<SocketDispatcher> socket;
+    zx_status_t status = up->GetDispatcherWithRights(handle, ZX_RIGHT_READ, &socket);
+    if (status != ZX_OK)
+        return status;
+
+    size_t nread;
+    if (options & ZX_SOCKET_DATAGRAM_BATCH) {
+        status = socket->ReadDatagramVector(vectors, num_vectors, &nread);
+    } else {
+        status = socket->ReadVector(vectors, num_vectors, &nread);
+    }
+
+    // Caller may ignore results if desired.
+    if (status == ZX_OK && actual)
+        status = actual.copy_to_user(nread);
+
+    return status;
+}
+
 // zx_status_t zx_socket_share
 zx_status_t sys_socket_share(zx_handle_t handle, zx_handle_t other) {
     auto up = ProcessDispatcher::GetCurrent();
@@ -10,9 +10,11 @@
 #include <lib/ktrace.h>
 #include <lib/vdso.h>
 #include <object/process_dispatcher.h>
+#include <object/syscall_stats.h>
 #include <platform.h>
 #include <syscalls/syscalls.h>
 #include <trace.h>
+#include <zircon/time.h>
 #include <zircon/zx-syscall-numbers.h>
 
 #include <inttypes.h>
@@ -42,6 +44,9 @@ inline syscall_result do_syscall(uint64_t syscall_num, uint64_t pc,
 
     CPU_STATS_INC(syscalls);
 
+    // Only read the clock when syscall stats were enabled at boot.
+    const zx_time_t start_time = unlikely(SyscallStats::enabled()) ? current_time() : 0;
+
     /* re-enable interrupts to maintain kernel preemptiveness
        This must be done after the above ktrace_tiny call, and after the
        above CPU_STATS_INC call as it also calls arch_curr_cpu_num. */
@@ -66,6 +71,11 @@ inline syscall_result do_syscall(uint64_t syscall_num, uint64_t pc,
        This must be done before the below ktrace_tiny call. */
     arch_disable_ints();
 
+    if (unlikely(start_time)) {
+        SyscallStats::Record(syscall_num, zx_time_sub_time(current_time(), start_time),
+                             current_process->syscall_stats());
+    }
+
     ktrace_tiny(TAG_SYSCALL_EXIT, (static_cast<uint32_t>(syscall_num << 8)) | arch_curr_cpu_num());
 
     // The assembler caller will re-disable interrupts at the appropriate time.
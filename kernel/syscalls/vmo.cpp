@@ -14,6 +14,7 @@
 #include <lib/user_copy/user_ptr.h>
 
 #include <object/handle.h>
+#include <object/port_dispatcher.h>
 #include <object/process_dispatcher.h>
 #include <object/resource.h>
 #include <object/vm_object_dispatcher.h>
@@ -204,6 +205,24 @@ zx_status_t sys_vmo_op_range(zx_handle_t handle, uint32_t op, uint64_t offset, u
         return status;
     }
 
+    if (op == ZX_VMO_OP_COMMIT_ASYNC || op == ZX_VMO_OP_PREFETCH_ASYNC) {
+        zx_vmo_op_async_t args;
+        if (buffer_size != sizeof(args))
+            return ZX_ERR_INVALID_ARGS;
+        status = _buffer.reinterpret<zx_vmo_op_async_t>().copy_from_user(&args);
+        if (status != ZX_OK)
+            return status;
+        if (args.options != 0)
+            return ZX_ERR_INVALID_ARGS;
+
+        fbl::RefPtr<PortDispatcher> port;
+        status = up->GetDispatcherWithRights(args.port, ZX_RIGHT_WRITE, &port);
+        if (status != ZX_OK)
+            return status;
+
+        return vmo->RangeOpAsync(op, offset, size, fbl::move(port), args.key, rights);
+    }
+
     return vmo->RangeOp(op, offset, size, _buffer, buffer_size, rights);
 }
 
@@ -8,12 +8,23 @@
 #include "tests.h"
 
 #include <arch/ops.h>
+#include <arch/user_copy.h>
+#include <dev/iommu/dummy.h>
 #include <err.h>
+#include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
+#include <fbl/auto_call.h>
+#include <fbl/unique_ptr.h>
 #include <inttypes.h>
 #include <kernel/mp.h>
 #include <kernel/mutex.h>
 #include <kernel/spinlock.h>
 #include <kernel/thread.h>
+#include <kernel/thread_lock.h>
+#include <kernel/timer.h>
+#include <lib/unittest/user_memory.h>
+#include <object/bus_transaction_initiator_dispatcher.h>
+#include <object/pinned_memory_token_dispatcher.h>
 #include <platform.h>
 #include <rand.h>
 #include <stdio.h>
@@ -21,6 +32,10 @@
 #include <string.h>
 #include <sys/types.h>
 #include <trace.h>
+#include <vm/vm_aspace.h>
+#include <vm/pmm.h>
+#include <vm/vm_object_paged.h>
+#include <zxcpp/new.h>
 
 const size_t BUFSIZE = (3 * 1024 * 1024); // must be smaller than max allowed heap allocation
 const size_t ITER = (1UL * 1024 * 1024 * 1024 / BUFSIZE); // enough iterations to have to copy/set 1GB of memory
@@ -207,6 +222,178 @@ __NO_INLINE static void bench_memcpy() {
     free(buf);
 }
 
+// Copy sizes for bench_user_copy, from small message headers up to large
+// channel and VMO payloads.
+static const size_t kUserCopySizes[] = {16, 64, 256, 1024, 4096, 16384, 64 * 1024, 1024 * 1024};
+static const size_t kUserCopyBytes = (256 * 1024 * 1024); // bytes moved per size and direction
+
+__NO_INLINE static void bench_user_copy_size(void* user, uint8_t* buf, size_t size, bool to_user) {
+    const size_t iter = kUserCopyBytes / size;
+
+    spin_lock_saved_state_t state;
+    arch_interrupt_save(&state, ARCH_DEFAULT_SPIN_LOCK_FLAG_INTERRUPTS);
+    uint64_t count = arch_cycle_count();
+    for (size_t i = 0; i < iter; i++) {
+        if (to_user) {
+            arch_copy_to_user(user, buf, size);
+        } else {
+            arch_copy_from_user(buf, user, size);
+        }
+    }
+    count = arch_cycle_count() - count;
+    arch_interrupt_restore(state, ARCH_DEFAULT_SPIN_LOCK_FLAG_INTERRUPTS);
+
+    uint64_t bytes_cycle = (size * iter * 1000ULL) / count;
+    printf("took %" PRIu64 " cycles to %s a buffer of size %zu %zu times "
+           "(%zu bytes), %" PRIu64 ".%03" PRIu64 " bytes/cycle\n",
+           count, to_user ? "copy_to_user" : "copy_from_user", size, iter, size * iter,
+           bytes_cycle / 1000, bytes_cycle % 1000);
+}
+
+static int bench_user_copy_thread(void*) {
+    const size_t max_size = kUserCopySizes[fbl::count_of(kUserCopySizes) - 1];
+    fbl::unique_ptr<testing::UserMemory> mem = testing::UserMemory::Create(max_size);
+    if (!mem) {
+        TRACEF("error: failed to map user memory\n");
+        return -1;
+    }
+    uint8_t* buf = (uint8_t*)calloc(1, max_size);
+    if (buf == nullptr) {
+        TRACEF("error: calloc failed\n");
+        return -1;
+    }
+
+    // Commit the user pages up front, so the timed loops never take a page
+    // fault with interrupts disabled.
+    if (arch_copy_to_user(mem->out(), buf, max_size) != ZX_OK) {
+        TRACEF("error: failed to fault in user memory\n");
+        free(buf);
+        return -1;
+    }
+
+    for (size_t size : kUserCopySizes) {
+        bench_user_copy_size(mem->out(), buf, size, true);
+        bench_user_copy_size(mem->out(), buf, size, false);
+    }
+
+    free(buf);
+    return 0;
+}
+
+// user_copy needs a user address space, which the shell thread does not
+// have, so run the copies in a thread with a scratch one attached.
+__NO_INLINE static void bench_user_copy() {
+    fbl::RefPtr<VmAspace> aspace = VmAspace::Create(VmAspace::TYPE_USER, "bench_user_copy");
+    if (!aspace) {
+        TRACEF("error: failed to create user aspace\n");
+        return;
+    }
+    auto destroy_aspace = fbl::MakeAutoCall([&]() {
+        zx_status_t status = aspace->Destroy();
+        DEBUG_ASSERT(status == ZX_OK);
+    });
+
+    thread_t* t = thread_create("bench_user_copy", bench_user_copy_thread, nullptr,
+                                DEFAULT_PRIORITY);
+    if (!t) {
+        TRACEF("error: failed to create thread\n");
+        return;
+    }
+    aspace->AttachToThread(t);
+    thread_resume(t);
+    thread_join(t, nullptr, ZX_TIME_INFINITE);
+}
+
+// Pin sizes for bench_bti_pin, from a single page up to large storage buffers.
+static const size_t kPinSizes[] = {PAGE_SIZE, 64 * 1024, 1024 * 1024, 16 * 1024 * 1024};
+static const size_t kPinBytes = (1024 * 1024 * 1024); // bytes pinned per size
+
+__NO_INLINE static void bench_bti_pin_size(const fbl::RefPtr<BusTransactionInitiatorDispatcher>& bti,
+                                           const fbl::RefPtr<VmObject>& vmo, size_t size) {
+    const uint32_t perms = IOMMU_FLAG_PERM_READ | IOMMU_FLAG_PERM_WRITE;
+    const size_t iter = fbl::max(kPinBytes / size, static_cast<size_t>(16));
+
+    uint64_t pin_cycles = 0;
+    uint64_t unpin_cycles = 0;
+    for (size_t i = 0; i < iter; i++) {
+        fbl::RefPtr<Dispatcher> pmt;
+        zx_rights_t rights;
+
+        uint64_t c = arch_cycle_count();
+        zx_status_t status = bti->Pin(vmo, 0, size, perms, &pmt, &rights);
+        pin_cycles += arch_cycle_count() - c;
+        if (status != ZX_OK) {
+            TRACEF("error: pin failed: %d\n", status);
+            return;
+        }
+
+        // Dropping the only reference unmaps and unpins.
+        c = arch_cycle_count();
+        pmt.reset();
+        unpin_cycles += arch_cycle_count() - c;
+    }
+
+    printf("bti pin %8zu bytes: %" PRIu64 " cycles per pin, %" PRIu64 " cycles per unpin\n",
+           size, pin_cycles / iter, unpin_cycles / iter);
+}
+
+// Measures the cost of zx_bti_pin() and unpinning the resulting PMT for
+// paged and contiguous VMOs.  This runs against the dummy IOMMU, so it
+// covers the VM and PMT bookkeeping; the IOMMU drivers add their map and
+// invalidation costs on top of it.
+__NO_INLINE static void bench_bti_pin() {
+    const size_t max_size = kPinSizes[fbl::count_of(kPinSizes) - 1];
+
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<uint8_t[]> desc(new (&ac) uint8_t[sizeof(zx_iommu_desc_dummy_t)]());
+    if (!ac.check()) {
+        TRACEF("error: failed to allocate iommu descriptor\n");
+        return;
+    }
+    fbl::RefPtr<Iommu> iommu;
+    zx_status_t status = DummyIommu::Create(fbl::unique_ptr<const uint8_t[]>(desc.release()),
+                                            sizeof(zx_iommu_desc_dummy_t), &iommu);
+    if (status != ZX_OK) {
+        TRACEF("error: failed to create iommu: %d\n", status);
+        return;
+    }
+    fbl::RefPtr<Dispatcher> disp;
+    zx_rights_t rights;
+    status = BusTransactionInitiatorDispatcher::Create(iommu, 0, &disp, &rights);
+    if (status != ZX_OK) {
+        TRACEF("error: failed to create bti: %d\n", status);
+        return;
+    }
+    auto bti = DownCastDispatcher<BusTransactionInitiatorDispatcher>(&disp);
+
+    fbl::RefPtr<VmObject> paged;
+    status = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u, max_size, &paged);
+    if (status != ZX_OK) {
+        TRACEF("error: failed to create vmo: %d\n", status);
+        return;
+    }
+    status = paged->CommitRange(0, max_size, nullptr);
+    if (status != ZX_OK) {
+        TRACEF("error: failed to commit vmo: %d\n", status);
+        return;
+    }
+    fbl::RefPtr<VmObject> contiguous;
+    status = VmObjectPaged::CreateContiguous(PMM_ALLOC_FLAG_ANY, max_size, 0, &contiguous);
+    if (status != ZX_OK) {
+        TRACEF("error: failed to create contiguous vmo: %d\n", status);
+        return;
+    }
+
+    printf("paged vmo:\n");
+    for (size_t size : kPinSizes) {
+        bench_bti_pin_size(bti, paged, size);
+    }
+    printf("contiguous vmo:\n");
+    for (size_t size : kPinSizes) {
+        bench_bti_pin_size(bti, contiguous, size);
+    }
+}
+
 __NO_INLINE static void bench_spinlock() {
     spin_lock_saved_state_t state;
     spin_lock_saved_state_t state2;
@@ -270,10 +457,89 @@ __NO_INLINE static void bench_mutex() {
     printf("%" PRIu64 " cycles to acquire/release uncontended mutex %u times (%" PRIu64 " cycles per)\n", c, count, c / count);
 }
 
+// Runs |fn| |count| times per trial, after an untimed warmup trial, and
+// prints the fastest and slowest trials in cycles per iteration.  The output
+// lines all start with "bench:" so that they are easy to pick out of the
+// debuglog.
+template <typename Func>
+__NO_INLINE static void bench_loop(const char* name, size_t count, Func fn) {
+    static const uint kTrials = 5;
+
+    for (size_t i = 0; i < count; i++) {
+        fn();
+    }
+
+    uint64_t min = UINT64_MAX;
+    uint64_t max = 0;
+    for (uint trial = 0; trial < kTrials; trial++) {
+        uint64_t c = arch_cycle_count();
+        for (size_t i = 0; i < count; i++) {
+            fn();
+        }
+        c = (arch_cycle_count() - c) / count;
+        min = fbl::min(min, c);
+        max = fbl::max(max, c);
+    }
+
+    printf("bench: %s: %" PRIu64 " cycles min, %" PRIu64 " cycles max (%u trials of %zu)\n",
+           name, min, max, kTrials, count);
+}
+
+__NO_INLINE static void bench_pmm() {
+    bench_loop("pmm alloc/free page", 1024 * 1024, [] {
+        vm_page_t* page;
+        paddr_t pa;
+        if (pmm_alloc_page(0, &page, &pa) == ZX_OK) {
+            pmm_free_page(page);
+        }
+    });
+}
+
+__NO_INLINE static void bench_heap() {
+    bench_loop("malloc/free 64 bytes", 1024 * 1024, [] {
+        void* ptr = malloc(64);
+        __asm__ volatile("" :: "r"(ptr));
+        free(ptr);
+    });
+}
+
+__NO_INLINE static void bench_thread_lock() {
+    bench_loop("thread_lock acquire/release", 16 * 1024 * 1024, [] {
+        Guard<spin_lock_t, IrqSave> guard{ThreadLock::Get()};
+    });
+}
+
+__NO_INLINE static void bench_timer() {
+    timer_t timer;
+    timer_init(&timer);
+    bench_loop("timer set/cancel", 1024 * 1024, [&timer] {
+        timer_set(&timer, ZX_TIME_INFINITE - 1, TIMER_SLACK_CENTER, 0,
+                  [](timer_t*, zx_time_t, void*) {}, nullptr);
+        timer_cancel(&timer);
+    });
+}
+
+__NO_INLINE static void bench_yield() {
+    bench_loop("thread_yield", 1024 * 1024, [] {
+        thread_yield();
+    });
+}
+
+__NO_INLINE static void bench_ipi() {
+    if ((mp_get_online_mask() & ~cpu_num_to_mask(arch_curr_cpu_num())) == 0) {
+        return;
+    }
+    bench_loop("sync ipi to all other cpus", 64 * 1024, [] {
+        mp_sync_exec(MP_IPI_TARGET_ALL_BUT_LOCAL, 0, [](void*) {}, nullptr);
+    });
+}
+
 int benchmarks(int, const cmd_args*, uint32_t) {
     bench_set_overhead();
     bench_memcpy();
     bench_memset();
+    bench_user_copy();
+    bench_bti_pin();
 
     bench_memset_per_page();
     bench_zero_page();
@@ -287,5 +553,12 @@ int benchmarks(int, const cmd_args*, uint32_t) {
     bench_spinlock();
     bench_mutex();
 
+    bench_pmm();
+    bench_heap();
+    bench_thread_lock();
+    bench_timer();
+    bench_yield();
+    bench_ipi();
+
     return 0;
 }
@@ -183,6 +183,19 @@ struct Mutex : fbl::Mutex {
 };
 // Uses the default traits: fbl::LockClassState::None.
 
+// Mutex that reports contention on every acquisition, like the kernel mutex
+// does when it has to block.
+struct ContendedMutex : fbl::Mutex {
+    using fbl::Mutex::Mutex;
+
+    void Acquire() __TA_ACQUIRE() {
+        fbl::Mutex::Acquire();
+#if WITH_LOCK_PROF
+        lockdep::ThreadLockState::Get()->NoteContention();
+#endif
+    }
+};
+
 struct Nestable : fbl::Mutex {
     using fbl::Mutex::Mutex;
 };
@@ -714,9 +727,72 @@ static bool lock_dep_static_analysis_tests() {
     END_TEST;
 }
 
+#if WITH_LOCK_PROF
+static bool lock_dep_profile_tests() {
+    BEGIN_TEST;
+
+    using lockdep::Guard;
+    using lockdep::LockClassProfile;
+    using lockdep::LockClassState;
+    using test::Baz;
+    using test::ContendedMutex;
+    using test::Mutex;
+
+    // Reset the tracking state, which includes the profiles.
+    test::ResetTrackingState();
+
+    // Uncontended acquisitions are counted and their hold time recorded.
+    {
+        Baz<Mutex> a{};
+        const LockClassProfile& profile = LockClassState::Get(a.lock.id())->profile();
+
+        for (int i = 0; i < 3; i++) {
+            Guard<Mutex> guard{&a.lock};
+        }
+        EXPECT_EQ(3u, profile.acquisitions(), "");
+        EXPECT_EQ(0u, profile.contentions(), "");
+        EXPECT_GE(profile.total_hold_ns(), profile.max_hold_ns(), "");
+
+        uint64_t waits = 0;
+        uint64_t holds = 0;
+        for (size_t i = 0; i < lockdep::kLockProfileBuckets; i++) {
+            waits += profile.wait_histogram(i);
+            holds += profile.hold_histogram(i);
+        }
+        EXPECT_EQ(3u, waits, "");
+        EXPECT_EQ(3u, holds, "");
+    }
+
+    // Contention noted by the primitive is charged to the class being acquired.
+    {
+        Baz<ContendedMutex> a{};
+        const LockClassProfile& profile = LockClassState::Get(a.lock.id())->profile();
+
+        Guard<ContendedMutex> guard{&a.lock};
+        EXPECT_EQ(1u, profile.acquisitions(), "");
+        EXPECT_EQ(1u, profile.contentions(), "");
+
+        // The noted contention is consumed by that acquisition.
+        EXPECT_FALSE(lockdep::ThreadLockState::Get()->TakeContention(), "");
+    }
+
+    // Histogram bucket boundaries.
+    EXPECT_EQ(0u, LockClassProfile::BucketIndex(0), "");
+    EXPECT_EQ(0u, LockClassProfile::BucketIndex(255), "");
+    EXPECT_EQ(1u, LockClassProfile::BucketIndex(256), "");
+    EXPECT_EQ(2u, LockClassProfile::BucketIndex(512), "");
+    EXPECT_EQ(lockdep::kLockProfileBuckets - 1, LockClassProfile::BucketIndex(UINT64_MAX), "");
+
+    END_TEST;
+}
+#endif
+
 UNITTEST_START_TESTCASE(lock_dep_tests)
 UNITTEST("lock_dep_dynamic_analysis_tests", lock_dep_dynamic_analysis_tests)
 UNITTEST("lock_dep_static_analysis_tests", lock_dep_static_analysis_tests)
+#if WITH_LOCK_PROF
+UNITTEST("lock_dep_profile_tests", lock_dep_profile_tests)
+#endif
 UNITTEST_END_TESTCASE(lock_dep_tests, "lock_dep_tests", "lock_dep_tests");
 
 #endif
@@ -376,6 +376,38 @@ static bool set_from_callback() {
     END_TEST;
 }
 
+// A timer whose slack window has opened fires with the interrupt of an
+// earlier timer, rather than at its own scheduled time.
+static bool fire_in_slack_window() {
+    BEGIN_TEST;
+    timer_args early{};
+    timer_args oneshot{};
+    timer_t early_timer = TIMER_INITIAL_VALUE(early_timer);
+    timer_t oneshot_timer = TIMER_INITIAL_VALUE(oneshot_timer);
+
+    // Both timers must be queued on the same cpu.
+    spin_lock_saved_state_t state;
+    arch_interrupt_save(&state, ARCH_DEFAULT_SPIN_LOCK_FLAG_INTERRUPTS);
+    zx_time_t now = current_time();
+    // The early timer's window opens at now + 10ms, but it is scheduled for
+    // now + 1s since it does not overlap with the oneshot timer below.
+    zx_time_t deadline = now + ZX_SEC(1);
+    timer_set(&early_timer, deadline, TIMER_SLACK_EARLY, ZX_SEC(1) - ZX_MSEC(10),
+              timer_cb, &early);
+    timer_set(&oneshot_timer, now + ZX_MSEC(20), TIMER_SLACK_CENTER, 0, timer_cb, &oneshot);
+    arch_interrupt_restore(state, ARCH_DEFAULT_SPIN_LOCK_FLAG_INTERRUPTS);
+
+    while (!atomic_load(&oneshot.timer_fired)) {
+    }
+    while (!atomic_load(&early.timer_fired)) {
+    }
+    EXPECT_TRUE(current_time() < deadline, "early timer waited for its deadline");
+
+    timer_cancel(&early_timer);
+    timer_cancel(&oneshot_timer);
+    END_TEST;
+}
+
 static void timer_trylock_cb(struct timer* t, zx_time_t now, void* void_arg) {
     timer_args* arg = reinterpret_cast<timer_args*>(void_arg);
     atomic_store(&arg->timer_fired, 1);
@@ -490,6 +522,7 @@ UNITTEST("cancel_before_deadline", cancel_before_deadline)
 UNITTEST("cancel_after_fired", cancel_after_fired)
 UNITTEST("cancel_from_callback", cancel_from_callback)
 UNITTEST("set_from_callback", set_from_callback)
+UNITTEST("fire_in_slack_window", fire_in_slack_window)
 UNITTEST("trylock_or_cancel_canceled", trylock_or_cancel_canceled)
 UNITTEST("trylock_or_cancel_get_lock", trylock_or_cancel_get_lock)
 UNITTEST_END_TESTCASE(timer_tests, "timer", "timer tests");
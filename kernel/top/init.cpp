@@ -15,6 +15,8 @@
 
 #include <assert.h>
 #include <debug.h>
+#include <fbl/atomic.h>
+#include <platform.h>
 #include <trace.h>
 #include <zircon/compiler.h>
 
@@ -27,6 +29,18 @@
 extern const struct lk_init_struct __start_lk_init[];
 extern const struct lk_init_struct __stop_lk_init[];
 
+// Hooks called on the primary cpu, in call order, for ktrace to report.
+// Entries are only written by the primary cpu's init sequence and are
+// published by advancing |init_timing_count|.
+#define MAX_INIT_TIMINGS 512
+static struct lk_init_timing init_timings[MAX_INIT_TIMINGS];
+static fbl::atomic<size_t> init_timing_count;
+
+const struct lk_init_timing* lk_init_timings(size_t* count) {
+    *count = init_timing_count.load(fbl::memory_order_acquire);
+    return init_timings;
+}
+
 void lk_init_level(enum lk_init_flags required_flag, uint start_level, uint stop_level) {
     LTRACEF("flags %#x, start_level %#x, stop_level %#x\n",
             (uint)required_flag, start_level, stop_level);
@@ -82,7 +96,15 @@ void lk_init_level(enum lk_init_flags required_flag, uint start_level, uint stop
             }
         }
 
+        zx_ticks_t start = current_ticks();
         found->hook(found->level);
+        if (required_flag == LK_INIT_FLAG_PRIMARY_CPU) {
+            size_t n = init_timing_count.load(fbl::memory_order_relaxed);
+            if (n < MAX_INIT_TIMINGS) {
+                init_timings[n] = {found, start, current_ticks() - start};
+                init_timing_count.store(n + 1, fbl::memory_order_release);
+            }
+        }
         last_called_level = found->level;
         last = found;
     }
@@ -29,6 +29,9 @@ const uint ARCH_MMU_FLAG_INVALID = (1u << 7); // Indicates that flags are not sp
 const uint ARCH_ASPACE_FLAG_KERNEL = (1u << 0);
 const uint ARCH_ASPACE_FLAG_GUEST = (1u << 1);
 
+// Called by HarvestAccessed() for every page whose accessed flag was set.
+typedef void (*harvest_accessed_fn_t)(void* context, vaddr_t vaddr);
+
 // per arch base class api to encapsulate the mmu routines on an aspace
 class ArchVmAspaceInterface {
 public:
@@ -58,6 +61,25 @@ public:
 
     virtual zx_status_t Query(vaddr_t vaddr, paddr_t* paddr, uint* mmu_flags) = 0;
 
+    // Clear the hardware accessed flag of every page mapped in the range
+    // [vaddr, vaddr + count * PAGE_SIZE), calling |accessed_fn| for each page
+    // that had it set. Pages mapped by a large page are reported but their flag
+    // is left alone. Returns ZX_ERR_NOT_SUPPORTED if the aspace does not track
+    // accesses, in which case callers must assume every page was accessed.
+    virtual zx_status_t HarvestAccessed(vaddr_t vaddr, size_t count,
+                                        harvest_accessed_fn_t accessed_fn, void* context) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
+    // Between StartTlbBatch() and FinishTlbBatch(), the TLB invalidations
+    // needed by this thread's Unmap and Protect calls may be deferred and
+    // issued together when the outermost batch finishes.  The caller must
+    // keep every page unmapped during the batch from being freed until it
+    // finishes.  A page table change made by any other thread performs the
+    // deferred invalidations as well, before it returns.
+    virtual void StartTlbBatch() {}
+    virtual void FinishTlbBatch() {}
+
     virtual vaddr_t PickSpot(vaddr_t base, uint prev_region_mmu_flags,
                              vaddr_t end, uint next_region_mmu_flags,
                              vaddr_t align, size_t size, uint mmu_flags) = 0;
@@ -19,6 +19,7 @@ const uint VMM_PF_FLAG_NOT_PRESENT = (1u << 4);
 const uint VMM_PF_FLAG_HW_FAULT = (1u << 5); // hardware is requesting a fault
 const uint VMM_PF_FLAG_SW_FAULT = (1u << 6); // software fault
 const uint VMM_PF_FLAG_FAULT_MASK = (VMM_PF_FLAG_HW_FAULT | VMM_PF_FLAG_SW_FAULT);
+const uint VMM_PF_FLAG_NO_ALLOC = (1u << 7); // fail with ZX_ERR_SHOULD_WAIT rather than allocate
 
 // convenience routine for convering page fault flags to a string
 static const char* vmm_pf_flags_to_string(uint pf_flags, char str[5]) {
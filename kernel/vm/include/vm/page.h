@@ -29,6 +29,15 @@ enum vm_page_state {
 #define VM_PAGE_STATE_BITS 3
 static_assert((1u << VM_PAGE_STATE_BITS) >= VM_PAGE_STATE_COUNT_, "");
 
+// set on free pages parked in a per-cpu cache of the pmm. such pages are not on
+// the free list and must not be claimed by range or contiguous searches.
+#define VM_PAGE_FLAG_PCPU_CACHED (1u << 0)
+
+// set on free pages that the pmm has zeroed in the background. the flag is
+// cleared when a page is freed, and a freshly allocated page still carrying
+// it is known to be all zeroes until its new owner writes to it.
+#define VM_PAGE_FLAG_ZEROED (1u << 1)
+
 // core per page structure allocated at pmm arena creation time
 typedef struct vm_page {
     struct list_node queue_node;
@@ -47,12 +56,18 @@ typedef struct vm_page {
 #define VM_PAGE_OBJECT_MAX_PIN_COUNT ((1ul << VM_PAGE_OBJECT_PIN_COUNT_BITS) - 1)
 
             uint8_t pin_count : VM_PAGE_OBJECT_PIN_COUNT_BITS;
+
+// number of reclaim scans since the page was last seen accessed, saturating
+#define VM_PAGE_OBJECT_AGE_BITS 3
+#define VM_PAGE_OBJECT_MAX_AGE ((1u << VM_PAGE_OBJECT_AGE_BITS) - 1)
+
+            uint8_t age : VM_PAGE_OBJECT_AGE_BITS;
         } object; // attached to a vm object
     };
 
     // helper routines
     bool is_free() const {
-        return state == VM_PAGE_STATE_FREE;
+        return state == VM_PAGE_STATE_FREE && !(flags & VM_PAGE_FLAG_PCPU_CACHED);
     }
 
     void dump() const;
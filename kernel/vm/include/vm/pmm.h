@@ -54,6 +54,11 @@ zx_status_t pmm_alloc_contiguous(size_t count, uint alloc_flags, uint8_t align_l
 // Free a list of physical pages.
 void pmm_free(list_node* list) __NONNULL((1));
 
+// Free a list of physical pages that the caller is done with for good, such
+// as those of a destroyed VMO. If kernel.pmm.background-free is set, large
+// lists are returned by a background thread instead of the calling cpu.
+void pmm_free_background(list_node* list) __NONNULL((1));
+
 // Free a single page.
 void pmm_free_page(vm_page_t* page) __NONNULL((1));
 
@@ -0,0 +1,12 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+#pragma once
+
+#include <sys/types.h>
+
+// Evict up to |target_pages| discardable VMO pages that have not been accessed
+// recently. Returns the number of pages given back to the pmm.
+size_t vm_reclaim_pages(size_t target_pages);
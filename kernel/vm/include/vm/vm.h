@@ -19,6 +19,11 @@
 #define ROUNDUP_PAGE_SIZE(x) ROUNDUP((x), PAGE_SIZE)
 #define IS_PAGE_ALIGNED(x) IS_ALIGNED((x), PAGE_SIZE)
 
+// Smallest block the arch mmu code maps with a single large page entry when
+// the virtual and physical addresses are both aligned to it.
+#define LARGE_PAGE_SIZE_SHIFT (PAGE_SIZE_SHIFT + 9)
+#define LARGE_PAGE_SIZE (1UL << LARGE_PAGE_SIZE_SHIFT)
+
 // kernel address space
 static_assert(KERNEL_ASPACE_BASE + (KERNEL_ASPACE_SIZE - 1) > KERNEL_ASPACE_BASE, "");
 
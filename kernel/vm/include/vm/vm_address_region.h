@@ -7,6 +7,7 @@
 #pragma once
 
 #include <assert.h>
+#include <fbl/algorithm.h>
 #include <fbl/canary.h>
 #include <fbl/intrusive_double_list.h>
 #include <fbl/intrusive_wavl_tree.h>
@@ -44,6 +45,8 @@
 #define VMAR_FLAG_CAN_MAP_EXECUTE (1 << 6)
 // Require that VMO backing the mapping is non-resizable.
 #define VMAR_FLAG_REQUIRE_NON_RESIZABLE (1 << 7)
+// Don't map neighbouring committed pages when a page of the mapping faults.
+#define VMAR_FLAG_NO_FAULT_AROUND (1 << 8)
 
 #define VMAR_CAN_RWX_FLAGS (VMAR_FLAG_CAN_MAP_READ |  \
                             VMAR_FLAG_CAN_MAP_WRITE | \
@@ -199,6 +202,41 @@ protected:
 
     // node for element in list of parent's children.
     fbl::WAVLTreeNodeState<fbl::RefPtr<VmAddressRegionOrMapping>, bool> subregion_list_node_;
+
+    // Summary of the subtree of the parent's child list rooted at this node:
+    // the base of its first region, the end of its last region, and the
+    // largest gap between two of its regions.  Lets the allocators skip
+    // subtrees with no room for a new region.
+    vaddr_t subtree_base_ = 0;
+    vaddr_t subtree_end_ = 0;
+    size_t subtree_max_gap_ = 0;
+
+    // Keeps the subtree summaries up to date as the child list changes.
+    struct WAVLTreeObserver : public fbl::tests::intrusive_containers::DefaultWAVLTreeObserver {
+        static constexpr bool kRecordsSubtreeChanges = true;
+
+        template <typename Iter>
+        static void RecordSubtreeChange(Iter iter) {
+            VmAddressRegionOrMapping& node = *iter;
+            const vaddr_t end = node.base_ + node.size_;
+            node.subtree_base_ = node.base_;
+            node.subtree_end_ = end;
+            node.subtree_max_gap_ = 0;
+            if (iter.left().IsValid()) {
+                const VmAddressRegionOrMapping& left = *iter.left();
+                node.subtree_base_ = left.subtree_base_;
+                node.subtree_max_gap_ = fbl::max(left.subtree_max_gap_,
+                                                 node.base_ - left.subtree_end_);
+            }
+            if (iter.right().IsValid()) {
+                const VmAddressRegionOrMapping& right = *iter.right();
+                node.subtree_end_ = right.subtree_end_;
+                node.subtree_max_gap_ = fbl::max(node.subtree_max_gap_,
+                                                 fbl::max(right.subtree_max_gap_,
+                                                          right.subtree_base_ - end));
+            }
+        }
+    };
 };
 
 // A representation of a contiguous range of virtual address space
@@ -267,7 +305,7 @@ protected:
 private:
     using ChildList = fbl::WAVLTree<vaddr_t, fbl::RefPtr<VmAddressRegionOrMapping>,
                                     fbl::DefaultKeyedObjectTraits<vaddr_t, VmAddressRegionOrMapping>,
-                                    WAVLTreeTraits>;
+                                    WAVLTreeTraits, WAVLTreeObserver>;
 
     DISALLOW_COPY_ASSIGN_AND_MOVE(VmAddressRegion);
 
@@ -280,6 +318,10 @@ private:
     // Version of FindRegion() that does not acquire the aspace lock
     fbl::RefPtr<VmAddressRegionOrMapping> FindRegionLocked(vaddr_t addr);
 
+    // Recursively traverses the regions to find the mapping containing |va|,
+    // if it exists.  Does not acquire the aspace lock.
+    fbl::RefPtr<VmMapping> FindMappingLocked(vaddr_t va);
+
     // Version of Destroy() that does not acquire the aspace lock
     zx_status_t DestroyLocked() override;
 
@@ -304,6 +346,13 @@ private:
     // exist, the first child that contains an address greater than |base|.
     ChildList::iterator UpperBoundInternalLocked(vaddr_t base);
 
+    // Remove the page table entries of every mapping in this region's subtree
+    // that intersect [base, base + size), leaving the mappings in place, and
+    // perform all of the TLB invalidations this needs in one batch.  Done
+    // ahead of destroying or unmapping several mappings, so they don't each
+    // send their own shootdown.
+    void UnmapPagesBatchedLocked(vaddr_t base, size_t size);
+
     // Implementation for Unmap() and OverwriteVmMapping() that does not hold
     // the aspace lock. If |can_destroy_regions| is true, then this may destroy
     // VMARs that it completely covers. If |allow_partial_vmar| is true, then
@@ -338,9 +387,10 @@ private:
     // Utility for allocators for iterating over gaps between allocations
     // F should have a signature of bool func(vaddr_t gap_base, size_t gap_size).
     // If func returns false, the iteration stops.  gap_base will be aligned in
-    // accordance with align_pow2.
+    // accordance with align_pow2.  Gaps smaller than min_gap may be skipped
+    // without being passed to func.
     template <typename F>
-    void ForEachGap(F func, uint8_t align_pow2);
+    void ForEachGap(F func, uint8_t align_pow2, size_t min_gap);
 
     // list of subregions, indexed by base address
     ChildList subregions_;
@@ -448,6 +498,10 @@ public:
     bool is_mapping() const override { return true; }
 
     void Dump(uint depth, bool verbose) const override;
+
+    // Unlike the other operations here, this may be called without the
+    // aspace lock, as long as the caller has registered itself as an active
+    // fault with the aspace (see VmAspace::WaitForFaultsLocked()).
     zx_status_t PageFault(vaddr_t va, uint pf_flags) override;
 
 protected:
@@ -460,6 +514,11 @@ protected:
     // unmap any pages that map the passed in vmo range. May not intersect with this range
     zx_status_t UnmapVmoRangeLocked(uint64_t start, uint64_t size) const;
 
+    // report the parts of the passed in vmo range that were accessed through this mapping since
+    // they were last harvested, clearing their accessed state.
+    void HarvestAccessedVmoRangeLocked(uint64_t start, uint64_t size,
+                                       vmo_accessed_fn_t accessed_fn, void* context) const;
+
 private:
     DISALLOW_COPY_ASSIGN_AND_MOVE(VmMapping);
 
@@ -493,6 +552,10 @@ private:
     // in Clang around capability aliasing, we need to relax the analysis.
     void ActivateLocked();
 
+    // Change size_ while in the parent's child list, keeping the parent's
+    // subtree summaries up to date.
+    void set_size_locked(size_t size);
+
     // pointer and region of the object we are mapping
     fbl::RefPtr<VmObject> object_;
     uint64_t object_offset_ = 0;
@@ -500,6 +563,16 @@ private:
     // cached mapping flags (read/write/user/etc)
     uint arch_mmu_flags_;
 
+    // Implementation for PageFault(), called with the object_ lock held.
+    // |free_list| is passed through to GetPageLocked().
+    // Should be annotated TA_REQ(object_->lock()), but due to limitations
+    // in Clang around capability aliasing, we need to relax the analysis.
+    zx_status_t PageFaultLocked(vaddr_t va, uint pf_flags, uint64_t vmo_offset,
+                                list_node* free_list) TA_NO_THREAD_SAFETY_ANALYSIS;
+
+    // Map already committed neighbours of a freshly faulted page at |va|.
+    void FaultAroundLocked(vaddr_t va);
+
     // used to detect recursions through the vmo fault path
     bool currently_faulting_ = false;
 };
@@ -9,12 +9,14 @@
 #include <arch/aspace.h>
 #include <arch/mmu.h>
 #include <assert.h>
+#include <fbl/atomic.h>
 #include <fbl/canary.h>
 #include <fbl/intrusive_double_list.h>
 #include <fbl/intrusive_wavl_tree.h>
 #include <fbl/macros.h>
 #include <fbl/ref_counted.h>
 #include <fbl/ref_ptr.h>
+#include <kernel/event.h>
 #include <kernel/lockdep.h>
 #include <kernel/mutex.h>
 #include <lib/crypto/prng.h>
@@ -159,6 +161,12 @@ protected:
     friend class VmMapping;
     Lock<fbl::Mutex>* lock() { return &lock_; }
 
+    // Waits until no page faults are in progress in this aspace.  Page faults
+    // only hold lock_ while they look up their mapping, so anything that
+    // changes an existing mapping, or the arch mappings under it, must call
+    // this first.  lock_ must be held, so that no new faults can start.
+    void WaitForFaultsLocked();
+
     // Expose the PRNG for ASLR to VmAddressRegion
     crypto::PRNG& AslrPrng() {
         DEBUG_ASSERT(aslr_enabled_);
@@ -202,6 +210,13 @@ private:
     // Access to this reference is guarded by lock_.
     fbl::RefPtr<VmAddressRegion> root_vmar_;
 
+    // The number of page faults which have found their mapping and dropped
+    // lock_, but not yet finished.  Only incremented with lock_ held.
+    fbl::atomic<uint32_t> active_faults_{0};
+
+    // Signaled when active_faults_ drops to zero.
+    event_t faults_done_;
+
     // PRNG used by VMARs for address choices.  We record the seed to enable
     // reproducible debugging.
     crypto::PRNG aslr_prng_;
@@ -0,0 +1,45 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+#pragma once
+
+#include <fbl/intrusive_wavl_tree.h>
+#include <fbl/macros.h>
+#include <fbl/unique_ptr.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <zircon/types.h>
+
+// The LZ4 compressed contents of a page that was evicted from a VMO by
+// reclaim, kept in the kernel heap until the page is faulted back in.
+class VmCompressedPage final
+    : public fbl::WAVLTreeContainable<fbl::unique_ptr<VmCompressedPage>> {
+public:
+    // Returns true if reclaim should compress pages it can't discard.
+    static bool enabled();
+
+    // Compresses the page at |pa|, which lives at |offset| in its object.
+    // Returns nullptr if the page doesn't compress well enough to be worth
+    // keeping, or if there's no memory to hold it.
+    static fbl::unique_ptr<VmCompressedPage> Create(uint64_t offset, paddr_t pa);
+
+    ~VmCompressedPage();
+
+    // Restores the contents into the page at |pa|.
+    zx_status_t Decompress(paddr_t pa) const;
+
+    uint64_t offset() const { return offset_; }
+    uint64_t GetKey() const { return offset_; }
+    size_t size() const { return size_; }
+
+private:
+    VmCompressedPage(uint64_t offset, fbl::unique_ptr<uint8_t[]> data, size_t size);
+
+    DISALLOW_COPY_ASSIGN_AND_MOVE(VmCompressedPage);
+
+    const uint64_t offset_;
+    const fbl::unique_ptr<uint8_t[]> data_;
+    const size_t size_;
+};
@@ -12,7 +12,7 @@
 #include <fbl/intrusive_double_list.h>
 #include <fbl/macros.h>
 #include <fbl/name.h>
-#include <fbl/ref_counted.h>
+#include <fbl/ref_counted_upgradeable.h>
 #include <fbl/ref_ptr.h>
 #include <kernel/lockdep.h>
 #include <kernel/mutex.h>
@@ -28,6 +28,7 @@
 class VmMapping;
 
 typedef zx_status_t (*vmo_lookup_fn_t)(void* context, size_t offset, size_t index, paddr_t pa);
+typedef void (*vmo_accessed_fn_t)(void* context, uint64_t offset, uint64_t len);
 
 class VmObjectChildObserver {
 public:
@@ -39,7 +40,7 @@ public:
 //
 // Can be created without mapping and used as a container of data, or mappable
 // into an address space via VmAddressRegion::CreateVmMapping
-class VmObject : public fbl::RefCounted<VmObject>,
+class VmObject : public fbl::RefCountedUpgradeable<VmObject>,
                  public fbl::DoublyLinkedListable<VmObject*> {
 public:
     // public API
@@ -78,6 +79,12 @@ public:
         return ZX_ERR_NOT_SUPPORTED;
     }
 
+    // bring in the contents the range already has without committing new
+    // pages, so that touching it later does not have to
+    virtual zx_status_t PrefetchRange(uint64_t offset, uint64_t len) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
     // Pin the given range of the vmo.  If any pages are not committed, this
     // returns a ZX_ERR_NO_MEMORY.
     virtual zx_status_t Pin(uint64_t offset, uint64_t len) {
@@ -91,6 +98,20 @@ public:
         panic("Unpin should only be called on a pinned range");
     }
 
+    // Move the pages backing the page aligned range [offset, offset + len) out of the vmo and onto
+    // |pages|, in order, leaving the range decommitted. Fails with ZX_ERR_BAD_STATE if other vmos
+    // could observe the range through this one.
+    virtual zx_status_t TakePages(uint64_t offset, uint64_t len, list_node* pages) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
+    // Replace the contents of the page aligned range [offset, offset + len) with the pages on
+    // |pages|, which must hold exactly len / PAGE_SIZE pages taken by TakePages(). On success the
+    // vmo owns the pages and |pages| is empty.
+    virtual zx_status_t SupplyPages(uint64_t offset, uint64_t len, list_node* pages) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
     // read/write operators against kernel pointers only
     virtual zx_status_t Read(void* ptr, uint64_t offset, size_t len) {
         return ZX_ERR_NOT_SUPPORTED;
@@ -157,6 +178,21 @@ public:
         return ZX_ERR_NOT_SUPPORTED;
     }
 
+    // page reclamation. AgePages() ages every page of the object by one scan,
+    // resetting pages that were accessed since the previous scan.
+    // ReclaimPages() then evicts up to |max_pages| discardable pages that have
+    // gone at least |min_age| scans without being accessed, returning the
+    // number of pages freed.
+    virtual void AgePages() {}
+    virtual size_t ReclaimPages(uint32_t min_age, size_t max_pages) { return 0; }
+
+    // Called as each dispatcher wrapping the object is created and destroyed.
+    // Once the last one is gone no user handle can reach the object, and its
+    // contents can only be reached through existing mappings and clones, so
+    // the object is hidden and pages that none of them can see may be dropped.
+    void AddDispatcher();
+    void RemoveDispatcher();
+
     virtual uint32_t GetMappingCachePolicy() const = 0;
     virtual zx_status_t SetMappingCachePolicy(const uint32_t cache_policy) {
         return ZX_ERR_NOT_SUPPORTED;
@@ -182,6 +218,13 @@ public:
         return ZX_ERR_NOT_SUPPORTED;
     }
 
+    // allocate and zero a page that GetPageLocked() may use to fault in a new page, and add it
+    // to |free_list|. called without the lock held, so that the zeroing does not hold up other
+    // users of the vmo. see VMM_PF_FLAG_NO_ALLOC.
+    virtual zx_status_t AllocFaultPage(list_node* free_list) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
     Lock<fbl::Mutex>* lock() TA_RET_CAP(lock_) { return &lock_; }
     Lock<fbl::Mutex>& lock_ref() TA_RET_CAP(lock_) { return lock_; }
 
@@ -216,6 +259,13 @@ public:
         return ZX_OK;
     }
 
+    // Calls AgePages() on every VMO in the system.
+    static void AgeAllPages();
+
+    // Calls ReclaimPages() on every VMO in the system until |max_pages| pages
+    // have been freed, returning the number of pages freed.
+    static size_t ReclaimAllPages(uint32_t min_age, size_t max_pages);
+
 protected:
     // private constructor (use Create())
     explicit VmObject(fbl::RefPtr<VmObject> parent);
@@ -231,6 +281,15 @@ protected:
     // inform all mappings and children that a range of this vmo's pages were added or removed.
     void RangeChangeUpdateLocked(uint64_t offset, uint64_t len) TA_REQ(lock_);
 
+    // report the ranges of [offset, offset + len) that were accessed through
+    // any mapping since the last time they were harvested.
+    void HarvestAccessedLocked(uint64_t offset, uint64_t len, vmo_accessed_fn_t accessed_fn,
+                               void* context) TA_REQ(lock_);
+
+    // drop whatever nothing can reach anymore. called after the object was
+    // hidden, and again whenever a hidden object loses a mapping or a child.
+    virtual void TrimHiddenLocked() TA_REQ(lock_) {}
+
     // above call but called from a parent
     virtual void RangeChangeUpdateFromParentLocked(uint64_t offset, uint64_t len)
         // Called under the parent's lock, which confuses analysis.
@@ -264,6 +323,12 @@ protected:
 
     uint64_t user_id_ TA_GUARDED(lock_) = 0;
 
+    // number of dispatchers wrapping the object
+    uint32_t dispatcher_count_ TA_GUARDED(lock_) = 0;
+
+    // set by RemoveDispatcher() once dispatcher_count_ drops to 0
+    bool hidden_ TA_GUARDED(lock_) = false;
+
     // The user-friendly VMO name. For debug purposes only. That
     // is, there is no mechanism to get access to a VMO via this name.
     fbl::Name<ZX_MAX_NAME_LEN> name_;
@@ -285,4 +350,10 @@ private:
     using GlobalList = fbl::DoublyLinkedList<VmObject*, GlobalListTraits>;
     DECLARE_SINGLETON_MUTEX(AllVmosLock);
     static GlobalList all_vmos_ TA_GUARDED(AllVmosLock::Get());
+
+    // Calls |func(VmObject*)| on a reference to every live VMO in the system,
+    // without holding AllVmosLock across the calls. Stops if |func| returns
+    // false.
+    template <typename T>
+    static void ForEachLiveVmo(T func);
 };
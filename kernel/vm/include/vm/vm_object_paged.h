@@ -10,9 +10,11 @@
 #include <fbl/array.h>
 #include <fbl/canary.h>
 #include <fbl/intrusive_double_list.h>
+#include <fbl/intrusive_wavl_tree.h>
 #include <fbl/macros.h>
 #include <fbl/ref_counted.h>
 #include <fbl/ref_ptr.h>
+#include <fbl/unique_ptr.h>
 #include <kernel/mutex.h>
 #include <lib/user_copy/user_ptr.h>
 #include <list.h>
@@ -20,6 +22,7 @@
 #include <vm/pmm.h>
 #include <vm/vm.h>
 #include <vm/vm_aspace.h>
+#include <vm/vm_compressed_page.h>
 #include <vm/vm_object.h>
 #include <vm/vm_page_list.h>
 #include <zircon/thread_annotations.h>
@@ -59,10 +62,14 @@ public:
 
     zx_status_t CommitRange(uint64_t offset, uint64_t len, uint64_t* committed) override;
     zx_status_t DecommitRange(uint64_t offset, uint64_t len, uint64_t* decommitted) override;
+    zx_status_t PrefetchRange(uint64_t offset, uint64_t len) override;
 
     zx_status_t Pin(uint64_t offset, uint64_t len) override;
     void Unpin(uint64_t offset, uint64_t len) override;
 
+    zx_status_t TakePages(uint64_t offset, uint64_t len, list_node* pages) override;
+    zx_status_t SupplyPages(uint64_t offset, uint64_t len, list_node* pages) override;
+
     zx_status_t Read(void* ptr, uint64_t offset, size_t len) override;
     zx_status_t Write(const void* ptr, uint64_t offset, size_t len) override;
     zx_status_t Lookup(uint64_t offset, uint64_t len, uint pf_flags,
@@ -81,6 +88,8 @@ public:
     zx_status_t CleanInvalidateCache(const uint64_t offset, const uint64_t len) override;
     zx_status_t SyncCache(const uint64_t offset, const uint64_t len) override;
 
+    zx_status_t AllocFaultPage(list_node* free_list) override;
+
     zx_status_t GetPageLocked(uint64_t offset, uint pf_flags, list_node* free_list,
                               vm_page_t**, paddr_t*) override
         // Calls a Locked method of the parent, which confuses analysis.
@@ -95,6 +104,13 @@ public:
         // Called under the parent's lock, which confuses analysis.
         TA_NO_THREAD_SAFETY_ANALYSIS;
 
+    void AgePages() override;
+    size_t ReclaimPages(uint32_t min_age, size_t max_pages) override;
+
+    void TrimHiddenLocked() override
+        // Looks at the Locked state of the children, which confuses analysis.
+        TA_NO_THREAD_SAFETY_ANALYSIS;
+
     uint32_t GetMappingCachePolicy() const override;
     zx_status_t SetMappingCachePolicy(const uint32_t cache_policy) override;
 
@@ -130,6 +146,22 @@ private:
     zx_status_t PinLocked(uint64_t offset, uint64_t len) TA_REQ(lock_);
     void UnpinLocked(uint64_t offset, uint64_t len) TA_REQ(lock_);
 
+    // internal check if the object's pages may be evicted by ReclaimPages()
+    bool CanReclaimLocked() const TA_REQ(lock_);
+
+    // bring a page that reclaim compressed back into page_list_, taking the
+    // page from |free_list| if it isn't empty. returns ZX_ERR_NOT_FOUND if
+    // there is no compressed page at |offset|.
+    zx_status_t DecompressPageLocked(uint64_t offset, list_node* free_list,
+                                     vm_page_t** page_out) TA_REQ(lock_);
+    zx_status_t DecompressRangeLocked(uint64_t start, uint64_t end) TA_REQ(lock_);
+    void FreeCompressedPagesLocked(uint64_t start, uint64_t end) TA_REQ(lock_);
+
+    // internal check if a clone can read through to our page at |offset|
+    bool IsVisibleToChildrenLocked(uint64_t offset) const
+        // Looks at the Locked state of the children, which confuses analysis.
+        TA_NO_THREAD_SAFETY_ANALYSIS;
+
     // internal check if any pages in a range are pinned
     bool AnyPagesPinnedLocked(uint64_t offset, size_t len) TA_REQ(lock_);
 
@@ -149,4 +181,7 @@ private:
 
     // a tree of pages
     VmPageList page_list_ TA_GUARDED(lock_);
+
+    // pages evicted by reclaim whose contents were kept compressed, by offset
+    fbl::WAVLTree<uint64_t, fbl::unique_ptr<VmCompressedPage>> compressed_pages_ TA_GUARDED(lock_);
 };
@@ -23,7 +23,8 @@ public:
 
     DISALLOW_COPY_ASSIGN_AND_MOVE(VmPageListNode);
 
-    static const size_t kPageFanOut = 16;
+    // One bit of populated_ per slot, so the fan out is bounded by its width.
+    static const size_t kPageFanOut = 64;
 
     // accessors
     uint64_t offset() const { return obj_offset_; }
@@ -32,24 +33,17 @@ public:
     // for every valid page in the node call the passed in function
     template <typename T>
     zx_status_t ForEveryPage(T func, uint64_t start_offset, uint64_t end_offset) {
-        DEBUG_ASSERT(IS_PAGE_ALIGNED(start_offset) && IS_PAGE_ALIGNED(end_offset));
-        size_t start = 0;
-        size_t end = kPageFanOut;
-        if (start_offset > obj_offset_) {
-            start = (start_offset - obj_offset_) / PAGE_SIZE;
-        }
-        if (end_offset < obj_offset_) {
-            return ZX_ERR_NEXT;
-        }
-        if (end_offset < obj_offset_ + kPageFanOut * PAGE_SIZE) {
-            end = (end_offset - obj_offset_) / PAGE_SIZE;
-        }
-        for (size_t i = start; i < end; i++) {
-            if (pages_[i]) {
-                zx_status_t status = func(pages_[i], obj_offset_ + i * PAGE_SIZE);
-                if (unlikely(status != ZX_ERR_NEXT)) {
-                    return status;
-                }
+        uint64_t mask = RangeMask(start_offset, end_offset);
+        while (mask) {
+            size_t i = __builtin_ctzll(mask);
+            mask &= mask - 1;
+            zx_status_t status = func(pages_[i], obj_offset_ + i * PAGE_SIZE);
+            // the callback is allowed to take the page out of the node
+            if (!pages_[i]) {
+                populated_ &= ~(1ull << i);
+            }
+            if (unlikely(status != ZX_ERR_NEXT)) {
+                return status;
             }
         }
         return ZX_ERR_NEXT;
@@ -58,49 +52,62 @@ public:
     // for every valid page in the node call the passed in function
     template <typename T>
     zx_status_t ForEveryPage(T func, uint64_t start_offset, uint64_t end_offset) const {
+        uint64_t mask = RangeMask(start_offset, end_offset);
+        while (mask) {
+            size_t i = __builtin_ctzll(mask);
+            mask &= mask - 1;
+            zx_status_t status = func(pages_[i], obj_offset_ + i * PAGE_SIZE);
+            if (unlikely(status != ZX_ERR_NEXT)) {
+                return status;
+            }
+        }
+        return ZX_ERR_NEXT;
+    }
+
+    vm_page* GetPage(size_t index);
+    vm_page* RemovePage(size_t index);
+    zx_status_t AddPage(vm_page* p, size_t index);
+
+    // Move every page in [start_offset, end_offset) to the tail of |list|,
+    // returning how many were moved.
+    size_t RemovePages(uint64_t start_offset, uint64_t end_offset, list_node* list);
+
+    bool IsEmpty() const { return populated_ == 0; }
+
+private:
+    // Bitmap of the populated slots that fall in [start_offset, end_offset).
+    uint64_t RangeMask(uint64_t start_offset, uint64_t end_offset) const {
         DEBUG_ASSERT(IS_PAGE_ALIGNED(start_offset) && IS_PAGE_ALIGNED(end_offset));
         size_t start = 0;
         size_t end = kPageFanOut;
         if (start_offset > obj_offset_) {
             start = (start_offset - obj_offset_) / PAGE_SIZE;
         }
-        if (end_offset < obj_offset_) {
-            return ZX_ERR_NEXT;
+        if (end_offset <= obj_offset_ || start >= kPageFanOut) {
+            return 0;
         }
         if (end_offset < obj_offset_ + kPageFanOut * PAGE_SIZE) {
             end = (end_offset - obj_offset_) / PAGE_SIZE;
         }
-        for (size_t i = start; i < end; i++) {
-            if (pages_[i]) {
-                zx_status_t status = func(pages_[i], obj_offset_ + i * PAGE_SIZE);
-                if (unlikely(status != ZX_ERR_NEXT)) {
-                    return status;
-                }
-            }
+        if (start >= end) {
+            return 0;
         }
-        return ZX_ERR_NEXT;
-    }
-
-    vm_page* GetPage(size_t index);
-    vm_page* RemovePage(size_t index);
-    zx_status_t AddPage(vm_page* p, size_t index);
-
-    bool IsEmpty() const {
-        for (const auto p : pages_) {
-            if (p) {
-                return false;
-            }
+        uint64_t mask = ~0ull << start;
+        if (end < kPageFanOut) {
+            mask &= (1ull << end) - 1;
         }
-        return true;
+        return populated_ & mask;
     }
 
-private:
     fbl::Canary<fbl::magic("PLST")> canary_;
 
     uint64_t obj_offset_ = 0;
+    uint64_t populated_ = 0;
     vm_page* pages_[kPageFanOut] = {};
 };
 
+static_assert(VmPageListNode::kPageFanOut <= sizeof(uint64_t) * 8, "");
+
 class VmPageList final {
 public:
     VmPageList();
@@ -191,9 +198,23 @@ public:
     zx_status_t AddPage(vm_page*, uint64_t offset);
     vm_page* GetPage(uint64_t offset);
     zx_status_t FreePage(uint64_t offset);
+    // Remove the page at |offset| from the list without freeing it, returning
+    // it or nullptr if there was none.
+    vm_page* RemovePage(uint64_t offset);
+    // Free every page in [start_offset, end_offset) back to the pmm in one
+    // batch, returning the number of pages freed.
+    size_t FreePages(uint64_t start_offset, uint64_t end_offset);
     size_t FreeAllPages();
     bool IsEmpty();
 
 private:
+    // Look up the node starting at |node_offset|, going through the cached
+    // node first since accesses tend to be sequential.
+    VmPageListNode* FindNode(uint64_t node_offset);
+    void EraseNode(VmPageListNode* node);
+
     fbl::WAVLTree<uint64_t, fbl::unique_ptr<VmPageListNode>> list_;
+
+    // The node most recently returned by FindNode, or null.
+    VmPageListNode* last_node_ = nullptr;
 };
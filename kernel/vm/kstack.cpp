@@ -11,6 +11,10 @@
 #include <string.h>
 #include <trace.h>
 
+#include <arch/ops.h>
+#include <kernel/align.h>
+#include <kernel/spinlock.h>
+#include <lib/counters.h>
 #include <vm/vm.h>
 #include <vm/vm_address_region.h>
 #include <vm/vm_aspace.h>
@@ -24,6 +28,83 @@
 
 #define LOCAL_TRACE 0
 
+KCOUNTER(kstack_cache_hit, "kernel.kstack.cache.hit");
+KCOUNTER(kstack_cache_miss, "kernel.kstack.cache.miss");
+// The number of stacks held by the caches, each DEFAULT_STACK_SIZE bytes, or
+// twice that with safe-stack. Unlike the counters above, this one goes down.
+KCOUNTER(kstack_cache_held, "kernel.kstack.cache.held");
+
+namespace {
+
+// The stacks of exited threads are kept in a small per-cpu cache instead of
+// being freed, as allocating a stack creates a VMO and a VMAR and maps it,
+// which costs far more than zeroing the stack for its next thread.
+constexpr size_t kCacheMax = 4;
+
+struct KstackCache {
+    DECLARE_SPINLOCK(KstackCache) lock;
+    kstack_t stacks[kCacheMax] TA_GUARDED(lock) = {};
+    size_t count TA_GUARDED(lock) = 0;
+} __CPU_ALIGN;
+
+KstackCache kstack_cache[SMP_MAX_CPUS];
+
+} // namespace
+
+// Pop a stack off the current cpu's cache, returning false if it is empty.
+static bool take_cached_kstack(kstack_t* stack) {
+    bool found = false;
+
+    spin_lock_saved_state_t irqstate;
+    arch_interrupt_save(&irqstate, SPIN_LOCK_FLAG_INTERRUPTS);
+    {
+        KstackCache& cache = kstack_cache[arch_curr_cpu_num()];
+        Guard<SpinLock, NoIrqSave> guard{&cache.lock};
+        if (cache.count > 0) {
+            *stack = cache.stacks[--cache.count];
+            found = true;
+        }
+    }
+    arch_interrupt_restore(irqstate, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    return found;
+}
+
+// Zero |stack| and push it onto the current cpu's cache, returning false if
+// the cache is full.
+static bool cache_kstack(const kstack_t& stack) {
+    // Only complete stacks are cached.
+    if (stack.vmar == nullptr) {
+        return false;
+    }
+#if __has_feature(safe_stack)
+    if (stack.unsafe_vmar == nullptr) {
+        return false;
+    }
+#endif
+
+    memset(reinterpret_cast<void*>(stack.base), 0, DEFAULT_STACK_SIZE);
+#if __has_feature(safe_stack)
+    memset(reinterpret_cast<void*>(stack.unsafe_base), 0, DEFAULT_STACK_SIZE);
+#endif
+
+    bool cached = false;
+
+    spin_lock_saved_state_t irqstate;
+    arch_interrupt_save(&irqstate, SPIN_LOCK_FLAG_INTERRUPTS);
+    {
+        KstackCache& cache = kstack_cache[arch_curr_cpu_num()];
+        Guard<SpinLock, NoIrqSave> guard{&cache.lock};
+        if (cache.count < kCacheMax) {
+            cache.stacks[cache.count++] = stack;
+            cached = true;
+        }
+    }
+    arch_interrupt_restore(irqstate, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    return cached;
+}
+
 // Allocates and maps a kernel stack with one page of padding before and after the mapping.
 static zx_status_t allocate_vmar(bool unsafe,
                                  fbl::RefPtr<VmMapping>* out_kstack_mapping,
@@ -111,6 +192,13 @@ zx_status_t vm_allocate_kstack(kstack_t* stack) {
     DEBUG_ASSERT(stack->unsafe_vmar == nullptr);
 #endif
 
+    if (take_cached_kstack(stack)) {
+        kcounter_add(kstack_cache_hit, 1);
+        kcounter_add(kstack_cache_held, -1);
+        return ZX_OK;
+    }
+    kcounter_add(kstack_cache_miss, 1);
+
     fbl::RefPtr<VmMapping> mapping;
     fbl::RefPtr<VmAddressRegion> vmar;
     zx_status_t status = allocate_vmar(false, &mapping, &vmar);
@@ -141,6 +229,12 @@ zx_status_t vm_allocate_kstack(kstack_t* stack) {
 }
 
 zx_status_t vm_free_kstack(kstack_t* stack) {
+    if (cache_kstack(*stack)) {
+        kcounter_add(kstack_cache_held, 1);
+        *stack = {};
+        return ZX_OK;
+    }
+
     stack->base = 0;
     stack->size = 0;
     stack->top = 0;
@@ -10,6 +10,7 @@
 #include <assert.h>
 #include <err.h>
 #include <inttypes.h>
+#include <kernel/cmdline.h>
 #include <kernel/mp.h>
 #include <kernel/timer.h>
 #include <lib/console.h>
@@ -47,6 +48,33 @@ static void pmm_enforce_fill(uint level) {
 LK_INIT_HOOK(pmm_fill, &pmm_enforce_fill, LK_INIT_LEVEL_VM);
 #endif
 
+static void pmm_start_zero_thread(uint level) {
+    if (cmdline_get_bool("kernel.pmm.background-zero", true)) {
+        pmm_node.StartZeroThread();
+    }
+}
+LK_INIT_HOOK(pmm_zero, &pmm_start_zero_thread, LK_INIT_LEVEL_THREADING);
+
+static void pmm_start_free_thread(uint level) {
+    if (cmdline_get_bool("kernel.pmm.background-free", false)) {
+        pmm_node.StartFreeThread();
+    }
+}
+LK_INIT_HOOK(pmm_free_thread, &pmm_start_free_thread, LK_INIT_LEVEL_THREADING);
+
+// The secondary cpus are up by the platform level, so the deferred parts of
+// the arenas can be set up on all of them while the rest of the kernel
+// initializes, as long as they are all done before userspace starts.
+static void pmm_start_deferred_init(uint level) {
+    pmm_node.StartDeferredInit();
+}
+LK_INIT_HOOK(pmm_deferred_init, &pmm_start_deferred_init, LK_INIT_LEVEL_PLATFORM);
+
+static void pmm_wait_deferred_init(uint level) {
+    pmm_node.WaitDeferredInit();
+}
+LK_INIT_HOOK(pmm_deferred_init_wait, &pmm_wait_deferred_init, LK_INIT_LEVEL_USER - 1);
+
 vm_page_t* paddr_to_vm_page(paddr_t addr) {
     return pmm_node.PaddrToPage(addr);
 }
@@ -95,6 +123,10 @@ void pmm_free(list_node* list) {
     pmm_node.FreeList(list);
 }
 
+void pmm_free_background(list_node* list) {
+    pmm_node.FreeListBackground(list);
+}
+
 void pmm_free_page(vm_page* page) {
     pmm_node.FreePage(page);
 }
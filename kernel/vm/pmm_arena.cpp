@@ -6,7 +6,9 @@
 #include "pmm_arena.h"
 
 #include <err.h>
+#include <fbl/algorithm.h>
 #include <inttypes.h>
+#include <kernel/atomic.h>
 #include <pretty/sizes.h>
 #include <string.h>
 #include <trace.h>
@@ -20,13 +22,33 @@
 
 #define LOCAL_TRACE MAX(VM_GLOBAL_TRACE, 0)
 
+#if PMM_ENABLE_FREE_FILL
+// pages set up after EnforceFill() would be missing the fill pattern
+static constexpr bool kDeferInit = false;
+#else
+static constexpr bool kDeferInit = true;
+#endif
+
+// Pages at the start of an arena that are always set up right away, so that
+// early boot has memory to work with.
+static constexpr size_t kEagerInitPages = 1ul << PmmArena::kSummaryOrder[PmmArena::kSummaryLevels - 1];
+
 zx_status_t PmmArena::Init(const pmm_arena_info_t* info, PmmNode* node) {
     // TODO: validate that info is sane (page aligned, etc)
     info_ = *info;
 
-    // allocate an array of pages to back this one
+    // allocate an array of pages to back this one, followed by the free run summaries
+    // and the deferred block flags
+    const uint top = kSummaryLevels - 1;
     size_t page_count = size() / PAGE_SIZE;
-    size_t page_array_size = ROUNDUP_PAGE_SIZE(page_count * sizeof(vm_page));
+    first_pfn_ = base() / PAGE_SIZE;
+    size_t summary_size = 0;
+    for (uint level = 0; level < kSummaryLevels; level++) {
+        block_count_[level] = block_index(level, page_count - 1) + 1;
+        summary_size += block_count_[level] * sizeof(uint32_t);
+    }
+    summary_size += block_count_[top] * sizeof(int);
+    size_t page_array_size = ROUNDUP_PAGE_SIZE(page_count * sizeof(vm_page) + summary_size);
 
     // if the arena is too small to be useful, bail
     if (page_array_size >= size()) {
@@ -49,10 +71,18 @@ zx_status_t PmmArena::Init(const pmm_arena_info_t* info, PmmNode* node) {
     LTRACEF("arena for base 0%#" PRIxPTR " size %#zx page array at %p size %#zx\n", base(), size(),
             raw_page_array, page_array_size);
 
-    memset(raw_page_array, 0, page_array_size);
-
     page_array_ = (vm_page_t*)raw_page_array;
 
+    // the summaries start out empty, pages are counted as the node adds them to its free list;
+    // the pages themselves are cleared as their blocks are set up
+    memset(page_array_ + page_count, 0, summary_size);
+    uint32_t* summary = reinterpret_cast<uint32_t*>(page_array_ + page_count);
+    for (uint level = 0; level < kSummaryLevels; level++) {
+        block_free_[level] = summary;
+        summary += block_count_[level];
+    }
+    block_deferred_ = reinterpret_cast<int*>(summary);
+
     // compute the range of the array that backs the array itself
     size_t array_start_index = (PAGE_ALIGN(range.pa) - info_.base) / PAGE_SIZE;
     size_t array_end_index = array_start_index + page_array_size / PAGE_SIZE;
@@ -61,27 +91,108 @@ zx_status_t PmmArena::Init(const pmm_arena_info_t* info, PmmNode* node) {
 
     DEBUG_ASSERT(array_start_index < page_count && array_end_index <= page_count);
 
+    // defer every large block except the first ones and those holding the page array or
+    // boot reserved memory, which is wired as soon as the arenas are added
+    if (kDeferInit) {
+        for (size_t b = 0; b < block_count_[top]; b++) {
+            size_t start, end;
+            block_range(top, b, &start, &end);
+            block_deferred_[b] = start >= kEagerInitPages &&
+                                 (end <= array_start_index || start >= array_end_index);
+        }
+        boot_reserve_foreach([this](reserve_range_t r) {
+            if (r.pa + r.len > base() && r.pa < base() + size()) {
+                size_t first = (fbl::max(r.pa, base()) - base()) / PAGE_SIZE;
+                size_t last = (fbl::min(r.pa + r.len, base() + size()) - 1 - base()) / PAGE_SIZE;
+                for (size_t b = block_index(kSummaryLevels - 1, first);
+                     b <= block_index(kSummaryLevels - 1, last); b++) {
+                    block_deferred_[b] = 0;
+                }
+            }
+            return true;
+        });
+    }
+
     // add all pages that aren't part of the page array to the free list
     // pages part of the free array go to the WIRED state
     list_node list;
     list_initialize(&list);
-    for (size_t i = 0; i < page_count; i++) {
-        auto& p = page_array_[i];
+    size_t deferred_pages = 0;
+    for (size_t b = 0; b < block_count_[top]; b++) {
+        size_t start, end;
+        block_range(top, b, &start, &end);
+        if (block_deferred_[b]) {
+            deferred_pages += end - start;
+            continue;
+        }
+        memset(&page_array_[start], 0, (end - start) * sizeof(vm_page));
+        for (size_t i = start; i < end; i++) {
+            auto& p = page_array_[i];
 
-        p.paddr_priv = base() + i * PAGE_SIZE;
-        if (i >= array_start_index && i < array_end_index) {
-            p.state = VM_PAGE_STATE_WIRED;
-        } else {
-            p.state = VM_PAGE_STATE_FREE;
-            list_add_tail(&list, &p.queue_node);
+            p.paddr_priv = base() + i * PAGE_SIZE;
+            if (i >= array_start_index && i < array_end_index) {
+                p.state = VM_PAGE_STATE_WIRED;
+            } else {
+                p.state = VM_PAGE_STATE_FREE;
+                list_add_tail(&list, &p.queue_node);
+            }
         }
     }
+    LTRACEF("%zu pages deferred\n", deferred_pages);
 
     node->AddFreePages(&list);
 
     return ZX_OK;
 }
 
+void PmmArena::block_range(uint level, size_t block, size_t* start, size_t* end) const {
+    const uint order = kSummaryOrder[level];
+    const size_t page_count = size() / PAGE_SIZE;
+    size_t first_pfn = ((first_pfn_ >> order) + block) << order;
+    *start = first_pfn > first_pfn_ ? first_pfn - first_pfn_ : 0;
+    *end = MIN(first_pfn + (1ul << order) - first_pfn_, page_count);
+}
+
+bool PmmArena::large_block_deferred(size_t block) const {
+    DEBUG_ASSERT(block < large_block_count());
+    return atomic_load(&block_deferred_[block]) != 0;
+}
+
+size_t PmmArena::InitDeferredBlock(size_t block, list_node* list) {
+    DEBUG_ASSERT(large_block_deferred(block));
+    size_t start, end;
+    block_range(kSummaryLevels - 1, block, &start, &end);
+
+    // deferred blocks never hold any of the page array, so every page is free
+    memset(&page_array_[start], 0, (end - start) * sizeof(vm_page));
+    for (size_t i = start; i < end; i++) {
+        auto& p = page_array_[i];
+        p.paddr_priv = base() + i * PAGE_SIZE;
+        p.state = VM_PAGE_STATE_FREE;
+        list_add_tail(list, &p.queue_node);
+    }
+    return end - start;
+}
+
+void PmmArena::FinishDeferredBlock(size_t block) {
+    DEBUG_ASSERT(large_block_deferred(block));
+    const uint top = kSummaryLevels - 1;
+    size_t start, end;
+    block_range(top, block, &start, &end);
+
+    // a large block is made of whole smaller blocks, so it can fill in their summaries directly
+    for (uint level = 0; level < kSummaryLevels; level++) {
+        for (size_t b = block_index(level, start); b <= block_index(level, end - 1); b++) {
+            size_t block_start, block_end;
+            block_range(level, b, &block_start, &block_end);
+            DEBUG_ASSERT(block_free_[level][b] == 0);
+            block_free_[level][b] = static_cast<uint32_t>(block_end - block_start);
+        }
+    }
+
+    atomic_store(&block_deferred_[block], 0);
+}
+
 vm_page_t* PmmArena::FindSpecific(paddr_t pa) {
     if (!address_in_arena(pa)) {
         return nullptr;
@@ -91,9 +202,71 @@ vm_page_t* PmmArena::FindSpecific(paddr_t pa) {
 
     DEBUG_ASSERT(index < size() / PAGE_SIZE);
 
+    if (large_block_deferred(block_index(kSummaryLevels - 1, index))) {
+        return nullptr;
+    }
+
     return get_page(index);
 }
 
+constexpr uint PmmArena::kSummaryOrder[];
+
+void PmmArena::AdjustSummaries(const vm_page_t* page, int delta) {
+    DEBUG_ASSERT(page_in_arena(page));
+    size_t i = page - page_array_;
+    for (uint level = 0; level < kSummaryLevels; level++) {
+        uint32_t& count = block_free_[level][block_index(level, i)];
+        DEBUG_ASSERT(delta > 0 || count > 0);
+        count += delta;
+        DEBUG_ASSERT(count <= (1u << kSummaryOrder[level]));
+    }
+}
+
+size_t PmmArena::CountFreeBlocks(uint level) const {
+    DEBUG_ASSERT(level < kSummaryLevels);
+    size_t count = 0;
+    for (size_t b = 0; b < block_count_[level]; b++) {
+        if (block_free_[level][b] == (1u << kSummaryOrder[level])) {
+            count++;
+        }
+    }
+    return count;
+}
+
+size_t PmmArena::SkipToNonFree(size_t i, size_t end) const {
+    DEBUG_ASSERT(end <= size() / PAGE_SIZE);
+
+    while (i < end) {
+        bool skipped = false;
+        // walk down from the largest summary level
+        for (uint level = kSummaryLevels; level-- > 0;) {
+            const size_t block_pages = 1ul << kSummaryOrder[level];
+            const uint32_t free = block_free_[level][block_index(level, i)];
+            if (free == 0) {
+                // nothing in this block is free, report its last page inside the range
+                size_t block_end = ROUNDUP(first_pfn_ + i + 1, block_pages) - first_pfn_;
+                return MIN(block_end, end) - 1;
+            }
+            if (free == block_pages && block_aligned(level, i) && i + block_pages <= end) {
+                // the whole block is free and inside the range
+                i += block_pages;
+                skipped = true;
+                break;
+            }
+        }
+        if (skipped) {
+            continue;
+        }
+
+        if (!page_array_[i].is_free()) {
+            return i;
+        }
+        i++;
+    }
+
+    return end;
+}
+
 vm_page_t* PmmArena::FindFreeContiguous(size_t count, uint8_t alignment_log2) {
     // walk the list starting at alignment boundaries.
     // calculate the starting offset into this arena, based on the
@@ -104,29 +277,26 @@ vm_page_t* PmmArena::FindFreeContiguous(size_t count, uint8_t alignment_log2) {
         return 0;
     }
 
+    const size_t page_count = size() / PAGE_SIZE;
+    const size_t align_pages = 1UL << (alignment_log2 - PAGE_SIZE_SHIFT);
     paddr_t aligned_offset = (rounded_base - base()) / PAGE_SIZE;
     paddr_t start = aligned_offset;
     LTRACEF("starting search at aligned offset %#" PRIxPTR "\n", start);
     LTRACEF("arena base %#" PRIxPTR " size %zu\n", base(), size());
 
-retry:
     // search while we're still within the arena and have a chance of finding a slot
     // (start + count < end of arena)
-    while ((start < size() / PAGE_SIZE) && ((start + count) <= size() / PAGE_SIZE)) {
-        vm_page_t* p = &page_array_[start];
-        for (uint i = 0; i < count; i++) {
-            if (!p->is_free()) {
-                // this run is broken, break out of the inner loop.
-                // start over at the next alignment boundary
-                start = ROUNDUP(start - aligned_offset + i + 1, 1UL << (alignment_log2 - PAGE_SIZE_SHIFT)) +
-                        aligned_offset;
-                goto retry;
-            }
-            p++;
+    while ((start < page_count) && ((start + count) <= page_count)) {
+        size_t non_free = SkipToNonFree(start, start + count);
+        if (non_free != start + count) {
+            // this run is broken, start over at the next alignment boundary past
+            // the last page known not to be free
+            start = ROUNDUP(non_free - aligned_offset + 1, align_pages) + aligned_offset;
+            continue;
         }
 
         // we found a run
-        p = &page_array_[start];
+        vm_page_t* p = &page_array_[start];
         LTRACEF("found run from pa %#" PRIxPTR " to %#" PRIxPTR "\n", p->paddr(), p->paddr() + count * PAGE_SIZE);
 
         return p;
@@ -136,8 +306,16 @@ retry:
 }
 
 void PmmArena::CountStates(size_t state_count[VM_PAGE_STATE_COUNT_]) const {
-    for (size_t i = 0; i < size() / PAGE_SIZE; i++) {
-        state_count[page_array_[i].state]++;
+    // the pages of deferred blocks are not set up yet, leave them out
+    for (size_t b = 0; b < large_block_count(); b++) {
+        if (large_block_deferred(b)) {
+            continue;
+        }
+        size_t start, end;
+        block_range(kSummaryLevels - 1, b, &start, &end);
+        for (size_t i = start; i < end; i++) {
+            state_count[page_array_[i].state]++;
+        }
     }
 }
 
@@ -146,11 +324,26 @@ void PmmArena::Dump(bool dump_pages, bool dump_free_ranges) const {
     printf("  arena %p: name '%s' base %#" PRIxPTR " size %s (0x%zx) priority %u flags 0x%x\n",
            this, name(), base(), format_size(pbuf, sizeof(pbuf), size()), size(), priority(), flags());
     printf("\tpage_array %p\n", page_array_);
+    for (uint level = 0; level < kSummaryLevels; level++) {
+        printf("\tfree %zuKB blocks: %zu\n", (PAGE_SIZE << kSummaryOrder[level]) / 1024,
+               CountFreeBlocks(level));
+    }
+
+    size_t deferred = 0;
+    for (size_t b = 0; b < large_block_count(); b++) {
+        deferred += large_block_deferred(b);
+    }
+    if (deferred) {
+        printf("\tdeferred %zuKB blocks: %zu\n",
+               (PAGE_SIZE << kSummaryOrder[kSummaryLevels - 1]) / 1024, deferred);
+    }
 
     // dump all of the pages
     if (dump_pages) {
         for (size_t i = 0; i < size() / PAGE_SIZE; i++) {
-            page_array_[i].dump();
+            if (!large_block_deferred(block_index(kSummaryLevels - 1, i))) {
+                page_array_[i].dump();
+            }
         }
     }
 
@@ -169,7 +362,8 @@ void PmmArena::Dump(bool dump_pages, bool dump_free_ranges) const {
         printf("\tfree ranges:\n");
         ssize_t last = -1;
         for (size_t i = 0; i < size() / PAGE_SIZE; i++) {
-            if (page_array_[i].is_free()) {
+            if (!large_block_deferred(block_index(kSummaryLevels - 1, i)) &&
+                page_array_[i].is_free()) {
                 if (last == -1) {
                     last = i;
                 }
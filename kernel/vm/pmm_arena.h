@@ -39,9 +39,37 @@ public:
 
     vm_page_t* get_page(size_t index) { return &page_array_[index]; }
 
+    // Deferred initialization. Setting up the page array of a large arena
+    // takes a while, so Init() only sets up the largest summary blocks that
+    // hold the start of the arena, the page array or a boot reserved range,
+    // and leaves the others to be set up later by threads on all cpus.
+    // Until then the pages of a deferred block appear to be absent: they
+    // are not on the free list and FindSpecific() does not return them.
+    size_t large_block_count() const { return block_count_[kSummaryLevels - 1]; }
+    bool large_block_deferred(size_t block) const;
+    // Sets up the pages of deferred block |block| and adds them all to
+    // |list|, returning how many there are. Does not need the node lock, as
+    // nothing else touches the pages of a deferred block.
+    size_t InitDeferredBlock(size_t block, list_node* list);
+    // Called by the owning PmmNode under its lock once it has put the pages
+    // of |block| on its free list, to count them and make them visible.
+    void FinishDeferredBlock(size_t block);
+
     // find a free run of contiguous pages
     vm_page_t* FindFreeContiguous(size_t count, uint8_t alignment_log2);
 
+    // Free run summaries. For every physically aligned block of each summary
+    // order the arena counts how many of its pages are on the node free list,
+    // which lets contiguous searches step over fully allocated blocks and
+    // accept fully free ones without looking at individual pages.
+    // The owning PmmNode calls these under its lock as pages enter and leave
+    // its free list.
+    void NoteFree(const vm_page_t* page) { AdjustSummaries(page, 1); }
+    void NoteAllocated(const vm_page_t* page) { AdjustSummaries(page, -1); }
+
+    // number of completely free blocks of summary level |level|
+    size_t CountFreeBlocks(uint level) const;
+
     // return a pointer to a specific page
     vm_page_t* FindSpecific(paddr_t pa);
 
@@ -54,9 +82,42 @@ public:
         return (address >= info_.base && address <= info_.base + info_.size - 1);
     }
 
+    bool page_in_arena(const vm_page_t* page) const {
+        return page >= page_array_ && page < page_array_ + size() / PAGE_SIZE;
+    }
+
+    // summary levels: 2MB and 1GB blocks with 4K pages
+    static constexpr uint kSummaryLevels = 2;
+    static constexpr uint kSummaryOrder[kSummaryLevels] = {9, 18};
+
     void Dump(bool dump_pages, bool dump_free_ranges) const;
 
 private:
+    void AdjustSummaries(const vm_page_t* page, int delta);
+
+    // index of the summary block of |level| holding page index |i|
+    size_t block_index(uint level, size_t i) const {
+        return ((first_pfn_ + i) >> kSummaryOrder[level]) - (first_pfn_ >> kSummaryOrder[level]);
+    }
+    bool block_aligned(uint level, size_t i) const {
+        return ((first_pfn_ + i) & ((1ul << kSummaryOrder[level]) - 1)) == 0;
+    }
+    // page index range [*start, *end) of the summary block |block| of |level|
+    void block_range(uint level, size_t block, size_t* start, size_t* end) const;
+
+    // returns |end| if every page in [|i|, |end|) is free, and otherwise the index
+    // of a page in [|i|, |end|) that is not free. when a whole summary block is
+    // not free that is its last page below |end|, so callers can skip past it.
+    size_t SkipToNonFree(size_t i, size_t end) const;
+
     pmm_arena_info_t info_ = {};
     vm_page_t* page_array_ = nullptr;
+
+    // physical page number of the first page in the arena
+    size_t first_pfn_ = 0;
+    // per level array of free page counts, one entry per block
+    uint32_t* block_free_[kSummaryLevels] = {};
+    size_t block_count_[kSummaryLevels] = {};
+    // one flag per largest summary block, nonzero while the block is deferred
+    int* block_deferred_ = nullptr;
 };
@@ -5,8 +5,11 @@
 // https://opensource.org/licenses/MIT
 #include "pmm_node.h"
 
+#include <arch/ops.h>
+#include <fbl/algorithm.h>
 #include <inttypes.h>
 #include <kernel/mp.h>
+#include <lib/counters.h>
 #include <trace.h>
 #include <vm/bootalloc.h>
 #include <vm/physmap.h>
@@ -16,6 +19,16 @@
 
 #define LOCAL_TRACE MAX(VM_GLOBAL_TRACE, 0)
 
+KCOUNTER(pmm_cache_alloc_hit, "kernel.pmm.pcpu_cache.alloc_hit");
+KCOUNTER(pmm_cache_alloc_miss, "kernel.pmm.pcpu_cache.alloc_miss");
+KCOUNTER(pmm_cache_free_hit, "kernel.pmm.pcpu_cache.free_hit");
+KCOUNTER(pmm_cache_drain, "kernel.pmm.pcpu_cache.drain");
+KCOUNTER(pmm_zeroed_pages, "kernel.pmm.zero.pages");
+KCOUNTER(pmm_zeroed_alloc, "kernel.pmm.zero.alloc");
+KCOUNTER(pmm_deferred_pages, "kernel.pmm.deferred_init.pages");
+KCOUNTER(pmm_background_free_pages, "kernel.pmm.background_free.pages");
+KCOUNTER(pmm_background_free_reclaimed, "kernel.pmm.background_free.reclaimed");
+
 namespace {
 
 void set_state_alloc(vm_page* page) {
@@ -29,11 +42,217 @@ void set_state_alloc(vm_page* page) {
 } // namespace
 
 PmmNode::PmmNode() {
+    event_init(&zero_event_, false, EVENT_FLAG_AUTOUNSIGNAL);
+    event_init(&zeroing_done_event_, true, 0);
+    event_init(&free_event_, false, EVENT_FLAG_AUTOUNSIGNAL);
 }
 
 PmmNode::~PmmNode() {
 }
 
+PmmArena* PmmNode::ArenaForPage(const vm_page* page) TA_NO_THREAD_SAFETY_ANALYSIS {
+    // the arena list is only modified during early boot
+    for (auto& a : arena_list_) {
+        if (a.page_in_arena(page)) {
+            return &a;
+        }
+    }
+    return nullptr;
+}
+
+void PmmNode::AddToFreeListLocked(vm_page* page, bool head) {
+    if (page->flags & VM_PAGE_FLAG_ZEROED) {
+        list_add_tail(&zeroed_list_, &page->queue_node);
+        zeroed_count_++;
+    } else {
+        if (list_is_empty(&free_list_) && zero_thread_) {
+            event_signal(&zero_event_, false);
+        }
+        if (head) {
+            list_add_head(&free_list_, &page->queue_node);
+        } else {
+            list_add_tail(&free_list_, &page->queue_node);
+        }
+    }
+    free_count_++;
+    ArenaForPage(page)->NoteFree(page);
+}
+
+void PmmNode::RemoveFromFreeListLocked(vm_page* page) {
+    DEBUG_ASSERT(list_in_list(&page->queue_node));
+    DEBUG_ASSERT(free_count_ > 0);
+
+    list_delete(&page->queue_node);
+    free_count_--;
+    if (page->flags & VM_PAGE_FLAG_ZEROED) {
+        DEBUG_ASSERT(zeroed_count_ > 0);
+        zeroed_count_--;
+    }
+    ArenaForPage(page)->NoteAllocated(page);
+}
+
+// Prefers pages that have already been zeroed, since most callers zero what
+// they allocate anyway.
+// Pages still waiting for the background free thread are returned here
+// rather than failing the allocation.
+vm_page* PmmNode::PopFreeListLocked() {
+    vm_page* page = list_peek_head_type(&zeroed_list_, vm_page, queue_node);
+    if (page) {
+        kcounter_add(pmm_zeroed_alloc, 1);
+    } else {
+        page = list_peek_head_type(&free_list_, vm_page, queue_node);
+        if (!page && FreePendingLocked(kFreeBatch) > 0) {
+            kcounter_add(pmm_background_free_reclaimed, 1);
+            page = list_peek_head_type(&free_list_, vm_page, queue_node);
+        }
+    }
+    if (page) {
+        RemoveFromFreeListLocked(page);
+    }
+    return page;
+}
+
+// Clear a batch of pages taken from free_list_ and put them on zeroed_list_.
+// Returns the number of pages zeroed.
+size_t PmmNode::ZeroBatch() {
+    list_node batch = LIST_INITIAL_VALUE(batch);
+    size_t count = 0;
+    {
+        Guard<fbl::Mutex> guard{&lock_};
+        while (count < kZeroBatch) {
+            vm_page* page = list_peek_tail_type(&free_list_, vm_page, queue_node);
+            if (!page) {
+                break;
+            }
+            // Take the page out of circulation while it is being zeroed.
+            // Range and contiguous allocations that need it wait for the
+            // batch to come back, see WaitForZeroingLocked().
+            RemoveFromFreeListLocked(page);
+            page->state = VM_PAGE_STATE_ALLOC;
+            list_add_tail(&batch, &page->queue_node);
+            count++;
+        }
+        if (count == 0) {
+            return 0;
+        }
+        zeroing_count_ = count;
+        event_unsignal(&zeroing_done_event_);
+    }
+
+    // Allocations may be waiting for this batch, so don't let the thread be
+    // preempted with it out; a batch only takes a few microseconds to clear.
+    thread_preempt_disable();
+    vm_page* page;
+    list_for_every_entry (&batch, page, vm_page, queue_node) {
+        arch_zero_page(paddr_to_physmap(page->paddr()));
+    }
+    thread_preempt_reenable();
+
+    Guard<fbl::Mutex> guard{&lock_};
+    while ((page = list_remove_head_type(&batch, vm_page, queue_node)) != nullptr) {
+        page->state = VM_PAGE_STATE_FREE;
+        page->flags |= VM_PAGE_FLAG_ZEROED;
+        AddToFreeListLocked(page, false);
+    }
+    zeroing_count_ = 0;
+    event_signal(&zeroing_done_event_, false);
+    kcounter_add(pmm_zeroed_pages, count);
+    return count;
+}
+
+// Pages out with the zero thread are neither on the free list nor seen as free
+// by the arenas. Wait, with lock_ dropped, until it has returned them, so that
+// searches for specific or contiguous pages see every free page.
+void PmmNode::WaitForZeroingLocked(Guard<fbl::Mutex>* guard) {
+    while (zeroing_count_ > 0) {
+        guard->CallUnlocked([this]() { event_wait(&zeroing_done_event_); });
+    }
+}
+
+int PmmNode::ZeroThreadEntry(void* arg) {
+    return static_cast<PmmNode*>(arg)->ZeroThreadLoop();
+}
+
+int PmmNode::ZeroThreadLoop() {
+    for (;;) {
+        if (ZeroBatch() == 0) {
+            event_wait(&zero_event_);
+        }
+    }
+    return 0;
+}
+
+// Return up to |max| pages from pending_free_ to the free list.
+size_t PmmNode::FreePendingLocked(size_t max) {
+    size_t count = 0;
+    while (count < max) {
+        vm_page* page = list_remove_head_type(&pending_free_, vm_page, queue_node);
+        if (!page) {
+            break;
+        }
+        FreePageLocked(page);
+        count++;
+    }
+    pending_free_count_ -= count;
+    return count;
+}
+
+int PmmNode::FreeThreadEntry(void* arg) {
+    return static_cast<PmmNode*>(arg)->FreeThreadLoop();
+}
+
+int PmmNode::FreeThreadLoop() {
+    for (;;) {
+        size_t count;
+        {
+            Guard<fbl::Mutex> guard{&lock_};
+            count = FreePendingLocked(kFreeBatch);
+        }
+        if (count == 0) {
+            event_wait(&free_event_);
+        }
+    }
+    return 0;
+}
+
+void PmmNode::StartFreeThread() {
+    // Below normal priority, so that it doesn't compete with the work that
+    // follows a large teardown, but above the zero thread, which feeds on
+    // the pages this thread returns.
+    thread_t* t = thread_create("pmm-free", &PmmNode::FreeThreadEntry, this, LOW_PRIORITY);
+    if (!t) {
+        printf("PMM: failed to create free thread\n");
+        return;
+    }
+    {
+        Guard<fbl::Mutex> guard{&lock_};
+        DEBUG_ASSERT(!free_thread_);
+        free_thread_ = t;
+    }
+    thread_detach_and_resume(t);
+}
+
+void PmmNode::StartZeroThread() {
+#if PMM_ENABLE_FREE_FILL
+    // zeroing would destroy the fill pattern that is checked on allocation
+#else
+    DEBUG_ASSERT(!zero_thread_);
+
+    // Runs at the lowest priority, so the memsets only consume otherwise idle
+    // time and show up in traces as this thread rather than as fault latency.
+    thread_t* t = thread_create("pmm-zero", &PmmNode::ZeroThreadEntry, this, LOWEST_PRIORITY);
+    if (!t) {
+        printf("PMM: failed to create zero thread\n");
+        return;
+    }
+    {
+        Guard<fbl::Mutex> guard{&lock_};
+        zero_thread_ = t;
+    }
+    thread_detach_and_resume(t);
+#endif
+}
+
 // We disable thread safety analysis here, since this function is only called
 // during early boot before threading exists.
 zx_status_t PmmNode::AddArena(const pmm_arena_info_t* info) TA_NO_THREAD_SAFETY_ANALYSIS {
@@ -84,23 +303,198 @@ void PmmNode::AddFreePages(list_node* list) TA_NO_THREAD_SAFETY_ANALYSIS {
     vm_page *temp, *page;
     list_for_every_entry_safe (list, page, temp, vm_page, queue_node) {
         list_delete(&page->queue_node);
-        list_add_tail(&free_list_, &page->queue_node);
-        free_count_++;
+        AddToFreeListLocked(page, false);
     }
 
     LTRACEF("free count now %" PRIu64 "\n", free_count_);
 }
 
-zx_status_t PmmNode::AllocPage(uint alloc_flags, vm_page_t** page_out, paddr_t* pa_out) {
+int PmmNode::DeferredInitThreadEntry(void* arg) TA_NO_THREAD_SAFETY_ANALYSIS {
+    auto worker = static_cast<DeferredInitWorker*>(arg);
+    PmmNode* node = worker->node;
+
+    // The arena list does not change after early boot.  Blocks are assigned
+    // by their fixed index rather than by how many are still deferred, which
+    // changes as the other workers finish theirs.
+    size_t n = 0;
+    size_t pages = 0;
+    for (auto& a : node->arena_list_) {
+        for (size_t b = 0; b < a.large_block_count(); b++) {
+            if (n++ % worker->count != worker->index || !a.large_block_deferred(b)) {
+                continue;
+            }
+            list_node list = LIST_INITIAL_VALUE(list);
+            size_t count = a.InitDeferredBlock(b, &list);
+            node->AddDeferredBlock(&a, b, &list, count);
+            pages += count;
+        }
+    }
+    LTRACEF("worker %u added %zu pages\n", worker->index, pages);
+    return 0;
+}
+
+void PmmNode::AddDeferredBlock(PmmArena* arena, size_t block, list_node* list, size_t count) {
     Guard<fbl::Mutex> guard{&lock_};
+    if (list_is_empty(&free_list_) && zero_thread_) {
+        event_signal(&zero_event_, false);
+    }
+    list_splice_after(list, &free_list_);
+    free_count_ += count;
+    arena->FinishDeferredBlock(block);
+    kcounter_add(pmm_deferred_pages, count);
+}
 
-    vm_page* page = list_remove_head_type(&free_list_, vm_page, queue_node);
+void PmmNode::StartDeferredInit() TA_NO_THREAD_SAFETY_ANALYSIS {
+    bool deferred = false;
+    for (auto& a : arena_list_) {
+        for (size_t b = 0; b < a.large_block_count() && !deferred; b++) {
+            deferred = a.large_block_deferred(b);
+        }
+    }
+    if (!deferred) {
+        return;
+    }
+
+    cpu_mask_t online = mp_get_online_mask();
+    uint count = 0;
+    for (cpu_num_t i = 0; i < SMP_MAX_CPUS; i++) {
+        count += (online & cpu_num_to_mask(i)) != 0;
+    }
+
+    uint index = 0;
+    for (cpu_num_t i = 0; i < SMP_MAX_CPUS; i++) {
+        if (!(online & cpu_num_to_mask(i))) {
+            continue;
+        }
+        DeferredInitWorker& worker = deferred_workers_[index];
+        worker = {this, index, count, nullptr};
+        index++;
+
+        char name[ZX_MAX_NAME_LEN];
+        snprintf(name, sizeof(name), "pmm-init-%u", i);
+        thread_t* t = thread_create(name, &PmmNode::DeferredInitThreadEntry, &worker,
+                                    DEFAULT_PRIORITY);
+        if (!t) {
+            // do this worker's share here instead
+            DeferredInitThreadEntry(&worker);
+            continue;
+        }
+        thread_set_cpu_affinity(t, cpu_num_to_mask(i));
+        worker.thread = t;
+        thread_resume(t);
+    }
+}
+
+void PmmNode::WaitDeferredInit() {
+    for (auto& worker : deferred_workers_) {
+        if (worker.thread) {
+            thread_join(worker.thread, nullptr, ZX_TIME_INFINITE);
+            worker.thread = nullptr;
+        }
+    }
+}
+
+// Pop a page off the current cpu's cache, or return nullptr if it is empty.
+vm_page* PmmNode::AllocPageFromCache() {
+    vm_page* page;
+
+    spin_lock_saved_state_t irqstate;
+    arch_interrupt_save(&irqstate, SPIN_LOCK_FLAG_INTERRUPTS);
+    {
+        PcpuCache& cache = pcpu_cache_[arch_curr_cpu_num()];
+        Guard<SpinLock, NoIrqSave> guard{&cache.lock};
+
+        page = list_remove_head_type(&cache.free_list, vm_page, queue_node);
+        if (page) {
+            DEBUG_ASSERT(cache.count > 0);
+            cache.count--;
+        }
+    }
+    arch_interrupt_restore(irqstate, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    if (page) {
+        DEBUG_ASSERT(page->flags & VM_PAGE_FLAG_PCPU_CACHED);
+        page->flags &= ~VM_PAGE_FLAG_PCPU_CACHED;
+    }
+    return page;
+}
+
+// Take a page from the free list and, while holding the lock, move a batch of
+// pages into the current cpu's cache for subsequent allocations.
+vm_page* PmmNode::AllocPageAndRefillCache() {
+    Guard<fbl::Mutex> guard{&lock_};
+
+    vm_page* page = PopFreeListLocked();
     if (!page) {
-        return ZX_ERR_NO_MEMORY;
+        return nullptr;
     }
 
-    DEBUG_ASSERT(free_count_ > 0);
-    free_count_--;
+    list_node batch = LIST_INITIAL_VALUE(batch);
+    size_t batch_count = 0;
+    while (batch_count < kPcpuCacheBatch) {
+        vm_page* p = PopFreeListLocked();
+        if (!p) {
+            break;
+        }
+        DEBUG_ASSERT(p->is_free());
+        p->flags |= VM_PAGE_FLAG_PCPU_CACHED;
+        list_add_tail(&batch, &p->queue_node);
+        batch_count++;
+    }
+
+    if (batch_count > 0) {
+        // we may have migrated while acquiring lock_, so look the cache up again
+        spin_lock_saved_state_t irqstate;
+        arch_interrupt_save(&irqstate, SPIN_LOCK_FLAG_INTERRUPTS);
+        {
+            PcpuCache& cache = pcpu_cache_[arch_curr_cpu_num()];
+            Guard<SpinLock, NoIrqSave> cache_guard{&cache.lock};
+            list_splice_after(&batch, &cache.free_list);
+            cache.count += batch_count;
+        }
+        arch_interrupt_restore(irqstate, SPIN_LOCK_FLAG_INTERRUPTS);
+    }
+
+    return page;
+}
+
+// Put a list of pages that were parked in a cache back on the free list.
+void PmmNode::ReturnBatchLocked(list_node* list) {
+    vm_page* page;
+    while ((page = list_remove_head_type(list, vm_page, queue_node)) != nullptr) {
+        DEBUG_ASSERT(page->state == VM_PAGE_STATE_FREE);
+        DEBUG_ASSERT(page->flags & VM_PAGE_FLAG_PCPU_CACHED);
+        page->flags &= ~VM_PAGE_FLAG_PCPU_CACHED;
+        AddToFreeListLocked(page, true);
+    }
+}
+
+// Empty every cpu's cache into the free list, so that searches over the arenas
+// for specific or contiguous pages can see all free pages.
+void PmmNode::DrainCachesLocked() {
+    for (auto& cache : pcpu_cache_) {
+        list_node batch = LIST_INITIAL_VALUE(batch);
+        {
+            Guard<SpinLock, IrqSave> guard{&cache.lock};
+            list_splice_after(&cache.free_list, &batch);
+            cache.count = 0;
+        }
+        ReturnBatchLocked(&batch);
+    }
+    kcounter_add(pmm_cache_drain, 1);
+}
+
+zx_status_t PmmNode::AllocPage(uint alloc_flags, vm_page_t** page_out, paddr_t* pa_out) {
+    vm_page* page = AllocPageFromCache();
+    if (page) {
+        kcounter_add(pmm_cache_alloc_hit, 1);
+    } else {
+        kcounter_add(pmm_cache_alloc_miss, 1);
+        page = AllocPageAndRefillCache();
+        if (!page) {
+            return ZX_ERR_NO_MEMORY;
+        }
+    }
 
     DEBUG_ASSERT(page->is_free());
 
@@ -136,7 +530,7 @@ zx_status_t PmmNode::AllocPages(size_t count, uint alloc_flags, list_node* list)
     Guard<fbl::Mutex> guard{&lock_};
 
     while (count > 0) {
-        vm_page* page = list_remove_head_type(&free_list_, vm_page, queue_node);
+        vm_page* page = PopFreeListLocked();
         if (unlikely(!page)) {
             // free pages that have already been allocated
             FreeListLocked(list);
@@ -145,10 +539,6 @@ zx_status_t PmmNode::AllocPages(size_t count, uint alloc_flags, list_node* list)
 
         LTRACEF("allocating page %p, pa %#" PRIxPTR "\n", page, page->paddr());
 
-        DEBUG_ASSERT(free_count_ > 0);
-
-        free_count_--;
-
         DEBUG_ASSERT(page->is_free());
 #if PMM_ENABLE_FREE_FILL
         CheckFreeFill(page);
@@ -178,6 +568,12 @@ zx_status_t PmmNode::AllocRange(paddr_t address, size_t count, list_node* list)
 
     Guard<fbl::Mutex> guard{&lock_};
 
+    // pages being zeroed, parked in the per-cpu caches or waiting for the
+    // background free thread are invisible to the search below
+    WaitForZeroingLocked(&guard);
+    DrainCachesLocked();
+    FreePendingLocked(SIZE_MAX);
+
     // walk through the arenas, looking to see if the physical page belongs to it
     for (auto& a : arena_list_) {
         while (allocated < count && a.address_in_arena(address)) {
@@ -190,7 +586,7 @@ zx_status_t PmmNode::AllocRange(paddr_t address, size_t count, list_node* list)
                 break;
             }
 
-            list_delete(&page->queue_node);
+            RemoveFromFreeListLocked(page);
 
             page->state = VM_PAGE_STATE_ALLOC;
 
@@ -198,7 +594,6 @@ zx_status_t PmmNode::AllocRange(paddr_t address, size_t count, list_node* list)
 
             allocated++;
             address += PAGE_SIZE;
-            free_count_--;
         }
 
         if (allocated == count) {
@@ -215,23 +610,8 @@ zx_status_t PmmNode::AllocRange(paddr_t address, size_t count, list_node* list)
     return ZX_OK;
 }
 
-zx_status_t PmmNode::AllocContiguous(const size_t count, uint alloc_flags, uint8_t alignment_log2,
-                                     paddr_t* pa, list_node* list) {
-    LTRACEF("count %zu, align %u\n", count, alignment_log2);
-
-    if (count == 0) {
-        return ZX_OK;
-    }
-    if (alignment_log2 < PAGE_SIZE_SHIFT) {
-        alignment_log2 = PAGE_SIZE_SHIFT;
-    }
-
-    // pa and list must be valid pointers
-    DEBUG_ASSERT(pa);
-    DEBUG_ASSERT(list);
-
-    Guard<fbl::Mutex> guard{&lock_};
-
+zx_status_t PmmNode::AllocContiguousLocked(const size_t count, uint8_t alignment_log2,
+                                           paddr_t* pa, list_node* list) {
     for (auto& a : arena_list_) {
         vm_page_t* p = a.FindFreeContiguous(count, alignment_log2);
         if (!p) {
@@ -243,15 +623,10 @@ zx_status_t PmmNode::AllocContiguous(const size_t count, uint alloc_flags, uint8
         // remove the pages from the run out of the free list
         for (size_t i = 0; i < count; i++, p++) {
             DEBUG_ASSERT_MSG(p->is_free(), "p %p state %u\n", p, p->state);
-            DEBUG_ASSERT(list_in_list(&p->queue_node));
 
-            list_delete(&p->queue_node);
+            RemoveFromFreeListLocked(p);
             p->state = VM_PAGE_STATE_ALLOC;
 
-            DEBUG_ASSERT(free_count_ > 0);
-
-            free_count_--;
-
 #if PMM_ENABLE_FREE_FILL
             CheckFreeFill(p);
 #endif
@@ -262,6 +637,47 @@ zx_status_t PmmNode::AllocContiguous(const size_t count, uint alloc_flags, uint8
         return ZX_OK;
     }
 
+    return ZX_ERR_NOT_FOUND;
+}
+
+zx_status_t PmmNode::AllocContiguous(const size_t count, uint alloc_flags, uint8_t alignment_log2,
+                                     paddr_t* pa, list_node* list) {
+    LTRACEF("count %zu, align %u\n", count, alignment_log2);
+
+    if (count == 0) {
+        return ZX_OK;
+    }
+    if (alignment_log2 < PAGE_SIZE_SHIFT) {
+        alignment_log2 = PAGE_SIZE_SHIFT;
+    }
+
+    // pa and list must be valid pointers
+    DEBUG_ASSERT(pa);
+    DEBUG_ASSERT(list);
+
+    Guard<fbl::Mutex> guard{&lock_};
+
+    if (AllocContiguousLocked(count, alignment_log2, pa, list) == ZX_OK) {
+        return ZX_OK;
+    }
+
+    // pages being zeroed or parked in the per-cpu caches were excluded from
+    // the search, pull them back to the free list and try once more
+    WaitForZeroingLocked(&guard);
+    DrainCachesLocked();
+    if (AllocContiguousLocked(count, alignment_log2, pa, list) == ZX_OK) {
+        return ZX_OK;
+    }
+
+    // the same goes for pages still waiting for the background free thread
+    if (pending_free_count_ > 0) {
+        FreePendingLocked(SIZE_MAX);
+        kcounter_add(pmm_background_free_reclaimed, 1);
+        if (AllocContiguousLocked(count, alignment_log2, pa, list) == ZX_OK) {
+            return ZX_OK;
+        }
+    }
+
     LTRACEF("couldn't find run\n");
     return ZX_ERR_NOT_FOUND;
 }
@@ -281,19 +697,63 @@ void PmmNode::FreePageLocked(vm_page* page) {
         list_delete(&page->queue_node);
     }
 
-    // mark it free
+    // mark it free, its contents are no longer known
     page->state = VM_PAGE_STATE_FREE;
+    page->flags &= ~VM_PAGE_FLAG_ZEROED;
 
     // add it to the free queue
-    list_add_head(&free_list_, &page->queue_node);
-
-    free_count_++;
+    AddToFreeListLocked(page, true);
 }
 
 void PmmNode::FreePage(vm_page* page) {
-    Guard<fbl::Mutex> guard{&lock_};
+    // pages still linked into a queue take the slow path
+    if (list_in_list(&page->queue_node)) {
+        Guard<fbl::Mutex> guard{&lock_};
+        FreePageLocked(page);
+        return;
+    }
+
+    LTRACEF("page %p state %u paddr %#" PRIxPTR "\n", page, page->state, page->paddr());
+
+    DEBUG_ASSERT(page->state != VM_PAGE_STATE_OBJECT || page->object.pin_count == 0);
+    DEBUG_ASSERT(page->state != VM_PAGE_STATE_FREE);
 
-    FreePageLocked(page);
+#if PMM_ENABLE_FREE_FILL
+    FreeFill(page);
+#endif
+
+    page->state = VM_PAGE_STATE_FREE;
+    page->flags = (page->flags & ~VM_PAGE_FLAG_ZEROED) | VM_PAGE_FLAG_PCPU_CACHED;
+
+    // park the page in the current cpu's cache, trimming a batch off the cold
+    // end if the cache has grown too large
+    list_node overflow = LIST_INITIAL_VALUE(overflow);
+    spin_lock_saved_state_t irqstate;
+    arch_interrupt_save(&irqstate, SPIN_LOCK_FLAG_INTERRUPTS);
+    {
+        PcpuCache& cache = pcpu_cache_[arch_curr_cpu_num()];
+        Guard<SpinLock, NoIrqSave> guard{&cache.lock};
+
+        list_add_head(&cache.free_list, &page->queue_node);
+        cache.count++;
+
+        if (cache.count > kPcpuCacheMax) {
+            for (size_t i = 0; i < kPcpuCacheBatch; i++) {
+                vm_page* p = list_remove_tail_type(&cache.free_list, vm_page, queue_node);
+                list_add_head(&overflow, &p->queue_node);
+            }
+            cache.count -= kPcpuCacheBatch;
+        }
+    }
+    arch_interrupt_restore(irqstate, SPIN_LOCK_FLAG_INTERRUPTS);
+
+    if (list_is_empty(&overflow)) {
+        kcounter_add(pmm_cache_free_hit, 1);
+        return;
+    }
+
+    Guard<fbl::Mutex> guard{&lock_};
+    ReturnBatchLocked(&overflow);
 }
 
 void PmmNode::FreeListLocked(list_node* list) {
@@ -312,9 +772,31 @@ void PmmNode::FreeList(list_node* list) {
     FreeListLocked(list);
 }
 
+void PmmNode::FreeListBackground(list_node* list) {
+    DEBUG_ASSERT(list);
+
+    size_t count = list_length(list);
+
+    Guard<fbl::Mutex> guard{&lock_};
+
+    if (!free_thread_ || count < kBackgroundFreeMin) {
+        FreeListLocked(list);
+        return;
+    }
+
+    list_splice_after(list, &pending_free_);
+    pending_free_count_ += count;
+    kcounter_add(pmm_background_free_pages, count);
+    event_signal(&free_event_, false);
+}
+
 // okay if accessed outside of a lock
 uint64_t PmmNode::CountFreePages() const TA_NO_THREAD_SAFETY_ANALYSIS {
-    return free_count_;
+    uint64_t count = free_count_ + pending_free_count_;
+    for (const auto& cache : pcpu_cache_) {
+        count += cache.count;
+    }
+    return count;
 }
 
 uint64_t PmmNode::CountTotalBytes() const TA_NO_THREAD_SAFETY_ANALYSIS {
@@ -338,8 +820,14 @@ void PmmNode::DumpFree() const TA_NO_THREAD_SAFETY_ANALYSIS {
 void PmmNode::Dump(bool is_panic) const {
     // No lock analysis here, as we want to just go for it in the panic case without the lock.
     auto dump = [this]() TA_NO_THREAD_SAFETY_ANALYSIS {
-        printf("pmm node %p: free_count %zu (%zu bytes), total size %zu\n",
-               this, free_count_, free_count_ * PAGE_SIZE, arena_cumulative_size_);
+        printf("pmm node %p: free_count %zu (%zu bytes), zeroed %zu, total size %zu\n",
+               this, free_count_, free_count_ * PAGE_SIZE, zeroed_count_,
+               arena_cumulative_size_);
+        for (size_t i = 0; i < fbl::count_of(pcpu_cache_); i++) {
+            if (pcpu_cache_[i].count > 0) {
+                printf("\tcpu %zu cache: %zu free pages\n", i, pcpu_cache_[i].count);
+            }
+        }
         for (auto& a : arena_list_) {
             a.Dump(false, false);
         }
@@ -355,8 +843,12 @@ void PmmNode::Dump(bool is_panic) const {
 
 #if PMM_ENABLE_FREE_FILL
 void PmmNode::EnforceFill() {
+    Guard<fbl::Mutex> guard{&lock_};
+
     DEBUG_ASSERT(!enforce_fill_);
 
+    DrainCachesLocked();
+
     vm_page* page;
     list_for_every_entry (&free_list_, page, vm_page, queue_node) {
         FreeFill(page);
@@ -9,7 +9,11 @@
 #include <fbl/intrusive_double_list.h>
 #include <fbl/mutex.h>
 
+#include <kernel/align.h>
+#include <kernel/event.h>
 #include <kernel/lockdep.h>
+#include <kernel/spinlock.h>
+#include <kernel/thread.h>
 #include <vm/pmm.h>
 
 #include "pmm_arena.h"
@@ -35,6 +39,9 @@ public:
     zx_status_t AllocContiguous(size_t count, uint alloc_flags, uint8_t alignment_log2, paddr_t* pa, list_node* list);
     void FreePage(vm_page* page);
     void FreeList(list_node* list);
+    // Hands large lists to the background free thread, if it runs, instead
+    // of returning them to the free list on the calling cpu.
+    void FreeListBackground(list_node* list);
 
     uint64_t CountFreePages() const;
     uint64_t CountTotalBytes() const;
@@ -47,7 +54,7 @@ public:
     void Dump(bool is_panic) const TA_NO_THREAD_SAFETY_ANALYSIS;
 
 #if PMM_ENABLE_FREE_FILL
-    void EnforceFill() TA_NO_THREAD_SAFETY_ANALYSIS;
+    void EnforceFill() TA_EXCL(lock_);
 #endif
 
     zx_status_t AddArena(const pmm_arena_info_t* info);
@@ -55,9 +62,50 @@ public:
     // add new pages to the free queue. used when boostrapping a PmmArena
     void AddFreePages(list_node* list);
 
+    // start the low priority thread that zeroes free pages in the background
+    void StartZeroThread();
+
+    // start the thread that returns pages handed to FreeListBackground()
+    void StartFreeThread();
+
+    // Set up the arena blocks that AddArena() deferred, on one thread per
+    // online cpu. Each block's pages join the free list as soon as it is
+    // done; WaitDeferredInit() blocks until all of them have.
+    void StartDeferredInit();
+    void WaitDeferredInit();
+
 private:
     void FreePageLocked(vm_page* page) TA_REQ(lock_);
     void FreeListLocked(list_node* list) TA_REQ(lock_);
+    zx_status_t AllocContiguousLocked(size_t count, uint8_t alignment_log2, paddr_t* pa,
+                                      list_node* list) TA_REQ(lock_);
+
+    // free list maintenance, keeps free_count_ and the arena summaries in sync
+    PmmArena* ArenaForPage(const vm_page* page);
+    void AddToFreeListLocked(vm_page* page, bool head) TA_REQ(lock_);
+    void RemoveFromFreeListLocked(vm_page* page) TA_REQ(lock_);
+    vm_page* PopFreeListLocked() TA_REQ(lock_);
+
+    // deferred arena initialization
+    static int DeferredInitThreadEntry(void* arg);
+    void AddDeferredBlock(PmmArena* arena, size_t block, list_node* list, size_t count);
+
+    // background zeroing
+    static int ZeroThreadEntry(void* arg);
+    int ZeroThreadLoop();
+    size_t ZeroBatch();
+    void WaitForZeroingLocked(Guard<fbl::Mutex>* guard) TA_REQ(lock_);
+
+    // background freeing
+    static int FreeThreadEntry(void* arg);
+    int FreeThreadLoop();
+    size_t FreePendingLocked(size_t max) TA_REQ(lock_);
+
+    // per-cpu page cache helpers
+    vm_page* AllocPageFromCache();
+    vm_page* AllocPageAndRefillCache() TA_EXCL(lock_);
+    void ReturnBatchLocked(list_node* list) TA_REQ(lock_);
+    void DrainCachesLocked() TA_REQ(lock_);
 
     fbl::Canary<fbl::magic("PNOD")> canary_;
 
@@ -65,15 +113,70 @@ private:
 
     uint64_t arena_cumulative_size_ TA_GUARDED(lock_) = 0;
     uint64_t free_count_ TA_GUARDED(lock_) = 0;
+    uint64_t zeroed_count_ TA_GUARDED(lock_) = 0;
+    uint64_t pending_free_count_ TA_GUARDED(lock_) = 0;
 
     fbl::DoublyLinkedList<PmmArena*> arena_list_ TA_GUARDED(lock_);
 
     // page queues
+    // Free pages live on free_list_ until the zero thread has cleared them,
+    // then move to zeroed_list_, which allocations are served from first.
     list_node free_list_ TA_GUARDED(lock_) = LIST_INITIAL_VALUE(free_list_);
-    list_node inactive_list_ TA_GUARDED(lock_) = LIST_INITIAL_VALUE(inactive_list_);
-    list_node active_list_ TA_GUARDED(lock_) = LIST_INITIAL_VALUE(active_list_);
-    list_node modified_list_ TA_GUARDED(lock_) = LIST_INITIAL_VALUE(modified_list_);
+    list_node zeroed_list_ TA_GUARDED(lock_) = LIST_INITIAL_VALUE(zeroed_list_);
     list_node wired_list_ TA_GUARDED(lock_) = LIST_INITIAL_VALUE(wired_list_);
+    // Pages handed to FreeListBackground() that the free thread has not yet
+    // returned. They still count as free, and allocations that would fail
+    // otherwise return some of them on the spot.
+    list_node pending_free_ TA_GUARDED(lock_) = LIST_INITIAL_VALUE(pending_free_);
+
+    // Each cpu keeps a small magazine of free pages so that single page
+    // allocations and frees do not need lock_. Magazines are refilled from and
+    // drained to free_list_ kPcpuCacheBatch pages at a time. A cache lock is
+    // only ever contended by a drain from another cpu, and may be acquired
+    // while holding lock_ but never the other way around.
+    static constexpr size_t kPcpuCacheBatch = 32;
+    static constexpr size_t kPcpuCacheMax = 2 * kPcpuCacheBatch;
+
+    struct PcpuCache {
+        DECLARE_SPINLOCK(PcpuCache) lock;
+        list_node free_list TA_GUARDED(lock) = LIST_INITIAL_VALUE(free_list);
+        size_t count TA_GUARDED(lock) = 0;
+    } __CPU_ALIGN;
+
+    PcpuCache pcpu_cache_[SMP_MAX_CPUS];
+
+    // Pages are pulled off free_list_ and zeroed outside of lock_ this many
+    // at a time, to keep lock hold times short.
+    static constexpr size_t kZeroBatch = 16;
+
+    thread_t* zero_thread_ = nullptr;
+    // signaled when free_list_ goes from empty to non-empty
+    event_t zero_event_;
+    // number of pages the zero thread has taken off free_list_ and not yet
+    // returned; zeroing_done_event_ is signaled whenever it is 0
+    size_t zeroing_count_ TA_GUARDED(lock_) = 0;
+    event_t zeroing_done_event_;
+
+    // Lists shorter than this are cheap enough to free on the calling cpu,
+    // and the free thread returns pages this many at a time between drops of
+    // lock_.
+    static constexpr size_t kBackgroundFreeMin = 64;
+    static constexpr size_t kFreeBatch = 256;
+
+    thread_t* free_thread_ TA_GUARDED(lock_) = nullptr;
+    // signaled when pages are added to pending_free_
+    event_t free_event_;
+
+    // Worker |index| of |count| sets up the deferred blocks whose index,
+    // counting every large block across all arenas, is |index| modulo
+    // |count|, so no two workers ever pick the same block.
+    struct DeferredInitWorker {
+        PmmNode* node;
+        uint index;
+        uint count;
+        thread_t* thread;
+    };
+    DeferredInitWorker deferred_workers_[SMP_MAX_CPUS] = {};
 
 #if PMM_ENABLE_FREE_FILL
     void FreeFill(vm_page_t* page);
@@ -84,12 +187,12 @@ private:
 };
 
 // We don't need to hold the arena lock while executing this, since it is
-// only accesses values that are set once during system initialization.
+// only accesses values that are set once during system initialization, and
+// the deferred block flags, which are read atomically.
 inline vm_page_t* PmmNode::PaddrToPage(paddr_t addr) TA_NO_THREAD_SAFETY_ANALYSIS {
     for (auto& a : arena_list_) {
         if (a.address_in_arena(addr)) {
-            size_t index = (addr - a.base()) / PAGE_SIZE;
-            return a.get_page(index);
+            return a.FindSpecific(addr);
         }
     }
     return nullptr;
@@ -0,0 +1,93 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <vm/reclaim.h>
+
+#include <kernel/cmdline.h>
+#include <kernel/thread.h>
+#include <lib/counters.h>
+#include <lk/init.h>
+#include <trace.h>
+#include <vm/page.h>
+#include <vm/vm_object.h>
+#include <zircon/time.h>
+#include <zircon/types.h>
+
+#include "vm_priv.h"
+
+#define LOCAL_TRACE MAX(VM_GLOBAL_TRACE, 0)
+
+KCOUNTER(vm_reclaim_scans, "kernel.vm.reclaim.scans");
+KCOUNTER(vm_reclaim_requests, "kernel.vm.reclaim.requests");
+KCOUNTER(vm_reclaim_pages_freed, "kernel.vm.reclaim.pages");
+
+namespace {
+
+bool reclaim_enabled = false;
+
+// Pages must go this many scans without being accessed before they are
+// evicted, unless memory is short enough that younger ones are needed too.
+uint32_t reclaim_min_age = 2;
+
+zx_duration_t reclaim_scan_period = ZX_SEC(5);
+
+// The aging thread periodically walks every VMO, bumping the age of its pages
+// and resetting the ones the hardware saw accessed.
+int reclaim_thread_entry(void* arg) {
+    for (;;) {
+        thread_sleep_relative(reclaim_scan_period);
+        VmObject::AgeAllPages();
+        kcounter_add(vm_reclaim_scans, 1);
+    }
+    return 0;
+}
+
+void reclaim_init(uint level) {
+    if (!cmdline_get_bool("kernel.vm.reclaim.enable", true)) {
+        return;
+    }
+
+    reclaim_min_age = cmdline_get_uint32("kernel.vm.reclaim.min-age", reclaim_min_age);
+    if (reclaim_min_age < 1) {
+        reclaim_min_age = 1;
+    } else if (reclaim_min_age > VM_PAGE_OBJECT_MAX_AGE) {
+        reclaim_min_age = VM_PAGE_OBJECT_MAX_AGE;
+    }
+
+    reclaim_scan_period = ZX_SEC(cmdline_get_uint32("kernel.vm.reclaim.scan-sec", 5));
+    if (reclaim_scan_period <= 0) {
+        return;
+    }
+    reclaim_enabled = true;
+
+    thread_t* t = thread_create("vm-reclaim", reclaim_thread_entry, nullptr, LOW_PRIORITY);
+    if (t) {
+        thread_detach_and_resume(t);
+    }
+}
+
+} // namespace
+
+size_t vm_reclaim_pages(size_t target_pages) {
+    if (!reclaim_enabled) {
+        return 0;
+    }
+    kcounter_add(vm_reclaim_requests, 1);
+
+    // Take pages that have been idle for a while first, and only dip into
+    // younger ones if that wasn't enough. Pages accessed since the last scan
+    // are never evicted.
+    size_t reclaimed = VmObject::ReclaimAllPages(reclaim_min_age, target_pages);
+    if (reclaimed < target_pages && reclaim_min_age > 1) {
+        reclaimed += VmObject::ReclaimAllPages(1, target_pages - reclaimed);
+    }
+
+    LTRACEF("reclaimed %zu of %zu pages\n", reclaimed, target_pages);
+    kcounter_add(vm_reclaim_pages_freed, reclaimed);
+    return reclaimed;
+}
+
+LK_INIT_HOOK(vm_reclaim, &reclaim_init, LK_INIT_LEVEL_THREADING);
@@ -13,7 +13,8 @@ MODULE_DEPS += \
     kernel/lib/fbl \
     kernel/lib/pretty \
     kernel/lib/user_copy \
-    third_party/lib/cryptolib
+    third_party/lib/cryptolib \
+    third_party/lib/lz4
 
 MODULE_SRCS += \
     $(LOCAL_DIR)/bootalloc.cpp \
@@ -24,10 +25,12 @@ MODULE_SRCS += \
     $(LOCAL_DIR)/pmm.cpp \
     $(LOCAL_DIR)/pmm_arena.cpp \
     $(LOCAL_DIR)/pmm_node.cpp \
+    $(LOCAL_DIR)/reclaim.cpp \
     $(LOCAL_DIR)/vm.cpp \
     $(LOCAL_DIR)/vm_address_region.cpp \
     $(LOCAL_DIR)/vm_address_region_or_mapping.cpp \
     $(LOCAL_DIR)/vm_aspace.cpp \
+    $(LOCAL_DIR)/vm_compressed_page.cpp \
     $(LOCAL_DIR)/vm_mapping.cpp \
     $(LOCAL_DIR)/vm_object.cpp \
     $(LOCAL_DIR)/vm_object_paged.cpp \
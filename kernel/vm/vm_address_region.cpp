@@ -21,6 +21,25 @@
 
 #define LOCAL_TRACE MAX(VM_GLOBAL_TRACE, 0)
 
+namespace {
+
+// Keeps a TLB batch open on an arch aspace for the lifetime of the object.
+class TlbBatch {
+public:
+    explicit TlbBatch(ArchVmAspace* arch_aspace)
+        : arch_aspace_(arch_aspace) {
+        arch_aspace_->StartTlbBatch();
+    }
+    ~TlbBatch() { arch_aspace_->FinishTlbBatch(); }
+
+private:
+    DISALLOW_COPY_ASSIGN_AND_MOVE(TlbBatch);
+
+    ArchVmAspace* const arch_aspace_;
+};
+
+} // namespace {}
+
 VmAddressRegion::VmAddressRegion(VmAspace& aspace, vaddr_t base, size_t size, uint32_t vmar_flags)
     : VmAddressRegionOrMapping(base, size, vmar_flags | VMAR_CAN_RWX_FLAGS,
                                &aspace, nullptr) {
@@ -218,7 +237,8 @@ zx_status_t VmAddressRegion::CreateVmMapping(size_t mapping_offset, size_t size,
     LTRACEF("%p %#zx %#zx %x\n", this, mapping_offset, size, vmar_flags);
 
     // Check that only allowed flags have been set
-    if (vmar_flags & ~(VMAR_FLAG_SPECIFIC | VMAR_FLAG_SPECIFIC_OVERWRITE | VMAR_CAN_RWX_FLAGS)) {
+    if (vmar_flags & ~(VMAR_FLAG_SPECIFIC | VMAR_FLAG_SPECIFIC_OVERWRITE |
+                       VMAR_FLAG_NO_FAULT_AROUND | VMAR_CAN_RWX_FLAGS)) {
         return ZX_ERR_INVALID_ARGS;
     }
 
@@ -250,9 +270,20 @@ zx_status_t VmAddressRegion::CreateVmMapping(size_t mapping_offset, size_t size,
     }
 
     fbl::RefPtr<VmAddressRegionOrMapping> res;
-    zx_status_t status =
-        CreateSubVmarInternal(mapping_offset, size, align_pow2, vmar_flags, fbl::move(vmo),
-                              vmo_offset, arch_mmu_flags, name, &res);
+    zx_status_t status = ZX_ERR_NO_MEMORY;
+    // Place big mappings so that large page aligned blocks of the vmo land
+    // on large page aligned addresses, letting the arch layer map them with
+    // large pages once they are backed contiguously.
+    const bool is_specific = vmar_flags & (VMAR_FLAG_SPECIFIC | VMAR_FLAG_SPECIFIC_OVERWRITE);
+    if (!is_specific && align_pow2 < LARGE_PAGE_SIZE_SHIFT && size >= LARGE_PAGE_SIZE &&
+        IS_ALIGNED(vmo_offset, LARGE_PAGE_SIZE)) {
+        status = CreateSubVmarInternal(mapping_offset, size, LARGE_PAGE_SIZE_SHIFT, vmar_flags,
+                                       vmo, vmo_offset, arch_mmu_flags, name, &res);
+    }
+    if (status == ZX_ERR_NO_MEMORY) {
+        status = CreateSubVmarInternal(mapping_offset, size, align_pow2, vmar_flags,
+                                       fbl::move(vmo), vmo_offset, arch_mmu_flags, name, &res);
+    }
     if (status != ZX_OK) {
         return status;
     }
@@ -280,6 +311,7 @@ zx_status_t VmAddressRegion::OverwriteVmMapping(
         return ZX_ERR_NO_MEMORY;
     }
 
+    aspace_->WaitForFaultsLocked();
     zx_status_t status = UnmapInternalLocked(base, size, false /* can_destroy_regions */,
                                              false /* allow_partial_vmar */);
     if (status != ZX_OK) {
@@ -296,6 +328,8 @@ zx_status_t VmAddressRegion::DestroyLocked() {
     DEBUG_ASSERT(aspace_->lock()->lock().IsHeld());
     LTRACEF("%p '%s'\n", this, name_);
 
+    UnmapPagesBatchedLocked(base_, size_);
+
     // The cur reference prevents regions from being destructed after dropping
     // the last reference to them when removing from their parent.
     fbl::RefPtr<VmAddressRegion> cur(this);
@@ -382,15 +416,26 @@ zx_status_t VmAddressRegion::PageFault(vaddr_t va, uint pf_flags) {
     canary_.Assert();
     DEBUG_ASSERT(aspace_->lock()->lock().IsHeld());
 
+    fbl::RefPtr<VmMapping> mapping = FindMappingLocked(va);
+    if (!mapping) {
+        return ZX_ERR_NOT_FOUND;
+    }
+    return mapping->PageFault(va, pf_flags);
+}
+
+fbl::RefPtr<VmMapping> VmAddressRegion::FindMappingLocked(vaddr_t va) {
+    canary_.Assert();
+    DEBUG_ASSERT(aspace_->lock()->lock().IsHeld());
+
     auto vmar = WrapRefPtr(this);
     while (auto next = vmar->FindRegionLocked(va)) {
         if (next->is_mapping()) {
-            return next->PageFault(va, pf_flags);
+            return next->as_vm_mapping();
         }
         vmar = next->as_vm_address_region();
     }
 
-    return ZX_ERR_NOT_FOUND;
+    return nullptr;
 }
 
 bool VmAddressRegion::IsRangeAvailableLocked(vaddr_t base, size_t size) {
@@ -616,6 +661,7 @@ zx_status_t VmAddressRegion::Unmap(vaddr_t base, size_t size) {
     }
 
     Guard<fbl::Mutex> guard{aspace_->lock()};
+    aspace_->WaitForFaultsLocked();
     if (state_ != LifeCycleState::ALIVE) {
         return ZX_ERR_BAD_STATE;
     }
@@ -633,6 +679,7 @@ zx_status_t VmAddressRegion::UnmapAllowPartial(vaddr_t base, size_t size) {
     }
 
     Guard<fbl::Mutex> guard{aspace_->lock()};
+    aspace_->WaitForFaultsLocked();
     if (state_ != LifeCycleState::ALIVE) {
         return ZX_ERR_BAD_STATE;
     }
@@ -654,6 +701,45 @@ VmAddressRegion::ChildList::iterator VmAddressRegion::UpperBoundInternalLocked(v
     return itr;
 }
 
+void VmAddressRegion::UnmapPagesBatchedLocked(vaddr_t base, size_t size) {
+    DEBUG_ASSERT(aspace_->lock()->lock().IsHeld());
+
+    // Every mapping stays attached to its VMO until we return, so its pages
+    // cannot be freed before the batch has invalidated them.
+    TlbBatch batch(&aspace_->arch_aspace());
+
+    const vaddr_t end_addr = base + size;
+    VmAddressRegion* cur = this;
+    auto itr = UpperBoundInternalLocked(base);
+    for (;;) {
+        if (!itr.IsValid() || itr->base() >= end_addr) {
+            if (cur == this) {
+                break;
+            }
+            // Done with this subregion, continue after it in its parent.
+            VmAddressRegion* up = cur->parent_;
+            itr = up->subregions_.upper_bound(cur->base());
+            cur = up;
+            continue;
+        }
+
+        if (!itr->is_mapping()) {
+            cur = itr->as_vm_address_region().get();
+            itr = cur->UpperBoundInternalLocked(base);
+            continue;
+        }
+
+        fbl::RefPtr<VmMapping> mapping = itr->as_vm_mapping();
+        vaddr_t unmap_base = 0;
+        size_t unmap_size = 0;
+        if (mapping != aspace_->vdso_code_mapping_ &&
+            GetIntersect(base, size, mapping->base(), mapping->size(), &unmap_base, &unmap_size)) {
+            aspace_->arch_aspace().Unmap(unmap_base, unmap_size / PAGE_SIZE, nullptr);
+        }
+        ++itr;
+    }
+}
+
 zx_status_t VmAddressRegion::UnmapInternalLocked(vaddr_t base, size_t size,
                                                  bool can_destroy_regions,
                                                  bool allow_partial_vmar) {
@@ -690,6 +776,8 @@ zx_status_t VmAddressRegion::UnmapInternalLocked(vaddr_t base, size_t size,
         }
     }
 
+    UnmapPagesBatchedLocked(base, size);
+
     bool at_top = true;
     for (auto itr = begin; itr != end;) {
         // Create a copy of the iterator, in case we destroy this element
@@ -776,6 +864,7 @@ zx_status_t VmAddressRegion::Protect(vaddr_t base, size_t size, uint new_arch_mm
     }
 
     Guard<fbl::Mutex> guard{aspace_->lock()};
+    aspace_->WaitForFaultsLocked();
     if (state_ != LifeCycleState::ALIVE) {
         return ZX_ERR_BAD_STATE;
     }
@@ -822,6 +911,7 @@ zx_status_t VmAddressRegion::Protect(vaddr_t base, size_t size, uint new_arch_mm
         return ZX_ERR_NOT_FOUND;
     }
 
+    TlbBatch batch(&aspace_->arch_aspace());
     for (auto itr = begin; itr != end;) {
         DEBUG_ASSERT(itr->is_mapping());
 
@@ -860,41 +950,97 @@ zx_status_t VmAddressRegion::LinearRegionAllocatorLocked(size_t size, uint8_t al
 
     // Find the first gap in the address space which can contain a region of the
     // requested size.
-    auto before_iter = subregions_.end();
-    auto after_iter = subregions_.begin();
+    zx_status_t status = ZX_ERR_NO_MEMORY;
+    ForEachGap([this, base, align, size, arch_mmu_flags, spot, &status](vaddr_t gap_base,
+                                                                      size_t gap_len) -> bool {
+        if (gap_len < size) {
+            return true;
+        }
+
+        auto after_iter = subregions_.upper_bound(gap_base);
+        auto before_iter = after_iter;
+        if (after_iter == subregions_.begin()) {
+            before_iter = subregions_.end();
+        } else {
+            --before_iter;
+        }
 
-    do {
         if (CheckGapLocked(before_iter, after_iter, spot, base, align, size, 0, arch_mmu_flags)) {
             if (*spot != static_cast<vaddr_t>(-1)) {
-                return ZX_OK;
-            } else {
-                return ZX_ERR_NO_MEMORY;
+                status = ZX_OK;
             }
+            return false;
         }
+        return true;
+    },
+               align_pow2, size);
 
-        before_iter = after_iter++;
-    } while (before_iter.IsValid());
-
-    // couldn't find anything
-    return ZX_ERR_NO_MEMORY;
+    return status;
 }
 
 template <typename F>
-void VmAddressRegion::ForEachGap(F func, uint8_t align_pow2) {
+void VmAddressRegion::ForEachGap(F func, uint8_t align_pow2, size_t min_gap) {
     const vaddr_t align = 1UL << align_pow2;
 
-    // Scan the regions list to find the gap to the left of each region.  We
+    // Walk the regions in order to find the gap to the left of each region.  We
     // round up the end of the previous region to the requested alignment, so
     // all gaps reported will be for aligned ranges.
     vaddr_t prev_region_end = ROUNDUP(base_, align);
-    for (const auto& region : subregions_) {
+    auto visit = [&func, align, &prev_region_end](const VmAddressRegionOrMapping& region) -> bool {
         if (region.base() > prev_region_end) {
             const size_t gap = region.base() - prev_region_end;
             if (!func(prev_region_end, gap)) {
-                return;
+                return false;
             }
         }
         prev_region_end = ROUNDUP(region.base() + region.size(), align);
+        return true;
+    };
+
+    // The walk goes down the tree rather than along the list, so that whole
+    // subtrees that have no gap of at least min_gap, either between their
+    // regions or before their first one, can be stepped over using the
+    // summaries kept by WAVLTreeObserver.  |node| is always the root of a
+    // subtree none of whose regions have been visited.
+    auto node = subregions_.root();
+    while (node.IsValid()) {
+        const size_t leading_gap = (node->subtree_base_ > prev_region_end)
+                                       ? node->subtree_base_ - prev_region_end
+                                       : 0;
+        if (node->subtree_max_gap_ < min_gap && leading_gap < min_gap) {
+            prev_region_end = ROUNDUP(node->subtree_end_, align);
+        } else if (node.left().IsValid()) {
+            node = node.left();
+            continue;
+        } else {
+            if (!visit(*node)) {
+                return;
+            }
+            if (node.right().IsValid()) {
+                node = node.right();
+                continue;
+            }
+        }
+
+        // Everything under |node| is done, so climb to the next region that
+        // isn't, then go on with the subtree to its right.
+        for (;;) {
+            auto parent = node.parent();
+            if (!parent.IsValid()) {
+                node = parent;
+                break;
+            }
+            if (parent.left() == node) {
+                if (!visit(*parent)) {
+                    return;
+                }
+                if (parent.right().IsValid()) {
+                    node = parent.right();
+                    break;
+                }
+            }
+            node = parent;
+        }
     }
 
     // Grab the gap to the right of the last region (note that if there are no
@@ -937,7 +1083,7 @@ zx_status_t VmAddressRegion::NonCompactRandomizedRegionAllocatorLocked(size_t si
         }
         return true;
     },
-               align_pow2);
+               align_pow2, size);
 
     if (candidate_spaces == 0) {
         return ZX_ERR_NO_MEMORY;
@@ -963,7 +1109,7 @@ zx_status_t VmAddressRegion::NonCompactRandomizedRegionAllocatorLocked(size_t si
         selected_index -= spots;
         return true;
     },
-               align_pow2);
+               align_pow2, size);
     ASSERT(alloc_spot != static_cast<vaddr_t>(-1));
     ASSERT(IS_ALIGNED(alloc_spot, align));
 
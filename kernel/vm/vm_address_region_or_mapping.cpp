@@ -35,6 +35,7 @@ zx_status_t VmAddressRegionOrMapping::Destroy() {
         return ZX_ERR_BAD_STATE;
     }
 
+    aspace_->WaitForFaultsLocked();
     return DestroyLocked();
 }
 
@@ -140,6 +140,7 @@ VmAspace::VmAspace(vaddr_t base, size_t size, uint32_t flags, const char* name)
     DEBUG_ASSERT(base + size - 1 >= base);
 
     Rename(name);
+    event_init(&faults_done_, false, 0);
 
     LTRACEF("%p '%s'\n", this, name_);
 }
@@ -244,6 +245,8 @@ VmAspace::~VmAspace() {
     // aspace.
     zx_status_t status = arch_aspace_.Destroy();
     DEBUG_ASSERT(status == ZX_OK);
+
+    event_destroy(&faults_done_);
 }
 
 fbl::RefPtr<VmAddressRegion> VmAspace::RootVmar() {
@@ -257,6 +260,7 @@ zx_status_t VmAspace::Destroy() {
     LTRACEF("%p '%s'\n", this, name_);
 
     Guard<fbl::Mutex> guard{&lock_};
+    WaitForFaultsLocked();
 
     // Don't let a vDSO mapping prevent destroying a VMAR
     // when the whole process is being destroyed.
@@ -557,12 +561,40 @@ zx_status_t VmAspace::PageFault(vaddr_t va, uint flags) {
         flags |= VMM_PF_FLAG_GUEST;
     }
 
-    // for now, hold the aspace lock across the page fault operation,
-    // which stops any other operations on the address space from moving
-    // the region out from underneath it
-    Guard<fbl::Mutex> guard{&lock_};
+    // Only hold the aspace lock while finding the mapping, so that faults on
+    // different mappings can proceed in parallel.  Registering as an active
+    // fault before dropping the lock stops anything from changing the mapping
+    // out from underneath us, see WaitForFaultsLocked().
+    fbl::RefPtr<VmMapping> mapping;
+    {
+        Guard<fbl::Mutex> guard{&lock_};
+        mapping = root_vmar_->FindMappingLocked(va);
+        if (!mapping) {
+            return ZX_ERR_NOT_FOUND;
+        }
+        active_faults_.fetch_add(1);
+    }
+
+    zx_status_t status = mapping->PageFault(va, flags);
 
-    return root_vmar_->PageFault(va, flags);
+    if (active_faults_.fetch_sub(1) == 1) {
+        event_signal(&faults_done_, false);
+    }
+    return status;
+}
+
+void VmAspace::WaitForFaultsLocked() {
+    DEBUG_ASSERT(lock_.lock().IsHeld());
+
+    while (active_faults_.load() != 0) {
+        // Check again once the event is clear, in case the last fault
+        // finished in between.
+        event_unsignal(&faults_done_);
+        if (active_faults_.load() == 0) {
+            break;
+        }
+        event_wait(&faults_done_);
+    }
 }
 
 void VmAspace::Dump(bool verbose) const {
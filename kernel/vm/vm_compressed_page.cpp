@@ -0,0 +1,107 @@
+// Copyright 2018 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <vm/vm_compressed_page.h>
+
+#include <fbl/alloc_checker.h>
+#include <inttypes.h>
+#include <kernel/cmdline.h>
+#include <kernel/mutex.h>
+#include <lib/counters.h>
+#include <lk/init.h>
+#include <lz4/lz4.h>
+#include <string.h>
+#include <trace.h>
+#include <vm/physmap.h>
+#include <vm/vm.h>
+
+#include "vm_priv.h"
+
+#define LOCAL_TRACE MAX(VM_GLOBAL_TRACE, 0)
+
+// The compression ratio is bytes_out / bytes_in.
+KCOUNTER(vm_compression_pages_stored, "kernel.vm.compression.pages_stored");
+KCOUNTER(vm_compression_pages_rejected, "kernel.vm.compression.pages_rejected");
+KCOUNTER(vm_compression_bytes_in, "kernel.vm.compression.bytes_in");
+KCOUNTER(vm_compression_bytes_out, "kernel.vm.compression.bytes_out");
+
+namespace {
+
+// Pages that don't shrink below this aren't worth the heap they'd take up.
+constexpr size_t kMaxCompressedSize = PAGE_SIZE * 3 / 4;
+
+bool compression_enabled = false;
+
+// The LZ4 working state is far too large for a kernel stack, so a single one
+// is shared, along with a buffer to compress into.
+struct CompressorLock {};
+DECLARE_MUTEX(CompressorLock) compressor_lock;
+LZ4_stream_t compressor_state TA_GUARDED(compressor_lock);
+char compressor_buffer[kMaxCompressedSize] TA_GUARDED(compressor_lock);
+
+void compression_init(uint level) {
+    compression_enabled = cmdline_get_bool("kernel.vm.compression.enable", false);
+}
+
+} // namespace
+
+bool VmCompressedPage::enabled() {
+    return compression_enabled;
+}
+
+VmCompressedPage::VmCompressedPage(uint64_t offset, fbl::unique_ptr<uint8_t[]> data, size_t size)
+    : offset_(offset), data_(fbl::move(data)), size_(size) {}
+
+VmCompressedPage::~VmCompressedPage() = default;
+
+fbl::unique_ptr<VmCompressedPage> VmCompressedPage::Create(uint64_t offset, paddr_t pa) {
+    const char* src = static_cast<const char*>(paddr_to_physmap(pa));
+    DEBUG_ASSERT(src);
+
+    Guard<fbl::Mutex> guard{&compressor_lock};
+
+    // Fails, returning 0, if the output doesn't fit in the buffer.
+    int size = LZ4_compress_fast_extState(&compressor_state, src, compressor_buffer,
+                                          PAGE_SIZE, kMaxCompressedSize, 1);
+    if (size <= 0) {
+        kcounter_add(vm_compression_pages_rejected, 1);
+        return nullptr;
+    }
+
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<uint8_t[]> data(new (&ac) uint8_t[size]);
+    if (!ac.check()) {
+        return nullptr;
+    }
+    memcpy(data.get(), compressor_buffer, size);
+
+    fbl::unique_ptr<VmCompressedPage> page(new (&ac) VmCompressedPage(offset, fbl::move(data),
+                                                                      size));
+    if (!ac.check()) {
+        return nullptr;
+    }
+
+    LTRACEF("offset %#" PRIx64 " pa %#" PRIxPTR " compressed to %d bytes\n", offset, pa, size);
+
+    kcounter_add(vm_compression_pages_stored, 1);
+    kcounter_add(vm_compression_bytes_in, PAGE_SIZE);
+    kcounter_add(vm_compression_bytes_out, size);
+    return page;
+}
+
+zx_status_t VmCompressedPage::Decompress(paddr_t pa) const {
+    char* dst = static_cast<char*>(paddr_to_physmap(pa));
+    DEBUG_ASSERT(dst);
+
+    int size = LZ4_decompress_safe(reinterpret_cast<const char*>(data_.get()), dst,
+                                   static_cast<int>(size_), PAGE_SIZE);
+    if (size != PAGE_SIZE) {
+        return ZX_ERR_IO_DATA_INTEGRITY;
+    }
+    return ZX_OK;
+}
+
+LK_INIT_HOOK(vm_compression, &compression_init, LK_INIT_LEVEL_VM);
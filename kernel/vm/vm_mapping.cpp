@@ -12,8 +12,12 @@
 #include <fbl/alloc_checker.h>
 #include <fbl/auto_call.h>
 #include <inttypes.h>
+#include <kernel/cmdline.h>
+#include <lib/counters.h>
+#include <lk/init.h>
 #include <trace.h>
 #include <vm/fault.h>
+#include <vm/pmm.h>
 #include <vm/vm.h>
 #include <vm/vm_aspace.h>
 #include <vm/vm_object.h>
@@ -21,6 +25,20 @@
 
 #define LOCAL_TRACE MAX(VM_GLOBAL_TRACE, 0)
 
+KCOUNTER(vm_mapping_contiguous_runs, "kernel.vm.mapping.contiguous_runs");
+KCOUNTER(vm_fault_around_faults, "kernel.vm.fault_around.faults");
+KCOUNTER(vm_fault_around_pages, "kernel.vm.fault_around.pages");
+
+// Number of pages, including the faulting one, that a page fault tries to
+// populate from already committed pages of the vmo. 0 or 1 disables it.
+static uint32_t vm_fault_around_window = 16;
+
+static void vm_fault_around_init(uint level) {
+    vm_fault_around_window = cmdline_get_uint32("kernel.vm.fault-around-pages",
+                                                vm_fault_around_window);
+}
+LK_INIT_HOOK(vm_fault_around, &vm_fault_around_init, LK_INIT_LEVEL_VM);
+
 VmMapping::VmMapping(VmAddressRegion& parent, vaddr_t base, size_t size, uint32_t vmar_flags,
                      fbl::RefPtr<VmObject> vmo, uint64_t vmo_offset, uint arch_mmu_flags)
     : VmAddressRegionOrMapping(base, size, vmar_flags,
@@ -91,6 +109,7 @@ zx_status_t VmMapping::Protect(vaddr_t base, size_t size, uint new_arch_mmu_flag
         return ZX_ERR_INVALID_ARGS;
     }
 
+    aspace_->WaitForFaultsLocked();
     return ProtectLocked(base, size, new_arch_mmu_flags);
 }
 
@@ -158,7 +177,7 @@ zx_status_t VmMapping::ProtectLocked(vaddr_t base, size_t size, uint new_arch_mm
         LTRACEF("arch_mmu_protect returns %d\n", status);
         arch_mmu_flags_ = new_arch_mmu_flags;
 
-        size_ = size;
+        set_size_locked(size);
         mapping->ActivateLocked();
         return ZX_OK;
     }
@@ -179,7 +198,7 @@ zx_status_t VmMapping::ProtectLocked(vaddr_t base, size_t size, uint new_arch_mm
         zx_status_t status = ProtectOrUnmap(aspace_, base, size, new_arch_mmu_flags);
         LTRACEF("arch_mmu_protect returns %d\n", status);
 
-        size_ -= size;
+        set_size_locked(size_ - size);
         mapping->ActivateLocked();
         return ZX_OK;
     }
@@ -208,7 +227,7 @@ zx_status_t VmMapping::ProtectLocked(vaddr_t base, size_t size, uint new_arch_mm
     LTRACEF("arch_mmu_protect returns %d\n", status);
 
     // Turn us into the left half
-    size_ = left_size;
+    set_size_locked(left_size);
 
     center_mapping->ActivateLocked();
     right_mapping->ActivateLocked();
@@ -238,6 +257,8 @@ zx_status_t VmMapping::Unmap(vaddr_t base, size_t size) {
         return ZX_ERR_INVALID_ARGS;
     }
 
+    aspace_->WaitForFaultsLocked();
+
     // If we're unmapping everything, destroy this mapping
     if (base == base_ && size == size_) {
         return DestroyLocked();
@@ -283,7 +304,7 @@ zx_status_t VmMapping::UnmapLocked(vaddr_t base, size_t size) {
             object_offset_ += size;
             parent_->subregions_.insert(fbl::move(ref));
         }
-        size_ -= size;
+        set_size_locked(size_ - size);
 
         return ZX_OK;
     }
@@ -311,7 +332,7 @@ zx_status_t VmMapping::UnmapLocked(vaddr_t base, size_t size) {
     }
 
     // Turn us into the left half
-    size_ = base - base_;
+    set_size_locked(base - base_);
     mapping->ActivateLocked();
     return ZX_OK;
 }
@@ -387,11 +408,48 @@ zx_status_t VmMapping::UnmapVmoRangeLocked(uint64_t offset, uint64_t len) const
     return ZX_OK;
 }
 
+void VmMapping::HarvestAccessedVmoRangeLocked(uint64_t offset, uint64_t len,
+                                              vmo_accessed_fn_t accessed_fn,
+                                              void* context) const {
+    canary_.Assert();
+
+    // Same locking rules as UnmapVmoRangeLocked().
+    DEBUG_ASSERT(state_ == LifeCycleState::ALIVE);
+    DEBUG_ASSERT(object_->lock()->lock().IsHeld());
+
+    uint64_t offset_new;
+    uint64_t len_new;
+    if (!GetIntersect(object_offset_, static_cast<uint64_t>(size_), offset, len,
+                      &offset_new, &len_new)) {
+        return;
+    }
+
+    struct HarvestContext {
+        vaddr_t base;
+        uint64_t object_offset;
+        vmo_accessed_fn_t accessed_fn;
+        void* context;
+    } ctx = {base_, object_offset_, accessed_fn, context};
+
+    auto harvest_fn = [](void* context, vaddr_t va) {
+        auto ctx = static_cast<HarvestContext*>(context);
+        ctx->accessed_fn(ctx->context, ctx->object_offset + (va - ctx->base), PAGE_SIZE);
+    };
+
+    const vaddr_t harvest_base = base_ + (offset_new - object_offset_);
+    zx_status_t status = aspace_->arch_aspace().HarvestAccessed(
+        harvest_base, static_cast<size_t>(len_new) / PAGE_SIZE, harvest_fn, &ctx);
+    if (status != ZX_OK) {
+        // accesses aren't tracked, so assume the whole range is in use
+        accessed_fn(context, offset_new, len_new);
+    }
+}
+
 namespace {
 
 class VmMappingCoalescer {
 public:
-    VmMappingCoalescer(VmMapping* mapping, vaddr_t base);
+    VmMappingCoalescer(VmMapping* mapping, vaddr_t base, uint mmu_flags);
     ~VmMappingCoalescer();
 
     // Add a page to the mapping run.  If this fails, the VmMappingCoalescer is
@@ -399,13 +457,30 @@ public:
     zx_status_t Append(vaddr_t vaddr, paddr_t paddr) {
         DEBUG_ASSERT(!aborted_);
         // If this isn't the expected vaddr, flush the run we have first.
-        if (count_ >= fbl::count_of(phys_) || vaddr != base_ + count_ * PAGE_SIZE) {
+        if (vaddr != base_ + count_ * PAGE_SIZE) {
             zx_status_t status = Flush();
             if (status != ZX_OK) {
                 return status;
             }
             base_ = vaddr;
         }
+        // A run that is physically contiguous is tracked by its base address
+        // alone, so it can keep growing past the size of phys_ and be handed
+        // to the arch layer in one piece, where it may become large pages.
+        if (count_ > 0 && contiguous_ && paddr == phys_[0] + count_ * PAGE_SIZE) {
+            if (count_ < fbl::count_of(phys_)) {
+                phys_[count_] = paddr;
+            }
+            ++count_;
+            return ZX_OK;
+        }
+        if (count_ >= fbl::count_of(phys_)) {
+            zx_status_t status = Flush();
+            if (status != ZX_OK) {
+                return status;
+            }
+        }
+        contiguous_ = (count_ == 0);
         phys_[count_] = paddr;
         ++count_;
         return ZX_OK;
@@ -425,14 +500,17 @@ private:
     DISALLOW_COPY_ASSIGN_AND_MOVE(VmMappingCoalescer);
 
     VmMapping* mapping_;
+    uint mmu_flags_;
     vaddr_t base_;
     paddr_t phys_[16];
     size_t count_;
+    // True if every page in the run follows phys_[0] physically.
+    bool contiguous_;
     bool aborted_;
 };
 
-VmMappingCoalescer::VmMappingCoalescer(VmMapping* mapping, vaddr_t base)
-    : mapping_(mapping), base_(base), count_(0), aborted_(false) {}
+VmMappingCoalescer::VmMappingCoalescer(VmMapping* mapping, vaddr_t base, uint mmu_flags)
+    : mapping_(mapping), mmu_flags_(mmu_flags), base_(base), count_(0), contiguous_(true), aborted_(false) {}
 
 VmMappingCoalescer::~VmMappingCoalescer() {
     // Make sure we've flushed or aborted
@@ -444,11 +522,21 @@ zx_status_t VmMappingCoalescer::Flush() {
         return ZX_OK;
     }
 
-    uint flags = mapping_->arch_mmu_flags();
+    uint flags = mmu_flags_;
     if (flags & ARCH_MMU_FLAG_PERM_RWX_MASK) {
         size_t mapped;
-        zx_status_t ret = mapping_->aspace()->arch_aspace().Map(base_, phys_, count_, flags,
-                                                                &mapped);
+        zx_status_t ret;
+        if (contiguous_ && count_ > 1) {
+            // Only phys_[0] is known to be valid once the run outgrows phys_,
+            // and the arch layer can use large pages for any aligned blocks.
+            ret = mapping_->aspace()->arch_aspace().MapContiguous(base_, phys_[0], count_, flags,
+                                                                  &mapped);
+            if (ret == ZX_OK && count_ >= LARGE_PAGE_SIZE / PAGE_SIZE) {
+                kcounter_add(vm_mapping_contiguous_runs, 1);
+            }
+        } else {
+            ret = mapping_->aspace()->arch_aspace().Map(base_, phys_, count_, flags, &mapped);
+        }
         if (ret != ZX_OK) {
             TRACEF("error %d mapping %zu pages starting at va %#" PRIxPTR "\n", ret, count_, base_);
             aborted_ = true;
@@ -501,7 +589,7 @@ zx_status_t VmMapping::MapRange(size_t offset, size_t len, bool commit) {
     // iterate through the range, grabbing a page from the underlying object and
     // mapping it in
     size_t o;
-    VmMappingCoalescer coalescer(this, base_ + offset);
+    VmMappingCoalescer coalescer(this, base_ + offset, arch_mmu_flags_);
     for (o = offset; o < offset + len; o += PAGE_SIZE) {
         uint64_t vmo_offset = object_offset_ + o;
 
@@ -599,7 +687,6 @@ zx_status_t VmMapping::DestroyLocked() {
 
 zx_status_t VmMapping::PageFault(vaddr_t va, const uint pf_flags) {
     canary_.Assert();
-    DEBUG_ASSERT(aspace_->lock()->lock().IsHeld());
 
     DEBUG_ASSERT(va >= base_ && va <= base_ + size_ - 1);
 
@@ -633,8 +720,36 @@ zx_status_t VmMapping::PageFault(vaddr_t va, const uint pf_flags) {
         return ZX_ERR_ACCESS_DENIED;
     }
 
-    // grab the lock for the vmo
-    Guard<fbl::Mutex> guard{object_->lock()};
+    // First try without allocating, so that faults on pages the vmo already has, or which only
+    // need the zero page, don't pay for one. If a new page is needed, allocate and zero it
+    // without the vmo lock held, so that first touches of different parts of a large shared vmo
+    // don't all wait behind each other's zeroing, then try again with the page in hand.
+    list_node free_list = LIST_INITIAL_VALUE(free_list);
+    zx_status_t status;
+    {
+        Guard<fbl::Mutex> guard{object_->lock()};
+        status = PageFaultLocked(va, pf_flags | VMM_PF_FLAG_NO_ALLOC, vmo_offset, &free_list);
+    }
+    if (status == ZX_ERR_SHOULD_WAIT) {
+        status = object_->AllocFaultPage(&free_list);
+        if (status != ZX_OK) {
+            return status;
+        }
+        {
+            Guard<fbl::Mutex> guard{object_->lock()};
+            status = PageFaultLocked(va, pf_flags, vmo_offset, &free_list);
+        }
+        // someone else may have faulted the page in while we were allocating
+        if (!list_is_empty(&free_list)) {
+            pmm_free(&free_list);
+        }
+    }
+    return status;
+}
+
+zx_status_t VmMapping::PageFaultLocked(vaddr_t va, uint pf_flags, uint64_t vmo_offset,
+                                       list_node* free_list) {
+    DEBUG_ASSERT(object_->lock()->lock().IsHeld());
 
     // set the currently faulting flag for any recursive calls the vmo may make back into us
     // The specific path we're avoiding is if the VMO calls back into us during vmo->GetPageLocked()
@@ -647,7 +762,10 @@ zx_status_t VmMapping::PageFault(vaddr_t va, const uint pf_flags) {
     // fault in or grab an existing page
     paddr_t new_pa;
     vm_page_t* page;
-    zx_status_t status = object_->GetPageLocked(vmo_offset, pf_flags, nullptr, &page, &new_pa);
+    zx_status_t status = object_->GetPageLocked(vmo_offset, pf_flags, free_list, &page, &new_pa);
+    if (status == ZX_ERR_SHOULD_WAIT) {
+        return status;
+    }
     if (status != ZX_OK) {
         // TODO(cpu): This trace was originally TRACEF() always on, but it fires if the
         // VMO was resized, rather than just when the system is running out of memory.
@@ -731,6 +849,10 @@ zx_status_t VmMapping::PageFault(vaddr_t va, const uint pf_flags) {
             return ZX_ERR_NO_MEMORY;
         }
         DEBUG_ASSERT(mapped == 1);
+
+        if (!(pf_flags & VMM_PF_FLAG_GUEST) && !(flags_ & VMAR_FLAG_NO_FAULT_AROUND)) {
+            FaultAroundLocked(va);
+        }
     }
 
 // TODO: figure out what to do with this
@@ -744,6 +866,68 @@ zx_status_t VmMapping::PageFault(vaddr_t va, const uint pf_flags) {
     return ZX_OK;
 }
 
+// Map the already committed pages of the vmo around |va|, which has just been
+// faulted in, so that sequential access does not trap on every page.  Pages are
+// mapped without write permission, so a later write still faults and gets the
+// usual copy-on-write treatment.  Failures are not fatal, the pages will simply
+// be faulted in individually.
+void VmMapping::FaultAroundLocked(vaddr_t va) TA_NO_THREAD_SAFETY_ANALYSIS {
+    DEBUG_ASSERT(object_->lock()->lock().IsHeld());
+
+    const size_t window = vm_fault_around_window;
+    if (window <= 1) {
+        return;
+    }
+
+    // Use a window aligned to its own size so neighbouring faults don't overlap.
+    vaddr_t start = va - ((va / PAGE_SIZE) % window) * PAGE_SIZE;
+    vaddr_t end = start + window * PAGE_SIZE;
+    if (start < base_) {
+        start = base_;
+    }
+    if (end < start || end > base_ + size_) {
+        end = base_ + size_;
+    }
+
+    const uint mmu_flags = arch_mmu_flags_ & ~ARCH_MMU_FLAG_PERM_WRITE;
+    size_t count = 0;
+    VmMappingCoalescer coalescer(this, start, mmu_flags);
+    for (vaddr_t addr = start; addr < end; addr += PAGE_SIZE) {
+        if (addr == va || aspace_->arch_aspace().Query(addr, nullptr, nullptr) == ZX_OK) {
+            continue;
+        }
+
+        // No fault flags, so this only returns pages that already exist and
+        // never allocates.
+        paddr_t pa;
+        zx_status_t status = object_->GetPageLocked(addr - base_ + object_offset_, 0,
+                                                    nullptr, nullptr, &pa);
+        if (status != ZX_OK) {
+            continue;
+        }
+        if (coalescer.Append(addr, pa) != ZX_OK) {
+            return;
+        }
+        ++count;
+    }
+    if (coalescer.Flush() != ZX_OK || count == 0) {
+        return;
+    }
+
+#if ARCH_ARM64
+    if (arch_mmu_flags_ & ARCH_MMU_FLAG_PERM_EXECUTE) {
+        for (vaddr_t addr = start; addr < end; addr += PAGE_SIZE) {
+            if (addr != va && aspace_->arch_aspace().Query(addr, nullptr, nullptr) == ZX_OK) {
+                arch_sync_cache_range(addr, PAGE_SIZE);
+            }
+        }
+    }
+#endif
+
+    kcounter_add(vm_fault_around_faults, 1);
+    kcounter_add(vm_fault_around_pages, count);
+}
+
 // We disable thread safety analysis here because one of the common uses of this
 // function is for splitting one mapping object into several that will be backed
 // by the same VmObject.  In that case, object_->lock() gets aliased across all
@@ -767,3 +951,11 @@ void VmMapping::Activate() {
     Guard<fbl::Mutex> guard{object_->lock()};
     ActivateLocked();
 }
+
+void VmMapping::set_size_locked(size_t size) {
+    DEBUG_ASSERT(aspace_->lock()->lock().IsHeld());
+    DEBUG_ASSERT(parent_);
+
+    size_ = size;
+    parent_->subregions_.node_changed(*this);
+}
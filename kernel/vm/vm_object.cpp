@@ -115,6 +115,25 @@ bool VmObject::is_cow_clone() const {
     return parent_ != nullptr;
 }
 
+void VmObject::AddDispatcher() {
+    canary_.Assert();
+    Guard<fbl::Mutex> guard{&lock_};
+    // the pages dropped once hidden can't be brought back
+    DEBUG_ASSERT(!hidden_);
+    dispatcher_count_++;
+}
+
+void VmObject::RemoveDispatcher() {
+    canary_.Assert();
+    Guard<fbl::Mutex> guard{&lock_};
+    DEBUG_ASSERT(dispatcher_count_ > 0);
+    if (--dispatcher_count_ > 0) {
+        return;
+    }
+    hidden_ = true;
+    TrimHiddenLocked();
+}
+
 void VmObject::AddMappingLocked(VmMapping* r) {
     canary_.Assert();
     DEBUG_ASSERT(lock_.lock().IsHeld());
@@ -128,6 +147,10 @@ void VmObject::RemoveMappingLocked(VmMapping* r) {
     mapping_list_.erase(*r);
     DEBUG_ASSERT(mapping_list_len_ > 0);
     mapping_list_len_--;
+
+    if (hidden_ && mapping_list_len_ == 0) {
+        TrimHiddenLocked();
+    }
 }
 
 uint32_t VmObject::num_mappings() const {
@@ -221,6 +244,10 @@ void VmObject::RemoveChildLocked(VmObject* o) {
     if ((child_observer_ != nullptr) && (children_list_len_ == 0)) {
         child_observer_->OnZeroChild();
     }
+
+    if (hidden_) {
+        TrimHiddenLocked();
+    }
 }
 
 uint32_t VmObject::num_children() const {
@@ -248,6 +275,81 @@ void VmObject::RangeChangeUpdateLocked(uint64_t offset, uint64_t len) {
     }
 }
 
+void VmObject::HarvestAccessedLocked(uint64_t offset, uint64_t len,
+                                     vmo_accessed_fn_t accessed_fn, void* context) {
+    canary_.Assert();
+    DEBUG_ASSERT(lock_.lock().IsHeld());
+    DEBUG_ASSERT(IS_PAGE_ALIGNED(offset));
+    DEBUG_ASSERT(IS_PAGE_ALIGNED(len));
+
+    for (auto& m : mapping_list_) {
+        m.HarvestAccessedVmoRangeLocked(offset, len, accessed_fn, context);
+    }
+}
+
+template <typename T>
+void VmObject::ForEachLiveVmo(T func) {
+    // VMOs are visited in batches so that AllVmosLock is not held while
+    // calling |func|, which takes the VMO lock. Holding a reference to the
+    // last VMO of a batch keeps it in the list, so the walk can pick up after
+    // it the next time around.
+    static constexpr size_t kBatchSize = 32;
+    fbl::RefPtr<VmObject> batch[kBatchSize];
+    fbl::RefPtr<VmObject> last;
+
+    for (;;) {
+        size_t count = 0;
+        bool done;
+        {
+            Guard<fbl::Mutex> guard{AllVmosLock::Get()};
+            auto iter = last ? ++all_vmos_.make_iterator(*last) : all_vmos_.begin();
+            for (; iter != all_vmos_.end() && count < kBatchSize; ++iter) {
+                // Objects in the middle of being destroyed are skipped.
+                fbl::RefPtr<VmObject> ref =
+                    fbl::MakeRefPtrUpgradeFromRaw(&*iter, AllVmosLock::Get());
+                if (ref) {
+                    batch[count++] = fbl::move(ref);
+                }
+            }
+            done = iter == all_vmos_.end();
+        }
+
+        // Drop our references outside of AllVmosLock, since releasing the last
+        // one will run the destructor, which acquires it.
+        last.reset();
+        bool stop = false;
+        for (size_t i = 0; i < count; i++) {
+            if (!stop && !func(batch[i].get())) {
+                stop = true;
+            }
+            if (i == count - 1) {
+                last = fbl::move(batch[i]);
+            } else {
+                batch[i].reset();
+            }
+        }
+        if (done || stop) {
+            return;
+        }
+    }
+}
+
+void VmObject::AgeAllPages() {
+    ForEachLiveVmo([](VmObject* vmo) {
+        vmo->AgePages();
+        return true;
+    });
+}
+
+size_t VmObject::ReclaimAllPages(uint32_t min_age, size_t max_pages) {
+    size_t reclaimed = 0;
+    ForEachLiveVmo([&](VmObject* vmo) {
+        reclaimed += vmo->ReclaimPages(min_age, max_pages - reclaimed);
+        return reclaimed < max_pages;
+    });
+    return reclaimed;
+}
+
 static int cmd_vm_object(int argc, const cmd_args* argv, uint32_t flags) {
     if (argc < 2) {
     notenoughargs:
@@ -15,6 +15,8 @@
 #include <fbl/auto_call.h>
 #include <inttypes.h>
 #include <lib/console.h>
+#include <lib/counters.h>
+#include <platform.h>
 #include <stdlib.h>
 #include <string.h>
 #include <trace.h>
@@ -26,6 +28,12 @@
 
 #define LOCAL_TRACE MAX(VM_GLOBAL_TRACE, 0)
 
+KCOUNTER(vm_zero_page_lookups, "kernel.vm.zero_page.lookups");
+KCOUNTER(vm_zero_page_write_elided, "kernel.vm.zero_page.write_elided");
+// The average latency of a fault on a compressed page is fault_ns / faults.
+KCOUNTER(vm_compression_faults, "kernel.vm.compression.faults");
+KCOUNTER(vm_compression_fault_ns, "kernel.vm.compression.fault_ns");
+
 namespace {
 
 void ZeroPage(paddr_t pa) {
@@ -35,15 +43,47 @@ void ZeroPage(paddr_t pa) {
     arch_zero_page(ptr);
 }
 
+// Zero a freshly allocated page, unless the pmm already did so in the
+// background.
 void ZeroPage(vm_page_t* p) {
+    if (p->flags & VM_PAGE_FLAG_ZEROED) {
+        p->flags &= ~VM_PAGE_FLAG_ZEROED;
+        return;
+    }
     paddr_t pa = p->paddr();
     ZeroPage(pa);
 }
 
+// Returns true if every byte in [ptr, ptr + len) is zero.
+bool IsZeroRange(const uint8_t* ptr, size_t len) {
+    while (len > 0 && (reinterpret_cast<uintptr_t>(ptr) % sizeof(uint64_t)) != 0) {
+        if (*ptr++) {
+            return false;
+        }
+        len--;
+    }
+    const uint64_t* words = reinterpret_cast<const uint64_t*>(ptr);
+    for (; len >= sizeof(uint64_t); len -= sizeof(uint64_t)) {
+        if (*words++) {
+            return false;
+        }
+    }
+    ptr = reinterpret_cast<const uint8_t*>(words);
+    while (len > 0) {
+        if (*ptr++) {
+            return false;
+        }
+        len--;
+    }
+    return true;
+}
+
 void InitializeVmPage(vm_page_t* p) {
     DEBUG_ASSERT(p->state == VM_PAGE_STATE_ALLOC);
     p->state = VM_PAGE_STATE_OBJECT;
+    p->flags &= ~VM_PAGE_FLAG_ZEROED;
     p->object.pin_count = 0;
+    p->object.age = 0;
 }
 
 // round up the size to the next page size boundary and make sure we dont wrap
@@ -61,6 +101,41 @@ zx_status_t RoundSize(uint64_t size, uint64_t* out_size) {
     return ZX_OK;
 }
 
+// Allocate pages for the empty range [offset, end) onto the tail of |list|.
+// Each LARGE_PAGE_SIZE aligned block in the range is allocated physically
+// contiguous and aligned when possible, so mappings of it can use large pages.
+zx_status_t AllocCommitPages(uint64_t offset, uint64_t end, uint alloc_flags,
+                             list_node* list) {
+    const uint64_t large_start = ROUNDUP(offset, LARGE_PAGE_SIZE);
+    const uint64_t large_end = ROUNDDOWN(end, LARGE_PAGE_SIZE);
+    if (large_start >= large_end) {
+        return pmm_alloc_pages((end - offset) / PAGE_SIZE, alloc_flags, list);
+    }
+
+    zx_status_t status = ZX_OK;
+    uint64_t o = offset;
+    if (o < large_start) {
+        status = pmm_alloc_pages((large_start - o) / PAGE_SIZE, alloc_flags, list);
+        o = large_start;
+    }
+    while (status == ZX_OK && o < large_end) {
+        paddr_t pa;
+        if (pmm_alloc_contiguous(LARGE_PAGE_SIZE / PAGE_SIZE, alloc_flags, LARGE_PAGE_SIZE_SHIFT,
+                                 &pa, list) != ZX_OK) {
+            // Physical memory is too fragmented, stop trying.
+            break;
+        }
+        o += LARGE_PAGE_SIZE;
+    }
+    if (status == ZX_OK && o < end) {
+        status = pmm_alloc_pages((end - o) / PAGE_SIZE, alloc_flags, list);
+    }
+    if (status != ZX_OK) {
+        pmm_free(list);
+    }
+    return status;
+}
+
 } // namespace
 
 VmObjectPaged::VmObjectPaged(
@@ -160,10 +235,9 @@ zx_status_t VmObjectPaged::CreateContiguous(uint32_t pmm_alloc_flags, uint64_t s
         vm_page_t* p = list_remove_head_type(&page_list, vm_page_t, queue_node);
         ASSERT(p);
 
-        InitializeVmPage(p);
-
-        // TODO: remove once pmm returns zeroed pages
+        // skipped for pages the pmm zeroed in the background
         ZeroPage(p);
+        InitializeVmPage(p);
 
         // We don't need thread-safety analysis here, since this VMO has not
         // been shared anywhere yet.
@@ -301,8 +375,8 @@ void VmObjectPaged::Dump(uint depth, bool verbose) {
         printf("  ");
     }
     printf("vmo %p/k%" PRIu64 " size %#" PRIx64
-           " pages %zu ref %d parent k%" PRIu64 "\n",
-           this, user_id_, size_, count, ref_count_debug(), parent_id);
+           " pages %zu compressed %zu ref %d parent k%" PRIu64 "\n",
+           this, user_id_, size_, count, compressed_pages_.size(), ref_count_debug(), parent_id);
 
     if (verbose) {
         auto f = [depth](const auto p, uint64_t offset) {
@@ -336,6 +410,293 @@ size_t VmObjectPaged::AllocatedPagesInRange(uint64_t offset, uint64_t len) const
     return count;
 }
 
+bool VmObjectPaged::CanReclaimLocked() const {
+    // There is no backing store to write pages out to, so pages are either
+    // discarded because they read back as zeroes, or kept compressed. Either
+    // is invisible to the user as long as no parent page would show through
+    // in its place and no clone is reading through to it.
+    return user_id_ != 0 && !parent_ && children_list_len_ == 0 && !is_contiguous() &&
+           cache_policy_ == ARCH_MMU_FLAG_CACHED;
+}
+
+void VmObjectPaged::AgePages() {
+    canary_.Assert();
+    Guard<fbl::Mutex> guard{&lock_};
+
+    if (!CanReclaimLocked()) {
+        return;
+    }
+
+    // pages accessed through a mapping since the last scan start over
+    auto accessed_fn = [](void* context, uint64_t offset, uint64_t len) {
+        auto page_list = static_cast<VmPageList*>(context);
+        page_list->ForEveryPageInRange(
+            [](auto p, uint64_t off) {
+                p->object.age = 0;
+                return ZX_ERR_NEXT;
+            },
+            offset, offset + len);
+    };
+
+    // Age every page, and harvest the mappings one run of committed pages at
+    // a time so that sparse objects don't walk page tables for holes.
+    uint64_t run_start = 0;
+    uint64_t run_end = 0;
+    auto harvest_run = [&]() TA_NO_THREAD_SAFETY_ANALYSIS {
+        if (run_end > run_start && mapping_list_len_ > 0) {
+            HarvestAccessedLocked(run_start, run_end - run_start, accessed_fn, &page_list_);
+        }
+    };
+    page_list_.ForEveryPage(
+        [&](auto p, uint64_t off) {
+            if (p->object.age < VM_PAGE_OBJECT_MAX_AGE) {
+                p->object.age++;
+            }
+            if (off != run_end) {
+                harvest_run();
+                run_start = off;
+            }
+            run_end = off + PAGE_SIZE;
+            return ZX_ERR_NEXT;
+        });
+    harvest_run();
+}
+
+size_t VmObjectPaged::ReclaimPages(uint32_t min_age, size_t max_pages) {
+    canary_.Assert();
+    DEBUG_ASSERT(min_age > 0);
+    Guard<fbl::Mutex> guard{&lock_};
+
+    if (!CanReclaimLocked()) {
+        return 0;
+    }
+
+    // Pages can't be taken out of page_list_ while walking it, so candidates
+    // are collected and freed a batch at a time.
+    static constexpr size_t kReclaimBatch = 16;
+    uint64_t batch[kReclaimBatch];
+    uint64_t start = 0;
+    size_t reclaimed = 0;
+    bool more = true;
+    while (more && reclaimed < max_pages) {
+        size_t count = 0;
+        more = false;
+        page_list_.ForEveryPageInRange(
+            [&](auto p, uint64_t off) TA_NO_THREAD_SAFETY_ANALYSIS {
+                start = off + PAGE_SIZE;
+                if (p->state != VM_PAGE_STATE_OBJECT || p->object.pin_count > 0 ||
+                    p->object.age < min_age) {
+                    return ZX_ERR_NEXT;
+                }
+
+                // Unmap the page before looking at it, so that a write through
+                // an existing mapping can't land after the check. If it turns
+                // out to be in use it is simply faulted back in.
+                RangeChangeUpdateLocked(off, PAGE_SIZE);
+                auto ptr = static_cast<const uint8_t*>(paddr_to_physmap(p->paddr()));
+                if (!IsZeroRange(ptr, PAGE_SIZE)) {
+                    // keep the contents compressed if that's enabled and
+                    // worthwhile, otherwise leave the page be until it has
+                    // aged out once more
+                    fbl::unique_ptr<VmCompressedPage> compressed;
+                    if (VmCompressedPage::enabled()) {
+                        compressed = VmCompressedPage::Create(off, p->paddr());
+                    }
+                    if (!compressed) {
+                        p->object.age = 0;
+                        return ZX_ERR_NEXT;
+                    }
+                    compressed_pages_.insert(fbl::move(compressed));
+                }
+
+                batch[count++] = off;
+                if (count == kReclaimBatch || reclaimed + count == max_pages) {
+                    more = true;
+                    return ZX_ERR_STOP;
+                }
+                return ZX_ERR_NEXT;
+            },
+            start, size_);
+
+        for (size_t i = 0; i < count; i++) {
+            page_list_.FreePage(batch[i]);
+        }
+        reclaimed += count;
+    }
+
+    return reclaimed;
+}
+
+bool VmObjectPaged::IsVisibleToChildrenLocked(uint64_t offset) const {
+    for (const auto& c : children_list_) {
+        // clones of a paged object are always paged
+        const auto& child = static_cast<const VmObjectPaged&>(c);
+        if (offset < child.parent_offset_) {
+            continue;
+        }
+        // a resizable clone may grow over any of our later pages
+        if (child.is_resizable() || offset - child.parent_offset_ < child.size_) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void VmObjectPaged::TrimHiddenLocked() {
+    canary_.Assert();
+    DEBUG_ASSERT(lock_.lock().IsHeld());
+    DEBUG_ASSERT(hidden_);
+
+    // Without handles or mappings, our pages are only reachable by clones
+    // reading through to us, so free the ones outside every clone's range.
+    // None of them can be mapped anywhere, so there is nothing to unmap.
+    if (mapping_list_len_ > 0) {
+        return;
+    }
+
+    static constexpr size_t kTrimBatch = 16;
+    uint64_t batch[kTrimBatch];
+    uint64_t start = 0;
+    bool more = true;
+    while (more) {
+        size_t count = 0;
+        more = false;
+        page_list_.ForEveryPageInRange(
+            [&](auto p, uint64_t off) {
+                start = off + PAGE_SIZE;
+                if (p->state != VM_PAGE_STATE_OBJECT || p->object.pin_count > 0 ||
+                    IsVisibleToChildrenLocked(off)) {
+                    return ZX_ERR_NEXT;
+                }
+                batch[count++] = off;
+                if (count == kTrimBatch) {
+                    more = true;
+                    return ZX_ERR_STOP;
+                }
+                return ZX_ERR_NEXT;
+            },
+            start, size_);
+
+        for (size_t i = 0; i < count; i++) {
+            page_list_.FreePage(batch[i]);
+        }
+    }
+
+    for (auto iter = compressed_pages_.begin(); iter.IsValid();) {
+        auto cur = iter++;
+        if (!IsVisibleToChildrenLocked(cur->offset())) {
+            compressed_pages_.erase(cur);
+        }
+    }
+
+    // If nothing of ours is left for our only clone to see, it can read
+    // straight through to our parent instead, which takes a level out of
+    // every lookup it does. A root can't be taken out of the chain because
+    // its clones share its lock.
+    if (!parent_ || children_list_len_ != 1) {
+        return;
+    }
+    auto& child = static_cast<VmObjectPaged&>(children_list_.front());
+    uint64_t child_end;
+    uint64_t new_offset;
+    if (child.is_resizable() ||
+        add_overflow(child.parent_offset_, child.size_, &child_end) || child_end > size_ ||
+        add_overflow(parent_offset_, child.parent_offset_, &new_offset)) {
+        return;
+    }
+    bool any_pages = false;
+    page_list_.ForEveryPageInRange(
+        [&any_pages](const auto, uint64_t) {
+            any_pages = true;
+            return ZX_ERR_STOP;
+        },
+        child.parent_offset_, child_end);
+    auto compressed = compressed_pages_.lower_bound(child.parent_offset_);
+    if (any_pages || (compressed.IsValid() && compressed->offset() < child_end)) {
+        return;
+    }
+
+    // We stay on our parent's list of children until we are destroyed, since
+    // our lock is really our parent's.
+    parent_->AddChildLocked(&child);
+    RemoveChildLocked(&child);
+    child.parent_offset_ = new_offset;
+    // Whoever hid us or took away our mapping or other child still holds a
+    // reference, so this doesn't run our destructor under the lock.
+    child.parent_ = parent_;
+}
+
+zx_status_t VmObjectPaged::DecompressPageLocked(uint64_t offset, list_node* free_list,
+                                                vm_page_t** page_out) {
+    DEBUG_ASSERT(lock_.lock().IsHeld());
+    DEBUG_ASSERT(IS_PAGE_ALIGNED(offset));
+
+    auto iter = compressed_pages_.find(offset);
+    if (!iter.IsValid()) {
+        return ZX_ERR_NOT_FOUND;
+    }
+
+    const zx_time_t start = current_time();
+
+    vm_page_t* p = nullptr;
+    paddr_t pa;
+    if (free_list) {
+        p = list_remove_head_type(free_list, vm_page, queue_node);
+        if (p) {
+            pa = p->paddr();
+        }
+    }
+    if (!p) {
+        pmm_alloc_page(pmm_alloc_flags_, &p, &pa);
+    }
+    if (!p) {
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    zx_status_t status = iter->Decompress(pa);
+    if (status != ZX_OK) {
+        pmm_free_page(p);
+        return status;
+    }
+    compressed_pages_.erase(iter);
+
+    InitializeVmPage(p);
+    status = AddPageLocked(p, offset);
+    DEBUG_ASSERT(status == ZX_OK);
+
+    kcounter_add(vm_compression_faults, 1);
+    kcounter_add(vm_compression_fault_ns, current_time() - start);
+
+    *page_out = p;
+    return ZX_OK;
+}
+
+zx_status_t VmObjectPaged::DecompressRangeLocked(uint64_t start, uint64_t end) {
+    DEBUG_ASSERT(lock_.lock().IsHeld());
+
+    for (auto iter = compressed_pages_.lower_bound(start);
+         iter.IsValid() && iter->offset() < end;) {
+        const uint64_t offset = iter->offset();
+        ++iter;
+        vm_page_t* p;
+        zx_status_t status = DecompressPageLocked(offset, nullptr, &p);
+        if (status != ZX_OK) {
+            return status;
+        }
+    }
+    return ZX_OK;
+}
+
+void VmObjectPaged::FreeCompressedPagesLocked(uint64_t start, uint64_t end) {
+    DEBUG_ASSERT(lock_.lock().IsHeld());
+
+    for (auto iter = compressed_pages_.lower_bound(start);
+         iter.IsValid() && iter->offset() < end;) {
+        auto cur = iter++;
+        compressed_pages_.erase(cur);
+    }
+}
+
 zx_status_t VmObjectPaged::AddPage(vm_page_t* p, uint64_t offset) {
     Guard<fbl::Mutex> guard{&lock_};
 
@@ -372,6 +733,10 @@ zx_status_t VmObjectPaged::AddPageLocked(vm_page_t* p, uint64_t offset) {
 // this function may allocate from.  This function will need at most one entry,
 // and will not fail if |free_list| is a non-empty list, faulting in was requested,
 // and offset is in range.
+//
+// If VMM_PF_FLAG_NO_ALLOC is set and a new zero page is needed but |free_list|
+// is empty, returns ZX_ERR_SHOULD_WAIT so that the caller can get one from
+// AllocFaultPage() without the lock held and try again.
 zx_status_t VmObjectPaged::GetPageLocked(uint64_t offset, uint pf_flags, list_node* free_list,
                                          vm_page_t** const page_out, paddr_t* const pa_out) {
     canary_.Assert();
@@ -387,6 +752,7 @@ zx_status_t VmObjectPaged::GetPageLocked(uint64_t offset, uint pf_flags, list_no
     // see if we already have a page at that offset
     p = page_list_.GetPage(offset);
     if (p) {
+        p->object.age = 0;
         if (page_out) {
             *page_out = p;
         }
@@ -396,6 +762,24 @@ zx_status_t VmObjectPaged::GetPageLocked(uint64_t offset, uint pf_flags, list_no
         return ZX_OK;
     }
 
+    // a page reclaim compressed still holds our contents, so it is brought
+    // back whether or not we were asked to fault
+    if (!compressed_pages_.is_empty()) {
+        zx_status_t status = DecompressPageLocked(ROUNDDOWN(offset, PAGE_SIZE), free_list, &p);
+        if (status == ZX_OK) {
+            if (page_out) {
+                *page_out = p;
+            }
+            if (pa_out) {
+                *pa_out = p->paddr();
+            }
+            return ZX_OK;
+        }
+        if (status != ZX_ERR_NOT_FOUND) {
+            return status;
+        }
+    }
+
     __UNUSED char pf_string[5];
     LTRACEF("vmo %p, offset %#" PRIx64 ", pf_flags %#x (%s)\n", this, offset, pf_flags,
             vmm_pf_flags_to_string(pf_flags, pf_string));
@@ -480,6 +864,7 @@ zx_status_t VmObjectPaged::GetPageLocked(uint64_t offset, uint pf_flags, list_no
     // return the single global zero page
     if ((pf_flags & VMM_PF_FLAG_WRITE) == 0) {
         LTRACEF("returning the zero page\n");
+        kcounter_add(vm_zero_page_lookups, 1);
         if (page_out) {
             *page_out = vm_get_zero_page();
         }
@@ -497,17 +882,19 @@ zx_status_t VmObjectPaged::GetPageLocked(uint64_t offset, uint pf_flags, list_no
         }
     }
     if (!p) {
+        if (pf_flags & VMM_PF_FLAG_NO_ALLOC) {
+            return ZX_ERR_SHOULD_WAIT;
+        }
         pmm_alloc_page(pmm_alloc_flags_, &p, &pa);
     }
     if (!p) {
         return ZX_ERR_NO_MEMORY;
     }
 
+    // zero before InitializeVmPage, which forgets whether the pmm did it
+    ZeroPage(p);
     InitializeVmPage(p);
 
-    // TODO: remove once pmm returns zeroed pages
-    ZeroPage(pa);
-
 // if ARM and not fully cached, clean/invalidate the page after zeroing it
 #if ARCH_ARM64
     if (cache_policy_ != ARCH_MMU_FLAG_CACHED) {
@@ -533,6 +920,32 @@ zx_status_t VmObjectPaged::GetPageLocked(uint64_t offset, uint pf_flags, list_no
     return ZX_OK;
 }
 
+zx_status_t VmObjectPaged::AllocFaultPage(list_node* free_list) {
+    canary_.Assert();
+
+    uint32_t pmm_alloc_flags;
+    {
+        Guard<fbl::Mutex> guard{&lock_};
+        pmm_alloc_flags = pmm_alloc_flags_;
+    }
+
+    vm_page_t* p;
+    paddr_t pa;
+    zx_status_t status = pmm_alloc_page(pmm_alloc_flags, &p, &pa);
+    if (status != ZX_OK) {
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    // mark it zeroed so that GetPageLocked() skips the work
+    if (!(p->flags & VM_PAGE_FLAG_ZEROED)) {
+        ZeroPage(pa);
+        p->flags |= VM_PAGE_FLAG_ZEROED;
+    }
+    list_add_tail(free_list, &p->queue_node);
+
+    return ZX_OK;
+}
+
 zx_status_t VmObjectPaged::CommitRange(uint64_t offset, uint64_t len, uint64_t* committed) {
     canary_.Assert();
     LTRACEF("offset %#" PRIx64 ", len %#" PRIx64 "\n", offset, len);
@@ -583,7 +996,14 @@ zx_status_t VmObjectPaged::CommitRange(uint64_t offset, uint64_t len, uint64_t*
     list_node page_list;
     list_initialize(&page_list);
 
-    zx_status_t status = pmm_alloc_pages(count, pmm_alloc_flags_, &page_list);
+    zx_status_t status;
+    if (count == (end - offset) / PAGE_SIZE) {
+        // Nothing in the range is committed yet, so the pages are consumed in
+        // offset order and large page aligned runs can be backed contiguously.
+        status = AllocCommitPages(offset, end, pmm_alloc_flags_, &page_list);
+    } else {
+        status = pmm_alloc_pages(count, pmm_alloc_flags_, &page_list);
+    }
     if (status != ZX_OK) {
         return status;
     }
@@ -620,6 +1040,65 @@ zx_status_t VmObjectPaged::CommitRange(uint64_t offset, uint64_t len, uint64_t*
     return ZX_OK;
 }
 
+zx_status_t VmObjectPaged::PrefetchRange(uint64_t offset, uint64_t len) {
+    canary_.Assert();
+    LTRACEF("offset %#" PRIx64 ", len %#" PRIx64 "\n", offset, len);
+
+    Guard<fbl::Mutex> guard{&lock_};
+
+    // trim the size
+    uint64_t new_len;
+    if (!TrimRange(offset, len, size_, &new_len)) {
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+
+    // was in range, just zero length
+    if (new_len == 0) {
+        return ZX_OK;
+    }
+
+    uint64_t end = ROUNDUP_PAGE_SIZE(offset + new_len);
+    DEBUG_ASSERT(end > offset);
+    offset = ROUNDDOWN(offset, PAGE_SIZE);
+
+    // Allocate for all of our own compressed pages in the range at once. The
+    // pages of ancestors get allocated one at a time as they are found.
+    size_t count = 0;
+    for (auto iter = compressed_pages_.lower_bound(offset);
+         iter.IsValid() && iter->offset() < end; ++iter) {
+        count++;
+    }
+
+    list_node free_list;
+    list_initialize(&free_list);
+    if (count > 0) {
+        zx_status_t status = pmm_alloc_pages(count, pmm_alloc_flags_, &free_list);
+        if (status != ZX_OK) {
+            return status;
+        }
+    }
+
+    // Without fault flags this only decompresses pages, here or in the
+    // ancestors we read through to, and marks present pages as used. Holes
+    // stay holes.
+    zx_status_t status = ZX_OK;
+    for (uint64_t o = offset; o < end; o += PAGE_SIZE) {
+        status = GetPageLocked(o, 0, &free_list, nullptr, nullptr);
+        if (status == ZX_ERR_NOT_FOUND) {
+            status = ZX_OK;
+        }
+        if (status != ZX_OK) {
+            break;
+        }
+    }
+
+    if (!list_is_empty(&free_list)) {
+        pmm_free(&free_list);
+    }
+
+    return status;
+}
+
 zx_status_t VmObjectPaged::DecommitRange(uint64_t offset, uint64_t len, uint64_t* decommitted) {
     canary_.Assert();
     LTRACEF("offset %#" PRIx64 ", len %#" PRIx64 "\n", offset, len);
@@ -665,14 +1144,107 @@ zx_status_t VmObjectPaged::DecommitRange(uint64_t offset, uint64_t len, uint64_t
     // unmap all of the pages in this range on all the mapping regions
     RangeChangeUpdateLocked(start, page_aligned_len);
 
-    // iterate through the pages, freeing them
-    // TODO: use page_list iterator, move pages to list, free at once
-    while (start < end) {
-        auto status = page_list_.FreePage(start);
-        if (status == ZX_OK && decommitted) {
-            *decommitted += PAGE_SIZE;
+    // free all of the pages in the range at once
+    size_t freed = page_list_.FreePages(start, end);
+    FreeCompressedPagesLocked(start, end);
+    if (decommitted) {
+        *decommitted = freed * PAGE_SIZE;
+    }
+
+    return ZX_OK;
+}
+
+zx_status_t VmObjectPaged::TakePages(uint64_t offset, uint64_t len, list_node* pages) {
+    canary_.Assert();
+    LTRACEF("offset %#" PRIx64 ", len %#" PRIx64 "\n", offset, len);
+
+    if (options_ & kContiguous) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+    if (!IS_PAGE_ALIGNED(offset) || !IS_PAGE_ALIGNED(len)) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    Guard<fbl::Mutex> guard{&lock_};
+
+    if (!InRange(offset, len, size_)) {
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+
+    // clones read through to our pages, so they would see them vanish
+    if (children_list_len_ != 0) {
+        return ZX_ERR_BAD_STATE;
+    }
+    if (AnyPagesPinnedLocked(offset, len)) {
+        return ZX_ERR_BAD_STATE;
+    }
+
+    // make every page in the range our own: committed, decompressed, and
+    // copied from the parent if need be
+    const uint64_t end = offset + len;
+    for (uint64_t o = offset; o < end; o += PAGE_SIZE) {
+        zx_status_t status = GetPageLocked(o, VMM_PF_FLAG_SW_FAULT | VMM_PF_FLAG_WRITE,
+                                           nullptr, nullptr, nullptr);
+        if (status != ZX_OK) {
+            return status;
         }
-        start += PAGE_SIZE;
+    }
+
+    // unmap all of the pages in this range on all the mapping regions
+    RangeChangeUpdateLocked(offset, len);
+
+    for (uint64_t o = offset; o < end; o += PAGE_SIZE) {
+        vm_page_t* p = page_list_.RemovePage(o);
+        DEBUG_ASSERT(p && p->state == VM_PAGE_STATE_OBJECT);
+        p->state = VM_PAGE_STATE_IPC;
+        list_add_tail(pages, &p->queue_node);
+    }
+
+    return ZX_OK;
+}
+
+zx_status_t VmObjectPaged::SupplyPages(uint64_t offset, uint64_t len, list_node* pages) {
+    canary_.Assert();
+    LTRACEF("offset %#" PRIx64 ", len %#" PRIx64 "\n", offset, len);
+
+    if (options_ & kContiguous) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+    if (!IS_PAGE_ALIGNED(offset) || !IS_PAGE_ALIGNED(len) ||
+        list_length(pages) != len / PAGE_SIZE) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    Guard<fbl::Mutex> guard{&lock_};
+
+    if (!InRange(offset, len, size_)) {
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+
+    // see TakePages()
+    if (children_list_len_ != 0) {
+        return ZX_ERR_BAD_STATE;
+    }
+    if (AnyPagesPinnedLocked(offset, len)) {
+        return ZX_ERR_BAD_STATE;
+    }
+
+    // unmap all of the pages in this range on all the mapping regions
+    RangeChangeUpdateLocked(offset, len);
+
+    // the previous contents are being overwritten as a whole
+    const uint64_t end = offset + len;
+    page_list_.FreePages(offset, end);
+    FreeCompressedPagesLocked(offset, end);
+
+    for (uint64_t o = offset; o < end; o += PAGE_SIZE) {
+        vm_page_t* p = list_remove_head_type(pages, vm_page_t, queue_node);
+        DEBUG_ASSERT(p->state == VM_PAGE_STATE_IPC);
+        p->state = VM_PAGE_STATE_OBJECT;
+        p->object.pin_count = 0;
+        p->object.age = 0;
+        zx_status_t status = page_list_.AddPage(p, o);
+        DEBUG_ASSERT(status == ZX_OK);
     }
 
     return ZX_OK;
@@ -700,8 +1272,14 @@ zx_status_t VmObjectPaged::PinLocked(uint64_t offset, uint64_t len) {
     const uint64_t start_page_offset = ROUNDDOWN(offset, PAGE_SIZE);
     const uint64_t end_page_offset = ROUNDUP(offset + len, PAGE_SIZE);
 
+    // committed pages that reclaim compressed have to come back first
+    zx_status_t status = DecompressRangeLocked(start_page_offset, end_page_offset);
+    if (status != ZX_OK) {
+        return status;
+    }
+
     uint64_t expected_next_off = start_page_offset;
-    zx_status_t status = page_list_.ForEveryPageInRange(
+    status = page_list_.ForEveryPageInRange(
         [&expected_next_off](const auto p, uint64_t off) {
             if (off != expected_next_off) {
                 return ZX_ERR_NOT_FOUND;
@@ -826,12 +1404,9 @@ zx_status_t VmObjectPaged::ResizeLocked(uint64_t s) {
         // unmap all of the pages in this range on all the mapping regions
         RangeChangeUpdateLocked(start, len);
 
-        // iterate through the pages, freeing them
-        // TODO: use page_list iterator, move pages to list, free at once
-        while (start < end) {
-            page_list_.FreePage(start);
-            start += PAGE_SIZE;
-        }
+        // free all of the pages in the range at once
+        page_list_.FreePages(start, end);
+        FreeCompressedPagesLocked(start, end);
     } else if (s > size_) {
         // expanding
         // figure the starting and ending page offset that is affected
@@ -902,6 +1477,14 @@ zx_status_t VmObjectPaged::ReadWriteInternal(uint64_t offset, size_t len, bool w
         size_t page_offset = src_offset % PAGE_SIZE;
         size_t tocopy = MIN(PAGE_SIZE - page_offset, len);
 
+        // A write to a page that doesn't exist yet, and that no parent can
+        // supply, starts from a zero filled page.  If the data turns out to
+        // be all zeroes too the page can be dropped again, leaving reads to
+        // the shared zero page.
+        const uint64_t page_base = ROUNDDOWN(src_offset, PAGE_SIZE);
+        const bool fresh_page = write && !parent_ && !page_list_.GetPage(page_base) &&
+                                !compressed_pages_.find(page_base).IsValid();
+
         // fault in the page
         paddr_t pa;
         auto status = GetPageLocked(src_offset,
@@ -920,6 +1503,13 @@ zx_status_t VmObjectPaged::ReadWriteInternal(uint64_t offset, size_t len, bool w
             return err;
         }
 
+        // Nothing can have mapped the new page since we hold the lock, so it
+        // is safe to free it here.
+        if (fresh_page && IsZeroRange(page_ptr + page_offset, tocopy)) {
+            page_list_.FreePage(page_base);
+            kcounter_add(vm_zero_page_write_elided, 1);
+        }
+
         src_offset += tocopy;
         dest_offset += tocopy;
         len -= tocopy;
@@ -1114,9 +1704,46 @@ zx_status_t VmObjectPaged::CacheOp(const uint64_t start_offset, const uint64_t l
         return ZX_ERR_OUT_OF_RANGE;
     }
 
+    // Perform the cache op against a range of the physmap.
+    auto cache_op = [type](addr_t addr, size_t len) {
+        LTRACEF("addr %#" PRIxPTR " len %#zx op %d\n", addr, len, (int)type);
+
+        switch (type) {
+        case CacheOpType::Invalidate:
+            arch_invalidate_cache_range(addr, len);
+            break;
+        case CacheOpType::Clean:
+            arch_clean_cache_range(addr, len);
+            break;
+        case CacheOpType::CleanInvalidate:
+            arch_clean_invalidate_cache_range(addr, len);
+            break;
+        case CacheOpType::Sync:
+            arch_sync_cache_range(addr, len);
+            break;
+        }
+    };
+
     const size_t end_offset = static_cast<size_t>(start_offset + len);
     size_t op_start_offset = static_cast<size_t>(start_offset);
 
+    // A contiguous VMO is fully committed and physically contiguous, so the
+    // whole range can be done in one go from the address of its first page.
+    if (is_contiguous()) {
+        paddr_t pa;
+        __UNUSED auto status = GetPageLocked(ROUNDDOWN(op_start_offset, PAGE_SIZE), 0,
+                                             nullptr, nullptr, &pa);
+        DEBUG_ASSERT(status == ZX_OK);
+        cache_op(reinterpret_cast<addr_t>(paddr_to_physmap(pa)) + op_start_offset % PAGE_SIZE,
+                 len);
+        return ZX_OK;
+    }
+
+    // Otherwise pages that are adjacent in the physmap are gathered into runs,
+    // and each run gets a single cache op, which saves a barrier per page.
+    addr_t run_addr = 0;
+    size_t run_len = 0;
+
     while (op_start_offset != end_offset) {
         // Offset at the end of the current page.
         const size_t page_end_offset = ROUNDUP(op_start_offset + 1, PAGE_SIZE);
@@ -1135,31 +1762,27 @@ zx_status_t VmObjectPaged::CacheOp(const uint64_t start_offset, const uint64_t l
 
         if (likely(status == ZX_OK)) {
             // Convert the page address to a Kernel virtual address.
-            const void* ptr = paddr_to_physmap(pa);
-            const addr_t cache_op_addr = reinterpret_cast<addr_t>(ptr) + page_offset;
-
-            LTRACEF("ptr %p op %d\n", ptr, (int)type);
-
-            // Perform the necessary cache op against this page.
-            switch (type) {
-            case CacheOpType::Invalidate:
-                arch_invalidate_cache_range(cache_op_addr, cache_op_len);
-                break;
-            case CacheOpType::Clean:
-                arch_clean_cache_range(cache_op_addr, cache_op_len);
-                break;
-            case CacheOpType::CleanInvalidate:
-                arch_clean_invalidate_cache_range(cache_op_addr, cache_op_len);
-                break;
-            case CacheOpType::Sync:
-                arch_sync_cache_range(cache_op_addr, cache_op_len);
-                break;
+            const addr_t cache_op_addr = reinterpret_cast<addr_t>(paddr_to_physmap(pa)) +
+                                         page_offset;
+
+            if (run_len != 0 && run_addr + run_len == cache_op_addr) {
+                run_len += cache_op_len;
+            } else {
+                if (run_len != 0) {
+                    cache_op(run_addr, run_len);
+                }
+                run_addr = cache_op_addr;
+                run_len = cache_op_len;
             }
         }
 
         op_start_offset += cache_op_len;
     }
 
+    if (run_len != 0) {
+        cache_op(run_addr, run_len);
+    }
+
     return ZX_OK;
 }
 
@@ -48,6 +48,7 @@ vm_page* VmPageListNode::RemovePage(size_t index) {
     }
 
     pages_[index] = nullptr;
+    populated_ &= ~(1ull << index);
 
     return p;
 }
@@ -59,9 +60,27 @@ zx_status_t VmPageListNode::AddPage(vm_page* p, size_t index) {
         return ZX_ERR_ALREADY_EXISTS;
     }
     pages_[index] = p;
+    populated_ |= 1ull << index;
     return ZX_OK;
 }
 
+size_t VmPageListNode::RemovePages(uint64_t start_offset, uint64_t end_offset, list_node* list) {
+    canary_.Assert();
+
+    const uint64_t range = RangeMask(start_offset, end_offset);
+    uint64_t mask = range;
+    size_t count = 0;
+    while (mask) {
+        size_t i = __builtin_ctzll(mask);
+        mask &= mask - 1;
+        list_add_tail(list, &pages_[i]->queue_node);
+        pages_[i] = nullptr;
+        count++;
+    }
+    populated_ &= ~range;
+    return count;
+}
+
 VmPageList::VmPageList() {
     LTRACEF("%p\n", this);
 }
@@ -71,6 +90,25 @@ VmPageList::~VmPageList() {
     DEBUG_ASSERT(list_.is_empty());
 }
 
+VmPageListNode* VmPageList::FindNode(uint64_t node_offset) {
+    if (last_node_ && last_node_->offset() == node_offset) {
+        return last_node_;
+    }
+    auto pln = list_.find(node_offset);
+    if (!pln.IsValid()) {
+        return nullptr;
+    }
+    last_node_ = &*pln;
+    return last_node_;
+}
+
+void VmPageList::EraseNode(VmPageListNode* node) {
+    if (last_node_ == node) {
+        last_node_ = nullptr;
+    }
+    list_.erase(*node);
+}
+
 zx_status_t VmPageList::AddPage(vm_page* p, uint64_t offset) {
     uint64_t node_offset = ROUNDDOWN(offset, PAGE_SIZE * VmPageListNode::kPageFanOut);
     size_t index = (offset >> PAGE_SIZE_SHIFT) % VmPageListNode::kPageFanOut;
@@ -79,8 +117,8 @@ zx_status_t VmPageList::AddPage(vm_page* p, uint64_t offset) {
                   node_offset, index);
 
     // lookup the tree node that holds this page
-    auto pln = list_.find(node_offset);
-    if (!pln.IsValid()) {
+    VmPageListNode* pln = FindNode(node_offset);
+    if (!pln) {
         fbl::AllocChecker ac;
         fbl::unique_ptr<VmPageListNode> pl =
             fbl::unique_ptr<VmPageListNode>(new (&ac) VmPageListNode(node_offset));
@@ -92,6 +130,7 @@ zx_status_t VmPageList::AddPage(vm_page* p, uint64_t offset) {
         __UNUSED auto status = pl->AddPage(p, index);
         DEBUG_ASSERT(status == ZX_OK);
 
+        last_node_ = pl.get();
         list_.insert(fbl::move(pl));
     } else {
         pln->AddPage(p, index);
@@ -108,8 +147,8 @@ vm_page* VmPageList::GetPage(uint64_t offset) {
                   index);
 
     // lookup the tree node that holds this page
-    auto pln = list_.find(node_offset);
-    if (!pln.IsValid()) {
+    VmPageListNode* pln = FindNode(node_offset);
+    if (!pln) {
         return nullptr;
     }
 
@@ -117,6 +156,15 @@ vm_page* VmPageList::GetPage(uint64_t offset) {
 }
 
 zx_status_t VmPageList::FreePage(uint64_t offset) {
+    auto page = RemovePage(offset);
+    if (page) {
+        pmm_free_page(page);
+    }
+
+    return ZX_OK;
+}
+
+vm_page* VmPageList::RemovePage(uint64_t offset) {
     uint64_t node_offset = ROUNDDOWN(offset, PAGE_SIZE * VmPageListNode::kPageFanOut);
     size_t index = (offset >> PAGE_SIZE_SHIFT) % VmPageListNode::kPageFanOut;
 
@@ -124,24 +172,49 @@ zx_status_t VmPageList::FreePage(uint64_t offset) {
                   index);
 
     // lookup the tree node that holds this page
-    auto pln = list_.find(node_offset);
-    if (!pln.IsValid()) {
-        return ZX_ERR_NOT_FOUND;
+    VmPageListNode* pln = FindNode(node_offset);
+    if (!pln) {
+        return nullptr;
     }
 
-    // free this page
     auto page = pln->RemovePage(index);
     if (page) {
         // if it was the last page in the node, remove the node from the tree
         if (pln->IsEmpty()) {
             LTRACEF_LEVEL(2, "%p freeing the list node\n", this);
-            list_.erase(*pln);
+            EraseNode(pln);
         }
+    }
 
-        pmm_free_page(page);
+    return page;
+}
+
+size_t VmPageList::FreePages(uint64_t start_offset, uint64_t end_offset) {
+    DEBUG_ASSERT(IS_PAGE_ALIGNED(start_offset) && IS_PAGE_ALIGNED(end_offset));
+    LTRACEF_LEVEL(2, "%p start %#" PRIx64 " end %#" PRIx64 "\n", this, start_offset, end_offset);
+
+    list_node list;
+    list_initialize(&list);
+
+    // Only visit the nodes that overlap the range; the node holding
+    // start_offset, if any, is the one before the first node after it.
+    auto itr = --list_.upper_bound(start_offset);
+    if (!itr.IsValid()) {
+        itr = list_.begin();
+    }
+    size_t count = 0;
+    while (itr.IsValid() && itr->offset() < end_offset) {
+        VmPageListNode* pln = &*itr;
+        ++itr;
+        count += pln->RemovePages(start_offset, end_offset, &list);
+        if (pln->IsEmpty()) {
+            EraseNode(pln);
+        }
     }
 
-    return ZX_OK;
+    pmm_free(&list);
+
+    return count;
 }
 
 size_t VmPageList::FreeAllPages() {
@@ -166,9 +239,10 @@ size_t VmPageList::FreeAllPages() {
     ForEveryPage(per_page_func);
 
     // return all the pages to the pmm at once
-    pmm_free(&list);
+    pmm_free_background(&list);
 
     // empty the tree
+    last_node_ = nullptr;
     list_.clear();
 
     return count;
@@ -8,14 +8,18 @@
 #include <err.h>
 #include <fbl/alloc_checker.h>
 #include <fbl/array.h>
+#include <kernel/thread.h>
 #include <lib/unittest/unittest.h>
+#include <vm/kstack.h>
 #include <vm/physmap.h>
 #include <vm/vm.h>
 #include <vm/vm_address_region.h>
 #include <vm/vm_aspace.h>
+#include <vm/vm_compressed_page.h>
 #include <vm/vm_object.h>
 #include <vm/vm_object_paged.h>
 #include <vm/vm_object_physical.h>
+#include <vm/vm_page_list.h>
 #include <zircon/types.h>
 
 static const uint kArchRwFlags = ARCH_MMU_FLAG_PERM_READ | ARCH_MMU_FLAG_PERM_WRITE;
@@ -84,6 +88,97 @@ static bool pmm_alloc_contiguous_one_test() {
     END_TEST;
 }
 
+// Allocates an aligned multi-page run and checks its alignment and contiguity.
+static bool pmm_alloc_contiguous_aligned_test() {
+    BEGIN_TEST;
+    list_node list = LIST_INITIAL_VALUE(list);
+    paddr_t pa;
+    static const size_t count = 16;
+    static const uint8_t alignment_log2 = 16; // 64KB
+    zx_status_t status = pmm_alloc_contiguous(count, 0, alignment_log2, &pa, &list);
+    ASSERT_EQ(ZX_OK, status, "pmm_alloc_contiguous returned failure\n");
+    ASSERT_EQ(count, list_length(&list), "pmm_alloc_contiguous list size is wrong");
+    EXPECT_TRUE(IS_ALIGNED(pa, 1ul << alignment_log2), "run is not aligned");
+
+    paddr_t expected = pa;
+    vm_page_t* page;
+    list_for_every_entry (&list, page, vm_page_t, queue_node) {
+        EXPECT_EQ(expected, page->paddr(), "run is not contiguous");
+        expected += PAGE_SIZE;
+    }
+    pmm_free(&list);
+    END_TEST;
+}
+
+// Allocates a whole aligned 2MB block, then asks for an aligned run one page
+// short of it. The allocated block is where the search would first land, and
+// it must be stepped over rather than handed out again.
+static bool pmm_alloc_contiguous_allocated_block_test() {
+    BEGIN_TEST;
+    static const uint8_t alignment_log2 = 21; // 2MB
+    static const size_t block_pages = (1ul << alignment_log2) / PAGE_SIZE;
+    list_node block = LIST_INITIAL_VALUE(block);
+    paddr_t block_pa;
+    ASSERT_EQ(ZX_OK, pmm_alloc_contiguous(block_pages, 0, alignment_log2, &block_pa, &block), "");
+
+    list_node list = LIST_INITIAL_VALUE(list);
+    paddr_t pa;
+    zx_status_t status = pmm_alloc_contiguous(block_pages - 1, 0, alignment_log2, &pa, &list);
+    if (status == ZX_OK) {
+        EXPECT_TRUE(pa + (block_pages - 1) * PAGE_SIZE <= block_pa ||
+                        pa >= block_pa + block_pages * PAGE_SIZE,
+                    "run overlaps an allocated block");
+        pmm_free(&list);
+    }
+    pmm_free(&block);
+    END_TEST;
+}
+
+// Frees single pages so they land in the per-cpu cache, then makes sure they
+// are handed back out and that a specific cached page can still be claimed.
+static bool pmm_pcpu_cache_test() {
+    BEGIN_TEST;
+    static const size_t alloc_count = 8;
+    vm_page_t* pages[alloc_count];
+
+    for (size_t i = 0; i < alloc_count; i++) {
+        ASSERT_EQ(ZX_OK, pmm_alloc_page(0, &pages[i], nullptr), "");
+    }
+    for (size_t i = 0; i < alloc_count; i++) {
+        pmm_free_page(pages[i]);
+    }
+
+    // a freed page must be claimable by address even if it sits in a cache
+    paddr_t pa = pages[0]->paddr();
+    list_node list = LIST_INITIAL_VALUE(list);
+    ASSERT_EQ(ZX_OK, pmm_alloc_range(pa, 1, &list), "pmm_alloc_range of a cached page");
+    ASSERT_EQ(1u, list_length(&list), "");
+    EXPECT_EQ(pa, list_peek_head_type(&list, vm_page_t, queue_node)->paddr(), "");
+    pmm_free(&list);
+
+    END_TEST;
+}
+
+static bool pmm_free_background_test() {
+    BEGIN_TEST;
+    static const size_t alloc_count = 128;
+    list_node list = LIST_INITIAL_VALUE(list);
+
+    ASSERT_EQ(ZX_OK, pmm_alloc_pages(alloc_count, 0, &list), "");
+    paddr_t pa = list_peek_head_type(&list, vm_page_t, queue_node)->paddr();
+
+    pmm_free_background(&list);
+    EXPECT_TRUE(list_is_empty(&list), "");
+
+    // the pages must be claimable by address whether or not the free thread
+    // has gotten to them yet
+    ASSERT_EQ(ZX_OK, pmm_alloc_range(pa, 1, &list), "pmm_alloc_range of a pending page");
+    EXPECT_EQ(pa, list_peek_head_type(&list, vm_page_t, queue_node)->paddr(), "");
+    pmm_free(&list);
+
+    END_TEST;
+}
+
 static uint32_t test_rand(uint32_t seed) {
     return (seed = seed * 1664525 + 1013904223);
 }
@@ -578,6 +673,46 @@ static bool vmo_contiguous_decommit_test() {
     END_TEST;
 }
 
+// Maps a contiguous vm object longer than the coalescer's page array, and
+// makes sure every page ends up mapped to the right physical address.
+static bool vmo_contiguous_map_test() {
+    BEGIN_TEST;
+    static const size_t alloc_size = PAGE_SIZE * 64;
+    fbl::RefPtr<VmObject> vmo;
+    zx_status_t status = VmObjectPaged::CreateContiguous(PMM_ALLOC_FLAG_ANY, alloc_size, 0, &vmo);
+    ASSERT_EQ(status, ZX_OK, "vmobject creation\n");
+
+    paddr_t base_pa;
+    auto lookup_func = [](void* ctx, size_t offset, size_t index, paddr_t pa) {
+        *static_cast<paddr_t*>(ctx) = pa;
+        return ZX_OK;
+    };
+    status = vmo->Lookup(0, PAGE_SIZE, 0, lookup_func, &base_pa);
+    ASSERT_EQ(status, ZX_OK, "vmo lookup\n");
+
+    auto ka = VmAspace::kernel_aspace();
+    void* ptr;
+    auto ret = ka->MapObjectInternal(vmo, "test", 0, alloc_size, &ptr,
+                                     0, VmAspace::VMM_FLAG_COMMIT, kArchRwFlags);
+    ASSERT_EQ(ZX_OK, ret, "mapping object");
+
+    for (size_t i = 0; i < alloc_size / PAGE_SIZE; i++) {
+        paddr_t pa;
+        status = ka->arch_aspace().Query(reinterpret_cast<vaddr_t>(ptr) + i * PAGE_SIZE, &pa,
+                                         nullptr);
+        EXPECT_EQ(ZX_OK, status, "page not mapped");
+        EXPECT_EQ(base_pa + i * PAGE_SIZE, pa, "page mapped to the wrong address");
+    }
+
+    if (!fill_and_test(ptr, alloc_size)) {
+        all_ok = false;
+    }
+
+    auto err = ka->FreeRegion((vaddr_t)ptr);
+    EXPECT_EQ(ZX_OK, err, "unmapping object");
+    END_TEST;
+}
+
 // Creats a vm object, maps it, precommitted.
 static bool vmo_precommitted_map_test() {
     BEGIN_TEST;
@@ -1040,6 +1175,323 @@ static bool arch_noncontiguous_map() {
     END_TEST;
 }
 
+// Checks that unmap and protect take effect in the page tables right away
+// inside a (nested) TLB batch.
+static bool arch_tlb_batch() {
+    BEGIN_TEST;
+
+    paddr_t phys[3];
+    struct list_node phys_list = LIST_INITIAL_VALUE(phys_list);
+    zx_status_t status = pmm_alloc_pages(fbl::count_of(phys), 0, &phys_list);
+    ASSERT_EQ(ZX_OK, status, "tlb batch alloc");
+    {
+        size_t i = 0;
+        vm_page_t* p;
+        list_for_every_entry (&phys_list, p, vm_page_t, queue_node) {
+            phys[i] = p->paddr();
+            ++i;
+        }
+    }
+
+    {
+        ArchVmAspace aspace;
+        status = aspace.Init(USER_ASPACE_BASE, USER_ASPACE_SIZE, 0);
+        ASSERT_EQ(ZX_OK, status, "failed to init aspace\n");
+
+        const uint flags = ARCH_MMU_FLAG_PERM_READ | ARCH_MMU_FLAG_PERM_WRITE;
+        const vaddr_t base = USER_ASPACE_BASE + 10 * PAGE_SIZE;
+        size_t mapped;
+        status = aspace.Map(base, phys, fbl::count_of(phys), flags, &mapped);
+        ASSERT_EQ(ZX_OK, status, "failed map\n");
+
+        aspace.StartTlbBatch();
+        status = aspace.Unmap(base, 1, nullptr);
+        EXPECT_EQ(ZX_OK, status, "failed unmap\n");
+
+        aspace.StartTlbBatch();
+        status = aspace.Protect(base + PAGE_SIZE, 1, ARCH_MMU_FLAG_PERM_READ);
+        EXPECT_EQ(ZX_OK, status, "failed protect\n");
+        aspace.FinishTlbBatch();
+
+        uint mmu_flags;
+        status = aspace.Query(base, nullptr, nullptr);
+        EXPECT_EQ(ZX_ERR_NOT_FOUND, status, "unmap not visible in batch\n");
+        status = aspace.Query(base + PAGE_SIZE, nullptr, &mmu_flags);
+        EXPECT_EQ(ZX_OK, status, "bad protect\n");
+        EXPECT_EQ(ARCH_MMU_FLAG_PERM_READ, mmu_flags, "protect not visible in batch\n");
+        aspace.FinishTlbBatch();
+
+        status = aspace.Query(base + 2 * PAGE_SIZE, nullptr, &mmu_flags);
+        EXPECT_EQ(ZX_OK, status, "bad untouched page\n");
+        EXPECT_EQ(flags, mmu_flags, "bad untouched page\n");
+
+        status = aspace.Unmap(base, fbl::count_of(phys), nullptr);
+        EXPECT_EQ(ZX_OK, status, "failed final unmap\n");
+        status = aspace.Destroy();
+        EXPECT_EQ(ZX_OK, status, "failed to destroy aspace\n");
+    }
+
+    pmm_free(&phys_list);
+
+    END_TEST;
+}
+
+// Maps a large page and checks that partial protect and unmap split it.
+static bool arch_large_page_split() {
+    BEGIN_TEST;
+
+    static const size_t count = LARGE_PAGE_SIZE / PAGE_SIZE;
+    paddr_t base_pa;
+    struct list_node phys_list = LIST_INITIAL_VALUE(phys_list);
+    zx_status_t status = pmm_alloc_contiguous(count, 0, LARGE_PAGE_SIZE_SHIFT, &base_pa,
+                                              &phys_list);
+    ASSERT_EQ(ZX_OK, status, "large page alloc");
+
+    {
+        ArchVmAspace aspace;
+        status = aspace.Init(USER_ASPACE_BASE, USER_ASPACE_SIZE, 0);
+        ASSERT_EQ(ZX_OK, status, "failed to init aspace\n");
+
+        const uint rw = ARCH_MMU_FLAG_PERM_READ | ARCH_MMU_FLAG_PERM_WRITE;
+        vaddr_t base = ROUNDUP(USER_ASPACE_BASE + LARGE_PAGE_SIZE, LARGE_PAGE_SIZE);
+        size_t mapped;
+        status = aspace.MapContiguous(base, base_pa, count, rw, &mapped);
+        ASSERT_EQ(ZX_OK, status, "failed large map\n");
+        EXPECT_EQ(count, mapped, "weird large map\n");
+
+        status = aspace.Protect(base + 3 * PAGE_SIZE, 1, ARCH_MMU_FLAG_PERM_READ);
+        EXPECT_EQ(ZX_OK, status, "failed partial protect\n");
+        size_t unmapped;
+        status = aspace.Unmap(base + 5 * PAGE_SIZE, 1, &unmapped);
+        EXPECT_EQ(ZX_OK, status, "failed partial unmap\n");
+
+        for (size_t i = 0; i < count; ++i) {
+            paddr_t paddr;
+            uint mmu_flags;
+            status = aspace.Query(base + i * PAGE_SIZE, &paddr, &mmu_flags);
+            if (i == 5) {
+                EXPECT_EQ(ZX_ERR_NOT_FOUND, status, "page not unmapped\n");
+                continue;
+            }
+            EXPECT_EQ(ZX_OK, status, "lost page after split\n");
+            EXPECT_EQ(base_pa + i * PAGE_SIZE, paddr, "bad paddr after split\n");
+            EXPECT_EQ(i == 3 ? ARCH_MMU_FLAG_PERM_READ : rw, mmu_flags,
+                      "bad flags after split\n");
+        }
+
+        status = aspace.Unmap(base, count, &unmapped);
+        EXPECT_EQ(ZX_OK, status, "failed unmap\n");
+        status = aspace.Destroy();
+        EXPECT_EQ(ZX_OK, status, "failed to destroy aspace\n");
+    }
+
+    pmm_free(&phys_list);
+
+    END_TEST;
+}
+
+// Round trips pages through VmCompressedPage.
+static bool vm_compressed_page_test() {
+    BEGIN_TEST;
+
+    vm_page_t* src_page;
+    vm_page_t* dst_page;
+    paddr_t src_pa;
+    paddr_t dst_pa;
+    ASSERT_EQ(ZX_OK, pmm_alloc_page(0, &src_page, &src_pa), "pmm_alloc_page\n");
+    ASSERT_EQ(ZX_OK, pmm_alloc_page(0, &dst_page, &dst_pa), "pmm_alloc_page\n");
+    auto src = static_cast<uint8_t*>(paddr_to_physmap(src_pa));
+    auto dst = static_cast<uint8_t*>(paddr_to_physmap(dst_pa));
+
+    // A repeating pattern compresses well and comes back intact.
+    for (size_t i = 0; i < PAGE_SIZE; i++) {
+        src[i] = static_cast<uint8_t>(i % 7);
+    }
+    fbl::unique_ptr<VmCompressedPage> compressed = VmCompressedPage::Create(0, src_pa);
+    ASSERT_TRUE(compressed, "compressible page\n");
+    EXPECT_LT(compressed->size(), static_cast<size_t>(PAGE_SIZE), "compressed size\n");
+    memset(dst, 0xff, PAGE_SIZE);
+    EXPECT_EQ(ZX_OK, compressed->Decompress(dst_pa), "decompress\n");
+    EXPECT_EQ(0, memcmp(src, dst, PAGE_SIZE), "decompressed contents\n");
+
+    // Noise doesn't compress, and isn't kept.
+    uint32_t x = 1;
+    for (size_t i = 0; i < PAGE_SIZE; i++) {
+        x = x * 1103515245 + 12345;
+        src[i] = static_cast<uint8_t>(x >> 16);
+    }
+    compressed = VmCompressedPage::Create(0, src_pa);
+    EXPECT_FALSE(compressed, "incompressible page\n");
+
+    pmm_free_page(src_page);
+    pmm_free_page(dst_page);
+
+    END_TEST;
+}
+
+// Checks that only aged, all-zero pages of a VMO are reclaimed.
+static bool vmo_reclaim_test() {
+    BEGIN_TEST;
+
+    static const size_t alloc_size = PAGE_SIZE * 16;
+    fbl::RefPtr<VmObject> vmo;
+    zx_status_t status = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u, alloc_size, &vmo);
+    ASSERT_EQ(status, ZX_OK, "vmobject creation\n");
+    ASSERT_TRUE(vmo, "vmobject creation\n");
+    // Only user visible VMOs are eligible.
+    vmo->set_user_id(1);
+
+    uint64_t committed;
+    status = vmo->CommitRange(0, alloc_size, &committed);
+    ASSERT_EQ(ZX_OK, status, "committing vm object\n");
+
+    const uint8_t data = 0x5a;
+    status = vmo->Write(&data, 3 * PAGE_SIZE, sizeof(data));
+    ASSERT_EQ(ZX_OK, status, "writing vm object\n");
+
+    // Freshly committed pages are too young.
+    EXPECT_EQ(0u, vmo->ReclaimPages(2, SIZE_MAX), "reclaim before aging\n");
+
+    vmo->AgePages();
+    vmo->AgePages();
+
+    // Every page is old enough now, but the one holding data must stay.
+    EXPECT_EQ(15u, vmo->ReclaimPages(2, SIZE_MAX), "reclaim after aging\n");
+    EXPECT_EQ(1u, vmo->AllocatedPages(), "pages left after reclaim\n");
+
+    uint8_t readback = 0;
+    status = vmo->Read(&readback, 3 * PAGE_SIZE, sizeof(readback));
+    EXPECT_EQ(ZX_OK, status, "reading vm object\n");
+    EXPECT_EQ(data, readback, "data preserved by reclaim\n");
+
+    END_TEST;
+}
+
+// Checks that hiding a cloned VMO frees the pages its clones can't see, and
+// that an empty hidden clone is taken out of the chain.
+static bool vmo_hidden_clone_test() {
+    BEGIN_TEST;
+
+    static const size_t alloc_size = PAGE_SIZE * 16;
+    fbl::RefPtr<VmObject> vmo;
+    zx_status_t status = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u, alloc_size, &vmo);
+    ASSERT_EQ(status, ZX_OK, "vmobject creation\n");
+
+    uint64_t committed;
+    status = vmo->CommitRange(0, alloc_size, &committed);
+    ASSERT_EQ(ZX_OK, status, "committing vm object\n");
+    const uint8_t data = 0x5a;
+    status = vmo->Write(&data, 5 * PAGE_SIZE, sizeof(data));
+    ASSERT_EQ(ZX_OK, status, "writing vm object\n");
+
+    fbl::RefPtr<VmObject> clone;
+    status = vmo->CloneCOW(false, 4 * PAGE_SIZE, 4 * PAGE_SIZE, false, &clone);
+    ASSERT_EQ(ZX_OK, status, "cloning vm object\n");
+    fbl::RefPtr<VmObject> clone2;
+    status = clone->CloneCOW(false, 0, 4 * PAGE_SIZE, false, &clone2);
+    ASSERT_EQ(ZX_OK, status, "cloning clone\n");
+
+    // The parent is only hidden once the last of its dispatchers goes away,
+    // and then only the pages under the clone survive.
+    vmo->AddDispatcher();
+    vmo->AddDispatcher();
+    vmo->RemoveDispatcher();
+    EXPECT_EQ(16u, vmo->AllocatedPages(), "pages left while still reachable\n");
+    vmo->RemoveDispatcher();
+    EXPECT_EQ(4u, vmo->AllocatedPages(), "pages left after hiding\n");
+
+    // The first clone has no pages of its own, so hiding it moves its clone
+    // over to read straight from the original.
+    clone->AddDispatcher();
+    clone->RemoveDispatcher();
+    EXPECT_EQ(0u, clone->num_children(), "hidden clone children\n");
+    clone.reset();
+    EXPECT_EQ(1u, vmo->num_children(), "children after collapse\n");
+
+    uint8_t readback = 0;
+    status = clone2->Read(&readback, PAGE_SIZE, sizeof(readback));
+    EXPECT_EQ(ZX_OK, status, "reading clone\n");
+    EXPECT_EQ(data, readback, "clone reads through to the original\n");
+
+    END_TEST;
+}
+
+// Fills a page list across several nodes and frees a range out of the middle.
+static bool vmpl_free_pages_test() {
+    BEGIN_TEST;
+
+    static const size_t kCount = VmPageListNode::kPageFanOut * 3;
+    vm_page_t* pages[kCount];
+    list_node list = LIST_INITIAL_VALUE(list);
+    zx_status_t status = pmm_alloc_pages(kCount, 0, &list);
+    ASSERT_EQ(ZX_OK, status, "pmm_alloc_pages");
+
+    VmPageList pl;
+    for (size_t i = 0; i < kCount; i++) {
+        pages[i] = list_remove_head_type(&list, vm_page_t, queue_node);
+        EXPECT_EQ(ZX_OK, pl.AddPage(pages[i], i * PAGE_SIZE), "add page\n");
+    }
+    for (size_t i = 0; i < kCount; i++) {
+        EXPECT_EQ(pages[i], pl.GetPage(i * PAGE_SIZE), "get page\n");
+    }
+
+    // free a range that starts and ends in the middle of a node
+    const size_t first = VmPageListNode::kPageFanOut / 2;
+    const size_t last = kCount - VmPageListNode::kPageFanOut / 2;
+    EXPECT_EQ(last - first, pl.FreePages(first * PAGE_SIZE, last * PAGE_SIZE), "free pages\n");
+    for (size_t i = 0; i < kCount; i++) {
+        vm_page_t* expected = (i >= first && i < last) ? nullptr : pages[i];
+        EXPECT_EQ(expected, pl.GetPage(i * PAGE_SIZE), "get page after free\n");
+    }
+
+    size_t visited = 0;
+    pl.ForEveryPageInRange([&visited](const auto, uint64_t) {
+        visited++;
+        return ZX_ERR_NEXT;
+    }, 0, kCount * PAGE_SIZE);
+    EXPECT_EQ(kCount - (last - first), visited, "pages left\n");
+
+    EXPECT_EQ(0u, pl.FreePages(first * PAGE_SIZE, last * PAGE_SIZE), "free empty range\n");
+    EXPECT_EQ(kCount - (last - first), pl.FreeAllPages(), "free all pages\n");
+    EXPECT_TRUE(pl.IsEmpty(), "page list empty\n");
+
+    END_TEST;
+}
+
+// Stacks that are freed and allocated again, possibly through the kstack
+// cache, must come back zeroed and mapped.
+static bool kstack_reuse_test() {
+    BEGIN_TEST;
+
+    static const size_t kCount = 8;
+    kstack_t stacks[kCount] = {};
+    for (size_t i = 0; i < kCount; i++) {
+        ASSERT_EQ(ZX_OK, vm_allocate_kstack(&stacks[i]), "allocate stack\n");
+        memset(reinterpret_cast<void*>(stacks[i].base), 0xa5, DEFAULT_STACK_SIZE);
+    }
+    for (size_t i = 0; i < kCount; i++) {
+        ASSERT_EQ(ZX_OK, vm_free_kstack(&stacks[i]), "free stack\n");
+        EXPECT_EQ(0u, stacks[i].base, "stack cleared\n");
+        EXPECT_EQ(nullptr, stacks[i].vmar, "stack cleared\n");
+    }
+    for (size_t i = 0; i < kCount; i++) {
+        ASSERT_EQ(ZX_OK, vm_allocate_kstack(&stacks[i]), "allocate stack\n");
+        EXPECT_EQ(static_cast<size_t>(DEFAULT_STACK_SIZE), stacks[i].size, "stack size\n");
+        EXPECT_EQ(stacks[i].base + DEFAULT_STACK_SIZE, stacks[i].top, "stack top\n");
+        auto words = reinterpret_cast<const uint64_t*>(stacks[i].base);
+        bool zero = true;
+        for (size_t j = 0; j < DEFAULT_STACK_SIZE / sizeof(uint64_t); j++) {
+            zero = zero && words[j] == 0;
+        }
+        EXPECT_TRUE(zero, "stack is zeroed\n");
+    }
+    for (size_t i = 0; i < kCount; i++) {
+        EXPECT_EQ(ZX_OK, vm_free_kstack(&stacks[i]), "free stack\n");
+    }
+
+    END_TEST;
+}
+
 // Use the function name as the test name
 #define VM_UNITTEST(fname) UNITTEST(#fname, fname)
 
@@ -1049,6 +1501,10 @@ VM_UNITTEST(pmm_smoke_test)
 //VM_UNITTEST(pmm_large_alloc_test)
 //VM_UNITTEST(pmm_oversized_alloc_test)
 VM_UNITTEST(pmm_alloc_contiguous_one_test)
+VM_UNITTEST(pmm_alloc_contiguous_aligned_test)
+VM_UNITTEST(pmm_alloc_contiguous_allocated_block_test)
+VM_UNITTEST(pmm_pcpu_cache_test)
+VM_UNITTEST(pmm_free_background_test)
 VM_UNITTEST(vmm_alloc_smoke_test)
 VM_UNITTEST(vmm_alloc_contiguous_smoke_test)
 VM_UNITTEST(multiple_regions_test)
@@ -1066,6 +1522,7 @@ VM_UNITTEST(vmo_odd_size_commit_test)
 VM_UNITTEST(vmo_create_physical_test)
 VM_UNITTEST(vmo_create_contiguous_test)
 VM_UNITTEST(vmo_contiguous_decommit_test)
+VM_UNITTEST(vmo_contiguous_map_test)
 VM_UNITTEST(vmo_precommitted_map_test)
 VM_UNITTEST(vmo_demand_paged_map_test)
 VM_UNITTEST(vmo_dropped_ref_test)
@@ -1074,7 +1531,14 @@ VM_UNITTEST(vmo_double_remap_test)
 VM_UNITTEST(vmo_read_write_smoke_test)
 VM_UNITTEST(vmo_cache_test)
 VM_UNITTEST(vmo_lookup_test)
+VM_UNITTEST(vmo_reclaim_test)
+VM_UNITTEST(vm_compressed_page_test)
+VM_UNITTEST(vmo_hidden_clone_test)
 VM_UNITTEST(arch_noncontiguous_map)
+VM_UNITTEST(arch_large_page_split)
+VM_UNITTEST(arch_tlb_batch)
+VM_UNITTEST(vmpl_free_pages_test)
+VM_UNITTEST(kstack_reuse_test)
 // Uncomment for debugging
 // VM_UNITTEST(dump_all_aspaces)  // Run last
 UNITTEST_END_TESTCASE(vm_tests, "vmtests", "Virtual memory tests");
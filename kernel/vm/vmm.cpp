@@ -13,6 +13,7 @@
 #include <kernel/thread_lock.h>
 #include <lib/console.h>
 #include <lib/ktrace.h>
+#include <object/c_user_thread.h>
 #include <object/diagnostics.h>
 #include <string.h>
 #include <trace.h>
@@ -26,6 +27,9 @@
 #define LOCAL_TRACE MAX(VM_GLOBAL_TRACE, 0)
 #define TRACE_PAGE_FAULT 0
 
+// page faults a user thread takes before they are charged to its task counters
+static constexpr uint32_t kPageFaultChargeBatch = 32;
+
 // This file mostly contains C wrappers around the underlying C++ objects, conforming to
 // the older api.
 
@@ -61,6 +65,16 @@ zx_status_t vmm_page_fault_handler(vaddr_t addr, uint flags) {
     // page fault it
     zx_status_t status = aspace->PageFault(addr, flags);
 
+    // count faults on user memory against the faulting thread's process,
+    // charging its task counters in batches
+    if (aspace->is_user()) {
+        thread_t* t = get_current_thread();
+        if (t->user_thread && ++t->uncharged_page_faults >= kPageFaultChargeBatch) {
+            user_thread_charge_usage(t->user_thread, 0, 0, t->uncharged_page_faults);
+            t->uncharged_page_faults = 0;
+        }
+    }
+
     // If it's a user fault, dump info about process memory usage.
     // If it's a kernel fault, the kernel could possibly already
     // hold locks on VMOs, Aspaces, etc, so we can't safely do
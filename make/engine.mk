@@ -27,6 +27,7 @@ ENABLE_INSTALL_SAMPLES ?= false
 ENABLE_NEW_BOOTDATA := true
 ENABLE_LOCK_DEP ?= false
 ENABLE_LOCK_DEP_TESTS ?= $(ENABLE_LOCK_DEP)
+ENABLE_LOCK_PROF ?= false
 DISABLE_UTEST ?= false
 ENABLE_ULIB_ONLY ?= false
 USE_ASAN ?= false
@@ -421,6 +422,16 @@ KERNEL_DEFINES += WITH_LOCK_DEP=1
 KERNEL_DEFINES += LOCK_DEP_ENABLE_VALIDATION=1
 endif
 
+# Kernel lock contention profiling. This builds on lock dependency tracking,
+# which provides the lock classes the statistics are kept for.
+ifeq ($(call TOBOOL,$(ENABLE_LOCK_PROF)),true)
+ifneq ($(call TOBOOL,$(ENABLE_LOCK_DEP)),true)
+$(error ENABLE_LOCK_PROF requires ENABLE_LOCK_DEP)
+endif
+KERNEL_DEFINES += WITH_LOCK_PROF=1
+KERNEL_DEFINES += LOCK_DEP_ENABLE_PROFILING=1
+endif
+
 # Kernel lock dependency tracking tests. By default this is enabled when
 # tracking is enabled, but can also be eanbled independently to assess whether
 # the tests build and *fail correctly* when lockdep is disabled.
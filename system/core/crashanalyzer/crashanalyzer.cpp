@@ -322,10 +322,9 @@ static void process_report(zx_handle_t process, zx_handle_t thread, zx_handle_t
         inspector_dso_print_list(stdout, dso_list);
         inspector_print_markup_context(stdout, process);
         // TODO (jakehehrlich): Remove the old backtrace format.
-        inspector_print_backtrace(stdout, process, thread, dso_list,
-                                  pc, sp, fp, use_libunwind);
-        inspector_print_backtrace_markup(stdout, process, thread, dso_list,
-                                         pc, sp, fp, use_libunwind);
+        inspector_print_backtraces(stdout, process, thread, dso_list,
+                                   pc, sp, fp, use_libunwind);
+        inspector_dso_free_list(dso_list);
     }
 
     // TODO(ZX-588): Print a backtrace of all other threads in the process.
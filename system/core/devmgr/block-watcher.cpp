@@ -59,6 +59,13 @@ public:
     // if "zircon.system.filesystem-check" is set.
     zx_status_t CheckFilesystem(const char* device_path, disk_format_t df) const;
 
+    // Returns true if blobfs should verify its blobs after it is mounted rather
+    // than during fsck.
+    bool VerifyBlobsInBackground() const {
+        return getenv_bool("zircon.system.filesystem-check", false) &&
+               getenv_bool("zircon.system.blobfs-verify-in-background", false);
+    }
+
     // Attempts to mount a block device backed by |fd| to "/data".
     // Fails if already mounted.
     zx_status_t MountData(fbl::unique_fd fd, mount_options_t* options);
@@ -387,7 +394,12 @@ zx_status_t BlockWatcher::CheckFilesystem(const char* device_path, disk_format_t
     }
 
     printf("fshost: fsck of %s started\n", disk_format_string_[df]);
-    const fsck_options_t* options = &default_fsck_options;
+    fsck_options_t fsck_options = default_fsck_options;
+    if (df == DISK_FORMAT_BLOBFS) {
+        // The blobs are verified by blobfs itself once it is mounted.
+        fsck_options.verify_in_background = VerifyBlobsInBackground();
+    }
+    const fsck_options_t* options = &fsck_options;
 
     auto launch_fsck = [](int argc, const char** argv, zx_handle_t* hnd, uint32_t* ids,
                           size_t len) {
@@ -591,6 +603,7 @@ zx_status_t block_device_added(int dirfd, int event, const char* name, void* coo
 
         mount_options_t options = default_mount_options;
         options.enable_journal = true;
+        options.verify_in_background = watcher->VerifyBlobsInBackground();
         zx_status_t status = watcher->MountBlob(fbl::move(fd), &options);
         if (status != ZX_OK) {
             printf("devmgr: Failed to mount blobfs partition %s at %s: %s.\n",
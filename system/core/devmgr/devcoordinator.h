@@ -291,6 +291,9 @@ struct Driver {
     // Binding size in number of bytes, not number of entries
     // TODO: Change it to number of entries
     uint32_t binding_size = 0;
+    // The protocol a device must have for the binding to match, or 0 if the
+    // binding does not require a particular protocol up front.
+    uint32_t bind_protocol = 0;
     uint32_t flags = 0;
     zx::vmo dso_vmo;
 
@@ -324,6 +327,11 @@ bool dc_is_bindable(const Driver* drv, uint32_t protocol_id,
                     zx_device_prop_t* props, size_t prop_count,
                     bool autobind);
 
+// Returns the protocol the bind program requires before it can match,
+// or 0 if it has none. Used to skip evaluating the program for devices
+// that cannot match.
+uint32_t dc_bind_protocol(const zx_bind_inst_t* binding, size_t count);
+
 extern bool dc_asan_drivers;
 extern bool dc_launched_first_devhost;
 
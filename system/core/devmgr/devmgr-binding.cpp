@@ -140,6 +140,21 @@ next_instruction:
     return false;
 }
 
+uint32_t dc_bind_protocol(const zx_bind_inst_t* binding, size_t count) {
+    // Only a leading run of aborts is considered: they cannot change the
+    // flags or jump, so every match must get past all of them.
+    for (size_t i = 0; i < count; i++) {
+        uint32_t inst = binding[i].op;
+        if (BINDINST_OP(inst) != OP_ABORT) {
+            break;
+        }
+        if (BINDINST_CC(inst) == COND_NE && BINDINST_PB(inst) == BIND_PROTOCOL) {
+            return binding[i].arg;
+        }
+    }
+    return 0;
+}
+
 bool dc_is_bindable(const Driver* drv, uint32_t protocol_id,
                     zx_device_prop_t* props, size_t prop_count,
                     bool autobind) {
@@ -154,6 +169,10 @@ bool dc_is_bindable(const Driver* drv, uint32_t protocol_id,
     ctx.binding_size = drv->binding_size;
     ctx.name = drv->name.c_str();
     ctx.autobind = autobind ? 1 : 0;
+    if (drv->bind_protocol != 0 &&
+        dev_get_prop(&ctx, BIND_PROTOCOL) != drv->bind_protocol) {
+        return false;
+    }
     return is_bindable(&ctx);
 }
 
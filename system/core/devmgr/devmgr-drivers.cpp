@@ -71,6 +71,7 @@ static void found_driver(zircon_driver_note_payload_t* note,
     memcpy(binding.get(), bi, bindlen);
     drv->binding.reset(binding.release());
     drv->binding_size = static_cast<uint32_t>(bindlen);
+    drv->bind_protocol = dc_bind_protocol(drv->binding.get(), note->bindcount);
 
     drv->libname.Set(libname);
     drv->name.Set(note->name);
@@ -302,7 +302,8 @@ int service_starter(void* arg) {
     __UNUSED bool netboot = false;
     bool vruncmd = false;
     if (!getenv_bool("netsvc.disable", false)) {
-        const char* args[] = {"/boot/bin/netsvc", nullptr, nullptr, nullptr, nullptr, nullptr};
+        const char* args[] = {"/boot/bin/netsvc", nullptr, nullptr, nullptr, nullptr, nullptr,
+                              nullptr, nullptr};
         int argc = 1;
 
         if (getenv_bool("netsvc.netboot", false)) {
@@ -321,6 +322,12 @@ int service_starter(void* arg) {
             args[argc++] = interface;
         }
 
+        const char* spin_us;
+        if ((spin_us = getenv("netsvc.spin-us")) != nullptr) {
+            args[argc++] = "--spin-us";
+            args[argc++] = spin_us;
+        }
+
         const char* nodename = getenv("zircon.nodename");
         if (nodename) {
             args[argc++] = nodename;
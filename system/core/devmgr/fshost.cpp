@@ -7,6 +7,7 @@
 
 #include <bootdata/decompress.h>
 
+#include <fbl/algorithm.h>
 #include <fbl/function.h>
 #include <fbl/intrusive_single_list.h>
 #include <fbl/unique_fd.h>
@@ -185,6 +186,51 @@ int RamctlWatcher(void* arg) {
     return 0;
 }
 
+// Runs the decompressor's calls on their own threads, except the first,
+// which runs on the calling thread.
+constexpr size_t kMaxDecompressThreads = 8;
+
+struct DecompressCall {
+    void (*fn)(void* arg, size_t i);
+    void* arg;
+    size_t i;
+};
+
+int DecompressThread(void* arg) {
+    auto call = static_cast<DecompressCall*>(arg);
+    call->fn(call->arg, call->i);
+    return 0;
+}
+
+void RunDecompressThreads(void* ctx, void (*fn)(void* arg, size_t i), void* arg, size_t count) {
+    DecompressCall calls[kMaxDecompressThreads];
+    thrd_t threads[kMaxDecompressThreads];
+    bool started[kMaxDecompressThreads] = {};
+    for (size_t i = 1; i < count; i++) {
+        calls[i] = {fn, arg, i};
+        started[i] = thrd_create_with_name(&threads[i], DecompressThread, &calls[i],
+                                           "bootfs-lz4") == thrd_success;
+        if (!started[i]) {
+            fn(arg, i);
+        }
+    }
+    fn(arg, 0);
+    for (size_t i = 1; i < count; i++) {
+        if (started[i]) {
+            thrd_join(threads[i], nullptr);
+        }
+    }
+}
+
+const decompress_threads_t* DecompressThreads() {
+    static const decompress_threads_t threads = {
+        RunDecompressThreads,
+        nullptr,
+        fbl::min<size_t>(zx_system_get_num_cpus(), kMaxDecompressThreads),
+    };
+    return &threads;
+}
+
 #define HND_BOOTFS(n) PA_HND(PA_VMO_BOOTFS, n)
 #define HND_BOOTDATA(n) PA_HND(PA_VMO_BOOTDATA, n)
 
@@ -238,9 +284,9 @@ void SetupBootfs(const fbl::unique_ptr<FsManager>& root,
             case BOOTDATA_BOOTFS_SYSTEM: {
                 const char* errmsg;
                 zx_handle_t bootfs_vmo;
-                status = decompress_bootdata(zx_vmar_root_self(), vmo.get(),
-                                             off, bootdata.length + sizeof(bootdata_t),
-                                             &bootfs_vmo, &errmsg);
+                status = decompress_bootdata_threads(zx_vmar_root_self(), vmo.get(),
+                                                     off, bootdata.length + sizeof(bootdata_t),
+                                                     DecompressThreads(), &bootfs_vmo, &errmsg);
                 if (status < 0) {
                     printf("devmgr: failed to decompress bootdata: %s\n", errmsg);
                 } else {
@@ -251,10 +297,10 @@ void SetupBootfs(const fbl::unique_ptr<FsManager>& root,
             case BOOTDATA_RAMDISK: {
                 const char* errmsg;
                 zx_handle_t ramdisk_vmo;
-                status = decompress_bootdata(
+                status = decompress_bootdata_threads(
                     zx_vmar_root_self(), vmo.get(),
                     off, bootdata.length + sizeof(bootdata_t),
-                    &ramdisk_vmo, &errmsg);
+                    DecompressThreads(), &ramdisk_vmo, &errmsg);
                 if (status != ZX_OK) {
                     printf("fshost: failed to decompress bootdata: %s\n",
                            errmsg);
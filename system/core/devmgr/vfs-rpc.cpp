@@ -33,6 +33,8 @@
 namespace devmgr {
 namespace {
 
+constexpr uint32_t kRootDispatcherMaxThreads = 4;
+
 zx_status_t AddVmofile(fbl::RefPtr<memfs::VnodeDir> vnb, const char* path, zx_handle_t vmo,
                        zx_off_t off, size_t len) {
     zx_status_t r;
@@ -92,8 +94,13 @@ FsManager::FsManager() {
         ZX_ASSERT(status == ZX_OK);
     }
 
+    // Serve the in-memory filesystems, in particular "/tmp", from several
+    // threads, so that I/O to independent files proceeds in parallel.
     global_loop_.reset(new async::Loop(&kAsyncLoopConfigNoAttachToThread));
-    global_loop_->StartThread("root-dispatcher");
+    uint32_t threads = fbl::clamp(zx_system_get_num_cpus(), 1u, kRootDispatcherMaxThreads);
+    for (uint32_t i = 0; i < threads; i++) {
+        global_loop_->StartThread("root-dispatcher");
+    }
     root_vfs_.SetDispatcher(global_loop_->dispatcher());
     system_vfs_.SetDispatcher(global_loop_->dispatcher());
 }
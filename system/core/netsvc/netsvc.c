@@ -144,6 +144,14 @@ int main(int argc, char** argv) {
             // Advance args one position. The second arg will be advanced below.
             argv++;
             argc--;
+        } else if (!strncmp(argv[1], "--spin-us", 9)) {
+            if (argc < 3) {
+                printf("netsvc: fatal error: missing argument to --spin-us\n");
+                return -1;
+            }
+            netifc_set_spin_budget(strtoul(argv[2], NULL, 10));
+            argv++;
+            argc--;
         } else {
             nodename = argv[1];
             nodename_provided = true;
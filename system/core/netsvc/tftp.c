@@ -148,9 +148,12 @@ static int drain_pipe(void* arg) {
 
 // Pushes all data from the paver buffer (filled by netsvc) into the paver input pipe. When
 // there's no data to copy, blocks on data_ready until more data is written into the buffer.
+// Pages are decommitted once their data is in the pipe, so that memory use follows the data
+// in flight rather than the size of the image.
 static int paver_copy_buffer(void* arg) {
     file_info_t* file_info = arg;
     size_t read_ndx = 0;
+    size_t decommit_ndx = 0;
     int result = 0;
     zx_time_t last_reported = zx_clock_get_monotonic();
     while (read_ndx < file_info->paver.size) {
@@ -176,6 +179,12 @@ static int paver_copy_buffer(void* arg) {
                 goto done;
             }
             read_ndx += r;
+            size_t consumed = read_ndx & ~((size_t)PAGE_SIZE - 1);
+            if (consumed > decommit_ndx) {
+                zx_vmo_op_range(file_info->paver.buffer_handle, ZX_VMO_OP_DECOMMIT, decommit_ndx,
+                                consumed - decommit_ndx, NULL, 0);
+                decommit_ndx = consumed;
+            }
             zx_time_t curr_time = zx_clock_get_monotonic();
             if (zx_time_sub_time(curr_time, last_reported) >= ZX_SEC(1)) {
                 float complete = ((float)read_ndx / (float)file_info->paver.size) * 100.0;
@@ -9,13 +9,100 @@
 
 #include <bootdata/decompress.h>
 #include <zircon/boot/bootdata.h>
+#include <zircon/stack.h>
 #include <zircon/syscalls.h>
+#include <stdnoreturn.h>
 #include <string.h>
 
 #pragma GCC visibility pop
 
-zx_handle_t bootdata_get_bootfs(zx_handle_t log, zx_handle_t vmar_self,
-                                zx_handle_t bootdata_vmo) {
+// Userboot has no libc, so decompression runs on bare threads that make
+// one call into the decompressor each and exit. The calling thread makes
+// the first call itself.
+#define DECOMPRESS_MAX_THREADS 8
+#define DECOMPRESS_STACK_SIZE (32 << 10)
+#define DECOMPRESS_THREAD_NAME "userboot-lz4"
+
+struct decompress_ctx {
+    zx_handle_t log;
+    zx_handle_t proc;
+    zx_handle_t vmar;
+};
+
+struct decompress_call {
+    void (*fn)(void* arg, size_t i);
+    void* arg;
+    size_t i;
+};
+
+static noreturn void decompress_thread(uintptr_t arg1, uintptr_t arg2) {
+    const struct decompress_call* call = (const struct decompress_call*)arg1;
+    call->fn(call->arg, call->i);
+    zx_thread_exit();
+}
+
+static void run_decompress_threads(void* ctx, void (*fn)(void* arg, size_t i),
+                                   void* arg, size_t count) {
+    const struct decompress_ctx* dc = ctx;
+    struct decompress_call calls[DECOMPRESS_MAX_THREADS];
+    zx_handle_t threads[DECOMPRESS_MAX_THREADS];
+
+    size_t stacks_size = (count - 1) * DECOMPRESS_STACK_SIZE;
+    zx_handle_t stack_vmo;
+    zx_status_t status = zx_vmo_create(stacks_size, 0, &stack_vmo);
+    check(dc->log, status, "zx_vmo_create failed for decompression stacks");
+    uintptr_t stacks;
+    status = zx_vmar_map(dc->vmar, ZX_VM_PERM_READ | ZX_VM_PERM_WRITE, 0,
+                         stack_vmo, 0, stacks_size, &stacks);
+    check(dc->log, status, "zx_vmar_map failed for decompression stacks");
+    zx_handle_close(stack_vmo);
+
+    for (size_t i = 1; i < count; ++i) {
+        calls[i] = (struct decompress_call){fn, arg, i};
+        threads[i] = ZX_HANDLE_INVALID;
+        status = zx_thread_create(dc->proc, DECOMPRESS_THREAD_NAME,
+                                  sizeof(DECOMPRESS_THREAD_NAME) - 1, 0, &threads[i]);
+        if (status == ZX_OK) {
+            uintptr_t sp = compute_initial_stack_pointer(
+                stacks + (i - 1) * DECOMPRESS_STACK_SIZE, DECOMPRESS_STACK_SIZE);
+            status = zx_thread_start(threads[i], (uintptr_t)decompress_thread, sp,
+                                     (uintptr_t)&calls[i], 0);
+            if (status != ZX_OK) {
+                zx_handle_close(threads[i]);
+                threads[i] = ZX_HANDLE_INVALID;
+            }
+        }
+        if (threads[i] == ZX_HANDLE_INVALID) {
+            // Do this share here instead.
+            fn(arg, i);
+        }
+    }
+
+    fn(arg, 0);
+
+    for (size_t i = 1; i < count; ++i) {
+        if (threads[i] != ZX_HANDLE_INVALID) {
+            status = zx_object_wait_one(threads[i], ZX_THREAD_TERMINATED,
+                                        ZX_TIME_INFINITE, NULL);
+            check(dc->log, status, "zx_object_wait_one failed on decompression thread");
+            zx_handle_close(threads[i]);
+        }
+    }
+    zx_vmar_unmap(dc->vmar, stacks, stacks_size);
+}
+
+zx_handle_t bootdata_get_bootfs(zx_handle_t log, zx_handle_t proc_self,
+                                zx_handle_t vmar_self, zx_handle_t bootdata_vmo) {
+    struct decompress_ctx ctx = {log, proc_self, vmar_self};
+    decompress_threads_t threads = {
+        .run = run_decompress_threads,
+        .ctx = &ctx,
+        .max_threads = zx_system_get_num_cpus(),
+    };
+    if (threads.max_threads > DECOMPRESS_MAX_THREADS) {
+        threads.max_threads = DECOMPRESS_MAX_THREADS;
+    }
+
     size_t off = 0;
     for (;;) {
         bootdata_t bootdata;
@@ -39,9 +126,9 @@ zx_handle_t bootdata_get_bootfs(zx_handle_t log, zx_handle_t vmar_self,
         case BOOTDATA_BOOTFS_BOOT:;
             const char* errmsg;
             zx_handle_t bootfs_vmo;
-            status = decompress_bootdata(vmar_self, bootdata_vmo, off,
-                                         bootdata.length + sizeof(bootdata),
-                                         &bootfs_vmo, &errmsg);
+            status = decompress_bootdata_threads(vmar_self, bootdata_vmo, off,
+                                                 bootdata.length + sizeof(bootdata),
+                                                 &threads, &bootfs_vmo, &errmsg);
             check(log, status, "%s", errmsg);
 
             // Signal that we've already processed this one.
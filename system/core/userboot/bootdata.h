@@ -8,7 +8,9 @@
 
 #include <zircon/types.h>
 
-zx_handle_t bootdata_get_bootfs(zx_handle_t log, zx_handle_t vmar_self,
-                                zx_handle_t bootdata_vmo);
+// Decompresses the first bootfs item of |bootdata_vmo|, using threads in
+// |proc_self| when there are several cpus.
+zx_handle_t bootdata_get_bootfs(zx_handle_t log, zx_handle_t proc_self,
+                                zx_handle_t vmar_self, zx_handle_t bootdata_vmo);
 
 #pragma GCC visibility pop
@@ -197,7 +197,7 @@ static noreturn void bootstrap(zx_handle_t log, zx_handle_t bootstrap_pipe) {
 
     // Hang on to our own process handle.  If we closed it, our process
     // would be killed.  Exiting will clean it up.
-    __UNUSED const zx_handle_t proc_self = *proc_handle_loc;
+    const zx_handle_t proc_self = *proc_handle_loc;
     const zx_handle_t vmar_self = *vmar_root_handle_loc;
 
     // Hang on to the resource root handle.
@@ -210,7 +210,7 @@ static noreturn void bootstrap(zx_handle_t log, zx_handle_t bootstrap_pipe) {
     // Locate the first bootfs bootdata section and decompress it.
     // We need it to load devmgr and libc from.
     // Later bootfs sections will be processed by devmgr.
-    zx_handle_t bootfs_vmo = bootdata_get_bootfs(log, vmar_self, bootdata_vmo);
+    zx_handle_t bootfs_vmo = bootdata_get_bootfs(log, proc_self, vmar_self, bootdata_vmo);
 
     // TODO(mdempsky): Push further down the stack? Seems unnecessary to
     // mark the entire bootfs VMO as executable.
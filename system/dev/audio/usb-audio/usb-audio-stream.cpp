@@ -1002,7 +1002,14 @@ void UsbAudioStream::RequestComplete(usb_request_t* req) {
             break;
 
         case RingBufferState::STARTED:
-            QueueRequestLocked();
+            // Top the pipeline back up with every free request, not just the
+            // one which just completed.  Requests which completed while we
+            // were still transitioning out of STARTING were not re-queued, and
+            // leaving them idle would permanently reduce the number of
+            // transactions in flight (and our margin against underflow).
+            while (!list_is_empty(&free_req_)) {
+                QueueRequestLocked();
+            }
             break;
 
         case RingBufferState::STOPPED:
@@ -558,6 +558,12 @@ static int ahci_worker_thread(void* arg) {
             }
 
             // process queued txns
+            // Slots the hardware still owns, sampled once for the whole pass. Bits only
+            // clear as commands finish, so a stale value is conservative; slots issued
+            // during this pass are tracked in port->running.
+            uint32_t hw_busy = ahci_read(&port->regs->sact) | ahci_read(&port->regs->ci);
+            int max = MIN(port->devinfo.max_cmd, (int)((dev->cap >> 8) & 0x1f));
+            uint32_t slot_mask = (max >= 31) ? UINT32_MAX : ((1u << (max + 1)) - 1);
             for (;;) {
                 txn = list_peek_head_type(&port->txn_list, sata_txn_t, node);
                 if (!txn) {
@@ -565,14 +571,11 @@ static int ahci_worker_thread(void* arg) {
                 }
 
                 // find a free command tag
-                int max = MIN(port->devinfo.max_cmd, (int)((dev->cap >> 8) & 0x1f));
-                int i = 0;
-                for (i = 0; i <= max; i++) {
-                    if (!ahci_port_cmd_busy(port, i)) break;
-                }
-                if (i > max) {
+                uint32_t free_slots = ~(hw_busy | port->running | port->completed) & slot_mask;
+                if (!free_slots) {
                     break;
                 }
+                int i = __builtin_ctz(free_slots);
 
                 list_delete(&txn->node);
 
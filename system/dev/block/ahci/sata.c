@@ -141,7 +141,8 @@ static zx_status_t sata_device_identify(sata_device_t* dev, ahci_device_t* contr
     } else {
         zxlogf(INFO, " PIO");
     }
-    dev->max_cmd = *(devinfo + SATA_DEVINFO_QUEUE_DEPTH);
+    // only bits 4:0 hold the queue depth (minus one), the rest are reserved
+    dev->max_cmd = *(devinfo + SATA_DEVINFO_QUEUE_DEPTH) & 0x1f;
     zxlogf(INFO, " %d commands\n", dev->max_cmd + 1);
 
     uint32_t block_size = 512; // default
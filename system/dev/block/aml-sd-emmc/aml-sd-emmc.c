@@ -725,8 +725,14 @@ static zx_status_t aml_sd_emmc_setup_data_descs_dma(aml_sd_emmc_t* dev, sdmmc_re
         .length = req_len,
         .vmo_offset = req->buf_offset,
     };
+    // A descriptor can cover up to AML_SD_EMMC_CMD_INFO_LEN_MASK blocks, so let physically
+    // contiguous pages share one instead of using a descriptor per page.
+    size_t max_desc_len = ROUNDDOWN(AML_SD_EMMC_CMD_INFO_LEN_MASK * req->blocksize, PAGE_SIZE);
+    if (max_desc_len < PAGE_SIZE) {
+        max_desc_len = PAGE_SIZE;
+    }
     phys_iter_t iter;
-    phys_iter_init(&iter, &buf, PAGE_SIZE);
+    phys_iter_init(&iter, &buf, max_desc_len);
 
     int count = 0;
     size_t length;
@@ -744,7 +750,7 @@ static zx_status_t aml_sd_emmc_setup_data_descs_dma(aml_sd_emmc_t* dev, sdmmc_re
                 zxlogf(TRACE, "aml-sd-emmc: empty descriptor list!\n");
                 return ZX_ERR_NOT_SUPPORTED;
             }
-        } else if (length > PAGE_SIZE) {
+        } else if (length > max_desc_len) {
             zxlogf(TRACE, "aml-sd-emmc: chunk size > %zu is unsupported\n", length);
             return ZX_ERR_NOT_SUPPORTED;
         } else if ((++count) > AML_DMA_DESC_MAX_COUNT) {
@@ -6,6 +6,7 @@
 #include <ddk/device.h>
 #include <ddk/driver.h>
 #include <ddk/metadata.h>
+#include <ddk/protocol/block-lib.h>
 
 #include <assert.h>
 #include <inttypes.h>
@@ -362,9 +363,7 @@ static void blkdev_query(void* ctx, block_info_t* bi, size_t* bopsz) {
     *bopsz = bdev->block_op_size;
 }
 
-static void blkdev_queue(void* ctx, block_op_t* bop, block_impl_queue_callback completion_cb,
-                        void* cookie) {
-    blkdev_t* bdev = ctx;
+static void blkdev_count_op(blkdev_t* bdev, const block_op_t* bop) {
     uint64_t op = bop->command & BLOCK_OP_MASK;
     bdev->stats.total_ops++;
     if (op == BLOCK_OP_READ) {
@@ -376,9 +375,24 @@ static void blkdev_queue(void* ctx, block_op_t* bop, block_impl_queue_callback c
         bdev->stats.total_blocks_written += bop->rw.length;
         bdev->stats.total_blocks += bop->rw.length;
     }
+}
+
+static void blkdev_queue(void* ctx, block_op_t* bop, block_impl_queue_callback completion_cb,
+                        void* cookie) {
+    blkdev_t* bdev = ctx;
+    blkdev_count_op(bdev, bop);
     block_impl_queue(&bdev->parent_protocol, bop, completion_cb, cookie);
 }
 
+static void blkdev_queue_batch(void* ctx, block_op_t** bops, size_t count,
+                               block_impl_queue_callback completion_cb, void* cookie) {
+    blkdev_t* bdev = ctx;
+    for (size_t i = 0; i < count; i++) {
+        blkdev_count_op(bdev, bops[i]);
+    }
+    block_impl_queue_many(&bdev->parent_protocol, bops, count, completion_cb, cookie);
+}
+
 static zx_status_t handle_stats(void* ctx, const void* cmd,
                                 size_t cmdlen, void* reply, size_t max, size_t* out_actual) {
     blkdev_t* blkdev = ctx;
@@ -418,6 +432,7 @@ static block_impl_protocol_ops_t block_ops = {
     .query = blkdev_query,
     .queue = blkdev_queue,
     .get_stats = handle_stats,
+    .queue_batch = blkdev_queue_batch,
 };
 
 static zx_protocol_device_t blkdev_ops = {
@@ -5,10 +5,12 @@
 #include <unistd.h>
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <string.h>
 
 #include <ddk/device.h>
 #include <ddk/protocol/block.h>
+#include <ddk/protocol/block-lib.h>
 #include <fbl/algorithm.h>
 #include <fbl/alloc_checker.h>
 #include <fbl/auto_call.h>
@@ -40,6 +42,13 @@ constexpr zx_signals_t kSignalFifoTerminated  = ZX_USER_SIGNAL_2;
 // has no accompanying group.
 constexpr groupid_t kNoGroup = MAX_TXN_GROUP_COUNT;
 
+// Number of queued messages looked at for ones to merge with the message
+// about to be sent to the driver.
+constexpr size_t kMergeScanLimit = 32;
+
+// Most messages handed to the driver in one queue_batch() call.
+constexpr size_t kMaxBatch = 32;
+
 void OutOfBandRespond(const fzl::fifo<block_fifo_response_t, block_fifo_request_t>& fifo,
                       zx_status_t status, reqid_t reqid, groupid_t group) {
     block_fifo_response_t response;
@@ -67,6 +76,18 @@ void BlockCompleteCb(void* cookie, zx_status_t status, block_op_t* bop) {
     ZX_DEBUG_ASSERT(bop != nullptr);
     BlockMsg msg(static_cast<block_msg_t*>(cookie));
     BlockComplete(&msg, status);
+    while (!msg.extra()->merged.is_empty()) {
+        BlockMsg merged(msg.extra()->merged.pop_front());
+        BlockComplete(&merged, status);
+    }
+}
+
+// Batches share one cookie, so the message is found from the op instead.
+void BlockBatchCompleteCb(void* cookie, zx_status_t status, block_op_t* bop) {
+    ZX_DEBUG_ASSERT(bop != nullptr);
+    block_msg_t* msg = reinterpret_cast<block_msg_t*>(reinterpret_cast<uintptr_t>(bop) -
+                                                      offsetof(block_msg_t, op));
+    BlockCompleteCb(msg, status, bop);
 }
 
 uint32_t OpcodeToCommand(uint32_t opcode) {
@@ -228,8 +249,18 @@ void BlockServer::TxnEnd() {
 }
 
 void BlockServer::InQueueDrainer() {
+    // Everything between barriers goes to the driver in batches. A batch is
+    // always sent before waiting on a barrier, since the wait is for it too.
+    block_op_t* batch[kMaxBatch];
+    size_t batch_count = 0;
+    auto flush = [&]() {
+        block_impl_queue_many(bp_, batch, batch_count, BlockBatchCompleteCb, this);
+        batch_count = 0;
+    };
+
     while (true) {
         if (in_queue_.is_empty()) {
+            flush();
             return;
         }
 
@@ -240,6 +271,7 @@ void BlockServer::InQueueDrainer() {
         }
 
         if (msg->op.command & BLOCK_FL_BARRIER_BEFORE) {
+            flush();
             barrier_in_progress_.store(true);
             if (pending_count_.load() > 0) {
                 return;
@@ -259,7 +291,53 @@ void BlockServer::InQueueDrainer() {
         // This may be altered in the future if block devices
         // are capable of implementing hardware barriers.
         msg->op.command &= ~(BLOCK_FL_BARRIER_BEFORE | BLOCK_FL_BARRIER_AFTER);
-        bp_->ops->queue(bp_->ctx, &msg->op, BlockCompleteCb, &*msg);
+        MergeRequests(&*msg);
+        batch[batch_count++] = &msg->op;
+        if (batch_count == kMaxBatch) {
+            flush();
+        }
+    }
+}
+
+void BlockServer::MergeRequests(block_msg_t* msg) {
+    const uint32_t op = msg->op.command & BLOCK_OP_MASK;
+    if ((op != BLOCK_OP_READ && op != BLOCK_OP_WRITE) || deferred_barrier_before_) {
+        // Nothing may be issued alongside an operation followed by a barrier.
+        return;
+    }
+    const uint64_t max_xfer = info_.max_transfer_size / info_.block_size;
+    const uint64_t start = msg->op.rw.offset_dev;
+
+    // Requests may be moved ahead of those they skip over, since clients
+    // order requests only with barriers, but never past a barrier or a flush,
+    // nor past a request whose device range they overlap.  For the latter,
+    // track the range spanned by the requests skipped so far.
+    uint64_t skipped_start = UINT64_MAX;
+    uint64_t skipped_end = 0;
+
+    auto iter = in_queue_.begin();
+    for (size_t scanned = 0; iter.IsValid() && scanned < kMergeScanLimit; scanned++) {
+        block_op_t* bop = &iter->op;
+        if ((bop->command & (BLOCK_FL_BARRIER_BEFORE | BLOCK_FL_BARRIER_AFTER)) ||
+            ((bop->command & BLOCK_OP_MASK) == BLOCK_OP_FLUSH)) {
+            return;
+        }
+        const uint64_t end = msg->op.rw.offset_dev + msg->op.rw.length;
+        const uint64_t next_end = bop->rw.offset_dev + bop->rw.length;
+        if ((bop->command & BLOCK_OP_MASK) == op && bop->rw.vmo == msg->op.rw.vmo &&
+            bop->rw.offset_dev == end &&
+            bop->rw.offset_vmo == msg->op.rw.offset_vmo + msg->op.rw.length &&
+            next_end - start <= max_xfer &&
+            (next_end <= skipped_start || bop->rw.offset_dev >= skipped_end)) {
+            block_msg_t* next = in_queue_.erase(iter++);
+            msg->op.rw.length += bop->rw.length;
+            msg->extra.merged.push_back(next);
+            pending_count_.fetch_add(1);
+            continue;
+        }
+        skipped_start = fbl::min(skipped_start, bop->rw.offset_dev);
+        skipped_end = fbl::max(skipped_end, next_end);
+        ++iter;
     }
 }
 
@@ -58,6 +58,15 @@ class BlockServer;
 typedef struct block_msg_extra block_msg_extra_t;
 typedef struct block_msg block_msg_t;
 
+// Since the linked list state (necessary to queue up block messages) is based
+// in C++ code, but may need to reference the "block_op_t" object, it uses
+// a custom type trait.
+struct DoublyLinkedListTraits {
+    static fbl::DoublyLinkedListNodeState<block_msg_t*>& node_state(block_msg_t& obj);
+};
+
+using BlockMsgQueue = fbl::DoublyLinkedList<block_msg_t*, DoublyLinkedListTraits>;
+
 // All the C++ bits of a block message. This allows the block server to utilize
 // C++ libraries while also using "block_op_t"s, which may require extra space.
 struct block_msg_extra {
@@ -66,6 +75,9 @@ struct block_msg_extra {
     BlockServer* server;
     reqid_t reqid;
     groupid_t group;
+    // Messages which were merged into this one before it was sent to the
+    // driver, and which complete along with it.
+    BlockMsgQueue merged;
 };
 
 // A single unit of work transmitted to the underlying block layer.
@@ -75,16 +87,10 @@ struct block_msg {
     // + Extra space for underlying block_op
 };
 
-// Since the linked list state (necessary to queue up block messages) is based
-// in C++ code, but may need to reference the "block_op_t" object, it uses
-// a custom type trait.
-struct DoublyLinkedListTraits {
-    static fbl::DoublyLinkedListNodeState<block_msg_t*>& node_state(block_msg_t& obj) {
-        return obj.extra.dll_node_state;
-    }
-};
-
-using BlockMsgQueue = fbl::DoublyLinkedList<block_msg_t*, DoublyLinkedListTraits>;
+inline fbl::DoublyLinkedListNodeState<block_msg_t*>&
+DoublyLinkedListTraits::node_state(block_msg_t& obj) {
+    return obj.extra.dll_node_state;
+}
 
 // C++ safe wrapper around block_msg_t.
 //
@@ -192,6 +198,11 @@ private:
     // operations are in-flight.
     void InQueueDrainer();
 
+    // Moves the reads or writes queued behind |msg| on the |in_queue_| which
+    // continue it, both on the device and in the same VMO, into |msg|, so that
+    // the driver sees them as a single larger transfer.
+    void MergeRequests(block_msg_t* msg);
+
     zx_status_t FindVmoIDLocked(vmoid_t* out) TA_REQ(server_lock_);
 
     fzl::fifo<block_fifo_response_t, block_fifo_request_t> fifo_;
@@ -9,6 +9,7 @@
 #include <stdlib.h>
 
 #include <ddk/device.h>
+#include <ddk/protocol/block-lib.h>
 #include <fvm/fvm.h>
 #include <zircon/device/block.h>
 #include <zircon/thread_annotations.h>
@@ -99,6 +100,10 @@ public:
     void Queue(block_op_t* txn, block_impl_queue_callback completion_cb, void* cookie) const {
         bp_.ops->queue(bp_.ctx, txn, completion_cb, cookie);
     }
+    void QueueBatch(block_op_t** txns, size_t txn_count, block_impl_queue_callback completion_cb,
+                    void* cookie) const {
+        block_impl_queue_many(&bp_, txns, txn_count, completion_cb, cookie);
+    }
 
     // Acquire access to a VPart Entry which has already been modified (and
     // will, as a consequence, not be de-allocated underneath us).
@@ -160,6 +165,9 @@ private:
 
     zx_status_t FindFreeVPartEntryLocked(size_t* out) const TA_REQ(lock_);
     zx_status_t FindFreeSliceLocked(size_t* out, size_t hint) const TA_REQ(lock_);
+    // Finds the first run of |count| free physical slices at or after |hint|,
+    // wrapping around to the start of the slice table.
+    zx_status_t FindFreeRunLocked(size_t* out, size_t count, size_t hint) const TA_REQ(lock_);
 
     fvm_t* GetFvmLocked() const TA_REQ(lock_) {
         return reinterpret_cast<fvm_t*>(metadata_.start());
@@ -231,6 +239,8 @@ public:
                                   size_t reply_size, size_t* out_reply_actual) {
         return ZX_ERR_NOT_SUPPORTED;
     }
+    void BlockImplQueueBatch(block_op_t** txns, size_t txn_count,
+                             block_impl_queue_callback completion_cb, void* cookie);
 
     auto ExtentBegin() TA_REQ(lock_) {
         return slice_map_.begin();
@@ -283,6 +293,11 @@ private:
 
     zx_device_t* GetParent() const { return mgr_->parent(); }
 
+    // Translates |txn| to the parent device if it is a valid read or write
+    // within one allocated slice. Returns false, leaving |txn| as it was,
+    // for anything else.
+    bool TranslateInSliceLocked(block_op_t* txn) TA_REQ(lock_);
+
     VPartitionManager* mgr_;
     size_t entry_index_;
 
@@ -411,6 +411,28 @@ zx_status_t VPartitionManager::FindFreeSliceLocked(size_t* out, size_t hint) con
     return ZX_ERR_NO_SPACE;
 }
 
+zx_status_t VPartitionManager::FindFreeRunLocked(size_t* out, size_t count,
+                                                 size_t hint) const {
+    hint = fbl::max(hint, 1lu);
+    size_t run = 0;
+    for (size_t i = hint; i <= pslice_total_count_; i++) {
+        run = (GetSliceEntryLocked(i)->Vpart() == FVM_SLICE_ENTRY_FREE) ? run + 1 : 0;
+        if (run == count) {
+            *out = i + 1 - count;
+            return ZX_OK;
+        }
+    }
+    run = 0;
+    for (size_t i = 1; i < hint; i++) {
+        run = (GetSliceEntryLocked(i)->Vpart() == FVM_SLICE_ENTRY_FREE) ? run + 1 : 0;
+        if (run == count) {
+            *out = i + 1 - count;
+            return ZX_OK;
+        }
+    }
+    return ZX_ERR_NO_SPACE;
+}
+
 zx_status_t VPartitionManager::AllocateSlices(VPartition* vp, size_t vslice_start,
                                               size_t count) {
     fbl::AutoLock lock(&lock_);
@@ -431,6 +453,22 @@ zx_status_t VPartitionManager::AllocateSlicesLocked(VPartition* vp, size_t vslic
         if (vp->IsKilledLocked()) {
             return ZX_ERR_BAD_STATE;
         }
+
+        // Keep the partition physically contiguous where possible, so that
+        // large I/O does not need to be split: continue from the slice backing
+        // the preceding vslice, and look for a free run long enough to hold
+        // the whole allocation.  If there is none, fill in whatever is free.
+        if (vslice_start > 0) {
+            uint32_t prev = vp->SliceGetLocked(vslice_start - 1);
+            if (prev != PSLICE_UNALLOCATED) {
+                hint = prev + 1;
+            }
+        }
+        size_t run;
+        if (FindFreeRunLocked(&run, count, hint) == ZX_OK) {
+            hint = run;
+        }
+
         for (size_t i = 0; i < count; i++) {
             size_t pslice;
             auto vslice = vslice_start + i;
@@ -1045,39 +1083,41 @@ void VPartition::BlockImplQueue(block_op_t* txn, block_impl_queue_callback compl
     size_t vslice_start = txn->rw.offset_dev / blocks_per_slice;
     size_t vslice_end = (txn->rw.offset_dev + txn->rw.length - 1) / blocks_per_slice;
 
+    // The slice map is only needed to translate the request; the lock is
+    // dropped before anything is sent to the parent device.
     fbl::AutoLock lock(&lock_);
-    if (vslice_start == vslice_end) {
-        // Common case: txn occurs within one slice
-        uint32_t pslice = SliceGetLocked(vslice_start);
-        if (pslice == PSLICE_UNALLOCATED) {
-            completion_cb(cookie, ZX_ERR_OUT_OF_RANGE, txn);
-            return;
-        }
-        txn->rw.offset_dev = SliceStart(disk_size, slice_size, pslice) /
-                BlockSize() + (txn->rw.offset_dev % blocks_per_slice);
-        mgr_->Queue(txn, completion_cb, cookie);
+    auto extent = --slice_map_.upper_bound(vslice_start);
+    const uint32_t pslice_start = extent.IsValid() ? extent->get(vslice_start) :
+                                                     PSLICE_UNALLOCATED;
+    if (pslice_start == PSLICE_UNALLOCATED) {
+        completion_cb(cookie, ZX_ERR_OUT_OF_RANGE, txn);
         return;
     }
 
-    // Less common case: txn spans multiple slices
-
-    // First, check that all slices are allocated.
+    // Check that all slices are allocated, and whether they are physically
+    // contiguous, walking the extents rather than looking each slice up.
     // If any are missing, then this txn will fail.
     bool contiguous = true;
-    for (size_t vslice = vslice_start; vslice <= vslice_end; vslice++) {
-        if (SliceGetLocked(vslice) == PSLICE_UNALLOCATED) {
-            completion_cb(cookie, ZX_ERR_OUT_OF_RANGE, txn);
-            return;
+    uint32_t pslice_prev = pslice_start;
+    for (size_t vslice = vslice_start + 1; vslice <= vslice_end; vslice++) {
+        if (vslice == extent->end()) {
+            ++extent;
+            if (!extent.IsValid() || extent->start() != vslice) {
+                completion_cb(cookie, ZX_ERR_OUT_OF_RANGE, txn);
+                return;
+            }
         }
-        if (vslice != vslice_start && SliceGetLocked(vslice - 1) + 1 != SliceGetLocked(vslice)) {
+        uint32_t pslice = extent->get(vslice);
+        if (pslice != pslice_prev + 1) {
             contiguous = false;
         }
+        pslice_prev = pslice;
     }
 
-    // Ideal case: slices are contiguous
+    // Common case: txn occurs within one slice, or slices which are contiguous
     if (contiguous) {
-        uint32_t pslice = SliceGetLocked(vslice_start);
-        txn->rw.offset_dev = SliceStart(disk_size, slice_size, pslice) /
+        lock.release();
+        txn->rw.offset_dev = SliceStart(disk_size, slice_size, pslice_start) /
                 BlockSize() + (txn->rw.offset_dev % blocks_per_slice);
         mgr_->Queue(txn, completion_cb, cookie);
         return;
@@ -1133,6 +1173,7 @@ void VPartition::BlockImplQueue(block_op_t* txn, block_impl_queue_callback compl
         length_remaining -= txns[i]->rw.length;
     }
     ZX_DEBUG_ASSERT(length_remaining == 0);
+    lock.release();
 
     for (size_t i = 0; i < txn_count; i++) {
         mgr_->Queue(txns[i], multi_txn_completion, state.get());
@@ -1141,6 +1182,55 @@ void VPartition::BlockImplQueue(block_op_t* txn, block_impl_queue_callback compl
     __UNUSED auto ptr = state.release();
 }
 
+bool VPartition::TranslateInSliceLocked(block_op_t* txn) {
+    const uint32_t op = txn->command & BLOCK_OP_MASK;
+    if ((op != BLOCK_OP_READ && op != BLOCK_OP_WRITE) || txn->rw.length == 0) {
+        return false;
+    }
+    const uint64_t device_capacity = DdkGetSize() / BlockSize();
+    if ((txn->rw.offset_dev >= device_capacity) ||
+        (device_capacity - txn->rw.offset_dev < txn->rw.length)) {
+        return false;
+    }
+
+    const size_t slice_size = mgr_->SliceSize();
+    const uint64_t blocks_per_slice = slice_size / BlockSize();
+    const size_t vslice = txn->rw.offset_dev / blocks_per_slice;
+    if ((txn->rw.offset_dev + txn->rw.length - 1) / blocks_per_slice != vslice) {
+        return false;
+    }
+    const uint32_t pslice = SliceGetLocked(vslice);
+    if (pslice == PSLICE_UNALLOCATED) {
+        return false;
+    }
+    txn->rw.offset_dev = SliceStart(mgr_->DiskSize(), slice_size, pslice) / BlockSize() +
+            (txn->rw.offset_dev % blocks_per_slice);
+    return true;
+}
+
+void VPartition::BlockImplQueueBatch(block_op_t** txns, size_t txn_count,
+                                     block_impl_queue_callback completion_cb, void* cookie) {
+    ZX_DEBUG_ASSERT(mgr_->BlockOpSize() > 0);
+    // Runs of ops within one slice are translated under a single acquisition
+    // of the lock, packed at the front of |txns| and passed down together.
+    // Anything else, including every error, takes the single op path, in
+    // order with the runs around it.
+    size_t i = 0;
+    while (i < txn_count) {
+        size_t batch_count = 0;
+        {
+            fbl::AutoLock lock(&lock_);
+            for (; i < txn_count && TranslateInSliceLocked(txns[i]); i++) {
+                txns[batch_count++] = txns[i];
+            }
+        }
+        mgr_->QueueBatch(txns, batch_count, completion_cb, cookie);
+        if (i < txn_count) {
+            BlockImplQueue(txns[i++], completion_cb, cookie);
+        }
+    }
+}
+
 zx_off_t VPartition::DdkGetSize() {
     const zx_off_t sz = mgr_->VSliceMax() * mgr_->SliceSize();
     // Check for overflow; enforced when loading driver
@@ -9,6 +9,7 @@
 #include <ddk/metadata.h>
 #include <ddk/metadata/gpt.h>
 #include <ddk/protocol/block.h>
+#include <ddk/protocol/block-lib.h>
 
 #include <assert.h>
 #include <fcntl.h>
@@ -161,10 +162,9 @@ static void gpt_query(void* ctx, block_info_t* bi, size_t* bopsz) {
     *bopsz = gpt->block_op_size;
 }
 
-static void gpt_queue(void* ctx, block_op_t* bop, block_impl_queue_callback completion_cb,
-                      void* cookie) {
-    gptpart_device_t* gpt = ctx;
-
+// Checks |bop| and translates it to the parent device, or returns the status
+// it should be completed with.
+static zx_status_t gpt_translate(gptpart_device_t* gpt, block_op_t* bop) {
     switch (bop->command & BLOCK_OP_MASK) {
     case BLOCK_OP_READ:
     case BLOCK_OP_WRITE: {
@@ -174,24 +174,52 @@ static void gpt_queue(void* ctx, block_op_t* bop, block_impl_queue_callback comp
         // Ensure that the request is in-bounds
         if ((bop->rw.offset_dev >= max) ||
             ((max - bop->rw.offset_dev) < blocks)) {
-            completion_cb(cookie, ZX_ERR_OUT_OF_RANGE, bop);
-            return;
+            return ZX_ERR_OUT_OF_RANGE;
         }
 
         // Adjust for partition starting block
         bop->rw.offset_dev += gpt->gpt_entry.first;
-        break;
+        return ZX_OK;
     }
     case BLOCK_OP_FLUSH:
-        break;
+        return ZX_OK;
     default:
-        completion_cb(cookie, ZX_ERR_NOT_SUPPORTED, bop);
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+}
+
+static void gpt_queue(void* ctx, block_op_t* bop, block_impl_queue_callback completion_cb,
+                      void* cookie) {
+    gptpart_device_t* gpt = ctx;
+
+    zx_status_t status = gpt_translate(gpt, bop);
+    if (status != ZX_OK) {
+        completion_cb(cookie, status, bop);
         return;
     }
 
     block_impl_queue(&gpt->bp, bop, completion_cb, cookie);
 }
 
+static void gpt_queue_batch(void* ctx, block_op_t** bops, size_t count,
+                            block_impl_queue_callback completion_cb, void* cookie) {
+    gptpart_device_t* gpt = ctx;
+
+    // Ops which fail are completed now, the rest are packed in place and
+    // passed down together.
+    size_t valid = 0;
+    for (size_t i = 0; i < count; i++) {
+        zx_status_t status = gpt_translate(gpt, bops[i]);
+        if (status != ZX_OK) {
+            completion_cb(cookie, status, bops[i]);
+            continue;
+        }
+        bops[valid++] = bops[i];
+    }
+
+    block_impl_queue_many(&gpt->bp, bops, valid, completion_cb, cookie);
+}
+
 static void gpt_unbind(void* ctx) {
     gptpart_device_t* device = ctx;
     device_remove(device->zxdev);
@@ -220,6 +248,7 @@ static zx_protocol_device_t gpt_proto = {
 static block_impl_protocol_ops_t block_ops = {
     .query = gpt_query,
     .queue = gpt_queue,
+    .queue_batch = gpt_queue_batch,
 };
 
 static void gpt_read_sync_complete(void* cookie, zx_status_t status, block_op_t* bop) {
@@ -4,6 +4,7 @@
 
 #include <assert.h>
 #include <limits.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -53,8 +54,6 @@ typedef struct {
     uint32_t reserved1;
 } nvme_utxn_t;
 
-#define UTXN_COUNT 63
-
 // There's no system constant for this.  Ensure it matches reality.
 #define PAGE_SHIFT (12ULL)
 static_assert(PAGE_SIZE == (1ULL << PAGE_SHIFT), "");
@@ -70,36 +69,56 @@ static_assert(PAGE_SIZE == (1ULL << PAGE_SHIFT), "");
 #define SQMAX (PAGE_SIZE / sizeof(nvme_cmd_t))
 #define CQMAX (PAGE_SIZE / sizeof(nvme_cpl_t))
 
+// Maximum item count of the io submission and completion queues,
+// further limited by the controller (CAP.MQES).  The submission
+// queue spans IO_SQ_PAGES pages, the completion queue a single page.
+#define IO_QUEUE_DEPTH 128
+#define IO_SQ_PAGES ((IO_QUEUE_DEPTH * sizeof(nvme_cmd_t)) / PAGE_SIZE)
+static_assert(IO_QUEUE_DEPTH * sizeof(nvme_cpl_t) <= PAGE_SIZE, "");
+
+// One submission queue entry is always left empty, so a queue
+// can have at most IO_QUEUE_DEPTH - 1 commands outstanding.
+#define UTXN_COUNT (IO_QUEUE_DEPTH - 1)
+#define UTXN_WORDS ((UTXN_COUNT + 63) / 64)
+
+// Upper bound on the number of io queue pairs, each of which
+// gets its own interrupt vector and io thread.
+#define MAX_IO_QUEUES 16
+
 // global driver state bits
-#define FLAG_IRQ_THREAD_STARTED  0x0001
-#define FLAG_IO_THREAD_STARTED   0x0002
 #define FLAG_SHUTDOWN            0x0004
 
 #define FLAG_HAS_VWC             0x0100
 
+typedef struct nvme_device nvme_device_t;
+
+// An io submission queue and the completion queue it posts to.
 typedef struct {
-    mmio_buffer_t mmio;
-    zx_handle_t irqh;
-    zx_handle_t bti;
-    uint32_t flags;
-    mtx_t lock;
+    nvme_device_t* nvme;
+    uint16_t qid;       // queue id of both the sq and cq
+    uint16_t vector;    // interrupt vector of the cq
+    uint16_t depth;     // item count of both the sq and cq
+    bool thread_started;
 
     // io queue doorbell registers
-    void* io_sq_tail_db;
-    void* io_cq_head_db;
+    void* sq_tail_db;
+    void* cq_head_db;
 
-    nvme_cpl_t* io_cq;
-    nvme_cmd_t* io_sq;
-    uint32_t io_nsid;
-    uint16_t io_cq_head;
-    uint16_t io_cq_toggle;
-    uint16_t io_sq_tail;
-    uint16_t io_sq_head;
+    nvme_cpl_t* cq;
+    nvme_cmd_t* sq;
+    uint16_t cq_head;
+    uint16_t cq_toggle;
+    uint16_t sq_tail;
+    uint16_t sq_head;
 
-    uint64_t utxn_avail;   // bitmask of available utxns
+    uint16_t utxn_count;
+    uint64_t utxn_avail[UTXN_WORDS];   // bitmask of available utxns
 
-    // The pending list is txns that have been received
-    // via nvme_queue() and are waiting for io to start.
+    mtx_t lock;
+
+    // The pending list is txns that have been assigned to this
+    // queue by nvme_queue() or nvme_queue_batch() and are waiting
+    // for io to start.
     // The exception is the head of the pending list which may
     // be partially started, waiting for more utxns to become
     // available.
@@ -114,6 +133,39 @@ typedef struct {
     // it has work to do.
     sync_completion_t io_signal;
 
+    // physically contiguous pages of the sq followed by the cq
+    io_buffer_t queue_iob;
+    // one scatter gather page per utxn
+    io_buffer_t utxn_iob;
+
+    thrd_t iothread;
+
+    // pool of utxns
+    nvme_utxn_t utxn[UTXN_COUNT];
+} nvme_ioq_t;
+
+typedef struct {
+    nvme_device_t* nvme;
+    zx_handle_t irqh;
+    uint16_t vector;
+    bool thread_started;
+    thrd_t thread;
+} nvme_irq_t;
+
+struct nvme_device {
+    mmio_buffer_t mmio;
+    zx_handle_t bti;
+    uint32_t flags;
+
+    // interrupt vector 0 serves the admin queue, and the
+    // io queues as well if it is the only vector
+    nvme_irq_t irq[MAX_IO_QUEUES + 1];
+    uint32_t irq_count;
+
+    nvme_ioq_t ioq[MAX_IO_QUEUES];
+    uint32_t ioq_count;
+    atomic_uint next_ioq;   // round robin assignment of txns to ioqs
+
     uint32_t max_xfer;
     block_info_t info;
 
@@ -140,15 +192,9 @@ typedef struct {
 
     size_t iosz;
 
-    // source of physical pages for queues and admin commands
+    // source of physical pages for admin queues and admin commands
     io_buffer_t iob;
-
-    thrd_t irqthread;
-    thrd_t iothread;
-
-    // pool of utxns
-    nvme_utxn_t utxn[UTXN_COUNT];
-} nvme_device_t;
+};
 
 
 // We break IO transactions down into one or more "micro transactions" (utxn)
@@ -157,26 +203,31 @@ typedef struct {
 // queued to the NVME device.  This id is the same as its index into the
 // pool of utxns and the bitmask of free txns, to simplify management.
 //
-// We maintain a pool of 63 of these, which is the number of commands
-// that can be submitted to NVME via a single page submit queue.
+// Each io queue has its own pool, as large as the number of commands
+// that can be outstanding on its submission queue.  Since command ids
+// only need to be unique within a submission queue, ids are reused
+// across queues.  The scatter gather page of each utxn is allocated
+// once and reused by every command issued with it.
 //
 // The utxns are not protected by locks.  Instead, after initialization,
-// they may only be touched by the io thread, which is responsible for
-// queueing commands and dequeuing completion messages.
-
-static nvme_utxn_t* utxn_get(nvme_device_t* nvme) {
-    uint64_t n = __builtin_ffsll(nvme->utxn_avail);
-    if (n == 0) {
-        return NULL;
+// they may only be touched by the io thread of their queue, which is
+// responsible for queueing commands and dequeuing completion messages.
+
+static nvme_utxn_t* utxn_get(nvme_ioq_t* ioq) {
+    for (unsigned w = 0; w < UTXN_WORDS; w++) {
+        uint64_t n = __builtin_ffsll(ioq->utxn_avail[w]);
+        if (n != 0) {
+            n--;
+            ioq->utxn_avail[w] &= ~(1ULL << n);
+            return ioq->utxn + (w * 64) + n;
+        }
     }
-    n--;
-    nvme->utxn_avail &= ~(1ULL << n);
-    return nvme->utxn + n;
+    return NULL;
 }
 
-static void utxn_put(nvme_device_t* nvme, nvme_utxn_t* utxn) {
+static void utxn_put(nvme_ioq_t* ioq, nvme_utxn_t* utxn) {
     uint64_t n = utxn->id;
-    nvme->utxn_avail |= (1ULL << n);
+    ioq->utxn_avail[n / 64] |= (1ULL << (n % 64));
 }
 
 static zx_status_t nvme_admin_cq_get(nvme_device_t* nvme, nvme_cpl_t* cpl) {
@@ -215,60 +266,72 @@ static zx_status_t nvme_admin_sq_put(nvme_device_t* nvme, nvme_cmd_t* cmd) {
     return ZX_OK;
 }
 
-static zx_status_t nvme_io_cq_get(nvme_device_t* nvme, nvme_cpl_t* cpl) {
-    if ((readw(&nvme->io_cq[nvme->io_cq_head].status) & 1) != nvme->io_cq_toggle) {
+static zx_status_t nvme_io_cq_get(nvme_ioq_t* ioq, nvme_cpl_t* cpl) {
+    if ((readw(&ioq->cq[ioq->cq_head].status) & 1) != ioq->cq_toggle) {
         return ZX_ERR_SHOULD_WAIT;
     }
-    *cpl = nvme->io_cq[nvme->io_cq_head];
+    *cpl = ioq->cq[ioq->cq_head];
 
     // advance the head pointer, wrapping and inverting toggle at max
-    uint16_t next = (nvme->io_cq_head + 1) & (CQMAX - 1);
-    if ((nvme->io_cq_head = next) == 0) {
-        nvme->io_cq_toggle ^= 1;
+    uint16_t next = ioq->cq_head + 1;
+    if (next == ioq->depth) {
+        next = 0;
+    }
+    if ((ioq->cq_head = next) == 0) {
+        ioq->cq_toggle ^= 1;
     }
 
     // note the new sq head reported by hw
-    nvme->io_sq_head = cpl->sq_head;
+    ioq->sq_head = cpl->sq_head;
     return ZX_OK;
 }
 
-static void nvme_io_cq_ack(nvme_device_t* nvme) {
+static void nvme_io_cq_ack(nvme_ioq_t* ioq) {
     // ring the doorbell
-    writel(nvme->io_cq_head, nvme->io_cq_head_db);
+    writel(ioq->cq_head, ioq->cq_head_db);
 }
 
-static zx_status_t nvme_io_sq_put(nvme_device_t* nvme, nvme_cmd_t* cmd) {
-    uint16_t next = (nvme->io_sq_tail + 1) & (SQMAX - 1);
+static zx_status_t nvme_io_sq_put(nvme_ioq_t* ioq, nvme_cmd_t* cmd) {
+    uint16_t next = ioq->sq_tail + 1;
+    if (next == ioq->depth) {
+        next = 0;
+    }
 
     // if head+1 == tail: queue is full
-    if (next == nvme->io_sq_head) {
+    if (next == ioq->sq_head) {
         return ZX_ERR_SHOULD_WAIT;
     }
 
-    nvme->io_sq[nvme->io_sq_tail] = *cmd;
-    nvme->io_sq_tail = next;
-
-    // ring the doorbell
-    writel(next, nvme->io_sq_tail_db);
+    // The doorbell is rung by io_process_txns(), once for all the
+    // commands it submits.
+    ioq->sq[ioq->sq_tail] = *cmd;
+    ioq->sq_tail = next;
     return ZX_OK;
 }
 
 static int irq_thread(void* arg) {
-    nvme_device_t* nvme = arg;
+    nvme_irq_t* irq = arg;
+    nvme_device_t* nvme = irq->nvme;
     for (;;) {
         zx_status_t r;
-        if ((r = zx_interrupt_wait(nvme->irqh, NULL)) != ZX_OK) {
-            zxlogf(ERROR, "nvme: irq wait failed: %d\n", r);
+        if ((r = zx_interrupt_wait(irq->irqh, NULL)) != ZX_OK) {
+            zxlogf(ERROR, "nvme: irq %u wait failed: %d\n", irq->vector, r);
             break;
         }
 
-        nvme_cpl_t cpl;
-        if (nvme_admin_cq_get(nvme, &cpl) == ZX_OK) {
-            nvme->admin_result = cpl;
-            sync_completion_signal(&nvme->admin_signal);
+        if (irq->vector == 0) {
+            nvme_cpl_t cpl;
+            if (nvme_admin_cq_get(nvme, &cpl) == ZX_OK) {
+                nvme->admin_result = cpl;
+                sync_completion_signal(&nvme->admin_signal);
+            }
         }
 
-        sync_completion_signal(&nvme->io_signal);
+        for (unsigned n = 0; n < nvme->ioq_count; n++) {
+            if (nvme->ioq[n].vector == irq->vector) {
+                sync_completion_signal(&nvme->ioq[n].io_signal);
+            }
+        }
     }
     return 0;
 }
@@ -305,7 +368,8 @@ static inline void txn_complete(nvme_txn_t* txn, zx_status_t status) {
 // Attempt to generate utxns and queue nvme commands for a txn
 // Returns true if this could not be completed due to temporary
 // lack of resources or false if either it succeeded or errored out.
-static bool io_process_txn(nvme_device_t* nvme, nvme_txn_t* txn) {
+static bool io_process_txn(nvme_ioq_t* ioq, nvme_txn_t* txn) {
+    nvme_device_t* nvme = ioq->nvme;
     zx_handle_t vmo = txn->op.rw.vmo;
     nvme_utxn_t* utxn;
     zx_paddr_t* pages;
@@ -314,7 +378,7 @@ static bool io_process_txn(nvme_device_t* nvme, nvme_txn_t* txn) {
     for (;;) {
         // If there are no available utxns, we can't proceed
         // and we tell the caller to retain the txn (true)
-        if ((utxn = utxn_get(nvme)) == NULL) {
+        if ((utxn = utxn_get(ioq)) == NULL) {
             return true;
         }
 
@@ -364,13 +428,13 @@ static bool io_process_txn(nvme_device_t* nvme, nvme_txn_t* txn) {
             cmd.dptr.prp[1] = utxn->phys + sizeof(uint64_t);
         }
 
-        zxlogf(TRACE, "nvme: txn=%p utxn id=%u pages=%zu op=%s\n", txn, utxn->id, pagecount,
-               txn->opcode == NVME_OP_WRITE ? "WR" : "RD");
+        zxlogf(TRACE, "nvme: txn=%p q=%u utxn id=%u pages=%zu op=%s\n", txn, ioq->qid, utxn->id,
+               pagecount, txn->opcode == NVME_OP_WRITE ? "WR" : "RD");
         zxlogf(SPEW, "nvme: prp[0]=%016zx prp[1]=%016zx\n", cmd.dptr.prp[0], cmd.dptr.prp[1]);
         zxlogf(SPEW, "nvme: pages[] = { %016zx, %016zx, %016zx, %016zx, ... }\n",
                pages[0], pages[1], pages[2], pages[3]);
 
-        if ((r = nvme_io_sq_put(nvme, &cmd)) != ZX_OK) {
+        if ((r = nvme_io_sq_put(ioq, &cmd)) != ZX_OK) {
             zxlogf(ERROR, "nvme: could not submit cmd (txn=%p id=%u)\n", txn, utxn->id);
             break;
         }
@@ -387,9 +451,9 @@ static bool io_process_txn(nvme_device_t* nvme, nvme_txn_t* txn) {
         // move this txn to the active list and tell the
         // caller not to retain the txn (false)
         if (txn->op.rw.length == 0) {
-            mtx_lock(&nvme->lock);
-            list_add_tail(&nvme->active_txns, &txn->node);
-            mtx_unlock(&nvme->lock);
+            mtx_lock(&ioq->lock);
+            list_add_tail(&ioq->active_txns, &txn->node);
+            mtx_unlock(&ioq->lock);
             return false;
         }
     }
@@ -398,17 +462,17 @@ static bool io_process_txn(nvme_device_t* nvme, nvme_txn_t* txn) {
     if ((r = zx_pmt_unpin(utxn->pmt)) != ZX_OK) {
         zxlogf(ERROR, "nvme: cannot unpin io buffer: %d\n", r);
     }
-    utxn_put(nvme, utxn);
+    utxn_put(ioq, utxn);
 
-    mtx_lock(&nvme->lock);
+    mtx_lock(&ioq->lock);
     txn->flags |= TXN_FLAG_FAILED;
     if (txn->pending_utxns) {
         // if there are earlier uncompleted IOs we become active now
         // and will finish erroring out when they complete
-        list_add_tail(&nvme->active_txns, &txn->node);
+        list_add_tail(&ioq->active_txns, &txn->node);
         txn = NULL;
     }
-    mtx_unlock(&nvme->lock);
+    mtx_unlock(&ioq->lock);
 
     if (txn != NULL) {
         txn_complete(txn, ZX_ERR_INTERNAL);
@@ -418,44 +482,50 @@ static bool io_process_txn(nvme_device_t* nvme, nvme_txn_t* txn) {
     return false;
 }
 
-static void io_process_txns(nvme_device_t* nvme) {
+static void io_process_txns(nvme_ioq_t* ioq) {
     nvme_txn_t* txn;
+    uint16_t sq_tail = ioq->sq_tail;
 
     for (;;) {
-        mtx_lock(&nvme->lock);
-        txn = list_remove_head_type(&nvme->pending_txns, nvme_txn_t, node);
-        mtx_unlock(&nvme->lock);
+        mtx_lock(&ioq->lock);
+        txn = list_remove_head_type(&ioq->pending_txns, nvme_txn_t, node);
+        mtx_unlock(&ioq->lock);
 
         if (txn == NULL) {
-            return;
+            break;
         }
 
-        if (io_process_txn(nvme, txn)) {
+        if (io_process_txn(ioq, txn)) {
             // put txn back at front of queue for further processing later
-            mtx_lock(&nvme->lock);
-            list_add_head(&nvme->pending_txns, &txn->node);
-            mtx_unlock(&nvme->lock);
-            return;
+            mtx_lock(&ioq->lock);
+            list_add_head(&ioq->pending_txns, &txn->node);
+            mtx_unlock(&ioq->lock);
+            break;
         }
     }
+
+    // ring the doorbell
+    if (ioq->sq_tail != sq_tail) {
+        writel(ioq->sq_tail, ioq->sq_tail_db);
+    }
 }
 
-static void io_process_cpls(nvme_device_t* nvme) {
+static void io_process_cpls(nvme_ioq_t* ioq) {
     bool ring_doorbell = false;
     nvme_cpl_t cpl;
 
-    while (nvme_io_cq_get(nvme, &cpl) == ZX_OK) {
+    while (nvme_io_cq_get(ioq, &cpl) == ZX_OK) {
         ring_doorbell = true;
 
-        if (cpl.cmd_id >= UTXN_COUNT) {
-            zxlogf(ERROR, "nvme: unexpected cmd id %u\n", cpl.cmd_id);
+        if (cpl.cmd_id >= ioq->utxn_count) {
+            zxlogf(ERROR, "nvme: q%u: unexpected cmd id %u\n", ioq->qid, cpl.cmd_id);
             continue;
         }
-        nvme_utxn_t* utxn = nvme->utxn + cpl.cmd_id;
+        nvme_utxn_t* utxn = ioq->utxn + cpl.cmd_id;
         nvme_txn_t* txn = utxn->txn;
 
         if (txn == NULL) {
-            zxlogf(ERROR, "nvme: inactive utxn #%u completed?!\n", cpl.cmd_id);
+            zxlogf(ERROR, "nvme: q%u: inactive utxn #%u completed?!\n", ioq->qid, cpl.cmd_id);
             continue;
         }
 
@@ -478,51 +548,52 @@ static void io_process_cpls(nvme_device_t* nvme) {
 
         // release the microtransaction
         utxn->txn = NULL;
-        utxn_put(nvme, utxn);
+        utxn_put(ioq, utxn);
 
         txn->pending_utxns--;
         if ((txn->pending_utxns == 0) && (txn->op.rw.length == 0)) {
             // remove from either pending or active list
-            mtx_lock(&nvme->lock);
+            mtx_lock(&ioq->lock);
             list_delete(&txn->node);
-            mtx_unlock(&nvme->lock);
+            mtx_unlock(&ioq->lock);
             zxlogf(TRACE, "nvme: txn %p %s\n", txn, txn->flags & TXN_FLAG_FAILED ? "error" : "okay");
             txn_complete(txn, txn->flags & TXN_FLAG_FAILED ? ZX_ERR_IO : ZX_OK);
         }
     }
 
     if (ring_doorbell) {
-        nvme_io_cq_ack(nvme);
+        nvme_io_cq_ack(ioq);
     }
 }
 
 static int io_thread(void* arg) {
-    nvme_device_t* nvme = arg;
+    nvme_ioq_t* ioq = arg;
+    nvme_device_t* nvme = ioq->nvme;
     for (;;) {
-        if (sync_completion_wait(&nvme->io_signal, ZX_TIME_INFINITE)) {
+        if (sync_completion_wait(&ioq->io_signal, ZX_TIME_INFINITE)) {
             break;
         }
         if (nvme->flags & FLAG_SHUTDOWN) {
             //TODO: cancel out pending IO
-            zxlogf(INFO, "nvme: io thread exiting\n");
+            zxlogf(INFO, "nvme: q%u: io thread exiting\n", ioq->qid);
             break;
         }
 
-        sync_completion_reset(&nvme->io_signal);
+        sync_completion_reset(&ioq->io_signal);
 
         // process completion messages
-        io_process_cpls(nvme);
+        io_process_cpls(ioq);
 
         // process work queue
-        io_process_txns(nvme);
+        io_process_txns(ioq);
 
     }
     return 0;
 }
 
-static void nvme_queue(void* ctx, block_op_t* op, block_impl_queue_callback completion_cb,
-                       void* cookie) {
-    nvme_device_t* nvme = ctx;
+// Checks and sets up the txn for |op|, or completes it and returns false.
+static bool nvme_txn_prepare(nvme_device_t* nvme, block_op_t* op,
+                             block_impl_queue_callback completion_cb, void* cookie) {
     nvme_txn_t* txn = containerof(op, nvme_txn_t, op);
     txn->completion_cb = completion_cb;
     txn->cookie = cookie;
@@ -537,21 +608,21 @@ static void nvme_queue(void* ctx, block_op_t* op, block_impl_queue_callback comp
     case BLOCK_OP_FLUSH:
         // TODO
         txn_complete(txn, ZX_OK);
-        return;
+        return false;
     default:
         txn_complete(txn, ZX_ERR_NOT_SUPPORTED);
-        return;
+        return false;
     }
 
     if (txn->op.rw.length == 0) {
         txn_complete(txn, ZX_ERR_INVALID_ARGS);
-        return;
+        return false;
     }
     // Transaction must fit within device
     if ((txn->op.rw.offset_dev >= nvme->info.block_count) ||
         (nvme->info.block_count - txn->op.rw.offset_dev < txn->op.rw.length)) {
         txn_complete(txn, ZX_ERR_OUT_OF_RANGE);
-        return;
+        return false;
     }
 
     // convert vmo offset to a byte offset
@@ -563,12 +634,58 @@ static void nvme_queue(void* ctx, block_op_t* op, block_impl_queue_callback comp
     zxlogf(SPEW, "nvme: io: %s: %ublks @ blk#%zu\n",
            txn->opcode == NVME_OP_WRITE ? "wr" : "rd",
            txn->op.rw.length + 1U, txn->op.rw.offset_dev);
+    return true;
+}
+
+// Spread txns over the io queues, so that concurrent clients are
+// serviced by independent queues, interrupts and io threads.
+static nvme_ioq_t* nvme_next_ioq(nvme_device_t* nvme) {
+    unsigned n = atomic_fetch_add(&nvme->next_ioq, 1) % nvme->ioq_count;
+    return &nvme->ioq[n];
+}
 
-    mtx_lock(&nvme->lock);
-    list_add_tail(&nvme->pending_txns, &txn->node);
-    mtx_unlock(&nvme->lock);
+static void nvme_queue(void* ctx, block_op_t* op, block_impl_queue_callback completion_cb,
+                       void* cookie) {
+    nvme_device_t* nvme = ctx;
+    if (!nvme_txn_prepare(nvme, op, completion_cb, cookie)) {
+        return;
+    }
 
-    sync_completion_signal(&nvme->io_signal);
+    nvme_ioq_t* ioq = nvme_next_ioq(nvme);
+    nvme_txn_t* txn = containerof(op, nvme_txn_t, op);
+
+    mtx_lock(&ioq->lock);
+    list_add_tail(&ioq->pending_txns, &txn->node);
+    mtx_unlock(&ioq->lock);
+
+    sync_completion_signal(&ioq->io_signal);
+}
+
+// A batch stays together on one io queue, taking its lock and waking its
+// io thread once, so the thread fills the submission queue before ringing
+// the doorbell.
+static void nvme_queue_batch(void* ctx, block_op_t** ops, size_t count,
+                             block_impl_queue_callback completion_cb, void* cookie) {
+    nvme_device_t* nvme = ctx;
+    list_node_t txns = LIST_INITIAL_VALUE(txns);
+    for (size_t i = 0; i < count; i++) {
+        if (nvme_txn_prepare(nvme, ops[i], completion_cb, cookie)) {
+            nvme_txn_t* txn = containerof(ops[i], nvme_txn_t, op);
+            list_add_tail(&txns, &txn->node);
+        }
+    }
+    if (list_is_empty(&txns)) {
+        return;
+    }
+
+    nvme_ioq_t* ioq = nvme_next_ioq(nvme);
+
+    mtx_lock(&ioq->lock);
+    // Append after the current tail, which is the list head when it is empty.
+    list_splice_after(&txns, ioq->pending_txns.prev);
+    mtx_unlock(&ioq->lock);
+
+    sync_completion_signal(&ioq->io_signal);
 }
 
 static void nvme_query(void* ctx, block_info_t* info_out, size_t* block_op_size_out) {
@@ -623,26 +740,36 @@ static void nvme_release(void* ctx) {
         mmio_buffer_release(&nvme->mmio);
         // TODO: risks a handle use-after-close, will be resolved by IRQ api
         // changes coming soon
-        zx_handle_close(nvme->irqh);
-    }
-    if (nvme->flags & FLAG_IRQ_THREAD_STARTED) {
-        thrd_join(nvme->irqthread, &r);
+        for (unsigned n = 0; n < nvme->irq_count; n++) {
+            zx_handle_close(nvme->irq[n].irqh);
+        }
     }
-    if (nvme->flags & FLAG_IO_THREAD_STARTED) {
-        sync_completion_signal(&nvme->io_signal);
-        thrd_join(nvme->iothread, &r);
+    for (unsigned n = 0; n < nvme->irq_count; n++) {
+        if (nvme->irq[n].thread_started) {
+            thrd_join(nvme->irq[n].thread, &r);
+        }
     }
+    for (unsigned n = 0; n < MAX_IO_QUEUES; n++) {
+        nvme_ioq_t* ioq = &nvme->ioq[n];
+        if (ioq->thread_started) {
+            sync_completion_signal(&ioq->io_signal);
+            thrd_join(ioq->iothread, &r);
+        }
 
-    // error out any pending txns
-    mtx_lock(&nvme->lock);
-    nvme_txn_t* txn;
-    while ((txn = list_remove_head_type(&nvme->active_txns, nvme_txn_t, node)) != NULL) {
-        txn_complete(txn, ZX_ERR_PEER_CLOSED);
-    }
-    while ((txn = list_remove_head_type(&nvme->pending_txns, nvme_txn_t, node)) != NULL) {
-        txn_complete(txn, ZX_ERR_PEER_CLOSED);
+        // error out any pending txns
+        mtx_lock(&ioq->lock);
+        nvme_txn_t* txn;
+        while ((txn = list_remove_head_type(&ioq->active_txns, nvme_txn_t, node)) != NULL) {
+            txn_complete(txn, ZX_ERR_PEER_CLOSED);
+        }
+        while ((txn = list_remove_head_type(&ioq->pending_txns, nvme_txn_t, node)) != NULL) {
+            txn_complete(txn, ZX_ERR_PEER_CLOSED);
+        }
+        mtx_unlock(&ioq->lock);
+
+        io_buffer_release(&ioq->queue_iob);
+        io_buffer_release(&ioq->utxn_iob);
     }
-    mtx_unlock(&nvme->lock);
 
     io_buffer_release(&nvme->iob);
     free(nvme);
@@ -693,12 +820,9 @@ static void infostring(const char* prefix, uint8_t* str, size_t len) {
 // dedicated pages from the page pool
 #define IDX_ADMIN_SQ   0
 #define IDX_ADMIN_CQ   1
-#define IDX_IO_SQ      2
-#define IDX_IO_CQ      3
-#define IDX_SCRATCH    4
-#define IDX_UTXN_POOL  5 // this must always be last
+#define IDX_SCRATCH    2
 
-#define IO_PAGE_COUNT  (IDX_UTXN_POOL + UTXN_COUNT)
+#define IO_PAGE_COUNT  (IDX_SCRATCH + 1)
 
 static inline uint64_t U64(uint8_t* x) {
     return *((uint64_t*) (void*) x);
@@ -712,6 +836,80 @@ static inline uint32_t U16(uint8_t* x) {
 
 #define WAIT_MS 5000
 
+// Allocate the queues and scatter gather pages of an io queue pair,
+// and ask the controller to create it.
+static zx_status_t nvme_ioq_create(nvme_device_t* nvme, nvme_ioq_t* ioq, uint64_t cap,
+                                   uint16_t qid, uint16_t vector, uint16_t depth) {
+    ioq->nvme = nvme;
+    ioq->qid = qid;
+    ioq->vector = vector;
+    ioq->depth = depth;
+    ioq->utxn_count = depth - 1;
+
+    if (io_buffer_init(&ioq->queue_iob, nvme->bti, PAGE_SIZE * (IO_SQ_PAGES + 1),
+                       IO_BUFFER_RW | IO_BUFFER_CONTIG) ||
+        io_buffer_init(&ioq->utxn_iob, nvme->bti, PAGE_SIZE * ioq->utxn_count, IO_BUFFER_RW) ||
+        io_buffer_physmap(&ioq->utxn_iob)) {
+        zxlogf(ERROR, "nvme: q%u: could not allocate io buffers\n", qid);
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    // initialize the microtransaction pool
+    for (unsigned n = 0; n < ioq->utxn_count; n++) {
+        ioq->utxn_avail[n / 64] |= 1ULL << (n % 64);
+        ioq->utxn[n].id = n;
+        ioq->utxn[n].phys = ioq->utxn_iob.phys_list[n];
+        ioq->utxn[n].virt = ioq->utxn_iob.virt + n * PAGE_SIZE;
+    }
+
+    // registers and buffers for IO queues
+    ioq->sq_tail_db = nvme->mmio.vaddr + NVME_REG_SQnTDBL(qid, cap);
+    ioq->cq_head_db = nvme->mmio.vaddr + NVME_REG_CQnHDBL(qid, cap);
+
+    zx_paddr_t phys = io_buffer_phys(&ioq->queue_iob);
+    ioq->sq = io_buffer_virt(&ioq->queue_iob);
+    ioq->sq_head = 0;
+    ioq->sq_tail = 0;
+
+    ioq->cq = io_buffer_virt(&ioq->queue_iob) + IO_SQ_PAGES * PAGE_SIZE;
+    ioq->cq_head = 0;
+    ioq->cq_toggle = 1;
+
+    // create the IO completion queue
+    nvme_cmd_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.cmd = NVME_CMD_CID(0) | NVME_CMD_PRP | NVME_CMD_NORMAL | NVME_CMD_OPC(NVME_ADMIN_OP_CREATE_IOCQ);
+    cmd.dptr.prp[0] = phys + IO_SQ_PAGES * PAGE_SIZE;
+    cmd.u.raw[0] = ((depth - 1) << 16) | qid; // queue size, queue id
+    cmd.u.raw[1] = (vector << 16) | 2 | 1; // irq vector, irq enable, phys contig
+
+    if (nvme_admin_txn(nvme, &cmd, NULL) != ZX_OK) {
+        zxlogf(ERROR, "nvme: q%u: completion queue creation op failed\n", qid);
+        return ZX_ERR_INTERNAL;
+    }
+
+    // create the IO submit queue
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.cmd = NVME_CMD_CID(0) | NVME_CMD_PRP | NVME_CMD_NORMAL | NVME_CMD_OPC(NVME_ADMIN_OP_CREATE_IOSQ);
+    cmd.dptr.prp[0] = phys;
+    cmd.u.raw[0] = ((depth - 1) << 16) | qid; // queue size, queue id
+    cmd.u.raw[1] = (qid << 16) | 0 | 1; // cqid, qprio, phys contig
+
+    if (nvme_admin_txn(nvme, &cmd, NULL) != ZX_OK) {
+        zxlogf(ERROR, "nvme: q%u: submit queue creation op failed\n", qid);
+        return ZX_ERR_INTERNAL;
+    }
+
+    char name[ZX_MAX_NAME_LEN];
+    snprintf(name, sizeof(name), "nvme-io-thread-%u", qid);
+    if (thrd_create_with_name(&ioq->iothread, io_thread, ioq, name)) {
+        zxlogf(ERROR, "nvme; cannot create io thread\n");
+        return ZX_ERR_INTERNAL;
+    }
+    ioq->thread_started = true;
+    return ZX_OK;
+}
+
 static zx_status_t nvme_init(nvme_device_t* nvme) {
     uint32_t n = rd32(VS);
     uint64_t cap = rd64(CAP);
@@ -742,14 +940,6 @@ static zx_status_t nvme_init(nvme_device_t* nvme) {
         return ZX_ERR_NO_MEMORY;
     }
 
-    // initialize the microtransaction pool
-    nvme->utxn_avail = 0x7FFFFFFFFFFFFFFFULL;
-    for (unsigned n = 0; n < UTXN_COUNT; n++) {
-        nvme->utxn[n].id = n;
-        nvme->utxn[n].phys = nvme->iob.phys_list[IDX_UTXN_POOL + n];
-        nvme->utxn[n].virt = nvme->iob.virt + (IDX_UTXN_POOL + n) * PAGE_SIZE;
-    }
-
     if (rd32(CSTS) & NVME_CSTS_RDY) {
         zxlogf(INFO, "nvme: controller is active. resetting...\n");
         wr32(rd32(CC) & ~NVME_CC_EN, CC); // disable
@@ -799,32 +989,19 @@ static zx_status_t nvme_init(nvme_device_t* nvme) {
     nvme->admin_cq_head = 0;
     nvme->admin_cq_toggle = 1;
 
-    // registers and buffers for IO queues
-    nvme->io_sq_tail_db = nvme->mmio.vaddr + NVME_REG_SQnTDBL(1, cap);
-    nvme->io_cq_head_db = nvme->mmio.vaddr + NVME_REG_CQnHDBL(1, cap);
-
-    nvme->io_sq = nvme->iob.virt + PAGE_SIZE * IDX_IO_SQ;
-    nvme->io_sq_head = 0;
-    nvme->io_sq_tail = 0;
-
-    nvme->io_cq = nvme->iob.virt + PAGE_SIZE * IDX_IO_CQ;
-    nvme->io_cq_head = 0;
-    nvme->io_cq_toggle = 1;
-
     // scratch page for admin ops
     void* scratch = nvme->iob.virt + PAGE_SIZE * IDX_SCRATCH;
 
-    if (thrd_create_with_name(&nvme->irqthread, irq_thread, nvme, "nvme-irq-thread")) {
-        zxlogf(ERROR, "nvme; cannot create irq thread\n");
-        return ZX_ERR_INTERNAL;
-    }
-    nvme->flags |= FLAG_IRQ_THREAD_STARTED;
-
-    if (thrd_create_with_name(&nvme->iothread, io_thread, nvme, "nvme-io-thread")) {
-        zxlogf(ERROR, "nvme; cannot create io thread\n");
-        return ZX_ERR_INTERNAL;
+    for (unsigned n = 0; n < nvme->irq_count; n++) {
+        nvme_irq_t* irq = &nvme->irq[n];
+        char name[ZX_MAX_NAME_LEN];
+        snprintf(name, sizeof(name), "nvme-irq-thread-%u", n);
+        if (thrd_create_with_name(&irq->thread, irq_thread, irq, name)) {
+            zxlogf(ERROR, "nvme; cannot create irq thread\n");
+            return ZX_ERR_INTERNAL;
+        }
+        irq->thread_started = true;
     }
-    nvme->flags |= FLAG_IO_THREAD_STARTED;
 
     nvme_cmd_t cmd;
 
@@ -902,42 +1079,48 @@ static zx_status_t nvme_init(nvme_device_t* nvme) {
     FEATURE(ONCS, WRITE_UNCORRECTABLE);
     FEATURE(ONCS, COMPARE);
 
-    // set feature (number of queues) to 1 iosq and 1 iocq
+    // One io queue pair per interrupt vector beyond the admin one,
+    // or a single pair sharing vector 0 with the admin queue.
+    uint32_t want = (nvme->irq_count > 1) ? (nvme->irq_count - 1) : 1;
+
+    // set feature (number of queues); both counts are zero based
     memset(&cmd, 0, sizeof(cmd));
     cmd.cmd = NVME_CMD_CID(0) | NVME_CMD_PRP | NVME_CMD_NORMAL | NVME_CMD_OPC(NVME_ADMIN_OP_SET_FEATURE);
     cmd.u.raw[0] = NVME_FEATURE_NUMBER_OF_QUEUES;
-    cmd.u.raw[1] = 0;
+    cmd.u.raw[1] = ((want - 1) << 16) | (want - 1);
 
     nvme_cpl_t cpl;
     if (nvme_admin_txn(nvme, &cmd, &cpl) != ZX_OK) {
         zxlogf(ERROR, "nvme: set feature (number queues) op failed\n");
         return ZX_ERR_INTERNAL;
     }
-    zxlogf(INFO,"cpl.cmd %08x\n", cpl.cmd);
-
-    // create the IO completion queue
-    memset(&cmd, 0, sizeof(cmd));
-    cmd.cmd = NVME_CMD_CID(0) | NVME_CMD_PRP | NVME_CMD_NORMAL | NVME_CMD_OPC(NVME_ADMIN_OP_CREATE_IOCQ);
-    cmd.dptr.prp[0] = nvme->iob.phys_list[IDX_IO_CQ];
-    cmd.u.raw[0] = ((CQMAX - 1) << 16) | 1; // queue size, queue id
-    cmd.u.raw[1] = (0 << 16) | 2 | 1; // irq vector, irq enable, phys contig
-
-    if (nvme_admin_txn(nvme, &cmd, NULL) != ZX_OK) {
-        zxlogf(ERROR, "nvme: completion queue creation op failed\n");
-        return ZX_ERR_INTERNAL;
+    uint32_t nsqa = (cpl.cmd & 0xFFFF) + 1;
+    uint32_t ncqa = (cpl.cmd >> 16) + 1;
+    zxlogf(INFO, "nvme: io queues: requested %u, allocated %u sq / %u cq\n", want, nsqa, ncqa);
+    if (want > nsqa) {
+        want = nsqa;
+    }
+    if (want > ncqa) {
+        want = ncqa;
     }
 
-    // create the IO submit queue
-    memset(&cmd, 0, sizeof(cmd));
-    cmd.cmd = NVME_CMD_CID(0) | NVME_CMD_PRP | NVME_CMD_NORMAL | NVME_CMD_OPC(NVME_ADMIN_OP_CREATE_IOSQ);
-    cmd.dptr.prp[0] = nvme->iob.phys_list[IDX_IO_SQ];
-    cmd.u.raw[0] = ((SQMAX - 1) << 16) | 1; // queue size, queue id
-    cmd.u.raw[1] = (1 << 16) | 0 | 1; // cqid, qprio, phys contig
+    uint32_t depth = NVME_CAP_MQES(cap) + 1;
+    if (depth > IO_QUEUE_DEPTH) {
+        depth = IO_QUEUE_DEPTH;
+    }
 
-    if (nvme_admin_txn(nvme, &cmd, NULL) != ZX_OK) {
-        zxlogf(ERROR, "nvme: submit queue creation op failed\n");
+    for (unsigned n = 0; n < want; n++) {
+        uint16_t vector = (nvme->irq_count > 1) ? n + 1 : 0;
+        if (nvme_ioq_create(nvme, &nvme->ioq[n], cap, n + 1, vector, depth) != ZX_OK) {
+            // Make do with the queues created so far.
+            break;
+        }
+        nvme->ioq_count++;
+    }
+    if (nvme->ioq_count == 0) {
         return ZX_ERR_INTERNAL;
     }
+    zxlogf(INFO, "nvme: using %u io queue(s) of depth %u\n", nvme->ioq_count, depth);
 
     // identify namespace 1
     memset(&cmd, 0, sizeof(cmd));
@@ -1013,6 +1196,7 @@ static zx_status_t nvme_init(nvme_device_t* nvme) {
 block_impl_protocol_ops_t block_ops = {
     .query = nvme_query,
     .queue = nvme_queue,
+    .queue_batch = nvme_queue_batch,
 };
 
 static zx_status_t nvme_bind(void* ctx, zx_device_t* dev) {
@@ -1020,9 +1204,11 @@ static zx_status_t nvme_bind(void* ctx, zx_device_t* dev) {
     if ((nvme = calloc(1, sizeof(nvme_device_t))) == NULL) {
         return ZX_ERR_NO_MEMORY;
     }
-    list_initialize(&nvme->pending_txns);
-    list_initialize(&nvme->active_txns);
-    mtx_init(&nvme->lock, mtx_plain);
+    for (unsigned n = 0; n < MAX_IO_QUEUES; n++) {
+        list_initialize(&nvme->ioq[n].pending_txns);
+        list_initialize(&nvme->ioq[n].active_txns);
+        mtx_init(&nvme->ioq[n].lock, mtx_plain);
+    }
     mtx_init(&nvme->admin_lock, mtx_plain);
 
     if (device_get_protocol(dev, ZX_PROTOCOL_PCI, &nvme->pci)) {
@@ -1034,14 +1220,41 @@ static zx_status_t nvme_bind(void* ctx, zx_device_t* dev) {
         goto fail;
     }
 
+    // Prefer one MSI-X vector for the admin queue plus one per cpu,
+    // each serving its own io queue pair.
+    uint32_t nirq = 0;
+    uint32_t want = zx_system_get_num_cpus();
+    const char* value = getenv("driver.nvme.io-queues");
+    if (value != NULL) {
+        uint32_t n = (uint32_t) strtoul(value, NULL, 10);
+        if ((n >= 1) && (n < want)) {
+            want = n;
+        }
+    }
+    if (want > MAX_IO_QUEUES) {
+        want = MAX_IO_QUEUES;
+    }
+    want += 1;
+    if ((pci_query_irq_mode(&nvme->pci, ZX_PCIE_IRQ_MODE_MSI_X, &nirq) == ZX_OK) && (nirq > 1)) {
+        if (want > nirq) {
+            want = nirq;
+        }
+        if (pci_set_irq_mode(&nvme->pci, ZX_PCIE_IRQ_MODE_MSI_X, want) == ZX_OK) {
+            zxlogf(INFO, "nvme: irq mode %u, irq count %u, using %u\n",
+                   ZX_PCIE_IRQ_MODE_MSI_X, nirq, want);
+            nvme->irq_count = want;
+            goto irq_configured;
+        }
+    }
+
     uint32_t modes[3] = {
         ZX_PCIE_IRQ_MODE_MSI_X, ZX_PCIE_IRQ_MODE_MSI, ZX_PCIE_IRQ_MODE_LEGACY,
     };
-    uint32_t nirq = 0;
     for (unsigned n = 0; n < countof(modes); n++) {
         if ((pci_query_irq_mode(&nvme->pci, modes[n], &nirq) == ZX_OK) &&
             (pci_set_irq_mode(&nvme->pci, modes[n], 1) == ZX_OK)) {
             zxlogf(INFO, "nvme: irq mode %u, irq count %u (#%u)\n", modes[n], nirq, n);
+            nvme->irq_count = 1;
             goto irq_configured;
         }
     }
@@ -1049,10 +1262,25 @@ static zx_status_t nvme_bind(void* ctx, zx_device_t* dev) {
     goto fail;
 
 irq_configured:
-    if (pci_map_interrupt(&nvme->pci, 0, &nvme->irqh) != ZX_OK) {
-        zxlogf(ERROR, "nvme: could not map irq\n");
-        goto fail;
+    for (unsigned n = 0; n < nvme->irq_count; n++) {
+        nvme->irq[n].nvme = nvme;
+        nvme->irq[n].vector = n;
+        if (pci_map_interrupt(&nvme->pci, n, &nvme->irq[n].irqh) != ZX_OK) {
+            zxlogf(ERROR, "nvme: could not map irq %u\n", n);
+            nvme->irq_count = n;
+            goto fail;
+        }
+        if (n > 0) {
+            // Steer the vector of io queue pair n to cpu n-1.
+            uint32_t cpu = n - 1;
+            zx_status_t r = zx_object_set_property(nvme->irq[n].irqh, ZX_PROP_INTERRUPT_AFFINITY,
+                                                   &cpu, sizeof(cpu));
+            if (r != ZX_OK) {
+                zxlogf(INFO, "nvme: cannot steer irq %u to cpu %u: %d\n", n, cpu, r);
+            }
+        }
     }
+
     if (pci_enable_bus_master(&nvme->pci, true)) {
         zxlogf(ERROR, "nvme: cannot enable bus mastering\n");
         goto fail;
@@ -8,7 +8,6 @@
 #include <ddk/protocol/block.h>
 
 #include <zircon/device/ramdisk.h>
-#include <lib/sync/completion.h>
 
 #include <assert.h>
 #include <inttypes.h>
@@ -27,6 +26,9 @@
 
 #define MAX_TRANSFER_SIZE (1 << 19)
 
+// Upper bound on the number of threads servicing requests for one ramdisk.
+#define MAX_WORKER_COUNT 4
+
 typedef struct {
     zx_device_t* zxdev;
 } ramctl_device_t;
@@ -39,7 +41,7 @@ typedef struct ramdisk_device {
     uint8_t type_guid[ZBI_PARTITION_GUID_LEN];
 
     mtx_t lock;
-    sync_completion_t signal;
+    cnd_t cond;
     list_node_t txn_list;
     list_node_t deferred_list;
     bool dead;
@@ -50,8 +52,10 @@ typedef struct ramdisk_device {
     bool asleep; // true if the ramdisk is "sleeping"
     uint64_t sa_blk_count; // number of blocks to sleep after
     ramdisk_blk_counts_t blk_counts; // current block counts
+    ramdisk_latency_t latency; // simulated device timing
 
-    thrd_t worker;
+    thrd_t workers[MAX_WORKER_COUNT];
+    uint32_t worker_count;
     char name[NAME_MAX];
 } ramdisk_device_t;
 
@@ -62,54 +66,78 @@ typedef struct {
     void* cookie;
 } ramdisk_txn_t;
 
-// The worker thread processes messages from iotxns in the background
+// Sleeps for the time the latency model charges for |length| bytes.
+static void ramdisk_delay(const ramdisk_latency_t* latency, uint64_t fixed_ns, size_t length) {
+    zx_duration_t delay = fixed_ns;
+    if (latency->bytes_per_sec != 0) {
+        delay += (length * ZX_SEC(1)) / latency->bytes_per_sec;
+    }
+    if (delay > 0) {
+        zx_nanosleep(zx_deadline_after(delay));
+    }
+}
+
+// The worker threads process messages from iotxns in the background. Each
+// takes one transaction at a time, so requests are serviced in parallel.
 static int worker_thread(void* arg) {
     zx_status_t status = ZX_OK;
     ramdisk_device_t* dev = (ramdisk_device_t*)arg;
     ramdisk_txn_t* txn = NULL;
-    bool dead, asleep, defer;
-    size_t blocks = 0;
+    bool asleep, defer;
+    ramdisk_latency_t latency;
 
     for (;;) {
+        mtx_lock(&dev->lock);
         for (;;) {
-            mtx_lock(&dev->lock);
-            txn = NULL;
-            dead = dev->dead;
-            asleep = dev->asleep;
-            defer = (dev->flags & RAMDISK_FLAG_RESUME_ON_WAKE) != 0;
-            blocks = dev->sa_blk_count;
+            if (dev->dead) {
+                mtx_unlock(&dev->lock);
+                goto goodbye;
+            }
 
-            if (!asleep) {
+            txn = NULL;
+            if (!dev->asleep) {
                 // If we are awake, try grabbing pending transactions from the deferred list.
                 txn = list_remove_head_type(&dev->deferred_list, ramdisk_txn_t, node);
             }
-
             if (txn == NULL) {
                 // If no transactions were available in the deferred list (or we are asleep),
                 // grab one from the regular txn_list.
                 txn = list_remove_head_type(&dev->txn_list, ramdisk_txn_t, node);
             }
+            if (txn != NULL) {
+                break;
+            }
+            cnd_wait(&dev->cond, &dev->lock);
+        }
 
-            mtx_unlock(&dev->lock);
+        asleep = dev->asleep;
+        defer = (dev->flags & RAMDISK_FLAG_RESUME_ON_WAKE) != 0;
+        latency = dev->latency;
 
-            if (dead) {
-                goto goodbye;
+        size_t txn_blocks = txn->op.rw.length;
+        size_t blocks = txn_blocks;
+        if (txn->op.command == BLOCK_OP_WRITE) {
+            if (asleep && defer) {
+                // If we are asleep but resuming on wake, add txn to the deferred_list.
+                list_add_tail(&dev->deferred_list, &txn->node);
+                mtx_unlock(&dev->lock);
+                continue;
             }
-
-            if (txn == NULL) {
-                sync_completion_wait(&dev->signal, ZX_TIME_INFINITE);
-            } else {
-                sync_completion_reset(&dev->signal);
-                break;
+            if (!asleep && dev->sa_blk_count > 0) {
+                // If the ramdisk is configured to sleep after x blocks, claim this
+                // transaction's share of them now, so that writes running on other
+                // workers observe the sleep in the order they were dequeued.
+                blocks = MIN(txn_blocks, dev->sa_blk_count);
+                dev->sa_blk_count -= blocks;
+                dev->asleep = (dev->sa_blk_count == 0);
             }
         }
+        mtx_unlock(&dev->lock);
 
-        size_t txn_blocks = txn->op.rw.length;
-        if (txn->op.command == BLOCK_OP_READ || blocks == 0 || blocks > txn_blocks) {
-            // If the ramdisk is not configured to sleep after x blocks, or the number of blocks in
-            // this transaction does not exceed the sa_blk_count, or we are performing a read
-            // operation, use the current transaction length.
-            blocks = txn_blocks;
+        if (txn->op.command == BLOCK_OP_FLUSH) {
+            ramdisk_delay(&latency, latency.flush_ns, 0);
+            txn->completion_cb(txn->cookie, ZX_OK, &txn->op);
+            continue;
         }
 
         size_t length = blocks * dev->blk_size;
@@ -121,62 +149,47 @@ static int worker_thread(void* arg) {
             status = ZX_ERR_OUT_OF_RANGE;
         } else if (txn->op.command == BLOCK_OP_READ) {
             // A read operation should always succeed, even if the ramdisk is "asleep".
+            ramdisk_delay(&latency, latency.request_ns, length);
             status = zx_vmo_write(txn->op.rw.vmo, addr, vmo_offset, length);
         } else if (asleep) {
-            if (defer) {
-                // If we are asleep but resuming on wake, add txn to the deferred_list.
-                // deferred_list is only accessed by the worker_thread, so a lock is not needed.
-                list_add_tail(&dev->deferred_list, &txn->node);
-                continue;
-            } else {
-                status = ZX_ERR_UNAVAILABLE;
-            }
+            status = ZX_ERR_UNAVAILABLE;
         } else { // BLOCK_OP_WRITE
+            ramdisk_delay(&latency, latency.request_ns, length);
             status = zx_vmo_read(txn->op.rw.vmo, addr, vmo_offset, length);
-
-            if (status == ZX_OK && blocks < txn->op.rw.length && defer) {
-                // If the first part of the transaction succeeded but the entire transaction is not
-                // complete, we need to address the remainder.
-
-                // If we are deferring after this block count, update the transaction to
-                // reflect the blocks that have already been written, and add it to the
-                // deferred queue.
-                txn->op.rw.length -= blocks;
-                txn->op.rw.offset_vmo += blocks;
-                txn->op.rw.offset_dev += blocks;
-
-                // Add the remaining blocks to the deferred list.
-                list_add_tail(&dev->deferred_list, &txn->node);
-            }
         }
 
         if (txn->op.command == BLOCK_OP_WRITE) {
             // Update the ramdisk block counts. Since we aren't failing read transactions,
             // only include write transaction counts.
+            bool deferred = false;
             mtx_lock(&dev->lock);
             // Increment the count based on the result of the last transaction.
             if (status == ZX_OK) {
                 dev->blk_counts.successful += blocks;
 
-                if (blocks != txn_blocks && !defer) {
-                    // If we are not deferring, then any excess blocks have failed.
-                    dev->blk_counts.failed += txn_blocks - blocks;
-                    status = ZX_ERR_UNAVAILABLE;
+                if (blocks != txn_blocks) {
+                    if (defer) {
+                        // If the first part of the transaction succeeded but the entire
+                        // transaction is not complete, update the transaction to reflect the
+                        // blocks that have already been written, and add the remainder to
+                        // the deferred queue. The result is returned once it completes.
+                        txn->op.rw.length -= blocks;
+                        txn->op.rw.offset_vmo += blocks;
+                        txn->op.rw.offset_dev += blocks;
+                        list_add_tail(&dev->deferred_list, &txn->node);
+                        deferred = true;
+                    } else {
+                        // If we are not deferring, then any excess blocks have failed.
+                        dev->blk_counts.failed += txn_blocks - blocks;
+                        status = ZX_ERR_UNAVAILABLE;
+                    }
                 }
             } else {
                 dev->blk_counts.failed += txn_blocks;
             }
-
-            // Put the ramdisk to sleep if we have reached the required # of blocks.
-            if (dev->sa_blk_count > 0) {
-                dev->sa_blk_count -= blocks;
-                dev->asleep = (dev->sa_blk_count == 0);
-            }
             mtx_unlock(&dev->lock);
 
-            if (defer && blocks != txn_blocks && status == ZX_OK) {
-                // If we deferred partway through a transaction, hold off on returning the
-                // result until the remainder of the transaction is completed.
+            if (deferred) {
                 continue;
             }
         }
@@ -187,15 +200,18 @@ static int worker_thread(void* arg) {
     }
 
 goodbye:
-    while (txn != NULL) {
-        txn->completion_cb(txn->cookie, ZX_ERR_BAD_STATE, &txn->op);
+    for (;;) {
+        mtx_lock(&dev->lock);
         txn = list_remove_head_type(&dev->deferred_list, ramdisk_txn_t, node);
-
         if (txn == NULL) {
-            mtx_lock(&dev->lock);
             txn = list_remove_head_type(&dev->txn_list, ramdisk_txn_t, node);
-            mtx_unlock(&dev->lock);
         }
+        mtx_unlock(&dev->lock);
+
+        if (txn == NULL) {
+            break;
+        }
+        txn->completion_cb(txn->cookie, ZX_ERR_BAD_STATE, &txn->op);
     }
     return 0;
 }
@@ -220,8 +236,8 @@ static void ramdisk_unbind(void* ctx) {
     ramdisk_device_t* ramdev = ctx;
     mtx_lock(&ramdev->lock);
     ramdev->dead = true;
+    cnd_broadcast(&ramdev->cond);
     mtx_unlock(&ramdev->lock);
-    sync_completion_signal(&ramdev->signal);
     device_remove(ramdev->zxdev);
 }
 
@@ -251,8 +267,8 @@ static zx_status_t ramdisk_ioctl(void* ctx, uint32_t op, const void* cmd, size_t
         ramdev->asleep = false;
         memset(&ramdev->blk_counts, 0, sizeof(ramdev->blk_counts));
         ramdev->sa_blk_count = 0;
+        cnd_broadcast(&ramdev->cond);
         mtx_unlock(&ramdev->lock);
-        sync_completion_signal(&ramdev->signal);
         return ZX_OK;
     }
     case IOCTL_RAMDISK_SLEEP_AFTER: {
@@ -271,6 +287,15 @@ static zx_status_t ramdisk_ioctl(void* ctx, uint32_t op, const void* cmd, size_t
         mtx_unlock(&ramdev->lock);
         return ZX_OK;
     }
+    case IOCTL_RAMDISK_SET_LATENCY: {
+        if (cmd_len < sizeof(ramdisk_latency_t)) {
+            return ZX_ERR_INVALID_ARGS;
+        }
+        mtx_lock(&ramdev->lock);
+        memcpy(&ramdev->latency, cmd, sizeof(ramdisk_latency_t));
+        mtx_unlock(&ramdev->lock);
+        return ZX_OK;
+    }
     case IOCTL_RAMDISK_GET_BLK_COUNTS: {
         if (max < sizeof(ramdisk_blk_counts_t)) {
             return ZX_ERR_INVALID_ARGS;
@@ -339,17 +364,31 @@ static void ramdisk_queue(void* ctx, block_op_t* bop, block_impl_queue_callback
             txn->completion_cb = completion_cb;
             txn->cookie = cookie;
             list_add_tail(&ramdev->txn_list, &txn->node);
+            cnd_signal(&ramdev->cond);
         }
         mtx_unlock(&ramdev->lock);
         if (dead) {
             completion_cb(cookie, ZX_ERR_BAD_STATE, bop);
-        } else {
-            sync_completion_signal(&ramdev->signal);
         }
         break;
-    case BLOCK_OP_FLUSH:
-        completion_cb(cookie, ZX_OK, bop);
+    case BLOCK_OP_FLUSH: {
+        // Flushes are free unless the latency model gives them a cost, in which
+        // case a worker sleeps it off.
+        bool queued = false;
+        mtx_lock(&ramdev->lock);
+        if (!ramdev->dead && ramdev->latency.flush_ns != 0) {
+            txn->completion_cb = completion_cb;
+            txn->cookie = cookie;
+            list_add_tail(&ramdev->txn_list, &txn->node);
+            cnd_signal(&ramdev->cond);
+            queued = true;
+        }
+        mtx_unlock(&ramdev->lock);
+        if (!queued) {
+            completion_cb(cookie, ZX_OK, bop);
+        }
         break;
+    }
     default:
         completion_cb(cookie, ZX_ERR_NOT_SUPPORTED, bop);
         break;
@@ -368,14 +407,18 @@ static zx_off_t ramdisk_getsize(void* ctx) {
 static void ramdisk_release(void* ctx) {
     ramdisk_device_t* ramdev = ctx;
 
-    // Wake up the worker thread, in case it is sleeping
+    // Wake up the worker threads, in case they are sleeping
     mtx_lock(&ramdev->lock);
     ramdev->dead = true;
+    cnd_broadcast(&ramdev->cond);
     mtx_unlock(&ramdev->lock);
-    sync_completion_signal(&ramdev->signal);
 
-    int r;
-    thrd_join(ramdev->worker, &r);
+    for (uint32_t i = 0; i < ramdev->worker_count; i++) {
+        int r;
+        thrd_join(ramdev->workers[i], &r);
+    }
+    cnd_destroy(&ramdev->cond);
+    mtx_destroy(&ramdev->lock);
     if (ramdev->vmo != ZX_HANDLE_INVALID) {
         zx_vmar_unmap(zx_vmar_root_self(), ramdev->mapped_addr, sizebytes(ramdev));
         zx_handle_close(ramdev->vmo);
@@ -418,6 +461,9 @@ static zx_status_t ramctl_config(ramctl_device_t* ramctl, zx_handle_t vmo,
     if (mtx_init(&ramdev->lock, mtx_plain) != thrd_success) {
         goto fail_free;
     }
+    if (cnd_init(&ramdev->cond) != thrd_success) {
+        goto fail_mtx;
+    }
     ramdev->vmo = vmo;
     ramdev->blk_size = blk_size;
     ramdev->blk_count = blk_count;
@@ -432,12 +478,17 @@ static zx_status_t ramctl_config(ramctl_device_t* ramctl, zx_handle_t vmo,
     status = zx_vmar_map(zx_vmar_root_self(), ZX_VM_PERM_READ | ZX_VM_PERM_WRITE,
                          0, ramdev->vmo, 0, sizebytes(ramdev), &ramdev->mapped_addr);
     if (status != ZX_OK) {
-        goto fail_mtx;
+        goto fail_cnd;
     }
     list_initialize(&ramdev->txn_list);
     list_initialize(&ramdev->deferred_list);
-    if (thrd_create(&ramdev->worker, worker_thread, ramdev) != thrd_success) {
-        goto fail_unmap;
+    uint32_t worker_count = MIN(MAX(zx_system_get_num_cpus(), 1u), MAX_WORKER_COUNT);
+    for (ramdev->worker_count = 0; ramdev->worker_count < worker_count; ramdev->worker_count++) {
+        if (thrd_create_with_name(&ramdev->workers[ramdev->worker_count], worker_thread, ramdev,
+                                  "ramdisk-worker") != thrd_success) {
+            status = ZX_ERR_NO_RESOURCES;
+            goto fail_workers;
+        }
     }
 
     device_add_args_t args = {
@@ -457,8 +508,17 @@ static zx_status_t ramctl_config(ramctl_device_t* ramctl, zx_handle_t vmo,
     *out_actual = strlen(reply);
     return ZX_OK;
 
-fail_unmap:
+fail_workers:
+    mtx_lock(&ramdev->lock);
+    ramdev->dead = true;
+    cnd_broadcast(&ramdev->cond);
+    mtx_unlock(&ramdev->lock);
+    for (uint32_t i = 0; i < ramdev->worker_count; i++) {
+        thrd_join(ramdev->workers[i], NULL);
+    }
     zx_vmar_unmap(zx_vmar_root_self(), ramdev->mapped_addr, sizebytes(ramdev));
+fail_cnd:
+    cnd_destroy(&ramdev->cond);
 fail_mtx:
     mtx_destroy(&ramdev->lock);
 fail_free:
@@ -23,6 +23,9 @@
 #define STORAGE_SIZE    (10 * 1024 * 1024)
 #define BLOCK_COUNT     (STORAGE_SIZE / BLOCK_SIZE)
 #define DATA_REQ_SIZE   16384
+// data requests kept queued during reads and writes, so that one can be
+// filled from or copied to storage while the other is on the bus
+#define DATA_REQ_COUNT  2
 #define BULK_MAX_PACKET 512
 
 typedef enum {
@@ -69,7 +72,7 @@ typedef struct {
     zx_device_t* zxdev;
     usb_function_protocol_t function;
     usb_request_t* cbw_req;
-    usb_request_t* data_req;
+    usb_request_t* data_reqs[DATA_REQ_COUNT];
     usb_request_t* csw_req;
 
     // vmo for backing storage
@@ -83,9 +86,13 @@ typedef struct {
 
     // state for data transfers
     ums_data_state_t    data_state;
-    // state for reads and writes
-    zx_off_t data_offset;
-    size_t data_remaining;
+    // state for reads and writes. Data requests complete in the order they
+    // were queued, so the one completing is always for data_done_offset.
+    zx_off_t data_offset;       // storage offset for the next data request queued
+    size_t data_remaining;      // bytes left to queue data requests for
+    zx_off_t data_done_offset;  // storage offset of the oldest queued data request
+    unsigned data_queued;       // number of data requests queued
+    uint8_t data_status;        // CSW status for the transfer
 
     uint8_t bulk_out_addr;
     uint8_t bulk_in_addr;
@@ -116,9 +123,8 @@ static void ums_queue_csw(usb_ums_t* ums, uint8_t status) {
     usb_function_queue(&ums->function, ums->csw_req);
 }
 
-static void ums_continue_transfer(usb_ums_t* ums) {
-    usb_request_t* req = ums->data_req;
-
+// Queues |req| for the next part of the current read or write.
+static void ums_continue_transfer(usb_ums_t* ums, usb_request_t* req) {
     size_t length = ums->data_remaining;
     if (length > DATA_REQ_SIZE) {
         length = DATA_REQ_SIZE;
@@ -127,12 +133,15 @@ static void ums_continue_transfer(usb_ums_t* ums) {
 
     if (ums->data_state == DATA_STATE_READ) {
         usb_request_copy_to(req, ums->storage + ums->data_offset, length, 0);
-        ums_function_queue_data(ums, req);
-    } else if (ums->data_state == DATA_STATE_WRITE) {
-        ums_function_queue_data(ums, req);
-    } else {
+    } else if (ums->data_state != DATA_STATE_WRITE) {
         zxlogf(ERROR, "ums_continue_transfer: bad data state %d\n", ums->data_state);
+        return;
     }
+
+    ums->data_offset += length;
+    ums->data_remaining -= length;
+    ums->data_queued++;
+    ums_function_queue_data(ums, req);
 }
 
 static void ums_start_transfer(usb_ums_t* ums, ums_data_state_t state, uint64_t lba,
@@ -150,14 +159,25 @@ static void ums_start_transfer(usb_ums_t* ums, ums_data_state_t state, uint64_t
     ums->data_state = state;
     ums->data_offset = offset;
     ums->data_remaining = length;
+    ums->data_done_offset = offset;
+    ums->data_queued = 0;
+    ums->data_status = CSW_SUCCESS;
 
-    ums_continue_transfer(ums);
+    if (length == 0) {
+        ums->data_state = DATA_STATE_NONE;
+        ums_queue_csw(ums, CSW_SUCCESS);
+        return;
+    }
+
+    for (unsigned i = 0; i < DATA_REQ_COUNT && ums->data_remaining > 0; i++) {
+        ums_continue_transfer(ums, ums->data_reqs[i]);
+    }
 }
 
 static void ums_handle_inquiry(usb_ums_t* ums, ums_cbw_t* cbw) {
     zxlogf(TRACE, "ums_handle_inquiry\n");
 
-    usb_request_t* req = ums->data_req;
+    usb_request_t* req = ums->data_reqs[0];
     uint8_t* buffer;
     usb_request_mmap(req, (void **)&buffer);
     memset(buffer, 0, UMS_INQUIRY_TRANSFER_LENGTH);
@@ -186,7 +206,7 @@ static void ums_handle_test_unit_ready(usb_ums_t* ums, ums_cbw_t* cbw) {
 static void ums_handle_request_sense(usb_ums_t* ums, ums_cbw_t* cbw) {
     zxlogf(TRACE, "ums_handle_request_sense\n");
 
-    usb_request_t* req = ums->data_req;
+    usb_request_t* req = ums->data_reqs[0];
     uint8_t* buffer;
     usb_request_mmap(req, (void **)&buffer);
     memset(buffer, 0, UMS_REQUEST_SENSE_TRANSFER_LENGTH);
@@ -205,7 +225,7 @@ static void ums_handle_request_sense(usb_ums_t* ums, ums_cbw_t* cbw) {
 static void ums_handle_read_capacity10(usb_ums_t* ums, ums_cbw_t* cbw) {
     zxlogf(TRACE, "ums_handle_read_capacity10\n");
 
-    usb_request_t* req = ums->data_req;
+    usb_request_t* req = ums->data_reqs[0];
     scsi_read_capacity_10_t* data;
     usb_request_mmap(req, (void **)&data);
 
@@ -225,7 +245,7 @@ static void ums_handle_read_capacity10(usb_ums_t* ums, ums_cbw_t* cbw) {
 static void ums_handle_read_capacity16(usb_ums_t* ums, ums_cbw_t* cbw) {
     zxlogf(TRACE, "ums_handle_read_capacity16\n");
 
-    usb_request_t* req = ums->data_req;
+    usb_request_t* req = ums->data_reqs[0];
     scsi_read_capacity_16_t* data;
     usb_request_mmap(req, (void **)&data);
     memset(data, 0, sizeof(*data));
@@ -241,7 +261,7 @@ static void ums_handle_read_capacity16(usb_ums_t* ums, ums_cbw_t* cbw) {
 static void ums_handle_mode_sense6(usb_ums_t* ums, ums_cbw_t* cbw) {
     zxlogf(TRACE, "ums_handle_mode_sense6\n");
 
-    usb_request_t* req = ums->data_req;
+    usb_request_t* req = ums->data_reqs[0];
     scsi_mode_sense_6_data_t* data;
     usb_request_mmap(req, (void **)&data);
     memset(data, 0, sizeof(*data));
@@ -359,7 +379,7 @@ static void ums_handle_cbw(usb_ums_t* ums, ums_cbw_t* cbw) {
         zxlogf(TRACE, "ums_handle_cbw: unsupported opcode %d\n", command->opcode);
         if (cbw->dCBWDataTransferLength) {
             // queue zero length packet to satisfy data phase
-            usb_request_t* req = ums->data_req;
+            usb_request_t* req = ums->data_reqs[0];
             req->header.length = 0;
             ums_function_queue_data(ums, req);
         }
@@ -385,24 +405,28 @@ static void ums_data_complete(usb_request_t* req, void* cookie) {
 
     zxlogf(TRACE, "ums_data_complete %d %ld\n", req->response.status, req->response.actual);
 
-    if (ums->data_state == DATA_STATE_WRITE) {
-        usb_request_copy_from(req, ums->storage + ums->data_offset, req->response.actual, 0);
-    } else if (ums->data_state != DATA_STATE_READ) {
+    if (ums->data_state != DATA_STATE_READ && ums->data_state != DATA_STATE_WRITE) {
         return;
     }
+    ums->data_queued--;
 
-    ums->data_offset += req->response.actual;
-    if (ums->data_remaining > req->response.actual) {
-        ums->data_remaining -= req->response.actual;
-    } else {
+    if (ums->data_state == DATA_STATE_WRITE && req->response.status == ZX_OK) {
+        usb_request_copy_from(req, ums->storage + ums->data_done_offset, req->response.actual, 0);
+    }
+    ums->data_done_offset += req->header.length;
+
+    // after a failed or short transfer, let the requests already queued
+    // finish and then fail the command
+    if (req->response.status != ZX_OK || req->response.actual < req->header.length) {
+        ums->data_status = CSW_FAILED;
         ums->data_remaining = 0;
     }
 
     if (ums->data_remaining > 0) {
-        ums_continue_transfer(ums);
-    } else {
+        ums_continue_transfer(ums, req);
+    } else if (ums->data_queued == 0) {
         ums->data_state = DATA_STATE_NONE;
-        ums_queue_csw(ums, CSW_SUCCESS);
+        ums_queue_csw(ums, ums->data_status);
     }
 }
 
@@ -482,10 +506,12 @@ static void usb_ums_release(void* ctx) {
     if (ums->cbw_req) {
         usb_request_release(ums->cbw_req);
     }
-    if (ums->data_req) {
-        usb_request_release(ums->data_req);
+    for (unsigned i = 0; i < DATA_REQ_COUNT; i++) {
+        if (ums->data_reqs[i]) {
+            usb_request_release(ums->data_reqs[i]);
+        }
     }
-    if (ums->cbw_req) {
+    if (ums->csw_req) {
         usb_request_release(ums->csw_req);
     }
     free(ums);
@@ -535,11 +561,13 @@ zx_status_t usb_ums_bind(void* ctx, zx_device_t* parent) {
     if (status != ZX_OK) {
         goto fail;
     }
-    // Endpoint for data_req depends on current_cbw.bmCBWFlags,
+    // Endpoint for data_reqs depends on current_cbw.bmCBWFlags,
     // and will be set in ums_function_queue_data.
-    status = usb_request_alloc(&ums->data_req, DATA_REQ_SIZE, 0, sizeof(usb_request_t));
-    if (status != ZX_OK) {
-        goto fail;
+    for (unsigned i = 0; i < DATA_REQ_COUNT; i++) {
+        status = usb_request_alloc(&ums->data_reqs[i], DATA_REQ_SIZE, 0, sizeof(usb_request_t));
+        if (status != ZX_OK) {
+            goto fail;
+        }
     }
     status = usb_request_alloc(&ums->csw_req, BULK_MAX_PACKET,
                                     ums->bulk_in_addr, sizeof(usb_request_t));
@@ -560,11 +588,13 @@ zx_status_t usb_ums_bind(void* ctx, zx_device_t* parent) {
 
     ums->csw_req->header.length = sizeof(ums_csw_t);
     ums->cbw_req->complete_cb = ums_cbw_complete;
-    ums->data_req->complete_cb = ums_data_complete;
     ums->csw_req->complete_cb = ums_csw_complete;
     ums->cbw_req->cookie = ums;
-    ums->data_req->cookie = ums;
     ums->csw_req->cookie = ums;
+    for (unsigned i = 0; i < DATA_REQ_COUNT; i++) {
+        ums->data_reqs[i]->complete_cb = ums_data_complete;
+        ums->data_reqs[i]->cookie = ums;
+    }
 
     device_add_args_t args = {
         .version = DEVICE_ADD_ARGS_VERSION,
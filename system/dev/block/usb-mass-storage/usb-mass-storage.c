@@ -68,15 +68,18 @@ static void ums_req_complete(usb_request_t* req, void* cookie) {
     }
 }
 
-static void ums_send_cbw(ums_t* ums, uint8_t lun, uint32_t transfer_length, uint8_t flags,
-                         uint8_t command_len, void* command) {
+// queues a CBW without waiting for it to be sent. |completion| is signaled when it has been,
+// unless an error is returned.
+static zx_status_t ums_queue_cbw(ums_t* ums, uint8_t lun, uint32_t transfer_length, uint8_t flags,
+                                 uint8_t command_len, void* command,
+                                 sync_completion_t* completion) {
     usb_request_t* req = ums->cbw_req;
 
     ums_cbw_t* cbw;
     zx_status_t status = usb_request_mmap(req, (void **)&cbw);
     if (status != ZX_OK) {
         DEBUG_PRINT(("UMS: usb request mmap failed: %d\n", status));
-        return;
+        return status;
     }
 
     memset(cbw, 0, sizeof(*cbw));
@@ -90,10 +93,18 @@ static void ums_send_cbw(ums_t* ums, uint8_t lun, uint32_t transfer_length, uint
     // copy command_len bytes from the command passed in into the command_len
     memcpy(cbw->CBWCB, command, command_len);
 
-    sync_completion_t completion = SYNC_COMPLETION_INIT;
-    req->cookie = &completion;
+    req->cookie = completion;
     usb_request_queue(&ums->usb, req);
-    sync_completion_wait(&completion, ZX_TIME_INFINITE);
+    return ZX_OK;
+}
+
+static void ums_send_cbw(ums_t* ums, uint8_t lun, uint32_t transfer_length, uint8_t flags,
+                         uint8_t command_len, void* command) {
+    sync_completion_t completion = SYNC_COMPLETION_INIT;
+    if (ums_queue_cbw(ums, lun, transfer_length, flags, command_len, command,
+                      &completion) == ZX_OK) {
+        sync_completion_wait(&completion, ZX_TIME_INFINITE);
+    }
 }
 
 static zx_status_t ums_read_csw(ums_t* ums, uint32_t* out_residue) {
@@ -305,6 +316,11 @@ static zx_status_t ums_read(ums_block_t* dev, ums_txn_t* txn) {
         }
         size_t length = blocks * block_size;
 
+        // The CBW is queued without waiting for it to go out, so that the data
+        // stage is already queued behind it when the device is ready for it.
+        sync_completion_t cbw_completion = SYNC_COMPLETION_INIT;
+        zx_status_t cbw_status;
+
         // CBW Configuration
         // Need to use UMS_READ16 if block addresses are greater than 32 bit
         if (dev->total_blocks > UINT32_MAX) {
@@ -313,7 +329,8 @@ static zx_status_t ums_read(ums_block_t* dev, ums_txn_t* txn) {
             command.opcode = UMS_READ16;
             command.lba = htobe64(block_offset);
             command.length = htobe32(blocks);
-            ums_send_cbw(ums, dev->lun, length, USB_DIR_IN, sizeof(command), &command);
+            cbw_status = ums_queue_cbw(ums, dev->lun, length, USB_DIR_IN, sizeof(command),
+                                       &command, &cbw_completion);
         } else if (blocks <= UINT16_MAX) {
             scsi_command10_t command;
             memset(&command, 0, sizeof(command));
@@ -321,17 +338,22 @@ static zx_status_t ums_read(ums_block_t* dev, ums_txn_t* txn) {
             command.lba = htobe32(block_offset);
             command.length_hi = blocks >> 8;
             command.length_lo = blocks & 0xFF;
-            ums_send_cbw(ums, dev->lun, length, USB_DIR_IN, sizeof(command), &command);
+            cbw_status = ums_queue_cbw(ums, dev->lun, length, USB_DIR_IN, sizeof(command),
+                                       &command, &cbw_completion);
         } else {
             scsi_command12_t command;
             memset(&command, 0, sizeof(command));
             command.opcode = UMS_READ12;
             command.lba = htobe32(block_offset);
             command.length = htobe32(blocks);
-            ums_send_cbw(ums, dev->lun, length, USB_DIR_IN, sizeof(command), &command);
+            cbw_status = ums_queue_cbw(ums, dev->lun, length, USB_DIR_IN, sizeof(command),
+                                       &command, &cbw_completion);
         }
 
         status = ums_data_transfer(ums, txn, vmo_offset, length, ums->bulk_in_addr);
+        if (cbw_status == ZX_OK) {
+            sync_completion_wait(&cbw_completion, ZX_TIME_INFINITE);
+        }
 
         block_offset += blocks;
         num_blocks -= blocks;
@@ -370,6 +392,11 @@ static zx_status_t ums_write(ums_block_t* dev, ums_txn_t* txn) {
         }
         size_t length = blocks * block_size;
 
+        // The CBW is queued without waiting for it to go out, so that the data
+        // stage is already queued behind it when the device is ready for it.
+        sync_completion_t cbw_completion = SYNC_COMPLETION_INIT;
+        zx_status_t cbw_status;
+
         // CBW Configuration
         // Need to use UMS_WRITE16 if block addresses are greater than 32 bit
         if (dev->total_blocks > UINT32_MAX) {
@@ -378,7 +405,8 @@ static zx_status_t ums_write(ums_block_t* dev, ums_txn_t* txn) {
             command.opcode = UMS_WRITE16;
             command.lba = htobe64(block_offset);
             command.length = htobe32(blocks);
-            ums_send_cbw(ums, dev->lun, length, USB_DIR_OUT, sizeof(command), &command);
+            cbw_status = ums_queue_cbw(ums, dev->lun, length, USB_DIR_OUT, sizeof(command),
+                                       &command, &cbw_completion);
         } else if (blocks <= UINT16_MAX) {
             scsi_command10_t command;
             memset(&command, 0, sizeof(command));
@@ -386,17 +414,22 @@ static zx_status_t ums_write(ums_block_t* dev, ums_txn_t* txn) {
             command.lba = htobe32(block_offset);
             command.length_hi = blocks >> 8;
             command.length_lo = blocks & 0xFF;
-            ums_send_cbw(ums, dev->lun, length, USB_DIR_OUT, sizeof(command), &command);
+            cbw_status = ums_queue_cbw(ums, dev->lun, length, USB_DIR_OUT, sizeof(command),
+                                       &command, &cbw_completion);
         } else {
             scsi_command12_t command;
             memset(&command, 0, sizeof(command));
             command.opcode = UMS_WRITE12;
             command.lba = htobe32(block_offset);
             command.length = htobe32(blocks);
-            ums_send_cbw(ums, dev->lun, length, USB_DIR_OUT, sizeof(command), &command);
+            cbw_status = ums_queue_cbw(ums, dev->lun, length, USB_DIR_OUT, sizeof(command),
+                                       &command, &cbw_completion);
         }
 
         status = ums_data_transfer(ums, txn, vmo_offset, length, ums->bulk_out_addr);
+        if (cbw_status == ZX_OK) {
+            sync_completion_wait(&cbw_completion, ZX_TIME_INFINITE);
+        }
 
         block_offset += blocks;
         num_blocks -= blocks;
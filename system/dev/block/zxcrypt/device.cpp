@@ -10,6 +10,7 @@
 
 #include <ddk/debug.h>
 #include <ddk/device.h>
+#include <ddk/protocol/block-lib.h>
 #include <fbl/algorithm.h>
 #include <fbl/alloc_checker.h>
 #include <fbl/atomic.h>
@@ -23,6 +24,7 @@
 #include <zircon/device/block.h>
 #include <zircon/errors.h>
 #include <zircon/status.h>
+#include <zircon/syscalls.h>
 #include <zircon/thread_annotations.h>
 #include <zircon/types.h>
 #include <zxcrypt/volume.h>
@@ -158,17 +160,24 @@ zx_status_t Device::Init() {
         return rc;
     }
 
-    // Start workers
-    // TODO(aarongreen): Investigate performance implications of adding more workers.
+    // Start workers.  Each pulls requests from the shared port, so with one per CPU independent
+    // requests are transformed in parallel, and the encryption of one write overlaps the parent
+    // device's I/O for those already forwarded.
     if ((rc = zx::port::create(0, &port_)) != ZX_OK) {
         zxlogf(ERROR, "zx::port::create failed: %s\n", zx_status_get_string(rc));
         return rc;
     }
-    for (size_t i = 0; i < kNumWorkers; ++i) {
+    uint32_t num_workers = fbl::clamp(zx_system_get_num_cpus(), 1u, kMaxWorkers);
+    workers_.reset(new (&ac) Worker[num_workers]);
+    if (!ac.check()) {
+        zxlogf(ERROR, "failed to allocate %zu bytes\n", num_workers * sizeof(Worker));
+        return ZX_ERR_NO_MEMORY;
+    }
+    for (uint32_t i = 0; i < num_workers; ++i) {
         zx::port port;
         port_.duplicate(ZX_RIGHT_SAME_RIGHTS, &port);
         if ((rc = workers_[i].Start(this, *volume, fbl::move(port))) != ZX_OK) {
-            zxlogf(ERROR, "failed to start worker %zu: %s\n", i, zx_status_get_string(rc));
+            zxlogf(ERROR, "failed to start worker %" PRIu32 ": %s\n", i, zx_status_get_string(rc));
             return rc;
         }
         ++info->num_workers;
@@ -180,7 +189,7 @@ zx_status_t Device::Init() {
     // Enable the device
     active_.store(true);
     DdkMakeVisible();
-    zxlogf(TRACE, "zxcrypt device %p initialized\n", this);
+    zxlogf(TRACE, "zxcrypt device %p initialized with %" PRIu32 " workers\n", this, num_workers);
 
     cleanup.cancel();
     return ZX_OK;
@@ -326,16 +335,13 @@ void Device::BlockImplQuery(block_info_t* out_info, size_t* out_op_size) {
     *out_op_size = info_->op_size;
 }
 
-void Device::BlockImplQueue(block_op_t* block, block_impl_queue_callback completion_cb,
-                            void* cookie) {
-    LOG_ENTRY_ARGS("block=%p", block);
-    ZX_DEBUG_ASSERT(info_);
-
+bool Device::BlockStart(block_op_t* block, block_impl_queue_callback completion_cb,
+                        void* cookie) {
     // Check if the device is active.
     if (!active_.load()) {
         zxlogf(ERROR, "rejecting I/O request: device is not active\n");
         completion_cb(cookie, ZX_ERR_BAD_STATE, block);
-        return;
+        return false;
     }
     num_ops_.fetch_add(1);
 
@@ -345,6 +351,17 @@ void Device::BlockImplQueue(block_op_t* block, block_impl_queue_callback complet
     if (rc != ZX_OK) {
         zxlogf(ERROR, "failed to initialize extra info: %s\n", zx_status_get_string(rc));
         BlockComplete(block, rc);
+        return false;
+    }
+    return true;
+}
+
+void Device::BlockImplQueue(block_op_t* block, block_impl_queue_callback completion_cb,
+                            void* cookie) {
+    LOG_ENTRY_ARGS("block=%p", block);
+    ZX_DEBUG_ASSERT(info_);
+
+    if (!BlockStart(block, completion_cb, cookie)) {
         return;
     }
 
@@ -359,6 +376,28 @@ void Device::BlockImplQueue(block_op_t* block, block_impl_queue_callback complet
     }
 }
 
+void Device::BlockImplQueueBatch(block_op_t** blocks, size_t count,
+                                 block_impl_queue_callback completion_cb, void* cookie) {
+    LOG_ENTRY_ARGS("blocks=%p, count=%zu", blocks, count);
+    ZX_DEBUG_ASSERT(info_);
+
+    // Writes still go through the write queue and the workers.  Everything else is forwarded
+    // as-is, so it is packed at the front of |blocks| and sent to the parent device together.
+    size_t num_forward = 0;
+    for (size_t i = 0; i < count; ++i) {
+        block_op_t* block = blocks[i];
+        if (!BlockStart(block, completion_cb, cookie)) {
+            continue;
+        }
+        if ((block->command & BLOCK_OP_MASK) == BLOCK_OP_WRITE) {
+            EnqueueWrite(block);
+            continue;
+        }
+        blocks[num_forward++] = block;
+    }
+    block_impl_queue_many(&info_->proto, blocks, num_forward, BlockCallback, this);
+}
+
 void Device::BlockForward(block_op_t* block, zx_status_t status) {
     LOG_ENTRY_ARGS("block=%p, status=%s", block, zx_status_get_string(status));
     ZX_DEBUG_ASSERT(info_);
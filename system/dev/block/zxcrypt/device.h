@@ -18,6 +18,7 @@
 #include <fbl/atomic.h>
 #include <fbl/macros.h>
 #include <fbl/mutex.h>
+#include <fbl/unique_ptr.h>
 #include <lib/zx/port.h>
 #include <lib/zx/vmar.h>
 #include <lib/zx/vmo.h>
@@ -72,6 +73,9 @@ public:
                                   size_t reply_size, size_t* out_reply_actual) {
         return ZX_ERR_NOT_SUPPORTED;
     }
+    void BlockImplQueueBatch(block_op_t** blocks, size_t count,
+                             block_impl_queue_callback completion_cb, void* cookie)
+        __TA_EXCLUDES(mtx_);
 
     // If |status| is |ZX_OK|, sends |block| to the parent block device; otherwise calls
     // |BlockComplete| on the |block|. Uses the extra space following the |block| to save fields
@@ -84,9 +88,14 @@ public:
 private:
     DISALLOW_COPY_ASSIGN_AND_MOVE(Device);
 
-    // TODO(aarongreen): Investigate performance impact of changing this.
-    // Number of encrypting/decrypting workers
-    static const size_t kNumWorkers = 2;
+    // Maximum number of encrypting/decrypting workers.  The device starts one per CPU, up to this
+    // limit.
+    static const uint32_t kMaxWorkers = 16;
+
+    // Prepares an incoming |block| request, saving the caller's fields in its extra space.  Returns
+    // false if it could not be, in which case |block| has already been completed.
+    bool BlockStart(block_op_t* block, block_impl_queue_callback completion_cb, void* cookie)
+        __TA_EXCLUDES(mtx_);
 
     // Adds |block| to the write queue if not null, and sends to the workers as many write requests
     // as fit in the space available in the write buffer.
@@ -141,8 +150,8 @@ private:
     // The |Init| thread, used to configure and add the device.
     thrd_t init_;
 
-    // Threads that performs encryption/decryption.
-    Worker workers_[kNumWorkers];
+    // Threads that performs encryption/decryption.  There are |info_->num_workers| of them.
+    fbl::unique_ptr<Worker[]> workers_;
 
     // Port used to send write/read operations to be encrypted/decrypted.
     zx::port port_;
@@ -495,42 +495,8 @@ static ACPI_STATUS acpi_ns_walk_callback(ACPI_HANDLE object, uint32_t nesting_le
 
     if ((!memcmp(hid, PCI_EXPRESS_ROOT_HID_STRING, HID_LENGTH) ||
          !memcmp(hid, PCI_ROOT_HID_STRING, HID_LENGTH))) {
-// TODO(cja): Stubbed out for userspace PCI development
-#ifdef ENABLE_USER_PCI
-        register_pci_root(object);
-#else
-        if (!ctx->found_pci) {
-            // Report current resources to kernel PCI driver
-            zx_status_t status = pci_report_current_resources(get_root_resource());
-            if (status != ZX_OK) {
-                zxlogf(ERROR, "acpi: WARNING: ACPI failed to report all current resources!\n");
-            }
-
-            // Initialize kernel PCI driver
-            zx_pci_init_arg_t* arg;
-            uint32_t arg_size;
-            status = get_pci_init_arg(&arg, &arg_size);
-            if (status != ZX_OK) {
-                zxlogf(ERROR, "acpi: erorr %d in get_pci_init_arg\n", status);
-                return AE_ERROR;
-            }
-
-            status = zx_pci_init(get_root_resource(), arg, arg_size);
-            if (status != ZX_OK) {
-                zxlogf(ERROR, "acpi: error %d in zx_pci_init\n", status);
-                return AE_ERROR;
-            }
-
-            free(arg);
-
-            // Publish PCI root as top level
-            // Only publish one PCI root device for all PCI roots
-            // TODO: store context for PCI root protocol
-            parent = device_get_parent(parent);
-            zx_device_t* pcidev = publish_device(parent, object, info, "pci",
-                    ZX_PROTOCOL_PCIROOT, get_pciroot_ops());
-            ctx->found_pci = (pcidev != NULL);
-        }
+        // PCI roots were already set up by publish_pci_roots().
+#ifndef ENABLE_USER_PCI
         // Get the PCI base bus number
         zx_status_t status = acpi_bbn_call(object, &ctx->last_pci);
         if (status != ZX_OK) {
@@ -565,29 +531,140 @@ out:
     return AE_OK;
 }
 
-static zx_status_t publish_acpi_devices(zx_device_t* parent) {
-    zx_status_t status = pwrbtn_init(parent);
-    if (status != ZX_OK) {
-        zxlogf(ERROR, "acpi: failed to initialize pwrbtn device: %d\n", status);
+static ACPI_STATUS acpi_pci_root_callback(ACPI_HANDLE object, uint32_t nesting_level,
+                                          void* context, void** status) {
+    ACPI_DEVICE_INFO* info = NULL;
+    ACPI_STATUS acpi_status = AcpiGetObjectInfo(object, &info);
+    if (acpi_status != AE_OK) {
+        return acpi_status;
+    }
+
+    // AcpiGetDevices() also matches on _CID, but PCI roots are recognized by
+    // their _HID alone, as in acpi_ns_walk_callback().
+    publish_acpi_device_ctx_t* ctx = (publish_acpi_device_ctx_t*)context;
+    const char* hid = hid_from_acpi_devinfo(info);
+    if (hid == NULL ||
+        memcmp(hid, ctx->pci_hid, HID_LENGTH)) {
+        goto out;
+    }
+
+// TODO(cja): Stubbed out for userspace PCI development
+#ifdef ENABLE_USER_PCI
+    register_pci_root(object);
+#else
+    if (!ctx->found_pci) {
+        // Report current resources to kernel PCI driver
+        zx_status_t status = pci_report_current_resources(get_root_resource());
+        if (status != ZX_OK) {
+            zxlogf(ERROR, "acpi: WARNING: ACPI failed to report all current resources!\n");
+        }
+
+        // Initialize kernel PCI driver
+        zx_pci_init_arg_t* arg;
+        uint32_t arg_size;
+        status = get_pci_init_arg(&arg, &arg_size);
+        if (status != ZX_OK) {
+            zxlogf(ERROR, "acpi: erorr %d in get_pci_init_arg\n", status);
+            acpi_status = AE_ERROR;
+            goto out;
+        }
+
+        status = zx_pci_init(get_root_resource(), arg, arg_size);
+        if (status != ZX_OK) {
+            zxlogf(ERROR, "acpi: error %d in zx_pci_init\n", status);
+            acpi_status = AE_ERROR;
+            goto out;
+        }
+
+        free(arg);
+
+        // Publish PCI root as top level
+        // Only publish one PCI root device for all PCI roots
+        // TODO: store context for PCI root protocol
+        zx_device_t* parent = device_get_parent(ctx->parent);
+        zx_device_t* pcidev = publish_device(parent, object, info, "pci",
+                ZX_PROTOCOL_PCIROOT, get_pciroot_ops());
+        ctx->found_pci = (pcidev != NULL);
     }
+#endif
+
+out:
+    ACPI_FREE(info);
 
-    // Walk the ACPI namespace for devices and publish them
-    // Only publish a single PCI device
-    publish_acpi_device_ctx_t ctx = {
-        .parent = parent,
-        .found_pci = false,
-        .last_pci = 0xFF,
+    return acpi_status;
+}
+
+// Set up the PCI roots ahead of the full namespace walk, so that PCI
+// enumeration is not held up by the evaluation of every other device.
+static zx_status_t publish_pci_roots(publish_acpi_device_ctx_t* ctx) {
+    static const char* const hids[] = {
+        PCI_EXPRESS_ROOT_HID_STRING,
+        PCI_ROOT_HID_STRING,
     };
+    for (size_t i = 0; i < countof(hids); i++) {
+        ctx->pci_hid = hids[i];
+        ACPI_STATUS acpi_status = AcpiGetDevices((char*)hids[i], acpi_pci_root_callback,
+                                                 ctx, NULL);
+        if (acpi_status != AE_OK) {
+            return ZX_ERR_BAD_STATE;
+        }
+    }
+    return ZX_OK;
+}
+
+static int publish_acpi_devices_thread(void* arg) {
+    publish_acpi_device_ctx_t* ctx = arg;
+
+    zx_time_t start = zx_clock_get_monotonic();
     ACPI_STATUS acpi_status = AcpiWalkNamespace(ACPI_TYPE_DEVICE,
                                                 ACPI_ROOT_OBJECT,
                                                 MAX_NAMESPACE_DEPTH,
                                                 acpi_ns_walk_callback,
-                                                NULL, &ctx, NULL);
+                                                NULL, ctx, NULL);
     if (acpi_status != AE_OK) {
-        return ZX_ERR_BAD_STATE;
-    } else {
+        zxlogf(ERROR, "acpi: acpi error 0x%x in namespace walk\n", acpi_status);
+    }
+    zxlogf(INFO, "acpi: namespace walk took %" PRId64 " ms\n",
+           (zx_clock_get_monotonic() - start) / ZX_MSEC(1));
+
+    free(ctx);
+    return 0;
+}
+
+static zx_status_t publish_acpi_devices(zx_device_t* parent) {
+    zx_status_t status = pwrbtn_init(parent);
+    if (status != ZX_OK) {
+        zxlogf(ERROR, "acpi: failed to initialize pwrbtn device: %d\n", status);
+    }
+
+    publish_acpi_device_ctx_t* ctx = calloc(1, sizeof(*ctx));
+    if (ctx == NULL) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    ctx->parent = parent;
+    ctx->found_pci = false;
+    ctx->last_pci = 0xFF;
+
+    zx_time_t start = zx_clock_get_monotonic();
+    status = publish_pci_roots(ctx);
+    if (status != ZX_OK) {
+        zxlogf(ERROR, "acpi: failed to publish PCI roots: %d\n", status);
+    }
+    zxlogf(INFO, "acpi: PCI root setup took %" PRId64 " ms\n",
+           (zx_clock_get_monotonic() - start) / ZX_MSEC(1));
+
+    // Walk the ACPI namespace for the remaining devices and publish them. This
+    // is the slow part, so it runs off the bind thread, and devmgr can go on
+    // binding PCI in the meantime.
+    thrd_t thread;
+    if (thrd_create_with_name(&thread, publish_acpi_devices_thread, ctx,
+                              "acpi-publish") != thrd_success) {
+        zxlogf(ERROR, "acpi: failed to start namespace walk thread, walking inline\n");
+        publish_acpi_devices_thread(ctx);
         return ZX_OK;
     }
+    thrd_detach(thread);
+    return ZX_OK;
 }
 
 static zx_status_t acpi_drv_create(void* ctx, zx_device_t* parent, const char* name,
@@ -599,13 +676,15 @@ static zx_status_t acpi_drv_create(void* ctx, zx_device_t* parent, const char* n
     // We don't need ZBI VMO handle.
     zx_handle_close(zbi_vmo);
 
+    zx_time_t start = zx_clock_get_monotonic();
     zx_status_t status = init();
     if (status != ZX_OK) {
         zxlogf(ERROR, "acpi: failed to initialize ACPI %d \n", status);
         return ZX_ERR_INTERNAL;
     }
 
-    zxlogf(TRACE, "acpi: initialized\n");
+    zxlogf(INFO, "acpi: initialized in %" PRId64 " ms\n",
+           (zx_clock_get_monotonic() - start) / ZX_MSEC(1));
 
     // publish sys root
     device_add_args_t args = {
@@ -53,6 +53,7 @@ typedef struct {
     zx_device_t* parent;
     bool found_pci;
     uint8_t last_pci; // bus number of the last PCI root seen
+    const char* pci_hid; // HID being matched by publish_pci_roots()
 } publish_acpi_device_ctx_t;
 
 typedef struct {
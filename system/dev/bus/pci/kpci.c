@@ -69,6 +69,52 @@ static zx_status_t kpci_config_read(pci_msg_t* req, kpci_device_t* device, zx_ha
     return pci_rpc_reply(ch, st, NULL, req, &resp);
 }
 
+// Walks the capability list for the proxy, so that a lookup costs it a single
+// rpc rather than two config reads per capability. The kernel serves the
+// capability headers from its copy of config space.
+static zx_status_t kpci_get_next_capability(pci_msg_t* req, kpci_device_t* device,
+                                            zx_handle_t ch) {
+    uint32_t cap_offset = 0;
+    uint8_t type = (uint8_t)req->cfg.value;
+    uint8_t limit = 64;
+    bool found = false;
+    zx_status_t st = zx_pci_config_read(device->handle, req->cfg.offset + 1, sizeof(uint8_t),
+                                        &cap_offset);
+
+    // Walk the capability list looking for the type requested, starting at the offset
+    // passed in. limit acts as a barrier in case of an invalid capability pointer list
+    // that causes us to iterate forever otherwise.
+    while (st == ZX_OK && cap_offset != 0 && limit--) {
+        uint32_t type_id = 0;
+        if ((st = zx_pci_config_read(device->handle, cap_offset, sizeof(uint8_t),
+                                     &type_id)) != ZX_OK) {
+            break;
+        }
+
+        if (type_id == type) {
+            found = true;
+            break;
+        }
+
+        // We didn't find the right type, move on, but ensure we're still
+        // within the first 256 bytes of standard config space.
+        if (cap_offset >= UINT8_MAX) {
+            zxlogf(ERROR, "%s: %#x is an invalid capability offset!\n", __func__, cap_offset);
+            st = ZX_ERR_OUT_OF_RANGE;
+            break;
+        }
+        st = zx_pci_config_read(device->handle, cap_offset + 1, sizeof(uint8_t), &cap_offset);
+    }
+
+    pci_msg_t resp = {};
+    if (st == ZX_OK) {
+        resp.cfg.offset = req->cfg.offset;
+        resp.cfg.width = sizeof(uint8_t);
+        resp.cfg.value = found ? cap_offset : 0;
+    }
+    return pci_rpc_reply(ch, st, NULL, req, &resp);
+}
+
 static zx_status_t kpci_config_write(pci_msg_t* req, kpci_device_t* device, zx_handle_t ch) {
     pci_msg_t resp = {};
     zx_status_t st = zx_pci_config_write(device->handle, req->cfg.offset, req->cfg.width,
@@ -190,6 +236,7 @@ const rxrpc_cbk_t rxrpc_cbk_tbl[] = {
     [PCI_OP_GET_DEVICE_INFO] = kpci_get_device_info,
     [PCI_OP_GET_AUXDATA] = kpci_get_auxdata,
     [PCI_OP_GET_BTI] = kpci_get_bti,
+    [PCI_OP_GET_NEXT_CAPABILITY] = kpci_get_next_capability,
     [PCI_OP_MAX] = NULL,
 };
 
@@ -207,6 +254,7 @@ const char* const rxrpc_string_tbl[] = {
     LABEL(PCI_OP_GET_DEVICE_INFO),
     LABEL(PCI_OP_GET_AUXDATA),
     LABEL(PCI_OP_GET_BTI),
+    LABEL(PCI_OP_GET_NEXT_CAPABILITY),
 };
 #undef LABEL
 static_assert(countof(rxrpc_string_tbl) == PCI_OP_MAX, "rpc string table is not contiguous!");
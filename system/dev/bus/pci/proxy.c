@@ -124,42 +124,25 @@ static zx_status_t pci_op_config_write(void* ctx, uint16_t offset, size_t width,
     return pci_rpc_request(dev, PCI_OP_CONFIG_WRITE, NULL, &req, &resp);
 }
 
+// The capability list is walked by the top devhost, in a single rpc.
 static uint8_t pci_op_get_next_capability(void* ctx, uint8_t offset, uint8_t type) {
-    uint32_t cap_offset = 0;
-    pci_op_config_read(ctx, offset + 1, sizeof(uint8_t), &cap_offset);
-    uint8_t limit = 64;
-    zx_status_t st;
-
-    // Walk the capability list looking for the type requested, starting at the offset
-    // passed in. limit acts as a barrier in case of an invalid capability pointer list
-    // that causes us to iterate forever otherwise.
-    while (cap_offset != 0 && limit--) {
-        uint32_t type_id = 0;
-        if ((st = pci_op_config_read(ctx, cap_offset, sizeof(uint8_t), &type_id)) != ZX_OK) {
-            zxlogf(ERROR, "%s: error reading type from cap offset %#x: %d\n",
-                   __func__, cap_offset, st);
-            return 0;
-        }
-
-        if (type_id == type) {
-            return cap_offset;
-        }
-
-        // We didn't find the right type, move on, but ensure we're still
-        // within the first 256 bytes of standard config space.
-        if (cap_offset >= UINT8_MAX) {
-            zxlogf(ERROR, "%s: %#x is an invalid capability offset!\n", __func__, cap_offset);
-            return 0;
-        }
-        if ((st = pci_op_config_read(ctx, cap_offset + 1, sizeof(uint8_t), &cap_offset)) != ZX_OK) {
-            zxlogf(ERROR, "%s: error reading next cap from cap offset %#x: %d\n",
-                   __func__, cap_offset + 1, st);
-            return 0;
-        }
+    kpci_device_t* dev = ctx;
+    pci_msg_t req = {
+        .cfg = {
+            .offset = offset,
+            .width = sizeof(uint8_t),
+            .value = type,
+        },
+    };
+    pci_msg_t resp = {};
+    zx_status_t st = pci_rpc_request(dev, PCI_OP_GET_NEXT_CAPABILITY, NULL, &req, &resp);
+    if (st != ZX_OK) {
+        zxlogf(ERROR, "%s: error walking capabilities from offset %#x: %d\n",
+               __func__, offset, st);
+        return 0;
     }
 
-    // No more entries are in the list
-    return 0;
+    return (uint8_t)resp.cfg.value;
 }
 
 static zx_status_t pci_op_get_bar(void* ctx, uint32_t bar_id, zx_pci_bar_t* out_bar) {
@@ -11,7 +11,6 @@
 #include <ddk/debug.h>
 #include <ddk/protocol/i2c-lib.h>
 #include <fbl/array.h>
-#include <fbl/auto_lock.h>
 #include <fbl/unique_ptr.h>
 #include <zircon/assert.h>
 #include <zircon/listnode.h>
@@ -59,6 +58,33 @@ void PlatformI2cBus::Complete(I2cTxn* txn, zx_status_t status, const uint8_t* re
     }
 }
 
+void PlatformI2cBus::Execute(I2cTxn* txn, uint8_t* resp_buffer) {
+    auto rpc_ops = reinterpret_cast<i2c_rpc_op_t*>(txn + 1);
+    auto p_writes = reinterpret_cast<uint8_t*>(rpc_ops) +
+        txn->cnt * sizeof(i2c_rpc_op_t);
+    uint8_t* p_reads = resp_buffer + sizeof(rpc_i2c_rsp_t);
+
+    ZX_ASSERT(txn->cnt < I2C_MAX_RW_OPS);
+    i2c_impl_op_t ops[I2C_MAX_RW_OPS];
+    for (size_t i = 0; i < txn->cnt; ++i) {
+        // Same address for all ops, since there is one address per channel.
+        ops[i].address = txn->address;
+        ops[i].data_size = rpc_ops[i].length;
+        ops[i].is_read = rpc_ops[i].is_read;
+        ops[i].stop = rpc_ops[i].stop;
+        if (ops[i].is_read) {
+            ops[i].data_buffer = p_reads;
+            p_reads += ops[i].data_size;
+        } else {
+            ops[i].data_buffer = p_writes;
+            p_writes += ops[i].data_size;
+        }
+    }
+    auto status = i2c_.Transact(bus_id_, ops, txn->cnt);
+    size_t actual = status == ZX_OK ? p_reads - resp_buffer : sizeof(rpc_i2c_rsp_t);
+    Complete(txn, status, resp_buffer, actual);
+}
+
 int PlatformI2cBus::I2cThread() {
     fbl::AllocChecker ac;
     fbl::Array<uint8_t> read_buffer(new (&ac) uint8_t[PROXY_MAX_TRANSFER_SIZE],
@@ -75,36 +101,20 @@ int PlatformI2cBus::I2cThread() {
         I2cTxn* txn;
 
         mutex_.Acquire();
+        // A transaction running on a caller's thread signals us when it is
+        // done if anything was queued behind it.
+        if (busy_) {
+            mutex_.Release();
+            continue;
+        }
         while ((txn = list_remove_head_type(&queued_txns_, I2cTxn, node)) != nullptr) {
+            busy_ = true;
             mutex_.Release();
-            auto rpc_ops = reinterpret_cast<i2c_rpc_op_t*>(txn + 1);
-            auto p_writes = reinterpret_cast<uint8_t*>(rpc_ops) +
-                txn->cnt * sizeof(i2c_rpc_op_t);
-            uint8_t* p_reads = read_buffer.get() + sizeof(rpc_i2c_rsp_t);
-
-            ZX_ASSERT(txn->cnt < I2C_MAX_RW_OPS);
-            i2c_impl_op_t ops[I2C_MAX_RW_OPS];
-            for (size_t i = 0; i < txn->cnt; ++i) {
-                // Same address for all ops, since there is one address per channel.
-                ops[i].address = txn->address;
-                ops[i].data_size = rpc_ops[i].length;
-                ops[i].is_read = rpc_ops[i].is_read;
-                ops[i].stop = rpc_ops[i].stop;
-                if (ops[i].is_read) {
-                    ops[i].data_buffer = p_reads;
-                    p_reads += ops[i].data_size;
-                } else {
-                    ops[i].data_buffer = p_writes;
-                    p_writes += ops[i].data_size;
-                }
-            }
-            auto status = i2c_.Transact(bus_id_, ops, txn->cnt);
-            size_t actual = status == ZX_OK ? p_reads - read_buffer.get() : sizeof(rpc_i2c_rsp_t);
-            Complete(txn, status, read_buffer.get(), actual);
-
+            Execute(txn, read_buffer.get());
             mutex_.Acquire();
             list_add_tail(&free_txns_, &txn->node);
         }
+        busy_ = false;
         mutex_.Release();
     }
     return 0;
@@ -115,11 +125,14 @@ zx_status_t PlatformI2cBus::Transact(uint32_t txid, rpc_i2c_req_t* req, uint16_t
     i2c_rpc_op_t* ops = reinterpret_cast<i2c_rpc_op_t*>(req + 1);
 
     size_t writes_length = 0;
+    size_t reads_length = 0;
     for (size_t i = 0; i < req->cnt; ++i) {
         if (ops[i].length == 0 || ops[i].length > max_transfer_) {
             return ZX_ERR_INVALID_ARGS;
         }
-        if (!ops[i].is_read) {
+        if (ops[i].is_read) {
+            reads_length += ops[i].length;
+        } else {
             writes_length += ops[i].length;
         }
     }
@@ -129,7 +142,7 @@ zx_status_t PlatformI2cBus::Transact(uint32_t txid, rpc_i2c_req_t* req, uint16_t
         return ZX_ERR_INVALID_ARGS;
     }
 
-    fbl::AutoLock lock(&mutex_);
+    mutex_.Acquire();
 
     I2cTxn* txn = list_remove_head_type(&free_txns_, I2cTxn, node);
     if (txn && txn->length < req_length) {
@@ -140,11 +153,12 @@ zx_status_t PlatformI2cBus::Transact(uint32_t txid, rpc_i2c_req_t* req, uint16_t
     if (!txn) {
         // add space for write buffer
         txn = static_cast<I2cTxn*>(calloc(1, req_length));
+        if (!txn) {
+            mutex_.Release();
+            return ZX_ERR_NO_MEMORY;
+        }
         txn->length = req_length;
     }
-    if (!txn) {
-        return ZX_ERR_NO_MEMORY;
-    }
 
     txn->address = address;
     txn->txid = txid;
@@ -156,13 +170,37 @@ zx_status_t PlatformI2cBus::Transact(uint32_t txid, rpc_i2c_req_t* req, uint16_t
     auto rpc_ops = reinterpret_cast<i2c_rpc_op_t*>(req + 1);
     if (req->cnt && !(rpc_ops[req->cnt - 1].stop)) {
         list_add_tail(&free_txns_, &txn->node);
+        mutex_.Release();
         return ZX_ERR_INVALID_ARGS; // no stop in last op in transaction
     }
 
     memcpy(txn + 1, req + 1, req->cnt * sizeof(i2c_rpc_op_t) + writes_length);
 
+    // If the bus is idle, run short transactions right here, which saves
+    // waking up the bus thread and switching to it twice per transaction.
+    // Anything already queued or running has to go first though, to keep
+    // transactions in order.
+    if (reads_length <= kInlineMaxReadSize && !busy_ && list_is_empty(&queued_txns_)) {
+        busy_ = true;
+        mutex_.Release();
+
+        uint8_t resp_buffer[sizeof(rpc_i2c_rsp_t) + kInlineMaxReadSize]
+            __ALIGNED(alignof(rpc_i2c_rsp_t));
+        Execute(txn, resp_buffer);
+
+        mutex_.Acquire();
+        list_add_tail(&free_txns_, &txn->node);
+        busy_ = false;
+        if (!list_is_empty(&queued_txns_)) {
+            sync_completion_signal(&txn_signal_);
+        }
+        mutex_.Release();
+        return ZX_OK;
+    }
+
     list_add_tail(&queued_txns_, &txn->node);
     sync_completion_signal(&txn_signal_);
+    mutex_.Release();
 
     return ZX_OK;
 }
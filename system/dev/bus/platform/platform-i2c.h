@@ -37,8 +37,15 @@ private:
         size_t cnt;
     };
 
+    // Transactions that read at most this many bytes may be run on the
+    // caller's thread when the bus is idle, rather than on the bus thread.
+    static constexpr size_t kInlineMaxReadSize = 64;
+
     void Complete(I2cTxn* txn, zx_status_t status, const uint8_t* data,
                   size_t data_length);
+    // Runs |txn| on the controller, reading into |resp_buffer| after the
+    // response header, and sends the response.
+    void Execute(I2cTxn* txn, uint8_t* resp_buffer);
     int I2cThread();
 
     ddk::I2cImplProtocolProxy i2c_;
@@ -48,6 +55,9 @@ private:
     list_node_t queued_txns_ __TA_GUARDED(mutex_);
     list_node_t free_txns_ __TA_GUARDED(mutex_);
     sync_completion_t txn_signal_;
+    // True while a transaction is running, on either the bus thread or a
+    // caller's thread.
+    bool busy_ __TA_GUARDED(mutex_) = false;
 
     thrd_t thread_;
     fbl::Mutex mutex_;
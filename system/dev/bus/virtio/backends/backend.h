@@ -60,6 +60,19 @@ public:
     virtual zx_status_t InterruptValid() = 0;
     virtual zx_status_t WaitForInterrupt() = 0;
 
+    // Gives virtqueues 0 to |count| - 1 an interrupt each, waited on with
+    // WaitForQueueInterrupt(). Other virtqueues and config changes stay on the
+    // interrupt behind WaitForInterrupt(). Must be called before SetRing().
+    virtual zx_status_t SetQueueInterrupts(uint16_t count) { return ZX_ERR_NOT_SUPPORTED; }
+    virtual zx_status_t WaitForQueueInterrupt(uint16_t index) { return ZX_ERR_NOT_SUPPORTED; }
+    // Delivers the interrupt of virtqueue |index| to |cpu|.
+    virtual zx_status_t SetQueueInterruptAffinity(uint16_t index, uint32_t cpu) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
+    // The most virtqueues that can be given interrupts of their own.
+    static constexpr uint16_t kMaxQueueInterrupts = 16;
+
     DISALLOW_COPY_ASSIGN_AND_MOVE(Backend);
 
 protected:
@@ -20,8 +20,6 @@ PciBackend::PciBackend(pci_protocol_t pci, zx_pcie_device_info_t info)
 }
 
 zx_status_t PciBackend::Bind() {
-    zx_handle_t tmp_handle;
-
     // enable bus mastering
     zx_status_t st;
     if ((st = pci_enable_bus_master(&pci_, true)) != ZX_OK) {
@@ -29,6 +27,15 @@ zx_status_t PciBackend::Bind() {
         return st;
     }
 
+    if ((st = SetupSharedInterrupt()) != ZX_OK) {
+        return st;
+    }
+    return Init();
+}
+
+zx_status_t PciBackend::SetupSharedInterrupt() {
+    zx_handle_t tmp_handle;
+    zx_status_t st;
     // try to set up our IRQ mode
     uint32_t avail_irqs = 0;
     zx_pci_irq_mode_t mode = ZX_PCIE_IRQ_MODE_MSI;
@@ -53,7 +60,7 @@ zx_status_t PciBackend::Bind() {
     }
     irq_handle_.reset(tmp_handle);
     zxlogf(SPEW, "%s: irq handle %u\n", tag(), irq_handle_.get());
-    return Init();
+    return ZX_OK;
 }
 
 zx_status_t PciBackend::InterruptValid() {
@@ -22,6 +22,9 @@ public:
     zx_status_t WaitForInterrupt() override;
 
 protected:
+    // Sets up a single MSI or legacy interrupt in irq_handle_.
+    zx_status_t SetupSharedInterrupt();
+
     pci_protocol_t pci_ = {nullptr, nullptr};
     zx_pcie_device_info_t info_;
     fbl::Mutex lock_;
@@ -123,6 +126,12 @@ public:
     void RingKick(uint16_t ring_index) override;
     char* tag() { return tag_; }
 
+    // Per-queue interrupts, as MSI-X vectors 1 and up. Vector 0 is shared by
+    // config changes and the remaining queues.
+    zx_status_t SetQueueInterrupts(uint16_t count) override;
+    zx_status_t WaitForQueueInterrupt(uint16_t index) override;
+    zx_status_t SetQueueInterruptAffinity(uint16_t index, uint32_t cpu) override;
+
 private:
     zx_status_t MapBar(uint8_t bar);
 
@@ -134,6 +143,9 @@ private:
     volatile virtio_pci_common_cfg_t* common_cfg_ TA_GUARDED(lock_) = nullptr;
     uint32_t notify_off_mul_;
 
+    zx::handle queue_irqs_[kMaxQueueInterrupts];
+    uint16_t queue_irq_count_ = 0;
+
     DISALLOW_COPY_AND_ASSIGN_ALLOW_MOVE(PciModernBackend);
 };
 
@@ -149,7 +149,6 @@ bool PciLegacyBackend::ReadFeature(uint32_t feature) {
     fbl::AutoLock lock(&lock_);
     uint32_t val;
 
-    ZX_DEBUG_ASSERT((feature & (feature - 1)) == 0);
     IoReadLocked(VIRTIO_PCI_DEVICE_FEATURES, &val);
     bool is_set = (val & (1u << feature)) > 0;
     zxlogf(SPEW, "%s: read feature bit %u = %u\n", tag(), feature, is_set);
@@ -164,7 +163,6 @@ void PciLegacyBackend::SetFeature(uint32_t feature) {
 
     fbl::AutoLock lock(&lock_);
     uint32_t val;
-    ZX_DEBUG_ASSERT((feature & (feature - 1)) == 0);
     IoReadLocked(VIRTIO_PCI_DRIVER_FEATURES, &val);
     IoWriteLocked(VIRTIO_PCI_DRIVER_FEATURES, val | (1u << feature));
     zxlogf(SPEW, "%s: feature bit %u now set\n", tag(), feature);
@@ -8,6 +8,7 @@
 #include <fbl/auto_lock.h>
 #include <hw/reg.h>
 #include <inttypes.h>
+#include <zircon/syscalls.h>
 
 #include "pci.h"
 
@@ -267,6 +268,14 @@ void PciModernBackend::SetRing(uint16_t index, uint16_t count, zx_paddr_t pa_des
     MmioWrite(&common_cfg_->queue_desc, pa_desc);
     MmioWrite(&common_cfg_->queue_avail, pa_avail);
     MmioWrite(&common_cfg_->queue_used, pa_used);
+    if (queue_irq_count_ > 0) {
+        uint16_t vector = index < queue_irq_count_ ? static_cast<uint16_t>(index + 1) : 0;
+        MmioWrite(&common_cfg_->queue_msix_vector, vector);
+        MmioRead(&common_cfg_->queue_msix_vector, &vector);
+        if (vector == VIRTIO_MSI_NO_VECTOR) {
+            zxlogf(ERROR, "%s: no interrupt vector for queue %u\n", tag(), index);
+        }
+    }
     MmioWrite<uint16_t>(&common_cfg_->queue_enable, 1);
 
     // Assert that queue_notify_off is equal to the ring index.
@@ -358,7 +367,80 @@ void PciModernBackend::DriverStatusAck() {
 }
 
 uint32_t PciModernBackend::IsrStatus() {
+    // The ISR is not updated with MSI-X, so vector 0 may be for either cause.
+    if (queue_irq_count_ > 0) {
+        return VIRTIO_ISR_QUEUE_INT | VIRTIO_ISR_DEV_CFG_INT;
+    }
     return (*isr_status_ & (VIRTIO_ISR_QUEUE_INT | VIRTIO_ISR_DEV_CFG_INT));
 }
 
+zx_status_t PciModernBackend::SetQueueInterrupts(uint16_t count) {
+    if (count == 0 || count > kMaxQueueInterrupts) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+    uint32_t avail_irqs = 0;
+    zx_status_t st = pci_query_irq_mode(&pci_, ZX_PCIE_IRQ_MODE_MSI_X, &avail_irqs);
+    if (st != ZX_OK || avail_irqs < count + 1u) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
+    // The shared interrupt has to be released before the mode can change.
+    irq_handle_.reset();
+    if ((st = pci_set_irq_mode(&pci_, ZX_PCIE_IRQ_MODE_MSI_X, count + 1)) != ZX_OK) {
+        zxlogf(ERROR, "%s: failed to set %u msi-x vectors: %d\n", tag(), count + 1, st);
+        SetupSharedInterrupt();
+        return st;
+    }
+    for (uint16_t i = 0; i <= count; i++) {
+        zx_handle_t tmp_handle;
+        if ((st = pci_map_interrupt(&pci_, i, &tmp_handle)) != ZX_OK) {
+            zxlogf(ERROR, "%s: failed to map msi-x vector %u: %d\n", tag(), i, st);
+            break;
+        }
+        if (i == 0) {
+            irq_handle_.reset(tmp_handle);
+        } else {
+            queue_irqs_[i - 1].reset(tmp_handle);
+        }
+    }
+
+    if (st == ZX_OK) {
+        fbl::AutoLock lock(&lock_);
+        uint16_t vector = 0;
+        MmioWrite(&common_cfg_->msix_config, vector);
+        MmioRead(&common_cfg_->msix_config, &vector);
+        if (vector == VIRTIO_MSI_NO_VECTOR) {
+            zxlogf(ERROR, "%s: device rejected the config vector\n", tag());
+            st = ZX_ERR_NO_RESOURCES;
+        }
+    }
+    if (st != ZX_OK) {
+        irq_handle_.reset();
+        for (auto& irq : queue_irqs_) {
+            irq.reset();
+        }
+        SetupSharedInterrupt();
+        return st;
+    }
+
+    queue_irq_count_ = count;
+    zxlogf(TRACE, "%s: %u queue interrupts\n", tag(), count);
+    return ZX_OK;
+}
+
+zx_status_t PciModernBackend::WaitForQueueInterrupt(uint16_t index) {
+    if (index >= queue_irq_count_) {
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+    return zx_interrupt_wait(queue_irqs_[index].get(), nullptr);
+}
+
+zx_status_t PciModernBackend::SetQueueInterruptAffinity(uint16_t index, uint32_t cpu) {
+    if (index >= queue_irq_count_) {
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+    return zx_object_set_property(queue_irqs_[index].get(), ZX_PROP_INTERRUPT_AFFINITY,
+                                  &cpu, sizeof(cpu));
+}
+
 } // namespace virtio
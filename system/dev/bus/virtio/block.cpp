@@ -6,6 +6,7 @@
 
 #include <ddk/debug.h>
 #include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
 #include <fbl/auto_lock.h>
 #include <inttypes.h>
 #include <pretty/hexdump.h>
@@ -14,6 +15,7 @@
 #include <string.h>
 #include <sys/param.h>
 #include <zircon/compiler.h>
+#include <zircon/syscalls.h>
 
 #include "trace.h"
 
@@ -25,6 +27,16 @@
 
 #define PAGE_MASK (PAGE_SIZE - 1)
 
+namespace {
+
+// The VIRTIO_BLK_F_* values are masks, while features are negotiated by bit
+// number.
+constexpr uint32_t FeatureBit(uint32_t mask) {
+    return __builtin_ctz(mask);
+}
+
+} // namespace
+
 namespace virtio {
 
 void BlockDevice::txn_complete(block_txn_t* txn, zx_status_t status) {
@@ -115,13 +127,15 @@ zx_status_t BlockDevice::virtio_block_ioctl(void* ctx, uint32_t op, const void*
 
 BlockDevice::BlockDevice(zx_device_t* bus_device, zx::bti bti, fbl::unique_ptr<Backend> backend)
     : Device(bus_device, fbl::move(bti), fbl::move(backend)) {
-    sync_completion_reset(&txn_signal_);
-
-    memset(&blk_req_buf_, 0, sizeof(blk_req_buf_));
 }
 
 BlockDevice::~BlockDevice() {
-    io_buffer_release(&blk_req_buf_);
+    for (auto& queue : queues_) {
+        if (queue) {
+            io_buffer_release(&queue->blk_req_buf);
+            io_buffer_release(&queue->indirect_buf);
+        }
+    }
 }
 
 zx_status_t BlockDevice::Init() {
@@ -149,33 +163,34 @@ zx_status_t BlockDevice::Init() {
     DriverStatusAck();
 
     // XXX check features bits and ack/nak them
-
-    // allocate the main vring
-    auto err = vring_.Init(0, ring_size);
-    if (err < 0) {
-        zxlogf(ERROR, "failed to allocate vring\n");
-        return err;
+    // 5.2.6.2: with VIRTIO_BLK_F_MQ, requests may go to any of num_queues
+    // virtqueues. One is used per cpu.
+    if (DeviceFeatureSupported(FeatureBit(VIRTIO_BLK_F_MQ)) && config_.num_queues > 1) {
+        DriverFeatureAck(FeatureBit(VIRTIO_BLK_F_MQ));
+        uint32_t cpus = zx_system_get_num_cpus();
+        num_queues_ = static_cast<uint16_t>(fbl::min<uint32_t>(
+            fbl::min<uint32_t>(config_.num_queues, cpus), max_queues));
     }
-
-    // allocate a queue of block requests
-    size_t size = sizeof(virtio_blk_req_t) * blk_req_count + sizeof(uint8_t) * blk_req_count;
-
-    zx_status_t status = io_buffer_init(&blk_req_buf_, bti_.get(), size,
-                                        IO_BUFFER_RW | IO_BUFFER_CONTIG);
+    NegotiateRingFeatures();
+    zx_status_t status = DeviceStatusFeaturesOk();
     if (status != ZX_OK) {
-        zxlogf(ERROR, "cannot alloc blk_req buffers %d\n", status);
+        zxlogf(ERROR, "%s: Feature negotiation failed (%d)\n", tag(), status);
         return status;
     }
-    blk_req_ = static_cast<virtio_blk_req_t*>(io_buffer_virt(&blk_req_buf_));
 
-    LTRACEF("allocated blk request at %p, physical address %#" PRIxPTR "\n", blk_req_,
-            io_buffer_phys(&blk_req_buf_));
-
-    // responses are 32 words at the end of the allocated block
-    blk_res_pa_ = io_buffer_phys(&blk_req_buf_) + sizeof(virtio_blk_req_t) * blk_req_count;
-    blk_res_ = (uint8_t*)((uintptr_t)blk_req_ + sizeof(virtio_blk_req_t) * blk_req_count);
+    // Each queue interrupts the cpu of its own, when the backend allows.
+    if (num_queues_ > 1 && SetupQueueInterrupts(num_queues_) == ZX_OK) {
+        for (uint16_t i = 0; i < num_queues_; i++) {
+            SteerQueueInterrupt(i, i);
+        }
+    }
 
-    LTRACEF("allocated blk responses at %p, physical address %#" PRIxPTR "\n", blk_res_, blk_res_pa_);
+    for (uint16_t i = 0; i < num_queues_; i++) {
+        if ((status = InitQueue(i)) != ZX_OK) {
+            return status;
+        }
+    }
+    LTRACEF("%u request queues\n", num_queues_);
 
     // start the interrupt thread
     StartIrqThread();
@@ -208,16 +223,90 @@ zx_status_t BlockDevice::Init() {
     return ZX_OK;
 }
 
+zx_status_t BlockDevice::InitQueue(uint16_t index) {
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<RequestQueue> queue(new (&ac) RequestQueue(this));
+    if (!ac.check()) {
+        zxlogf(ERROR, "out of memory!\n");
+        return ZX_ERR_NO_MEMORY;
+    }
+    sync_completion_reset(&queue->txn_signal);
+
+    // allocate the vring
+    auto err = queue->vring.Init(index, ring_size);
+    if (err < 0) {
+        zxlogf(ERROR, "failed to allocate vring\n");
+        return err;
+    }
+
+    // allocate a queue of block requests
+    size_t size = sizeof(virtio_blk_req_t) * blk_req_count + sizeof(uint8_t) * blk_req_count;
+
+    zx_status_t status = io_buffer_init(&queue->blk_req_buf, bti_.get(), size,
+                                        IO_BUFFER_RW | IO_BUFFER_CONTIG);
+    if (status != ZX_OK) {
+        zxlogf(ERROR, "cannot alloc blk_req buffers %d\n", status);
+        return status;
+    }
+    queues_[index] = fbl::move(queue);
+    RequestQueue* q = queues_[index].get();
+
+    if (indirect_desc()) {
+        size = sizeof(vring_desc) * ring_size * blk_req_count;
+        status = io_buffer_init(&q->indirect_buf, bti_.get(), size,
+                                IO_BUFFER_RW | IO_BUFFER_CONTIG);
+        if (status != ZX_OK) {
+            zxlogf(ERROR, "cannot alloc indirect descriptor tables %d\n", status);
+            return status;
+        }
+    }
+    q->blk_req = static_cast<virtio_blk_req_t*>(io_buffer_virt(&q->blk_req_buf));
+
+    LTRACEF("allocated blk request at %p, physical address %#" PRIxPTR "\n", q->blk_req,
+            io_buffer_phys(&q->blk_req_buf));
+
+    // responses are 32 words at the end of the allocated block
+    q->blk_res_pa = io_buffer_phys(&q->blk_req_buf) + sizeof(virtio_blk_req_t) * blk_req_count;
+    q->blk_res = (uint8_t*)((uintptr_t)q->blk_req + sizeof(virtio_blk_req_t) * blk_req_count);
+
+    LTRACEF("allocated blk responses at %p, physical address %#" PRIxPTR "\n", q->blk_res,
+            q->blk_res_pa);
+    return ZX_OK;
+}
+
+BlockDevice::RequestQueue* BlockDevice::SelectQueue() {
+    // There is no telling which cpu a thread runs on, so each submitting
+    // thread is handed a queue of its own in turn, and keeps it.
+    static thread_local uint16_t t_queue = UINT16_MAX;
+    if (t_queue == UINT16_MAX) {
+        t_queue = next_queue_.fetch_add(1, fbl::memory_order_relaxed);
+    }
+    return queues_[t_queue % num_queues_].get();
+}
+
 void BlockDevice::IrqRingUpdate() {
     LTRACE_ENTRY;
 
+    // Queues with interrupts of their own are serviced by IrqQueueUpdate().
+    for (uint16_t i = queue_interrupts(); i < num_queues_; i++) {
+        QueueUpdate(queues_[i].get());
+    }
+}
+
+void BlockDevice::IrqQueueUpdate(uint16_t index) {
+    if (index < num_queues_) {
+        QueueUpdate(queues_[index].get());
+    }
+}
+
+void BlockDevice::QueueUpdate(RequestQueue* queue) {
     // parse our descriptor chain, add back to the free queue
-    auto free_chain = [this](vring_used_elem* used_elem) {
+    auto free_chain = [this, queue](vring_used_elem* used_elem) {
         uint32_t i = (uint16_t)used_elem->id;
-        struct vring_desc* desc = vring_.DescFromIndex((uint16_t)i);
+        struct vring_desc* desc = queue->vring.DescFromIndex((uint16_t)i);
         auto head_desc = desc; // save the first element
         {
-            fbl::AutoLock lock(&ring_lock_);
+            fbl::AutoLock lock(&queue->ring_lock);
             for (;;) {
                 int next;
                 LTRACE_DO(virtio_dump_desc(desc));
@@ -228,12 +317,12 @@ void BlockDevice::IrqRingUpdate() {
                     next = -1;
                 }
 
-                vring_.FreeDesc((uint16_t)i);
+                queue->vring.FreeDesc((uint16_t)i);
 
                 if (next < 0)
                     break;
                 i = next;
-                desc = vring_.DescFromIndex((uint16_t)i);
+                desc = queue->vring.DescFromIndex((uint16_t)i);
             }
         }
 
@@ -241,14 +330,14 @@ void BlockDevice::IrqRingUpdate() {
         bool need_complete = false;
         block_txn_t* txn = nullptr;
         {
-            fbl::AutoLock lock(&txn_lock_);
+            fbl::AutoLock lock(&queue->txn_lock);
 
             // search our pending txn list to see if this completes it
 
-            list_for_every_entry (&txn_list_, txn, block_txn_t, node) {
+            list_for_every_entry (&queue->txn_list, txn, block_txn_t, node) {
                 if (txn->desc == head_desc) {
                     LTRACEF("completes txn %p\n", txn);
-                    free_blk_req((unsigned int)txn->index);
+                    queue->free_blk_req((unsigned int)txn->index);
                     list_delete(&txn->node);
 
                     // we will do this outside of the lock
@@ -256,8 +345,8 @@ void BlockDevice::IrqRingUpdate() {
 
                     // check to see if QueueTxn is waiting on
                     // resources becoming available
-                    if ((need_signal = txn_wait_)) {
-                        txn_wait_ = false;
+                    if ((need_signal = queue->txn_wait)) {
+                        queue->txn_wait = false;
                     }
                     break;
                 }
@@ -265,7 +354,7 @@ void BlockDevice::IrqRingUpdate() {
         }
 
         if (need_signal) {
-            sync_completion_signal(&txn_signal_);
+            sync_completion_signal(&queue->txn_signal);
         }
         if (need_complete) {
             txn_complete(txn, ZX_OK);
@@ -273,27 +362,28 @@ void BlockDevice::IrqRingUpdate() {
     };
 
     // tell the ring to find free chains and hand it back to our lambda
-    vring_.IrqRingUpdate(free_chain);
+    queue->vring.IrqRingUpdate(free_chain);
 }
 
 void BlockDevice::IrqConfigChange() {
     LTRACE_ENTRY;
 }
 
-zx_status_t BlockDevice::QueueTxn(block_txn_t* txn, bool write, size_t bytes,
-                                  uint64_t* pages, size_t pagecount, uint16_t* idx) {
+zx_status_t BlockDevice::QueueTxn(RequestQueue* queue, block_txn_t* txn, bool write,
+                                  size_t bytes, uint64_t* pages, size_t pagecount,
+                                  uint16_t* idx) {
 
     size_t index;
     {
-        fbl::AutoLock lock(&txn_lock_);
-        index = alloc_blk_req();
+        fbl::AutoLock lock(&queue->txn_lock);
+        index = queue->alloc_blk_req();
         if (index >= blk_req_count) {
             LTRACEF("too many block requests queued (%zu)!\n", index);
             return ZX_ERR_NO_RESOURCES;
         }
     }
 
-    auto req = &blk_req_[index];
+    auto req = &queue->blk_req[index];
     req->type = write ? VIRTIO_BLK_T_OUT : VIRTIO_BLK_T_IN;
     req->ioprio = 0;
     req->sector = txn->op.rw.offset_dev;
@@ -316,14 +406,16 @@ zx_status_t BlockDevice::QueueTxn(block_txn_t* txn, bool write, size_t bytes,
     /* put together a transfer */
     uint16_t i;
     vring_desc *desc;
+    uint16_t count = (uint16_t)(2u + pagecount);
+    bool indirect = io_buffer_is_valid(&queue->indirect_buf);
     {
-        fbl::AutoLock lock(&ring_lock_);
-        desc = vring_.AllocDescChain((uint16_t)(2u + pagecount), &i);
+        fbl::AutoLock lock(&queue->ring_lock);
+        desc = queue->vring.AllocDescChain(indirect ? 1 : count, &i);
     }
     if (!desc) {
         LTRACEF("failed to allocate descriptor chain of length %zu\n", 2u + pagecount);
-        fbl::AutoLock lock(&txn_lock_);
-        free_blk_req(index);
+        fbl::AutoLock lock(&queue->txn_lock);
+        queue->free_blk_req(index);
         return ZX_ERR_NO_RESOURCES;
     }
 
@@ -332,14 +424,32 @@ zx_status_t BlockDevice::QueueTxn(block_txn_t* txn, bool write, size_t bytes,
     /* point the txn at this head descriptor */
     txn->desc = desc;
 
+    /* with indirect descriptors, the head points at the table of the request,
+     * which holds the chain */
+    vring_desc* table = nullptr;
+    if (indirect) {
+        table = static_cast<vring_desc*>(io_buffer_virt(&queue->indirect_buf)) + index * ring_size;
+        desc->addr = io_buffer_phys(&queue->indirect_buf) + index * ring_size * sizeof(vring_desc);
+        desc->len = (uint32_t)(count * sizeof(vring_desc));
+        desc->flags = VRING_DESC_F_INDIRECT;
+        LTRACE_DO(virtio_dump_desc(desc));
+        for (uint16_t n = 0; n < count; n++) {
+            table[n].next = (uint16_t)(n + 1);
+        }
+        desc = &table[0];
+    }
+    auto next_desc = [queue, table](vring_desc* desc) {
+        return table ? &table[desc->next] : queue->vring.DescFromIndex(desc->next);
+    };
+
     /* set up the descriptor pointing to the head */
-    desc->addr = io_buffer_phys(&blk_req_buf_) + index * sizeof(virtio_blk_req_t);
+    desc->addr = io_buffer_phys(&queue->blk_req_buf) + index * sizeof(virtio_blk_req_t);
     desc->len = sizeof(virtio_blk_req_t);
     desc->flags = VRING_DESC_F_NEXT;
     LTRACE_DO(virtio_dump_desc(desc));
 
     for (size_t n = 0; n < pagecount; n++) {
-        desc = vring_.DescFromIndex(desc->next);
+        desc = next_desc(desc);
         desc->addr = pages[n];
         desc->len = (uint32_t) ((bytes > PAGE_SIZE) ? PAGE_SIZE : bytes);
         if (n == 0) {
@@ -367,8 +477,8 @@ zx_status_t BlockDevice::QueueTxn(block_txn_t* txn, bool write, size_t bytes,
     assert(bytes == 0);
 
     /* set up the descriptor pointing to the response */
-    desc = vring_.DescFromIndex(desc->next);
-    desc->addr = blk_res_pa_ + index;
+    desc = next_desc(desc);
+    desc->addr = queue->blk_res_pa + index;
     desc->len = 1;
     desc->flags = VRING_DESC_F_WRITE;
     LTRACE_DO(virtio_dump_desc(desc));
@@ -380,7 +490,8 @@ zx_status_t BlockDevice::QueueTxn(block_txn_t* txn, bool write, size_t bytes,
 void BlockDevice::QueueReadWriteTxn(block_txn_t* txn, bool write) {
     LTRACEF("txn %p, command %#x\n", txn, txn->op.command);
 
-    fbl::AutoLock lock(&lock_);
+    RequestQueue* queue = SelectQueue();
+    fbl::AutoLock lock(&queue->lock);
 
     txn->op.rw.offset_vmo *= config_.blk_size;
 
@@ -427,18 +538,18 @@ void BlockDevice::QueueReadWriteTxn(block_txn_t* txn, bool write) {
         uint16_t idx;
 
         // attempt to setup hw txn
-        zx_status_t status = QueueTxn(txn, write, bytes, pages, num_pages, &idx);
+        zx_status_t status = QueueTxn(queue, txn, write, bytes, pages, num_pages, &idx);
         if (status == ZX_OK) {
-            fbl::AutoLock lock(&txn_lock_);
+            fbl::AutoLock lock(&queue->txn_lock);
 
             // save the txn in a list
-            list_add_tail(&txn_list_, &txn->node);
+            list_add_tail(&queue->txn_list, &txn->node);
 
             /* submit the transfer */
-            vring_.SubmitChain(idx);
+            queue->vring.SubmitChain(idx);
 
             /* kick it off */
-            vring_.Kick();
+            queue->vring.Kick();
 
             return;
         } else {
@@ -448,21 +559,21 @@ void BlockDevice::QueueReadWriteTxn(block_txn_t* txn, bool write) {
                 return;
             }
 
-            fbl::AutoLock lock(&txn_lock_);
+            fbl::AutoLock lock(&queue->txn_lock);
 
-            if (list_is_empty(&txn_list_)) {
+            if (list_is_empty(&queue->txn_list)) {
                 // we hold the queue lock and the list is empty
                 // if we fail this time around, no point in trying again
                 cannot_fail = true;
                 continue;
             } else {
                 // let the completer know we need to wake up
-                txn_wait_ = true;
+                queue->txn_wait = true;
             }
         }
 
-        sync_completion_wait(&txn_signal_, ZX_TIME_INFINITE);
-        sync_completion_reset(&txn_signal_);
+        sync_completion_wait(&queue->txn_signal, ZX_TIME_INFINITE);
+        sync_completion_reset(&queue->txn_signal);
     }
 }
 
@@ -14,6 +14,7 @@
 #include <zircon/device/block.h>
 #include <ddk/protocol/block.h>
 
+#include <fbl/atomic.h>
 #include <lib/sync/completion.h>
 
 namespace virtio {
@@ -39,6 +40,7 @@ public:
 
     virtual void IrqRingUpdate() override;
     virtual void IrqConfigChange() override;
+    virtual void IrqQueueUpdate(uint16_t index) override;
 
     uint64_t GetSize() const { return config_.capacity * config_.blk_size; }
     uint32_t GetBlockSize() const { return config_.blk_size; }
@@ -57,54 +59,79 @@ private:
 
     void GetInfo(block_info_t* info);
 
-    zx_status_t QueueTxn(block_txn_t* txn, bool write, size_t bytes,
-                         uint64_t* pages, size_t pagecount, uint16_t* idx);
-    void QueueReadWriteTxn(block_txn_t* txn, bool write);
+    // A request virtqueue, and the block requests in flight on it.
+    struct RequestQueue {
+        explicit RequestQueue(Device* device) : vring(device) {}
 
-    void txn_complete(block_txn_t* txn, zx_status_t status);
+        // the virtio ring
+        Ring vring;
 
-    // the main virtio ring
-    Ring vring_ = {this};
+        // held while a request is put together and submitted
+        fbl::Mutex lock;
 
-    // lock to be used around Ring::AllocDescChain and FreeDesc
-    // TODO: move this into Ring class once it's certain that other
-    // users of the class are okay with it.
-    fbl::Mutex ring_lock_;
+        // lock to be used around Ring::AllocDescChain and FreeDesc
+        // TODO: move this into Ring class once it's certain that other
+        // users of the class are okay with it.
+        fbl::Mutex ring_lock;
 
-    static const uint16_t ring_size = 128; // 128 matches legacy pci
+        io_buffer_t blk_req_buf = {};
+        virtio_blk_req_t* blk_req = nullptr;
 
-    // saved block device configuration out of the pci config BAR
-    virtio_blk_config_t config_ = {};
+        // With VIRTIO_F_RING_INDIRECT_DESC, each block request builds its chain in
+        // its own table of ring_size descriptors, and takes a single descriptor of
+        // the ring.
+        io_buffer_t indirect_buf = {};
 
-    // a queue of block request/responses
-    static const size_t blk_req_count = 32;
+        zx_paddr_t blk_res_pa = 0;
+        uint8_t* blk_res = nullptr;
+
+        uint32_t blk_req_bitmap = 0;
+
+        size_t alloc_blk_req() {
+            size_t i = 0;
+            if (blk_req_bitmap != 0)
+                i = sizeof(blk_req_bitmap) * CHAR_BIT - __builtin_clz(blk_req_bitmap);
+            blk_req_bitmap |= (1 << i);
+            return i;
+        }
 
-    io_buffer_t blk_req_buf_;
-    virtio_blk_req_t* blk_req_ = nullptr;
+        void free_blk_req(size_t i) {
+            blk_req_bitmap &= ~(1 << i);
+        }
 
-    zx_paddr_t blk_res_pa_ = 0;
-    uint8_t* blk_res_ = nullptr;
+        // pending iotxns and waiter state
+        fbl::Mutex txn_lock;
+        list_node txn_list = LIST_INITIAL_VALUE(txn_list);
+        bool txn_wait = false;
+        sync_completion_t txn_signal;
+    };
 
-    uint32_t blk_req_bitmap_ = 0;
-    static_assert(blk_req_count <= sizeof(blk_req_bitmap_) * CHAR_BIT, "");
+    zx_status_t InitQueue(uint16_t index);
+    // The queue requests of the calling thread go to.
+    RequestQueue* SelectQueue();
+    void QueueUpdate(RequestQueue* queue);
 
-    size_t alloc_blk_req() {
-        size_t i = 0;
-        if (blk_req_bitmap_ != 0)
-            i = sizeof(blk_req_bitmap_) * CHAR_BIT - __builtin_clz(blk_req_bitmap_);
-        blk_req_bitmap_ |= (1 << i);
-        return i;
-    }
+    zx_status_t QueueTxn(RequestQueue* queue, block_txn_t* txn, bool write, size_t bytes,
+                         uint64_t* pages, size_t pagecount, uint16_t* idx);
+    void QueueReadWriteTxn(block_txn_t* txn, bool write);
+
+    void txn_complete(block_txn_t* txn, zx_status_t status);
+
+    static const uint16_t ring_size = 128; // 128 matches legacy pci
 
-    void free_blk_req(size_t i) {
-        blk_req_bitmap_ &= ~(1 << i);
-    }
+    // saved block device configuration out of the pci config BAR
+    virtio_blk_config_t config_ = {};
 
-    // pending iotxns and waiter state
-    fbl::Mutex txn_lock_;
-    list_node txn_list_ = LIST_INITIAL_VALUE(txn_list_);
-    bool txn_wait_ = false;
-    sync_completion_t txn_signal_;
+    // a queue of block request/responses
+    static const size_t blk_req_count = 32;
+    static_assert(blk_req_count <= sizeof(RequestQueue::blk_req_bitmap) * CHAR_BIT, "");
+
+    // With VIRTIO_BLK_F_MQ there is a request queue per cpu, up to max_queues.
+    static const uint16_t max_queues = 8;
+    fbl::unique_ptr<RequestQueue> queues_[max_queues];
+    uint16_t num_queues_ = 1;
+    // Hands out queues to submitting threads.
+    fbl::atomic<uint16_t> next_queue_ = {0};
 
     block_impl_protocol_ops_t block_ops_ = {};
 };
@@ -80,9 +80,61 @@ int Device::IrqThreadEntry(void* arg) {
     return 0;
 }
 
+int Device::QueueIrqThreadEntry(void* arg) {
+    QueueIrq* irq = static_cast<QueueIrq*>(arg);
+    Device* d = irq->device;
+
+    while (d->backend_->WaitForQueueInterrupt(irq->index) == ZX_OK) {
+        d->IrqQueueUpdate(irq->index);
+    }
+    zxlogf(TRACE, "%s: queue %u irq thread exiting\n", d->tag(), irq->index);
+    return 0;
+}
+
 void Device::StartIrqThread() {
     thrd_create_with_name(&irq_thread_, IrqThreadEntry, this, "virtio-irq-thread");
     thrd_detach(irq_thread_);
+    for (uint16_t i = 0; i < queue_irq_count_; i++) {
+        QueueIrq* irq = &queue_irqs_[i];
+        irq->device = this;
+        irq->index = i;
+        thrd_create_with_name(&irq->thread, QueueIrqThreadEntry, irq, "virtio-queue-irq-thread");
+        thrd_detach(irq->thread);
+    }
+}
+
+zx_status_t Device::SetupQueueInterrupts(uint16_t count) {
+    zx_status_t status = backend_->SetQueueInterrupts(count);
+    if (status != ZX_OK) {
+        zxlogf(TRACE, "%s: no per-queue interrupts: %d\n", tag(), status);
+        return status;
+    }
+    queue_irq_count_ = count;
+    return ZX_OK;
+}
+
+void Device::SteerQueueInterrupt(uint16_t index, uint32_t cpu) {
+    zx_status_t status = backend_->SetQueueInterruptAffinity(index, cpu);
+    if (status != ZX_OK) {
+        zxlogf(INFO, "%s: cannot steer queue %u irq to cpu %u: %d\n", tag(), index, cpu, status);
+    }
+}
+
+void Device::NegotiateRingFeatures() {
+    // 2.4.7 Virtqueue Interrupt Suppression
+    //
+    // With event indices, notifications and interrupts are suppressed until
+    // the other side reaches the ring entry it asked for, rather than by
+    // flags that are only advisory.
+    if (DeviceFeatureSupported(VIRTIO_F_RING_EVENT_IDX)) {
+        DriverFeatureAck(VIRTIO_F_RING_EVENT_IDX);
+        event_idx_ = true;
+    }
+    // 2.4.5.3 Indirect Descriptors
+    if (DeviceFeatureSupported(VIRTIO_F_RING_INDIRECT_DESC)) {
+        DriverFeatureAck(VIRTIO_F_RING_INDIRECT_DESC);
+        indirect_desc_ = true;
+    }
 }
 
 zx_status_t Device::CopyDeviceConfig(void* _buf, size_t len) const {
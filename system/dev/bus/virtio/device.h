@@ -37,6 +37,9 @@ public:
     // interrupt cases that devices may override
     virtual void IrqRingUpdate() = 0;
     virtual void IrqConfigChange() = 0;
+    // Called for the virtqueues given interrupts of their own with
+    // SetupQueueInterrupts(), instead of IrqRingUpdate().
+    virtual void IrqQueueUpdate(uint16_t index) {}
 
     // Get the Ring size for the particular device / backend.
     // This has to be proxied to a backend method because we can't
@@ -58,11 +61,26 @@ public:
 
     // Accessor for bti so that Rings can map IO buffers
     const zx::bti& bti() { return bti_; }
+
+    // Ring features negotiated by NegotiateRingFeatures().
+    bool event_idx() const { return event_idx_; }
+    bool indirect_desc() const { return indirect_desc_; }
 protected:
     // Methods for checking / acknowledging features
     bool DeviceFeatureSupported(uint32_t feature) { return backend_->ReadFeature(feature); }
     void DriverFeatureAck(uint32_t feature) { backend_->SetFeature(feature); }
     bool DeviceStatusFeaturesOk() { return backend_->ConfirmFeatures(); }
+    // Acks the event index and indirect descriptor features the device
+    // supports. Called before the rings are initialized.
+    void NegotiateRingFeatures();
+    // Gives virtqueues 0 to |count| - 1 interrupts of their own, each serviced
+    // by a thread of its own once StartIrqThread() is called. Called before the
+    // rings are initialized; on failure every ring keeps using IrqRingUpdate().
+    zx_status_t SetupQueueInterrupts(uint16_t count);
+    // The number of virtqueues set up by SetupQueueInterrupts().
+    uint16_t queue_interrupts() const { return queue_irq_count_; }
+    // Delivers the interrupt of virtqueue |index| to |cpu|.
+    void SteerQueueInterrupt(uint16_t index, uint32_t cpu);
 
     // Devie lifecycle methods
     void DeviceReset() { backend_->DeviceReset(); }
@@ -80,13 +98,24 @@ protected:
     zx_device_t* bus_device() const { return bus_device_; }
     static int IrqThreadEntry(void* arg);
     void IrqWorker();
+    static int QueueIrqThreadEntry(void* arg);
 
     // BTI for managing DMA
     zx::bti bti_;
+    bool event_idx_ = false;
+    bool indirect_desc_ = false;
     // backend responsible for hardware io. Will be released when device goes out of scope
     fbl::unique_ptr<Backend> backend_;
     // irq thread object
     thrd_t irq_thread_ = {};
+    // Per-queue interrupt threads.
+    struct QueueIrq {
+        Device* device;
+        uint16_t index;
+        thrd_t thread;
+    };
+    QueueIrq queue_irqs_[Backend::kMaxQueueInterrupts] = {};
+    uint16_t queue_irq_count_ = 0;
     zx::handle irq_handle_ = {};
     // Bus device is the parent device on the bus, device is this driver's device node.
     zx_device_t* bus_device_ = nullptr;
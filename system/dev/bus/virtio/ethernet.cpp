@@ -18,11 +18,13 @@
 #include <fbl/auto_call.h>
 #include <fbl/auto_lock.h>
 #include <fbl/unique_ptr.h>
+#include <lib/sync/completion.h>
 #include <pretty/hexdump.h>
 #include <virtio/net.h>
 #include <virtio/virtio.h>
 #include <zircon/assert.h>
 #include <zircon/status.h>
+#include <zircon/syscalls.h>
 #include <zircon/types.h>
 
 #include "ring.h"
@@ -50,9 +52,20 @@ const size_t kFrameSize = sizeof(virtio_net_hdr_t) + kL1EthHdrLen + kVirtioMtu;
 const size_t kFramesInBuf = PAGE_SIZE / kFrameSize;
 const size_t kNumIoBufs = fbl::round_up(kBacklog * 2, kFramesInBuf) / kFramesInBuf;
 
+// Virtqueues of a pair, relative to twice its index, and frames of its I/O
+// buffers.
 const uint16_t kRxId = 0u;
 const uint16_t kTxId = 1u;
 
+// Only a single command is ever outstanding on the control virtqueue.
+const uint16_t kCtrlDescs = 4u;
+
+// The VIRTIO_NET_F_* values are masks, while features are negotiated by bit
+// number.
+constexpr uint32_t FeatureBit(uint32_t mask) {
+    return __builtin_ctz(mask);
+}
+
 // Strictly for convenience...
 typedef struct vring_desc desc_t;
 
@@ -107,7 +120,8 @@ zx_status_t virtio_net_queue_tx(void* ctx, uint32_t options, ethmac_netbuf_t* ne
 }
 
 static zx_status_t virtio_set_param(void* ctx, uint32_t param, int32_t value, void* data) {
-    return ZX_ERR_NOT_SUPPORTED;
+    virtio::EthernetDevice* eth = static_cast<virtio::EthernetDevice*>(ctx);
+    return eth->SetParam(param, value, data);
 }
 
 ethmac_protocol_ops_t kProtoOps = {
@@ -179,11 +193,37 @@ uint8_t* GetFrameData(io_buffer_t* bufs, uint16_t ring_id, uint16_t desc_id, siz
     return reinterpret_cast<uint8_t*>(vaddr + hdr_size);
 }
 
+// 5.1.6.4.1 Device Requirements: Processing of Incoming Packets
+//
+// Frames received with VIRTIO_NET_HDR_F_NEEDS_CSUM carry the checksum of the
+// pseudo-header only, and the rest is left to the driver.
+bool CompleteChecksum(uint8_t* data, size_t len, size_t start, size_t offset) {
+    if (start > len || len - start < sizeof(uint16_t) ||
+        offset > len - start - sizeof(uint16_t)) {
+        return false;
+    }
+    uint32_t sum = 0;
+    for (size_t i = start; i + 1 < len; i += 2) {
+        sum += (data[i] << 8) | data[i + 1];
+    }
+    if ((len - start) & 1) {
+        sum += data[len - 1] << 8;
+    }
+    while (sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    uint16_t csum = static_cast<uint16_t>(~sum);
+    data[start + offset] = static_cast<uint8_t>(csum >> 8);
+    data[start + offset + 1] = static_cast<uint8_t>(csum & 0xff);
+    return true;
+}
+
 } // namespace
 
 EthernetDevice::EthernetDevice(zx_device_t* bus_device, zx::bti bti, fbl::unique_ptr<Backend> backend)
-    : Device(bus_device, fbl::move(bti), fbl::move(backend)), rx_(this), tx_(this), bufs_(nullptr),
-      unkicked_(0), ifc_(nullptr), cookie_(nullptr) {
+    : Device(bus_device, fbl::move(bti), fbl::move(backend)), ctrl_(this), ifc_(nullptr),
+      cookie_(nullptr) {
+    memset(&ctrl_buf_, 0, sizeof(ctrl_buf_));
 }
 
 EthernetDevice::~EthernetDevice() {
@@ -193,8 +233,7 @@ EthernetDevice::~EthernetDevice() {
 zx_status_t EthernetDevice::Init() {
     LTRACE_ENTRY;
     zx_status_t rc;
-    if (mtx_init(&state_lock_, mtx_plain) != thrd_success ||
-        mtx_init(&tx_lock_, mtx_plain) != thrd_success) {
+    if (mtx_init(&state_lock_, mtx_plain) != thrd_success) {
         return ZX_ERR_NO_RESOURCES;
     }
     fbl::AutoLock lock(&state_lock_);
@@ -222,6 +261,39 @@ zx_status_t EthernetDevice::Init() {
       virtio_hdr_len_ -= 2;
     }
 
+    // 5.1.6.5.5 Automatic receive steering in multiqueue mode
+    //
+    // Traffic is spread over several queue pairs once the driver sets their
+    // number through the control virtqueue.
+    uint16_t max_pairs = 1;
+    if (DeviceFeatureSupported(FeatureBit(VIRTIO_NET_F_CTRL_VQ)) &&
+        DeviceFeatureSupported(FeatureBit(VIRTIO_NET_F_MQ)) && config_.max_virtqueue_pairs > 1) {
+        DriverFeatureAck(FeatureBit(VIRTIO_NET_F_CTRL_VQ));
+        DriverFeatureAck(FeatureBit(VIRTIO_NET_F_MQ));
+        max_pairs = config_.max_virtqueue_pairs;
+    }
+    num_pairs_ = fbl::min<uint16_t>(max_pairs, ETHMAC_MAX_QUEUES);
+    NegotiateRingFeatures();
+
+    // 5.1.3.1 Feature bit requirements
+    //
+    // Segmentation requires checksum offload. It is only used when offered
+    // for both IPv4 and IPv6, as ethmac does not tell them apart.
+    if (DeviceFeatureSupported(FeatureBit(VIRTIO_NET_F_CSUM))) {
+        DriverFeatureAck(FeatureBit(VIRTIO_NET_F_CSUM));
+        features_ |= ETHMAC_FEATURE_TX_CSUM;
+        if (DeviceFeatureSupported(FeatureBit(VIRTIO_NET_F_HOST_TSO4)) &&
+            DeviceFeatureSupported(FeatureBit(VIRTIO_NET_F_HOST_TSO6))) {
+            DriverFeatureAck(FeatureBit(VIRTIO_NET_F_HOST_TSO4));
+            DriverFeatureAck(FeatureBit(VIRTIO_NET_F_HOST_TSO6));
+            features_ |= ETHMAC_FEATURE_TSO;
+        }
+    }
+    if (DeviceFeatureSupported(FeatureBit(VIRTIO_NET_F_GUEST_CSUM))) {
+        DriverFeatureAck(FeatureBit(VIRTIO_NET_F_GUEST_CSUM));
+        features_ |= ETHMAC_FEATURE_RX_CSUM;
+    }
+
     // TODO(aarongreen): Check additional features bits and ack/nak them
     rc = DeviceStatusFeaturesOk();
     if (rc != ZX_OK) {
@@ -232,63 +304,192 @@ zx_status_t EthernetDevice::Init() {
     // Plan to clean up unless everything goes right.
     auto cleanup = fbl::MakeAutoCall([this]() { Release(); });
 
+    // Give the virtqueues of each pair an interrupt of their own, delivered to
+    // the cpu of the pair, when the backend allows. Transmit virtqueues do not
+    // interrupt, but their vectors keep the numbering simple.
+    if (num_pairs_ > 1 && SetupQueueInterrupts(static_cast<uint16_t>(num_pairs_ * 2)) == ZX_OK) {
+        uint32_t cpus = zx_system_get_num_cpus();
+        for (uint16_t i = 0; i < num_pairs_; ++i) {
+            SteerQueueInterrupt(static_cast<uint16_t>(i * 2 + kRxId), i % cpus);
+        }
+    }
+
     // Allocate I/O buffers and virtqueues.
+    for (uint16_t i = 0; i < num_pairs_; ++i) {
+        if ((rc = InitQueuePair(i)) != ZX_OK) {
+            return rc;
+        }
+    }
+    if (num_pairs_ > 1) {
+        // The control virtqueue comes after all of the pairs of the device,
+        // including those left unused.
+        uint16_t ctrl_id = static_cast<uint16_t>(max_pairs * 2);
+        if ((rc = io_buffer_init(&ctrl_buf_, bti_.get(), PAGE_SIZE,
+                                 IO_BUFFER_RW | IO_BUFFER_CONTIG)) != ZX_OK ||
+            (rc = ctrl_.Init(ctrl_id, kCtrlDescs)) != ZX_OK) {
+            zxlogf(ERROR, "failed to allocate control virtqueue: %s\n",
+                   zx_status_get_string(rc));
+            return rc;
+        }
+    }
+
+    // Start the interrupt thread and set the driver OK status, which the
+    // device waits for before looking at the virtqueues.
+    StartIrqThread();
+    DriverStatusOk();
+
+    if (num_pairs_ > 1 && (rc = SetQueuePairs()) != ZX_OK) {
+        // The device keeps using the first pair only.
+        zxlogf(ERROR, "%s: failed to use %u queue pairs: %s\n", tag(), num_pairs_,
+               zx_status_get_string(rc));
+        num_pairs_ = 1;
+    }
+
+    // Initialize the zx_device and publish us
+    device_add_args_t args;
+    memset(&args, 0, sizeof(args));
+    args.version = DEVICE_ADD_ARGS_VERSION;
+    args.name = "virtio-net";
+    args.ctx = this;
+    args.ops = &kDeviceOps;
+    args.proto_id = ZX_PROTOCOL_ETHERNET_IMPL;
+    args.proto_ops = &kProtoOps;
+    if ((rc = device_add(bus_device_, &args, &device_)) != ZX_OK) {
+        zxlogf(ERROR, "failed to add device: %s\n", zx_status_get_string(rc));
+        return rc;
+    }
+    // Give the rx buffers to the host
+    for (uint16_t i = 0; i < num_pairs_; ++i) {
+        pairs_[i]->rx.Kick();
+    }
+
+    // Woohoo! Driver should be ready.
+    cleanup.cancel();
+    return ZX_OK;
+}
+
+zx_status_t EthernetDevice::InitQueuePair(uint16_t index) {
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<QueuePair> pair(new (&ac) QueuePair(this));
+    if (!ac.check()) {
+        zxlogf(ERROR, "out of memory!\n");
+        return ZX_ERR_NO_MEMORY;
+    }
+    if (mtx_init(&pair->tx_lock, mtx_plain) != thrd_success) {
+        return ZX_ERR_NO_RESOURCES;
+    }
+
+    zx_status_t rc;
     uint16_t num_descs = static_cast<uint16_t>(kBacklog & 0xffff);
-    if ((rc = InitBuffers(bti_, &bufs_)) != ZX_OK || (rc = rx_.Init(kRxId, num_descs)) != ZX_OK ||
-        (rc = tx_.Init(kTxId, num_descs)) != ZX_OK) {
+    uint16_t ring_id = static_cast<uint16_t>(index * 2);
+    if ((rc = InitBuffers(bti_, &pair->bufs)) != ZX_OK ||
+        (rc = pair->rx.Init(static_cast<uint16_t>(ring_id + kRxId), num_descs)) != ZX_OK ||
+        (rc = pair->tx.Init(static_cast<uint16_t>(ring_id + kTxId), num_descs)) != ZX_OK) {
         zxlogf(ERROR, "failed to allocate virtqueue: %s\n", zx_status_get_string(rc));
+        ReleaseQueuePair(pair.get());
         return rc;
     }
 
     // Associate the I/O buffers with the virtqueue descriptors
+    io_buffer_t* bufs = pair->bufs.get();
     desc_t* desc = nullptr;
     uint16_t id;
 
     // For rx buffers, we queue a bunch of "reads" from the network that
     // complete when packets arrive.
     for (uint16_t i = 0; i < num_descs; ++i) {
-        desc = rx_.AllocDescChain(1, &id);
-        desc->addr = GetFramePhys(bufs_.get(), kRxId, id);
+        desc = pair->rx.AllocDescChain(1, &id);
+        desc->addr = GetFramePhys(bufs, kRxId, id);
         desc->len = kFrameSize;
         desc->flags |= VRING_DESC_F_WRITE;
         LTRACE_DO(virtio_dump_desc(desc));
-        rx_.SubmitChain(id);
+        pair->rx.SubmitChain(id);
     }
 
-    // For tx buffers, we hold onto them until we need to send a packet.
+    // For tx buffers, we hold onto them until we need to send a packet. Sent
+    // buffers are reclaimed by QueueTx() once it runs out, so the device need
+    // not interrupt when it is done with them.
+    pair->tx.DisableInterrupts();
     for (uint16_t id = 0; id < num_descs; ++id) {
-        desc = tx_.DescFromIndex(id);
-        desc->addr = GetFramePhys(bufs_.get(), kTxId, id);
+        desc = pair->tx.DescFromIndex(id);
+        desc->addr = GetFramePhys(bufs, kTxId, id);
         desc->len = 0;
         desc->flags &= static_cast<uint16_t>(~VRING_DESC_F_WRITE);
         LTRACE_DO(virtio_dump_desc(desc));
     }
 
-    // Start the interrupt thread and set the driver OK status
-    StartIrqThread();
-
-    // Initialize the zx_device and publish us
-    device_add_args_t args;
-    memset(&args, 0, sizeof(args));
-    args.version = DEVICE_ADD_ARGS_VERSION;
-    args.name = "virtio-net";
-    args.ctx = this;
-    args.ops = &kDeviceOps;
-    args.proto_id = ZX_PROTOCOL_ETHERNET_IMPL;
-    args.proto_ops = &kProtoOps;
-    if ((rc = device_add(bus_device_, &args, &device_)) != ZX_OK) {
-        zxlogf(ERROR, "failed to add device: %s\n", zx_status_get_string(rc));
-        return rc;
+    if (features_ & ETHMAC_FEATURE_TSO) {
+        for (size_t i = 0; i < kTsoBufs; ++i) {
+            if ((rc = io_buffer_init(&pair->tso_bufs[i], bti_.get(), kTsoBufSize,
+                                     IO_BUFFER_RW | IO_BUFFER_CONTIG)) != ZX_OK) {
+                zxlogf(ERROR, "failed to allocate TSO buffers: %s\n", zx_status_get_string(rc));
+                ReleaseQueuePair(pair.get());
+                return rc;
+            }
+        }
+        fbl::AutoLock lock(&pair->tx_lock);
+        pair->tso_free = (1u << kTsoBufs) - 1;
     }
-    // Give the rx buffers to the host
-    rx_.Kick();
 
-    // Woohoo! Driver should be ready.
-    cleanup.cancel();
-    DriverStatusOk();
+    pairs_[index] = fbl::move(pair);
     return ZX_OK;
 }
 
+void EthernetDevice::ReleaseQueuePair(QueuePair* pair) {
+    ReleaseBuffers(fbl::move(pair->bufs));
+    for (auto& buf : pair->tso_bufs) {
+        if (io_buffer_is_valid(&buf)) {
+            io_buffer_release(&buf);
+        }
+    }
+}
+
+zx_status_t EthernetDevice::SetQueuePairs() {
+    // 5.1.6.5 Control Virtqueue
+    //
+    // The header, the command-specific data and the ack each get their own
+    // descriptor, as legacy devices expect.
+    uint16_t id;
+    desc_t* desc = ctrl_.AllocDescChain(3, &id);
+    if (!desc) {
+        return ZX_ERR_NO_RESOURCES;
+    }
+    uint8_t* virt = static_cast<uint8_t*>(io_buffer_virt(&ctrl_buf_));
+    zx_paddr_t phys = io_buffer_phys(&ctrl_buf_);
+
+    virtio_net_ctrl_hdr_t* hdr = reinterpret_cast<virtio_net_ctrl_hdr_t*>(virt);
+    hdr->ctrl_class = VIRTIO_NET_CTRL_MQ;
+    hdr->command = VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET;
+    uint16_t pairs = num_pairs_;
+    size_t data_offset = sizeof(*hdr);
+    memcpy(virt + data_offset, &pairs, sizeof(pairs));
+    size_t ack_offset = data_offset + sizeof(pairs);
+    volatile uint8_t* ack = virt + ack_offset;
+    *ack = VIRTIO_NET_ERR;
+
+    desc->addr = phys;
+    desc->len = sizeof(*hdr);
+    desc->flags = VRING_DESC_F_NEXT;
+    desc = ctrl_.DescFromIndex(desc->next);
+    desc->addr = phys + data_offset;
+    desc->len = sizeof(pairs);
+    desc->flags = VRING_DESC_F_NEXT;
+    desc = ctrl_.DescFromIndex(desc->next);
+    desc->addr = phys + ack_offset;
+    desc->len = 1;
+    desc->flags = VRING_DESC_F_WRITE;
+
+    // IrqRingUpdate() signals the completion once the device is done.
+    sync_completion_reset(&ctrl_done_);
+    ctrl_.SubmitChain(id);
+    ctrl_.Kick();
+    zx_status_t rc = sync_completion_wait(&ctrl_done_, ZX_SEC(1));
+    if (rc != ZX_OK) {
+        return rc;
+    }
+    return *ack == VIRTIO_NET_OK ? ZX_OK : ZX_ERR_IO;
+}
+
 void EthernetDevice::Release() {
     LTRACE_ENTRY;
     fbl::AutoLock lock(&state_lock_);
@@ -297,55 +498,110 @@ void EthernetDevice::Release() {
 
 void EthernetDevice::ReleaseLocked() {
     ifc_ = nullptr;
-    ReleaseBuffers(fbl::move(bufs_));
+    for (auto& pair : pairs_) {
+        if (pair) {
+            ReleaseQueuePair(pair.get());
+        }
+    }
+    if (io_buffer_is_valid(&ctrl_buf_)) {
+        io_buffer_release(&ctrl_buf_);
+    }
     Device::Release();
 }
 
 void EthernetDevice::IrqRingUpdate() {
     LTRACE_ENTRY;
-    // Lock to prevent changes to ifc_.
-    {
-        fbl::AutoLock lock(&state_lock_);
-        if (!ifc_) {
-            return;
-        }
-        // Ring::IrqRingUpdate will call this lambda on each rx buffer filled by
-        // the underlying device since the last IRQ.
-        // Thread safety analysis is explicitly disabled as clang isn't able to determine that the
-        // state_lock_ is  held when the lambda invoked.
-        rx_.IrqRingUpdate([this](vring_used_elem* used_elem) TA_NO_THREAD_SAFETY_ANALYSIS {
+    // The control virtqueue is only used while Init() holds state_lock_.
+    if (io_buffer_is_valid(&ctrl_buf_)) {
+        ctrl_.IrqRingUpdate([this](vring_used_elem* used_elem) {
             uint16_t id = static_cast<uint16_t>(used_elem->id & 0xffff);
-            desc_t* desc = rx_.DescFromIndex(id);
-
-            // Transitional driver does not merge rx buffers.
-            assert(used_elem->len < desc->len);
-            uint8_t* data = GetFrameData(bufs_.get(), kRxId, id, virtio_hdr_len_);
-            size_t len = used_elem->len - virtio_hdr_len_;
-            LTRACEF("Receiving %zu bytes:\n", len);
-            LTRACE_DO(hexdump8_ex(data, len, 0));
-
-            // Pass the data up the stack to the generic Ethernet driver
-            ifc_->recv(cookie_, data, len, 0);
-            assert((desc->flags & VRING_DESC_F_NEXT) == 0);
-            LTRACE_DO(virtio_dump_desc(desc));
-            rx_.FreeDesc(id);
+            for (;;) {
+                desc_t* desc = ctrl_.DescFromIndex(id);
+                bool next = desc->flags & VRING_DESC_F_NEXT;
+                uint16_t next_id = desc->next;
+                ctrl_.FreeDesc(id);
+                if (!next) {
+                    break;
+                }
+                id = next_id;
+            }
+            sync_completion_signal(&ctrl_done_);
         });
     }
 
-    // Now recycle the rx buffers.  As in Init(), this means queuing a bunch of
-    // "reads" from the network that will complete when packets arrive.
-    desc_t* desc = nullptr;
-    uint16_t id;
-    bool need_kick = false;
-    while ((desc = rx_.AllocDescChain(1, &id))) {
-        desc->len = kFrameSize;
-        rx_.SubmitChain(id);
-        need_kick = true;
+    // Pairs whose rx virtqueue has an interrupt of its own are serviced by
+    // IrqQueueUpdate().
+    for (uint16_t i = 0; i < num_pairs_; ++i) {
+        if (i * 2 + kRxId >= queue_interrupts()) {
+            RxUpdate(i);
+        }
+    }
+}
+
+void EthernetDevice::IrqQueueUpdate(uint16_t index) {
+    uint16_t i = static_cast<uint16_t>(index / 2);
+    if (index % 2 == kRxId && i < num_pairs_) {
+        RxUpdate(i);
     }
+}
+
+void EthernetDevice::RxUpdate(uint16_t i) {
+    QueuePair* pair = pairs_[i].get();
+    {
+        // Lock to prevent changes to ifc_.
+        {
+            fbl::AutoLock lock(&state_lock_);
+            if (!ifc_) {
+                return;
+            }
+            // Ring::IrqRingUpdate will call this lambda on each rx buffer filled
+            // by the underlying device since the last IRQ.
+            // Thread safety analysis is explicitly disabled as clang isn't able
+            // to determine that the state_lock_ is held when the lambda invoked.
+            pair->rx.IrqRingUpdate([this, pair, i](vring_used_elem* used_elem)
+                                       TA_NO_THREAD_SAFETY_ANALYSIS {
+                uint16_t id = static_cast<uint16_t>(used_elem->id & 0xffff);
+                desc_t* desc = pair->rx.DescFromIndex(id);
+
+                // Transitional driver does not merge rx buffers.
+                assert(used_elem->len < desc->len);
+                uint8_t* data = GetFrameData(pair->bufs.get(), kRxId, id, virtio_hdr_len_);
+                size_t len = used_elem->len - virtio_hdr_len_;
+                LTRACEF("Receiving %zu bytes:\n", len);
+                LTRACE_DO(hexdump8_ex(data, len, 0));
+
+                // Checksums are only reported with VIRTIO_NET_F_GUEST_CSUM.
+                uint32_t flags = ETHMAC_RX_OPT_QUEUE(i);
+                virtio_net_hdr_t* rx_hdr = GetFrameHdr(pair->bufs.get(), kRxId, id);
+                if ((rx_hdr->flags & VIRTIO_NET_HDR_F_DATA_VALID) ||
+                    ((rx_hdr->flags & VIRTIO_NET_HDR_F_NEEDS_CSUM) &&
+                     CompleteChecksum(data, len, rx_hdr->csum_start, rx_hdr->csum_offset))) {
+                    flags |= ETHMAC_RX_OPT_CSUM_OK;
+                }
+
+                // Pass the data up the stack to the generic Ethernet driver
+                ifc_->recv(cookie_, data, len, flags);
+                assert((desc->flags & VRING_DESC_F_NEXT) == 0);
+                LTRACE_DO(virtio_dump_desc(desc));
+                pair->rx.FreeDesc(id);
+            });
+        }
+
+        // Now recycle the rx buffers.  As in Init(), this means queuing a bunch of
+        // "reads" from the network that will complete when packets arrive.
+        desc_t* desc = nullptr;
+        uint16_t id;
+        bool need_kick = false;
+        while ((desc = pair->rx.AllocDescChain(1, &id))) {
+            desc->len = kFrameSize;
+            pair->rx.SubmitChain(id);
+            need_kick = true;
+        }
 
-    // If we have re-queued any rx buffers, poke the virtqueue to pick them up.
-    if (need_kick) {
-        rx_.Kick();
+        // If we have re-queued any rx buffers, poke the virtqueue to pick them up.
+        if (need_kick) {
+            pair->rx.Kick();
+        }
     }
 }
 
@@ -368,9 +624,10 @@ zx_status_t EthernetDevice::Query(uint32_t options, ethmac_info_t* info) {
     }
     fbl::AutoLock lock(&state_lock_);
     if (info) {
-        // TODO(aarongreen): Add info->features = GetFeatures();
+        info->features = features_;
         info->mtu = kVirtioMtu;
         memcpy(info->mac, config_.mac, sizeof(info->mac));
+        info->queue_count = num_pairs_;
     }
     return ZX_OK;
 }
@@ -387,7 +644,7 @@ zx_status_t EthernetDevice::Start(ethmac_ifc_t* ifc, void* cookie) {
         return ZX_ERR_INVALID_ARGS;
     }
     fbl::AutoLock lock(&state_lock_);
-    if (!bufs_ || ifc_) {
+    if (!pairs_[0] || !pairs_[0]->bufs || ifc_) {
         return ZX_ERR_BAD_STATE;
     }
     ifc_ = ifc;
@@ -400,30 +657,64 @@ zx_status_t EthernetDevice::QueueTx(uint32_t options, ethmac_netbuf_t* netbuf) {
     LTRACE_ENTRY;
     void* data = netbuf->data;
     size_t length = netbuf->len;
+    bool tso = netbuf->flags & ETHMAC_NETBUF_TSO;
     // First, validate the packet
-    if (!data || length > virtio_hdr_len_ + kVirtioMtu) {
+    if (!data || length > (tso ? kTsoBufSize : virtio_hdr_len_ + kVirtioMtu)) {
         LTRACEF("dropping packet; invalid packet\n");
         return ZX_ERR_INVALID_ARGS;
     }
+    if ((tso && !(features_ & ETHMAC_FEATURE_TSO)) ||
+        ((netbuf->flags & ETHMAC_NETBUF_CSUM) && !(features_ & ETHMAC_FEATURE_TX_CSUM))) {
+        LTRACEF("dropping packet; offload not negotiated\n");
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+    uint32_t queue = ETHMAC_TX_QUEUE(options);
+    if (queue >= num_pairs_) {
+        LTRACEF("dropping packet; invalid queue %u\n", queue);
+        return ZX_ERR_INVALID_ARGS;
+    }
+    QueuePair* pair = pairs_[queue].get();
 
-    fbl::AutoLock lock(&tx_lock_);
+    fbl::AutoLock lock(&pair->tx_lock);
 
     // Flush outstanding descriptors.  Ring::IrqRingUpdate will call this lambda
     // on each sent tx_buffer, allowing us to reclaim them.
-    auto flush = [this](vring_used_elem* used_elem) {
+    // Thread safety analysis is explicitly disabled as clang isn't able to
+    // determine that tx_lock is held when the lambda is invoked.
+    auto flush = [pair](vring_used_elem* used_elem) TA_NO_THREAD_SAFETY_ANALYSIS {
         uint16_t id = static_cast<uint16_t>(used_elem->id & 0xffff);
-        desc_t* desc = tx_.DescFromIndex(id);
-        assert((desc->flags & VRING_DESC_F_NEXT) == 0);
+        desc_t* desc = pair->tx.DescFromIndex(id);
         LTRACE_DO(virtio_dump_desc(desc));
-        tx_.FreeDesc(id);
+        if (desc->flags & VRING_DESC_F_NEXT) {
+            // A TSO packet. Release its buffer, and point the second
+            // descriptor back at its own frame.
+            uint16_t next_id = desc->next;
+            desc_t* next = pair->tx.DescFromIndex(next_id);
+            assert((next->flags & VRING_DESC_F_NEXT) == 0);
+            for (size_t i = 0; i < kTsoBufs; ++i) {
+                if (next->addr == io_buffer_phys(&pair->tso_bufs[i])) {
+                    pair->tso_free |= 1u << i;
+                }
+            }
+            next->addr = GetFramePhys(pair->bufs.get(), kTxId, next_id);
+            next->len = 0;
+            pair->tx.FreeDesc(next_id);
+        }
+        pair->tx.FreeDesc(id);
     };
 
-    // Grab a free descriptor
+    // Grab a free descriptor, and a TSO buffer for a TSO packet
     uint16_t id;
-    desc_t* desc = tx_.AllocDescChain(1, &id);
+    uint16_t num_descs = tso ? 2 : 1;
+    desc_t* desc = nullptr;
+    if (!tso || pair->tso_free) {
+        desc = pair->tx.AllocDescChain(num_descs, &id);
+    }
     if (!desc) {
-        tx_.IrqRingUpdate(flush);
-        desc = tx_.AllocDescChain(1, &id);
+        pair->tx.IrqRingUpdate(flush);
+        if (!tso || pair->tso_free) {
+            desc = pair->tx.AllocDescChain(num_descs, &id);
+        }
     }
     if (!desc) {
         LTRACEF("dropping packet; out of descriptors\n");
@@ -431,7 +722,7 @@ zx_status_t EthernetDevice::QueueTx(uint32_t options, ethmac_netbuf_t* netbuf) {
     }
 
     // Add the data to be sent
-    virtio_net_hdr_t* tx_hdr = GetFrameHdr(bufs_.get(), kTxId, id);
+    virtio_net_hdr_t* tx_hdr = GetFrameHdr(pair->bufs.get(), kTxId, id);
     memset(tx_hdr, 0, virtio_hdr_len_);
 
     // 5.1.6.2.1 Driver Requirements: Packet Transmission
@@ -453,21 +744,57 @@ zx_status_t EthernetDevice::QueueTx(uint32_t options, ethmac_netbuf_t* netbuf) {
     // negotiated, the driver MUST set gso_type to VIRTIO_NET_HDR_GSO_NONE.
     tx_hdr->gso_type = VIRTIO_NET_HDR_GSO_NONE;
 
-    void* tx_buf = GetFrameData(bufs_.get(), kTxId, id, virtio_hdr_len_);
+    // 5.1.6.2 Packet Transmission
+    //
+    // With VIRTIO_NET_F_CSUM, the device completes the checksum from
+    // csum_start on, and with VIRTIO_NET_F_HOST_TSO4/6 splits the packet into
+    // segments of gso_size bytes following hdr_len bytes of headers.
+    if (netbuf->flags & ETHMAC_NETBUF_CSUM) {
+        tx_hdr->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+        tx_hdr->csum_start = netbuf->csum_start;
+        tx_hdr->csum_offset = netbuf->csum_offset;
+    }
+
+    void* tx_buf;
+    if (tso) {
+        tx_hdr->gso_type = (netbuf->flags & ETHMAC_NETBUF_IPV6) ? VIRTIO_NET_HDR_GSO_TCPV6
+                                                                : VIRTIO_NET_HDR_GSO_TCPV4;
+        tx_hdr->gso_size = netbuf->mss;
+        tx_hdr->hdr_len = netbuf->hdr_len;
+
+        // The header stays in the frame of the head descriptor, and the packet
+        // goes in its own buffer.
+        size_t i = __builtin_ctz(pair->tso_free);
+        pair->tso_free &= ~(1u << i);
+        desc->len = static_cast<uint32_t>(virtio_hdr_len_);
+        desc_t* next = pair->tx.DescFromIndex(desc->next);
+        next->addr = io_buffer_phys(&pair->tso_bufs[i]);
+        next->len = static_cast<uint32_t>(length);
+        tx_buf = io_buffer_virt(&pair->tso_bufs[i]);
+    } else {
+        tx_buf = GetFrameData(pair->bufs.get(), kTxId, id, virtio_hdr_len_);
+        desc->len = static_cast<uint32_t>(virtio_hdr_len_ + length);
+    }
     memcpy(tx_buf, data, length);
-    desc->len = static_cast<uint32_t>(virtio_hdr_len_ + length);
 
     // Submit the descriptor and notify the back-end.
     LTRACE_DO(virtio_dump_desc(desc));
     LTRACEF("Sending %zu bytes:\n", length);
     LTRACE_DO(hexdump8_ex(tx_buf, length, 0));
-    tx_.SubmitChain(id);
-    ++unkicked_;
-    if ((options & ETHMAC_TX_OPT_MORE) == 0 || unkicked_ > kBacklog / 2) {
-        tx_.Kick();
-        unkicked_ = 0;
+    pair->tx.SubmitChain(id);
+    ++pair->unkicked;
+    if ((options & ETHMAC_TX_OPT_MORE) == 0 || pair->unkicked > kBacklog / 2) {
+        pair->tx.Kick();
+        pair->unkicked = 0;
     }
     return ZX_OK;
 }
 
+zx_status_t EthernetDevice::SetParam(uint32_t param, int32_t value, void* data) {
+    // Received flows follow the queue they are transmitted on, and there is
+    // no hash to configure without VIRTIO_NET_F_RSS, which this driver does
+    // not know about.
+    return ZX_ERR_NOT_SUPPORTED;
+}
+
 } // namespace virtio
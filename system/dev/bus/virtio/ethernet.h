@@ -15,6 +15,7 @@
 #include <ddk/protocol/ethernet.h>
 #include <fbl/macros.h>
 #include <fbl/unique_ptr.h>
+#include <lib/sync/completion.h>
 #include <virtio/net.h>
 #include <zircon/compiler.h>
 #include <zircon/thread_annotations.h>
@@ -39,31 +40,67 @@ public:
     void Stop() TA_EXCL(state_lock_);
     zx_status_t Start(ethmac_ifc_t* ifc, void* cookie) TA_EXCL(state_lock_);
     zx_status_t QueueTx(uint32_t options, ethmac_netbuf_t* netbuf) TA_EXCL(state_lock_);
+    zx_status_t SetParam(uint32_t param, int32_t value, void* data);
 
     const char* tag() const override { return "virtio-net"; }
 
 private:
     DISALLOW_COPY_ASSIGN_AND_MOVE(EthernetDevice);
 
+    // Number and size of the transmit buffers large enough for the segments
+    // the device splits up with TSO.
+    static constexpr size_t kTsoBufs = 4;
+    static constexpr size_t kTsoBufSize = 65536;
+
+    // A receive and a transmit virtqueue, and the I/O buffers of their
+    // descriptors; see section 5.1.2 of the spec.
+    struct QueuePair {
+        explicit QueuePair(Device* device) : rx(device), tx(device) {}
+
+        Ring rx;
+        Ring tx;
+        fbl::unique_ptr<io_buffer_t[]> bufs;
+        mtx_t tx_lock;
+        size_t unkicked TA_GUARDED(tx_lock) = 0;
+
+        // Only allocated with TSO. A TSO packet is sent as a chain of its
+        // virtio header, in the frame of the head descriptor, and of one of
+        // these buffers holding the packet. Bit i of |tso_free| is set while
+        // tso_bufs[i] is unused.
+        io_buffer_t tso_bufs[kTsoBufs] = {};
+        uint32_t tso_free TA_GUARDED(tx_lock) = 0;
+    };
+
     // DDK device hooks; see ddk/device.h
     void ReleaseLocked() TA_REQ(state_lock_);
 
+    zx_status_t InitQueuePair(uint16_t index);
+    void ReleaseQueuePair(QueuePair* pair);
+    // Passes up the frames received on pair |i| and recycles their buffers.
+    void RxUpdate(uint16_t i) TA_EXCL(state_lock_);
+    // Has the device spread traffic over |num_pairs_| queue pairs, with
+    // automatic receive steering; see section 5.1.6.5.5 of the spec.
+    zx_status_t SetQueuePairs();
+
     // Mutexes to control concurrent access
     mtx_t state_lock_;
-    mtx_t tx_lock_;
 
     // Virtqueues; see section 5.1.2 of the spec
-    // This driver doesn't currently support multi-queueing, automatic
-    // steering, or the control virtqueue, so only a single queue is needed in
-    // each direction.
-    Ring rx_;
-    Ring tx_;
-    fbl::unique_ptr<io_buffer_t[]> bufs_;
-    size_t unkicked_ TA_GUARDED(tx_lock_);
+    // Each pair is an ethmac queue. The device steers received flows to the
+    // pair they were last transmitted on; there is no configurable hash.
+    fbl::unique_ptr<QueuePair> pairs_[ETHMAC_MAX_QUEUES];
+    uint16_t num_pairs_ = 1;
+
+    // Control virtqueue, only used during Init() to set the number of pairs.
+    Ring ctrl_;
+    io_buffer_t ctrl_buf_;
+    sync_completion_t ctrl_done_;
 
     // Saved net device configuration out of the pci config BAR
     virtio_net_config_t config_ TA_GUARDED(state_lock_);
     size_t virtio_hdr_len_;
+    // ETHMAC_FEATURE_* offloads negotiated with the device.
+    uint32_t features_ = 0;
 
     // Ethmac callback interface; see ddk/protocol/ethernet.h
     ethmac_ifc_t* ifc_ TA_GUARDED(state_lock_);
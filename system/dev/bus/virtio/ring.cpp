@@ -70,6 +70,13 @@ zx_status_t Ring::Init(uint16_t index, uint16_t count) {
     vring_init(&ring_, count, io_buffer_virt(&ring_buf_), PAGE_SIZE);
     ring_.free_list = 0xffff;
     ring_.free_count = 0;
+    event_idx_ = device_->event_idx();
+    interrupts_ = true;
+    avail_idx_ = 0;
+    kicked_idx_ = 0;
+    if (event_idx_) {
+        vring_used_event(&ring_) = 0;
+    }
 
     /* add all the descriptors to the free list */
     for (uint16_t i = 0; i < count; i++) {
@@ -130,18 +137,41 @@ struct vring_desc* Ring::AllocDescChain(uint16_t count, uint16_t* start_index) {
 void Ring::SubmitChain(uint16_t desc_index) {
     LTRACEF("desc %u\n", desc_index);
 
-    /* add the chain to the available list */
-    struct vring_avail* avail = ring_.avail;
-
-    avail->ring[avail->idx & ring_.num_mask] = desc_index;
-    //mb();
-    avail->idx++;
+    /* add the chain to the available list, published by Kick() */
+    ring_.avail->ring[avail_idx_ & ring_.num_mask] = desc_index;
+    avail_idx_++;
 }
 
 void Ring::Kick() {
     LTRACE_ENTRY;
 
-    device_->RingKick(index_);
+    /* make the descriptors visible before the chains, and the chains before
+     * reading whether the device wants to be notified */
+    hw_wmb();
+    ring_.avail->idx = avail_idx_;
+    hw_mb();
+
+    uint16_t old_idx = kicked_idx_;
+    kicked_idx_ = avail_idx_;
+    bool notify;
+    if (event_idx_) {
+        notify = vring_need_event(vring_avail_event(&ring_), avail_idx_, old_idx);
+    } else {
+        notify = !(ring_.used->flags & VRING_USED_F_NO_NOTIFY);
+    }
+    if (notify) {
+        device_->RingKick(index_);
+    }
+}
+
+void Ring::DisableInterrupts() {
+    interrupts_ = false;
+    ring_.avail->flags = VRING_AVAIL_F_NO_INTERRUPT;
+    if (event_idx_) {
+        /* the device interrupts once it reaches the entry before the last
+         * collected one, which takes a wrap of the 16 bit indices */
+        vring_used_event(&ring_) = static_cast<uint16_t>(ring_.last_used - 1);
+    }
 }
 
 } // namespace virtio
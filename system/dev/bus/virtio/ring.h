@@ -4,6 +4,7 @@
 #pragma once
 
 #include <ddk/io-buffer.h>
+#include <hw/arch_ops.h>
 #include <virtio/virtio_ring.h>
 #include <zircon/types.h>
 
@@ -22,9 +23,17 @@ public:
 
     void FreeDesc(uint16_t desc_index);
     struct vring_desc* AllocDescChain(uint16_t count, uint16_t* start_index);
+    // Chains submitted since the last Kick() are made available to the device
+    // together by the next one, which only notifies the device if it asked
+    // to be notified of them.
     void SubmitChain(uint16_t desc_index);
     void Kick();
 
+    // Asks the device not to interrupt when it uses buffers of this ring,
+    // whose used entries are then only collected by calls to IrqRingUpdate()
+    // made by the driver on its own.
+    void DisableInterrupts();
+
     struct vring_desc* DescFromIndex(uint16_t index) {
         return &ring_.desc[index];
     }
@@ -40,6 +49,14 @@ private:
     uint16_t index_ = 0;
 
     vring ring_ = {};
+
+    // Set if VIRTIO_F_RING_EVENT_IDX was negotiated by the device.
+    bool event_idx_ = false;
+    bool interrupts_ = true;
+    // Index of the next entry of the available ring, and its value at the
+    // last Kick().
+    uint16_t avail_idx_ = 0;
+    uint16_t kicked_idx_ = 0;
 };
 
 // perform the main loop of finding free descriptor chains and passing it to a passed in function
@@ -48,19 +65,34 @@ inline void Ring::IrqRingUpdate(T free_chain) {
     // TRACEF("used flags %#x idx %#x last_used %u\n",
     //         ring_.used->flags, ring_.used->idx, ring_.last_used);
 
-    // find a new free chain of descriptors
-    uint16_t cur_idx = ring_.used->idx;
-    uint16_t i = ring_.last_used;
-    for (; i != cur_idx; ++i) {
-        // TRACEF("looking at idx %u\n", i);
-
-        struct vring_used_elem* used_elem = &ring_.used->ring[i & ring_.num_mask];
-        // TRACEF("used chain id %u, len %u\n", used_elem->id, used_elem->len);
-
-        // free the chain
-        free_chain(used_elem);
+    for (;;) {
+        // find a new free chain of descriptors
+        uint16_t cur_idx = ring_.used->idx;
+        hw_rmb();
+        uint16_t i = ring_.last_used;
+        for (; i != cur_idx; ++i) {
+            // TRACEF("looking at idx %u\n", i);
+
+            struct vring_used_elem* used_elem = &ring_.used->ring[i & ring_.num_mask];
+            // TRACEF("used chain id %u, len %u\n", used_elem->id, used_elem->len);
+
+            // free the chain
+            free_chain(used_elem);
+        }
+        ring_.last_used = i;
+
+        // With event indices, the device only interrupts once it uses the
+        // entry named by the driver. Ask for the next one, and collect the
+        // entries used in the meantime, which will not raise an interrupt.
+        if (!event_idx_ || !interrupts_) {
+            return;
+        }
+        vring_used_event(&ring_) = i;
+        hw_mb();
+        if (ring_.used->idx == i) {
+            return;
+        }
     }
-    ring_.last_used = i;
 }
 
 void virtio_dump_desc(const struct vring_desc* desc);
@@ -1055,6 +1055,11 @@ bool Client::CheckConfig(fidl::Builder* resp_builder) {
 void Client::ApplyConfig() {
     ZX_DEBUG_ASSERT(controller_->current_thread_is_loop());
 
+    // This picks up every image which is ready, so a deferred apply would be redundant.
+    if (fences_fired_task_.is_pending()) {
+        fences_fired_task_.Cancel();
+    }
+
     bool config_missing_image = false;
     layer_t* layers[layers_.size()];
     int layer_idx = 0;
@@ -1350,13 +1355,27 @@ fbl::RefPtr<FenceReference> Client::GetFence(uint64_t id) {
 }
 
 void Client::OnFenceFired(FenceReference* fence) {
+    bool image_ready = false;
     for (auto& layer: layers_) {
         image_node_t* waiting;
         list_for_every_entry(&layer.waiting_images_, waiting, image_node_t, link) {
-            waiting->self->OnFenceReady(fence);
+            image_ready |= waiting->self->OnFenceReady(fence);
         }
     }
-    ApplyConfig();
+    if (!image_ready || fences_fired_task_.is_pending()) {
+        return;
+    }
+    // Defer the apply, so that any other fences which have already fired get handled first.
+    if (fences_fired_task_.Post(controller_->loop().dispatcher()) != ZX_OK) {
+        ApplyConfig();
+    }
+}
+
+void Client::HandleFencesFired(async_dispatcher_t* dispatcher, async::TaskBase* task,
+                               zx_status_t status) {
+    if (status == ZX_OK) {
+        ApplyConfig();
+    }
 }
 
 void Client::OnRefForFenceDead(Fence* fence) {
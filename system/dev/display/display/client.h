@@ -232,6 +232,12 @@ private:
                              zx_status_t status, const zx_packet_signal_t* signal);
     async::WaitMethod<Client, &Client::HandleControllerApi> api_wait_{this};
 
+    // Applies the config on behalf of fences which have fired. Fences which fire together
+    // only cause a single apply.
+    void HandleFencesFired(async_dispatcher_t* dispatcher, async::TaskBase* task,
+                           zx_status_t status);
+    async::TaskMethod<Client, &Client::HandleFencesFired> fences_fired_task_{this};
+
     void NotifyDisplaysChanged(const int32_t* displays_added, uint32_t added_count,
                                const int32_t* displays_removed, uint32_t removed_count);
     bool CheckConfig(fidl::Builder* resp_builder);
@@ -34,10 +34,12 @@ void Image::PrepareFences(fbl::RefPtr<FenceReference>&& wait,
     }
 }
 
-void Image::OnFenceReady(FenceReference* fence) {
+bool Image::OnFenceReady(FenceReference* fence) {
     if (wait_fence_.get() == fence) {
         wait_fence_ = nullptr;
+        return true;
     }
+    return false;
 }
 
 void Image::StartPresent() {
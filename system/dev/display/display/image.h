@@ -45,8 +45,9 @@ public:
     // Called on vsync after StartRetire has been called.
     void OnRetire();
 
-    // Called on all waiting images when any fence fires.
-    void OnFenceReady(FenceReference* fence);
+    // Called on all waiting images when any fence fires. Returns true if |fence| was the
+    // fence this image was waiting on.
+    bool OnFenceReady(FenceReference* fence);
 
     // Called to reset fences when client releases the image. Releasing fences
     // is independent of the rest of the image lifecycle.
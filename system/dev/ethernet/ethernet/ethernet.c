@@ -18,6 +18,7 @@
 #include <zircon/types.h>
 
 #include <limits.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -31,6 +32,14 @@
 // This is used for signaling that eth_tx_thread() should exit.
 static const zx_signals_t kSignalFifoTerminate = ZX_USER_SIGNAL_0;
 
+// This is used for signaling that eth_tx_thread() should start or stop
+// watching the rx fifo for buffers to give to the device.
+static const zx_signals_t kSignalRxDma = ZX_USER_SIGNAL_1;
+
+// This is used for signaling that eth_tx_thread() should write the completed
+// tx entries collected by eth0_complete_tx() back to the tx fifo.
+static const zx_signals_t kSignalTxDone = ZX_USER_SIGNAL_2;
+
 // ensure that we will not exceed fifo capacity
 static_assert((FIFO_DEPTH * FIFO_ESIZE) <= 4096, "");
 
@@ -53,16 +62,28 @@ typedef struct ethdev0 {
     ethmac_info_t info;
     uint32_t status;
     zx_device_t* zxdev;
+
+    // With ETHMAC_FEATURE_RX_DMA, the instance whose rx buffers are given to
+    // the device. Frames received into them are copied to the other
+    // instances.
+    struct ethdev* rx_owner;
 } ethdev0_t;
 
 typedef struct tx_info {
-    struct ethdev* edev;
+    struct ethqueue* queue;
     uint64_t fifo_cookie;
     ethmac_netbuf_t netbuf;
+    // set once the device completes the transmission
+    zx_status_t status;
+    struct tx_info* done_next;
 } tx_info_t;
 
-// transmit thread has been created
-#define ETHDEV_TX_THREAD (1u)
+typedef struct rx_info {
+    struct ethdev* edev;
+    uint64_t fifo_cookie;
+    uint32_t offset;
+    ethmac_netbuf_t netbuf;
+} rx_info_t;
 
 // connected to the ethmac and handling traffic
 #define ETHDEV_RUNNING (2u)
@@ -94,6 +115,37 @@ typedef struct tx_info {
 //   zircon/system/utest/ethernet/ethernet.cpp
 #define MULTICAST_LIST_LIMIT (32)
 
+// a tx/rx fifo pair of an instance, and the thread transmitting from it;
+// queue 0 is the pair returned by GetFifos()
+typedef struct ethqueue {
+    struct ethdev* edev;
+    uint32_t index;
+
+    // fifos are named from the perspective
+    // of the packet from from the client
+    // to the network interface
+    zx_handle_t tx_fifo;
+    zx_handle_t rx_fifo;
+    zircon_ethernet_FifoEntry rx_entries[FIFO_BATCH_SZ];
+    size_t rx_entry_count;
+    // completed rx entries not yet written to the rx fifo
+    zircon_ethernet_FifoEntry rx_done[FIFO_BATCH_SZ];
+    size_t rx_done_count;
+
+    tx_info_t all_tx_bufs[FIFO_DEPTH];
+    mtx_t tx_lock;            // Protects free_tx_bufs
+    list_node_t free_tx_bufs; // tx_info_t elements
+    // tx buffers completed by the device, not yet written back to the tx fifo;
+    // pushed without locking by eth0_complete_tx() and taken all at once by
+    // eth_flush_tx_done()
+    _Atomic(tx_info_t*) tx_done;
+    atomic_uint tx_done_count;
+
+    // fifo thread
+    bool tx_thread;
+    thrd_t tx_thr;
+} ethqueue_t;
+
 // ethernet instance device
 typedef struct ethdev {
     list_node_t node;
@@ -103,15 +155,8 @@ typedef struct ethdev {
     uint32_t state;
     char name[zircon_ethernet_MAX_CLIENT_NAME_LEN+1];
 
-    // fifos are named from the perspective
-    // of the packet from from the client
-    // to the network interface
-    zx_handle_t tx_fifo;
-    uint32_t tx_depth;
-    zx_handle_t rx_fifo;
-    uint32_t rx_depth;
-    zircon_ethernet_FifoEntry rx_entries[FIFO_BATCH_SZ];
-    size_t rx_entry_count;
+    // allocated as the client obtains their fifos
+    ethqueue_t* queues[ETHMAC_MAX_QUEUES];
 
     // io buffer
     zx_handle_t io_vmo;
@@ -120,12 +165,13 @@ typedef struct ethdev {
     zx_paddr_t* paddr_map;
     zx_handle_t pmt;
 
-    tx_info_t all_tx_bufs[FIFO_DEPTH];
-    mtx_t lock;               // Protects free_tx_bufs
-    list_node_t free_tx_bufs; // tx_info_t elements
-
-    // fifo thread
-    thrd_t tx_thr;
+    // rx buffers given to the device, which are those of queue 0
+    rx_info_t all_rx_bufs[FIFO_DEPTH];
+    mtx_t lock;               // Protects free_rx_bufs and rx_dma
+    list_node_t free_rx_bufs; // rx_info_t elements
+    size_t free_rx_count;
+    // rx buffers are given to the device, see ethdev0_t.rx_owner
+    bool rx_dma;
 
     zx_device_t* zxdev;
 
@@ -255,13 +301,70 @@ static ssize_t eth_test_clear_multicast_promisc_locked(ethdev_t* edev) {
     return status;
 }
 
-static void eth_handle_rx(ethdev_t* edev, const void* data, size_t len, uint32_t extra) {
+static uint32_t eth_queue_count(ethdev0_t* edev0) {
+    return edev0->info.queue_count > 0 ? edev0->info.queue_count : 1;
+}
+
+// Returns the queue of |edev| receiving the frames the device steered to its
+// queue |index|. That is queue 0 unless the client obtained the fifos of
+// |index|.
+static ethqueue_t* eth_rx_queue(ethdev_t* edev, uint32_t index) {
+    if (index < ETHMAC_MAX_QUEUES && edev->queues[index] != NULL) {
+        return edev->queues[index];
+    }
+    return edev->queues[0];
+}
+
+// Writes the rx entries completed so far to the rx fifo.
+static void eth_rx_flush(ethqueue_t* q) {
+    if (q->rx_done_count == 0) {
+        return;
+    }
+    ethdev_t* edev = q->edev;
+    size_t count = q->rx_done_count;
+    q->rx_done_count = 0;
+
+    zx_status_t status;
+    size_t actual;
+    if ((status = zx_fifo_write(q->rx_fifo, sizeof(q->rx_done[0]), q->rx_done, count,
+                                &actual)) < 0) {
+        if (status == ZX_ERR_SHOULD_WAIT) {
+            if ((edev->fail_rx_write++ % FAIL_REPORT_RATE) == 0) {
+                zxlogf(ERROR, "eth [%s]: no rx_fifo space available (%u times)\n",
+                       edev->name, edev->fail_rx_write);
+            }
+        } else {
+            // Fatal, should force teardown
+            zxlogf(ERROR, "eth [%s]: rx_fifo write failed %d\n", edev->name, status);
+        }
+        return;
+    }
+    if (actual != count) {
+        if ((edev->fail_rx_write++ % FAIL_REPORT_RATE) == 0) {
+            zxlogf(ERROR, "eth [%s]: no rx_fifo space available (%u times)\n",
+                   edev->name, edev->fail_rx_write);
+        }
+    }
+}
+
+// Queues a completed rx entry for the client. Unless |more| frames are about
+// to follow, the entries are written to the rx fifo right away.
+static void eth_rx_report(ethqueue_t* q, const zircon_ethernet_FifoEntry* e, bool more) {
+    q->rx_done[q->rx_done_count++] = *e;
+    if (!more || q->rx_done_count == countof(q->rx_done)) {
+        eth_rx_flush(q);
+    }
+}
+
+static void eth_handle_rx(ethqueue_t* q, const void* data, size_t len, uint32_t extra,
+                          bool more) {
+    ethdev_t* edev = q->edev;
     zx_status_t status;
     size_t count;
 
-    if (edev->rx_entry_count == 0) {
-        status = zx_fifo_read(edev->rx_fifo, sizeof(edev->rx_entries[0]), edev->rx_entries,
-                              countof(edev->rx_entries), &count);
+    if (q->rx_entry_count == 0) {
+        status = zx_fifo_read(q->rx_fifo, sizeof(q->rx_entries[0]), q->rx_entries,
+                              countof(q->rx_entries), &count);
         if (status != ZX_OK) {
             if (status == ZX_ERR_SHOULD_WAIT) {
                 if ((edev->fail_rx_read++ % FAIL_REPORT_RATE) == 0) {
@@ -274,10 +377,10 @@ static void eth_handle_rx(ethdev_t* edev, const void* data, size_t len, uint32_t
             }
             return;
         }
-        edev->rx_entry_count = count;
+        q->rx_entry_count = count;
     }
 
-    zircon_ethernet_FifoEntry* e = &edev->rx_entries[--edev->rx_entry_count];
+    zircon_ethernet_FifoEntry* e = &q->rx_entries[--q->rx_entry_count];
     if ((e->offset >= edev->io_size) || ((e->length > (edev->io_size - e->offset)))) {
         // invalid offset/length. report error. drop packet
         e->length = 0;
@@ -292,18 +395,7 @@ static void eth_handle_rx(ethdev_t* edev, const void* data, size_t len, uint32_t
         e->flags = zircon_ethernet_FIFO_RX_OK | extra;
     }
 
-    if ((status = zx_fifo_write(edev->rx_fifo, sizeof(*e), e, 1, NULL)) < 0) {
-        if (status == ZX_ERR_SHOULD_WAIT) {
-            if ((edev->fail_rx_write++ % FAIL_REPORT_RATE) == 0) {
-                zxlogf(ERROR, "eth [%s]: no rx_fifo space available (%u times)\n",
-                       edev->name, edev->fail_rx_write);
-            }
-        } else {
-            // Fatal, should force teardown
-            zxlogf(ERROR, "eth [%s]: rx_fifo write failed %d\n", edev->name, status);
-        }
-        return;
-    }
+    eth_rx_report(q, e, more);
 }
 
 static void eth0_status(void* cookie, uint32_t status) {
@@ -318,16 +410,17 @@ static void eth0_status(void* cookie, uint32_t status) {
     static_assert(zircon_ethernet_SIGNAL_STATUS == ZX_USER_SIGNAL_0, "");
     ethdev_t* edev;
     list_for_every_entry(&edev0->list_active, edev, ethdev_t, node) {
-        zx_object_signal_peer(edev->rx_fifo, 0, zircon_ethernet_SIGNAL_STATUS);
+        zx_object_signal_peer(edev->queues[0]->rx_fifo, 0, zircon_ethernet_SIGNAL_STATUS);
     }
     mtx_unlock(&edev0->lock);
 }
 
-static int tx_fifo_write(ethdev_t* edev, zircon_ethernet_FifoEntry* entries, size_t count) {
+static int tx_fifo_write(ethqueue_t* q, zircon_ethernet_FifoEntry* entries, size_t count) {
+    ethdev_t* edev = q->edev;
     zx_status_t status;
     size_t actual;
     // Writing should never fail, or fail to write all entries
-    status = zx_fifo_write(edev->tx_fifo, sizeof(zircon_ethernet_FifoEntry), entries, count, &actual);
+    status = zx_fifo_write(q->tx_fifo, sizeof(zircon_ethernet_FifoEntry), entries, count, &actual);
     if (status < 0) {
         zxlogf(ERROR, "eth [%s]: tx_fifo write failed %d\n", edev->name, status);
         return -1;
@@ -343,61 +436,294 @@ static int tx_fifo_write(ethdev_t* edev, zircon_ethernet_FifoEntry* entries, siz
 // can deadlock with the ethermac device
 static void eth0_recv(void* cookie, void* data, size_t len, uint32_t flags) {
     ethdev0_t* edev0 = cookie;
+    bool more = flags & ETHMAC_RX_OPT_MORE;
+    uint32_t queue = ETHMAC_RX_QUEUE(flags);
+
+    uint32_t extra = (flags & ETHMAC_RX_OPT_CSUM_OK) ? zircon_ethernet_FIFO_RX_CSUM_OK : 0;
 
     ethdev_t* edev;
     mtx_lock(&edev0->lock);
     list_for_every_entry(&edev0->list_active, edev, ethdev_t, node) {
-        eth_handle_rx(edev, data, len, 0);
+        eth_handle_rx(eth_rx_queue(edev, queue), data, len, extra, more);
     }
     mtx_unlock(&edev0->lock);
 }
 
+static void eth_flush_tx_done(ethqueue_t* q);
+
 // Borrows a TX buffer from the pool. Logs and returns NULL if none is available
-static tx_info_t* eth_get_tx_info(ethdev_t* edev) {
-    mtx_lock(&edev->lock);
-    tx_info_t* tx_info = list_remove_head_type(&edev->free_tx_bufs, tx_info_t, netbuf.node);
-    mtx_unlock(&edev->lock);
+static tx_info_t* eth_get_tx_info(ethqueue_t* q) {
+    mtx_lock(&q->tx_lock);
+    tx_info_t* tx_info = list_remove_head_type(&q->free_tx_bufs, tx_info_t, netbuf.node);
+    mtx_unlock(&q->tx_lock);
+    if (tx_info == NULL) {
+        // Buffers still waiting to be written back are returned by the flush.
+        eth_flush_tx_done(q);
+        mtx_lock(&q->tx_lock);
+        tx_info = list_remove_head_type(&q->free_tx_bufs, tx_info_t, netbuf.node);
+        mtx_unlock(&q->tx_lock);
+    }
     if (tx_info == NULL) {
-        zxlogf(ERROR, "eth [%s]: tx_info pool empty\n", edev->name);
+        zxlogf(ERROR, "eth [%s]: tx_info pool empty\n", q->edev->name);
     }
     return tx_info;
 }
 
 // Returns a TX buffer to the pool
-static void eth_put_tx_info(ethdev_t* edev, tx_info_t* tx_info) {
-    mtx_lock(&edev->lock);
-    list_add_head(&edev->free_tx_bufs, &tx_info->netbuf.node);
-    mtx_unlock(&edev->lock);
+static void eth_put_tx_info(ethqueue_t* q, tx_info_t* tx_info) {
+    mtx_lock(&q->tx_lock);
+    list_add_head(&q->free_tx_bufs, &tx_info->netbuf.node);
+    mtx_unlock(&q->tx_lock);
+}
+
+// Writes the completed tx buffers back to the tx fifo, in batches, and returns
+// them to the pool under a single lock.
+static void eth_flush_tx_done(ethqueue_t* q) {
+    tx_info_t* done = atomic_exchange_explicit(&q->tx_done, NULL, memory_order_acquire);
+    if (done == NULL) {
+        return;
+    }
+    // The list is in reverse completion order.
+    tx_info_t* list = NULL;
+    unsigned count = 0;
+    while (done != NULL) {
+        tx_info_t* next = done->done_next;
+        done->done_next = list;
+        list = done;
+        done = next;
+        count++;
+    }
+    atomic_fetch_sub_explicit(&q->tx_done_count, count, memory_order_relaxed);
+
+    ethdev_t* edev = q->edev;
+    zircon_ethernet_FifoEntry entries[FIFO_BATCH_SZ];
+    size_t n = 0;
+    for (tx_info_t* tx_info = list; tx_info != NULL; tx_info = tx_info->done_next) {
+        ethmac_netbuf_t* netbuf = &tx_info->netbuf;
+        zircon_ethernet_FifoEntry* entry = &entries[n++];
+        entry->offset = netbuf->data - edev->io_buf;
+        entry->length = netbuf->len;
+        entry->flags = tx_info->status == ZX_OK ? zircon_ethernet_FIFO_TX_OK : 0;
+        entry->cookie = tx_info->fifo_cookie;
+        if (netbuf->flags & ETHMAC_NETBUF_TSO) {
+            // Report the entry as the client wrote it, offload struct included.
+            entry->offset -= sizeof(zircon_ethernet_TxOffload);
+            entry->length += sizeof(zircon_ethernet_TxOffload);
+        }
+        if (n == countof(entries)) {
+            tx_fifo_write(q, entries, n);
+            n = 0;
+        }
+    }
+    if (n > 0) {
+        tx_fifo_write(q, entries, n);
+    }
+
+    mtx_lock(&q->tx_lock);
+    while (list != NULL) {
+        tx_info_t* next = list->done_next;
+        list_add_head(&q->free_tx_bufs, &list->netbuf.node);
+        list = next;
+    }
+    mtx_unlock(&q->tx_lock);
 }
 
 static void eth0_complete_tx(void* cookie, ethmac_netbuf_t* netbuf, zx_status_t status) {
     tx_info_t* tx_info = containerof(netbuf, tx_info_t, netbuf);
-    ethdev_t* edev = tx_info->edev;
-    zircon_ethernet_FifoEntry entry = {.offset = netbuf->data - edev->io_buf,
-                              .length = netbuf->len,
-                              .flags = status == ZX_OK ? zircon_ethernet_FIFO_TX_OK : 0,
-                              .cookie = tx_info->fifo_cookie};
-
-    // Now that we've copied all pertinent data from the netbuf, return it to the free list so
-    // it is avaialble immediately for the next request.
-    eth_put_tx_info(edev, tx_info);
-
-    // Send the entry back to the client
-    tx_fifo_write(edev, &entry, 1);
+    ethqueue_t* q = tx_info->queue;
+    tx_info->status = status;
+
+    // Counted before it is pushed, so that the count never falls below the
+    // length of the list.
+    unsigned pending =
+        atomic_fetch_add_explicit(&q->tx_done_count, 1, memory_order_relaxed) + 1;
+    tx_info_t* head = atomic_load_explicit(&q->tx_done, memory_order_relaxed);
+    do {
+        tx_info->done_next = head;
+    } while (!atomic_compare_exchange_weak_explicit(&q->tx_done, &head, tx_info,
+                                                    memory_order_release,
+                                                    memory_order_relaxed));
+
+    // A burst of completions is written back by the tx thread with a single
+    // fifo write, and a long one is written back here every FIFO_BATCH_SZ
+    // entries, so entries never wait for more than a wakeup.
+    if (pending >= FIFO_BATCH_SZ) {
+        eth_flush_tx_done(q);
+    } else if (head == NULL) {
+        zx_object_signal(q->tx_fifo, 0, kSignalTxDone);
+    }
+}
+
+// Gives the empty buffers the client has queued in the rx fifo to the device,
+// for as long as the device has room for them and |edev| owns the device's rx
+// buffers.
+static void eth_rx_refill(ethdev_t* edev) {
+    ethdev0_t* edev0 = edev->edev0;
+    ethqueue_t* q = edev->queues[0];
+    zircon_ethernet_FifoEntry entries[FIFO_BATCH_SZ];
+    zircon_ethernet_FifoEntry rejected[FIFO_BATCH_SZ];
+
+    mtx_lock(&edev->lock);
+    while (edev->rx_dma && edev->free_rx_count > 0) {
+        size_t count;
+        size_t batch = edev->free_rx_count < countof(entries) ? edev->free_rx_count
+                                                              : countof(entries);
+        if (zx_fifo_read(q->rx_fifo, sizeof(entries[0]), entries, batch, &count) != ZX_OK) {
+            break;
+        }
+
+        size_t rejected_count = 0;
+        for (size_t i = 0; i < count; i++) {
+            zircon_ethernet_FifoEntry* e = &entries[i];
+            if (!edev->rx_dma || (e->offset >= edev->io_size) ||
+                (e->length > (edev->io_size - e->offset)) || (e->length == 0)) {
+                e->length = 0;
+                e->flags = zircon_ethernet_FIFO_INVALID;
+                rejected[rejected_count++] = *e;
+                continue;
+            }
+
+            // The device is given the part of the buffer which is physically
+            // contiguous.
+            size_t page = e->offset / PAGE_SIZE;
+            size_t len = PAGE_SIZE - (e->offset & PAGE_MASK);
+            while (len < e->length &&
+                   edev->paddr_map[page + 1] == edev->paddr_map[page] + PAGE_SIZE) {
+                page++;
+                len += PAGE_SIZE;
+            }
+
+            rx_info_t* rx_info = list_remove_head_type(&edev->free_rx_bufs, rx_info_t,
+                                                       netbuf.node);
+            edev->free_rx_count--;
+            rx_info->fifo_cookie = e->cookie;
+            rx_info->offset = e->offset;
+            rx_info->netbuf.data = edev->io_buf + e->offset;
+            rx_info->netbuf.phys = edev->paddr_map[e->offset / PAGE_SIZE] +
+                                   (e->offset & PAGE_MASK);
+            rx_info->netbuf.len = len < e->length ? len : e->length;
+            rx_info->netbuf.flags = 0;
+            zx_status_t status = edev0->mac.ops->queue_rx(edev0->mac.ctx, &rx_info->netbuf);
+            if (status != ZX_OK) {
+                // Fall back to copying frames into the buffers of this client.
+                zxlogf(ERROR, "eth [%s]: device refused rx buffer: %d\n", edev->name, status);
+                edev->rx_dma = false;
+                list_add_head(&edev->free_rx_bufs, &rx_info->netbuf.node);
+                edev->free_rx_count++;
+                e->length = 0;
+                e->flags = zircon_ethernet_FIFO_INVALID;
+                rejected[rejected_count++] = *e;
+            }
+        }
+        if (rejected_count > 0) {
+            zx_fifo_write(q->rx_fifo, sizeof(rejected[0]), rejected, rejected_count, NULL);
+        }
+    }
+    mtx_unlock(&edev->lock);
+}
+
+static void eth0_complete_rx(void* cookie, uint32_t options, ethmac_netbuf_t* netbuf,
+                             zx_status_t status) {
+    ethdev0_t* edev0 = cookie;
+    rx_info_t* rx_info = containerof(netbuf, rx_info_t, netbuf);
+    ethdev_t* edev = rx_info->edev;
+    bool more = options & ETHMAC_RX_OPT_MORE;
+    uint32_t queue = ETHMAC_RX_QUEUE(options);
+    uint32_t extra = (options & ETHMAC_RX_OPT_CSUM_OK) ? zircon_ethernet_FIFO_RX_CSUM_OK : 0;
+    // Cancelled buffers go back to the client empty, so it can reuse them.
+    zircon_ethernet_FifoEntry entry = {.offset = rx_info->offset,
+                              .length = status == ZX_OK ? netbuf->len : 0,
+                              .flags = status == ZX_OK ? zircon_ethernet_FIFO_RX_OK | extra : 0,
+                              .cookie = rx_info->fifo_cookie};
+
+    mtx_lock(&edev->lock);
+    list_add_head(&edev->free_rx_bufs, &rx_info->netbuf.node);
+    edev->free_rx_count++;
+    mtx_unlock(&edev->lock);
+
+    mtx_lock(&edev0->lock);
+    if (status == ZX_OK) {
+        ethdev_t* edev_i;
+        list_for_every_entry(&edev0->list_active, edev_i, ethdev_t, node) {
+            if (edev_i != edev) {
+                eth_handle_rx(eth_rx_queue(edev_i, queue), edev->io_buf + entry.offset,
+                              entry.length, extra, more);
+            }
+        }
+    }
+    eth_rx_report(edev->queues[0], &entry, more);
+    if (status == ZX_OK) {
+        eth_rx_refill(edev);
+    }
+    mtx_unlock(&edev0->lock);
 }
 
 static ethmac_ifc_t ethmac_ifc = {
     .status = eth0_status,
     .recv = eth0_recv,
     .complete_tx = eth0_complete_tx,
+    .complete_rx = eth0_complete_rx,
 };
 
-static void eth_tx_echo(ethdev0_t* edev0, const void* data, size_t len) {
+// Makes |edev| the instance whose rx buffers are given to the device, if the
+// device supports it and none has been picked.
+static void eth_rx_dma_claim_locked(ethdev_t* edev) {
+    ethdev0_t* edev0 = edev->edev0;
+    if (!(edev0->info.features & ETHMAC_FEATURE_RX_DMA) || edev0->rx_owner != NULL ||
+        edev->paddr_map == NULL || (edev->state & ETHDEV_DEAD)) {
+        return;
+    }
+    edev0->rx_owner = edev;
+
+    mtx_lock(&edev->lock);
+    edev->rx_dma = true;
+    mtx_unlock(&edev->lock);
+    zx_object_signal(edev->queues[0]->tx_fifo, 0, kSignalRxDma);
+    eth_rx_refill(edev);
+}
+
+// Takes back the buffers of |edev|, the rx owner, from the device, and hands
+// the role to another running instance. The device has to be restarted for
+// its buffers to be returned.
+static void eth_rx_dma_release_locked(ethdev_t* edev) TA_NO_THREAD_SAFETY_ANALYSIS {
+    ethdev0_t* edev0 = edev->edev0;
+    edev0->rx_owner = NULL;
+
+    mtx_lock(&edev->lock);
+    edev->rx_dma = false;
+    mtx_unlock(&edev->lock);
+    zx_object_signal(edev->queues[0]->tx_fifo, 0, kSignalRxDma);
+
+    // Release the lock to allow other device operations in callback routine.
+    // Re-acquire lock afterwards. Set busy to prevent problems with other ioctls.
+    bool restart = !list_is_empty(&edev0->list_active);
+    edev0->state |= ETHDEV0_BUSY;
+    mtx_unlock(&edev0->lock);
+    edev0->mac.ops->stop(edev0->mac.ctx);
+    zx_status_t status = restart ? edev0->mac.ops->start(edev0->mac.ctx, &ethmac_ifc, edev0)
+                                 : ZX_OK;
+    mtx_lock(&edev0->lock);
+    edev0->state &= ~ETHDEV0_BUSY;
+    eth_rx_flush(edev->queues[0]);
+
+    if (status != ZX_OK) {
+        zxlogf(ERROR, "eth [%s]: failed to restart mac: %d\n", edev->name, status);
+        return;
+    }
+    ethdev_t* edev_i;
+    list_for_every_entry(&edev0->list_active, edev_i, ethdev_t, node) {
+        if (edev_i != edev) {
+            eth_rx_dma_claim_locked(edev_i);
+        }
+    }
+}
+
+static void eth_tx_echo(ethdev0_t* edev0, const void* data, size_t len, uint32_t extra) {
     ethdev_t* edev;
     mtx_lock(&edev0->lock);
     list_for_every_entry(&edev0->list_active, edev, ethdev_t, node) {
         if (edev->state & ETHDEV_TX_LISTEN) {
-            eth_handle_rx(edev, data, len, zircon_ethernet_FIFO_RX_TX);
+            eth_handle_rx(edev->queues[0], data, len, zircon_ethernet_FIFO_RX_TX | extra, false);
         }
     }
     mtx_unlock(&edev0->lock);
@@ -433,9 +759,102 @@ static zx_status_t eth_tx_listen_locked(ethdev_t* edev, bool yes) {
     return ZX_OK;
 }
 
+// Points |netbuf| at the frame of the tx entry |e|, and fills in the offloads
+// requested in its flags. Offloads the device does not support, or packets
+// they cannot be applied to, are rejected.
+static zx_status_t eth_tx_prepare(ethdev_t* edev, const zircon_ethernet_FifoEntry* e,
+                                  ethmac_netbuf_t* netbuf) {
+    uint32_t features = edev->edev0->info.features;
+    uint32_t offset = e->offset;
+    size_t len = e->length;
+
+    netbuf->flags = 0;
+    if (e->flags & zircon_ethernet_FIFO_TX_TSO) {
+        zircon_ethernet_TxOffload offload;
+        if (!(features & ETHMAC_FEATURE_TSO) || len < sizeof(offload)) {
+            return ZX_ERR_NOT_SUPPORTED;
+        }
+        memcpy(&offload, edev->io_buf + offset, sizeof(offload));
+        if (offload.mss == 0) {
+            return ZX_ERR_INVALID_ARGS;
+        }
+        offset += sizeof(offload);
+        len -= sizeof(offload);
+        netbuf->flags = ETHMAC_NETBUF_TSO | ETHMAC_NETBUF_CSUM;
+        netbuf->mss = offload.mss;
+    } else if (e->flags & zircon_ethernet_FIFO_TX_CSUM) {
+        if (!(features & ETHMAC_FEATURE_TX_CSUM)) {
+            return ZX_ERR_NOT_SUPPORTED;
+        }
+        netbuf->flags = ETHMAC_NETBUF_CSUM;
+    }
+
+    netbuf->data = edev->io_buf + offset;
+    if (features & ETHMAC_FEATURE_DMA) {
+        netbuf->phys = edev->paddr_map[offset / PAGE_SIZE] + (offset & PAGE_MASK);
+    }
+    netbuf->len = len;
+    if (netbuf->flags == 0) {
+        return ZX_OK;
+    }
+
+    // Find the TCP or UDP header, behind the ethernet header, an optional
+    // 802.1Q tag, and an IPv4 header or an IPv6 header without extensions.
+    const uint8_t* frame = netbuf->data;
+    size_t l3 = 14;
+    if (len < l3) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+    uint16_t ethertype = (frame[12] << 8) | frame[13];
+    if (ethertype == 0x8100) {
+        l3 = 18;
+        if (len < l3) {
+            return ZX_ERR_INVALID_ARGS;
+        }
+        ethertype = (frame[16] << 8) | frame[17];
+    }
+    uint8_t protocol;
+    size_t l4;
+    if (ethertype == 0x0800) {
+        if (len < l3 + 20 || (frame[l3] & 0xf) < 5) {
+            return ZX_ERR_INVALID_ARGS;
+        }
+        protocol = frame[l3 + 9];
+        l4 = l3 + (frame[l3] & 0xf) * 4;
+    } else if (ethertype == 0x86dd) {
+        if (len < l3 + 40) {
+            return ZX_ERR_INVALID_ARGS;
+        }
+        protocol = frame[l3 + 6];
+        l4 = l3 + 40;
+        netbuf->flags |= ETHMAC_NETBUF_IPV6;
+    } else {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    if (protocol == 6) {
+        if (len < l4 + 20 || (frame[l4 + 12] >> 4) < 5) {
+            return ZX_ERR_INVALID_ARGS;
+        }
+        netbuf->csum_offset = 16;
+        netbuf->hdr_len = l4 + (frame[l4 + 12] >> 4) * 4;
+    } else if (protocol == 17 && !(netbuf->flags & ETHMAC_NETBUF_TSO)) {
+        netbuf->csum_offset = 6;
+        netbuf->hdr_len = l4 + 8;
+    } else {
+        return ZX_ERR_INVALID_ARGS;
+    }
+    if (len < netbuf->hdr_len) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+    netbuf->csum_start = l4;
+    return ZX_OK;
+}
+
 // The array of entries is invalidated after the call
-static int eth_send(ethdev_t* edev, zircon_ethernet_FifoEntry* entries, uint32_t count) {
+static int eth_send(ethqueue_t* q, zircon_ethernet_FifoEntry* entries, uint32_t count) {
     tx_info_t* tx_info = NULL;
+    ethdev_t* edev = q->edev;
     ethdev0_t* edev0 = edev->edev0;
     // The entries that we can't send back to the fifo immediately are filtered
     // out in-place using a classic algorithm a-la "std::remove_if".
@@ -450,25 +869,33 @@ static int eth_send(ethdev_t* edev, zircon_ethernet_FifoEntry* entries, uint32_t
         } else {
             zx_status_t status;
             if (tx_info == NULL) {
-                tx_info = eth_get_tx_info(edev);
+                tx_info = eth_get_tx_info(q);
                 if (tx_info == NULL) {
                     return -1;
                 }
             }
+            if (eth_tx_prepare(edev, e, &tx_info->netbuf) != ZX_OK) {
+                e->flags = zircon_ethernet_FIFO_INVALID;
+                entries[to_write++] = *e;
+                count--;
+                continue;
+            }
             uint32_t opts = count > 1 ? ETHMAC_TX_OPT_MORE : 0u;
             if (opts) {
                 zxlogf(SPEW, "setting OPT_MORE (%u packets to go)\n", count);
             }
-            tx_info->netbuf.data = edev->io_buf + e->offset;
-            if (edev0->info.features & ETHMAC_FEATURE_DMA) {
-                tx_info->netbuf.phys = edev->paddr_map[e->offset / PAGE_SIZE] +
-                                       (e->offset & PAGE_MASK);
-            }
-            tx_info->netbuf.len = e->length;
+            // The netbuf belongs to the device once queued.
+            void* data = tx_info->netbuf.data;
+            size_t len = tx_info->netbuf.len;
+            // Checksums left to the device are as good as verified for
+            // listeners.
+            uint32_t extra = (tx_info->netbuf.flags & ETHMAC_NETBUF_CSUM)
+                                 ? zircon_ethernet_FIFO_RX_CSUM_OK : 0;
             tx_info->fifo_cookie = e->cookie;
+            opts |= ETHMAC_TX_OPT_QUEUE(q->index);
             status = edev0->mac.ops->queue_tx(edev0->mac.ctx, opts, &tx_info->netbuf);
             if (edev->state & ETHDEV_TX_LOOPBACK) {
-                eth_tx_echo(edev0, edev->io_buf + e->offset, e->length);
+                eth_tx_echo(edev0, data, len, extra);
             }
             if (status != ZX_ERR_SHOULD_WAIT) {
                 // Transmission completed. To avoid extra mutex locking/unlocking,
@@ -485,67 +912,137 @@ static int eth_send(ethdev_t* edev, zircon_ethernet_FifoEntry* entries, uint32_t
         count--;
     }
     if (tx_info) {
-        eth_put_tx_info(edev, tx_info);
+        eth_put_tx_info(q, tx_info);
     }
     if (to_write) {
-        tx_fifo_write(edev, entries, to_write);
+        tx_fifo_write(q, entries, to_write);
     }
     return 0;
 }
 
 static int eth_tx_thread(void* arg) {
-    ethdev_t* edev = (ethdev_t*)arg;
+    ethqueue_t* q = (ethqueue_t*)arg;
+    ethdev_t* edev = q->edev;
     zircon_ethernet_FifoEntry entries[FIFO_DEPTH / 2];
     zx_status_t status;
     size_t count;
 
     for (;;) {
-        if ((status = zx_fifo_read(edev->tx_fifo, sizeof(entries[0]), entries,
+        eth_flush_tx_done(q);
+        if ((status = zx_fifo_read(q->tx_fifo, sizeof(entries[0]), entries,
                                    countof(entries), &count)) < 0) {
             if (status == ZX_ERR_SHOULD_WAIT) {
-                zx_signals_t observed;
-                if ((status = zx_object_wait_one(edev->tx_fifo,
-                                                 ZX_FIFO_READABLE |
-                                                 ZX_FIFO_PEER_CLOSED |
-                                                 kSignalFifoTerminate,
-                                                 ZX_TIME_INFINITE,
-                                                 &observed)) < 0) {
+                // While the device takes our rx buffers, also wait for the
+                // client to queue more of them, as long as the device has
+                // room for them.
+                bool rx_refill = false;
+                if (q->index == 0) {
+                    mtx_lock(&edev->lock);
+                    rx_refill = edev->rx_dma && edev->free_rx_count > 0;
+                    mtx_unlock(&edev->lock);
+                }
+                zx_wait_item_t items[] = {
+                    {.handle = q->tx_fifo,
+                     .waitfor = ZX_FIFO_READABLE | ZX_FIFO_PEER_CLOSED |
+                                kSignalFifoTerminate | kSignalRxDma | kSignalTxDone},
+                    {.handle = q->rx_fifo, .waitfor = ZX_FIFO_READABLE},
+                };
+                if ((status = zx_object_wait_many(items, rx_refill ? 2 : 1,
+                                                  ZX_TIME_INFINITE)) < 0) {
                     zxlogf(ERROR, "eth [%s]: tx_fifo: error waiting: %d\n", edev->name, status);
                     break;
                 }
-                if (observed & kSignalFifoTerminate)
+                if (items[0].pending & kSignalFifoTerminate)
                     break;
+                if (items[0].pending & kSignalRxDma) {
+                    zx_object_signal(q->tx_fifo, kSignalRxDma, 0);
+                }
+                if (items[0].pending & kSignalTxDone) {
+                    // Cleared before the flush at the top of the loop, so a
+                    // completion pushed after it signals again.
+                    zx_object_signal(q->tx_fifo, kSignalTxDone, 0);
+                }
+                if (rx_refill && (items[1].pending & ZX_FIFO_READABLE)) {
+                    eth_rx_refill(edev);
+                }
                 continue;
             } else {
                 zxlogf(ERROR, "eth [%s]: tx_fifo: cannot read: %d\n", edev->name, status);
                 break;
             }
         }
-        if (eth_send(edev, entries, count)) {
+        if (eth_send(q, entries, count)) {
             break;
         }
     }
 
-    zxlogf(INFO, "eth [%s]: tx_thread: exit: %d\n", edev->name, status);
+    zxlogf(INFO, "eth [%s]: tx_thread %u: exit: %d\n", edev->name, q->index, status);
     return 0;
 }
 
-static zx_status_t eth_get_fifos_locked(ethdev_t* edev, struct zircon_ethernet_Fifos* fifos) {
+static zx_status_t eth_start_queue_locked(ethqueue_t* q) {
+    if (q->tx_thread) {
+        return ZX_OK;
+    }
+    int r = thrd_create_with_name(&q->tx_thr, eth_tx_thread, q, "eth-tx-thread");
+    if (r != thrd_success) {
+        zxlogf(ERROR, "eth [%s]: failed to start tx thread: %d\n", q->edev->name, r);
+        return ZX_ERR_INTERNAL;
+    }
+    q->tx_thread = true;
+    return ZX_OK;
+}
+
+static zx_status_t eth_get_fifos_locked(ethdev_t* edev, uint32_t index,
+                                        struct zircon_ethernet_Fifos* fifos) {
+    if (index >= eth_queue_count(edev->edev0)) {
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+    if (edev->state & ETHDEV_DEAD) {
+        return ZX_ERR_BAD_STATE;
+    }
+    if (edev->queues[index] != NULL) {
+        return ZX_ERR_ALREADY_BOUND;
+    }
+
+    ethqueue_t* q = calloc(1, sizeof(ethqueue_t));
+    if (q == NULL) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    q->edev = edev;
+    q->index = index;
+    list_initialize(&q->free_tx_bufs);
+    for (size_t ndx = 0; ndx < FIFO_DEPTH; ndx++) {
+        q->all_tx_bufs[ndx].queue = q;
+        list_add_tail(&q->free_tx_bufs, &q->all_tx_bufs[ndx].netbuf.node);
+    }
+    mtx_init(&q->tx_lock, mtx_plain);
+
     zx_status_t status;
-    if ((status = zx_fifo_create(FIFO_DEPTH, FIFO_ESIZE, 0, &fifos->tx, &edev->tx_fifo)) < 0) {
+    if ((status = zx_fifo_create(FIFO_DEPTH, FIFO_ESIZE, 0, &fifos->tx, &q->tx_fifo)) < 0) {
         zxlogf(ERROR, "eth_create  [%s]: failed to create tx fifo: %d\n", edev->name, status);
+        free(q);
         return status;
     }
-    if ((status = zx_fifo_create(FIFO_DEPTH, FIFO_ESIZE, 0, &fifos->rx, &edev->rx_fifo)) < 0) {
+    if ((status = zx_fifo_create(FIFO_DEPTH, FIFO_ESIZE, 0, &fifos->rx, &q->rx_fifo)) < 0) {
         zxlogf(ERROR, "eth_create  [%s]: failed to create rx fifo: %d\n", edev->name, status);
         zx_handle_close(fifos->tx);
-        zx_handle_close(edev->tx_fifo);
-        edev->tx_fifo = ZX_HANDLE_INVALID;
+        zx_handle_close(q->tx_fifo);
+        free(q);
+        return status;
+    }
+
+    // Fifos of a running instance are served right away.
+    if ((edev->state & ETHDEV_RUNNING) && (status = eth_start_queue_locked(q)) != ZX_OK) {
+        zx_handle_close(fifos->tx);
+        zx_handle_close(fifos->rx);
+        zx_handle_close(q->tx_fifo);
+        zx_handle_close(q->rx_fifo);
+        free(q);
         return status;
     }
+    edev->queues[index] = q;
 
-    edev->tx_depth = FIFO_DEPTH;
-    edev->rx_depth = FIFO_DEPTH;
     fifos->tx_depth = FIFO_DEPTH;
     fifos->rx_depth = FIFO_DEPTH;
 
@@ -618,9 +1115,7 @@ static zx_status_t eth_start_locked(ethdev_t* edev) TA_NO_THREAD_SAFETY_ANALYSIS
     ethdev0_t* edev0 = edev->edev0;
 
     // Cannot start unless tx/rx rings are configured
-    if ((edev->io_vmo == ZX_HANDLE_INVALID) ||
-        (edev->tx_fifo == ZX_HANDLE_INVALID) ||
-        (edev->rx_fifo == ZX_HANDLE_INVALID)) {
+    if ((edev->io_vmo == ZX_HANDLE_INVALID) || (edev->queues[0] == NULL)) {
         return ZX_ERR_BAD_STATE;
     }
 
@@ -628,17 +1123,16 @@ static zx_status_t eth_start_locked(ethdev_t* edev) TA_NO_THREAD_SAFETY_ANALYSIS
         return ZX_OK;
     }
 
-    if (!(edev->state & ETHDEV_TX_THREAD)) {
-        int r = thrd_create_with_name(&edev->tx_thr, eth_tx_thread,
-                                      edev, "eth-tx-thread");
-        if (r != thrd_success) {
-            zxlogf(ERROR, "eth [%s]: failed to start tx thread: %d\n", edev->name, r);
-            return ZX_ERR_INTERNAL;
+    zx_status_t status;
+    for (uint32_t i = 0; i < ETHMAC_MAX_QUEUES; i++) {
+        if (edev->queues[i] == NULL) {
+            continue;
+        }
+        if ((status = eth_start_queue_locked(edev->queues[i])) != ZX_OK) {
+            return status;
         }
-        edev->state |= ETHDEV_TX_THREAD;
     }
 
-    zx_status_t status;
     if (list_is_empty(&edev0->list_active)) {
         // Release the lock to allow other device operations in callback routine.
         // Re-acquire lock afterwards. Set busy to prevent problems with other ioctls.
@@ -657,6 +1151,7 @@ static zx_status_t eth_start_locked(ethdev_t* edev) TA_NO_THREAD_SAFETY_ANALYSIS
         list_add_tail(&edev0->list_active, &edev->node);
         // TODO - After we get IGMP, don't automatically set multicast promisc true
         eth_set_multicast_promisc_locked(edev, true);
+        eth_rx_dma_claim_locked(edev);
     } else {
         zxlogf(ERROR, "eth [%s]: failed to start mac: %d\n", edev->name, status);
     }
@@ -679,7 +1174,15 @@ static zx_status_t eth_stop_locked(ethdev_t* edev) TA_NO_THREAD_SAFETY_ANALYSIS
         eth_set_promisc_locked(edev, false);
         eth_set_multicast_promisc_locked(edev, false);
         eth_rebuild_multicast_filter_locked(edev);
-        if (list_is_empty(&edev0->list_active)) {
+        for (uint32_t i = 0; i < ETHMAC_MAX_QUEUES; i++) {
+            if (edev->queues[i] != NULL) {
+                eth_rx_flush(edev->queues[i]);
+            }
+        }
+        if (edev0->rx_owner == edev) {
+            // Stops the mac, and restarts it if other instances are running.
+            eth_rx_dma_release_locked(edev);
+        } else if (list_is_empty(&edev0->list_active)) {
             if (!(edev->state & ETHDEV_DEAD)) {
                 // Release the lock to allow other device operations in callback routine.
                 // Re-acquire lock afterwards. Set busy to prevent problems with other ioctls.
@@ -709,10 +1212,11 @@ static zx_status_t eth_get_status_locked(ethdev_t* edev, void* out_buf, size_t o
     if (out_len < sizeof(uint32_t)) {
         return ZX_ERR_INVALID_ARGS;
     }
-    if (edev->rx_fifo == ZX_HANDLE_INVALID) {
+    if (edev->queues[0] == NULL || edev->queues[0]->rx_fifo == ZX_HANDLE_INVALID) {
         return ZX_ERR_BAD_STATE;
     }
-    if (zx_object_signal_peer(edev->rx_fifo, zircon_ethernet_SIGNAL_STATUS, 0) != ZX_OK) {
+    if (zx_object_signal_peer(edev->queues[0]->rx_fifo, zircon_ethernet_SIGNAL_STATUS,
+                              0) != ZX_OK) {
         return ZX_ERR_INTERNAL;
     }
 
@@ -735,6 +1239,15 @@ static zx_status_t fidl_GetInfo_locked(void* ctx, fidl_txn_t* txn) {
     if (edev->edev0->info.features & ETHMAC_FEATURE_SYNTH) {
         info.features |= zircon_ethernet_INFO_FEATURE_SYNTH;
     }
+    if (edev->edev0->info.features & ETHMAC_FEATURE_TX_CSUM) {
+        info.features |= zircon_ethernet_INFO_FEATURE_TX_CSUM;
+    }
+    if (edev->edev0->info.features & ETHMAC_FEATURE_RX_CSUM) {
+        info.features |= zircon_ethernet_INFO_FEATURE_RX_CSUM;
+    }
+    if (edev->edev0->info.features & ETHMAC_FEATURE_TSO) {
+        info.features |= zircon_ethernet_INFO_FEATURE_TSO;
+    }
     info.mtu = edev->edev0->info.mtu;
     return REPLY(GetInfo)(txn, &info);
 }
@@ -742,7 +1255,7 @@ static zx_status_t fidl_GetInfo_locked(void* ctx, fidl_txn_t* txn) {
 static zx_status_t fidl_GetFifos_locked(void* ctx, fidl_txn_t* txn) {
     ethdev_t* edev = ctx;
     zircon_ethernet_Fifos fifos;
-    return REPLY(GetFifos)(txn, eth_get_fifos_locked(edev, &fifos), &fifos);
+    return REPLY(GetFifos)(txn, eth_get_fifos_locked(edev, 0, &fifos), &fifos);
 }
 
 static zx_status_t fidl_SetIOBuffer_locked(void* ctx, zx_handle_t h, fidl_txn_t* txn) {
@@ -780,7 +1293,9 @@ static zx_status_t fidl_SetClientName_locked(void* ctx, const char* buf, size_t
 
 static zx_status_t fidl_GetStatus_locked(void* ctx, fidl_txn_t* txn) {
     ethdev_t* edev = ctx;
-    if (zx_object_signal_peer(edev->rx_fifo, zircon_ethernet_SIGNAL_STATUS, 0) != ZX_OK) {
+    if (edev->queues[0] == NULL ||
+        zx_object_signal_peer(edev->queues[0]->rx_fifo, zircon_ethernet_SIGNAL_STATUS,
+                              0) != ZX_OK) {
         return ZX_ERR_INTERNAL;
     }
     return REPLY(GetStatus)(txn, edev->edev0->status);
@@ -829,6 +1344,46 @@ static zx_status_t fidl_DumpRegisters_locked(void* ctx, fidl_txn_t* txn) {
     return REPLY(DumpRegisters)(txn, status);
 }
 
+static zx_status_t fidl_GetQueueCount_locked(void* ctx, fidl_txn_t* txn) {
+    ethdev_t* edev = ctx;
+    return REPLY(GetQueueCount)(txn, eth_queue_count(edev->edev0));
+}
+
+static zx_status_t fidl_GetQueueFifos_locked(void* ctx, uint32_t queue, fidl_txn_t* txn) {
+    ethdev_t* edev = ctx;
+    zircon_ethernet_Fifos fifos;
+    zx_status_t status = eth_get_fifos_locked(edev, queue, &fifos);
+    return REPLY(GetQueueFifos)(txn, status, status == ZX_OK ? &fifos : NULL);
+}
+
+static zx_status_t fidl_ConfigRss_locked(void* ctx, const zircon_ethernet_RssConfig* config,
+                                         fidl_txn_t* txn) {
+    ethdev_t* edev = ctx;
+    ethdev0_t* edev0 = edev->edev0;
+    static_assert(zircon_ethernet_RSS_HASH_IPV4 == ETHMAC_RSS_HASH_IPV4, "");
+    static_assert(zircon_ethernet_RSS_HASH_TCP_IPV4 == ETHMAC_RSS_HASH_TCP_IPV4, "");
+    static_assert(zircon_ethernet_RSS_HASH_IPV6 == ETHMAC_RSS_HASH_IPV6, "");
+    static_assert(zircon_ethernet_RSS_HASH_TCP_IPV6 == ETHMAC_RSS_HASH_TCP_IPV6, "");
+    static_assert(sizeof(config->key) == ETHMAC_RSS_KEY_SIZE, "");
+    static_assert(sizeof(config->table) == ETHMAC_RSS_TABLE_SIZE, "");
+
+    ethmac_rss_config_t rss;
+    rss.hash_types = config->hash_types;
+    memcpy(rss.key, config->key, sizeof(rss.key));
+    memcpy(rss.table, config->table, sizeof(rss.table));
+
+    zx_status_t status = ZX_OK;
+    for (size_t i = 0; i < countof(rss.table); i++) {
+        if (rss.table[i] >= eth_queue_count(edev0)) {
+            status = ZX_ERR_INVALID_ARGS;
+        }
+    }
+    if (status == ZX_OK) {
+        status = edev0->mac.ops->set_param(edev0->mac.ctx, ETHMAC_SETPARAM_RSS, 0, &rss);
+    }
+    return REPLY(ConfigRss)(txn, status);
+}
+
 #undef REPLY
 
 zircon_ethernet_Device_ops_t fidl_ops = {
@@ -847,6 +1402,9 @@ zircon_ethernet_Device_ops_t fidl_ops = {
     .ConfigMulticastSetPromiscuousMode = fidl_ConfigMulticastSetPromiscuousMode_locked,
     .ConfigMulticastTestFilter = fidl_ConfigMulticastTestFilter_locked,
     .DumpRegisters = fidl_DumpRegisters_locked,
+    .GetQueueCount = fidl_GetQueueCount_locked,
+    .GetQueueFifos = fidl_GetQueueFifos_locked,
+    .ConfigRss = fidl_ConfigRss_locked,
 };
 
 static zx_status_t eth_message(void* ctx, fidl_msg_t* msg, fidl_txn_t* txn) {
@@ -865,37 +1423,52 @@ static void eth_kill_locked(ethdev_t* edev) {
         return;
     }
 
-    zxlogf(TRACE, "eth [%s]: kill: tearing down%s\n",
-           edev->name, (edev->state & ETHDEV_TX_THREAD) ? " tx thread" : "");
+    zxlogf(TRACE, "eth [%s]: kill: tearing down\n", edev->name);
     eth_set_promisc_locked(edev, false);
 
+    // the device must be done with our rx buffers before they are unpinned
+    if (edev->edev0->rx_owner == edev) {
+        eth_rx_dma_release_locked(edev);
+    }
+
     // make sure any future ioctls or other ops will fail
     edev->state |= ETHDEV_DEAD;
 
     // try to convince clients to close us
-    if (edev->rx_fifo) {
-        zx_handle_close(edev->rx_fifo);
-        edev->rx_fifo = ZX_HANDLE_INVALID;
-    }
-    if (edev->tx_fifo) {
-        // Ask the TX thread to exit.
-        zx_object_signal(edev->tx_fifo, 0, kSignalFifoTerminate);
+    for (uint32_t i = 0; i < ETHMAC_MAX_QUEUES; i++) {
+        ethqueue_t* q = edev->queues[i];
+        if (q == NULL) {
+            continue;
+        }
+        if (q->rx_fifo) {
+            zx_handle_close(q->rx_fifo);
+            q->rx_fifo = ZX_HANDLE_INVALID;
+        }
+        if (q->tx_fifo) {
+            // Ask the TX thread to exit.
+            zx_object_signal(q->tx_fifo, 0, kSignalFifoTerminate);
+        }
     }
     if (edev->io_vmo) {
         zx_handle_close(edev->io_vmo);
         edev->io_vmo = ZX_HANDLE_INVALID;
     }
 
-    if (edev->state & ETHDEV_TX_THREAD) {
-        edev->state &= (~ETHDEV_TX_THREAD);
-        int ret;
-        thrd_join(edev->tx_thr, &ret);
-        zxlogf(TRACE, "eth [%s]: kill: tx thread exited\n", edev->name);
-    }
-
-    if (edev->tx_fifo) {
-        zx_handle_close(edev->tx_fifo);
-        edev->tx_fifo = ZX_HANDLE_INVALID;
+    for (uint32_t i = 0; i < ETHMAC_MAX_QUEUES; i++) {
+        ethqueue_t* q = edev->queues[i];
+        if (q == NULL) {
+            continue;
+        }
+        if (q->tx_thread) {
+            q->tx_thread = false;
+            int ret;
+            thrd_join(q->tx_thr, &ret);
+            zxlogf(TRACE, "eth [%s]: kill: tx thread %u exited\n", edev->name, i);
+        }
+        if (q->tx_fifo) {
+            zx_handle_close(q->tx_fifo);
+            q->tx_fifo = ZX_HANDLE_INVALID;
+        }
     }
 
     if (edev->io_buf) {
@@ -919,6 +1492,9 @@ static void eth_release(void* ctx) {
     ethdev_t* edev = ctx;
     if (edev) {
         free(edev->paddr_map);
+        for (uint32_t i = 0; i < ETHMAC_MAX_QUEUES; i++) {
+            free(edev->queues[i]);
+        }
     }
     free(edev);
 }
@@ -951,11 +1527,12 @@ static zx_status_t eth0_open(void* ctx, zx_device_t** out, uint32_t flags) {
     }
     edev->edev0 = edev0;
 
-    list_initialize(&edev->free_tx_bufs);
+    list_initialize(&edev->free_rx_bufs);
     for (size_t ndx = 0; ndx < FIFO_DEPTH; ndx++) {
-        edev->all_tx_bufs[ndx].edev = edev;
-        list_add_tail(&edev->free_tx_bufs, &edev->all_tx_bufs[ndx].netbuf.node);
+        edev->all_rx_bufs[ndx].edev = edev;
+        list_add_tail(&edev->free_rx_bufs, &edev->all_rx_bufs[ndx].netbuf.node);
     }
+    edev->free_rx_count = FIFO_DEPTH;
     mtx_init(&edev->lock, mtx_plain);
 
     device_add_args_t args = {
@@ -1048,6 +1625,21 @@ static zx_status_t eth_bind(void* ctx, zx_device_t* dev) {
         goto fail;
     }
 
+    if (edev0->info.queue_count > ETHMAC_MAX_QUEUES) {
+        zxlogf(ERROR, "eth: bind: device '%s': too many queues (%u)\n", device_get_name(dev),
+               edev0->info.queue_count);
+        status = ZX_ERR_NOT_SUPPORTED;
+        goto fail;
+    }
+
+    if ((edev0->info.features & ETHMAC_FEATURE_RX_DMA) &&
+        (!(edev0->info.features & ETHMAC_FEATURE_DMA) || (ops->queue_rx == NULL))) {
+        zxlogf(ERROR, "eth: bind: device '%s': does not implement ops->queue_rx()\n",
+               device_get_name(dev));
+        status = ZX_ERR_NOT_SUPPORTED;
+        goto fail;
+    }
+
     mtx_init(&edev0->lock, mtx_plain);
     list_initialize(&edev0->list_active);
     list_initialize(&edev0->list_idle);
@@ -46,8 +46,31 @@ typedef struct ethernet_device {
     // callback interface to attached ethernet layer
     ethmac_ifc_t* ifc;
     void* cookie;
+
+    // Buffers given through queue_rx(), waiting for a slot of the rx ring to
+    // be recycled. Protected by rx_lock rather than lock, since queue_rx()
+    // may be called from within the callbacks.
+    mtx_t rx_lock;
+    list_node_t rx_pending;
+    bool rx_accepting;
+
+    // Buffer placed on each slot of the rx ring, if not the driver's own.
+    ethmac_netbuf_t* rx_slots[ETH_RXBUF_COUNT];
+    // Slots holding a frame received into a buffer cancelled by stop().
+    bool rx_discard[ETH_RXBUF_COUNT];
 } ethernet_device_t;
 
+// Places the next buffer from queue_rx() on |slot|, or the driver's own.
+static void eth_rx_refill_slot(ethernet_device_t* edev, uint32_t slot) {
+    mtx_lock(&edev->rx_lock);
+    ethmac_netbuf_t* netbuf = list_remove_head_type(&edev->rx_pending, ethmac_netbuf_t, node);
+    mtx_unlock(&edev->rx_lock);
+
+    edev->rx_slots[slot] = netbuf;
+    eth_rx_set_buffer(&edev->eth, slot,
+                      netbuf ? netbuf->phys : eth_rx_own_buffer(&edev->eth, slot));
+}
+
 static int irq_thread(void* arg) {
     ethernet_device_t* edev = arg;
     for (;;) {
@@ -64,9 +87,22 @@ static int irq_thread(void* arg) {
             size_t len;
 
             while (eth_rx(&edev->eth, &data, &len) == ZX_OK) {
-                if (edev->ifc && (edev->state == ETH_RUNNING)) {
-                    edev->ifc->recv(edev->cookie, data, len, 0);
+                uint32_t slot = eth_rx_slot(&edev->eth);
+                uint32_t opts = eth_rx_more(&edev->eth) ? ETHMAC_RX_OPT_MORE : 0u;
+                if (eth_rx_csum_ok(&edev->eth)) {
+                    opts |= ETHMAC_RX_OPT_CSUM_OK;
                 }
+                ethmac_netbuf_t* netbuf = edev->rx_slots[slot];
+                if (netbuf) {
+                    // Buffers are only on the ring while the ethmac is started.
+                    netbuf->len = len;
+                    edev->ifc->complete_rx(edev->cookie, opts, netbuf, ZX_OK);
+                } else if (edev->ifc && (edev->state == ETH_RUNNING) &&
+                           !edev->rx_discard[slot]) {
+                    edev->ifc->recv(edev->cookie, data, len, opts);
+                }
+                edev->rx_discard[slot] = false;
+                eth_rx_refill_slot(edev, slot);
                 eth_rx_ack(&edev->eth);
             }
         }
@@ -95,6 +131,8 @@ static zx_status_t eth_query(void* ctx, uint32_t options, ethmac_info_t* info) {
 
     memset(info, 0, sizeof(*info));
     ZX_DEBUG_ASSERT(ETH_TXBUF_SIZE >= ETH_MTU);
+    info->features = ETHMAC_FEATURE_DMA | ETHMAC_FEATURE_RX_DMA | ETHMAC_FEATURE_TX_CSUM |
+                     ETHMAC_FEATURE_RX_CSUM;
     info->mtu = ETH_MTU;
     memcpy(info->mac, edev->eth.mac, sizeof(edev->eth.mac));
 
@@ -103,7 +141,33 @@ static zx_status_t eth_query(void* ctx, uint32_t options, ethmac_info_t* info) {
 
 static void eth_stop(void* ctx) {
     ethernet_device_t* edev = ctx;
+    list_node_t pending = LIST_INITIAL_VALUE(pending);
+
+    mtx_lock(&edev->rx_lock);
+    edev->rx_accepting = false;
+    list_move(&edev->rx_pending, &pending);
+    mtx_unlock(&edev->rx_lock);
+
     mtx_lock(&edev->lock);
+    // Take the buffers of the ethernet layer back from the hardware. Frames
+    // already received into them are dropped.
+    eth_disable_rx(&edev->eth);
+    for (uint32_t slot = 0; slot < ETH_RXBUF_COUNT; slot++) {
+        ethmac_netbuf_t* netbuf = edev->rx_slots[slot];
+        if (netbuf) {
+            edev->rx_slots[slot] = NULL;
+            edev->rx_discard[slot] = eth_rx_slot_done(&edev->eth, slot);
+            eth_rx_set_buffer(&edev->eth, slot, eth_rx_own_buffer(&edev->eth, slot));
+            edev->ifc->complete_rx(edev->cookie, 0, netbuf, ZX_ERR_CANCELED);
+        }
+    }
+    ethmac_netbuf_t* netbuf;
+    while ((netbuf = list_remove_head_type(&pending, ethmac_netbuf_t, node)) != NULL) {
+        edev->ifc->complete_rx(edev->cookie, 0, netbuf, ZX_ERR_CANCELED);
+    }
+    if (edev->state == ETH_RUNNING) {
+        eth_enable_rx(&edev->eth);
+    }
     edev->ifc = NULL;
     mtx_unlock(&edev->lock);
 }
@@ -122,6 +186,11 @@ static zx_status_t eth_start(void* ctx, ethmac_ifc_t* ifc, void* cookie) {
     }
     mtx_unlock(&edev->lock);
 
+    if (status == ZX_OK) {
+        mtx_lock(&edev->rx_lock);
+        edev->rx_accepting = true;
+        mtx_unlock(&edev->rx_lock);
+    }
     return status;
 }
 
@@ -131,7 +200,38 @@ static zx_status_t eth_queue_tx(void* ctx, uint32_t options, ethmac_netbuf_t* ne
         return ZX_ERR_BAD_STATE;
     }
     // TODO: Add support for DMA directly from netbuf
-    return eth_tx(&edev->eth, netbuf->data, netbuf->len);
+    if (netbuf->flags & ETHMAC_NETBUF_TSO) {
+        // Segmentation needs the context descriptors of the extended format.
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+    if (netbuf->flags & ETHMAC_NETBUF_CSUM) {
+        return eth_tx(&edev->eth, netbuf->data, netbuf->len, netbuf->csum_start,
+                      netbuf->csum_start + netbuf->csum_offset);
+    }
+    return eth_tx(&edev->eth, netbuf->data, netbuf->len, 0, 0);
+}
+
+static zx_status_t eth_queue_rx(void* ctx, ethmac_netbuf_t* netbuf) {
+    ethernet_device_t* edev = ctx;
+    // The hardware is set up to receive frames of up to ETH_RXBUF_SIZE bytes.
+    if (netbuf->len < ETH_RXBUF_SIZE) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    zx_status_t status = ZX_OK;
+    mtx_lock(&edev->rx_lock);
+    if (edev->rx_accepting) {
+        list_add_tail(&edev->rx_pending, &netbuf->node);
+    } else {
+        status = ZX_ERR_BAD_STATE;
+    }
+    mtx_unlock(&edev->rx_lock);
+    return status;
+}
+
+static zx_handle_t eth_get_bti(void* ctx) {
+    ethernet_device_t* edev = ctx;
+    return edev->btih;
 }
 
 static zx_status_t eth_set_param(void *ctx, uint32_t param, int32_t value, void* data) {
@@ -163,6 +263,8 @@ static ethmac_protocol_ops_t ethmac_ops = {
     .start = eth_start,
     .queue_tx = eth_queue_tx,
     .set_param = eth_set_param,
+    .get_bti = eth_get_bti,
+    .queue_rx = eth_queue_rx,
 };
 
 static zx_status_t eth_suspend(void* ctx, uint32_t flags) {
@@ -232,6 +334,8 @@ static zx_status_t eth_bind(void* ctx, zx_device_t* dev) {
     }
     mtx_init(&edev->lock, mtx_plain);
     mtx_init(&edev->eth.send_lock, mtx_plain);
+    mtx_init(&edev->rx_lock, mtx_plain);
+    list_initialize(&edev->rx_pending);
 
     if (device_get_protocol(dev, ZX_PROTOCOL_PCI, &edev->pci)) {
         printf("no pci protocol\n");
@@ -116,6 +116,9 @@
 #define IE_RCTL_BSEX      (1u << 25) // Buffer Size Extension (x16)
 #define IE_RCTL_SECRC     (1u << 26) // Strip CRC Field
 
+#define IE_RXCSUM_IPOFL   (1u << 8) // IPv4 Checksum Offload Enable
+#define IE_RXCSUM_TUOFL   (1u << 9) // TCP/UDP Checksum Offload Enable
+
 #define IE_TCTL_RESERVED  ((1u << 2) | (1u << 23) | (0xfu << 25) | (1u << 31))
 #define IE_TCTL_RST       (1u << 0) // TX Reset?
 #define IE_TCTL_EN        (1u << 1) // TX Enable
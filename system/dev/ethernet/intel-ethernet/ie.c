@@ -67,6 +67,35 @@ status_t eth_rx(ethdev_t* eth, void** data, size_t* len) {
     return ZX_OK;
 }
 
+uint32_t eth_rx_slot(ethdev_t* eth) {
+    return eth->rx_rd_ptr;
+}
+
+bool eth_rx_more(ethdev_t* eth) {
+    uint32_t n = (eth->rx_rd_ptr + 1) & (ETH_RXBUF_COUNT - 1);
+    return eth->rxd[n].info & IE_RXD_DONE;
+}
+
+bool eth_rx_csum_ok(ethdev_t* eth) {
+    uint64_t info = eth->rxd[eth->rx_rd_ptr].info;
+    if ((info & IE_RXD_IXSM) || !(info & IE_RXD_TCPCS)) {
+        return false;
+    }
+    return !(info & (IE_RXD_TCPE | IE_RXD_IPE));
+}
+
+bool eth_rx_slot_done(ethdev_t* eth, uint32_t n) {
+    return eth->rxd[n].info & IE_RXD_DONE;
+}
+
+void eth_rx_set_buffer(ethdev_t* eth, uint32_t n, uint64_t phys) {
+    eth->rxd[n].addr = phys;
+}
+
+uint64_t eth_rx_own_buffer(ethdev_t* eth, uint32_t n) {
+    return eth->rxb_phys + ETH_RXBUF_SIZE * n;
+}
+
 void eth_rx_ack(ethdev_t* eth) {
     uint32_t n = eth->rx_rd_ptr;
 
@@ -106,11 +135,15 @@ static void reap_tx_buffers(ethdev_t* eth) {
     eth->tx_rd_ptr = n;
 }
 
-status_t eth_tx(ethdev_t* eth, const void* data, size_t len) {
+status_t eth_tx(ethdev_t* eth, const void* data, size_t len, size_t css, size_t cso) {
     if (len > ETH_TXBUF_DSIZE) {
         printf("intel-eth: unsupported packet length %zu\n", len);
         return ZX_ERR_INVALID_ARGS;
     }
+    // The legacy descriptor only holds 8 bit checksum offsets.
+    if (cso > 0xff || css > cso) {
+        return ZX_ERR_INVALID_ARGS;
+    }
 
     zx_status_t status = ZX_OK;
 
@@ -134,6 +167,9 @@ status_t eth_tx(ethdev_t* eth, const void* data, size_t len) {
     }
     eth->txd[n].addr = frame->phys;
     eth->txd[n].info = IE_TXD_LEN(len) | IE_TXD_EOP | IE_TXD_IFCS | IE_TXD_RS;
+    if (cso) {
+        eth->txd[n].info |= IE_TXD_IC | IE_TXD_CSS(css) | IE_TXD_CSO(cso);
+    }
     list_add_tail(&eth->busy_frames, &frame->node);
 
     // inform hw of buffer availability
@@ -356,6 +392,7 @@ void eth_init_hw(ethdev_t* eth) {
     }
 
     writel(ETH_RXBUF_COUNT - 1, IE_RDT);
+    writel(IE_RXCSUM_IPOFL | IE_RXCSUM_TUOFL, IE_RXCSUM);
     writel(IE_RCTL_BSIZE2048 | IE_RCTL_DPF | IE_RCTL_SECRC |
            IE_RCTL_BAM | IE_RCTL_MPE | IE_RCTL_EN,
            IE_RCTL);
@@ -422,8 +459,8 @@ void eth_setup_buffers(ethdev_t* eth, void* iomem, zx_paddr_t iophys) {
     iomem += ETH_RXBUF_SIZE * ETH_RXBUF_COUNT;
     iophys += ETH_RXBUF_SIZE * ETH_RXBUF_COUNT;
 
-    for (int n = 0; n < ETH_RXBUF_COUNT; n++) {
-        eth->rxd[n].addr = eth->rxb_phys + ETH_RXBUF_SIZE * n;
+    for (uint32_t n = 0; n < ETH_RXBUF_COUNT; n++) {
+        eth->rxd[n].addr = eth_rx_own_buffer(eth, n);
     }
     for (int n = 0; n < ETH_TXBUF_COUNT - 1; n++) {
         framebuf_t *txb = iomem;
@@ -75,10 +75,24 @@ void eth_dump_regs(ethdev_t* eth);
 
 status_t eth_rx(ethdev_t* eth, void** data, size_t* len);
 void eth_rx_ack(ethdev_t* eth);
+// Ring slot of the frame returned by eth_rx(), and whether the frame after
+// it has been received too.
+uint32_t eth_rx_slot(ethdev_t* eth);
+bool eth_rx_more(ethdev_t* eth);
+bool eth_rx_slot_done(ethdev_t* eth, uint32_t n);
+// Whether the hardware found the IPv4 header and TCP/UDP checksums of the
+// frame returned by eth_rx() correct.
+bool eth_rx_csum_ok(ethdev_t* eth);
+// Sets the buffer the hardware receives into at ring slot |n|. It must hold
+// ETH_RXBUF_SIZE bytes.
+void eth_rx_set_buffer(ethdev_t* eth, uint32_t n, uint64_t phys);
+uint64_t eth_rx_own_buffer(ethdev_t* eth, uint32_t n);
 void eth_enable_rx(ethdev_t* eth);
 void eth_disable_rx(ethdev_t* eth);
 
-status_t eth_tx(ethdev_t* eth, const void* data, size_t len);
+// Unless |cso| is zero, the hardware replaces the 16 bits at |cso| with the
+// checksum of the frame from |css| on, seeded with their former value.
+status_t eth_tx(ethdev_t* eth, const void* data, size_t len, size_t css, size_t cso);
 size_t eth_tx_queued(ethdev_t* eth);
 void eth_enable_tx(ethdev_t* eth);
 void eth_disable_tx(ethdev_t* eth);
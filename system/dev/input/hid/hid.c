@@ -69,6 +69,10 @@ typedef struct hid_device {
 #define HID_MAX_REPORT_IDS 32
     size_t num_reports;
     hid_report_size_t sizes[HID_MAX_REPORT_IDS];
+    // Input report sizes in bytes, indexed by report id and built once from
+    // |sizes|, so that incoming and outgoing reports don't have to search for
+    // their size.  Zero for unknown report ids.
+    input_report_size_t in_bytes_by_id[256];
 
     struct list_node instance_list;
     mtx_t instance_lock;
@@ -136,6 +140,10 @@ static inline zx_status_t hid_op_set_protocol(hid_device_t* hid, uint8_t protoco
 static input_report_size_t hid_get_report_size_by_id(hid_device_t* hid,
                                                      input_report_id_t id,
                                                      zircon_input_ReportType type) {
+    if (type == zircon_input_ReportType_INPUT) {
+        return hid->in_bytes_by_id[id];
+    }
+
     for (size_t i = 0; i < hid->num_reports; i++) {
         if ((hid->sizes[i].id == id) || (hid->num_reports == 1)) {
             switch (type) {
@@ -465,6 +473,24 @@ static void hid_clear_global_state(list_node_t* stack) {
     }
 }
 
+static void hid_build_input_size_table(hid_device_t* dev) {
+    memset(dev->in_bytes_by_id, 0, sizeof(dev->in_bytes_by_id));
+    if (dev->num_reports == 1) {
+        // A device with a single report may not use report ids at all, so
+        // every id maps to that report.
+        input_report_size_t size = bits_to_bytes(dev->sizes[0].in_size);
+        for (size_t i = 0; i < countof(dev->in_bytes_by_id); i++) {
+            dev->in_bytes_by_id[i] = size;
+        }
+        return;
+    }
+    // Walk backwards so that the first entry wins if an id is repeated.
+    for (size_t i = dev->num_reports; i > 0; i--) {
+        const hid_report_size_t* size = &dev->sizes[i - 1];
+        dev->in_bytes_by_id[size->id] = bits_to_bytes(size->in_size);
+    }
+}
+
 static zx_status_t hid_process_hid_report_desc(hid_device_t* dev) {
     const uint8_t* buf = dev->hid_report_desc;
     const uint8_t* end = buf + dev->hid_report_desc_len;
@@ -838,6 +864,7 @@ static zx_status_t hid_bind(void* ctx, zx_device_t* parent) {
         zxlogf(ERROR, "hid: could not parse hid report descriptor: %d\n", status);
         goto fail;
     }
+    hid_build_input_size_table(hiddev);
     hid_dump_hid_report_desc(hiddev);
 
     status = hid_init_reassembly_buffer(hiddev);
@@ -512,6 +512,14 @@ static zx_status_t ipm_stage_fixed_config(const cpuperf_config_t* icfg,
         ocfg->fixed_flags[ss->num_fixed] |= IPM_CONFIG_FLAG_TIMEBASE;
     if (icfg->flags[ii] & CPUPERF_CONFIG_FLAG_PC)
         ocfg->fixed_flags[ss->num_fixed] |= IPM_CONFIG_FLAG_PC;
+    if (icfg->flags[ii] & CPUPERF_CONFIG_FLAG_THREAD) {
+        if (!(icfg->flags[ii] & CPUPERF_CONFIG_FLAG_PC)) {
+            zxlogf(ERROR, "%s: Thread data requires pc data, event [%u]\n"
+                   , __func__, ii);
+            return ZX_ERR_INVALID_ARGS;
+        }
+        ocfg->fixed_flags[ss->num_fixed] |= IPM_CONFIG_FLAG_THREAD;
+    }
     if (icfg->flags[ii] & CPUPERF_CONFIG_FLAG_LAST_BRANCH) {
         if (!ipm_lbr_supported()) {
             zxlogf(ERROR, "%s: Last branch not supported, event [%u]\n"
@@ -610,6 +618,14 @@ static zx_status_t ipm_stage_programmable_config(const cpuperf_config_t* icfg,
         ocfg->programmable_flags[ss->num_programmable] |= IPM_CONFIG_FLAG_TIMEBASE;
     if (icfg->flags[ii] & CPUPERF_CONFIG_FLAG_PC)
         ocfg->programmable_flags[ss->num_programmable] |= IPM_CONFIG_FLAG_PC;
+    if (icfg->flags[ii] & CPUPERF_CONFIG_FLAG_THREAD) {
+        if (!(icfg->flags[ii] & CPUPERF_CONFIG_FLAG_PC)) {
+            zxlogf(ERROR, "%s: Thread data requires pc data, event [%u]\n"
+                   , __func__, ii);
+            return ZX_ERR_INVALID_ARGS;
+        }
+        ocfg->programmable_flags[ss->num_programmable] |= IPM_CONFIG_FLAG_THREAD;
+    }
     if (icfg->flags[ii] & CPUPERF_CONFIG_FLAG_LAST_BRANCH) {
         if (!ipm_lbr_supported()) {
             zxlogf(ERROR, "%s: Last branch not supported, event [%u]\n"
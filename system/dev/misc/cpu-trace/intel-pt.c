@@ -624,6 +624,29 @@ static zx_status_t x86_pt_get_trace_data(insntrace_device_t* dev, zx_handle_t re
     return ZX_OK;
 }
 
+// Like x86_pt_get_trace_data(), but for a trace that is still running.
+// Only the output position is updated: the configuration cannot change while
+// tracing.
+static zx_status_t x86_pt_snapshot_trace_data(insntrace_device_t* dev, zx_handle_t resource,
+                                              zx_itrace_buffer_descriptor_t descriptor) {
+    if (descriptor >= dev->num_traces)
+        return ZX_ERR_INVALID_ARGS;
+    assert(dev->per_trace_state);
+    ipt_per_trace_state_t* per_trace = &dev->per_trace_state[descriptor];
+
+    zx_x86_pt_regs_t regs;
+    zx_status_t status = zx_mtrace_control(resource, MTRACE_KIND_INSNTRACE,
+                                           MTRACE_INSNTRACE_SNAPSHOT_TRACE_DATA,
+                                           descriptor, &regs, sizeof(regs));
+    if (status != ZX_OK)
+        return status;
+    per_trace->status = regs.status;
+    per_trace->output_base = regs.output_base;
+    per_trace->output_mask_ptrs = regs.output_mask_ptrs;
+
+    return ZX_OK;
+}
+
 
 // ioctl handlers
 
@@ -841,6 +864,38 @@ static zx_status_t ipt_get_buffer_info(insntrace_device_t* dev,
     return ZX_OK;
 }
 
+static zx_status_t ipt_snapshot_buffer_info(insntrace_device_t* dev,
+                                            const void* cmd, size_t cmdlen,
+                                            void* reply, size_t replymax,
+                                            size_t* out_actual) {
+    zx_itrace_buffer_descriptor_t descriptor;
+    ioctl_insntrace_buffer_info_t data;
+
+    if (cmdlen != sizeof(descriptor))
+        return ZX_ERR_INVALID_ARGS;
+    if (replymax < sizeof(data))
+        return ZX_ERR_BUFFER_TOO_SMALL;
+
+    if (dev->mode != IPT_TRACE_CPUS || !dev->active)
+        return ZX_ERR_BAD_STATE;
+
+    memcpy(&descriptor, cmd, sizeof(descriptor));
+    if (descriptor >= dev->num_traces)
+        return ZX_ERR_INVALID_ARGS;
+    const ipt_per_trace_state_t* per_trace = &dev->per_trace_state[descriptor];
+    if (!per_trace->assigned)
+        return ZX_ERR_INVALID_ARGS;
+
+    zx_status_t status = x86_pt_snapshot_trace_data(dev, get_root_resource(), descriptor);
+    if (status != ZX_OK)
+        return status;
+
+    data.capture_end = compute_capture_size(dev, per_trace);
+    memcpy(reply, &data, sizeof(data));
+    *out_actual = sizeof(data);
+    return ZX_OK;
+}
+
 static zx_status_t ipt_get_chunk_handle(insntrace_device_t* dev,
                                         const void* cmd, size_t cmdlen,
                                         void* reply, size_t replymax,
@@ -1026,6 +1081,9 @@ zx_status_t insntrace_ioctl_worker(insntrace_device_t* dev, uint32_t op,
     case IOCTL_INSNTRACE_GET_BUFFER_INFO:
         return ipt_get_buffer_info(dev, cmd, cmdlen, reply, replymax, out_actual);
 
+    case IOCTL_INSNTRACE_SNAPSHOT_BUFFER_INFO:
+        return ipt_snapshot_buffer_info(dev, cmd, cmdlen, reply, replymax, out_actual);
+
     case IOCTL_INSNTRACE_GET_CHUNK_HANDLE:
         return ipt_get_chunk_handle(dev, cmd, cmdlen, reply, replymax, out_actual);
 
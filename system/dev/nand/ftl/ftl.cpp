@@ -0,0 +1,412 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ftl.h"
+
+#include <string.h>
+
+#include <ddk/debug.h>
+#include <ddk/protocol/bad-block.h>
+#include <ddk/protocol/block.h>
+#include <ddk/protocol/nand.h>
+
+#include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
+#include <fbl/auto_lock.h>
+#include <fbl/unique_ptr.h>
+#include <zircon/assert.h>
+#include <zircon/syscalls.h>
+
+namespace ftl {
+
+namespace {
+
+struct FtlOp {
+    block_op_t op;
+    block_impl_queue_callback completion_cb;
+    void* cookie;
+    list_node_t node;
+};
+
+void NandCompletionCallback(nand_op_t* op, zx_status_t status) {
+    auto* device = static_cast<BlockDevice*>(op->cookie);
+    device->NandOpDone(status);
+}
+
+} // namespace
+
+zx_status_t BlockDevice::Create(zx_device_t* parent) {
+    // Get NAND protocol.
+    nand_protocol_t nand_proto;
+    if (device_get_protocol(parent, ZX_PROTOCOL_NAND, &nand_proto) != ZX_OK) {
+        zxlogf(ERROR, "ftl: parent device '%s': does not support nand protocol\n",
+               device_get_name(parent));
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
+    // Get bad block protocol.
+    bad_block_protocol_t bad_block_proto;
+    if (device_get_protocol(parent, ZX_PROTOCOL_BAD_BLOCK, &bad_block_proto) != ZX_OK) {
+        zxlogf(ERROR, "ftl: parent device '%s': does not support bad_block protocol\n",
+               device_get_name(parent));
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<BlockDevice> device(new (&ac) BlockDevice(parent, nand_proto,
+                                                              bad_block_proto));
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    zx_status_t status = device->Bind();
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    // devmgr is now in charge of the device.
+    __UNUSED auto* dummy = device.release();
+    return ZX_OK;
+}
+
+BlockDevice::~BlockDevice() {
+    if (thread_created_) {
+        Kill();
+        sync_completion_signal(&wake_signal_);
+        int result_code;
+        thrd_join(worker_, &result_code);
+
+        for (;;) {
+            FtlOp* ftl_op = list_remove_head_type(&txn_list_, FtlOp, node);
+            if (!ftl_op) {
+                break;
+            }
+            ftl_op->completion_cb(ftl_op->cookie, ZX_ERR_BAD_STATE, &ftl_op->op);
+        }
+    }
+
+    if (volume_) {
+        // Pages still in the open erase block would otherwise be lost.
+        volume_->Flush();
+    }
+}
+
+zx_status_t BlockDevice::GetBadBlockList(fbl::Array<uint32_t>* bad_blocks) {
+    size_t bad_block_count;
+    zx_status_t status = bad_block_.GetBadBlockList(nullptr, 0, &bad_block_count);
+    if (status != ZX_OK) {
+        return status;
+    }
+    if (bad_block_count == 0) {
+        bad_blocks->reset();
+        return ZX_OK;
+    }
+    fbl::AllocChecker ac;
+    fbl::Array<uint32_t> list(new (&ac) uint32_t[bad_block_count], bad_block_count);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    status = bad_block_.GetBadBlockList(list.get(), list.size(), &bad_block_count);
+    if (status != ZX_OK) {
+        return status;
+    }
+    if (bad_block_count != list.size()) {
+        return ZX_ERR_INTERNAL;
+    }
+    *bad_blocks = fbl::move(list);
+    return ZX_OK;
+}
+
+zx_status_t BlockDevice::Bind() {
+    zxlogf(INFO, "ftl: Binding to %s\n", device_get_name(parent()));
+
+    if (sizeof(nand_op_t) > parent_op_size_) {
+        zxlogf(ERROR, "ftl: parent op size, %zu, is smaller than minimum op size: %zu\n",
+               sizeof(nand_op_t), parent_op_size_);
+        return ZX_ERR_INTERNAL;
+    }
+
+    fbl::AllocChecker ac;
+    nand_op_.reset(new (&ac) uint8_t[parent_op_size_], parent_op_size_);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    size_t transfer_size = static_cast<size_t>(nand_info_.pages_per_block) * nand_info_.page_size;
+    transfer_.reset(new (&ac) uint8_t[transfer_size], transfer_size);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    size_t vmo_size = static_cast<size_t>(nand_info_.pages_per_block) *
+                      (nand_info_.page_size + nand_info_.oob_size);
+    zx_status_t status = mapper_.CreateAndMap(vmo_size, ZX_VM_PERM_READ | ZX_VM_PERM_WRITE,
+                                              nullptr, &vmo_);
+    if (status != ZX_OK) {
+        zxlogf(ERROR, "ftl: Failed to create staging vmo: %d\n", status);
+        return status;
+    }
+
+    fbl::Array<uint32_t> bad_blocks;
+    if ((status = GetBadBlockList(&bad_blocks)) != ZX_OK) {
+        zxlogf(ERROR, "ftl: Failed to get bad block list\n");
+        return status;
+    }
+
+    NandGeometry geometry = {nand_info_.page_size, nand_info_.pages_per_block,
+                             nand_info_.num_blocks, nand_info_.oob_size};
+    status = Volume::Create(this, geometry, bad_blocks, &volume_);
+    if (status != ZX_OK) {
+        zxlogf(ERROR, "ftl: Failed to mount volume: %d\n", status);
+        return status;
+    }
+
+    list_initialize(&txn_list_);
+    if (thrd_create_with_name(&worker_, WorkerThreadStub, this, "ftl-worker") != thrd_success) {
+        return ZX_ERR_NO_RESOURCES;
+    }
+    thread_created_ = true;
+
+    return DdkAdd("ftl");
+}
+
+zx_off_t BlockDevice::DdkGetSize() {
+    return static_cast<zx_off_t>(volume_->page_count()) * nand_info_.page_size;
+}
+
+void BlockDevice::DdkUnbind() {
+    Kill();
+    sync_completion_signal(&wake_signal_);
+    DdkRemove();
+}
+
+void BlockDevice::BlockImplQuery(block_info_t* info_out, size_t* block_op_size_out) {
+    memset(info_out, 0, sizeof(*info_out));
+    info_out->block_count = volume_->page_count();
+    info_out->block_size = nand_info_.page_size;
+    info_out->max_transfer_size = BLOCK_MAX_TRANSFER_UNBOUNDED;
+    *block_op_size_out = sizeof(FtlOp);
+}
+
+void BlockDevice::BlockImplQueue(block_op_t* operation, block_impl_queue_callback completion_cb,
+                                 void* cookie) {
+    switch (operation->command & BLOCK_OP_MASK) {
+    case BLOCK_OP_READ:
+    case BLOCK_OP_WRITE: {
+        uint64_t block_count = volume_->page_count();
+        if (operation->rw.offset_dev >= block_count ||
+            block_count - operation->rw.offset_dev < operation->rw.length) {
+            completion_cb(cookie, ZX_ERR_OUT_OF_RANGE, operation);
+            return;
+        }
+        if (operation->rw.length == 0) {
+            completion_cb(cookie, ZX_OK, operation);
+            return;
+        }
+        break;
+    }
+    case BLOCK_OP_FLUSH:
+        break;
+
+    default:
+        completion_cb(cookie, ZX_ERR_NOT_SUPPORTED, operation);
+        return;
+    }
+
+    FtlOp* ftl_op = reinterpret_cast<FtlOp*>(operation);
+    ftl_op->completion_cb = completion_cb;
+    ftl_op->cookie = cookie;
+    if (AddToList(operation)) {
+        sync_completion_signal(&wake_signal_);
+    } else {
+        completion_cb(cookie, ZX_ERR_BAD_STATE, operation);
+    }
+}
+
+void BlockDevice::BlockImplQueueBatch(block_op_t** operations, size_t count,
+                                      block_impl_queue_callback completion_cb, void* cookie) {
+    // The worker thread takes operations off the list one at a time anyway.
+    for (size_t i = 0; i < count; i++) {
+        BlockImplQueue(operations[i], completion_cb, cookie);
+    }
+}
+
+void BlockDevice::NandOpDone(zx_status_t status) {
+    nand_op_status_ = status;
+    sync_completion_signal(&nand_op_done_);
+}
+
+zx_status_t BlockDevice::QueueNandOp() {
+    nand_op_t* op = reinterpret_cast<nand_op_t*>(nand_op_.get());
+    op->completion_cb = NandCompletionCallback;
+    op->cookie = this;
+    sync_completion_reset(&nand_op_done_);
+    nand_.Queue(op);
+    sync_completion_wait(&nand_op_done_, ZX_TIME_INFINITE);
+    return nand_op_status_;
+}
+
+zx_status_t BlockDevice::Read(uint32_t page, uint32_t count, void* data, void* oob) {
+    ZX_DEBUG_ASSERT(count <= nand_info_.pages_per_block);
+    nand_op_t* op = reinterpret_cast<nand_op_t*>(nand_op_.get());
+    op->rw.command = NAND_OP_READ;
+    op->rw.data_vmo = data ? vmo_.get() : ZX_HANDLE_INVALID;
+    op->rw.oob_vmo = oob ? vmo_.get() : ZX_HANDLE_INVALID;
+    op->rw.length = count;
+    op->rw.offset_nand = page;
+    op->rw.offset_data_vmo = 0;
+    op->rw.offset_oob_vmo = nand_info_.pages_per_block;
+    op->rw.pages = nullptr;
+    zx_status_t status = QueueNandOp();
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    uint8_t* staging = static_cast<uint8_t*>(mapper_.start());
+    if (data) {
+        memcpy(data, staging, count * nand_info_.page_size);
+    }
+    if (oob) {
+        memcpy(oob, staging + nand_info_.pages_per_block * nand_info_.page_size,
+               count * nand_info_.oob_size);
+    }
+    return ZX_OK;
+}
+
+zx_status_t BlockDevice::Write(uint32_t page, uint32_t count, const void* data, const void* oob) {
+    ZX_DEBUG_ASSERT(count <= nand_info_.pages_per_block);
+    uint8_t* staging = static_cast<uint8_t*>(mapper_.start());
+    memcpy(staging, data, count * nand_info_.page_size);
+    memcpy(staging + nand_info_.pages_per_block * nand_info_.page_size, oob,
+           count * nand_info_.oob_size);
+
+    nand_op_t* op = reinterpret_cast<nand_op_t*>(nand_op_.get());
+    op->rw.command = NAND_OP_WRITE;
+    op->rw.data_vmo = vmo_.get();
+    op->rw.oob_vmo = vmo_.get();
+    op->rw.length = count;
+    op->rw.offset_nand = page;
+    op->rw.offset_data_vmo = 0;
+    op->rw.offset_oob_vmo = nand_info_.pages_per_block;
+    op->rw.pages = nullptr;
+    return QueueNandOp();
+}
+
+zx_status_t BlockDevice::Erase(uint32_t block) {
+    nand_op_t* op = reinterpret_cast<nand_op_t*>(nand_op_.get());
+    op->erase.command = NAND_OP_ERASE;
+    op->erase.first_block = block;
+    op->erase.num_blocks = 1;
+    return QueueNandOp();
+}
+
+zx_status_t BlockDevice::MarkBad(uint32_t block) {
+    zxlogf(ERROR, "ftl: Marking block %u bad\n", block);
+    return bad_block_.MarkBlockBad(block);
+}
+
+void BlockDevice::Kill() {
+    fbl::AutoLock lock(&lock_);
+    dead_ = true;
+}
+
+bool BlockDevice::AddToList(block_op_t* operation) {
+    fbl::AutoLock lock(&lock_);
+    bool is_dead = dead_;
+    if (!dead_) {
+        FtlOp* ftl_op = reinterpret_cast<FtlOp*>(operation);
+        list_add_tail(&txn_list_, &ftl_op->node);
+    }
+    return !is_dead;
+}
+
+bool BlockDevice::RemoveFromList(block_op_t** operation) {
+    fbl::AutoLock lock(&lock_);
+    bool is_dead = dead_;
+    if (!dead_) {
+        FtlOp* ftl_op = list_remove_head_type(&txn_list_, FtlOp, node);
+        *operation = reinterpret_cast<block_op_t*>(ftl_op);
+    }
+    return !is_dead;
+}
+
+int BlockDevice::WorkerThread() {
+    for (;;) {
+        block_op_t* operation;
+        for (;;) {
+            if (!RemoveFromList(&operation)) {
+                return 0;
+            }
+            if (operation) {
+                sync_completion_reset(&wake_signal_);
+                break;
+            }
+            // Spend idle time making room for the next burst of writes.
+            if (!volume_->CollectGarbage()) {
+                sync_completion_wait(&wake_signal_, ZX_TIME_INFINITE);
+            }
+        }
+
+        zx_status_t status;
+        switch (operation->command & BLOCK_OP_MASK) {
+        case BLOCK_OP_READ:
+        case BLOCK_OP_WRITE:
+            status = ReadWrite(operation);
+            break;
+
+        case BLOCK_OP_FLUSH:
+            status = volume_->Flush();
+            break;
+
+        default:
+            ZX_DEBUG_ASSERT(false);  // Unexpected.
+            status = ZX_ERR_NOT_SUPPORTED;
+        }
+
+        FtlOp* ftl_op = reinterpret_cast<FtlOp*>(operation);
+        ftl_op->completion_cb(ftl_op->cookie, status, operation);
+    }
+}
+
+int BlockDevice::WorkerThreadStub(void* arg) {
+    BlockDevice* device = static_cast<BlockDevice*>(arg);
+    return device->WorkerThread();
+}
+
+zx_status_t BlockDevice::ReadWrite(block_op_t* operation) {
+    const uint32_t page_size = nand_info_.page_size;
+    const uint32_t max_pages = static_cast<uint32_t>(transfer_.size() / page_size);
+    bool is_write = (operation->command & BLOCK_OP_MASK) == BLOCK_OP_WRITE;
+
+    uint32_t done = 0;
+    while (done < operation->rw.length) {
+        uint32_t count = fbl::min(operation->rw.length - done, max_pages);
+        uint32_t page = static_cast<uint32_t>(operation->rw.offset_dev) + done;
+        uint64_t vmo_offset = (operation->rw.offset_vmo + done) * page_size;
+        size_t length = static_cast<size_t>(count) * page_size;
+
+        zx_status_t status;
+        if (is_write) {
+            status = zx_vmo_read(operation->rw.vmo, transfer_.get(), vmo_offset, length);
+            if (status == ZX_OK) {
+                status = volume_->Write(page, count, transfer_.get());
+            }
+        } else {
+            status = volume_->Read(page, count, transfer_.get());
+            if (status == ZX_OK) {
+                status = zx_vmo_write(operation->rw.vmo, transfer_.get(), vmo_offset, length);
+            }
+        }
+        if (status != ZX_OK) {
+            return status;
+        }
+        done += count;
+    }
+    return ZX_OK;
+}
+
+} // namespace ftl
+
+extern "C" zx_status_t ftl_bind(void* ctx, zx_device_t* parent) {
+    return ftl::BlockDevice::Create(parent);
+}
@@ -0,0 +1,122 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <threads.h>
+
+#include <ddk/protocol/block.h>
+#include <ddk/protocol/nand.h>
+#include <ddktl/device.h>
+#include <ddktl/protocol/bad-block.h>
+#include <ddktl/protocol/block.h>
+#include <ddktl/protocol/nand.h>
+
+#include <fbl/array.h>
+#include <fbl/macros.h>
+#include <fbl/mutex.h>
+#include <fbl/unique_ptr.h>
+#include <lib/fzl/vmo-mapper.h>
+#include <lib/sync/completion.h>
+#include <lib/zx/vmo.h>
+#include <zircon/listnode.h>
+#include <zircon/nand/c/fidl.h>
+#include <zircon/thread_annotations.h>
+#include <zircon/types.h>
+
+#include "volume.h"
+
+namespace ftl {
+
+class BlockDevice;
+using DeviceType = ddk::Device<BlockDevice, ddk::GetSizable, ddk::Unbindable>;
+
+// Exposes a nand partition as a block device, through a |Volume|.
+class BlockDevice : public DeviceType, public ddk::BlockImplProtocol<BlockDevice>,
+                    public NandDriver {
+public:
+    // Spawns device node based on parent node.
+    static zx_status_t Create(zx_device_t* parent);
+
+    ~BlockDevice();
+
+    zx_status_t Bind();
+
+    // Device protocol implementation.
+    zx_off_t DdkGetSize();
+    void DdkUnbind();
+    void DdkRelease() { delete this; }
+
+    // Block protocol implementation.
+    void BlockImplQuery(block_info_t* info_out, size_t* block_op_size_out);
+    void BlockImplQueue(block_op_t* operation, block_impl_queue_callback completion_cb,
+                        void* cookie);
+    zx_status_t BlockImplGetStats(const void* cmd_buffer, size_t cmd_size, void* out_reply_buffer,
+                                  size_t reply_size, size_t* out_reply_actual) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+    void BlockImplQueueBatch(block_op_t** operations, size_t count,
+                             block_impl_queue_callback completion_cb, void* cookie);
+
+    // NandDriver implementation, used by |volume_| on the worker thread.
+    zx_status_t Read(uint32_t page, uint32_t count, void* data, void* oob) override;
+    zx_status_t Write(uint32_t page, uint32_t count, const void* data, const void* oob) override;
+    zx_status_t Erase(uint32_t block) override;
+    zx_status_t MarkBad(uint32_t block) override;
+
+    // Completion of |nand_op_|.
+    void NandOpDone(zx_status_t status);
+
+private:
+    BlockDevice(zx_device_t* parent, nand_protocol_t nand_proto,
+                bad_block_protocol_t bad_block_proto)
+        : DeviceType(parent), nand_proto_(nand_proto), bad_block_proto_(bad_block_proto),
+          nand_(&nand_proto_), bad_block_(&bad_block_proto_) {
+        nand_.Query(&nand_info_, &parent_op_size_);
+    }
+
+    DISALLOW_COPY_ASSIGN_AND_MOVE(BlockDevice);
+
+    zx_status_t GetBadBlockList(fbl::Array<uint32_t>* bad_blocks);
+    // Queues |nand_op_| and waits for it.
+    zx_status_t QueueNandOp();
+
+    void Kill();
+    bool AddToList(block_op_t* operation);
+    bool RemoveFromList(block_op_t** operation);
+    int WorkerThread();
+    static int WorkerThreadStub(void* arg);
+
+    zx_status_t ReadWrite(block_op_t* operation);
+
+    nand_protocol_t nand_proto_;
+    bad_block_protocol_t bad_block_proto_;
+    ddk::NandProtocolProxy nand_;
+    ddk::BadBlockProtocolProxy bad_block_;
+    zircon_nand_Info nand_info_;
+    size_t parent_op_size_;
+
+    // Only used by the worker thread, once bound.
+    fbl::unique_ptr<Volume> volume_;
+    // Operation buffer of size parent_op_size_.
+    fbl::Array<uint8_t> nand_op_;
+    sync_completion_t nand_op_done_;
+    zx_status_t nand_op_status_;
+    // Staging area for the data of an erase block, followed by its oob.
+    zx::vmo vmo_;
+    fzl::VmoMapper mapper_;
+    // Pages of client data moved at once through the volume.
+    fbl::Array<uint8_t> transfer_;
+
+    fbl::Mutex lock_;
+    list_node_t txn_list_ TA_GUARDED(lock_) = {};
+    bool dead_ TA_GUARDED(lock_) = false;
+
+    bool thread_created_ = false;
+
+    sync_completion_t wake_signal_;
+    thrd_t worker_;
+};
+
+} // namespace ftl
@@ -0,0 +1,295 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "volume.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <fbl/array.h>
+#include <fbl/unique_ptr.h>
+#include <fbl/vector.h>
+#include <unittest/unittest.h>
+#include <zircon/types.h>
+
+namespace ftl {
+namespace {
+
+constexpr NandGeometry kGeometry = {64, 16, 64, 8};
+constexpr uint32_t kNone = UINT32_MAX;
+
+// In-memory nand which checks that erased pages are only programmed once, and
+// can be told to fail an operation.
+class FakeNand : public NandDriver {
+public:
+    FakeNand() {
+        size_t pages = kGeometry.pages_per_block * kGeometry.num_blocks;
+        data_.reset(new uint8_t[pages * kGeometry.page_size], pages * kGeometry.page_size);
+        oob_.reset(new uint8_t[pages * kGeometry.oob_size], pages * kGeometry.oob_size);
+        memset(data_.get(), 0xff, data_.size());
+        memset(oob_.get(), 0xff, oob_.size());
+    }
+
+    zx_status_t Read(uint32_t page, uint32_t count, void* data, void* oob) override {
+        if (!InOneBlock(page, count)) {
+            return ZX_ERR_INVALID_ARGS;
+        }
+        if (data) {
+            memcpy(data, &data_[page * kGeometry.page_size], count * kGeometry.page_size);
+        }
+        if (oob) {
+            memcpy(oob, &oob_[page * kGeometry.oob_size], count * kGeometry.oob_size);
+        }
+        return ZX_OK;
+    }
+
+    zx_status_t Write(uint32_t page, uint32_t count, const void* data,
+                      const void* oob) override {
+        if (!InOneBlock(page, count)) {
+            return ZX_ERR_INVALID_ARGS;
+        }
+        write_count_++;
+        if (page / kGeometry.pages_per_block == fail_write_block_) {
+            fail_write_block_ = kNone;
+            return ZX_ERR_IO;
+        }
+        for (size_t i = 0; i < count * kGeometry.page_size; i++) {
+            if (data_[page * kGeometry.page_size + i] != 0xff) {
+                return ZX_ERR_BAD_STATE;
+            }
+        }
+        memcpy(&data_[page * kGeometry.page_size], data, count * kGeometry.page_size);
+        memcpy(&oob_[page * kGeometry.oob_size], oob, count * kGeometry.oob_size);
+        return ZX_OK;
+    }
+
+    zx_status_t Erase(uint32_t block) override {
+        if (block == fail_erase_block_) {
+            fail_erase_block_ = kNone;
+            return ZX_ERR_IO;
+        }
+        size_t block_data = kGeometry.pages_per_block * kGeometry.page_size;
+        size_t block_oob = kGeometry.pages_per_block * kGeometry.oob_size;
+        memset(&data_[block * block_data], 0xff, block_data);
+        memset(&oob_[block * block_oob], 0xff, block_oob);
+        return ZX_OK;
+    }
+
+    zx_status_t MarkBad(uint32_t block) override {
+        bad_blocks_.push_back(block);
+        return ZX_OK;
+    }
+
+    fbl::Array<uint32_t> BadBlocks() const {
+        fbl::Array<uint32_t> list(new uint32_t[bad_blocks_.size()], bad_blocks_.size());
+        for (size_t i = 0; i < bad_blocks_.size(); i++) {
+            list[i] = bad_blocks_[i];
+        }
+        return list;
+    }
+
+    uint32_t write_count_ = 0;
+    uint32_t fail_write_block_ = kNone;
+    uint32_t fail_erase_block_ = kNone;
+    fbl::Vector<uint32_t> bad_blocks_;
+
+private:
+    static bool InOneBlock(uint32_t page, uint32_t count) {
+        return count > 0 &&
+               page / kGeometry.pages_per_block == (page + count - 1) / kGeometry.pages_per_block;
+    }
+
+    fbl::Array<uint8_t> data_;
+    fbl::Array<uint8_t> oob_;
+};
+
+// Fills |page| with a pattern identifying |value|.
+void FillPage(uint32_t value, uint8_t* page) {
+    for (uint32_t i = 0; i < kGeometry.page_size / sizeof(value); i++) {
+        memcpy(&page[i * sizeof(value)], &value, sizeof(value));
+    }
+}
+
+// Writes random pages, recording what each logical page holds in |contents|.
+bool WriteRandomPages(Volume* volume, uint32_t count, uint32_t first_value,
+                      fbl::Array<uint32_t>* contents) {
+    BEGIN_HELPER;
+    uint8_t page[kGeometry.page_size];
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t logical = static_cast<uint32_t>(rand()) % volume->page_count();
+        uint32_t value = first_value + i;
+        FillPage(value, page);
+        ASSERT_EQ(volume->Write(logical, 1, page), ZX_OK);
+        (*contents)[logical] = value;
+        if (i % 1000 == 999) {
+            ASSERT_EQ(volume->Flush(), ZX_OK);
+        }
+        if (i % 97 == 0) {
+            while (volume->CollectGarbage()) {
+            }
+        }
+    }
+    END_HELPER;
+}
+
+bool CheckContents(Volume* volume, const fbl::Array<uint32_t>& contents) {
+    BEGIN_HELPER;
+    constexpr uint32_t kPagesPerRead = 8;
+    uint8_t data[kPagesPerRead * kGeometry.page_size];
+    uint8_t expected[kGeometry.page_size];
+    for (uint32_t page = 0; page < volume->page_count(); page += kPagesPerRead) {
+        ASSERT_EQ(volume->Read(page, kPagesPerRead, data), ZX_OK);
+        for (uint32_t i = 0; i < kPagesPerRead; i++) {
+            if (contents[page + i] == 0) {
+                memset(expected, 0, sizeof(expected));
+            } else {
+                FillPage(contents[page + i], expected);
+            }
+            ASSERT_EQ(memcmp(&data[i * kGeometry.page_size], expected, sizeof(expected)), 0);
+        }
+    }
+    END_HELPER;
+}
+
+fbl::Array<uint32_t> MakeContents(const Volume& volume) {
+    fbl::Array<uint32_t> contents(new uint32_t[volume.page_count()], volume.page_count());
+    memset(contents.get(), 0, volume.page_count() * sizeof(uint32_t));
+    return contents;
+}
+
+bool EmptyVolumeTest() {
+    BEGIN_TEST;
+    FakeNand nand;
+    fbl::unique_ptr<Volume> volume;
+    ASSERT_EQ(Volume::Create(&nand, kGeometry, fbl::Array<uint32_t>(), &volume), ZX_OK);
+    EXPECT_GT(volume->page_count(), 0);
+    EXPECT_LT(volume->page_count(), kGeometry.pages_per_block * kGeometry.num_blocks);
+    EXPECT_TRUE(CheckContents(volume.get(), MakeContents(*volume)));
+    END_TEST;
+}
+
+bool TooManyBadBlocksTest() {
+    BEGIN_TEST;
+    FakeNand nand;
+    fbl::Array<uint32_t> bad_blocks(new uint32_t[kGeometry.num_blocks / 2],
+                                    kGeometry.num_blocks / 2);
+    for (uint32_t i = 0; i < bad_blocks.size(); i++) {
+        bad_blocks[i] = i * 2;
+    }
+    fbl::unique_ptr<Volume> volume;
+    EXPECT_EQ(Volume::Create(&nand, kGeometry, bad_blocks, &volume), ZX_ERR_NO_SPACE);
+    END_TEST;
+}
+
+bool OutOfRangeTest() {
+    BEGIN_TEST;
+    FakeNand nand;
+    fbl::unique_ptr<Volume> volume;
+    ASSERT_EQ(Volume::Create(&nand, kGeometry, fbl::Array<uint32_t>(), &volume), ZX_OK);
+    uint8_t data[2 * kGeometry.page_size] = {};
+    EXPECT_EQ(volume->Read(volume->page_count(), 1, data), ZX_ERR_OUT_OF_RANGE);
+    EXPECT_EQ(volume->Write(volume->page_count() - 1, 2, data), ZX_ERR_OUT_OF_RANGE);
+    END_TEST;
+}
+
+bool FullBlockProgrammedAtOnceTest() {
+    BEGIN_TEST;
+    FakeNand nand;
+    fbl::unique_ptr<Volume> volume;
+    ASSERT_EQ(Volume::Create(&nand, kGeometry, fbl::Array<uint32_t>(), &volume), ZX_OK);
+
+    uint8_t data[kGeometry.pages_per_block * kGeometry.page_size];
+    memset(data, 0x5a, sizeof(data));
+    ASSERT_EQ(volume->Write(0, kGeometry.pages_per_block - 1, data), ZX_OK);
+    EXPECT_EQ(nand.write_count_, 0, "partial block should stay buffered");
+    ASSERT_EQ(volume->Write(kGeometry.pages_per_block - 1, 1, data), ZX_OK);
+    EXPECT_EQ(nand.write_count_, 1);
+
+    ASSERT_EQ(volume->Write(kGeometry.pages_per_block, 3, data), ZX_OK);
+    EXPECT_EQ(nand.write_count_, 1);
+    ASSERT_EQ(volume->Flush(), ZX_OK);
+    EXPECT_EQ(nand.write_count_, 2);
+    ASSERT_EQ(volume->Flush(), ZX_OK);
+    EXPECT_EQ(nand.write_count_, 2, "nothing left to flush");
+    END_TEST;
+}
+
+bool RemountTest() {
+    BEGIN_TEST;
+    srand(1);
+    FakeNand nand;
+    fbl::unique_ptr<Volume> volume;
+    ASSERT_EQ(Volume::Create(&nand, kGeometry, fbl::Array<uint32_t>(), &volume), ZX_OK);
+    fbl::Array<uint32_t> contents = MakeContents(*volume);
+    ASSERT_TRUE(WriteRandomPages(volume.get(), 2000, 1, &contents));
+    ASSERT_EQ(volume->Flush(), ZX_OK);
+
+    volume.reset();
+    ASSERT_EQ(Volume::Create(&nand, kGeometry, fbl::Array<uint32_t>(), &volume), ZX_OK);
+    EXPECT_TRUE(CheckContents(volume.get(), contents));
+
+    // The log continues where it was left.
+    ASSERT_TRUE(WriteRandomPages(volume.get(), 2000, 10000, &contents));
+    ASSERT_EQ(volume->Flush(), ZX_OK);
+    volume.reset();
+    ASSERT_EQ(Volume::Create(&nand, kGeometry, fbl::Array<uint32_t>(), &volume), ZX_OK);
+    EXPECT_TRUE(CheckContents(volume.get(), contents));
+    END_TEST;
+}
+
+bool GarbageCollectionTest() {
+    BEGIN_TEST;
+    srand(2);
+    FakeNand nand;
+    fbl::unique_ptr<Volume> volume;
+    ASSERT_EQ(Volume::Create(&nand, kGeometry, fbl::Array<uint32_t>(), &volume), ZX_OK);
+    fbl::Array<uint32_t> contents = MakeContents(*volume);
+
+    // Write the volume over many times.
+    ASSERT_TRUE(WriteRandomPages(volume.get(), 20 * volume->page_count(), 1, &contents));
+    EXPECT_TRUE(CheckContents(volume.get(), contents));
+
+    uint32_t min, max;
+    volume->GetEraseCounts(&min, &max);
+    EXPECT_GT(min, 0);
+    EXPECT_LE(max - min, 64, "erase counts should stay close");
+    END_TEST;
+}
+
+bool BadBlocksTest() {
+    BEGIN_TEST;
+    srand(3);
+    FakeNand nand;
+    fbl::unique_ptr<Volume> volume;
+    ASSERT_EQ(Volume::Create(&nand, kGeometry, fbl::Array<uint32_t>(), &volume), ZX_OK);
+    uint32_t page_count = volume->page_count();
+    fbl::Array<uint32_t> contents = MakeContents(*volume);
+
+    nand.fail_erase_block_ = 5;
+    nand.fail_write_block_ = 7;
+    ASSERT_TRUE(WriteRandomPages(volume.get(), 10 * page_count, 1, &contents));
+    ASSERT_EQ(volume->Flush(), ZX_OK);
+    EXPECT_TRUE(CheckContents(volume.get(), contents));
+    EXPECT_EQ(nand.bad_blocks_.size(), 2);
+
+    // Blocks going bad do not change the capacity.
+    volume.reset();
+    ASSERT_EQ(Volume::Create(&nand, kGeometry, nand.BadBlocks(), &volume), ZX_OK);
+    EXPECT_EQ(volume->page_count(), page_count);
+    EXPECT_TRUE(CheckContents(volume.get(), contents));
+    END_TEST;
+}
+
+} // namespace
+} // namespace ftl
+
+BEGIN_TEST_CASE(FtlVolumeTests)
+RUN_TEST(ftl::EmptyVolumeTest)
+RUN_TEST(ftl::TooManyBadBlocksTest)
+RUN_TEST(ftl::OutOfRangeTest)
+RUN_TEST(ftl::FullBlockProgrammedAtOnceTest)
+RUN_TEST(ftl::RemountTest)
+RUN_TEST(ftl::GarbageCollectionTest)
+RUN_TEST(ftl::BadBlocksTest)
+END_TEST_CASE(FtlVolumeTests);
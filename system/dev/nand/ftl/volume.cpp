@@ -0,0 +1,474 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "volume.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
+
+namespace ftl {
+
+namespace {
+
+constexpr uint32_t kNone = UINT32_MAX;
+
+// Erase blocks kept out of the logical capacity, so that collection always
+// finds blocks holding stale pages, and blocks can go bad.
+constexpr uint32_t kMinSpareBlocks = 6;
+
+// Writes collect garbage before opening a block below this many free blocks;
+// idle time is spent collecting below |kBackgroundFreeBlocks|.
+constexpr uint32_t kForegroundFreeBlocks = 2;
+constexpr uint32_t kBackgroundFreeBlocks = 4;
+
+// Every |kWearLevelingInterval| erases, the least-erased full block is
+// collected if it lags the most-erased one by |kWearLevelingThreshold|.
+constexpr uint32_t kWearLevelingInterval = 64;
+constexpr uint32_t kWearLevelingThreshold = 32;
+
+struct ScannedBlock {
+    uint32_t sequence;
+    uint32_t block;
+    uint32_t written;
+};
+
+int CompareScannedBlocks(const void* a, const void* b) {
+    uint32_t sequence_a = static_cast<const ScannedBlock*>(a)->sequence;
+    uint32_t sequence_b = static_cast<const ScannedBlock*>(b)->sequence;
+    if (sequence_a < sequence_b) {
+        return -1;
+    }
+    return sequence_a > sequence_b ? 1 : 0;
+}
+
+} // namespace
+
+Volume::Volume(NandDriver* driver, const NandGeometry& geometry)
+    : driver_(driver), geometry_(geometry), open_block_(kNone) {}
+
+zx_status_t Volume::Create(NandDriver* driver, const NandGeometry& geometry,
+                           const fbl::Array<uint32_t>& bad_blocks,
+                           fbl::unique_ptr<Volume>* out) {
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<Volume> volume(new (&ac) Volume(driver, geometry));
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    zx_status_t status = volume->Init(bad_blocks);
+    if (status != ZX_OK) {
+        return status;
+    }
+    if ((status = volume->Mount()) != ZX_OK) {
+        return status;
+    }
+    *out = fbl::move(volume);
+    return ZX_OK;
+}
+
+zx_status_t Volume::Init(const fbl::Array<uint32_t>& bad_blocks) {
+    if (geometry_.page_size == 0 || geometry_.pages_per_block == 0 ||
+        geometry_.oob_size < sizeof(PageHeader)) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
+    fbl::AllocChecker ac;
+    blocks_.reset(new (&ac) BlockInfo[geometry_.num_blocks], geometry_.num_blocks);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    for (uint32_t block : bad_blocks) {
+        if (block < geometry_.num_blocks) {
+            blocks_[block].state = BlockState::kBad;
+        }
+    }
+    for (const BlockInfo& info : blocks_) {
+        if (info.state != BlockState::kBad) {
+            usable_blocks_++;
+        }
+    }
+    // The capacity must not change when blocks go bad, so it only depends on
+    // the size of the device; blocks going bad eat into the spares instead.
+    uint32_t spare_blocks = fbl::max(kMinSpareBlocks, geometry_.num_blocks / 16);
+    if (geometry_.num_blocks <= spare_blocks ||
+        usable_blocks_ < geometry_.num_blocks - spare_blocks + kForegroundFreeBlocks) {
+        return ZX_ERR_NO_SPACE;
+    }
+    page_count_ = (geometry_.num_blocks - spare_blocks) * geometry_.pages_per_block;
+
+    size_t physical_pages = static_cast<size_t>(geometry_.num_blocks) * geometry_.pages_per_block;
+    map_.reset(new (&ac) uint32_t[page_count_], page_count_);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    owner_.reset(new (&ac) uint32_t[physical_pages], physical_pages);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    size_t buffer_size = geometry_.pages_per_block * geometry_.page_size;
+    buffer_.reset(new (&ac) uint8_t[buffer_size], buffer_size);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    size_t oob_size = geometry_.pages_per_block * geometry_.oob_size;
+    oob_.reset(new (&ac) uint8_t[oob_size], oob_size);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    memset(map_.get(), 0xff, map_.size() * sizeof(map_[0]));
+    memset(owner_.get(), 0xff, owner_.size() * sizeof(owner_[0]));
+    return ZX_OK;
+}
+
+zx_status_t Volume::Mount() {
+    const uint32_t ppb = geometry_.pages_per_block;
+    fbl::AllocChecker ac;
+    fbl::Array<ScannedBlock> scanned(new (&ac) ScannedBlock[geometry_.num_blocks],
+                                     geometry_.num_blocks);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    size_t scanned_count = 0;
+
+    // Read the headers of every page. The logical pages are parked in
+    // |owner_| until the blocks can be replayed in the order they were
+    // written.
+    for (uint32_t block = 0; block < geometry_.num_blocks; block++) {
+        if (blocks_[block].state == BlockState::kBad) {
+            continue;
+        }
+        zx_status_t status = driver_->Read(block * ppb, ppb, nullptr, oob_.get());
+        if (status != ZX_OK) {
+            return status;
+        }
+        uint32_t sequence = BufferHeader(0)->sequence;
+        uint32_t written = 0;
+        // Pages are programmed in order, so the first page not carrying the
+        // block's sequence number ends the block.
+        while (written < ppb && BufferHeader(written)->sequence == sequence &&
+               BufferHeader(written)->logical_page != kNone) {
+            owner_[block * ppb + written] = BufferHeader(written)->logical_page;
+            written++;
+        }
+        if (written == 0) {
+            free_blocks_++;
+            continue;
+        }
+        blocks_[block].state = BlockState::kFull;
+        blocks_[block].sequence = sequence;
+        scanned[scanned_count++] = {sequence, block, written};
+        next_sequence_ = fbl::max(next_sequence_, sequence + 1);
+    }
+
+    qsort(scanned.get(), scanned_count, sizeof(ScannedBlock), CompareScannedBlocks);
+    for (size_t i = 0; i < scanned_count; i++) {
+        for (uint32_t page = 0; page < scanned[i].written; page++) {
+            uint32_t physical = scanned[i].block * ppb + page;
+            uint32_t logical = owner_[physical];
+            owner_[physical] = kNone;
+            if (logical >= page_count_) {
+                continue;
+            }
+            Unmap(logical);
+            map_[logical] = physical;
+            owner_[physical] = logical;
+            blocks_[scanned[i].block].valid_pages++;
+        }
+    }
+    return ZX_OK;
+}
+
+zx_status_t Volume::Read(uint32_t page, uint32_t count, void* data) {
+    if (page >= page_count_ || count > page_count_ - page) {
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+    const uint32_t ppb = geometry_.pages_per_block;
+    uint8_t* out = static_cast<uint8_t*>(data);
+    uint32_t i = 0;
+    while (i < count) {
+        uint8_t* dest = out + static_cast<size_t>(i) * geometry_.page_size;
+        uint32_t physical = map_[page + i];
+        if (physical == kNone) {
+            memset(dest, 0, geometry_.page_size);
+            i++;
+            continue;
+        }
+        uint32_t block = physical / ppb;
+        uint32_t index = physical % ppb;
+        if (block == open_block_ && index >= programmed_) {
+            memcpy(dest, BufferPage(index), geometry_.page_size);
+            i++;
+            continue;
+        }
+
+        // Read runs of pages which are also contiguous on the nand at once.
+        uint32_t run = 1;
+        while (i + run < count && index + run < ppb && map_[page + i + run] == physical + run &&
+               !(block == open_block_ && index + run >= programmed_)) {
+            run++;
+        }
+        zx_status_t status = driver_->Read(physical, run, dest, nullptr);
+        if (status != ZX_OK) {
+            return status;
+        }
+        i += run;
+    }
+    return ZX_OK;
+}
+
+zx_status_t Volume::Write(uint32_t page, uint32_t count, const void* data) {
+    if (page >= page_count_ || count > page_count_ - page) {
+        return ZX_ERR_OUT_OF_RANGE;
+    }
+    const uint8_t* in = static_cast<const uint8_t*>(data);
+    for (uint32_t i = 0; i < count; i++) {
+        zx_status_t status = Append(page + i, in + static_cast<size_t>(i) * geometry_.page_size);
+        if (status != ZX_OK) {
+            return status;
+        }
+    }
+    return ZX_OK;
+}
+
+zx_status_t Volume::Flush() {
+    return ProgramOpenBlock();
+}
+
+bool Volume::CollectGarbage() {
+    if (free_blocks_ >= kBackgroundFreeBlocks) {
+        return false;
+    }
+    uint32_t victim = PickVictim();
+    if (victim == kNone || Collect(victim) != ZX_OK) {
+        return false;
+    }
+    return free_blocks_ < kBackgroundFreeBlocks;
+}
+
+void Volume::GetEraseCounts(uint32_t* min, uint32_t* max) const {
+    *min = UINT32_MAX;
+    *max = 0;
+    for (const BlockInfo& info : blocks_) {
+        if (info.state != BlockState::kBad) {
+            *min = fbl::min(*min, info.erase_count);
+            *max = fbl::max(*max, info.erase_count);
+        }
+    }
+}
+
+zx_status_t Volume::Append(uint32_t logical_page, const uint8_t* data) {
+    if (open_block_ == kNone) {
+        zx_status_t status = OpenBlock();
+        if (status != ZX_OK) {
+            return status;
+        }
+    }
+
+    uint32_t index = next_page_++;
+    memcpy(BufferPage(index), data, geometry_.page_size);
+    PageHeader* header = BufferHeader(index);
+    header->logical_page = logical_page;
+    header->sequence = blocks_[open_block_].sequence;
+
+    uint32_t physical = open_block_ * geometry_.pages_per_block + index;
+    Unmap(logical_page);
+    map_[logical_page] = physical;
+    owner_[physical] = logical_page;
+    blocks_[open_block_].valid_pages++;
+
+    if (next_page_ == geometry_.pages_per_block) {
+        return ProgramOpenBlock();
+    }
+    return ZX_OK;
+}
+
+zx_status_t Volume::OpenBlock() {
+    if (!collecting_) {
+        for (uint32_t i = 0; free_blocks_ < kForegroundFreeBlocks && i < usable_blocks_; i++) {
+            uint32_t victim = PickVictim();
+            if (victim == kNone) {
+                break;
+            }
+            zx_status_t status = Collect(victim);
+            if (status != ZX_OK) {
+                return status;
+            }
+        }
+        if (open_block_ != kNone) {
+            // Collection opened a block, which still has room.
+            return ZX_OK;
+        }
+    }
+
+    while (free_blocks_ > 0) {
+        // Reuse the least worn block.
+        uint32_t block = kNone;
+        for (uint32_t i = 0; i < geometry_.num_blocks; i++) {
+            if (blocks_[i].state == BlockState::kFree &&
+                (block == kNone || blocks_[i].erase_count < blocks_[block].erase_count)) {
+                block = i;
+            }
+        }
+
+        // Blocks are erased on reuse rather than once collected, so the stale
+        // copies they hold stay behind the new ones until those are written.
+        blocks_[block].erase_count++;
+        erases_since_wear_leveling_++;
+        if (driver_->Erase(block) != ZX_OK) {
+            MarkBad(block);
+            continue;
+        }
+
+        free_blocks_--;
+        blocks_[block].state = BlockState::kOpen;
+        blocks_[block].valid_pages = 0;
+        blocks_[block].sequence = next_sequence_++;
+        open_block_ = block;
+        next_page_ = 0;
+        programmed_ = 0;
+        memset(oob_.get(), 0xff, oob_.size());
+        return ZX_OK;
+    }
+    return ZX_ERR_NO_SPACE;
+}
+
+zx_status_t Volume::ProgramOpenBlock() {
+    if (open_block_ == kNone) {
+        return ZX_OK;
+    }
+    if (programmed_ < next_page_) {
+        zx_status_t status =
+            driver_->Write(open_block_ * geometry_.pages_per_block + programmed_,
+                           next_page_ - programmed_, BufferPage(programmed_),
+                           BufferHeader(programmed_));
+        if (status != ZX_OK) {
+            return RetireOpenBlock();
+        }
+        programmed_ = next_page_;
+    }
+    if (programmed_ == geometry_.pages_per_block) {
+        blocks_[open_block_].state = BlockState::kFull;
+        open_block_ = kNone;
+    }
+    return ZX_OK;
+}
+
+zx_status_t Volume::RetireOpenBlock() {
+    fbl::AllocChecker ac;
+    fbl::Array<uint8_t> pages(new (&ac) uint8_t[buffer_.size()], buffer_.size());
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    memcpy(pages.get(), buffer_.get(), buffer_.size());
+
+    uint32_t block = open_block_;
+    uint32_t count = next_page_;
+    open_block_ = kNone;
+    MarkBad(block);
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t logical = owner_[block * geometry_.pages_per_block + i];
+        if (logical == kNone) {
+            continue;
+        }
+        zx_status_t status = Append(logical, &pages[i * geometry_.page_size]);
+        if (status != ZX_OK) {
+            return status;
+        }
+    }
+    return ZX_OK;
+}
+
+void Volume::MarkBad(uint32_t block) {
+    if (blocks_[block].state == BlockState::kFree) {
+        free_blocks_--;
+    }
+    blocks_[block].state = BlockState::kBad;
+    usable_blocks_--;
+    // The block is not used again before remounting either way, so a failure
+    // to record it only costs another failed erase or program later.
+    driver_->MarkBad(block);
+}
+
+zx_status_t Volume::Collect(uint32_t victim) {
+    fbl::AllocChecker ac;
+    fbl::Array<uint8_t> page(new (&ac) uint8_t[geometry_.page_size], geometry_.page_size);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    zx_status_t status = ZX_OK;
+    collecting_ = true;
+    for (uint32_t i = 0; i < geometry_.pages_per_block && blocks_[victim].valid_pages > 0; i++) {
+        uint32_t physical = victim * geometry_.pages_per_block + i;
+        uint32_t logical = owner_[physical];
+        if (logical == kNone) {
+            continue;
+        }
+        if ((status = driver_->Read(physical, 1, page.get(), nullptr)) != ZX_OK ||
+            (status = Append(logical, page.get())) != ZX_OK) {
+            break;
+        }
+    }
+    collecting_ = false;
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    // The moved pages must be on the nand before the victim can be erased.
+    if ((status = ProgramOpenBlock()) != ZX_OK) {
+        return status;
+    }
+    blocks_[victim].state = BlockState::kFree;
+    free_blocks_++;
+    return ZX_OK;
+}
+
+uint32_t Volume::PickVictim() {
+    const uint32_t ppb = geometry_.pages_per_block;
+    uint32_t victim = kNone;
+    uint32_t coldest = kNone;
+    uint32_t max_erase_count = 0;
+    for (uint32_t i = 0; i < geometry_.num_blocks; i++) {
+        const BlockInfo& info = blocks_[i];
+        if (info.state == BlockState::kBad) {
+            continue;
+        }
+        max_erase_count = fbl::max(max_erase_count, info.erase_count);
+        if (info.state != BlockState::kFull) {
+            continue;
+        }
+        if (coldest == kNone || info.erase_count < blocks_[coldest].erase_count) {
+            coldest = i;
+        }
+        if (info.valid_pages < ppb &&
+            (victim == kNone || info.valid_pages < blocks_[victim].valid_pages ||
+             (info.valid_pages == blocks_[victim].valid_pages &&
+              info.erase_count < blocks_[victim].erase_count))) {
+            victim = i;
+        }
+    }
+
+    if (erases_since_wear_leveling_ >= kWearLevelingInterval) {
+        erases_since_wear_leveling_ = 0;
+        if (coldest != kNone &&
+            max_erase_count - blocks_[coldest].erase_count >= kWearLevelingThreshold) {
+            return coldest;
+        }
+    }
+    return victim;
+}
+
+void Volume::Unmap(uint32_t logical_page) {
+    uint32_t physical = map_[logical_page];
+    if (physical == kNone) {
+        return;
+    }
+    blocks_[physical / geometry_.pages_per_block].valid_pages--;
+    owner_[physical] = kNone;
+    map_[logical_page] = kNone;
+}
+
+} // namespace ftl
@@ -0,0 +1,161 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <fbl/array.h>
+#include <fbl/macros.h>
+#include <fbl/unique_ptr.h>
+#include <zircon/types.h>
+
+namespace ftl {
+
+// Synchronous access to the raw nand below the translation layer.
+class NandDriver {
+public:
+    virtual ~NandDriver() = default;
+
+    // Reads |count| pages, starting at |page|, within a single erase block.
+    // Either |data| (|count| pages) or |oob| (|count| times the oob size) may
+    // be null if that part is not needed.
+    virtual zx_status_t Read(uint32_t page, uint32_t count, void* data, void* oob) = 0;
+
+    // Programs |count| erased pages, starting at |page|, within a single erase
+    // block.
+    virtual zx_status_t Write(uint32_t page, uint32_t count, const void* data,
+                              const void* oob) = 0;
+
+    virtual zx_status_t Erase(uint32_t block) = 0;
+
+    // Records that |block| must not be used anymore.
+    virtual zx_status_t MarkBad(uint32_t block) = 0;
+};
+
+struct NandGeometry {
+    uint32_t page_size;
+    uint32_t pages_per_block;
+    uint32_t num_blocks;
+    uint32_t oob_size;
+};
+
+// Written at the start of the oob area of every page, so the mapping can be
+// rebuilt by scanning the device.
+struct PageHeader {
+    // Logical page stored in the page.
+    uint32_t logical_page;
+    // Sequence number of the erase block, which orders copies of a page.
+    uint32_t sequence;
+};
+
+// A log-structured flash translation layer over a raw nand device.
+//
+// Logical pages are appended to an open erase block, and only reach the nand
+// once a whole erase block is ready or the volume is flushed, so erase blocks
+// are programmed in few, large operations. The complete logical to physical
+// mapping is kept in memory, and rebuilt from the page headers on mount.
+// Space held by stale copies is reclaimed by garbage collection, which moves
+// the live pages of the erase block with the fewest of them to the head of
+// the log; blocks are reused least-erased first, and cold blocks are
+// occasionally collected so their erase cycles are not left unused.
+//
+// This class is not thread-safe.
+class Volume {
+public:
+    DISALLOW_COPY_ASSIGN_AND_MOVE(Volume);
+
+    // Mounts the volume found on |driver|, which must outlive it. Erased
+    // devices are mounted as empty volumes. |bad_blocks| are never used.
+    static zx_status_t Create(NandDriver* driver, const NandGeometry& geometry,
+                              const fbl::Array<uint32_t>& bad_blocks,
+                              fbl::unique_ptr<Volume>* out);
+
+    // Number of logical pages, each |geometry.page_size| bytes.
+    uint32_t page_count() const { return page_count_; }
+
+    // Pages never written read as zeroes.
+    zx_status_t Read(uint32_t page, uint32_t count, void* data);
+    zx_status_t Write(uint32_t page, uint32_t count, const void* data);
+
+    // Programs the pages accepted by |Write| but not yet on the nand.
+    zx_status_t Flush();
+
+    // Reclaims one erase block if free space is below the level kept ahead of
+    // demand. Returns true if more collection would be useful, so idle time
+    // can be spent on it.
+    bool CollectGarbage();
+
+    // Range of erase counts of the usable erase blocks since mount.
+    void GetEraseCounts(uint32_t* min, uint32_t* max) const;
+
+private:
+    enum class BlockState : uint8_t {
+        kFree,
+        kOpen,
+        kFull,
+        kBad,
+    };
+
+    struct BlockInfo {
+        BlockState state = BlockState::kFree;
+        uint32_t valid_pages = 0;
+        uint32_t erase_count = 0;
+        uint32_t sequence = 0;
+    };
+
+    Volume(NandDriver* driver, const NandGeometry& geometry);
+
+    zx_status_t Init(const fbl::Array<uint32_t>& bad_blocks);
+    zx_status_t Mount();
+
+    // Adds a copy of |logical_page| to the open erase block, opening one if
+    // needed, and programs the block once it is full.
+    zx_status_t Append(uint32_t logical_page, const uint8_t* data);
+    zx_status_t OpenBlock();
+    zx_status_t ProgramOpenBlock();
+    // Moves the live pages of the open block, whose programming failed, to a
+    // new block.
+    zx_status_t RetireOpenBlock();
+    void MarkBad(uint32_t block);
+
+    // Collects |victim|, which must be full.
+    zx_status_t Collect(uint32_t victim);
+    // Returns the block to collect next, or |kNone|.
+    uint32_t PickVictim();
+
+    void Unmap(uint32_t logical_page);
+    uint8_t* BufferPage(uint32_t index) { return &buffer_[index * geometry_.page_size]; }
+    PageHeader* BufferHeader(uint32_t index) {
+        return reinterpret_cast<PageHeader*>(&oob_[index * geometry_.oob_size]);
+    }
+
+    NandDriver* const driver_;
+    const NandGeometry geometry_;
+    uint32_t page_count_ = 0;
+    uint32_t usable_blocks_ = 0;
+    uint32_t free_blocks_ = 0;
+    uint32_t next_sequence_ = 0;
+
+    fbl::Array<BlockInfo> blocks_;
+    // Logical to physical page.
+    fbl::Array<uint32_t> map_;
+    // Physical to logical page, for the pages holding the current copy.
+    fbl::Array<uint32_t> owner_;
+
+    // Image of the open erase block. Pages [0, programmed_) are on the nand,
+    // pages [programmed_, next_page_) only here.
+    uint32_t open_block_;
+    uint32_t next_page_ = 0;
+    uint32_t programmed_ = 0;
+    fbl::Array<uint8_t> buffer_;
+    fbl::Array<uint8_t> oob_;
+
+    // Set while pages are moved, so that opening a block does not start
+    // another collection.
+    bool collecting_ = false;
+    uint32_t erases_since_wear_leveling_ = 0;
+};
+
+} // namespace ftl
@@ -36,6 +36,9 @@ void dwc3_cmd_ep_set_config(dwc3_t* dwc, unsigned ep_num, unsigned ep_type,
     uint32_t fifo_num = (EP_OUT(ep_num) || ep_num == EP0_IN ? 0 : ep_num >> 1);
     uint32_t action = (modify ? DEPCFG_DEPCMDPAR0::ACTION_MODIFY
                               : DEPCFG_DEPCMDPAR0::ACTION_INITIALIZE);
+    // bulk and interrupt transfers carry several requests, each of which
+    // interrupts when it is done, so completions are reaped on XferInProgress
+    uint32_t xfer_in_progress = (ep_type == USB_ENDPOINT_CONTROL ? 0 : 1);
 
     DEPCFG_DEPCMDPAR0::Get(ep_num)
         .FromValue(0)
@@ -49,6 +52,7 @@ void dwc3_cmd_ep_set_config(dwc3_t* dwc, unsigned ep_num, unsigned ep_type,
         .set_EP_NUMBER(ep_num)
         .set_INTERVAL(interval)
         .set_XFER_NOT_READY_EN(1)
+        .set_XFER_IN_PROGRESS_EN(xfer_in_progress)
         .set_XFER_COMPLETE_EN(1)
         .set_INTR_NUM(0)
         .WriteTo(mmio);
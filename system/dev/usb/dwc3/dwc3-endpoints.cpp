@@ -17,6 +17,9 @@
 #include <string.h>
 
 #define EP_FIFO_SIZE    PAGE_SIZE
+// largest buffer a TRB of a non-control endpoint is given, a multiple of
+// PAGE_SIZE that fits in TRB_BUFSIZ
+#define EP_TRB_MAX_LENGTH   ((1u << TRB_BUFSIZ_BITS) - PAGE_SIZE)
 
 static zx_paddr_t dwc3_ep_trb_phys(dwc3_endpoint_t* ep, dwc3_trb_t* trb) {
     return io_buffer_phys(&ep->fifo.buffer) + (trb - ep->fifo.first) * sizeof(*trb);
@@ -110,29 +113,171 @@ void dwc3_ep_start_transfer(dwc3_t* dwc, unsigned ep_num, unsigned type, zx_padd
     dwc3_cmd_ep_start_transfer(dwc, ep_num, dwc3_ep_trb_phys(ep, trb));
 }
 
+static void dwc_ep_read_trb(dwc3_endpoint_t* ep, dwc3_trb_t* trb, dwc3_trb_t* out_trb) {
+    if (trb >= ep->fifo.first && trb < ep->fifo.last) {
+        io_buffer_cache_flush_invalidate(&ep->fifo.buffer, (trb - ep->fifo.first) * sizeof(*trb),
+                                         sizeof(*trb));
+        memcpy((void *)out_trb, (void *)trb, sizeof(*trb));
+    } else {
+        zxlogf(ERROR, "dwc_ep_read_trb: bad trb\n");
+    }
+}
+
+static dwc3_trb_t* dwc3_ep_next_trb(dwc3_endpoint_t* ep, dwc3_trb_t* trb) {
+    return ++trb == ep->fifo.last ? ep->fifo.first : trb;
+}
+
+// Fills in the TRB at the tail of the fifo. It is handed to the controller
+// when the transfer starts.
+static dwc3_trb_t* dwc3_ep_write_trb(dwc3_endpoint_t* ep, zx_paddr_t buffer, size_t length,
+                                     uint32_t control) {
+    dwc3_trb_t* trb = ep->fifo.next;
+    ep->fifo.next = dwc3_ep_next_trb(ep, trb);
+
+    trb->ptr_low = (uint32_t)buffer;
+    trb->ptr_high = (uint32_t)(buffer >> 32);
+    trb->status = TRB_BUFSIZ(static_cast<uint32_t>(length));
+    trb->control = control;
+    return trb;
+}
+
+// Returns the number of TRBs |req| needs: one per physically contiguous run
+// of its buffer, plus one for a zero length packet.
+static size_t dwc3_ep_req_trbs(dwc3_t* dwc, dwc3_endpoint_t* ep, usb_request_t* req,
+                               bool send_zlp) {
+    phys_iter_t iter;
+    zx_paddr_t phys;
+    size_t count = 0;
+    usb_request_physmap(req, dwc->bti_handle.get());
+    usb_request_phys_iter_init(&iter, req, EP_TRB_MAX_LENGTH);
+    while (usb_request_phys_iter_next(&iter, &phys) > 0) {
+        count++;
+    }
+    return (count == 0 || send_zlp) ? count + 1 : count;
+}
+
+// Starts a transfer with as many of the queued requests as fit, each as a
+// chain of TRBs that interrupts when it completes. The controller then moves
+// from one request to the next without waiting for us.
 static void dwc3_ep_queue_next_locked(dwc3_t* dwc, dwc3_endpoint_t* ep) {
+    if (ep->xfer_count > 0 || !ep->got_not_ready) {
+        return;
+    }
+
+    // leave one TRB unused so that a full fifo is not mistaken for an empty one
+    size_t trbs_free = ep->fifo.last - ep->fifo.first - 1;
+    dwc3_trb_t* first = ep->fifo.next;
+    dwc3_trb_t* last = nullptr;
     usb_request_t* req;
+    while (ep->xfer_count < DWC3_MAX_XFER_REQS &&
+           (req = list_peek_head_type(&ep->queued_reqs, usb_request_t, node)) != nullptr) {
+        bool send_zlp = req->header.send_zlp && (req->header.length % ep->max_packet_size) == 0;
+        size_t trbs = dwc3_ep_req_trbs(dwc, ep, req, send_zlp);
+        if (trbs > trbs_free) {
+            if (ep->xfer_count == 0) {
+                zxlogf(ERROR, "dwc3_ep_queue_next_locked: request needs %zu TRBs\n", trbs);
+                list_delete(&req->node);
+                usb_request_complete(req, ZX_ERR_OUT_OF_RANGE, 0);
+                continue;
+            }
+            break;
+        }
+        list_delete(&req->node);
+        trbs_free -= trbs;
 
-    if (ep->current_req == nullptr && ep->got_not_ready &&
-        (req = list_remove_head_type(&ep->queued_reqs, usb_request_t, node)) != nullptr) {
-        ep->current_req = req;
-        ep->got_not_ready = false;
         if (EP_IN(ep->ep_num)) {
             usb_request_cache_flush(req, 0, req->header.length);
         } else {
             usb_request_cache_flush_invalidate(req, 0, req->header.length);
         }
 
-        // TODO(voydanoff) scatter/gather support
+        // OUT transfers may end early with a short packet, after which the
+        // controller should carry on with the next request.
+        const uint32_t control = TRB_TRBCTL_NORMAL | (EP_OUT(ep->ep_num) ? TRB_CSP : 0);
+        dwc3_trb_t* req_first = ep->fifo.next;
+        dwc3_trb_t* trb = nullptr;
         phys_iter_t iter;
         zx_paddr_t phys;
-        usb_request_physmap(req, dwc->bti_handle.get());
-        usb_request_phys_iter_init(&iter, req, PAGE_SIZE);
-        usb_request_phys_iter_next(&iter, &phys);
-        bool send_zlp = req->header.send_zlp && (req->header.length % ep->max_packet_size) == 0;
-        dwc3_ep_start_transfer(dwc, ep->ep_num, TRB_TRBCTL_NORMAL, phys, req->header.length,
-                               send_zlp);
+        size_t length;
+        usb_request_phys_iter_init(&iter, req, EP_TRB_MAX_LENGTH);
+        while ((length = usb_request_phys_iter_next(&iter, &phys)) > 0) {
+            if (trb) {
+                trb->control |= TRB_CHN;
+            }
+            trb = dwc3_ep_write_trb(ep, phys, length, control);
+        }
+        if (trb == nullptr || send_zlp) {
+            trb = dwc3_ep_write_trb(ep, 0, 0, control);
+        }
+        trb->control |= TRB_IOC;
+
+        ep->xfer_reqs[ep->xfer_count] = req;
+        ep->xfer_first_trb[ep->xfer_count] = req_first;
+        ep->xfer_last_trb[ep->xfer_count] = trb;
+        ep->xfer_count++;
+        last = trb;
     }
+
+    if (ep->xfer_count == 0) {
+        return;
+    }
+    last->control |= TRB_LST;
+
+    // only now hand the TRBs to the controller
+    for (dwc3_trb_t* trb = first; trb != ep->fifo.next; trb = dwc3_ep_next_trb(ep, trb)) {
+        trb->control |= TRB_HWO;
+        io_buffer_cache_flush(&ep->fifo.buffer, (trb - ep->fifo.first) * sizeof(*trb),
+                              sizeof(*trb));
+    }
+
+    ep->xfer_done = 0;
+    ep->got_not_ready = false;
+    dwc3_cmd_ep_start_transfer(dwc, ep->ep_num, dwc3_ep_trb_phys(ep, first));
+}
+
+// Takes the requests of the current transfer that the controller is done
+// with, all of them if |all|, and returns how many were put in |reqs| and
+// |actuals|.
+static unsigned dwc3_ep_reap_locked(dwc3_endpoint_t* ep, bool all, usb_request_t** reqs,
+                                    zx_off_t* actuals) {
+    // the controller works through the requests in order, so every request
+    // before the last one it has finished is done too
+    unsigned end = ep->xfer_done;
+    if (all) {
+        end = ep->xfer_count;
+    } else {
+        for (unsigned i = ep->xfer_count; i > ep->xfer_done; i--) {
+            dwc3_trb_t trb;
+            dwc_ep_read_trb(ep, ep->xfer_last_trb[i - 1], &trb);
+            if (!(trb.control & TRB_HWO)) {
+                end = i;
+                break;
+            }
+        }
+    }
+
+    unsigned count = 0;
+    for (unsigned i = ep->xfer_done; i < end; i++) {
+        usb_request_t* req = ep->xfer_reqs[i];
+
+        // TRBs skipped after a short packet keep their whole size, so summing
+        // what is left in each gives the residue either way
+        size_t residue = 0;
+        for (dwc3_trb_t* t = ep->xfer_first_trb[i];; t = dwc3_ep_next_trb(ep, t)) {
+            dwc3_trb_t trb;
+            dwc_ep_read_trb(ep, t, &trb);
+            residue += TRB_BUFSIZ(trb.status);
+            if (t == ep->xfer_last_trb[i]) {
+                break;
+            }
+        }
+
+        reqs[count] = req;
+        actuals[count] = residue < req->header.length ? req->header.length - residue : 0;
+        count++;
+    }
+    ep->xfer_done = end;
+    return count;
 }
 
 zx_status_t dwc3_ep_config(dwc3_t* dwc, const usb_endpoint_descriptor_t* ep_desc,
@@ -251,16 +396,6 @@ void dwc3_start_eps(dwc3_t* dwc) {
     }
 }
 
-static void dwc_ep_read_trb(dwc3_endpoint_t* ep, dwc3_trb_t* trb, dwc3_trb_t* out_trb) {
-    if (trb >= ep->fifo.first && trb < ep->fifo.last) {
-        io_buffer_cache_flush_invalidate(&ep->fifo.buffer, (trb - ep->fifo.first) * sizeof(*trb),
-                                         sizeof(*trb));
-        memcpy((void *)out_trb, (void *)trb, sizeof(*trb));
-    } else {
-        zxlogf(ERROR, "dwc_ep_read_trb: bad trb\n");
-    }
-}
-
 void dwc3_ep_xfer_started(dwc3_t* dwc, unsigned ep_num, unsigned rsrc_id) {
     dwc3_endpoint_t* ep = &dwc->eps[ep_num];
     fbl::AutoLock lock(&ep->lock);
@@ -282,6 +417,31 @@ void dwc3_ep_xfer_not_ready(dwc3_t* dwc, unsigned ep_num, unsigned stage) {
     }
 }
 
+static void dwc3_ep_complete_reqs(usb_request_t** reqs, zx_off_t* actuals, unsigned count) {
+    for (unsigned i = 0; i < count; i++) {
+        usb_request_complete(reqs[i], ZX_OK, actuals[i]);
+    }
+}
+
+void dwc3_ep_xfer_in_progress(dwc3_t* dwc, unsigned ep_num) {
+    zxlogf(LTRACE, "dwc3_ep_xfer_in_progress ep %u\n", ep_num);
+
+    if (ep_num < 2 || ep_num >= countof(dwc->eps)) {
+        zxlogf(ERROR, "dwc3_ep_xfer_in_progress: bad ep_num %u\n", ep_num);
+        return;
+    }
+
+    dwc3_endpoint_t* ep = &dwc->eps[ep_num];
+    usb_request_t* reqs[DWC3_MAX_XFER_REQS];
+    zx_off_t actuals[DWC3_MAX_XFER_REQS];
+
+    ep->lock.Acquire();
+    unsigned count = dwc3_ep_reap_locked(ep, false, reqs, actuals);
+    ep->lock.Release();
+
+    dwc3_ep_complete_reqs(reqs, actuals, count);
+}
+
 void dwc3_ep_xfer_complete(dwc3_t* dwc, unsigned ep_num) {
     zxlogf(LTRACE, "dwc3_ep_xfer_complete ep %u state %d\n", ep_num, dwc->ep0_state);
 
@@ -294,29 +454,29 @@ void dwc3_ep_xfer_complete(dwc3_t* dwc, unsigned ep_num) {
         dwc3_ep0_xfer_complete(dwc, ep_num);
     } else {
         dwc3_endpoint_t* ep = &dwc->eps[ep_num];
+        usb_request_t* reqs[DWC3_MAX_XFER_REQS];
+        zx_off_t actuals[DWC3_MAX_XFER_REQS];
 
         ep->lock.Acquire();
-        usb_request_t* req = ep->current_req;
-        ep->current_req = nullptr;
-
-        if (req) {
-            dwc3_trb_t  trb;
-            dwc_ep_read_trb(ep, ep->fifo.current, &trb);
-            ep->fifo.current = nullptr;
-            if (trb.control & TRB_HWO) {
-                zxlogf(ERROR, "TRB_HWO still set in dwc3_ep_xfer_complete\n");
-            }
-
-            zx_off_t actual = req->header.length - TRB_BUFSIZ(trb.status);
-//            dwc3_ep_queue_next_locked(dwc, ep);
-
-            ep->lock.Release();
-
-            usb_request_complete(req, ZX_OK, actual);
-        } else {
+        if (ep->xfer_count == 0) {
             ep->lock.Release();
             zxlogf(ERROR, "dwc3_ep_xfer_complete: no usb request found to complete!\n");
+            return;
+        }
+
+        unsigned count = dwc3_ep_reap_locked(ep, true, reqs, actuals);
+        ep->xfer_count = 0;
+        ep->xfer_done = 0;
+
+        // start on the requests queued meanwhile before completing these, so
+        // the controller is kept busy while their callbacks run
+        ep->got_not_ready = true;
+        if (dwc->configured) {
+            dwc3_ep_queue_next_locked(dwc, ep);
         }
+        ep->lock.Release();
+
+        dwc3_ep_complete_reqs(reqs, actuals, count);
     }
 }
 
@@ -345,10 +505,13 @@ void dwc3_ep_end_transfers(dwc3_t* dwc, unsigned ep_num, zx_status_t reason) {
     dwc3_endpoint_t* ep = &dwc->eps[ep_num];
     fbl::AutoLock lock(&ep->lock);
 
-    if (ep->current_req) {
+    if (ep->xfer_count > 0) {
         dwc3_cmd_ep_end_transfer(dwc, ep_num);
-        usb_request_complete(ep->current_req, reason, 0);
-        ep->current_req = nullptr;
+        for (unsigned i = ep->xfer_done; i < ep->xfer_count; i++) {
+            usb_request_complete(ep->xfer_reqs[i], reason, 0);
+        }
+        ep->xfer_count = 0;
+        ep->xfer_done = 0;
     }
 
     usb_request_t* req;
@@ -21,7 +21,7 @@ static void dwc3_handle_ep_event(dwc3_t* dwc, uint32_t event) {
         dwc3_ep_xfer_complete(dwc, ep_num);
         break;
     case DEPEVT_XFER_IN_PROGRESS:
-        zxlogf(TRACE, "DEPEVT_XFER_IN_PROGRESS ep_num: %u status %u\n", ep_num, status);
+        dwc3_ep_xfer_in_progress(dwc, ep_num);
         break;
     case DEPEVT_XFER_NOT_READY:
         dwc3_ep_xfer_not_ready(dwc, ep_num, DEPEVT_XFER_NOT_READY_STAGE(event));
@@ -35,6 +35,8 @@
 #define EVENT_BUFFER_SIZE   PAGE_SIZE
 #define EP0_MAX_PACKET_SIZE 512
 #define DWC3_MAX_EPS    32
+// maximum number of requests in one transfer on a non-control endpoint
+#define DWC3_MAX_XFER_REQS  16
 
 // converts a USB endpoint address to 0 - 31 index
 #define dwc3_ep_num(addr) ((((addr) & 0xF) << 1) | !!((addr) & USB_DIR_IN))
@@ -60,8 +62,14 @@ typedef struct {
 typedef struct {
     dwc3_fifo_t fifo;
     list_node_t queued_reqs;    // requests waiting to be processed
-    usb_request_t* current_req; // request currently being processed
-    unsigned rsrc_id;           // resource ID for current_req
+    // requests in the transfer currently owned by the controller, in TRB
+    // order, with the first and last TRB of each
+    usb_request_t* xfer_reqs[DWC3_MAX_XFER_REQS];
+    dwc3_trb_t* xfer_first_trb[DWC3_MAX_XFER_REQS];
+    dwc3_trb_t* xfer_last_trb[DWC3_MAX_XFER_REQS];
+    unsigned xfer_count;        // number of requests in the current transfer
+    unsigned xfer_done;         // number of those already completed
+    unsigned rsrc_id;           // resource ID for the current transfer
 
     // Used for synchronizing endpoint state
     // and ep specific hardware registers
@@ -150,6 +158,7 @@ void dwc3_ep_queue(dwc3_t* dwc, unsigned ep_num, usb_request_t* req);
 void dwc3_ep_start_transfer(dwc3_t* dwc, unsigned ep_num, unsigned type, zx_paddr_t buffer,
                             size_t length, bool send_zlp);
 void dwc3_ep_xfer_started(dwc3_t* dwc, unsigned ep_num, unsigned rsrc_id);
+void dwc3_ep_xfer_in_progress(dwc3_t* dwc, unsigned ep_num);
 void dwc3_ep_xfer_complete(dwc3_t* dwc, unsigned ep_num);
 void dwc3_ep_xfer_not_ready(dwc3_t* dwc, unsigned ep_num, unsigned stage);
 zx_status_t dwc3_ep_set_stall(dwc3_t* dwc, unsigned ep_num, bool stall);
@@ -139,6 +139,7 @@ static void usb_device_release(void* ctx) {
     usb_device_t* dev = ctx;
 
     stop_callback_thread(dev);
+    usb_request_pool_release(&dev->free_reqs);
 
     if (dev->config_descs) {
         for (int i = 0; i <  dev->num_configurations; i++) {
@@ -159,17 +160,10 @@ static zx_status_t usb_device_control(void* ctx, uint8_t request_type, uint8_t r
                                       zx_time_t timeout, size_t* out_length) {
     usb_device_t* dev = ctx;
 
-    usb_request_t* req = NULL;
-    bool use_free_list = length == 0;
-    if (use_free_list) {
-        req = usb_request_pool_get(&dev->free_reqs, length);
-    }
-
-    if (req == NULL) {
-        zx_status_t status = usb_request_alloc(&req, length, 0, sizeof(usb_request_t));
-        if (status != ZX_OK) {
-            return status;
-        }
+    usb_request_t* req;
+    zx_status_t status = usb_util_get_control_req(dev, length, &req);
+    if (status != ZX_OK) {
+        return status;
     }
 
     // fill in protocol data
@@ -194,7 +188,7 @@ static zx_status_t usb_device_control(void* ctx, uint8_t request_type, uint8_t r
     // We call this directly instead of via hci_queue, as it's safe to call our
     // own completion callback, and prevents clients getting into odd deadlocks.
     usb_hci_request_queue(&dev->hci, req);
-    zx_status_t status = sync_completion_wait(&completion, timeout);
+    status = sync_completion_wait(&completion, timeout);
 
     if (status == ZX_OK) {
         status = req->response.status;
@@ -217,11 +211,7 @@ static zx_status_t usb_device_control(void* ctx, uint8_t request_type, uint8_t r
         }
     }
 
-    if (use_free_list) {
-        usb_request_pool_add(&dev->free_reqs, req);
-    } else {
-        usb_request_release(req);
-    }
+    usb_util_put_control_req(dev, req);
     return status;
 }
 
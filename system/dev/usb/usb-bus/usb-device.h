@@ -12,12 +12,17 @@
 #include <usb/usb-request.h>
 #include <lib/sync/completion.h>
 #include <zircon/hw/usb.h>
+#include <zircon/limits.h>
 
 #include <threads.h>
 #include <stdatomic.h>
 
 typedef struct usb_bus usb_bus_t;
 
+// Size of the requests kept in usb_device_t.free_reqs.  Control transfers up to
+// this size reuse a pooled request instead of allocating and pinning a new one.
+#define USB_CONTROL_POOL_REQ_SIZE ((size_t)ZX_PAGE_SIZE)
+
 // Represents a USB top-level device
 typedef struct usb_device {
     zx_device_t* zxdev;
@@ -52,7 +57,7 @@ typedef struct usb_device {
     // mutex that protects the callback_* members above
     mtx_t callback_lock;
 
-    // pool of requests that can be reused
+    // pool of control requests that can be reused, all USB_CONTROL_POOL_REQ_SIZE bytes
     usb_request_pool_t free_reqs;
     size_t parent_request_size;
 } usb_device_t;
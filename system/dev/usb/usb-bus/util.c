@@ -27,17 +27,34 @@ static void usb_util_control_complete(usb_request_t* req, void* cookie) {
     sync_completion_signal((sync_completion_t*)cookie);
 }
 
-zx_status_t usb_util_control(usb_device_t* dev, uint8_t request_type, uint8_t request,
-                             uint16_t value, uint16_t index, void* data, size_t length) {
-    usb_request_t* req = NULL;
-    bool use_free_list = length == 0;
-    if (use_free_list) {
-        req = usb_request_pool_get(&dev->free_reqs, length);
+zx_status_t usb_util_get_control_req(usb_device_t* dev, size_t length, usb_request_t** out) {
+    if (length > USB_CONTROL_POOL_REQ_SIZE) {
+        return usb_request_alloc(out, length, 0, sizeof(usb_request_t));
     }
+
+    usb_request_t* req = usb_request_pool_get(&dev->free_reqs, USB_CONTROL_POOL_REQ_SIZE);
     if (req == NULL) {
-        zx_status_t status = usb_request_alloc(&req, length, 0, sizeof(usb_request_t));
+        zx_status_t status = usb_request_alloc(&req, USB_CONTROL_POOL_REQ_SIZE, 0,
+                                               sizeof(usb_request_t));
         if (status != ZX_OK) return status;
     }
+    *out = req;
+    return ZX_OK;
+}
+
+void usb_util_put_control_req(usb_device_t* dev, usb_request_t* req) {
+    if (req->size == USB_CONTROL_POOL_REQ_SIZE) {
+        usb_request_pool_add(&dev->free_reqs, req);
+    } else {
+        usb_request_release(req);
+    }
+}
+
+zx_status_t usb_util_control(usb_device_t* dev, uint8_t request_type, uint8_t request,
+                             uint16_t value, uint16_t index, void* data, size_t length) {
+    usb_request_t* req;
+    zx_status_t status = usb_util_get_control_req(dev, length, &req);
+    if (status != ZX_OK) return status;
 
     // fill in protocol data
     usb_setup_t* setup = &req->setup;
@@ -60,7 +77,7 @@ zx_status_t usb_util_control(usb_device_t* dev, uint8_t request_type, uint8_t re
     req->cookie = &completion;
 
     usb_hci_request_queue(&dev->hci, req);
-    zx_status_t status = sync_completion_wait(&completion, ZX_SEC(1));
+    status = sync_completion_wait(&completion, ZX_SEC(1));
     if (status == ZX_OK) {
         status = req->response.status;
     } else if (status == ZX_ERR_TIMED_OUT) {
@@ -79,11 +96,7 @@ zx_status_t usb_util_control(usb_device_t* dev, uint8_t request_type, uint8_t re
             usb_request_copy_from(req, data, req->response.actual, 0);
         }
     }
-    if (use_free_list) {
-        usb_request_pool_add(&dev->free_reqs, req);
-    } else {
-        usb_request_release(req);
-    }
+    usb_util_put_control_req(dev, req);
     return status;
 }
 
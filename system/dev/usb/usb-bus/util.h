@@ -6,6 +6,13 @@
 
 #include <ddk/device.h>
 
+// Returns a request for a control transfer of |length| bytes.  Requests for
+// transfers of up to USB_CONTROL_POOL_REQ_SIZE bytes come from the device's
+// pool, so that they are allocated and pinned only once; pass them back to
+// usb_util_put_control_req() when done.
+zx_status_t usb_util_get_control_req(usb_device_t* dev, size_t length, usb_request_t** out);
+void usb_util_put_control_req(usb_device_t* dev, usb_request_t* req);
+
 zx_status_t usb_util_control(usb_device_t* dev, uint8_t request_type,  uint8_t request,
                              uint16_t value, uint16_t index, void* data, size_t length);
 
@@ -292,29 +292,38 @@ static zx_status_t xhci_continue_transfer_locked(xhci_t* xhci, xhci_slot_t* slot
         state->needs_status = false;
     }
 
-    // if we get here, then we are ready to ring the doorbell
+    // if we get here, then the transfer is ready for the doorbell, which our
+    // caller rings once for all the transfers it queued
     // update dequeue_ptr to TRB following this transaction
     req->context = (void *)ring->current;
 
-    XHCI_WRITE32(&xhci->doorbells[header->device_id], ep_index + 1);
+    return ZX_OK;
+}
+
+// locked on ep->lock
+static void xhci_ring_ep_doorbell_locked(xhci_t* xhci, uint32_t slot_id, xhci_slot_t* slot,
+                                         uint8_t ep_index) {
+    xhci_endpoint_t* ep = &slot->eps[ep_index];
+
+    XHCI_WRITE32(&xhci->doorbells[slot_id], ep_index + 1);
     // it seems we need to ring the doorbell a second time when transitioning from STOPPED
     while (xhci_get_ep_ctx_state(slot, ep) == EP_CTX_STATE_STOPPED) {
         zx_nanosleep(zx_deadline_after(ZX_MSEC(1)));
-        XHCI_WRITE32(&xhci->doorbells[header->device_id], ep_index + 1);
+        XHCI_WRITE32(&xhci->doorbells[slot_id], ep_index + 1);
     }
-
-    return ZX_OK;
 }
 
 static void xhci_process_transactions_locked(xhci_t* xhci, xhci_slot_t* slot, uint8_t ep_index,
                                              list_node_t* completed_reqs) {
     xhci_endpoint_t* ep = &slot->eps[ep_index];
+    // slot id of the transfers queued on this pass, or zero if there were none
+    uint32_t doorbell_slot_id = 0;
 
     // loop until we fill our transfer ring or run out of requests to process
     while (1) {
         if (xhci_transfer_ring_free_trbs(&ep->transfer_ring) == 0) {
             // no available TRBs - need to wait for some complete
-            return;
+            break;
         }
 
         while (!ep->current_req) {
@@ -322,7 +331,7 @@ static void xhci_process_transactions_locked(xhci_t* xhci, xhci_slot_t* slot, ui
             usb_request_t* req = list_remove_head_type(&ep->queued_reqs, usb_request_t, node);
             if (!req) {
                 // nothing to do
-                return;
+                break;
             }
 
             zx_status_t status = xhci_start_transfer_locked(xhci, slot, ep_index, req);
@@ -336,23 +345,33 @@ static void xhci_process_transactions_locked(xhci_t* xhci, xhci_slot_t* slot, ui
             }
         }
 
-        if (ep->current_req) {
-            usb_request_t* req = ep->current_req;
-            zx_status_t status = xhci_continue_transfer_locked(xhci, slot, ep_index, req);
-            if (status == ZX_ERR_SHOULD_WAIT) {
-                // no available TRBs - need to wait for some complete
-                return;
+        if (!ep->current_req) {
+            // queue is empty
+            break;
+        }
+
+        usb_request_t* req = ep->current_req;
+        zx_status_t status = xhci_continue_transfer_locked(xhci, slot, ep_index, req);
+        if (status == ZX_ERR_SHOULD_WAIT) {
+            // no available TRBs - need to wait for some complete
+            break;
+        } else {
+            if (status == ZX_OK) {
+                doorbell_slot_id = req->header.device_id;
             } else {
-                if (status != ZX_OK) {
-                    req->response.status = status;
-                    req->response.actual = 0;
-                    list_delete(&req->node);
-                    list_add_tail(completed_reqs, &req->node);
-                }
-                ep->current_req = nullptr;
+                req->response.status = status;
+                req->response.actual = 0;
+                list_delete(&req->node);
+                list_add_tail(completed_reqs, &req->node);
             }
+            ep->current_req = nullptr;
         }
     }
+
+    // ring the doorbell once for everything we queued, rather than once per request
+    if (doorbell_slot_id != 0) {
+        xhci_ring_ep_doorbell_locked(xhci, doorbell_slot_id, slot, ep_index);
+    }
 }
 
 zx_status_t xhci_queue_transfer(xhci_t* xhci, usb_request_t* req) {
@@ -192,7 +192,8 @@ void usage(void) {
             "  -b <sz>    tftp block size (default=%d, ignored with --netboot)\n"
             "  -i <NN>    number of microseconds between packets\n"
             "             set between 50-500 to deal with poor bootloader network stacks (default=%d)\n"
-            "             (ignored with --tftp)\n"
+            "             (with --tftp, the spacing starts at zero and grows from this value\n"
+            "             once the target loses packets)\n"
             "  -n         only boot device with this nodename\n"
             "  -w <sz>    tftp window size (default=%d, ignored with --netboot)\n"
             "  --fvm <file>             use the supplied file as a sparse FVM image (up to 4 times)\n"
@@ -16,6 +16,7 @@
 #include <poll.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <unistd.h>
 
 #include <tftp/tftp.h>
@@ -97,13 +98,57 @@ typedef struct {
     bool connected;
     uint32_t previous_timeout_ms;
     struct sockaddr_in6 target_addr;
+
+    // Packets are spaced out by us_between_data, which starts at zero and
+    // grows whenever the session reports that the target lost packets.
+    tftp_session* session;
+    uint32_t lost_windows;
+    int64_t us_between_data;
+    uint32_t sends_since_loss;
+    struct timeval last_send_time;
 } transport_state;
 
 #define SEND_TIMEOUT_US 1000
 
+// Largest spacing between packets we adapt to; at 1024 blocks per window
+// this is well inside the target's timeout.
+#define MAX_US_BETWEEN_DATA 500
+// Number of packets sent without loss before the spacing shrinks by 1us.
+#define SENDS_PER_SPACING_DECREASE 64
+
+// Busy waits, as sleeping would often oversleep the few microseconds needed.
+static void pace_send(transport_state* state) {
+    uint32_t lost_windows = tftp_session_get_lost_windows(state->session);
+    if (lost_windows != state->lost_windows) {
+        state->lost_windows = lost_windows;
+        state->sends_since_loss = 0;
+        state->us_between_data = state->us_between_data ? state->us_between_data * 2
+                                                        : us_between_packets;
+        if (state->us_between_data > MAX_US_BETWEEN_DATA) {
+            state->us_between_data = MAX_US_BETWEEN_DATA;
+        }
+    } else if (++state->sends_since_loss == SENDS_PER_SPACING_DECREASE) {
+        state->sends_since_loss = 0;
+        if (state->us_between_data > 0) {
+            state->us_between_data--;
+        }
+    }
+
+    int64_t us_since_last_send;
+    do {
+        struct timeval now;
+        gettimeofday(&now, NULL);
+        us_since_last_send = (int64_t)(now.tv_sec - state->last_send_time.tv_sec) * 1000000 +
+                             ((int64_t)now.tv_usec - (int64_t)state->last_send_time.tv_usec);
+    } while (us_since_last_send < state->us_between_data);
+}
+
 tftp_status transport_send(void* data, size_t len, void* cookie) {
     transport_state* state = cookie;
     ssize_t send_result;
+    if (state->connected) {
+        pace_send(state);
+    }
     do {
         struct pollfd poll_fds = {.fd = state->socket,
                                   .events = POLLOUT,
@@ -126,6 +171,7 @@ tftp_status transport_send(void* data, size_t len, void* cookie) {
         fprintf(stderr, "%s: Send failed with errno = %d (%s)\n", appname, errno, strerror(errno));
         return TFTP_ERR_IO;
     }
+    gettimeofday(&state->last_send_time, NULL);
     return TFTP_NO_ERROR;
 }
 
@@ -249,6 +295,7 @@ int tftp_xfer(struct sockaddr_in6* addr, const char* fn, const char* name) {
     tftp_transport_interface transport_ifc = {transport_send, transport_recv,
                                               transport_timeout_set};
     tftp_session_set_transport_interface(session, &transport_ifc);
+    ts.session = session;
 
     uint16_t default_block_size = DEFAULT_TFTP_BLOCK_SZ;
     uint16_t default_window_size = DEFAULT_TFTP_WIN_SZ;
@@ -467,6 +467,59 @@ flat::Decl::Kind GetDeclKind(const flat::Library* library, const flat::Type* typ
     return named_decl->kind;
 }
 
+// Returns true if the coding tables check nothing of |type| beyond its
+// size, that is if it holds no handles, out-of-line objects or unions.
+bool IsPlainOldData(const flat::Library* library, const flat::Type* type) {
+    switch (type->kind) {
+    case flat::Type::Kind::kPrimitive:
+        return true;
+    case flat::Type::Kind::kArray:
+        return IsPlainOldData(library,
+                              static_cast<const flat::ArrayType*>(type)->element_type.get());
+    case flat::Type::Kind::kVector:
+    case flat::Type::Kind::kString:
+    case flat::Type::Kind::kHandle:
+    case flat::Type::Kind::kRequestHandle:
+        return false;
+    case flat::Type::Kind::kIdentifier: {
+        auto identifier_type = static_cast<const flat::IdentifierType*>(type);
+        if (identifier_type->nullability == types::Nullability::kNullable)
+            return false;
+        auto named_decl = library->LookupDeclByName(identifier_type->name);
+        assert(named_decl && "library must contain declaration");
+        switch (named_decl->kind) {
+        case flat::Decl::Kind::kEnum:
+            return true;
+        case flat::Decl::Kind::kStruct: {
+            auto struct_decl = static_cast<const flat::Struct*>(named_decl);
+            for (const auto& member : struct_decl->members) {
+                if (!IsPlainOldData(library, member.type.get()))
+                    return false;
+            }
+            return true;
+        }
+        case flat::Decl::Kind::kConst:
+        case flat::Decl::Kind::kInterface:
+        case flat::Decl::Kind::kTable:
+        case flat::Decl::Kind::kUnion:
+            return false;
+        }
+    }
+    }
+    return false;
+}
+
+// Returns true if decoding the message only needs to check its size and that
+// it carries no handles.
+bool IsPlainOldDataMessage(const flat::Library* library,
+                           const CGenerator::NamedMessage& message) {
+    for (const auto& parameter : message.parameters) {
+        if (!IsPlainOldData(library, parameter.type.get()))
+            return false;
+    }
+    return true;
+}
+
 void ArrayCountsAndElementTypeName(const flat::Library* library, const flat::Type* type,
                                    std::vector<uint32_t>* out_array_counts,
                                    std::string* out_element_type_name) {
@@ -1169,9 +1222,18 @@ void CGenerator::ProduceInterfaceServerImplementation(const NamedInterface& name
         if (!method_info.request)
             continue;
         file_ << kIndent << "case " << method_info.ordinal_name << ": {\n";
-        file_ << kIndent << kIndent << "status = fidl_decode_msg(&" << method_info.request->coded_name << ", msg, NULL);\n";
-        file_ << kIndent << kIndent << "if (status != ZX_OK)\n";
-        file_ << kIndent << kIndent << kIndent << "break;\n";
+        if (IsPlainOldDataMessage(library_, *method_info.request)) {
+            file_ << kIndent << kIndent << "// OPTIMIZED AWAY fidl_decode() of POD-only request\n";
+            file_ << kIndent << kIndent << "if (msg->num_bytes != FIDL_ALIGN(sizeof(" << method_info.request->c_name << ")) || msg->num_handles > 0) {\n";
+            file_ << kIndent << kIndent << kIndent << "zx_handle_close_many(msg->handles, msg->num_handles);\n";
+            file_ << kIndent << kIndent << kIndent << "status = ZX_ERR_INVALID_ARGS;\n";
+            file_ << kIndent << kIndent << kIndent << "break;\n";
+            file_ << kIndent << kIndent << "}\n";
+        } else {
+            file_ << kIndent << kIndent << "status = fidl_decode_msg(&" << method_info.request->coded_name << ", msg, NULL);\n";
+            file_ << kIndent << kIndent << "if (status != ZX_OK)\n";
+            file_ << kIndent << kIndent << kIndent << "break;\n";
+        }
         std::vector<Member> request;
         GetMethodParameters(library_, method_info, &request, nullptr);
         if (!request.empty())
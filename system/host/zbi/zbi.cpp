@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
 #include <cerrno>
 #include <climits>
@@ -26,6 +27,7 @@
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/uio.h>
+#include <thread>
 #include <unistd.h>
 #include <utility>
 #include <vector>
@@ -426,7 +428,8 @@ public:
         return result;                                                     \
     }()
 
-    void Init(OutputStream* out, const zbi_header_t& header) {
+    template <typename Stream>
+    void Init(Stream* out, const zbi_header_t& header) {
         header_ = header;
         assert(header_.flags & ZBI_FLAG_STORAGE_COMPRESSED);
         assert(header_.flags & ZBI_FLAG_CRC32);
@@ -466,7 +469,8 @@ public:
     }
 
     // NOTE: Input buffer may be referenced for the life of the Compressor!
-    void Write(OutputStream* out, const iovec& input) {
+    template <typename Stream>
+    void Write(Stream* out, const iovec& input) {
         auto buffer = GetBuffer(LZ4F_compressBound(input.iov_len, &prefs_));
         size_t actual_size = LZ4F_CALL(LZ4F_compressUpdate,
                                        ctx_, buffer.data.get(), buffer.size,
@@ -475,7 +479,8 @@ public:
         WriteBuffer(out, std::move(buffer), actual_size);
     }
 
-    uint32_t Finish(OutputStream* out) {
+    template <typename Stream>
+    uint32_t Finish(Stream* out) {
         // Write the closing chunk from the compressor.
         auto buffer = GetBuffer(LZ4F_compressBound(0, &prefs_));
         size_t actual_size = LZ4F_CALL(LZ4F_compressEnd,
@@ -530,7 +535,8 @@ private:
         }
     }
 
-    void WriteBuffer(OutputStream* out, Buffer buffer, size_t actual_size) {
+    template <typename Stream>
+    void WriteBuffer(Stream* out, Buffer buffer, size_t actual_size) {
         if (actual_size > 0) {
             header_.length += actual_size;
             const iovec iov{buffer.data.get(), actual_size};
@@ -547,6 +553,37 @@ private:
 
 const size_t Compressor::kMinBufferSize;
 
+// This collects the output of a Compressor in memory rather than writing it
+// to a file, so that items can be compressed concurrently before they are
+// streamed out in order.
+class MemoryStream {
+public:
+    void Write(const iovec& buffer,
+               std::unique_ptr<std::byte[]> owned = nullptr) {
+        assert(buffer.iov_len > 0);
+        iovecs_.push_back(buffer);
+        if (owned) {
+            owned_buffers_.push_front(std::move(owned));
+        }
+    }
+
+    // The header is not part of the collected output; it is kept
+    // separately and supplied by PatchHeader.
+    uint32_t PlaceHeader() { return 0; }
+    void PatchHeader(const zbi_header_t& header, uint32_t) { header_ = header; }
+
+    const zbi_header_t& header() const { return header_; }
+    std::list<const iovec>* iovecs() { return &iovecs_; }
+    std::forward_list<std::unique_ptr<std::byte[]>>* owned_buffers() {
+        return &owned_buffers_;
+    }
+
+private:
+    zbi_header_t header_{};
+    std::list<const iovec> iovecs_;
+    std::forward_list<std::unique_ptr<std::byte[]>> owned_buffers_;
+};
+
 constexpr const LZ4F_decompressOptions_t kDecompressOpt{};
 
 std::unique_ptr<std::byte[]> Decompress(const std::list<const iovec>& payload,
@@ -1365,6 +1402,8 @@ Extracted items use the file names shown below:\n\
         uint32_t payload_start = out.WritePosition();
         assert(Aligned(payload_start));
 
+        CompressItems(items);
+
         for (const auto& item : items) {
             // The OutputStream stores pointers into Item buffers in its write
             // queue until it goes out of scope below.  The ItemList keeps all
@@ -1378,6 +1417,40 @@ Extracted items use the file names shown below:\n\
         out.PatchHeader(header, header_start);
     }
 
+    // Compress every item that is still to be compressed, using a thread
+    // per CPU.  Each item is done in memory and then streams out as if it
+    // had already been compressed.  With only one such item there is
+    // nothing to overlap, so that is left to be compressed on the fly
+    // while it is streamed.
+    template <typename ItemList>
+    static void CompressItems(const ItemList& items) {
+        std::vector<Item*> pending;
+        for (const auto& item : items) {
+            if (item->compress_ && !item->payload_.empty()) {
+                pending.push_back(&*item);
+            }
+        }
+        if (pending.size() < 2) {
+            return;
+        }
+
+        size_t n_threads = std::max(std::thread::hardware_concurrency(), 1u);
+        n_threads = std::min(n_threads, pending.size());
+        std::atomic<size_t> next(0);
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < n_threads; ++i) {
+            threads.emplace_back([&]() {
+                size_t index;
+                while ((index = next++) < pending.size()) {
+                    pending[index]->CompressInMemory();
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
     void AppendPayload(std::string* buffer) const {
         if (AlreadyCompressed()) {
             CreateFromCompressed(*this)->AppendPayload(buffer);
@@ -1396,7 +1469,7 @@ private:
     // stored here to own the buffers until the payload is exhausted.
     std::forward_list<FileContents> files_;
     std::forward_list<std::unique_ptr<std::byte[]>> buffers_;
-    const bool compress_;
+    bool compress_;
 
     struct ItemTypeInfo {
         uint32_t type;
@@ -1460,6 +1533,25 @@ private:
         return sizeof(header_) + header_.length;
     }
 
+    // Replace the payload with its compressed form, leaving an item that
+    // is AlreadyCompressed() and streams out raw.
+    void CompressInMemory() {
+        assert(compress_);
+        MemoryStream out;
+        Compressor compressor;
+        compressor.Init(&out, header_);
+        do {
+            compressor.Write(&out, payload_.front());
+            payload_.pop_front();
+        } while (!payload_.empty());
+        compressor.Finish(&out);
+
+        header_ = out.header();
+        payload_.swap(*out.iovecs());
+        buffers_.splice_after(buffers_.before_begin(), *out.owned_buffers());
+        compress_ = false;
+    }
+
     uint32_t StreamCompressed(OutputStream* out) {
         // Compress and checksum the payload.
         Compressor compressor;
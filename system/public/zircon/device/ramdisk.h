@@ -24,6 +24,8 @@
     IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_RAMDISK, 5)
 #define IOCTL_RAMDISK_GET_BLK_COUNTS \
     IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_RAMDISK, 6)
+#define IOCTL_RAMDISK_SET_LATENCY \
+    IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_RAMDISK, 7)
 
 // Ramdisk-specific flags
 #define RAMDISK_FLAG_RESUME_ON_WAKE 0xFF000001
@@ -44,6 +46,18 @@ typedef struct ramdisk_blk_counts {
     uint64_t failed;
 } ramdisk_blk_counts_t;
 
+// Simulated timing of the ramdisk. All zeroes, the default, completes requests
+// as fast as memory allows.
+typedef struct ramdisk_latency {
+    // Fixed cost of each read and write, in nanoseconds.
+    uint64_t request_ns;
+    // Transfer rate of reads and writes, on top of |request_ns|. Zero means
+    // unlimited.
+    uint64_t bytes_per_sec;
+    // Cost of each flush, in nanoseconds.
+    uint64_t flush_ns;
+} ramdisk_latency_t;
+
 // ssize_t ioctl_ramdisk_config(int fd, const ramdisk_ioctl_config_t* in,
 //                              ramdisk_ioctl_config_response_t* out);
 IOCTL_WRAPPER_INOUT(ioctl_ramdisk_config, IOCTL_RAMDISK_CONFIG, ramdisk_ioctl_config_t,
@@ -81,3 +95,9 @@ IOCTL_WRAPPER_IN(ioctl_ramdisk_sleep_after, IOCTL_RAMDISK_SLEEP_AFTER, uint64_t)
 // Retrieve the number of received, successful, and failed block writes since the last call to
 // sleep/wake.
 IOCTL_WRAPPER_OUT(ioctl_ramdisk_get_blk_counts, IOCTL_RAMDISK_GET_BLK_COUNTS, ramdisk_blk_counts_t);
+
+// ssize_t ioctl_ramdisk_set_latency(int fd, const ramdisk_latency_t* in);
+// Makes the ramdisk take as long as |in| describes to service each request.
+// Requests are serviced by several threads, so this models a device with a
+// queue depth greater than one.
+IOCTL_WRAPPER_IN(ioctl_ramdisk_set_latency, IOCTL_RAMDISK_SET_LATENCY, ramdisk_latency_t);
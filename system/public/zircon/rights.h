@@ -32,7 +32,7 @@
     ((ZX_RIGHTS_BASIC & (~ZX_RIGHT_DUPLICATE)) | ZX_RIGHTS_IO)
 
 #define ZX_DEFAULT_IRQ_RIGHTS \
-    (ZX_RIGHTS_BASIC | ZX_RIGHTS_IO | ZX_RIGHT_SIGNAL)
+    (ZX_RIGHTS_BASIC | ZX_RIGHTS_IO | ZX_RIGHT_SIGNAL | ZX_RIGHTS_PROPERTY)
 
 #define ZX_DEFAULT_IO_MAPPING_RIGHTS \
     (ZX_RIGHT_READ | ZX_RIGHT_INSPECT)
@@ -88,7 +88,7 @@
     (ZX_RIGHTS_BASIC & (~ZX_RIGHT_WAIT))
 
 #define ZX_DEFAULT_BTI_RIGHTS \
-    ((ZX_RIGHTS_BASIC & (~ZX_RIGHT_WAIT)) | ZX_RIGHTS_IO | ZX_RIGHT_MAP)
+    ((ZX_RIGHTS_BASIC & (~ZX_RIGHT_WAIT)) | ZX_RIGHTS_IO | ZX_RIGHT_MAP | ZX_RIGHTS_PROPERTY)
 
 #define ZX_DEFAULT_PROFILE_RIGHTS \
     ((ZX_RIGHTS_BASIC & (~ZX_RIGHT_WAIT)) | ZX_RIGHT_APPLY_PROFILE)
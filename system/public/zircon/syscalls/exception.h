@@ -6,6 +6,7 @@
 #define ZIRCON_SYSCALLS_EXCEPTION_H_
 
 #include <zircon/compiler.h>
+#include <zircon/syscalls/debug.h>
 #include <zircon/syscalls/port.h>
 #include <zircon/types.h>
 
@@ -110,6 +111,34 @@ typedef struct zx_exception_report {
     zx_exception_context_t context;
 } zx_exception_report_t;
 
+// The exceptions which can be handled on the faulting thread itself, as bits
+// of zx_thread_exception_handler_t.types. See ZX_PROP_EXCEPTION_HANDLER.
+#define ZX_EXCEPTION_HANDLER_TYPE(excp) ((uint32_t)1u << (((excp) >> 8) & 0x1fu))
+#define ZX_EXCEPTION_HANDLER_TYPES_ALLOWED                          \
+    (ZX_EXCEPTION_HANDLER_TYPE(ZX_EXCP_GENERAL) |                   \
+     ZX_EXCEPTION_HANDLER_TYPE(ZX_EXCP_FATAL_PAGE_FAULT) |          \
+     ZX_EXCEPTION_HANDLER_TYPE(ZX_EXCP_UNDEFINED_INSTRUCTION) |     \
+     ZX_EXCEPTION_HANDLER_TYPE(ZX_EXCP_UNALIGNED_ACCESS))
+
+// The value of ZX_PROP_EXCEPTION_HANDLER.
+typedef struct zx_thread_exception_handler {
+    // The handler's entry point. Zero removes the handler.
+    zx_vaddr_t pc;
+    // The stack the handler runs on, which the thread must not use otherwise.
+    zx_vaddr_t stack_base;
+    size_t stack_size;
+    // ZX_EXCEPTION_HANDLER_TYPE() bits of the exceptions to handle.
+    uint32_t types;
+    uint32_t reserved;
+} zx_thread_exception_handler_t;
+
+// What a ZX_PROP_EXCEPTION_HANDLER handler is called with, at the top of its
+// stack. |regs| are the registers at the time of the exception.
+typedef struct zx_exception_frame {
+    zx_exception_report_t report;
+    zx_thread_state_general_regs_t regs;
+} zx_exception_frame_t;
+
 // Options for zx_task_resume()
 #define ZX_RESUME_EXCEPTION ((uint32_t)1)
 // Indicates that we should resume the thread from stopped-in-exception state
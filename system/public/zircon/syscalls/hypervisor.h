@@ -12,6 +12,9 @@
 __BEGIN_CDECLS
 
 // clang-format off
+// Options for zx_guest_create().
+#define ZX_GUEST_OPT_PREFAULT ((uint32_t) 1u << 0)
+
 typedef uint32_t zx_guest_trap_t;
 
 #define ZX_GUEST_TRAP_BELL ((zx_guest_trap_t) 0u)
@@ -0,0 +1,51 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <zircon/types.h>
+
+__BEGIN_CDECLS
+
+// Layout of the read-only VMO returned by zx_kcounters_get_vmo().
+//
+// The VMO starts with a zx_kcounters_header_t, followed at
+// |descriptor_offset| by |num_counters| zx_kcounter_desc_t entries sorted by
+// name. The kernel never changes this part after boot.
+//
+// The live counter values follow at |data_offset|: an array of
+// |num_counters| int64_t per cpu, with the array of cpu N starting at
+// |data_offset| + N * |cpu_stride|. Each cpu's array starts on its own page.
+// Counter i of cpu N is only ever written by cpu N, one aligned 64-bit store
+// at a time, so readers can load each value without tearing and sum them
+// across cpus. Values read while the kernel runs are approximate.
+
+// ask clang format not to mess up the indentation:
+// clang-format off
+
+#define ZX_KCOUNTERS_MAGIC      (0x544e434bu) // "KCNT"
+#define ZX_KCOUNTER_NAME_LEN    (56u)
+
+// clang-format on
+
+typedef struct zx_kcounters_header {
+    uint32_t magic;
+    uint32_t num_counters;
+    // The number of per-cpu arrays, which may exceed the number of cpus
+    // present. The arrays of absent cpus stay zero.
+    uint32_t max_cpus;
+    uint32_t reserved0;
+    uint64_t descriptor_offset;
+    uint64_t data_offset;
+    uint64_t cpu_stride;
+    uint64_t reserved1[3];
+} zx_kcounters_header_t;
+
+typedef struct zx_kcounter_desc {
+    // The counter name, for example "kernel.handles.new", NUL terminated.
+    char name[ZX_KCOUNTER_NAME_LEN];
+    uint64_t reserved;
+} zx_kcounter_desc_t;
+
+__END_CDECLS
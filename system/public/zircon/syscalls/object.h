@@ -36,6 +36,11 @@ typedef uint32_t zx_object_info_topic_t;
 #define ZX_INFO_PROCESS_HANDLE_STATS    ((zx_object_info_topic_t) 21u) // zx_info_process_handle_stats_t[1]
 #define ZX_INFO_SOCKET                  ((zx_object_info_topic_t) 22u) // zx_info_socket_t[1]
 #define ZX_INFO_VMO                     ((zx_object_info_topic_t) 23u) // zx_info_vmo_t[1]
+#define ZX_INFO_LOCK_STATS              ((zx_object_info_topic_t) 24u) // zx_info_lock_stats_t[n]
+#define ZX_INFO_INTERRUPT               ((zx_object_info_topic_t) 25u) // zx_info_interrupt_t[1]
+#define ZX_INFO_TASK_USAGE              ((zx_object_info_topic_t) 26u) // zx_info_task_usage_t[1]
+#define ZX_INFO_SYSCALL_STATS           ((zx_object_info_topic_t) 27u) // zx_info_syscall_stats_t[n]
+#define ZX_INFO_JOB_CPU_BANDWIDTH       ((zx_object_info_topic_t) 28u) // zx_info_job_cpu_bandwidth_t[1]
 
 typedef uint32_t zx_obj_props_t;
 #define ZX_OBJ_PROP_NONE                ((zx_obj_props_t)0u)
@@ -138,6 +143,23 @@ typedef struct zx_info_task_stats {
     size_t mem_scaled_shared_bytes;
 } zx_info_task_stats_t;
 
+typedef struct zx_info_task_usage {
+    // Usage of a process, or of all the processes that have run in a job or
+    // any of its descendant jobs, including processes that have since
+    // exited. The counters are maintained as the usage happens, so reading
+    // them does not walk the job tree. They lag the true totals by at most a
+    // millisecond of runtime and a few dozen page faults per running thread.
+
+    // Total time the threads have spent running.
+    zx_duration_t cpu_time;
+
+    // Number of times the threads have been switched off a cpu.
+    uint64_t context_switches;
+
+    // Number of page faults the threads have taken on user memory.
+    uint64_t page_faults;
+} zx_info_task_usage_t;
+
 typedef struct zx_info_vmar {
     // Base address of the region.
     uintptr_t base;
@@ -155,6 +177,19 @@ typedef struct zx_info_bti {
 
     // The number of bytes in the device's address space (UINT64_MAX if 2^64).
     uint64_t aspace_size;
+
+    // The value of ZX_PROP_BTI_PIN_CACHE_QUOTA, and the number of bytes of
+    // unpinned buffers currently kept under it.
+    uint64_t pin_cache_quota;
+    uint64_t pin_cache_bytes;
+
+    // The number of zx_bti_pin() calls, while the cache was enabled, that
+    // reused a cached pin or had to pin and map the memory themselves.
+    uint64_t pin_cache_hits;
+    uint64_t pin_cache_misses;
+
+    // The number of cached pins released to stay within the quota.
+    uint64_t pin_cache_evictions;
 } zx_info_bti_t;
 
 typedef struct zx_info_socket {
@@ -289,7 +324,9 @@ typedef struct zx_info_vmo {
 
     // If |ZX_INFO_VMO_TYPE(flags) == ZX_INFO_VMO_TYPE_PAGED|, the amount of
     // memory currently allocated to this VMO; i.e., the amount of physical
-    // memory it consumes. Undefined otherwise.
+    // memory it consumes. Pages that have only been read, or only written
+    // with zeroes, are backed by a shared zero page and are not counted.
+    // Undefined otherwise.
     uint64_t committed_bytes;
 
     // If |flags & ZX_INFO_VMO_VIA_HANDLE|, the handle rights.
@@ -373,6 +410,63 @@ typedef struct zx_info_kmem_stats {
     uint64_t other_bytes;
 } zx_info_kmem_stats_t;
 
+// Number of buckets in the wait and hold time histograms of
+// zx_info_lock_stats_t. Bucket 0 counts times below 256ns, bucket i counts
+// times in [2^(7+i), 2^(8+i))ns and the last bucket counts everything above.
+#define ZX_INFO_LOCK_STATS_BUCKETS 16
+
+// Maximum length of a lock class name, including the terminating NUL.
+#define ZX_INFO_LOCK_STATS_NAME_LEN 128
+
+// Contention statistics of one kernel lock class.
+// Only available in kernels built with lock profiling.
+typedef struct zx_info_lock_stats {
+    // The name of the lock class, possibly truncated.
+    char name[ZX_INFO_LOCK_STATS_NAME_LEN];
+
+    // Identifies the lock class in ktrace lock contention records.
+    uint64_t id;
+
+    // The number of acquisitions, and how many of those had to wait for
+    // another owner.
+    uint64_t acquisitions;
+    uint64_t contentions;
+
+    // Time spent waiting for and holding locks of this class.
+    zx_duration_t total_wait_time;
+    zx_duration_t max_wait_time;
+    zx_duration_t total_hold_time;
+    zx_duration_t max_hold_time;
+
+    // Log2 histograms of the wait and hold times, see above.
+    uint64_t wait_histogram[ZX_INFO_LOCK_STATS_BUCKETS];
+    uint64_t hold_histogram[ZX_INFO_LOCK_STATS_BUCKETS];
+} zx_info_lock_stats_t;
+
+// Number of buckets in the latency histogram of zx_info_syscall_stats_t.
+// Bucket 0 counts calls which took below 128ns, bucket i counts calls which
+// took [2^(6+i), 2^(7+i))ns and the last bucket counts everything above.
+#define ZX_INFO_SYSCALL_STATS_BUCKETS 28
+
+// Counts and latencies of one syscall, made either by one process or by
+// the whole system. Only collected when the kernel is booted with
+// kernel.syscall-stats=true.
+typedef struct zx_info_syscall_stats {
+    // The ZX_SYS_* number of the syscall.
+    uint32_t syscall_num;
+    uint32_t reserved;
+
+    // The number of calls which have returned.
+    uint64_t count;
+
+    // Time spent in the kernel by those calls, including time blocked.
+    zx_duration_t total_time;
+    zx_duration_t max_time;
+
+    // Log2 histogram of the call durations, see above.
+    uint64_t histogram[ZX_INFO_SYSCALL_STATS_BUCKETS];
+} zx_info_syscall_stats_t;
+
 typedef struct zx_info_resource {
     // The resource kind; resource object kinds are detailed in the resource.md
     uint32_t kind;
@@ -387,6 +481,51 @@ typedef struct zx_info_resource {
 
 #define ZX_INFO_CPU_STATS_FLAG_ONLINE       (1u<<0)
 
+typedef struct zx_interrupt_coalesce {
+    // Hold back the packet until this many interrupts are pending.
+    // Zero or one delivers every interrupt as soon as it is acked.
+    uint32_t max_count;
+    uint32_t reserved;
+    // Never hold back a pending interrupt for longer than this.
+    zx_duration_t max_delay;
+} zx_interrupt_coalesce_t;
+
+// Returned in zx_info_interrupt_t.cpu_affinity by interrupts which are
+// delivered wherever the platform routes them by default.
+#define ZX_INFO_INVALID_CPU                 ((uint32_t)0xFFFFFFFFu)
+
+#define ZX_INFO_INTERRUPT_FLAG_VIRTUAL      (1u<<0)
+#define ZX_INFO_INTERRUPT_FLAG_LEVEL        (1u<<1)
+
+typedef struct zx_info_interrupt {
+    // The cpu the interrupt was steered to with ZX_PROP_INTERRUPT_AFFINITY,
+    // or ZX_INFO_INVALID_CPU.
+    uint32_t cpu_affinity;
+    // ZX_INFO_INTERRUPT_FLAG_* bits.
+    uint32_t flags;
+    // The current ZX_PROP_INTERRUPT_COALESCE settings.
+    zx_interrupt_coalesce_t coalesce;
+} zx_info_interrupt_t;
+
+// The value of ZX_PROP_JOB_CPU_BANDWIDTH.
+typedef struct zx_job_cpu_bandwidth {
+    // The cpu time the threads of the job and its descendants may use in
+    // each period, summed over all cpus, so it may exceed |period|. Zero
+    // removes the limit.
+    zx_duration_t quota;
+    zx_duration_t period;
+} zx_job_cpu_bandwidth_t;
+
+typedef struct zx_info_job_cpu_bandwidth {
+    // The current ZX_PROP_JOB_CPU_BANDWIDTH settings.
+    zx_job_cpu_bandwidth_t limit;
+    // The cpu time charged to the current period.
+    zx_duration_t period_used;
+    // The number of periods in which the quota ran out, and the threads of
+    // the job were held back until the next period.
+    uint64_t throttled_periods;
+} zx_info_job_cpu_bandwidth_t;
+
 // Object properties.
 
 // Argument is a char[ZX_MAX_NAME_LEN].
@@ -423,6 +562,31 @@ typedef struct zx_info_resource {
 // Terminate this job if the system is low on memory.
 #define ZX_PROP_JOB_KILL_ON_OOM             15u
 
+// Argument is a zx_interrupt_coalesce_t, controlling how many interrupts a
+// port-bound interrupt object folds into one ZX_PKT_TYPE_INTERRUPT packet.
+#define ZX_PROP_INTERRUPT_COALESCE          16u
+
+// Argument is a uint32_t cpu number. Steers the interrupt to that cpu, for
+// example the one which submits work to the queue the interrupt belongs to.
+// Only some interrupts can be steered; in PCI MSI mode, steering one of a
+// device's interrupts steers all of them.
+#define ZX_PROP_INTERRUPT_AFFINITY          17u
+
+// Argument is a uint64_t, the number of bytes of unpinned buffers a bus
+// transaction initiator keeps pinned and mapped so that pinning them again
+// is cheap. 0, the default, disables this caching.
+#define ZX_PROP_BTI_PIN_CACHE_QUOTA         18u
+
+// Argument is a zx_job_cpu_bandwidth_t. Caps the cpu time used by the
+// threads of a job and all its descendants at |quota| per |period|. The
+// caps of enclosing jobs apply too, so a job cannot escape its parent's.
+#define ZX_PROP_JOB_CPU_BANDWIDTH           19u
+
+// Argument is a zx_thread_exception_handler_t. Runs the handler on the
+// faulting thread for the given exceptions, instead of sending them to the
+// exception ports. Only the current thread may set it.
+#define ZX_PROP_EXCEPTION_HANDLER           20u
+
 // Basic thread states, in zx_info_thread_t.state.
 #define ZX_THREAD_STATE_NEW                 ((zx_thread_state_t) 0x0000u)
 #define ZX_THREAD_STATE_RUNNING             ((zx_thread_state_t) 0x0001u)
@@ -26,10 +26,14 @@ __BEGIN_CDECLS
 #define ZX_PKT_TYPE_GUEST_VCPU      ((uint8_t)0x06u)
 #define ZX_PKT_TYPE_INTERRUPT       ((uint8_t)0x07u)
 #define ZX_PKT_TYPE_EXCEPTION(n)    ((uint32_t)(0x08u | (((n) & 0xFFu) << 8)))
+#define ZX_PKT_TYPE_VMO_OP          ((uint8_t)0x09u)
 
 // For options passed to port_create
 #define ZX_PORT_BIND_TO_INTERRUPT   ((uint32_t)(0x1u << 0))
 
+// Maximum number of packets returned by one zx_port_wait_many()
+#define ZX_PORT_WAIT_MANY_MAX_PACKETS ((uint32_t)16u)
+
 #define ZX_PKT_TYPE_MASK            ((uint32_t)0x000000FFu)
 
 #define ZX_PKT_IS_USER(type)        ((type) == ZX_PKT_TYPE_USER)
@@ -41,6 +45,7 @@ __BEGIN_CDECLS
 #define ZX_PKT_IS_GUEST_VCPU(type)  ((type) == ZX_PKT_TYPE_GUEST_VCPU)
 #define ZX_PKT_IS_INTERRUPT(type)   ((type) == ZX_PKT_TYPE_INTERRUPT)
 #define ZX_PKT_IS_EXCEPTION(type)   (((type) & ZX_PKT_TYPE_MASK) == ZX_PKT_TYPE_EXCEPTION(0))
+#define ZX_PKT_IS_VMO_OP(type)      ((type) == ZX_PKT_TYPE_VMO_OP)
 
 // zx_packet_guest_vcpu_t::type
 #define ZX_PKT_GUEST_VCPU_INTERRUPT  ((uint8_t)0)
@@ -128,9 +133,26 @@ typedef struct zx_packet_guest_vcpu {
 } zx_packet_guest_vcpu_t;
 
 typedef struct zx_packet_interrupt {
+    // The time of the first interrupt folded into this packet.
     zx_time_t timestamp;
+    // The time of the last interrupt folded into this packet.
+    zx_time_t last_timestamp;
+    // The number of interrupts folded into this packet, at least one.
+    uint32_t count;
+    uint32_t reserved0;
+    uint64_t reserved1;
 } zx_packet_interrupt_t;
 
+// port_packet_t::type ZX_PKT_TYPE_VMO_OP. The packet's status is the result
+// of the operation.
+typedef struct zx_packet_vmo_op {
+    uint32_t op;
+    uint32_t reserved0;
+    uint64_t offset;
+    uint64_t size;
+    uint64_t reserved1;
+} zx_packet_vmo_op_t;
+
 typedef struct zx_port_packet {
     uint64_t key;
     uint32_t type;
@@ -144,6 +166,7 @@ typedef struct zx_port_packet {
         zx_packet_guest_io_t guest_io;
         zx_packet_guest_vcpu_t guest_vcpu;
         zx_packet_interrupt_t interrupt;
+        zx_packet_vmo_op_t vmo_op;
     };
 } zx_port_packet_t;
 
@@ -12,6 +12,7 @@ __BEGIN_CDECLS
 // clang-format off
 
 #define ZX_PROFILE_INFO_SCHEDULER   1
+#define ZX_PROFILE_INFO_FAIR        2
 
 typedef struct zx_profile_scheduler {
     int32_t priority;
@@ -26,10 +27,35 @@ typedef struct zx_profile_scheduler {
 #define ZX_PRIORITY_HIGH                24
 #define ZX_PRIORITY_HIGHEST             31
 
+// Weighted-fair scheduling class. Threads in this class are not boosted or
+// deboosted. Within their priority level they are ordered by virtual finish
+// time, and each one gets a share of the cpu proportional to |weight|. A
+// non-zero |deadline_us| bounds how long the thread should wait once it is
+// runnable, relative to other fair threads at the same priority.
+// |perf_hint| is one of ZX_PROFILE_PERF_HINT_ and tells the kernel how to
+// trade energy against performance on the cpus the thread runs on, where
+// the hardware allows it.
+typedef struct zx_profile_fair {
+    int32_t priority;
+    uint32_t weight;
+    uint32_t deadline_us;
+    uint32_t perf_hint;
+} zx_profile_fair_t;
+
+#define ZX_PROFILE_FAIR_WEIGHT_MIN      1
+#define ZX_PROFILE_FAIR_WEIGHT_DEFAULT  1024
+#define ZX_PROFILE_FAIR_WEIGHT_MAX      65536
+#define ZX_PROFILE_FAIR_DEADLINE_MAX_US 1000000
+
+#define ZX_PROFILE_PERF_HINT_NONE       0   // use the system policy
+#define ZX_PROFILE_PERF_HINT_LATENCY    1   // favor performance
+#define ZX_PROFILE_PERF_HINT_EFFICIENCY 2   // favor energy efficiency
+
 typedef struct zx_profile_info {
     uint32_t type;                  // one of ZX_PROFILE_INFO_
     union {
         zx_profile_scheduler_t scheduler;
+        zx_profile_fair_t fair;
     };
 } zx_profile_info_t;
 
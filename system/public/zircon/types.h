@@ -188,6 +188,19 @@ typedef struct zx_channel_call_args {
     uint32_t rd_num_handles;
 } zx_channel_call_args_t;
 
+// Structure for zx_channel_write_many() and zx_channel_read_many().
+// When writing, |bytes| and |handles| are the message and |status| reports
+// whether it was written. When reading, |num_bytes| and |num_handles| give the
+// buffer sizes on input and the message sizes on output.
+typedef struct zx_channel_msg {
+    void* bytes;
+    zx_handle_t* handles;
+    uint32_t num_bytes;
+    uint32_t num_handles;
+    zx_status_t status;
+    uint32_t reserved;
+} zx_channel_msg_t;
+
 // Maximum number of wait items allowed for zx_object_wait_many()
 // TODO(ZX-1349) Re-lower this.
 #define ZX_WAIT_MANY_MAX_ITEMS ((size_t)16)
@@ -199,6 +212,52 @@ typedef struct zx_wait_item {
     zx_signals_t pending;
 } zx_wait_item_t;
 
+// Maximum number of vectors allowed for zx_socket_writev() and zx_socket_readv()
+#define ZX_SOCKET_MAX_IOVECS ((size_t)16)
+
+// Structure for zx_socket_writev() and zx_socket_readv():
+typedef struct zx_iovec {
+    void* buffer;
+    size_t capacity;
+} zx_iovec_t;
+
+// Written at the start of each vector filled by zx_socket_readv() with
+// ZX_SOCKET_DATAGRAM_BATCH. |length| is the full length of the datagram, which
+// exceeds what was copied if the vector was too small to hold it.
+typedef struct zx_socket_datagram_header {
+    uint32_t length;
+    uint32_t reserved;
+} zx_socket_datagram_header_t;
+
+// Operations for zx_batch()
+#define ZX_BATCH_OP_HANDLE_CLOSE        ((uint32_t)1u)
+#define ZX_BATCH_OP_OBJECT_SIGNAL       ((uint32_t)2u)
+#define ZX_BATCH_OP_OBJECT_SIGNAL_PEER  ((uint32_t)3u)
+#define ZX_BATCH_OP_CHANNEL_WRITE       ((uint32_t)4u)
+#define ZX_BATCH_OP_PORT_QUEUE          ((uint32_t)5u)
+
+// Maximum number of operations allowed for zx_batch()
+#define ZX_BATCH_MAX_OPS ((size_t)16)
+
+// Structure for zx_batch(). |op| says which zx_* call the entry stands
+// for and how the other fields map to its arguments:
+//   HANDLE_CLOSE:                 handle
+//   OBJECT_SIGNAL(_PEER):         handle, arg0 = clear_mask, arg1 = set_mask
+//   CHANNEL_WRITE:                handle, ptr0 = bytes, arg0 = num_bytes,
+//                                 ptr1 = handles, arg1 = num_handles
+//   PORT_QUEUE:                   handle, ptr0 = packet
+// |status| receives what that call would have returned.
+typedef struct zx_batch_op {
+    uint32_t op;
+    zx_handle_t handle;
+    uint32_t arg0;
+    uint32_t arg1;
+    const void* ptr0;
+    const void* ptr1;
+    zx_status_t status;
+    uint32_t reserved;
+} zx_batch_op_t;
+
 typedef uint32_t zx_rights_t;
 #define ZX_RIGHT_NONE             ((zx_rights_t)0u)
 #define ZX_RIGHT_DUPLICATE        ((zx_rights_t)1u << 0)
@@ -250,6 +309,17 @@ typedef uint32_t zx_rights_t;
 #define ZX_VMO_OP_CACHE_INVALIDATE       ((uint32_t)7u)
 #define ZX_VMO_OP_CACHE_CLEAN            ((uint32_t)8u)
 #define ZX_VMO_OP_CACHE_CLEAN_INVALIDATE ((uint32_t)9u)
+#define ZX_VMO_OP_COMMIT_ASYNC           ((uint32_t)10u)
+#define ZX_VMO_OP_PREFETCH_ASYNC         ((uint32_t)11u)
+
+// Passed as the buffer of ZX_VMO_OP_COMMIT_ASYNC and ZX_VMO_OP_PREFETCH_ASYNC.
+// A ZX_PKT_TYPE_VMO_OP packet with |key| is queued on |port| once the
+// operation completes.
+typedef struct zx_vmo_op_async {
+    zx_handle_t port;
+    uint32_t options;
+    uint64_t key;
+} zx_vmo_op_async_t;
 
 // VM Object clone flags
 #define ZX_VMO_CLONE_COPY_ON_WRITE        ((uint32_t)1u << 0)
@@ -269,6 +339,7 @@ typedef uint32_t zx_vm_option_t;
 #define ZX_VM_CAN_MAP_EXECUTE       ((zx_vm_option_t)(1u << 9))
 #define ZX_VM_MAP_RANGE             ((zx_vm_option_t)(1u << 10))
 #define ZX_VM_REQUIRE_NON_RESIZABLE ((zx_vm_option_t)(1u << 11))
+#define ZX_VM_NO_FAULT_AROUND       ((zx_vm_option_t)(1u << 12))
 
 
 // virtual address
@@ -312,9 +383,12 @@ typedef uint64_t zx_off_t;
 
 // Channel options and limits.
 #define ZX_CHANNEL_READ_MAY_DISCARD         ((uint32_t)1u)
+// This option can be passed to zx_channel_write()
+#define ZX_CHANNEL_WRITE_MOVE_PAGES         ((uint32_t)1u)
 
 #define ZX_CHANNEL_MAX_MSG_BYTES            ((uint32_t)65536u)
 #define ZX_CHANNEL_MAX_MSG_HANDLES          ((uint32_t)64u)
+#define ZX_CHANNEL_MAX_BATCH_MSGS           ((uint32_t)16u)
 
 // Socket options and limits.
 // These options can be passed to zx_socket_write()
@@ -332,6 +406,37 @@ typedef uint64_t zx_off_t;
 // These can be passed to zx_socket_read() and zx_socket_write().
 #define ZX_SOCKET_CONTROL                   ((uint32_t)1u << 2)
 
+// This option can be passed to zx_socket_write()
+#define ZX_SOCKET_WRITE_MOVE_PAGES          ((uint32_t)1u << 3)
+
+// This option can be passed to zx_socket_writev() and zx_socket_readv() on
+// datagram sockets to transfer one datagram per vector.
+#define ZX_SOCKET_DATAGRAM_BATCH            ((uint32_t)1u << 4)
+
+// Fifo options.
+// This option can be passed to zx_fifo_create()
+#define ZX_FIFO_SHARED                      ((uint32_t)1u << 0)
+
+// The indices of one direction of a ZX_FIFO_SHARED fifo, as laid out in the
+// vmo returned by zx_fifo_get_vmo(). Both count elements since the fifo was
+// created and wrap around; element n lives at index (n & (elem_count - 1)) of
+// the ring's data.
+typedef struct zx_fifo_ring {
+    // Advanced by the producer once elements have been written.
+    uint32_t head;
+    uint32_t reserved0[15];
+    // Advanced by the consumer once elements have been read.
+    uint32_t tail;
+    uint32_t reserved1[15];
+} zx_fifo_ring_t;
+
+// Layout of the vmo of a ZX_FIFO_SHARED fifo. Ring 0 carries elements written
+// to the first endpoint returned by zx_fifo_create(), ring 1 those written to
+// the second.
+#define ZX_FIFO_SHARED_RING_OFFSET(ring)    ((uint64_t)(ring) * sizeof(zx_fifo_ring_t))
+#define ZX_FIFO_SHARED_DATA_OFFSET(ring)    ((uint64_t)((ring) + 1u) * 4096u)
+#define ZX_FIFO_SHARED_VMO_SIZE             ((uint64_t)3u * 4096u)
+
 // Flags which can be used to to control cache policy for APIs which map memory.
 #define ZX_CACHE_POLICY_CACHED              ((uint32_t)0u)
 #define ZX_CACHE_POLICY_UNCACHED            ((uint32_t)1u)
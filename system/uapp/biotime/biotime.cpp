@@ -267,6 +267,8 @@ void usage(void) {
                     "       -live-dangerously  required if using \"-write\"\n"
                     "       -linear       transfers in linear order (default)\n"
                     "       -random       random transfers across total range\n"
+                    "       -sweep        repeat the test with 1, 2, 4, ... up to -mo\n"
+                    "                     outstanding ops, reporting ops/s for each\n"
                     "       -output-file <filename>  destination file for "
                     "writing results in JSON format\n"
                     );
@@ -285,6 +287,7 @@ int main(int argc, char** argv) {
     blkdev_t blk;
 
     bool live_dangerously = false;
+    bool sweep = false;
     bio_random_args_t a = {};
     a.blk = &blk;
     a.xfer = 32768;
@@ -327,6 +330,8 @@ int main(int argc, char** argv) {
             a.linear = true;
         } else if (!strcmp(argv[0], "-random")) {
             a.linear = false;
+        } else if (!strcmp(argv[0], "-sweep")) {
+            sweep = true;
         } else if (!strcmp(argv[0], "-output-file")) {
             needparam();
             output_file = argv[0];
@@ -367,6 +372,26 @@ int main(int argc, char** argv) {
     }
     a.count = total / a.xfer;
 
+    if (sweep) {
+        // With more outstanding ops the driver can spread them across its
+        // io queues, so this shows how throughput scales with them.
+        int max_pending = a.max_pending;
+        for (int mo = 1; mo <= max_pending; mo *= 2) {
+            a.max_pending = mo;
+            a.pending.store(0);
+            sync_completion_reset(&a.signal);
+
+            zx_duration_t res = 0;
+            uint64_t bytes = 0;
+            if (bio_random(&a, &bytes, &res) != ZX_OK) {
+                return -1;
+            }
+            fprintf(stderr, "mo %3d: %zu ops in %zu ns: ", mo, a.count, res);
+            ops_per_second(a.count, res);
+        }
+        return 0;
+    }
+
     zx_duration_t res = 0;
     total = 0;
     if (bio_random(&a, &total, &res) != ZX_OK) {
@@ -74,7 +74,7 @@ int Fsck(fbl::unique_fd fd, blobfs::MountOptions* options) {
         return -1;
     }
 
-    return blobfs::Fsck(fbl::move(blobfs));
+    return blobfs::Fsck(fbl::move(blobfs), !options->verify_in_background);
 }
 
 typedef int (*CommandFunction)(fbl::unique_fd fd, blobfs::MountOptions* options);
@@ -97,6 +97,13 @@ int usage() {
             "\n"
             "options: -r|--readonly  Mount filesystem read-only\n"
             "         -m|--metrics   Collect filesystem metrics\n"
+            "         -c|--cache-size <MB>\n"
+            "                        Keep up to <MB> of closed blobs in memory,\n"
+            "                        evicting the least recently used first\n"
+            "         -b|--verify-in-background\n"
+            "                        When mounting, verify every blob after mount\n"
+            "                        rather than only as it is read; when checking,\n"
+            "                        skip verifying blob contents\n"
             "         -h|--help      Display this message\n"
             "\n"
             "On Fuchsia, blobfs takes the block device argument by handle.\n"
@@ -118,11 +125,13 @@ int ProcessArgs(int argc, char** argv, CommandFunction* func, blobfs::MountOptio
             {"readonly", no_argument, nullptr, 'r'},
             {"metrics", no_argument, nullptr, 'm'},
             {"journal", no_argument, nullptr, 'j'},
+            {"cache-size", required_argument, nullptr, 'c'},
+            {"verify-in-background", no_argument, nullptr, 'b'},
             {"help", no_argument, nullptr, 'h'},
             {nullptr, 0, nullptr, 0},
         };
         int opt_index;
-        int c = getopt_long(argc, argv, "rmjh", opts, &opt_index);
+        int c = getopt_long(argc, argv, "rmjc:bh", opts, &opt_index);
         if (c < 0) {
             break;
         }
@@ -136,6 +145,13 @@ int ProcessArgs(int argc, char** argv, CommandFunction* func, blobfs::MountOptio
         case 'j':
             options->journal = true;
             break;
+        case 'c':
+            options->cache_policy = blobfs::CachePolicy::EvictLru;
+            options->cache_bytes = strtoull(optarg, nullptr, 10) << 20;
+            break;
+        case 'b':
+            options->verify_in_background = true;
+            break;
         case 'h':
         default:
             return usage();
@@ -0,0 +1,446 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Samples the user (and optionally kernel) pc of every cpu each time the
+// unhalted core cycles counter overflows, and writes the samples out in the
+// "folded stacks" format that flame graph tools read:
+//
+//   <process>;<thread>;<module>+0x<offset> <count>
+//
+// The offset is relative to the start of the module's VMO, so it can be
+// fed to a symbolizer along with the module list written by -m.
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
+#include <fbl/unique_fd.h>
+#include <fbl/unique_ptr.h>
+#include <fbl/vector.h>
+#include <inspector/inspector.h>
+#include <lib/zircon-internal/device/cpu-trace/cpu-perf.h>
+#include <task-utils/walker.h>
+#include <zircon/status.h>
+#include <zircon/syscalls.h>
+#include <zircon/syscalls/object.h>
+
+namespace {
+
+constexpr char kDevicePath[] = "/dev/sys/cpu-trace/cpuperf";
+
+// Generate the ids of the fixed events, which every supported cpu has.
+#define DEF_FIXED_EVENT(symbol, event_name, id, regnum, flags, readable_name, description) \
+    constexpr cpuperf_event_id_t k##symbol = CPUPERF_MAKE_EVENT_ID(CPUPERF_GROUP_FIXED, id);
+#include <lib/zircon-internal/device/cpu-trace/intel-pm-events.inc>
+
+struct Sample {
+    zx_koid_t pid;
+    zx_koid_t tid;
+    uint64_t pc;
+};
+
+struct Mapping {
+    char name[ZX_MAX_NAME_LEN];
+    zx_vaddr_t base;
+    size_t size;
+    uint64_t vmo_offset;
+};
+
+struct Process {
+    zx_koid_t koid;
+    char name[ZX_MAX_NAME_LEN];
+    fbl::Vector<Mapping> mappings;
+    inspector_dsoinfo_t* dsos = nullptr;
+};
+
+struct Thread {
+    zx_koid_t koid;
+    char name[ZX_MAX_NAME_LEN];
+};
+
+struct Options {
+    uint32_t seconds = 5;
+    uint32_t rate = 1000000;
+    uint32_t buffer_size = 16u << 20;
+    bool kernel = false;
+    const char* output = nullptr;
+    const char* modules = nullptr;
+};
+
+int CompareSamples(const void* a, const void* b) {
+    auto x = static_cast<const Sample*>(a);
+    auto y = static_cast<const Sample*>(b);
+    if (x->pid != y->pid) {
+        return x->pid < y->pid ? -1 : 1;
+    }
+    if (x->tid != y->tid) {
+        return x->tid < y->tid ? -1 : 1;
+    }
+    if (x->pc != y->pc) {
+        return x->pc < y->pc ? -1 : 1;
+    }
+    return 0;
+}
+
+// The size of the record at |hdr|, or 0 if it is not one we know.
+size_t RecordSize(const cpuperf_record_header_t* hdr) {
+    switch (hdr->type) {
+    case CPUPERF_RECORD_TIME:
+        return sizeof(cpuperf_time_record_t);
+    case CPUPERF_RECORD_TICK:
+        return sizeof(cpuperf_tick_record_t);
+    case CPUPERF_RECORD_COUNT:
+        return sizeof(cpuperf_count_record_t);
+    case CPUPERF_RECORD_VALUE:
+        return sizeof(cpuperf_value_record_t);
+    case CPUPERF_RECORD_PC:
+        return sizeof(cpuperf_pc_record_t);
+    case CPUPERF_RECORD_LAST_BRANCH:
+        return CPUPERF_LAST_BRANCH_RECORD_SIZE(
+            reinterpret_cast<const cpuperf_last_branch_record_t*>(hdr));
+    case CPUPERF_RECORD_THREAD_PC:
+        return sizeof(cpuperf_thread_pc_record_t);
+    default:
+        return 0;
+    }
+}
+
+// Appends the samples in the buffer of cpu |cpu| to |samples|.
+zx_status_t ReadBuffer(int fd, uint32_t cpu, fbl::Vector<Sample>* samples) {
+    ioctl_cpuperf_buffer_handle_req_t req = {cpu};
+    zx_handle_t vmo;
+    ssize_t ret = ioctl_cpuperf_get_buffer_handle(fd, &req, &vmo);
+    if (ret < 0) {
+        return static_cast<zx_status_t>(ret);
+    }
+
+    uint64_t size;
+    zx_status_t status = zx_vmo_get_size(vmo, &size);
+    uintptr_t addr = 0;
+    if (status == ZX_OK) {
+        status = zx_vmar_map(zx_vmar_root_self(), ZX_VM_PERM_READ, 0, vmo, 0, size, &addr);
+    }
+    zx_handle_close(vmo);
+    if (status != ZX_OK) {
+        return status;
+    }
+
+    auto header = reinterpret_cast<const cpuperf_buffer_header_t*>(addr);
+    if (header->flags & CPUPERF_BUFFER_FLAG_FULL) {
+        fprintf(stderr, "cpuperf-profile: cpu %u buffer filled, samples were dropped\n", cpu);
+    }
+    uint64_t end = fbl::min(header->capture_end, size);
+    uint64_t off = sizeof(*header);
+    while (off + sizeof(cpuperf_record_header_t) <= end) {
+        auto hdr = reinterpret_cast<const cpuperf_record_header_t*>(addr + off);
+        size_t len = RecordSize(hdr);
+        if (len == 0 || off + len > end) {
+            fprintf(stderr, "cpuperf-profile: bad record in cpu %u buffer at %#" PRIx64 "\n",
+                    cpu, off);
+            break;
+        }
+        if (hdr->type == CPUPERF_RECORD_THREAD_PC) {
+            auto rec = reinterpret_cast<const cpuperf_thread_pc_record_t*>(hdr);
+            fbl::AllocChecker ac;
+            samples->push_back({rec->pid, rec->tid, rec->pc}, &ac);
+            if (!ac.check()) {
+                status = ZX_ERR_NO_MEMORY;
+                break;
+            }
+        }
+        off += len;
+    }
+
+    zx_vmar_unmap(zx_vmar_root_self(), addr, size);
+    return status;
+}
+
+zx_status_t CollectSamples(const Options& options, fbl::Vector<Sample>* samples) {
+    fbl::unique_fd fd(open(kDevicePath, O_WRONLY));
+    if (!fd) {
+        fprintf(stderr, "cpuperf-profile: cannot open %s\n", kDevicePath);
+        return ZX_ERR_NOT_FOUND;
+    }
+
+    uint32_t num_cpus = zx_system_get_num_cpus();
+    ioctl_cpuperf_alloc_t alloc = {num_cpus, options.buffer_size};
+    ssize_t ret = ioctl_cpuperf_alloc_trace(fd.get(), &alloc);
+    if (ret < 0) {
+        fprintf(stderr, "cpuperf-profile: allocating buffers failed: %zd\n", ret);
+        return static_cast<zx_status_t>(ret);
+    }
+
+    cpuperf_config_t config = {};
+    config.events[0] = kFIXED_UNHALTED_CORE_CYCLES;
+    config.rate[0] = options.rate;
+    config.flags[0] = CPUPERF_CONFIG_FLAG_USER | CPUPERF_CONFIG_FLAG_PC |
+                      CPUPERF_CONFIG_FLAG_THREAD;
+    if (options.kernel) {
+        config.flags[0] |= CPUPERF_CONFIG_FLAG_OS;
+    }
+    ret = ioctl_cpuperf_stage_config(fd.get(), &config);
+    if (ret >= 0) {
+        ret = ioctl_cpuperf_start(fd.get());
+    }
+    if (ret < 0) {
+        fprintf(stderr, "cpuperf-profile: starting the sampler failed: %zd\n", ret);
+        ioctl_cpuperf_free_trace(fd.get());
+        return static_cast<zx_status_t>(ret);
+    }
+
+    zx_nanosleep(zx_deadline_after(ZX_SEC(options.seconds)));
+    ioctl_cpuperf_stop(fd.get());
+
+    zx_status_t status = ZX_OK;
+    for (uint32_t cpu = 0; cpu < num_cpus && status == ZX_OK; cpu++) {
+        status = ReadBuffer(fd.get(), cpu, samples);
+    }
+    ioctl_cpuperf_free_trace(fd.get());
+    return status;
+}
+
+// Gathers the names and mappings of the sampled processes and threads.
+class Symbolizer : public TaskEnumerator {
+public:
+    explicit Symbolizer(const fbl::Vector<Sample>& samples) : samples_(samples) {}
+
+    ~Symbolizer() {
+        for (auto& p : processes_) {
+            if (p.dsos) {
+                inspector_dso_free_list(p.dsos);
+            }
+        }
+    }
+
+    const Process* FindProcess(zx_koid_t koid) const {
+        for (const auto& p : processes_) {
+            if (p.koid == koid) {
+                return &p;
+            }
+        }
+        return nullptr;
+    }
+
+    const Thread* FindThread(zx_koid_t koid) const {
+        for (const auto& t : threads_) {
+            if (t.koid == koid) {
+                return &t;
+            }
+        }
+        return nullptr;
+    }
+
+    const fbl::Vector<Process>& processes() const { return processes_; }
+
+private:
+    bool Sampled(zx_koid_t koid, bool thread) const {
+        for (const auto& s : samples_) {
+            if ((thread ? s.tid : s.pid) == koid) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    zx_status_t OnProcess(int depth, zx_handle_t process, zx_koid_t koid,
+                          zx_koid_t parent_koid) override {
+        if (!Sampled(koid, false)) {
+            return ZX_OK;
+        }
+        Process p;
+        p.koid = koid;
+        zx_object_get_property(process, ZX_PROP_NAME, p.name, sizeof(p.name));
+
+        size_t actual = 0;
+        size_t avail = 0;
+        zx_object_get_info(process, ZX_INFO_PROCESS_MAPS, nullptr, 0, &actual, &avail);
+        fbl::AllocChecker ac;
+        fbl::unique_ptr<zx_info_maps_t[]> maps(new (&ac) zx_info_maps_t[avail]);
+        if (ac.check() &&
+            zx_object_get_info(process, ZX_INFO_PROCESS_MAPS, maps.get(),
+                               avail * sizeof(zx_info_maps_t), &actual, &avail) == ZX_OK) {
+            for (size_t i = 0; i < actual; i++) {
+                const zx_info_maps_t& m = maps[i];
+                if (m.type != ZX_INFO_MAPS_TYPE_MAPPING ||
+                    !(m.u.mapping.mmu_flags & ZX_VM_PERM_EXECUTE)) {
+                    continue;
+                }
+                Mapping mapping;
+                memcpy(mapping.name, m.name, sizeof(mapping.name));
+                mapping.base = m.base;
+                mapping.size = m.size;
+                mapping.vmo_offset = m.u.mapping.vmo_offset;
+                p.mappings.push_back(mapping, &ac);
+                if (!ac.check()) {
+                    return ZX_ERR_NO_MEMORY;
+                }
+            }
+        }
+        p.dsos = inspector_dso_fetch_list(process);
+
+        processes_.push_back(fbl::move(p), &ac);
+        return ac.check() ? ZX_OK : ZX_ERR_NO_MEMORY;
+    }
+
+    zx_status_t OnThread(int depth, zx_handle_t thread, zx_koid_t koid,
+                         zx_koid_t parent_koid) override {
+        if (!Sampled(koid, true)) {
+            return ZX_OK;
+        }
+        Thread t;
+        t.koid = koid;
+        zx_object_get_property(thread, ZX_PROP_NAME, t.name, sizeof(t.name));
+        fbl::AllocChecker ac;
+        threads_.push_back(t, &ac);
+        return ac.check() ? ZX_OK : ZX_ERR_NO_MEMORY;
+    }
+
+    bool has_on_process() const override { return true; }
+    bool has_on_thread() const override { return true; }
+
+    const fbl::Vector<Sample>& samples_;
+    fbl::Vector<Process> processes_;
+    fbl::Vector<Thread> threads_;
+};
+
+void PrintFrame(FILE* f, const Process* process, uint64_t pc) {
+    if (process) {
+        for (const auto& m : process->mappings) {
+            if (pc >= m.base && pc - m.base < m.size) {
+                fprintf(f, "%s+%#" PRIx64, m.name[0] ? m.name : "<anon>",
+                        pc - m.base + m.vmo_offset);
+                return;
+            }
+        }
+    }
+    fprintf(f, "%#" PRIx64, pc);
+}
+
+void WriteProfile(FILE* f, const fbl::Vector<Sample>& samples, const Symbolizer& symbols) {
+    for (size_t i = 0; i < samples.size();) {
+        const Sample& s = samples[i];
+        size_t count = 0;
+        for (; i < samples.size() && CompareSamples(&samples[i], &s) == 0; i++) {
+            count++;
+        }
+
+        if (s.pid == 0) {
+            fprintf(f, "kernel;kernel;");
+        } else {
+            const Process* p = symbols.FindProcess(s.pid);
+            const Thread* t = symbols.FindThread(s.tid);
+            if (p) {
+                fprintf(f, "%s;", p->name);
+            } else {
+                fprintf(f, "pid %" PRIu64 ";", s.pid);
+            }
+            if (t) {
+                fprintf(f, "%s;", t->name);
+            } else {
+                fprintf(f, "tid %" PRIu64 ";", s.tid);
+            }
+        }
+        PrintFrame(f, s.pid ? symbols.FindProcess(s.pid) : nullptr, s.pc);
+        fprintf(f, " %zu\n", count);
+    }
+}
+
+void Usage() {
+    fprintf(stderr,
+            "usage: cpuperf-profile [options]\n"
+            "Samples the pc of all cpus and writes a folded-stack profile.\n"
+            "  -t <seconds>  how long to sample (default 5)\n"
+            "  -r <cycles>   cycles between samples (default 1000000)\n"
+            "  -b <MB>       buffer size per cpu (default 16)\n"
+            "  -k            also sample kernel pcs\n"
+            "  -o <path>     write the profile to <path> instead of stdout\n"
+            "  -m <path>     write the module lists of the sampled processes to <path>\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    int opt;
+    while ((opt = getopt(argc, argv, "t:r:b:ko:m:h")) != -1) {
+        switch (opt) {
+        case 't':
+            options.seconds = static_cast<uint32_t>(strtoul(optarg, nullptr, 0));
+            break;
+        case 'r':
+            options.rate = static_cast<uint32_t>(strtoul(optarg, nullptr, 0));
+            break;
+        case 'b':
+            options.buffer_size = static_cast<uint32_t>(strtoul(optarg, nullptr, 0)) << 20;
+            break;
+        case 'k':
+            options.kernel = true;
+            break;
+        case 'o':
+            options.output = optarg;
+            break;
+        case 'm':
+            options.modules = optarg;
+            break;
+        default:
+            Usage();
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (options.rate == 0 || options.buffer_size == 0) {
+        Usage();
+        return 1;
+    }
+
+    fbl::Vector<Sample> samples;
+    zx_status_t status = CollectSamples(options, &samples);
+    if (status != ZX_OK) {
+        fprintf(stderr, "cpuperf-profile: sampling failed: %s\n", zx_status_get_string(status));
+        return 1;
+    }
+    qsort(samples.get(), samples.size(), sizeof(Sample), CompareSamples);
+
+    // Processes that exited while sampling can no longer be looked up, and
+    // are reported by koid.
+    Symbolizer symbols(samples);
+    status = symbols.WalkRootJobTree();
+    if (status != ZX_OK) {
+        fprintf(stderr, "cpuperf-profile: cannot walk the job tree: %s\n",
+                zx_status_get_string(status));
+    }
+
+    FILE* f = options.output ? fopen(options.output, "w") : stdout;
+    if (!f) {
+        fprintf(stderr, "cpuperf-profile: cannot open %s\n", options.output);
+        return 1;
+    }
+    WriteProfile(f, samples, symbols);
+    if (f != stdout) {
+        fclose(f);
+    }
+
+    if (options.modules) {
+        FILE* m = fopen(options.modules, "w");
+        if (!m) {
+            fprintf(stderr, "cpuperf-profile: cannot open %s\n", options.modules);
+            return 1;
+        }
+        for (const auto& p : symbols.processes()) {
+            fprintf(m, "process %" PRIu64 " %s\n", p.koid, p.name);
+            if (p.dsos) {
+                inspector_dso_print_list(m, p.dsos);
+            }
+        }
+        fclose(m);
+    }
+
+    fprintf(stderr, "cpuperf-profile: %zu samples\n", samples.size());
+    return 0;
+}
@@ -0,0 +1,34 @@
+# Copyright 2018 The Fuchsia Authors. All rights reserved.
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+
+LOCAL_DIR := $(GET_LOCAL_DIR)
+
+MODULE := $(LOCAL_DIR)
+
+MODULE_TYPE := userapp
+MODULE_GROUP := misc
+
+MODULE_SRCS += \
+    $(LOCAL_DIR)/cpuperf-profile.cpp
+
+MODULE_NAME := cpuperf-profile
+
+MODULE_LIBS := \
+    third_party/ulib/backtrace \
+    third_party/ulib/ngunwind \
+    system/ulib/fdio \
+    system/ulib/zircon \
+    system/ulib/c
+
+MODULE_STATIC_LIBS := \
+    system/ulib/elf-search \
+    system/ulib/inspector \
+    system/ulib/fbl \
+    system/ulib/zxcpp \
+    system/ulib/task-utils
+
+MODULE_FIDL_LIBS := \
+    system/fidl/fuchsia-sysinfo
+
+include make/module.mk
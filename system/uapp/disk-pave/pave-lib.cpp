@@ -8,6 +8,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <string.h>
+#include <threads.h>
 
 #include <block-client/cpp/client.h>
 #include <crypto/bytes.h>
@@ -22,6 +23,7 @@
 #include <fvm/fvm-lz4.h>
 #include <fvm/fvm-sparse.h>
 #include <lib/cksum.h>
+#include <lib/sync/completion.h>
 #include <lib/fzl/fdio.h>
 #include <lib/fzl/resizeable-vmo-mapper.h>
 #include <lib/fzl/vmo-mapper.h>
@@ -126,12 +128,108 @@ zx_status_t RegisterFastBlockIo(const fbl::unique_fd& fd, const zx::vmo& vmo,
     return block_client::Client::Create(fbl::move(fifo), client_out);
 }
 
+// Issues block writes on a background thread, so that the caller can read
+// and decompress the next chunk of a partition while the previous chunk is
+// being written. At most one write is outstanding at a time.
+class StreamWriter {
+public:
+    StreamWriter(const block_client::Client& client, const block_fifo_request_t& request)
+        : client_(client), request_(request) {
+        sync_completion_signal(&done_);
+    }
+
+    ~StreamWriter() {
+        if (started_) {
+            Finish();
+        }
+    }
+
+    zx_status_t Start() {
+        if (thrd_create(&thread_, ThreadFunc, this) != thrd_success) {
+            ERROR("Failed to create writer thread\n");
+            return ZX_ERR_NO_RESOURCES;
+        }
+        started_ = true;
+        return ZX_OK;
+    }
+
+    // Waits for the outstanding write, if any, to complete.
+    zx_status_t Wait() {
+        sync_completion_wait(&done_, ZX_TIME_INFINITE);
+        return status_;
+    }
+
+    // Waits for the outstanding write, then queues a write of |length|
+    // blocks from |vmo_offset| to |dev_offset|.
+    zx_status_t Write(uint64_t vmo_offset, uint64_t dev_offset, uint32_t length) {
+        zx_status_t status;
+        if ((status = Wait()) != ZX_OK) {
+            return status;
+        }
+        sync_completion_reset(&done_);
+        request_.length = length;
+        request_.vmo_offset = vmo_offset;
+        request_.dev_offset = dev_offset;
+        sync_completion_signal(&pending_);
+        return ZX_OK;
+    }
+
+    // Waits for the outstanding write and stops the writer thread.
+    zx_status_t Finish() {
+        zx_status_t status = Wait();
+        stop_ = true;
+        sync_completion_signal(&pending_);
+        thrd_join(thread_, nullptr);
+        started_ = false;
+        return status;
+    }
+
+private:
+    static int ThreadFunc(void* arg) {
+        auto* writer = static_cast<StreamWriter*>(arg);
+        for (;;) {
+            sync_completion_wait(&writer->pending_, ZX_TIME_INFINITE);
+            sync_completion_reset(&writer->pending_);
+            if (writer->stop_) {
+                return 0;
+            }
+            writer->status_ = writer->client_.Transaction(&writer->request_, 1);
+            sync_completion_signal(&writer->done_);
+        }
+    }
+
+    const block_client::Client& client_;
+    block_fifo_request_t request_;
+    thrd_t thread_;
+    bool started_ = false;
+    bool stop_ = false;
+    zx_status_t status_ = ZX_OK;
+    // Signalled when a write is queued, or when the thread should stop.
+    sync_completion_t pending_;
+    // Signalled when no write is outstanding.
+    sync_completion_t done_;
+};
+
 // Stream an FVM partition to disk.
+//
+// The buffer is split in two halves, which are filled alternately: while the
+// writer thread writes one half to disk, the next chunk of the image is read
+// into the other.
 zx_status_t StreamFvmPartition(fvm::SparseReader* reader, PartitionInfo* part,
                                const fzl::VmoMapper& mapper, const block_client::Client& client,
                                size_t block_size, block_fifo_request_t* request) {
     size_t slice_size = reader->Image()->slice_size;
-    const size_t vmo_cap = mapper.size();
+    const size_t chunk_cap = fbl::round_down(mapper.size() / 2, block_size);
+    if (chunk_cap == 0) {
+        ERROR("Stream buffer too small for block size %zu\n", block_size);
+        return ZX_ERR_INVALID_ARGS;
+    }
+    StreamWriter writer(client, *request);
+    zx_status_t status;
+    if ((status = writer.Start()) != ZX_OK) {
+        return status;
+    }
+    size_t chunk = 0;
     for (size_t e = 0; e < part->pd->extent_count; e++) {
         LOG("Writing extent %zu... \n", e);
         fvm::extent_descriptor_t* ext = GetExtent(part->pd, e);
@@ -140,13 +238,13 @@ zx_status_t StreamFvmPartition(fvm::SparseReader* reader, PartitionInfo* part,
 
         // Write real data
         while (bytes_left > 0) {
+            // The write queued last used the other half, so this one is free.
+            size_t vmo_offset = chunk * chunk_cap;
             size_t vmo_sz = 0;
-            size_t actual;
-            zx_status_t status = reader->ReadData(
-                &reinterpret_cast<uint8_t*>(mapper.start())[vmo_sz],
-                fbl::min(bytes_left, vmo_cap - vmo_sz), &actual);
-            vmo_sz += actual;
-            bytes_left -= actual;
+            status = reader->ReadData(
+                &reinterpret_cast<uint8_t*>(mapper.start())[vmo_offset],
+                fbl::min(bytes_left, chunk_cap), &vmo_sz);
+            bytes_left -= vmo_sz;
 
             if (vmo_sz == 0) {
                 ERROR("Read nothing from src_fd; %zu bytes left\n", bytes_left);
@@ -164,17 +262,14 @@ zx_status_t StreamFvmPartition(fvm::SparseReader* reader, PartitionInfo* part,
                 ERROR("Error writing partition: Too large\n");
                 return ZX_ERR_OUT_OF_RANGE;
             }
-            request->length = static_cast<uint32_t>(length);
-            request->vmo_offset = 0;
-            request->dev_offset = offset / block_size;
-
-            ssize_t r;
-            if ((r = client.Transaction(request, 1)) != ZX_OK) {
+            if ((status = writer.Write(vmo_offset / block_size, offset / block_size,
+                                       static_cast<uint32_t>(length))) != ZX_OK) {
                 ERROR("Error writing partition data\n");
-                return static_cast<zx_status_t>(r);
+                return status;
             }
 
             offset += vmo_sz;
+            chunk ^= 1;
         }
 
         // Write trailing zeroes (which are implied, but were omitted from
@@ -182,28 +277,33 @@ zx_status_t StreamFvmPartition(fvm::SparseReader* reader, PartitionInfo* part,
         bytes_left = (ext->slice_count * slice_size) - ext->extent_length;
         if (bytes_left > 0) {
             LOG("%zu bytes written, %zu zeroes left\n", ext->extent_length, bytes_left);
-            memset(mapper.start(), 0, vmo_cap);
+            if ((status = writer.Wait()) != ZX_OK) {
+                ERROR("Error writing partition data\n");
+                return status;
+            }
+            memset(mapper.start(), 0, 2 * chunk_cap);
         }
         while (bytes_left > 0) {
-            uint64_t length = fbl::min(bytes_left, vmo_cap) / block_size;
+            uint64_t length = fbl::min(bytes_left, chunk_cap) / block_size;
             if (length > UINT32_MAX) {
                 ERROR("Error writing trailing zeroes: Too large\n");
                 return ZX_ERR_OUT_OF_RANGE;
             }
-            request->length = static_cast<uint32_t>(length);
-            request->vmo_offset = 0;
-            request->dev_offset = offset / block_size;
-
-            zx_status_t status;
-            if ((status = client.Transaction(request, 1)) != ZX_OK) {
+            if ((status = writer.Write(chunk * chunk_cap / block_size, offset / block_size,
+                                       static_cast<uint32_t>(length))) != ZX_OK) {
                 ERROR("Error writing trailing zeroes\n");
                 return status;
             }
 
-            offset += request->length * block_size;
-            bytes_left -= request->length * block_size;
+            offset += length * block_size;
+            bytes_left -= length * block_size;
+            chunk ^= 1;
         }
     }
+    if ((status = writer.Finish()) != ZX_OK) {
+        ERROR("Error writing partition data\n");
+        return status;
+    }
     return ZX_OK;
 }
 
@@ -761,7 +861,8 @@ zx_status_t FvmStreamPartitions(fbl::unique_fd partition_fd, fbl::unique_fd src_
 
     LOG("Partition space pre-allocated successfully.\n");
 
-    constexpr size_t vmo_size = 1 << 20;
+    // Two 1MiB chunks; see StreamFvmPartition.
+    constexpr size_t vmo_size = 2 << 20;
 
     fzl::VmoMapper mapping;
     zx::vmo vmo;
@@ -0,0 +1,157 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fbl/atomic.h>
+#include <fbl/vector.h>
+#include <lib/zx/channel.h>
+#include <lib/zx/time.h>
+#include <zircon/status.h>
+#include <zircon/syscalls.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <threads.h>
+
+#include "stress_test.h"
+
+class IpcStressTest : public StressTest {
+public:
+    IpcStressTest() = default;
+    virtual ~IpcStressTest() = default;
+
+    virtual zx_status_t Start();
+    virtual zx_status_t Stop();
+
+    virtual const char* name() const { return "IPC Stress"; }
+
+private:
+    static constexpr uint32_t kMessageSize = 64;
+
+    struct Pair {
+        IpcStressTest* test;
+        zx::channel client;
+        zx::channel server;
+        thrd_t client_thread;
+        thrd_t server_thread;
+    };
+
+    int client_thread(Pair* pair);
+    int server_thread(Pair* pair);
+
+    fbl::Vector<fbl::unique_ptr<Pair>> pairs_;
+
+    // used by the worker threads at runtime
+    fbl::atomic<bool> shutdown_{false};
+    LatencyHistogram latency_;
+};
+
+// our singleton
+IpcStressTest ipcstress;
+
+// IPC Stresser
+//
+// Runs a client and a server thread per cpu, connected by a channel. Each
+// client sends a small message to its server, which sends it straight back,
+// about a thousand times a second, and records the round trip time. Unlike
+// the perftest IPC benchmarks the clients pause between messages, so that
+// every round trip includes waking up a blocked thread on each side.
+
+int IpcStressTest::client_thread(Pair* pair) {
+    constexpr zx_duration_t kMinPeriod = ZX_USEC(500);
+    constexpr zx_duration_t kMaxPeriod = ZX_USEC(1500);
+
+    unsigned int seed = static_cast<unsigned int>(zx_ticks_get());
+    uint8_t buf[kMessageSize] = {};
+    while (!shutdown_.load()) {
+        zx::time start = zx::clock::get_monotonic();
+        zx_status_t status = pair->client.write(0, buf, sizeof(buf), nullptr, 0);
+        if (status == ZX_OK) {
+            status = pair->client.wait_one(ZX_CHANNEL_READABLE, zx::time::infinite(), nullptr);
+        }
+        if (status == ZX_OK) {
+            status = pair->client.read(0, buf, sizeof(buf), nullptr, nullptr, 0, nullptr);
+        }
+        if (status != ZX_OK) {
+            fprintf(stderr, "ipc client error %d (%s)\n", status, zx_status_get_string(status));
+            break;
+        }
+        zx::time end = zx::clock::get_monotonic();
+        latency_.Add((end - start).get());
+
+        zx::nanosleep(start + zx::duration(kMinPeriod + rand_r(&seed) % (kMaxPeriod - kMinPeriod)));
+    }
+
+    // closing our end tells the server to exit
+    pair->client.reset();
+    return 0;
+}
+
+int IpcStressTest::server_thread(Pair* pair) {
+    uint8_t buf[kMessageSize];
+    for (;;) {
+        zx_signals_t observed;
+        zx_status_t status = pair->server.wait_one(ZX_CHANNEL_READABLE | ZX_CHANNEL_PEER_CLOSED,
+                                                   zx::time::infinite(), &observed);
+        if (status != ZX_OK || !(observed & ZX_CHANNEL_READABLE)) {
+            break;
+        }
+        uint32_t actual;
+        status = pair->server.read(0, buf, sizeof(buf), &actual, nullptr, 0, nullptr);
+        if (status == ZX_OK) {
+            status = pair->server.write(0, buf, actual, nullptr, 0);
+        }
+        if (status != ZX_OK) {
+            fprintf(stderr, "ipc server error %d (%s)\n", status, zx_status_get_string(status));
+            break;
+        }
+    }
+
+    return 0;
+}
+
+zx_status_t IpcStressTest::Start() {
+    auto client_worker = [](void* arg) -> int {
+        Pair* pair = static_cast<Pair*>(arg);
+
+        return pair->test->client_thread(pair);
+    };
+    auto server_worker = [](void* arg) -> int {
+        Pair* pair = static_cast<Pair*>(arg);
+
+        return pair->test->server_thread(pair);
+    };
+
+    for (uint32_t i = 0; i < num_cpus_; i++) {
+        fbl::unique_ptr<Pair> pair(new Pair);
+        pair->test = this;
+        zx_status_t status = zx::channel::create(0, &pair->client, &pair->server);
+        if (status != ZX_OK) {
+            return status;
+        }
+        if (thrd_create_with_name(&pair->server_thread, server_worker, pair.get(),
+                                  "ipcstress_server") != thrd_success) {
+            return ZX_ERR_NO_RESOURCES;
+        }
+        if (thrd_create_with_name(&pair->client_thread, client_worker, pair.get(),
+                                  "ipcstress_client") != thrd_success) {
+            return ZX_ERR_NO_RESOURCES;
+        }
+        pairs_.push_back(fbl::move(pair));
+    }
+
+    return ZX_OK;
+}
+
+zx_status_t IpcStressTest::Stop() {
+    shutdown_.store(true);
+
+    for (auto& pair : pairs_) {
+        thrd_join(pair->client_thread, nullptr);
+        thrd_join(pair->server_thread, nullptr);
+    }
+
+    latency_.Print("ipc round trip latency");
+
+    return ZX_OK;
+}
@@ -10,9 +10,11 @@ MODULE_TYPE := userapp
 MODULE_GROUP := misc
 
 MODULE_SRCS += \
+    $(LOCAL_DIR)/ipcstress.cpp \
     $(LOCAL_DIR)/main.cpp \
     $(LOCAL_DIR)/stress_test.cpp \
-    $(LOCAL_DIR)/vmstress.cpp
+    $(LOCAL_DIR)/vmstress.cpp \
+    $(LOCAL_DIR)/wakeupstress.cpp \
 
 MODULE_LIBS := \
     system/ulib/c \
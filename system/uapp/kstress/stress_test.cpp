@@ -4,4 +4,57 @@
 
 #include "stress_test.h"
 
+#include <inttypes.h>
+#include <stdio.h>
+
 fbl::Vector<StressTest*> StressTest::tests_;
+
+void LatencyHistogram::Add(zx_duration_t latency) {
+    if (latency < 0) {
+        latency = 0;
+    }
+    size_t bucket = 0;
+    if (latency > 0) {
+        bucket = 64 - __builtin_clzll(static_cast<uint64_t>(latency));
+        if (bucket >= kNumBuckets) {
+            bucket = kNumBuckets - 1;
+        }
+    }
+    buckets_[bucket].fetch_add(1);
+    count_.fetch_add(1);
+
+    zx_duration_t max = max_.load();
+    while (latency > max && !max_.compare_exchange_weak(&max, latency, fbl::memory_order_relaxed,
+                                                          fbl::memory_order_relaxed)) {
+    }
+}
+
+zx_duration_t LatencyHistogram::Percentile(uint32_t percent) const {
+    const uint64_t count = count_.load();
+    if (count == 0) {
+        return 0;
+    }
+    // The index of the value we are after, counting from 1.
+    const uint64_t rank = (count * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kNumBuckets; i++) {
+        seen += buckets_[i].load();
+        if (seen >= rank) {
+            return i == 0 ? 0 : static_cast<zx_duration_t>(1ull << i);
+        }
+    }
+    return max_.load();
+}
+
+void LatencyHistogram::Print(const char* label) const {
+    printf("%s: %" PRIu64 " samples, p50 < %" PRId64 " ns, p99 < %" PRId64
+           " ns, max %" PRId64 " ns\n",
+           label, count_.load(), Percentile(50), Percentile(99), max_.load());
+    for (size_t i = 0; i < kNumBuckets; i++) {
+        uint64_t value = buckets_[i].load();
+        if (value == 0) {
+            continue;
+        }
+        printf("  < %20" PRIu64 " ns: %" PRIu64 "\n", i == 0 ? 1ull : 1ull << i, value);
+    }
+}
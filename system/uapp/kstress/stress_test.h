@@ -6,12 +6,40 @@
 
 #include <stdarg.h>
 
+#include <fbl/atomic.h>
 #include <fbl/macros.h>
 #include <fbl/vector.h>
 #include <fbl/unique_ptr.h>
 #include <zircon/status.h>
 #include <zircon/syscalls.h>
 
+// Counts latencies in power-of-two buckets: bucket |i| counts values in
+// [2^(i-1), 2^i) nanoseconds, and bucket 0 counts zeros. Safe to update from
+// several threads at once.
+class LatencyHistogram {
+public:
+    static constexpr size_t kNumBuckets = 48;
+
+    LatencyHistogram() = default;
+
+    void Add(zx_duration_t latency);
+
+    // Prints the count, an upper bound on the median, 99th percentile and
+    // max, and every non-empty bucket.
+    void Print(const char* label) const;
+
+    DISALLOW_COPY_ASSIGN_AND_MOVE(LatencyHistogram);
+
+private:
+    // Returns the upper bound of the bucket below which |percent| of the
+    // values fall.
+    zx_duration_t Percentile(uint32_t percent) const;
+
+    fbl::atomic<uint64_t> buckets_[kNumBuckets]{};
+    fbl::atomic<uint64_t> count_{0};
+    fbl::atomic<zx_duration_t> max_{0};
+};
+
 class StressTest {
 public:
     StressTest() {
@@ -0,0 +1,96 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fbl/atomic.h>
+#include <fbl/vector.h>
+#include <lib/zx/time.h>
+#include <zircon/syscalls.h>
+
+#include <stdlib.h>
+#include <threads.h>
+
+#include "stress_test.h"
+
+class WakeupStressTest : public StressTest {
+public:
+    WakeupStressTest() = default;
+    virtual ~WakeupStressTest() = default;
+
+    virtual zx_status_t Start();
+    virtual zx_status_t Stop();
+
+    virtual const char* name() const { return "Wakeup Stress"; }
+
+private:
+    int stress_thread();
+
+    fbl::Vector<thrd_t> threads_;
+
+    // used by the worker threads at runtime
+    fbl::atomic<bool> shutdown_{false};
+    LatencyHistogram latency_;
+};
+
+// our singleton
+WakeupStressTest wakeupstress;
+
+// Wakeup Stresser
+//
+// Runs two threads per cpu, each of which sleeps until a deadline roughly a
+// millisecond after the previous one, so that the scheduler and timer code
+// are kept busy with a steady stream of wakeups. Records how late each thread
+// is woken relative to its deadline.
+//
+// The period is jittered so that the threads do not all wake at once.
+
+int WakeupStressTest::stress_thread() {
+    constexpr zx_duration_t kMinPeriod = ZX_USEC(500);
+    constexpr zx_duration_t kMaxPeriod = ZX_USEC(1500);
+
+    unsigned int seed = static_cast<unsigned int>(zx_ticks_get());
+    zx::time deadline = zx::clock::get_monotonic();
+    while (!shutdown_.load()) {
+        deadline += zx::duration(kMinPeriod + rand_r(&seed) % (kMaxPeriod - kMinPeriod));
+        zx::nanosleep(deadline);
+        zx::time now = zx::clock::get_monotonic();
+        latency_.Add((now - deadline).get());
+
+        // if we fell behind, don't try to catch up
+        if (now > deadline) {
+            deadline = now;
+        }
+    }
+
+    return 0;
+}
+
+zx_status_t WakeupStressTest::Start() {
+    auto worker = [](void* arg) -> int {
+        WakeupStressTest* test = static_cast<WakeupStressTest*>(arg);
+
+        return test->stress_thread();
+    };
+
+    for (uint32_t i = 0; i < num_cpus_ * 2; i++) {
+        thrd_t t;
+        if (thrd_create_with_name(&t, worker, this, "wakeupstress_worker") != thrd_success) {
+            return ZX_ERR_NO_RESOURCES;
+        }
+        threads_.push_back(t);
+    }
+
+    return ZX_OK;
+}
+
+zx_status_t WakeupStressTest::Stop() {
+    shutdown_.store(true);
+
+    for (auto& t : threads_) {
+        thrd_join(t, nullptr);
+    }
+
+    latency_.Print("wakeup latency");
+
+    return ZX_OK;
+}
@@ -256,3 +256,28 @@ MODULE_FIDL_LIBS := \
     system/fidl/fuchsia-sysinfo
 
 include make/module.mk
+
+
+MODULE := $(LOCAL_DIR).syscalls
+
+MODULE_TYPE := userapp
+
+MODULE_SRCS += \
+    $(LOCAL_DIR)/syscalls.c \
+    $(LOCAL_DIR)/resources.c
+
+MODULE_NAME := syscalls
+MODULE_GROUP := core
+
+MODULE_LIBS := \
+    system/ulib/fdio \
+    system/ulib/zircon \
+    system/ulib/c
+
+MODULE_STATIC_LIBS := \
+    system/ulib/task-utils
+
+MODULE_FIDL_LIBS := \
+    system/fidl/fuchsia-sysinfo
+
+include make/module.mk
@@ -0,0 +1,281 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <task-utils/get.h>
+#include <zircon/status.h>
+#include <zircon/syscalls.h>
+#include <zircon/syscalls/object.h>
+#include <zircon/time.h>
+#include <zircon/types.h>
+#include <zircon/zx-syscall-numbers.h>
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "resources.h"
+
+// Generated table of the syscall numbers and names.
+static const struct {
+    uint32_t id;
+    uint32_t nargs;
+    const char* name;
+} syscall_info[] = {
+#include <zircon/syscall-ktrace-info.inc>
+};
+
+enum sort_order {
+    SORT_TIME,
+    SORT_COUNT,
+};
+
+// arguments
+static zx_duration_t delay = ZX_SEC(1);
+static int max_rows = 20;
+static enum sort_order sort_order = SORT_TIME;
+
+// the previous sample, indexed by syscall number
+static zx_info_syscall_stats_t last_stats[ZX_SYS_COUNT];
+
+static const char* syscall_name(uint32_t num) {
+    for (size_t i = 0; i < countof(syscall_info); i++) {
+        if (syscall_info[i].id == num)
+            return syscall_info[i].name;
+    }
+    return "?";
+}
+
+// Returns the upper bound of the histogram bucket holding the |percent|th
+// percentile of |stats|, which is as close as the kernel's log2 buckets get.
+// The last bucket is open ended, so the max time stands in for its bound.
+static zx_duration_t percentile(const zx_info_syscall_stats_t* stats, unsigned percent) {
+    uint64_t target = (stats->count * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < ZX_INFO_SYSCALL_STATS_BUCKETS - 1; i++) {
+        seen += stats->histogram[i];
+        if (seen >= target)
+            return (zx_duration_t)1 << (7 + i);
+    }
+    return stats->max_time;
+}
+
+static int compare_rows(const void* a, const void* b) {
+    const zx_info_syscall_stats_t* ra = a;
+    const zx_info_syscall_stats_t* rb = b;
+    uint64_t ka, kb;
+    if (sort_order == SORT_COUNT) {
+        ka = ra->count;
+        kb = rb->count;
+    } else {
+        ka = ra->total_time;
+        kb = rb->total_time;
+    }
+    return ka < kb ? 1 : ka > kb ? -1 : 0;
+}
+
+// Prints the syscalls made since the previous sample. The max times are not
+// deltas, but the longest calls since boot or since the process started.
+static zx_status_t print_syscalls(zx_handle_t handle, bool print) {
+    static zx_info_syscall_stats_t stats[ZX_SYS_COUNT];
+    static zx_info_syscall_stats_t rows[ZX_SYS_COUNT];
+
+    size_t actual, avail;
+    zx_status_t err = zx_object_get_info(handle, ZX_INFO_SYSCALL_STATS, stats, sizeof(stats),
+                                         &actual, &avail);
+    if (err != ZX_OK) {
+        fprintf(stderr, "ZX_INFO_SYSCALL_STATS returns %d (%s)\n", err,
+                zx_status_get_string(err));
+        if (err == ZX_ERR_NOT_SUPPORTED)
+            fprintf(stderr, "Boot with kernel.syscall-stats=true to collect them\n");
+        return err;
+    }
+
+    size_t num_rows = 0;
+    uint64_t total_count = 0;
+    for (size_t i = 0; i < actual; i++) {
+        const zx_info_syscall_stats_t* s = &stats[i];
+        if (s->syscall_num >= ZX_SYS_COUNT)
+            continue;
+        zx_info_syscall_stats_t* last = &last_stats[s->syscall_num];
+
+        zx_info_syscall_stats_t* row = &rows[num_rows];
+        row->syscall_num = s->syscall_num;
+        row->count = s->count - last->count;
+        row->total_time = s->total_time - last->total_time;
+        row->max_time = s->max_time;
+        for (size_t b = 0; b < ZX_INFO_SYSCALL_STATS_BUCKETS; b++)
+            row->histogram[b] = s->histogram[b] - last->histogram[b];
+        *last = *s;
+
+        if (row->count == 0)
+            continue;
+        total_count += row->count;
+        num_rows++;
+    }
+
+    if (!print)
+        return ZX_OK;
+
+    qsort(rows, num_rows, sizeof(rows[0]), compare_rows);
+
+    printf("%-28s %10s %10s %10s %10s %10s %10s\n",
+           "SYSCALL", "CALLS/S", "TIME%", "AVG_US", "P50_US", "P99_US", "MAX_US");
+    for (size_t i = 0; i < num_rows && (max_rows < 0 || i < (size_t)max_rows); i++) {
+        const zx_info_syscall_stats_t* d = &rows[i];
+        double seconds = (double)delay / ZX_SEC(1);
+        printf("%-28s %10.0f %10.2f %10.2f %10.2f %10.2f %10.2f\n",
+               syscall_name(d->syscall_num),
+               d->count / seconds,
+               d->total_time / (double)delay * 100,
+               d->total_time / (double)d->count / ZX_USEC(1),
+               percentile(d, 50) / (double)ZX_USEC(1),
+               percentile(d, 99) / (double)ZX_USEC(1),
+               d->max_time / (double)ZX_USEC(1));
+    }
+    printf("%zu syscalls, %" PRIu64 " calls\n\n", num_rows, total_count);
+    return ZX_OK;
+}
+
+static void print_help(FILE* f) {
+    fprintf(f, "Usage: syscalls [options]\n");
+    fprintf(f, "Options:\n");
+    fprintf(f, " -p <koid>       Only show syscalls made by this process\n");
+    fprintf(f, " -c <count>      Print the first count syscalls (default 20, -1 for all)\n");
+    fprintf(f, " -d <delay>      Delay in seconds (default 1 second)\n");
+    fprintf(f, " -n <times>      Run this many times and then exit\n");
+    fprintf(f, " -o <sort field> Sort by different fields (default is time)\n");
+    fprintf(f, "\nSupported sort fields:\n");
+    fprintf(f, "\ttime  : time spent in the syscall between scans\n");
+    fprintf(f, "\tcount : number of calls between scans\n");
+    fprintf(f, "\nColumns:\n");
+    fprintf(f, "\tTIME%%:  time spent in the syscall, summed over all threads,\n");
+    fprintf(f, "\t        as a percentage of the delay\n");
+    fprintf(f, "\tP50_US, P99_US: upper bounds of the percentiles, from log2 buckets\n");
+    fprintf(f, "\tMAX_US: longest call since boot or process start\n");
+    fprintf(f, "\nRequires booting with kernel.syscall-stats=true.\n");
+}
+
+int main(int argc, char** argv) {
+    zx_koid_t koid = ZX_KOID_INVALID;
+    int num_loops = -1;
+
+    int c;
+    while ((c = getopt(argc, argv, "c:d:hn:o:p:")) > 0) {
+        switch (c) {
+            case 'c':
+                max_rows = atoi(optarg);
+                if (max_rows == 0) {
+                    fprintf(stderr, "Bad -c value '%s'\n", optarg);
+                    print_help(stderr);
+                    return 1;
+                }
+                break;
+            case 'd':
+                delay = ZX_SEC(atoi(optarg));
+                if (delay == 0) {
+                    fprintf(stderr, "Bad -d value '%s'\n", optarg);
+                    print_help(stderr);
+                    return 1;
+                }
+                break;
+            case 'h':
+                print_help(stdout);
+                return 0;
+            case 'n':
+                num_loops = atoi(optarg);
+                if (num_loops == 0) {
+                    fprintf(stderr, "Bad -n value '%s'\n", optarg);
+                    print_help(stderr);
+                    return 1;
+                }
+                break;
+            case 'o':
+                if (!strcmp(optarg, "time")) {
+                    sort_order = SORT_TIME;
+                } else if (!strcmp(optarg, "count")) {
+                    sort_order = SORT_COUNT;
+                } else {
+                    fprintf(stderr, "Bad sort field '%s'\n", optarg);
+                    print_help(stderr);
+                    return 1;
+                }
+                break;
+            case 'p': {
+                char* end;
+                koid = strtoull(optarg, &end, 0);
+                if (optarg[0] == '\0' || *end != '\0') {
+                    fprintf(stderr, "Bad -p value '%s'\n", optarg);
+                    print_help(stderr);
+                    return 1;
+                }
+                break;
+            }
+            default:
+                fprintf(stderr, "Unknown option\n");
+                print_help(stderr);
+                return 1;
+        }
+    }
+
+    zx_handle_t handle;
+    zx_status_t ret;
+    if (koid != ZX_KOID_INVALID) {
+        zx_obj_type_t type;
+        ret = get_task_by_koid(koid, &type, &handle);
+        if (ret == ZX_OK && type != ZX_OBJ_TYPE_PROCESS) {
+            zx_handle_close(handle);
+            ret = ZX_ERR_WRONG_TYPE;
+        }
+        if (ret != ZX_OK) {
+            fprintf(stderr, "ERROR: couldn't find process with koid %" PRIu64 ": %s (%d)\n",
+                    koid, zx_status_get_string(ret), ret);
+            return 1;
+        }
+    } else {
+        ret = get_root_resource(&handle);
+        if (ret != ZX_OK) {
+            return 1;
+        }
+    }
+
+    // set stdin to non blocking so we can intercept ctrl-c.
+    // TODO: remove once ctrl-c works in the shell
+    fcntl(STDIN_FILENO, F_SETFL, O_NONBLOCK);
+
+    // The first sample only provides the base for the deltas.
+    bool first_run = true;
+    for (;;) {
+        zx_time_t next_deadline = zx_deadline_after(delay);
+
+        ret = print_syscalls(handle, !first_run);
+        if (ret != ZX_OK)
+            break;
+
+        if (!first_run && num_loops > 0) {
+            if (--num_loops == 0) {
+                break;
+            }
+        } else {
+            // TODO: replace once ctrl-c works in the shell
+            char c;
+            int err;
+            while ((err = read(STDIN_FILENO, &c, 1)) > 0) {
+                if (c == 0x3)
+                    return 0;
+            }
+        }
+        first_run = false;
+
+        zx_nanosleep(next_deadline);
+    }
+
+    zx_handle_close(handle);
+
+    return ret == ZX_OK ? 0 : 1;
+}
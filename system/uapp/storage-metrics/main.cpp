@@ -86,6 +86,12 @@ void PrintFsStats(MinfsMetrics metrics) {
     printf("lookup calls:                       %lu\n", metrics.lookup_calls);
     printf("successful lookup calls:            %lu\n", metrics.lookup_calls_success);
     printf("lookup nanoseconds:                 %lu\n", metrics.lookup_ticks);
+    printf("\n");
+
+    printf("Block cache metrics\n");
+    printf("block cache hits:                   %lu\n", metrics.block_cache_hits);
+    printf("block cache misses:                 %lu\n", metrics.block_cache_misses);
+    printf("blocks read ahead:                  %lu\n", metrics.block_cache_readahead_blocks);
 }
 
 zx_status_t EnableFsStats(const char* path, bool enable) {
@@ -0,0 +1,149 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fbl/vector.h>
+#include <trace-reader/reader.h>
+#include <trace-reader/summary.h>
+
+namespace {
+
+constexpr uint64_t kNanosecondsPerMicrosecond = 1000u;
+
+void Usage(const char* argv0) {
+    fprintf(stderr, "Usage: %s <trace file>\n", argv0);
+    fprintf(stderr, "Prints duration and flow latency histograms, and per-thread\n"
+                    "running times, of a trace in the binary trace format.\n");
+}
+
+int CompareTotals(const void* a, const void* b) {
+    auto lhs = *static_cast<const trace::NamedStats* const*>(a);
+    auto rhs = *static_cast<const trace::NamedStats* const*>(b);
+    if (lhs->durations.total() != rhs->durations.total())
+        return lhs->durations.total() > rhs->durations.total() ? -1 : 1;
+    return 0;
+}
+
+double ToMicroseconds(uint64_t nanoseconds) {
+    return static_cast<double>(nanoseconds) / kNanosecondsPerMicrosecond;
+}
+
+void PrintHistograms(const char* title, fbl::Vector<const trace::NamedStats*>* stats) {
+    if (stats->is_empty())
+        return;
+
+    qsort(stats->get(), stats->size(), sizeof(stats->get()[0]), CompareTotals);
+
+    // Percentiles are upper bounds of power-of-two buckets.
+    printf("%s (us):\n", title);
+    printf("%10s %12s %10s %10s %10s %10s %10s  %s\n",
+           "count", "total", "min", "p50", "p90", "p99", "max", "category:name");
+    for (const trace::NamedStats* entry : *stats) {
+        const trace::Histogram& h = entry->durations;
+        printf("%10" PRIu64 " %12.1f %10.1f %10.1f %10.1f %10.1f %10.1f  %s:%s\n",
+               h.count(), ToMicroseconds(h.total()), ToMicroseconds(h.min()),
+               ToMicroseconds(h.Percentile(50)), ToMicroseconds(h.Percentile(90)),
+               ToMicroseconds(h.Percentile(99)), ToMicroseconds(h.max()),
+               entry->category.c_str(), entry->name.c_str());
+    }
+    printf("\n");
+}
+
+void PrintSummary(const trace::TraceSummary& summary) {
+    fbl::Vector<const trace::NamedStats*> durations;
+    summary.ForEachDuration([&durations](const trace::NamedStats& stats) {
+        durations.push_back(&stats);
+    });
+    PrintHistograms("Durations", &durations);
+
+    fbl::Vector<const trace::NamedStats*> flows;
+    summary.ForEachFlow([&flows](const trace::NamedStats& stats) {
+        flows.push_back(&stats);
+    });
+    PrintHistograms("Flow latencies", &flows);
+
+    bool header_printed = false;
+    summary.ForEachThread([&header_printed](const trace::ThreadStats& stats) {
+        if (stats.switch_count == 0u)
+            return;
+        if (!header_printed) {
+            printf("Threads:\n");
+            printf("%12s %10s  %s\n", "running(us)", "switches", "process/thread");
+            header_printed = true;
+        }
+        printf("%12.1f %10" PRIu64 "  %" PRIu64 "/%" PRIu64 "\n",
+               ToMicroseconds(stats.running_time), stats.switch_count,
+               stats.process_thread.process_koid(), stats.process_thread.thread_koid());
+    });
+    if (header_printed)
+        printf("\n");
+
+    if (summary.unmatched_duration_ends() || summary.unmatched_flow_ends()) {
+        printf("Unmatched duration ends: %" PRIu64 ", unmatched flow ends: %" PRIu64 "\n",
+               summary.unmatched_duration_ends(), summary.unmatched_flow_ends());
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        Usage(argv[0]);
+        return 1;
+    }
+
+    int fd = open(argv[1], O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Unable to open %s\n", argv[1]);
+        return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        fprintf(stderr, "Unable to stat %s\n", argv[1]);
+        close(fd);
+        return 1;
+    }
+    size_t size = st.st_size;
+    if (size == 0u) {
+        close(fd);
+        return 0;
+    }
+
+    // Map the trace rather than reading it, records are decoded in place.
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "Unable to map %s\n", argv[1]);
+        return 1;
+    }
+
+    trace::TraceSummary summary;
+    size_t num_errors = 0u;
+    trace::TraceReader reader(
+        [&summary](trace::Record record) {
+            summary.AddRecord(record);
+        },
+        [&num_errors](fbl::String error) {
+            if (num_errors++ < 10u)
+                fprintf(stderr, "Error: %s\n", error.c_str());
+        });
+    trace::Chunk chunk(static_cast<const uint64_t*>(data), size / sizeof(uint64_t));
+    bool ok = reader.ReadRecords(chunk);
+    munmap(data, size);
+
+    PrintSummary(summary);
+
+    if (!ok) {
+        fprintf(stderr, "Trace is corrupt, the summary is partial\n");
+        return 1;
+    }
+    return 0;
+}
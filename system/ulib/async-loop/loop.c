@@ -26,6 +26,11 @@
 // The port wait key associated with the dispatcher's control messages.
 #define KEY_CONTROL (0u)
 
+// Tasks due within the next |WHEEL_SLOTS| slots of 2^|WHEEL_SLOT_SHIFT| ns
+// (about 4.3 seconds) are kept in the timer wheel, later ones in the heap.
+#define WHEEL_SLOT_SHIFT (24u)
+#define WHEEL_SLOTS (256u)
+
 static zx_time_t async_loop_now(async_dispatcher_t* dispatcher);
 static zx_status_t async_loop_begin_wait(async_dispatcher_t* dispatcher, async_wait_t* wait);
 static zx_status_t async_loop_cancel_wait(async_dispatcher_t* dispatcher, async_wait_t* wait);
@@ -86,7 +91,14 @@ typedef struct async_loop {
     mtx_t lock; // guards the lists and the dispatching tasks flag
     bool dispatching_tasks; // true while the loop is busy dispatching tasks
     list_node_t wait_list; // most recently added first
-    list_node_t task_list; // pending tasks, earliest deadline first
+    async_task_t** task_heap; // pending tasks, min-heap by deadline then posting order
+    size_t task_count; // number of tasks in |task_heap|
+    size_t task_capacity; // allocated size of |task_heap|
+    uint64_t task_seq; // posting order of the next pending task
+    list_node_t wheel[WHEEL_SLOTS]; // pending tasks by slot of their deadline, posting order
+    uint64_t wheel_map[WHEEL_SLOTS / 64u]; // non-empty slots of |wheel|
+    size_t wheel_count; // number of tasks in |wheel|
+    uint64_t wheel_slot; // first slot held by |wheel|, earlier ones are in |task_heap|
     list_node_t due_list; // due tasks, earliest deadline first
     list_node_t thread_list; // earliest created thread first
     list_node_t exception_list; // most recently added first
@@ -109,7 +121,10 @@ static zx_status_t async_loop_dispatch_exception(async_loop_t* loop,
                                                  zx_status_t status,
                                                  const zx_port_packet_t* report);
 static void async_loop_wake_threads(async_loop_t* loop);
-static void async_loop_insert_task_locked(async_loop_t* loop, async_task_t* task);
+static zx_status_t async_loop_insert_task_locked(async_loop_t* loop, async_task_t* task);
+static async_task_t* async_loop_remove_task_locked(async_loop_t* loop, size_t index);
+static void async_loop_advance_wheel_locked(async_loop_t* loop, zx_time_t now);
+static zx_time_t async_loop_next_deadline_locked(async_loop_t* loop);
 static void async_loop_restart_timer_locked(async_loop_t* loop);
 static void async_loop_invoke_prologue(async_loop_t* loop);
 static void async_loop_invoke_epilogue(async_loop_t* loop);
@@ -140,6 +155,26 @@ static inline list_node_t* exception_to_node(async_exception_t* exception) {
     return TO_NODE(async_exception_t, exception);
 }
 
+// While a task is in the loop's |task_heap|, its state holds its heap index,
+// tagged with the low bit to tell it apart from the (aligned) list node links
+// it holds while in the |wheel| or the |due_list|, and its posting order.
+static inline bool task_in_heap(async_task_t* task) {
+    return task->state.reserved[0] & 1u;
+}
+
+static inline size_t task_heap_index(async_task_t* task) {
+    return task->state.reserved[0] >> 1;
+}
+
+static inline void task_set_heap_index(async_task_t* task, size_t index) {
+    task->state.reserved[0] = (index << 1) | 1u;
+}
+
+static inline bool task_before(async_task_t* a, async_task_t* b) {
+    return a->deadline < b->deadline ||
+           (a->deadline == b->deadline && a->state.reserved[1] < b->state.reserved[1]);
+}
+
 static inline async_exception_t* node_to_exception(list_node_t* node) {
     return FROM_NODE(async_exception_t, node);
 }
@@ -158,8 +193,10 @@ zx_status_t async_loop_create(const async_loop_config_t* config, async_loop_t**
     loop->config = *config;
     mtx_init(&loop->lock, mtx_plain);
     list_initialize(&loop->wait_list);
-    list_initialize(&loop->task_list);
     list_initialize(&loop->due_list);
+    for (size_t i = 0; i < WHEEL_SLOTS; i++)
+        list_initialize(&loop->wheel[i]);
+    loop->wheel_slot = ((uint64_t)zx_clock_get_monotonic() >> WHEEL_SLOT_SHIFT) + 1u;
     list_initialize(&loop->thread_list);
     list_initialize(&loop->exception_list);
 
@@ -192,6 +229,7 @@ void async_loop_destroy(async_loop_t* loop) {
     zx_handle_close(loop->port);
     zx_handle_close(loop->timer);
     mtx_destroy(&loop->lock);
+    free(loop->task_heap);
     free(loop);
 }
 
@@ -216,8 +254,9 @@ void async_loop_shutdown(async_loop_t* loop) {
         async_task_t* task = node_to_task(node);
         async_loop_dispatch_task(loop, task, ZX_ERR_CANCELED);
     }
-    while ((node = list_remove_head(&loop->task_list))) {
-        async_task_t* task = node_to_task(node);
+    async_loop_advance_wheel_locked(loop, ZX_TIME_INFINITE);
+    while (loop->task_count) {
+        async_task_t* task = async_loop_remove_task_locked(loop, 0u);
         async_loop_dispatch_task(loop, task, ZX_ERR_CANCELED);
     }
     while ((node = list_remove_head(&loop->exception_list))) {
@@ -350,20 +389,10 @@ static zx_status_t async_loop_dispatch_tasks(async_loop_t* loop) {
         list_node_t* node;
         if (list_is_empty(&loop->due_list)) {
             zx_time_t due_time = async_loop_now((async_dispatcher_t*)loop);
-            list_node_t* tail = NULL;
-            list_for_every(&loop->task_list, node) {
-                if (node_to_task(node)->deadline > due_time)
-                    break;
-                tail = node;
-            }
-            if (tail) {
-                list_node_t* head = loop->task_list.next;
-                loop->task_list.next = tail->next;
-                tail->next->prev = &loop->task_list;
-                loop->due_list.next = head;
-                head->prev = &loop->due_list;
-                loop->due_list.prev = tail;
-                tail->next = &loop->due_list;
+            async_loop_advance_wheel_locked(loop, due_time);
+            while (loop->task_count && loop->task_heap[0]->deadline <= due_time) {
+                async_task_t* task = async_loop_remove_task_locked(loop, 0u);
+                list_add_tail(&loop->due_list, task_to_node(task));
             }
         }
 
@@ -549,15 +578,16 @@ static zx_status_t async_loop_post_task(async_dispatcher_t* async, async_task_t*
 
     mtx_lock(&loop->lock);
 
-    async_loop_insert_task_locked(loop, task);
-    if (!loop->dispatching_tasks &&
-        task_to_node(task)->prev == &loop->task_list) {
-        // Task inserted at head.  Earliest deadline changed.
+    zx_time_t prior_deadline = async_loop_next_deadline_locked(loop);
+    zx_status_t status = async_loop_insert_task_locked(loop, task);
+    if (status == ZX_OK && !loop->dispatching_tasks &&
+        async_loop_next_deadline_locked(loop) < prior_deadline) {
+        // Earliest deadline changed.
         async_loop_restart_timer_locked(loop);
     }
 
     mtx_unlock(&loop->lock);
-    return ZX_OK;
+    return status;
 }
 
 static zx_status_t async_loop_cancel_task(async_dispatcher_t* async, async_task_t* task) {
@@ -569,24 +599,36 @@ static zx_status_t async_loop_cancel_task(async_dispatcher_t* async, async_task_
     // destroyed in case the client is counting on the handler not being
     // invoked again past this point.  Also, the task we're removing here
     // might be present in the dispatcher's |due_list| if it is pending
-    // dispatch instead of in the loop's |task_list| as usual.  The same
-    // logic works in both cases.
+    // dispatch instead of in the loop's |task_heap| as usual.
 
     mtx_lock(&loop->lock);
     list_node_t* node = task_to_node(task);
-    if (!list_in_list(node)) {
+    if (!task_in_heap(task) && !list_in_list(node)) {
         mtx_unlock(&loop->lock);
         return ZX_ERR_NOT_FOUND;
     }
 
-    // Determine whether the head task was canceled and following task has
+    // Tasks in the |due_list| were due before the |wheel| last advanced, so
+    // the deadline tells which list a task is in.
+    zx_time_t prior_deadline = async_loop_next_deadline_locked(loop);
+    if (task_in_heap(task)) {
+        async_loop_remove_task_locked(loop, task_heap_index(task));
+    } else if (task->deadline >= 0 &&
+               (uint64_t)task->deadline >> WHEEL_SLOT_SHIFT >= loop->wheel_slot) {
+        size_t pos = ((uint64_t)task->deadline >> WHEEL_SLOT_SHIFT) % WHEEL_SLOTS;
+        list_delete(node);
+        loop->wheel_count--;
+        if (list_is_empty(&loop->wheel[pos]))
+            loop->wheel_map[pos / 64u] &= ~(1ull << (pos % 64u));
+    } else {
+        list_delete(node);
+    }
+
+    // Determine whether the earliest task was canceled and following task has
     // a later deadline.  If so, we will bump the timer along to that deadline.
-    bool must_restart = !loop->dispatching_tasks &&
-                        node->prev == &loop->task_list &&
-                        node->next != &loop->task_list &&
-                        node_to_task(node->next)->deadline > task->deadline;
-    list_delete(node);
-    if (must_restart)
+    zx_time_t deadline = async_loop_next_deadline_locked(loop);
+    if (!loop->dispatching_tasks && deadline > prior_deadline &&
+        deadline != ZX_TIME_INFINITE)
         async_loop_restart_timer_locked(loop);
 
     mtx_unlock(&loop->lock);
@@ -701,27 +743,146 @@ static zx_status_t async_loop_resume_from_exception(async_dispatcher_t* async,
     return zx_task_resume_from_exception(task, loop->port, options);
 }
 
-static void async_loop_insert_task_locked(async_loop_t* loop, async_task_t* task) {
-    // TODO(ZX-976): We assume that tasks are inserted in quasi-monotonic order and
-    // that insertion into the task queue will typically take no more than a few steps.
-    // If this assumption proves false and the cost of insertion becomes a problem, we
-    // should consider using a more efficient representation for maintaining order.
-    list_node_t* node;
-    for (node = loop->task_list.prev; node != &loop->task_list; node = node->prev) {
-        if (task->deadline >= node_to_task(node)->deadline)
+static void async_loop_sift_up_locked(async_loop_t* loop, size_t index) {
+    async_task_t* task = loop->task_heap[index];
+    while (index > 0u) {
+        size_t parent = (index - 1u) / 2u;
+        if (!task_before(task, loop->task_heap[parent]))
+            break;
+        loop->task_heap[index] = loop->task_heap[parent];
+        task_set_heap_index(loop->task_heap[index], index);
+        index = parent;
+    }
+    loop->task_heap[index] = task;
+    task_set_heap_index(task, index);
+}
+
+static void async_loop_sift_down_locked(async_loop_t* loop, size_t index) {
+    async_task_t* task = loop->task_heap[index];
+    for (;;) {
+        size_t child = index * 2u + 1u;
+        if (child >= loop->task_count)
+            break;
+        if (child + 1u < loop->task_count &&
+            task_before(loop->task_heap[child + 1u], loop->task_heap[child]))
+            child++;
+        if (!task_before(loop->task_heap[child], task))
+            break;
+        loop->task_heap[index] = loop->task_heap[child];
+        task_set_heap_index(loop->task_heap[index], index);
+        index = child;
+    }
+    loop->task_heap[index] = task;
+    task_set_heap_index(task, index);
+}
+
+static void async_loop_push_task_locked(async_loop_t* loop, async_task_t* task) {
+    ZX_DEBUG_ASSERT(loop->task_count < loop->task_capacity);
+
+    // Tasks with the same deadline are dispatched in the order they were posted.
+    task->state.reserved[1] = loop->task_seq++;
+    loop->task_heap[loop->task_count++] = task;
+    async_loop_sift_up_locked(loop, loop->task_count - 1u);
+}
+
+static zx_status_t async_loop_insert_task_locked(async_loop_t* loop, async_task_t* task) {
+    // The heap always has room for the tasks in the wheel, so advancing the
+    // wheel never fails.
+    if (loop->task_count + loop->wheel_count == loop->task_capacity) {
+        size_t capacity = loop->task_capacity ? loop->task_capacity * 2u : 16u;
+        async_task_t** heap = realloc(loop->task_heap, capacity * sizeof(*heap));
+        if (!heap)
+            return ZX_ERR_NO_MEMORY;
+        loop->task_heap = heap;
+        loop->task_capacity = capacity;
+    }
+
+    // A task lands in the heap if its slot has already been advanced past,
+    // after all earlier posted tasks of the same deadline, or if it is due
+    // beyond the wheel, before all later posted ones.
+    if (task->deadline >= 0) {
+        uint64_t slot = (uint64_t)task->deadline >> WHEEL_SLOT_SHIFT;
+        if (slot >= loop->wheel_slot && slot - loop->wheel_slot < WHEEL_SLOTS) {
+            size_t pos = slot % WHEEL_SLOTS;
+            list_add_tail(&loop->wheel[pos], task_to_node(task));
+            loop->wheel_map[pos / 64u] |= 1ull << (pos % 64u);
+            loop->wheel_count++;
+            return ZX_OK;
+        }
+    }
+    async_loop_push_task_locked(loop, task);
+    return ZX_OK;
+}
+
+// Returns the number of slots from |wheel_slot| to the first non-empty one.
+static uint64_t async_loop_first_wheel_slot_locked(async_loop_t* loop) {
+    ZX_DEBUG_ASSERT(loop->wheel_count);
+
+    uint64_t distance = 0u;
+    for (;;) {
+        size_t pos = (loop->wheel_slot + distance) % WHEEL_SLOTS;
+        uint64_t bits = loop->wheel_map[pos / 64u] >> (pos % 64u);
+        if (bits)
+            return distance + __builtin_ctzll(bits);
+        distance += 64u - pos % 64u;
+    }
+}
+
+// Moves the tasks of the wheel slots which begin at or before |now| to the heap.
+static void async_loop_advance_wheel_locked(async_loop_t* loop, zx_time_t now) {
+    uint64_t now_slot = now < 0 ? 0u : (uint64_t)now >> WHEEL_SLOT_SHIFT;
+    while (loop->wheel_count) {
+        uint64_t slot = loop->wheel_slot + async_loop_first_wheel_slot_locked(loop);
+        if (slot > now_slot)
             break;
+        size_t pos = slot % WHEEL_SLOTS;
+        list_node_t* node;
+        while ((node = list_remove_head(&loop->wheel[pos]))) {
+            async_loop_push_task_locked(loop, node_to_task(node));
+            loop->wheel_count--;
+        }
+        loop->wheel_map[pos / 64u] &= ~(1ull << (pos % 64u));
+    }
+    if (loop->wheel_slot <= now_slot)
+        loop->wheel_slot = now_slot + 1u;
+}
+
+// Returns the earliest time the timer must fire for, which is the start of a
+// wheel slot if that comes before the head of the heap.
+static zx_time_t async_loop_next_deadline_locked(async_loop_t* loop) {
+    zx_time_t deadline = loop->task_count ? loop->task_heap[0]->deadline : ZX_TIME_INFINITE;
+    if (loop->wheel_count) {
+        uint64_t slot = loop->wheel_slot + async_loop_first_wheel_slot_locked(loop);
+        zx_time_t start = (zx_time_t)(slot << WHEEL_SLOT_SHIFT);
+        if (start < deadline)
+            deadline = start;
     }
-    list_add_after(node, task_to_node(task));
+    return deadline;
+}
+
+static async_task_t* async_loop_remove_task_locked(async_loop_t* loop, size_t index) {
+    ZX_DEBUG_ASSERT(index < loop->task_count);
+
+    async_task_t* task = loop->task_heap[index];
+    task->state.reserved[0] = 0u;
+    task->state.reserved[1] = 0u;
+
+    async_task_t* last = loop->task_heap[--loop->task_count];
+    if (index < loop->task_count) {
+        loop->task_heap[index] = last;
+        if (index > 0u && task_before(last, loop->task_heap[(index - 1u) / 2u])) {
+            async_loop_sift_up_locked(loop, index);
+        } else {
+            async_loop_sift_down_locked(loop, index);
+        }
+    }
+    return task;
 }
 
 static void async_loop_restart_timer_locked(async_loop_t* loop) {
     zx_time_t deadline;
     if (list_is_empty(&loop->due_list)) {
-        list_node_t* head = list_peek_head(&loop->task_list);
-        if (!head)
-            return;
-        async_task_t* task = node_to_task(head);
-        deadline = task->deadline;
+        deadline = async_loop_next_deadline_locked(loop);
         if (deadline == ZX_TIME_INFINITE)
             return;
     } else {
@@ -90,6 +90,10 @@ bool RawBitmapBase::Scan(size_t bitoff, size_t bitmax, bool is_set,
         return true;
     }
     size_t i = FirstIdx(bitoff);
+    const size_t last_idx = LastIdx(bitmax);
+    // Only the first and last words need to be masked. Skip over interior
+    // words which match |is_set| entirely without examining their bits.
+    const size_t all_match = is_set ? ~(size_t(0)) : 0;
     while (true) {
         size_t masked = MaskBits(data_[i], i, bitoff, bitmax, is_set);
         if (masked != 0) {
@@ -98,10 +102,13 @@ bool RawBitmapBase::Scan(size_t bitoff, size_t bitmax, bool is_set,
             }
             return false;
         }
-        if (i == LastIdx(bitmax)) {
+        if (i == last_idx) {
             return true;
         }
         ++i;
+        while (i < last_idx && data_[i] == all_match) {
+            ++i;
+        }
     }
 }
 
@@ -112,6 +119,9 @@ bool RawBitmapBase::ReverseScan(size_t bitoff, size_t bitmax, bool is_set,
         return true;
     }
     size_t i = LastIdx(bitmax);
+    const size_t first_idx = FirstIdx(bitoff);
+    // As in Scan, interior words which match |is_set| entirely are skipped.
+    const size_t all_match = is_set ? ~(size_t(0)) : 0;
     while (true) {
         size_t masked = MaskBits(data_[i], i, bitoff, bitmax, is_set);
         if (masked != 0) {
@@ -120,10 +130,13 @@ bool RawBitmapBase::ReverseScan(size_t bitoff, size_t bitmax, bool is_set,
             }
             return false;
         }
-        if (i == FirstIdx(bitoff)) {
+        if (i == first_idx) {
             return true;
         }
         --i;
+        while (i > first_idx && data_[i] == all_match) {
+            --i;
+        }
     }
 }
 
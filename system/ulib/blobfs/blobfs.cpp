@@ -38,6 +38,19 @@ using digest::MerkleTree;
 namespace blobfs {
 namespace {
 
+// Uncompressed blobs are read from disk and verified on demand, one run of
+// chunks at a time. A chunk covers whole blocks and whole Merkle tree nodes.
+constexpr uint64_t kDemandChunkBlocks = 8;
+constexpr uint64_t kDemandChunkSize = kDemandChunkBlocks * kBlobfsBlockSize;
+static_assert(kDemandChunkSize % MerkleTree::kNodeSize == 0,
+              "Demand chunks must cover whole Merkle tree nodes");
+static_assert(kDemandChunkSize == kCompressionChunkSize,
+              "Demand chunks must match the chunks of compressed blobs");
+
+// Blobs which are written uncompressed are streamed to disk in runs of at
+// least this many blocks while the client is still writing.
+constexpr uint64_t kStreamWriteBlocks = 4 * kDemandChunkBlocks;
+
 zx_status_t CheckFvmConsistency(const Superblock* info, int block_fd) {
     if ((info->flags & kBlobFlagFVM) == 0) {
         return ZX_OK;
@@ -152,22 +165,22 @@ Inode* Blobfs::GetNode(size_t index) const {
 }
 
 zx_status_t VnodeBlob::Verify() const {
-    TRACE_DURATION("blobfs", "Blobfs::Verify");
+    return VerifyRange(0, inode_.blob_size);
+}
+
+zx_status_t VnodeBlob::VerifyRange(uint64_t offset, uint64_t length) const {
+    TRACE_DURATION("blobfs", "Blobfs::Verify", "offset", offset, "length", length);
     fs::Ticker ticker(blobfs_->CollectingMetrics());
 
     const void* data = inode_.blob_size ? GetData() : nullptr;
     const void* tree = inode_.blob_size ? GetMerkle() : nullptr;
     const uint64_t data_size = inode_.blob_size;
     const uint64_t merkle_size = MerkleTree::GetTreeLength(data_size);
-    // TODO(smklein): We could lazily verify more of the VMO if
-    // we could fault in pages on-demand.
-    //
-    // For now, we aggressively verify the entire VMO up front.
     Digest digest;
     digest = reinterpret_cast<const uint8_t*>(&digest_[0]);
     zx_status_t status = MerkleTree::Verify(data, data_size, tree,
-                                            merkle_size, 0, data_size, digest);
-    blobfs_->UpdateMerkleVerifyMetrics(data_size, merkle_size, ticker.End());
+                                            merkle_size, offset, length, digest);
+    blobfs_->UpdateMerkleVerifyMetrics(length, merkle_size, ticker.End());
 
     if (status != ZX_OK) {
         char name[Digest::kLength * 2 + 1];
@@ -217,14 +230,16 @@ zx_status_t VnodeBlob::InitVmos() {
         if ((status = InitCompressed()) != ZX_OK) {
             return status;
         }
+        // Chunked blobs are verified by LoadRange() as they are decompressed.
+        if (seek_table_ == nullptr && (status = Verify()) != ZX_OK) {
+            return status;
+        }
     } else {
+        // The data is read and verified by LoadRange() as it is accessed.
         if ((status = InitUncompressed()) != ZX_OK) {
             return status;
         }
     }
-    if ((status = Verify()) != ZX_OK) {
-        return status;
-    }
 
     cleanup.cancel();
     return ZX_OK;
@@ -274,6 +289,27 @@ zx_status_t VnodeBlob::InitCompressed() {
     fs::Duration read_time = ticker.End();
     ticker.Reset();
 
+    if ((inode_.flags & kBlobFlagLZ4Chunked) != 0) {
+        // Keep the compressed data; chunks are decompressed as they are accessed.
+        fbl::AllocChecker ac;
+        fbl::unique_ptr<SeekTable> table(new (&ac) SeekTable());
+        if (!ac.check()) {
+            return ZX_ERR_NO_MEMORY;
+        }
+        status = table->Init(compressed_mapper.start(), compressed_size, inode_.blob_size);
+        if (status != ZX_OK) {
+            FS_TRACE_ERROR("Failed to index compressed blob: %d\n", status);
+            return status;
+        }
+        if ((status = InitChunkBitmap()) != ZX_OK) {
+            return status;
+        }
+        compressed_mapping_ = fbl::move(compressed_mapper);
+        seek_table_ = fbl::move(table);
+        blobfs_->UpdateMerkleDecompressMetrics(compressed_size, 0, read_time, fs::Duration());
+        return ZX_OK;
+    }
+
     // Decompress the compressed data into the target buffer.
     size_t target_size = inode_.blob_size;
     status = Decompressor::Decompress(GetData(), &target_size,
@@ -295,16 +331,103 @@ zx_status_t VnodeBlob::InitCompressed() {
 zx_status_t VnodeBlob::InitUncompressed() {
     TRACE_DURATION("blobfs", "Blobfs::InitUncompressed", "size", inode_.blob_size,
                    "blocks", inode_.num_blocks);
-    fs::Ticker ticker(blobfs_->CollectingMetrics());
-    fs::ReadTxn txn(blobfs_);
-    uint64_t start = inode_.start_block + DataStartBlock(blobfs_->info_);
+    zx_status_t status = InitChunkBitmap();
+    if (status != ZX_OK) {
+        return status;
+    }
 
-    // Read both the uncompressed merkle tree and data.
-    uint64_t length = BlobDataBlocks(inode_) + MerkleTreeBlocks(inode_);
-    txn.Enqueue(vmoid_, 0, start, length);
-    zx_status_t status = txn.Transact();
-    blobfs_->UpdateMerkleDiskReadMetrics(length * kBlobfsBlockSize, ticker.End());
-    return status;
+    // Only the merkle tree is read up front.
+    uint64_t merkle_blocks = MerkleTreeBlocks(inode_);
+    if (merkle_blocks > 0) {
+        fs::Ticker ticker(blobfs_->CollectingMetrics());
+        fs::ReadTxn txn(blobfs_);
+        txn.Enqueue(vmoid_, 0, inode_.start_block + DataStartBlock(blobfs_->info_),
+                    merkle_blocks);
+        if ((status = txn.Transact()) != ZX_OK) {
+            return status;
+        }
+        blobfs_->UpdateMerkleDiskReadMetrics(merkle_blocks * kBlobfsBlockSize, ticker.End());
+    }
+    return ZX_OK;
+}
+
+zx_status_t VnodeBlob::InitChunkBitmap() {
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<ChunkBitmap> chunks(new (&ac) ChunkBitmap());
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    zx_status_t status = chunks->Reset(fbl::round_up(inode_.blob_size, kDemandChunkSize) /
+                                       kDemandChunkSize);
+    if (status != ZX_OK) {
+        return status;
+    }
+    loaded_chunks_ = fbl::move(chunks);
+    return ZX_OK;
+}
+
+zx_status_t VnodeBlob::LoadRange(uint64_t offset, uint64_t length) {
+    if (loaded_chunks_ == nullptr || length == 0) {
+        // Fully loaded and freshly written blobs are entirely in memory.
+        return ZX_OK;
+    }
+    ZX_DEBUG_ASSERT(offset + length <= inode_.blob_size);
+    TRACE_DURATION("blobfs", "Blobfs::LoadRange", "offset", offset, "length", length);
+
+    const uint64_t merkle_blocks = MerkleTreeBlocks(inode_);
+    const uint64_t data_blocks = BlobDataBlocks(inode_);
+    const uint64_t dev_start = inode_.start_block + DataStartBlock(blobfs_->info_) +
+                               merkle_blocks;
+    const size_t last = (offset + length - 1) / kDemandChunkSize + 1;
+
+    size_t chunk = offset / kDemandChunkSize;
+    while (!loaded_chunks_->Scan(chunk, last, true, &chunk)) {
+        // Load the whole run of missing chunks at once.
+        size_t end = last;
+        loaded_chunks_->Scan(chunk, last, false, &end);
+
+        uint64_t start = chunk * kDemandChunkSize;
+        uint64_t finish = fbl::min(end * kDemandChunkSize, inode_.blob_size);
+        fs::Ticker ticker(blobfs_->CollectingMetrics());
+        zx_status_t status;
+        if (seek_table_ != nullptr) {
+            uint8_t* data = static_cast<uint8_t*>(GetData());
+            for (size_t i = chunk; i < end; i++) {
+                uint64_t chunk_start = i * kDemandChunkSize;
+                status = seek_table_->DecompressChunk(i, data + chunk_start,
+                                                      finish - chunk_start);
+                if (status != ZX_OK) {
+                    FS_TRACE_ERROR("Failed to decompress chunk %zu: %d\n", i, status);
+                    return status;
+                }
+            }
+            blobfs_->UpdateMerkleDecompressMetrics(0, finish - start, fs::Duration(),
+                                                   ticker.End());
+        } else {
+            uint64_t block = chunk * kDemandChunkBlocks;
+            uint64_t blocks = fbl::min(end * kDemandChunkBlocks, data_blocks) - block;
+            fs::ReadTxn txn(blobfs_);
+            txn.Enqueue(vmoid_, merkle_blocks + block, dev_start + block, blocks);
+            if ((status = txn.Transact()) != ZX_OK) {
+                return status;
+            }
+            blobfs_->UpdateMerkleDiskReadMetrics(blocks * kBlobfsBlockSize, ticker.End());
+        }
+
+        if ((status = VerifyRange(start, finish - start)) != ZX_OK) {
+            return status;
+        }
+        loaded_chunks_->Set(chunk, end);
+        chunk = end;
+    }
+
+    if (loaded_chunks_->Scan(0, loaded_chunks_->size(), true)) {
+        // Everything is in |mapping_| now; the compressed data is not needed.
+        loaded_chunks_.reset();
+        seek_table_.reset();
+        compressed_mapping_.Reset();
+    }
+    return ZX_OK;
 }
 
 void VnodeBlob::PopulateInode(size_t node_index) {
@@ -336,6 +459,9 @@ VnodeBlob::VnodeBlob(Blobfs* bs)
 
 void VnodeBlob::BlobCloseHandles() {
     mapping_.Reset();
+    loaded_chunks_.reset();
+    seek_table_.reset();
+    compressed_mapping_.Reset();
     readable_event_.reset();
 }
 
@@ -389,6 +515,13 @@ zx_status_t VnodeBlob::SpaceAllocate(uint64_t size_data) {
     }
 
     write_info_ = fbl::make_unique<WritebackInfo>();
+    if (MerkleTree::GetTreeLength(inode_.blob_size) > 0) {
+        status = write_info_->merkle.CreateInit(inode_.blob_size,
+                                                MerkleTree::GetTreeLength(inode_.blob_size));
+        if (status != ZX_OK) {
+            return status;
+        }
+    }
     if (inode_.blob_size >= kCompressionMinBytesSaved) {
         size_t max = write_info_->compressor.BufferMax(inode_.blob_size);
         status = write_info_->compressed_blob.CreateAndMap(max, "compressed-blob");
@@ -481,6 +614,15 @@ zx_status_t VnodeBlob::WriteInternal(const void* data, size_t len, size_t* actua
         }
 
         *actual = to_write;
+        size_t merkle_size = MerkleTree::GetTreeLength(inode_.blob_size);
+        if (merkle_size > 0) {
+            const uint8_t* written = static_cast<const uint8_t*>(GetData()) +
+                                     write_info_->bytes_written;
+            if ((status = write_info_->merkle.CreateUpdate(written, to_write,
+                                                           GetMerkle())) != ZX_OK) {
+                return status;
+            }
+        }
         write_info_->bytes_written += to_write;
 
         if (write_info_->compressor.Compressing()) {
@@ -492,11 +634,16 @@ zx_status_t VnodeBlob::WriteInternal(const void* data, size_t len, size_t* actua
 
         // More data to write.
         if (write_info_->bytes_written < inode_.blob_size) {
+            // Once the blob is known to be stored uncompressed, there is no
+            // reason to hold its data back: start writing it to disk.
+            if (!write_info_->compressor.Compressing()) {
+                return StreamDataBlocks();
+            }
             return ZX_OK;
         }
 
-        // Only write data to disk once we've buffered the file into memory.
-        // This gives us a chance to try compressing the blob before we write it back.
+        // Compressed blobs are only written to disk once the whole file has been
+        // buffered into memory, since the compressed size is not known until then.
         fbl::unique_ptr<WritebackWork> wb;
         if ((status = blobfs_->CreateWork(&wb, this)) != ZX_OK) {
             return status;
@@ -533,28 +680,24 @@ zx_status_t VnodeBlob::WriteInternal(const void* data, size_t len, size_t* actua
             blobfs_->UnreserveBlocks(inode_.num_blocks - blocks,
                                      inode_.start_block + blocks);
             inode_.num_blocks = blocks;
-            inode_.flags |= kBlobFlagLZ4Compressed;
+            inode_.flags |= kBlobFlagLZ4Compressed | kBlobFlagLZ4Chunked;
         } else {
+            // Any data blocks already streamed to disk don't need to be written again.
+            uint64_t done = write_info_->blocks_written;
             uint64_t blocks = fbl::round_up(inode_.blob_size, kBlobfsBlockSize) / kBlobfsBlockSize;
             if ((status = EnqueuePaginated(&wb, blobfs_, this, mapping_.vmo().get(),
-                                           merkle_blocks, dev_offset, blocks)) != ZX_OK) {
+                                           merkle_blocks + done, dev_offset + done,
+                                           blocks - done)) != ZX_OK) {
                 return status;
             }
         }
 
-        // TODO(smklein): As an optimization, use the CreateInit/Update/Final
-        // methods to create the merkle tree as we write data, rather than
-        // waiting until the data is fully downloaded to create the tree.
-        size_t merkle_size = MerkleTree::GetTreeLength(inode_.blob_size);
         fs::Duration generation_time;
         if (merkle_size > 0) {
             Digest digest;
-            void* merkle_data = GetMerkle();
-            const void* blob_data = GetData();
             fs::Ticker ticker(blobfs_->CollectingMetrics()); // Tracking generation time.
 
-            if ((status = MerkleTree::Create(blob_data, inode_.blob_size, merkle_data,
-                                             merkle_size, &digest)) != ZX_OK) {
+            if ((status = write_info_->merkle.CreateFinal(GetMerkle(), &digest)) != ZX_OK) {
                 return status;
             } else if (digest != digest_) {
                 // Downloaded blob did not match provided digest.
@@ -591,6 +734,39 @@ zx_status_t VnodeBlob::WriteInternal(const void* data, size_t len, size_t* actua
     return ZX_ERR_BAD_STATE;
 }
 
+zx_status_t VnodeBlob::StreamDataBlocks() {
+    ZX_DEBUG_ASSERT(!write_info_->compressor.Compressing());
+    // Wait until a reasonable amount of data has accumulated, rather than
+    // issuing a tiny write for every block.
+    const uint64_t complete_blocks = write_info_->bytes_written / kBlobfsBlockSize;
+    const uint64_t blocks = complete_blocks - write_info_->blocks_written;
+    if (blocks < kStreamWriteBlocks) {
+        return ZX_OK;
+    }
+
+    zx_status_t status;
+    fbl::unique_ptr<WritebackWork> wb;
+    if ((status = blobfs_->CreateWork(&wb, this)) != ZX_OK) {
+        return status;
+    }
+
+    const uint64_t relative_block = MerkleTreeBlocks(inode_) + write_info_->blocks_written;
+    const uint64_t dev_offset = DataStartBlock(blobfs_->info_) + inode_.start_block +
+                                relative_block;
+    if ((status = EnqueuePaginated(&wb, blobfs_, this, mapping_.vmo().get(), relative_block,
+                                   dev_offset, blocks)) != ZX_OK) {
+        if (wb != nullptr) {
+            wb->Reset(ZX_ERR_BAD_STATE);
+        }
+        return status;
+    }
+    if ((status = blobfs_->EnqueueWork(fbl::move(wb), EnqueueType::kData)) != ZX_OK) {
+        return status;
+    }
+    write_info_->blocks_written = complete_blocks;
+    return ZX_OK;
+}
+
 void VnodeBlob::ConsiderCompressionAbort() {
     ZX_DEBUG_ASSERT(write_info_->compressor.Compressing());
     if (inode_.blob_size - kCompressionMinBytesSaved < write_info_->compressor.Size()) {
@@ -631,8 +807,12 @@ zx_status_t VnodeBlob::CloneVmo(zx_rights_t rights, zx_handle_t* out) {
         return status;
     }
 
-    // TODO(smklein): Only clone / verify the part of the vmo that
-    // was requested.
+    // Clients may touch any page of the clone, so all of it must be present
+    // and verified before it is handed out.
+    if ((status = LoadRange(0, inode_.blob_size)) != ZX_OK) {
+        return status;
+    }
+
     const size_t merkle_bytes = MerkleTreeBlocks(inode_) * kBlobfsBlockSize;
     zx::vmo clone;
     if ((status = mapping_.vmo().clone(ZX_VMO_CLONE_COPY_ON_WRITE, merkle_bytes, inode_.blob_size,
@@ -703,6 +883,10 @@ zx_status_t VnodeBlob::ReadInternal(void* data, size_t len, size_t off, size_t*
         len = inode_.blob_size - off;
     }
 
+    if ((status = LoadRange(off, len)) != ZX_OK) {
+        return status;
+    }
+
     const size_t merkle_bytes = MerkleTreeBlocks(inode_) * kBlobfsBlockSize;
     status = mapping_.vmo().read(data, merkle_bytes + off, len);
     if (status == ZX_OK) {
@@ -734,14 +918,58 @@ zx_status_t VnodeBlob::VerifyBlob(Blobfs* bs, size_t node_index) {
     vn->SetState(kBlobStatePurged);
 
     // If we are unable to read in the blob from disk, this should also be a VerifyBlob error.
-    // Since InitVmos calls Verify as its final step, we can just return its result here.
-    return vn->InitVmos();
+    zx_status_t status = vn->InitVmos();
+    if (status != ZX_OK) {
+        return status;
+    }
+    return vn->LoadRange(0, vn->inode_.blob_size);
 }
 
 zx_status_t Blobfs::VerifyBlob(size_t node_index) {
     return VnodeBlob::VerifyBlob(this, node_index);
 }
 
+void Blobfs::VerifyBlobsInBackground() {
+    verify_index_ = 0;
+    verify_failures_ = 0;
+    verify_task_.Post(dispatcher());
+}
+
+void Blobfs::VerifyNextBlob() {
+    while (verify_index_ < info_.inode_count) {
+        size_t n = verify_index_++;
+        const Inode* inode = GetNode(n);
+        if (inode->start_block < kStartBlockMinimum) {
+            continue;
+        }
+
+        // Skip blobs which are still being written, or were deleted since
+        // verification started.
+        Digest digest(inode->merkle_root_hash);
+        fbl::RefPtr<VnodeBlob> vn;
+        if (LookupBlob(digest, &vn) != ZX_OK || vn->GetState() != kBlobStateReadable) {
+            continue;
+        }
+        if (VerifyBlob(n) != ZX_OK) {
+            char name[digest::Digest::kLength * 2 + 1];
+            digest.ToString(name, sizeof(name));
+            FS_TRACE_ERROR("blobfs: CORRUPTED FILESYSTEM: blob %s @ index %zu failed "
+                           "verification\n", name, n);
+            verify_failures_++;
+        }
+        break;
+    }
+
+    if (verify_index_ < info_.inode_count) {
+        verify_task_.Post(dispatcher());
+    } else if (verify_failures_ == 0) {
+        printf("blobfs: background verification completed OK\n");
+    } else {
+        FS_TRACE_ERROR("blobfs: background verification found %u corrupt blob%s\n",
+                       verify_failures_, verify_failures_ > 1 ? "s" : "");
+    }
+}
+
 zx_status_t Blobfs::FindBlocks(size_t start, size_t num_blocks, size_t* blkno_out) {
     while (true) {
         // Search for a range of nblocks in block_map_.
@@ -777,7 +1005,7 @@ zx_status_t Blobfs::FindBlocks(size_t start, size_t num_blocks, size_t* blkno_ou
 
 zx_status_t Blobfs::ReserveBlocks(size_t num_blocks, size_t* block_index_out) {
     zx_status_t status;
-    if ((status = FindBlocks(0, num_blocks, block_index_out) != ZX_OK)) {
+    if ((status = FindBlocks(free_block_lower_bound_, num_blocks, block_index_out) != ZX_OK)) {
         // If we have run out of blocks, attempt to add block slices via FVM.
         // The new 'hint' is the first location we could try to find blocks
         // after merely extending the allocation maps.
@@ -792,6 +1020,12 @@ zx_status_t Blobfs::ReserveBlocks(size_t num_blocks, size_t* block_index_out) {
 
     status = reserved_blocks_.Set(*block_index_out, *block_index_out + num_blocks);
     ZX_DEBUG_ASSERT(status == ZX_OK);
+
+    // If the run started at the lower bound, every block before its end is now
+    // either allocated or reserved.
+    if (*block_index_out == free_block_lower_bound_) {
+        free_block_lower_bound_ = *block_index_out + num_blocks;
+    }
     return ZX_OK;
 }
 
@@ -825,6 +1059,9 @@ void Blobfs::UnreserveBlocks(size_t num_blocks, size_t block_index) {
 
     zx_status_t status = reserved_blocks_.Clear(block_index, block_index + num_blocks);
     ZX_DEBUG_ASSERT(status == ZX_OK);
+    if (free_block_lower_bound_ > block_index) {
+        free_block_lower_bound_ = block_index;
+    }
 }
 
 void Blobfs::PersistBlocks(WritebackWork* wb, size_t num_blocks, size_t block_index) {
@@ -869,6 +1106,11 @@ void Blobfs::FreeBlocks(WritebackWork* wb, size_t num_blocks, size_t block_index
 
     zx_status_t status = reserved_blocks_.Clear(block_index, block_index + num_blocks);
     ZX_DEBUG_ASSERT(status == ZX_OK);
+
+    // We update lower bound if the freed blocks precede it.
+    if (free_block_lower_bound_ > block_index) {
+        free_block_lower_bound_ = block_index;
+    }
 }
 
 zx_status_t Blobfs::FindNode(size_t* node_index_out) {
@@ -997,6 +1239,8 @@ size_t Blobfs::WritebackCapacity() const { return writeback_->GetCapacity(); }
 void Blobfs::Shutdown(fs::Vfs::ShutdownCallback cb) {
     TRACE_DURATION("blobfs", "Blobfs::Unmount");
 
+    verify_task_.Cancel();
+
     // 1) Shutdown all external connections to blobfs.
     ManagedVfs::Shutdown([this, cb = fbl::move(cb)](zx_status_t status) mutable {
         // 2a) Shutdown all internal connections to blobfs.
@@ -1397,6 +1641,23 @@ void Blobfs::UpdateLookupMetrics(uint64_t size) {
     }
 }
 
+void Blobfs::UpdateCacheLookupMetrics(bool hit) {
+    if (CollectingMetrics()) {
+        if (hit) {
+            metrics_.cache_hits++;
+        } else {
+            metrics_.cache_misses++;
+        }
+    }
+}
+
+void Blobfs::UpdateCacheEvictionMetrics(uint64_t size) {
+    if (CollectingMetrics()) {
+        metrics_.cache_evictions++;
+        metrics_.cache_evicted_bytes += size;
+    }
+}
+
 void Blobfs::UpdateClientWriteMetrics(uint64_t data_size, uint64_t merkle_size,
                                       const fs::Duration& enqueue_duration,
                                       const fs::Duration& generate_duration) {
@@ -1408,10 +1669,13 @@ void Blobfs::UpdateClientWriteMetrics(uint64_t data_size, uint64_t merkle_size,
     }
 }
 
-void Blobfs::UpdateWritebackMetrics(uint64_t size, const fs::Duration& duration) {
+void Blobfs::UpdateWritebackMetrics(uint64_t size, uint64_t works,
+                                    const fs::Duration& duration) {
     if (CollectingMetrics()) {
         metrics_.total_writeback_time_ticks += duration;
         metrics_.total_writeback_bytes_written += size;
+        metrics_.writeback_transactions++;
+        metrics_.writeback_works += works;
     }
 }
 
@@ -1456,6 +1720,7 @@ Blobfs::~Blobfs() {
     writeback_.reset();
 
     ZX_ASSERT(open_hash_.is_empty());
+    closed_lru_.clear();
     closed_hash_.clear();
 
     if (blockfd_) {
@@ -1476,6 +1741,7 @@ zx_status_t Blobfs::Create(fbl::unique_fd fd, const MountOptions& options,
     auto fs = fbl::unique_ptr<Blobfs>(new Blobfs(fbl::move(fd), info));
     fs->SetReadonly(options.readonly);
     fs->SetCachePolicy(options.cache_policy);
+    fs->SetCacheBudget(options.cache_bytes);
     if (options.metrics) {
         fs->CollectMetrics();
     }
@@ -1546,6 +1812,8 @@ zx_status_t Blobfs::Create(fbl::unique_fd fd, const MountOptions& options,
 
 zx_status_t Blobfs::InitializeVnodes() {
     fbl::AutoLock lock(&hash_lock_);
+    closed_lru_.clear();
+    closed_lru_bytes_ = 0;
     closed_hash_.clear();
     for (size_t i = 0; i < info_.inode_count; ++i) {
         const Inode* inode = GetNode(i);
@@ -1643,6 +1911,7 @@ zx_status_t Blobfs::Reload() {
         fprintf(stderr, "blobfs: Failed to load bitmaps: %d\n", status);
         return status;
     }
+    free_block_lower_bound_ = 0;
 
     // Load the vnodes from disk.
     if ((status = InitializeVnodes() != ZX_OK)) {
@@ -1670,6 +1939,13 @@ zx_status_t Blobfs::VnodeInsertClosedLocked(fbl::RefPtr<VnodeBlob> vn) {
         break;
     case CachePolicy::NeverEvict:
         break;
+    case CachePolicy::EvictLru:
+        if (vn->CachedBytes() > 0) {
+            closed_lru_.push_back(vn.get());
+            closed_lru_bytes_ += vn->CachedBytes();
+            EvictClosedLocked(cache_bytes_);
+        }
+        break;
     default:
         ZX_ASSERT_MSG(false, "Unexpected cache policy");
     }
@@ -1684,12 +1960,27 @@ fbl::RefPtr<VnodeBlob> Blobfs::VnodeUpgradeLocked(const uint8_t* key) {
     if (raw_vn == nullptr) {
         return nullptr;
     }
+    if (raw_vn->InClosedLru()) {
+        closed_lru_.erase(*raw_vn);
+        closed_lru_bytes_ -= raw_vn->CachedBytes();
+    }
+    UpdateCacheLookupMetrics(raw_vn->CachedBytes() > 0);
     open_hash_.insert(raw_vn);
     // To have existed in the closed_hash_, this RefPtr must have
     // been leaked.
     return fbl::internal::MakeRefPtrNoAdopt(raw_vn);
 }
 
+void Blobfs::EvictClosedLocked(uint64_t budget) {
+    while (closed_lru_bytes_ > budget) {
+        VnodeBlob* vn = closed_lru_.pop_front();
+        uint64_t size = vn->CachedBytes();
+        closed_lru_bytes_ -= size;
+        vn->TearDown();
+        UpdateCacheEvictionMetrics(size);
+    }
+}
+
 zx_status_t Blobfs::OpenRootNode(fbl::RefPtr<VnodeBlob>* out) {
     fbl::AllocChecker ac;
     fbl::RefPtr<VnodeBlob> vn =
@@ -1783,6 +2074,10 @@ zx_status_t Mount(async_dispatcher_t* dispatcher, fbl::unique_fd blockfd,
         return status;
     }
 
+    if (options.verify_in_background) {
+        fs->VerifyBlobsInBackground();
+    }
+
     // Shutdown is now responsible for deleting the Blobfs object.
     __UNUSED auto r = fs.release();
     return ZX_OK;
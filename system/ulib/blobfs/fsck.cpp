@@ -3,11 +3,16 @@
 // found in the LICENSE file.
 
 #include <blobfs/fsck.h>
+#include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
 #include <fs/trace.h>
 #include <inttypes.h>
 
 #ifdef __Fuchsia__
+#include <threads.h>
+
 #include <blobfs/blobfs.h>
+#include <zircon/syscalls.h>
 #else
 #include <blobfs/host.h>
 #endif
@@ -35,16 +40,83 @@ void BlobfsChecker::TraverseInodeBitmap() {
                 valid = false;
             }
 
-            if (blobfs_->VerifyBlob(n) != ZX_OK) {
-                FS_TRACE_ERROR("check: detected inode %u with bad state\n", n);
-                valid = false;
-            }
             if (!valid) {
-                error_blobs_++;
+                error_blobs_.fetch_add(1);
             }
+
+            fbl::AllocChecker ac;
+            blobs_.push_back(n, &ac);
+            if (!ac.check()) {
+                FS_TRACE_ERROR("check: out of memory\n");
+                error_blobs_.fetch_add(1);
+            }
+        }
+    }
+}
+
+void BlobfsChecker::VerifyRange(size_t start, size_t end) {
+    for (size_t i = start; i < end; i++) {
+        if (blobfs_->VerifyBlob(blobs_[i]) != ZX_OK) {
+            FS_TRACE_ERROR("check: detected inode %u with bad state\n", blobs_[i]);
+            error_blobs_.fetch_add(1);
+        }
+    }
+}
+
+#ifdef __Fuchsia__
+namespace {
+
+// Each thread uses its own block fifo group, so leave some for the rest of
+// blobfs.
+constexpr uint32_t kMaxVerifyThreads = 4;
+
+struct VerifyArgs {
+    BlobfsChecker* checker;
+    size_t start;
+    size_t end;
+};
+
+} // namespace
+
+int BlobfsChecker::VerifyThread(void* arg) {
+    auto args = static_cast<VerifyArgs*>(arg);
+    args->checker->VerifyRange(args->start, args->end);
+    return 0;
+}
+
+void BlobfsChecker::VerifyBlobs() {
+    // Verification is dominated by reading and hashing the blobs, which
+    // parallelizes well; split the blobs into contiguous ranges so each thread
+    // reads from its own part of the disk.
+    uint32_t thread_count = fbl::clamp(zx_system_get_num_cpus(), 1u, kMaxVerifyThreads);
+    if (blobs_.size() < thread_count) {
+        thread_count = 1;
+    }
+    thrd_t threads[kMaxVerifyThreads];
+    VerifyArgs args[kMaxVerifyThreads];
+    uint32_t started = 0;
+    for (uint32_t i = 0; i < thread_count; i++) {
+        args[i].checker = this;
+        args[i].start = blobs_.size() * i / thread_count;
+        args[i].end = blobs_.size() * (i + 1) / thread_count;
+        if (i == thread_count - 1 ||
+            thrd_create_with_name(&threads[i], VerifyThread, &args[i],
+                                  "blobfs-fsck") != thrd_success) {
+            // Check whatever is left on this thread.
+            VerifyRange(args[i].start, blobs_.size());
+            break;
         }
+        started++;
+    }
+    for (uint32_t i = 0; i < started; i++) {
+        thrd_join(threads[i], nullptr);
     }
 }
+#else
+void BlobfsChecker::VerifyBlobs() {
+    VerifyRange(0, blobs_.size());
+}
+#endif
 
 void BlobfsChecker::TraverseBlockBitmap() {
     for (uint64_t n = 0; n < blobfs_->info_.data_block_count; n++) {
@@ -82,7 +154,7 @@ zx_status_t BlobfsChecker::CheckAllocatedCounts() const {
         status = ZX_ERR_BAD_STATE;
     }
 
-    if (error_blobs_) {
+    if (error_blobs_.load()) {
         status = ZX_ERR_BAD_STATE;
     }
 
@@ -96,11 +168,14 @@ void BlobfsChecker::Init(fbl::unique_ptr<Blobfs> blob) {
     blobfs_ = fbl::move(blob);
 }
 
-zx_status_t Fsck(fbl::unique_ptr<Blobfs> blob) {
+zx_status_t Fsck(fbl::unique_ptr<Blobfs> blob, bool verify_blobs) {
     BlobfsChecker chk;
     chk.Init(fbl::move(blob));
     chk.TraverseInodeBitmap();
     chk.TraverseBlockBitmap();
+    if (verify_blobs) {
+        chk.VerifyBlobs();
+    }
     return chk.CheckAllocatedCounts();
 }
 
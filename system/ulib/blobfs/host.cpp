@@ -143,7 +143,7 @@ zx_status_t blobfs_add_mapped_blob_with_merkle(Blobfs* bs, const FileMapping& ma
     Inode* inode = inode_block->GetInode();
     inode->blob_size = mapping.length();
     inode->num_blocks = MerkleTreeBlocks(*inode) + info.GetDataBlocks();
-    inode->flags |= (info.compressed ? kBlobFlagLZ4Compressed : 0);
+    inode->flags |= (info.compressed ? kBlobFlagLZ4Compressed | kBlobFlagLZ4Chunked : 0);
 
     if ((status = bs->AllocateBlocks(inode->num_blocks,
                                      reinterpret_cast<size_t*>(&inode->start_block))) != ZX_OK) {
@@ -15,8 +15,10 @@
 
 #include <bitmap/raw-bitmap.h>
 #include <bitmap/rle-bitmap.h>
+#include <bitmap/storage.h>
 #include <block-client/cpp/client.h>
 #include <digest/digest.h>
+#include <digest/merkle-tree.h>
 #include <fbl/algorithm.h>
 #include <fbl/intrusive_double_list.h>
 #include <fbl/intrusive_wavl_tree.h>
@@ -32,6 +34,7 @@
 #include <fs/vfs.h>
 #include <fs/vnode.h>
 #include <fuchsia/io/c/fidl.h>
+#include <lib/async/cpp/task.h>
 #include <lib/async/cpp/wait.h>
 #include <lib/fzl/owned-vmo-mapper.h>
 #include <lib/fzl/resizeable-vmo-mapper.h>
@@ -92,6 +95,10 @@ public:
     struct TypeWavlTraits {
         static WAVLTreeNodeState& node_state(VnodeBlob& b) { return b.type_wavl_state_; }
     };
+    using LruNodeState = fbl::DoublyLinkedListNodeState<VnodeBlob*>;
+    struct TypeLruTraits {
+        static LruNodeState& node_state(VnodeBlob& b) { return b.type_lru_state_; }
+    };
     const uint8_t* GetKey() const {
         return &digest_[0];
     };
@@ -137,6 +144,13 @@ public:
     void fbl_recycle() final;
     void TearDown();
     virtual ~VnodeBlob();
+
+    // The number of bytes of memory held by the blob's VMOs, or zero if it
+    // has been torn down.
+    uint64_t CachedBytes() const { return mapping_.size() + compressed_mapping_.size(); }
+
+    // Returns true if the blob is on the LRU list of closed blobs.
+    bool InClosedLru() const { return type_lru_state_.InContainer(); }
     void CompleteSync();
 
     // When blob VMOs are cloned and returned to clients, blobfs watches
@@ -157,6 +171,7 @@ public:
 
 private:
     friend struct TypeWavlTraits;
+    friend struct TypeLruTraits;
 
     DISALLOW_COPY_ASSIGN_AND_MOVE(VnodeBlob);
 
@@ -206,6 +221,11 @@ private:
     // hatch to avoid wasting work.
     void ConsiderCompressionAbort();
 
+    // For a blob being written uncompressed, enqueues the data blocks which
+    // have been completely written into the VMO, but not yet enqueued for
+    // writeback, as a work unit of their own.
+    zx_status_t StreamDataBlocks();
+
     // Reads from a blob.
     // Requires: kBlobStateReadable
     zx_status_t ReadInternal(void* data, size_t len, size_t off, size_t* actual);
@@ -232,26 +252,40 @@ private:
     zx_status_t GetVmo(int flags, zx_handle_t* out) final;
     void Sync(SyncCallback closure) final;
 
-    // Read both VMOs into memory, if we haven't already.
+    // Create the blob's VMO, if we haven't already.
+    //
+    // Blobs compressed as a single stream are read, decompressed and verified
+    // in full. Chunked compressed blobs are read in full, but decompressed and
+    // verified a chunk at a time by LoadRange(). For uncompressed blobs only
+    // the merkle tree is read; the data is read and verified by LoadRange() as
+    // it is accessed.
     //
     // TODO(ZX-1481): When we have can register the Blob Store as a pager
     // service, and it can properly handle pages faults on a vnode's contents,
-    // then we can avoid reading the entire blob up-front. Until then, read
-    // the contents of a VMO into memory when it is opened.
+    // then we can avoid reading the entire blob when a client maps it, too.
     zx_status_t InitVmos();
 
-    // Initialize a compressed blob by reading it from disk and decompressing
-    // it.
+    // Initialize a compressed blob by reading it from disk and, unless it is
+    // chunked, decompressing it.
     // Does not verify the blob.
     zx_status_t InitCompressed();
 
-    // Initialize a decompressed blob by reading it from disk.
-    // Does not verify the blob.
+    // Initialize a decompressed blob by reading its merkle tree from disk.
     zx_status_t InitUncompressed();
 
-    // Verify the integrity of the in-memory Blob.
+    // Allocate |loaded_chunks_| with every chunk of the blob missing.
+    zx_status_t InitChunkBitmap();
+
+    // Ensure the data in [offset, offset + length) has been read from disk (or
+    // decompressed) and verified. InitVmos() must have already been called for
+    // this blob.
+    zx_status_t LoadRange(uint64_t offset, uint64_t length);
+
+    // Verify the integrity of the in-memory Blob, or of the data in
+    // [offset, offset + length).
     // InitVmos() must have already been called for this blob.
     zx_status_t Verify() const;
+    zx_status_t VerifyRange(uint64_t offset, uint64_t length) const;
 
     // Called by the Vnode once the last write has completed, updating the
     // on-disk metadata.
@@ -262,6 +296,7 @@ private:
     void* GetMerkle() const;
 
     WAVLTreeNodeState type_wavl_state_ = {};
+    LruNodeState type_lru_state_ = {};
 
     Blobfs* const blobfs_;
     BlobFlags flags_ = {};
@@ -273,6 +308,16 @@ private:
     fzl::OwnedVmoMapper mapping_;
     vmoid_t vmoid_ = {};
 
+    // For blobs loaded on demand, the chunks of data which have been read and
+    // verified. Null when all of the data is in |mapping_|.
+    using ChunkBitmap = bitmap::RawBitmapGeneric<bitmap::DefaultStorage>;
+    fbl::unique_ptr<ChunkBitmap> loaded_chunks_;
+
+    // For chunked compressed blobs, the compressed data and the table used to
+    // decompress it on demand. Released once every chunk has been loaded.
+    fzl::OwnedVmoMapper compressed_mapping_;
+    fbl::unique_ptr<SeekTable> seek_table_;
+
     // Watches any clones of "vmo_" provided to clients.
     // Observes the ZX_VMO_ZERO_CHILDREN signal.
     async::WaitMethod<VnodeBlob, &VnodeBlob::HandleNoClones> clone_watcher_;
@@ -293,6 +338,10 @@ private:
     // Data used exclusively during writeback.
     struct WritebackInfo {
         uint64_t bytes_written = {};
+        // Number of data blocks which have already been enqueued for writeback.
+        uint64_t blocks_written = {};
+        // Builds the Merkle tree as the data arrives.
+        digest::MerkleTree merkle;
         Compressor compressor;
         fzl::OwnedVmoMapper compressed_blob;
     };
@@ -330,6 +379,14 @@ enum class CachePolicy {
     // This option costs a significant amount of memory, but it results in high
     // performance.
     NeverEvict,
+
+    // Closed blobs stay in memory until the memory they hold exceeds
+    // |MountOptions::cache_bytes|, at which point the least recently closed
+    // blobs are evicted first.
+    //
+    // This option keeps a frequently reopened working set of blobs in memory
+    // without letting the cache grow to hold every blob ever opened.
+    EvictLru,
 };
 
 // Toggles that may be set on blobfs during initialization.
@@ -338,6 +395,11 @@ struct MountOptions {
     bool metrics = false;
     bool journal = false;
     CachePolicy cache_policy = CachePolicy::EvictImmediately;
+    // The memory budget for closed blobs under CachePolicy::EvictLru.
+    uint64_t cache_bytes = 0;
+    // Once mounted, verify every blob against its Merkle tree in the
+    // background, and, when checking, skip that verification.
+    bool verify_in_background = false;
 };
 
 class Blobfs : public fs::ManagedVfs, public fbl::RefCounted<Blobfs>,
@@ -380,6 +442,7 @@ public:
                               const Superblock* info, fbl::unique_ptr<Blobfs>* out);
 
     void SetCachePolicy(CachePolicy policy) { cache_policy_ = policy; }
+    void SetCacheBudget(uint64_t bytes) { cache_bytes_ = bytes; }
     void CollectMetrics() { collecting_metrics_ = true; }
     bool CollectingMetrics() const { return collecting_metrics_; }
     void DisableMetrics() { collecting_metrics_ = false; }
@@ -400,6 +463,11 @@ public:
     // Returns the capacity of the writeback buffer in blocks.
     size_t WritebackCapacity() const;
 
+    // Starts verifying every blob on the dispatcher, one blob per task, so that
+    // the verification is interleaved with client requests.  Corrupt blobs are
+    // reported to the log.
+    void VerifyBlobsInBackground();
+
     virtual ~Blobfs();
 
     // Invokes "open" on the root directory.
@@ -460,6 +528,11 @@ public:
     // since mounting.
     void UpdateLookupMetrics(uint64_t size);
 
+    // Updates aggregate information about the closed blob cache since
+    // mounting.
+    void UpdateCacheLookupMetrics(bool hit);
+    void UpdateCacheEvictionMetrics(uint64_t size);
+
     // Updates aggregates information about blobs being written back
     // to blobfs since mounting.
     void UpdateClientWriteMetrics(uint64_t data_size, uint64_t merkle_size,
@@ -467,8 +540,8 @@ public:
                                   const fs::Duration& generate_duration);
 
     // Updates aggregate information about flushing bits down
-    // to the underlying storage driver.
-    void UpdateWritebackMetrics(uint64_t size, const fs::Duration& duration);
+    // to the underlying storage driver, |works| WritebackWorks at a time.
+    void UpdateWritebackMetrics(uint64_t size, uint64_t works, const fs::Duration& duration);
 
     // Updates aggregate information about reading blobs from storage
     // since mounting.
@@ -543,6 +616,10 @@ private:
     // Precondition: The Vnode must not exist in |open_hash_|.
     fbl::RefPtr<VnodeBlob> VnodeUpgradeLocked(const uint8_t* key) __TA_REQUIRES(hash_lock_);
 
+    // Tears down the least recently closed blobs on |closed_lru_| until the
+    // memory held by the rest fits in |budget| bytes.
+    void EvictClosedLocked(uint64_t budget) __TA_REQUIRES(hash_lock_);
+
     // Searches for |nblocks| free blocks between the block_map_ and reserved_blocks_ bitmaps.
     zx_status_t FindBlocks(size_t start, size_t nblocks, size_t* blkno_out);
 
@@ -601,6 +678,10 @@ private:
     // Verifies that the contents of a blob are valid.
     zx_status_t VerifyBlob(size_t node_index);
 
+    // Verifies the next blob after |verify_index_|, and posts |verify_task_|
+    // again until every node has been visited.
+    void VerifyNextBlob();
+
     // VnodeBlobs exist in the WAVLTree as long as one or more reference exists;
     // when the Vnode is deleted, it is immediately removed from the WAVL tree.
     using WAVLTreeByMerkle = fbl::WAVLTree<const uint8_t*,
@@ -615,6 +696,12 @@ private:
     WAVLTreeByMerkle open_hash_ __TA_GUARDED(hash_lock_){};   // All 'in use' blobs.
     WAVLTreeByMerkle closed_hash_ __TA_GUARDED(hash_lock_){}; // All 'closed' blobs.
 
+    // Closed blobs whose data is still in memory under CachePolicy::EvictLru,
+    // least recently closed first, and the memory they hold.
+    using LruList = fbl::DoublyLinkedList<VnodeBlob*, VnodeBlob::TypeLruTraits>;
+    LruList closed_lru_ __TA_GUARDED(hash_lock_){};
+    uint64_t closed_lru_bytes_ __TA_GUARDED(hash_lock_) = 0;
+
     fbl::unique_fd blockfd_;
     block_info_t block_info_ = {};
     fbl::atomic<groupid_t> next_group_ = {};
@@ -639,11 +726,22 @@ private:
     // can start looking for a free node from free_node_lower_bound_
     size_t free_node_lower_bound_ = 0;
 
+    // free_block_lower_bound_ is a lower bound on free data blocks: every block
+    // before it is either allocated or reserved, so block searches may begin
+    // there instead of at the start of the bitmap.
+    size_t free_block_lower_bound_ = 0;
+
     bool collecting_metrics_ = false;
     BlobfsMetrics metrics_ = {};
 
     CachePolicy cache_policy_;
+    uint64_t cache_bytes_ = 0;
     fbl::Closure on_unmount_ = {};
+
+    // State of the background verification.
+    async::TaskClosureMethod<Blobfs, &Blobfs::VerifyNextBlob> verify_task_{this};
+    size_t verify_index_ = 0;
+    uint32_t verify_failures_ = 0;
 };
 
 zx_status_t Initialize(fbl::unique_fd blockfd, const MountOptions& options,
@@ -197,6 +197,10 @@ constexpr uint64_t kStartBlockMinimum  = 1; // Smallest 'data' block possible.
 
 // Identifies that the on-disk storage of the blob is LZ4 compressed.
 constexpr uint32_t kBlobFlagLZ4Compressed = 0x00000001;
+// Identifies that the LZ4 frame is made of independent blocks of 64KiB of
+// uncompressed data, which may be decompressed on demand. Without this flag,
+// a compressed blob is decompressed as a whole.
+constexpr uint32_t kBlobFlagLZ4Chunked = 0x00000002;
 
 using digest::Digest;
 
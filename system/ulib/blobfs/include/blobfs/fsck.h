@@ -7,6 +7,9 @@
 
 #pragma once
 
+#include <fbl/atomic.h>
+#include <fbl/vector.h>
+
 #ifdef __Fuchsia__
 #include <blobfs/blobfs.h>
 #else
@@ -21,17 +24,31 @@ public:
     void Init(fbl::unique_ptr<Blobfs> vnode);
     void TraverseInodeBitmap();
     void TraverseBlockBitmap();
+    // Verifies the Merkle trees of the blobs found by TraverseInodeBitmap.
+    // On Fuchsia, the blobs are divided between several threads.
+    void VerifyBlobs();
     zx_status_t CheckAllocatedCounts() const;
 
 private:
     DISALLOW_COPY_ASSIGN_AND_MOVE(BlobfsChecker);
+
+#ifdef __Fuchsia__
+    static int VerifyThread(void* arg);
+#endif
+    void VerifyRange(size_t start, size_t end);
+
     fbl::unique_ptr<Blobfs> blobfs_;
     uint32_t alloc_inodes_;
     uint32_t alloc_blocks_;
-    uint32_t error_blobs_;
+    fbl::atomic<uint32_t> error_blobs_;
     uint32_t inode_blocks_;
+    // Indices of the allocated inodes, in order.
+    fbl::Vector<uint32_t> blobs_;
 };
 
-zx_status_t Fsck(fbl::unique_ptr<Blobfs> vnode);
+// Checks the consistency of |vnode|.  If |verify_blobs| is false, the contents
+// of the blobs are not verified against their Merkle trees; only the metadata
+// is checked.
+zx_status_t Fsck(fbl::unique_ptr<Blobfs> vnode, bool verify_blobs = true);
 
 } // namespace blobfs
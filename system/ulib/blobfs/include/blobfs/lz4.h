@@ -5,13 +5,21 @@
 #pragma once
 
 #include <fbl/macros.h>
+#include <fbl/unique_ptr.h>
 #include <lz4/lz4frame.h>
 #include <zircon/types.h>
 
 namespace blobfs {
 
+// Compressor writes LZ4 frames made of independent blocks, each holding this
+// many bytes of uncompressed data (except for the last one).
+constexpr size_t kCompressionChunkSize = 64 * 1024;
+
 // A Compressor is used to compress a blob transparently before it is written
 // back to disk.
+//
+// The output is a single LZ4 frame, readable by Decompressor, whose blocks
+// may also be decompressed one at a time through a SeekTable.
 class Compressor {
 public:
     Compressor();
@@ -75,4 +83,44 @@ public:
                                   const void* src_buf, size_t* src_size);
 };
 
+// A SeekTable locates the blocks of an LZ4 frame written by Compressor, so
+// that any chunk of kCompressionChunkSize uncompressed bytes can be
+// decompressed without decompressing the chunks before it.
+//
+// The table refers to the source buffer, which must outlive it.
+class SeekTable {
+public:
+    SeekTable();
+    ~SeekTable();
+
+    // Indexes the frame in |src_buf|, which must decompress to exactly
+    // |target_size| bytes. Fails with ZX_ERR_NOT_SUPPORTED if the blocks of
+    // the frame are not independent chunks of kCompressionChunkSize.
+    zx_status_t Init(const void* src_buf, size_t src_size, size_t target_size);
+
+    size_t Chunks() const { return chunks_; }
+
+    // Decompresses chunk |index| into |target_buf|, which must have room for
+    // the whole chunk.
+    zx_status_t DecompressChunk(size_t index, void* target_buf, size_t target_size) const;
+
+    // Returns the number of compressed bytes held by chunks [start, end).
+    size_t CompressedSize(size_t start, size_t end) const;
+
+private:
+    DISALLOW_COPY_ASSIGN_AND_MOVE(SeekTable);
+
+    struct Entry {
+        // Offset of the block data within the source buffer.
+        uint64_t offset;
+        // The LZ4 block size word, with the "uncompressed" bit.
+        uint32_t size;
+    };
+
+    const uint8_t* src_ = nullptr;
+    size_t target_size_ = 0;
+    size_t chunks_ = 0;
+    fbl::unique_ptr<Entry[]> entries_;
+};
+
 } // namespace blobfs
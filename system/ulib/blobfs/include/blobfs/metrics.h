@@ -41,6 +41,10 @@ struct BlobfsMetrics {
     // the client time because of asynchronous writeback buffers.
     zx::ticks total_writeback_time_ticks = {};
     uint64_t total_writeback_bytes_written = 0;
+    // Block device transactions issued by the writeback thread, and the
+    // WritebackWorks they carried.
+    uint64_t writeback_transactions = 0;
+    uint64_t writeback_works = 0;
 
     // LOOKUP STATS
 
@@ -62,6 +66,16 @@ struct BlobfsMetrics {
     uint64_t blobs_verified_total_size_merkle = 0;
     zx::ticks total_verification_time_ticks = {};
 
+    // CACHE STATS
+
+    // Lookups of closed blobs which found the data still in memory, and
+    // those which have to read it from disk again.
+    uint64_t cache_hits = 0;
+    uint64_t cache_misses = 0;
+    // Closed blobs torn down to keep the cache within its budget.
+    uint64_t cache_evictions = 0;
+    uint64_t cache_evicted_bytes = 0;
+
     // FVM STATS
     // TODO(smklein)
 };
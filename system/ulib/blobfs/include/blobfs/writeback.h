@@ -97,6 +97,18 @@ protected:
     // Activates the transaction.
     zx_status_t Flush();
 
+    // Writes the block device requests for this buffered transaction to |out|, which must have
+    // room for Requests().size() entries. Returns the number of requests written.
+    size_t BuildRequests(block_fifo_request_t* out) const;
+
+    // Clears the transaction once its requests have been issued.
+    void Clear() {
+        Reset();
+        block_count_ = 0;
+    }
+
+    Blobfs* blobfs() const { return bs_; }
+
 private:
     Blobfs* bs_;
     vmoid_t vmoid_;
@@ -151,7 +163,15 @@ public:
     // and resets the WritebackWork to its initial state.
     zx_status_t Complete();
 
+    // Persists the |count| works in |works| to disk with a single block device transaction,
+    // and resets each of them to its initial state. Each work is written only after the ones
+    // before it have reached the disk, just as if they had been completed one at a time.
+    static zx_status_t CompleteGroup(fbl::unique_ptr<WritebackWork>* works, size_t count);
+
 private:
+    // Runs the completion callbacks once the work's requests have finished with |status|.
+    void MarkCompleted(zx_status_t status);
+
     // If a sync callback exists, call it with |status|.
     void InvokeSyncCallback(zx_status_t status);
 
@@ -199,9 +219,10 @@ public:
     // starting at block |disk_start| on disk.
     void AddTransaction(size_t start, size_t disk_start, size_t length, WritebackWork* work);
 
-    // Returns true if |txn| belongs to this buffer, and if so verifies
-    // that it owns the next valid set of blocks within the buffer.
-    bool VerifyTransaction(WriteTxn* txn) const;
+    // Returns true if |txn| belongs to this buffer, and if so verifies that it owns the
+    // next valid set of blocks within the buffer, after the first |pending_blocks| blocks
+    // which belong to transactions that have been taken but not yet freed.
+    bool VerifyTransaction(WriteTxn* txn, size_t pending_blocks) const;
 
     // Given a transaction |txn|, verifies that all requests belong to this buffer
     // and then sets the transaction's buffer accordingly (if it is not already set).
@@ -278,7 +299,13 @@ private:
     void EnsureSpaceLocked(size_t blocks) __TA_REQUIRES(lock_);
 
     // Thread which asynchronously processes transactions.
+    //
+    // Consecutive ready works are taken off the queue together, at most kMaxGroupWorks works
+    // and (unless a single work is larger) kMaxGroupRequests block requests at a time, and
+    // are written out with a single block device transaction.
     static int WritebackThread(void* arg);
+    static constexpr size_t kMaxGroupWorks = 32;
+    static constexpr size_t kMaxGroupRequests = BLOCK_FIFO_MAX_DEPTH;
 
     // Signalled when the writeback buffer has space to add txns.
     cnd_t work_completed_;
@@ -2,11 +2,14 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <lz4/lz4.h>
 #include <lz4/lz4frame.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 
 #include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
 #include <fbl/auto_call.h>
 #include <fbl/macros.h>
 #include <fbl/unique_ptr.h>
@@ -17,8 +20,39 @@
 
 namespace blobfs {
 
+namespace {
+
 constexpr size_t kLz4HeaderSize = 15;
 
+// Pieces of the LZ4 frame format, which SeekTable parses by hand.
+constexpr uint32_t kLz4FrameMagic = 0x184D2204;
+constexpr size_t kLz4MinHeaderSize = 7;
+constexpr uint8_t kLz4FlagVersionMask = 0xC0;
+constexpr uint8_t kLz4FlagVersion = 0x40;
+constexpr uint8_t kLz4FlagBlockIndependent = 0x20;
+constexpr uint8_t kLz4FlagBlockChecksum = 0x10;
+constexpr uint8_t kLz4FlagContentSize = 0x08;
+constexpr uint8_t kLz4FlagDictId = 0x01;
+constexpr uint32_t kLz4BlockUncompressed = 0x80000000;
+
+static_assert(kCompressionChunkSize == 64 * 1024,
+              "Compressor chunks must match LZ4F_max64KB");
+
+LZ4F_preferences_t CompressionPreferences() {
+    LZ4F_preferences_t prefs;
+    memset(&prefs, 0, sizeof(prefs));
+    prefs.frameInfo.blockSizeID = LZ4F_max64KB;
+    prefs.frameInfo.blockMode = LZ4F_blockIndependent;
+    return prefs;
+}
+
+uint32_t LoadLE32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+           static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+} // namespace
+
 Compressor::Compressor() : buf_(nullptr) {}
 
 Compressor::~Compressor() {
@@ -43,7 +77,8 @@ zx_status_t Compressor::Initialize(void* buf, size_t buf_max) {
     buf_max_ = buf_max;
     buf_used_ = 0;
 
-    size_t r = LZ4F_compressBegin(ctx_, Buffer(), buf_remaining(), nullptr);
+    LZ4F_preferences_t prefs = CompressionPreferences();
+    size_t r = LZ4F_compressBegin(ctx_, Buffer(), buf_remaining(), &prefs);
     if (LZ4F_isError(r)) {
         return ZX_ERR_BUFFER_TOO_SMALL;
     }
@@ -52,7 +87,8 @@ zx_status_t Compressor::Initialize(void* buf, size_t buf_max) {
 }
 
 size_t Compressor::BufferMax(size_t blob_size) const {
-    return kLz4HeaderSize + LZ4F_compressBound(blob_size, nullptr);
+    LZ4F_preferences_t prefs = CompressionPreferences();
+    return kLz4HeaderSize + LZ4F_compressBound(blob_size, &prefs);
 }
 
 zx_status_t Compressor::Update(const void* data, size_t length) {
@@ -129,4 +165,108 @@ zx_status_t Decompressor::Decompress(void* target_buf_, size_t* target_size,
     return ZX_OK;
 }
 
+SeekTable::SeekTable() = default;
+
+SeekTable::~SeekTable() = default;
+
+zx_status_t SeekTable::Init(const void* src_buf, size_t src_size, size_t target_size) {
+    const uint8_t* src = reinterpret_cast<const uint8_t*>(src_buf);
+    if (src_size < kLz4MinHeaderSize || LoadLE32(src) != kLz4FrameMagic) {
+        return ZX_ERR_IO_DATA_INTEGRITY;
+    }
+    uint8_t flags = src[4];
+    uint8_t block_desc = src[5];
+    if ((flags & kLz4FlagVersionMask) != kLz4FlagVersion) {
+        return ZX_ERR_IO_DATA_INTEGRITY;
+    }
+    if (!(flags & kLz4FlagBlockIndependent) || (flags & kLz4FlagDictId) ||
+        ((block_desc >> 4) & 0x7) != LZ4F_max64KB) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
+    // Skip the rest of the frame descriptor: the optional content size and
+    // the header checksum.
+    size_t pos = kLz4MinHeaderSize + ((flags & kLz4FlagContentSize) ? sizeof(uint64_t) : 0);
+    size_t block_trailer = (flags & kLz4FlagBlockChecksum) ? sizeof(uint32_t) : 0;
+    if (pos > src_size) {
+        return ZX_ERR_IO_DATA_INTEGRITY;
+    }
+
+    size_t chunks = fbl::round_up(target_size, kCompressionChunkSize) / kCompressionChunkSize;
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<Entry[]> entries(new (&ac) Entry[chunks]);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    // Walk the block headers up to the end mark.
+    size_t count = 0;
+    while (true) {
+        if (src_size - pos < sizeof(uint32_t)) {
+            return ZX_ERR_IO_DATA_INTEGRITY;
+        }
+        uint32_t word = LoadLE32(src + pos);
+        pos += sizeof(uint32_t);
+        if (word == 0) {
+            break;
+        }
+        size_t length = word & ~kLz4BlockUncompressed;
+        if (count == chunks || length > kCompressionChunkSize ||
+            src_size - pos < length + block_trailer) {
+            return ZX_ERR_IO_DATA_INTEGRITY;
+        }
+        entries[count].offset = pos;
+        entries[count].size = word;
+        count++;
+        pos += length + block_trailer;
+    }
+    if (count != chunks) {
+        return ZX_ERR_IO_DATA_INTEGRITY;
+    }
+
+    src_ = src;
+    target_size_ = target_size;
+    chunks_ = chunks;
+    entries_ = fbl::move(entries);
+    return ZX_OK;
+}
+
+zx_status_t SeekTable::DecompressChunk(size_t index, void* target_buf,
+                                       size_t target_size) const {
+    ZX_DEBUG_ASSERT(index < chunks_);
+    TRACE_DURATION("blobfs", "SeekTable::DecompressChunk", "index", index);
+    size_t expected = fbl::min(kCompressionChunkSize,
+                               target_size_ - index * kCompressionChunkSize);
+    if (target_size < expected) {
+        return ZX_ERR_BUFFER_TOO_SMALL;
+    }
+
+    const Entry& entry = entries_[index];
+    size_t length = entry.size & ~kLz4BlockUncompressed;
+    if (entry.size & kLz4BlockUncompressed) {
+        if (length != expected) {
+            return ZX_ERR_IO_DATA_INTEGRITY;
+        }
+        memcpy(target_buf, src_ + entry.offset, length);
+        return ZX_OK;
+    }
+
+    int r = LZ4_decompress_safe(reinterpret_cast<const char*>(src_ + entry.offset),
+                                reinterpret_cast<char*>(target_buf),
+                                static_cast<int>(length), static_cast<int>(expected));
+    if (r < 0 || static_cast<size_t>(r) != expected) {
+        return ZX_ERR_IO_DATA_INTEGRITY;
+    }
+    return ZX_OK;
+}
+
+size_t SeekTable::CompressedSize(size_t start, size_t end) const {
+    ZX_DEBUG_ASSERT(start <= end && end <= chunks_);
+    size_t size = 0;
+    for (size_t i = start; i < end; i++) {
+        size += sizeof(uint32_t) + (entries_[i].size & ~kLz4BlockUncompressed);
+    }
+    return size;
+}
+
 } // namespace blobfs
@@ -35,6 +35,8 @@ void BlobfsMetrics::Dump() const {
     printf("  (Writeback Thread) Wrote %zu MB of data in %zu ms\n",
            total_writeback_bytes_written / mb,
            TicksToMs(total_writeback_time_ticks));
+    printf("  (Writeback Thread) Completed %zu works in %zu transactions\n",
+           writeback_works, writeback_transactions);
     printf("Lookup Info:\n");
     printf("  Opened %zu blobs (%zu MB)\n", blobs_opened,
            blobs_opened_total_size / mb);
@@ -45,6 +47,9 @@ void BlobfsMetrics::Dump() const {
            TicksToMs(total_read_from_disk_time_ticks),
            bytes_read_from_disk / mb,
            TicksToMs(total_verification_time_ticks));
+    printf("Cache Info:\n");
+    printf("  %zu hits, %zu misses\n", cache_hits, cache_misses);
+    printf("  Evicted %zu blobs (%zu MB)\n", cache_evictions, cache_evicted_bytes / mb);
 }
 
 } // namespace blobfs
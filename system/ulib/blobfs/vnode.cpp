@@ -46,6 +46,9 @@ void VnodeBlob::TearDown() {
         blobfs_->DetachVmo(vmoid_);
     }
     mapping_.Reset();
+    loaded_chunks_.reset();
+    seek_table_.reset();
+    compressed_mapping_.Reset();
 }
 
 VnodeBlob::~VnodeBlob() {
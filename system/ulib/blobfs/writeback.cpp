@@ -62,40 +62,45 @@ void WriteTxn::SetBuffer(vmoid_t vmoid) {
     vmoid_ = vmoid;
 }
 
-zx_status_t WriteTxn::Flush() {
+size_t WriteTxn::BuildRequests(block_fifo_request_t* out) const {
     ZX_ASSERT(IsBuffered());
-    fs::Ticker ticker(bs_->CollectingMetrics());
 
     // Update all the outgoing transactions to be in disk blocks
-    block_fifo_request_t blk_reqs[requests_.size()];
     const uint32_t kDiskBlocksPerBlobfsBlock = kBlobfsBlockSize / bs_->DeviceBlockSize();
     for (size_t i = 0; i < requests_.size(); i++) {
-        blk_reqs[i].group = bs_->BlockGroupID();
-        blk_reqs[i].vmoid = vmoid_;
-        blk_reqs[i].opcode = BLOCKIO_WRITE;
-        blk_reqs[i].vmo_offset = requests_[i].vmo_offset * kDiskBlocksPerBlobfsBlock;
-        blk_reqs[i].dev_offset = requests_[i].dev_offset * kDiskBlocksPerBlobfsBlock;
+        out[i].group = bs_->BlockGroupID();
+        out[i].vmoid = vmoid_;
+        out[i].opcode = BLOCKIO_WRITE;
+        out[i].vmo_offset = requests_[i].vmo_offset * kDiskBlocksPerBlobfsBlock;
+        out[i].dev_offset = requests_[i].dev_offset * kDiskBlocksPerBlobfsBlock;
         uint64_t length = requests_[i].length * kDiskBlocksPerBlobfsBlock;
         // TODO(ZX-2253): Requests this long, although unlikely, should be
         // handled more gracefully.
         ZX_ASSERT_MSG(length < UINT32_MAX, "Request size too large");
-        blk_reqs[i].length = static_cast<uint32_t>(length);
+        out[i].length = static_cast<uint32_t>(length);
     }
+    return requests_.size();
+}
+
+zx_status_t WriteTxn::Flush() {
+    ZX_ASSERT(IsBuffered());
+    fs::Ticker ticker(bs_->CollectingMetrics());
+
+    block_fifo_request_t blk_reqs[requests_.size()];
+    size_t count = BuildRequests(blk_reqs);
 
     // Actually send the operations to the underlying block device.
-    zx_status_t status = bs_->Transaction(blk_reqs, requests_.size());
+    zx_status_t status = bs_->Transaction(blk_reqs, count);
 
     if (bs_->CollectingMetrics()) {
         uint64_t sum = 0;
         for (const auto& blk_req : blk_reqs) {
             sum += blk_req.length * kBlobfsBlockSize;
         }
-        bs_->UpdateWritebackMetrics(sum, ticker.End());
+        bs_->UpdateWritebackMetrics(sum, 1, ticker.End());
     }
 
-    requests_.reset();
-    vmoid_ = VMOID_INVALID;
-    block_count_ = 0;
+    Clear();
     return status;
 }
 
@@ -136,19 +141,67 @@ void WritebackWork::SetSyncComplete() {
 // Returns the number of blocks of the writeback buffer that have been consumed
 zx_status_t WritebackWork::Complete() {
     zx_status_t status = Flush();
+    MarkCompleted(status);
+    return status;
+}
 
-    if (status == ZX_OK && sync_) {
-        vn_->CompleteSync();
+zx_status_t WritebackWork::CompleteGroup(fbl::unique_ptr<WritebackWork>* works, size_t count) {
+    ZX_DEBUG_ASSERT(count > 0);
+    if (count == 1) {
+        return works[0]->Complete();
     }
 
-    InvokeSyncCallback(status);
-    ResetInternal();
+    Blobfs* bs = works[0]->blobfs();
+    fs::Ticker ticker(bs->CollectingMetrics());
+
+    size_t request_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        request_count += works[i]->Requests().size();
+    }
+
+    block_fifo_request_t blk_reqs[request_count];
+    size_t next = 0;
+    for (size_t i = 0; i < count; i++) {
+        size_t added = works[i]->BuildRequests(&blk_reqs[next]);
+        if (added > 0 && next > 0) {
+            // Requests within a transaction may be reordered by the device. Keep the works in
+            // order, since the journal relies on data reaching the disk before the entries
+            // which reference it.
+            blk_reqs[next].opcode |= BLOCKIO_BARRIER_BEFORE;
+        }
+        next += added;
+    }
+
+    // Issue the whole group at once, so the writeback thread waits for the device only once.
+    zx_status_t status = bs->Transaction(blk_reqs, request_count);
+
+    if (bs->CollectingMetrics()) {
+        uint64_t sum = 0;
+        for (const auto& blk_req : blk_reqs) {
+            sum += blk_req.length * kBlobfsBlockSize;
+        }
+        bs->UpdateWritebackMetrics(sum, count, ticker.End());
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        works[i]->Clear();
+        works[i]->MarkCompleted(status);
+    }
     return status;
 }
 
 WritebackWork::WritebackWork(Blobfs* bs, fbl::RefPtr<VnodeBlob> vn) :
     WriteTxn(bs), ready_cb_(nullptr), sync_cb_(nullptr), sync_(false), vn_(fbl::move(vn)) {}
 
+void WritebackWork::MarkCompleted(zx_status_t status) {
+    if (status == ZX_OK && sync_) {
+        vn_->CompleteSync();
+    }
+
+    InvokeSyncCallback(status);
+    ResetInternal();
+}
+
 void WritebackWork::InvokeSyncCallback(zx_status_t status) {
     if (sync_cb_) {
         sync_cb_(status);
@@ -293,13 +346,14 @@ void Buffer::AddTransaction(size_t start, size_t disk_start, size_t length, Writ
     work->Enqueue(mapper_.vmo().get(), start, disk_start, length);
 }
 
-bool Buffer::VerifyTransaction(WriteTxn* txn) const {
+bool Buffer::VerifyTransaction(WriteTxn* txn, size_t pending_blocks) const {
     if (txn->CheckBuffer(vmoid_)) {
         if (txn->BlkCount() > 0) {
             // If the work belongs to the WritebackQueue, verify that it matches up with the
             // buffer's start/len.
-            ZX_ASSERT(txn->BlkStart() == start_);
-            ZX_ASSERT(txn->BlkCount() <= length_);
+            ZX_ASSERT(pending_blocks <= length_);
+            ZX_ASSERT(txn->BlkStart() == (start_ + pending_blocks) % capacity_);
+            ZX_ASSERT(txn->BlkCount() <= length_ - pending_blocks);
         }
 
         return true;
@@ -437,24 +491,42 @@ int WritebackQueue::WritebackThread(void* arg) {
                 break;
             }
 
-            auto work = b->work_queue_.pop();
-            TRACE_DURATION("blobfs", "WritebackQueue::WritebackThread", "work ptr", work.get());
-
-            bool our_buffer = b->buffer_->VerifyTransaction(work.get());
-            size_t blk_count = work->BlkCount();
+            // Take every consecutive ready work, up to the group limits.
+            fbl::unique_ptr<WritebackWork> works[kMaxGroupWorks];
+            size_t count = 0;
+            size_t request_count = 0;
+            size_t buffer_blocks = 0;
+            do {
+                size_t requests = b->work_queue_.front().Requests().size();
+                if (count > 0 && request_count + requests > kMaxGroupRequests) {
+                    break;
+                }
+                auto work = b->work_queue_.pop();
+                if (b->buffer_->VerifyTransaction(work.get(), buffer_blocks)) {
+                    buffer_blocks += work->BlkCount();
+                }
+                request_count += requests;
+                works[count++] = fbl::move(work);
+            } while (count < kMaxGroupWorks && !b->work_queue_.is_empty() &&
+                     (error || b->work_queue_.front().IsReady()));
+            TRACE_DURATION("blobfs", "WritebackQueue::WritebackThread", "works", count);
 
-            // Stay unlocked while processing a unit of work.
+            // Stay unlocked while processing the group.
             b->lock_.Release();
 
             if (error) {
-                // If we are in a read only state, reset the work without completing it.
-                work->Reset(ZX_ERR_BAD_STATE);
+                // If we are in a read only state, reset the works without completing them.
+                for (size_t i = 0; i < count; i++) {
+                    works[i]->Reset(ZX_ERR_BAD_STATE);
+                }
             } else {
-                // If we should complete the work, make sure it has been buffered.
+                // If we should complete the works, make sure they have been buffered.
                 // (This is not necessary if we are currently in an error state).
-                ZX_DEBUG_ASSERT(work->IsBuffered());
+                for (size_t i = 0; i < count; i++) {
+                    ZX_DEBUG_ASSERT(works[i]->IsBuffered());
+                }
                 zx_status_t status;
-                if ((status = work->Complete()) != ZX_OK) {
+                if ((status = WritebackWork::CompleteGroup(works, count)) != ZX_OK) {
                     fprintf(stderr, "Work failed with status %d - "
                                     "converting writeback to read only state.\n", status);
                     // If work completion failed, set the buffer to an error state.
@@ -462,7 +534,9 @@ int WritebackQueue::WritebackThread(void* arg) {
                 }
             }
 
-            work = nullptr;
+            for (size_t i = 0; i < count; i++) {
+                works[i] = nullptr;
+            }
             b->lock_.Acquire();
 
             if (error) {
@@ -470,10 +544,9 @@ int WritebackQueue::WritebackThread(void* arg) {
                 b->state_ = WritebackState::kReadOnly;
             }
 
-            if (our_buffer) {
-                // If the last work we processed belonged to our buffer,
-                // update the buffer's start/len accordingly.
-                b->buffer_->FreeSpace(blk_count);
+            // Release the part of our buffer used by the works we processed.
+            if (buffer_blocks > 0) {
+                b->buffer_->FreeSpace(buffer_blocks);
             }
 
             // We may have opened up space (or entered a read only state),
@@ -0,0 +1,193 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdlib.h>
+
+#include <block-client/cpp/async-client.h>
+#include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
+#include <fbl/array.h>
+#include <fbl/unique_ptr.h>
+#include <lib/async/cpp/wait.h>
+#include <lib/zx/fifo.h>
+#include <zircon/assert.h>
+#include <zircon/device/block.h>
+#include <zircon/types.h>
+
+namespace block_client {
+
+AsyncClient::AsyncClient(zx::fifo fifo, async_dispatcher_t* dispatcher)
+    : fifo_(fbl::move(fifo)), dispatcher_(dispatcher) {
+    for (groupid_t group = 0; group < MAX_TXN_GROUP_COUNT; group++) {
+        free_groups_[free_count_++] = group;
+    }
+    read_wait_.set_object(fifo_.get());
+    read_wait_.set_trigger(ZX_FIFO_READABLE | ZX_FIFO_PEER_CLOSED);
+    write_wait_.set_object(fifo_.get());
+    write_wait_.set_trigger(ZX_FIFO_WRITABLE | ZX_FIFO_PEER_CLOSED);
+}
+
+AsyncClient::~AsyncClient() {
+    read_wait_.Cancel();
+    write_wait_.Cancel();
+    CompleteAll(ZX_ERR_CANCELED);
+}
+
+zx_status_t AsyncClient::Create(zx::fifo fifo, async_dispatcher_t* dispatcher,
+                                fbl::unique_ptr<AsyncClient>* out) {
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<AsyncClient> client(new (&ac) AsyncClient(fbl::move(fifo), dispatcher));
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    zx_status_t status = client->read_wait_.Begin(dispatcher);
+    if (status != ZX_OK) {
+        return status;
+    }
+    *out = fbl::move(client);
+    return ZX_OK;
+}
+
+zx_status_t AsyncClient::Submit(const block_fifo_request_t* requests, size_t count,
+                                TransactionCallback callback) {
+    if (closed_) {
+        return ZX_ERR_BAD_STATE;
+    }
+    if (count == 0 || !callback) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<Transaction> txn(new (&ac) Transaction());
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    txn->requests.reset(new (&ac) block_fifo_request_t[count], count);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    const uint32_t kKeptFlags = BLOCKIO_OP_MASK | BLOCKIO_BARRIER_BEFORE | BLOCKIO_BARRIER_AFTER;
+    for (size_t i = 0; i < count; i++) {
+        txn->requests[i] = requests[i];
+        txn->requests[i].opcode = (requests[i].opcode & kKeptFlags) | BLOCKIO_GROUP_ITEM;
+    }
+    txn->requests[count - 1].opcode |= BLOCKIO_GROUP_LAST;
+    txn->callback = fbl::move(callback);
+
+    queue_.push_back(fbl::move(txn));
+    outstanding_++;
+    Flush();
+    return ZX_OK;
+}
+
+void AsyncClient::Flush() {
+    while (!closed_ && !queue_.is_empty()) {
+        Transaction& txn = queue_.front();
+        if (txn.group == MAX_TXN_GROUP_COUNT) {
+            if (free_count_ == 0) {
+                // Resumed when a transaction completes.
+                return;
+            }
+            txn.group = free_groups_[--free_count_];
+            for (size_t i = 0; i < txn.requests.size(); i++) {
+                txn.requests[i].group = txn.group;
+            }
+        }
+
+        size_t actual;
+        zx_status_t status = fifo_.write(sizeof(block_fifo_request_t), &txn.requests[txn.sent],
+                                         txn.requests.size() - txn.sent, &actual);
+        if (status == ZX_ERR_SHOULD_WAIT) {
+            if (!write_wait_.is_pending()) {
+                write_wait_.Begin(dispatcher_);
+            }
+            return;
+        } else if (status != ZX_OK) {
+            // The server has gone away; |HandleReadable| fails everything once
+            // it sees the peer closed.
+            return;
+        }
+
+        txn.sent += actual;
+        if (txn.sent == txn.requests.size()) {
+            groupid_t group = txn.group;
+            groups_[group] = queue_.pop_front();
+        }
+    }
+}
+
+void AsyncClient::CompleteAll(zx_status_t status) {
+    closed_ = true;
+    TransactionList done;
+    for (size_t i = 0; i < fbl::count_of(groups_); i++) {
+        if (groups_[i]) {
+            done.push_back(fbl::move(groups_[i]));
+        }
+    }
+    while (!queue_.is_empty()) {
+        done.push_back(queue_.pop_front());
+    }
+    outstanding_ = 0;
+
+    while (!done.is_empty()) {
+        fbl::unique_ptr<Transaction> txn = done.pop_front();
+        txn->callback(status);
+    }
+}
+
+void AsyncClient::HandleReadable(async_dispatcher_t* dispatcher, async::WaitBase* wait,
+                                 zx_status_t status, const zx_packet_signal_t* signal) {
+    if (status != ZX_OK) {
+        CompleteAll(status);
+        return;
+    }
+    if (!(signal->observed & ZX_FIFO_READABLE)) {
+        CompleteAll(ZX_ERR_PEER_CLOSED);
+        return;
+    }
+
+    // Collect the completed transactions, and only run their callbacks once
+    // the state of the client is consistent again, since they may submit more
+    // or destroy the client.
+    TransactionList done;
+    size_t done_count = 0;
+    block_fifo_response_t responses[BLOCK_FIFO_MAX_DEPTH];
+    size_t count;
+    while (fifo_.read(sizeof(block_fifo_response_t), responses, fbl::count_of(responses),
+                      &count) == ZX_OK) {
+        for (size_t i = 0; i < count; i++) {
+            groupid_t group = responses[i].group;
+            if (group >= MAX_TXN_GROUP_COUNT || !groups_[group]) {
+                // Not a response to anything in flight.
+                continue;
+            }
+            fbl::unique_ptr<Transaction> txn = fbl::move(groups_[group]);
+            txn->status = responses[i].status;
+            done.push_back(fbl::move(txn));
+            done_count++;
+            free_groups_[free_count_++] = group;
+        }
+    }
+    outstanding_ -= done_count;
+    Flush();
+
+    if ((status = wait->Begin(dispatcher)) != ZX_OK) {
+        CompleteAll(status);
+    }
+
+    while (!done.is_empty()) {
+        fbl::unique_ptr<Transaction> txn = done.pop_front();
+        txn->callback(txn->status);
+    }
+}
+
+void AsyncClient::HandleWritable(async_dispatcher_t* dispatcher, async::WaitBase* wait,
+                                 zx_status_t status, const zx_packet_signal_t* signal) {
+    if (status == ZX_OK && (signal->observed & ZX_FIFO_WRITABLE)) {
+        Flush();
+    }
+}
+
+}  // namespace block_client
@@ -100,9 +100,12 @@ zx_status_t block_fifo_txn(fifo_client_t* client, block_fifo_request_t* requests
     client->groups[group].status = ZX_ERR_IO;
 
     zx_status_t status;
+    // Callers may order requests within the transaction with barriers.
+    const uint32_t kKeptFlags = BLOCKIO_BARRIER_BEFORE | BLOCKIO_BARRIER_AFTER;
     for (size_t i = 0; i < count; i++) {
         assert(requests[i].group == group);
-        requests[i].opcode = (requests[i].opcode & BLOCKIO_OP_MASK) | BLOCKIO_GROUP_ITEM;
+        requests[i].opcode = (requests[i].opcode & (BLOCKIO_OP_MASK | kKeptFlags)) |
+                             BLOCKIO_GROUP_ITEM;
     }
 
     requests[0].opcode |= BLOCKIO_BARRIER_BEFORE;
@@ -38,6 +38,11 @@ void block_fifo_release_client(fifo_client_t* client);
 // length                                   read, write
 // vmo_offset                               read, write
 // dev_offset                               read, write
+//
+// The opcode may also carry BLOCKIO_BARRIER_BEFORE or BLOCKIO_BARRIER_AFTER to
+// order requests within the transaction; other flags are ignored. The first
+// request always waits for all prior operations, and the last one is always
+// followed by a barrier.
 zx_status_t block_fifo_txn(fifo_client_t* client, block_fifo_request_t* requests, size_t count);
 
 __END_CDECLS
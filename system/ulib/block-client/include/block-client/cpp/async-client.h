@@ -0,0 +1,111 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#ifndef __cplusplus
+#error "C++ Only file"
+#endif  // __cplusplus
+
+#include <stdlib.h>
+
+#include <fbl/array.h>
+#include <fbl/function.h>
+#include <fbl/intrusive_double_list.h>
+#include <fbl/macros.h>
+#include <fbl/unique_ptr.h>
+#include <lib/async/cpp/wait.h>
+#include <lib/async/dispatcher.h>
+#include <lib/zx/fifo.h>
+#include <zircon/device/block.h>
+#include <zircon/types.h>
+
+namespace block_client {
+
+// Invoked once every request of a transaction submitted to an |AsyncClient|
+// has completed, with the first error encountered, if any.
+using TransactionCallback = fbl::Function<void(zx_status_t status)>;
+
+// Issues block requests over a block device fifo without waiting for them.
+//
+// Each transaction submitted is sent as one group, and the client allocates
+// groups internally, so up to MAX_TXN_GROUP_COUNT transactions may be in
+// flight at once; further ones are queued until a group becomes free.
+// Responses are read on |dispatcher|, which also runs the callbacks.
+//
+// Unlike |block_fifo_txn|, no barriers are added: transactions may complete in
+// any order, and callers order requests with BLOCKIO_BARRIER_BEFORE or
+// BLOCKIO_BARRIER_AFTER where it matters.
+//
+// This class is not thread-safe.  It must be used, and destroyed, on the
+// dispatcher's thread.  The fifo must not be used by another client.
+class AsyncClient {
+public:
+    DISALLOW_COPY_ASSIGN_AND_MOVE(AsyncClient);
+
+    static zx_status_t Create(zx::fifo fifo, async_dispatcher_t* dispatcher,
+                              fbl::unique_ptr<AsyncClient>* out);
+
+    // Transactions still queued or in flight are completed with
+    // |ZX_ERR_CANCELED|.
+    ~AsyncClient();
+
+    // Submits |count| requests as a single transaction, and returns without
+    // waiting for them.  The requests are copied; their group fields are
+    // ignored.  On success, |callback| is always eventually invoked.
+    //
+    // Returns |ZX_ERR_BAD_STATE| if the fifo has been closed by the server.
+    zx_status_t Submit(const block_fifo_request_t* requests, size_t count,
+                       TransactionCallback callback);
+
+    // Returns the number of transactions submitted which have not completed.
+    size_t outstanding() const { return outstanding_; }
+
+private:
+    struct Transaction : public fbl::DoublyLinkedListable<fbl::unique_ptr<Transaction>> {
+        fbl::Array<block_fifo_request_t> requests;
+        // Number of |requests| written to the fifo so far.
+        size_t sent = 0;
+        groupid_t group = MAX_TXN_GROUP_COUNT;
+        // Status reported by the server once the group completes.
+        zx_status_t status = ZX_OK;
+        TransactionCallback callback;
+    };
+    using TransactionList = fbl::DoublyLinkedList<fbl::unique_ptr<Transaction>>;
+
+    AsyncClient(zx::fifo fifo, async_dispatcher_t* dispatcher);
+
+    // Writes queued transactions to the fifo until it is full, or no group is
+    // free for the next one.
+    void Flush();
+
+    // Stops accepting transactions, and runs the callbacks of those in flight
+    // and queued with |status|.
+    void CompleteAll(zx_status_t status);
+
+    void HandleReadable(async_dispatcher_t* dispatcher, async::WaitBase* wait,
+                        zx_status_t status, const zx_packet_signal_t* signal);
+    void HandleWritable(async_dispatcher_t* dispatcher, async::WaitBase* wait,
+                        zx_status_t status, const zx_packet_signal_t* signal);
+
+    zx::fifo fifo_;
+    async_dispatcher_t* const dispatcher_;
+    async::WaitMethod<AsyncClient, &AsyncClient::HandleReadable> read_wait_{this};
+    async::WaitMethod<AsyncClient, &AsyncClient::HandleWritable> write_wait_{this};
+
+    // Set once the server has closed the fifo.
+    bool closed_ = false;
+    size_t outstanding_ = 0;
+
+    // Transactions waiting for a group, or for room in the fifo.  Only the
+    // head may have been partially sent.
+    TransactionList queue_;
+    // Transactions fully sent, indexed by group.
+    fbl::unique_ptr<Transaction> groups_[MAX_TXN_GROUP_COUNT];
+    // Stack of the groups not in use.
+    groupid_t free_groups_[MAX_TXN_GROUP_COUNT];
+    size_t free_count_ = 0;
+};
+
+}  // namespace block_client
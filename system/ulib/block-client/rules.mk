@@ -11,10 +11,13 @@ MODULE_TYPE := userlib
 MODULE_COMPILEFLAGS += -fvisibility=hidden
 
 MODULE_SRCS += \
+    $(LOCAL_DIR)/async-client.cpp \
     $(LOCAL_DIR)/client.c \
     $(LOCAL_DIR)/client.cpp \
 
 MODULE_STATIC_LIBS := \
+    system/ulib/async \
+    system/ulib/async.cpp \
     system/ulib/fbl \
     system/ulib/fs \
     system/ulib/sync \
@@ -85,45 +85,13 @@ static zx_status_t check_lz4_frame(const lz4_frame_desc* fd,
     return ZX_OK;
 }
 
-static zx_status_t decompress_bootfs_vmo(zx_handle_t vmar, const uint8_t* data,
-                                         size_t _outsize, zx_handle_t* out,
-                                         const char** err) {
-    if (*(const uint32_t*)data != ZX_LZ4_MAGIC) {
-        *err = "bad magic number for compressed bootfs";
-        return ZX_ERR_INVALID_ARGS;
-    }
-    data += sizeof(uint32_t);
-
-    zx_status_t status = check_lz4_frame((const lz4_frame_desc*)data, _outsize, err);
-    if (status < 0)
-        return status;
-    data += sizeof(lz4_frame_desc);
-
-    size_t outsize = (_outsize + 4095) & ~4095;
-    if (outsize < _outsize) {
-        // newsize wrapped, which means the outsize was too large
-        *err = "lz4 output size too large";
-        return ZX_ERR_NO_MEMORY;
-    }
-    zx_handle_t dst_vmo;
-    status = zx_vmo_create((uint64_t)outsize, 0, &dst_vmo);
-    if (status < 0) {
-        *err = "zx_vmo_create failed for decompressing bootfs";
-        return status;
-    }
-    zx_object_set_property(dst_vmo, ZX_PROP_NAME, "bootfs", 6);
-
-    uintptr_t dst_addr = 0;
-    status = zx_vmar_map(vmar,
-            ZX_VM_PERM_READ|ZX_VM_PERM_WRITE,
-            0, dst_vmo, 0, outsize, &dst_addr);
-    if (status < 0) {
-        *err = "zx_vmar_map failed on bootfs vmo during decompression";
-        return status;
-    }
+#define ZX_LZ4_BLOCK_SIZE (64 << 10)
 
+// Decompresses the LZ4 blocks starting at |data| into |dst| one after
+// another.
+static zx_status_t lz4_decompress_serial(const uint8_t* data, uint8_t* dst,
+                                         size_t outsize, const char** err) {
     size_t remaining = outsize;
-    uint8_t* dst = (uint8_t*)dst_addr;
 
     // Read each LZ4 block and decompress it. Block sizes are 32 bits.
     uint32_t blocksize = *(const uint32_t*)data;
@@ -168,6 +136,190 @@ static zx_status_t decompress_bootfs_vmo(zx_handle_t vmar, const uint8_t* data,
         *err = "bootdata size error; outsize does not match decompressed size";
         return ZX_ERR_INVALID_ARGS;
     }
+    return ZX_OK;
+}
+
+// Blocks are independent, and the compressor fills every block but the
+// last, so block n decompresses to ZX_LZ4_BLOCK_SIZE bytes at offset
+// n * ZX_LZ4_BLOCK_SIZE. That lets each thread take every |nthreads|th block
+// without knowing what the blocks before it hold. A frame whose blocks are
+// not laid out like that is decompressed serially instead.
+#define LZ4_MAX_THREADS 16
+// Below this many blocks per thread, starting threads costs more than it
+// saves.
+#define LZ4_MIN_BLOCKS_PER_THREAD 16
+
+typedef struct {
+    const uint8_t* data;
+    uint8_t* dst;
+    size_t content_size;
+    size_t nthreads;
+    // ZX_ERR_NEXT if the worker found a block that does not fit the layout
+    zx_status_t status[LZ4_MAX_THREADS];
+} lz4_parallel_job;
+
+static void lz4_decompress_worker(void* arg, size_t index) {
+    lz4_parallel_job* job = arg;
+    const uint8_t* data = job->data;
+    zx_status_t status = ZX_OK;
+
+    uint32_t blocksize = *(const uint32_t*)data;
+    data += sizeof(uint32_t);
+    for (size_t n = 0; blocksize && status == ZX_OK; n++) {
+        uint32_t actual = blocksize & 0x7fffffff;
+        if (n % job->nthreads == index) {
+            size_t off = n * ZX_LZ4_BLOCK_SIZE;
+            size_t expected = job->content_size - off;
+            if (expected > ZX_LZ4_BLOCK_SIZE) {
+                expected = ZX_LZ4_BLOCK_SIZE;
+            }
+            uint8_t* dst = job->dst + off;
+            if (blocksize >> 31) {
+                if (actual != expected) {
+                    status = ZX_ERR_NEXT;
+                } else {
+                    memcpy(dst, data, actual);
+                }
+            } else {
+                int dcmp = LZ4_decompress_safe((const char*)data, (char*)dst,
+                                               actual, (int)expected);
+                // A block bigger than its slot fails to decompress, so
+                // corrupt data and odd layouts are both left for the
+                // serial pass to sort out.
+                if (dcmp < 0 || (size_t)dcmp != expected) {
+                    status = ZX_ERR_NEXT;
+                }
+            }
+        }
+        data += actual;
+        blocksize = *(const uint32_t*)data;
+        data += sizeof(uint32_t);
+    }
+
+    job->status[index] = status;
+}
+
+// Counts the blocks of the frame at |data| and checks that they lie within
+// |insize| bytes.
+static zx_status_t lz4_count_blocks(const uint8_t* data, size_t insize,
+                                    size_t* count, const char** err) {
+    size_t n = 0;
+    size_t pos = 0;
+    for (;;) {
+        if (insize - pos < sizeof(uint32_t)) {
+            *err = "lz4 frame truncated";
+            return ZX_ERR_INVALID_ARGS;
+        }
+        uint32_t blocksize = *(const uint32_t*)(data + pos);
+        pos += sizeof(uint32_t);
+        if (blocksize == 0) {
+            break;
+        }
+        uint32_t actual = blocksize & 0x7fffffff;
+        if (actual > insize - pos) {
+            *err = "lz4 frame truncated";
+            return ZX_ERR_INVALID_ARGS;
+        }
+        pos += actual;
+        n++;
+    }
+    *count = n;
+    return ZX_OK;
+}
+
+static zx_status_t lz4_decompress_parallel(const uint8_t* data, size_t insize, uint8_t* dst,
+                                           size_t content_size, size_t outsize,
+                                           const decompress_threads_t* threads,
+                                           const char** err) {
+    size_t nthreads = 1;
+    if (threads != NULL && threads->run != NULL) {
+        size_t nblocks;
+        zx_status_t status = lz4_count_blocks(data, insize, &nblocks, err);
+        if (status != ZX_OK) {
+            return status;
+        }
+        // Only a frame laid out the way the workers expect ends with a
+        // partial or full last block.
+        if (nblocks == (content_size + ZX_LZ4_BLOCK_SIZE - 1) / ZX_LZ4_BLOCK_SIZE) {
+            nthreads = nblocks / LZ4_MIN_BLOCKS_PER_THREAD;
+            if (nthreads > threads->max_threads) {
+                nthreads = threads->max_threads;
+            }
+            if (nthreads > LZ4_MAX_THREADS) {
+                nthreads = LZ4_MAX_THREADS;
+            }
+        }
+    }
+
+    if (nthreads > 1) {
+        lz4_parallel_job job = {
+            .data = data,
+            .dst = dst,
+            .content_size = content_size,
+            .nthreads = nthreads,
+        };
+        threads->run(threads->ctx, lz4_decompress_worker, &job, nthreads);
+
+        bool done = true;
+        for (size_t i = 0; i < nthreads; i++) {
+            done = done && job.status[i] == ZX_OK;
+        }
+        if (done) {
+            return ZX_OK;
+        }
+        memset(dst, 0, outsize);
+    }
+
+    return lz4_decompress_serial(data, dst, outsize, err);
+}
+
+static zx_status_t decompress_bootfs_vmo(zx_handle_t vmar, const uint8_t* data,
+                                         size_t insize, size_t _outsize,
+                                         const decompress_threads_t* threads,
+                                         zx_handle_t* out, const char** err) {
+    if (insize < sizeof(uint32_t) + sizeof(lz4_frame_desc) ||
+        *(const uint32_t*)data != ZX_LZ4_MAGIC) {
+        *err = "bad magic number for compressed bootfs";
+        return ZX_ERR_INVALID_ARGS;
+    }
+    data += sizeof(uint32_t);
+
+    zx_status_t status = check_lz4_frame((const lz4_frame_desc*)data, _outsize, err);
+    if (status < 0)
+        return status;
+    data += sizeof(lz4_frame_desc);
+    insize -= sizeof(uint32_t) + sizeof(lz4_frame_desc);
+
+    size_t outsize = (_outsize + 4095) & ~4095;
+    if (outsize < _outsize) {
+        // newsize wrapped, which means the outsize was too large
+        *err = "lz4 output size too large";
+        return ZX_ERR_NO_MEMORY;
+    }
+    zx_handle_t dst_vmo;
+    status = zx_vmo_create((uint64_t)outsize, 0, &dst_vmo);
+    if (status < 0) {
+        *err = "zx_vmo_create failed for decompressing bootfs";
+        return status;
+    }
+    zx_object_set_property(dst_vmo, ZX_PROP_NAME, "bootfs", 6);
+
+    uintptr_t dst_addr = 0;
+    status = zx_vmar_map(vmar,
+            ZX_VM_PERM_READ|ZX_VM_PERM_WRITE,
+            0, dst_vmo, 0, outsize, &dst_addr);
+    if (status < 0) {
+        *err = "zx_vmar_map failed on bootfs vmo during decompression";
+        return status;
+    }
+
+    status = lz4_decompress_parallel(data, insize, (uint8_t*)dst_addr, _outsize, outsize,
+                                     threads, err);
+    if (status != ZX_OK) {
+        zx_vmar_unmap(vmar, dst_addr, outsize);
+        zx_handle_close(dst_vmo);
+        return status;
+    }
 
     status = zx_vmar_unmap(vmar, dst_addr, outsize);
     if (status < 0) {
@@ -181,6 +333,13 @@ static zx_status_t decompress_bootfs_vmo(zx_handle_t vmar, const uint8_t* data,
 zx_status_t decompress_bootdata(zx_handle_t vmar, zx_handle_t vmo,
                                 size_t offset, size_t length,
                                 zx_handle_t* out, const char** err) {
+    return decompress_bootdata_threads(vmar, vmo, offset, length, NULL, out, err);
+}
+
+zx_status_t decompress_bootdata_threads(zx_handle_t vmar, zx_handle_t vmo,
+                                        size_t offset, size_t length,
+                                        const decompress_threads_t* threads,
+                                        zx_handle_t* out, const char** err) {
     *err = "none";
 
     if (length > SIZE_MAX) {
@@ -207,7 +366,9 @@ zx_status_t decompress_bootdata(zx_handle_t vmar, zx_handle_t vmo,
     case BOOTDATA_BOOTFS_SYSTEM:
     case BOOTDATA_RAMDISK:
         if (hdr->flags & BOOTDATA_BOOTFS_FLAG_COMPRESSED) {
-            status = decompress_bootfs_vmo(vmar, (const uint8_t*)bootdata_addr, hdr->extra, out, err);
+            status = decompress_bootfs_vmo(vmar, (const uint8_t*)bootdata_addr,
+                                           length - align_shift - sizeof(bootdata_t),
+                                           hdr->extra, threads, out, err);
         }
         break;
     default:
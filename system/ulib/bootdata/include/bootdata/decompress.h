@@ -6,11 +6,22 @@
 
 #pragma GCC visibility push(hidden)
 
+#include <stddef.h>
 #include <zircon/compiler.h>
 #include <zircon/types.h>
 
 __BEGIN_CDECLS
 
+// How the decompressor may use more than one thread. |run| calls
+// |fn|(|arg|, i) for each i in [0, |count|), concurrently where it can, and
+// returns once all of the calls have returned. |count| is never more than
+// |max_threads|.
+typedef struct decompress_threads {
+    void (*run)(void* ctx, void (*fn)(void* arg, size_t i), void* arg, size_t count);
+    void* ctx;
+    size_t max_threads;
+} decompress_threads_t;
+
 // Decompress bootdata at offset of total size length into a new VMO
 // On failure, errmsg is a human readable error description to provide
 // more precise debug information.
@@ -18,6 +29,14 @@ zx_status_t decompress_bootdata(zx_handle_t vmar, zx_handle_t vmo,
                                 size_t offset, size_t length,
                                 zx_handle_t* out, const char** errmsg);
 
+// Like decompress_bootdata(), but splits the independent blocks of a large
+// LZ4 frame between the threads that |threads| provides. |threads| may be
+// NULL.
+zx_status_t decompress_bootdata_threads(zx_handle_t vmar, zx_handle_t vmo,
+                                        size_t offset, size_t length,
+                                        const decompress_threads_t* threads,
+                                        zx_handle_t* out, const char** errmsg);
+
 __END_CDECLS
 
 #pragma GCC visibility pop
@@ -7,11 +7,23 @@
 #include <cobalt-client/cpp/counter-internal.h>
 #include <cobalt-client/cpp/counter.h>
 #include <zircon/assert.h>
+#include <zircon/compiler.h>
 
 namespace cobalt_client {
 namespace internal {
 
-BaseCounter::BaseCounter(BaseCounter&& other) : counter_(other.Exchange(0)) {}
+uint32_t GetMetricShard() {
+    static fbl::atomic<uint32_t> next_shard(0);
+    static thread_local uint32_t shard = kMetricShards;
+    if (unlikely(shard == kMetricShards)) {
+        shard = next_shard.fetch_add(1, fbl::memory_order_relaxed) % kMetricShards;
+    }
+    return shard;
+}
+
+BaseCounter::BaseCounter(BaseCounter&& other) {
+    shards_[0].value.store(other.Exchange(0), kMemoryOrder);
+}
 
 RemoteCounter::RemoteCounter(const RemoteMetricInfo& metric_info, EventBuffer buffer)
     : BaseCounter(), buffer_(fbl::move(buffer)), metric_info_(metric_info) {
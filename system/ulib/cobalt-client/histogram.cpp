@@ -87,14 +87,21 @@ void LoadLinear(HistogramOptions* options) {
 
 } // namespace
 
-BaseHistogram::BaseHistogram(uint32_t num_buckets) {
-    buckets_.reserve(num_buckets);
-    for (uint32_t i = 0; i < num_buckets; ++i) {
-        buckets_.push_back(BaseCounter());
+BaseHistogram::BaseHistogram(uint32_t num_buckets)
+    : num_buckets_(num_buckets),
+      shard_stride_(num_buckets +
+                    static_cast<uint32_t>(kMetricCacheLineSize / sizeof(fbl::atomic<Count>)) -
+                    1) {
+    size_t count = shard_stride_ * kMetricShards;
+    buckets_.reset(new fbl::atomic<Count>[count], count);
+    for (size_t i = 0; i < count; ++i) {
+        buckets_[i].store(0, BaseCounter::kMemoryOrder);
     }
 }
 
-BaseHistogram::BaseHistogram(BaseHistogram&& other) = default;
+BaseHistogram::BaseHistogram(BaseHistogram&& other)
+    : num_buckets_(other.num_buckets_), shard_stride_(other.shard_stride_),
+      buckets_(fbl::move(other.buckets_)) {}
 
 RemoteHistogram::RemoteHistogram(uint32_t num_buckets, const RemoteMetricInfo& metric_info,
                                  RemoteHistogram::EventBuffer buffer)
@@ -123,7 +130,7 @@ bool RemoteHistogram::Flush(const RemoteHistogram::FlushFn& flush_handler) {
     // Sets every bucket back to 0, not all buckets will be at the same instant, but
     // eventual consistency in the backend is good enough.
     for (uint32_t bucket_index = 0; bucket_index < bucket_buffer_.size(); ++bucket_index) {
-        bucket_buffer_[bucket_index].count = buckets_[bucket_index].Exchange();
+        bucket_buffer_[bucket_index].count = ExchangeCount(bucket_index);
     }
 
     flush_handler(metric_info_, buffer_, fbl::BindMember(&buffer_, &EventBuffer::CompleteFlush));
@@ -19,12 +19,27 @@ namespace internal {
 // Note: Everything on this namespace is internal, no external users should rely
 // on the behaviour of any of these classes.
 
+// Metrics are sharded, so that threads updating the same metric at the same time usually
+// write to different cache lines. Each thread updates a single shard, and readers sum all of
+// them.
+//
+// Every shard costs a cache line per counter, and a copy of the buckets plus 56 bytes per
+// histogram, so the count is kept to the handful of dispatch threads a filesystem runs.
+constexpr uint32_t kMetricShards = 4;
+
+// Size of the cache line the shards are kept apart by.
+constexpr size_t kMetricCacheLineSize = 64;
+
+// Returns the shard the calling thread updates. Threads are handed out shards in turn the
+// first time they update a metric.
+uint32_t GetMetricShard();
+
 // BaseCounter and RemoteCounter differ in that the first is simply a thin wrapper over
-// an atomic while the second provides Cobalt Fidl specific API and holds more metric related
-// data for a full fledged metric.
+// a set of atomics while the second provides Cobalt Fidl specific API and holds more metric
+// related data for a full fledged metric.
 //
-// Thin wrapper on top of an atomic, which provides a fixed memory ordering for all calls.
-// Calls are inlined to reduce overhead.
+// Thin wrapper on top of a sharded atomic, which provides a fixed memory ordering for all
+// calls. Calls are inlined to reduce overhead.
 class BaseCounter {
 public:
     using Type = uint64_t;
@@ -32,24 +47,45 @@ public:
     // All atomic operations use this memory order.
     static constexpr fbl::memory_order kMemoryOrder = fbl::memory_order::memory_order_relaxed;
 
-    BaseCounter() : counter_(0) {}
+    BaseCounter() = default;
     BaseCounter(const BaseCounter&) = delete;
     BaseCounter(BaseCounter&&);
     BaseCounter& operator=(const BaseCounter&) = delete;
     BaseCounter& operator=(BaseCounter&&) = delete;
     ~BaseCounter() = default;
 
-    // Increments |counter_| by |val|.
-    void Increment(Type val = 1) { counter_.fetch_add(val, kMemoryOrder); }
-
-    // Returns the current value of|counter_| and resets it to |val|.
-    Type Exchange(Type val = 0) { return counter_.exchange(val, kMemoryOrder); }
-
-    // Returns the current value of |counter_|.
-    Type Load() const { return counter_.load(kMemoryOrder); }
+    // Increments the calling thread's shard of the counter by |val|.
+    void Increment(Type val = 1) { shards_[GetMetricShard()].value.fetch_add(val, kMemoryOrder); }
+
+    // Returns the current value of the counter and resets it to |val|.
+    //
+    // Each shard is exchanged atomically, so no increments are lost, but increments which
+    // race with this call may be counted in either the returned value or the new one.
+    Type Exchange(Type val = 0) {
+        Type sum = shards_[0].value.exchange(val, kMemoryOrder);
+        for (uint32_t i = 1; i < kMetricShards; ++i) {
+            sum += shards_[i].value.exchange(0, kMemoryOrder);
+        }
+        return sum;
+    }
+
+    // Returns the current value of the counter.
+    Type Load() const {
+        Type sum = 0;
+        for (uint32_t i = 0; i < kMetricShards; ++i) {
+            sum += shards_[i].value.load(kMemoryOrder);
+        }
+        return sum;
+    }
 
 protected:
-    fbl::atomic<Type> counter_;
+    // Shards are padded out to a cache line each. Their start is not aligned, but consecutive
+    // values are a whole cache line apart, so no two of them share one.
+    struct Shard {
+        fbl::atomic<Type> value{0};
+        uint8_t padding[kMetricCacheLineSize - sizeof(fbl::atomic<Type>)];
+    };
+    Shard shards_[kMetricShards];
 };
 
 // Counter which represents a standalone cobalt metric. Provides API for converting
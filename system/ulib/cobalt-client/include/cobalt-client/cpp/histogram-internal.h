@@ -9,6 +9,7 @@
 
 #include <cobalt-client/cpp/counter-internal.h>
 #include <cobalt-client/cpp/types-internal.h>
+#include <fbl/array.h>
 #include <fbl/atomic.h>
 #include <fbl/function.h>
 #include <fbl/string.h>
@@ -41,21 +42,47 @@ public:
 
     // Increases the count of the |bucket| bucket by 1.
     void IncrementCount(uint32_t bucket, Count val = 1) {
-        ZX_DEBUG_ASSERT_MSG(bucket < buckets_.size(),
-                            "IncrementCount bucket(%u) out of range(%lu).", bucket,
-                            buckets_.size());
-        buckets_[bucket].Increment(val);
+        ZX_DEBUG_ASSERT_MSG(bucket < num_buckets_,
+                            "IncrementCount bucket(%u) out of range(%u).", bucket,
+                            num_buckets_);
+        Bucket(GetMetricShard(), bucket).fetch_add(val, BaseCounter::kMemoryOrder);
     }
 
     // Returns the count of the |bucket| bucket.
     Count GetCount(uint32_t bucket) const {
-        ZX_DEBUG_ASSERT_MSG(bucket < buckets_.size(), "GetCount bucket out of range.");
-        return buckets_[bucket].Load();
+        ZX_DEBUG_ASSERT_MSG(bucket < num_buckets_, "GetCount bucket out of range.");
+        Count sum = 0;
+        for (uint32_t shard = 0; shard < kMetricShards; ++shard) {
+            sum += Bucket(shard, bucket).load(BaseCounter::kMemoryOrder);
+        }
+        return sum;
+    }
+
+    // Returns the count of the |bucket| bucket, and resets it to 0.
+    Count ExchangeCount(uint32_t bucket) {
+        ZX_DEBUG_ASSERT_MSG(bucket < num_buckets_, "ExchangeCount bucket out of range.");
+        Count sum = 0;
+        for (uint32_t shard = 0; shard < kMetricShards; ++shard) {
+            sum += Bucket(shard, bucket).exchange(0, BaseCounter::kMemoryOrder);
+        }
+        return sum;
     }
 
 protected:
-    // Counter for the abs frequency of every histogram bucket.
-    fbl::Vector<BaseCounter> buckets_;
+    // Returns the count of |bucket| in |shard|.
+    fbl::atomic<Count>& Bucket(uint32_t shard, uint32_t bucket) const {
+        return buckets_[shard * shard_stride_ + bucket];
+    }
+
+    uint32_t num_buckets_;
+
+    // Distance between the start of consecutive shards. Each shard is followed by just
+    // enough padding that the last bucket of a shard and the first of the next one are a
+    // cache line apart, and so never share one.
+    uint32_t shard_stride_;
+
+    // Counter for the abs frequency of every histogram bucket, for each shard in turn.
+    fbl::Array<fbl::atomic<Count>> buckets_;
 };
 
 // This class provides a histogram which represents a full fledged cobalt metric. The histogram
@@ -0,0 +1,31 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <ddk/protocol/block.h>
+#include <zircon/compiler.h>
+#include <zircon/types.h>
+
+__BEGIN_CDECLS;
+
+// Submits the |txn_count| ops in |txn_list| to |proto|, with queue_batch() if
+// the device implements it and otherwise one at a time with queue(). As with
+// queue_batch(), the entries of |txn_list| may be overwritten by the callee.
+static inline void block_impl_queue_many(const block_impl_protocol_t* proto,
+                                         block_op_t** txn_list, size_t txn_count,
+                                         block_impl_queue_callback callback, void* cookie) {
+    if (txn_count == 0) {
+        return;
+    }
+    if (proto->ops->queue_batch != NULL) {
+        proto->ops->queue_batch(proto->ctx, txn_list, txn_count, callback, cookie);
+        return;
+    }
+    for (size_t i = 0; i < txn_count; i++) {
+        proto->ops->queue(proto->ctx, txn_list[i], callback, cookie);
+    }
+}
+
+__END_CDECLS;
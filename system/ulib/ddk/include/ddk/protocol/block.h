@@ -92,6 +92,8 @@ typedef struct block_impl_protocol_ops {
     void (*queue)(void* ctx, block_op_t* txn, block_impl_queue_callback callback, void* cookie);
     zx_status_t (*get_stats)(void* ctx, const void* cmd_buffer, size_t cmd_size,
                              void* out_reply_buffer, size_t reply_size, size_t* out_reply_actual);
+    void (*queue_batch)(void* ctx, block_op_t** txn_list, size_t txn_count,
+                        block_impl_queue_callback callback, void* cookie);
 } block_impl_protocol_ops_t;
 
 struct block_impl_protocol {
@@ -121,5 +123,16 @@ static inline zx_status_t block_impl_get_stats(const block_impl_protocol_t* prot
     return proto->ops->get_stats(proto->ctx, cmd_buffer, cmd_size, out_reply_buffer, reply_size,
                                  out_reply_actual);
 }
+// Submit several IO requests at once, as if by queue() in order. Each op is
+// completed through the completion_cb on its own, so a layer may split,
+// complete early or reorder ops between barriers as it would for queue().
+// The list is only borrowed for the duration of the call, and the callee
+// may overwrite its entries. Optional: devices without it are sent each op
+// through queue().
+static inline void block_impl_queue_batch(const block_impl_protocol_t* proto,
+                                          block_op_t** txn_list, size_t txn_count,
+                                          block_impl_queue_callback callback, void* cookie) {
+    proto->ops->queue_batch(proto->ctx, txn_list, txn_count, callback, cookie);
+}
 
 __END_CDECLS;
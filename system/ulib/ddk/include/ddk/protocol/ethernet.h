@@ -18,9 +18,10 @@ __BEGIN_CDECLS;
 // The ethermac interface supports both synchronous and asynchronous transmissions using the
 // proto->queue_tx() and ifc->complete_tx() methods.
 //
-// Receive operations are supported with the ifc->recv() interface.
-// TODO: implement netbuf-based receive operations by implementing proto->queue_rx() and
-// ifc->complete_rx()
+// Receive operations are supported with the ifc->recv() interface, which hands the driver's own
+// buffer to the generic ethernet driver to be copied. Devices advertising FEATURE_RX_DMA also
+// accept empty buffers through proto->queue_rx(), receive frames directly into them, and return
+// them through ifc->complete_rx().
 //
 // The FEATURE_WLAN flag indicates a device that supports wlan operations.
 //
@@ -28,21 +29,58 @@ __BEGIN_CDECLS;
 //
 // The FEATURE_DMA flag indicates that the device can copy the buffer data using DMA and will ensure
 // that physical addresses are provided in netbufs.
+//
+// The FEATURE_RX_DMA flag indicates that the device implements proto->queue_rx(). It requires
+// FEATURE_DMA.
+//
+// Devices with several tx/rx queues report their number in info->queue_count. The queue of a
+// transmission is selected with ETHMAC_TX_OPT_QUEUE(), and received frames are reported with the
+// queue the device steered them to in ETHMAC_RX_QUEUE(). How flows are spread over the queues is
+// configured with ETHMAC_SETPARAM_RSS.
+//
+// The FEATURE_TX_CSUM flag indicates that the device computes the TCP or UDP checksum of the
+// netbufs flagged with ETHMAC_NETBUF_CSUM, and FEATURE_TSO that it splits the TCP segments of
+// the netbufs flagged with ETHMAC_NETBUF_TSO into frames of netbuf->mss bytes of payload. TSO
+// implies TX_CSUM.
+//
+// The FEATURE_RX_CSUM flag indicates that the device verifies the checksums of received frames,
+// and reports the frames whose checksums are all correct with ETHMAC_RX_OPT_CSUM_OK.
 
 #define ETHMAC_FEATURE_WLAN     (1u)
 #define ETHMAC_FEATURE_SYNTH    (2u)
 #define ETHMAC_FEATURE_DMA      (4u)
+#define ETHMAC_FEATURE_RX_DMA   (8u)
+#define ETHMAC_FEATURE_TX_CSUM  (0x10u)
+#define ETHMAC_FEATURE_RX_CSUM  (0x20u)
+#define ETHMAC_FEATURE_TSO      (0x40u)
 
 #define ETHMAC_STATUS_ONLINE    (1u)
 
+#define ETHMAC_MAX_QUEUES       (8)
+
 typedef struct ethmac_info {
     uint32_t features;
     uint32_t mtu;
     uint8_t mac[ETH_MAC_SIZE];
     uint8_t reserved0[2];
-    uint32_t reserved1[4];
+    // Number of tx/rx queue pairs, up to ETHMAC_MAX_QUEUES. Zero is treated as one.
+    uint32_t queue_count;
+    uint32_t reserved1[3];
 } ethmac_info_t;
 
+// netbuf->flags bits, requesting the offloads of a transmission.
+//
+// NETBUF_CSUM: the checksum field at |csum_offset| from the start of the TCP or UDP header, found
+// at |csum_start|, holds the checksum of the pseudo-header and is to be replaced with the checksum
+// of the segment from |csum_start| to the end of the frame.
+//
+// NETBUF_TSO: the frame holds a single TCP segment, whose payload follows |hdr_len| bytes of
+// headers, to be sent as segments of |mss| bytes. The pseudo-header checksum in the TCP header
+// leaves out the length. Implies NETBUF_CSUM. NETBUF_IPV6 tells the IPv6 segments apart.
+#define ETHMAC_NETBUF_CSUM (1u)
+#define ETHMAC_NETBUF_TSO  (2u)
+#define ETHMAC_NETBUF_IPV6 (4u)
+
 typedef struct ethmac_netbuf {
     // Provided by the generic ethernet driver
     void* data;
@@ -50,6 +88,11 @@ typedef struct ethmac_netbuf {
     uint16_t len;
     uint16_t reserved;
     uint32_t flags;
+    // Offloads described by |flags|. Offsets are from the start of |data|.
+    uint16_t csum_start;
+    uint16_t csum_offset;
+    uint16_t hdr_len;
+    uint16_t mss;
 
     // Shared between the generic ethernet and ethmac drivers
     list_node_t node;
@@ -74,6 +117,15 @@ typedef struct ethmac_ifc_virt {
     // Upon a return of ZX_OK, the packet has been enqueued, but no information is returned as to
     // the completion state of the transmission itself.
     void (*complete_tx)(void* cookie, ethmac_netbuf_t* netbuf, zx_status_t status);
+
+    // complete_rx() is called to return ownership of a netbuf given to proto->queue_rx(). On
+    // ZX_OK, netbuf->len has been set to the length of the frame received into the buffer.
+    // Buffers still held by the driver are returned with ZX_ERR_CANCELED when it is stopped.
+    //
+    // |options| takes the ETHMAC_RX_OPT_* flags. proto->queue_rx() may be called from within
+    // complete_rx().
+    void (*complete_rx)(void* cookie, uint32_t options, ethmac_netbuf_t* netbuf,
+                        zx_status_t status);
 } ethmac_ifc_t;
 
 typedef struct eth_dev_metadata {
@@ -86,6 +138,23 @@ typedef struct eth_dev_metadata {
 // driver to batch tx to hardware if possible.
 #define ETHMAC_TX_OPT_MORE (1u)
 
+// Selects the queue, below info->queue_count, the packet is transmitted on.
+#define ETHMAC_TX_OPT_QUEUE(q) ((uint32_t)(q) << 16)
+#define ETHMAC_TX_QUEUE(options) (((options) >> 16) & 0xffu)
+
+// Passed in the |flags| of ifc->recv() or the |options| of ifc->complete_rx() to indicate that
+// more frames are delivered right after this one. Allows the generic ethernet driver to report
+// received frames to its clients in batches.
+#define ETHMAC_RX_OPT_MORE (1u)
+
+// Identifies the queue a frame was received on, in the same |flags| or |options|.
+#define ETHMAC_RX_OPT_QUEUE(q) ((uint32_t)(q) << 16)
+#define ETHMAC_RX_QUEUE(flags) (((flags) >> 16) & 0xffu)
+
+// Set, in the same |flags| or |options|, by devices with ETHMAC_FEATURE_RX_CSUM on the frames
+// whose TCP or UDP checksums were verified.
+#define ETHMAC_RX_OPT_CSUM_OK (2u)
+
 // SETPARAM_ values identify the parameter to set. Each call to set_param()
 // takes an int32_t |value| and void* |data| which have meaning specific to
 // the parameter being set.
@@ -105,6 +174,28 @@ typedef struct eth_dev_metadata {
 
 #define ETHMAC_SETPARAM_DUMP_REGS (4u)
 
+#define ETHMAC_RSS_HASH_IPV4     (1u)
+#define ETHMAC_RSS_HASH_TCP_IPV4 (2u)
+#define ETHMAC_RSS_HASH_IPV6     (4u)
+#define ETHMAC_RSS_HASH_TCP_IPV6 (8u)
+
+#define ETHMAC_RSS_KEY_SIZE   (40)
+#define ETHMAC_RSS_TABLE_SIZE (128)
+
+typedef struct ethmac_rss_config {
+    // ETHMAC_RSS_HASH_* fields the Toeplitz hash of a frame is computed over. Frames of other
+    // kinds, or with no bits set, are received on queue 0.
+    uint32_t hash_types;
+    uint8_t key[ETHMAC_RSS_KEY_SIZE];
+    // Queue of the frames whose hash, modulo the table size, is the index.
+    uint8_t table[ETHMAC_RSS_TABLE_SIZE];
+} ethmac_rss_config_t;
+
+// |value| is unused. |data| is an ethmac_rss_config_t. Caller retains ownership.
+// Devices which steer flows on their own, without a configurable hash, return
+// ZX_ERR_NOT_SUPPORTED.
+#define ETHMAC_SETPARAM_RSS (5u)
+
 // The ethernet midlayer will never call ethermac_protocol
 // methods from multiple threads simultaneously, but it
 // can call send() methods at the same time as non-send
@@ -152,6 +243,16 @@ typedef struct ethmac_protocol_ops {
     // The caller does *not* take ownership of the BTI handle and must never close
     // the handle.
     zx_handle_t (*get_bti)(void* ctx);
+
+    // Give the driver an empty buffer to receive a frame into, at netbuf->phys, of up to
+    // netbuf->len bytes. The buffer is physically contiguous. Return status indicates queue state:
+    //   ZX_OK: The driver owns the netbuf until it returns it through complete_rx().
+    //   Other: The buffer cannot be used, and ownership stays with the caller.
+    //
+    // Frames arriving while the driver has no buffer from queue_rx() are delivered through
+    // recv(). complete_rx() MUST NOT be called from within the queue_rx() implementation.
+    // This method is only valid on devices that advertise ETHMAC_FEATURE_RX_DMA.
+    zx_status_t (*queue_rx)(void* ctx, ethmac_netbuf_t* netbuf);
 } ethmac_protocol_ops_t;
 
 typedef struct ethmac_protocol {
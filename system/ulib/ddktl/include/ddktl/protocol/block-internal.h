@@ -23,6 +23,9 @@ DECLARE_HAS_MEMBER_FN_WITH_SIGNATURE(has_block_impl_protocol_get_stats, BlockImp
                                      zx_status_t (C::*)(const void* cmd_buffer, size_t cmd_size,
                                                         void* out_reply_buffer, size_t reply_size,
                                                         size_t* out_reply_actual));
+DECLARE_HAS_MEMBER_FN_WITH_SIGNATURE(has_block_impl_protocol_queue_batch, BlockImplQueueBatch,
+                                     void (C::*)(block_op_t** txn_list, size_t txn_count,
+                                                 block_impl_queue_callback callback, void* cookie));
 
 template <typename D>
 constexpr void CheckBlockImplProtocolSubclass() {
@@ -37,6 +40,10 @@ constexpr void CheckBlockImplProtocolSubclass() {
                   "BlockImplProtocol subclasses must implement "
                   "zx_status_t BlockImplGetStats(const void* cmd_buffer, size_t cmd_size, void* "
                   "out_reply_buffer, size_t reply_size, size_t* out_reply_actual");
+    static_assert(internal::has_block_impl_protocol_queue_batch<D>::value,
+                  "BlockImplProtocol subclasses must implement "
+                  "void BlockImplQueueBatch(block_op_t** txn_list, size_t txn_count, "
+                  "block_impl_queue_callback callback, void* cookie");
 }
 
 } // namespace internal
@@ -47,6 +47,9 @@
 //     zx_status_t BlockImplGetStats(const void* cmd_buffer, size_t cmd_size, void*
 //     out_reply_buffer, size_t reply_size, size_t* out_reply_actual);
 //
+//     void BlockImplQueueBatch(block_op_t** txn_list, size_t txn_count,
+//     block_impl_queue_callback callback, void* cookie);
+//
 //     ...
 // };
 
@@ -60,6 +63,7 @@ public:
         ops_.query = BlockImplQuery;
         ops_.queue = BlockImplQueue;
         ops_.get_stats = BlockImplGetStats;
+        ops_.queue_batch = BlockImplQueueBatch;
 
         // Can only inherit from one base_protocol implementation.
         ZX_ASSERT(ddk_proto_id_ == 0);
@@ -91,6 +95,16 @@ private:
         return static_cast<D*>(ctx)->BlockImplGetStats(cmd_buffer, cmd_size, out_reply_buffer,
                                                        reply_size, out_reply_actual);
     }
+    // Submit several IO requests at once, as if by queue() in order. Each op is
+    // completed through the completion_cb on its own, so a layer may split,
+    // complete early or reorder ops between barriers as it would for queue().
+    // The list is only borrowed for the duration of the call, and the callee
+    // may overwrite its entries. Optional: devices without it are sent each op
+    // through queue().
+    static void BlockImplQueueBatch(void* ctx, block_op_t** txn_list, size_t txn_count,
+                                    block_impl_queue_callback callback, void* cookie) {
+        static_cast<D*>(ctx)->BlockImplQueueBatch(txn_list, txn_count, callback, cookie);
+    }
 };
 
 class BlockImplProtocolProxy {
@@ -126,6 +140,16 @@ public:
         return ops_->get_stats(ctx_, cmd_buffer, cmd_size, out_reply_buffer, reply_size,
                                out_reply_actual);
     }
+    // Submit several IO requests at once, as if by queue() in order. Each op is
+    // completed through the completion_cb on its own, so a layer may split,
+    // complete early or reorder ops between barriers as it would for queue().
+    // The list is only borrowed for the duration of the call, and the callee
+    // may overwrite its entries. Optional: devices without it are sent each op
+    // through queue().
+    void QueueBatch(block_op_t** txn_list, size_t txn_count, block_impl_queue_callback callback,
+                    void* cookie) {
+        ops_->queue_batch(ctx_, txn_list, txn_count, callback, cookie);
+    }
 
 private:
     block_impl_protocol_ops_t* ops_;
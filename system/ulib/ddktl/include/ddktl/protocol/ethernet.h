@@ -166,6 +166,10 @@ public:
         ifc_->complete_tx(cookie_, netbuf, status);
     }
 
+    void CompleteRx(uint32_t options, ethmac_netbuf_t* netbuf, zx_status_t status) {
+        ifc_->complete_rx(cookie_, options, netbuf, status);
+    }
+
 private:
     ethmac_ifc_t* ifc_;
     void* cookie_;
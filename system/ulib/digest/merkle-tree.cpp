@@ -14,6 +14,11 @@
 #include <zircon/assert.h>
 #include <zircon/errors.h>
 
+#ifdef __Fuchsia__
+#include <threads.h>
+#include <zircon/syscalls.h>
+#endif
+
 namespace digest {
 
 // Size of a node in bytes.  Defined in tree.h.
@@ -94,6 +99,104 @@ size_t NextAligned(size_t length) {
     return fbl::round_up(NextLength(length), MerkleTree::kNodeSize);
 }
 
+////////
+// Helper functions for splitting the bottom level of the tree across threads.
+
+// Hashing the data nodes is nearly all of the work of creating or verifying a
+// tree. Levels of at least |kMinThreadedNodes| nodes are split into runs of
+// whole nodes and hashed on up to |kMaxThreads| threads.
+constexpr size_t kMinThreadedNodes = 128;
+constexpr size_t kMaxThreads = 8;
+
+// Hashes the data nodes [first, first + count) of the |data_len| bytes at
+// |data|, and writes their digests to |digests|.
+zx_status_t HashNodes(const uint8_t* data, size_t data_len, size_t first, size_t count,
+                      uint8_t* digests) {
+    zx_status_t rc;
+    Digest digest;
+    for (size_t i = first; i < first + count; ++i) {
+        size_t offset = i * MerkleTree::kNodeSize;
+        if ((rc = DigestInit(&digest, offset, data_len - offset)) != ZX_OK) {
+            return rc;
+        }
+        size_t chunk = DigestUpdate(&digest, data + offset, offset, data_len - offset);
+        DigestFinal(&digest, offset + chunk);
+        if ((rc = digest.CopyTo(digests + i * Digest::kLength, Digest::kLength)) != ZX_OK) {
+            return rc;
+        }
+    }
+    return ZX_OK;
+}
+
+// A run of nodes handed to one thread by |ForEachNodeRun|.
+template <typename Fn>
+struct NodeRun {
+    const Fn* fn;
+    size_t first;
+    size_t count;
+    zx_status_t rc;
+
+    static int Run(void* arg) {
+        NodeRun* run = static_cast<NodeRun*>(arg);
+        run->rc = (*run->fn)(run->first, run->count);
+        return 0;
+    }
+};
+
+// Calls |fn(first, count)| for runs of whole nodes which together cover
+// [0, nodes), on several threads if the level is large enough.  Returns the
+// first error, if any.
+template <typename Fn>
+zx_status_t ForEachNodeRun(size_t nodes, const Fn& fn) {
+    size_t num_threads = 1;
+#ifdef __Fuchsia__
+    if (nodes >= kMinThreadedNodes) {
+        num_threads = fbl::min(fbl::min<size_t>(zx_system_get_num_cpus(), kMaxThreads),
+                               nodes / (kMinThreadedNodes / 2));
+    }
+#endif
+    if (num_threads <= 1) {
+        return fn(0, nodes);
+    }
+
+    NodeRun<Fn> runs[kMaxThreads];
+    size_t per_thread = fbl::round_up(nodes, num_threads) / num_threads;
+    for (size_t i = 0; i < num_threads; ++i) {
+        runs[i].fn = &fn;
+        runs[i].first = fbl::min(i * per_thread, nodes);
+        runs[i].count = fbl::min(per_thread, nodes - runs[i].first);
+        runs[i].rc = ZX_OK;
+    }
+
+#ifdef __Fuchsia__
+    // The first run is done on the calling thread. Runs which fail to get a
+    // thread are done there, too.
+    thrd_t threads[kMaxThreads];
+    bool started[kMaxThreads] = {};
+    for (size_t i = 1; i < num_threads; ++i) {
+        started[i] = thrd_create_with_name(&threads[i], NodeRun<Fn>::Run, &runs[i],
+                                           "merkle-tree") == thrd_success;
+    }
+    for (size_t i = 0; i < num_threads; ++i) {
+        if (!started[i]) {
+            NodeRun<Fn>::Run(&runs[i]);
+        }
+    }
+    for (size_t i = 1; i < num_threads; ++i) {
+        if (started[i]) {
+            thrd_join(threads[i], nullptr);
+        }
+    }
+#endif
+
+    for (size_t i = 0; i < num_threads; ++i) {
+        if (runs[i].rc != ZX_OK) {
+            return runs[i].rc;
+        }
+    }
+    return ZX_OK;
+}
+
 } // namespace
 
 ////////
@@ -107,6 +210,39 @@ size_t MerkleTree::GetTreeLength(size_t data_len) {
 zx_status_t MerkleTree::Create(const void* data, size_t data_len, void* tree, size_t tree_len,
                                Digest* digest) {
     zx_status_t rc;
+    size_t nodes = fbl::round_up(data_len, kNodeSize) / kNodeSize;
+    if (nodes >= kMinThreadedNodes) {
+        // Hash the data nodes directly into the first level of the tree, then
+        // build the rest of it on top of that level as usual.
+        size_t level_len = NextAligned(data_len);
+        if (!data || !tree || !digest) {
+            return ZX_ERR_INVALID_ARGS;
+        }
+        if (tree_len < level_len) {
+            return ZX_ERR_BUFFER_TOO_SMALL;
+        }
+        const uint8_t* in = static_cast<const uint8_t*>(data);
+        uint8_t* out = static_cast<uint8_t*>(tree);
+        rc = ForEachNodeRun(nodes, [in, data_len, out](size_t first, size_t count) {
+            return HashNodes(in, data_len, first, count, out);
+        });
+        if (rc != ZX_OK) {
+            return rc;
+        }
+        size_t digests_len = nodes * Digest::kLength;
+        memset(out + digests_len, 0, level_len - digests_len);
+
+        MerkleTree mt;
+        mt.level_ = 1;
+        uint8_t* next = out + level_len;
+        if ((rc = mt.CreateInit(level_len, tree_len - level_len)) != ZX_OK ||
+            (rc = mt.CreateUpdate(out, digests_len, next)) != ZX_OK ||
+            (rc = mt.CreateFinalInternal(out, next, digest)) != ZX_OK) {
+            return rc;
+        }
+        return ZX_OK;
+    }
+
     MerkleTree mt;
     if ((rc = mt.CreateInit(data_len, tree_len)) != ZX_OK ||
         (rc = mt.CreateUpdate(data, data_len, tree)) != ZX_OK ||
@@ -250,8 +386,21 @@ zx_status_t MerkleTree::Verify(const void* data, size_t data_len, const void* tr
     size_t root_len = data_len;
     while (data_len > kNodeSize) {
         zx_status_t rc;
-        // Verify the data in this level.
-        if ((rc = VerifyLevel(data, data_len, tree, offset, length, level)) != ZX_OK) {
+        // Verify the data in this level, splitting a large range of data nodes
+        // across threads.
+        size_t first = offset / kNodeSize;
+        size_t end = fbl::round_up(offset + length, kNodeSize) / kNodeSize;
+        if (level == 0 && data && tree && offset + length <= data_len &&
+            end - first >= kMinThreadedNodes) {
+            rc = ForEachNodeRun(end - first, [=](size_t run, size_t count) {
+                size_t run_offset = (first + run) * kNodeSize;
+                size_t run_end = fbl::min((first + run + count) * kNodeSize, data_len);
+                return VerifyLevel(data, data_len, tree, run_offset, run_end - run_offset, 0);
+            });
+        } else {
+            rc = VerifyLevel(data, data_len, tree, offset, length, level);
+        }
+        if (rc != ZX_OK) {
             return rc;
         }
         // Ascend to the next level up.
@@ -13,7 +13,9 @@ MODULE_SRCS += \
     $(LOCAL_DIR)/merkle-tree.cpp
 
 MODULE_SO_NAME := digest
-MODULE_LIBS := system/ulib/c
+MODULE_LIBS := \
+    system/ulib/c \
+    system/ulib/zircon \
 
 MODULE_STATIC_LIBS := \
     third_party/ulib/uboringssl \
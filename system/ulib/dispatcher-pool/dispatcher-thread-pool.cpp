@@ -7,6 +7,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <fbl/algorithm.h>
 #include <dispatcher-pool/dispatcher-execution-domain.h>
 #include <dispatcher-pool/dispatcher-thread-pool.h>
 
@@ -104,8 +105,11 @@ zx_status_t ThreadPool::AddDomainToPool(fbl::RefPtr<ExecutionDomain> domain) {
     active_domains_.push_back(fbl::move(domain));
     ++active_domain_count_;
 
-    while ((active_thread_count_ < active_domain_count_) &&
-           (active_thread_count_ < zx_system_get_num_cpus())) {
+    // Reclaim any threads which retired since the last time the pool grew.
+    while (!retired_threads_.is_empty())
+        retired_threads_.pop_front()->Join();
+
+    while (active_thread_count_ < TargetThreadCount()) {
         auto thread = Thread::Create(fbl::WrapRefPtr(this), active_thread_count_);
         if (thread == nullptr) {
             LOG("Failed to create new thread\n");
@@ -129,6 +133,42 @@ void ThreadPool::RemoveDomainFromPool(ExecutionDomain* domain) {
     ZX_DEBUG_ASSERT(domain != nullptr);
     fbl::AutoLock pool_lock(&pool_lock_);
     active_domains_.erase(*domain);
+
+    ZX_DEBUG_ASSERT(active_domain_count_ > 0);
+    --active_domain_count_;
+
+    // If we now have more threads than we need, ask one of them to retire.
+    // Whichever thread picks up the request re-checks the counts before
+    // actually exiting.
+    if (!pool_shutting_down_ && (active_thread_count_ > TargetThreadCount())) {
+        zx_port_packet pkt;
+        memset(&pkt, 0, sizeof(pkt));
+        pkt.type = ZX_PKT_TYPE_USER;
+
+        __UNUSED zx_status_t res;
+        res = port_.queue(&pkt);
+        ZX_DEBUG_ASSERT(res == ZX_OK);
+    }
+}
+
+uint32_t ThreadPool::TargetThreadCount() const {
+    return fbl::min(active_domain_count_, zx_system_get_num_cpus());
+}
+
+bool ThreadPool::HandleQuitRequest(Thread* thread) {
+    fbl::AutoLock pool_lock(&pool_lock_);
+
+    // During shutdown every thread exits, and InternalShutdown joins it.
+    if (pool_shutting_down_)
+        return true;
+
+    // The pool may have grown again since this thread was asked to retire.
+    if (active_thread_count_ <= TargetThreadCount())
+        return false;
+
+    retired_threads_.push_front(active_threads_.erase(*thread));
+    --active_thread_count_;
+    return true;
 }
 
 zx_status_t ThreadPool::WaitOnPort(const zx::handle& handle,
@@ -228,15 +268,19 @@ void ThreadPool::InternalShutdown() {
         }
     }
 
-    // Synchronize with the threads as they exit.
+    // Synchronize with the threads as they exit, including any which retired
+    // on their own and have not been reclaimed yet.
     while (true) {
         fbl::unique_ptr<Thread> thread;
         {
             fbl::AutoLock lock(&pool_lock_);
-            if (active_threads_.is_empty())
+            if (!active_threads_.is_empty()) {
+                thread = active_threads_.pop_front();
+            } else if (!retired_threads_.is_empty()) {
+                thread = retired_threads_.pop_front();
+            } else {
                 break;
-
-            thread = active_threads_.pop_front();
+            }
         }
 
         thread->Join();
@@ -301,17 +345,20 @@ int ThreadPool::Thread::Main() {
     while (true) {
         zx_port_packet_t pkt;
 
-        // TODO(johngro) : consider automatically shutting down if we have more
-        // threads than clients.
-
         // Wait for there to be work to dispatch.  We should never encounter an
         // error, but if we do, shut down.
         res = pool_->port().wait(zx::time::infinite(), &pkt);
         ZX_DEBUG_ASSERT(res == ZX_OK);
 
-        // Is it time to exit?
-        if ((res != ZX_OK) || (pkt.type == ZX_PKT_TYPE_USER)) {
+        if (res != ZX_OK)
             break;
+
+        // Is it time to exit?  User packets are sent either when the pool is
+        // shutting down, or when it has more threads than domains to serve.
+        if (pkt.type == ZX_PKT_TYPE_USER) {
+            if (pool_->HandleQuitRequest(this))
+                break;
+            continue;
         }
 
         if ((pkt.type != ZX_PKT_TYPE_SIGNAL_ONE) &&
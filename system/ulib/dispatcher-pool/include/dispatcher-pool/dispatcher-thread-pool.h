@@ -75,6 +75,15 @@ private:
     zx_status_t Init();
     void InternalShutdown();
 
+    // The number of threads the pool should be running: one per active domain,
+    // but no more than one per CPU.
+    uint32_t TargetThreadCount() const __TA_REQUIRES(pool_lock_);
+
+    // Called by |thread| when it receives a quit request.  Returns true if the
+    // thread should exit.  A thread which exits outside of shutdown is moved
+    // to the retired list, to be joined the next time the pool grows.
+    bool HandleQuitRequest(Thread* thread);
+
     static fbl::Mutex active_pools_lock_;
     static fbl::WAVLTree<uint32_t, fbl::RefPtr<ThreadPool>> active_pools_
         __TA_GUARDED(active_pools_lock_);
@@ -94,6 +103,8 @@ private:
 
     fbl::DoublyLinkedList<fbl::unique_ptr<Thread>> active_threads_
         __TA_GUARDED(pool_lock_);
+    fbl::DoublyLinkedList<fbl::unique_ptr<Thread>> retired_threads_
+        __TA_GUARDED(pool_lock_);
 };
 
 }  // namespace dispatcher
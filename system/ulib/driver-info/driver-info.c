@@ -50,11 +50,59 @@ static zx_status_t find_note(const char* name, size_t nlen, uint32_t type,
     return ZX_ERR_NOT_FOUND;
 }
 
+// Looks for the note in the first |dsize| bytes of the file, already read
+// into |data|. Returns ZX_ERR_NEXT if the headers or a note segment are not
+// entirely within those bytes.
+static zx_status_t find_note_in_prefix(const char* name, size_t nlen, uint32_t type,
+                                       void* data, size_t dsize,
+                                       note_func_t func, void* cookie) {
+    elfphdr ph[64];
+    elfhdr eh;
+    if (dsize < sizeof(eh)) {
+        return ZX_ERR_NEXT;
+    }
+    memcpy(&eh, data, sizeof(eh));
+    if (memcmp(&eh, ELFMAG, 4) ||
+        (eh.e_ehsize != sizeof(elfhdr)) ||
+        (eh.e_phentsize != sizeof(elfphdr))) {
+        return ZX_ERR_NEXT;
+    }
+    size_t sz = sizeof(elfphdr) * eh.e_phnum;
+    if ((sz > sizeof(ph)) || (eh.e_phoff > dsize) || (sz > dsize - eh.e_phoff)) {
+        return ZX_ERR_NEXT;
+    }
+    memcpy(ph, data + eh.e_phoff, sz);
+    for (int i = 0; i < eh.e_phnum; i++) {
+        if (ph[i].p_type != PT_NOTE) {
+            continue;
+        }
+        if ((ph[i].p_offset > dsize) || (ph[i].p_filesz > dsize - ph[i].p_offset)) {
+            return ZX_ERR_NEXT;
+        }
+        int r = find_note(name, nlen, type, data + ph[i].p_offset, ph[i].p_filesz,
+                          func, cookie);
+        if (r == ZX_OK) {
+            return r;
+        }
+    }
+    return ZX_ERR_NOT_FOUND;
+}
+
 static zx_status_t for_each_note(void* obj, di_read_func_t diread,
                                  const char* name, uint32_t type,
                                  void* data, size_t dsize,
                                  note_func_t func, void* cookie) {
     size_t nlen = strlen(name) + 1;
+
+    // Drivers normally keep their headers and notes at the start of the
+    // file, so one read is usually enough to find the note.
+    if (diread(obj, data, dsize, 0) == ZX_OK) {
+        zx_status_t r = find_note_in_prefix(name, nlen, type, data, dsize, func, cookie);
+        if (r != ZX_ERR_NEXT) {
+            return r;
+        }
+    }
+
     elfphdr ph[64];
     elfhdr eh;
     if (diread(obj, &eh, sizeof(eh), 0) != ZX_OK) {
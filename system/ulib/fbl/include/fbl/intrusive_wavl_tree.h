@@ -197,6 +197,12 @@ public:
     // make_iterator : construct an iterator out of a pointer to an object
     iterator make_iterator(ValueType& obj) { return iterator(&obj); }
 
+    // root : an iterator to the node at the root of the tree, or end() if the
+    // tree is empty.  Along with iterator::left() and iterator::right(), this
+    // allows searches which use summaries kept by the Observer.
+    iterator       root()       { return iterator(root_ ? root_ : sentinel()); }
+    const_iterator root() const { return const_iterator(root_ ? root_ : sentinel()); }
+
     // is_empty : True if the tree has at least one element in it, false otherwise.
     bool is_empty() const { return root_ == nullptr; }
 
@@ -374,6 +380,16 @@ public:
         return internal_erase(&obj);
     }
 
+    // node_changed
+    //
+    // Tell the Observer that state it summarises for |obj|, which must be in
+    // this tree, has changed without the key changing, so that the summaries
+    // for |obj| and its ancestors are brought up to date.
+    void node_changed(ValueType& obj) {
+        ZX_DEBUG_ASSERT(NodeTraits::node_state(obj).InContainer());
+        RecordSubtreeChangesToRoot(&obj);
+    }
+
     // clear
     //
     // Clear out the tree, unlinking all of the elements in the process.  For
@@ -622,6 +638,23 @@ private:
             return IsValid() ? PtrTraits::Copy(node_) : nullptr;
         }
 
+        // The children and the parent of the node in the tree.  The iterator
+        // returned is not valid if there is no such node.
+        iterator_impl left() const {
+            ZX_DEBUG_ASSERT(IsValid());
+            return iterator_impl(NodeTraits::node_state(*node_).left_);
+        }
+
+        iterator_impl right() const {
+            ZX_DEBUG_ASSERT(IsValid());
+            return iterator_impl(NodeTraits::node_state(*node_).right_);
+        }
+
+        iterator_impl parent() const {
+            ZX_DEBUG_ASSERT(IsValid());
+            return iterator_impl(NodeTraits::node_state(*node_).parent_);
+        }
+
         typename IterTraits::RefType operator*()     const { ZX_DEBUG_ASSERT(node_); return *node_; }
         typename IterTraits::RawPtrType operator->() const { ZX_DEBUG_ASSERT(node_); return node_; }
 
@@ -709,6 +742,7 @@ private:
 
             ++count_;
             Observer::RecordInsert();
+            RecordSubtreeChangesToRoot(root_);
             return;
         }
 
@@ -784,12 +818,14 @@ private:
         ZX_DEBUG_ASSERT(internal::valid_sentinel_ptr(*owner) == false);
         ns.parent_ = parent;
         *owner = PtrTraits::Leak(ptr);
+        RawPtrType inserted = *owner;
 
         ++count_;
         Observer::RecordInsert();
 
         // Finally, perform post-insert balance operations.
-        BalancePostInsert(*owner);
+        BalancePostInsert(inserted);
+        RecordSubtreeChangesToRoot(inserted);
     }
 
     PtrType internal_erase(RawPtrType ptr) {
@@ -940,6 +976,11 @@ private:
             }
         }
 
+        // Every node which lost a descendant is still an ancestor of the
+        // removed node's old parent, or was summarised again when it was
+        // rotated away.
+        RecordSubtreeChangesToRoot(parent);
+
         // Give the reference to the node we just removed back to the caller.
         return removed;
     }
@@ -1005,6 +1046,7 @@ private:
         GetLinkPtrToNode(old_node) = PtrTraits::Leak(new_node);
         new_ns.parent_ = old_ns.parent_;
         old_ns.parent_ = nullptr;
+        RecordSubtreeChangesToRoot(new_raw);
         return PtrTraits::Reclaim(old_node);
     }
 
@@ -1358,6 +1400,24 @@ private:
         if (Y) {
             NodeTraits::node_state(*Y).parent_ = Z;
         }
+
+        // Z is now X's child, so must be summarised first.
+        if (Observer::kRecordsSubtreeChanges) {
+            Observer::RecordSubtreeChange(iterator(Z));
+            Observer::RecordSubtreeChange(iterator(X));
+        }
+    }
+
+    // Pass |node| and each of its ancestors to the Observer, if it keeps
+    // summaries of subtrees.
+    void RecordSubtreeChangesToRoot(RawPtrType node) {
+        if (!Observer::kRecordsSubtreeChanges)
+            return;
+
+        while (internal::valid_sentinel_ptr(node)) {
+            Observer::RecordSubtreeChange(iterator(node));
+            node = NodeTraits::node_state(*node).parent_;
+        }
     }
 
     // PostInsertFixupLR<LRTraits>
@@ -26,7 +26,19 @@ class WAVLTreeChecker;
 // phase of rebalancing are considered to be part of the cost of rotation and
 // are not tallied in the overall promote/demote accounting.
 //
+// Observers may also keep a summary of each subtree in its root node, so that
+// the tree can be searched by something other than its key (an "augmented"
+// tree).  Such an observer sets kRecordsSubtreeChanges, and is then passed
+// every node whose set of descendants or whose summarised state has changed,
+// once the change is complete.  Nodes are passed bottom up, so a node's
+// summary may always be recomputed from the node and its children (see
+// iterator::left() and iterator::right()).
+//
 struct DefaultWAVLTreeObserver {
+    static constexpr bool kRecordsSubtreeChanges = false;
+    template <typename Iter>
+    static void RecordSubtreeChange(Iter node) { }
+
     static void RecordInsert()               { }
     static void RecordInsertPromote()        { }
     static void RecordInsertRotation()       { }
@@ -470,6 +470,18 @@ public:
 
 protected:
     void* AllocateLocked() {
+        void* mem = AllocateFromSlabsLocked();
+        if ((mem == nullptr) && CanAddSlabLocked()) {
+            void* slab_mem = AllocateSlabMemory();
+            if (slab_mem != nullptr)
+                mem = AddSlabLocked(slab_mem);
+        }
+        return mem;
+    }
+
+    // Allocates from the free list or the currently active slab, without
+    // allocating a new slab.
+    void* AllocateFromSlabsLocked() {
         // If we can alloc from the free list, do so.
         if (!free_list_.is_empty()) {
             return free_list_.pop_front();
@@ -483,21 +495,30 @@ protected:
                 return mem;
         }
 
-        // If we are allowed to allocate new slabs, try to do so.
-        if (slab_count_ < max_slabs_) {
-            void* slab_mem = SlabMalloc::Allocate(slab_size_, slab_alignment_);
-            if (slab_mem != nullptr) {
-                Slab* slab = new (slab_mem) Slab(initial_slab_used_);
+        return nullptr;
+    }
 
-                slab_count_++;
-                slab_list_.push_front(slab);
+    // Returns whether the slab quota allows another slab to be added.
+    bool CanAddSlabLocked() const { return slab_count_ < max_slabs_; }
 
-                return slab->Allocate(alloc_size_, slab_storage_limit_);
-            }
-        }
+    // Allocates the memory for a new slab.  Does not require the lock to be
+    // held, so that the lock need not be held across a call into the heap.
+    void* AllocateSlabMemory() const {
+        return SlabMalloc::Allocate(slab_size_, slab_alignment_);
+    }
 
-        // Looks like we have run out of resources.
-        return nullptr;
+    static void FreeSlabMemory(void* slab_mem) { SlabMalloc::Free(slab_mem); }
+
+    // Makes |slab_mem| (from AllocateSlabMemory) the active slab and returns
+    // the first allocation from it.  The slab quota must allow a new slab.
+    void* AddSlabLocked(void* slab_mem) {
+        ZX_DEBUG_ASSERT(CanAddSlabLocked());
+        Slab* slab = new (slab_mem) Slab(initial_slab_used_);
+
+        slab_count_++;
+        slab_list_.push_front(slab);
+
+        return slab->Allocate(alloc_size_, slab_storage_limit_);
     }
 
     void ReturnToFreeListLocked(void* ptr) {
@@ -617,9 +638,38 @@ protected:
     friend class ::fbl::SlabAllocated<SATraits>;
 
     void* Allocate() {
-        AutoLock alloc_lock(&this->alloc_lock_);
-        void* ptr = AllocateLocked();
-        sa_obj_counter_.Inc(ptr);
+        {
+            AutoLock alloc_lock(&this->alloc_lock_);
+            void* ptr = this->AllocateFromSlabsLocked();
+            if ((ptr != nullptr) || !this->CanAddSlabLocked()) {
+                sa_obj_counter_.Inc(ptr);
+                return ptr;
+            }
+        }
+
+        // Grabbing a new slab from the heap can take a while, so do it
+        // without holding the lock, leaving other threads free to allocate
+        // and free objects from the existing slabs in the meantime.
+        void* slab_mem = this->AllocateSlabMemory();
+        if (slab_mem == nullptr)
+            return nullptr;
+
+        void* ptr;
+        {
+            AutoLock alloc_lock(&this->alloc_lock_);
+            // Another thread may have freed an object or added a slab while
+            // we were unlocked.  If so, use that and give our slab back,
+            // rather than stranding the unused part of the active slab.
+            ptr = this->AllocateFromSlabsLocked();
+            if (ptr == nullptr && this->CanAddSlabLocked()) {
+                ptr = this->AddSlabLocked(slab_mem);
+                slab_mem = nullptr;
+            }
+            sa_obj_counter_.Inc(ptr);
+        }
+
+        if (slab_mem != nullptr)
+            this->FreeSlabMemory(slab_mem);
         return ptr;
     }
 
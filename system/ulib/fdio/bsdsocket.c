@@ -5,6 +5,7 @@
 #include <assert.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <netdb.h>
 #include <poll.h>
 #include <stdarg.h>
@@ -432,6 +433,43 @@ int getpeername(int fd, struct sockaddr* restrict addr, socklen_t* restrict len)
     return STATUS(status);
 }
 
+__EXPORT
+int sendmmsg(int fd, struct mmsghdr* msgvec, unsigned int vlen, unsigned int flags) {
+    fdio_t* io = fd_to_io(fd);
+    if (io == NULL) {
+        return ERRNO(EBADF);
+    }
+    if (!(io->ioflag & IOFLAG_SOCKET)) {
+        fdio_release(io);
+        return ERRNO(ENOTSOCK);
+    }
+    if (vlen > IOV_MAX) {
+        vlen = IOV_MAX;
+    }
+    ssize_t r = fdio_socket_sendmmsg(io, msgvec, vlen, flags);
+    fdio_release(io);
+    return r < 0 ? STATUS(r) : (int)r;
+}
+
+__EXPORT
+int recvmmsg(int fd, struct mmsghdr* msgvec, unsigned int vlen, unsigned int flags,
+             struct timespec* timeout) {
+    fdio_t* io = fd_to_io(fd);
+    if (io == NULL) {
+        return ERRNO(EBADF);
+    }
+    if (!(io->ioflag & IOFLAG_SOCKET)) {
+        fdio_release(io);
+        return ERRNO(ENOTSOCK);
+    }
+    if (vlen > IOV_MAX) {
+        vlen = IOV_MAX;
+    }
+    ssize_t r = fdio_socket_recvmmsg(io, msgvec, vlen, flags, timeout);
+    fdio_release(io);
+    return r < 0 ? STATUS(r) : (int)r;
+}
+
 __EXPORT
 int getsockopt(int fd, int level, int optname, void* restrict optval,
                socklen_t* restrict optlen) {
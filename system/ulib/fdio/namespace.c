@@ -266,9 +266,12 @@ zx_status_t fdio_ns_connect(fdio_ns_t* ns, const char* path,
         goto fail1;
     }
 
-    r = fdio_open_at(vn->remote, path, flags, h);
+    // Like mxdir_open, don't hold the ns lock across the remote open:
+    // a remote is never replaced once bound, so using it unlocked is safe,
+    // and concurrent opens from other threads don't queue behind this one.
+    zx_handle_t remote = vn->remote;
     mtx_unlock(&ns->lock);
-    return r;
+    return fdio_open_at(remote, path, flags, h);
 
 fail1:
     mtx_unlock(&ns->lock);
@@ -18,11 +18,22 @@
 typedef struct fdio_zxio_remote {
     fdio_t io;
     zxio_remote_t remote;
+
+    // The VMO backing the remote file, if the server provides one. Large
+    // reads are served from it with zx_vmo_read rather than with a series of
+    // chunked FileRead messages. Dropped on write, and fetched again by the
+    // next large read.
+    mtx_t vmo_lock;
+    zx_handle_t vmo;
+    bool vmo_unavailable;
 } fdio_zxio_remote_t;
 
 // Create an |fdio_t| for a remote file backed by zxio.
 fdio_t* fdio_zxio_create_remote(zx_handle_t control, zx_handle_t event);
 
+// Releases the cached file VMO of |rio|, if any.
+void fdio_zxio_remote_drop_vmo(fdio_zxio_remote_t* rio);
+
 // open operation directly on remoteio handle
 zx_status_t zxrio_open_handle(zx_handle_t h, const char* path, uint32_t flags,
                               uint32_t mode, fdio_t** out);
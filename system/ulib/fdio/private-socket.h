@@ -41,4 +41,15 @@ struct zxsio {
 // Returns |NULL| if no |zxs_socket_t| was found.
 fdio_t* fd_to_socket(int fd, const zxs_socket_t** out_socket);
 
+// Implement sendmmsg() and recvmmsg() for the socket |io|. Datagram sockets
+// move up to ZX_SOCKET_MAX_IOVECS messages per socket transaction; other
+// sockets fall back to a message at a time.
+//
+// Both return the number of messages transferred, or an error if there were
+// none. recvmmsg() returns as soon as it has received messages and the socket
+// runs dry, as if MSG_WAITFORONE were always set.
+ssize_t fdio_socket_sendmmsg(fdio_t* io, struct mmsghdr* msgvec, unsigned int vlen, int flags);
+ssize_t fdio_socket_recvmmsg(fdio_t* io, struct mmsghdr* msgvec, unsigned int vlen, int flags,
+                             const struct timespec* timeout);
+
 __END_CDECLS
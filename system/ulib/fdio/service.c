@@ -102,6 +102,7 @@ zx_status_t fdio_get_service_handle(int fd, zx_handle_t* out) {
             r = ZX_OK;
         } else if (io->ops == &fdio_zxio_remote_ops) {
             fdio_zxio_remote_t* rio = (fdio_zxio_remote_t*) io;
+            fdio_zxio_remote_drop_vmo(rio);
             r = zxio_release(&rio->remote.io, out);
         } else {
             r = ZX_ERR_NOT_SUPPORTED;
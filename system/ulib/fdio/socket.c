@@ -60,6 +60,44 @@ static ssize_t zxsio_read_stream(fdio_t* io, void* data, size_t len) {
     }
 }
 
+// Like zxsio_read_stream(), but fills all of |vectors| with a single zx_socket_readv().
+static ssize_t zxsio_readv_stream(fdio_t* io, const zx_iovec_t* vectors, size_t count,
+                                  size_t len) {
+    zxsio_t* sio = (zxsio_t*)io;
+    int nonblock = sio->io.ioflag & IOFLAG_NONBLOCK;
+
+    if (len == 0) {
+        return 0;
+    }
+    for (;;) {
+        ssize_t r;
+        size_t bytes_read;
+        if ((r = zx_socket_readv(sio->s.socket, 0, vectors, count, &bytes_read)) == ZX_OK) {
+            return (ssize_t)bytes_read;
+        }
+        if (r == ZX_ERR_PEER_CLOSED || r == ZX_ERR_BAD_STATE) {
+            return 0;
+        } else if (r == ZX_ERR_SHOULD_WAIT && !nonblock) {
+            zx_signals_t pending;
+            r = zx_object_wait_one(sio->s.socket,
+                                   ZX_SOCKET_READABLE | ZX_SOCKET_PEER_CLOSED | ZX_SOCKET_PEER_WRITE_DISABLED,
+                                   ZX_TIME_INFINITE, &pending);
+            if (r < 0) {
+                return r;
+            }
+            if (pending & ZX_SOCKET_READABLE) {
+                continue;
+            }
+            if (pending & (ZX_SOCKET_PEER_CLOSED | ZX_SOCKET_PEER_WRITE_DISABLED)) {
+                return 0;
+            }
+            // impossible
+            return ZX_ERR_INTERNAL;
+        }
+        return r;
+    }
+}
+
 static ssize_t zxsio_recvfrom(fdio_t* io, void* data, size_t len, int flags,
                               struct sockaddr* restrict addr,
                               socklen_t* restrict addrlen) {
@@ -115,6 +153,38 @@ static ssize_t zxsio_write_stream(fdio_t* io, const void* data, size_t len) {
     }
 }
 
+// Like zxsio_write_stream(), but writes all of |vectors| with a single zx_socket_writev().
+static ssize_t zxsio_writev_stream(fdio_t* io, const zx_iovec_t* vectors, size_t count) {
+    zxsio_t* sio = (zxsio_t*)io;
+    int nonblock = sio->io.ioflag & IOFLAG_NONBLOCK;
+
+    for (;;) {
+        ssize_t r;
+        size_t len;
+        if ((r = zx_socket_writev(sio->s.socket, 0, vectors, count, &len)) == ZX_OK) {
+            return (ssize_t)len;
+        }
+        if (r == ZX_ERR_SHOULD_WAIT && !nonblock) {
+            zx_signals_t pending;
+            r = zx_object_wait_one(sio->s.socket,
+                                   ZX_SOCKET_WRITABLE | ZX_SOCKET_WRITE_DISABLED | ZX_SOCKET_PEER_CLOSED,
+                                   ZX_TIME_INFINITE, &pending);
+            if (r < 0) {
+                return r;
+            }
+            if (pending & (ZX_SOCKET_WRITE_DISABLED | ZX_SOCKET_PEER_CLOSED)) {
+                return ZX_ERR_PEER_CLOSED;
+            }
+            if (pending & ZX_SOCKET_WRITABLE) {
+                continue;
+            }
+            // impossible
+            return ZX_ERR_INTERNAL;
+        }
+        return r;
+    }
+}
+
 static ssize_t zxsio_sendto(fdio_t* io, const void* data, size_t len, int flags, const struct sockaddr* addr, socklen_t addrlen) {
     struct iovec iov;
     iov.iov_base = (void*)data;
@@ -144,13 +214,21 @@ static ssize_t zxsio_recvmsg_stream(fdio_t* io, struct msghdr* msg, int flags) {
     // (this is a consistent behavior with other OS implementations for TCP protocol)
     ssize_t total = 0;
     ssize_t n = 0;
-    for (int i = 0; i < msg->msg_iovlen; i++) {
-        struct iovec* iov = &msg->msg_iov[i];
-        n = zxsio_read_stream(io, iov->iov_base, iov->iov_len);
+    for (int i = 0; i < msg->msg_iovlen;) {
+        zx_iovec_t vectors[ZX_SOCKET_MAX_IOVECS];
+        size_t count = 0;
+        size_t len = 0;
+        for (; count < ZX_SOCKET_MAX_IOVECS && i < msg->msg_iovlen; count++, i++) {
+            struct iovec* iov = &msg->msg_iov[i];
+            vectors[count].buffer = iov->iov_base;
+            vectors[count].capacity = iov->iov_len;
+            len += iov->iov_len;
+        }
+        n = zxsio_readv_stream(io, vectors, count, len);
         if (n > 0) {
             total += n;
         }
-        if ((size_t)n != iov->iov_len) {
+        if ((size_t)n != len) {
             break;
         }
     }
@@ -174,16 +252,24 @@ static ssize_t zxsio_sendmsg_stream(fdio_t* io, const struct msghdr* msg, int fl
     }
     ssize_t total = 0;
     ssize_t n = 0;
-    for (int i = 0; i < msg->msg_iovlen; i++) {
-        struct iovec* iov = &msg->msg_iov[i];
-        if (iov->iov_len <= 0) {
-            return ZX_ERR_INVALID_ARGS;
+    for (int i = 0; i < msg->msg_iovlen;) {
+        zx_iovec_t vectors[ZX_SOCKET_MAX_IOVECS];
+        size_t count = 0;
+        size_t len = 0;
+        for (; count < ZX_SOCKET_MAX_IOVECS && i < msg->msg_iovlen; count++, i++) {
+            struct iovec* iov = &msg->msg_iov[i];
+            if (iov->iov_len <= 0) {
+                return total > 0 ? total : ZX_ERR_INVALID_ARGS;
+            }
+            vectors[count].buffer = iov->iov_base;
+            vectors[count].capacity = iov->iov_len;
+            len += iov->iov_len;
         }
-        n = zxsio_write_stream(io, iov->iov_base, iov->iov_len);
+        n = zxsio_writev_stream(io, vectors, count);
         if (n > 0) {
             total += n;
         }
-        if ((size_t)n != iov->iov_len) {
+        if ((size_t)n != len) {
             break;
         }
     }
@@ -362,41 +448,16 @@ static ssize_t zxsio_write_dgram(fdio_t* io, const void* data, size_t len) {
     return zxsio_sendmsg_dgram(io, &msg, 0);
 }
 
-static ssize_t zxsio_recvmsg_dgram(fdio_t* io, struct msghdr* msg, int flags) {
-    if (flags != 0) {
-        // TODO: support MSG_OOB
-        return ZX_ERR_NOT_SUPPORTED;
-    }
-    // Read 1 extra byte to detect if the buffer is too small to fit the whole
-    // packet, so we can set MSG_TRUNC flag if necessary.
-    size_t mlen = FDIO_SOCKET_MSG_HEADER_SIZE + 1;
-    for (int i = 0; i < msg->msg_iovlen; i++) {
-        struct iovec* iov = &msg->msg_iov[i];
-        if (iov->iov_len <= 0) {
-            return ZX_ERR_INVALID_ARGS;
-        }
-        mlen += iov->iov_len;
-    }
-
-    // TODO: avoid malloc
-    fdio_socket_msg_t* m = malloc(mlen);
-    ssize_t n = zxsio_rx_dgram(io, m, mlen);
-    if (n < 0) {
-        free(m);
-        return n;
-    }
-    if ((size_t)n < FDIO_SOCKET_MSG_HEADER_SIZE) {
-        free(m);
-        return ZX_ERR_INTERNAL;
-    }
-    n -= FDIO_SOCKET_MSG_HEADER_SIZE;
+// Copies the address, flags and payload of the datagram |m|, which carries |n|
+// bytes of payload, out to |msg|. Returns the number of bytes delivered.
+static ssize_t zxsio_scatter_dgram(struct msghdr* msg, const fdio_socket_msg_t* m, ssize_t n) {
     if (msg->msg_name != NULL) {
         int bytes_to_copy = (msg->msg_namelen < m->addrlen) ? msg->msg_namelen : m->addrlen;
         memcpy(msg->msg_name, &m->addr, bytes_to_copy);
     }
     msg->msg_namelen = m->addrlen;
     msg->msg_flags = m->flags;
-    char* data = m->data;
+    const char* data = m->data;
     size_t resid = n;
     for (int i = 0; i < msg->msg_iovlen; i++) {
         struct iovec* iov = &msg->msg_iov[i];
@@ -415,16 +476,53 @@ static ssize_t zxsio_recvmsg_dgram(fdio_t* io, struct msghdr* msg, int flags) {
         msg->msg_flags |= MSG_TRUNC;
         n -= resid;
     }
-
-    free(m);
     return n;
 }
 
-static ssize_t zxsio_sendmsg_dgram(fdio_t* io, const struct msghdr* msg, int flags) {
+// Returns the size of the buffer needed to receive a datagram into |msg|,
+// including 1 extra byte to detect if the buffer is too small to fit the whole
+// packet, so we can set MSG_TRUNC flag if necessary.
+static ssize_t zxsio_recv_dgram_len(const struct msghdr* msg) {
+    size_t mlen = FDIO_SOCKET_MSG_HEADER_SIZE + 1;
+    for (int i = 0; i < msg->msg_iovlen; i++) {
+        struct iovec* iov = &msg->msg_iov[i];
+        if (iov->iov_len <= 0) {
+            return ZX_ERR_INVALID_ARGS;
+        }
+        mlen += iov->iov_len;
+    }
+    return mlen;
+}
+
+static ssize_t zxsio_recvmsg_dgram(fdio_t* io, struct msghdr* msg, int flags) {
     if (flags != 0) {
-        // TODO: MSG_OOB
+        // TODO: support MSG_OOB
         return ZX_ERR_NOT_SUPPORTED;
     }
+    ssize_t mlen = zxsio_recv_dgram_len(msg);
+    if (mlen < 0) {
+        return mlen;
+    }
+
+    // TODO: avoid malloc
+    fdio_socket_msg_t* m = malloc(mlen);
+    ssize_t n = zxsio_rx_dgram(io, m, mlen);
+    if (n < 0) {
+        free(m);
+        return n;
+    }
+    if ((size_t)n < FDIO_SOCKET_MSG_HEADER_SIZE) {
+        free(m);
+        return ZX_ERR_INTERNAL;
+    }
+    n = zxsio_scatter_dgram(msg, m, n - FDIO_SOCKET_MSG_HEADER_SIZE);
+    free(m);
+    return n;
+}
+
+// Returns the payload length of the datagram described by |msg|, checking that
+// it may be sent on |io|.
+static ssize_t zxsio_send_dgram_len(fdio_t* io, const struct msghdr* msg) {
     // TODO: support flags and control messages
     if (io->ioflag & IOFLAG_SOCKET_CONNECTED) {
         // if connected, can't specify address
@@ -440,10 +538,11 @@ static ssize_t zxsio_sendmsg_dgram(fdio_t* io, const struct msghdr* msg, int fla
         }
         n += iov->iov_len;
     }
-    size_t mlen = n + FDIO_SOCKET_MSG_HEADER_SIZE;
+    return n;
+}
 
-    // TODO: avoid malloc m
-    fdio_socket_msg_t* m = malloc(mlen);
+// Gathers the address and payload of |msg| into the wire format datagram |m|.
+static void zxsio_gather_dgram(const struct msghdr* msg, int flags, fdio_socket_msg_t* m) {
     if (msg->msg_name != NULL) {
         memcpy(&m->addr, msg->msg_name, msg->msg_namelen);
     }
@@ -455,11 +554,243 @@ static ssize_t zxsio_sendmsg_dgram(fdio_t* io, const struct msghdr* msg, int fla
         memcpy(data, iov->iov_base, iov->iov_len);
         data += iov->iov_len;
     }
+}
+
+static ssize_t zxsio_sendmsg_dgram(fdio_t* io, const struct msghdr* msg, int flags) {
+    if (flags != 0) {
+        // TODO: MSG_OOB
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+    ssize_t n = zxsio_send_dgram_len(io, msg);
+    if (n < 0) {
+        return n;
+    }
+    size_t mlen = n + FDIO_SOCKET_MSG_HEADER_SIZE;
+
+    // TODO: avoid malloc m
+    fdio_socket_msg_t* m = malloc(mlen);
+    zxsio_gather_dgram(msg, flags, m);
     ssize_t r = zxsio_tx_dgram(io, m, mlen);
     free(m);
     return r == ZX_OK ? n : r;
 }
 
+// Datagrams are staged for a batch at this alignment, so that each one starts
+// with a properly aligned header.
+#define ZXSIO_DGRAM_ALIGN(n) (((n) + 7) & ~(size_t)7)
+
+// Writes each of |vectors| as one datagram with as few zx_socket_writev() calls
+// as possible. Returns the number of datagrams written, or an error if none
+// were.
+static ssize_t zxsio_writev_dgram(fdio_t* io, const zx_iovec_t* vectors, size_t count) {
+    zxsio_t* sio = (zxsio_t*)io;
+    int nonblock = sio->io.ioflag & IOFLAG_NONBLOCK;
+
+    size_t done = 0;
+    while (done < count) {
+        zx_status_t r;
+        size_t actual;
+        if ((r = zx_socket_writev(sio->s.socket, ZX_SOCKET_DATAGRAM_BATCH, vectors + done,
+                                  count - done, &actual)) == ZX_OK) {
+            done += actual;
+            continue;
+        }
+        if (r == ZX_ERR_SHOULD_WAIT && !nonblock) {
+            zx_signals_t pending;
+            r = zx_object_wait_one(sio->s.socket,
+                                   ZX_SOCKET_WRITABLE | ZX_SOCKET_WRITE_DISABLED | ZX_SOCKET_PEER_CLOSED,
+                                   ZX_TIME_INFINITE, &pending);
+            if (r == ZX_OK) {
+                if (pending & (ZX_SOCKET_WRITE_DISABLED | ZX_SOCKET_PEER_CLOSED)) {
+                    r = ZX_ERR_PEER_CLOSED;
+                } else if (pending & ZX_SOCKET_WRITABLE) {
+                    continue;
+                } else {
+                    // impossible
+                    r = ZX_ERR_INTERNAL;
+                }
+            }
+        }
+        return (done > 0) ? (ssize_t)done : r;
+    }
+    return done;
+}
+
+static ssize_t zxsio_sendmmsg_dgram(fdio_t* io, struct mmsghdr* msgvec, unsigned int vlen,
+                                    int flags) {
+    if (flags != 0) {
+        // TODO: MSG_OOB
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
+    unsigned int sent = 0;
+    while (sent < vlen) {
+        size_t count = vlen - sent;
+        if (count > ZX_SOCKET_MAX_IOVECS) {
+            count = ZX_SOCKET_MAX_IOVECS;
+        }
+        ssize_t n[ZX_SOCKET_MAX_IOVECS];
+        size_t total = 0;
+        for (size_t i = 0; i < count; i++) {
+            n[i] = zxsio_send_dgram_len(io, &msgvec[sent + i].msg_hdr);
+            if (n[i] < 0) {
+                if (sent + i > 0) {
+                    // Report the bad message on the next call.
+                    count = i;
+                    break;
+                }
+                return n[i];
+            }
+            total += ZXSIO_DGRAM_ALIGN(n[i] + FDIO_SOCKET_MSG_HEADER_SIZE);
+        }
+        if (count == 0) {
+            break;
+        }
+
+        char* buf = malloc(total);
+        if (buf == NULL) {
+            return (sent > 0) ? (ssize_t)sent : ZX_ERR_NO_MEMORY;
+        }
+        zx_iovec_t vectors[ZX_SOCKET_MAX_IOVECS];
+        char* next = buf;
+        for (size_t i = 0; i < count; i++) {
+            zxsio_gather_dgram(&msgvec[sent + i].msg_hdr, flags, (fdio_socket_msg_t*)next);
+            vectors[i].buffer = next;
+            vectors[i].capacity = n[i] + FDIO_SOCKET_MSG_HEADER_SIZE;
+            next += ZXSIO_DGRAM_ALIGN(vectors[i].capacity);
+        }
+        ssize_t r = zxsio_writev_dgram(io, vectors, count);
+        free(buf);
+        if (r < 0) {
+            return (sent > 0) ? (ssize_t)sent : r;
+        }
+        for (ssize_t i = 0; i < r; i++) {
+            msgvec[sent + i].msg_len = n[i];
+        }
+        sent += r;
+        if ((size_t)r < count) {
+            break;
+        }
+    }
+    return sent;
+}
+
+// Reads up to |count| datagrams into |vectors| with one zx_socket_readv(),
+// waiting until |deadline| for the first one unless |nonblock|. Returns the number of
+// datagrams read, 0 if the peer is gone, or an error.
+static ssize_t zxsio_readv_dgram(fdio_t* io, const zx_iovec_t* vectors, size_t count,
+                                 bool nonblock, zx_time_t deadline) {
+    zxsio_t* sio = (zxsio_t*)io;
+
+    for (;;) {
+        zx_status_t r;
+        size_t actual;
+        if ((r = zx_socket_readv(sio->s.socket, ZX_SOCKET_DATAGRAM_BATCH, vectors, count,
+                                 &actual)) == ZX_OK) {
+            return (ssize_t)actual;
+        }
+        if (r == ZX_ERR_PEER_CLOSED || r == ZX_ERR_BAD_STATE) {
+            return 0;
+        } else if (r == ZX_ERR_SHOULD_WAIT && !nonblock) {
+            zx_signals_t pending;
+            r = zx_object_wait_one(sio->s.socket,
+                                   ZX_SOCKET_READABLE | ZX_SOCKET_PEER_CLOSED | ZX_SOCKET_PEER_WRITE_DISABLED,
+                                   deadline, &pending);
+            if (r == ZX_ERR_TIMED_OUT) {
+                return ZX_ERR_SHOULD_WAIT;
+            }
+            if (r < 0) {
+                return r;
+            }
+            if (pending & ZX_SOCKET_READABLE) {
+                continue;
+            }
+            if (pending & (ZX_SOCKET_PEER_CLOSED | ZX_SOCKET_PEER_WRITE_DISABLED)) {
+                return 0;
+            }
+            // impossible
+            return ZX_ERR_INTERNAL;
+        }
+        return r;
+    }
+}
+
+static ssize_t zxsio_recvmmsg_dgram(fdio_t* io, struct mmsghdr* msgvec, unsigned int vlen,
+                                    int flags, const struct timespec* timeout) {
+    if (flags & ~(MSG_WAITFORONE | MSG_DONTWAIT)) {
+        // TODO: support MSG_OOB
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+    bool nonblock = (io->ioflag & IOFLAG_NONBLOCK) || (flags & MSG_DONTWAIT);
+    zx_time_t deadline = ZX_TIME_INFINITE;
+    if (timeout != NULL) {
+        deadline = zx_deadline_after(ZX_SEC(timeout->tv_sec) + timeout->tv_nsec);
+    }
+
+    unsigned int received = 0;
+    while (received < vlen) {
+        size_t count = vlen - received;
+        if (count > ZX_SOCKET_MAX_IOVECS) {
+            count = ZX_SOCKET_MAX_IOVECS;
+        }
+        ssize_t mlen[ZX_SOCKET_MAX_IOVECS];
+        size_t total = 0;
+        for (size_t i = 0; i < count; i++) {
+            mlen[i] = zxsio_recv_dgram_len(&msgvec[received + i].msg_hdr);
+            if (mlen[i] < 0) {
+                if (received + i > 0) {
+                    count = i;
+                    break;
+                }
+                return mlen[i];
+            }
+            mlen[i] += sizeof(zx_socket_datagram_header_t);
+            total += ZXSIO_DGRAM_ALIGN(mlen[i]);
+        }
+        if (count == 0) {
+            break;
+        }
+
+        char* buf = malloc(total);
+        if (buf == NULL) {
+            return (received > 0) ? (ssize_t)received : ZX_ERR_NO_MEMORY;
+        }
+        zx_iovec_t vectors[ZX_SOCKET_MAX_IOVECS];
+        char* next = buf;
+        for (size_t i = 0; i < count; i++) {
+            vectors[i].buffer = next;
+            vectors[i].capacity = mlen[i];
+            next += ZXSIO_DGRAM_ALIGN(mlen[i]);
+        }
+        ssize_t r = zxsio_readv_dgram(io, vectors, count, nonblock, deadline);
+        if (r < 0) {
+            free(buf);
+            return (received > 0) ? (ssize_t)received : r;
+        }
+        for (ssize_t i = 0; i < r; i++) {
+            zx_socket_datagram_header_t* header = vectors[i].buffer;
+            size_t copied = vectors[i].capacity - sizeof(*header);
+            size_t n = (header->length < copied) ? header->length : copied;
+            if (n < FDIO_SOCKET_MSG_HEADER_SIZE) {
+                free(buf);
+                return ZX_ERR_INTERNAL;
+            }
+            struct msghdr* msg = &msgvec[received + i].msg_hdr;
+            msgvec[received + i].msg_len =
+                zxsio_scatter_dgram(msg, (fdio_socket_msg_t*)(header + 1),
+                                    n - FDIO_SOCKET_MSG_HEADER_SIZE);
+        }
+        free(buf);
+        received += r;
+        if (r == 0 || (size_t)r < count) {
+            break;
+        }
+        // Hand back what has arrived rather than block with datagrams in hand.
+        nonblock = true;
+    }
+    return received;
+}
+
 static void zxsio_wait_begin_dgram(fdio_t* io, uint32_t events, zx_handle_t* handle, zx_signals_t* _signals) {
     zxsio_t* sio = (void*)io;
     *handle = sio->s.socket;
@@ -663,6 +994,38 @@ fdio_t* fdio_socket_create_datagram(zx_handle_t s, int flags) {
     return fdio_socket_create(s, flags, &fdio_socket_dgram_ops);
 }
 
+ssize_t fdio_socket_sendmmsg(fdio_t* io, struct mmsghdr* msgvec, unsigned int vlen, int flags) {
+    if (io->ops == &fdio_socket_dgram_ops) {
+        return zxsio_sendmmsg_dgram(io, msgvec, vlen, flags);
+    }
+    unsigned int sent = 0;
+    for (; sent < vlen; sent++) {
+        ssize_t r = io->ops->sendmsg(io, &msgvec[sent].msg_hdr, flags);
+        if (r < 0) {
+            return (sent > 0) ? (ssize_t)sent : r;
+        }
+        msgvec[sent].msg_len = r;
+    }
+    return sent;
+}
+
+ssize_t fdio_socket_recvmmsg(fdio_t* io, struct mmsghdr* msgvec, unsigned int vlen, int flags,
+                             const struct timespec* timeout) {
+    if (io->ops == &fdio_socket_dgram_ops) {
+        return zxsio_recvmmsg_dgram(io, msgvec, vlen, flags, timeout);
+    }
+    // Stream sockets have no message boundaries to batch on.
+    if (vlen == 0) {
+        return 0;
+    }
+    ssize_t r = io->ops->recvmsg(io, &msgvec[0].msg_hdr, flags & ~MSG_WAITFORONE);
+    if (r < 0) {
+        return r;
+    }
+    msgvec[0].msg_len = r;
+    return 1;
+}
+
 fdio_t* fd_to_socket(int fd, const zxs_socket_t** out_socket) {
     fdio_t* io = fd_to_io(fd);
     if (io == NULL) {
@@ -13,6 +13,7 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
+#include <threads.h>
 #include <unistd.h>
 #include <zircon/assert.h>
 #include <zircon/dlfcn.h>
@@ -100,6 +101,61 @@ static void report_error(char* err_msg, const char* format, ...) {
     va_end(args);
 }
 
+// A connection to the process launcher that can be reused by the next spawn.
+// The launcher resets its state after every Launch, so a connection whose
+// last Launch got a reply is clean. A caller takes the connection out of the
+// cache for the duration of its spawn, so concurrent spawns never interleave
+// messages on one channel.
+static mtx_t launcher_lock = MTX_INIT;
+static zx_handle_t cached_launcher = ZX_HANDLE_INVALID;
+
+static zx_status_t acquire_launcher(zx_handle_t* out, char* err_msg) {
+    mtx_lock(&launcher_lock);
+    zx_handle_t launcher = cached_launcher;
+    cached_launcher = ZX_HANDLE_INVALID;
+    mtx_unlock(&launcher_lock);
+
+    if (launcher != ZX_HANDLE_INVALID) {
+        // Drop the connection if the launcher has gone away since we used it.
+        zx_signals_t observed = 0;
+        zx_object_wait_one(launcher, ZX_CHANNEL_PEER_CLOSED, 0, &observed);
+        if (!(observed & ZX_CHANNEL_PEER_CLOSED)) {
+            *out = launcher;
+            return ZX_OK;
+        }
+        zx_handle_close(launcher);
+    }
+
+    zx_handle_t launcher_request = ZX_HANDLE_INVALID;
+    zx_status_t status = zx_channel_create(0, &launcher, &launcher_request);
+    if (status != ZX_OK) {
+        report_error(err_msg, "failed to create channel for process launcher: %d", status);
+        return status;
+    }
+
+    status = fdio_service_connect("/svc/fuchsia.process.Launcher", launcher_request);
+    if (status != ZX_OK) {
+        report_error(err_msg, "failed to connect to launcher service: %d", status);
+        zx_handle_close(launcher);
+        return status;
+    }
+
+    *out = launcher;
+    return ZX_OK;
+}
+
+static void release_launcher(zx_handle_t launcher) {
+    mtx_lock(&launcher_lock);
+    if (cached_launcher == ZX_HANDLE_INVALID) {
+        cached_launcher = launcher;
+        launcher = ZX_HANDLE_INVALID;
+    }
+    mtx_unlock(&launcher_lock);
+
+    if (launcher != ZX_HANDLE_INVALID)
+        zx_handle_close(launcher);
+}
+
 static zx_status_t send_string_array(zx_handle_t launcher, int ordinal, const char* const* array) {
     size_t count = 0;
     size_t len = 0;
@@ -388,7 +444,6 @@ zx_status_t fdio_spawn_vmo(zx_handle_t job,
     size_t name_len = 0;
     size_t handle_capacity = 0;
     zx_handle_t launcher = ZX_HANDLE_INVALID;
-    zx_handle_t launcher_request = ZX_HANDLE_INVALID;
     zx_handle_t msg_handles[FDIO_SPAWN_LAUNCH_HANDLE_COUNT];
 
     memset(msg_handles, 0, sizeof(msg_handles));
@@ -461,18 +516,9 @@ zx_status_t fdio_spawn_vmo(zx_handle_t job,
         }
     }
 
-    status = zx_channel_create(0, &launcher, &launcher_request);
-    if (status != ZX_OK) {
-        report_error(err_msg, "failed to create channel for process launcher: %d", status);
-        goto cleanup;
-    }
-
-    status = fdio_service_connect("/svc/fuchsia.process.Launcher", launcher_request);
-    launcher_request = ZX_HANDLE_INVALID;
-    if (status != ZX_OK) {
-        report_error(err_msg, "failed to connect to launcher service: %d", status);
+    status = acquire_launcher(&launcher, err_msg);
+    if (status != ZX_OK)
         goto cleanup;
-    }
 
     status = send_string_array(launcher, fuchsia_process_LauncherAddArgsOrdinal, argv);
     if (status != ZX_OK) {
@@ -591,6 +637,11 @@ zx_status_t fdio_spawn_vmo(zx_handle_t job,
             goto cleanup;
         }
 
+        // The launcher has answered and reset itself, so the connection can
+        // serve the next spawn.
+        release_launcher(launcher);
+        launcher = ZX_HANDLE_INVALID;
+
         status = reply.rsp.result.status;
 
         if (status == ZX_OK) {
@@ -646,9 +697,6 @@ cleanup:
     if (launcher != ZX_HANDLE_INVALID)
         zx_handle_close(launcher);
 
-    if (launcher_request != ZX_HANDLE_INVALID)
-        zx_handle_close(launcher_request);
-
     if (msg_handles[FDIO_SPAWN_LAUNCH_HANDLE_EXECUTABLE] != ZX_HANDLE_INVALID)
         zx_handle_close(msg_handles[FDIO_SPAWN_LAUNCH_HANDLE_EXECUTABLE]);
 
@@ -155,16 +155,6 @@ int ttyname_r(int fd, char* name, size_t size) {
     return checkfd(fd, ENOSYS);
 }
 
-__EXPORT
-int sendmmsg(int fd, struct mmsghdr* msgvec, unsigned int vlen, unsigned int flags) {
-    return checksocket(fd, ENOTSOCK, ENOSYS);
-}
-
-__EXPORT
-int recvmmsg(int fd, struct mmsghdr* msgvec, unsigned int vlen, unsigned int flags, struct timespec* timeout) {
-    return checksocket(fd, ENOTSOCK, ENOSYS);
-}
-
 __EXPORT
 int sockatmark(int fd) {
     // ENOTTY is sic.
@@ -182,6 +182,132 @@ static inline zxio_remote_t* fdio_get_zxio_remote(fdio_t* io) {
     return &wrapper->remote;
 }
 
+static zx_status_t fdio_zxio_remote_get_vmo(fdio_t* io, int flags, zx_handle_t* out_vmo);
+
+// Reads of at least this many bytes are served from the file VMO, when the
+// server provides one. Smaller reads fit in a single FileRead message.
+#define VMO_READ_MIN_SIZE FDIO_CHUNK_SIZE
+
+void fdio_zxio_remote_drop_vmo(fdio_zxio_remote_t* rio) {
+    mtx_lock(&rio->vmo_lock);
+    if (rio->vmo != ZX_HANDLE_INVALID) {
+        zx_handle_close(rio->vmo);
+        rio->vmo = ZX_HANDLE_INVALID;
+    }
+    mtx_unlock(&rio->vmo_lock);
+}
+
+// Returns the VMO backing the remote file, asking the server for it on first
+// use. Servers hand out a non-private VMO only when it reflects the current
+// contents of the file: blobs are immutable, and memfs shares the VMO which
+// backs the file. Servers which cannot, such as minfs, refuse the request and
+// are remembered as such.
+//
+// Must be called with |vmo_lock| held.
+static zx_handle_t fdio_zxio_remote_file_vmo(fdio_zxio_remote_t* rio) {
+    if (rio->vmo == ZX_HANDLE_INVALID && !rio->vmo_unavailable) {
+        zx_handle_t vmo;
+        if (fdio_zxio_remote_get_vmo(&rio->io, FDIO_MMAP_FLAG_READ, &vmo) == ZX_OK) {
+            rio->vmo = vmo;
+        } else {
+            rio->vmo_unavailable = true;
+        }
+    }
+    return rio->vmo;
+}
+
+// Reads up to |len| bytes at |offset| from the file VMO, clipped to the
+// current length of the file.
+//
+// Must be called with |vmo_lock| held.
+static zx_status_t fdio_zxio_remote_read_vmo(fdio_zxio_remote_t* rio, void* data, size_t len,
+                                             size_t offset, size_t* out_actual) {
+    zxio_node_attr_t attr;
+    zx_status_t status = zxio_attr_get(&rio->remote.io, &attr);
+    if (status != ZX_OK) {
+        return status;
+    }
+    if (offset >= attr.content_size) {
+        *out_actual = 0;
+        return ZX_OK;
+    }
+    if (len > attr.content_size - offset) {
+        len = attr.content_size - offset;
+    }
+    if ((status = zx_vmo_read(rio->vmo, data, offset, len)) != ZX_OK) {
+        // The VMO does not cover the file; stop using it.
+        zx_handle_close(rio->vmo);
+        rio->vmo = ZX_HANDLE_INVALID;
+        rio->vmo_unavailable = true;
+        return status;
+    }
+    *out_actual = len;
+    return ZX_OK;
+}
+
+static ssize_t fdio_zxio_remote_read(fdio_t* io, void* data, size_t len) {
+    fdio_zxio_remote_t* rio = (fdio_zxio_remote_t*)io;
+    if (len >= VMO_READ_MIN_SIZE) {
+        mtx_lock(&rio->vmo_lock);
+        if (fdio_zxio_remote_file_vmo(rio) != ZX_HANDLE_INVALID) {
+            // The seek pointer lives in the server, so it is read and
+            // advanced around the local copy.
+            zxio_t* z = fdio_get_zxio(io);
+            size_t offset = 0;
+            size_t actual = 0;
+            zx_status_t status = zxio_seek(z, 0, fuchsia_io_SeekOrigin_CURRENT, &offset);
+            if (status == ZX_OK &&
+                (status = fdio_zxio_remote_read_vmo(rio, data, len, offset, &actual)) == ZX_OK) {
+                status = zxio_seek(z, offset + actual, fuchsia_io_SeekOrigin_START, &offset);
+                mtx_unlock(&rio->vmo_lock);
+                return status != ZX_OK ? status : (ssize_t)actual;
+            }
+        }
+        mtx_unlock(&rio->vmo_lock);
+    }
+    return fdio_zxio_read(io, data, len);
+}
+
+static ssize_t fdio_zxio_remote_read_at(fdio_t* io, void* data, size_t len, off_t at) {
+    fdio_zxio_remote_t* rio = (fdio_zxio_remote_t*)io;
+    if (len >= VMO_READ_MIN_SIZE && at >= 0) {
+        mtx_lock(&rio->vmo_lock);
+        if (fdio_zxio_remote_file_vmo(rio) != ZX_HANDLE_INVALID) {
+            size_t actual = 0;
+            zx_status_t status = fdio_zxio_remote_read_vmo(rio, data, len, at, &actual);
+            if (status == ZX_OK) {
+                mtx_unlock(&rio->vmo_lock);
+                return actual;
+            }
+        }
+        mtx_unlock(&rio->vmo_lock);
+    }
+    return fdio_zxio_read_at(io, data, len, at);
+}
+
+static ssize_t fdio_zxio_remote_write(fdio_t* io, const void* data, size_t len) {
+    ssize_t r = fdio_zxio_write(io, data, len);
+    fdio_zxio_remote_drop_vmo((fdio_zxio_remote_t*)io);
+    return r;
+}
+
+static ssize_t fdio_zxio_remote_write_at(fdio_t* io, const void* data, size_t len, off_t at) {
+    ssize_t r = fdio_zxio_write_at(io, data, len, at);
+    fdio_zxio_remote_drop_vmo((fdio_zxio_remote_t*)io);
+    return r;
+}
+
+static zx_status_t fdio_zxio_remote_truncate(fdio_t* io, off_t off) {
+    zx_status_t status = fdio_zxio_truncate(io, off);
+    fdio_zxio_remote_drop_vmo((fdio_zxio_remote_t*)io);
+    return status;
+}
+
+static zx_status_t fdio_zxio_remote_close(fdio_t* io) {
+    fdio_zxio_remote_drop_vmo((fdio_zxio_remote_t*)io);
+    return fdio_zxio_close(io);
+}
+
 static zx_status_t fdio_zxio_remote_open(fdio_t* io, const char* path,
                                          uint32_t flags, uint32_t mode,
                                          fdio_t** out) {
@@ -246,6 +372,7 @@ static void fdio_zxio_remote_wait_end(fdio_t* io, zx_signals_t signals, uint32_t
 }
 
 static zx_status_t fdio_zxio_remote_unwrap(fdio_t* io, zx_handle_t* handles, uint32_t* types) {
+    fdio_zxio_remote_drop_vmo((fdio_zxio_remote_t*)io);
     zxio_t* z = fdio_get_zxio(io);
     zx_handle_t handle = ZX_HANDLE_INVALID;
     zx_status_t status = zxio_release(z, &handle);
@@ -334,13 +461,13 @@ static zx_status_t fdio_zxio_remote_link(fdio_t* io, const char* src, size_t src
 }
 
 fdio_ops_t fdio_zxio_remote_ops = {
-    .read = fdio_zxio_read,
-    .read_at = fdio_zxio_read_at,
-    .write = fdio_zxio_write,
-    .write_at = fdio_zxio_write_at,
+    .read = fdio_zxio_remote_read,
+    .read_at = fdio_zxio_remote_read_at,
+    .write = fdio_zxio_remote_write,
+    .write_at = fdio_zxio_remote_write_at,
     .seek = fdio_zxio_seek,
     .misc = fdio_default_misc,
-    .close = fdio_zxio_close,
+    .close = fdio_zxio_remote_close,
     .open = fdio_zxio_remote_open,
     .clone = fdio_zxio_remote_clone,
     .ioctl = fdio_zxio_remote_ioctl,
@@ -356,7 +483,7 @@ fdio_ops_t fdio_zxio_remote_ops = {
     .readdir = fdio_zxio_remote_readdir,
     .rewind = fdio_zxio_remote_rewind,
     .unlink = fdio_zxio_remote_unlink,
-    .truncate = fdio_zxio_truncate,
+    .truncate = fdio_zxio_remote_truncate,
     .rename = fdio_zxio_remote_rename,
     .link = fdio_zxio_remote_link,
     .get_flags = fdio_zxio_get_flags,
@@ -378,6 +505,8 @@ fdio_t* fdio_zxio_create_remote(zx_handle_t control, zx_handle_t event) {
     fv->io.ops = &fdio_zxio_remote_ops;
     fv->io.magic = FDIO_MAGIC;
     atomic_init(&fv->io.refcount, 1);
+    mtx_init(&fv->vmo_lock, mtx_plain);
+    fv->vmo = ZX_HANDLE_INVALID;
     zx_status_t status = zxio_remote_init(&fv->remote, control, event);
     if (status != ZX_OK) {
         return NULL;
@@ -24,7 +24,16 @@ public:
         uint32_t bytes_capacity = ZX_CHANNEL_MAX_MSG_BYTES,
         uint32_t handles_capacity = ZX_CHANNEL_MAX_MSG_HANDLES);
 
-    // The memory that backs the message is freed by this destructor.
+    // Creates a |MessageBuffer| backed by caller-provided memory, such as a
+    // buffer on the stack or in an arena, without using the heap.
+    //
+    // |bytes| must be aligned to |FIDL_ALIGNMENT| and, like |handles|, must
+    // outlive the |MessageBuffer|, which does not free them.
+    MessageBuffer(uint8_t* bytes, uint32_t bytes_capacity,
+                  zx_handle_t* handles, uint32_t handles_capacity);
+
+    // The memory that backs the message is freed by this destructor, unless
+    // it was provided by the caller.
     ~MessageBuffer();
 
     // The memory in which bytes can be stored in this buffer.
@@ -34,7 +43,7 @@ public:
     uint32_t bytes_capacity() const { return bytes_capacity_; }
 
     // The memory in which handles can be stored in this buffer.
-    zx_handle_t* handles() const;
+    zx_handle_t* handles() const { return handles_; }
 
     // The total number of handles that can be stored in this buffer.
     uint32_t handles_capacity() const { return handles_capacity_; }
@@ -49,8 +58,10 @@ public:
 
 private:
     uint8_t* const buffer_;
+    zx_handle_t* const handles_;
     const uint32_t bytes_capacity_;
     const uint32_t handles_capacity_;
+    const bool owns_buffer_;
 };
 
 } // namespace fidl
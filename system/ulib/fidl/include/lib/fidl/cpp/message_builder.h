@@ -18,8 +18,8 @@ namespace fidl {
 // A builder for FIDL messages that owns the memory for the message.
 //
 // A |MessageBuilder| is a |Builder| that uses the heap to back the memory for
-// the message. If you wish to manage the memory yourself, you can use |Builder|
-// and |Message| directly.
+// the message, unless it is given memory by the caller. If you wish to manage
+// the memory yourself, you can also use |Builder| and |Message| directly.
 //
 // Upon creation, the |MessageBuilder| creates a FIDL message header, which you
 // can modify using |header()|.
@@ -37,7 +37,16 @@ public:
         uint32_t bytes_capacity = ZX_CHANNEL_MAX_MSG_BYTES,
         uint32_t handles_capacity = ZX_CHANNEL_MAX_MSG_HANDLES);
 
-    // The memory that backs the message is freed by this destructor.
+    // Creates a |MessageBuilder| for the given |type| that builds the message
+    // in caller-provided memory, and so never touches the heap.
+    //
+    // See |MessageBuffer| for the requirements on |bytes| and |handles|.
+    MessageBuilder(const fidl_type_t* type,
+                   uint8_t* bytes, uint32_t bytes_capacity,
+                   zx_handle_t* handles, uint32_t handles_capacity);
+
+    // The memory that backs the message is freed by this destructor, unless
+    // it was provided by the caller.
     ~MessageBuilder();
 
     // The type of the message payload this object is building.
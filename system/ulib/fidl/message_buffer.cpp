@@ -11,9 +11,9 @@ namespace fidl {
 namespace {
 
 uint64_t AddPadding(uint32_t offset) {
-    constexpr uint32_t kMask = alignof(zx_handle_t) - 1;
+    constexpr uint64_t kMask = alignof(zx_handle_t) - 1;
     // Cast before addition to avoid overflow.
-    return static_cast<uint64_t>(offset) + static_cast<uint64_t>(offset & kMask);
+    return (static_cast<uint64_t>(offset) + kMask) & ~kMask;
 }
 
 size_t GetAllocSize(uint32_t bytes_capacity, uint32_t handles_capacity) {
@@ -25,17 +25,27 @@ size_t GetAllocSize(uint32_t bytes_capacity, uint32_t handles_capacity) {
 MessageBuffer::MessageBuffer(uint32_t bytes_capacity,
                              uint32_t handles_capacity)
     : buffer_(static_cast<uint8_t*>(malloc(GetAllocSize(bytes_capacity, handles_capacity)))),
+      handles_(reinterpret_cast<zx_handle_t*>(buffer_ + AddPadding(bytes_capacity))),
       bytes_capacity_(bytes_capacity),
-      handles_capacity_(handles_capacity) {
+      handles_capacity_(handles_capacity),
+      owns_buffer_(true) {
     ZX_ASSERT_MSG(buffer_, "malloc returned NULL in MessageBuffer::MessageBuffer()");
 }
 
-MessageBuffer::~MessageBuffer() {
-    free(buffer_);
+MessageBuffer::MessageBuffer(uint8_t* bytes, uint32_t bytes_capacity,
+                             zx_handle_t* handles, uint32_t handles_capacity)
+    : buffer_(bytes),
+      handles_(handles),
+      bytes_capacity_(bytes_capacity),
+      handles_capacity_(handles_capacity),
+      owns_buffer_(false) {
+    ZX_DEBUG_ASSERT(reinterpret_cast<uintptr_t>(bytes) % FIDL_ALIGNMENT == 0);
 }
 
-zx_handle_t* MessageBuffer::handles() const {
-    return reinterpret_cast<zx_handle_t*>(buffer_ + AddPadding(bytes_capacity_));
+MessageBuffer::~MessageBuffer() {
+    if (owns_buffer_) {
+        free(buffer_);
+    }
 }
 
 Message MessageBuffer::CreateEmptyMessage() {
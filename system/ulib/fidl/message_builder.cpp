@@ -17,6 +17,14 @@ MessageBuilder::MessageBuilder(const fidl_type_t* type,
     Reset();
 }
 
+MessageBuilder::MessageBuilder(const fidl_type_t* type,
+                               uint8_t* bytes, uint32_t bytes_capacity,
+                               zx_handle_t* handles, uint32_t handles_capacity)
+    : type_(type),
+      buffer_(bytes, bytes_capacity, handles, handles_capacity) {
+    Reset();
+}
+
 MessageBuilder::~MessageBuilder() = default;
 
 zx_status_t MessageBuilder::Encode(Message* message_out,
@@ -44,6 +44,9 @@ zx_status_t FsckNativeFs(const char* device_path, const fsck_options_t* options,
     if (options->verbose) {
         argv[argc++] = "-v";
     }
+    if (options->verify_in_background) {
+        argv[argc++] = "--verify-in-background";
+    }
     // TODO(smklein): Add support for modify, force flags. Without them,
     // we have "always_modify=true" and "force=true" effectively on by default.
     argv[argc++] = "fsck";
@@ -85,6 +85,13 @@ typedef struct mount_options {
     bool create_mountpoint;
     // Enable journaling on the file system (if supported).
     bool enable_journal;
+    // Verify the contents of the file system in the background once it is
+    // mounted (blobfs only).
+    bool verify_in_background;
+    // Keep up to this many megabytes of closed files in memory, evicting the
+    // least recently used first, instead of evicting each file as soon as it
+    // is closed (blobfs only). Zero keeps the default.
+    uint32_t cache_size_mb;
 } mount_options_t;
 
 extern const mount_options_t default_mount_options;
@@ -104,9 +111,12 @@ typedef struct fsck_options {
     bool never_modify;  // Fsck still looks for problems, but it does not try to resolve them.
     bool always_modify; // Fsck never asks to resolve problems; it assumes it should fix them.
     bool force;         // Force fsck to check the filesystem integrity, even if it is marked as "clean".
+    // Skip checks that the mounted filesystem will make in the background,
+    // because it will be mounted with |verify_in_background| (blobfs only).
+    bool verify_in_background;
 } fsck_options_t;
 
-#define NUM_FSCK_OPTIONS 3
+#define NUM_FSCK_OPTIONS 4
 
 extern const fsck_options_t default_fsck_options;
 
@@ -44,6 +44,10 @@ zx_status_t wake_ramdisk(const char* ramdisk_path);
 // Returns the ramdisk's current failed, successful, and total block counts as |counts|.
 zx_status_t get_ramdisk_blocks(const char* ramdisk_path, ramdisk_blk_counts_t* counts);
 
+// Makes the ramdisk at |ramdisk_path| simulate the request, transfer and flush
+// costs in |latency|.
+zx_status_t set_ramdisk_latency(const char* ramdisk_path, const ramdisk_latency_t* latency);
+
 // Destroys a ramdisk, given the "ramdisk_path" returned from "create_ramdisk".
 zx_status_t destroy_ramdisk(const char* ramdisk_path);
 
@@ -6,6 +6,7 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <stdio.h>
 #include <string.h>
 #include <unistd.h>
 
@@ -195,9 +196,13 @@ zx_status_t Mounter::MountNativeFs(const char* binary, unique_fd device,
     // 2. (optional) readonly
     // 3. (optional) verbose
     // 4. (optional) metrics
-    // 5. command
-    const char* argv[5] = {binary};
+    // 5. (optional) journal
+    // 6. (optional) verify in background
+    // 7. (optional) cache size, and its value
+    // 8. command
+    const char* argv[9] = {binary};
     int argc = 1;
+    char cache_size_arg[16];
     if (options.readonly) {
         argv[argc++] = "--readonly";
     }
@@ -210,6 +215,14 @@ zx_status_t Mounter::MountNativeFs(const char* binary, unique_fd device,
     if (options.enable_journal) {
         argv[argc++] = "--journal";
     }
+    if (options.verify_in_background) {
+        argv[argc++] = "--verify-in-background";
+    }
+    if (options.cache_size_mb > 0) {
+        snprintf(cache_size_arg, sizeof(cache_size_arg), "%u", options.cache_size_mb);
+        argv[argc++] = "--cache-size";
+        argv[argc++] = cache_size_arg;
+    }
     argv[argc++] = "mount";
     return LaunchAndMount(cb, options, argv, argc);
 }
@@ -261,6 +274,8 @@ const mount_options_t default_mount_options = {
     .wait_until_ready = true,
     .create_mountpoint = false,
     .enable_journal = false,
+    .verify_in_background = false,
+    .cache_size_mb = 0,
 };
 
 const mkfs_options_t default_mkfs_options = {
@@ -273,6 +288,7 @@ const fsck_options_t default_fsck_options = {
     .never_modify = false,
     .always_modify = false,
     .force = false,
+    .verify_in_background = false,
 };
 
 disk_format_t detect_disk_format(int fd) {
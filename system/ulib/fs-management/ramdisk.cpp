@@ -222,6 +222,20 @@ zx_status_t get_ramdisk_blocks(const char* ramdisk_path, ramdisk_blk_counts_t* c
     return ZX_OK;
 }
 
+zx_status_t set_ramdisk_latency(const char* ramdisk_path, const ramdisk_latency_t* latency) {
+    fbl::unique_fd fd(open(ramdisk_path, O_RDWR));
+    if (fd.get() < 0) {
+        fprintf(stderr, "Could not open ramdisk\n");
+        return ZX_ERR_BAD_STATE;
+    }
+    ssize_t r = ioctl_ramdisk_set_latency(fd.get(), latency);
+    if (r < 0) {
+        fprintf(stderr, "Could not set ramdisk latency\n");
+        return static_cast<zx_status_t>(r);
+    }
+    return ZX_OK;
+}
+
 zx_status_t destroy_ramdisk(const char* ramdisk_path) {
     fbl::unique_fd ramdisk(open(ramdisk_path, O_RDWR));
     if (!ramdisk) {
@@ -329,6 +329,7 @@ void Connection::HandleSignals(async_dispatcher_t* dispatcher, async::WaitBase*
     }
 
     bool call_close = (status != ERR_DISPATCHER_DONE);
+    Vfs::DispatchLock lock(vfs_, /* shared= */ false);
     Terminate(call_close);
 }
 
@@ -348,15 +349,44 @@ void Connection::Terminate(bool call_close) {
 }
 
 zx_status_t Connection::CallHandler() {
-    return zxfidl_handler(channel_.get(), &Connection::HandleMessageThunk, this);
+    return zxfidl_handler(channel_.get(), &Connection::DispatchMessageThunk, this);
 }
 
 void Connection::CallClose() {
     channel_.reset();
-    CallHandler();
+    // The close message is synthesized by the filesystem itself, from paths
+    // which already hold the dispatch lock.
+    zxfidl_handler(ZX_HANDLE_INVALID, &Connection::HandleMessageThunk, this);
     set_closed();
 }
 
+zx_status_t Connection::DispatchMessageThunk(fidl_msg_t* msg, fidl_txn_t* txn, void* cookie) {
+    Connection* connection = static_cast<Connection*>(cookie);
+    fidl_message_header_t* hdr = reinterpret_cast<fidl_message_header_t*>(msg->bytes);
+    bool shared;
+    switch (hdr->ordinal) {
+    case fuchsia_io_FileReadOrdinal:
+    case fuchsia_io_FileReadAtOrdinal:
+        shared = connection->vnode_->SupportsConcurrentReads();
+        break;
+    case fuchsia_io_FileWriteOrdinal:
+    case fuchsia_io_FileWriteAtOrdinal:
+    case fuchsia_io_FileSeekOrdinal:
+    case fuchsia_io_FileTruncateOrdinal:
+    case fuchsia_io_FileGetVmoOrdinal:
+    case fuchsia_io_NodeGetAttrOrdinal:
+        // These only touch the vnode and the state of this connection, which
+        // handles one message at a time.
+        shared = connection->vnode_->SupportsConcurrentWrites();
+        break;
+    default:
+        shared = false;
+        break;
+    }
+    Vfs::DispatchLock lock(connection->vfs_, shared);
+    return connection->HandleMessage(msg, txn);
+}
+
 zx_status_t Connection::HandleMessageThunk(fidl_msg_t* msg, fidl_txn_t* txn, void* cookie) {
     Connection* connection = static_cast<Connection*>(cookie);
     return connection->HandleMessage(msg, txn);
@@ -146,6 +146,10 @@ private:
     //
     // By default, handles the Node, File, Directory and DirectoryAdmin
     // protocols, dispatching to |HandleFsSpecificMessage| if the ordinal is not recognized.
+    //
+    // |DispatchMessageThunk| holds the Vfs dispatch lock for the duration of the
+    // message; |HandleMessageThunk| expects the caller to hold it already.
+    static zx_status_t DispatchMessageThunk(fidl_msg_t* msg, fidl_txn_t* txn, void* cookie);
     static zx_status_t HandleMessageThunk(fidl_msg_t* msg, fidl_txn_t* txn, void* cookie);
     zx_status_t HandleMessage(fidl_msg_t* msg, fidl_txn_t* txn);
 
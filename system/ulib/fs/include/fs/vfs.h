@@ -25,6 +25,7 @@
 #include <lib/zx/event.h>
 #include <lib/zx/vmo.h>
 #include <fbl/mutex.h>
+#include <pthread.h>
 #endif // __Fuchsia__
 
 #include <fbl/function.h>
@@ -156,6 +157,21 @@ public:
     async_dispatcher_t* dispatcher() { return dispatcher_; }
     void SetDispatcher(async_dispatcher_t* dispatcher) { dispatcher_ = dispatcher; }
 
+    // Serializes the operations dispatched on connections to this Vfs, which
+    // allows those connections to be served by a multi-threaded dispatcher.
+    //
+    // Operations hold the lock exclusively, except for reads of vnodes which
+    // report |Vnode::SupportsConcurrentReads|; those share it with each other.
+    class DispatchLock {
+    public:
+        DispatchLock(Vfs* vfs, bool shared);
+        ~DispatchLock();
+
+    private:
+        DISALLOW_COPY_ASSIGN_AND_MOVE(DispatchLock);
+        Vfs* const vfs_;
+    };
+
     // Begins serving VFS messages over the specified connection.
     zx_status_t ServeConnection(fbl::unique_ptr<Connection> connection) FS_TA_EXCLUDES(vfs_lock_);
 
@@ -238,6 +254,9 @@ private:
 
     async_dispatcher_t* dispatcher_{};
 
+    // Held by |DispatchLock|. Ordered before |vfs_lock_|.
+    pthread_rwlock_t dispatch_lock_ = PTHREAD_RWLOCK_INITIALIZER;
+
 protected:
     // A lock which should be used to protect lookup and walk operations
     mtx_t vfs_lock_{};
@@ -76,6 +76,7 @@ public:
     zx_status_t ValidateFlags(uint32_t flags) final;
     zx_status_t Getattr(vnattr_t* a) final;
     zx_status_t Read(void* data, size_t length, size_t offset, size_t* out_actual) final;
+    bool SupportsConcurrentReads() const final;
     zx_status_t Write(const void* data, size_t length, size_t offset, size_t* out_actual) final;
     zx_status_t GetHandles(uint32_t flags, zx_handle_t* hnd, uint32_t* type,
                            zxrio_node_info_t* extra) final;
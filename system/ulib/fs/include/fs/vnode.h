@@ -116,6 +116,23 @@ public:
     // less than or equal to |len|.
     virtual zx_status_t Read(void* data, size_t len, size_t off, size_t* out_actual);
 
+    // Identifies if |Read| may run concurrently with reads of any vnode of the
+    // same filesystem. When the filesystem is served by a multi-threaded
+    // dispatcher, reads of such vnodes are dispatched in parallel; every other
+    // operation remains serialized.
+    //
+    // Returns false by default.
+    virtual bool SupportsConcurrentReads() const;
+
+    // Identifies if |Write|, |Append|, |Truncate|, |GetVmo| and |Getattr| may
+    // run concurrently with each other, and with |Read|, on this vnode and on
+    // any other vnode of the same filesystem. Such vnodes serialize access to
+    // their own state. When the filesystem is served by a multi-threaded
+    // dispatcher, those operations are dispatched in parallel with reads.
+    //
+    // Returns false by default.
+    virtual bool SupportsConcurrentWrites() const;
+
     // Write |len| bytes of |data| to the file, starting at |offset|.
     //
     // If successful, returns the number of bytes written in |out_actual|. This must be
@@ -11,13 +11,18 @@
 #include <fbl/intrusive_double_list.h>
 #include <fbl/macros.h>
 #include <fbl/mutex.h>
+#include <fbl/ref_counted.h>
+#include <fbl/ref_ptr.h>
 #include <fbl/unique_ptr.h>
 #include <fs/vfs.h>
 #include <zircon/device/vfs.h>
+#include <lib/async/dispatcher.h>
 #include <lib/zx/channel.h>
 
 namespace fs {
 
+class WatchBuffer;
+
 // Implements directory watching , holding a list of watchers
 class WatcherContainer {
 public:
@@ -29,22 +34,45 @@ public:
 
     // Notifies all VnodeWatchers in the watch list, if their mask
     // indicates they are interested in the incoming event.
+    //
+    // If the Vfs serving the watcher has a dispatcher, events are buffered
+    // and sent together from a task posted to it, so that a burst of events
+    // turns into a few messages rather than one message per event.
     void Notify(fbl::StringPiece name, unsigned event);
 private:
     DISALLOW_COPY_ASSIGN_AND_MOVE(WatcherContainer);
 
     // A simple structure which holds a channel to a watching client,
     // as well as a mask of signals they are interested in hearing about.
-    struct VnodeWatcher : public fbl::DoublyLinkedListable<fbl::unique_ptr<VnodeWatcher>> {
-        VnodeWatcher(zx::channel h, uint32_t mask);
+    //
+    // Watchers are reference counted, since a pending flush may outlive
+    // the container it was posted for.
+    struct VnodeWatcher : public fbl::DoublyLinkedListable<fbl::RefPtr<VnodeWatcher>>,
+                          public fbl::RefCounted<VnodeWatcher> {
+        VnodeWatcher(zx::channel h, uint32_t mask, async_dispatcher_t* dispatcher,
+                     fbl::unique_ptr<WatchBuffer> pending);
         ~VnodeWatcher();
 
-        zx::channel h;
-        uint32_t mask;
+        // Adds an event to |pending|, posting a flush if there is none yet.
+        // Returns an error if the channel can no longer be written.
+        zx_status_t Queue(fbl::StringPiece name, unsigned event);
+
+        // Sends the events in |pending|.
+        void Flush();
+
+        const zx::channel h;
+        const uint32_t mask;
+        async_dispatcher_t* const dispatcher;
+
+        fbl::Mutex mutex;
+        fbl::unique_ptr<WatchBuffer> pending __TA_GUARDED(mutex);
+        bool flush_posted __TA_GUARDED(mutex) = false;
+        // Set once a write to |h| has failed.
+        bool closed __TA_GUARDED(mutex) = false;
     };
 
     fbl::Mutex lock_;
-    fbl::DoublyLinkedList<fbl::unique_ptr<VnodeWatcher>> watch_list_ __TA_GUARDED(lock_);
+    fbl::DoublyLinkedList<fbl::RefPtr<VnodeWatcher>> watch_list_ __TA_GUARDED(lock_);
 };
 
 }
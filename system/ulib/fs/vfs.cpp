@@ -401,6 +401,16 @@ zx_status_t Vfs::Link(zx::event token, fbl::RefPtr<Vnode> oldparent,
     return ZX_OK;
 }
 
+Vfs::DispatchLock::DispatchLock(Vfs* vfs, bool shared) : vfs_(vfs) {
+    int r = shared ? pthread_rwlock_rdlock(&vfs_->dispatch_lock_) :
+                     pthread_rwlock_wrlock(&vfs_->dispatch_lock_);
+    ZX_ASSERT_MSG(r == 0, "Failed to acquire dispatch lock: %d\n", r);
+}
+
+Vfs::DispatchLock::~DispatchLock() {
+    pthread_rwlock_unlock(&vfs_->dispatch_lock_);
+}
+
 zx_status_t Vfs::ServeConnection(fbl::unique_ptr<Connection> connection) {
     ZX_DEBUG_ASSERT(connection);
 
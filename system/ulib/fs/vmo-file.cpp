@@ -86,6 +86,11 @@ zx_status_t VmoFile::Read(void* data, size_t length, size_t offset, size_t* out_
     return ZX_OK;
 }
 
+bool VmoFile::SupportsConcurrentReads() const {
+    // |Read| only touches the VMO and fields fixed at construction.
+    return true;
+}
+
 zx_status_t VmoFile::Write(const void* data, size_t length, size_t offset, size_t* out_actual) {
     ZX_DEBUG_ASSERT(writable_); // checked by the VFS
 
@@ -49,6 +49,14 @@ zx_status_t Vnode::Read(void* data, size_t len, size_t off, size_t* out_actual)
     return ZX_ERR_NOT_SUPPORTED;
 }
 
+bool Vnode::SupportsConcurrentReads() const {
+    return false;
+}
+
+bool Vnode::SupportsConcurrentWrites() const {
+    return false;
+}
+
 zx_status_t Vnode::Write(const void* data, size_t len, size_t offset, size_t* out_actual) {
     return ZX_ERR_NOT_SUPPORTED;
 }
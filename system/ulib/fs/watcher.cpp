@@ -11,6 +11,7 @@
 #include <zircon/device/vfs.h>
 #include <zircon/syscalls.h>
 #include <fbl/auto_lock.h>
+#include <lib/async/cpp/task.h>
 #endif
 
 #include <fbl/alloc_checker.h>
@@ -24,11 +25,6 @@ namespace fs {
 WatcherContainer::WatcherContainer() = default;
 WatcherContainer::~WatcherContainer() = default;
 
-WatcherContainer::VnodeWatcher::VnodeWatcher(zx::channel h, uint32_t mask) : h(fbl::move(h)),
-    mask(mask & ~(fuchsia_io_WATCH_MASK_EXISTING | fuchsia_io_WATCH_MASK_IDLE)) {}
-
-WatcherContainer::VnodeWatcher::~VnodeWatcher() {}
-
 // Transmission buffer for sending directory watcher notifications to clients.
 // Allows enqueueing multiple messages in a buffer before sending an IPC message
 // to a client.
@@ -76,6 +72,51 @@ zx_status_t WatchBuffer::Send(const zx::channel& c) {
     return ZX_OK;
 }
 
+WatcherContainer::VnodeWatcher::VnodeWatcher(zx::channel h, uint32_t mask,
+                                             async_dispatcher_t* dispatcher,
+                                             fbl::unique_ptr<WatchBuffer> pending)
+    : h(fbl::move(h)),
+      mask(mask & ~(fuchsia_io_WATCH_MASK_EXISTING | fuchsia_io_WATCH_MASK_IDLE)),
+      dispatcher(dispatcher), pending(fbl::move(pending)) {}
+
+WatcherContainer::VnodeWatcher::~VnodeWatcher() {}
+
+zx_status_t WatcherContainer::VnodeWatcher::Queue(fbl::StringPiece name, unsigned event) {
+    fbl::AutoLock lock(&mutex);
+    if (closed) {
+        return ZX_ERR_PEER_CLOSED;
+    }
+
+    zx_status_t status = pending->AddMsg(h, event, name);
+    if (status == ZX_OK) {
+        if (dispatcher == nullptr) {
+            status = pending->Send(h);
+        } else if (!flush_posted) {
+            // Events which arrive before the dispatcher gets to this task
+            // are sent along with this one.
+            fbl::RefPtr<VnodeWatcher> self(this);
+            status = async::PostTask(dispatcher, [self = fbl::move(self)]() { self->Flush(); });
+            if (status == ZX_OK) {
+                flush_posted = true;
+            } else {
+                status = pending->Send(h);
+            }
+        }
+    }
+    if (status != ZX_OK) {
+        closed = true;
+    }
+    return status;
+}
+
+void WatcherContainer::VnodeWatcher::Flush() {
+    fbl::AutoLock lock(&mutex);
+    flush_posted = false;
+    if (!closed && pending->Send(h) != ZX_OK) {
+        closed = true;
+    }
+}
+
 zx_status_t WatcherContainer::WatchDir(Vfs* vfs, Vnode* vn, uint32_t mask, uint32_t options,
                                        zx::channel channel) {
     if ((mask & fuchsia_io_WATCH_MASK_ALL) == 0) {
@@ -84,7 +125,13 @@ zx_status_t WatcherContainer::WatchDir(Vfs* vfs, Vnode* vn, uint32_t mask, uint3
     }
 
     fbl::AllocChecker ac;
-    fbl::unique_ptr<VnodeWatcher> watcher(new (&ac) VnodeWatcher(fbl::move(channel), mask));
+    fbl::unique_ptr<WatchBuffer> pending(new (&ac) WatchBuffer());
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    fbl::RefPtr<VnodeWatcher> watcher = fbl::AdoptRef(
+        new (&ac) VnodeWatcher(fbl::move(channel), mask, vfs ? vfs->dispatcher() : nullptr,
+                               fbl::move(pending)));
     if (!ac.check()) {
         return ZX_ERR_NO_MEMORY;
     }
@@ -144,19 +191,13 @@ void WatcherContainer::Notify(fbl::StringPiece name, unsigned event) {
         return;
     }
 
-    uint8_t msg[sizeof(vfs_watch_msg_t) + name.length()];
-    vfs_watch_msg_t* vmsg = reinterpret_cast<vfs_watch_msg_t*>(msg);
-    vmsg->event = static_cast<uint8_t>(event);
-    vmsg->len = static_cast<uint8_t>(name.length());
-    memcpy(vmsg->name, name.data(), name.length());
-
     for (auto it = watch_list_.begin(); it != watch_list_.end();) {
         if (!(it->mask & (1 << event))) {
             ++it;
             continue;
         }
 
-        zx_status_t status = it->h.write(0, msg, static_cast<uint32_t>(sizeof(msg)), nullptr, 0);
+        zx_status_t status = it->Queue(name, event);
         if (status < 0) {
             // Lazily remove watchers when their handles cannot accept incoming
             // watch messages.
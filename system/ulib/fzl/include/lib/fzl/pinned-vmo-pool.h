@@ -0,0 +1,96 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <fbl/array.h>
+#include <fbl/atomic.h>
+#include <fbl/limits.h>
+#include <fbl/macros.h>
+#include <lib/fzl/pinned-vmo.h>
+#include <lib/fzl/vmo-mapper.h>
+#include <lib/zx/bti.h>
+#include <lib/zx/vmo.h>
+#include <zircon/types.h>
+
+namespace fzl {
+
+// A fixed set of equally sized buffers for DMA, which are allocated, mapped
+// into the root VMAR and pinned against a BTI once, when the pool is
+// initialized, and stay pinned until the pool is destroyed.  Buffers are
+// then handed out and returned by index, giving drivers both the virtual
+// address and the physical regions of each buffer without paying to pin
+// it for every use.
+//
+// Init must be called, and must succeed, before any other method is used.
+// After that, Acquire and Release are lock-free and may be called from any
+// thread.  The pool does no cache maintenance; that is left to the caller.
+class PinnedVmoPool {
+public:
+    // Allocate each buffer as a single physically contiguous VMO.
+    static constexpr uint32_t kContiguous = 1u << 0;
+
+    PinnedVmoPool() = default;
+    ~PinnedVmoPool() = default;
+    DISALLOW_COPY_ASSIGN_AND_MOVE(PinnedVmoPool);
+
+    // Creates |buffer_count| buffers of |buffer_size| bytes each (rounded up
+    // to whole pages), maps them read/write and pins them against |bti| with
+    // |pin_rights| (ZX_BTI_PERM_READ and/or ZX_BTI_PERM_WRITE).  |options|
+    // may contain kContiguous.  All buffers start out free.
+    zx_status_t Init(const zx::bti& bti, uint32_t buffer_count, size_t buffer_size,
+                     uint32_t pin_rights, uint32_t options = 0);
+
+    // Takes a free buffer out of the pool, and stores its index in
+    // |buffer_index|.  Returns ZX_ERR_NOT_FOUND if no buffers are free.
+    zx_status_t Acquire(uint32_t* buffer_index);
+
+    // Returns the buffer with index |buffer_index| to the pool.  Returns
+    // ZX_ERR_INVALID_ARGS if the index is out of bounds, or ZX_ERR_BAD_STATE
+    // if the buffer was not acquired.
+    zx_status_t Release(uint32_t buffer_index);
+
+    uint32_t buffer_count() const { return static_cast<uint32_t>(buffers_.size()); }
+    size_t buffer_size() const { return buffer_size_; }
+
+    // Accessors for the buffer with index |buffer_index|.
+    void* virt(uint32_t buffer_index) const {
+        ZX_DEBUG_ASSERT(buffer_index < buffers_.size());
+        return buffers_[buffer_index].mapper.start();
+    }
+    const PinnedVmo& pinned(uint32_t buffer_index) const {
+        ZX_DEBUG_ASSERT(buffer_index < buffers_.size());
+        return buffers_[buffer_index].pinned;
+    }
+    const zx::vmo& vmo(uint32_t buffer_index) const {
+        ZX_DEBUG_ASSERT(buffer_index < buffers_.size());
+        return buffers_[buffer_index].vmo;
+    }
+
+private:
+    struct Buffer {
+        zx::vmo vmo;
+        VmoMapper mapper;
+        PinnedVmo pinned;
+        // Index of the next buffer in the free list, while this one is free.
+        fbl::atomic<uint32_t> next{kNone};
+        fbl::atomic<bool> acquired{false};
+    };
+
+    static constexpr uint32_t kNone = fbl::numeric_limits<uint32_t>::max();
+
+    // Pushes the buffer with index |buffer_index| onto the free list.
+    void PushFree(uint32_t buffer_index);
+
+    fbl::Array<Buffer> buffers_;
+    size_t buffer_size_ = 0;
+
+    // Head of the free list: the index of the first free buffer in the low
+    // 32 bits, and a count of changes to the head in the high 32 bits, so
+    // that a pop racing with a pop and push of the same buffer fails its
+    // compare-exchange instead of installing a stale next index.
+    fbl::atomic<uint64_t> free_head_{kNone};
+};
+
+} // namespace fzl
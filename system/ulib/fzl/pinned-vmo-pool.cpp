@@ -0,0 +1,111 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
+#include <lib/fzl/pinned-vmo-pool.h>
+#include <zircon/syscalls.h>
+
+namespace fzl {
+
+namespace {
+
+uint64_t MakeHead(uint64_t old_head, uint32_t index) {
+    return (((old_head >> 32) + 1) << 32) | index;
+}
+
+} // namespace
+
+zx_status_t PinnedVmoPool::Init(const zx::bti& bti, uint32_t buffer_count, size_t buffer_size,
+                                uint32_t pin_rights, uint32_t options) {
+    if (buffers_.size() != 0) {
+        return ZX_ERR_BAD_STATE;
+    }
+    if (!bti.is_valid() || buffer_count == 0 || buffer_count == kNone || buffer_size == 0 ||
+        (options & ~kContiguous) != 0) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+
+    fbl::AllocChecker ac;
+    fbl::Array<Buffer> buffers(new (&ac) Buffer[buffer_count], buffer_count);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+
+    buffer_size = fbl::round_up(buffer_size, static_cast<size_t>(PAGE_SIZE));
+    zx_status_t status;
+    for (uint32_t i = 0; i < buffer_count; ++i) {
+        Buffer& buffer = buffers[i];
+        if (options & kContiguous) {
+            status = zx_vmo_create_contiguous(bti.get(), buffer_size, 0,
+                                              buffer.vmo.reset_and_get_address());
+        } else {
+            status = zx::vmo::create(buffer_size, 0, &buffer.vmo);
+        }
+        if (status != ZX_OK) {
+            return status;
+        }
+        status = buffer.mapper.Map(buffer.vmo, 0, buffer_size,
+                                   ZX_VM_PERM_READ | ZX_VM_PERM_WRITE);
+        if (status != ZX_OK) {
+            return status;
+        }
+        if ((status = buffer.pinned.Pin(buffer.vmo, bti, pin_rights)) != ZX_OK) {
+            return status;
+        }
+    }
+
+    buffers_ = fbl::move(buffers);
+    buffer_size_ = buffer_size;
+    for (uint32_t i = buffer_count; i > 0; --i) {
+        PushFree(i - 1);
+    }
+    return ZX_OK;
+}
+
+zx_status_t PinnedVmoPool::Acquire(uint32_t* buffer_index) {
+    uint64_t head = free_head_.load(fbl::memory_order_acquire);
+    uint32_t index;
+    do {
+        index = static_cast<uint32_t>(head);
+        if (index == kNone) {
+            return ZX_ERR_NOT_FOUND;
+        }
+        // If another thread pops this buffer first, |next| may be stale,
+        // but then the head's count has changed and the exchange fails.
+        uint32_t next = buffers_[index].next.load(fbl::memory_order_relaxed);
+        if (free_head_.compare_exchange_weak(&head, MakeHead(head, next),
+                                             fbl::memory_order_acquire,
+                                             fbl::memory_order_acquire)) {
+            break;
+        }
+    } while (true);
+
+    buffers_[index].acquired.store(true, fbl::memory_order_relaxed);
+    *buffer_index = index;
+    return ZX_OK;
+}
+
+zx_status_t PinnedVmoPool::Release(uint32_t buffer_index) {
+    if (buffer_index >= buffers_.size()) {
+        return ZX_ERR_INVALID_ARGS;
+    }
+    if (!buffers_[buffer_index].acquired.exchange(false, fbl::memory_order_relaxed)) {
+        return ZX_ERR_BAD_STATE;
+    }
+    PushFree(buffer_index);
+    return ZX_OK;
+}
+
+void PinnedVmoPool::PushFree(uint32_t buffer_index) {
+    uint64_t head = free_head_.load(fbl::memory_order_relaxed);
+    do {
+        buffers_[buffer_index].next.store(static_cast<uint32_t>(head),
+                                          fbl::memory_order_relaxed);
+    } while (!free_head_.compare_exchange_weak(&head, MakeHead(head, buffer_index),
+                                               fbl::memory_order_release,
+                                               fbl::memory_order_relaxed));
+}
+
+} // namespace fzl
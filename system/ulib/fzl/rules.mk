@@ -14,6 +14,7 @@ MODULE_SRCS += \
     $(LOCAL_DIR)/memory-probe.cpp \
     $(LOCAL_DIR)/owned-vmo-mapper.cpp \
     $(LOCAL_DIR)/pinned-vmo.cpp \
+    $(LOCAL_DIR)/pinned-vmo-pool.cpp \
     $(LOCAL_DIR)/resizeable-vmo-mapper.cpp \
     $(LOCAL_DIR)/time.cpp \
     $(LOCAL_DIR)/vmar-manager.cpp \
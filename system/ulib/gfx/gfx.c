@@ -215,156 +215,55 @@ void gfx_putchar(gfx_surface* surface, const gfx_font* font, unsigned ch, unsign
     surface->putchar(surface, font, ch, x, y, fg, bg);
 }
 
-static void copyrect8(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height, unsigned x2, unsigned y2) {
-    // copy
-    const uint8_t* src = &((const uint8_t*)surface->ptr)[x + y * surface->stride];
-    uint8_t* dest = &((uint8_t*)surface->ptr)[x2 + y2 * surface->stride];
-    unsigned stride_diff = surface->stride - width;
-
-    if (dest < src) {
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest++;
-                src++;
-            }
-            dest += stride_diff;
-            src += stride_diff;
-        }
-    } else {
-        // copy backwards
-        src += (height-1) * surface->stride + (width-1);
-        dest += (height-1) * surface->stride + (width-1);
-
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest--;
-                src--;
-            }
-            dest -= stride_diff;
-            src -= stride_diff;
-        }
-    }
-}
-
-static void fillrect8(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height, unsigned color) {
-    uint8_t* dest = &((uint8_t*)surface->ptr)[x + y * surface->stride];
-    unsigned stride_diff = surface->stride - width;
-
-    uint8_t color8 = (uint8_t)(surface->translate_color(color));
-
-    unsigned i, j;
-    for (i = 0; i < height; i++) {
-        for (j = 0; j < width; j++) {
-            *dest = color8;
-            dest++;
-        }
-        dest += stride_diff;
-    }
-}
-
-static void copyrect16(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height, unsigned x2, unsigned y2) {
-    // copy
-    const uint16_t* src = &((const uint16_t*)surface->ptr)[x + y * surface->stride];
-    uint16_t* dest = &((uint16_t*)surface->ptr)[x2 + y2 * surface->stride];
-    unsigned stride_diff = surface->stride - width;
-
-    if (dest < src) {
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest++;
-                src++;
-            }
-            dest += stride_diff;
-            src += stride_diff;
-        }
-    } else {
-        // copy backwards
-        src += (height-1) * surface->stride + (width-1);
-        dest += (height-1) * surface->stride + (width-1);
-
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest--;
-                src--;
-            }
-            dest -= stride_diff;
-            src -= stride_diff;
-        }
-    }
-}
-
-static void fillrect16(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height, unsigned color) {
-    uint16_t* dest = &((uint16_t*)surface->ptr)[x + y * surface->stride];
-    unsigned stride_diff = surface->stride - width;
-
-    uint16_t color16 = (uint16_t)(surface->translate_color(color));
-
-    unsigned i, j;
-    for (i = 0; i < height; i++) {
-        for (j = 0; j < width; j++) {
-            *dest = color16;
-            dest++;
-        }
-        dest += stride_diff;
-    }
+// Copy a row at a time with memmove, which handles any overlap within a row
+// and is much faster than copying a pixel at a time.  Walk the rows backwards
+// when moving down so that overlapping rows are read before they are
+// overwritten.
+#define MKCOPYRECT(FUNC,TYPE) \
+static void FUNC(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height, unsigned x2, unsigned y2) { \
+    const TYPE* src = &((const TYPE*)surface->ptr)[x + y * surface->stride]; \
+    TYPE* dest = &((TYPE*)surface->ptr)[x2 + y2 * surface->stride]; \
+    size_t row_bytes = width * sizeof(TYPE); \
+    if (dest < src) { \
+        for (unsigned i = 0; i < height; i++) { \
+            memmove(dest, src, row_bytes); \
+            dest += surface->stride; \
+            src += surface->stride; \
+        } \
+    } else { \
+        src += (height - 1) * surface->stride; \
+        dest += (height - 1) * surface->stride; \
+        for (unsigned i = 0; i < height; i++) { \
+            memmove(dest, src, row_bytes); \
+            dest -= surface->stride; \
+            src -= surface->stride; \
+        } \
+    } \
 }
 
-static void copyrect32(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height, unsigned x2, unsigned y2) {
-    // copy
-    const uint32_t* src = &((const uint32_t*)surface->ptr)[x + y * surface->stride];
-    uint32_t* dest = &((uint32_t*)surface->ptr)[x2 + y2 * surface->stride];
-    unsigned stride_diff = surface->stride - width;
-
-    if (dest < src) {
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest++;
-                src++;
-            }
-            dest += stride_diff;
-            src += stride_diff;
-        }
-    } else {
-        // copy backwards
-        src += (height-1) * surface->stride + (width-1);
-        dest += (height-1) * surface->stride + (width-1);
+MKCOPYRECT(copyrect8, uint8_t)
+MKCOPYRECT(copyrect16, uint16_t)
+MKCOPYRECT(copyrect32, uint32_t)
 
-        unsigned i, j;
-        for (i = 0; i < height; i++) {
-            for (j = 0; j < width; j++) {
-                *dest = *src;
-                dest--;
-                src--;
-            }
-            dest -= stride_diff;
-            src -= stride_diff;
-        }
-    }
+// Fill the first row, then replicate it into the remaining rows.
+#define MKFILLRECT(FUNC,TYPE,COLOR) \
+static void FUNC(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height, unsigned color) { \
+    TYPE* dest = &((TYPE*)surface->ptr)[x + y * surface->stride]; \
+    TYPE c = (TYPE)(COLOR); \
+    for (unsigned j = 0; j < width; j++) { \
+        dest[j] = c; \
+    } \
+    const TYPE* first = dest; \
+    size_t row_bytes = width * sizeof(TYPE); \
+    for (unsigned i = 1; i < height; i++) { \
+        dest += surface->stride; \
+        memcpy(dest, first, row_bytes); \
+    } \
 }
 
-static void fillrect32(gfx_surface* surface, unsigned x, unsigned y, unsigned width, unsigned height, unsigned color) {
-    uint32_t* dest = &((uint32_t*)surface->ptr)[x + y * surface->stride];
-    unsigned stride_diff = surface->stride - width;
-
-    unsigned i, j;
-    for (i = 0; i < height; i++) {
-        for (j = 0; j < width; j++) {
-            *dest = color;
-            dest++;
-        }
-        dest += stride_diff;
-    }
-}
+MKFILLRECT(fillrect8, uint8_t, surface->translate_color(color))
+MKFILLRECT(fillrect16, uint16_t, surface->translate_color(color))
+MKFILLRECT(fillrect32, uint32_t, color)
 
 void gfx_line(gfx_surface* surface, unsigned x1, unsigned y1, unsigned x2, unsigned y2, unsigned color) {
     if (unlikely(x1 >= surface->width))
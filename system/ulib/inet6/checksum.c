@@ -3,19 +3,43 @@
 // found in the LICENSE file.
 
 #include <stdint.h>
+#include <string.h>
 
 #include <inet6/inet6.h>
 
 
+// Ones-complement addition is associative and 2^16 == 1 modulo 0xffff, so the
+// data can be summed as 32-bit words into a wide accumulator and folded down
+// to 16 bits once at the end. Loads go through memcpy since the payload is not
+// necessarily word aligned.
 static uint16_t checksum(const void* _data, size_t len, uint16_t _sum) {
-    uint32_t sum = _sum;
-    const uint16_t* data = _data;
-    while (len > 1) {
-        sum += *data++;
+    uint64_t sum = _sum;
+    const uint8_t* data = _data;
+    while (len >= 16) {
+        uint32_t w[4];
+        memcpy(w, data, sizeof(w));
+        sum += (uint64_t)w[0] + w[1] + w[2] + w[3];
+        data += 16;
+        len -= 16;
+    }
+    while (len >= 4) {
+        uint32_t w;
+        memcpy(&w, data, sizeof(w));
+        sum += w;
+        data += 4;
+        len -= 4;
+    }
+    if (len >= 2) {
+        uint16_t h;
+        memcpy(&h, data, sizeof(h));
+        sum += h;
+        data += 2;
         len -= 2;
     }
     if (len) {
-        sum += (*data & 0xFF);
+        uint16_t h = 0;
+        memcpy(&h, data, 1);
+        sum += h;
     }
     while (sum > 0xFFFF) {
         sum = (sum & 0xFFFF) + (sum >> 16);
@@ -100,6 +100,30 @@ zx_status_t eth_queue_rx(eth_client_t* eth, void* cookie,
     return zx_fifo_write(eth->rx_fifo, sizeof(e), &e, 1, NULL);
 }
 
+zx_status_t eth_queue_rx_batch(eth_client_t* eth, void** cookies, void** data,
+                               size_t count, size_t len, uint32_t options) {
+    zircon_ethernet_FifoEntry entries[count];
+    for (size_t n = 0; n < count; n++) {
+        entries[n].offset = data[n] - eth->iobuf;
+        entries[n].length = len;
+        entries[n].flags = options;
+        entries[n].cookie = (uint64_t)cookies[n];
+        IORING_TRACE("eth:rx+ c=%p o=%u l=%u f=%u\n",
+                     entries[n].cookie, entries[n].offset, entries[n].length, entries[n].flags);
+    }
+    size_t actual = 0;
+    while (actual < count) {
+        size_t written;
+        zx_status_t status = zx_fifo_write(eth->rx_fifo, sizeof(entries[0]), entries + actual,
+                                           count - actual, &written);
+        if (status < 0) {
+            return status;
+        }
+        actual += written;
+    }
+    return ZX_OK;
+}
+
 zx_status_t eth_complete_tx(eth_client_t* eth, void* ctx,
                             void (*func)(void* ctx, void* cookie)) {
     zircon_ethernet_FifoEntry entries[eth->tx_size];
@@ -164,3 +188,26 @@ zx_status_t eth_wait_rx(eth_client_t* eth, zx_time_t deadline) {
     }
     return ZX_OK;
 }
+
+// Busy-poll for completed rx packets
+// ZX_ERR_PEER_CLOSED - far side disconnected
+// ZX_ERR_TIMED_OUT - deadline lapsed without packets
+// ZX_OK - completed packets are available
+zx_status_t eth_spin_rx(eth_client_t* eth, zx_time_t deadline) {
+    do {
+        zx_signals_t signals = 0;
+        zx_status_t status = zx_object_wait_one(eth->rx_fifo,
+                                                ZX_FIFO_READABLE | ZX_FIFO_PEER_CLOSED,
+                                                0, &signals);
+        if (signals & ZX_FIFO_PEER_CLOSED) {
+            return ZX_ERR_PEER_CLOSED;
+        }
+        if (signals & ZX_FIFO_READABLE) {
+            return ZX_OK;
+        }
+        if (status != ZX_ERR_TIMED_OUT) {
+            return status;
+        }
+    } while (zx_clock_get_monotonic() < deadline);
+    return ZX_ERR_TIMED_OUT;
+}
@@ -33,6 +33,11 @@ zx_status_t eth_complete_tx(eth_client_t* eth, void* ctx,
 zx_status_t eth_queue_rx(eth_client_t* eth, void* cookie,
                          void* data, size_t len, uint32_t options);
 
+// Enqueue |count| packets of |len| bytes for reception with as few fifo writes
+// as the fifo allows. Used to return a whole batch of completed rx buffers.
+zx_status_t eth_queue_rx_batch(eth_client_t* eth, void** cookies, void** data,
+                               size_t count, size_t len, uint32_t options);
+
 // Process all received buffers
 zx_status_t eth_complete_rx(eth_client_t* eth, void* ctx,
                             void (*func)(void* ctx, void* cookie, size_t len, uint32_t flags));
@@ -43,4 +48,8 @@ zx_status_t eth_complete_rx(eth_client_t* eth, void* ctx,
 // ZX_OK - completed packets are available
 zx_status_t eth_wait_rx(eth_client_t* eth, zx_time_t deadline);
 
+// Same as eth_wait_rx(), but busy-polls the rx fifo instead of blocking, so
+// that a packet arriving before the deadline is seen without a thread wakeup.
+zx_status_t eth_spin_rx(eth_client_t* eth, zx_time_t deadline);
+
 __END_CDECLS;
@@ -11,6 +11,10 @@ int netifc_open(const char* interface);
 // process inbound packet(s)
 int netifc_poll(void);
 
+// busy-poll the interface for up to us microseconds before blocking for
+// packets in netifc_poll(); 0 (the default) always blocks
+void netifc_set_spin_budget(uint32_t us);
+
 // return nonzero if interface exists
 int netifc_active(void);
 
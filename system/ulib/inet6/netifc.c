@@ -428,11 +428,30 @@ void netifc_close(void) {
     mtx_unlock(&eth_lock);
 }
 
+// rx buffers drained by the current eth_complete_rx() pass, handed back to
+// the driver in one fifo write once the pass is over.
+static void* rx_requeue_cookies[NET_BUFFERS];
+static void* rx_requeue_data[NET_BUFFERS];
+static size_t rx_requeue_count;
+
 static void rx_complete(void* ctx, void* cookie, size_t len, uint32_t flags) {
     eth_buffer_t* ethbuf = cookie;
     check_ethbuf(ethbuf, ETH_BUFFER_RX);
     netifc_recv(ethbuf->data, len);
-    eth_queue_rx(eth, ethbuf, ethbuf->data, NET_BUFFERSZ, 0);
+    if (rx_requeue_count == countof(rx_requeue_cookies)) {
+        eth_queue_rx(eth, ethbuf, ethbuf->data, NET_BUFFERSZ, 0);
+        return;
+    }
+    rx_requeue_cookies[rx_requeue_count] = ethbuf;
+    rx_requeue_data[rx_requeue_count] = ethbuf->data;
+    rx_requeue_count++;
+}
+
+// How long netifc_poll() busy-polls the rx fifo before blocking on it.
+static zx_duration_t rx_spin_budget = 0;
+
+void netifc_set_spin_budget(uint32_t us) {
+    rx_spin_budget = ZX_USEC(us);
 }
 
 int netifc_poll(void) {
@@ -443,6 +462,15 @@ int netifc_poll(void) {
             printf("netifc: eth rx failed: %d\n", status);
             return -1;
         }
+        if (rx_requeue_count > 0) {
+            status = eth_queue_rx_batch(eth, rx_requeue_cookies, rx_requeue_data,
+                                        rx_requeue_count, NET_BUFFERSZ, 0);
+            rx_requeue_count = 0;
+            if (status < 0) {
+                printf("netifc: eth rx requeue failed: %d\n", status);
+                return -1;
+            }
+        }
 
         // Timeout passed
         if (net_timer && zx_clock_get_monotonic() > net_timer) {
@@ -459,6 +487,17 @@ int netifc_poll(void) {
         } else {
             deadline = ZX_TIME_INFINITE;
         }
+        if (rx_spin_budget > 0) {
+            zx_time_t spin_deadline = zx_deadline_after(rx_spin_budget);
+            status = eth_spin_rx(eth, (spin_deadline < deadline) ? spin_deadline : deadline);
+            if (status == ZX_OK) {
+                continue;
+            }
+            if (status != ZX_ERR_TIMED_OUT) {
+                printf("netifc: eth rx spin failed: %d\n", status);
+                return -1;
+            }
+        }
         status = eth_wait_rx(eth, deadline);
         if ((status < 0) && (status != ZX_ERR_TIMED_OUT)) {
             printf("netifc: eth rx wait failed: %d\n", status);
@@ -466,4 +505,3 @@ int netifc_poll(void) {
         }
     }
 }
-
@@ -279,13 +279,21 @@ static int dso_lookup_for_unw(void* context, unw_word_t pc,
     return 1;
 }
 
-static
-void inspector_print_backtrace_impl(FILE* f,
-                                    zx_handle_t process, zx_handle_t thread,
-                                    inspector_dsoinfo_t* dso_list,
-                                    uintptr_t pc, uintptr_t sp, uintptr_t fp,
-                                    bool use_libunwind,
-                                    bool use_new_format) {
+// A frame of a backtrace.
+struct Frame {
+    uintptr_t pc;
+    uintptr_t sp;
+};
+
+// The most frames we print for a backtrace.
+constexpr uint32_t kMaxFrames = 49;
+
+// Unwinds |thread|, starting from |pc|, |sp| and |fp|, and stores up to
+// kMaxFrames frames in |frames|. Returns the number of frames stored.
+static uint32_t unwind_thread(zx_handle_t process, zx_handle_t thread,
+                              inspector_dsoinfo_t* dso_list,
+                              uintptr_t pc, uintptr_t sp, uintptr_t fp,
+                              bool use_libunwind, Frame* frames) {
     // Set up libunwind if requested.
 
     bool libunwind_ok = use_libunwind;
@@ -335,17 +343,11 @@ void inspector_print_backtrace_impl(FILE* f,
     // TODO: Handle libunwind not finding .eh_frame in which case fallback
     // on using heuristics. Ideally this would be handled on a per-DSO basis.
 
-    // Keep a cache of loaded debug info to maintain some performance
-    // without loading debug info for all shared libs.
-    // This won't get used if initializing libunwind failed, but we can still
-    // use |dso_list|.
-    DebugInfoCache di_cache(dso_list, kDebugInfoCacheNumWays);
-
     // On with the show.
 
-    uint32_t n = 1;
-    btprint(f, &di_cache, n++, pc, sp, use_new_format);
-    while ((sp >= 0x1000000) && (n < 50)) {
+    uint32_t n = 0;
+    frames[n++] = {pc, sp};
+    while ((sp >= 0x1000000) && (n < kMaxFrames)) {
         if (libunwind_ok) {
             int ret = unw_step(&cursor);
             if (ret < 0) {
@@ -369,14 +371,27 @@ void inspector_print_backtrace_impl(FILE* f,
                 break;
             }
         }
-        btprint(f, &di_cache, n++, pc, sp, use_new_format);
-    }
-    if (!use_new_format) {
-        fprintf(f, "bt#%02d: end\n", n);
+        frames[n++] = {pc, sp};
     }
 
     unw_destroy_addr_space(remote_as);
     unw_destroy_fuchsia(fuchsia);
+    return n;
+}
+
+static void print_frames(FILE* f, inspector_dsoinfo_t* dso_list,
+                         const Frame* frames, uint32_t count,
+                         bool use_new_format) {
+    // Keep a cache of loaded debug info to maintain some performance
+    // without loading debug info for all shared libs.
+    DebugInfoCache di_cache(dso_list, kDebugInfoCacheNumWays);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        btprint(f, &di_cache, i + 1, frames[i].pc, frames[i].sp, use_new_format);
+    }
+    if (!use_new_format) {
+        fprintf(f, "bt#%02u: end\n", count + 1);
+    }
 }
 
 extern "C"
@@ -385,8 +400,10 @@ void inspector_print_backtrace_markup(FILE* f,
                                       inspector_dsoinfo_t* dso_list,
                                       uintptr_t pc, uintptr_t sp, uintptr_t fp,
                                       bool use_libunwind) {
-    inspector_print_backtrace_impl(f, process, thread, dso_list, pc, sp, fp,
-                                  use_libunwind, true);
+    Frame frames[kMaxFrames];
+    uint32_t count = unwind_thread(process, thread, dso_list, pc, sp, fp,
+                                   use_libunwind, frames);
+    print_frames(f, dso_list, frames, count, true);
 }
 
 extern "C"
@@ -395,8 +412,23 @@ void inspector_print_backtrace(FILE* f,
                                inspector_dsoinfo_t* dso_list,
                                uintptr_t pc, uintptr_t sp, uintptr_t fp,
                                bool use_libunwind) {
-    inspector_print_backtrace_impl(f, process, thread, dso_list, pc, sp, fp,
-                                  use_libunwind, false);
+    Frame frames[kMaxFrames];
+    uint32_t count = unwind_thread(process, thread, dso_list, pc, sp, fp,
+                                   use_libunwind, frames);
+    print_frames(f, dso_list, frames, count, false);
+}
+
+extern "C"
+void inspector_print_backtraces(FILE* f,
+                                zx_handle_t process, zx_handle_t thread,
+                                inspector_dsoinfo_t* dso_list,
+                                uintptr_t pc, uintptr_t sp, uintptr_t fp,
+                                bool use_libunwind) {
+    Frame frames[kMaxFrames];
+    uint32_t count = unwind_thread(process, thread, dso_list, pc, sp, fp,
+                                   use_libunwind, frames);
+    print_frames(f, dso_list, frames, count, false);
+    print_frames(f, dso_list, frames, count, true);
 }
 
 }  // namespace inspector
@@ -53,6 +53,16 @@ extern void inspector_print_backtrace(FILE* f,
                                       uintptr_t pc, uintptr_t sp, uintptr_t fp,
                                       bool use_libunwind);
 
+// Print a backtrace of |thread| to |f| in both of the formats above: first
+// the one read by zircon/scripts/symbolize, then the symbolizer markup.
+// This is cheaper than calling both functions, since |thread| is only
+// unwound once.
+extern void inspector_print_backtraces(FILE* f,
+                                       zx_handle_t process, zx_handle_t thread,
+                                       inspector_dsoinfo_t* dso_list,
+                                       uintptr_t pc, uintptr_t sp, uintptr_t fp,
+                                       bool use_libunwind);
+
 // Fetch the list of the DSOs of |process|.
 // |name| is the name of the application binary.
 extern inspector_dsoinfo_t* inspector_dso_fetch_list(zx_handle_t process);
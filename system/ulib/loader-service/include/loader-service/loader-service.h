@@ -33,14 +33,14 @@ typedef struct loader_service loader_service_t;
 // any number of clients.
 //
 // Requests will be processed on the given |async|. If |async| is NULL, this
-// library will create a new thread and listen for requests on that thread.
+// library will create a few new threads and listen for requests on them.
 zx_status_t loader_service_create_fs(async_dispatcher_t* dispatcher, loader_service_t** out);
 
 // Create a new file-descriptor backed loader service capable of handling any
 // number of clients.
 //
 // Requests will be processed on the given |async|. If |async| is NULL, this
-// library will create a new thread and listen for requests on that thread.
+// library will create a few new threads and listen for requests on them.
 // Paths and objects will be loaded relative to |root_dir_fd| and data will be
 // published relative to |data_sink_dir_fd|; the two file descriptors
 // are consumed on success.
@@ -17,6 +17,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <threads.h>
 #include <unistd.h>
 #include <zircon/compiler.h>
 #include <zircon/device/vfs.h>
@@ -26,6 +27,31 @@
 
 #define PREFIX_MAX 32
 
+// The most objects an instance keeps in its cache.
+#define CACHE_MAX 128
+
+// The number of threads the default implementation serves requests on when
+// it creates its own dispatcher. Requests mostly wait on the filesystem, so
+// a few threads let launches of unrelated processes proceed concurrently.
+#define DEFAULT_THREAD_COUNT 4
+
+// An object loaded from a path whose contents can never change, and the VMO
+// that every later load of that path is given a handle to. The VMO is never
+// written to: processes map it read-only and make their own copy-on-write
+// clones for writable segments.
+typedef struct cache_entry cache_entry_t;
+struct cache_entry {
+    cache_entry_t* next;
+    // ZX_HANDLE_INVALID if there is no file at |path|.
+    zx_handle_t vmo;
+    char path[];
+};
+
+// The rights of the handles that cached VMOs are handed out with.
+#define CACHE_VMO_RIGHTS (ZX_RIGHT_DUPLICATE | ZX_RIGHT_TRANSFER | ZX_RIGHT_READ | \
+                          ZX_RIGHT_EXECUTE | ZX_RIGHT_MAP | ZX_RIGHT_GET_PROPERTY | \
+                          ZX_RIGHT_INSPECT | ZX_RIGHT_WAIT)
+
 // State of a loader service instance.
 typedef struct instance_state instance_state_t;
 struct instance_state {
@@ -33,6 +59,12 @@ struct instance_state {
   int data_sink_dir_fd;
   // NULL-terminated list of paths from which objects will loaded.
   const char* const* lib_paths;
+  // Objects loaded from under this path, relative to |root_dir_fd|, are
+  // cached. NULL if nothing is known to be immutable.
+  const char* immutable_prefix;
+  mtx_t cache_lock;
+  cache_entry_t* cache;
+  size_t cache_count;
 };
 
 // This represents an instance of the loader service. Each session in an
@@ -67,21 +99,6 @@ static void loader_service_deref(loader_service_t* svc) {
     }
 }
 
-// When loading a library object, search in the locations provided in
-// |lib_paths|, which is required to be NULL-terminated.
-static int open_from_lib_paths(int root_dir_fd, const char* const* lib_paths,
-                               const char* fn) {
-    int fd = -1;
-    for (size_t n = 0; fd < 0 && lib_paths[n]; ++n) {
-        char path[PATH_MAX];
-        if (snprintf(path, sizeof(path), "%s/%s", lib_paths[n], fn) < 0) {
-            return -1;
-        }
-        fd = openat(root_dir_fd, path, O_RDONLY);
-    }
-    return fd;
-}
-
 // Always consumes the |fd|.
 static zx_handle_t vmo_from_fd(int fd, const char* fn, zx_handle_t* out) {
     zx_status_t status = fdio_get_vmo_clone(fd, out);
@@ -92,13 +109,134 @@ static zx_handle_t vmo_from_fd(int fd, const char* fn, zx_handle_t* out) {
     return status;
 }
 
+static bool cacheable(const instance_state_t* state, const char* path) {
+    return state->immutable_prefix != NULL &&
+        strncmp(path, state->immutable_prefix, strlen(state->immutable_prefix)) == 0;
+}
+
+// Returns ZX_ERR_NOT_FOUND if |path| is known not to exist, and
+// ZX_ERR_NEXT if it is not in the cache.
+static zx_status_t cache_lookup(instance_state_t* state, const char* path,
+                                zx_handle_t* out) {
+    zx_status_t status = ZX_ERR_NEXT;
+    mtx_lock(&state->cache_lock);
+    for (cache_entry_t* entry = state->cache; entry != NULL; entry = entry->next) {
+        if (strcmp(entry->path, path) == 0) {
+            if (entry->vmo == ZX_HANDLE_INVALID) {
+                status = ZX_ERR_NOT_FOUND;
+            } else {
+                status = zx_handle_duplicate(entry->vmo, CACHE_VMO_RIGHTS, out);
+            }
+            break;
+        }
+    }
+    mtx_unlock(&state->cache_lock);
+    return status;
+}
+
+// Adds an entry for |path| holding |vmo|, which is consumed. Does nothing
+// if the cache is full or already has an entry for |path|.
+static void cache_add(instance_state_t* state, const char* path, zx_handle_t vmo) {
+    size_t len = strlen(path) + 1;
+    cache_entry_t* entry = malloc(sizeof(*entry) + len);
+    if (entry == NULL) {
+        zx_handle_close(vmo);
+        return;
+    }
+    memcpy(entry->path, path, len);
+    entry->vmo = vmo;
+
+    mtx_lock(&state->cache_lock);
+    // Another request may have raced us here; keep the first one.
+    cache_entry_t* existing = state->cache;
+    while (existing != NULL && strcmp(existing->path, path) != 0) {
+        existing = existing->next;
+    }
+    if (existing == NULL && state->cache_count < CACHE_MAX) {
+        entry->next = state->cache;
+        state->cache = entry;
+        state->cache_count++;
+        entry = NULL;
+    }
+    mtx_unlock(&state->cache_lock);
+
+    if (entry != NULL) {
+        zx_handle_close(entry->vmo);
+        free(entry);
+    }
+}
+
+// Remembers |vmo| as the contents of |path|, and replaces it with a handle
+// with the rights that all users of the cached VMO get.
+static zx_status_t cache_insert(instance_state_t* state, const char* path,
+                                zx_handle_t* vmo) {
+    zx_status_t status = zx_handle_replace(*vmo, CACHE_VMO_RIGHTS, vmo);
+    if (status != ZX_OK) {
+        *vmo = ZX_HANDLE_INVALID;
+        return status;
+    }
+
+    zx_handle_t dup;
+    if (zx_handle_duplicate(*vmo, ZX_RIGHT_SAME_RIGHTS, &dup) == ZX_OK) {
+        cache_add(state, path, dup);
+    }
+    return ZX_OK;
+}
+
+static void cache_free(instance_state_t* state) {
+    cache_entry_t* entry = state->cache;
+    while (entry != NULL) {
+        cache_entry_t* next = entry->next;
+        zx_handle_close(entry->vmo);
+        free(entry);
+        entry = next;
+    }
+    state->cache = NULL;
+    state->cache_count = 0;
+}
+
+// Load |path|, relative to the root of |state|, from the cache if possible.
+// Returns ZX_ERR_NOT_FOUND if there is no such file.
+static zx_status_t load_path(instance_state_t* state, const char* path,
+                             const char* name, zx_handle_t* out) {
+    bool cache = cacheable(state, path);
+    if (cache) {
+        zx_status_t status = cache_lookup(state, path, out);
+        if (status != ZX_ERR_NEXT) {
+            return status;
+        }
+    }
+
+    int fd = openat(state->root_dir_fd, path, O_RDONLY);
+    if (fd < 0) {
+        // Files never appear under an immutable prefix either, so later
+        // searches through this path can skip the open.
+        if (cache && errno == ENOENT) {
+            cache_add(state, path, ZX_HANDLE_INVALID);
+        }
+        return ZX_ERR_NOT_FOUND;
+    }
+    zx_status_t status = vmo_from_fd(fd, name, out);
+    if (status == ZX_OK && cache) {
+        status = cache_insert(state, path, out);
+    }
+    return status;
+}
+
+// When loading a library object, search in the locations provided in
+// |lib_paths|, which is required to be NULL-terminated.
 static zx_status_t fd_load_object(void* ctx, const char* name, zx_handle_t* out) {
-    int root_dir_fd = ((instance_state_t*)ctx)->root_dir_fd;
-    const char* const* lib_paths = ((instance_state_t*)ctx)->lib_paths;
+    instance_state_t* state = (instance_state_t*)ctx;
 
-    int fd = open_from_lib_paths(root_dir_fd, lib_paths, name);
-    if (fd >= 0) {
-        return vmo_from_fd(fd, name, out);
+    for (size_t n = 0; state->lib_paths[n]; ++n) {
+        char path[PATH_MAX];
+        if (snprintf(path, sizeof(path), "%s/%s", state->lib_paths[n], name) < 0) {
+            return ZX_ERR_NOT_FOUND;
+        }
+        zx_status_t status = load_path(state, path, name, out);
+        if (status != ZX_ERR_NOT_FOUND) {
+            return status;
+        }
     }
     return ZX_ERR_NOT_FOUND;
 }
@@ -123,6 +261,8 @@ void fd_finalizer(void* ctx) {
     int data_sink_dir_fd = instance_state->data_sink_dir_fd;
     close(root_dir_fd);
     close(data_sink_dir_fd);
+    cache_free(instance_state);
+    mtx_destroy(&instance_state->cache_lock);
     free(instance_state);
 }
 
@@ -249,10 +389,14 @@ static zx_status_t loader_service_rpc(zx_handle_t h, session_state_t* session_st
     return ZX_OK;
 }
 
-zx_status_t loader_service_create(async_dispatcher_t* dispatcher,
-                                  const loader_service_ops_t* ops,
-                                  void* ctx,
-                                  loader_service_t** out) {
+// Like loader_service_create, but if |dispatcher| is NULL, requests are
+// served on |thread_count| threads. The |ops| must then be safe to call
+// from several threads at once.
+static zx_status_t loader_service_create_etc(async_dispatcher_t* dispatcher,
+                                             const loader_service_ops_t* ops,
+                                             void* ctx,
+                                             size_t thread_count,
+                                             loader_service_t** out) {
     if (out == NULL || ops == NULL) {
         return ZX_ERR_INVALID_ARGS;
     }
@@ -276,6 +420,13 @@ zx_status_t loader_service_create(async_dispatcher_t* dispatcher,
             async_loop_destroy(loop);
             return status;
         }
+        // Extra threads are only an optimization, so carry on without any
+        // that fail to start.
+        for (size_t i = 1; i < thread_count; i++) {
+            if (async_loop_start_thread(loop, "loader-service", NULL) != ZX_OK) {
+                break;
+            }
+        }
 
         dispatcher = async_loop_get_dispatcher(loop);
     }
@@ -294,10 +445,20 @@ zx_status_t loader_service_create(async_dispatcher_t* dispatcher,
     return ZX_OK;
 }
 
+zx_status_t loader_service_create(async_dispatcher_t* dispatcher,
+                                  const loader_service_ops_t* ops,
+                                  void* ctx,
+                                  loader_service_t** out) {
+    return loader_service_create_etc(dispatcher, ops, ctx, 1, out);
+}
+
 // Default library paths for the fd- and fs- loader service implementations.
 static const char* const fd_lib_paths[] = {"lib", NULL};
 static const char* const fs_lib_paths[] = {"system/lib", "boot/lib", NULL};
 
+// Everything under /boot comes from the read-only bootfs image.
+static const char fs_immutable_prefix[] = "boot/";
+
 // Create the default implementation of a loader service for which
 // paths are loaded relative to |root_dir_fd| and among the array of
 // subdirectories given by |lib_paths| (NULL-terminated), with data published
@@ -306,21 +467,28 @@ zx_status_t loader_service_create_default(async_dispatcher_t* dispatcher,
                                           int root_dir_fd,
                                           int data_sink_dir_fd,
                                           const char* const* lib_paths,
+                                          const char* immutable_prefix,
                                           loader_service_t** out) {
-    instance_state_t* instance_state = calloc(1, sizeof(loader_service_t));
+    instance_state_t* instance_state = calloc(1, sizeof(instance_state_t));
     if (instance_state == NULL) {
         return ZX_ERR_NO_MEMORY;
     }
     instance_state->root_dir_fd = root_dir_fd;
     instance_state->data_sink_dir_fd = data_sink_dir_fd;
     instance_state->lib_paths = lib_paths? lib_paths : fd_lib_paths;
+    instance_state->immutable_prefix = immutable_prefix;
+    mtx_init(&instance_state->cache_lock, mtx_plain);
 
     loader_service_t* svc;
-    zx_status_t status = loader_service_create(dispatcher, &fd_ops, NULL, &svc);
+    // The cache is locked and the rest of the instance state is read-only,
+    // so the default ops can serve several requests at once.
+    zx_status_t status = loader_service_create_etc(dispatcher, &fd_ops, NULL,
+                                                   DEFAULT_THREAD_COUNT, &svc);
     if (status == ZX_OK) {
       svc->ctx = instance_state;
       *out = svc;
     } else {
+      mtx_destroy(&instance_state->cache_lock);
       free(instance_state);
     }
     return status;
@@ -332,7 +500,7 @@ zx_status_t loader_service_create_fs(async_dispatcher_t* dispatcher, loader_serv
       return ZX_ERR_NOT_FOUND;
     }
     return loader_service_create_default(dispatcher, root_dir_fd, -1, fs_lib_paths,
-                                         out);
+                                         fs_immutable_prefix, out);
 }
 
 zx_status_t loader_service_create_fd(async_dispatcher_t* dispatcher,
@@ -340,7 +508,7 @@ zx_status_t loader_service_create_fd(async_dispatcher_t* dispatcher,
                                      int data_sink_dir_fd,
                                      loader_service_t** out) {
     return loader_service_create_default(dispatcher, root_dir_fd, data_sink_dir_fd,
-                                         fd_lib_paths, out);
+                                         fd_lib_paths, NULL, out);
 }
 
 zx_status_t loader_service_release(loader_service_t* svc) {
@@ -31,6 +31,13 @@ namespace lockdep {
 #define LOCK_DEP_ENABLE_VALIDATION 0
 #endif
 
+// Configures whether lock contention profiling is enabled or not. Defaults to
+// disabled. Profiling attributes wait and hold times to lock classes and so
+// requires lock validation to be enabled as well.
+#ifndef LOCK_DEP_ENABLE_PROFILING
+#define LOCK_DEP_ENABLE_PROFILING 0
+#endif
+
 // Id type used to identify each lock class.
 using LockClassId = uintptr_t;
 
@@ -82,6 +89,19 @@ using IfLockValidationEnabled = typename fbl::conditional<kLockValidationEnabled
                                                           EnabledType,
                                                           DisabledType>::type;
 
+// Whether or not lock contention profiling is globally enabled.
+constexpr bool kLockProfilingEnabled = static_cast<bool>(LOCK_DEP_ENABLE_PROFILING);
+
+static_assert(!kLockProfilingEnabled || kLockValidationEnabled,
+              "Lock profiling requires lock validation to be enabled!");
+
+// Utility template alias to simplify selecting different types based whether
+// lock profiling is enabled or disabled.
+template <typename EnabledType, typename DisabledType>
+using IfLockProfilingEnabled = typename fbl::conditional<kLockProfilingEnabled,
+                                                          EnabledType,
+                                                          DisabledType>::type;
+
 // Result type that represents whether a lock attempt was successful, or if not
 // which check failed.
 enum class LockResult : uint8_t {
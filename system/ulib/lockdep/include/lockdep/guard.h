@@ -98,6 +98,7 @@ public:
     template <typename... Args>
     void Release(Args&&... args) __TA_RELEASE() {
         if (lock_ != nullptr) {
+            profiler_.Release(validator_.id());
             LockPolicy<LockType, Option>::Release(lock_, &state_,
                                                   fbl::forward<Args>(args)...);
             validator_.ValidateRelease();
@@ -136,7 +137,9 @@ public:
     //
     Guard(AdoptLockTag, Guard&& other) __TA_ACQUIRE(other.lock_)
         : validator_{fbl::move(other.validator_)}, lock_{other.lock_},
-          state_{fbl::move(other.state_)} { other.lock_ = nullptr; }
+          state_{fbl::move(other.state_)}, profiler_{other.profiler_} {
+        other.lock_ = nullptr;
+    }
 
     // Temporarily releases and un-tracks the guarded lock before executing the
     // given callable Op and then re-acquires and tracks the lock. This permits
@@ -158,6 +161,7 @@ public:
         __TA_NO_THREAD_SAFETY_ANALYSIS {
         ZX_DEBUG_ASSERT(lock_ != nullptr);
 
+        profiler_.Release(validator_.id());
         LockPolicy<LockType, Option>::Release(
             lock_, &state_, fbl::forward<ReleaseArgs>(release_args)...);
         validator_.ValidateRelease();
@@ -179,9 +183,12 @@ private:
     // body.
     void ValidateAndAcquire() __TA_NO_THREAD_SAFETY_ANALYSIS {
         validator_.ValidateAcquire();
+        profiler_.BeginAcquire();
         if (!LockPolicy<LockType, Option>::Acquire(lock_, &state_)) {
             lock_ = nullptr;
             validator_.ValidateRelease();
+        } else {
+            profiler_.EndAcquire(validator_.id());
         }
     }
 
@@ -207,6 +214,7 @@ private:
         void ValidateRelease() {
             ThreadLockState::Get()->Release(&lock_entry);
         }
+        LockClassId id() const { return lock_entry.id(); }
 
         AcquiredLockEntry lock_entry;
     };
@@ -216,11 +224,49 @@ private:
         DummyValidator(LockClassId, uintptr_t = 0) {}
         void ValidateAcquire() {}
         void ValidateRelease() {}
+        LockClassId id() const { return kInvalidLockClassId; }
     };
 
     // Alias of the configured validator.
     using Validator = IfLockValidationEnabled<LockValidator, DummyValidator>;
 
+    // Profiler type used when lock profiling is enabled. Measures the time
+    // spent waiting for and holding the lock and charges it to the lock class.
+    // Contention is reported by the lock primitive through
+    // ThreadLockState::NoteContention() while the acquisition is in progress.
+    struct LockProfiler {
+        void BeginAcquire() {
+            ThreadLockState::Get()->TakeContention();
+            timestamp = SystemGetLockProfileTimestamp();
+        }
+        void EndAcquire(LockClassId id) {
+            const uint64_t now = SystemGetLockProfileTimestamp();
+            const uint64_t wait_ns = now - timestamp;
+            const bool contended = ThreadLockState::Get()->TakeContention();
+            LockClassState::Get(id)->profile().RecordAcquire(wait_ns, contended);
+            if (contended)
+                SystemLockContended(id, wait_ns);
+            timestamp = now;
+        }
+        void Release(LockClassId id) {
+            const uint64_t hold_ns = SystemGetLockProfileTimestamp() - timestamp;
+            LockClassState::Get(id)->profile().RecordRelease(hold_ns);
+        }
+
+        // The start of the wait before acquisition, then of the hold after.
+        uint64_t timestamp{0};
+    };
+
+    // Profiler type used when lock profiling is disabled.
+    struct DummyProfiler {
+        void BeginAcquire() {}
+        void EndAcquire(LockClassId) {}
+        void Release(LockClassId) {}
+    };
+
+    // Alias of the configured profiler.
+    using Profiler = IfLockProfilingEnabled<LockProfiler, DummyProfiler>;
+
     // The validator to use when acquiring and releasing the lock.
     Validator validator_;
 
@@ -230,6 +276,9 @@ private:
     // State to store in the guard as specified by the lock policy. For example,
     // this may be used to save IRQ state for spinlocks.
     typename LockPolicy<LockType, Option>::State state_;
+
+    // Timing state for lock profiling, when enabled.
+    Profiler profiler_;
 };
 
 } // namespace lockdep
@@ -17,6 +17,93 @@
 
 namespace lockdep {
 
+// Number of log2 histogram buckets kept for lock wait and hold times. Bucket 0
+// counts times below 256ns, bucket i counts times in [2^(7+i), 2^(8+i))ns and
+// the last bucket counts everything from 2^22ns (about 4ms) up.
+constexpr size_t kLockProfileBuckets = 16;
+
+// Per-lock class contention statistics, updated by Guard when lock profiling is
+// enabled. Counters are updated with relaxed atomics: each value is consistent
+// on its own but a set of values read together is not a snapshot.
+class LockClassProfile {
+public:
+    // Records a completed acquisition that waited |wait_ns| for the lock.
+    void RecordAcquire(uint64_t wait_ns, bool contended) {
+        acquisitions_.fetch_add(1, fbl::memory_order_relaxed);
+        if (contended)
+            contentions_.fetch_add(1, fbl::memory_order_relaxed);
+        total_wait_ns_.fetch_add(wait_ns, fbl::memory_order_relaxed);
+        UpdateMax(&max_wait_ns_, wait_ns);
+        wait_histogram_[BucketIndex(wait_ns)].fetch_add(1, fbl::memory_order_relaxed);
+    }
+
+    // Records a release after the lock was held for |hold_ns|.
+    void RecordRelease(uint64_t hold_ns) {
+        total_hold_ns_.fetch_add(hold_ns, fbl::memory_order_relaxed);
+        UpdateMax(&max_hold_ns_, hold_ns);
+        hold_histogram_[BucketIndex(hold_ns)].fetch_add(1, fbl::memory_order_relaxed);
+    }
+
+    uint64_t acquisitions() const { return Load(acquisitions_); }
+    uint64_t contentions() const { return Load(contentions_); }
+    uint64_t total_wait_ns() const { return Load(total_wait_ns_); }
+    uint64_t max_wait_ns() const { return Load(max_wait_ns_); }
+    uint64_t total_hold_ns() const { return Load(total_hold_ns_); }
+    uint64_t max_hold_ns() const { return Load(max_hold_ns_); }
+    uint64_t wait_histogram(size_t bucket) const { return Load(wait_histogram_[bucket]); }
+    uint64_t hold_histogram(size_t bucket) const { return Load(hold_histogram_[bucket]); }
+
+    // Clears all of the counters.
+    void Reset() {
+        acquisitions_.store(0, fbl::memory_order_relaxed);
+        contentions_.store(0, fbl::memory_order_relaxed);
+        total_wait_ns_.store(0, fbl::memory_order_relaxed);
+        max_wait_ns_.store(0, fbl::memory_order_relaxed);
+        total_hold_ns_.store(0, fbl::memory_order_relaxed);
+        max_hold_ns_.store(0, fbl::memory_order_relaxed);
+        for (size_t i = 0; i < kLockProfileBuckets; i++) {
+            wait_histogram_[i].store(0, fbl::memory_order_relaxed);
+            hold_histogram_[i].store(0, fbl::memory_order_relaxed);
+        }
+    }
+
+    // Returns the histogram bucket for the given time in nanoseconds.
+    static size_t BucketIndex(uint64_t ns) {
+        if (ns < (1u << 8))
+            return 0;
+        const size_t log2 = 63 - __builtin_clzll(ns);
+        return fbl::min(log2 - 7, kLockProfileBuckets - 1);
+    }
+
+private:
+    static uint64_t Load(const fbl::atomic<uint64_t>& value) {
+        return value.load(fbl::memory_order_relaxed);
+    }
+
+    static void UpdateMax(fbl::atomic<uint64_t>* max, uint64_t value) {
+        uint64_t current = max->load(fbl::memory_order_relaxed);
+        while (value > current &&
+               !max->compare_exchange_weak(&current, value,
+                                           fbl::memory_order_relaxed,
+                                           fbl::memory_order_relaxed)) {
+        }
+    }
+
+    fbl::atomic<uint64_t> acquisitions_{0};
+    fbl::atomic<uint64_t> contentions_{0};
+    fbl::atomic<uint64_t> total_wait_ns_{0};
+    fbl::atomic<uint64_t> max_wait_ns_{0};
+    fbl::atomic<uint64_t> total_hold_ns_{0};
+    fbl::atomic<uint64_t> max_hold_ns_{0};
+    fbl::atomic<uint64_t> wait_histogram_[kLockProfileBuckets]{};
+    fbl::atomic<uint64_t> hold_histogram_[kLockProfileBuckets]{};
+};
+
+// Empty stand-in for LockClassProfile when lock profiling is disabled.
+struct DummyLockClassProfile {
+    void Reset() {}
+};
+
 // Type that holds the essential information and state for a lock class. This is
 // used by ThreadLockState to uniformly operate on the variety of lock classes
 // created by each template instantiation of LockClass. Each template
@@ -130,6 +217,13 @@ public:
     // Returns the dependency set for this lock class.
     const LockDependencySet& dependency_set() const { return *dependency_set_; }
 
+    // Alias of the configured per-lock class profile type.
+    using Profile = IfLockProfilingEnabled<LockClassProfile, DummyLockClassProfile>;
+
+    // Returns the contention profile for this lock class.
+    Profile& profile() { return profile_; }
+    const Profile& profile() const { return profile_; }
+
     LockClassState* connected_set() { return LoopDetector::FindSet(&loop_node_)->ToState(); }
 
     // Runs a loop detection pass on the set of lock classes to find possible
@@ -147,6 +241,7 @@ public:
     void Reset() {
         dependency_set_->clear();
         loop_node_.Reset();
+        profile_.Reset();
     }
 
 private:
@@ -231,6 +326,9 @@ private:
     // Loop detector node.
     LoopNode loop_node_;
 
+    // Contention statistics for this lock class.
+    Profile profile_;
+
     // Loop detection using Tarjan's strongly connected components algorithm to
     // efficiently identify loops and disjoint set structures to store and
     // update the sets of nodes involved in loops.
@@ -54,4 +54,15 @@ extern void SystemInitThreadLockState(ThreadLockState* state);
 // given time interval.
 extern void SystemTriggerLoopDetection();
 
+// The following hooks are only required when lock profiling is enabled.
+
+// System-defined hook that returns a monotonic timestamp in nanoseconds used to
+// measure lock wait and hold times.
+extern uint64_t SystemGetLockProfileTimestamp();
+
+// System-defined hook called after a contended acquisition of a lock of the
+// given class completes, with the time spent waiting for the lock. Systems may
+// use this to emit trace events.
+extern void SystemLockContended(uintptr_t lock_class_id, uint64_t wait_time_ns);
+
 } // namespace lockdep
@@ -150,6 +150,18 @@ public:
 
     bool reporting_disabled() const { return reporting_disabled_count_ > 0; }
 
+    // Records that the lock acquisition in progress had to wait for another
+    // owner. Called by the system's lock primitives when lock profiling is
+    // enabled and consumed by the Guard performing the acquisition.
+    void NoteContention() { contended_ = true; }
+
+    // Returns whether contention was noted since the last call and clears it.
+    bool TakeContention() {
+        const bool contended = contended_;
+        contended_ = false;
+        return contended;
+    }
+
 private:
     friend ThreadLockState* SystemGetThreadLockState();
     friend void SystemInitThreadLockState(ThreadLockState*);
@@ -219,6 +231,9 @@ private:
 
     // Tracks the result of the last Acquire operation for testing.
     LockResult last_result_{LockResult::Success};
+
+    // Set by NoteContention() while a profiled acquisition is in progress.
+    bool contended_{false};
 };
 
 // Defined after ThreadLockState because of dependency on its methods.
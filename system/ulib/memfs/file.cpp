@@ -12,6 +12,7 @@
 #include <fbl/algorithm.h>
 #include <fbl/alloc_checker.h>
 #include <fbl/atomic.h>
+#include <fbl/auto_lock.h>
 #include <fbl/ref_ptr.h>
 #include <fbl/unique_ptr.h>
 #include <lib/fdio/vfs.h>
@@ -26,6 +27,10 @@ namespace memfs {
 // Artificially cap the maximum in-memory file size to 512MB.
 constexpr size_t kMemfsMaxFileSize = 512 * 1024 * 1024;
 
+// Files extended by writes grow their VMO geometrically, by at most this much
+// at a time, so that sequential writes don't resize it on every page.
+constexpr size_t kMemfsMaxGrowth = 16 * 1024 * 1024;
+
 VnodeFile::VnodeFile(Vfs* vfs)
     : VnodeMemfs(vfs), vmo_size_(0), length_(0)  {}
 
@@ -41,6 +46,7 @@ zx_status_t VnodeFile::ValidateFlags(uint32_t flags) {
 }
 
 zx_status_t VnodeFile::Read(void* data, size_t len, size_t off, size_t* out_actual) {
+    fbl::AutoLock lock(&lock_);
     if ((off >= length_) || (!vmo_.is_valid())) {
         *out_actual = 0;
         return ZX_OK;
@@ -55,13 +61,37 @@ zx_status_t VnodeFile::Read(void* data, size_t len, size_t off, size_t* out_actu
     return status;
 }
 
+bool VnodeFile::SupportsConcurrentReads() const {
+    // The state of the file is guarded by |lock_|.
+    return true;
+}
+
+bool VnodeFile::SupportsConcurrentWrites() const {
+    return true;
+}
+
 zx_status_t VnodeFile::Write(const void* data, size_t len, size_t offset,
                              size_t* out_actual) {
+    fbl::AutoLock lock(&lock_);
+    return WriteLocked(data, len, offset, out_actual);
+}
+
+zx_status_t VnodeFile::WriteLocked(const void* data, size_t len, size_t offset,
+                                   size_t* out_actual) {
     zx_status_t status;
     size_t newlen = offset + len;
     newlen = newlen > kMemfsMaxFileSize ? kMemfsMaxFileSize : newlen;
-    if ((status = vfs()->GrowVMO(vmo_, vmo_size_, newlen, &vmo_size_)) != ZX_OK) {
-        return status;
+    if (newlen > vmo_size_) {
+        // Reserve room for the writes which are likely to follow, if the page
+        // limit allows it.
+        size_t capacity = fbl::min(vmo_size_ + fbl::min(vmo_size_, kMemfsMaxGrowth),
+                                   kMemfsMaxFileSize);
+        if (capacity <= newlen ||
+            vfs()->GrowVMO(vmo_, vmo_size_, capacity, &vmo_size_) != ZX_OK) {
+            if ((status = vfs()->GrowVMO(vmo_, vmo_size_, newlen, &vmo_size_)) != ZX_OK) {
+                return status;
+            }
+        }
     }
     // Accessing beyond the end of the file? Extend it.
     if (offset > length_) {
@@ -88,12 +118,14 @@ zx_status_t VnodeFile::Write(const void* data, size_t len, size_t offset,
 
 zx_status_t VnodeFile::Append(const void* data, size_t len, size_t* out_end,
                               size_t* out_actual) {
-    zx_status_t status = Write(data, len, length_, out_actual);
+    fbl::AutoLock lock(&lock_);
+    zx_status_t status = WriteLocked(data, len, length_, out_actual);
     *out_end = length_;
     return status;
 }
 
 zx_status_t VnodeFile::GetVmo(int flags, zx_handle_t* out) {
+    fbl::AutoLock lock(&lock_);
     zx_status_t status;
     if (!vmo_.is_valid()) {
         // First access to the file? Allocate it.
@@ -129,6 +161,7 @@ zx_status_t VnodeFile::GetVmo(int flags, zx_handle_t* out) {
 }
 
 zx_status_t VnodeFile::Getattr(vnattr_t* attr) {
+    fbl::AutoLock lock(&lock_);
     memset(attr, 0, sizeof(vnattr_t));
     attr->inode = ino_;
     attr->mode = V_TYPE_FILE | V_IRUSR | V_IWUSR | V_IRGRP | V_IROTH;
@@ -152,6 +185,7 @@ zx_status_t VnodeFile::Truncate(size_t len) {
     if (len > kMemfsMaxFileSize) {
         return ZX_ERR_INVALID_ARGS;
     }
+    fbl::AutoLock lock(&lock_);
     if ((status = vfs()->GrowVMO(vmo_, vmo_size_, len, &vmo_size_)) != ZX_OK) {
         return status;
     }
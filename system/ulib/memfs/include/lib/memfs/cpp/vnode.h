@@ -18,7 +18,9 @@
 #include <fs/vfs.h>
 #include <fs/vnode.h>
 #include <fbl/atomic.h>
+#include <fbl/auto_lock.h>
 #include <fbl/intrusive_double_list.h>
+#include <fbl/mutex.h>
 #include <fbl/ref_ptr.h>
 #include <fbl/unique_ptr.h>
 #include <fs/remote.h>
@@ -81,6 +83,8 @@ public:
 
 private:
     zx_status_t Read(void* data, size_t len, size_t off, size_t* out_actual) final;
+    bool SupportsConcurrentReads() const final;
+    bool SupportsConcurrentWrites() const final;
     zx_status_t Write(const void* data, size_t len, size_t offset,
                       size_t* out_actual) final;
     zx_status_t Append(const void* data, size_t len, size_t* out_end,
@@ -91,15 +95,21 @@ private:
                            zxrio_node_info_t* extra) final;
     zx_status_t GetVmo(int flags, zx_handle_t* out) final;
 
+    zx_status_t WriteLocked(const void* data, size_t len, size_t offset,
+                            size_t* out_actual) __TA_REQUIRES(lock_);
+
     // Ensure the underlying vmo is filled with zero from:
     // [start, round_up(end, PAGE_SIZE)).
-    void ZeroTail(size_t start, size_t end);
+    void ZeroTail(size_t start, size_t end) __TA_REQUIRES(lock_);
 
-    zx::vmo vmo_;
+    // Serializes the data operations on this file, which may be dispatched
+    // concurrently with each other.
+    mutable fbl::Mutex lock_;
+    zx::vmo vmo_ __TA_GUARDED(lock_);
     // Cached length of the vmo.
-    uint64_t vmo_size_;
+    uint64_t vmo_size_ __TA_GUARDED(lock_);
     // Logical length of the underlying file.
-    zx_off_t length_;
+    zx_off_t length_ __TA_GUARDED(lock_);
 };
 
 class VnodeDir final : public VnodeMemfs {
@@ -198,7 +208,10 @@ public:
 
     size_t PagesLimit() const { return pages_limit_; }
 
-    size_t NumAllocatedPages() const { return num_allocated_pages_; }
+    size_t NumAllocatedPages() const {
+        fbl::AutoLock lock(&pages_lock_);
+        return num_allocated_pages_;
+    }
 
     uint64_t GetFsId() const { return fs_id_; }
 
@@ -231,8 +244,11 @@ private:
     // Puts a bound on maximum memory usage.
     const size_t pages_limit_;
 
+    // Files grow concurrently with each other.
+    mutable fbl::Mutex pages_lock_;
+
     // Number of pages currently in use by VnodeFiles.
-    size_t num_allocated_pages_;
+    size_t num_allocated_pages_ __TA_GUARDED(pages_lock_);
 
     uint64_t fs_id_ = 0;
 };
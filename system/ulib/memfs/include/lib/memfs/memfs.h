@@ -16,6 +16,9 @@ typedef struct memfs_filesystem memfs_filesystem_t;
 
 // Given an async dispatcher, create an in-memory filesystem.
 //
+// The dispatcher may be serviced by more than one thread, in which case
+// reads of files on different connections are handled concurrently.
+//
 // Returns the MemFS filesystem object in |out_fs|. This object
 // must be freed by memfs_free_filesystem.
 //
@@ -73,22 +73,26 @@ zx_status_t Vfs::GrowVMO(zx::vmo& vmo, size_t current_size,
     size_t aligned_len = fbl::round_up(request_size, kPageSize);
     ZX_DEBUG_ASSERT(current_size % kPageSize == 0);
     size_t num_new_pages = (aligned_len - current_size) / kPageSize;
-    if (num_new_pages + num_allocated_pages_ > pages_limit_) {
-        *actual_size = current_size;
-        return ZX_ERR_NO_SPACE;
+    {
+        // Reserve the pages before resizing, since other files may be growing
+        // concurrently.
+        fbl::AutoLock lock(&pages_lock_);
+        if (num_new_pages + num_allocated_pages_ > pages_limit_) {
+            *actual_size = current_size;
+            return ZX_ERR_NO_SPACE;
+        }
+        num_allocated_pages_ += num_new_pages;
     }
     zx_status_t status;
     if (!vmo.is_valid()) {
-        if ((status = zx::vmo::create(aligned_len, 0, &vmo)) != ZX_OK) {
-            return status;
-        }
+        status = zx::vmo::create(aligned_len, 0, &vmo);
     } else {
-        if ((status = vmo.set_size(aligned_len)) != ZX_OK) {
-            return status;
-        }
+        status = vmo.set_size(aligned_len);
+    }
+    if (status != ZX_OK) {
+        WillFreeVMO(num_new_pages * kPageSize);
+        return status;
     }
-    // vmo operation succeeded
-    num_allocated_pages_ += num_new_pages;
     *actual_size = aligned_len;
     return ZX_OK;
 }
@@ -96,6 +100,7 @@ zx_status_t Vfs::GrowVMO(zx::vmo& vmo, size_t current_size,
 void Vfs::WillFreeVMO(size_t vmo_size) {
     ZX_DEBUG_ASSERT(vmo_size % kPageSize == 0);
     size_t freed_pages = vmo_size / kPageSize;
+    fbl::AutoLock lock(&pages_lock_);
     ZX_DEBUG_ASSERT(freed_pages <= num_allocated_pages_);
     num_allocated_pages_ -= freed_pages;
 }
@@ -6,6 +6,7 @@
 #include <string.h>
 
 #include <bitmap/raw-bitmap.h>
+#include <fbl/algorithm.h>
 
 #include <minfs/allocator.h>
 #include <minfs/block-txn.h>
@@ -28,11 +29,14 @@ AllocatorPromise::~AllocatorPromise() {
     }
 }
 
-size_t AllocatorPromise::Allocate(WriteTxn* txn) {
+size_t AllocatorPromise::Allocate(WriteTxn* txn, size_t goal) {
     ZX_DEBUG_ASSERT(allocator_ != nullptr);
     ZX_DEBUG_ASSERT(reserved_ > 0);
+    // The remaining reservation bounds how many more elements this
+    // operation may allocate.
+    size_t run = reserved_;
     reserved_--;
-    return allocator_->Allocate(txn);
+    return allocator_->Allocate(txn, goal, run);
 }
 
 AllocatorFvmMetadata::AllocatorFvmMetadata() = default;
@@ -131,11 +135,31 @@ void Allocator::Unreserve(size_t count) {
     reserved_ -= count;
 }
 
-size_t Allocator::Allocate(WriteTxn* txn) {
+size_t Allocator::Allocate(WriteTxn* txn, size_t goal, size_t run) {
     ZX_DEBUG_ASSERT(reserved_ > 0);
     size_t bitoff_start;
-    if (map_.Find(false, hint_, map_.size(), 1, &bitoff_start) != ZX_OK) {
-        ZX_ASSERT(map_.Find(false, 0, hint_, 1, &bitoff_start) == ZX_OK);
+    if ((goal != 0) && (goal < map_.size()) && !map_.Get(goal, goal + 1)) {
+        bitoff_start = goal;
+        if (hint_ == goal) {
+            hint_ = goal + 1;
+        }
+    } else {
+        if (goal != 0) {
+            // The previous run filled up; set aside a reasonable extent for the rest.
+            run = fbl::max(run, kMinfsMinAllocationRun);
+        }
+        run = fbl::min(run, kMinfsMaxAllocationRun);
+        if ((run > 1) &&
+            ((map_.Find(false, hint_, map_.size(), run, &bitoff_start) == ZX_OK) ||
+             (map_.Find(false, 0, hint_, run, &bitoff_start) == ZX_OK))) {
+            // Leave the rest of the run to the stream starting here.
+            hint_ = bitoff_start + run;
+        } else {
+            if (map_.Find(false, hint_, map_.size(), 1, &bitoff_start) != ZX_OK) {
+                ZX_ASSERT(map_.Find(false, 0, hint_, 1, &bitoff_start) == ZX_OK);
+            }
+            hint_ = bitoff_start + 1;
+        }
     }
 
     ZX_ASSERT(map_.Set(bitoff_start, bitoff_start + 1) == ZX_OK);
@@ -144,7 +168,6 @@ size_t Allocator::Allocate(WriteTxn* txn) {
     metadata_.PoolAllocate(1);
     reserved_ -= 1;
     sb_->Write(txn);
-    hint_ = bitoff_start + 1;
     return bitoff_start;
 }
 
@@ -6,9 +6,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#include <fbl/algorithm.h>
 #include <fbl/alloc_checker.h>
+#include <fbl/auto_lock.h>
 #include <fbl/ref_ptr.h>
 #include <fbl/unique_ptr.h>
 #include <fs/trace.h>
@@ -19,7 +22,9 @@
 
 namespace minfs {
 
-zx_status_t Bcache::Readblk(blk_t bno, void* data) {
+zx_status_t Bcache::ReadRaw(blk_t bno, fbl::unique_ptr<CacheBlock>* blocks, uint32_t count,
+                            uint32_t* out_count) {
+    ZX_DEBUG_ASSERT(count > 0 && count <= kBcacheMaxReadahead);
     off_t off = static_cast<off_t>(bno) * kMinfsBlockSize;
     assert(off / kMinfsBlockSize == bno); // Overflow
 #ifndef __Fuchsia__
@@ -29,14 +34,23 @@ zx_status_t Bcache::Readblk(blk_t bno, void* data) {
         FS_TRACE_ERROR("minfs: cannot seek to block %u\n", bno);
         return ZX_ERR_IO;
     }
-    if (read(fd_.get(), data, kMinfsBlockSize) != kMinfsBlockSize) {
+    struct iovec iov[kBcacheMaxReadahead];
+    for (uint32_t i = 0; i < count; i++) {
+        iov[i].iov_base = blocks[i]->data;
+        iov[i].iov_len = kMinfsBlockSize;
+    }
+    // Only the first block is required; the rest is read-ahead and may be
+    // cut short by the end of the device.
+    ssize_t r = readv(fd_.get(), iov, count);
+    if (r < static_cast<ssize_t>(kMinfsBlockSize)) {
         FS_TRACE_ERROR("minfs: cannot read block %u\n", bno);
         return ZX_ERR_IO;
     }
+    *out_count = static_cast<uint32_t>(r / kMinfsBlockSize);
     return ZX_OK;
 }
 
-zx_status_t Bcache::Writeblk(blk_t bno, const void* data) {
+zx_status_t Bcache::WriteRaw(blk_t bno, const void* data) {
     off_t off = static_cast<off_t>(bno) * kMinfsBlockSize;
     assert(off / kMinfsBlockSize == bno); // Overflow
 #ifndef __Fuchsia__
@@ -53,12 +67,208 @@ zx_status_t Bcache::Writeblk(blk_t bno, const void* data) {
     return ZX_OK;
 }
 
+Bcache::CacheBlock* Bcache::Lookup(blk_t bno) {
+    auto iter = cache_.find(bno);
+    if (!iter.IsValid()) {
+        return nullptr;
+    }
+    CacheBlock* block = &*iter;
+    lru_.erase(*block);
+    lru_.push_front(block);
+    return block;
+}
+
+zx_status_t Bcache::AllocateBlock(blk_t bno, fbl::unique_ptr<CacheBlock>* out) {
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<CacheBlock> block(new (&ac) CacheBlock());
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    block->bno = bno;
+    *out = fbl::move(block);
+    return ZX_OK;
+}
+
+void Bcache::Insert(fbl::unique_ptr<CacheBlock> block) {
+    lru_.push_front(block.get());
+    cache_.insert(fbl::move(block));
+    while (cache_.size() > kBcacheBlocks) {
+        CacheBlock* victim = &lru_.back();
+        if (victim->dirty) {
+            if (WriteRaw(victim->bno, victim->data) != ZX_OK) {
+                // Keep the block; Sync() retries the write and reports failure.
+                return;
+            }
+            victim->dirty = false;
+            dirty_count_--;
+        }
+        lru_.erase(*victim);
+        cache_.erase(*victim);
+    }
+}
+
+zx_status_t Bcache::FlushDirty() {
+    if (dirty_count_ == 0) {
+        return ZX_OK;
+    }
+    for (auto iter = lru_.end(); iter != lru_.begin();) {
+        CacheBlock& block = *--iter;
+        if (!block.dirty) {
+            continue;
+        }
+        zx_status_t status = WriteRaw(block.bno, block.data);
+        if (status != ZX_OK) {
+            return status;
+        }
+        block.dirty = false;
+        dirty_count_--;
+    }
+    return ZX_OK;
+}
+
+zx_status_t Bcache::Readblk(blk_t bno, void* data) {
+#ifdef __Fuchsia__
+    fbl::AutoLock lock(&cache_lock_);
+#endif
+    CacheBlock* cached = Lookup(bno);
+    if (cached != nullptr) {
+        metrics_.hits++;
+        memcpy(data, cached->data, kMinfsBlockSize);
+        return ZX_OK;
+    }
+    metrics_.misses++;
+
+    // Double the read-ahead window while misses stay sequential, and read
+    // up to the next block which is already cached.
+    readahead_ = (bno == next_sequential_) ? fbl::min(readahead_ * 2, kBcacheMaxReadahead) : 1;
+    uint32_t count = 1;
+    while (count < readahead_ && bno + count < blockmax_ &&
+           !cache_.find(bno + count).IsValid()) {
+        count++;
+    }
+
+    zx_status_t status;
+    fbl::unique_ptr<CacheBlock> blocks[kBcacheMaxReadahead];
+    for (uint32_t i = 0; i < count; i++) {
+        if ((status = AllocateBlock(bno + i, &blocks[i])) != ZX_OK) {
+            return status;
+        }
+    }
+    uint32_t read_count;
+    if ((status = ReadRaw(bno, blocks, count, &read_count)) != ZX_OK) {
+        return status;
+    }
+    memcpy(data, blocks[0]->data, kMinfsBlockSize);
+    metrics_.readahead_blocks += read_count - 1;
+    next_sequential_ = bno + read_count;
+    for (uint32_t i = 0; i < read_count; i++) {
+        Insert(fbl::move(blocks[i]));
+    }
+    return ZX_OK;
+}
+
+zx_status_t Bcache::Writeblk(blk_t bno, const void* data) {
+#ifdef __Fuchsia__
+    fbl::AutoLock lock(&cache_lock_);
+#endif
+    CacheBlock* cached = Lookup(bno);
+    if (cached != nullptr) {
+        memcpy(cached->data, data, kMinfsBlockSize);
+        if (!cached->dirty) {
+            cached->dirty = true;
+            dirty_count_++;
+        }
+        return ZX_OK;
+    }
+
+    fbl::unique_ptr<CacheBlock> block;
+    zx_status_t status = AllocateBlock(bno, &block);
+    if (status != ZX_OK) {
+        // Fall back to writing through.
+        return WriteRaw(bno, data);
+    }
+    memcpy(block->data, data, kMinfsBlockSize);
+    block->dirty = true;
+    dirty_count_++;
+    Insert(fbl::move(block));
+    return ZX_OK;
+}
+
 int Bcache::Sync() {
+    {
+#ifdef __Fuchsia__
+        fbl::AutoLock lock(&cache_lock_);
+#endif
+        zx_status_t status = FlushDirty();
+        if (status != ZX_OK) {
+            return status;
+        }
+    }
     fs::WriteTxn sync_txn(this);
     sync_txn.EnqueueFlush();
     return sync_txn.Transact();
 }
 
+BcacheMetrics Bcache::GetMetrics() const {
+#ifdef __Fuchsia__
+    fbl::AutoLock lock(&cache_lock_);
+#endif
+    return metrics_;
+}
+
+#ifdef __Fuchsia__
+zx_status_t Bcache::Transaction(block_fifo_request_t* requests, size_t count) {
+    {
+        // Earlier single block writes must reach the device before any
+        // request which may read or overwrite the same blocks.
+        fbl::AutoLock lock(&cache_lock_);
+        zx_status_t status = FlushDirty();
+        if (status != ZX_OK) {
+            return status;
+        }
+    }
+    zx_status_t status = fifo_client_.Transaction(requests, count);
+
+    fbl::AutoLock lock(&cache_lock_);
+    if (cache_.is_empty()) {
+        return status;
+    }
+    const uint64_t kBlockFactor = kMinfsBlockSize / info_.block_size;
+    for (size_t i = 0; i < count; i++) {
+        if ((requests[i].opcode & BLOCKIO_OP_MASK) != BLOCKIO_WRITE) {
+            continue;
+        }
+        uint64_t start = requests[i].dev_offset / kBlockFactor;
+        uint64_t end = fbl::min<uint64_t>(blockmax_, fbl::round_up(requests[i].dev_offset +
+                                                                   requests[i].length,
+                                                                   kBlockFactor) / kBlockFactor);
+        if (start < end) {
+            Invalidate(static_cast<blk_t>(start), static_cast<blk_t>(end));
+        }
+    }
+    return status;
+}
+
+void Bcache::Invalidate(blk_t start, blk_t end) {
+    if (end - start <= cache_.size()) {
+        for (blk_t bno = start; bno < end; bno++) {
+            auto block = cache_.erase(bno);
+            if (block != nullptr) {
+                lru_.erase(*block);
+            }
+        }
+        return;
+    }
+    for (auto iter = lru_.begin(); iter != lru_.end();) {
+        CacheBlock* block = &*iter++;
+        if (block->bno >= start && block->bno < end) {
+            lru_.erase(*block);
+            cache_.erase(*block);
+        }
+    }
+}
+#endif
+
 zx_status_t Bcache::Create(fbl::unique_ptr<Bcache>* out, fbl::unique_fd fd, uint32_t blockmax) {
     fbl::AllocChecker ac;
     fbl::unique_ptr<Bcache> bc(new (&ac) Bcache(fbl::move(fd), blockmax));
@@ -119,6 +329,16 @@ Bcache::Bcache(fbl::unique_fd fd, uint32_t blockmax) :
     fd_(fbl::move(fd)), blockmax_(blockmax) {}
 
 Bcache::~Bcache() {
+    {
+#ifdef __Fuchsia__
+        fbl::AutoLock lock(&cache_lock_);
+#endif
+        if (FlushDirty() != ZX_OK) {
+            FS_TRACE_ERROR("minfs: failed to write back cached blocks\n");
+        }
+        lru_.clear();
+        cache_.clear();
+    }
 #ifdef __Fuchsia__
     if (fd_) {
         ioctl_block_fifo_close(fd_.get());
@@ -0,0 +1,61 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fbl/alloc_checker.h>
+#include <minfs/directory-index.h>
+
+namespace minfs {
+
+zx_status_t DirectoryIndex::Create(fbl::unique_ptr<DirectoryIndex>* out) {
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<DirectoryIndex> index(new (&ac) DirectoryIndex());
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    *out = fbl::move(index);
+    return ZX_OK;
+}
+
+bool DirectoryIndex::Find(fbl::StringPiece name, ino_t* out_ino, uint32_t* out_type) const {
+    auto iter = entries_.find(name);
+    if (!iter.IsValid()) {
+        return false;
+    }
+    *out_ino = iter->ino;
+    *out_type = iter->type;
+    return true;
+}
+
+zx_status_t DirectoryIndex::Insert(fbl::StringPiece name, ino_t ino, uint32_t type) {
+    if (entries_.find(name).IsValid()) {
+        return ZX_ERR_ALREADY_EXISTS;
+    }
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<Entry> entry(new (&ac) Entry());
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    entry->name.Set(name, &ac);
+    if (!ac.check()) {
+        return ZX_ERR_NO_MEMORY;
+    }
+    entry->ino = ino;
+    entry->type = type;
+    entries_.insert(fbl::move(entry));
+    return ZX_OK;
+}
+
+void DirectoryIndex::Update(fbl::StringPiece name, ino_t ino) {
+    auto iter = entries_.find(name);
+    ZX_DEBUG_ASSERT(iter.IsValid());
+    if (iter.IsValid()) {
+        iter->ino = ino;
+    }
+}
+
+void DirectoryIndex::Remove(fbl::StringPiece name) {
+    entries_.erase(name);
+}
+
+} // namespace minfs
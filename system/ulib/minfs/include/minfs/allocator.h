@@ -18,6 +18,11 @@
 
 namespace minfs {
 
+// Bounds, in elements, of the free run set aside when an allocation stream starts
+// over. The lower bound only applies to streams which are growing past a collision.
+constexpr size_t kMinfsMinAllocationRun = 16;
+constexpr size_t kMinfsMaxAllocationRun = 256;
+
 #ifdef __Fuchsia__
 using RawBitmap = bitmap::RawBitmapGeneric<bitmap::VmoStorage>;
 #else
@@ -39,7 +44,11 @@ public:
     ~AllocatorPromise();
 
     // Allocate a new item in allocator_. Return the index of the newly allocated item.
-    size_t Allocate(WriteTxn* txn);
+    size_t Allocate(WriteTxn* txn) { return Allocate(txn, 0); }
+
+    // Allocate a new item in allocator_, preferring index |goal| if it is free.
+    // A |goal| of zero means there is no preference.
+    size_t Allocate(WriteTxn* txn, size_t goal);
 private:
     friend class Allocator;
 
@@ -213,7 +222,11 @@ private:
     zx_status_t Extend(WriteTxn* txn);
 
     // Allocate an element and return the newly allocated index.
-    size_t Allocate(WriteTxn* txn);
+    //
+    // If |goal| is free it is used, continuing an earlier allocation. Otherwise the
+    // stream starts over at a free run of up to |run| elements, which other streams
+    // skip, so that allocations which chain their goals stay contiguous.
+    size_t Allocate(WriteTxn* txn, size_t goal, size_t run);
 
     // Write back the allocation of the following items to disk.
     void Persist(WriteTxn* txn, size_t index, size_t count);
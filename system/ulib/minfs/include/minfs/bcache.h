@@ -11,6 +11,7 @@
 
 #ifdef __Fuchsia__
 #include <block-client/cpp/client.h>
+#include <fbl/mutex.h>
 #include <fs/fvm.h>
 #include <lib/zx/vmo.h>
 #else
@@ -18,17 +19,34 @@
 #endif
 
 #include <fbl/algorithm.h>
+#include <fbl/intrusive_double_list.h>
+#include <fbl/intrusive_hash_table.h>
+#include <fbl/intrusive_single_list.h>
 #include <fbl/macros.h>
 #include <fbl/unique_ptr.h>
 #include <fbl/unique_fd.h>
 #include <fs/block-txn.h>
+#include <fs/locking.h>
 #include <fs/trace.h>
 #include <fs/vfs.h>
 #include <fs/vnode.h>
+#include <lib/zircon-internal/fnv1hash.h>
 #include <minfs/format.h>
 
 namespace minfs {
 
+// Maximum number of blocks held by the Bcache block cache.
+constexpr uint32_t kBcacheBlocks = 512;
+
+// Upper bound of the read-ahead window, in blocks.
+constexpr uint32_t kBcacheMaxReadahead = 32;
+
+struct BcacheMetrics {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t readahead_blocks;
+};
+
 class Bcache : public fs::TransactionHandler {
 public:
     DISALLOW_COPY_ASSIGN_AND_MOVE(Bcache);
@@ -55,12 +73,14 @@ public:
         return info_.block_size;
     }
 
-    zx_status_t Transaction(block_fifo_request_t* requests, size_t count) final {
-        return fifo_client_.Transaction(requests, count);
-    }
+    // Writes back dirty cached blocks before issuing |requests|, and drops
+    // cached copies of any blocks the requests overwrite.
+    zx_status_t Transaction(block_fifo_request_t* requests, size_t count) final;
 #endif // __Fuchsia__
-    // Raw block read functions.
-    // These do not track blocks (or attempt to access the block cache)
+    // Single block read and write functions.
+    // These go through a small LRU block cache. Writes are held in the cache
+    // until the block is evicted or Sync() is called, and sequential read
+    // misses trigger a growing read-ahead window.
     // NOTE: Not marked as final, since these are overridden methods on host,
     // but not on __Fuchsia__.
     zx_status_t Readblk(blk_t bno, void* data);
@@ -127,13 +147,50 @@ public:
     zx_status_t SetSparse(off_t offset, const fbl::Vector<size_t>& extent_lengths);
 #endif
 
+    // Writes back all dirty cached blocks and flushes the device.
     int Sync();
 
+    // Returns the block cache counters.
+    BcacheMetrics GetMetrics() const;
+
     ~Bcache();
 
 private:
+    struct CacheBlock : public fbl::SinglyLinkedListable<fbl::unique_ptr<CacheBlock>>,
+                        public fbl::DoublyLinkedListable<CacheBlock*> {
+        blk_t GetKey() const { return bno; }
+        static size_t GetHash(blk_t key) { return fnv1a_tiny(key, kMinfsHashBits); }
+
+        blk_t bno = 0;
+        bool dirty = false;
+        uint8_t data[kMinfsBlockSize];
+    };
+
+    using CacheHash = fbl::HashTable<blk_t, fbl::unique_ptr<CacheBlock>>;
+    using CacheList = fbl::DoublyLinkedList<CacheBlock*>;
+
     Bcache(fbl::unique_fd fd, uint32_t blockmax);
 
+    // Uncached I/O. ReadRaw reads up to |count| consecutive blocks starting
+    // at |bno| into |blocks|, and returns the number of whole blocks read.
+    zx_status_t ReadRaw(blk_t bno, fbl::unique_ptr<CacheBlock>* blocks, uint32_t count,
+                        uint32_t* out_count);
+    zx_status_t WriteRaw(blk_t bno, const void* data);
+
+    // Returns the cached block |bno|, marking it most recently used, or
+    // nullptr if the block is not cached.
+    CacheBlock* Lookup(blk_t bno) FS_TA_REQUIRES(cache_lock_);
+    static zx_status_t AllocateBlock(blk_t bno, fbl::unique_ptr<CacheBlock>* out);
+    // Inserts |block| as the most recently used block, then evicts (writing
+    // back if dirty) least recently used blocks while the cache is too large.
+    void Insert(fbl::unique_ptr<CacheBlock> block) FS_TA_REQUIRES(cache_lock_);
+    // Writes back dirty blocks, least recently used first.
+    zx_status_t FlushDirty() FS_TA_REQUIRES(cache_lock_);
+#ifdef __Fuchsia__
+    // Drops cached blocks in the range [start, end).
+    void Invalidate(blk_t start, blk_t end) FS_TA_REQUIRES(cache_lock_);
+#endif
+
 #ifdef __Fuchsia__
     block_client::Client fifo_client_{}; // Fast path to interact with block device
     block_info_t info_{};
@@ -143,6 +200,18 @@ private:
 #endif
     fbl::unique_fd fd_{};
     uint32_t blockmax_{};
+
+#ifdef __Fuchsia__
+    mutable fbl::Mutex cache_lock_;
+#endif
+    CacheHash cache_ FS_TA_GUARDED(cache_lock_){};
+    CacheList lru_ FS_TA_GUARDED(cache_lock_){};
+    size_t dirty_count_ FS_TA_GUARDED(cache_lock_) = 0;
+    // The block following the last read miss, and the read-ahead window
+    // that grows while misses stay sequential.
+    blk_t next_sequential_ FS_TA_GUARDED(cache_lock_) = 0;
+    uint32_t readahead_ FS_TA_GUARDED(cache_lock_) = 1;
+    BcacheMetrics metrics_ FS_TA_GUARDED(cache_lock_) = {};
 };
 
 } // namespace minfs
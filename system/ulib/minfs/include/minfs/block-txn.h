@@ -44,12 +44,13 @@ public:
 
     size_t BlkCount() const;
 
+    // Translates the enqueued requests into block device write requests
+    // against |vmoid|, without sending them. |out| must have room for
+    // |Requests().size()| entries. Returns the number of requests written.
+    size_t BuildRequests(vmoid_t vmoid, block_fifo_request_t* out) const;
+
 protected:
-    // Activate the transaction, writing it out to disk.
-    //
-    // Each transaction uses the |vmo| / |vmoid| pair supplied, since the
-    // transactions should be all reading from a single in-memory buffer.
-    zx_status_t Flush(zx_handle_t vmo, vmoid_t vmoid);
+    Bcache* bcache() const { return bc_; }
 
 private:
     Bcache* bc_;
@@ -0,0 +1,73 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This file describes the in-memory index of a directory's entries.
+
+#pragma once
+
+#include <fbl/intrusive_hash_table.h>
+#include <fbl/intrusive_single_list.h>
+#include <fbl/macros.h>
+#include <fbl/string.h>
+#include <fbl/string_piece.h>
+#include <fbl/unique_ptr.h>
+#include <lib/zircon-internal/fnv1hash.h>
+#include <minfs/format.h>
+
+namespace minfs {
+
+// Directories with at least this many entries (including "." and "..") are
+// indexed on their first lookup; smaller ones are scanned.
+constexpr uint32_t kDirectoryIndexMinEntries = 32;
+
+// DirectoryIndex maps the name of every live entry of a directory to its
+// inode number and type.
+//
+// The index is built by one pass over the directory and then kept up to
+// date by the operations which add, remove or retarget entries, so both
+// positive and negative lookups are answered without reading dirents.
+// Nothing is stored on disk, so existing images remain compatible.
+class DirectoryIndex {
+public:
+    DISALLOW_COPY_ASSIGN_AND_MOVE(DirectoryIndex);
+
+    static zx_status_t Create(fbl::unique_ptr<DirectoryIndex>* out);
+
+    // Returns true and fills |out_ino| and |out_type| if |name| is present.
+    bool Find(fbl::StringPiece name, ino_t* out_ino, uint32_t* out_type) const;
+
+    // Records a new entry. Fails with ZX_ERR_ALREADY_EXISTS if |name| is present.
+    zx_status_t Insert(fbl::StringPiece name, ino_t ino, uint32_t type);
+
+    // Points the existing entry |name| at |ino|.
+    void Update(fbl::StringPiece name, ino_t ino);
+
+    void Remove(fbl::StringPiece name);
+
+    size_t size() const { return entries_.size(); }
+
+private:
+    static constexpr size_t kBuckets = 1024;
+
+    struct Entry : public fbl::SinglyLinkedListable<fbl::unique_ptr<Entry>> {
+        fbl::StringPiece GetKey() const { return name.ToStringPiece(); }
+        static size_t GetHash(fbl::StringPiece key) {
+            return fnv1a32(key.data(), key.length());
+        }
+
+        fbl::String name;
+        ino_t ino;
+        uint32_t type;
+    };
+
+    using EntryTable = fbl::HashTable<fbl::StringPiece, fbl::unique_ptr<Entry>,
+                                      fbl::SinglyLinkedList<fbl::unique_ptr<Entry>>,
+                                      size_t, kBuckets>;
+
+    DirectoryIndex() = default;
+
+    EntryTable entries_;
+};
+
+} // namespace minfs
@@ -46,12 +46,16 @@ public:
     void Reset();
 
 #ifdef __Fuchsia__
-    // Actually transacts the enqueued work, and resets the WritebackWork to
-    // its initial state.
+    // Transacts the |count| works in |works| with a single block device
+    // transaction, reading from the writeback buffer |vmo| / |vmoid|, and
+    // resets each of them to its initial state. Each work is written only
+    // after the ones before it, and if any of them asked for a device flush,
+    // one flush is issued after all of them.
     //
     // Returns the number of blocks of the writeback buffer that have been
     // consumed.
-    size_t Complete(zx_handle_t vmo, vmoid_t vmoid);
+    static size_t CompleteGroup(fbl::unique_ptr<WritebackWork>* works, size_t count,
+                                zx_handle_t vmo, vmoid_t vmoid);
 
     // Adds a closure to the WritebackWork, such that it will be signalled
     // when the WritebackWork is flushed to disk.
@@ -60,6 +64,10 @@ public:
     // Only one closure may be set for each WritebackWork unit.
     using SyncCallback = fs::Vnode::SyncCallback;
     void SetClosure(SyncCallback closure);
+
+    // Asks for the block device's write cache to be flushed once this work
+    // has been written, before its closure is signalled.
+    void SetDeviceFlush();
 #else
     // Flushes any pending transactions.
     void Complete();
@@ -72,6 +80,7 @@ public:
 private:
 #ifdef __Fuchsia__
     SyncCallback closure_; // Optional.
+    bool device_flush_;
 #endif
     size_t node_count_;
     // May be empty. Currently '4' is the maximum number of vnodes within a
@@ -96,9 +105,10 @@ public:
         return inode_promise_->Allocate(work_.get());
     }
 
-    size_t AllocateBlock() {
+    // Allocates a reserved block, preferring |goal| if it is free.
+    size_t AllocateBlock(size_t goal) {
         ZX_DEBUG_ASSERT(block_promise_ != nullptr);
-        return block_promise_->Allocate(work_.get());
+        return block_promise_->Allocate(work_.get(), goal);
     }
 
     void SetWork(fbl::unique_ptr<WritebackWork> work) {
@@ -168,6 +178,13 @@ private:
     // It allows them to take turns putting data into the buffer when it is
     // mostly full.
     struct Waiter : public fbl::SinglyLinkedListable<Waiter*> {};
+
+    // Queued works are taken off the queue together, at most kMaxGroupWorks
+    // works and (unless a single work is larger) kMaxGroupRequests block
+    // requests at a time.
+    static constexpr size_t kMaxGroupWorks = 32;
+    static constexpr size_t kMaxGroupRequests = BLOCK_FIFO_MAX_DEPTH - 1;
+
     using WorkQueue = fs::Queue<fbl::unique_ptr<WritebackWork>>;
     using ProducerQueue = fs::Queue<Waiter*>;
 
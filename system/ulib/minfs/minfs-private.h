@@ -36,6 +36,7 @@
 #include <fs/vnode.h>
 #include <lib/zircon-internal/fnv1hash.h>
 #include <minfs/allocator.h>
+#include <minfs/directory-index.h>
 #include <minfs/format.h>
 #include <minfs/inode-manager.h>
 #include <minfs/superblock.h>
@@ -145,8 +146,8 @@ public:
     fbl::RefPtr<VnodeMinfs> VnodeLookup(uint32_t ino) FS_TA_EXCLUDES(hash_lock_);
     void VnodeRelease(VnodeMinfs* vn) FS_TA_EXCLUDES(hash_lock_);
 
-    // Allocate a new data block.
-    void BlockNew(Transaction* state, blk_t* out_bno);
+    // Allocate a new data block, preferring |goal| if it is free (zero for no preference).
+    void BlockNew(Transaction* state, blk_t goal, blk_t* out_bno);
 
     // Free a data block.
     void BlockFree(WriteTxn* txn, blk_t bno);
@@ -243,6 +244,10 @@ public:
     zx_status_t GetMetrics(fuchsia_minfs_Metrics* out) const {
         if (collecting_metrics_) {
             memcpy(out, &metrics_, sizeof(metrics_));
+            BcacheMetrics cache = bc_->GetMetrics();
+            out->block_cache_hits = cache.hits;
+            out->block_cache_misses = cache.misses;
+            out->block_cache_readahead_blocks = cache.readahead_blocks;
             return ZX_OK;
         }
         return ZX_ERR_UNAVAILABLE;
@@ -412,6 +417,7 @@ private:
 #ifdef __Fuchsia__
     zx_status_t QueryFilesystem(fuchsia_io_FilesystemInfo* out) final;
     zx_status_t GetDevicePath(size_t buffer_len, char* out_name, size_t* out_len) final;
+    zx_status_t GetVmo(int flags, zx_handle_t* out) final;
 #endif
 
     // Internal functions
@@ -434,6 +440,15 @@ private:
     // Enumerates directories.
     zx_status_t ForEachDirent(DirArgs* args, const DirentCallback func);
 
+    // Looks up |args->name|, filling |args->ino| and |args->type|. Returns the same values
+    // as ForEachDirent with DirentCallbackFind, but answers from |dir_index_| when the
+    // directory is large enough to be indexed.
+    zx_status_t FindDirent(DirArgs* args);
+    // Returns false if the directory index shows that |name| does not exist.
+    bool MayContainDirent(fbl::StringPiece name) const;
+    // Builds |dir_index_| with one pass over the directory.
+    zx_status_t BuildDirectoryIndex();
+
     // Directory callback functions.
     //
     // The following functions are passable to |ForEachDirent|, which reads the parent directory,
@@ -448,6 +463,7 @@ private:
     static zx_status_t DirentCallbackUpdateInode(fbl::RefPtr<VnodeMinfs>, Dirent*,
                                                  DirArgs*);
     static zx_status_t DirentCallbackFindSpace(fbl::RefPtr<VnodeMinfs>, Dirent*, DirArgs*);
+    static zx_status_t DirentCallbackIndex(fbl::RefPtr<VnodeMinfs>, Dirent*, DirArgs*);
 
     // Appends a new directory at the specified offset within |args|. This requires a prior call to
     // DirentCallbackFindSpace to find an offset where there is space for the direntry. It takes
@@ -692,6 +708,13 @@ private:
     ino_t ino_{};
     Inode inode_{};
 
+    // Index of the entries of a large directory. Either complete or absent.
+    fbl::unique_ptr<DirectoryIndex> dir_index_;
+
+    // The block following the last data block allocated to this vnode, used as the
+    // allocation goal so that sequentially written data stays contiguous.
+    blk_t alloc_goal_ = 0;
+
     // This field tracks the current number of file descriptors with
     // an open reference to this Vnode. Notably, this is distinct from the
     // VnodeMinfs's own refcount, since there may still be filesystem
@@ -283,6 +283,7 @@ void Minfs::Sync(SyncCallback closure) {
     fbl::unique_ptr<Transaction> state;
     ZX_ASSERT(BeginTransaction(0, 0, &state) == ZX_OK);
     state->GetWork()->SetClosure(fbl::move(closure));
+    state->GetWork()->SetDeviceFlush();
     CommitTransaction(fbl::move(state));
 }
 #endif
@@ -660,8 +661,8 @@ zx_status_t Minfs::VnodeGet(fbl::RefPtr<VnodeMinfs>* out, ino_t ino) {
 }
 
 // Allocate a new data block from the block bitmap.
-void Minfs::BlockNew(Transaction* state, blk_t* out_bno) {
-    size_t allocated_bno = state->AllocateBlock();
+void Minfs::BlockNew(Transaction* state, blk_t goal, blk_t* out_bno) {
+    size_t allocated_bno = state->AllocateBlock(goal);
     *out_bno = static_cast<blk_t>(allocated_bno);
 }
 
@@ -1106,6 +1107,11 @@ zx_status_t Mkfs(const MountOptions& options, fbl::unique_ptr<Bcache> bc) {
     memcpy(blk, &info, sizeof(info));
     bc->Writeblk(0, blk);
 
+    // The block cache holds the writes above until it is synced.
+    if ((status = bc->Sync()) != ZX_OK) {
+        return status;
+    }
+
     fvm_cleanup.cancel();
     return ZX_OK;
 }
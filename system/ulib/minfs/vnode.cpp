@@ -384,7 +384,7 @@ void VnodeMinfs::AllocateIndirect(Transaction* state, blk_t index, IndirectArgs*
 
     // allocate new indirect block
     blk_t bno;
-    fs_->BlockNew(state, &bno);
+    fs_->BlockNew(state, 0, &bno);
 
 #ifdef __Fuchsia__
     ClearIndirectVmoBlock(args->GetOffset() + index);
@@ -413,7 +413,8 @@ zx_status_t VnodeMinfs::BlockOpDirect(Transaction* state, DirectArgs* params) {
             case BlockOp::kWrite: {
                 ZX_DEBUG_ASSERT(state != nullptr);
                 if (bno == 0) {
-                    fs_->BlockNew(state, &bno);
+                    fs_->BlockNew(state, alloc_goal_, &bno);
+                    alloc_goal_ = bno + 1;
                     inode_.block_count++;
                 }
 
@@ -756,6 +757,18 @@ zx_status_t VnodeMinfs::DirentCallbackFind(fbl::RefPtr<VnodeMinfs> vndir, Dirent
     }
 }
 
+zx_status_t VnodeMinfs::DirentCallbackIndex(fbl::RefPtr<VnodeMinfs> vndir, Dirent* de,
+                                            DirArgs* args) {
+    if (de->ino != 0) {
+        zx_status_t status = vndir->dir_index_->Insert(fbl::StringPiece(de->name, de->namelen),
+                                                       de->ino, de->type);
+        if (status != ZX_OK) {
+            return status;
+        }
+    }
+    return NextDirent(de, &args->offs);
+}
+
 zx_status_t VnodeMinfs::CanUnlink() const {
     // directories must be empty (dirent_count == 2)
     if (IsDirectory()) {
@@ -830,6 +843,9 @@ zx_status_t VnodeMinfs::UnlinkChild(Transaction* state,
     if ((status = WriteExactInternal(state, de, MINFS_DIRENT_SIZE, off)) != ZX_OK) {
         return status;
     }
+    if (dir_index_ != nullptr) {
+        dir_index_->Remove(fbl::StringPiece(de->name, de->namelen));
+    }
 
     if (de->reclen & kMinfsReclenLast) {
         // Truncating the directory merely removed unused space; if it fails,
@@ -952,6 +968,9 @@ zx_status_t VnodeMinfs::DirentCallbackAttemptRename(fbl::RefPtr<VnodeMinfs> vndi
     if (status != ZX_OK) {
         return status;
     }
+    if (vndir->dir_index_ != nullptr) {
+        vndir->dir_index_->Update(args->name, args->ino);
+    }
 
     args->state->GetWork()->PinVnode(vn);
     args->state->GetWork()->PinVnode(vndir);
@@ -971,6 +990,9 @@ zx_status_t VnodeMinfs::DirentCallbackUpdateInode(fbl::RefPtr<VnodeMinfs> vndir,
     if (status != ZX_OK) {
         return status;
     }
+    if (vndir->dir_index_ != nullptr) {
+        vndir->dir_index_->Update(args->name, args->ino);
+    }
     args->state->GetWork()->PinVnode(vndir);
     return kDirIteratorSaveSync;
 }
@@ -1049,6 +1071,11 @@ zx_status_t VnodeMinfs::AppendDirent(DirArgs* args) {
                                      args->offs.off)) != ZX_OK) {
         return status;
     }
+    if ((dir_index_ != nullptr) &&
+        (dir_index_->Insert(args->name, args->ino, args->type) != ZX_OK)) {
+        // An incomplete index would hide entries; rebuild it on the next lookup.
+        dir_index_.reset();
+    }
 
     if (args->type == kMinfsTypeDir) {
         // Child directory has '..' which will point to parent directory
@@ -1106,6 +1133,37 @@ zx_status_t VnodeMinfs::ForEachDirent(DirArgs* args, const DirentCallback func)
     return ZX_ERR_NOT_FOUND;
 }
 
+zx_status_t VnodeMinfs::FindDirent(DirArgs* args) {
+    if ((dir_index_ == nullptr) && (inode_.dirent_count >= kDirectoryIndexMinEntries)) {
+        // If the index cannot be built, keep scanning the directory.
+        BuildDirectoryIndex();
+    }
+    if (dir_index_ != nullptr) {
+        return dir_index_->Find(args->name, &args->ino, &args->type) ? ZX_OK : ZX_ERR_NOT_FOUND;
+    }
+    return ForEachDirent(args, DirentCallbackFind);
+}
+
+bool VnodeMinfs::MayContainDirent(fbl::StringPiece name) const {
+    ino_t ino;
+    uint32_t type;
+    return (dir_index_ == nullptr) || dir_index_->Find(name, &ino, &type);
+}
+
+zx_status_t VnodeMinfs::BuildDirectoryIndex() {
+    zx_status_t status = DirectoryIndex::Create(&dir_index_);
+    if (status != ZX_OK) {
+        return status;
+    }
+    DirArgs args = DirArgs();
+    // DirentCallbackIndex never stops early, so a complete pass ends with ZX_ERR_NOT_FOUND.
+    if ((status = ForEachDirent(&args, DirentCallbackIndex)) != ZX_ERR_NOT_FOUND) {
+        dir_index_.reset();
+        return status;
+    }
+    return ZX_OK;
+}
+
 void VnodeMinfs::fbl_recycle() {
     ZX_DEBUG_ASSERT(fd_count_ == 0);
     if (!IsUnlinked()) {
@@ -1438,7 +1496,7 @@ zx_status_t VnodeMinfs::LookupInternal(fbl::RefPtr<fs::Vnode>* out, fbl::StringP
     auto get_metrics = fbl::MakeAutoCall([&ticker, &success, this]() {
         fs_->UpdateLookupMetrics(success, ticker.End());
     });
-    if ((status = ForEachDirent(&args, DirentCallbackFind)) < 0) {
+    if ((status = FindDirent(&args)) < 0) {
         return status;
     }
     fbl::RefPtr<VnodeMinfs> vn;
@@ -1450,6 +1508,41 @@ zx_status_t VnodeMinfs::LookupInternal(fbl::RefPtr<fs::Vnode>* out, fbl::StringP
     return status;
 }
 
+#ifdef __Fuchsia__
+// Without a pager, writes through a shared mapping would never reach the disk,
+// so only private (copy-on-write) mappings of the file's contents are offered.
+zx_status_t VnodeMinfs::GetVmo(int flags, zx_handle_t* out) {
+    TRACE_DURATION("minfs", "VnodeMinfs::GetVmo", "ino", ino_, "flags", flags);
+    if (IsDirectory()) {
+        return ZX_ERR_NOT_FILE;
+    }
+    if (!(flags & FDIO_MMAP_FLAG_PRIVATE) || (flags & FDIO_MMAP_FLAG_EXACT)) {
+        return ZX_ERR_NOT_SUPPORTED;
+    }
+
+    zx_status_t status;
+    if ((status = InitVmo()) != ZX_OK) {
+        return status;
+    }
+
+    // Let clients map and set the names of their VMOs.
+    zx_rights_t rights = ZX_RIGHTS_BASIC | ZX_RIGHT_MAP | ZX_RIGHTS_PROPERTY;
+    rights |= (flags & FDIO_MMAP_FLAG_READ) ? ZX_RIGHT_READ : 0;
+    rights |= (flags & FDIO_MMAP_FLAG_WRITE) ? ZX_RIGHT_WRITE : 0;
+    rights |= (flags & FDIO_MMAP_FLAG_EXEC) ? ZX_RIGHT_EXECUTE : 0;
+
+    zx::vmo clone;
+    if ((status = vmo_.clone(ZX_VMO_CLONE_COPY_ON_WRITE, 0, inode_.size, &clone)) != ZX_OK) {
+        return status;
+    }
+    if ((status = clone.replace(rights, &clone)) != ZX_OK) {
+        return status;
+    }
+    *out = clone.release();
+    return ZX_OK;
+}
+#endif
+
 zx_status_t VnodeMinfs::Getattr(vnattr_t* a) {
     xprintf("minfs_getattr() vn=%p(#%u)\n", this, ino_);
     a->mode = DTYPE_TO_VTYPE(MinfsMagicType(inode_.magic)) |
@@ -1627,7 +1720,7 @@ zx_status_t VnodeMinfs::Create(fbl::RefPtr<fs::Vnode>* out, fbl::StringPiece nam
     args.name = name;
     // ensure file does not exist
     zx_status_t status;
-    if ((status = ForEachDirent(&args, DirentCallbackFind)) != ZX_ERR_NOT_FOUND) {
+    if ((status = FindDirent(&args)) != ZX_ERR_NOT_FOUND) {
         return ZX_ERR_ALREADY_EXISTS;
     }
 
@@ -1752,6 +1845,8 @@ zx_status_t VnodeMinfs::Unlink(fbl::StringPiece name, bool must_be_dir) {
 
     if (!IsDirectory()) {
         return ZX_ERR_NOT_SUPPORTED;
+    } else if (!MayContainDirent(name)) {
+        return ZX_ERR_NOT_FOUND;
     }
     zx_status_t status;
     fbl::unique_ptr<Transaction> state;
@@ -1928,7 +2023,7 @@ zx_status_t VnodeMinfs::Rename(fbl::RefPtr<fs::Vnode> _newdir, fbl::StringPiece
     // acquire the 'oldname' node (it must exist)
     DirArgs args = DirArgs();
     args.name = oldname;
-    if ((status = ForEachDirent(&args, DirentCallbackFind)) < 0) {
+    if ((status = FindDirent(&args)) < 0) {
         return status;
     } else if ((status = fs_->VnodeGet(&oldvn, args.ino)) < 0) {
         return status;
@@ -1977,7 +2072,8 @@ zx_status_t VnodeMinfs::Rename(fbl::RefPtr<fs::Vnode> _newdir, fbl::StringPiece
     args.state = state.get();
     args.name = newname;
     args.ino = oldvn->ino_;
-    status = newdir->ForEachDirent(&args, DirentCallbackAttemptRename);
+    status = newdir->MayContainDirent(newname) ?
+             newdir->ForEachDirent(&args, DirentCallbackAttemptRename) : ZX_ERR_NOT_FOUND;
     if (status == ZX_ERR_NOT_FOUND) {
         // if 'newname' does not exist, create it
         args.offs = append_offs;
@@ -2039,7 +2135,7 @@ zx_status_t VnodeMinfs::Link(fbl::StringPiece name, fbl::RefPtr<fs::Vnode> _targ
     DirArgs args = DirArgs();
     args.name = name;
     zx_status_t status;
-    if ((status = ForEachDirent(&args, DirentCallbackFind)) != ZX_ERR_NOT_FOUND) {
+    if ((status = FindDirent(&args)) != ZX_ERR_NOT_FOUND) {
         return (status == ZX_OK) ? ZX_ERR_ALREADY_EXISTS : status;
     }
 
@@ -2094,15 +2190,10 @@ zx_status_t VnodeMinfs::GetHandles(uint32_t flags, zx_handle_t* hnd, uint32_t* t
 
 void VnodeMinfs::Sync(SyncCallback closure) {
     TRACE_DURATION("minfs", "VnodeMinfs::Sync");
-    fs_->Sync([this, cb = fbl::move(closure)](zx_status_t status) {
-        if (status != ZX_OK) {
-            cb(status);
-            return;
-        }
-        status = fs_->bc_->Sync();
-        cb(status);
-    });
-    return;
+    // The device flush is issued by the writeback thread once everything
+    // enqueued before this point has been written, and is shared with any
+    // other syncs that reach the thread at the same time.
+    fs_->Sync(fbl::move(closure));
 }
 
 zx_status_t VnodeMinfs::AttachRemote(fs::MountChannel h) {
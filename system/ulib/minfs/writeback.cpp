@@ -60,31 +60,22 @@ void WriteTxn::Enqueue(zx_handle_t vmo, uint64_t vmo_offset, uint64_t dev_offset
     requests_.push_back(fbl::move(request));
 }
 
-zx_status_t WriteTxn::Flush(zx_handle_t vmo, vmoid_t vmoid) {
-    ZX_DEBUG_ASSERT(vmo != ZX_HANDLE_INVALID);
-    ZX_DEBUG_ASSERT(vmoid != VMOID_INVALID);
-
+size_t WriteTxn::BuildRequests(vmoid_t vmoid, block_fifo_request_t* out) const {
     // Update all the outgoing transactions to be in "disk blocks",
     // not "Minfs blocks".
-    block_fifo_request_t blk_reqs[requests_.size()];
     const uint32_t kDiskBlocksPerMinfsBlock = kMinfsBlockSize / bc_->DeviceBlockSize();
     for (size_t i = 0; i < requests_.size(); i++) {
-        blk_reqs[i].group = bc_->BlockGroupID();
-        blk_reqs[i].vmoid = vmoid;
-        blk_reqs[i].opcode = BLOCKIO_WRITE;
-        blk_reqs[i].vmo_offset = requests_[i].vmo_offset * kDiskBlocksPerMinfsBlock;
-        blk_reqs[i].dev_offset = requests_[i].dev_offset * kDiskBlocksPerMinfsBlock;
+        out[i].group = bc_->BlockGroupID();
+        out[i].vmoid = vmoid;
+        out[i].opcode = BLOCKIO_WRITE;
+        out[i].vmo_offset = requests_[i].vmo_offset * kDiskBlocksPerMinfsBlock;
+        out[i].dev_offset = requests_[i].dev_offset * kDiskBlocksPerMinfsBlock;
         // TODO(ZX-2253): Remove this assertion.
         uint64_t length = requests_[i].length * kDiskBlocksPerMinfsBlock;
         ZX_ASSERT_MSG(length < UINT32_MAX, "Too many blocks");
-        blk_reqs[i].length = static_cast<uint32_t>(length);
+        out[i].length = static_cast<uint32_t>(length);
     }
-
-    // Actually send the operations to the underlying block device.
-    zx_status_t status = bc_->Transaction(blk_reqs, requests_.size());
-
-    requests_.reset();
-    return status;
+    return requests_.size();
 }
 
 size_t WriteTxn::BlkCount() const {
@@ -99,7 +90,7 @@ size_t WriteTxn::BlkCount() const {
 
 WritebackWork::WritebackWork(Bcache* bc) : WriteTxn(bc),
 #ifdef __Fuchsia__
-    closure_(nullptr),
+    closure_(nullptr), device_flush_(false),
 #endif
     node_count_(0) {}
 
@@ -107,6 +98,7 @@ void WritebackWork::Reset() {
 #ifdef __Fuchsia__
     ZX_DEBUG_ASSERT(Requests().size() == 0);
     closure_ = nullptr;
+    device_flush_ = false;
 #endif
     while (0 < node_count_) {
         vn_[--node_count_] = nullptr;
@@ -114,15 +106,56 @@ void WritebackWork::Reset() {
 }
 
 #ifdef __Fuchsia__
-// Returns the number of blocks of the writeback buffer that have been
-// consumed
-size_t WritebackWork::Complete(zx_handle_t vmo, vmoid_t vmoid) {
-    size_t blk_count = BlkCount();
-    zx_status_t status = Flush(vmo, vmoid);
-    if (closure_) {
-        closure_(status);
+size_t WritebackWork::CompleteGroup(fbl::unique_ptr<WritebackWork>* works, size_t count,
+                                    zx_handle_t vmo, vmoid_t vmoid) {
+    ZX_DEBUG_ASSERT(count > 0);
+    ZX_DEBUG_ASSERT(vmo != ZX_HANDLE_INVALID);
+    ZX_DEBUG_ASSERT(vmoid != VMOID_INVALID);
+
+    size_t blk_count = 0;
+    size_t request_count = 0;
+    bool device_flush = false;
+    for (size_t i = 0; i < count; i++) {
+        blk_count += works[i]->BlkCount();
+        request_count += works[i]->Requests().size();
+        device_flush |= works[i]->device_flush_;
+    }
+
+    // One extra slot for the device flush, if any work asked for one.
+    block_fifo_request_t blk_reqs[request_count + 1];
+    size_t next = 0;
+    for (size_t i = 0; i < count; i++) {
+        size_t added = works[i]->BuildRequests(vmoid, &blk_reqs[next]);
+        if (added > 0 && next > 0) {
+            // The device may reorder requests within a transaction; keep
+            // each work's writes behind those of the works before it.
+            blk_reqs[next].opcode |= BLOCKIO_BARRIER_BEFORE;
+        }
+        next += added;
+        works[i]->Requests().reset();
+    }
+
+    // Every sync in the group shares a single flush of the device, issued
+    // after all of the group's writes.
+    if (device_flush) {
+        blk_reqs[next] = {};
+        blk_reqs[next].group = works[0]->bcache()->BlockGroupID();
+        blk_reqs[next].vmoid = vmoid;
+        blk_reqs[next].opcode = BLOCKIO_FLUSH | BLOCKIO_BARRIER_BEFORE;
+        next++;
+    }
+
+    zx_status_t status = ZX_OK;
+    if (next > 0) {
+        status = works[0]->bcache()->Transaction(blk_reqs, next);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (works[i]->closure_) {
+            works[i]->closure_(status);
+        }
+        works[i]->Reset();
     }
-    Reset();
     return blk_count;
 }
 
@@ -130,6 +163,10 @@ void WritebackWork::SetClosure(SyncCallback closure) {
     ZX_DEBUG_ASSERT(!closure_);
     closure_ = fbl::move(closure);
 }
+
+void WritebackWork::SetDeviceFlush() {
+    device_flush_ = true;
+}
 #else
 void WritebackWork::Complete() {
     Transact();
@@ -316,18 +353,35 @@ int WritebackBuffer::WritebackThread(void* arg) {
     b->writeback_lock_.Acquire();
     while (true) {
         while (!b->work_queue_.is_empty()) {
-            auto work = b->work_queue_.pop();
-            TRACE_DURATION("minfs", "WritebackBuffer::WritebackThread");
-
-            // Stay unlocked while processing a unit of work
+            // Take every queued work, up to the group limits, so that they
+            // (and any syncs among them) reach the disk together.
+            fbl::unique_ptr<WritebackWork> works[kMaxGroupWorks];
+            size_t count = 0;
+            size_t request_count = 0;
+            do {
+                size_t requests = b->work_queue_.front().Requests().size();
+                if (count > 0 && request_count + requests > kMaxGroupRequests) {
+                    break;
+                }
+                request_count += requests;
+                works[count++] = b->work_queue_.pop();
+            } while (count < kMaxGroupWorks && !b->work_queue_.is_empty());
+            TRACE_DURATION("minfs", "WritebackBuffer::WritebackThread", "works", count);
+
+            // Stay unlocked while processing the group
             b->writeback_lock_.Release();
 
             // TODO(smklein): We could add additional validation that the blocks
-            // in "work" are contiguous and in the range of [start_, len_) (including
+            // in "works" are contiguous and in the range of [start_, len_) (including
             // wraparound).
-            size_t blks_consumed = work->Complete(b->mapper_.vmo().get(), b->buffer_vmoid_);
-            TRACE_FLOW_END("minfs", "writeback", reinterpret_cast<trace_flow_id_t>(work.get()));
-            work = nullptr;
+            size_t blks_consumed = WritebackWork::CompleteGroup(works, count,
+                                                                b->mapper_.vmo().get(),
+                                                                b->buffer_vmoid_);
+            for (size_t i = 0; i < count; i++) {
+                TRACE_FLOW_END("minfs", "writeback",
+                               reinterpret_cast<trace_flow_id_t>(works[i].get()));
+                works[i] = nullptr;
+            }
 
             // Relock before checking the state of the queue
             b->writeback_lock_.Acquire();
@@ -31,6 +31,10 @@ struct SummaryStatistics {
     double mean;
     double std_dev;
     double median;
+    // 90th, 99th and 99.9th percentiles, for tracking tail latencies.
+    double p90;
+    double p99;
+    double p999;
 };
 
 // This represents the results for a particular test case.  It contains a
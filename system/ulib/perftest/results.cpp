@@ -49,21 +49,16 @@ int CompareDoubles(const void* ptr1, const void* ptr2) {
     return 0;
 }
 
-double Median(const fbl::Vector<double>& values) {
-    // Make a sorted copy of the vector.
-    fbl::Vector<double> copy;
-    copy.reserve(values.size());
-    for (double value : values) {
-        copy.push_back(value);
-    }
-    qsort(copy.get(), copy.size(), sizeof(copy[0]), CompareDoubles);
-
-    size_t index = copy.size() / 2;
-    // Interpolate two values if necessary.
-    if (copy.size() % 2 == 0) {
-        return (copy[index - 1] + copy[index]) / 2;
+// Returns the value below which |fraction| of the sorted |values| fall,
+// interpolating linearly between the two closest ranks.
+double Percentile(const fbl::Vector<double>& sorted, double fraction) {
+    double rank = fraction * static_cast<double>(sorted.size() - 1);
+    size_t index = static_cast<size_t>(rank);
+    if (index + 1 >= sorted.size()) {
+        return sorted[sorted.size() - 1];
     }
-    return copy[index];
+    double weight = rank - static_cast<double>(index);
+    return sorted[index] + (sorted[index + 1] - sorted[index]) * weight;
 }
 
 } // namespace
@@ -71,12 +66,24 @@ double Median(const fbl::Vector<double>& values) {
 SummaryStatistics TestCaseResults::GetSummaryStatistics() const {
     ZX_ASSERT(values.size() > 0);
     double mean = Mean(values);
+
+    // Make a sorted copy of the vector for the percentiles.
+    fbl::Vector<double> sorted;
+    sorted.reserve(values.size());
+    for (double value : values) {
+        sorted.push_back(value);
+    }
+    qsort(sorted.get(), sorted.size(), sizeof(sorted[0]), CompareDoubles);
+
     return SummaryStatistics{
         .min = Min(values),
         .max = Max(values),
         .mean = mean,
         .std_dev = StdDev(values, mean),
-        .median = Median(values),
+        .median = Percentile(sorted, 0.5),
+        .p90 = Percentile(sorted, 0.9),
+        .p99 = Percentile(sorted, 0.99),
+        .p999 = Percentile(sorted, 0.999),
     };
 }
 
@@ -171,17 +178,17 @@ bool ResultsSet::WriteJSONFile(const char* output_filename) const {
 
 void ResultsSet::PrintSummaryStatistics(FILE* out_file) const {
     // Print table headings row.
-    fprintf(out_file, "%10s %10s %10s %10s %10s %-12s %15s %s\n",
-            "Mean", "Std dev", "Min", "Max", "Median", "Unit",
-            "Mean Mbytes/sec", "Test case");
+    fprintf(out_file, "%10s %10s %10s %10s %10s %10s %10s %10s %-12s %15s %s\n",
+            "Mean", "Std dev", "Min", "Max", "Median", "90th %ile", "99th %ile", "99.9th %ile",
+            "Unit", "Mean Mbytes/sec", "Test case");
     if (results_.size() == 0) {
         fprintf(out_file, "(No test results)\n");
     }
     for (const auto& test : results_) {
         SummaryStatistics stats = test.GetSummaryStatistics();
-        fprintf(out_file, "%10.0f %10.0f %10.0f %10.0f %10.0f %-12s",
+        fprintf(out_file, "%10.0f %10.0f %10.0f %10.0f %10.0f %10.0f %10.0f %10.0f %-12s",
                 stats.mean, stats.std_dev, stats.min, stats.max, stats.median,
-                test.unit.c_str());
+                stats.p90, stats.p99, stats.p999, test.unit.c_str());
         // Output the throughput column.
         if (test.bytes_processed_per_run != 0 && test.unit == "nanoseconds") {
             double bytes_per_second =
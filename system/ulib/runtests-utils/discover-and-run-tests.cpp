@@ -35,6 +35,7 @@ int Usage(const char* name, const fbl::Vector<fbl::String>& default_test_dirs) {
     fprintf(stderr,
             "Usage: %s [-q|-v] [-S|-s] [-M|-m] [-L|-l] [-P|-p] [-a]\n"
             "    [-w timeout] [-t test names] [-o directory]       \n"
+            "    [-j workers] [-x test names]                      \n"
             "    [directory globs ...]                             \n"
             "    [-- [-args -to -the -test -bin]]                  \n"
             "\n"
@@ -75,6 +76,11 @@ int Usage(const char* name, const fbl::Vector<fbl::String>& default_test_dirs) {
             "   -w: Watchdog timeout                               \n"
             "       (accepts the timeout value in seconds)         \n"
             "       The default is up to each test.                \n"
+            "   -j: Run up to this many tests at a time            \n"
+            "       (requires -o; the default is 1)                \n"
+            "   -x: With -j, run these tests on their own, after   \n"
+            "       all the others                                 \n"
+            "       (accepts a comma-separated list)               \n"
             "\n"
             "If -o is enabled, then a JSON summary of the test     \n"
             "results will be written to a file named 'summary.json'\n"
@@ -134,12 +140,14 @@ int DiscoverAndRunTests(const RunTestFn& RunTest, int argc, const char* const* a
     signed char verbosity = -1;
     int watchdog_timeout_seconds = -1;
     const char* test_list_path = nullptr;
+    int worker_count = 1;
+    fbl::Vector<fbl::String> exclusive_tests;
 
     int c;
     // getopt uses global state, reset it.
     optind = 1;
     // Starting with + means don't modify |argv|.
-    static const char* kOptString = "+qvsmlpSMLPaht:o:f:w:";
+    static const char* kOptString = "+qvsmlpSMLPaht:o:f:w:j:x:";
     while ((c = getopt(argc, const_cast<char* const*>(argv), kOptString)) != -1) {
         switch (c) {
         case 'q':
@@ -198,6 +206,20 @@ int DiscoverAndRunTests(const RunTestFn& RunTest, int argc, const char* const* a
             watchdog_timeout_seconds = static_cast<int>(timeout);
             break;
         }
+        case 'j': {
+            const char* workers_str = optarg;
+            char* end;
+            long workers = strtol(workers_str, &end, 0);
+            if (*workers_str == '\0' || *end != '\0' || workers < 1 || workers > INT_MAX) {
+                fprintf(stderr, "Error: bad worker count\n");
+                return EXIT_FAILURE;
+            }
+            worker_count = static_cast<int>(workers);
+            break;
+        }
+        case 'x':
+            ParseTestNames(optarg, &exclusive_tests);
+            break;
         default:
             return Usage(argv[0], default_test_dirs);
         }
@@ -218,6 +240,11 @@ int DiscoverAndRunTests(const RunTestFn& RunTest, int argc, const char* const* a
         test_args.push_back(argv[i]);
     }
 
+    if (worker_count > 1 && output_dir == nullptr) {
+        fprintf(stderr, "Can't set -j without -o.\n");
+        return Usage(argv[0], default_test_dirs);
+    }
+
     if (test_list_path && !test_dir_globs.is_empty()) {
         fprintf(stderr, "Can't set both -f and directory globs.\n");
         return Usage(argv[0], default_test_dirs);
@@ -289,8 +316,14 @@ int DiscoverAndRunTests(const RunTestFn& RunTest, int argc, const char* const* a
     stopwatch->Start();
     int failed_count = 0;
     fbl::Vector<fbl::unique_ptr<Result>> results;
-    if (!RunTests(RunTest, test_paths, test_args, output_dir, kOutputFileName, verbosity,
-                  &failed_count, &results)) {
+    if (worker_count > 1) {
+        if (!RunTestsInParallel(RunTest, test_paths, test_args, output_dir, kOutputFileName,
+                                verbosity, worker_count, exclusive_tests, &failed_count,
+                                &results)) {
+            return EXIT_FAILURE;
+        }
+    } else if (!RunTests(RunTest, test_paths, test_args, output_dir, kOutputFileName,
+                         verbosity, &failed_count, &results)) {
         return EXIT_FAILURE;
     }
 
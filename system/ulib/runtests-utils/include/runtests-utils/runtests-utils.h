@@ -157,6 +157,26 @@ bool RunTests(const RunTestFn& RunTest, const fbl::Vector<fbl::String>& test_pat
               signed char verbosity, int* failed_count,
               fbl::Vector<fbl::unique_ptr<Result>>* results);
 
+// Executes all specified binaries, up to |worker_count| at a time.
+//
+// The arguments are as for RunTests, except:
+// |output_dir| must not be nullptr, so that the output of tests running
+//   concurrently is kept apart.
+// |exclusive_basenames| are the basenames of tests which must not run
+//   alongside any other test, such as performance tests or tests which need
+//   exclusive use of a device. These are run one at a time after all the
+//   others have finished.
+// Results are appended to |results| in the order of |test_paths|, however
+// the tests were scheduled.
+//
+// Returns false if the tests could not be run, true otherwise.
+bool RunTestsInParallel(const RunTestFn& RunTest, const fbl::Vector<fbl::String>& test_paths,
+                        const fbl::Vector<fbl::String>& test_args,
+                        const char* output_dir, const fbl::StringPiece output_file_basename,
+                        signed char verbosity, int worker_count,
+                        const fbl::Vector<fbl::String>& exclusive_basenames,
+                        int* failed_count, fbl::Vector<fbl::unique_ptr<Result>>* results);
+
 // Expands |dir_globs| and searches those directories for files.
 //
 // |dir_globs| are expanded as globs to directory names, and then those directories are searched.
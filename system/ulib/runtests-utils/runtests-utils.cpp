@@ -12,6 +12,7 @@
 #include <inttypes.h>
 #include <libgen.h>
 #include <limits.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -289,55 +290,194 @@ int DiscoverTestsInListFile(FILE* test_list_file, fbl::Vector<fbl::String>* test
     return 0;
 }
 
+namespace {
+
+// Runs the test binary at |test_path|, as described for RunTests.
+//
+// Returns nullptr if the test's output directory could not be created.
+fbl::unique_ptr<Result> RunOneTest(const RunTestFn& RunTest, const fbl::String& test_path,
+                                   const fbl::Vector<fbl::String>& test_args,
+                                   const char* output_dir,
+                                   const fbl::StringPiece output_file_basename,
+                                   signed char verbosity) {
+    fbl::String output_dir_for_test_str;
+    fbl::String output_filename_str;
+    // Ensure the output directory for this test binary's output exists.
+    if (output_dir != nullptr) {
+        // If output_dir was specified, ask |RunTest| to redirect stdout/stderr
+        // to a file whose name is based on the test name.
+        output_dir_for_test_str = runtests::JoinPath(output_dir, test_path);
+        const int error = runtests::MkDirAll(output_dir_for_test_str);
+        if (error) {
+            fprintf(stderr, "Error: Could not create output directory %s: %s\n",
+                    output_dir_for_test_str.c_str(), strerror(error));
+            return nullptr;
+        }
+        output_filename_str = JoinPath(output_dir_for_test_str, output_file_basename);
+    }
+
+    // Assemble test binary args.
+    fbl::Vector<const char*> argv;
+    argv.push_back(test_path.c_str());
+    fbl::String verbosity_arg;
+    if (verbosity >= 0) {
+        // verbosity defaults to -1: "unspecified". Only pass it along
+        // if it was specified: i.e., non-negative.
+        verbosity_arg = fbl::StringPrintf("v=%d", verbosity);
+        argv.push_back(verbosity_arg.c_str());
+    }
+    // Add in args to the test binary
+    argv.reserve(test_args.size());
+    for (auto test_arg = test_args.begin(); test_arg != test_args.end(); ++test_arg) {
+        argv.push_back(test_arg->c_str());
+    }
+    argv.push_back(nullptr); // Important, since there's no argc.
+    const char* output_dir_for_test =
+        output_dir_for_test_str.empty() ? nullptr : output_dir_for_test_str.c_str();
+    const char* output_filename =
+        output_filename_str.empty() ? nullptr : output_filename_str.c_str();
+
+    // Execute the test binary.
+    printf("\n------------------------------------------------\n"
+           "RUNNING TEST: %s\n\n",
+           test_path.c_str());
+    return RunTest(argv.get(), output_dir_for_test, output_filename);
+}
+
+// State shared by the worker threads of RunTestsInParallel.
+struct ParallelRun {
+    const RunTestFn* run_test;
+    const fbl::Vector<fbl::String>* test_paths;
+    const fbl::Vector<fbl::String>* test_args;
+    const char* output_dir;
+    fbl::StringPiece output_file_basename;
+    signed char verbosity;
+    // Indices into |test_paths| of the tests which may run concurrently.
+    const fbl::Vector<size_t>* queue;
+
+    pthread_mutex_t mutex;
+    // The guarded members below are only accessed with |mutex| held.
+    size_t next;
+    bool error;
+    // One slot per element of |test_paths|, so that results come out in the
+    // same order however the tests were scheduled.
+    fbl::Vector<fbl::unique_ptr<Result>>* slots;
+};
+
+void* ParallelRunWorker(void* arg) {
+    auto* run = static_cast<ParallelRun*>(arg);
+    for (;;) {
+        pthread_mutex_lock(&run->mutex);
+        if (run->error || run->next == run->queue->size()) {
+            pthread_mutex_unlock(&run->mutex);
+            return nullptr;
+        }
+        const size_t index = (*run->queue)[run->next++];
+        pthread_mutex_unlock(&run->mutex);
+
+        fbl::unique_ptr<Result> result =
+            RunOneTest(*run->run_test, (*run->test_paths)[index], *run->test_args,
+                       run->output_dir, run->output_file_basename, run->verbosity);
+
+        pthread_mutex_lock(&run->mutex);
+        if (result == nullptr) {
+            run->error = true;
+        }
+        (*run->slots)[index] = fbl::move(result);
+        pthread_mutex_unlock(&run->mutex);
+    }
+}
+
+} // namespace
+
 bool RunTests(const RunTestFn& RunTest, const fbl::Vector<fbl::String>& test_paths,
               const fbl::Vector<fbl::String>& test_args,
               const char* output_dir,
               const fbl::StringPiece output_file_basename, signed char verbosity, int* failed_count,
               fbl::Vector<fbl::unique_ptr<Result>>* results) {
     for (const fbl::String& test_path : test_paths) {
-        fbl::String output_dir_for_test_str;
-        fbl::String output_filename_str;
-        // Ensure the output directory for this test binary's output exists.
-        if (output_dir != nullptr) {
-            // If output_dir was specified, ask |RunTest| to redirect stdout/stderr
-            // to a file whose name is based on the test name.
-            output_dir_for_test_str = runtests::JoinPath(output_dir, test_path);
-            const int error = runtests::MkDirAll(output_dir_for_test_str);
-            if (error) {
-                fprintf(stderr, "Error: Could not create output directory %s: %s\n",
-                        output_dir_for_test_str.c_str(), strerror(error));
-                return false;
-            }
-            output_filename_str = JoinPath(output_dir_for_test_str, output_file_basename);
+        fbl::unique_ptr<Result> result = RunOneTest(RunTest, test_path, test_args, output_dir,
+                                                    output_file_basename, verbosity);
+        if (result == nullptr) {
+            return false;
         }
+        if (result->launch_status != SUCCESS) {
+            *failed_count += 1;
+        }
+        results->push_back(fbl::move(result));
+    }
+    return true;
+}
+
+bool RunTestsInParallel(const RunTestFn& RunTest, const fbl::Vector<fbl::String>& test_paths,
+                        const fbl::Vector<fbl::String>& test_args,
+                        const char* output_dir, const fbl::StringPiece output_file_basename,
+                        signed char verbosity, int worker_count,
+                        const fbl::Vector<fbl::String>& exclusive_basenames,
+                        int* failed_count, fbl::Vector<fbl::unique_ptr<Result>>* results) {
+    if (output_dir == nullptr || worker_count < 1) {
+        fprintf(stderr, "Error: Running tests in parallel needs an output directory\n");
+        return false;
+    }
+
+    fbl::Vector<size_t> parallel;
+    fbl::Vector<size_t> exclusive;
+    fbl::Vector<fbl::unique_ptr<Result>> slots;
+    slots.reserve(test_paths.size());
+    for (size_t i = 0; i < test_paths.size(); i++) {
+        const char* test_name = strrchr(test_paths[i].c_str(), '/');
+        test_name = test_name ? test_name + 1 : test_paths[i].c_str();
+        if (IsInWhitelist(test_name, exclusive_basenames)) {
+            exclusive.push_back(i);
+        } else {
+            parallel.push_back(i);
+        }
+        slots.push_back(nullptr);
+    }
 
-        // Assemble test binary args.
-        fbl::Vector<const char*> argv;
-        argv.push_back(test_path.c_str());
-        fbl::String verbosity_arg;
-        if (verbosity >= 0) {
-            // verbosity defaults to -1: "unspecified". Only pass it along
-            // if it was specified: i.e., non-negative.
-            verbosity_arg = fbl::StringPrintf("v=%d", verbosity);
-            argv.push_back(verbosity_arg.c_str());
+    ParallelRun run;
+    run.run_test = &RunTest;
+    run.test_paths = &test_paths;
+    run.test_args = &test_args;
+    run.output_dir = output_dir;
+    run.output_file_basename = output_file_basename;
+    run.verbosity = verbosity;
+    run.queue = &parallel;
+    pthread_mutex_init(&run.mutex, nullptr);
+    run.next = 0;
+    run.error = false;
+    run.slots = &slots;
+
+    // The calling thread is one of the workers.
+    fbl::Vector<pthread_t> threads;
+    for (int i = 1; i < worker_count && static_cast<size_t>(i) < parallel.size(); i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, nullptr, ParallelRunWorker, &run) != 0) {
+            fprintf(stderr, "Warning: Could not start test worker thread\n");
+            break;
         }
-        // Add in args to the test binary
-        argv.reserve(test_args.size());
-        for (auto test_arg = test_args.begin(); test_arg != test_args.end(); ++test_arg) {
-            argv.push_back(test_arg->c_str());
+        threads.push_back(thread);
+    }
+    ParallelRunWorker(&run);
+    for (pthread_t thread : threads) {
+        pthread_join(thread, nullptr);
+    }
+    pthread_mutex_destroy(&run.mutex);
+    if (run.error) {
+        return false;
+    }
+
+    // Tests which must not share the system with others run one at a time
+    // once everything else has finished.
+    for (size_t index : exclusive) {
+        slots[index] = RunOneTest(RunTest, test_paths[index], test_args, output_dir,
+                                  output_file_basename, verbosity);
+        if (slots[index] == nullptr) {
+            return false;
         }
-        argv.push_back(nullptr); // Important, since there's no argc.
-        const char* output_dir_for_test =
-            output_dir_for_test_str.empty() ? nullptr : output_dir_for_test_str.c_str();
-        const char* output_filename =
-            output_filename_str.empty() ? nullptr : output_filename_str.c_str();
-
-        // Execute the test binary.
-        printf("\n------------------------------------------------\n"
-               "RUNNING TEST: %s\n\n",
-               test_path.c_str());
-        fbl::unique_ptr<Result> result = RunTest(argv.get(), output_dir_for_test,
-                                                 output_filename);
+    }
+
+    for (fbl::unique_ptr<Result>& result : slots) {
         if (result->launch_status != SUCCESS) {
             *failed_count += 1;
         }
@@ -55,8 +55,9 @@ zx_status_t fx_logger::VLogWriteToSocket(fx_log_severity_t severity,
                                          const char* tag, const char* msg,
                                          va_list args, bool perform_format) {
     zx_time_t time = zx_clock_get_monotonic();
+    // Only the bytes up to the end of the message are sent, so there's no
+    // need to clear the rest of the packet.
     fx_log_packet_t packet;
-    memset(&packet, 0, sizeof(packet));
     constexpr size_t kDataSize = sizeof(packet.data);
     packet.metadata.pid = pid_;
     packet.metadata.tid = GetCurrentThreadKoid();
@@ -65,14 +66,8 @@ zx_status_t fx_logger::VLogWriteToSocket(fx_log_severity_t severity,
     packet.metadata.dropped_logs = dropped_logs_.load();
 
     // Write tags
-    size_t pos = 0;
-    for (size_t i = 0; i < tags_.size(); i++) {
-        size_t len = tags_[i].length();
-        ZX_DEBUG_ASSERT(len < 128);
-        packet.data[pos++] = static_cast<char>(len);
-        memcpy(packet.data + pos, tags_[i].c_str(), len);
-        pos += len;
-    }
+    size_t pos = encoded_tags_.length();
+    memcpy(packet.data, encoded_tags_.data(), pos);
     if (tag != NULL) {
         size_t len = strlen(tag);
         if (len > 0) {
@@ -232,6 +227,11 @@ zx_status_t fx_logger::AddTags(const char** tags, size_t ntags) {
             }
         } else {
             tags_.push_back(str);
+            // Tags are sent with every message: Encode them once.
+            ZX_DEBUG_ASSERT(str.length() < 128);
+            char len_byte = static_cast<char>(str.length());
+            encoded_tags_ = fbl::String::Concat(
+                {encoded_tags_, fbl::StringPiece(&len_byte, 1), str});
         }
     }
     return ZX_OK;
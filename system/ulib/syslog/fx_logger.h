@@ -90,6 +90,9 @@ private:
     zx::socket socket_;
     fbl::Vector<fbl::String> tags_;
 
+    // |tags_| in wire format: each tag preceded by its length.
+    fbl::String encoded_tags_;
+
     // This field is just used to close fd when
     // logger object goes out of scope
     fbl::unique_fd fd_to_close_;
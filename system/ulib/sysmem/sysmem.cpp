@@ -121,6 +121,10 @@ static zx_status_t Allocator_AllocateCollection(void* ctx,
                                                 fidl_txn_t* txn) {
     fuchsia_sysmem_BufferCollectionInfo info;
     memset(&info, 0, sizeof(info));
+    if (buffer_count > fbl::count_of(info.vmos)) {
+        FX_LOGF(ERROR, kTag, "Too many buffers requested (%u)\n", buffer_count);
+        return fuchsia_sysmem_AllocatorAllocateCollection_reply(txn, ZX_ERR_INVALID_ARGS, &info);
+    }
     // Most basic usage of the allocator: create vmos with no special vendor format:
     // 1) Pick which format gets used.  For the simple case, just use whatever format was given.
     //    We also assume here that the format is an ImageFormat
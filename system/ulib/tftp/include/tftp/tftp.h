@@ -253,6 +253,11 @@ tftp_status tftp_set_options(tftp_session* session,
 // before sending additional data packets.
 bool tftp_session_has_pending(tftp_session* session);
 
+// Returns the number of times the remote host acknowledged only part of a
+// window of DATA packets, meaning that the rest were lost. Senders may use it
+// to pace their transmissions.
+uint32_t tftp_session_get_lost_windows(tftp_session* session);
+
 // Prepare a DATA packet to send to the remote host. This is only required when
 // tftp_session_has_pending(session) returns true, as tftp_process_msg() will
 // prepare the first DATA message in each window.
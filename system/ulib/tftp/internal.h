@@ -163,6 +163,9 @@ struct tftp_session_t {
     uint64_t block_number;
     uint32_t window_index;
 
+    // Number of windows the remote host acknowledged only part of.
+    uint32_t lost_windows;
+
     // Maximum number of times we will retransmit a single msg before aborting
     uint16_t max_timeouts;
 
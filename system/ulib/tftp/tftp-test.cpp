@@ -1643,6 +1643,58 @@ static bool test_tftp_send_data_receive_ack_window_size(void) {
     END_TEST;
 }
 
+static bool test_tftp_send_data_receive_ack_lost_window(void) {
+    uint16_t kWindowSize = 2;
+    BEGIN_TEST;
+
+    test_state ts;
+    ts.reset(1024, 2048, 1500);
+
+    auto status = tftp_generate_request(ts.session, SEND_FILE, kLocalFilename, kRemoteFilename,
+        MODE_OCTET, ts.msg_size, NULL, NULL, &kWindowSize, ts.out, &ts.outlen, &ts.timeout);
+    EXPECT_EQ(TFTP_NO_ERROR, status, "error generating write request");
+
+    uint8_t oack_buf[] = {
+        0x00, 0x06,                     // Opcode (OACK)
+        'T', 'S', 'I', 'Z', 'E', 0x00,  // Option
+        '2', '0', '4', '8', 0x00,       // TSIZE value
+        'W', 'I', 'N', 'D', 'O', 'W', 'S', 'I', 'Z', 'E', 0x00,      // Option
+        '2', 0x00,                                              // WINDOWSIZE value
+    };
+
+    tftp_file_interface ifc = {NULL, NULL, mock_read, NULL, NULL};
+    tftp_session_set_file_interface(ts.session, &ifc);
+
+    tx_test_data td;
+    status = tftp_process_msg(ts.session, oack_buf, sizeof(oack_buf), ts.out, &ts.outlen, &ts.timeout, &td);
+    ASSERT_EQ(TFTP_NO_ERROR, status, "receive error");
+    status = tftp_prepare_data(ts.session, ts.out, &ts.outlen, &ts.timeout, &td);
+    ASSERT_EQ(TFTP_NO_ERROR, status, "error preparing data");
+    ASSERT_FALSE(tftp_session_has_pending(ts.session), "expected to wait for ack");
+    EXPECT_EQ(0, tftp_session_get_lost_windows(ts.session), "no window should be lost yet");
+
+    // Only the first block of the window made it
+    uint8_t ack_buf[] = {
+        0x00, 0x04,  // Opcode (ACK)
+        0x00, 0x01,  // Block
+    };
+    status = tftp_process_msg(ts.session, ack_buf, sizeof(ack_buf), ts.out, &ts.outlen, &ts.timeout, &td);
+    ASSERT_EQ(TFTP_NO_ERROR, status, "receive error");
+    EXPECT_EQ(1, ts.session->block_number, "tftp session block number mismatch");
+    EXPECT_EQ(1, tftp_session_get_lost_windows(ts.session), "lost window not counted");
+
+    // The whole of the next window made it
+    status = tftp_prepare_data(ts.session, ts.out, &ts.outlen, &ts.timeout, &td);
+    ASSERT_EQ(TFTP_NO_ERROR, status, "error preparing data");
+    ack_buf[3] = 3;
+    status = tftp_process_msg(ts.session, ack_buf, sizeof(ack_buf), ts.out, &ts.outlen, &ts.timeout, &td);
+    ASSERT_EQ(TFTP_NO_ERROR, status, "receive error");
+    EXPECT_EQ(3, ts.session->block_number, "tftp session block number mismatch");
+    EXPECT_EQ(1, tftp_session_get_lost_windows(ts.session), "complete window counted as lost");
+
+    END_TEST;
+}
+
 static bool test_tftp_send_data_receive_ack_block_wrapping(void) {
     BEGIN_TEST;
 
@@ -2052,6 +2104,7 @@ RUN_TEST(test_tftp_send_data_receive_ack)
 RUN_TEST(test_tftp_send_data_receive_final_ack)
 RUN_TEST(test_tftp_send_data_receive_ack_skipped_block)
 RUN_TEST(test_tftp_send_data_receive_ack_window_size)
+RUN_TEST(test_tftp_send_data_receive_ack_lost_window)
 RUN_TEST(test_tftp_send_data_receive_ack_block_wrapping)
 RUN_TEST(test_tftp_send_data_receive_ack_skip_block_wrap)
 END_TEST_CASE(tftp_send_data)
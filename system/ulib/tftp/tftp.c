@@ -270,6 +270,10 @@ bool tftp_session_has_pending(tftp_session* session) {
             session->file_size;
 }
 
+uint32_t tftp_session_get_lost_windows(tftp_session* session) {
+    return session->lost_windows;
+}
+
 tftp_status tftp_set_options(tftp_session* session, const uint16_t* block_size,
                              const uint8_t* timeout, const uint16_t* window_size) {
     session->options.mask = 0;
@@ -800,6 +804,9 @@ tftp_status tftp_handle_ack(tftp_session* session,
             session->opcode_prefix++;
         }
     }
+    if (block_offset >= 0 && block_offset < session->window_index) {
+        session->lost_windows++;
+    }
     session->state = SENDING_DATA;
     session->block_number += block_offset;
     session->window_index = 0;
@@ -87,6 +87,37 @@ namespace {
 // The next context generation number.
 fbl::atomic<uint32_t> g_next_generation{1u};
 
+// The part of the rolling buffer this thread is currently filling.
+// See |trace_context::kRollingChunkSize|.
+struct RollingChunk {
+    // The generation of the context the chunk was allocated from,
+    // or 0 if there is no chunk.
+    uint32_t generation;
+    // The wrapped count at the time the chunk was allocated.
+    // The chunk is abandoned once the context switches buffers.
+    uint32_t wrapped_count;
+    uint8_t* ptr;
+    uint8_t* end;
+};
+thread_local RollingChunk tls_rolling_chunk{};
+
+// Takes |num_bytes| from the front of |chunk|, and covers what remains
+// with a padding record so the buffer stays readable if this thread writes
+// nothing more to it.
+uint64_t* TakeFromRollingChunk(RollingChunk* chunk, size_t num_bytes) {
+    uint8_t* ptr = chunk->ptr;
+    chunk->ptr += num_bytes;
+    size_t remaining = chunk->end - chunk->ptr;
+    if (remaining != 0u) {
+        *reinterpret_cast<uint64_t*>(chunk->ptr) =
+            MetadataRecordFields::Type::Make(ToUnderlyingType(RecordType::kMetadata)) |
+            MetadataRecordFields::RecordSize::Make(BytesToWords(remaining)) |
+            MetadataRecordFields::MetadataType::Make(
+                ToUnderlyingType(MetadataType::kPadding));
+    }
+    return reinterpret_cast<uint64_t*>(ptr);
+}
+
 } // namespace
 } // namespace trace
 
@@ -113,6 +144,35 @@ uint64_t* trace_context::AllocRecord(size_t num_bytes) {
         return nullptr;
     static_assert(TRACE_ENCODED_RECORD_MAX_LENGTH < kMaxRollingBufferSize, "");
 
+    uint32_t wrapped_count;
+    if (!use_rolling_chunks_ || num_bytes > kRollingChunkSize)
+        return AllocRollingRecord(num_bytes, &wrapped_count);
+
+    // Fast path: The record fits in this thread's chunk, and the chunk
+    // is still in the buffer being written to.
+    trace::RollingChunk* chunk = &trace::tls_rolling_chunk;
+    if (likely(chunk->generation == generation_ &&
+               chunk->wrapped_count == CurrentWrappedCount() &&
+               num_bytes <= static_cast<size_t>(chunk->end - chunk->ptr))) {
+        return trace::TakeFromRollingChunk(chunk, num_bytes);
+    }
+
+    // The tail of the previous chunk, if any, is already covered by
+    // padding: Simply drop it and allocate a new one.
+    uint64_t* ptr = AllocRollingRecord(kRollingChunkSize, &wrapped_count);
+    if (unlikely(!ptr)) {
+        chunk->generation = 0u;
+        return nullptr;
+    }
+    chunk->generation = generation_;
+    chunk->wrapped_count = wrapped_count;
+    chunk->ptr = reinterpret_cast<uint8_t*>(ptr);
+    chunk->end = chunk->ptr + kRollingChunkSize;
+    return trace::TakeFromRollingChunk(chunk, num_bytes);
+}
+
+uint64_t* trace_context::AllocRollingRecord(size_t num_bytes,
+                                            uint32_t* out_wrapped_count) {
     // For the circular and streaming cases, try at most once for each buffer.
     // Note: Keep the normal case of one successful pass the fast path.
     // E.g., We don't do a mode comparison unless we have to.
@@ -128,6 +188,7 @@ uint64_t* trace_context::AllocRecord(size_t num_bytes) {
         // Note: There's no worry of an overflow in the calcs here.
         if (likely(buffer_offset + num_bytes <= rolling_buffer_size_)) {
             uint8_t* ptr = rolling_buffer_start_[buffer_number] + buffer_offset;
+            *out_wrapped_count = wrapped_count;
             return reinterpret_cast<uint64_t*>(ptr); // success!
         }
 
@@ -372,6 +433,8 @@ void trace_context::ComputeBufferSizes() {
         __UNREACHABLE;
     }
 
+    use_rolling_chunks_ = rolling_buffer_size_ >= kMinChunkedRollingBufferSize;
+
     durable_buffer_current_.store(0);
     durable_buffer_full_mark_.store(0);
     rolling_buffer_current_.store(0);
@@ -121,6 +121,19 @@ private:
 
     static_assert(kBufferOffsetBits + kWrappedCounterBits <= 64, "");
 
+    // The size, in bytes, of the chunks each thread carves out of the
+    // rolling buffer and then fills with its own records.
+    // This keeps writers from all bumping |rolling_buffer_current_| for
+    // every record. The unused tail of a chunk is covered by a padding
+    // record, so a chunk can be no larger than one record.
+    static constexpr size_t kRollingChunkSize = 4096;
+
+    static_assert(kRollingChunkSize <= TRACE_ENCODED_RECORD_MAX_LENGTH, "");
+
+    // Rolling buffers smaller than this are shared by all threads one
+    // record at a time: Chunks would waste too much of them.
+    static constexpr size_t kMinChunkedRollingBufferSize = 64 * kRollingChunkSize;
+
     // The physical buffer must be at least this big.
     // Mostly this is here to simplify buffer size calculations.
     // It's as small as it is to simplify some testcases.
@@ -200,6 +213,8 @@ private:
 
     void ComputeBufferSizes();
 
+    uint64_t* AllocRollingRecord(size_t num_bytes, uint32_t* out_wrapped_count);
+
     void MarkDurableBufferFull(uint64_t last_offset);
 
     void MarkOneshotBufferFull(uint64_t last_offset);
@@ -263,6 +278,10 @@ private:
     // The size of both rolling buffers.
     size_t rolling_buffer_size_;
 
+    // True if threads allocate records from per-thread chunks of the
+    // rolling buffers. See |kRollingChunkSize|.
+    bool use_rolling_chunks_;
+
     // Current allocation pointer for durable records.
     // This only used in circular and streaming modes.
     // Starts at |durable_buffer_start| and grows from there.
@@ -0,0 +1,188 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <fbl/function.h>
+#include <fbl/intrusive_hash_table.h>
+#include <fbl/macros.h>
+#include <fbl/string.h>
+#include <fbl/string_piece.h>
+#include <fbl/unique_ptr.h>
+#include <fbl/vector.h>
+#include <trace-reader/records.h>
+
+namespace trace {
+
+// A histogram of durations, in nanoseconds, with power-of-two buckets.
+// Bucket |i| counts values in [2^(i-1), 2^i), bucket 0 counts zeros.
+class Histogram final {
+public:
+    static constexpr size_t kNumBuckets = 65;
+
+    Histogram() = default;
+
+    void Add(uint64_t value);
+
+    uint64_t count() const { return count_; }
+    uint64_t total() const { return total_; }
+    uint64_t min() const { return count_ ? min_ : 0u; }
+    uint64_t max() const { return max_; }
+    uint64_t bucket(size_t index) const { return buckets_[index]; }
+
+    // Returns an upper bound for the value below which |percent| of the
+    // values fall, or 0 if the histogram is empty.
+    uint64_t Percentile(uint32_t percent) const;
+
+private:
+    uint64_t count_ = 0u;
+    uint64_t total_ = 0u;
+    uint64_t min_ = UINT64_MAX;
+    uint64_t max_ = 0u;
+    uint64_t buckets_[kNumBuckets] = {};
+};
+
+// Statistics gathered for one category and name.
+struct NamedStats {
+    fbl::String category;
+    fbl::String name;
+    Histogram durations;
+};
+
+// Statistics gathered for one thread.
+struct ThreadStats {
+    ProcessThread process_thread;
+    // Nanoseconds the thread spent running, according to context switches.
+    uint64_t running_time = 0u;
+    // The number of times the thread was switched in.
+    uint64_t switch_count = 0u;
+};
+
+// Aggregates the records of a trace into per-event summaries as they are
+// read, so that large traces can be analyzed without keeping the records.
+// Computes:
+// - duration histograms per category and name, from duration begin/end
+//   pairs on each thread,
+// - flow latency histograms per category and name of the flow begin event,
+//   from flow begin to flow end,
+// - running time per thread, from context switch records.
+class TraceSummary final {
+public:
+    TraceSummary();
+    ~TraceSummary();
+
+    // Accounts for |record|. Records must be passed in trace order.
+    void AddRecord(const Record& record);
+
+    // The number of duration end events which had no matching begin event.
+    uint64_t unmatched_duration_ends() const { return unmatched_duration_ends_; }
+
+    // The number of flow end events which had no matching begin event.
+    uint64_t unmatched_flow_ends() const { return unmatched_flow_ends_; }
+
+    void ForEachDuration(fbl::Function<void(const NamedStats&)> callback) const;
+    void ForEachFlow(fbl::Function<void(const NamedStats&)> callback) const;
+    void ForEachThread(fbl::Function<void(const ThreadStats&)> callback) const;
+
+private:
+    struct NameKey {
+        fbl::StringPiece category;
+        fbl::StringPiece name;
+
+        bool operator==(const NameKey& other) const {
+            return category == other.category && name == other.name;
+        }
+    };
+
+    struct NamedEntry : public fbl::SinglyLinkedListable<fbl::unique_ptr<NamedEntry>> {
+        NamedStats stats;
+
+        // Used by the hash table.
+        NameKey GetKey() const { return NameKey{stats.category, stats.name}; }
+        static size_t GetHash(const NameKey& key);
+    };
+
+    struct OpenDuration {
+        trace_ticks_t begin;
+        NamedEntry* entry;
+    };
+
+    struct ThreadEntry : public fbl::SinglyLinkedListable<fbl::unique_ptr<ThreadEntry>> {
+        ThreadStats stats;
+        // Durations begun but not yet ended, innermost last.
+        fbl::Vector<OpenDuration> open_durations;
+
+        // Used by the hash table.
+        ProcessThread GetKey() const { return stats.process_thread; }
+        static size_t GetHash(const ProcessThread& key) {
+            return key.process_koid() * 31u + key.thread_koid();
+        }
+    };
+
+    struct FlowKey {
+        zx_koid_t process_koid;
+        trace_flow_id_t id;
+
+        bool operator==(const FlowKey& other) const {
+            return process_koid == other.process_koid && id == other.id;
+        }
+    };
+
+    struct FlowEntry : public fbl::SinglyLinkedListable<fbl::unique_ptr<FlowEntry>> {
+        FlowKey key;
+        trace_ticks_t begin;
+        NamedEntry* entry;
+
+        // Used by the hash table.
+        FlowKey GetKey() const { return key; }
+        static size_t GetHash(const FlowKey& key) {
+            return key.process_koid * 31u + key.id;
+        }
+    };
+
+    struct CpuState {
+        // False until the first context switch on the cpu is seen.
+        bool valid;
+        trace_ticks_t last_switch;
+    };
+
+    static constexpr size_t kNumHashBuckets = 1021;
+
+    using NamedTable = fbl::HashTable<NameKey, fbl::unique_ptr<NamedEntry>,
+                                      fbl::SinglyLinkedList<fbl::unique_ptr<NamedEntry>>,
+                                      size_t, kNumHashBuckets>;
+    using ThreadTable = fbl::HashTable<ProcessThread, fbl::unique_ptr<ThreadEntry>,
+                                       fbl::SinglyLinkedList<fbl::unique_ptr<ThreadEntry>>,
+                                       size_t, kNumHashBuckets>;
+    using FlowTable = fbl::HashTable<FlowKey, fbl::unique_ptr<FlowEntry>,
+                                     fbl::SinglyLinkedList<fbl::unique_ptr<FlowEntry>>,
+                                     size_t, kNumHashBuckets>;
+
+    void AddEvent(const Record::Event& event);
+    void AddContextSwitch(const Record::ContextSwitch& context_switch);
+
+    uint64_t TicksToNanoseconds(trace_ticks_t ticks) const;
+
+    static NamedEntry* GetNamedEntry(NamedTable* table, const fbl::String& category,
+                                     const fbl::String& name);
+    ThreadEntry* GetThreadEntry(const ProcessThread& process_thread);
+
+    // Until told otherwise, 1 tick is 1 nanosecond.
+    trace_ticks_t ticks_per_second_ = 1000000000u;
+
+    NamedTable durations_;
+    NamedTable flows_;
+    ThreadTable threads_;
+    FlowTable open_flows_;
+    fbl::Vector<CpuState> cpus_;
+
+    uint64_t unmatched_duration_ends_ = 0u;
+    uint64_t unmatched_flow_ends_ = 0u;
+
+    DISALLOW_COPY_ASSIGN_AND_MOVE(TraceSummary);
+};
+
+} // namespace trace
@@ -14,7 +14,8 @@ MODULE_COMPILEFLAGS += -fvisibility=hidden
 MODULE_SRCS = \
     $(LOCAL_DIR)/reader.cpp \
     $(LOCAL_DIR)/reader_internal.cpp \
-    $(LOCAL_DIR)/records.cpp
+    $(LOCAL_DIR)/records.cpp \
+    $(LOCAL_DIR)/summary.cpp
 
 MODULE_STATIC_LIBS := \
     system/ulib/trace-engine \
@@ -37,7 +38,8 @@ MODULE_COMPILEFLAGS += -fvisibility=hidden
 
 MODULE_SRCS = \
     $(LOCAL_DIR)/reader.cpp \
-    $(LOCAL_DIR)/records.cpp
+    $(LOCAL_DIR)/records.cpp \
+    $(LOCAL_DIR)/summary.cpp
 
 MODULE_COMPILEFLAGS := \
     -Isystem/ulib/trace-engine/include \
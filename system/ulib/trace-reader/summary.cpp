@@ -0,0 +1,188 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <trace-reader/summary.h>
+
+#include <fbl/algorithm.h>
+
+namespace trace {
+namespace {
+
+constexpr uint64_t kNanosecondsPerSecond = 1000000000u;
+
+size_t HashString(size_t hash, const fbl::StringPiece& string) {
+    // FNV-1a.
+    for (size_t i = 0; i < string.length(); i++) {
+        hash ^= static_cast<uint8_t>(string[i]);
+        hash *= 1099511628211u;
+    }
+    return hash;
+}
+
+} // namespace
+
+void Histogram::Add(uint64_t value) {
+    size_t index = value ? 64 - __builtin_clzll(value) : 0u;
+    buckets_[index]++;
+    count_++;
+    total_ += value;
+    min_ = fbl::min(min_, value);
+    max_ = fbl::max(max_, value);
+}
+
+uint64_t Histogram::Percentile(uint32_t percent) const {
+    uint64_t threshold = (count_ * percent + 99u) / 100u;
+    uint64_t seen = 0u;
+    for (size_t i = 0; i < kNumBuckets; i++) {
+        seen += buckets_[i];
+        if (seen != 0u && seen >= threshold) {
+            if (i == 0)
+                return 0u;
+            uint64_t limit = i == 64 ? UINT64_MAX : (1ull << i) - 1u;
+            return fbl::min(limit, max_);
+        }
+    }
+    return max_;
+}
+
+size_t TraceSummary::NamedEntry::GetHash(const NameKey& key) {
+    size_t hash = HashString(14695981039346656037u, key.category);
+    return HashString(hash ^ '/', key.name);
+}
+
+TraceSummary::TraceSummary() = default;
+
+TraceSummary::~TraceSummary() = default;
+
+void TraceSummary::AddRecord(const Record& record) {
+    switch (record.type()) {
+    case RecordType::kInitialization:
+        ticks_per_second_ = record.GetInitialization().ticks_per_second;
+        break;
+    case RecordType::kEvent:
+        AddEvent(record.GetEvent());
+        break;
+    case RecordType::kContextSwitch:
+        AddContextSwitch(record.GetContextSwitch());
+        break;
+    default:
+        break;
+    }
+}
+
+void TraceSummary::AddEvent(const Record::Event& event) {
+    switch (event.type()) {
+    case EventType::kDurationBegin: {
+        NamedEntry* entry = GetNamedEntry(&durations_, event.category, event.name);
+        GetThreadEntry(event.process_thread)->open_durations.push_back(
+            OpenDuration{event.timestamp, entry});
+        break;
+    }
+    case EventType::kDurationEnd: {
+        ThreadEntry* thread = GetThreadEntry(event.process_thread);
+        if (thread->open_durations.is_empty()) {
+            unmatched_duration_ends_++;
+            break;
+        }
+        OpenDuration open = thread->open_durations.erase(thread->open_durations.size() - 1);
+        open.entry->stats.durations.Add(TicksToNanoseconds(event.timestamp - open.begin));
+        break;
+    }
+    case EventType::kFlowBegin: {
+        FlowKey key{event.process_thread.process_koid(), event.data.GetFlowBegin().id};
+        NamedEntry* entry = GetNamedEntry(&flows_, event.category, event.name);
+        auto it = open_flows_.find(key);
+        if (it.IsValid()) {
+            // The id was reused before the flow ended: Start over.
+            it->begin = event.timestamp;
+            it->entry = entry;
+            break;
+        }
+        fbl::unique_ptr<FlowEntry> flow(new FlowEntry());
+        flow->key = key;
+        flow->begin = event.timestamp;
+        flow->entry = entry;
+        open_flows_.insert(fbl::move(flow));
+        break;
+    }
+    case EventType::kFlowEnd: {
+        FlowKey key{event.process_thread.process_koid(), event.data.GetFlowEnd().id};
+        fbl::unique_ptr<FlowEntry> flow = open_flows_.erase(key);
+        if (!flow) {
+            unmatched_flow_ends_++;
+            break;
+        }
+        flow->entry->stats.durations.Add(TicksToNanoseconds(event.timestamp - flow->begin));
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void TraceSummary::AddContextSwitch(const Record::ContextSwitch& context_switch) {
+    size_t cpu = context_switch.cpu_number;
+    while (cpus_.size() <= cpu)
+        cpus_.push_back(CpuState{false, 0u});
+
+    CpuState* state = &cpus_[cpu];
+    if (state->valid && context_switch.outgoing_thread) {
+        GetThreadEntry(context_switch.outgoing_thread)->stats.running_time +=
+            TicksToNanoseconds(context_switch.timestamp - state->last_switch);
+    }
+    if (context_switch.incoming_thread)
+        GetThreadEntry(context_switch.incoming_thread)->stats.switch_count++;
+    state->valid = true;
+    state->last_switch = context_switch.timestamp;
+}
+
+uint64_t TraceSummary::TicksToNanoseconds(trace_ticks_t ticks) const {
+    // Split the conversion to avoid overflowing for long traces.
+    return ticks / ticks_per_second_ * kNanosecondsPerSecond +
+           ticks % ticks_per_second_ * kNanosecondsPerSecond / ticks_per_second_;
+}
+
+TraceSummary::NamedEntry* TraceSummary::GetNamedEntry(NamedTable* table,
+                                                      const fbl::String& category,
+                                                      const fbl::String& name) {
+    auto it = table->find(NameKey{category, name});
+    if (it.IsValid())
+        return &*it;
+
+    fbl::unique_ptr<NamedEntry> entry(new NamedEntry());
+    entry->stats.category = category;
+    entry->stats.name = name;
+    NamedEntry* result = entry.get();
+    table->insert(fbl::move(entry));
+    return result;
+}
+
+TraceSummary::ThreadEntry* TraceSummary::GetThreadEntry(const ProcessThread& process_thread) {
+    auto it = threads_.find(process_thread);
+    if (it.IsValid())
+        return &*it;
+
+    fbl::unique_ptr<ThreadEntry> entry(new ThreadEntry());
+    entry->stats.process_thread = process_thread;
+    ThreadEntry* result = entry.get();
+    threads_.insert(fbl::move(entry));
+    return result;
+}
+
+void TraceSummary::ForEachDuration(fbl::Function<void(const NamedStats&)> callback) const {
+    for (const auto& entry : durations_)
+        callback(entry.stats);
+}
+
+void TraceSummary::ForEachFlow(fbl::Function<void(const NamedStats&)> callback) const {
+    for (const auto& entry : flows_)
+        callback(entry.stats);
+}
+
+void TraceSummary::ForEachThread(fbl::Function<void(const ThreadStats&)> callback) const {
+    for (const auto& entry : threads_)
+        callback(entry.stats);
+}
+
+} // namespace trace
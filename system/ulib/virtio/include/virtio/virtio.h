@@ -50,6 +50,9 @@
 #define VIRTIO_PCI_CONFIG_OFFSET_NOMSIX             0x14    // uint16_t
 #define VIRTIO_PCI_CONFIG_OFFSET_MSIX               0x18    // uint16_t
 
+// Written to an MSI-X vector field to leave the event without an interrupt.
+#define VIRTIO_MSI_NO_VECTOR                        0xffff
+
 #define VIRTIO_PCI_CAP_COMMON_CFG                   1
 #define VIRTIO_PCI_CAP_NOTIFY_CFG                   2
 #define VIRTIO_PCI_CAP_ISR_CFG                      3
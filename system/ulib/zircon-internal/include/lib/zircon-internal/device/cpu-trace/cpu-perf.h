@@ -72,6 +72,8 @@ typedef enum {
   CPUPERF_RECORD_PC = 5,
   // The record is a |cpuperf_last_branch_record_t|.
   CPUPERF_RECORD_LAST_BRANCH = 6,
+  // The record is a |cpuperf_thread_pc_record_t|.
+  CPUPERF_RECORD_THREAD_PC = 7,
 } cpuperf_record_type_t;
 
 // Trace buffer space is expensive, we want to keep records small.
@@ -193,6 +195,20 @@ typedef struct {
     uint64_t pc;
 } CPUPERF_ALIGN_RECORD cpuperf_pc_record_t;
 
+// Record the process, thread and pc values.
+// This is used instead of |cpuperf_pc_record_t| when the event has
+// CPUPERF_CONFIG_FLAG_THREAD set, and otherwise has the same meaning.
+// Unlike the aspace of a PC record, the koids can be used to look up
+// the process's mappings and symbolize the pc.
+typedef struct {
+    cpuperf_record_header_t header;
+    // The koids of the process and thread running at the time data was
+    // collected. Both are zero for kernel threads.
+    zx_koid_t pid;
+    zx_koid_t tid;
+    uint64_t pc;
+} CPUPERF_ALIGN_RECORD cpuperf_thread_pc_record_t;
+
 // Entry in a last branch record.
 typedef struct  {
     uint64_t from;
@@ -301,7 +317,7 @@ typedef struct {
     // TODO(dje): hypervisor, host/guest os/user
     uint32_t flags[CPUPERF_MAX_EVENTS];
 // Valid bits in |flags|.
-#define CPUPERF_CONFIG_FLAG_MASK      0x1f
+#define CPUPERF_CONFIG_FLAG_MASK      0x3f
 // Collect os data.
 #define CPUPERF_CONFIG_FLAG_OS        (1u << 0)
 // Collect userspace data.
@@ -319,6 +335,9 @@ typedef struct {
 // This is only available when the underlying system supports it.
 // TODO(dje): Provide knob to specify how many branches.
 #define CPUPERF_CONFIG_FLAG_LAST_BRANCH (1u << 4)
+// Collect process+thread+pc values, emitted as CPUPERF_RECORD_THREAD_PC
+// records. Requires CPUPERF_CONFIG_FLAG_PC.
+#define CPUPERF_CONFIG_FLAG_THREAD    (1u << 5)
 } cpuperf_config_t;
 
 ///////////////////////////////////////////////////////////////////////////////
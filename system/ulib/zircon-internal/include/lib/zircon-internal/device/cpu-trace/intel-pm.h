@@ -397,7 +397,7 @@ typedef struct {
     uint32_t programmable_flags[IPM_MAX_PROGRAMMABLE_COUNTERS];
     uint32_t misc_flags[IPM_MAX_MISC_EVENTS];
 // Both of IPM_CONFIG_FLAG_{PC,TIMEBASE} cannot be set.
-#define IPM_CONFIG_FLAG_MASK     0x7
+#define IPM_CONFIG_FLAG_MASK     0xf
 // Collect aspace+pc values.
 // Cannot be set with IPM_CONFIG_FLAG_TIMEBASE unless the counter is
 // |timebase_id|.
@@ -411,6 +411,9 @@ typedef struct {
 // |timebase_id|.
 // This is only available when the underlying system supports it.
 #define IPM_CONFIG_FLAG_LBR      (1u << 2)
+// Collect process+thread+pc values instead of aspace+pc values.
+// Cannot be set without IPM_CONFIG_FLAG_PC.
+#define IPM_CONFIG_FLAG_THREAD   (1u << 3)
 
     // IA32_PERFEVTSEL_*
     uint64_t programmable_events[IPM_MAX_PROGRAMMABLE_COUNTERS];
@@ -330,6 +330,18 @@ IOCTL_WRAPPER(ioctl_insntrace_start, IOCTL_INSNTRACE_START);
     IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_INSNTRACE, 11)
 IOCTL_WRAPPER(ioctl_insntrace_stop, IOCTL_INSNTRACE_STOP);
 
+// get the current trace data of a buffer without stopping tracing
+// Only supported when tracing cpus. Tracing on the buffer's cpu is paused
+// just long enough to flush its packets to memory. With a circular buffer
+// the latest window of the trace then ends at |capture_end|, and the oldest
+// data starts right after it and is overwritten as tracing continues.
+// Input: zx_itrace_buffer_descriptor_t
+// Output: ioctl_insntrace_buffer_info_t
+#define IOCTL_INSNTRACE_SNAPSHOT_BUFFER_INFO \
+    IOCTL(IOCTL_KIND_DEFAULT, IOCTL_FAMILY_INSNTRACE, 12)
+IOCTL_WRAPPER_INOUT(ioctl_insntrace_snapshot_buffer_info, IOCTL_INSNTRACE_SNAPSHOT_BUFFER_INFO,
+                    zx_itrace_buffer_descriptor_t, ioctl_insntrace_buffer_info_t);
+
 #endif // __Fuchsia__
 
 __END_CDECLS
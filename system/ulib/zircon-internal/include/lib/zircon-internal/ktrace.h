@@ -33,6 +33,7 @@ __BEGIN_CDECLS
 #define KTRACE_RECSIZE            (32)
 #define KTRACE_NAMESIZE           (12)
 #define KTRACE_NAMEOFF            (8)
+#define KTRACE_MAXSIZE            (120)
 
 #define KTRACE_VERSION            (0x00020000)
 
@@ -89,4 +90,15 @@ enum {
 #define KTRACE_ACTION_REWIND    3 // options ignored
 #define KTRACE_ACTION_NEW_PROBE 4 // options ignored, ptr = name
 
+// Flags or'd into the group mask given to KTRACE_ACTION_START.
+//
+// By default tracing stops once a cpu's buffer fills up. With
+// KTRACE_START_CIRCULAR each cpu overwrites its oldest records instead.
+// With KTRACE_START_STREAMING each cpu drops new records while its buffer
+// is full, and zx_ktrace_read() ignores its offset and consumes whole
+// records (metadata first, then each cpu's records in timestamp order)
+// as they are written, so a reader can drain the trace while it runs.
+#define KTRACE_START_CIRCULAR   0x10000
+#define KTRACE_START_STREAMING  0x20000
+
 __END_CDECLS
@@ -34,6 +34,10 @@ __BEGIN_CDECLS
 #define MTRACE_INSNTRACE_START 4
 #define MTRACE_INSNTRACE_STOP 5
 
+// Fetch the current trace buffer data (MSRs) for the specified buffer
+// descriptor while tracing continues. Only supported when tracing cpus.
+#define MTRACE_INSNTRACE_SNAPSHOT_TRACE_DATA 6
+
 // Actions for CPU Performance Counters/Statistics control
 
 // Get performonce monitoring system properties
@@ -0,0 +1,94 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <zircon/syscalls.h>
+
+#include "private.h"
+
+namespace {
+
+struct TimeSnapshot {
+    bool user_ticks;
+    uint32_t l0, l32, l64;
+    int64_t utc_offset;
+};
+
+// Take a consistent copy of DATA_TIME.  The kernel makes |seq| odd
+// before it changes anything and even again afterwards.
+TimeSnapshot ReadTime() {
+    const vdso_time* time = &DATA_TIME;
+    TimeSnapshot snap;
+    uint32_t seq;
+    do {
+        seq = __atomic_load_n(&time->seq, __ATOMIC_ACQUIRE);
+        snap.user_ticks = __atomic_load_n(&time->user_ticks, __ATOMIC_RELAXED) != 0;
+        snap.l0 = __atomic_load_n(&time->ns_per_tick_l0, __ATOMIC_RELAXED);
+        snap.l32 = __atomic_load_n(&time->ns_per_tick_l32, __ATOMIC_RELAXED);
+        snap.l64 = __atomic_load_n(&time->ns_per_tick_l64, __ATOMIC_RELAXED);
+        snap.utc_offset = __atomic_load_n(&time->utc_offset, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || __atomic_load_n(&time->seq, __ATOMIC_RELAXED) != seq);
+    return snap;
+}
+
+// This must round exactly like u64_mul_u64_fp32_64() in the kernel's
+// lib/fixed_point, so that user mode and the kernel agree to the
+// nanosecond on what time it is.
+zx_time_t TicksToNanos(uint64_t ticks, const TimeSnapshot& snap) {
+    uint32_t a_r32 = static_cast<uint32_t>(ticks >> 32);
+    uint32_t a_0 = static_cast<uint32_t>(ticks);
+    uint64_t res_0 = static_cast<uint64_t>(a_r32) * snap.l0 << 32;
+    res_0 += static_cast<uint64_t>(a_0) * snap.l0;
+    res_0 += static_cast<uint64_t>(a_r32) * snap.l32;
+    uint64_t tmp = static_cast<uint64_t>(a_0) * snap.l32;
+    res_0 += tmp >> 32;
+    uint64_t res_l32 = static_cast<uint32_t>(tmp);
+    tmp = static_cast<uint64_t>(a_r32) * snap.l64;
+    res_0 += tmp >> 32;
+    res_l32 += static_cast<uint32_t>(tmp);
+    tmp = static_cast<uint64_t>(a_0) * snap.l64;
+    res_l32 += tmp >> 32;
+    res_0 += res_l32 >> 32;
+    return res_0 + (static_cast<uint32_t>(res_l32) >> 31);
+}
+
+} // anonymous namespace
+
+zx_time_t _zx_clock_get_monotonic(void) {
+    TimeSnapshot snap = ReadTime();
+    if (!snap.user_ticks)
+        return SYSCALL_zx_clock_get_monotonic_via_kernel();
+    return TicksToNanos(VDSO_zx_ticks_get(), snap);
+}
+
+VDSO_INTERFACE_FUNCTION(zx_clock_get_monotonic);
+
+zx_status_t _zx_clock_get_new(zx_clock_t clock_id, zx_time_t* out_time) {
+    switch (clock_id) {
+    case ZX_CLOCK_MONOTONIC:
+    case ZX_CLOCK_UTC: {
+        TimeSnapshot snap = ReadTime();
+        if (!snap.user_ticks)
+            break;
+        zx_time_t now = TicksToNanos(VDSO_zx_ticks_get(), snap);
+        if (clock_id == ZX_CLOCK_UTC)
+            now += snap.utc_offset;
+        *out_time = now;
+        return ZX_OK;
+    }
+    }
+    // The thread clock is only known to the kernel.
+    return SYSCALL_zx_clock_get_via_kernel(clock_id, out_time);
+}
+
+VDSO_INTERFACE_FUNCTION(zx_clock_get_new);
+
+zx_time_t _zx_clock_get(zx_clock_t clock_id) {
+    zx_time_t time;
+    if (VDSO_zx_clock_get_new(clock_id, &time) != ZX_OK)
+        return 0;
+    return time;
+}
+
+VDSO_INTERFACE_FUNCTION(zx_clock_get);
@@ -211,6 +211,22 @@ protected:
     }
 };
 
+class OrderTask : public TestTask {
+public:
+    OrderTask(uint32_t id, uint32_t* order, uint32_t* count)
+        : id_(id), order_(order), count_(count) {}
+
+protected:
+    uint32_t id_;
+    uint32_t* order_;
+    uint32_t* count_;
+
+    void Handle(async_dispatcher_t* dispatcher, zx_status_t status) override {
+        TestTask::Handle(dispatcher, status);
+        order_[(*count_)++] = id_;
+    }
+};
+
 class TestReceiver : async_receiver_t {
 public:
     TestReceiver()
@@ -821,6 +837,99 @@ bool task_shutdown_test() {
     END_TEST;
 }
 
+bool task_order_test() {
+    const uint32_t num_tasks = 64u;
+
+    BEGIN_TEST;
+
+    async::Loop loop(&kAsyncLoopConfigNoAttachToThread);
+
+    // Post tasks in scrambled deadline order, several of them sharing each
+    // deadline, all of which are already due.
+    zx::time start_time = async::Now(loop.dispatcher());
+    uint32_t order[num_tasks];
+    uint32_t count = 0u;
+    OrderTask* tasks[num_tasks];
+    for (uint32_t i = 0; i < num_tasks; i++) {
+        tasks[i] = new OrderTask(i, order, &count);
+        zx::time deadline = start_time - zx::msec((i * 7u) % 16u);
+        EXPECT_EQ(ZX_OK, tasks[i]->PostForTime(loop.dispatcher(), deadline), "post task");
+    }
+
+    // Cancel every third task.
+    for (uint32_t i = 0; i < num_tasks; i += 3u) {
+        EXPECT_EQ(ZX_OK, tasks[i]->Cancel(loop.dispatcher()), "cancel task");
+    }
+
+    // Quit once all of them ran.
+    QuitTask quit;
+    EXPECT_EQ(ZX_OK, quit.PostForTime(loop.dispatcher(), start_time), "post quit");
+    EXPECT_EQ(ZX_ERR_CANCELED, loop.Run(), "run loop");
+    EXPECT_EQ(1u, quit.run_count, "run count quit");
+
+    // The remaining tasks ran once each, in deadline order, and in the order
+    // they were posted for equal deadlines.
+    EXPECT_EQ(num_tasks - (num_tasks + 2u) / 3u, count, "task count");
+    for (uint32_t i = 1; i < count; i++) {
+        zx_time_t prev = tasks[order[i - 1]]->deadline;
+        zx_time_t cur = tasks[order[i]]->deadline;
+        EXPECT_TRUE(prev < cur || (prev == cur && order[i - 1] < order[i]), "task order");
+    }
+    for (uint32_t i = 0; i < num_tasks; i++) {
+        EXPECT_EQ(i % 3u ? 1u : 0u, tasks[i]->run_count, "run count");
+        EXPECT_EQ(ZX_ERR_NOT_FOUND, tasks[i]->Cancel(loop.dispatcher()), "cancel after run");
+        delete tasks[i];
+    }
+
+    END_TEST;
+}
+
+bool task_future_order_test() {
+    BEGIN_TEST;
+
+    async::Loop loop(&kAsyncLoopConfigNoAttachToThread);
+
+    // Tasks due soon and tasks due much later are kept apart by the loop
+    // but must still run in deadline order, then posting order.
+    zx::time start_time = async::Now(loop.dispatcher());
+    const zx::duration delays[] = {zx::msec(20), zx::msec(5), zx::sec(100), zx::msec(20),
+                                   zx::msec(40), zx::msec(5), zx::sec(10), zx::msec(20)};
+    const uint32_t num_tasks = countof(delays);
+    uint32_t order[num_tasks];
+    uint32_t count = 0u;
+    OrderTask* tasks[num_tasks];
+    for (uint32_t i = 0; i < num_tasks; i++) {
+        tasks[i] = new OrderTask(i, order, &count);
+        EXPECT_EQ(ZX_OK, tasks[i]->PostForTime(loop.dispatcher(), start_time + delays[i]),
+                  "post task");
+    }
+    EXPECT_EQ(ZX_OK, tasks[2]->Cancel(loop.dispatcher()), "cancel far task");
+    EXPECT_EQ(ZX_OK, tasks[4]->Cancel(loop.dispatcher()), "cancel near task");
+    EXPECT_EQ(ZX_ERR_NOT_FOUND, tasks[4]->Cancel(loop.dispatcher()), "cancel twice");
+
+    QuitTask quit;
+    EXPECT_EQ(ZX_OK, quit.PostForTime(loop.dispatcher(), start_time + zx::msec(50)), "post quit");
+    EXPECT_EQ(ZX_ERR_CANCELED, loop.Run(), "run loop");
+
+    const uint32_t expected[] = {1u, 5u, 0u, 3u, 7u};
+    const uint32_t num_expected = countof(expected);
+    EXPECT_EQ(num_expected, count, "task count");
+    for (uint32_t i = 0; i < num_expected && i < count; i++) {
+        EXPECT_EQ(expected[i], order[i], "task order");
+    }
+    EXPECT_EQ(0u, tasks[6]->run_count, "run count pending");
+
+    // The task still pending is canceled on shutdown.
+    loop.Shutdown();
+    EXPECT_EQ(1u, tasks[6]->run_count, "run count pending");
+    EXPECT_EQ(ZX_ERR_CANCELED, tasks[6]->last_status, "status pending");
+    for (uint32_t i = 0; i < num_tasks; i++) {
+        delete tasks[i];
+    }
+
+    END_TEST;
+}
+
 bool receiver_test() {
     const zx_packet_user_t data1{.u64 = {11, 12, 13, 14}};
     const zx_packet_user_t data2{.u64 = {21, 22, 23, 24}};
@@ -1380,6 +1489,8 @@ RUN_TEST(wait_unwaitable_handle_test)
 RUN_TEST(wait_shutdown_test)
 RUN_TEST(task_test)
 RUN_TEST(task_shutdown_test)
+RUN_TEST(task_order_test)
+RUN_TEST(task_future_order_test)
 RUN_TEST(receiver_test)
 RUN_TEST(receiver_shutdown_test)
 RUN_TEST(exception_test)
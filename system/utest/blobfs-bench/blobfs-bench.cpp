@@ -6,6 +6,7 @@
 #include <fcntl.h>
 #include <stdint.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include <blobfs/format.h>
 #include <digest/digest.h>
@@ -167,6 +168,75 @@ fbl::String GetNegativeLookupPath(const fbl::String& fs_path) {
     return negative_path;
 }
 
+// Measures how long it takes to build and to verify the Merkle tree of a blob
+// held in memory, as blobfs does when a blob is written and read.
+bool MerkleTest(size_t blob_size, perftest::RepeatState* state, Fixture* fixture) {
+    BEGIN_HELPER;
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<uint8_t[]> data(new (&ac) uint8_t[blob_size]);
+    ASSERT_TRUE(ac.check());
+    unsigned int seed = rand_r(fixture->mutable_seed());
+    for (size_t i = 0; i < blob_size; i++) {
+        data[i] = static_cast<uint8_t>(rand_r(&seed));
+    }
+    size_t tree_size = MerkleTree::GetTreeLength(blob_size);
+    fbl::unique_ptr<uint8_t[]> tree(new (&ac) uint8_t[tree_size]);
+    ASSERT_TRUE(ac.check());
+
+    state->DeclareStep("create");
+    state->DeclareStep("verify");
+    while (state->KeepRunning()) {
+        Digest digest;
+        ASSERT_EQ(MerkleTree::Create(data.get(), blob_size, tree.get(), tree_size, &digest),
+                  ZX_OK);
+        state->NextStep();
+        ASSERT_EQ(MerkleTree::Verify(data.get(), blob_size, tree.get(), tree_size, 0, blob_size,
+                                     digest),
+                  ZX_OK);
+    }
+    END_HELPER;
+}
+
+// Measures the throughput of writing |blob_count| blobs back to back and
+// syncing once at the end, as a package install does. The blobs are unlinked
+// at the end of each run so the next run can write them again.
+bool WriteBatchTest(size_t blob_size, size_t blob_count, perftest::RepeatState* state,
+                    Fixture* fixture) {
+    BEGIN_HELPER;
+    fbl::Vector<fbl::unique_ptr<BlobInfo>> blobs;
+    for (size_t i = 0; i < blob_count; i++) {
+        fbl::unique_ptr<BlobInfo> blob;
+        ASSERT_TRUE(MakeBlob(fixture->fs_path(), blob_size, fixture->mutable_seed(), &blob));
+        blobs.push_back(fbl::move(blob));
+    }
+    fbl::unique_fd root(open(fixture->fs_path().c_str(), O_RDONLY | O_DIRECTORY));
+    ASSERT_TRUE(root, strerror(errno));
+
+    state->SetBytesProcessedPerRun(blob_size * blob_count);
+    state->DeclareStep("write");
+    state->DeclareStep("sync");
+    state->DeclareStep("unlink");
+    while (state->KeepRunning()) {
+        for (const auto& blob : blobs) {
+            fbl::unique_fd fd(open(blob->path.c_str(), O_CREAT | O_RDWR));
+            ASSERT_TRUE(fd, strerror(errno));
+            ASSERT_EQ(ftruncate(fd.get(), blob_size), 0, strerror(errno));
+            ASSERT_EQ(StreamAll(write, fd.get(), blob->data.get(), blob->size_data), 0,
+                      strerror(errno));
+        }
+        state->NextStep();
+
+        ASSERT_EQ(syncfs(root.get()), 0, strerror(errno));
+        state->NextStep();
+
+        for (const auto& blob : blobs) {
+            ASSERT_EQ(unlink(blob->path.c_str()), 0, strerror(errno));
+        }
+        ASSERT_EQ(syncfs(root.get()), 0, strerror(errno));
+    }
+    END_HELPER;
+}
+
 class BlobfsTest {
 public:
     BlobfsTest(BlobfsInfo&& info)
@@ -384,6 +454,59 @@ bool RunBenchmark(int argc, char** argv) {
         }
     }
 
+    // Batched writes of many small blobs, which are bound by the latency of
+    // the journal and the writeback queue rather than by bandwidth.
+    const size_t write_batch_sizes[] = {
+        8 * 1024,   // 8 Kb
+        128 * 1024, // 128 Kb
+    };
+    constexpr size_t kWriteBatchCount = 100;
+    TestCaseInfo write_batch_testcase;
+    write_batch_testcase.teardown = false;
+    write_batch_testcase.sample_count = 10;
+    for (auto blob_size : write_batch_sizes) {
+        size_t blob_count = p_opts.is_unittest ? 1 : kWriteBatchCount;
+        TestInfo write_test;
+        write_test.name = fbl::StringPrintf("%s/%s/%luBlobs/WriteBatch",
+                                            disk_format_string_[f_opts.fs_type],
+                                            GetNameForSize(blob_size).c_str(), blob_count);
+        write_test.required_disk_space =
+            blob_count * (blob_size + 2 * MerkleTree::kNodeSize + blobfs::kBlobfsInodeSize);
+        write_test.test_fn = [blob_size, blob_count](perftest::RepeatState* state,
+                                                     fs_test_utils::Fixture* fixture) {
+            return WriteBatchTest(blob_size, blob_count, state, fixture);
+        };
+        write_batch_testcase.tests.push_back(fbl::move(write_test));
+    }
+    testcases.push_back(fbl::move(write_batch_testcase));
+
+    // The Merkle tree benchmarks run in memory and do not touch the
+    // filesystem.
+    const size_t merkle_sizes[] = {
+        1024 * 1024,       // 1 MB
+        10 * 1024 * 1024,  // 10 MB
+        100 * 1024 * 1024, // 100 MB
+    };
+    TestCaseInfo merkle_testcase;
+    merkle_testcase.teardown = false;
+    merkle_testcase.sample_count = 10;
+    for (auto blob_size : merkle_sizes) {
+        if (p_opts.is_unittest && blob_size > merkle_sizes[0]) {
+            break;
+        }
+        TestInfo merkle_test;
+        merkle_test.name = fbl::StringPrintf("%s/%s/MerkleTree",
+                                             disk_format_string_[f_opts.fs_type],
+                                             GetNameForSize(blob_size).c_str());
+        merkle_test.required_disk_space = 0;
+        merkle_test.test_fn = [blob_size](perftest::RepeatState* state,
+                                          fs_test_utils::Fixture* fixture) {
+            return MerkleTest(blob_size, state, fixture);
+        };
+        merkle_testcase.tests.push_back(fbl::move(merkle_test));
+    }
+    testcases.push_back(fbl::move(merkle_testcase));
+
     return fs_test_utils::RunTestCases(f_opts, p_opts, testcases);
 }
 
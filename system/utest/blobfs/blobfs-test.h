@@ -90,6 +90,18 @@ public:
         stdio_ = stdio;
     }
 
+    // Sets the memory budget for closed blobs, in megabytes, used from the
+    // next mount. Zero evicts each blob as soon as it is closed.
+    void SetCacheSize(uint32_t cache_size_mb) {
+        cache_size_mb_ = cache_size_mb;
+    }
+
+    // Determines if the next remount verifies blobs in the background after
+    // mounting, rather than during fsck. Teardown always runs a full fsck.
+    void SetVerifyInBackground(bool verify_in_background) {
+        verify_in_background_ = verify_in_background;
+    }
+
     // Reset to initial state, given that the test was successfully torn down.
     bool Reset() {
         BEGIN_HELPER;
@@ -114,6 +126,9 @@ private:
     // Mounts the blobfs partition.
     bool Mount();
 
+    // Runs fsck on the unmounted blobfs partition.
+    zx_status_t Fsck(LaunchCallback launch) const;
+
     FsTestType type_;
     FsTestState state_ = FsTestState::kInit;
     uint64_t blk_size_ = 512;
@@ -123,6 +138,8 @@ private:
     bool read_only_ = false;
     bool asleep_ = false;
     bool stdio_ = true;
+    uint32_t cache_size_mb_ = 0;
+    bool verify_in_background_ = false;
 };
 
 }  // namespace
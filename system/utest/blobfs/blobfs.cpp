@@ -12,10 +12,12 @@
 #include <threads.h>
 #include <utime.h>
 
+#include <blobfs/common.h>
 #include <blobfs/format.h>
 #include <blobfs/lz4.h>
 #include <digest/digest.h>
 #include <digest/merkle-tree.h>
+#include <fbl/algorithm.h>
 #include <fbl/alloc_checker.h>
 #include <fbl/atomic.h>
 #include <fbl/auto_call.h>
@@ -211,6 +213,7 @@ const fsck_options_t test_fsck_options = {
     .never_modify = true,
     .always_modify = false,
     .force = true,
+    .verify_in_background = false,
 };
 
 BlobfsTest::~BlobfsTest() {
@@ -298,8 +301,7 @@ bool BlobfsTest::Remount() {
     auto error = fbl::MakeAutoCall([this](){ state_ = FsTestState::kError; });
     ASSERT_EQ(umount(MOUNT_PATH), ZX_OK, "Failed to unmount blobfs");
     LaunchCallback launch = stdio_ ? launch_stdio_sync : launch_silent_sync;
-    ASSERT_EQ(fsck(ramdisk_path_, DISK_FORMAT_BLOBFS, &test_fsck_options, launch), ZX_OK,
-              "Filesystem fsck failed");
+    ASSERT_EQ(Fsck(launch), ZX_OK, "Filesystem fsck failed");
     ASSERT_TRUE(Mount(), "Failed to mount blobfs");
     error.cancel();
     END_HELPER;
@@ -312,8 +314,7 @@ bool BlobfsTest::ForceRemount(zx_status_t* fsck_result) {
     umount(MOUNT_PATH);
 
     if (fsck_result != nullptr) {
-        *fsck_result = fsck(ramdisk_path_, DISK_FORMAT_BLOBFS, &test_fsck_options,
-                            launch_silent_sync);
+        *fsck_result = Fsck(launch_silent_sync);
     }
 
     ASSERT_TRUE(Mount());
@@ -488,6 +489,8 @@ bool BlobfsTest::Mount() {
 
     mount_options_t options = default_mount_options;
     options.enable_journal = gEnableJournal;
+    options.cache_size_mb = cache_size_mb_;
+    options.verify_in_background = verify_in_background_;
 
     if (read_only_) {
         options.readonly = true;
@@ -502,6 +505,12 @@ bool BlobfsTest::Mount() {
     END_HELPER;
 }
 
+zx_status_t BlobfsTest::Fsck(LaunchCallback launch) const {
+    fsck_options_t options = test_fsck_options;
+    options.verify_in_background = verify_in_background_;
+    return fsck(ramdisk_path_, DISK_FORMAT_BLOBFS, &options, launch);
+}
+
 // Helper functions for testing:
 
 // Helper for streaming operations (such as read, write) which may need to be
@@ -691,6 +700,58 @@ bool QueryInfo(size_t expected_nodes, size_t expected_bytes) {
     return true;
 }
 
+// Corrupts the data of the blob described by |info| at |offset| by writing
+// straight to the underlying device, which must not be mounted.
+static bool CorruptBlobOnDisk(BlobfsTest* blobfsTest, const blob_info_t* info, uint64_t offset) {
+    BEGIN_HELPER;
+    ASSERT_LT(offset, info->size_data);
+    fbl::unique_fd fd(blobfsTest->GetFd());
+    ASSERT_TRUE(fd, "Could not open ramdisk");
+
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<uint8_t[]> block(new (&ac) uint8_t[blobfs::kBlobfsBlockSize]);
+    ASSERT_TRUE(ac.check());
+    ASSERT_EQ(pread(fd.get(), block.get(), blobfs::kBlobfsBlockSize, 0),
+              blobfs::kBlobfsBlockSize);
+    blobfs::Superblock superblock;
+    memcpy(&superblock, block.get(), sizeof(superblock));
+
+    Digest digest;
+    const char* name = info->path + strlen(MOUNT_PATH "/");
+    ASSERT_EQ(digest.Parse(name, strlen(name)), ZX_OK);
+
+    // Find the blob's inode to locate its data.
+    off_t data_offset = -1;
+    for (uint64_t n = 0; n < superblock.inode_count && data_offset < 0; n++) {
+        if (n % blobfs::kBlobfsInodesPerBlock == 0) {
+            off_t node_block = NodeMapStartBlock(superblock) + n / blobfs::kBlobfsInodesPerBlock;
+            ASSERT_EQ(pread(fd.get(), block.get(), blobfs::kBlobfsBlockSize,
+                            node_block * blobfs::kBlobfsBlockSize),
+                      blobfs::kBlobfsBlockSize);
+        }
+        const blobfs::Inode* inode = reinterpret_cast<const blobfs::Inode*>(block.get()) +
+                                     n % blobfs::kBlobfsInodesPerBlock;
+        if (inode->start_block >= blobfs::kStartBlockMinimum &&
+            digest == inode->merkle_root_hash) {
+            const uint32_t kCompressed = blobfs::kBlobFlagLZ4Compressed |
+                                         blobfs::kBlobFlagLZ4Chunked;
+            ASSERT_EQ(inode->flags & kCompressed, 0, "Cannot corrupt a compressed blob in place");
+            data_offset = (DataStartBlock(superblock) + inode->start_block +
+                           blobfs::MerkleTreeBlocks(*inode)) * blobfs::kBlobfsBlockSize;
+        }
+    }
+    ASSERT_GE(data_offset, 0, "Blob not found on disk");
+
+    // Rewrite the whole block around |offset| with one byte flipped.
+    off_t block_offset = data_offset + fbl::round_down(offset, blobfs::kBlobfsBlockSize);
+    ASSERT_EQ(pread(fd.get(), block.get(), blobfs::kBlobfsBlockSize, block_offset),
+              blobfs::kBlobfsBlockSize);
+    block[offset % blobfs::kBlobfsBlockSize] ^= 0xff;
+    ASSERT_EQ(pwrite(fd.get(), block.get(), blobfs::kBlobfsBlockSize, block_offset),
+              blobfs::kBlobfsBlockSize);
+    END_HELPER;
+}
+
 }  // namespace
 
 // Actual tests:
@@ -2338,6 +2399,225 @@ static bool CreateWriteReopen(BlobfsTest* blobfsTest) {
     END_HELPER;
 }
 
+// Uncompressed blobs are read from disk and verified on demand, in chunks,
+// so a read returns the right data wherever it lands in the blob.
+static bool TestReadOnDemand(BlobfsTest* blobfsTest) {
+    BEGIN_HELPER;
+    fbl::unique_ptr<blob_info_t> info;
+    ASSERT_TRUE(GenerateRandomBlob(1 << 20, &info));
+
+    fbl::unique_fd fd;
+    ASSERT_TRUE(MakeBlob(info.get(), &fd));
+    ASSERT_EQ(close(fd.release()), 0);
+    ASSERT_TRUE(blobfsTest->Remount());
+
+    // Read small ranges out of order, some of them spanning chunks.
+    const size_t kOffsets[] = {
+        700001, 0, (1 << 20) - 100, (1 << 16) - 10, 3 * (1 << 16) + 5, 1 << 19,
+    };
+    char buf[300];
+    fd.reset(open(info->path, O_RDONLY));
+    ASSERT_TRUE(fd, "Failed to open blob");
+    for (size_t offset : kOffsets) {
+        size_t len = fbl::min(sizeof(buf), info->size_data - offset);
+        ASSERT_EQ(pread(fd.get(), buf, len, offset), static_cast<ssize_t>(len));
+        ASSERT_EQ(memcmp(buf, &info->data[offset], len), 0, "Unexpected data read");
+    }
+
+    // Then the whole blob, and through a mapping, which loads the rest.
+    ASSERT_TRUE(VerifyContents(fd.get(), info->data.get(), info->size_data));
+    void* addr = mmap(nullptr, info->size_data, PROT_READ, MAP_PRIVATE, fd.get(), 0);
+    ASSERT_NE(addr, MAP_FAILED, "Could not mmap blob");
+    ASSERT_EQ(memcmp(addr, info->data.get(), info->size_data), 0, "Mmap data invalid");
+    ASSERT_EQ(munmap(addr, info->size_data), 0, "Could not unmap blob");
+    ASSERT_EQ(close(fd.release()), 0);
+
+    ASSERT_EQ(unlink(info->path), 0);
+    END_HELPER;
+}
+
+// Only the chunks that are read are verified, so corruption on disk fails
+// the reads which touch it without failing the open or the other reads.
+static bool TestReadOnDemandCorrupted(BlobfsTest* blobfsTest) {
+    BEGIN_HELPER;
+    fbl::unique_ptr<blob_info_t> info;
+    ASSERT_TRUE(GenerateRandomBlob(1 << 20, &info));
+
+    fbl::unique_fd fd;
+    ASSERT_TRUE(MakeBlob(info.get(), &fd));
+    ASSERT_EQ(close(fd.release()), 0);
+
+    const size_t kCorruptOffset = 900000;
+    ASSERT_EQ(umount(MOUNT_PATH), ZX_OK, "Failed to unmount blobfs");
+    ASSERT_TRUE(CorruptBlobOnDisk(blobfsTest, info.get(), kCorruptOffset));
+    zx_status_t fsck_status;
+    ASSERT_TRUE(blobfsTest->ForceRemount(&fsck_status));
+    ASSERT_NE(fsck_status, ZX_OK, "fsck missed the corrupted blob");
+
+    fd.reset(open(info->path, O_RDONLY));
+    ASSERT_TRUE(fd, "Failed to open corrupted blob");
+    char buf[300];
+    ASSERT_EQ(pread(fd.get(), buf, sizeof(buf), 0), static_cast<ssize_t>(sizeof(buf)));
+    ASSERT_EQ(memcmp(buf, info->data.get(), sizeof(buf)), 0);
+    ASSERT_EQ(pread(fd.get(), buf, sizeof(buf), kCorruptOffset - 100), -1,
+              "Read of corrupted data succeeded");
+    const size_t kTailOffset = info->size_data - sizeof(buf);
+    ASSERT_EQ(pread(fd.get(), buf, sizeof(buf), kTailOffset), static_cast<ssize_t>(sizeof(buf)));
+    ASSERT_EQ(memcmp(buf, &info->data[kTailOffset], sizeof(buf)), 0);
+
+    // A mapping needs all of the blob to be valid.
+    ASSERT_EQ(mmap(nullptr, info->size_data, PROT_READ, MAP_PRIVATE, fd.get(), 0), MAP_FAILED);
+    ASSERT_EQ(close(fd.release()), 0);
+
+    // Leave a consistent filesystem for the final fsck.
+    ASSERT_EQ(unlink(info->path), 0);
+    END_HELPER;
+}
+
+// Reads all of the blob described by |info|, and returns in |blocks| the
+// number of blocks the device was asked for while doing so.
+static bool ReadBlobCountingBlocks(BlobfsTest* blobfsTest, const blob_info_t* info,
+                                   uint64_t* blocks) {
+    BEGIN_HELPER;
+    uint64_t before, after;
+    ASSERT_TRUE(blobfsTest->GetRamdiskCount(&before));
+    fbl::unique_fd fd(open(info->path, O_RDONLY));
+    ASSERT_TRUE(fd, "Failed to open blob");
+    ASSERT_TRUE(VerifyContents(fd.get(), info->data.get(), info->size_data));
+    ASSERT_EQ(close(fd.release()), 0);
+    ASSERT_TRUE(blobfsTest->GetRamdiskCount(&after));
+    *blocks = after - before;
+    END_HELPER;
+}
+
+// With a cache budget, closed blobs stay in memory until the least recently
+// closed ones have to make room for others.
+static bool TestCacheLru(BlobfsTest* blobfsTest) {
+    BEGIN_HELPER;
+    // Each blob takes a little over a quarter of the 1MB budget.
+    constexpr size_t kNumBlobs = 4;
+    fbl::unique_ptr<blob_info_t> info[kNumBlobs];
+    for (size_t i = 0; i < kNumBlobs; i++) {
+        ASSERT_TRUE(GenerateRandomBlob(1 << 18, &info[i]));
+        fbl::unique_fd fd;
+        ASSERT_TRUE(MakeBlob(info[i].get(), &fd));
+        ASSERT_EQ(close(fd.release()), 0);
+    }
+
+    // By default every open of a closed blob reads it again.
+    ASSERT_TRUE(blobfsTest->Remount());
+    uint64_t blocks;
+    ASSERT_TRUE(ReadBlobCountingBlocks(blobfsTest, info[0].get(), &blocks));
+    ASSERT_GT(blocks, 0);
+    ASSERT_TRUE(ReadBlobCountingBlocks(blobfsTest, info[0].get(), &blocks));
+    ASSERT_GT(blocks, 0, "Closed blob was not evicted");
+
+    blobfsTest->SetCacheSize(1);
+    ASSERT_TRUE(blobfsTest->Remount());
+    ASSERT_TRUE(ReadBlobCountingBlocks(blobfsTest, info[0].get(), &blocks));
+    ASSERT_GT(blocks, 0);
+    ASSERT_TRUE(ReadBlobCountingBlocks(blobfsTest, info[0].get(), &blocks));
+    ASSERT_EQ(blocks, 0, "Cached blob was read again");
+
+    // Closing the rest pushes the least recently closed blob, 0, out.
+    for (size_t i = 1; i < kNumBlobs; i++) {
+        ASSERT_TRUE(ReadBlobCountingBlocks(blobfsTest, info[i].get(), &blocks));
+        ASSERT_GT(blocks, 0);
+    }
+    ASSERT_TRUE(ReadBlobCountingBlocks(blobfsTest, info[1].get(), &blocks));
+    ASSERT_EQ(blocks, 0, "Cached blob was read again");
+    ASSERT_TRUE(ReadBlobCountingBlocks(blobfsTest, info[0].get(), &blocks));
+    ASSERT_GT(blocks, 0, "Blob beyond the budget was not evicted");
+
+    for (size_t i = 0; i < kNumBlobs; i++) {
+        ASSERT_EQ(unlink(info[i]->path), 0);
+    }
+    END_HELPER;
+}
+
+// Creates |count| blobs of assorted sizes, none of them compressible.
+static bool MakeBlobs(size_t count, fbl::unique_ptr<blob_info_t>* info) {
+    BEGIN_HELPER;
+    for (size_t i = 0; i < count; i++) {
+        ASSERT_TRUE(GenerateRandomBlob((i + 1) * 40000, &info[i]));
+        fbl::unique_fd fd;
+        ASSERT_TRUE(MakeBlob(info[i].get(), &fd));
+        ASSERT_EQ(close(fd.release()), 0);
+    }
+    END_HELPER;
+}
+
+// fsck verifies blobs across several threads, and still finds the one which
+// is corrupt. With verification left to the mounted filesystem, it only
+// checks metadata and passes.
+static bool TestFsckVerifiesInParallel(BlobfsTest* blobfsTest) {
+    BEGIN_HELPER;
+    constexpr size_t kNumBlobs = 16;
+    fbl::unique_ptr<blob_info_t> info[kNumBlobs];
+    ASSERT_TRUE(MakeBlobs(kNumBlobs, info));
+    ASSERT_TRUE(blobfsTest->Remount());
+
+    const blob_info_t* corrupt = info[kNumBlobs / 2].get();
+    ASSERT_EQ(umount(MOUNT_PATH), ZX_OK, "Failed to unmount blobfs");
+    ASSERT_TRUE(CorruptBlobOnDisk(blobfsTest, corrupt, corrupt->size_data / 2));
+    zx_status_t fsck_status;
+    ASSERT_TRUE(blobfsTest->ForceRemount(&fsck_status));
+    ASSERT_NE(fsck_status, ZX_OK, "fsck missed the corrupted blob");
+
+    blobfsTest->SetVerifyInBackground(true);
+    ASSERT_TRUE(blobfsTest->ForceRemount(&fsck_status));
+    ASSERT_EQ(fsck_status, ZX_OK, "fsck verified blob contents");
+    blobfsTest->SetVerifyInBackground(false);
+
+    for (size_t i = 0; i < kNumBlobs; i++) {
+        ASSERT_EQ(unlink(info[i]->path), 0);
+    }
+    END_HELPER;
+}
+
+// Once mounted with background verification, blobfs reads every blob
+// without being asked to, and keeps serving the intact ones when one of
+// them is corrupt.
+static bool TestVerifyInBackground(BlobfsTest* blobfsTest) {
+    BEGIN_HELPER;
+    constexpr size_t kNumBlobs = 8;
+    fbl::unique_ptr<blob_info_t> info[kNumBlobs];
+    ASSERT_TRUE(MakeBlobs(kNumBlobs, info));
+    uint64_t data_blocks = 0;
+    for (size_t i = 0; i < kNumBlobs; i++) {
+        data_blocks += info[i]->size_data / blobfsTest->GetBlockSize();
+    }
+
+    const blob_info_t* corrupt = info[0].get();
+    ASSERT_EQ(umount(MOUNT_PATH), ZX_OK, "Failed to unmount blobfs");
+    ASSERT_TRUE(CorruptBlobOnDisk(blobfsTest, corrupt, 0));
+    blobfsTest->SetVerifyInBackground(true);
+    uint64_t start;
+    ASSERT_TRUE(blobfsTest->GetRamdiskCount(&start));
+    ASSERT_TRUE(blobfsTest->ForceRemount());
+    blobfsTest->SetVerifyInBackground(false);
+
+    uint64_t count = start;
+    zx_time_t deadline = zx_deadline_after(ZX_SEC(10));
+    while (count - start < data_blocks) {
+        ASSERT_LT(zx_clock_get_monotonic(), deadline, "Blobs were not verified in background");
+        usleep(10000);
+        ASSERT_TRUE(blobfsTest->GetRamdiskCount(&count));
+    }
+
+    for (size_t i = 1; i < kNumBlobs; i++) {
+        fbl::unique_fd fd(open(info[i]->path, O_RDONLY));
+        ASSERT_TRUE(fd, "Failed to open blob");
+        ASSERT_TRUE(VerifyContents(fd.get(), info[i]->data.get(), info[i]->size_data));
+    }
+
+    // Leave a consistent filesystem for the final fsck.
+    for (size_t i = 0; i < kNumBlobs; i++) {
+        ASSERT_EQ(unlink(info[i]->path), 0);
+    }
+    END_HELPER;
+}
+
 // Ensure Compressor returns an error if we try to compress more data than the buffer can hold.
 static bool TestCompressorBufferTooSmall(void) {
     BEGIN_TEST;
@@ -2367,6 +2647,51 @@ static bool TestCompressorBufferTooSmall(void) {
     END_TEST;
 }
 
+// Ensure each chunk of a compressed blob can be decompressed on its own.
+static bool TestCompressorSeekTable(void) {
+    BEGIN_TEST;
+    unsigned int seed = 0;
+    const size_t kSizes[] = {
+        1, blobfs::kCompressionChunkSize, blobfs::kCompressionChunkSize + 1,
+        5 * blobfs::kCompressionChunkSize - 100,
+    };
+    for (size_t size : kSizes) {
+        // Make the first half of the data compressible and the rest not, so
+        // that the frame holds both compressed and stored blocks.
+        fbl::AllocChecker ac;
+        fbl::unique_ptr<char[]> data(new (&ac) char[size]);
+        ASSERT_TRUE(ac.check());
+        for (size_t i = 0; i < size; i++) {
+            data[i] = static_cast<char>(i < size / 2 ? i / 256 : rand_r(&seed));
+        }
+
+        blobfs::Compressor c;
+        const size_t buf_size = c.BufferMax(size);
+        fbl::unique_ptr<char[]> buf(new (&ac) char[buf_size]);
+        ASSERT_TRUE(ac.check());
+        ASSERT_EQ(c.Initialize(buf.get(), buf_size), ZX_OK);
+        ASSERT_EQ(c.Update(data.get(), size), ZX_OK);
+        ASSERT_EQ(c.End(), ZX_OK);
+
+        blobfs::SeekTable table;
+        ASSERT_EQ(table.Init(buf.get(), c.Size(), size), ZX_OK);
+        ASSERT_EQ(table.Chunks(), fbl::round_up(size, blobfs::kCompressionChunkSize) /
+                                  blobfs::kCompressionChunkSize);
+        ASSERT_EQ(table.Init(buf.get(), c.Size(), size + blobfs::kCompressionChunkSize),
+                  ZX_ERR_IO_DATA_INTEGRITY);
+
+        // Decompress the chunks back to front.
+        fbl::unique_ptr<char[]> out(new (&ac) char[size]);
+        ASSERT_TRUE(ac.check());
+        for (size_t i = table.Chunks(); i-- > 0;) {
+            size_t offset = i * blobfs::kCompressionChunkSize;
+            ASSERT_EQ(table.DecompressChunk(i, out.get() + offset, size - offset), ZX_OK);
+        }
+        ASSERT_EQ(memcmp(out.get(), data.get(), size), 0);
+    }
+    END_TEST;
+}
+
 static bool TestCreateFailure(void) {
     BEGIN_TEST;
     BlobfsTest blobfsTest(FsTestType::kNormal);
@@ -2638,7 +2963,13 @@ RUN_TESTS(MEDIUM, TestReadOnly)
 RUN_TEST_FVM(MEDIUM, ResizePartition)
 RUN_TEST_FVM(MEDIUM, CorruptAtMount)
 RUN_TESTS(LARGE, CreateWriteReopen)
+RUN_TESTS(MEDIUM, TestReadOnDemand)
+RUN_TESTS_SILENT(MEDIUM, TestReadOnDemandCorrupted)
+RUN_TESTS(MEDIUM, TestCacheLru)
+RUN_TESTS_SILENT(MEDIUM, TestFsckVerifiesInParallel)
+RUN_TESTS_SILENT(MEDIUM, TestVerifyInBackground)
 RUN_TEST(TestCompressorBufferTooSmall)
+RUN_TEST(TestCompressorSeekTable)
 RUN_TEST_MEDIUM(TestCreateFailure)
 RUN_TEST_MEDIUM(TestExtendFailure)
 RUN_TEST_LARGE(TestLargeBlob)
@@ -0,0 +1,120 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string.h>
+
+#include <unittest/unittest.h>
+#include <zircon/syscalls.h>
+#include <zircon/syscalls/port.h>
+#include <zircon/types.h>
+
+static bool batch_ops_test(void) {
+    BEGIN_TEST;
+
+    zx_handle_t event, sent, closed, port, ch[2];
+    ASSERT_EQ(zx_event_create(0u, &event), ZX_OK, "");
+    ASSERT_EQ(zx_event_create(0u, &sent), ZX_OK, "");
+    ASSERT_EQ(zx_event_create(0u, &closed), ZX_OK, "");
+    ASSERT_EQ(zx_port_create(0u, &port), ZX_OK, "");
+    ASSERT_EQ(zx_channel_create(0u, &ch[0], &ch[1]), ZX_OK, "");
+
+    static const char msg[] = "batched";
+    zx_port_packet_t packet = {.key = 42u, .type = ZX_PKT_TYPE_USER, .status = 0};
+
+    zx_batch_op_t ops[4] = {
+        {.op = ZX_BATCH_OP_OBJECT_SIGNAL, .handle = event, .arg0 = 0u, .arg1 = ZX_USER_SIGNAL_0},
+        {.op = ZX_BATCH_OP_CHANNEL_WRITE, .handle = ch[0],
+         .ptr0 = msg, .arg0 = sizeof(msg), .ptr1 = &sent, .arg1 = 1u},
+        {.op = ZX_BATCH_OP_PORT_QUEUE, .handle = port, .ptr0 = &packet},
+        {.op = ZX_BATCH_OP_HANDLE_CLOSE, .handle = closed},
+    };
+    for (size_t i = 0; i < countof(ops); ++i)
+        ops[i].status = ZX_ERR_INTERNAL;
+
+    ASSERT_EQ(zx_batch(0u, ops, countof(ops)), ZX_OK, "");
+    for (size_t i = 0; i < countof(ops); ++i)
+        EXPECT_EQ(ops[i].status, ZX_OK, "");
+
+    zx_signals_t pending;
+    EXPECT_EQ(zx_object_wait_one(event, ZX_USER_SIGNAL_0, 0u, &pending), ZX_OK, "");
+
+    char buf[sizeof(msg)];
+    zx_handle_t received = ZX_HANDLE_INVALID;
+    uint32_t actual_bytes, actual_handles;
+    ASSERT_EQ(zx_channel_read(ch[1], 0u, buf, &received, sizeof(buf), 1u,
+                              &actual_bytes, &actual_handles), ZX_OK, "");
+    EXPECT_EQ(actual_bytes, sizeof(msg), "");
+    EXPECT_EQ(actual_handles, 1u, "");
+    EXPECT_EQ(memcmp(buf, msg, sizeof(msg)), 0, "");
+
+    zx_port_packet_t out;
+    ASSERT_EQ(zx_port_wait(port, 0u, &out), ZX_OK, "");
+    EXPECT_EQ(out.key, 42u, "");
+
+    EXPECT_EQ(zx_handle_close(closed), ZX_ERR_BAD_HANDLE, "closed by the batch");
+
+    zx_handle_close(received);
+    zx_handle_close(ch[0]);
+    zx_handle_close(ch[1]);
+    zx_handle_close(port);
+    zx_handle_close(event);
+
+    END_TEST;
+}
+
+static bool batch_partial_failure_test(void) {
+    BEGIN_TEST;
+
+    zx_handle_t event;
+    ASSERT_EQ(zx_event_create(0u, &event), ZX_OK, "");
+
+    // An operation that fails does not stop the ones after it.
+    zx_batch_op_t ops[3] = {
+        {.op = ZX_BATCH_OP_OBJECT_SIGNAL, .handle = ZX_HANDLE_INVALID},
+        {.op = 0xffffu, .handle = event},
+        {.op = ZX_BATCH_OP_OBJECT_SIGNAL, .handle = event, .arg0 = 0u, .arg1 = ZX_USER_SIGNAL_1},
+    };
+    EXPECT_EQ(zx_batch(0u, ops, countof(ops)), ZX_ERR_BAD_HANDLE, "");
+    EXPECT_EQ(ops[0].status, ZX_ERR_BAD_HANDLE, "");
+    EXPECT_EQ(ops[1].status, ZX_ERR_NOT_SUPPORTED, "");
+    EXPECT_EQ(ops[2].status, ZX_OK, "");
+
+    zx_signals_t pending;
+    EXPECT_EQ(zx_object_wait_one(event, ZX_USER_SIGNAL_1, 0u, &pending), ZX_OK, "");
+
+    zx_handle_close(event);
+
+    END_TEST;
+}
+
+static bool batch_bad_args_test(void) {
+    BEGIN_TEST;
+
+    zx_batch_op_t ops[ZX_BATCH_MAX_OPS + 1];
+    memset(ops, 0, sizeof(ops));
+    for (size_t i = 0; i < countof(ops); ++i)
+        ops[i].op = ZX_BATCH_OP_HANDLE_CLOSE;
+
+    EXPECT_EQ(zx_batch(1u, ops, 1u), ZX_ERR_INVALID_ARGS, "");
+    EXPECT_EQ(zx_batch(0u, ops, 0u), ZX_ERR_OUT_OF_RANGE, "");
+    EXPECT_EQ(zx_batch(0u, ops, countof(ops)), ZX_ERR_OUT_OF_RANGE, "");
+    EXPECT_EQ(zx_batch(0u, NULL, 1u), ZX_ERR_INVALID_ARGS, "");
+
+    // Closing the invalid handle is not an error.
+    EXPECT_EQ(zx_batch(0u, ops, ZX_BATCH_MAX_OPS), ZX_OK, "");
+
+    END_TEST;
+}
+
+BEGIN_TEST_CASE(batch_tests)
+RUN_TEST(batch_ops_test)
+RUN_TEST(batch_partial_failure_test)
+RUN_TEST(batch_bad_args_test)
+END_TEST_CASE(batch_tests)
+
+#ifndef BUILD_COMBINED_TESTS
+int main(int argc, char** argv) {
+    return unittest_run_all_tests(argc, argv) ? 0 : -1;
+}
+#endif
@@ -0,0 +1,236 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <limits.h>
+#include <unittest/unittest.h>
+#include <zircon/syscalls.h>
+#include <zircon/syscalls/iommu.h>
+#include <zircon/syscalls/object.h>
+
+extern zx_handle_t get_root_resource(void);
+
+static const uint32_t kPerms = ZX_BTI_PERM_READ | ZX_BTI_PERM_WRITE;
+#define MAX_PIN_PAGES 4
+
+// Creates a BTI on a dummy IOMMU with a pin cache of |quota| bytes, and a
+// VMO of |vmo_pages| pages to pin.
+static bool create_bti(uint64_t quota, size_t vmo_pages, zx_handle_t* bti, zx_handle_t* vmo) {
+    zx_handle_t iommu;
+    zx_iommu_desc_dummy_t desc;
+    ASSERT_EQ(zx_iommu_create(get_root_resource(), ZX_IOMMU_TYPE_DUMMY,
+                              &desc, sizeof(desc), &iommu), ZX_OK, "");
+    ASSERT_EQ(zx_bti_create(iommu, 0, 0xdeadbeef, bti), ZX_OK, "");
+    ASSERT_EQ(zx_handle_close(iommu), ZX_OK, "");
+
+    ASSERT_EQ(zx_object_set_property(*bti, ZX_PROP_BTI_PIN_CACHE_QUOTA,
+                                     &quota, sizeof(quota)), ZX_OK, "");
+    ASSERT_EQ(zx_vmo_create(vmo_pages * PAGE_SIZE, 0, vmo), ZX_OK, "");
+    return true;
+}
+
+static bool get_bti_info(zx_handle_t bti, zx_info_bti_t* info) {
+    ASSERT_EQ(zx_object_get_info(bti, ZX_INFO_BTI, info, sizeof(*info), NULL, NULL),
+              ZX_OK, "");
+    return true;
+}
+
+// Pins and then unpins |pages| pages of |vmo| at page |page|, returning the
+// device address of the first page in |addr|.
+static bool pin_unpin(zx_handle_t bti, zx_handle_t vmo, size_t page, size_t pages,
+                      uint32_t perms, zx_paddr_t* addr) {
+    zx_paddr_t addrs[MAX_PIN_PAGES];
+    ASSERT_LE(pages, (size_t)MAX_PIN_PAGES, "");
+    zx_handle_t pmt;
+    ASSERT_EQ(zx_bti_pin(bti, perms, vmo, page * PAGE_SIZE, pages * PAGE_SIZE,
+                         addrs, pages, &pmt), ZX_OK, "");
+    ASSERT_EQ(zx_pmt_unpin(pmt), ZX_OK, "");
+    if (addr)
+        *addr = addrs[0];
+    return true;
+}
+
+static bool is_pinned(zx_handle_t vmo, size_t page) {
+    return zx_vmo_op_range(vmo, ZX_VMO_OP_DECOMMIT, page * PAGE_SIZE, PAGE_SIZE,
+                           NULL, 0) == ZX_ERR_BAD_STATE;
+}
+
+static bool pin_cache_disabled_test(void) {
+    BEGIN_TEST;
+
+    zx_handle_t bti, vmo;
+    ASSERT_TRUE(create_bti(0, 1, &bti, &vmo), "");
+
+    ASSERT_TRUE(pin_unpin(bti, vmo, 0, 1, kPerms, NULL), "");
+    ASSERT_TRUE(pin_unpin(bti, vmo, 0, 1, kPerms, NULL), "");
+
+    zx_info_bti_t info;
+    ASSERT_TRUE(get_bti_info(bti, &info), "");
+    EXPECT_EQ(info.pin_cache_quota, 0u, "");
+    EXPECT_EQ(info.pin_cache_bytes, 0u, "");
+    EXPECT_EQ(info.pin_cache_hits, 0u, "");
+    EXPECT_EQ(info.pin_cache_misses, 0u, "");
+    EXPECT_FALSE(is_pinned(vmo, 0), "unpinned range still pinned");
+
+    ASSERT_EQ(zx_handle_close(vmo), ZX_OK, "");
+    ASSERT_EQ(zx_handle_close(bti), ZX_OK, "");
+
+    END_TEST;
+}
+
+static bool pin_cache_hit_test(void) {
+    BEGIN_TEST;
+
+    zx_handle_t bti, vmo;
+    ASSERT_TRUE(create_bti(4 * PAGE_SIZE, 2, &bti, &vmo), "");
+
+    zx_paddr_t first, second;
+    ASSERT_TRUE(pin_unpin(bti, vmo, 0, 2, kPerms, &first), "");
+
+    zx_info_bti_t info;
+    ASSERT_TRUE(get_bti_info(bti, &info), "");
+    EXPECT_EQ(info.pin_cache_bytes, 2u * PAGE_SIZE, "");
+    EXPECT_EQ(info.pin_cache_misses, 1u, "");
+    EXPECT_TRUE(is_pinned(vmo, 0), "cached range not pinned");
+
+    ASSERT_TRUE(pin_unpin(bti, vmo, 0, 2, kPerms, &second), "");
+    EXPECT_EQ(first, second, "cached pin mapped at a different address");
+
+    ASSERT_TRUE(get_bti_info(bti, &info), "");
+    EXPECT_EQ(info.pin_cache_bytes, 2u * PAGE_SIZE, "");
+    EXPECT_EQ(info.pin_cache_hits, 1u, "");
+    EXPECT_EQ(info.pin_cache_misses, 1u, "");
+
+    ASSERT_EQ(zx_handle_close(vmo), ZX_OK, "");
+    ASSERT_EQ(zx_handle_close(bti), ZX_OK, "");
+
+    END_TEST;
+}
+
+static bool pin_cache_miss_test(void) {
+    BEGIN_TEST;
+
+    zx_handle_t bti, vmo;
+    ASSERT_TRUE(create_bti(8 * PAGE_SIZE, 2, &bti, &vmo), "");
+
+    ASSERT_TRUE(pin_unpin(bti, vmo, 0, 2, kPerms, NULL), "");
+    // Only an exact match of offset, size and permissions is reused.
+    ASSERT_TRUE(pin_unpin(bti, vmo, 0, 1, kPerms, NULL), "");
+    ASSERT_TRUE(pin_unpin(bti, vmo, 1, 1, kPerms, NULL), "");
+    ASSERT_TRUE(pin_unpin(bti, vmo, 0, 2, ZX_BTI_PERM_READ, NULL), "");
+
+    zx_info_bti_t info;
+    ASSERT_TRUE(get_bti_info(bti, &info), "");
+    EXPECT_EQ(info.pin_cache_hits, 0u, "");
+    EXPECT_EQ(info.pin_cache_misses, 4u, "");
+    EXPECT_EQ(info.pin_cache_bytes, 6u * PAGE_SIZE, "");
+
+    ASSERT_EQ(zx_handle_close(vmo), ZX_OK, "");
+    ASSERT_EQ(zx_handle_close(bti), ZX_OK, "");
+
+    END_TEST;
+}
+
+static bool pin_cache_eviction_test(void) {
+    BEGIN_TEST;
+
+    zx_handle_t bti, vmo;
+    ASSERT_TRUE(create_bti(2 * PAGE_SIZE, 3, &bti, &vmo), "");
+
+    // The least recently unpinned range goes first.
+    for (size_t page = 0; page < 3; ++page) {
+        ASSERT_TRUE(pin_unpin(bti, vmo, page, 1, kPerms, NULL), "");
+    }
+
+    zx_info_bti_t info;
+    ASSERT_TRUE(get_bti_info(bti, &info), "");
+    EXPECT_EQ(info.pin_cache_bytes, 2u * PAGE_SIZE, "");
+    EXPECT_EQ(info.pin_cache_evictions, 1u, "");
+    EXPECT_FALSE(is_pinned(vmo, 0), "evicted range still pinned");
+    EXPECT_TRUE(is_pinned(vmo, 1), "");
+    EXPECT_TRUE(is_pinned(vmo, 2), "");
+
+    ASSERT_TRUE(pin_unpin(bti, vmo, 2, 1, kPerms, NULL), "");
+    ASSERT_TRUE(get_bti_info(bti, &info), "");
+    EXPECT_EQ(info.pin_cache_hits, 1u, "");
+
+    ASSERT_EQ(zx_handle_close(vmo), ZX_OK, "");
+    ASSERT_EQ(zx_handle_close(bti), ZX_OK, "");
+
+    END_TEST;
+}
+
+static bool pin_cache_quota_test(void) {
+    BEGIN_TEST;
+
+    zx_handle_t bti, vmo;
+    ASSERT_TRUE(create_bti(PAGE_SIZE, 2, &bti, &vmo), "");
+
+    // A range larger than the quota is never cached.
+    ASSERT_TRUE(pin_unpin(bti, vmo, 0, 2, kPerms, NULL), "");
+
+    zx_info_bti_t info;
+    ASSERT_TRUE(get_bti_info(bti, &info), "");
+    EXPECT_EQ(info.pin_cache_bytes, 0u, "");
+    EXPECT_EQ(info.pin_cache_evictions, 0u, "");
+    EXPECT_FALSE(is_pinned(vmo, 0), "");
+    EXPECT_FALSE(is_pinned(vmo, 1), "");
+
+    // One that fits is.
+    ASSERT_TRUE(pin_unpin(bti, vmo, 0, 1, kPerms, NULL), "");
+    ASSERT_TRUE(get_bti_info(bti, &info), "");
+    EXPECT_EQ(info.pin_cache_bytes, (uint64_t)PAGE_SIZE, "");
+
+    uint64_t quota = 0;
+    ASSERT_EQ(zx_object_get_property(bti, ZX_PROP_BTI_PIN_CACHE_QUOTA,
+                                     &quota, sizeof(quota)), ZX_OK, "");
+    EXPECT_EQ(quota, (uint64_t)PAGE_SIZE, "");
+
+    ASSERT_EQ(zx_handle_close(vmo), ZX_OK, "");
+    ASSERT_EQ(zx_handle_close(bti), ZX_OK, "");
+
+    END_TEST;
+}
+
+static bool pin_cache_release_test(void) {
+    BEGIN_TEST;
+
+    zx_handle_t bti, vmo;
+    ASSERT_TRUE(create_bti(4 * PAGE_SIZE, 4, &bti, &vmo), "");
+
+    ASSERT_TRUE(pin_unpin(bti, vmo, 0, 1, kPerms, NULL), "");
+    ASSERT_TRUE(pin_unpin(bti, vmo, 1, 1, kPerms, NULL), "");
+
+    // Dropping the quota to 0 releases everything in the cache.
+    uint64_t quota = 0;
+    ASSERT_EQ(zx_object_set_property(bti, ZX_PROP_BTI_PIN_CACHE_QUOTA,
+                                     &quota, sizeof(quota)), ZX_OK, "");
+    zx_info_bti_t info;
+    ASSERT_TRUE(get_bti_info(bti, &info), "");
+    EXPECT_EQ(info.pin_cache_bytes, 0u, "");
+    EXPECT_EQ(info.pin_cache_evictions, 2u, "");
+    EXPECT_FALSE(is_pinned(vmo, 0), "");
+    EXPECT_FALSE(is_pinned(vmo, 1), "");
+
+    // So does closing the last handle to the BTI.
+    quota = 4 * PAGE_SIZE;
+    ASSERT_EQ(zx_object_set_property(bti, ZX_PROP_BTI_PIN_CACHE_QUOTA,
+                                     &quota, sizeof(quota)), ZX_OK, "");
+    ASSERT_TRUE(pin_unpin(bti, vmo, 2, 1, kPerms, NULL), "");
+    EXPECT_TRUE(is_pinned(vmo, 2), "");
+    ASSERT_EQ(zx_handle_close(bti), ZX_OK, "");
+    EXPECT_FALSE(is_pinned(vmo, 2), "closed BTI kept its cached pin");
+
+    ASSERT_EQ(zx_handle_close(vmo), ZX_OK, "");
+
+    END_TEST;
+}
+
+BEGIN_TEST_CASE(bti_tests)
+RUN_TEST(pin_cache_disabled_test)
+RUN_TEST(pin_cache_hit_test)
+RUN_TEST(pin_cache_miss_test)
+RUN_TEST(pin_cache_eviction_test)
+RUN_TEST(pin_cache_quota_test)
+RUN_TEST(pin_cache_release_test)
+END_TEST_CASE(bti_tests)
@@ -8,6 +8,7 @@
 #include <zircon/syscalls.h>
 #include <zircon/syscalls/object.h>
 #include <unittest/unittest.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -1025,6 +1026,120 @@ static bool channel_write_different_sizes(void) {
     END_TEST;
 }
 
+// Write a batch of messages, one of them bad, and read them back in batches.
+static bool channel_write_read_many(void) {
+    BEGIN_TEST;
+
+    zx_handle_t channel[2];
+    ASSERT_EQ(zx_channel_create(0, &channel[0], &channel[1]), ZX_OK, "");
+
+    zx_handle_t event;
+    ASSERT_EQ(zx_event_create(0u, &event), ZX_OK, "");
+
+    zx_handle_t no_transfer;
+    ASSERT_EQ(zx_handle_duplicate(event, ZX_RIGHT_SIGNAL, &no_transfer), ZX_OK, "");
+
+    uint32_t data[3] = {1u, 2u, 3u};
+    zx_channel_msg_t out[4] = {
+        {.bytes = &data[0], .num_bytes = sizeof(uint32_t)},
+        {.bytes = &data[1], .num_bytes = sizeof(uint32_t), .handles = &event, .num_handles = 1u},
+        // A handle without ZX_RIGHT_TRANSFER fails without affecting the others.
+        {.handles = &no_transfer, .num_handles = 1u},
+        {.bytes = &data[2], .num_bytes = sizeof(uint32_t)},
+    };
+    EXPECT_EQ(zx_channel_write_many(channel[0], 0u, out, 4u), ZX_ERR_ACCESS_DENIED, "");
+    EXPECT_EQ(out[0].status, ZX_OK, "");
+    EXPECT_EQ(out[1].status, ZX_OK, "");
+    EXPECT_EQ(out[2].status, ZX_ERR_ACCESS_DENIED, "");
+    EXPECT_EQ(out[3].status, ZX_OK, "");
+
+    // Handles are consumed whether or not their message was written.
+    EXPECT_EQ(zx_handle_close(no_transfer), ZX_ERR_BAD_HANDLE, "");
+    EXPECT_EQ(zx_handle_close(event), ZX_ERR_BAD_HANDLE, "");
+
+    uint32_t recv[3] = {};
+    zx_handle_t recv_handle = ZX_HANDLE_INVALID;
+    zx_channel_msg_t in[2] = {
+        {.bytes = &recv[0], .num_bytes = sizeof(uint32_t)},
+        {.bytes = &recv[1], .num_bytes = sizeof(uint32_t)},
+    };
+    // The second message carries a handle that does not fit.
+    uint32_t actual = 0u;
+    EXPECT_EQ(zx_channel_read_many(channel[1], 0u, in, 2u, &actual), ZX_OK, "");
+    EXPECT_EQ(actual, 1u, "");
+    EXPECT_EQ(in[0].status, ZX_OK, "");
+    EXPECT_EQ(recv[0], 1u, "");
+    EXPECT_EQ(in[1].status, ZX_ERR_BUFFER_TOO_SMALL, "");
+    EXPECT_EQ(in[1].num_handles, 1u, "");
+
+    in[0] = (zx_channel_msg_t){.bytes = &recv[1], .num_bytes = sizeof(uint32_t),
+                               .handles = &recv_handle, .num_handles = 1u};
+    in[1] = (zx_channel_msg_t){.bytes = &recv[2], .num_bytes = sizeof(uint32_t)};
+    EXPECT_EQ(zx_channel_read_many(channel[1], 0u, in, 2u, &actual), ZX_OK, "");
+    EXPECT_EQ(actual, 2u, "");
+    EXPECT_EQ(recv[1], 2u, "");
+    EXPECT_EQ(recv[2], 3u, "");
+    EXPECT_NE(recv_handle, ZX_HANDLE_INVALID, "");
+
+    EXPECT_EQ(zx_channel_read_many(channel[1], 0u, in, 2u, &actual), ZX_ERR_SHOULD_WAIT, "");
+    EXPECT_EQ(zx_handle_close(channel[0]), ZX_OK, "");
+    EXPECT_EQ(zx_channel_read_many(channel[1], 0u, in, 2u, &actual), ZX_ERR_PEER_CLOSED, "");
+
+    EXPECT_EQ(zx_handle_close(recv_handle), ZX_OK, "");
+    EXPECT_EQ(zx_handle_close(channel[1]), ZX_OK, "");
+    END_TEST;
+}
+
+// Pages moved by ZX_CHANNEL_WRITE_MOVE_PAGES arrive intact and leave the
+// writer's range zero filled.
+static bool channel_write_move_pages(void) {
+    BEGIN_TEST;
+
+    const size_t kSize = 4 * PAGE_SIZE;
+    zx_handle_t channel[2];
+    ASSERT_EQ(zx_channel_create(0, &channel[0], &channel[1]), ZX_OK, "");
+
+    zx_handle_t vmo;
+    ASSERT_EQ(zx_vmo_create(2 * kSize, 0, &vmo), ZX_OK, "");
+    uintptr_t addr = 0;
+    ASSERT_EQ(zx_vmar_map(zx_vmar_root_self(), ZX_VM_PERM_READ | ZX_VM_PERM_WRITE,
+                          0u, vmo, 0, 2 * kSize, &addr), ZX_OK, "");
+    uint8_t* send = (uint8_t*)addr;
+    uint8_t* recv = send + kSize;
+
+    for (size_t i = 0; i < kSize; ++i) {
+        send[i] = (uint8_t)(i * 7);
+    }
+    EXPECT_EQ(zx_channel_write(channel[0], ZX_CHANNEL_WRITE_MOVE_PAGES, send, (uint32_t)kSize,
+                               NULL, 0u), ZX_OK, "");
+    for (size_t i = 0; i < kSize; ++i) {
+        ASSERT_EQ(send[i], 0u, "moved range should read as zero");
+    }
+
+    uint32_t actual_bytes = 0;
+    EXPECT_EQ(zx_channel_read(channel[1], 0u, recv, NULL, (uint32_t)kSize, 0u,
+                              &actual_bytes, NULL), ZX_OK, "");
+    EXPECT_EQ(actual_bytes, kSize, "");
+    for (size_t i = 0; i < kSize; ++i) {
+        ASSERT_EQ(recv[i], (uint8_t)(i * 7), "");
+    }
+
+    // Unaligned writes fall back to copying.
+    EXPECT_EQ(zx_channel_write(channel[0], ZX_CHANNEL_WRITE_MOVE_PAGES, recv + 1, 16u,
+                               NULL, 0u), ZX_OK, "");
+    EXPECT_EQ(recv[1], (uint8_t)7, "");
+    uint8_t small[16];
+    EXPECT_EQ(zx_channel_read(channel[1], 0u, small, NULL, sizeof(small), 0u,
+                              &actual_bytes, NULL), ZX_OK, "");
+    EXPECT_EQ(memcmp(small, recv + 1, sizeof(small)), 0, "");
+
+    EXPECT_EQ(zx_vmar_unmap(zx_vmar_root_self(), addr, 2 * kSize), ZX_OK, "");
+    EXPECT_EQ(zx_handle_close(vmo), ZX_OK, "");
+    EXPECT_EQ(zx_handle_close(channel[0]), ZX_OK, "");
+    EXPECT_EQ(zx_handle_close(channel[1]), ZX_OK, "");
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(channel_tests)
 RUN_TEST(channel_test)
 RUN_TEST(channel_read_error_test)
@@ -1042,6 +1157,8 @@ RUN_TEST(channel_nest)
 RUN_TEST(channel_disallow_write_to_self)
 RUN_TEST(channel_read_etc)
 RUN_TEST(channel_write_different_sizes)
+RUN_TEST(channel_write_read_many)
+RUN_TEST(channel_write_move_pages)
 END_TEST_CASE(channel_tests)
 
 #ifndef BUILD_COMBINED_TESTS
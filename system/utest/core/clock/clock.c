@@ -32,8 +32,55 @@ static bool clock_monotonic_test(void) {
     END_TEST;
 }
 
+// The vDSO may compute the monotonic clock in user mode.  Check it agrees
+// with the kernel's view, which decides when a sleep is over.
+static bool clock_monotonic_matches_kernel_test(void) {
+    BEGIN_TEST;
+
+    for (int idx = 0; idx < 100; ++idx) {
+        zx_time_t deadline = zx_time_add_duration(zx_clock_get_monotonic(), ZX_USEC(10));
+        ASSERT_EQ(zx_nanosleep(deadline), ZX_OK, "");
+        ASSERT_GE(zx_clock_get_monotonic(), deadline, "woke up before the deadline");
+
+        zx_time_t now;
+        ASSERT_EQ(zx_clock_get_new(ZX_CLOCK_MONOTONIC, &now), ZX_OK, "");
+        ASSERT_GE(now, deadline, "");
+        ASSERT_GE(zx_clock_get(ZX_CLOCK_MONOTONIC), now, "");
+    }
+
+    END_TEST;
+}
+
+static bool clock_utc_test(void) {
+    BEGIN_TEST;
+
+    // UTC is the monotonic clock offset by what was last set with
+    // zx_clock_adjust(), so both ways of reading it must work.
+    zx_time_t utc = 0;
+    ASSERT_EQ(zx_clock_get_new(ZX_CLOCK_UTC, &utc), ZX_OK, "");
+    ASSERT_NE(zx_clock_get(ZX_CLOCK_UTC), 0, "");
+
+    END_TEST;
+}
+
+static bool clock_get_new_test(void) {
+    BEGIN_TEST;
+
+    zx_time_t time = 0;
+    ASSERT_EQ(zx_clock_get_new(ZX_CLOCK_THREAD, &time), ZX_OK, "");
+    ASSERT_GT(time, 0, "this thread has run");
+
+    ASSERT_EQ(zx_clock_get_new(12345u, &time), ZX_ERR_INVALID_ARGS, "");
+    ASSERT_EQ(zx_clock_get(12345u), 0, "");
+
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(clock_tests)
 RUN_TEST(clock_monotonic_test)
+RUN_TEST(clock_monotonic_matches_kernel_test)
+RUN_TEST(clock_utc_test)
+RUN_TEST(clock_get_new_test)
 END_TEST_CASE(clock_tests)
 
 #ifndef BUILD_COMBINED_TESTS
@@ -157,6 +157,83 @@ static bool options_test(void) {
     zx_handle_t fifos[2];
     ASSERT_EQ(zx_fifo_create(23, 8, 8, &fifos[0], &fifos[1]),
               ZX_ERR_OUT_OF_RANGE, "");
+    ASSERT_EQ(zx_fifo_create(8, 8, 2, &fifos[0], &fifos[1]),
+              ZX_ERR_INVALID_ARGS, "");
+
+    // Only shared fifos have a vmo.
+    ASSERT_EQ(zx_fifo_create(8, 8, 0, &fifos[0], &fifos[1]), ZX_OK, "");
+    zx_handle_t vmo;
+    uint32_t ring;
+    EXPECT_EQ(zx_fifo_get_vmo(fifos[0], &vmo, &ring), ZX_ERR_NOT_SUPPORTED, "");
+    EXPECT_EQ(zx_fifo_update_signals(fifos[0]), ZX_ERR_NOT_SUPPORTED, "");
+    zx_handle_close(fifos[0]);
+    zx_handle_close(fifos[1]);
+
+    END_TEST;
+}
+
+// Elements moved through the mapped rings and through the syscalls of a
+// ZX_FIFO_SHARED fifo are seen by the other side.
+static bool shared_test(void) {
+    BEGIN_TEST;
+
+    enum { COUNT = 8, ELEM_SZ = sizeof(uint64_t) };
+    zx_handle_t a, b;
+    ASSERT_EQ(zx_fifo_create(COUNT, ELEM_SZ, ZX_FIFO_SHARED, &a, &b), ZX_OK, "");
+
+    zx_handle_t vmo;
+    uint32_t a_ring, b_ring;
+    ASSERT_EQ(zx_fifo_get_vmo(b, &vmo, &b_ring), ZX_OK, "");
+    zx_handle_close(vmo);
+    ASSERT_EQ(zx_fifo_get_vmo(a, &vmo, &a_ring), ZX_OK, "");
+    EXPECT_EQ(a_ring, 0u, "");
+    EXPECT_EQ(b_ring, 1u, "");
+
+    uintptr_t addr;
+    ASSERT_EQ(zx_vmar_map(zx_vmar_root_self(), ZX_VM_PERM_READ | ZX_VM_PERM_WRITE, 0,
+                          vmo, 0, ZX_FIFO_SHARED_VMO_SIZE, &addr), ZX_OK, "");
+    zx_fifo_ring_t* tx = (zx_fifo_ring_t*)(addr + ZX_FIFO_SHARED_RING_OFFSET(a_ring));
+    uint64_t* tx_data = (uint64_t*)(addr + ZX_FIFO_SHARED_DATA_OFFSET(a_ring));
+    zx_fifo_ring_t* rx = (zx_fifo_ring_t*)(addr + ZX_FIFO_SHARED_RING_OFFSET(b_ring));
+    uint64_t* rx_data = (uint64_t*)(addr + ZX_FIFO_SHARED_DATA_OFFSET(b_ring));
+
+    // Produce directly from a, consume with a syscall on b.
+    for (uint64_t i = 0; i < 3; ++i) {
+        tx_data[i] = i + 100;
+    }
+    __atomic_store_n(&tx->head, 3u, __ATOMIC_SEQ_CST);
+    EXPECT_EQ(__atomic_load_n(&tx->tail, __ATOMIC_SEQ_CST), 0u, "was empty");
+    EXPECT_SIGNALS(b, ZX_FIFO_WRITABLE);
+    EXPECT_EQ(zx_fifo_update_signals(a), ZX_OK, "");
+    EXPECT_SIGNALS(b, ZX_FIFO_WRITABLE | ZX_FIFO_READABLE);
+
+    uint64_t n[COUNT];
+    size_t actual;
+    EXPECT_EQ(zx_fifo_read(b, ELEM_SZ, n, COUNT, &actual), ZX_OK, "");
+    EXPECT_EQ(actual, 3u, "");
+    EXPECT_EQ(n[0], 100u, "");
+    EXPECT_EQ(n[2], 102u, "");
+    EXPECT_EQ(__atomic_load_n(&tx->tail, __ATOMIC_SEQ_CST), 3u, "");
+    EXPECT_SIGNALS(b, ZX_FIFO_WRITABLE);
+
+    // Produce with a syscall on b, consume directly from a.
+    n[0] = 7u;
+    EXPECT_EQ(zx_fifo_write(b, ELEM_SZ, n, 1, &actual), ZX_OK, "");
+    EXPECT_SIGNALS(a, ZX_FIFO_WRITABLE | ZX_FIFO_READABLE);
+    EXPECT_EQ(__atomic_load_n(&rx->head, __ATOMIC_SEQ_CST), 1u, "");
+    EXPECT_EQ(rx_data[0], 7u, "");
+    __atomic_store_n(&rx->tail, 1u, __ATOMIC_SEQ_CST);
+    EXPECT_EQ(zx_fifo_update_signals(a), ZX_OK, "");
+    EXPECT_SIGNALS(a, ZX_FIFO_WRITABLE);
+
+    // The kernel refuses rings whose indices make no sense.
+    __atomic_store_n(&tx->head, 3u + COUNT + 1, __ATOMIC_SEQ_CST);
+    EXPECT_EQ(zx_fifo_read(b, ELEM_SZ, n, COUNT, &actual), ZX_ERR_BAD_STATE, "");
+
+    zx_vmar_unmap(zx_vmar_root_self(), addr, ZX_FIFO_SHARED_VMO_SIZE);
+    zx_handle_close(vmo);
+    zx_handle_close(a);
+    zx_handle_close(b);
 
     END_TEST;
 }
@@ -165,6 +242,7 @@ BEGIN_TEST_CASE(fifo_tests)
 RUN_TEST(basic_test)
 RUN_TEST(peer_closed_test)
 RUN_TEST(options_test)
+RUN_TEST(shared_test)
 END_TEST_CASE(fifo_tests)
 
 #ifndef BUILD_COMBINED_TESTS
@@ -437,6 +437,60 @@ static bool TestFutexThreadSuspended() {
 }
 
 // Test that misaligned pointers cause futex syscalls to return a failure.
+struct PiWaiter {
+    volatile int32_t* futex_addr;
+    zx_handle_t owner;
+    volatile bool about_to_wait;
+    zx_status_t status;
+};
+
+static int pi_wait_thread(void* arg) {
+    PiWaiter* waiter = reinterpret_cast<PiWaiter*>(arg);
+    waiter->about_to_wait = true;
+    waiter->status = zx_futex_wait_pi(const_cast<int32_t*>(waiter->futex_addr),
+                                      *waiter->futex_addr, waiter->owner,
+                                      ZX_TIME_INFINITE);
+    return 0;
+}
+
+// Check the argument checks of futex_wait_pi(), and that futex_wake_pi()
+// wakes a thread that named us as the futex's owner.
+static bool TestFutexPi() {
+    BEGIN_TEST;
+    volatile int32_t futex_value = 1;
+
+    // A thread cannot block on a futex that it owns.
+    EXPECT_EQ(zx_futex_wait_pi(const_cast<int32_t*>(&futex_value), futex_value,
+                               zx_thread_self(), ZX_TIME_INFINITE),
+              ZX_ERR_INVALID_ARGS);
+
+    zx_handle_t event;
+    ASSERT_EQ(zx_event_create(0, &event), ZX_OK);
+    EXPECT_EQ(zx_futex_wait_pi(const_cast<int32_t*>(&futex_value), futex_value,
+                               event, ZX_TIME_INFINITE),
+              ZX_ERR_WRONG_TYPE);
+    EXPECT_EQ(zx_handle_close(event), ZX_OK);
+
+    // Waking a futex without waiters is not an error.
+    EXPECT_EQ(zx_futex_wake_pi(const_cast<int32_t*>(&futex_value)), ZX_OK);
+
+    PiWaiter waiter = {&futex_value, zx_thread_self(), false, ZX_ERR_INTERNAL};
+    thrd_t thread;
+    ASSERT_EQ(thrd_create_with_name(&thread, pi_wait_thread, &waiter, "pi_waiter"),
+              thrd_success);
+    // As with TestThread, only look at the thread's state once it is past
+    // any libc-internal futex waits.
+    while (!waiter.about_to_wait) {
+        sched_yield();
+    }
+    ASSERT_TRUE(wait_until_blocked_on_some_futex(thrd_get_zx_handle(thread)));
+
+    EXPECT_EQ(zx_futex_wake_pi(const_cast<int32_t*>(&futex_value)), ZX_OK);
+    EXPECT_EQ(thrd_join(thread, NULL), thrd_success);
+    EXPECT_EQ(waiter.status, ZX_OK);
+    END_TEST;
+}
+
 static bool TestFutexMisaligned() {
     BEGIN_TEST;
 
@@ -556,6 +610,7 @@ RUN_TEST(TestFutexRequeue);
 RUN_TEST(TestFutexRequeueUnqueuedOnTimeout);
 RUN_TEST(TestFutexThreadKilled);
 RUN_TEST(TestFutexThreadSuspended);
+RUN_TEST(TestFutexPi);
 RUN_TEST(TestFutexMisaligned);
 RUN_TEST(TestEventSignaling);
 END_TEST_CASE(futex_tests)
@@ -283,8 +283,43 @@ bool handle_wait_test(void) {
     END_TEST;
 }
 
+static bool wait_many_poll_test(void) {
+    BEGIN_TEST;
+
+    zx_handle_t events[4];
+    for (size_t i = 0; i < countof(events); ++i)
+        ASSERT_EQ(zx_event_create(0u, &events[i]), ZX_OK, "");
+
+    zx_wait_item_t items[4];
+    for (size_t i = 0; i < countof(items); ++i) {
+        items[i].handle = events[i];
+        items[i].waitfor = ZX_EVENT_SIGNALED;
+        items[i].pending = 0xffffffffu;
+    }
+
+    // Nothing signaled and a deadline in the past: report the state and time out.
+    EXPECT_EQ(zx_object_wait_many(items, countof(items), 0u), ZX_ERR_TIMED_OUT, "");
+    for (size_t i = 0; i < countof(items); ++i)
+        EXPECT_EQ(items[i].pending, 0u, "");
+
+    // One item already satisfied: return at once with an infinite deadline.
+    ASSERT_EQ(zx_object_signal(events[2], 0u, ZX_EVENT_SIGNALED | ZX_USER_SIGNAL_0), ZX_OK, "");
+    EXPECT_EQ(zx_object_wait_many(items, countof(items), ZX_TIME_INFINITE), ZX_OK, "");
+    EXPECT_EQ(items[0].pending, 0u, "");
+    EXPECT_EQ(items[2].pending, ZX_EVENT_SIGNALED | ZX_USER_SIGNAL_0, "");
+
+    // A bad handle anywhere in the set still fails the whole call.
+    items[3].handle = ZX_HANDLE_INVALID;
+    EXPECT_EQ(zx_object_wait_many(items, countof(items), 0u), ZX_ERR_BAD_HANDLE, "");
+
+    for (size_t i = 0; i < countof(events); ++i)
+        EXPECT_EQ(zx_handle_close(events[i]), ZX_OK, "");
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(handle_wait_tests)
 RUN_TEST(handle_wait_test);
+RUN_TEST(wait_many_poll_test);
 END_TEST_CASE(handle_wait_tests)
 
 #ifndef BUILD_COMBINED_TESTS
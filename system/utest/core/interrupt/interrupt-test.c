@@ -87,6 +87,7 @@ static bool interrupt_port_bound_test(void) {
     ASSERT_EQ(zx_interrupt_ack(virt_interrupt_port_handle), ZX_OK, "");
     ASSERT_EQ(zx_port_wait(port_handle_bind, ZX_TIME_INFINITE, &out), ZX_OK, "");
     ASSERT_EQ(out.interrupt.timestamp, signaled_timestamp_1, "");
+    ASSERT_EQ(out.interrupt.count, 1u, "");
     ASSERT_EQ(out.key, key, "");
     ASSERT_EQ(out.type, ZX_PKT_TYPE_INTERRUPT, "");
     ASSERT_EQ(out.status, ZX_OK, "");
@@ -115,6 +116,102 @@ static bool interrupt_port_bound_test(void) {
     END_TEST;
 }
 
+// Tests that a coalescing interrupt folds several triggers into one packet
+static bool interrupt_port_coalesce_test(void) {
+    BEGIN_TEST;
+
+    zx_handle_t vinth;
+    zx_handle_t port;
+    zx_handle_t rsrc = get_root_resource();
+    zx_port_packet_t out;
+    uint64_t key = 123;
+
+    ASSERT_EQ(zx_interrupt_create(rsrc, 0, ZX_INTERRUPT_VIRTUAL, &vinth), ZX_OK, "");
+    ASSERT_EQ(zx_port_create(ZX_PORT_BIND_TO_INTERRUPT, &port), ZX_OK, "");
+    ASSERT_EQ(zx_interrupt_bind(vinth, port, key, 0), ZX_OK, "");
+
+    zx_interrupt_coalesce_t coalesce = {};
+    coalesce.max_count = 2;
+    ASSERT_EQ(zx_object_set_property(vinth, ZX_PROP_INTERRUPT_COALESCE,
+                                     &coalesce, sizeof(coalesce)), ZX_ERR_INVALID_ARGS, "");
+
+    // Deliver by count.
+    coalesce.max_count = 3;
+    coalesce.max_delay = ZX_SEC(1000);
+    ASSERT_EQ(zx_object_set_property(vinth, ZX_PROP_INTERRUPT_COALESCE,
+                                     &coalesce, sizeof(coalesce)), ZX_OK, "");
+    zx_interrupt_coalesce_t readback = {};
+    ASSERT_EQ(zx_object_get_property(vinth, ZX_PROP_INTERRUPT_COALESCE,
+                                     &readback, sizeof(readback)), ZX_OK, "");
+    ASSERT_EQ(readback.max_count, 3u, "");
+    ASSERT_EQ(readback.max_delay, ZX_SEC(1000), "");
+
+    ASSERT_EQ(zx_interrupt_trigger(vinth, 0, 100), ZX_OK, "");
+    ASSERT_EQ(zx_interrupt_trigger(vinth, 0, 200), ZX_OK, "");
+    ASSERT_EQ(zx_port_wait(port, 0, &out), ZX_ERR_TIMED_OUT, "");
+    ASSERT_EQ(zx_interrupt_trigger(vinth, 0, 300), ZX_OK, "");
+    ASSERT_EQ(zx_port_wait(port, 0, &out), ZX_OK, "");
+    ASSERT_EQ(out.key, key, "");
+    ASSERT_EQ(out.type, ZX_PKT_TYPE_INTERRUPT, "");
+    ASSERT_EQ(out.interrupt.timestamp, 100, "");
+    ASSERT_EQ(out.interrupt.last_timestamp, 300, "");
+    ASSERT_EQ(out.interrupt.count, 3u, "");
+    ASSERT_EQ(zx_interrupt_ack(vinth), ZX_OK, "");
+
+    // Deliver by time.
+    coalesce.max_count = 100;
+    coalesce.max_delay = ZX_MSEC(1);
+    ASSERT_EQ(zx_object_set_property(vinth, ZX_PROP_INTERRUPT_COALESCE,
+                                     &coalesce, sizeof(coalesce)), ZX_OK, "");
+    ASSERT_EQ(zx_interrupt_trigger(vinth, 0, 400), ZX_OK, "");
+    ASSERT_EQ(zx_port_wait(port, ZX_TIME_INFINITE, &out), ZX_OK, "");
+    ASSERT_EQ(out.interrupt.timestamp, 400, "");
+    ASSERT_EQ(out.interrupt.count, 1u, "");
+
+    ASSERT_EQ(zx_handle_close(vinth), ZX_OK, "");
+    ASSERT_EQ(zx_handle_close(port), ZX_OK, "");
+
+    END_TEST;
+}
+
+// Tests ZX_INFO_INTERRUPT and ZX_PROP_INTERRUPT_AFFINITY on a virtual interrupt
+static bool interrupt_info_test(void) {
+    BEGIN_TEST;
+
+    zx_handle_t vinth;
+    zx_handle_t rsrc = get_root_resource();
+    ASSERT_EQ(zx_interrupt_create(rsrc, 0, ZX_INTERRUPT_VIRTUAL, &vinth), ZX_OK, "");
+
+    zx_interrupt_coalesce_t coalesce = {};
+    coalesce.max_count = 8;
+    coalesce.max_delay = ZX_USEC(50);
+    ASSERT_EQ(zx_object_set_property(vinth, ZX_PROP_INTERRUPT_COALESCE,
+                                     &coalesce, sizeof(coalesce)), ZX_OK, "");
+
+    zx_info_interrupt_t info;
+    size_t actual, avail;
+    ASSERT_EQ(zx_object_get_info(vinth, ZX_INFO_INTERRUPT, &info, sizeof(info),
+                                 &actual, &avail), ZX_OK, "");
+    EXPECT_EQ(actual, 1u, "");
+    EXPECT_EQ(avail, 1u, "");
+    EXPECT_EQ(info.cpu_affinity, ZX_INFO_INVALID_CPU, "");
+    EXPECT_EQ(info.flags, ZX_INFO_INTERRUPT_FLAG_VIRTUAL, "");
+    EXPECT_EQ(info.coalesce.max_count, 8u, "");
+    EXPECT_EQ(info.coalesce.max_delay, ZX_USEC(50), "");
+
+    // Virtual interrupts are not delivered by any cpu.
+    uint32_t cpu = 0;
+    EXPECT_EQ(zx_object_set_property(vinth, ZX_PROP_INTERRUPT_AFFINITY, &cpu, sizeof(cpu)),
+              ZX_ERR_NOT_SUPPORTED, "");
+    cpu = UINT32_MAX;
+    EXPECT_EQ(zx_object_set_property(vinth, ZX_PROP_INTERRUPT_AFFINITY, &cpu, sizeof(cpu)),
+              ZX_ERR_INVALID_ARGS, "");
+
+    ASSERT_EQ(zx_handle_close(vinth), ZX_OK, "");
+
+    END_TEST;
+}
+
 // Tests support for virtual interrupts
 static bool interrupt_test(void) {
     BEGIN_TEST;
@@ -193,5 +290,7 @@ BEGIN_TEST_CASE(interrupt_tests)
 RUN_TEST(interrupt_test)
 RUN_TEST(interrupt_port_bound_test)
 RUN_TEST(interrupt_port_non_bindable_test)
+RUN_TEST(interrupt_port_coalesce_test)
+RUN_TEST(interrupt_info_test)
 RUN_TEST(interrupt_suspend_test)
 END_TEST_CASE(interrupt_tests)
@@ -10,6 +10,7 @@
 #include <zircon/process.h>
 #include <zircon/rights.h>
 #include <zircon/syscalls.h>
+#include <zircon/syscalls/object.h>
 #include <zircon/syscalls/policy.h>
 
 #include <mini-process/mini-process.h>
@@ -288,6 +289,116 @@ static bool max_height_smoke(void) {
     END_TEST;
 }
 
+static bool cpu_bandwidth_property_test(void) {
+    BEGIN_TEST;
+
+    zx_handle_t job;
+    ASSERT_EQ(zx_job_create(zx_job_default(), 0u, &job), ZX_OK, "");
+
+    // There is no cap by default.
+    zx_job_cpu_bandwidth_t limit = {.quota = 1, .period = 1};
+    ASSERT_EQ(zx_object_get_property(job, ZX_PROP_JOB_CPU_BANDWIDTH, &limit, sizeof(limit)),
+              ZX_OK, "");
+    EXPECT_EQ(limit.quota, 0, "");
+    EXPECT_EQ(limit.period, 0, "");
+
+    limit.quota = ZX_MSEC(1);
+    limit.period = ZX_MSEC(10);
+    ASSERT_EQ(zx_object_set_property(job, ZX_PROP_JOB_CPU_BANDWIDTH, &limit, sizeof(limit)),
+              ZX_OK, "");
+    zx_job_cpu_bandwidth_t value;
+    ASSERT_EQ(zx_object_get_property(job, ZX_PROP_JOB_CPU_BANDWIDTH, &value, sizeof(value)),
+              ZX_OK, "");
+    EXPECT_EQ(value.quota, ZX_MSEC(1), "");
+    EXPECT_EQ(value.period, ZX_MSEC(10), "");
+
+    zx_info_job_cpu_bandwidth_t info;
+    ASSERT_EQ(zx_object_get_info(job, ZX_INFO_JOB_CPU_BANDWIDTH, &info, sizeof(info),
+                                 NULL, NULL), ZX_OK, "");
+    EXPECT_EQ(info.limit.quota, ZX_MSEC(1), "");
+    EXPECT_EQ(info.limit.period, ZX_MSEC(10), "");
+    EXPECT_EQ(info.period_used, 0, "job without threads was charged");
+    EXPECT_EQ(info.throttled_periods, 0u, "");
+
+    // Out of range periods and quotas are rejected, and leave the cap alone.
+    zx_job_cpu_bandwidth_t bad[] = {
+        {.quota = ZX_MSEC(1), .period = ZX_MSEC(5)},
+        {.quota = ZX_MSEC(1), .period = ZX_SEC(20)},
+        {.quota = ZX_USEC(500), .period = ZX_MSEC(10)},
+    };
+    for (size_t i = 0; i < countof(bad); i++) {
+        EXPECT_EQ(zx_object_set_property(job, ZX_PROP_JOB_CPU_BANDWIDTH, &bad[i], sizeof(bad[i])),
+                  ZX_ERR_INVALID_ARGS, "");
+    }
+    ASSERT_EQ(zx_object_get_property(job, ZX_PROP_JOB_CPU_BANDWIDTH, &value, sizeof(value)),
+              ZX_OK, "");
+    EXPECT_EQ(value.quota, ZX_MSEC(1), "");
+
+    EXPECT_EQ(zx_object_set_property(job, ZX_PROP_JOB_CPU_BANDWIDTH, &limit, sizeof(limit) - 1),
+              ZX_ERR_BUFFER_TOO_SMALL, "");
+    EXPECT_EQ(zx_object_get_property(job, ZX_PROP_JOB_CPU_BANDWIDTH, &value, sizeof(value) - 1),
+              ZX_ERR_BUFFER_TOO_SMALL, "");
+    EXPECT_EQ(zx_object_set_property(zx_process_self(), ZX_PROP_JOB_CPU_BANDWIDTH,
+                                     &limit, sizeof(limit)), ZX_ERR_WRONG_TYPE, "");
+    EXPECT_EQ(zx_object_get_info(zx_process_self(), ZX_INFO_JOB_CPU_BANDWIDTH, &info,
+                                 sizeof(info), NULL, NULL), ZX_ERR_WRONG_TYPE, "");
+
+    // A quota of 0 removes the cap.
+    limit.quota = 0;
+    ASSERT_EQ(zx_object_set_property(job, ZX_PROP_JOB_CPU_BANDWIDTH, &limit, sizeof(limit)),
+              ZX_OK, "");
+    ASSERT_EQ(zx_object_get_info(job, ZX_INFO_JOB_CPU_BANDWIDTH, &info, sizeof(info),
+                                 NULL, NULL), ZX_OK, "");
+    EXPECT_EQ(info.limit.quota, 0, "");
+    EXPECT_EQ(info.limit.period, 0, "");
+
+    ASSERT_EQ(zx_handle_close(job), ZX_OK, "");
+
+    END_TEST;
+}
+
+static zx_duration_t thread_runtime(void) {
+    zx_info_thread_stats_t stats;
+    if (zx_object_get_info(zx_thread_self(), ZX_INFO_THREAD_STATS, &stats, sizeof(stats),
+                           NULL, NULL) != ZX_OK)
+        return -1;
+    return stats.total_runtime;
+}
+
+static bool cpu_bandwidth_throttle_test(void) {
+    BEGIN_TEST;
+
+    // Cap the job this test runs in at a quarter of a cpu, and spin. The
+    // test's own thread then only gets about a quarter of the time it spins.
+    zx_handle_t job = zx_job_default();
+    zx_job_cpu_bandwidth_t limit = {.quota = ZX_MSEC(5), .period = ZX_MSEC(20)};
+    ASSERT_EQ(zx_object_set_property(job, ZX_PROP_JOB_CPU_BANDWIDTH, &limit, sizeof(limit)),
+              ZX_OK, "");
+
+    const zx_duration_t kSpinTime = ZX_MSEC(400);
+    zx_duration_t runtime = thread_runtime();
+    zx_time_t start = zx_clock_get_monotonic();
+    while (zx_clock_get_monotonic() - start < kSpinTime) {
+    }
+    runtime = thread_runtime() - runtime;
+
+    zx_info_job_cpu_bandwidth_t info;
+    zx_status_t status = zx_object_get_info(job, ZX_INFO_JOB_CPU_BANDWIDTH, &info, sizeof(info),
+                                            NULL, NULL);
+    limit.quota = 0;
+    ASSERT_EQ(zx_object_set_property(job, ZX_PROP_JOB_CPU_BANDWIDTH, &limit, sizeof(limit)),
+              ZX_OK, "");
+    ASSERT_EQ(status, ZX_OK, "");
+
+    EXPECT_GT(info.throttled_periods, 0u, "job was never throttled");
+    EXPECT_GT(runtime, 0, "");
+    // The quota may be overrun by about a millisecond a period, so allow
+    // well under the whole spin but over the quarter.
+    EXPECT_LT(runtime, kSpinTime / 2, "throttled thread ran for too long");
+
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(job_tests)
 RUN_TEST(basic_test)
 RUN_TEST(create_missing_rights_test)
@@ -299,4 +410,6 @@ RUN_TEST(set_job_oom_kill_bit)
 RUN_TEST(wait_test)
 RUN_TEST(info_task_stats_fails)
 RUN_TEST(max_height_smoke)
+RUN_TEST(cpu_bandwidth_property_test)
+RUN_TEST(cpu_bandwidth_throttle_test)
 END_TEST_CASE(job_tests)
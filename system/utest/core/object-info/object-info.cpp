@@ -90,6 +90,34 @@ bool task_stats_smoke() {
     END_TEST;
 }
 
+// Tests that ZX_INFO_TASK_USAGE charges a process and its job.
+bool task_usage_smoke() {
+    BEGIN_TEST;
+    // Run for a few milliseconds and then block, so the scheduler charges
+    // the runtime when this thread is switched out.
+    zx_time_t deadline = zx_clock_get_monotonic() + ZX_MSEC(5);
+    while (zx_clock_get_monotonic() < deadline) {
+    }
+    zx_nanosleep(zx_deadline_after(ZX_MSEC(1)));
+
+    zx_info_task_usage_t process_info;
+    ASSERT_EQ(zx_object_get_info(zx_process_self(), ZX_INFO_TASK_USAGE,
+                                 &process_info, sizeof(process_info), nullptr, nullptr),
+              ZX_OK);
+    EXPECT_GT(process_info.cpu_time, ZX_MSEC(1));
+    EXPECT_GT(process_info.context_switches, 0u);
+
+    // The job was read second, and also covers every other process in it.
+    zx_info_task_usage_t job_info;
+    ASSERT_EQ(zx_object_get_info(zx_job_default(), ZX_INFO_TASK_USAGE,
+                                 &job_info, sizeof(job_info), nullptr, nullptr),
+              ZX_OK);
+    EXPECT_GE(job_info.cpu_time, process_info.cpu_time);
+    EXPECT_GE(job_info.context_switches, process_info.context_switches);
+    EXPECT_GE(job_info.page_faults, process_info.page_faults);
+    END_TEST;
+}
+
 // Structs to keep track of VMARs/mappings in the test child process.
 struct TestMapping {
     uintptr_t base;
@@ -996,6 +1024,11 @@ RUN_SINGLE_ENTRY_TESTS(ZX_INFO_TASK_STATS, zx_info_task_stats_t, zx_process_self
 RUN_TEST((wrong_handle_type_fails<ZX_INFO_TASK_STATS, zx_info_task_stats_t, get_test_job>));
 RUN_TEST((wrong_handle_type_fails<ZX_INFO_TASK_STATS, zx_info_task_stats_t, zx_thread_self>));
 
+RUN_TEST(task_usage_smoke);
+RUN_SINGLE_ENTRY_TESTS(ZX_INFO_TASK_USAGE, zx_info_task_usage_t, get_test_job);
+RUN_SINGLE_ENTRY_TESTS(ZX_INFO_TASK_USAGE, zx_info_task_usage_t, get_test_process);
+RUN_TEST((wrong_handle_type_fails<ZX_INFO_TASK_USAGE, zx_info_task_usage_t, zx_thread_self>));
+
 RUN_TEST(process_maps_unstarted);
 RUN_TEST(process_maps_smoke);
 RUN_MULTI_ENTRY_TESTS(ZX_INFO_PROCESS_MAPS, zx_info_maps_t, get_test_process);
@@ -49,6 +49,41 @@ static bool basic_test(void) {
     END_TEST;
 }
 
+static bool wait_many_test(void) {
+    BEGIN_TEST;
+
+    zx_handle_t port;
+    ASSERT_EQ(zx_port_create(0, &port), ZX_OK);
+
+    zx_port_packet_t out[4] = {};
+    uint32_t actual = 0u;
+    EXPECT_EQ(zx_port_wait_many(port, 0, out, 0u, &actual), ZX_ERR_OUT_OF_RANGE);
+    EXPECT_EQ(zx_port_wait_many(port, zx_deadline_after(ZX_USEC(1)), out, 4u, &actual),
+              ZX_ERR_TIMED_OUT);
+
+    for (uint64_t key = 1u; key <= 6u; ++key) {
+        const zx_port_packet_t in = {key, ZX_PKT_TYPE_USER, 0, { {} }};
+        ASSERT_EQ(zx_port_queue(port, &in), ZX_OK);
+    }
+
+    // Packets come back in FIFO order, at most |count| at a time.
+    EXPECT_EQ(zx_port_wait_many(port, ZX_TIME_INFINITE, out, 4u, &actual), ZX_OK);
+    EXPECT_EQ(actual, 4u);
+    for (uint32_t i = 0u; i < 4u; ++i) {
+        EXPECT_EQ(out[i].key, i + 1u);
+        EXPECT_EQ(out[i].type, ZX_PKT_TYPE_USER);
+    }
+
+    EXPECT_EQ(zx_port_wait_many(port, ZX_TIME_INFINITE, out, 4u, &actual), ZX_OK);
+    EXPECT_EQ(actual, 2u);
+    EXPECT_EQ(out[0].key, 5u);
+    EXPECT_EQ(out[1].key, 6u);
+
+    EXPECT_EQ(zx_handle_close(port), ZX_OK);
+
+    END_TEST;
+}
+
 static bool queue_and_close_test(void) {
     BEGIN_TEST;
     zx_status_t status;
@@ -679,6 +714,7 @@ static bool cancel_stress() {
 
 BEGIN_TEST_CASE(port_tests)
 RUN_TEST(basic_test)
+RUN_TEST(wait_many_test)
 RUN_TEST(queue_and_close_test)
 RUN_TEST(queue_too_many)
 RUN_TEST(async_wait_channel_test)
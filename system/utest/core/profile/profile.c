@@ -2,6 +2,9 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <stdatomic.h>
+#include <threads.h>
+
 #include <unittest/unittest.h>
 #include <zircon/process.h>
 #include <zircon/syscalls.h>
@@ -27,6 +30,22 @@ static bool make_profile_fails(void) {
         profile_info.type = ZX_PROFILE_INFO_SCHEDULER;
         profile_info.scheduler.priority = ZX_PRIORITY_HIGHEST + 1;
         ASSERT_EQ(zx_profile_create(rrh, &profile_info, &profile), ZX_ERR_INVALID_ARGS, "");
+
+        profile_info.type = ZX_PROFILE_INFO_FAIR;
+        profile_info.fair.priority = ZX_PRIORITY_DEFAULT;
+        profile_info.fair.weight = 0;
+        ASSERT_EQ(zx_profile_create(rrh, &profile_info, &profile), ZX_ERR_INVALID_ARGS, "");
+
+        profile_info.fair.weight = ZX_PROFILE_FAIR_WEIGHT_MAX + 1;
+        ASSERT_EQ(zx_profile_create(rrh, &profile_info, &profile), ZX_ERR_INVALID_ARGS, "");
+
+        profile_info.fair.weight = ZX_PROFILE_FAIR_WEIGHT_DEFAULT;
+        profile_info.fair.deadline_us = ZX_PROFILE_FAIR_DEADLINE_MAX_US + 1;
+        ASSERT_EQ(zx_profile_create(rrh, &profile_info, &profile), ZX_ERR_INVALID_ARGS, "");
+
+        profile_info.fair.deadline_us = 0;
+        profile_info.fair.perf_hint = ZX_PROFILE_PERF_HINT_EFFICIENCY + 1;
+        ASSERT_EQ(zx_profile_create(rrh, &profile_info, &profile), ZX_ERR_INVALID_ARGS, "");
     }
 
     END_TEST;
@@ -61,7 +80,95 @@ static bool change_priority_via_profile(void) {
     END_TEST;
 }
 
+typedef struct {
+    zx_handle_t profile;
+    atomic_bool* stop;
+    atomic_uint_fast64_t count;
+} spinner_t;
+
+// applies the spinner's profile, if any, to itself and counts until told to stop
+static int spinner(void* arg) {
+    spinner_t* s = arg;
+    if (s->profile != ZX_HANDLE_INVALID &&
+        zx_object_set_profile(zx_thread_self(), s->profile, 0) != ZX_OK) {
+        return -1;
+    }
+    while (!atomic_load(s->stop)) {
+        atomic_fetch_add(&s->count, 1);
+    }
+    return 0;
+}
+
+static bool change_class_via_profile(void) {
+    BEGIN_TEST;
+
+    zx_handle_t rrh = get_root_resource();
+    if (rrh == ZX_HANDLE_INVALID) {
+        unittest_printf("no root resource. skipping test\n");
+    } else {
+        zx_profile_info_t profile_info = { 0 };
+        profile_info.type = ZX_PROFILE_INFO_FAIR;
+        profile_info.fair.priority = ZX_PRIORITY_DEFAULT;
+        profile_info.fair.weight = ZX_PROFILE_FAIR_WEIGHT_DEFAULT * 2;
+        profile_info.fair.deadline_us = 2000;
+        profile_info.fair.perf_hint = ZX_PROFILE_PERF_HINT_LATENCY;
+
+        zx_handle_t fair;
+        ASSERT_EQ(zx_profile_create(rrh, &profile_info, &fair), ZX_OK, "");
+
+        zx_profile_info_t priority_info = { 0 };
+        priority_info.type = ZX_PROFILE_INFO_SCHEDULER;
+        priority_info.scheduler.priority = ZX_PRIORITY_DEFAULT;
+
+        zx_handle_t priority;
+        ASSERT_EQ(zx_profile_create(rrh, &priority_info, &priority), ZX_OK, "");
+
+        ASSERT_EQ(zx_object_set_profile(zx_thread_self(), fair, 0), ZX_OK, "");
+        zx_nanosleep(ZX_USEC(100));
+        ASSERT_EQ(zx_object_set_profile(zx_thread_self(), priority, 0), ZX_OK, "");
+
+        // keep every cpu busy with a fair thread, then check that both the fair
+        // threads and a priority class thread at the same priority get to run
+        enum { kMaxSpinners = 64 };
+        uint32_t fair_count = zx_system_get_num_cpus();
+        if (fair_count > kMaxSpinners - 1) {
+            fair_count = kMaxSpinners - 1;
+        }
+
+        atomic_bool stop = ATOMIC_VAR_INIT(false);
+        spinner_t spinners[kMaxSpinners];
+        thrd_t threads[kMaxSpinners];
+        uint32_t count = fair_count + 1;
+        for (uint32_t i = 0; i < count; i++) {
+            spinners[i].profile = i < fair_count ? fair : priority;
+            spinners[i].stop = &stop;
+            atomic_init(&spinners[i].count, 0);
+            ASSERT_EQ(thrd_create(&threads[i], spinner, &spinners[i]), thrd_success, "");
+        }
+
+        // a thread that never runs hangs the test here
+        for (uint32_t i = 0; i < count; i++) {
+            while (atomic_load(&spinners[i].count) == 0) {
+                zx_nanosleep(zx_deadline_after(ZX_MSEC(1)));
+            }
+        }
+
+        atomic_store(&stop, true);
+        for (uint32_t i = 0; i < count; i++) {
+            int ret;
+            ASSERT_EQ(thrd_join(threads[i], &ret), thrd_success, "");
+            EXPECT_EQ(ret, 0, "could not apply the spinner's profile");
+        }
+
+        ASSERT_EQ(zx_handle_close(fair), ZX_OK, "");
+        ASSERT_EQ(zx_handle_close(priority), ZX_OK, "");
+    }
+
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(profile_tests)
 RUN_TEST(make_profile_fails)
 RUN_TEST(change_priority_via_profile)
+RUN_TEST(change_class_via_profile)
 END_TEST_CASE(profile_tests)
@@ -9,7 +9,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unittest/unittest.h>
+#include <string.h>
 #include <zircon/syscalls.h>
+#include <zircon/syscalls/kcounters.h>
 #include <zircon/syscalls/object.h>
 #include <zircon/syscalls/port.h>
 #include <zircon/syscalls/resource.h>
@@ -251,6 +253,70 @@ static bool TestVmoReplaceAsExecutable() {
     END_TEST;
 }
 
+// Sums counter |name| over all cpus in a mapped kcounters VMO, or returns -1.
+static int64_t sum_kcounter(uintptr_t base, const char* name) {
+    auto header = reinterpret_cast<const zx_kcounters_header_t*>(base);
+    auto descs = reinterpret_cast<const zx_kcounter_desc_t*>(base + header->descriptor_offset);
+    for (uint32_t i = 0; i < header->num_counters; i++) {
+        if (strcmp(descs[i].name, name) != 0)
+            continue;
+        int64_t sum = 0;
+        for (uint32_t cpu = 0; cpu < header->max_cpus; cpu++) {
+            auto values = reinterpret_cast<const volatile int64_t*>(
+                base + header->data_offset + cpu * header->cpu_stride);
+            sum += values[i];
+        }
+        return sum;
+    }
+    return -1;
+}
+
+static bool TestKcountersVmo(void) {
+    BEGIN_TEST;
+
+    zx::vmo vmo;
+    ASSERT_EQ(zx_kcounters_get_vmo(root()->get(), vmo.reset_and_get_address()), ZX_OK);
+
+    zx_rights_t rights = get_vmo_rights(vmo);
+    EXPECT_EQ(rights & (ZX_RIGHT_WRITE | ZX_RIGHT_EXECUTE), 0u);
+    EXPECT_EQ(rights & (ZX_RIGHT_READ | ZX_RIGHT_MAP), ZX_RIGHT_READ | ZX_RIGHT_MAP);
+
+    uint64_t size;
+    ASSERT_EQ(vmo.get_size(&size), ZX_OK);
+
+    // Writable mappings are refused.
+    uintptr_t addr;
+    EXPECT_EQ(zx_vmar_map(zx_vmar_root_self(), ZX_VM_PERM_READ | ZX_VM_PERM_WRITE, 0,
+                          vmo.get(), 0, size, &addr),
+              ZX_ERR_ACCESS_DENIED);
+
+    ASSERT_EQ(zx_vmar_map(zx_vmar_root_self(), ZX_VM_PERM_READ, 0, vmo.get(), 0, size, &addr),
+              ZX_OK);
+
+    auto header = reinterpret_cast<const zx_kcounters_header_t*>(addr);
+    EXPECT_EQ(header->magic, ZX_KCOUNTERS_MAGIC);
+    EXPECT_GT(header->num_counters, 0u);
+    EXPECT_GT(header->max_cpus, 0u);
+    EXPECT_EQ(header->cpu_stride % PAGE_SIZE, 0u);
+    EXPECT_LE(header->data_offset + header->max_cpus * header->cpu_stride, size);
+
+    // The values are live: making a handle bumps kernel.handles.new.
+    int64_t before = sum_kcounter(addr, "kernel.handles.new");
+    ASSERT_GE(before, 0);
+    zx_handle_t event;
+    ASSERT_EQ(zx_event_create(0u, &event), ZX_OK);
+    EXPECT_GT(sum_kcounter(addr, "kernel.handles.new"), before);
+    EXPECT_EQ(zx_handle_close(event), ZX_OK);
+
+    EXPECT_EQ(zx_vmar_unmap(zx_vmar_root_self(), addr, size), ZX_OK);
+
+    // Only the root resource can get at the counters.
+    zx::vmo other;
+    EXPECT_EQ(zx_kcounters_get_vmo(vmo.get(), other.reset_and_get_address()), ZX_ERR_WRONG_TYPE);
+
+    END_TEST;
+}
+
 #if defined(__x86_64__)
 static bool test_ioports(void) {
     BEGIN_TEST;
@@ -279,6 +345,7 @@ RUN_TEST(TestVmoCreation);
 RUN_TEST(TestVmoCreationSmaller);
 RUN_TEST(TestVmoCreationUnaligned);
 RUN_TEST(TestVmoReplaceAsExecutable);
+RUN_TEST(TestKcountersVmo);
 #if defined(__x86_64__)
 RUN_TEST(test_ioports);
 #endif
@@ -5,9 +5,11 @@
 #include <assert.h>
 #include <zircon/syscalls.h>
 #include <unittest/unittest.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 static zx_signals_t get_satisfied_signals(zx_handle_t handle) {
@@ -1153,6 +1155,161 @@ bool socket_share_consumes_on_failure(void) {
     END_TEST;
 }
 
+// Pages moved by ZX_SOCKET_WRITE_MOVE_PAGES arrive intact and leave the
+// writer's range zero filled.
+static bool socket_write_move_pages(void) {
+    BEGIN_TEST;
+
+    const size_t kSize = 4 * PAGE_SIZE;
+    zx_handle_t socket[2];
+    ASSERT_EQ(zx_socket_create(0, &socket[0], &socket[1]), ZX_OK, "");
+
+    zx_handle_t vmo;
+    ASSERT_EQ(zx_vmo_create(2 * kSize, 0, &vmo), ZX_OK, "");
+    uintptr_t addr = 0;
+    ASSERT_EQ(zx_vmar_map(zx_vmar_root_self(), ZX_VM_PERM_READ | ZX_VM_PERM_WRITE,
+                          0u, vmo, 0, 2 * kSize, &addr), ZX_OK, "");
+    uint8_t* send = (uint8_t*)addr;
+    uint8_t* recv = send + kSize;
+
+    for (size_t i = 0; i < kSize; ++i) {
+        send[i] = (uint8_t)(i * 7);
+    }
+    size_t count = 0;
+    EXPECT_EQ(zx_socket_write(socket[0], ZX_SOCKET_WRITE_MOVE_PAGES, send, kSize, &count),
+              ZX_OK, "");
+    EXPECT_EQ(count, kSize, "");
+    for (size_t i = 0; i < kSize; ++i) {
+        ASSERT_EQ(send[i], 0u, "moved range should read as zero");
+    }
+
+    EXPECT_EQ(zx_socket_read(socket[1], 0u, recv, kSize, &count), ZX_OK, "");
+    EXPECT_EQ(count, kSize, "");
+    for (size_t i = 0; i < kSize; ++i) {
+        ASSERT_EQ(recv[i], (uint8_t)(i * 7), "");
+    }
+
+    // Unaligned writes fall back to copying.
+    EXPECT_EQ(zx_socket_write(socket[0], ZX_SOCKET_WRITE_MOVE_PAGES, recv + 1, 16u, &count),
+              ZX_OK, "");
+    EXPECT_EQ(recv[1], (uint8_t)7, "");
+
+    zx_vmar_unmap(zx_vmar_root_self(), addr, 2 * kSize);
+    zx_handle_close(vmo);
+    zx_handle_close(socket[0]);
+    zx_handle_close(socket[1]);
+
+    END_TEST;
+}
+
+static bool socket_writev_readv(void) {
+    BEGIN_TEST;
+
+    zx_handle_t h[2];
+    ASSERT_EQ(zx_socket_create(0, &h[0], &h[1]), ZX_OK, "");
+
+    char header[] = "header:";
+    char empty[1];
+    char body[] = "body";
+    zx_iovec_t out[3] = {
+        {header, sizeof(header) - 1},
+        {empty, 0u},
+        {body, sizeof(body) - 1},
+    };
+    size_t count = 0;
+    EXPECT_EQ(zx_socket_writev(h[0], 0u, out, 3u, &count), ZX_OK, "");
+    EXPECT_EQ(count, 11u, "");
+
+    char first[4];
+    char rest[16];
+    zx_iovec_t in[2] = {
+        {first, sizeof(first)},
+        {rest, sizeof(rest)},
+    };
+    EXPECT_EQ(zx_socket_readv(h[1], 0u, in, 2u, &count), ZX_OK, "");
+    EXPECT_EQ(count, 11u, "");
+    EXPECT_EQ(memcmp(first, "head", 4), 0, "");
+    EXPECT_EQ(memcmp(rest, "er:body", 7), 0, "");
+
+    EXPECT_EQ(zx_socket_readv(h[1], 0u, in, 2u, &count), ZX_ERR_SHOULD_WAIT, "");
+    EXPECT_EQ(zx_socket_writev(h[0], 1u, out, 3u, &count), ZX_ERR_INVALID_ARGS, "");
+    EXPECT_EQ(zx_socket_writev(h[0], 0u, out, ZX_SOCKET_MAX_IOVECS + 1, &count),
+              ZX_ERR_OUT_OF_RANGE, "");
+
+    zx_handle_close(h[0]);
+    zx_handle_close(h[1]);
+
+    ASSERT_EQ(zx_socket_create(ZX_SOCKET_DATAGRAM, &h[0], &h[1]), ZX_OK, "");
+    EXPECT_EQ(zx_socket_writev(h[0], 0u, out, 3u, &count), ZX_ERR_NOT_SUPPORTED, "");
+    zx_handle_close(h[0]);
+    zx_handle_close(h[1]);
+
+    END_TEST;
+}
+
+static bool socket_datagram_batch(void) {
+    BEGIN_TEST;
+
+    zx_handle_t h[2];
+    ASSERT_EQ(zx_socket_create(ZX_SOCKET_DATAGRAM, &h[0], &h[1]), ZX_OK, "");
+
+    char one[] = "one";
+    char three[] = "three";
+    char two[] = "two";
+    zx_iovec_t out[3] = {
+        {one, sizeof(one) - 1},
+        {three, sizeof(three) - 1},
+        {two, sizeof(two) - 1},
+    };
+    size_t count = 0;
+    EXPECT_EQ(zx_socket_writev(h[0], ZX_SOCKET_DATAGRAM_BATCH, out, 3u, &count), ZX_OK, "");
+    EXPECT_EQ(count, 3u, "");
+
+    // The second vector is too small for "three", which is truncated.
+    char first[sizeof(zx_socket_datagram_header_t) + 8];
+    char second[sizeof(zx_socket_datagram_header_t) + 2];
+    zx_iovec_t in[2] = {
+        {first, sizeof(first)},
+        {second, sizeof(second)},
+    };
+    EXPECT_EQ(zx_socket_readv(h[1], ZX_SOCKET_DATAGRAM_BATCH, in, 2u, &count), ZX_OK, "");
+    EXPECT_EQ(count, 2u, "");
+    zx_socket_datagram_header_t header;
+    memcpy(&header, first, sizeof(header));
+    EXPECT_EQ(header.length, 3u, "");
+    EXPECT_EQ(memcmp(first + sizeof(header), "one", 3), 0, "");
+    memcpy(&header, second, sizeof(header));
+    EXPECT_EQ(header.length, 5u, "");
+    EXPECT_EQ(memcmp(second + sizeof(header), "th", 2), 0, "");
+
+    // "two" is still queued as an ordinary datagram.
+    char rbuf[8];
+    EXPECT_EQ(zx_socket_read(h[1], 0u, rbuf, sizeof(rbuf), &count), ZX_OK, "");
+    EXPECT_EQ(count, 3u, "");
+    EXPECT_EQ(memcmp(rbuf, "two", 3), 0, "");
+
+    EXPECT_EQ(zx_socket_readv(h[1], ZX_SOCKET_DATAGRAM_BATCH, in, 2u, &count),
+              ZX_ERR_SHOULD_WAIT, "");
+    in[0].capacity = sizeof(zx_socket_datagram_header_t);
+    EXPECT_EQ(zx_socket_readv(h[1], ZX_SOCKET_DATAGRAM_BATCH, in, 2u, &count),
+              ZX_ERR_INVALID_ARGS, "");
+    out[1].capacity = 0u;
+    EXPECT_EQ(zx_socket_writev(h[0], ZX_SOCKET_DATAGRAM_BATCH, out, 3u, &count),
+              ZX_ERR_INVALID_ARGS, "");
+
+    zx_handle_close(h[0]);
+    zx_handle_close(h[1]);
+
+    ASSERT_EQ(zx_socket_create(0, &h[0], &h[1]), ZX_OK, "");
+    out[1].capacity = sizeof(three) - 1;
+    EXPECT_EQ(zx_socket_writev(h[0], ZX_SOCKET_DATAGRAM_BATCH, out, 3u, &count),
+              ZX_ERR_NOT_SUPPORTED, "");
+    zx_handle_close(h[0]);
+    zx_handle_close(h[1]);
+
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(socket_tests)
 RUN_TEST(socket_basic)
 RUN_TEST(socket_signals)
@@ -1173,6 +1330,9 @@ RUN_TEST(socket_accept)
 RUN_TEST(socket_share_invalid_handle)
 RUN_TEST(socket_share_consumes_on_failure)
 RUN_TEST(socket_signals2)
+RUN_TEST(socket_write_move_pages)
+RUN_TEST(socket_writev_readv)
+RUN_TEST(socket_datagram_batch)
 END_TEST_CASE(socket_tests)
 
 #ifndef BUILD_COMBINED_TESTS
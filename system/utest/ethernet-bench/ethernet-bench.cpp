@@ -0,0 +1,296 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <fbl/algorithm.h>
+#include <fbl/string_printf.h>
+#include <fbl/unique_fd.h>
+#include <lib/fdio/util.h>
+#include <lib/fdio/watcher.h>
+#include <lib/fzl/fifo.h>
+#include <lib/zx/channel.h>
+#include <lib/zx/socket.h>
+#include <lib/zx/time.h>
+#include <lib/zx/vmar.h>
+#include <lib/zx/vmo.h>
+#include <perftest/perftest.h>
+#include <zircon/assert.h>
+#include <zircon/device/ethertap.h>
+#include <zircon/ethernet/c/fidl.h>
+
+// These tests measure the cost of moving frames between an ethernet client and an ethertap
+// device through the ethernet core driver, in both directions.  The ethertap socket stands in
+// for the wire, so each test run covers the client fifo, ethernet.c and the ethermac protocol.
+//
+// The per-run times give the latency distribution of a single frame or burst; the bytes
+// processed per run give throughput, from which packets per second follow.
+
+namespace {
+
+constexpr char kEthernetDir[] = "/dev/class/ethernet";
+constexpr char kTapctl[] = "/dev/misc/tapctl";
+constexpr uint8_t kTapMac[] = {0x12, 0x20, 0x30, 0x40, 0x50, 0x61};
+constexpr uint32_t kMtu = 1500;
+
+// Number of buffers given to each of the rx and tx paths, and their size.
+constexpr uint32_t kBufferCount = 64;
+constexpr uint32_t kBufferSize = 2048;
+
+constexpr size_t kTapHeaderSize = sizeof(ethertap_socket_header_t);
+constexpr size_t kTapReadSize = ETHERTAP_MAX_MTU + kTapHeaderSize;
+
+// Time allowed for the ethertap link status to reach the ethernet driver.
+constexpr zx::duration kPropagateDuration = zx::msec(200);
+
+zx_status_t WatchCb(int dirfd, int event, const char* fn, void* cookie) {
+    if (event != WATCH_EVENT_ADD_FILE) {
+        return ZX_OK;
+    }
+    if (!strcmp(fn, ".") || !strcmp(fn, "..")) {
+        return ZX_OK;
+    }
+
+    zx::channel svc;
+    {
+        int devfd = openat(dirfd, fn, O_RDONLY);
+        if (devfd < 0) {
+            return ZX_OK;
+        }
+        if (fdio_get_service_handle(devfd, svc.reset_and_get_address()) != ZX_OK) {
+            return ZX_OK;
+        }
+    }
+
+    zircon_ethernet_Info info;
+    if (zircon_ethernet_DeviceGetInfo(svc.get(), &info) != ZX_OK) {
+        return ZX_OK;
+    }
+    if (!(info.features & zircon_ethernet_INFO_FEATURE_SYNTH) ||
+        memcmp(info.mac.octets, kTapMac, sizeof(kTapMac))) {
+        return ZX_OK;
+    }
+
+    *static_cast<zx::channel*>(cookie) = fbl::move(svc);
+    return ZX_ERR_STOP;
+}
+
+// An ethertap device with one started ethernet client bound to it.
+//
+// The first kBufferCount buffers of the client's io buffer are posted to the
+// rx fifo; the next kBufferCount are used for transmit.
+class TapClient {
+public:
+    TapClient() {
+        fbl::unique_fd ctlfd(open(kTapctl, O_RDONLY));
+        ZX_ASSERT(ctlfd.is_valid());
+
+        ethertap_ioctl_config_t config = {};
+        strlcpy(config.name, "ethernet-bench", ETHERTAP_MAX_NAME_LEN);
+        config.mtu = kMtu;
+        memcpy(config.mac, kTapMac, sizeof(kTapMac));
+        ZX_ASSERT(ioctl_ethertap_config(ctlfd.get(), &config, tap_.reset_and_get_address()) >= 0);
+        ZX_ASSERT(tap_.signal_peer(0, ETHERTAP_SIGNAL_ONLINE) == ZX_OK);
+        zx::nanosleep(zx::deadline_after(kPropagateDuration));
+
+        fbl::unique_fd ethdir(open(kEthernetDir, O_RDONLY));
+        ZX_ASSERT(ethdir.is_valid());
+        ZX_ASSERT(fdio_watch_directory(ethdir.get(), WatchCb, zx_deadline_after(ZX_SEC(5)),
+                                       &svc_) == ZX_ERR_STOP);
+
+        zircon_ethernet_Fifos fifos;
+        zx_status_t call_status;
+        ZX_ASSERT(zircon_ethernet_DeviceGetFifos(svc_.get(), &call_status, &fifos) == ZX_OK);
+        ZX_ASSERT(call_status == ZX_OK);
+        tx_.reset(fifos.tx);
+        rx_.reset(fifos.rx);
+        ZX_ASSERT(fifos.rx_depth >= kBufferCount && fifos.tx_depth >= kBufferCount);
+
+        size_t vmo_size = 2 * kBufferCount * kBufferSize;
+        zx::vmo vmo;
+        ZX_ASSERT(zx::vmo::create(vmo_size, ZX_VMO_NON_RESIZABLE, &vmo) == ZX_OK);
+        ZX_ASSERT(zx::vmar::root_self()->map(0, vmo, 0, vmo_size,
+                                             ZX_VM_PERM_READ | ZX_VM_PERM_WRITE,
+                                             &mapped_) == ZX_OK);
+        zx::vmo vmo_copy;
+        ZX_ASSERT(vmo.duplicate(ZX_RIGHT_SAME_RIGHTS, &vmo_copy) == ZX_OK);
+        ZX_ASSERT(zircon_ethernet_DeviceSetIOBuffer(svc_.get(), vmo_copy.release(),
+                                                    &call_status) == ZX_OK);
+        ZX_ASSERT(call_status == ZX_OK);
+
+        zircon_ethernet_FifoEntry entries[kBufferCount];
+        for (uint32_t i = 0; i < kBufferCount; i++) {
+            entries[i] = {i * kBufferSize, static_cast<uint16_t>(kBufferSize), 0, 0};
+        }
+        size_t actual;
+        ZX_ASSERT(rx_.write(entries, kBufferCount, &actual) == ZX_OK);
+        ZX_ASSERT(actual == kBufferCount);
+
+        ZX_ASSERT(zircon_ethernet_DeviceStart(svc_.get(), &call_status) == ZX_OK);
+        ZX_ASSERT(call_status == ZX_OK);
+
+        // Fill the transmit buffers once; the tests only care about moving them.
+        memset(reinterpret_cast<void*>(mapped_ + kBufferCount * kBufferSize), 0xa5,
+               kBufferCount * kBufferSize);
+    }
+
+    ~TapClient() {
+        zircon_ethernet_DeviceStop(svc_.get());
+        svc_.reset();
+        tap_.reset();
+        zx::vmar::root_self()->unmap(mapped_, 2 * kBufferCount * kBufferSize);
+        // Give devmgr time to tear the ethertap device down before the
+        // next test creates another one.
+        zx::nanosleep(zx::deadline_after(kPropagateDuration));
+    }
+
+    // Queues |count| frames of |size| bytes for transmit with a single fifo write.
+    void QueueTx(size_t size, uint32_t count) {
+        ZX_ASSERT(count <= kBufferCount);
+        zircon_ethernet_FifoEntry entries[kBufferCount];
+        for (uint32_t i = 0; i < count; i++) {
+            entries[i] = {(kBufferCount + i) * kBufferSize, static_cast<uint16_t>(size), 0, i};
+        }
+        size_t actual;
+        ZX_ASSERT(tx_.write(entries, count, &actual) == ZX_OK);
+        ZX_ASSERT(actual == count);
+    }
+
+    // Reads |count| frames of |size| bytes off the wire.
+    void ReceiveOnTap(size_t size, uint32_t count) {
+        for (uint32_t i = 0; i < count; i++) {
+            for (;;) {
+                size_t actual;
+                zx_status_t status = tap_.read(0u, tap_buf_, sizeof(tap_buf_), &actual);
+                if (status == ZX_ERR_SHOULD_WAIT) {
+                    ZX_ASSERT(tap_.wait_one(ZX_SOCKET_READABLE, zx::time::infinite(),
+                                            nullptr) == ZX_OK);
+                    continue;
+                }
+                ZX_ASSERT(status == ZX_OK);
+                auto header = reinterpret_cast<ethertap_socket_header_t*>(tap_buf_);
+                // Skip anything that is not a frame, such as parameter reports.
+                if (header->type != ETHERTAP_MSG_PACKET) {
+                    continue;
+                }
+                ZX_ASSERT(actual == kTapHeaderSize + size);
+                break;
+            }
+        }
+    }
+
+    // Waits for |count| transmit completions.
+    void CompleteTx(uint32_t count) {
+        DrainFifo(&tx_, count, nullptr);
+    }
+
+    // Puts |count| frames of |size| bytes on the wire.
+    void SendOnTap(size_t size, uint32_t count) {
+        for (uint32_t i = 0; i < count; i++) {
+            size_t actual;
+            zx_status_t status;
+            while ((status = tap_.write(0u, tap_buf_, size, &actual)) == ZX_ERR_SHOULD_WAIT) {
+                ZX_ASSERT(tap_.wait_one(ZX_SOCKET_WRITABLE, zx::time::infinite(),
+                                        nullptr) == ZX_OK);
+            }
+            ZX_ASSERT(status == ZX_OK);
+        }
+    }
+
+    // Waits for |count| received frames and posts their buffers back to the driver.
+    void CompleteRx(size_t size, uint32_t count) {
+        zircon_ethernet_FifoEntry entries[kBufferCount];
+        DrainFifo(&rx_, count, entries);
+        for (uint32_t i = 0; i < count; i++) {
+            ZX_ASSERT(entries[i].length == size);
+            entries[i].length = kBufferSize;
+        }
+        size_t actual;
+        ZX_ASSERT(rx_.write(entries, count, &actual) == ZX_OK);
+        ZX_ASSERT(actual == count);
+    }
+
+private:
+    // Reads |count| entries from |fifo|, blocking as needed, into |out| if it is non-null.
+    void DrainFifo(fzl::fifo<zircon_ethernet_FifoEntry>* fifo, uint32_t count,
+                   zircon_ethernet_FifoEntry* out) {
+        ZX_ASSERT(count <= kBufferCount);
+        zircon_ethernet_FifoEntry scratch[kBufferCount];
+        zircon_ethernet_FifoEntry* entries = out ? out : scratch;
+        uint32_t done = 0;
+        while (done < count) {
+            size_t actual;
+            zx_status_t status = fifo->read(entries + done, count - done, &actual);
+            if (status == ZX_ERR_SHOULD_WAIT) {
+                ZX_ASSERT(fifo->wait_one(ZX_FIFO_READABLE, zx::time::infinite(),
+                                         nullptr) == ZX_OK);
+                continue;
+            }
+            ZX_ASSERT(status == ZX_OK);
+            done += static_cast<uint32_t>(actual);
+        }
+    }
+
+    zx::socket tap_;
+    zx::channel svc_;
+    fzl::fifo<zircon_ethernet_FifoEntry> tx_;
+    fzl::fifo<zircon_ethernet_FifoEntry> rx_;
+    uintptr_t mapped_ = 0;
+    uint8_t tap_buf_[kTapReadSize] = {};
+};
+
+// Measure the time taken to transmit a burst of |count| frames of |size|
+// bytes: from the client's tx fifo write until the frames appear on the
+// ethertap socket, and then until the client sees the completions.
+bool TxTest(perftest::RepeatState* state, size_t size, uint32_t count) {
+    state->DeclareStep("send");
+    state->DeclareStep("complete");
+    state->SetBytesProcessedPerRun(size * count);
+
+    TapClient client;
+    while (state->KeepRunning()) {
+        client.QueueTx(size, count);
+        client.ReceiveOnTap(size, count);
+        state->NextStep();
+        client.CompleteTx(count);
+    }
+    return true;
+}
+
+// Measure the time taken to receive a burst of |count| frames of |size|
+// bytes: from the ethertap socket write until the client reads them from its
+// rx fifo and posts the buffers back.
+bool RxTest(perftest::RepeatState* state, size_t size, uint32_t count) {
+    state->SetBytesProcessedPerRun(size * count);
+
+    TapClient client;
+    while (state->KeepRunning()) {
+        client.SendOnTap(size, count);
+        client.CompleteRx(size, count);
+    }
+    return true;
+}
+
+void RegisterTests() {
+    static const size_t kFrameSizes[] = {60, kMtu};
+    static const uint32_t kBurstSizes[] = {1, 16, kBufferCount};
+    for (size_t size : kFrameSizes) {
+        for (uint32_t count : kBurstSizes) {
+            auto tx_name = fbl::StringPrintf("Ethernet/Tx/%zubytes/%uframes", size, count);
+            perftest::RegisterTest(tx_name.c_str(), TxTest, size, count);
+            auto rx_name = fbl::StringPrintf("Ethernet/Rx/%zubytes/%uframes", size, count);
+            perftest::RegisterTest(rx_name.c_str(), RxTest, size, count);
+        }
+    }
+}
+PERFTEST_CTOR(RegisterTests);
+
+} // namespace
+
+int main(int argc, char** argv) {
+    return perftest::PerfTestMain(argc, argv, "fuchsia.zircon.ethernet_bench");
+}
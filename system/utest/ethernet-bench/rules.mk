@@ -0,0 +1,39 @@
+# Copyright 2018 The Fuchsia Authors. All rights reserved.
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+
+LOCAL_DIR := $(GET_LOCAL_DIR)
+
+MODULE := $(LOCAL_DIR)
+
+MODULE_TYPE := usertest
+
+MODULE_NAME := ethernet-bench-test
+
+MODULE_SRCS := \
+    $(LOCAL_DIR)/ethernet-bench.cpp \
+
+MODULE_STATIC_LIBS := \
+    system/ulib/async \
+    system/ulib/async.cpp \
+    system/ulib/async-loop \
+    system/ulib/async-loop.cpp \
+    system/ulib/fbl \
+    system/ulib/fzl \
+    system/ulib/perftest \
+    system/ulib/trace \
+    system/ulib/trace-provider \
+    system/ulib/zx \
+    system/ulib/zxcpp \
+
+MODULE_LIBS := \
+    system/ulib/async.default \
+    system/ulib/c \
+    system/ulib/fdio \
+    system/ulib/trace-engine \
+    system/ulib/unittest \
+    system/ulib/zircon \
+
+MODULE_FIDL_LIBS := system/fidl/zircon-ethernet
+
+include make/module.mk
@@ -279,6 +279,20 @@ public:
         return zircon_ethernet_DeviceGetStatus(svc_.get(), eth_status);
     }
 
+    zx_status_t GetQueueCount(uint32_t* count) {
+        return zircon_ethernet_DeviceGetQueueCount(svc_.get(), count);
+    }
+
+    zx_status_t GetQueueFifos(uint32_t queue, zircon_ethernet_Fifos* fifos) {
+        zx_status_t call_status = ZX_OK;
+        zx_status_t status = zircon_ethernet_DeviceGetQueueFifos(svc_.get(), queue, &call_status,
+                                                                 fifos);
+        if (status != ZX_OK) {
+            return status;
+        }
+        return call_status;
+    }
+
     zx_status_t SetPromisc(bool on) {
         zx_status_t call_status = ZX_OK;
         zx_status_t status = zircon_ethernet_DeviceSetPromiscuousMode(svc_.get(), on, &call_status);
@@ -541,6 +555,27 @@ static bool EthernetStartTest() {
     END_TEST;
 }
 
+static bool EthernetQueuesTest() {
+    BEGIN_TEST;
+
+    zx::socket sock;
+    EthernetClient client;
+    EthernetOpenInfo info(__func__);
+    ASSERT_TRUE(OpenFirstClientHelper(&sock, &client, info));
+
+    // Ethertap devices have a single queue, whose fifos Register() obtained
+    uint32_t count = 0;
+    EXPECT_EQ(ZX_OK, client.GetQueueCount(&count));
+    EXPECT_EQ(1u, count);
+
+    zircon_ethernet_Fifos fifos;
+    EXPECT_EQ(ZX_ERR_ALREADY_BOUND, client.GetQueueFifos(0, &fifos));
+    EXPECT_EQ(ZX_ERR_OUT_OF_RANGE, client.GetQueueFifos(1, &fifos));
+
+    ASSERT_TRUE(EthernetCleanupHelper(&sock, &client));
+    END_TEST;
+}
+
 static bool EthernetLinkStatusTest() {
     BEGIN_TEST;
     // Create the ethertap device
@@ -847,6 +882,37 @@ static bool EthernetDataTest_Send() {
     END_TEST;
 }
 
+static bool EthernetDataTest_SendUnsupportedOffload() {
+    BEGIN_TEST;
+    zx::socket sock;
+    EthernetClient client;
+    EthernetOpenInfo info(__func__);
+    ASSERT_TRUE(OpenFirstClientHelper(&sock, &client, info));
+
+    // Ethertap computes no checksums, so a packet asking for it is refused
+    auto entry = client.GetTxBuffer();
+    ASSERT_TRUE(entry != nullptr);
+    uint8_t* buf = reinterpret_cast<uint8_t*>(entry->cookie);
+    memset(buf, 0, 64);
+    entry->length = 64;
+    entry->flags = zircon_ethernet_FIFO_TX_CSUM;
+    ASSERT_EQ(ZX_OK, client.tx_fifo()->write_one(*entry));
+    entry->flags = 0;
+
+    zx_signals_t obs;
+    EXPECT_EQ(ZX_OK, client.tx_fifo()->wait_one(ZX_FIFO_READABLE, FAIL_TIMEOUT, &obs));
+    ASSERT_TRUE(obs & ZX_FIFO_READABLE);
+
+    zircon_ethernet_FifoEntry return_entry;
+    ASSERT_EQ(ZX_OK, client.tx_fifo()->read_one(&return_entry));
+    EXPECT_EQ(zircon_ethernet_FIFO_INVALID, return_entry.flags);
+    EXPECT_EQ(entry->cookie, return_entry.cookie);
+    client.ReturnTxBuffer(&return_entry);
+
+    ASSERT_TRUE(EthernetCleanupHelper(&sock, &client));
+    END_TEST;
+}
+
 static bool EthernetDataTest_Recv() {
     BEGIN_TEST;
     zx::socket sock;
@@ -894,6 +960,7 @@ static bool EthernetDataTest_Recv() {
 BEGIN_TEST_CASE(EthernetSetupTests)
 RUN_TEST_MEDIUM(EthernetStartTest)
 RUN_TEST_MEDIUM(EthernetLinkStatusTest)
+RUN_TEST_MEDIUM(EthernetQueuesTest)
 END_TEST_CASE(EthernetSetupTests)
 
 BEGIN_TEST_CASE(EthernetConfigTests)
@@ -909,6 +976,7 @@ END_TEST_CASE(EthernetConfigTests)
 
 BEGIN_TEST_CASE(EthernetDataTests)
 RUN_TEST_MEDIUM(EthernetDataTest_Send)
+RUN_TEST_MEDIUM(EthernetDataTest_SendUnsupportedOffload)
 RUN_TEST_MEDIUM(EthernetDataTest_Recv)
 END_TEST_CASE(EthernetDataTests)
 
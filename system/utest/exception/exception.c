@@ -18,6 +18,7 @@
 #include <zircon/compiler.h>
 #include <zircon/process.h>
 #include <zircon/processargs.h>
+#include <zircon/stack.h>
 #include <zircon/syscalls.h>
 #include <zircon/syscalls/debug.h>
 #include <zircon/syscalls/exception.h>
@@ -1882,6 +1883,93 @@ static bool full_queue_sending_exception_packet_test(void)
     END_TEST;
 }
 
+// State for the in-thread handler tests. The faulting thread is a bare
+// thread, without any libc state, so it only makes system calls.
+static char in_thread_stack[8192] __ALIGNED(16);
+static char in_thread_handler_stack[8192] __ALIGNED(16);
+static zx_exception_frame_t in_thread_frame;
+static zx_status_t in_thread_set_status;
+
+// Records the exception and ends the thread; resuming would need the
+// registers restored in assembly.
+static void in_thread_handler(zx_exception_frame_t* frame)
+{
+    in_thread_frame = *frame;
+    zx_thread_exit();
+}
+
+static void in_thread_fault_func(uintptr_t thread, uintptr_t unused)
+{
+    zx_thread_exception_handler_t handler = {
+        .pc = (zx_vaddr_t)&in_thread_handler,
+        .stack_base = (zx_vaddr_t)in_thread_handler_stack,
+        .stack_size = sizeof(in_thread_handler_stack),
+        .types = ZX_EXCEPTION_HANDLER_TYPE(ZX_EXCP_FATAL_PAGE_FAULT),
+    };
+    in_thread_set_status = zx_object_set_property((zx_handle_t)thread, ZX_PROP_EXCEPTION_HANDLER,
+                                                  &handler, sizeof(handler));
+    volatile int* p = 0;
+    *p = 42;
+    zx_thread_exit();
+}
+
+static bool in_thread_handler_test(void)
+{
+    BEGIN_TEST;
+
+    zx_handle_t thread;
+    static const char name[] = "in-thread-handler";
+    ASSERT_EQ(zx_thread_create(zx_process_self(), name, sizeof(name) - 1, 0, &thread), ZX_OK);
+    uintptr_t sp = compute_initial_stack_pointer((uintptr_t)in_thread_stack,
+                                                 sizeof(in_thread_stack));
+    ASSERT_EQ(zx_thread_start(thread, (uintptr_t)&in_thread_fault_func, sp, thread, 0), ZX_OK);
+    ASSERT_EQ(zx_object_wait_one(thread, ZX_THREAD_TERMINATED, ZX_TIME_INFINITE, NULL), ZX_OK);
+
+    EXPECT_EQ(in_thread_set_status, ZX_OK);
+    EXPECT_EQ(in_thread_frame.report.header.type, ZX_EXCP_FATAL_PAGE_FAULT);
+#if defined(__x86_64__)
+    EXPECT_EQ(in_thread_frame.report.context.arch.u.x86_64.cr2, 0u);
+#elif defined(__aarch64__)
+    EXPECT_EQ(in_thread_frame.report.context.arch.u.arm_64.far, 0u);
+#endif
+
+    zx_handle_close(thread);
+    END_TEST;
+}
+
+static bool in_thread_handler_args_test(void)
+{
+    BEGIN_TEST;
+
+    zx_thread_exception_handler_t handler = {
+        .pc = (zx_vaddr_t)&in_thread_handler,
+        .stack_base = (zx_vaddr_t)in_thread_handler_stack,
+        .stack_size = sizeof(in_thread_handler_stack),
+        .types = ZX_EXCEPTION_HANDLER_TYPE(ZX_EXCP_SW_BREAKPOINT),
+    };
+    EXPECT_EQ(zx_object_set_property(zx_thread_self(), ZX_PROP_EXCEPTION_HANDLER,
+                                     &handler, sizeof(handler)),
+              ZX_ERR_INVALID_ARGS);
+
+    handler.types = ZX_EXCEPTION_HANDLER_TYPE(ZX_EXCP_GENERAL);
+    handler.stack_size = 16;
+    EXPECT_EQ(zx_object_set_property(zx_thread_self(), ZX_PROP_EXCEPTION_HANDLER,
+                                     &handler, sizeof(handler)),
+              ZX_ERR_INVALID_ARGS);
+
+    // Only the thread itself can set its handler.
+    zx_handle_t thread;
+    static const char name[] = "not-current";
+    ASSERT_EQ(zx_thread_create(zx_process_self(), name, sizeof(name) - 1, 0, &thread), ZX_OK);
+    handler.stack_size = sizeof(in_thread_handler_stack);
+    EXPECT_EQ(zx_object_set_property(thread, ZX_PROP_EXCEPTION_HANDLER,
+                                     &handler, sizeof(handler)),
+              ZX_ERR_ACCESS_DENIED);
+    zx_handle_close(thread);
+
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(exceptions_tests)
 RUN_TEST(job_set_close_set_test);
 RUN_TEST(process_set_close_set_test);
@@ -1918,6 +2006,8 @@ RUN_TEST_ENABLE_CRASH_HANDLER(self_death_test);
 RUN_TEST_ENABLE_CRASH_HANDLER(multiple_threads_registered_death_test);
 RUN_TEST(exit_closing_excp_handle_test);
 RUN_TEST(full_queue_sending_exception_packet_test);
+RUN_TEST(in_thread_handler_test);
+RUN_TEST(in_thread_handler_args_test);
 END_TEST_CASE(exceptions_tests)
 
 static void scan_argv(int argc, char** argv)
@@ -140,6 +140,10 @@ public:
     static void RecordEraseRotation()           { ++op_counts_.erase_rotations_; }
     static void RecordEraseDoubleRotation()     { ++op_counts_.erase_double_rotations_; }
 
+    static constexpr bool kRecordsSubtreeChanges = false;
+    template <typename Iter>
+    static void RecordSubtreeChange(Iter node) { }
+
     template <typename TreeType>
     static bool VerifyRankRule(const TreeType& tree, typename TreeType::RawPtrType node) {
         BEGIN_TEST;
@@ -420,6 +424,136 @@ static bool WAVLBalanceTest() {
     END_TEST;
 }
 
+// SubtreeSumTestObserver
+//
+// An Observer which keeps the sum of the weights of each subtree in the
+// subtree's root, used to check that the tree reports every node whose
+// subtree changes.
+class SubtreeSumTestObj;
+
+struct SubtreeSumTestObserver : public DefaultWAVLTreeObserver {
+    static constexpr bool kRecordsSubtreeChanges = true;
+    template <typename Iter>
+    static void RecordSubtreeChange(Iter node);
+};
+
+using SubtreeSumTestObjPtr = unique_ptr<SubtreeSumTestObj>;
+using SubtreeSumTestTree   = WAVLTree<uint64_t,
+                                      SubtreeSumTestObjPtr,
+                                      DefaultKeyedObjectTraits<uint64_t, SubtreeSumTestObj>,
+                                      DefaultWAVLTreeTraits<SubtreeSumTestObjPtr>,
+                                      SubtreeSumTestObserver>;
+
+class SubtreeSumTestObj : public WAVLTreeContainable<SubtreeSumTestObjPtr> {
+public:
+    uint64_t GetKey() const { return key_; }
+
+    uint64_t key_ = 0;
+    uint64_t weight_ = 0;
+    uint64_t subtree_sum_ = 0;
+
+private:
+    static void operator delete(void* ptr) {
+        // Deliberate no-op
+    }
+    friend class fbl::unique_ptr<SubtreeSumTestObj[]>;
+    friend class fbl::unique_ptr<SubtreeSumTestObj>;
+};
+
+template <typename Iter>
+void SubtreeSumTestObserver::RecordSubtreeChange(Iter node) {
+    uint64_t sum = node->weight_;
+    if (node.left().IsValid())
+        sum += node.left()->subtree_sum_;
+    if (node.right().IsValid())
+        sum += node.right()->subtree_sum_;
+    node->subtree_sum_ = sum;
+}
+
+// Check the summary of every node in the tree against its children, and
+// that the root's summary covers the whole tree.
+static bool CheckSubtreeSums(const SubtreeSumTestTree& tree) {
+    BEGIN_TEST;
+
+    uint64_t total = 0;
+    for (auto iter = tree.begin(); iter.IsValid(); ++iter) {
+        uint64_t sum = iter->weight_;
+        if (iter.left().IsValid()) {
+            ASSERT_TRUE(iter == iter.left().parent());
+            sum += iter.left()->subtree_sum_;
+        }
+        if (iter.right().IsValid()) {
+            ASSERT_TRUE(iter == iter.right().parent());
+            sum += iter.right()->subtree_sum_;
+        }
+        ASSERT_EQ(sum, iter->subtree_sum_);
+        total += iter->weight_;
+    }
+
+    if (tree.is_empty()) {
+        ASSERT_FALSE(tree.root().IsValid());
+    } else {
+        ASSERT_FALSE(tree.root().parent().IsValid());
+        ASSERT_EQ(total, tree.root()->subtree_sum_);
+    }
+
+    END_TEST;
+}
+
+static bool WAVLSubtreeChangeTest() {
+    BEGIN_TEST;
+
+    static constexpr size_t kCount = 512;
+
+    // Declare the objects first so that the tree is cleaned up before them.
+    unique_ptr<SubtreeSumTestObj[]> objects;
+    unique_ptr<SubtreeSumTestObj[]> replacements;
+    SubtreeSumTestTree tree;
+    Lfsr<uint64_t> rng(0x6a3cc0ffee5eed01u);
+
+    {
+        AllocChecker ac;
+        objects.reset(new (&ac) SubtreeSumTestObj[kCount]);
+        ASSERT_TRUE(ac.check());
+        replacements.reset(new (&ac) SubtreeSumTestObj[kCount]);
+        ASSERT_TRUE(ac.check());
+    }
+
+    for (size_t i = 0; i < kCount; ++i) {
+        objects[i].key_ = rng.GetNext();
+        objects[i].weight_ = rng.GetNext() & 0xffff;
+        tree.insert(SubtreeSumTestObjPtr(&objects[i]));
+        ASSERT_TRUE(CheckSubtreeSums(tree));
+    }
+
+    // Change weights in place.
+    for (size_t i = 0; i < kCount; i += 3) {
+        objects[i].weight_ = rng.GetNext() & 0xffff;
+        tree.node_changed(objects[i]);
+        ASSERT_TRUE(CheckSubtreeSums(tree));
+    }
+
+    // Replace some of the nodes with nodes of the same key.
+    for (size_t i = 0; i < kCount; i += 5) {
+        replacements[i].key_ = objects[i].key_;
+        replacements[i].weight_ = rng.GetNext() & 0xffff;
+        SubtreeSumTestObjPtr old = tree.insert_or_replace(SubtreeSumTestObjPtr(&replacements[i]));
+        ASSERT_EQ(&objects[i], old.get());
+        ASSERT_TRUE(CheckSubtreeSums(tree));
+    }
+
+    // Erase everything, in an order unrelated to the keys.
+    for (size_t i = 0; i < kCount; ++i) {
+        size_t ndx = (i * 263) % kCount;
+        SubtreeSumTestObjPtr erased = tree.erase(objects[ndx].key_);
+        ASSERT_NONNULL(erased.get());
+        ASSERT_TRUE(CheckSubtreeSums(tree));
+    }
+    ASSERT_TRUE(tree.is_empty());
+
+    END_TEST;
+}
+
 BEGIN_TEST_CASE(wavl_tree_tests)
 //////////////////////////////////////////
 // General container specific tests.
@@ -544,6 +678,7 @@ RUN_NAMED_TEST("LowerBound (RefPtr)",            RPTE::LowerBoundTest)
 ////////////////////////////
 // ZX-2230: This can take more than 20 seconds in CI, so mark it medium.
 RUN_NAMED_TEST_MEDIUM("BalanceTest", WAVLBalanceTest)
+RUN_NAMED_TEST("SubtreeChangeTest", WAVLSubtreeChangeTest)
 
 END_TEST_CASE(wavl_tree_tests);
 
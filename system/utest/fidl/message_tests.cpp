@@ -91,9 +91,44 @@ bool message_builder_test() {
     END_TEST;
 }
 
+bool message_builder_storage_test() {
+    BEGIN_TEST;
+
+    zx::event e;
+    EXPECT_EQ(zx::event::create(0, &e), ZX_OK);
+    EXPECT_NE(e.get(), ZX_HANDLE_INVALID);
+
+    FIDL_ALIGNDECL uint8_t byte_buffer[64];
+    zx_handle_t handle_buffer[1];
+    fidl::MessageBuilder builder(&nonnullable_handle_message_type,
+                                 byte_buffer, sizeof(byte_buffer),
+                                 handle_buffer, countof(handle_buffer));
+    EXPECT_EQ(reinterpret_cast<uint8_t*>(builder.header()), byte_buffer);
+    builder.header()->txid = 5u;
+    builder.header()->ordinal = 42u;
+
+    zx_handle_t* handle_ptr = builder.New<zx_handle_t>();
+    zx_handle_t handle_value = e.release();
+    *handle_ptr = handle_value;
+
+    fidl::Message message;
+    const char* error_msg;
+    EXPECT_EQ(builder.Encode(&message, &error_msg), ZX_OK);
+
+    // The message lives in the storage given to the builder.
+    EXPECT_EQ(message.bytes().data(), byte_buffer);
+    EXPECT_EQ(message.handles().data(), handle_buffer);
+    EXPECT_EQ(message.txid(), 5u);
+    EXPECT_EQ(message.handles().actual(), 1u);
+    EXPECT_EQ(handle_buffer[0], handle_value);
+
+    END_TEST;
+}
+
 }  // namespace
 
 BEGIN_TEST_CASE(message_tests)
 RUN_NAMED_TEST("Message test", message_test)
 RUN_NAMED_TEST("MessageBuilder test", message_builder_test)
+RUN_NAMED_TEST("MessageBuilder with caller storage test", message_builder_storage_test)
 END_TEST_CASE(message_tests);
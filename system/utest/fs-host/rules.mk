@@ -13,6 +13,7 @@ MODULE_NAME := fs-test
 MODULE_SRCS := \
     $(LOCAL_DIR)/main.cpp \
     $(LOCAL_DIR)/util.cpp \
+    $(LOCAL_DIR)/test-allocation.cpp \
     $(LOCAL_DIR)/test-basic.cpp \
     $(LOCAL_DIR)/test-directory.cpp \
     $(LOCAL_DIR)/test-maxfile.cpp \
@@ -0,0 +1,78 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fbl/unique_fd.h>
+#include <minfs/format.h>
+
+#include "util.h"
+
+// Reads the on-disk inode of the file at |path| straight from the disk image.
+static bool read_inode(const char* path, minfs::Inode* out) {
+    BEGIN_HELPER;
+    struct stat s;
+    ASSERT_EQ(emu_stat(path, &s), 0);
+
+    fbl::unique_fd disk(open(MOUNT_PATH, O_RDONLY));
+    ASSERT_TRUE(disk);
+    minfs::Superblock info;
+    ASSERT_EQ(pread(disk.get(), &info, sizeof(info), 0), (ssize_t)sizeof(info));
+    off_t off = static_cast<off_t>(info.ino_block) * minfs::kMinfsBlockSize +
+                static_cast<off_t>(s.st_ino) * minfs::kMinfsInodeSize;
+    ASSERT_EQ(pread(disk.get(), out, sizeof(*out), off), (ssize_t)sizeof(*out));
+    END_HELPER;
+}
+
+// Grow two files a block at a time, alternating between them. Each file
+// still gets a single run of blocks once its first block is placed, rather
+// than every other block of a shared run.
+static bool TestInterleavedAppendsStayContiguous(void) {
+    BEGIN_TEST;
+
+    constexpr size_t kBlocks = 8;
+    static_assert(kBlocks <= minfs::kMinfsDirect, "Test only checks direct blocks");
+    const char* const kFiles[] = { "::alloc_a", "::alloc_b" };
+    int fd[2];
+    for (unsigned i = 0; i < 2; i++) {
+        fd[i] = emu_open(kFiles[i], O_RDWR | O_CREAT, 0644);
+        ASSERT_GT(fd[i], 0);
+    }
+
+    uint8_t buf[minfs::kMinfsBlockSize];
+    memset(buf, 'a', sizeof(buf));
+    for (size_t n = 0; n < kBlocks; n++) {
+        for (unsigned i = 0; i < 2; i++) {
+            ASSERT_STREAM_ALL(emu_write, fd[i], buf, sizeof(buf));
+        }
+    }
+    for (unsigned i = 0; i < 2; i++) {
+        ASSERT_EQ(emu_close(fd[i]), 0);
+    }
+
+    minfs::Inode inode[2];
+    for (unsigned i = 0; i < 2; i++) {
+        ASSERT_TRUE(read_inode(kFiles[i], &inode[i]));
+        ASSERT_EQ(inode[i].block_count, kBlocks);
+        for (size_t n = 2; n < kBlocks; n++) {
+            ASSERT_EQ(inode[i].dnum[n], inode[i].dnum[n - 1] + 1,
+                      "Block not allocated at its goal");
+        }
+    }
+
+    // The two runs do not overlap.
+    minfs::blk_t a_start = inode[0].dnum[1];
+    minfs::blk_t b_start = inode[1].dnum[1];
+    ASSERT_TRUE(a_start + kBlocks - 1 <= b_start || b_start + kBlocks - 1 <= a_start,
+                "Runs overlap");
+
+    ASSERT_EQ(run_fsck(), 0);
+    END_TEST;
+}
+
+RUN_MINFS_TESTS(allocation_tests,
+    RUN_TEST_MEDIUM(TestInterleavedAppendsStayContiguous)
+)
@@ -80,6 +80,59 @@ bool TestDirectoryLarge(void) {
     END_TEST;
 }
 
+// Exercises lookups in a directory large enough to be indexed by the
+// filesystem, while entries are added, removed, and renamed.
+bool TestDirectoryLargeLookup(void) {
+    BEGIN_TEST;
+
+    const int num_files = 256;
+    char path[PATH_MAX];
+    char path2[PATH_MAX];
+    struct stat s;
+    ASSERT_EQ(mkdir("::dir", 0755), 0);
+    for (int i = 0; i < num_files; i++) {
+        snprintf(path, sizeof(path), "::dir/file-%d", i);
+        int fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+        ASSERT_GT(fd, 0);
+        ASSERT_EQ(close(fd), 0);
+    }
+    ASSERT_EQ(open("::dir/file-7", O_RDWR | O_CREAT | O_EXCL, 0644), -1);
+
+    // Remove every even entry, then check which entries are still visible.
+    for (int i = 0; i < num_files; i += 2) {
+        snprintf(path, sizeof(path), "::dir/file-%d", i);
+        ASSERT_EQ(unlink(path), 0);
+    }
+    for (int i = 0; i < num_files; i++) {
+        snprintf(path, sizeof(path), "::dir/file-%d", i);
+        ASSERT_EQ(stat(path, &s), (i % 2) ? 0 : -1);
+    }
+    ASSERT_EQ(unlink("::dir/file-0"), -1);
+
+    // Rename onto a new name, onto an existing name, and out of the directory.
+    ASSERT_EQ(rename("::dir/file-1", "::dir/renamed"), 0);
+    ASSERT_EQ(rename("::dir/file-3", "::dir/file-5"), 0);
+    ASSERT_EQ(rename("::dir/file-7", "::moved"), 0);
+    ASSERT_EQ(stat("::dir/file-1", &s), -1);
+    ASSERT_EQ(stat("::dir/renamed", &s), 0);
+    ASSERT_EQ(stat("::dir/file-3", &s), -1);
+    ASSERT_EQ(stat("::dir/file-5", &s), 0);
+    ASSERT_EQ(stat("::dir/file-7", &s), -1);
+    ASSERT_EQ(unlink("::moved"), 0);
+    ASSERT_EQ(unlink("::dir/renamed"), 0);
+
+    for (int i = 9; i < num_files; i += 2) {
+        snprintf(path, sizeof(path), "::dir/file-%d", i);
+        snprintf(path2, sizeof(path2), "::dir/file-%d", i - 1);
+        ASSERT_EQ(rename(path, path2), 0);
+        ASSERT_EQ(unlink(path2), 0);
+    }
+    ASSERT_EQ(unlink("::dir/file-5"), 0);
+    ASSERT_EQ(rmdir("::dir"), 0);
+
+    END_TEST;
+}
+
 bool TestDirectoryMax(void) {
     BEGIN_TEST;
 
@@ -463,6 +516,7 @@ RUN_FOR_ALL_FILESYSTEMS(directory_tests,
     RUN_TEST_MEDIUM(TestDirectoryCoalesceLargeRecord)
     RUN_TEST_MEDIUM(TestDirectoryFilenameMax)
     RUN_TEST_LARGE(TestDirectoryLarge)
+    RUN_TEST_MEDIUM(TestDirectoryLargeLookup)
     RUN_TEST_MEDIUM(TestDirectoryTrailingSlash)
     RUN_TEST_MEDIUM(TestDirectoryReaddir)
     RUN_TEST_LARGE(TestDirectoryReaddirRmAll)
@@ -112,9 +112,60 @@ bool TestOffsetOperations(void) {
     END_TEST;
 }
 
+// Test that large reads, which fdio may serve from the file's VMO, observe
+// the seek pointer, the file length, and writes made through other
+// connections.
+bool TestLargeReads(void) {
+    BEGIN_TEST;
+
+    constexpr size_t kFileSize = 1 << 17;
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<uint8_t[]> expected(new (&ac) uint8_t[kFileSize]);
+    ASSERT_TRUE(ac.check());
+    fbl::unique_ptr<uint8_t[]> buf(new (&ac) uint8_t[kFileSize]);
+    ASSERT_TRUE(ac.check());
+    for (size_t i = 0; i < kFileSize; i++) {
+        expected[i] = static_cast<uint8_t>(rand());
+    }
+
+    const char* filename = "::large_reads";
+    fbl::unique_fd fd(open(filename, O_RDWR | O_CREAT, 0644));
+    ASSERT_TRUE(fd);
+    fbl::unique_fd reader(open(filename, O_RDONLY));
+    ASSERT_TRUE(reader);
+    ASSERT_EQ(write(fd.get(), expected.get(), kFileSize), static_cast<ssize_t>(kFileSize));
+
+    // Sequential reads advance the shared seek pointer.
+    ASSERT_EQ(read(reader.get(), buf.get(), kFileSize / 2), static_cast<ssize_t>(kFileSize / 2));
+    ASSERT_EQ(lseek(reader.get(), 0, SEEK_CUR), static_cast<off_t>(kFileSize / 2));
+    ASSERT_EQ(read(reader.get(), &buf[kFileSize / 2], kFileSize),
+              static_cast<ssize_t>(kFileSize / 2));
+    ASSERT_EQ(memcmp(buf.get(), expected.get(), kFileSize), 0);
+    ASSERT_EQ(read(reader.get(), buf.get(), kFileSize), 0);
+
+    // Writes through another connection are visible.
+    memset(&expected[PAGE_SIZE], 0xab, 3 * PAGE_SIZE);
+    ASSERT_EQ(pwrite(fd.get(), &expected[PAGE_SIZE], 3 * PAGE_SIZE, PAGE_SIZE),
+              static_cast<ssize_t>(3 * PAGE_SIZE));
+    ASSERT_EQ(pread(reader.get(), buf.get(), kFileSize, 0), static_cast<ssize_t>(kFileSize));
+    ASSERT_EQ(memcmp(buf.get(), expected.get(), kFileSize), 0);
+
+    // So are changes to the length of the file.
+    ASSERT_EQ(ftruncate(fd.get(), kFileSize / 4), 0);
+    ASSERT_EQ(pread(reader.get(), buf.get(), kFileSize, 0), static_cast<ssize_t>(kFileSize / 4));
+    ASSERT_EQ(memcmp(buf.get(), expected.get(), kFileSize / 4), 0);
+
+    ASSERT_EQ(close(reader.release()), 0);
+    ASSERT_EQ(close(fd.release()), 0);
+    ASSERT_EQ(unlink(filename), 0);
+
+    END_TEST;
+}
+
 }  // namespace
 
 RUN_FOR_ALL_FILESYSTEMS(rw_tests,
     RUN_TEST_MEDIUM(TestZeroLengthOperations)
     RUN_TEST_MEDIUM(TestOffsetOperations)
+    RUN_TEST_MEDIUM(TestLargeReads)
 )
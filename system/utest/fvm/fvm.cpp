@@ -1811,6 +1811,87 @@ bool TestSliceAccessNonContiguousVirtual() {
     END_TEST;
 }
 
+// Test that extending a partition prefers physical slices which keep it
+// contiguous, rather than filling the first free slice.
+bool TestSliceAllocationContiguous() {
+    BEGIN_TEST;
+    char ramdisk_path[PATH_MAX];
+    char fvm_driver[PATH_MAX];
+
+    size_t kDiskSize = use_real_disk ? test_block_size * test_block_count : 512 * (1 << 20);
+    ASSERT_EQ(StartFVMTest(512, 1 << 20, 64lu * (1 << 20), ramdisk_path, fvm_driver), 0,
+              "error mounting FVM");
+
+    int ramdisk_fd = open(ramdisk_path, O_RDWR);
+    ASSERT_GT(ramdisk_fd, 0);
+
+    int fd = open(fvm_driver, O_RDWR);
+    ASSERT_GT(fd, 0);
+    fvm_info_t fvm_info;
+    ASSERT_GT(ioctl_block_fvm_query(fd, &fvm_info), 0);
+    size_t slice_size = fvm_info.slice_size;
+    ASSERT_GE(fvm::UsableSlicesCount(kDiskSize, slice_size), 6);
+
+    // Allocate three partitions, backed by pslices 1, 2 and 3, and free the
+    // middle one, leaving a hole which is too small for a two slice extension.
+    alloc_req_t request;
+    memset(&request, 0, sizeof(request));
+    request.slice_count = 1;
+    memcpy(request.guid, kTestUniqueGUID, GUID_LEN);
+    strcpy(request.name, kTestPartName1);
+    memcpy(request.type, kTestPartGUIDData, GUID_LEN);
+    int data_fd = fvm_allocate_partition(fd, &request);
+    ASSERT_GT(data_fd, 0);
+    strcpy(request.name, kTestPartName2);
+    memcpy(request.type, kTestPartGUIDBlob, GUID_LEN);
+    int blob_fd = fvm_allocate_partition(fd, &request);
+    ASSERT_GT(blob_fd, 0);
+    strcpy(request.name, kTestPartName3);
+    memcpy(request.type, kTestPartGUIDSystem, GUID_LEN);
+    int sys_fd = fvm_allocate_partition(fd, &request);
+    ASSERT_GT(sys_fd, 0);
+    ASSERT_EQ(ioctl_block_fvm_destroy_partition(blob_fd), 0);
+    ASSERT_EQ(close(blob_fd), 0);
+
+    // The extension should be placed in pslices 4 and 5, and the next one
+    // should follow on in pslice 6.
+    extend_request_t erequest;
+    erequest.offset = 1;
+    erequest.length = 2;
+    ASSERT_EQ(ioctl_block_fvm_extend(data_fd, &erequest), 0);
+    erequest.offset = 3;
+    erequest.length = 1;
+    ASSERT_EQ(ioctl_block_fvm_extend(data_fd, &erequest), 0);
+
+    block_info_t info;
+    ASSERT_GE(ioctl_block_get_info(data_fd, &info), 0);
+    fbl::unique_ptr<uint8_t[]> buf(new uint8_t[info.block_size]);
+    fbl::unique_ptr<uint8_t[]> raw(new uint8_t[info.block_size]);
+    const size_t kExpected[] = {1, 4, 5, 6};
+    for (size_t vslice = 0; vslice < fbl::count_of(kExpected); vslice++) {
+        memset(buf.get(), static_cast<int>(0xA0 + vslice), info.block_size);
+        off_t off = vslice * slice_size;
+        ASSERT_EQ(pwrite(data_fd, buf.get(), info.block_size, off),
+                  static_cast<ssize_t>(info.block_size));
+        ASSERT_EQ(fsync(data_fd), 0);
+
+        off = fvm::SliceStart(kDiskSize, slice_size, kExpected[vslice]);
+        ASSERT_EQ(pread(ramdisk_fd, raw.get(), info.block_size, off),
+                  static_cast<ssize_t>(info.block_size));
+        ASSERT_EQ(memcmp(buf.get(), raw.get(), info.block_size), 0,
+                  "Slice not allocated contiguously");
+    }
+
+    ASSERT_EQ(close(data_fd), 0);
+    ASSERT_EQ(close(sys_fd), 0);
+    ASSERT_EQ(close(fd), 0);
+    ASSERT_EQ(close(ramdisk_fd), 0);
+    ASSERT_TRUE(FVMCheckSliceSize(fvm_driver, slice_size));
+    ASSERT_TRUE(ValidateFVM(ramdisk_path));
+    ASSERT_EQ(EndFVMTest(ramdisk_path), 0, "unmounting FVM");
+    END_TEST;
+}
+
 // Test that the FVM driver actually persists updates.
 bool TestPersistenceSimple() {
     BEGIN_TEST;
@@ -2978,6 +3059,7 @@ RUN_TEST_MEDIUM(TestSliceAccessContiguous)
 RUN_TEST_MEDIUM(TestSliceAccessMany)
 RUN_TEST_MEDIUM(TestSliceAccessNonContiguousPhysical)
 RUN_TEST_MEDIUM(TestSliceAccessNonContiguousVirtual)
+RUN_TEST_MEDIUM(TestSliceAllocationContiguous)
 RUN_TEST_MEDIUM(TestPersistenceSimple)
 RUN_TEST_LARGE(TestVPartitionUpgrade)
 RUN_TEST_LARGE(TestMounting)
@@ -6,6 +6,8 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
+#include <stdio.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <threads.h>
@@ -276,6 +278,175 @@ bool TestMemfsCloseDuringAccess() {
     END_TEST;
 }
 
+constexpr size_t kConcurrentReaders = 4;
+constexpr size_t kConcurrentFileSize = 1 << 16;
+
+struct ConcurrentReader {
+    int dirfd;
+    const uint8_t* expected;
+    bool success;
+};
+
+int ConcurrentReadThread(void* arg) {
+    ConcurrentReader* reader = static_cast<ConcurrentReader*>(arg);
+    fbl::unique_fd fd(openat(reader->dirfd, "shared", O_RDONLY));
+    if (!fd) {
+        return -1;
+    }
+    fbl::unique_ptr<uint8_t[]> buf(new uint8_t[kConcurrentFileSize]);
+    for (size_t i = 0; i < 32; i++) {
+        for (size_t off = 0; off < kConcurrentFileSize; off += 8192) {
+            if (pread(fd.get(), &buf[off], 8192, off) != 8192) {
+                return -1;
+            }
+        }
+        if (memcmp(buf.get(), reader->expected, kConcurrentFileSize) != 0) {
+            return -1;
+        }
+    }
+    reader->success = true;
+    return 0;
+}
+
+bool TestMemfsMultiThreaded() {
+    BEGIN_TEST;
+
+    // Serve the filesystem on several threads, so that reads from independent
+    // connections are dispatched concurrently with each other and with
+    // unrelated directory operations.
+    async::Loop loop(&kAsyncLoopConfigNoAttachToThread);
+    for (size_t i = 0; i < kConcurrentReaders; i++) {
+        ASSERT_EQ(loop.StartThread(), ZX_OK);
+    }
+
+    memfs_filesystem_t* vfs;
+    zx_handle_t root;
+    ASSERT_EQ(memfs_create_filesystem(loop.dispatcher(), &vfs, &root), ZX_OK);
+    uint32_t type = PA_FDIO_REMOTE;
+    int dirfd;
+    ASSERT_EQ(fdio_create_fd(&root, &type, 1, &dirfd), ZX_OK);
+
+    fbl::unique_ptr<uint8_t[]> data(new uint8_t[kConcurrentFileSize]);
+    for (size_t i = 0; i < kConcurrentFileSize; i++) {
+        data[i] = static_cast<uint8_t>(i * 7);
+    }
+    fbl::unique_fd fd(openat(dirfd, "shared", O_CREAT | O_RDWR));
+    ASSERT_TRUE(fd);
+    ASSERT_EQ(write(fd.get(), data.get(), kConcurrentFileSize),
+              static_cast<ssize_t>(kConcurrentFileSize));
+    fd.reset();
+
+    ConcurrentReader readers[kConcurrentReaders];
+    thrd_t threads[kConcurrentReaders];
+    for (size_t i = 0; i < kConcurrentReaders; i++) {
+        readers[i] = {dirfd, data.get(), false};
+        ASSERT_EQ(thrd_create(&threads[i], ConcurrentReadThread, &readers[i]), thrd_success);
+    }
+
+    for (size_t i = 0; i < 32; i++) {
+        fbl::unique_fd other(openat(dirfd, "other", O_CREAT | O_RDWR));
+        ASSERT_TRUE(other);
+        ASSERT_EQ(write(other.get(), data.get(), 4096), 4096);
+        other.reset();
+        ASSERT_EQ(unlinkat(dirfd, "other", 0), 0);
+    }
+
+    for (size_t i = 0; i < kConcurrentReaders; i++) {
+        int result;
+        ASSERT_EQ(thrd_join(threads[i], &result), thrd_success);
+        ASSERT_EQ(result, 0);
+        ASSERT_TRUE(readers[i].success);
+    }
+
+    ASSERT_EQ(close(dirfd), 0);
+    sync_completion_t unmounted;
+    memfs_free_filesystem(vfs, &unmounted);
+    ASSERT_EQ(sync_completion_wait(&unmounted, ZX_SEC(3)), ZX_OK);
+
+    END_TEST;
+}
+
+struct ConcurrentWriter {
+    int dirfd;
+    char name[16];
+    uint8_t seed;
+    bool success;
+};
+
+int ConcurrentWriteThread(void* arg) {
+    ConcurrentWriter* writer = static_cast<ConcurrentWriter*>(arg);
+    fbl::unique_fd fd(openat(writer->dirfd, writer->name, O_CREAT | O_RDWR));
+    if (!fd) {
+        return -1;
+    }
+    fbl::unique_ptr<uint8_t[]> data(new uint8_t[kConcurrentFileSize]);
+    for (size_t i = 0; i < kConcurrentFileSize; i++) {
+        data[i] = static_cast<uint8_t>(i * writer->seed);
+    }
+    // Extend the file a little at a time, as with a stream of appends.
+    for (size_t off = 0; off < kConcurrentFileSize; off += 1024) {
+        if (write(fd.get(), &data[off], 1024) != 1024) {
+            return -1;
+        }
+        struct stat st;
+        if (fstat(fd.get(), &st) != 0 || st.st_size != static_cast<off_t>(off + 1024)) {
+            return -1;
+        }
+    }
+    fbl::unique_ptr<uint8_t[]> buf(new uint8_t[kConcurrentFileSize]);
+    if (pread(fd.get(), buf.get(), kConcurrentFileSize, 0) !=
+        static_cast<ssize_t>(kConcurrentFileSize)) {
+        return -1;
+    }
+    if (memcmp(buf.get(), data.get(), kConcurrentFileSize) != 0) {
+        return -1;
+    }
+    writer->success = true;
+    return 0;
+}
+
+bool TestMemfsConcurrentWrites() {
+    BEGIN_TEST;
+
+    async::Loop loop(&kAsyncLoopConfigNoAttachToThread);
+    for (size_t i = 0; i < kConcurrentReaders; i++) {
+        ASSERT_EQ(loop.StartThread(), ZX_OK);
+    }
+
+    memfs_filesystem_t* vfs;
+    zx_handle_t root;
+    ASSERT_EQ(memfs_create_filesystem(loop.dispatcher(), &vfs, &root), ZX_OK);
+    uint32_t type = PA_FDIO_REMOTE;
+    int dirfd;
+    ASSERT_EQ(fdio_create_fd(&root, &type, 1, &dirfd), ZX_OK);
+
+    // Each thread writes to its own file, so the writes are dispatched
+    // concurrently.
+    ConcurrentWriter writers[kConcurrentReaders];
+    thrd_t threads[kConcurrentReaders];
+    for (size_t i = 0; i < kConcurrentReaders; i++) {
+        writers[i].dirfd = dirfd;
+        snprintf(writers[i].name, sizeof(writers[i].name), "file-%zu", i);
+        writers[i].seed = static_cast<uint8_t>(i + 3);
+        writers[i].success = false;
+        ASSERT_EQ(thrd_create(&threads[i], ConcurrentWriteThread, &writers[i]), thrd_success);
+    }
+    for (size_t i = 0; i < kConcurrentReaders; i++) {
+        int result;
+        ASSERT_EQ(thrd_join(threads[i], &result), thrd_success);
+        ASSERT_EQ(result, 0);
+        ASSERT_TRUE(writers[i].success);
+        ASSERT_EQ(unlinkat(dirfd, writers[i].name, 0), 0);
+    }
+
+    ASSERT_EQ(close(dirfd), 0);
+    sync_completion_t unmounted;
+    memfs_free_filesystem(vfs, &unmounted);
+    ASSERT_EQ(sync_completion_wait(&unmounted, ZX_SEC(3)), ZX_OK);
+
+    END_TEST;
+}
+
 } // namespace
 
 BEGIN_TEST_CASE(memfs_tests)
@@ -284,4 +455,6 @@ RUN_TEST(TestMemfsBasic)
 RUN_TEST(TestMemfsLimitPages)
 RUN_TEST(TestMemfsInstall)
 RUN_TEST(TestMemfsCloseDuringAccess)
+RUN_TEST(TestMemfsMultiThreaded)
+RUN_TEST(TestMemfsConcurrentWrites)
 END_TEST_CASE(memfs_tests)
@@ -8,9 +8,10 @@
 namespace {
 
 // Performance test for zx_clock_get_monotonic().  This is worth
-// testing because it is a very commonly called syscall.  The kernel's
-// implementation of the syscall is non-trivial and can be rather slow on
-// some machines/VMs.
+// testing because it is a very commonly called syscall.  The vDSO
+// usually answers it without entering the kernel, but falls back to
+// the kernel's implementation, which can be rather slow on some
+// machines/VMs, when the clock cannot be read from user mode.
 bool ClockGetMonotonicTest() {
     zx_clock_get_monotonic();
     return true;
@@ -0,0 +1,171 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <threads.h>
+
+#include <fbl/atomic.h>
+#include <fbl/function.h>
+#include <fbl/macros.h>
+#include <fbl/string_printf.h>
+#include <fbl/vector.h>
+#include <lib/zx/channel.h>
+#include <lib/zx/event.h>
+#include <lib/zx/port.h>
+#include <perftest/perftest.h>
+#include <zircon/assert.h>
+
+namespace {
+
+// These tests measure the same operations as some of the single-threaded
+// tests, but while other threads are repeatedly doing the same thing, so
+// that lock contention in the kernel or in libc shows up in the results.
+
+// Runs |func| in a loop on each of |thread_count| background threads for
+// the lifetime of this object.  The constructor does not return until all
+// the threads have started, so that thread startup does not overlap with
+// the measurements.
+class BackgroundLoad {
+public:
+    BackgroundLoad(uint32_t thread_count, fbl::Function<void()> func)
+        : func_(fbl::move(func)) {
+        for (uint32_t i = 0; i < thread_count; ++i) {
+            thrd_t thread;
+            ZX_ASSERT(thrd_create(&thread, ThreadFunc, this) == thrd_success);
+            threads_.push_back(thread);
+        }
+        while (started_.load() != thread_count) {
+            thrd_yield();
+        }
+    }
+
+    ~BackgroundLoad() {
+        stop_.store(true);
+        for (thrd_t thread : threads_) {
+            ZX_ASSERT(thrd_join(thread, nullptr) == thrd_success);
+        }
+    }
+
+private:
+    static int ThreadFunc(void* arg) {
+        auto* load = static_cast<BackgroundLoad*>(arg);
+        load->started_.fetch_add(1u);
+        while (!load->stop_.load()) {
+            load->func_();
+        }
+        return 0;
+    }
+
+    fbl::Function<void()> func_;
+    fbl::Vector<thrd_t> threads_;
+    fbl::atomic<uint32_t> started_{0u};
+    fbl::atomic<bool> stop_{false};
+
+    DISALLOW_COPY_ASSIGN_AND_MOVE(BackgroundLoad);
+};
+
+// Measure the times taken to lock and unlock a C11 mutex which other
+// threads are also locking and unlocking.
+bool MutexContendedTest(perftest::RepeatState* state, uint32_t thread_count) {
+    state->DeclareStep("lock");
+    state->DeclareStep("unlock");
+    mtx_t mutex;
+    ZX_ASSERT(mtx_init(&mutex, mtx_plain) == thrd_success);
+    {
+        BackgroundLoad load(thread_count, [&mutex] {
+            ZX_ASSERT(mtx_lock(&mutex) == thrd_success);
+            ZX_ASSERT(mtx_unlock(&mutex) == thrd_success);
+        });
+        while (state->KeepRunning()) {
+            ZX_ASSERT(mtx_lock(&mutex) == thrd_success);
+            state->NextStep();
+            ZX_ASSERT(mtx_unlock(&mutex) == thrd_success);
+        }
+    }
+    mtx_destroy(&mutex);
+    return true;
+}
+
+// Measure the times taken to create and close an event while other threads
+// in the process are also creating and closing handles.
+bool EventCreateContendedTest(perftest::RepeatState* state, uint32_t thread_count) {
+    state->DeclareStep("create");
+    state->DeclareStep("close");
+    BackgroundLoad load(thread_count, [] {
+        zx::event handle;
+        ZX_ASSERT(zx::event::create(0, &handle) == ZX_OK);
+    });
+    while (state->KeepRunning()) {
+        zx::event handle;
+        ZX_ASSERT(zx::event::create(0, &handle) == ZX_OK);
+        state->NextStep();
+    }
+    return true;
+}
+
+// Measure the times taken to write a message to and read it back from a
+// channel while other threads do the same on their own channels.
+bool ChannelWriteReadContendedTest(perftest::RepeatState* state, uint32_t thread_count) {
+    state->DeclareStep("write");
+    state->DeclareStep("read");
+    BackgroundLoad load(thread_count, [] {
+        zx::channel channel1;
+        zx::channel channel2;
+        ZX_ASSERT(zx::channel::create(0, &channel1, &channel2) == ZX_OK);
+        for (int i = 0; i < 100; ++i) {
+            uint32_t msg = 0;
+            ZX_ASSERT(channel1.write(0, &msg, sizeof(msg), nullptr, 0) == ZX_OK);
+            ZX_ASSERT(channel2.read(0, &msg, sizeof(msg), nullptr, nullptr, 0, nullptr) == ZX_OK);
+        }
+    });
+    zx::channel channel1;
+    zx::channel channel2;
+    ZX_ASSERT(zx::channel::create(0, &channel1, &channel2) == ZX_OK);
+    while (state->KeepRunning()) {
+        uint32_t msg = 0;
+        ZX_ASSERT(channel1.write(0, &msg, sizeof(msg), nullptr, 0) == ZX_OK);
+        state->NextStep();
+        ZX_ASSERT(channel2.read(0, &msg, sizeof(msg), nullptr, nullptr, 0, nullptr) == ZX_OK);
+    }
+    return true;
+}
+
+// Measure the times taken to queue a packet to and dequeue it from a port
+// which other threads are also queueing packets to and dequeueing from.
+bool PortQueueWaitContendedTest(perftest::RepeatState* state, uint32_t thread_count) {
+    state->DeclareStep("queue");
+    state->DeclareStep("wait");
+    zx::port port;
+    ZX_ASSERT(zx::port::create(0, &port) == ZX_OK);
+    BackgroundLoad load(thread_count, [&port] {
+        zx_port_packet_t packet = {};
+        packet.type = ZX_PKT_TYPE_USER;
+        ZX_ASSERT(port.queue(&packet) == ZX_OK);
+        ZX_ASSERT(port.wait(zx::time::infinite(), &packet) == ZX_OK);
+    });
+    while (state->KeepRunning()) {
+        zx_port_packet_t packet = {};
+        packet.type = ZX_PKT_TYPE_USER;
+        ZX_ASSERT(port.queue(&packet) == ZX_OK);
+        state->NextStep();
+        ZX_ASSERT(port.wait(zx::time::infinite(), &packet) == ZX_OK);
+    }
+    return true;
+}
+
+void RegisterTests() {
+    static const uint32_t kThreadCounts[] = {1, 3};
+    for (auto thread_count : kThreadCounts) {
+        auto name = fbl::StringPrintf("Contended/MutexLockUnlock/%uThreads", thread_count);
+        perftest::RegisterTest(name.c_str(), MutexContendedTest, thread_count);
+        name = fbl::StringPrintf("Contended/HandleCreate_Event/%uThreads", thread_count);
+        perftest::RegisterTest(name.c_str(), EventCreateContendedTest, thread_count);
+        name = fbl::StringPrintf("Contended/ChannelWriteRead/%uThreads", thread_count);
+        perftest::RegisterTest(name.c_str(), ChannelWriteReadContendedTest, thread_count);
+        name = fbl::StringPrintf("Contended/PortQueueWait/%uThreads", thread_count);
+        perftest::RegisterTest(name.c_str(), PortQueueWaitContendedTest, thread_count);
+    }
+}
+PERFTEST_CTOR(RegisterTests);
+
+}  // namespace
@@ -0,0 +1,62 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <lib/fidl/coding.h>
+#include <lib/fidl/internal.h>
+#include <perftest/perftest.h>
+#include <zircon/assert.h>
+#include <zircon/fidl.h>
+
+namespace {
+
+// A message made of plain old data only, like the requests for which the C
+// bindings generate a size check in place of a call to fidl_decode().
+struct PodMessage {
+    fidl_message_header_t hdr;
+    uint32_t mode;
+    uint32_t flags;
+    uint64_t offset;
+    uint64_t length;
+};
+
+const fidl_type_t kPodMessageType =
+    fidl_type_t(fidl::FidlCodedStruct(nullptr, 0u, sizeof(PodMessage), "PodMessage"));
+
+// Measures decoding of a POD-only message by walking its coding table.
+bool DecodeWalkerTest(perftest::RepeatState* state) {
+    FIDL_ALIGNDECL PodMessage message = {};
+    while (state->KeepRunning()) {
+        zx_status_t status = fidl_decode(&kPodMessageType, &message, sizeof(message),
+                                         nullptr, 0u, nullptr);
+        ZX_ASSERT(status == ZX_OK);
+    }
+    return true;
+}
+
+// Measures decoding of the same message by the check the C bindings
+// generate instead.
+bool DecodeSizeCheckTest(perftest::RepeatState* state) {
+    FIDL_ALIGNDECL PodMessage message = {};
+    fidl_msg_t msg = {
+        .bytes = &message,
+        .handles = nullptr,
+        .num_bytes = sizeof(message),
+        .num_handles = 0u,
+    };
+    while (state->KeepRunning()) {
+        // Keep the compiler from folding the check away.
+        __asm__ volatile("" : : "r"(&msg) : "memory");
+        bool valid = msg.num_bytes == FIDL_ALIGN(sizeof(PodMessage)) && msg.num_handles == 0u;
+        ZX_ASSERT(valid);
+    }
+    return true;
+}
+
+void RegisterTests() {
+    perftest::RegisterTest("Fidl/Decode/Walker/PodMessage", DecodeWalkerTest);
+    perftest::RegisterTest("Fidl/Decode/SizeCheck/PodMessage", DecodeSizeCheckTest);
+}
+PERFTEST_CTOR(RegisterTests);
+
+}  // namespace
@@ -0,0 +1,272 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <threads.h>
+
+#include <fbl/function.h>
+#include <fbl/macros.h>
+#include <fbl/string_printf.h>
+#include <fbl/unique_ptr.h>
+#include <lib/zx/channel.h>
+#include <lib/zx/event.h>
+#include <lib/zx/eventpair.h>
+#include <lib/zx/fifo.h>
+#include <lib/zx/port.h>
+#include <lib/zx/socket.h>
+#include <perftest/perftest.h>
+#include <zircon/assert.h>
+
+namespace {
+
+// These tests measure the round trip time of IPC between two threads in
+// the same process, for each of the Zircon IPC primitives: the main thread
+// sends a message and the other thread sends it straight back.  Where the
+// primitive carries a payload, the tests are run over a range of message
+// sizes, so that the Mbytes/sec column of the results gives the throughput.
+//
+// Unlike the single-threaded write/read tests, these include the cost of
+// waking up the other thread.
+
+// Runs |func| on a new thread, and joins the thread on destruction.  |func|
+// should return once the main thread closes its end of the IPC object.
+class EchoThread {
+public:
+    explicit EchoThread(fbl::Function<void()> func)
+        : func_(fbl::move(func)) {
+        ZX_ASSERT(thrd_create(&thread_, ThreadFunc, this) == thrd_success);
+    }
+
+    ~EchoThread() {
+        ZX_ASSERT(thrd_join(thread_, nullptr) == thrd_success);
+    }
+
+private:
+    static int ThreadFunc(void* arg) {
+        static_cast<EchoThread*>(arg)->func_();
+        return 0;
+    }
+
+    fbl::Function<void()> func_;
+    thrd_t thread_;
+
+    DISALLOW_COPY_ASSIGN_AND_MOVE(EchoThread);
+};
+
+// Waits for |channel| to be readable.  Returns false if the peer was closed
+// and there is nothing left to read.
+bool WaitReadable(const zx::channel& channel) {
+    zx_signals_t observed;
+    ZX_ASSERT(channel.wait_one(ZX_CHANNEL_READABLE | ZX_CHANNEL_PEER_CLOSED,
+                               zx::time::infinite(), &observed) == ZX_OK);
+    return (observed & ZX_CHANNEL_READABLE) != 0;
+}
+
+bool ChannelRoundTripTest(perftest::RepeatState* state, uint32_t size,
+                          uint32_t handle_count) {
+    state->SetBytesProcessedPerRun(size * 2);
+
+    zx::channel client;
+    zx::channel server;
+    ZX_ASSERT(zx::channel::create(0, &client, &server) == ZX_OK);
+
+    fbl::unique_ptr<uint8_t[]> buffer(new uint8_t[size]());
+    fbl::unique_ptr<zx_handle_t[]> handles(new zx_handle_t[handle_count]);
+    for (uint32_t i = 0; i < handle_count; ++i) {
+        zx::event event;
+        ZX_ASSERT(zx::event::create(0, &event) == ZX_OK);
+        handles[i] = event.release();
+    }
+
+    {
+        EchoThread echo([&server, size, handle_count] {
+            fbl::unique_ptr<uint8_t[]> buffer(new uint8_t[size]);
+            fbl::unique_ptr<zx_handle_t[]> handles(new zx_handle_t[handle_count]);
+            while (WaitReadable(server)) {
+                uint32_t actual_bytes;
+                uint32_t actual_handles;
+                ZX_ASSERT(server.read(0, buffer.get(), size, &actual_bytes, handles.get(),
+                                      handle_count, &actual_handles) == ZX_OK);
+                ZX_ASSERT(server.write(0, buffer.get(), actual_bytes, handles.get(),
+                                       actual_handles) == ZX_OK);
+            }
+        });
+
+        while (state->KeepRunning()) {
+            ZX_ASSERT(client.write(0, buffer.get(), size, handles.get(),
+                                   handle_count) == ZX_OK);
+            ZX_ASSERT(WaitReadable(client));
+            uint32_t actual_bytes;
+            uint32_t actual_handles;
+            ZX_ASSERT(client.read(0, buffer.get(), size, &actual_bytes, handles.get(),
+                                  handle_count, &actual_handles) == ZX_OK);
+            ZX_ASSERT(actual_bytes == size);
+            ZX_ASSERT(actual_handles == handle_count);
+        }
+        client.reset();
+    }
+
+    for (uint32_t i = 0; i < handle_count; ++i) {
+        zx_handle_close(handles[i]);
+    }
+    return true;
+}
+
+// Reads exactly |size| bytes from |socket|.  Returns false if the peer was
+// closed first.
+bool SocketReadAll(const zx::socket& socket, uint8_t* buffer, size_t size) {
+    while (size > 0) {
+        zx_signals_t observed;
+        ZX_ASSERT(socket.wait_one(ZX_SOCKET_READABLE | ZX_SOCKET_PEER_CLOSED,
+                                  zx::time::infinite(), &observed) == ZX_OK);
+        if (!(observed & ZX_SOCKET_READABLE)) {
+            return false;
+        }
+        size_t actual;
+        ZX_ASSERT(socket.read(0, buffer, size, &actual) == ZX_OK);
+        buffer += actual;
+        size -= actual;
+    }
+    return true;
+}
+
+bool SocketRoundTripTest(perftest::RepeatState* state, uint32_t size) {
+    state->SetBytesProcessedPerRun(size * 2);
+
+    zx::socket client;
+    zx::socket server;
+    ZX_ASSERT(zx::socket::create(ZX_SOCKET_STREAM, &client, &server) == ZX_OK);
+
+    fbl::unique_ptr<uint8_t[]> buffer(new uint8_t[size]());
+
+    EchoThread echo([&server, size] {
+        fbl::unique_ptr<uint8_t[]> buffer(new uint8_t[size]);
+        while (SocketReadAll(server, buffer.get(), size)) {
+            size_t actual;
+            ZX_ASSERT(server.write(0, buffer.get(), size, &actual) == ZX_OK);
+            ZX_ASSERT(actual == size);
+        }
+    });
+
+    while (state->KeepRunning()) {
+        size_t actual;
+        ZX_ASSERT(client.write(0, buffer.get(), size, &actual) == ZX_OK);
+        ZX_ASSERT(actual == size);
+        ZX_ASSERT(SocketReadAll(client, buffer.get(), size));
+    }
+    client.reset();
+    return true;
+}
+
+bool FifoRoundTripTest(perftest::RepeatState* state) {
+    zx::fifo client;
+    zx::fifo server;
+    ZX_ASSERT(zx::fifo::create(1, sizeof(uint64_t), 0, &client, &server) == ZX_OK);
+
+    EchoThread echo([&server] {
+        for (;;) {
+            zx_signals_t observed;
+            ZX_ASSERT(server.wait_one(ZX_FIFO_READABLE | ZX_FIFO_PEER_CLOSED,
+                                      zx::time::infinite(), &observed) == ZX_OK);
+            if (!(observed & ZX_FIFO_READABLE)) {
+                return;
+            }
+            uint64_t entry;
+            ZX_ASSERT(server.read(sizeof(entry), &entry, 1, nullptr) == ZX_OK);
+            ZX_ASSERT(server.write(sizeof(entry), &entry, 1, nullptr) == ZX_OK);
+        }
+    });
+
+    uint64_t entry = 0;
+    while (state->KeepRunning()) {
+        ZX_ASSERT(client.write(sizeof(entry), &entry, 1, nullptr) == ZX_OK);
+        ZX_ASSERT(client.wait_one(ZX_FIFO_READABLE, zx::time::infinite(),
+                                  nullptr) == ZX_OK);
+        ZX_ASSERT(client.read(sizeof(entry), &entry, 1, nullptr) == ZX_OK);
+    }
+    client.reset();
+    return true;
+}
+
+bool EventPairRoundTripTest(perftest::RepeatState* state) {
+    zx::eventpair client;
+    zx::eventpair server;
+    ZX_ASSERT(zx::eventpair::create(0, &client, &server) == ZX_OK);
+
+    EchoThread echo([&server] {
+        for (;;) {
+            zx_signals_t observed;
+            ZX_ASSERT(server.wait_one(ZX_USER_SIGNAL_0 | ZX_EVENTPAIR_PEER_CLOSED,
+                                      zx::time::infinite(), &observed) == ZX_OK);
+            if (!(observed & ZX_USER_SIGNAL_0)) {
+                return;
+            }
+            ZX_ASSERT(server.signal(ZX_USER_SIGNAL_0, 0) == ZX_OK);
+            ZX_ASSERT(server.signal_peer(0, ZX_USER_SIGNAL_0) == ZX_OK);
+        }
+    });
+
+    while (state->KeepRunning()) {
+        ZX_ASSERT(client.signal_peer(0, ZX_USER_SIGNAL_0) == ZX_OK);
+        ZX_ASSERT(client.wait_one(ZX_USER_SIGNAL_0, zx::time::infinite(),
+                                  nullptr) == ZX_OK);
+        ZX_ASSERT(client.signal(ZX_USER_SIGNAL_0, 0) == ZX_OK);
+    }
+    client.reset();
+    return true;
+}
+
+bool PortRoundTripTest(perftest::RepeatState* state) {
+    // Ports have no peer, so the request packet's key tells the other
+    // thread whether to keep going.
+    constexpr uint64_t kKeyEcho = 0;
+    constexpr uint64_t kKeyQuit = 1;
+
+    zx::port request_port;
+    zx::port reply_port;
+    ZX_ASSERT(zx::port::create(0, &request_port) == ZX_OK);
+    ZX_ASSERT(zx::port::create(0, &reply_port) == ZX_OK);
+
+    EchoThread echo([&request_port, &reply_port] {
+        for (;;) {
+            zx_port_packet_t packet;
+            ZX_ASSERT(request_port.wait(zx::time::infinite(), &packet) == ZX_OK);
+            if (packet.key == kKeyQuit) {
+                return;
+            }
+            ZX_ASSERT(reply_port.queue(&packet) == ZX_OK);
+        }
+    });
+
+    zx_port_packet_t packet = {};
+    packet.key = kKeyEcho;
+    packet.type = ZX_PKT_TYPE_USER;
+    while (state->KeepRunning()) {
+        ZX_ASSERT(request_port.queue(&packet) == ZX_OK);
+        ZX_ASSERT(reply_port.wait(zx::time::infinite(), &packet) == ZX_OK);
+    }
+
+    packet.key = kKeyQuit;
+    ZX_ASSERT(request_port.queue(&packet) == ZX_OK);
+    return true;
+}
+
+void RegisterTests() {
+    static const uint32_t kMessageSizes[] = {64, 1024, 32 * 1024};
+    static const uint32_t kHandleCounts[] = {0, 1, 8};
+    for (auto size : kMessageSizes) {
+        for (auto handle_count : kHandleCounts) {
+            auto name = fbl::StringPrintf("IpcRoundTrip/Channel/%ubytes/%uhandles",
+                                          size, handle_count);
+            perftest::RegisterTest(name.c_str(), ChannelRoundTripTest, size, handle_count);
+        }
+        auto name = fbl::StringPrintf("IpcRoundTrip/Socket/%ubytes", size);
+        perftest::RegisterTest(name.c_str(), SocketRoundTripTest, size);
+    }
+    perftest::RegisterTest("IpcRoundTrip/Fifo", FifoRoundTripTest);
+    perftest::RegisterTest("IpcRoundTrip/EventPair", EventPairRoundTripTest);
+    perftest::RegisterTest("IpcRoundTrip/Port", PortRoundTripTest);
+}
+PERFTEST_CTOR(RegisterTests);
+
+}  // namespace
@@ -0,0 +1,58 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fbl/string_printf.h>
+#include <fbl/vector.h>
+#include <perftest/perftest.h>
+#include <region-alloc/region-alloc.h>
+#include <zircon/assert.h>
+
+namespace {
+
+constexpr uint64_t kPageSize = 4096;
+constexpr size_t kRegionPoolSize = 1 << 20;
+
+// Measure the times taken to allocate and free a page-sized, page-aligned
+// region from an allocator whose free space is:
+//  - a single large region, if |fragments| is 0, or
+//  - that large region plus |fragments| page-sized free regions which are
+//    not page aligned, and so are candidates by size but not by alignment.
+//
+// The second case measures how the allocator copes with free space which
+// has been fragmented by earlier allocations with smaller alignments.
+bool RegionAllocTest(perftest::RepeatState* state, uint32_t fragments) {
+    state->DeclareStep("alloc");
+    state->DeclareStep("free");
+
+    RegionAllocator alloc(RegionAllocator::RegionPool::Create(kRegionPoolSize));
+
+    // Lay the fragments out at the start of the space, each separated from
+    // the next by a gap so that they cannot merge, followed by the large
+    // region.
+    uint64_t base = 0;
+    for (uint32_t i = 0; i < fragments; ++i) {
+        ZX_ASSERT(alloc.AddRegion({ .base = base + 1, .size = kPageSize }) == ZX_OK);
+        base += 4 * kPageSize;
+    }
+    ZX_ASSERT(alloc.AddRegion({ .base = base, .size = 1024 * kPageSize }) == ZX_OK);
+
+    while (state->KeepRunning()) {
+        RegionAllocator::Region::UPtr region;
+        ZX_ASSERT(alloc.GetRegion(kPageSize, kPageSize, region) == ZX_OK);
+        state->NextStep();
+        region.reset();
+    }
+    return true;
+}
+
+void RegisterTests() {
+    static const uint32_t kFragmentCounts[] = {0, 100, 1000};
+    for (auto fragments : kFragmentCounts) {
+        auto name = fbl::StringPrintf("RegionAlloc/AllocFree/%ufragments", fragments);
+        perftest::RegisterTest(name.c_str(), RegionAllocTest, fragments);
+    }
+}
+PERFTEST_CTOR(RegisterTests);
+
+}  // namespace
@@ -2,6 +2,8 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <math.h>
+
 #include <fbl/algorithm.h>
 #include <fbl/unique_ptr.h>
 #include <perftest/results.h>
@@ -61,6 +63,10 @@ static bool TestSummaryStatistics() {
     EXPECT_EQ(static_cast<int>(stats.std_dev), 68);
     // There is an even number of values, so the median is interpolated.
     EXPECT_EQ(stats.median, (100 + 110) / 2);
+    // Interpolated between the two largest values: 110 + (200 - 110) * 0.7.
+    EXPECT_EQ(lround(stats.p90), 173);
+    EXPECT_EQ(lround(stats.p99 * 10), 1973);
+    EXPECT_EQ(lround(stats.p999 * 100), 19973);
 
     test_case->AppendValue(300);
     stats = test_case->GetSummaryStatistics();
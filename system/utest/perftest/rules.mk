@@ -10,16 +10,23 @@ MODULE_TYPE := usertest
 
 MODULE_SRCS += \
     $(LOCAL_DIR)/clock-test.cpp \
+    $(LOCAL_DIR)/contention-test.cpp \
+    $(LOCAL_DIR)/fidl-test.cpp \
     $(LOCAL_DIR)/handle-creation-test.cpp \
+    $(LOCAL_DIR)/ipc-test.cpp \
     $(LOCAL_DIR)/malloc-test.cpp \
     $(LOCAL_DIR)/memcpy-test.cpp \
     $(LOCAL_DIR)/mutex-test.cpp \
     $(LOCAL_DIR)/null-test.cpp \
     $(LOCAL_DIR)/process-test.cpp \
+    $(LOCAL_DIR)/region-alloc-test.cpp \
     $(LOCAL_DIR)/results-test.cpp \
     $(LOCAL_DIR)/runner-test.cpp \
     $(LOCAL_DIR)/sleep-test.cpp \
+    $(LOCAL_DIR)/string-test.cpp \
     $(LOCAL_DIR)/syscalls-test.cpp \
+    $(LOCAL_DIR)/vmar-test.cpp \
+    $(LOCAL_DIR)/vmo-cache-op-test.cpp \
 
 MODULE_NAME := perf-test
 
@@ -29,7 +36,9 @@ MODULE_STATIC_LIBS := \
     system/ulib/async-loop.cpp \
     system/ulib/async.cpp \
     system/ulib/fbl \
+    system/ulib/fidl \
     system/ulib/perftest \
+    system/ulib/region-alloc \
     system/ulib/trace \
     system/ulib/trace-provider \
     system/ulib/zx \
@@ -0,0 +1,65 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <string.h>
+
+#include <fbl/string_printf.h>
+#include <fbl/unique_ptr.h>
+#include <perftest/perftest.h>
+
+namespace {
+
+// Test performance of memcmp() on two equal blocks of the given size, so
+// that every byte has to be compared.
+bool MemcmpTest(perftest::RepeatState* state, size_t size) {
+    state->SetBytesProcessedPerRun(size);
+
+    fbl::unique_ptr<char[]> buf1(new char[size]);
+    fbl::unique_ptr<char[]> buf2(new char[size]);
+    memset(buf1.get(), 0, size);
+    memset(buf2.get(), 0, size);
+
+    while (state->KeepRunning()) {
+        int result = memcmp(buf1.get(), buf2.get(), size);
+        // Stop the compiler from optimizing away the memcmp() call.
+        perftest::DoNotOptimize(result);
+        perftest::DoNotOptimize(buf1.get());
+        perftest::DoNotOptimize(buf2.get());
+    }
+    return true;
+}
+
+// Test performance of strlen() on a string of the given length.
+bool StrlenTest(perftest::RepeatState* state, size_t size) {
+    state->SetBytesProcessedPerRun(size);
+
+    fbl::unique_ptr<char[]> str(new char[size + 1]);
+    memset(str.get(), 'a', size);
+    str[size] = '\0';
+
+    while (state->KeepRunning()) {
+        size_t length = strlen(str.get());
+        // Stop the compiler from optimizing away the strlen() call.
+        perftest::DoNotOptimize(length);
+        perftest::DoNotOptimize(str.get());
+    }
+    return true;
+}
+
+void RegisterTests() {
+    static const size_t kSizesBytes[] = {
+        16,
+        1000,
+        100000,
+    };
+    for (auto size : kSizesBytes) {
+        auto name = fbl::StringPrintf("Memcmp/%zubytes", size);
+        perftest::RegisterTest(name.c_str(), MemcmpTest, size);
+        name = fbl::StringPrintf("Strlen/%zubytes", size);
+        perftest::RegisterTest(name.c_str(), StrlenTest, size);
+    }
+}
+PERFTEST_CTOR(RegisterTests);
+
+}  // namespace
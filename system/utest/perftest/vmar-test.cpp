@@ -0,0 +1,57 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fbl/string_printf.h>
+#include <lib/zx/vmar.h>
+#include <lib/zx/vmo.h>
+#include <perftest/perftest.h>
+#include <zircon/assert.h>
+
+namespace {
+
+constexpr size_t kPageSize = 4096;
+constexpr size_t kVmarSize = 1 << 30;
+
+// Measure the times taken to map and unmap a page in a VMAR which already
+// holds |mapping_count| other one-page mappings, placed by the kernel.  This
+// shows how the cost of choosing a spot for a new mapping grows with the
+// number of mappings in the VMAR.
+bool VmarMapTest(perftest::RepeatState* state, uint32_t mapping_count) {
+    state->DeclareStep("map");
+    state->DeclareStep("unmap");
+
+    zx::vmo vmo;
+    ZX_ASSERT(zx::vmo::create(kPageSize, 0, &vmo) == ZX_OK);
+
+    zx::vmar vmar;
+    uintptr_t vmar_addr;
+    ZX_ASSERT(zx::vmar::root_self()->allocate(
+                  0, kVmarSize, ZX_VM_CAN_MAP_READ, &vmar, &vmar_addr) == ZX_OK);
+
+    for (uint32_t i = 0; i < mapping_count; ++i) {
+        uintptr_t addr;
+        ZX_ASSERT(vmar.map(0, vmo, 0, kPageSize, ZX_VM_PERM_READ, &addr) == ZX_OK);
+    }
+
+    while (state->KeepRunning()) {
+        uintptr_t addr;
+        ZX_ASSERT(vmar.map(0, vmo, 0, kPageSize, ZX_VM_PERM_READ, &addr) == ZX_OK);
+        state->NextStep();
+        ZX_ASSERT(vmar.unmap(addr, kPageSize) == ZX_OK);
+    }
+
+    ZX_ASSERT(vmar.destroy() == ZX_OK);
+    return true;
+}
+
+void RegisterTests() {
+    static const uint32_t kMappingCounts[] = {0, 1000, 10000};
+    for (auto mapping_count : kMappingCounts) {
+        auto name = fbl::StringPrintf("Vmar/MapUnmap/%umappings", mapping_count);
+        perftest::RegisterTest(name.c_str(), VmarMapTest, mapping_count);
+    }
+}
+PERFTEST_CTOR(RegisterTests);
+
+}  // namespace
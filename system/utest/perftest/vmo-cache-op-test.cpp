@@ -0,0 +1,50 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fbl/string_printf.h>
+#include <lib/zx/vmo.h>
+#include <perftest/perftest.h>
+#include <zircon/assert.h>
+
+namespace {
+
+// Measure the throughput of cache maintenance on a committed VMO of |size|
+// bytes, as done by drivers handing frame buffers to and from a device.
+bool VmoCacheOpTest(perftest::RepeatState* state, uint32_t op, size_t size) {
+    state->SetBytesProcessedPerRun(size);
+
+    zx::vmo vmo;
+    ZX_ASSERT(zx::vmo::create(size, 0, &vmo) == ZX_OK);
+    ZX_ASSERT(vmo.op_range(ZX_VMO_OP_COMMIT, 0, size, nullptr, 0) == ZX_OK);
+
+    while (state->KeepRunning()) {
+        ZX_ASSERT(vmo.op_range(op, 0, size, nullptr, 0) == ZX_OK);
+    }
+    return true;
+}
+
+void RegisterTests() {
+    static const struct {
+        const char* name;
+        uint32_t op;
+    } kOps[] = {
+        {"Clean", ZX_VMO_OP_CACHE_CLEAN},
+        {"CleanInvalidate", ZX_VMO_OP_CACHE_CLEAN_INVALIDATE},
+    };
+    static const size_t kSizesBytes[] = {
+        4096,
+        65536,
+        1 << 20,
+        8 << 20,
+    };
+    for (const auto& op : kOps) {
+        for (auto size : kSizesBytes) {
+            auto name = fbl::StringPrintf("Vmo/Cache%s/%zubytes", op.name, size);
+            perftest::RegisterTest(name.c_str(), VmoCacheOpTest, op.op, size);
+        }
+    }
+}
+PERFTEST_CTOR(RegisterTests);
+
+}  // namespace
@@ -15,6 +15,7 @@
 #include <threads.h>
 #include <unistd.h>
 
+#include <block-client/cpp/async-client.h>
 #include <block-client/cpp/client.h>
 #include <fbl/algorithm.h>
 #include <fbl/alloc_checker.h>
@@ -27,6 +28,7 @@
 #include <fbl/unique_fd.h>
 #include <fbl/unique_ptr.h>
 #include <fs-management/ramdisk.h>
+#include <lib/async-loop/cpp/loop.h>
 #include <lib/fdio/watcher.h>
 #include <lib/fzl/fifo.h>
 #include <lib/fzl/vmo-mapper.h>
@@ -202,6 +204,37 @@ static bool RamdiskTestVmo(void) {
     END_TEST;
 }
 
+static bool RamdiskTestLatency(void) {
+    BEGIN_TEST;
+    fbl::unique_ptr<RamdiskTest> ramdisk;
+    ASSERT_TRUE(RamdiskTest::Create(PAGE_SIZE, 64, &ramdisk));
+
+    ramdisk_latency_t latency = {};
+    latency.request_ns = ZX_MSEC(10);
+    ASSERT_EQ(ioctl_ramdisk_set_latency(ramdisk->fd(), &latency), ZX_OK);
+
+    uint8_t buf[PAGE_SIZE];
+    uint8_t out[PAGE_SIZE];
+    memset(buf, 'a', sizeof(buf));
+    memset(out, 0, sizeof(out));
+
+    // Each request takes at least as long as the latency model says.
+    zx::time start = zx::clock::get_monotonic();
+    ASSERT_EQ(pwrite(ramdisk->fd(), buf, sizeof(buf), 0), (ssize_t)sizeof(buf));
+    ASSERT_EQ(pread(ramdisk->fd(), out, sizeof(out), 0), (ssize_t)sizeof(out));
+    EXPECT_GE((zx::clock::get_monotonic() - start).get(), 2 * latency.request_ns);
+    EXPECT_EQ(memcmp(out, buf, sizeof(out)), 0);
+
+    // Clearing the model makes the ramdisk as fast as before.
+    latency = {};
+    ASSERT_EQ(ioctl_ramdisk_set_latency(ramdisk->fd(), &latency), ZX_OK);
+    memset(out, 0, sizeof(out));
+    ASSERT_EQ(pread(ramdisk->fd(), out, sizeof(out), 0), (ssize_t)sizeof(out));
+    EXPECT_EQ(memcmp(out, buf, sizeof(out)), 0);
+
+    END_TEST;
+}
+
 // This test creates a ramdisk, verifies it is visible in the filesystem
 // (where we expect it to be!) and verifies that it is removed when we
 // "unplug" the device.
@@ -576,6 +609,157 @@ bool RamdiskTestFifoBasic(void) {
     END_TEST;
 }
 
+bool RamdiskTestFifoMergedRequests(void) {
+    BEGIN_TEST;
+    fbl::unique_ptr<RamdiskTest> ramdisk;
+    ASSERT_TRUE(RamdiskTest::Create(PAGE_SIZE, 512, &ramdisk));
+
+    zx::fifo fifo;
+    ssize_t expected = sizeof(fifo);
+    ASSERT_EQ(ioctl_block_get_fifos(ramdisk->fd(), fifo.reset_and_get_address()),
+              expected, "Failed to get FIFO");
+    groupid_t group = 0;
+
+    // The first half of the VMO is written, the second half is read into.
+    constexpr size_t kBlocks = 8;
+    uint64_t vmo_size = PAGE_SIZE * kBlocks * 2;
+    zx::vmo vmo;
+    ASSERT_EQ(zx::vmo::create(vmo_size, 0, &vmo), ZX_OK, "Failed to create VMO");
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<uint8_t[]> buf(new (&ac) uint8_t[vmo_size]);
+    ASSERT_TRUE(ac.check());
+    fill_random(buf.get(), vmo_size);
+    ASSERT_EQ(vmo.write(buf.get(), 0, vmo_size), ZX_OK);
+
+    vmoid_t vmoid;
+    expected = sizeof(vmoid_t);
+    zx::vmo xfer_vmo;
+    ASSERT_EQ(vmo.duplicate(ZX_RIGHT_SAME_RIGHTS, &xfer_vmo), ZX_OK);
+    zx_handle_t raw_xfer_vmo = xfer_vmo.release();
+    ASSERT_EQ(ioctl_block_attach_vmo(ramdisk->fd(), &raw_xfer_vmo, &vmoid), expected,
+              "Failed to attach vmo");
+
+    block_client::Client client;
+    ASSERT_EQ(block_client::Client::Create(fbl::move(fifo), &client), ZX_OK);
+
+    // Single block writes which the server may merge: a contiguous run, a run
+    // submitted out of order, and blocks contiguous on the device but not in
+    // the VMO.
+    const uint64_t vmo_offsets[kBlocks] = { 0, 1, 2, 3, 5, 4, 6, 7 };
+    const uint64_t dev_offsets[kBlocks] = { 0, 1, 2, 3, 5, 4, 7, 6 };
+    block_fifo_request_t requests[kBlocks];
+    for (size_t i = 0; i < kBlocks; i++) {
+        requests[i].group      = group;
+        requests[i].vmoid      = vmoid;
+        requests[i].opcode     = BLOCKIO_WRITE;
+        requests[i].length     = 1;
+        requests[i].vmo_offset = vmo_offsets[i];
+        requests[i].dev_offset = dev_offsets[i];
+    }
+    ASSERT_EQ(client.Transaction(requests, fbl::count_of(requests)), ZX_OK);
+
+    // Read the blocks back one at a time, in order, into the second half.
+    for (size_t i = 0; i < kBlocks; i++) {
+        requests[i].opcode     = BLOCKIO_READ;
+        requests[i].vmo_offset = kBlocks + i;
+        requests[i].dev_offset = i;
+    }
+    ASSERT_EQ(client.Transaction(requests, fbl::count_of(requests)), ZX_OK);
+
+    fbl::unique_ptr<uint8_t[]> out(new (&ac) uint8_t[vmo_size]);
+    ASSERT_TRUE(ac.check());
+    ASSERT_EQ(vmo.read(out.get(), 0, vmo_size), ZX_OK);
+    for (size_t i = 0; i < kBlocks; i++) {
+        const uint8_t* written = buf.get() + vmo_offsets[i] * PAGE_SIZE;
+        const uint8_t* read = out.get() + (kBlocks + dev_offsets[i]) * PAGE_SIZE;
+        ASSERT_EQ(memcmp(written, read, PAGE_SIZE), 0, "Read data not equal to written data");
+    }
+
+    requests[0].opcode = BLOCKIO_CLOSE_VMO;
+    ASSERT_EQ(client.Transaction(&requests[0], 1), ZX_OK);
+
+    END_TEST;
+}
+
+bool RamdiskTestFifoAsyncClient(void) {
+    BEGIN_TEST;
+    fbl::unique_ptr<RamdiskTest> ramdisk;
+    ASSERT_TRUE(RamdiskTest::Create(PAGE_SIZE, 512, &ramdisk));
+
+    zx::fifo fifo;
+    ssize_t expected = sizeof(fifo);
+    ASSERT_EQ(ioctl_block_get_fifos(ramdisk->fd(), fifo.reset_and_get_address()),
+              expected, "Failed to get FIFO");
+
+    // More transactions than there are groups, so that some are queued in
+    // the client until others complete.  The first half of the VMO is
+    // written, the second half is read into.
+    constexpr size_t kTxns = MAX_TXN_GROUP_COUNT * 4;
+    uint64_t vmo_size = PAGE_SIZE * kTxns * 2;
+    zx::vmo vmo;
+    ASSERT_EQ(zx::vmo::create(vmo_size, 0, &vmo), ZX_OK, "Failed to create VMO");
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<uint8_t[]> buf(new (&ac) uint8_t[vmo_size]);
+    ASSERT_TRUE(ac.check());
+    fill_random(buf.get(), vmo_size);
+    ASSERT_EQ(vmo.write(buf.get(), 0, vmo_size), ZX_OK);
+
+    vmoid_t vmoid;
+    expected = sizeof(vmoid_t);
+    zx::vmo xfer_vmo;
+    ASSERT_EQ(vmo.duplicate(ZX_RIGHT_SAME_RIGHTS, &xfer_vmo), ZX_OK);
+    zx_handle_t raw_xfer_vmo = xfer_vmo.release();
+    ASSERT_EQ(ioctl_block_attach_vmo(ramdisk->fd(), &raw_xfer_vmo, &vmoid), expected,
+              "Failed to attach vmo");
+
+    async::Loop loop(&kAsyncLoopConfigNoAttachToThread);
+    fbl::unique_ptr<block_client::AsyncClient> client;
+    ASSERT_EQ(block_client::AsyncClient::Create(fbl::move(fifo), loop.dispatcher(), &client),
+              ZX_OK);
+
+    // Each transaction moves one block, in the given direction.
+    size_t completed = 0;
+    zx_status_t result = ZX_OK;
+    auto submit_all = [&](uint32_t opcode, uint64_t vmo_base) {
+        BEGIN_HELPER;
+        completed = 0;
+        for (size_t i = 0; i < kTxns; i++) {
+            block_fifo_request_t request = {};
+            request.vmoid      = vmoid;
+            request.opcode     = opcode;
+            request.length     = 1;
+            request.vmo_offset = vmo_base + i;
+            request.dev_offset = i * 2;
+            ASSERT_EQ(client->Submit(&request, 1, [&](zx_status_t status) {
+                if (status != ZX_OK) {
+                    result = status;
+                }
+                if (++completed == kTxns) {
+                    loop.Quit();
+                }
+            }), ZX_OK);
+        }
+        ASSERT_EQ(loop.Run(), ZX_ERR_CANCELED);
+        loop.ResetQuit();
+        ASSERT_EQ(result, ZX_OK);
+        ASSERT_EQ(completed, kTxns);
+        ASSERT_EQ(client->outstanding(), 0);
+        END_HELPER;
+    };
+
+    ASSERT_TRUE(submit_all(BLOCKIO_WRITE, 0));
+    ASSERT_TRUE(submit_all(BLOCKIO_READ, kTxns));
+
+    fbl::unique_ptr<uint8_t[]> out(new (&ac) uint8_t[vmo_size]);
+    ASSERT_TRUE(ac.check());
+    ASSERT_EQ(vmo.read(out.get(), 0, vmo_size), ZX_OK);
+    ASSERT_EQ(memcmp(buf.get(), out.get() + PAGE_SIZE * kTxns, PAGE_SIZE * kTxns), 0,
+              "Read data not equal to written data");
+
+    client.reset();
+    END_TEST;
+}
+
 bool RamdiskTestFifoNoGroup(void) {
     BEGIN_TEST;
     // Set up the initial handshake connection with the ramdisk
@@ -1582,6 +1766,7 @@ RUN_TEST_SMALL(RamdiskTestWaitForDevice)
 RUN_TEST_SMALL(RamdiskTestSimple)
 RUN_TEST_SMALL(RamdiskTestGuid)
 RUN_TEST_SMALL(RamdiskTestVmo)
+RUN_TEST_SMALL(RamdiskTestLatency)
 RUN_TEST_SMALL(RamdiskTestFilesystem)
 RUN_TEST_SMALL(RamdiskTestRebind)
 RUN_TEST_SMALL(RamdiskTestBadRequests)
@@ -1590,6 +1775,8 @@ RUN_TEST_SMALL(RamdiskTestReleaseDuringFifoAccess)
 RUN_TEST_SMALL(RamdiskTestMultiple)
 RUN_TEST_SMALL(RamdiskTestFifoNoOp)
 RUN_TEST_SMALL(RamdiskTestFifoBasic)
+RUN_TEST_SMALL(RamdiskTestFifoMergedRequests)
+RUN_TEST_SMALL(RamdiskTestFifoAsyncClient)
 RUN_TEST_SMALL(RamdiskTestFifoNoGroup)
 RUN_TEST_SMALL(RamdiskTestFifoMultipleVmo)
 RUN_TEST_SMALL(RamdiskTestFifoMultipleVmoMultithreaded)
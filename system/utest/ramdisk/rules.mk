@@ -15,6 +15,10 @@ MODULE_SRCS += \
 MODULE_NAME := ramdisk-test
 
 MODULE_STATIC_LIBS := \
+    system/ulib/async \
+    system/ulib/async.cpp \
+    system/ulib/async-loop \
+    system/ulib/async-loop.cpp \
     system/ulib/block-client \
     system/ulib/sync \
     system/ulib/zx \
@@ -24,6 +28,7 @@ MODULE_STATIC_LIBS := \
     system/ulib/fzl \
 
 MODULE_LIBS := \
+    system/ulib/async.default \
     system/ulib/c \
     system/ulib/fs-management \
     system/ulib/zircon \
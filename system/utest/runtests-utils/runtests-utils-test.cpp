@@ -533,6 +533,37 @@ bool RunTestsWithArguments() {
   END_TEST;
 }
 
+bool RunTestsInParallelKeepsOrder() {
+    BEGIN_TEST;
+
+    ScopedTestDir test_dir;
+    const fbl::String succeed_file_name1 = JoinPath(test_dir.path(), "succeed1.sh");
+    ScopedScriptFile succeed_file1(succeed_file_name1, kEchoSuccessAndArgs);
+    const fbl::String fail_file_name = JoinPath(test_dir.path(), "fail.sh");
+    ScopedScriptFile fail_file(fail_file_name, kEchoFailureAndArgs);
+    const fbl::String succeed_file_name2 = JoinPath(test_dir.path(), "succeed2.sh");
+    ScopedScriptFile succeed_file2(succeed_file_name2, kEchoSuccessAndArgs);
+    int num_failed = 0;
+    fbl::Vector<fbl::unique_ptr<Result>> results;
+    const fbl::String output_dir = JoinPath(test_dir.path(), "output");
+    const char output_file_base_name[] = "output.txt";
+    ASSERT_EQ(0, MkDirAll(output_dir));
+    EXPECT_TRUE(RunTestsInParallel(PlatformRunTest,
+                                   {succeed_file_name1, fail_file_name, succeed_file_name2},
+                                   {}, output_dir.c_str(), output_file_base_name, -1, 2,
+                                   {"succeed1.sh"}, &num_failed, &results));
+    EXPECT_EQ(1, num_failed);
+    ASSERT_EQ(3, results.size());
+    EXPECT_STR_EQ(succeed_file_name1.c_str(), results[0]->name.c_str());
+    EXPECT_EQ(SUCCESS, results[0]->launch_status);
+    EXPECT_STR_EQ(fail_file_name.c_str(), results[1]->name.c_str());
+    EXPECT_EQ(FAILED_NONZERO_RETURN_CODE, results[1]->launch_status);
+    EXPECT_STR_EQ(succeed_file_name2.c_str(), results[2]->name.c_str());
+    EXPECT_EQ(SUCCESS, results[2]->launch_status);
+
+    END_TEST;
+}
+
 bool DiscoverAndRunTestsBasicPass() {
     BEGIN_TEST;
 
@@ -854,6 +885,7 @@ END_TEST_CASE(DiscoverTestsInListFile)
 BEGIN_TEST_CASE(RunTests)
 RUN_TEST_MEDIUM(RunTestsWithVerbosity)
 RUN_TEST_MEDIUM(RunTestsWithArguments)
+RUN_TEST_MEDIUM(RunTestsInParallelKeepsOrder)
 END_TEST_CASE(RunTests)
 
 BEGIN_TEST_CASE(DiscoverAndRunTests)
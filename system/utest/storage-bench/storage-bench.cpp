@@ -0,0 +1,528 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <threads.h>
+#include <unistd.h>
+
+#include <digest/digest.h>
+#include <digest/merkle-tree.h>
+#include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
+#include <fbl/array.h>
+#include <fbl/function.h>
+#include <fbl/string.h>
+#include <fbl/string_printf.h>
+#include <fbl/unique_fd.h>
+#include <fbl/unique_ptr.h>
+#include <fbl/vector.h>
+#include <fs-management/mount.h>
+#include <fs-test-utils/fixture.h>
+#include <fs-test-utils/perftest.h>
+#include <perftest/perftest.h>
+#include <unittest/unittest.h>
+#include <zircon/assert.h>
+
+// A single benchmark covering the storage stack end to end: data I/O at
+// several queue depths, fsync latency and metadata operations on minfs, and
+// blob install and open on blobfs (selected with --fs blobfs). Results are
+// written in the perftest JSON format with --out.
+
+namespace storage_bench {
+namespace {
+
+using digest::Digest;
+using digest::MerkleTree;
+using fs_test_utils::Fixture;
+using fs_test_utils::FixtureOptions;
+using fs_test_utils::PerformanceTestOptions;
+using fs_test_utils::TestCaseInfo;
+using fs_test_utils::TestInfo;
+
+// Number of I/Os issued by each run of a data I/O test, split between the
+// threads keeping the queue full.
+constexpr size_t kIosPerRun = 64;
+
+// Size of the file the data I/O tests operate on.
+constexpr size_t kIoFileSize = 16 << 20;
+constexpr size_t kIoFileSizeUnittest = 1 << 20;
+
+// Each run of the fsync test overwrites one block of a file this large.
+constexpr size_t kFsyncBlockSize = 4096;
+constexpr size_t kFsyncFileBlocks = 256;
+constexpr uint32_t kFsyncSampleCount = 1000;
+
+// Minfs does not grow its inode table outside of FVM, so larger metadata
+// tests only run with --use_fvm.
+constexpr size_t kMaxFilesWithoutFvm = 32768;
+
+struct IoWorkload {
+    bool random;
+    bool write;
+    size_t io_size;
+    uint32_t depth;
+    size_t file_size;
+};
+
+// The share of a run's I/Os issued by one thread.
+struct IoWorker {
+    const IoWorkload* workload;
+    int fd;
+    uint8_t* buffer;
+    const off_t* offsets;
+    off_t base;
+    uint32_t index;
+    bool ok;
+};
+
+int IoWorkerThread(void* arg) {
+    IoWorker* worker = static_cast<IoWorker*>(arg);
+    const IoWorkload& workload = *worker->workload;
+    worker->ok = true;
+    for (size_t i = worker->index; i < kIosPerRun; i += workload.depth) {
+        off_t offset = (worker->offsets[i] + worker->base) % workload.file_size;
+        ssize_t r = workload.write
+                        ? pwrite(worker->fd, worker->buffer, workload.io_size, offset)
+                        : pread(worker->fd, worker->buffer, workload.io_size, offset);
+        if (r != static_cast<ssize_t>(workload.io_size)) {
+            worker->ok = false;
+        }
+    }
+    return 0;
+}
+
+// Measures the time taken by |kIosPerRun| reads or writes of a preallocated
+// file, issued sequentially or at random offsets by |depth| threads at once,
+// as an approximation of the queue depth seen by the filesystem.
+bool IoTest(const IoWorkload& workload, perftest::RepeatState* state, Fixture* fixture) {
+    BEGIN_HELPER;
+    ASSERT_GT(workload.depth, 0);
+    fbl::String path = fbl::StringPrintf("%s/io.dat", fixture->fs_path().c_str());
+    fbl::unique_fd fd(open(path.c_str(), O_CREAT | O_RDWR));
+    ASSERT_TRUE(fd, strerror(errno));
+
+    fbl::AllocChecker ac;
+    fbl::Array<uint8_t> buffers(new (&ac) uint8_t[workload.io_size * workload.depth],
+                                workload.io_size * workload.depth);
+    ASSERT_TRUE(ac.check());
+    memset(buffers.get(), static_cast<uint8_t>(rand_r(fixture->mutable_seed())), buffers.size());
+    for (size_t offset = 0; offset < workload.file_size; offset += workload.io_size) {
+        ASSERT_EQ(pwrite(fd.get(), buffers.get(), workload.io_size, offset),
+                  static_cast<ssize_t>(workload.io_size), strerror(errno));
+    }
+    ASSERT_EQ(fsync(fd.get()), 0, strerror(errno));
+
+    off_t offsets[kIosPerRun];
+    size_t io_count = workload.file_size / workload.io_size;
+    for (size_t i = 0; i < kIosPerRun; i++) {
+        size_t index = workload.random ? rand_r(fixture->mutable_seed()) % io_count : i;
+        offsets[i] = static_cast<off_t>(index * workload.io_size);
+    }
+
+    fbl::Array<IoWorker> workers(new (&ac) IoWorker[workload.depth], workload.depth);
+    ASSERT_TRUE(ac.check());
+    fbl::Array<thrd_t> threads(new (&ac) thrd_t[workload.depth], workload.depth);
+    ASSERT_TRUE(ac.check());
+    for (uint32_t i = 0; i < workload.depth; i++) {
+        workers[i].workload = &workload;
+        workers[i].fd = fd.get();
+        workers[i].buffer = &buffers[i * workload.io_size];
+        workers[i].offsets = offsets;
+        workers[i].index = i;
+    }
+
+    state->SetBytesProcessedPerRun(kIosPerRun * workload.io_size);
+    off_t base = 0;
+    while (state->KeepRunning()) {
+        for (uint32_t i = 0; i < workload.depth; i++) {
+            workers[i].base = base;
+        }
+        if (workload.depth == 1) {
+            IoWorkerThread(&workers[0]);
+        } else {
+            for (uint32_t i = 0; i < workload.depth; i++) {
+                ASSERT_EQ(thrd_create(&threads[i], IoWorkerThread, &workers[i]), thrd_success);
+            }
+            for (uint32_t i = 0; i < workload.depth; i++) {
+                ASSERT_EQ(thrd_join(threads[i], nullptr), thrd_success);
+            }
+        }
+        for (uint32_t i = 0; i < workload.depth; i++) {
+            ASSERT_TRUE(workers[i].ok, "I/O failed");
+        }
+        // Sequential runs pick up where the previous one stopped.
+        base = (base + kIosPerRun * workload.io_size) % workload.file_size;
+    }
+    END_HELPER;
+}
+
+// Measures the latency of making a small overwrite durable. The percentiles
+// in the summary statistics are the interesting part of this test.
+bool FsyncTest(perftest::RepeatState* state, Fixture* fixture) {
+    BEGIN_HELPER;
+    fbl::String path = fbl::StringPrintf("%s/fsync.dat", fixture->fs_path().c_str());
+    fbl::unique_fd fd(open(path.c_str(), O_CREAT | O_RDWR));
+    ASSERT_TRUE(fd, strerror(errno));
+    uint8_t data[kFsyncBlockSize];
+    memset(data, static_cast<uint8_t>(rand_r(fixture->mutable_seed())), sizeof(data));
+    for (size_t i = 0; i < kFsyncFileBlocks; i++) {
+        ASSERT_EQ(write(fd.get(), data, sizeof(data)), static_cast<ssize_t>(sizeof(data)));
+    }
+    ASSERT_EQ(fsync(fd.get()), 0, strerror(errno));
+
+    state->DeclareStep("write");
+    state->DeclareStep("fsync");
+    size_t block = 0;
+    while (state->KeepRunning()) {
+        ASSERT_EQ(pwrite(fd.get(), data, sizeof(data), block * kFsyncBlockSize),
+                  static_cast<ssize_t>(sizeof(data)), strerror(errno));
+        state->NextStep();
+        ASSERT_EQ(fsync(fd.get()), 0, strerror(errno));
+        block = (block + 1) % kFsyncFileBlocks;
+    }
+    END_HELPER;
+}
+
+// Metadata operations over a directory holding as many files as the test
+// case has samples. Each run of a test operates on one file, so the tests
+// must run in order: create, readdir, rename and then unlink.
+class MetadataOp {
+public:
+    MetadataOp() = default;
+    MetadataOp(const MetadataOp&) = delete;
+    MetadataOp(MetadataOp&&) = delete;
+    MetadataOp& operator=(const MetadataOp&) = delete;
+    MetadataOp& operator=(MetadataOp&&) = delete;
+    ~MetadataOp() = default;
+
+    bool Create(perftest::RepeatState* state, Fixture* fixture) {
+        BEGIN_HELPER;
+        while (state->KeepRunning()) {
+            fbl::String path = GetPath(*fixture, "file", created_);
+            fbl::unique_fd fd(open(path.c_str(), O_CREAT | O_EXCL | O_RDWR));
+            ASSERT_TRUE(fd, strerror(errno));
+            ASSERT_EQ(close(fd.release()), 0);
+            created_++;
+        }
+        END_HELPER;
+    }
+
+    // Each run reads a single entry, starting over once the end of the
+    // directory is reached.
+    bool Readdir(perftest::RepeatState* state, Fixture* fixture) {
+        BEGIN_HELPER;
+        DIR* dir = opendir(fixture->fs_path().c_str());
+        ASSERT_NONNULL(dir, strerror(errno));
+        while (state->KeepRunning()) {
+            struct dirent* entry = readdir(dir);
+            if (entry == nullptr) {
+                rewinddir(dir);
+                entry = readdir(dir);
+            }
+            ASSERT_NONNULL(entry);
+        }
+        ASSERT_EQ(closedir(dir), 0);
+        END_HELPER;
+    }
+
+    bool Rename(perftest::RepeatState* state, Fixture* fixture) {
+        BEGIN_HELPER;
+        while (state->KeepRunning()) {
+            ASSERT_LT(renamed_, created_);
+            ASSERT_EQ(rename(GetPath(*fixture, "file", renamed_).c_str(),
+                             GetPath(*fixture, "renamed", renamed_).c_str()),
+                      0, strerror(errno));
+            renamed_++;
+        }
+        END_HELPER;
+    }
+
+    bool Unlink(perftest::RepeatState* state, Fixture* fixture) {
+        BEGIN_HELPER;
+        while (state->KeepRunning()) {
+            ASSERT_LT(unlinked_, renamed_);
+            ASSERT_EQ(unlink(GetPath(*fixture, "renamed", unlinked_).c_str()), 0,
+                      strerror(errno));
+            unlinked_++;
+        }
+        END_HELPER;
+    }
+
+private:
+    static fbl::String GetPath(const Fixture& fixture, const char* prefix, size_t index) {
+        return fbl::StringPrintf("%s/%s-%zu", fixture.fs_path().c_str(), prefix, index);
+    }
+
+    size_t created_ = 0;
+    size_t renamed_ = 0;
+    size_t unlinked_ = 0;
+};
+
+// A blob held in memory, named after its merkle root.
+struct Blob {
+    fbl::String path;
+    fbl::Array<uint8_t> data;
+};
+
+bool MakeBlob(Fixture* fixture, size_t size, fbl::unique_ptr<Blob>* out) {
+    BEGIN_HELPER;
+    fbl::AllocChecker ac;
+    fbl::unique_ptr<Blob> blob(new (&ac) Blob);
+    ASSERT_TRUE(ac.check());
+    blob->data.reset(new (&ac) uint8_t[size], size);
+    ASSERT_TRUE(ac.check());
+    // Draw a new seed per blob rather than per byte, so the cycle of rand_r
+    // does not produce duplicate blobs.
+    unsigned int seed = rand_r(fixture->mutable_seed());
+    for (size_t i = 0; i < size; i++) {
+        blob->data[i] = static_cast<uint8_t>(rand_r(&seed));
+    }
+
+    size_t tree_size = MerkleTree::GetTreeLength(size);
+    fbl::Array<uint8_t> tree(new (&ac) uint8_t[tree_size], tree_size);
+    ASSERT_TRUE(ac.check());
+    Digest digest;
+    ASSERT_EQ(MerkleTree::Create(blob->data.get(), size, tree.get(), tree_size, &digest), ZX_OK);
+    char name[2 * Digest::kLength + 1];
+    ASSERT_EQ(digest.ToString(name, sizeof(name)), ZX_OK);
+    blob->path = fbl::StringPrintf("%s/%s", fixture->fs_path().c_str(), name);
+    *out = fbl::move(blob);
+    END_HELPER;
+}
+
+bool WriteBlob(const Blob& blob) {
+    BEGIN_HELPER;
+    fbl::unique_fd fd(open(blob.path.c_str(), O_CREAT | O_RDWR));
+    ASSERT_TRUE(fd, strerror(errno));
+    ASSERT_EQ(ftruncate(fd.get(), blob.data.size()), 0, strerror(errno));
+    size_t written = 0;
+    while (written < blob.data.size()) {
+        ssize_t r = write(fd.get(), &blob.data[written], blob.data.size() - written);
+        ASSERT_GT(r, 0, strerror(errno));
+        written += r;
+    }
+    END_HELPER;
+}
+
+bool MakeBlobs(Fixture* fixture, size_t size, size_t count,
+               fbl::Vector<fbl::unique_ptr<Blob>>* out) {
+    BEGIN_HELPER;
+    for (size_t i = 0; i < count; i++) {
+        fbl::unique_ptr<Blob> blob;
+        ASSERT_TRUE(MakeBlob(fixture, size, &blob));
+        out->push_back(fbl::move(blob));
+    }
+    END_HELPER;
+}
+
+// Measures the time taken to install |count| blobs and make them durable,
+// as a package install does.
+bool BlobInstallTest(size_t blob_size, size_t count, perftest::RepeatState* state,
+                     Fixture* fixture) {
+    BEGIN_HELPER;
+    fbl::Vector<fbl::unique_ptr<Blob>> blobs;
+    ASSERT_TRUE(MakeBlobs(fixture, blob_size, count, &blobs));
+    fbl::unique_fd root(open(fixture->fs_path().c_str(), O_RDONLY | O_DIRECTORY));
+    ASSERT_TRUE(root, strerror(errno));
+
+    state->SetBytesProcessedPerRun(blob_size * count);
+    state->DeclareStep("write");
+    state->DeclareStep("sync");
+    state->DeclareStep("unlink");
+    while (state->KeepRunning()) {
+        for (const auto& blob : blobs) {
+            ASSERT_TRUE(WriteBlob(*blob));
+        }
+        state->NextStep();
+        ASSERT_EQ(syncfs(root.get()), 0, strerror(errno));
+        state->NextStep();
+        for (const auto& blob : blobs) {
+            ASSERT_EQ(unlink(blob->path.c_str()), 0, strerror(errno));
+        }
+        ASSERT_EQ(syncfs(root.get()), 0, strerror(errno));
+    }
+    END_HELPER;
+}
+
+// Measures the time taken to open and close one of |count| installed blobs,
+// picked at random.
+bool BlobOpenTest(size_t blob_size, size_t count, perftest::RepeatState* state,
+                  Fixture* fixture) {
+    BEGIN_HELPER;
+    fbl::Vector<fbl::unique_ptr<Blob>> blobs;
+    ASSERT_TRUE(MakeBlobs(fixture, blob_size, count, &blobs));
+    for (const auto& blob : blobs) {
+        ASSERT_TRUE(WriteBlob(*blob));
+    }
+    fbl::unique_fd root(open(fixture->fs_path().c_str(), O_RDONLY | O_DIRECTORY));
+    ASSERT_TRUE(root, strerror(errno));
+    ASSERT_EQ(syncfs(root.get()), 0, strerror(errno));
+
+    state->DeclareStep("open");
+    state->DeclareStep("close");
+    while (state->KeepRunning()) {
+        const Blob& blob = *blobs[rand_r(fixture->mutable_seed()) % blobs.size()];
+        fbl::unique_fd fd(open(blob.path.c_str(), O_RDONLY));
+        ASSERT_TRUE(fd, strerror(errno));
+        state->NextStep();
+        ASSERT_EQ(close(fd.release()), 0);
+    }
+    END_HELPER;
+}
+
+void AddFileTestCases(const FixtureOptions& f_opts, const PerformanceTestOptions& p_opts,
+                      fbl::Vector<fbl::unique_ptr<MetadataOp>>* metadata_ops,
+                      fbl::Vector<TestCaseInfo>* testcases) {
+    const char* fs_name = disk_format_string_[f_opts.fs_type];
+    const size_t io_sizes[] = {
+        4 * (1 << 10),
+        64 * (1 << 10),
+    };
+    const uint32_t depths[] = {1, 4, 16};
+    const size_t file_size = p_opts.is_unittest ? kIoFileSizeUnittest : kIoFileSize;
+
+    for (bool random : {false, true}) {
+        for (size_t io_size : io_sizes) {
+            TestCaseInfo testcase;
+            testcase.name = fbl::StringPrintf("%s/Io/%s/%zuKbytes", fs_name,
+                                              random ? "Random" : "Sequential", io_size >> 10);
+            testcase.teardown = true;
+            for (bool write : {false, true}) {
+                for (uint32_t depth : depths) {
+                    IoWorkload workload = {random, write, io_size, depth, file_size};
+                    TestInfo test;
+                    test.name = fbl::StringPrintf("%s/%s/Depth-%u", testcase.name.c_str(),
+                                                  write ? "Write" : "Read", depth);
+                    test.test_fn = [workload](perftest::RepeatState* state, Fixture* fixture) {
+                        return IoTest(workload, state, fixture);
+                    };
+                    test.required_disk_space = file_size;
+                    testcase.tests.push_back(fbl::move(test));
+                }
+            }
+            testcases->push_back(fbl::move(testcase));
+        }
+    }
+
+    TestCaseInfo fsync_case;
+    fsync_case.name = fbl::StringPrintf("%s/Fsync/4Kbytes", fs_name);
+    fsync_case.sample_count = kFsyncSampleCount;
+    fsync_case.teardown = true;
+    TestInfo fsync_test;
+    fsync_test.name = fsync_case.name;
+    fsync_test.test_fn = FsyncTest;
+    fsync_test.required_disk_space = kFsyncBlockSize * kFsyncFileBlocks;
+    fsync_case.tests.push_back(fbl::move(fsync_test));
+    testcases->push_back(fbl::move(fsync_case));
+
+    const uint32_t file_counts[] = {1000, 10000, 100000};
+    for (uint32_t file_count : file_counts) {
+        if (!f_opts.use_fvm && file_count > kMaxFilesWithoutFvm) {
+            continue;
+        }
+        fbl::AllocChecker ac;
+        fbl::unique_ptr<MetadataOp> op(new (&ac) MetadataOp);
+        ZX_ASSERT(ac.check());
+
+        TestCaseInfo testcase;
+        testcase.name = fbl::StringPrintf("%s/Metadata/%u-Files", fs_name, file_count);
+        testcase.sample_count = file_count;
+        testcase.teardown = false;
+
+        TestInfo create_test;
+        create_test.name = fbl::StringPrintf("%s/Create", testcase.name.c_str());
+        create_test.test_fn = fbl::BindMember(op.get(), &MetadataOp::Create);
+        testcase.tests.push_back(fbl::move(create_test));
+
+        TestInfo readdir_test;
+        readdir_test.name = fbl::StringPrintf("%s/Readdir", testcase.name.c_str());
+        readdir_test.test_fn = fbl::BindMember(op.get(), &MetadataOp::Readdir);
+        testcase.tests.push_back(fbl::move(readdir_test));
+
+        TestInfo rename_test;
+        rename_test.name = fbl::StringPrintf("%s/Rename", testcase.name.c_str());
+        rename_test.test_fn = fbl::BindMember(op.get(), &MetadataOp::Rename);
+        testcase.tests.push_back(fbl::move(rename_test));
+
+        TestInfo unlink_test;
+        unlink_test.name = fbl::StringPrintf("%s/Unlink", testcase.name.c_str());
+        unlink_test.test_fn = fbl::BindMember(op.get(), &MetadataOp::Unlink);
+        testcase.tests.push_back(fbl::move(unlink_test));
+
+        metadata_ops->push_back(fbl::move(op));
+        testcases->push_back(fbl::move(testcase));
+    }
+}
+
+void AddBlobTestCases(const FixtureOptions& f_opts, fbl::Vector<TestCaseInfo>* testcases) {
+    const char* fs_name = disk_format_string_[f_opts.fs_type];
+    const size_t blob_sizes[] = {
+        8 * (1 << 10),
+        1 << 20,
+    };
+    const size_t blob_counts[] = {10, 100};
+    constexpr uint32_t kBlobSampleCount = 20;
+
+    for (size_t blob_size : blob_sizes) {
+        for (size_t count : blob_counts) {
+            TestCaseInfo testcase;
+            testcase.name = fbl::StringPrintf("%s/Blob/%zuKbytes/%zu-Blobs", fs_name,
+                                              blob_size >> 10, count);
+            testcase.sample_count = kBlobSampleCount;
+            testcase.teardown = true;
+
+            TestInfo install_test;
+            install_test.name = fbl::StringPrintf("%s/Install", testcase.name.c_str());
+            install_test.test_fn = [blob_size, count](perftest::RepeatState* state,
+                                                      Fixture* fixture) {
+                return BlobInstallTest(blob_size, count, state, fixture);
+            };
+            install_test.required_disk_space = blob_size * count;
+            testcase.tests.push_back(fbl::move(install_test));
+
+            TestInfo open_test;
+            open_test.name = fbl::StringPrintf("%s/Open", testcase.name.c_str());
+            open_test.test_fn = [blob_size, count](perftest::RepeatState* state,
+                                                   Fixture* fixture) {
+                return BlobOpenTest(blob_size, count, state, fixture);
+            };
+            open_test.required_disk_space = blob_size * count;
+            testcase.tests.push_back(fbl::move(open_test));
+
+            testcases->push_back(fbl::move(testcase));
+        }
+    }
+}
+
+} // namespace
+
+bool RunBenchmark(int argc, char** argv) {
+    FixtureOptions f_opts = FixtureOptions::Default(DISK_FORMAT_MINFS);
+    PerformanceTestOptions p_opts;
+    if (!fs_test_utils::ParseCommandLineArgs(argc, argv, &f_opts, &p_opts)) {
+        return false;
+    }
+
+    fbl::Vector<fbl::unique_ptr<MetadataOp>> metadata_ops;
+    fbl::Vector<TestCaseInfo> testcases;
+    if (f_opts.fs_type == DISK_FORMAT_BLOBFS) {
+        AddBlobTestCases(f_opts, &testcases);
+    } else {
+        AddFileTestCases(f_opts, p_opts, &metadata_ops, &testcases);
+    }
+    return fs_test_utils::RunTestCases(f_opts, p_opts, testcases);
+}
+
+} // namespace storage_bench
+
+int main(int argc, char** argv) {
+    return fs_test_utils::RunWithMemFs(
+        [argc, argv]() { return storage_bench::RunBenchmark(argc, argv) ? 0 : -1; });
+}
@@ -0,0 +1,170 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <trace-reader/summary.h>
+
+#include <stdint.h>
+
+#include <fbl/algorithm.h>
+#include <fbl/vector.h>
+#include <unittest/unittest.h>
+
+namespace {
+
+const trace::ProcessThread kThread1(1, 2);
+const trace::ProcessThread kThread2(1, 3);
+
+trace::Record MakeEvent(trace_ticks_t timestamp, const trace::ProcessThread& process_thread,
+                        const char* name, trace::EventData data) {
+    return trace::Record(trace::Record::Event{
+        timestamp, process_thread, "cat", name, fbl::Vector<trace::Argument>(),
+        fbl::move(data)});
+}
+
+trace::Record MakeContextSwitch(trace_ticks_t timestamp, trace_cpu_number_t cpu,
+                                const trace::ProcessThread& outgoing,
+                                const trace::ProcessThread& incoming) {
+    return trace::Record(trace::Record::ContextSwitch{
+        timestamp, cpu, trace::ThreadState::kSuspended, outgoing, incoming, 0u, 0u});
+}
+
+bool histogram_test() {
+    BEGIN_TEST;
+
+    trace::Histogram histogram;
+    EXPECT_EQ(0u, histogram.count());
+    EXPECT_EQ(0u, histogram.min());
+    EXPECT_EQ(0u, histogram.Percentile(50));
+
+    histogram.Add(0u);
+    histogram.Add(1u);
+    histogram.Add(5u);
+    histogram.Add(1000u);
+
+    EXPECT_EQ(4u, histogram.count());
+    EXPECT_EQ(1006u, histogram.total());
+    EXPECT_EQ(0u, histogram.min());
+    EXPECT_EQ(1000u, histogram.max());
+    EXPECT_EQ(1u, histogram.bucket(0));
+    EXPECT_EQ(1u, histogram.bucket(1));
+    EXPECT_EQ(1u, histogram.bucket(3));
+    EXPECT_EQ(1u, histogram.bucket(10));
+
+    EXPECT_EQ(1u, histogram.Percentile(50));
+    EXPECT_EQ(7u, histogram.Percentile(75));
+    EXPECT_EQ(1000u, histogram.Percentile(100));
+
+    END_TEST;
+}
+
+bool duration_test() {
+    BEGIN_TEST;
+
+    trace::TraceSummary summary;
+    // 1000 ticks per second, so each tick is one millisecond.
+    summary.AddRecord(trace::Record(trace::Record::Initialization{1000u}));
+
+    // Nested durations on one thread, interleaved with another thread.
+    summary.AddRecord(MakeEvent(10u, kThread1, "outer",
+                                trace::EventData(trace::EventData::DurationBegin{})));
+    summary.AddRecord(MakeEvent(11u, kThread2, "inner",
+                                trace::EventData(trace::EventData::DurationBegin{})));
+    summary.AddRecord(MakeEvent(12u, kThread1, "inner",
+                                trace::EventData(trace::EventData::DurationBegin{})));
+    summary.AddRecord(MakeEvent(14u, kThread1, "inner",
+                                trace::EventData(trace::EventData::DurationEnd{})));
+    summary.AddRecord(MakeEvent(15u, kThread2, "inner",
+                                trace::EventData(trace::EventData::DurationEnd{})));
+    summary.AddRecord(MakeEvent(20u, kThread1, "outer",
+                                trace::EventData(trace::EventData::DurationEnd{})));
+    summary.AddRecord(MakeEvent(21u, kThread1, "outer",
+                                trace::EventData(trace::EventData::DurationEnd{})));
+
+    EXPECT_EQ(1u, summary.unmatched_duration_ends());
+
+    size_t num_names = 0u;
+    summary.ForEachDuration([&num_names](const trace::NamedStats& stats) {
+        num_names++;
+        EXPECT_STR_EQ("cat", stats.category.c_str());
+        if (stats.name == "outer") {
+            EXPECT_EQ(1u, stats.durations.count());
+            EXPECT_EQ(10000000u, stats.durations.total());
+        } else {
+            EXPECT_STR_EQ("inner", stats.name.c_str());
+            EXPECT_EQ(2u, stats.durations.count());
+            EXPECT_EQ(2000000u, stats.durations.min());
+            EXPECT_EQ(4000000u, stats.durations.max());
+        }
+    });
+    EXPECT_EQ(2u, num_names);
+
+    END_TEST;
+}
+
+bool flow_test() {
+    BEGIN_TEST;
+
+    trace::TraceSummary summary;
+    summary.AddRecord(MakeEvent(100u, kThread1, "request",
+                                trace::EventData(trace::EventData::FlowBegin{7u})));
+    summary.AddRecord(MakeEvent(150u, kThread2, "step",
+                                trace::EventData(trace::EventData::FlowStep{7u})));
+    summary.AddRecord(MakeEvent(300u, kThread2, "reply",
+                                trace::EventData(trace::EventData::FlowEnd{7u})));
+    summary.AddRecord(MakeEvent(400u, kThread2, "reply",
+                                trace::EventData(trace::EventData::FlowEnd{7u})));
+
+    EXPECT_EQ(1u, summary.unmatched_flow_ends());
+
+    size_t num_names = 0u;
+    summary.ForEachFlow([&num_names](const trace::NamedStats& stats) {
+        num_names++;
+        EXPECT_STR_EQ("request", stats.name.c_str());
+        EXPECT_EQ(1u, stats.durations.count());
+        EXPECT_EQ(200u, stats.durations.total());
+    });
+    EXPECT_EQ(1u, num_names);
+
+    END_TEST;
+}
+
+bool context_switch_test() {
+    BEGIN_TEST;
+
+    const trace::ProcessThread kIdle(0u, 9u);
+
+    trace::TraceSummary summary;
+    summary.AddRecord(MakeContextSwitch(100u, 0u, kIdle, kThread1));
+    summary.AddRecord(MakeContextSwitch(110u, 1u, kIdle, kThread2));
+    summary.AddRecord(MakeContextSwitch(130u, 0u, kThread1, kThread2));
+    summary.AddRecord(MakeContextSwitch(140u, 1u, kThread2, kIdle));
+    summary.AddRecord(MakeContextSwitch(145u, 0u, kThread2, kThread1));
+
+    uint64_t running_time[2] = {};
+    uint64_t switch_count[2] = {};
+    summary.ForEachThread([&](const trace::ThreadStats& stats) {
+        if (stats.process_thread == kThread1) {
+            running_time[0] = stats.running_time;
+            switch_count[0] = stats.switch_count;
+        } else if (stats.process_thread == kThread2) {
+            running_time[1] = stats.running_time;
+            switch_count[1] = stats.switch_count;
+        }
+    });
+    EXPECT_EQ(30u, running_time[0]);
+    EXPECT_EQ(2u, switch_count[0]);
+    EXPECT_EQ(45u, running_time[1]);
+    EXPECT_EQ(2u, switch_count[1]);
+
+    END_TEST;
+}
+
+} // namespace
+
+BEGIN_TEST_CASE(summary_tests)
+RUN_TEST(histogram_test)
+RUN_TEST(duration_test)
+RUN_TEST(flow_test)
+RUN_TEST(context_switch_test)
+END_TEST_CASE(summary_tests)
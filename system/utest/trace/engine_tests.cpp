@@ -332,6 +332,42 @@ String(index: 4, "string2")
     END_TRACE_TEST;
 }
 
+bool TestRecordsGroupedByThread() {
+    BEGIN_TRACE_TEST;
+
+    fixture_start_tracing();
+
+    // Each thread writes its records to its own chunk of the buffer, so
+    // records of different threads don't interleave. The unused parts of
+    // the chunks must be skipped by the reader.
+    trace_string_ref_t a1, a2, b1;
+    {
+        auto context = trace::TraceContext::Acquire();
+
+        trace_context_register_string_literal(context.get(), "string1", &a1);
+    }
+
+    RunThread([&b1] {
+        auto context = trace::TraceContext::Acquire();
+
+        trace_context_register_string_literal(context.get(), "string2", &b1);
+    });
+
+    {
+        auto context = trace::TraceContext::Acquire();
+
+        trace_context_register_string_literal(context.get(), "string3", &a2);
+    }
+
+    ASSERT_RECORDS(R"X(String(index: 1, "string1")
+String(index: 3, "string3")
+String(index: 2, "string2")
+)X",
+                   "");
+
+    END_TRACE_TEST;
+}
+
 bool TestRegisterStringLiteralTableOverflow() {
     BEGIN_TRACE_TEST;
 
@@ -692,6 +728,7 @@ RUN_TEST(TestRegisterCurrentThread)
 RUN_TEST(TestRegisterCurrentThreadMultipleThreads)
 RUN_TEST(TestRegisterStringLiteral)
 RUN_TEST(TestRegisterStringLiteralMultipleThreads)
+RUN_TEST(TestRecordsGroupedByThread)
 RUN_TEST(TestRegisterStringLiteralTableOverflow)
 RUN_TEST(TestMaximumRecordLength)
 RUN_TEST(TestEventWithInlineEverything)
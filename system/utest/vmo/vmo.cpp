@@ -15,6 +15,7 @@
 #include <zircon/process.h>
 #include <zircon/syscalls.h>
 #include <zircon/syscalls/object.h>
+#include <zircon/syscalls/port.h>
 #include <fbl/algorithm.h>
 #include <fbl/atomic.h>
 #include <fbl/function.h>
@@ -812,6 +813,92 @@ bool vmo_commit_test() {
     END_TEST;
 }
 
+bool vmo_commit_async_test() {
+    BEGIN_TEST;
+
+    const size_t size = 16 * PAGE_SIZE;
+    zx_handle_t vmo;
+    ASSERT_EQ(ZX_OK, zx_vmo_create(size, 0, &vmo));
+    zx_handle_t port;
+    ASSERT_EQ(ZX_OK, zx_port_create(0, &port));
+
+    zx_vmo_op_async_t args = {};
+    args.port = port;
+    args.key = 42;
+
+    // the arguments must be passed in full
+    EXPECT_EQ(ZX_ERR_INVALID_ARGS,
+              zx_vmo_op_range(vmo, ZX_VMO_OP_COMMIT_ASYNC, 0, size, nullptr, 0));
+    EXPECT_EQ(ZX_ERR_OUT_OF_RANGE,
+              zx_vmo_op_range(vmo, ZX_VMO_OP_COMMIT_ASYNC, 0, size * 2, &args, sizeof(args)));
+
+    EXPECT_EQ(ZX_OK, zx_vmo_op_range(vmo, ZX_VMO_OP_COMMIT_ASYNC, PAGE_SIZE, size - PAGE_SIZE,
+                                     &args, sizeof(args)));
+
+    zx_port_packet_t packet;
+    ASSERT_EQ(ZX_OK, zx_port_wait(port, ZX_TIME_INFINITE, &packet));
+    EXPECT_EQ(42u, packet.key);
+    EXPECT_EQ(ZX_PKT_TYPE_VMO_OP, packet.type);
+    EXPECT_EQ(ZX_OK, packet.status);
+    EXPECT_EQ(ZX_VMO_OP_COMMIT_ASYNC, packet.vmo_op.op);
+    EXPECT_EQ(PAGE_SIZE, packet.vmo_op.offset);
+    EXPECT_EQ(size - PAGE_SIZE, packet.vmo_op.size);
+
+    zx_info_vmo_t info;
+    ASSERT_EQ(ZX_OK, zx_object_get_info(vmo, ZX_INFO_VMO, &info, sizeof(info), nullptr, nullptr));
+    EXPECT_EQ(size - PAGE_SIZE, info.committed_bytes);
+
+    // prefetching leaves uncommitted pages alone
+    args.key = 43;
+    EXPECT_EQ(ZX_OK, zx_vmo_op_range(vmo, ZX_VMO_OP_PREFETCH_ASYNC, 0, size,
+                                     &args, sizeof(args)));
+    ASSERT_EQ(ZX_OK, zx_port_wait(port, ZX_TIME_INFINITE, &packet));
+    EXPECT_EQ(43u, packet.key);
+    EXPECT_EQ(ZX_OK, packet.status);
+    EXPECT_EQ(ZX_VMO_OP_PREFETCH_ASYNC, packet.vmo_op.op);
+    ASSERT_EQ(ZX_OK, zx_object_get_info(vmo, ZX_INFO_VMO, &info, sizeof(info), nullptr, nullptr));
+    EXPECT_EQ(size - PAGE_SIZE, info.committed_bytes);
+
+    EXPECT_EQ(ZX_OK, zx_handle_close(port));
+    EXPECT_EQ(ZX_OK, zx_handle_close(vmo));
+
+    END_TEST;
+}
+
+bool vmo_commit_async_cancel_test() {
+    BEGIN_TEST;
+
+    const size_t size = 64 * PAGE_SIZE;
+    const uint64_t kOps = 32;
+    zx_handle_t vmo;
+    ASSERT_EQ(ZX_OK, zx_vmo_create(size, 0, &vmo));
+    zx_handle_t port;
+    ASSERT_EQ(ZX_OK, zx_port_create(0, &port));
+
+    zx_vmo_op_async_t args = {};
+    args.port = port;
+    for (uint64_t i = 0; i < kOps; i++) {
+        args.key = i;
+        ASSERT_EQ(ZX_OK, zx_vmo_op_range(vmo, ZX_VMO_OP_COMMIT_ASYNC, 0, size,
+                                         &args, sizeof(args)));
+    }
+
+    // closing the vmo cancels the ops which have not run yet, but every op
+    // still completes with a packet
+    EXPECT_EQ(ZX_OK, zx_handle_close(vmo));
+    for (uint64_t i = 0; i < kOps; i++) {
+        zx_port_packet_t packet;
+        ASSERT_EQ(ZX_OK, zx_port_wait(port, ZX_TIME_INFINITE, &packet));
+        EXPECT_EQ(ZX_PKT_TYPE_VMO_OP, packet.type);
+        EXPECT_LT(packet.key, kOps);
+        EXPECT_TRUE(packet.status == ZX_OK || packet.status == ZX_ERR_CANCELED);
+    }
+
+    EXPECT_EQ(ZX_OK, zx_handle_close(port));
+
+    END_TEST;
+}
+
 bool vmo_zero_page_test() {
     BEGIN_TEST;
 
@@ -887,6 +974,102 @@ bool vmo_zero_page_test() {
     END_TEST;
 }
 
+// Checks that pages mapped ahead of a fault are correct and still take
+// write faults, with and without fault-around.
+bool vmo_fault_around_test() {
+    BEGIN_TEST;
+
+    const size_t kPages = 32;
+    const size_t size = PAGE_SIZE * kPages;
+    zx_handle_t vmo;
+    ASSERT_EQ(ZX_OK, zx_vmo_create(size, 0, &vmo), "vm_object_create");
+
+    // commit every page with a known value
+    for (uint32_t i = 0; i < kPages; i++) {
+        EXPECT_EQ(ZX_OK, zx_vmo_write(vmo, &i, i * PAGE_SIZE, sizeof(i)), "writing to vmo");
+    }
+
+    const zx_vm_option_t options[] = { 0, ZX_VM_NO_FAULT_AROUND };
+    for (zx_vm_option_t option : options) {
+        uintptr_t ptr;
+        ASSERT_EQ(ZX_OK,
+                  zx_vmar_map(zx_vmar_root_self(), ZX_VM_PERM_READ | ZX_VM_PERM_WRITE | option,
+                              0, vmo, 0, size, &ptr),
+                  "map");
+
+        for (uint32_t i = 0; i < kPages; i++) {
+            volatile uint32_t* val = (volatile uint32_t*)(ptr + i * PAGE_SIZE);
+            EXPECT_EQ(i, *val, "read back page value");
+        }
+
+        // pages mapped ahead are read-only, writes must still land in the vmo
+        for (uint32_t i = 0; i < kPages; i++) {
+            volatile uint32_t* val = (volatile uint32_t*)(ptr + i * PAGE_SIZE);
+            *val = i + 1;
+        }
+        for (uint32_t i = 0; i < kPages; i++) {
+            uint32_t v;
+            EXPECT_EQ(ZX_OK, zx_vmo_read(vmo, &v, i * PAGE_SIZE, sizeof(v)), "reading vmo");
+            EXPECT_EQ(i + 1, v, "write through mapping");
+            EXPECT_EQ(ZX_OK, zx_vmo_write(vmo, &i, i * PAGE_SIZE, sizeof(i)), "writing to vmo");
+        }
+
+        EXPECT_EQ(ZX_OK, zx_vmar_unmap(zx_vmar_root_self(), ptr, size), "unmap");
+    }
+
+    // the option only makes sense for mappings
+    zx_handle_t vmar;
+    uintptr_t addr;
+    EXPECT_EQ(ZX_ERR_INVALID_ARGS,
+              zx_vmar_allocate(zx_vmar_root_self(), ZX_VM_CAN_MAP_READ | ZX_VM_NO_FAULT_AROUND,
+                               0, size, &vmar, &addr),
+              "vmar_allocate");
+
+    EXPECT_EQ(ZX_OK, zx_handle_close(vmo), "handle_close");
+
+    END_TEST;
+}
+
+// Checks that reads and zero writes of untouched pages don't commit memory.
+bool vmo_zero_write_test() {
+    BEGIN_TEST;
+
+    const size_t size = PAGE_SIZE * 4;
+    zx_handle_t vmo;
+    ASSERT_EQ(ZX_OK, zx_vmo_create(size, 0, &vmo), "vm_object_create");
+
+    auto committed = [vmo]() -> uint64_t {
+        zx_info_vmo_t info;
+        if (zx_object_get_info(vmo, ZX_INFO_VMO, &info, sizeof(info), nullptr, nullptr) != ZX_OK) {
+            return UINT64_MAX;
+        }
+        return info.committed_bytes;
+    };
+
+    uint8_t buf[PAGE_SIZE] = {};
+    EXPECT_EQ(ZX_OK, zx_vmo_write(vmo, buf, 0, sizeof(buf)), "zero write");
+    EXPECT_EQ(ZX_OK, zx_vmo_read(vmo, buf, PAGE_SIZE, sizeof(buf)), "read");
+    EXPECT_EQ(0u, committed(), "zero write and read commit nothing");
+
+    buf[7] = 1;
+    EXPECT_EQ(ZX_OK, zx_vmo_write(vmo, buf, 2 * PAGE_SIZE, sizeof(buf)), "write");
+    EXPECT_EQ(PAGE_SIZE, committed(), "real write commits a page");
+
+    // a zero write over a committed page keeps it
+    buf[7] = 0;
+    EXPECT_EQ(ZX_OK, zx_vmo_write(vmo, buf, 2 * PAGE_SIZE, sizeof(buf)), "zero write");
+    EXPECT_EQ(PAGE_SIZE, committed(), "committed page kept");
+
+    EXPECT_EQ(ZX_OK, zx_vmo_read(vmo, buf, 0, sizeof(buf)), "read");
+    for (size_t i = 0; i < sizeof(buf); i++) {
+        EXPECT_EQ(0, buf[i], "zero page content");
+    }
+
+    EXPECT_EQ(ZX_OK, zx_handle_close(vmo), "handle_close");
+
+    END_TEST;
+}
+
 // test set 1: create a few clones, close them
 bool vmo_clone_test_1() {
     BEGIN_TEST;
@@ -1784,12 +1967,16 @@ RUN_TEST(vmo_resize_align_test);
 RUN_TEST(vmo_clone_size_align_test);
 RUN_TEST(vmo_rights_test);
 RUN_TEST(vmo_commit_test);
+RUN_TEST(vmo_commit_async_test);
+RUN_TEST(vmo_commit_async_cancel_test);
 RUN_TEST(vmo_decommit_misaligned_test);
 RUN_TEST(vmo_cache_test);
 RUN_TEST_PERFORMANCE(vmo_cache_map_test);
 RUN_TEST(vmo_cache_op_test);
 RUN_TEST(vmo_cache_flush_test);
 RUN_TEST(vmo_zero_page_test);
+RUN_TEST(vmo_fault_around_test);
+RUN_TEST(vmo_zero_write_test);
 RUN_TEST(vmo_clone_test_1);
 RUN_TEST(vmo_clone_test_2);
 RUN_TEST(vmo_clone_test_3);
@@ -36,8 +36,11 @@
  * propagate the "poisoned" memory state.  Since we typically decommit as the
  * next step after purging on Windows anyway, there's no point in adding such
  * complexity.
+ *
+ * On Fuchsia, forced purging decommits the range of the heap vmo.
  */
-#if !defined(_WIN32) && defined(JEMALLOC_PURGE_MADVISE_DONTNEED)
+#if !defined(_WIN32) && (defined(JEMALLOC_PURGE_MADVISE_DONTNEED) || \
+    defined(__Fuchsia__))
 #  define PAGES_CAN_PURGE_FORCED
 #endif
 
@@ -93,8 +93,20 @@ static void* fuchsia_pages_map(void* start, size_t len) {
 	return (void*)ptr;
 }
 
+// Release the memory backing a range of the heap. The range stays
+// mapped, and reads as zeros the next time it is touched.
+static zx_status_t fuchsia_pages_decommit(void* addr, size_t size) {
+	uintptr_t ptr = (uintptr_t)addr;
+	return _zx_vmo_op_range(pages_vmo, ZX_VMO_OP_DECOMMIT,
+	    ptr - pages_base, size, NULL, 0);
+}
+
 static zx_status_t fuchsia_pages_free(void* addr, size_t size) {
 	uintptr_t ptr = (uintptr_t)addr;
+	// Unmapping alone would leave the pages committed in pages_vmo.
+	zx_status_t status = fuchsia_pages_decommit(addr, size);
+	if (status != ZX_OK)
+		return status;
 	return _zx_vmar_unmap(pages_vmar, ptr, size);
 }
 
@@ -289,7 +301,9 @@ pages_purge_forced(void *addr, size_t size)
 	if (!pages_can_purge_forced)
 		return (true);
 
-#if defined(JEMALLOC_PURGE_MADVISE_DONTNEED)
+#if defined(__Fuchsia__)
+	return (fuchsia_pages_decommit(addr, size) != ZX_OK);
+#elif defined(JEMALLOC_PURGE_MADVISE_DONTNEED)
 	return (madvise(addr, size, MADV_DONTNEED) != 0);
 #else
 	not_reached();
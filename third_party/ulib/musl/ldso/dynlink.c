@@ -445,6 +445,11 @@ __NO_SAFESTACK NO_ASAN static void do_relocs(struct dso* dso, size_t* rel,
     size_t tls_val;
     size_t addend;
     int skip_relative = 0, reuse_addends = 0, save_slot = 0;
+    // The linker sorts the non-relative relocations by symbol, so runs of
+    // relocations against the same symbol are common; remember the last
+    // lookup so each run costs one find_sym.
+    int cached_sym_index = 0, cached_type = REL_NONE;
+    struct symdef cached_def = {};
 
     if (dso == &ldso) {
         /* Only ldso's REL table needs addend saving/reuse. */
@@ -465,8 +470,19 @@ __NO_SAFESTACK NO_ASAN static void do_relocs(struct dso* dso, size_t* rel,
             sym = syms + sym_index;
             name = strings + sym->st_name;
             ctx = type == REL_COPY ? dso_next(head) : head;
-            def = (sym->st_info & 0xf) == STT_SECTION ? (struct symdef){.dso = dso, .sym = sym}
-                                                      : find_sym(ctx, name, type == REL_PLT);
+            if ((sym->st_info & 0xf) == STT_SECTION) {
+                def = (struct symdef){.dso = dso, .sym = sym};
+            } else if (sym_index == cached_sym_index &&
+                       (type == REL_PLT) == (cached_type == REL_PLT) &&
+                       (type == REL_COPY) == (cached_type == REL_COPY)) {
+                // Same symbol and same lookup rules as the last time.
+                def = cached_def;
+            } else {
+                def = find_sym(ctx, name, type == REL_PLT);
+                cached_sym_index = sym_index;
+                cached_type = type;
+                cached_def = def;
+            }
             if (!def.sym && (sym->st_shndx != SHN_UNDEF || sym->st_info >> 4 != STB_WEAK)) {
                 error("Error relocating %s: %s: symbol not found", dso->l_map.l_name, name);
                 if (runtime)